@@ -8,6 +8,7 @@
 #include "bag_metadata_import.h"
 #include "bag_private.h"
 #include "bag_simplelayer.h"
+#include "bag_simplelayerdescriptor.h"
 #include "bag_surfacecorrections.h"
 #include "bag_surfacecorrectionsdescriptor.h"
 #include "bag_trackinglist.h"
@@ -28,6 +29,7 @@
 #include <H5Cpp.h>
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <sstream>
 #include <string>
@@ -40,6 +42,31 @@
 
 namespace {
 
+//! The error of the last C interface call of this thread that failed.
+thread_local BagError lastError = BAG_SUCCESS;
+//! What went wrong in the last C interface call of this thread that failed.
+thread_local std::string lastErrorMessage;
+
+//! Record the error of a failed call for bagGetLastError().
+/*!
+\param error
+    The error code.
+\param message
+    What went wrong; may be NULL.
+
+\return
+    \e error.
+*/
+BagError setLastError(
+    BagError error,
+    const char* message = nullptr)
+{
+    lastError = error;
+    lastErrorMessage = message ? message : "";
+
+    return error;
+}
+
 //! Convert a BAG::CompoundDataType (C++) into a BagCompoundDataType (C).
 /*!
 \param field
@@ -111,6 +138,105 @@ BAG::CompoundDataType getValue(
     }
 }
 
+//! Read a window of a layer into a caller owned buffer.
+/*!
+\param layer
+    The layer.
+\param window
+    The window to read.
+\param data
+    The buffer to read into.
+\param rowStride
+    The distance, in bytes, between the start of two rows in data.
+    Zero means the rows are tightly packed.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError readWindowInto(
+    const BAG::Layer& layer,
+    const BagWindow& window,
+    void* data,
+    size_t rowStride)
+{
+    if (!data || window.rowStart > window.rowEnd ||
+        window.colStart > window.colEnd)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    const size_t rowBytes = static_cast<size_t>(window.colEnd -
+        window.colStart + 1) * layer.getDescriptor()->getElementSize();
+    if (rowStride == 0)
+        rowStride = rowBytes;
+    else if (rowStride < rowBytes)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    // The last row does not need a whole stride.
+    const size_t bufferSize = (window.rowEnd - window.rowStart) * rowStride +
+        rowBytes;
+
+    try
+    {
+        layer.readInto(window.rowStart, window.colStart, window.rowEnd,
+            window.colEnd, static_cast<uint8_t*>(data), bufferSize, rowStride);
+    }
+    catch(const BAG::InvalidReadSize& e)
+    {
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT, e.what());
+    }
+    catch(const std::exception& e)
+    {
+        return setLastError(BAG_HDF_READ_FAILURE, e.what());
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Copy the I/O counters of the library into those of the C interface.
+void toBagIoStats(
+    const BAG::IoStats& from,
+    BagIoStats& to) noexcept
+{
+    to = {};
+    to.numReads = from.numReads;
+    to.numWrites = from.numWrites;
+    to.bytesRequested = from.bytesRequested;
+    to.bytesWritten = from.bytesWritten;
+    to.bytesDecompressed = from.bytesDecompressed;
+    to.chunksRead = from.chunksRead;
+    to.chunksWritten = from.chunksWritten;
+    to.numAttributeWrites = from.numAttributeWrites;
+    to.readSeconds = from.readSeconds;
+    to.writeSeconds = from.writeSeconds;
+    to.attributeSeconds = from.attributeSeconds;
+    to.selectionSeconds = from.selectionSeconds;
+    to.hdf5ReadSeconds = from.hdf5ReadSeconds;
+    to.decompressSeconds = from.decompressSeconds;
+}
+
+//! Find the descriptor of a layer, without opening the layer.
+/*!
+    The attributes of the descriptors are read when the BAG is opened, so a
+    layer found with BAG::OpenOptions::lazy is not opened to query them.
+
+\param handle
+    A handle to the BAG.
+\param type
+    The layer type.
+
+\return
+    The descriptor.
+    nullptr if the BAG has no such layer, or its descriptor is not a \e T.
+*/
+template <typename T>
+const T* findDescriptor(
+    const BagHandle& handle,
+    BAG_LAYER_TYPE type)
+{
+    return dynamic_cast<const T*>(
+        handle.dataset->getDescriptor().getLayerDescriptor(type, {}));
+}
+
 }  // namespace
 
 //! Open the specified BAG.
@@ -156,6 +282,153 @@ BagError bagFileOpen(
     return BAG_SUCCESS;
 }
 
+//! Open the specified BAG with options, such as the size of the chunk cache.
+/*!
+\param handle
+    A handle to the new BAG.
+    Cannot be NULL.
+\param accessMode
+    How to access the BAG.
+    Read only or reading and writing.
+\param fileName
+    The BAG file name, or an s3:// or https:// URL.
+    Cannot be NULL.
+\param options
+    The options to open the BAG with.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagFileOpenWithOptions(
+    BagHandle** handle,
+    BAG_OPEN_MODE accessMode,
+    const char* fileName,
+    const BagOpenOptions* options)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!fileName || !options)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    try
+    {
+        BAG::OpenOptions openOptions;
+        openOptions.chunkCache.size =
+            static_cast<size_t>(options->chunkCacheSize);
+        openOptions.chunkCache.slots =
+            static_cast<size_t>(options->chunkCacheSlots);
+        openOptions.chunkCache.preemption = options->chunkCachePreemption;
+        openOptions.concurrentReads = options->concurrentReads != 0;
+        openOptions.pageBufferSize =
+            static_cast<size_t>(options->pageBufferSize);
+        openOptions.collectIoStats = options->collectIoStats != 0;
+        if (options->awsRegion)
+            openOptions.remote.region = options->awsRegion;
+        if (options->awsAccessKeyId)
+            openOptions.remote.accessKeyId = options->awsAccessKeyId;
+        if (options->awsSecretAccessKey)
+            openOptions.remote.secretAccessKey = options->awsSecretAccessKey;
+
+        auto pHandle = std::make_unique<BagHandle>();
+
+        pHandle->dataset = BAG::Dataset::open(std::string{fileName}, accessMode,
+            openOptions);
+
+        *handle = pHandle.release();
+    }
+    catch(const BAG::ConcurrentReadsRequireReadOnly& /*e*/)
+    {
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+    }
+    catch(const BAG::RemoteReadsRequireReadOnly& /*e*/)
+    {
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+    }
+    catch(const std::exception& /*e*/)
+    {
+        return BAG_BAD_FILE_IO_OPERATION;
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Open the specified BAG read only, to be shared by several threads.
+/*!
+    Any number of threads may call bagRead(), bagReadInto() and
+    bagReadBatch() with the handle at the same time; the reads of the HDF5
+    file are serialized, but nothing else is.  Layer handles from
+    bagGetLayerHandle() may be shared as well.  Each thread keeps its own
+    bagGetLastError().  The handle must only be closed once no thread is
+    using it.
+
+\param handle
+    A handle to the new BAG.
+    Cannot be NULL.
+\param fileName
+    The BAG file name, or an s3:// or https:// URL.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagFileOpenShared(
+    BagHandle** handle,
+    const char* fileName)
+{
+    if (!handle)
+        return setLastError(BAG_INVALID_BAG_HANDLE);
+
+    if (!fileName)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    try
+    {
+        BAG::OpenOptions openOptions;
+        openOptions.concurrentReads = true;
+
+        auto pHandle = std::make_unique<BagHandle>();
+
+        pHandle->dataset = BAG::Dataset::open(std::string{fileName},
+            BAG_OPEN_READONLY, openOptions);
+
+        *handle = pHandle.release();
+    }
+    catch(const std::exception& e)
+    {
+        return setLastError(BAG_BAD_FILE_IO_OPERATION, e.what());
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Retrieve the error of the last call of this thread that failed.
+/*!
+    Only bagFileOpenShared(), bagGetLayerHandle(), bagRead(), bagReadInto(),
+    bagReadBatch() and bagFindCells() record their errors.  Successful calls leave the
+    error unchanged.
+
+\param message
+    What went wrong, when known; otherwise empty.  Valid until this thread
+    makes another call that fails.
+    May be NULL.
+
+\return
+    The error code of the last call that failed.
+    0 if none has.
+*/
+BagError bagGetLastError(
+    const char** message)
+{
+    if (message)
+        *message = lastErrorMessage.c_str();
+
+    return lastError;
+}
+
 //! Close the specified BAG.
 /*!
 \param handle
@@ -437,6 +710,128 @@ BagError bagGetGeoCover(
     return BAG_SUCCESS;
 }
 
+//! Set whether the layers of a BAG count and time their reads and writes.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param collect
+    \e true to collect I/O statistics.
+    \e false to stop collecting them.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagSetCollectIoStats(
+    BagHandle* handle,
+    bool collect)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    handle->dataset->setCollectIoStats(collect);
+
+    return BAG_SUCCESS;
+}
+
+//! Retrieve the I/O statistics of a BAG, totalled over its opened layers.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param stats
+    The I/O statistics.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagGetIoStats(
+    BagHandle* handle,
+    BagIoStats* stats)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!stats)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    const auto datasetStats = handle->dataset->getIoStats();
+
+    toBagIoStats(datasetStats.total, *stats);
+    stats->metadataCacheHitRate = datasetStats.metadataCacheHitRate;
+    stats->pageBufferHits = datasetStats.pageBufferHits;
+    stats->pageBufferMisses = datasetStats.pageBufferMisses;
+
+    return BAG_SUCCESS;
+}
+
+//! Retrieve the I/O statistics of a layer.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param type
+    The layer type.
+\param layerName
+    The case-insensitive name of the layer.
+    Optional unless retrieving a georeferenced metadata layer.
+\param stats
+    The I/O statistics.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagGetLayerIoStats(
+    BagHandle* handle,
+    BAG_LAYER_TYPE type,
+    const char* layerName,
+    BagIoStats* stats)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!stats)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
+        return BAG_GEOREF_METADATA_LAYER_NAME_MISSING;
+
+    const auto layer = handle->dataset->getLayer(type,
+        layerName ? layerName : "");
+    if (!layer)
+        return BAG_LAYER_MISSING;
+
+    toBagIoStats(layer->getIoStats(), *stats);
+
+    return BAG_SUCCESS;
+}
+
+//! Reset the I/O statistics of a BAG, and of its layers, to zero.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagResetIoStats(
+    BagHandle* handle)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    handle->dataset->resetIoStats();
+
+    return BAG_SUCCESS;
+}
+
 //! Retrieve the minimum and maximum value of a simple layer.
 /*!
 \param handle
@@ -467,11 +862,12 @@ BagError bagGetMinMaxSimple(
     if (!minValue || !maxValue)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto layer = handle->dataset->getSimpleLayer(type);
-    if (!layer)
+    const auto* pDescriptor = findDescriptor<BAG::SimpleLayerDescriptor>(
+        *handle, type);
+    if (!pDescriptor)
         return 9997;  // layer type not found
 
-    std::tie(*minValue, *maxValue) = layer->getDescriptor()->getMinMax();
+    std::tie(*minValue, *maxValue) = pDescriptor->getMinMax();
 
     return BAG_SUCCESS;
 }
@@ -504,86 +900,426 @@ BagError bagSetMinMaxSimple(
     if (!minValue || !maxValue)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto layer = handle->dataset->getSimpleLayer(type);
-    if (!layer)
-        return BAG_SIMPLE_LAYER_MISSING;
-
-    layer->getDescriptor()->setMinMax(minValue, maxValue);
+    auto layer = handle->dataset->getSimpleLayer(type);
+    if (!layer)
+        return BAG_SIMPLE_LAYER_MISSING;
+
+    layer->getDescriptor()->setMinMax(minValue, maxValue);
+
+    return BAG_SUCCESS;
+}
+
+//! Find the nodes of a simple layer whose values are in a range.
+/*!
+    Only the tiles of the layer that may hold such values are read; see
+    BAG::SimpleLayer::findCells().
+
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param layerHandle
+    A handle from bagGetLayerHandle() for a simple layer of the same BAG.
+    Cannot be NULL.
+\param window
+    The area to search; clipped to the layer.
+    NULL to search the whole layer.
+\param minValue
+    The smallest value looked for.
+\param maxValue
+    The largest value looked for.
+\param cells
+    The non null nodes whose values are from minValue to maxValue, in row
+    major order.
+    Must be freed with bagFreeCells().
+    Cannot be NULL.
+\param numCells
+    The number of nodes found.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagFindCells(
+    BagHandle* handle,
+    const BagLayerHandle* layerHandle,
+    const BagWindow* window,
+    float minValue,
+    float maxValue,
+    BagCell** cells,
+    uint32_t* numCells)
+{
+    if (!handle)
+        return setLastError(BAG_INVALID_BAG_HANDLE);
+
+    if (!layerHandle || !cells || !numCells)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    if (layerHandle->dataset != handle->dataset.get())
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    const auto* layer =
+        dynamic_cast<const BAG::SimpleLayer*>(layerHandle->layer.get());
+    if (!layer)
+        return setLastError(BAG_SIMPLE_LAYER_MISSING);
+
+    const BagWindow wholeLayer{0, 0, std::numeric_limits<uint32_t>::max(),
+        std::numeric_limits<uint32_t>::max()};
+    if (!window)
+        window = &wholeLayer;
+
+    try
+    {
+        const auto found = layer->findCells(minValue, maxValue,
+            window->rowStart, window->colStart, window->rowEnd,
+            window->colEnd);
+
+        *numCells = static_cast<uint32_t>(found.size());
+        *cells = new BAG::LayerCell[found.size()];
+        std::copy(found.begin(), found.end(), *cells);
+    }
+    catch(const BAG::InvalidReadSize& e)
+    {
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT, e.what());
+    }
+    catch(const std::exception& e)
+    {
+        return setLastError(BAG_HDF_READ_FAILURE, e.what());
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Free the nodes found by bagFindCells().
+/*!
+\param cells
+    The nodes to free.
+*/
+void bagFreeCells(
+    BagCell* cells)
+{
+    delete[] cells;
+}
+
+//! Retrieve the number of layers in the BAG.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param numLayers
+    The number of layers.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagGetNumLayers(
+    BagHandle* handle,
+    uint32_t* numLayers)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!numLayers)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    *numLayers = static_cast<uint32_t>(handle->dataset->getLayers().size());
+
+    return BAG_SUCCESS;
+}
+
+//! Determine if the specified layer and optional case-insensitive name exists.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param type
+    The layer type.
+\param layerName
+    The case-insensitive name of the layer.
+    Optional unless checking for a georeferenced metadata layer.
+\param bagError
+    BAG_SUCCESS if successful.
+    The error code, otherwise.
+    Cannot be NULL.
+
+\return
+    \e true if the BAG contains the specified layer
+    \e false otherwise
+*/
+bool bagContainsLayer(
+    BagHandle* handle,
+    BAG_LAYER_TYPE type,
+    const char* layerName,
+    BagError* bagError)
+{
+    if (!handle)
+    {
+        *bagError = BAG_INVALID_BAG_HANDLE;
+        return false;
+    }
+
+    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
+    {
+        *bagError = BAG_GEOREF_METADATA_LAYER_NAME_MISSING;
+        return false;
+    }
+
+    *bagError = BAG_SUCCESS;
+
+    return handle->dataset->getLayer(type, layerName) != nullptr;
+}
+
+//! Read a specific area of a BAG.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param rowStart
+    The starting row.
+\param colStart
+    The starting column.
+\param rowEnd
+    The end row (inclusive).
+\param colEnd
+    The end column (inclusive).
+\param type
+    The layer type.
+\param layerName
+    The case-insensitive name of the layer.
+    Optional unless checking for a georeferenced metadata layer.
+\param data
+    The buffer the BAG is read into.
+    data must be at least large enough to hold the specified number of rows and columns.
+    Cannot be NULL.
+\param x
+    The geographical position of the \e rowStart.
+    Cannot be NULL.
+\param y
+    The geographical position of the \e colStart.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagRead(
+    BagHandle* handle,
+    uint32_t rowStart,
+    uint32_t colStart,
+    uint32_t rowEnd,
+    uint32_t colEnd,
+    BAG_LAYER_TYPE type,
+    const char* layerName,
+    uint8_t** data,
+    double* x,
+    double* y)
+{
+    if (!handle)
+        return setLastError(BAG_INVALID_BAG_HANDLE);
+
+    if (!data)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    if (!x || !y)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
+        return setLastError(BAG_GEOREF_METADATA_LAYER_NAME_MISSING);
+
+    const auto layer = handle->dataset->getLayer(type,
+        layerName ? layerName : "");
+    if (!layer)
+        return setLastError(BAG_HDF_DATASET_OPEN_FAILURE);
+
+    try
+    {
+        auto buffer = layer->read(rowStart, colStart, rowEnd, colEnd);
+        *data = buffer.release();
+
+        // Get the position of the node.
+        std::tie(*x, *y) = handle->dataset->gridToGeo(rowStart, colStart);
+    }
+    catch(const BAG::InvalidReadSize& e)
+    {
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT, e.what());
+    }
+    catch(const std::exception& e)
+    {
+        return setLastError(BAG_HDF_READ_FAILURE, e.what());
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Look up a layer of a BAG once, for repeated reads.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param type
+    The layer type.
+\param layerName
+    The case-insensitive name of the layer.
+    Optional unless looking up a georeferenced metadata layer.
+\param layerHandle
+    The handle to the layer.
+    Must be freed with bagFreeLayerHandle().
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagGetLayerHandle(
+    BagHandle* handle,
+    BAG_LAYER_TYPE type,
+    const char* layerName,
+    BagLayerHandle** layerHandle)
+{
+    if (!handle)
+        return setLastError(BAG_INVALID_BAG_HANDLE);
+
+    if (!layerHandle)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
+        return setLastError(BAG_GEOREF_METADATA_LAYER_NAME_MISSING);
+
+    try
+    {
+        auto layer = handle->dataset->getLayer(type,
+            layerName ? layerName : "");
+        if (!layer)
+            return setLastError(BAG_HDF_DATASET_OPEN_FAILURE);
+
+        std::unique_ptr<BagLayerHandle> pLayerHandle{new BagLayerHandle};
+        pLayerHandle->dataset = handle->dataset.get();
+        pLayerHandle->layer = std::move(layer);
+
+        *layerHandle = pLayerHandle.release();
+    }
+    catch(const std::exception& e)
+    {
+        return setLastError(BAG_HDF_DATASET_OPEN_FAILURE, e.what());
+    }
+
+    return BAG_SUCCESS;
+}
+
+//! Free a layer handle created by bagGetLayerHandle().
+/*!
+\param layerHandle
+    The layer handle.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagFreeLayerHandle(
+    BagLayerHandle* layerHandle)
+{
+    if (!layerHandle)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    delete layerHandle;
 
     return BAG_SUCCESS;
 }
 
-//! Retrieve the number of layers in the BAG.
+//! Read a specific area of a layer into a caller owned buffer.
 /*!
+    Unlike bagRead(), nothing is allocated, and the layer is not looked up
+    again, so reading many small areas (such as one row at a time) is cheap.
+
 \param handle
     A handle to the BAG.
     Cannot be NULL.
-\param numLayers
-    The number of layers.
+\param layerHandle
+    A handle from bagGetLayerHandle() for the same BAG.
+    Cannot be NULL.
+\param window
+    The area to read.
     Cannot be NULL.
+\param data
+    The buffer to read into.  Must hold every row of the window, rowStride
+    bytes apart.
+    Cannot be NULL.
+\param rowStride
+    The distance, in bytes, between the start of two rows in data.
+    Zero means the rows are tightly packed.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagGetNumLayers(
+BagError bagReadInto(
     BagHandle* handle,
-    uint32_t* numLayers)
+    const BagLayerHandle* layerHandle,
+    const BagWindow* window,
+    void* data,
+    size_t rowStride)
 {
-    if (!handle)
-        return BAG_INVALID_BAG_HANDLE;
-
-    if (!numLayers)
-        return BAG_INVALID_FUNCTION_ARGUMENT;
-
-    *numLayers = static_cast<uint32_t>(handle->dataset->getLayers().size());
-
-    return BAG_SUCCESS;
+    return bagReadBatch(handle, layerHandle, window, 1, &data, rowStride);
 }
 
-//! Determine if the specified layer and optional case-insensitive name exists.
+//! Read several areas of a layer, each into its own caller owned buffer.
 /*!
 \param handle
     A handle to the BAG.
     Cannot be NULL.
-\param type
-    The layer type.
-\param layerName
-    The case-insensitive name of the layer.
-    Optional unless checking for a georeferenced metadata layer.
-\param bagError
-    BAG_SUCCESS if successful.
-    The error code, otherwise.
+\param layerHandle
+    A handle from bagGetLayerHandle() for the same BAG.
+    Cannot be NULL.
+\param windows
+    The areas to read.
+    Cannot be NULL.
+\param numWindows
+    The number of areas.
+\param data
+    The buffers to read each area into, in the order of windows.  Each must
+    hold every row of its window, rowStride bytes apart.
     Cannot be NULL.
+\param rowStride
+    The distance, in bytes, between the start of two rows in every buffer.
+    Zero means the rows are tightly packed.
 
 \return
-    \e true if the BAG contains the specified layer
-    \e false otherwise
+    0 if successful.
+    An error code otherwise; the areas after the one that failed are not
+    read.
 */
-bool bagContainsLayer(
+BagError bagReadBatch(
     BagHandle* handle,
-    BAG_LAYER_TYPE type,
-    const char* layerName,
-    BagError* bagError)
+    const BagLayerHandle* layerHandle,
+    const BagWindow* windows,
+    uint32_t numWindows,
+    void* const* data,
+    size_t rowStride)
 {
     if (!handle)
-    {
-        *bagError = BAG_INVALID_BAG_HANDLE;
-        return false;
-    }
+        return setLastError(BAG_INVALID_BAG_HANDLE);
 
-    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
+    if (!layerHandle || !windows || !data)
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    if (layerHandle->dataset != handle->dataset.get())
+        return setLastError(BAG_INVALID_FUNCTION_ARGUMENT);
+
+    for (uint32_t i = 0; i < numWindows; ++i)
     {
-        *bagError = BAG_GEOREF_METADATA_LAYER_NAME_MISSING;
-        return false;
+        const auto error = readWindowInto(*layerHandle->layer, windows[i],
+            data[i], rowStride);
+        if (error != BAG_SUCCESS)
+            return error;
     }
 
-    *bagError = BAG_SUCCESS;
-
-    return handle->dataset->getLayer(type, layerName) != nullptr;
+    return BAG_SUCCESS;
 }
 
-//! Read a specific area of a BAG.
+//! Read the same area of several layers of a BAG in one call.
 /*!
 \param handle
     A handle to the BAG.
@@ -596,61 +1332,53 @@ bool bagContainsLayer(
     The end row (inclusive).
 \param colEnd
     The end column (inclusive).
-\param type
-    The layer type.
-\param layerName
-    The case-insensitive name of the layer.
-    Optional unless checking for a georeferenced metadata layer.
+\param types
+    The types of the layers to read, in the order they are returned.
+    Cannot be NULL.
+\param numTypes
+    The number of layer types.
+\param layout
+    BAG_LAYOUT_PLANAR to return each layer as a contiguous block.
+    BAG_LAYOUT_INTERLEAVED to return the values of all layers for a node
+    next to each other.
 \param data
-    The buffer the BAG is read into.
-    data must be at least large enough to hold the specified number of rows and columns.
-    Cannot be NULL.
-\param x
-    The geographical position of the \e rowStart.
-    Cannot be NULL.
-\param y
-    The geographical position of the \e colStart.
+    The buffer the layers are read into.
+    Must be freed with bagFree().
     Cannot be NULL.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagRead(
+BagError bagReadLayers(
     BagHandle* handle,
     uint32_t rowStart,
     uint32_t colStart,
     uint32_t rowEnd,
     uint32_t colEnd,
-    BAG_LAYER_TYPE type,
-    const char* layerName,
-    uint8_t** data,
-    double* x,
-    double* y)
+    const BAG_LAYER_TYPE* types,
+    uint32_t numTypes,
+    BAG_LAYER_LAYOUT layout,
+    uint8_t** data)
 {
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    if (!data)
+    if (!data || !types || numTypes == 0)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    if (!x || !y)
+    if (layout != BAG_LAYOUT_PLANAR && layout != BAG_LAYOUT_INTERLEAVED)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    if (type == Georef_Metadata && (!layerName || layerName[0] == '\0'))
-        return BAG_GEOREF_METADATA_LAYER_NAME_MISSING;
-
-    const auto layer = handle->dataset->getLayer(type, layerName);
-    if (!layer)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
     try
     {
-        auto buffer = layer->read(rowStart, colStart, rowEnd, colEnd);
+        auto buffer = handle->dataset->readLayers(rowStart, colStart, rowEnd,
+            colEnd, {types, types + numTypes}, layout);
         *data = buffer.release();
-
-        // Get the position of the node.
-        std::tie(*x, *y) = handle->dataset->gridToGeo(rowStart, colStart);
+    }
+    catch(const BAG::LayerNotFound& /*e*/)
+    {
+        return BAG_HDF_DATASET_OPEN_FAILURE;
     }
     catch(const std::exception& /*e*/)
     {
@@ -1143,9 +1871,7 @@ BagError bagReadCorrectorVerticalDatum(
     if (!layer)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::SurfaceCorrectionsDescriptor>(
-            layer->getDescriptor());
+    const auto pDescriptor = layer->getDescriptor();
     const auto& allVerticalDatums = pDescriptor->getVerticalDatums();
 
     if (!allVerticalDatums.empty())
@@ -1206,8 +1932,7 @@ BagError bagWriteCorrectorVerticalDatum(
     if (!layer)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::SurfaceCorrectionsDescriptor>(
-        layer->getDescriptor());
+    auto pDescriptor = layer->getDescriptor();
 
     // Set/replace the specified datum.
     std::vector<std::string> datums;
@@ -1248,26 +1973,199 @@ BagError bagWriteCorrectorVerticalDatum(
     return BAG_SUCCESS;
 }
 
-//! Read a corrected simple layer.
+//! Read a corrected simple layer.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param corrector
+    The corrector to use.
+    Valid values are 1-10.
+\param type
+    The simple layer type.
+\param data
+    The buffer to place the corrected layer data into.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagReadCorrectedLayer(
+    BagHandle* handle,
+    uint8_t corrector,
+    BAG_LAYER_TYPE type,
+    float** data)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!data)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    const auto corrections = handle->dataset->getSurfaceCorrections();
+    if (!corrections)
+        return BAG_SURFACE_CORRECTIONS_MISSING;
+
+    const auto layer = handle->dataset->getSimpleLayer(type);
+    if (!layer)
+        return BAG_SIMPLE_LAYER_MISSING;
+
+    constexpr uint32_t rowStart = 0;
+    constexpr uint32_t columnStart = 0;
+
+    const auto& descriptor = handle->dataset->getDescriptor();
+
+    uint32_t rowEnd = 0;
+    uint32_t columnEnd = 0;
+    std::tie(rowEnd, columnEnd) = descriptor.getDims();
+
+    auto correctedData = corrections->readCorrected(rowStart, columnStart,
+        rowEnd - 1, columnEnd - 1, corrector, *layer);
+
+    *data = reinterpret_cast<float*>(correctedData.release());
+
+    return BAG_SUCCESS;
+}
+
+//! Read a corrected region from a simple layer.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param rowStart
+    The starting row.
+\param colStart
+    The starting column.
+\param rowEnd
+    The end row (inclusive).
+\param colEnd
+    The end column (inclusive).
+\param corrector
+    The corrector to use.
+    Valid values are 1-10.
+\param type
+    The simple layer type.
+\param data
+    The buffer to place the corrected layer into.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagReadCorrectedRegion(
+    BagHandle* handle,
+    uint32_t rowStart,
+    uint32_t colStart,
+    uint32_t rowEnd,
+    uint32_t colEnd,
+    uint8_t corrector,
+    BAG_LAYER_TYPE type,
+    float** data)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!data)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    const auto corrections = handle->dataset->getSurfaceCorrections();
+    if (!corrections)
+        return BAG_SURFACE_CORRECTIONS_MISSING;
+
+    const auto layer = handle->dataset->getSimpleLayer(type);
+    if (!layer)
+        return BAG_HDF_DATASET_OPEN_FAILURE;
+
+    auto correctedData = corrections->readCorrected(rowStart, colStart, rowEnd,
+        colEnd, corrector, *layer);
+
+    *data = reinterpret_cast<float*>(correctedData.release());
+
+    return BAG_SUCCESS;
+}
+
+//! Read a corrected row from a simple layer.
+/*!
+\param handle
+    A handle to the BAG.
+    Cannot be NULL.
+\param row
+    The row.
+\param corrector
+    The corrector to use.
+    Valid values are 1-10.
+\param type
+    The simple layer type.
+\param data
+    The buffer to place the corrected layer's row into.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagReadCorrectedRow(
+    BagHandle* handle,
+    uint32_t row,
+    uint8_t corrector,
+    BAG_LAYER_TYPE type,
+    float** data)
+{
+    if (!handle)
+        return BAG_INVALID_BAG_HANDLE;
+
+    if (!data)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    const auto corrections = handle->dataset->getSurfaceCorrections();
+    if (!corrections)
+        return BAG_SURFACE_CORRECTIONS_MISSING;
+
+    const auto layer = handle->dataset->getSimpleLayer(type);
+    if (!layer)
+        return BAG_HDF_DATASET_OPEN_FAILURE;
+
+    constexpr uint32_t columnStart = 0;
+
+    const auto& descriptor = handle->dataset->getDescriptor();
+    const auto columnEnd = std::get<1>(descriptor.getDims()) - 1;
+
+    auto correctedData = corrections->readCorrectedRow(row, columnStart,
+        columnEnd, corrector, *layer);
+
+    *data = reinterpret_cast<float*>(correctedData.release());
+
+    return BAG_SUCCESS;
+}
+
+//! Read a corrected node from a simple layer.
 /*!
 \param handle
     A handle to the BAG.
     Cannot be NULL.
+\param row
+    The row.
+\param column
+    The column.
 \param corrector
     The corrector to use.
     Valid values are 1-10.
 \param type
     The simple layer type.
 \param data
-    The buffer to place the corrected layer data into.
+    The buffer to place the corrected layer's row into.
     Cannot be NULL.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagReadCorrectedLayer(
+BagError bagReadCorrectedNode(
     BagHandle* handle,
+    uint32_t row,
+    uint32_t column,
     uint8_t corrector,
     BAG_LAYER_TYPE type,
     float** data)
@@ -1286,107 +2184,136 @@ BagError bagReadCorrectedLayer(
     if (!layer)
         return BAG_SIMPLE_LAYER_MISSING;
 
-    constexpr uint32_t rowStart = 0;
-    constexpr uint32_t columnStart = 0;
-
-    const auto& descriptor = handle->dataset->getDescriptor();
-
-    uint32_t rowEnd = 0;
-    uint32_t columnEnd = 0;
-    std::tie(rowEnd, columnEnd) = descriptor.getDims();
-
-    auto correctedData = corrections->readCorrected(rowStart, rowEnd - 1,
-        columnStart, columnEnd - 1, corrector, *layer);
+    auto correctedData = corrections->readCorrectedRow(row, column,
+        column, corrector, *layer);
 
     *data = reinterpret_cast<float*>(correctedData.release());
 
     return BAG_SUCCESS;
 }
 
-//! Read a corrected region from a simple layer.
+//! Create a context for repeated corrected reads of a BAG.
 /*!
+    The context holds what the corrected reads of a BAG can share, so
+    calling bagReadCorrectedRegionInto() or bagReadCorrectedRowInto() many
+    times does not redo it: which corrector nodes neighbour each node of a
+    gridded surface, and how far away they are.  The correctors themselves
+    are read once per BAG whether a context is used or not.
+
+    The context is only valid while the correctors and the BAG grid are
+    unchanged.
+
 \param handle
     A handle to the BAG.
     Cannot be NULL.
-\param rowStart
-    The starting row.
-\param colStart
-    The starting column.
-\param rowEnd
-    The end row (inclusive).
-\param colEnd
-    The end column (inclusive).
-\param corrector
-    The corrector to use.
-    Valid values are 1-10.
-\param type
-    The simple layer type.
-\param data
-    The buffer to place the corrected layer into.
+\param context
+    The new context.
+    Must be freed with bagFreeCorrectionContext().
     Cannot be NULL.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagReadCorrectedRegion(
+BagError bagCreateCorrectionContext(
     BagHandle* handle,
-    uint32_t rowStart,
-    uint32_t colStart,
-    uint32_t rowEnd,
-    uint32_t colEnd,
-    uint8_t corrector,
-    BAG_LAYER_TYPE type,
-    float** data)
+    BagCorrectionContext** context)
 {
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    if (!data)
+    if (!context)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
     const auto corrections = handle->dataset->getSurfaceCorrections();
     if (!corrections)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
-    const auto layer = handle->dataset->getSimpleLayer(type);
-    if (!layer)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    try
+    {
+        std::unique_ptr<BagCorrectionContext> pContext{new BagCorrectionContext};
+        pContext->dataset = handle->dataset.get();
+        pContext->isGridded = corrections->getDescriptor()->getSurfaceType() ==
+            BAG_SURFACE_GRID_EXTENTS;
 
-    auto correctedData = corrections->readCorrected(rowStart, colStart, rowEnd,
-        colEnd, corrector, *layer);
+        if (pContext->isGridded)
+            pContext->plan = corrections->createCorrectionPlan();
 
-    *data = reinterpret_cast<float*>(correctedData.release());
+        *context = pContext.release();
+    }
+    catch(const std::exception& /*e*/)
+    {
+        return BAG_HDF_READ_FAILURE;
+    }
 
     return BAG_SUCCESS;
 }
 
-//! Read a corrected row from a simple layer.
+//! Free a context created by bagCreateCorrectionContext().
+/*!
+\param context
+    The context.
+    Cannot be NULL.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagFreeCorrectionContext(
+    BagCorrectionContext* context)
+{
+    if (!context)
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
+    delete context;
+
+    return BAG_SUCCESS;
+}
+
+//! Read a corrected region from a simple layer into a caller owned buffer.
 /*!
 \param handle
     A handle to the BAG.
     Cannot be NULL.
-\param row
-    The row.
+\param context
+    A context from bagCreateCorrectionContext() for the same BAG.
+    NULL to correct without one.
+\param rowStart
+    The starting row.
+\param colStart
+    The starting column.
+\param rowEnd
+    The end row (inclusive).
+\param colEnd
+    The end column (inclusive).
 \param corrector
     The corrector to use.
     Valid values are 1-10.
 \param type
     The simple layer type.
 \param data
-    The buffer to place the corrected layer's row into.
+    The buffer to place the corrected region into.  Must hold every row of
+    the region, rowStride values apart.
     Cannot be NULL.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+    Zero means the rows are tightly packed.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagReadCorrectedRow(
+BagError bagReadCorrectedRegionInto(
     BagHandle* handle,
-    uint32_t row,
+    const BagCorrectionContext* context,
+    uint32_t rowStart,
+    uint32_t colStart,
+    uint32_t rowEnd,
+    uint32_t colEnd,
     uint8_t corrector,
     BAG_LAYER_TYPE type,
-    float** data)
+    float* data,
+    uint32_t rowStride)
 {
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
@@ -1394,77 +2321,84 @@ BagError bagReadCorrectedRow(
     if (!data)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
+    if (context && context->dataset != handle->dataset.get())
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+
     const auto corrections = handle->dataset->getSurfaceCorrections();
     if (!corrections)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
     const auto layer = handle->dataset->getSimpleLayer(type);
     if (!layer)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    constexpr uint32_t columnStart = 0;
-
-    const auto& descriptor = handle->dataset->getDescriptor();
-    const auto columnEnd = std::get<1>(descriptor.getDims());
-
-    auto correctedData = corrections->readCorrectedRow(row, columnStart,
-        columnEnd, corrector, *layer);
+        return BAG_SIMPLE_LAYER_MISSING;
 
-    *data = reinterpret_cast<float*>(correctedData.release());
+    try
+    {
+        if (context && context->isGridded)
+            corrections->readCorrectedInto(rowStart, colStart, rowEnd, colEnd,
+                corrector, *layer, context->plan, data, rowStride);
+        else
+            corrections->readCorrectedInto(rowStart, colStart, rowEnd, colEnd,
+                corrector, *layer, data, rowStride);
+    }
+    catch(const BAG::InvalidReadSize& /*e*/)
+    {
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+    }
+    catch(const BAG::InvalidCorrector& /*e*/)
+    {
+        return BAG_INVALID_FUNCTION_ARGUMENT;
+    }
+    catch(const std::exception& /*e*/)
+    {
+        return BAG_HDF_READ_FAILURE;
+    }
 
     return BAG_SUCCESS;
 }
 
-//! Read a corrected node from a simple layer.
+//! Read a corrected row from a simple layer into a caller owned buffer.
 /*!
 \param handle
     A handle to the BAG.
     Cannot be NULL.
+\param context
+    A context from bagCreateCorrectionContext() for the same BAG.
+    NULL to correct without one.
 \param row
     The row.
-\param column
-    The column.
 \param corrector
     The corrector to use.
     Valid values are 1-10.
 \param type
     The simple layer type.
 \param data
-    The buffer to place the corrected layer's row into.
+    The buffer to place the corrected row into.  Must hold a value for
+    every column.
     Cannot be NULL.
 
 \return
     0 if successful.
     An error code otherwise.
 */
-BagError bagReadCorrectedNode(
+BagError bagReadCorrectedRowInto(
     BagHandle* handle,
+    const BagCorrectionContext* context,
     uint32_t row,
-    uint32_t column,
     uint8_t corrector,
     BAG_LAYER_TYPE type,
-    float** data)
+    float* data)
 {
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    if (!data)
+    const auto& descriptor = handle->dataset->getDescriptor();
+    const auto numColumns = std::get<1>(descriptor.getDims());
+    if (numColumns == 0)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto corrections = handle->dataset->getSurfaceCorrections();
-    if (!corrections)
-        return BAG_SURFACE_CORRECTIONS_MISSING;
-
-    const auto layer = handle->dataset->getSimpleLayer(type);
-    if (!layer)
-        return BAG_SIMPLE_LAYER_MISSING;
-
-    auto correctedData = corrections->readCorrectedRow(row, column,
-        column, corrector, *layer);
-
-    *data = reinterpret_cast<float*>(correctedData.release());
-
-    return BAG_SUCCESS;
+    return bagReadCorrectedRegionInto(handle, context, row, 0, row,
+        numColumns - 1, corrector, type, data, 0);
 }
 
 //! Retrieve the number of correctors.
@@ -1494,11 +2428,7 @@ BagError bagGetNumSurfaceCorrectors(
     if (!layer)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::SurfaceCorrectionsDescriptor>(
-            layer->getDescriptor());
-    if (!pDescriptor)
-        return BAG_WRONG_DESCRIPTOR_FOUND;
+    const auto pDescriptor = layer->getDescriptor();
 
     *numCorrectors = pDescriptor->getNumCorrectors();
 
@@ -1532,11 +2462,7 @@ BagError bagGetSurfaceCorrectionTopography(
     if (!layer)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::SurfaceCorrectionsDescriptor>(
-            layer->getDescriptor());
-    if (!pDescriptor)
-        return BAG_WRONG_DESCRIPTOR_FOUND;
+    const auto pDescriptor = layer->getDescriptor();
 
     *type = pDescriptor->getSurfaceType();
 
@@ -1566,17 +2492,18 @@ BagError bagCreateCorrectorLayer(
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    // Get chunkSize & compressionLevel from the elevation layer.
+    // Get the chunk shape & compression from the elevation layer.
     const auto elevationLayer = handle->dataset->getSimpleLayer(Elevation);
     if (!elevationLayer)
         return BAG_SIMPLE_LAYER_MISSING;
 
     auto pDescriptor = elevationLayer->getDescriptor();
-    const auto chunkSize = pDescriptor->getChunkSize();
-    const auto compressionLevel = pDescriptor->getCompressionLevel();
+    BAG::ChunkShape chunkShape;
+    std::tie(chunkShape.rows, chunkShape.columns) = pDescriptor->getChunkDims();
+    const auto& compression = pDescriptor->getCompressionSpec();
 
     handle->dataset->createSurfaceCorrections(topography, numCorrectors,
-        chunkSize, compressionLevel);
+        chunkShape, compression);
 
     return BAG_SUCCESS;
 }
@@ -1608,11 +2535,7 @@ BagError bagWriteCorrectorDefinition(
     if (!corrections)
         return BAG_SURFACE_CORRECTIONS_MISSING;
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<BAG::SurfaceCorrectionsDescriptor>(
-            corrections->getDescriptor());
-    if (!pDescriptor)
-        return BAG_WRONG_DESCRIPTOR_FOUND;
+    auto pDescriptor = corrections->getDescriptor();
 
     pDescriptor->setOrigin(def->swCornerX, def->swCornerY)
         .setSpacing(def->nodeSpacingX, def->nodeSpacingY);
@@ -1656,11 +2579,7 @@ BagError bagReadCorrectorDefinition(
     if (!corrections)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<BAG::SurfaceCorrectionsDescriptor>(
-            corrections->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = corrections->getDescriptor();
 
     std::tie(def->swCornerX, def->swCornerY) = pDescriptor->getOrigin();
     std::tie(def->nodeSpacingX, def->nodeSpacingY) = pDescriptor->getSpacing();
@@ -1732,19 +2651,12 @@ BagError bagReadTrackingListNode(
 
     const auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::TrackingItem> results;
-
-    std::copy_if(cbegin(trackingList), cend(trackingList),
-        std::back_inserter(results),
-        [row, col](const BAG::TrackingItem& item) {
-            return item.row == row && item.col == col;
-        });
+    const auto results = trackingList.getItemsAtNode(row, col);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::TrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -1781,19 +2693,12 @@ BagError bagReadTrackingListCode(
 
     const auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::TrackingItem> results;
-
-    std::copy_if(cbegin(trackingList), cend(trackingList),
-        std::back_inserter(results),
-        [code](const BAG::TrackingItem& item) {
-            return item.track_code == code;
-        });
+    const auto results = trackingList.getItemsWithCode(code);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::TrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -1830,19 +2735,12 @@ BagError bagReadTrackingListSeries(
 
     const auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::TrackingItem> results;
-
-    std::copy_if(cbegin(trackingList), cend(trackingList),
-        std::back_inserter(results),
-        [series](const BAG::TrackingItem& item) {
-            return item.list_series == series;
-        });
+    const auto results = trackingList.getItemsInSeries(series);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::TrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -1903,12 +2801,7 @@ BagError bagSortTrackingListByNode(BagHandle* handle)
 
     auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(trackingList), end(trackingList),
-        [](const BAG::TrackingItem& lhs, const BAG::TrackingItem& rhs) {
-            return (lhs.row >= rhs.row) && (lhs.col >= rhs.col);
-        });
+    trackingList.sortByNode(true);
 
     try
     {
@@ -1939,12 +2832,7 @@ BagError bagSortTrackingListBySeries(BagHandle* handle)
 
     auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(trackingList), end(trackingList),
-        [](const BAG::TrackingItem& lhs, const BAG::TrackingItem& rhs) {
-            return lhs.list_series > rhs.list_series;
-        });
+    trackingList.sortBySeries(true);
 
     try
     {
@@ -1975,12 +2863,7 @@ BagError bagSortTrackingListByCode(BagHandle* handle)
 
     auto& trackingList = handle->dataset->getTrackingList();
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(trackingList), end(trackingList),
-        [](const BAG::TrackingItem& lhs, const BAG::TrackingItem& rhs) {
-            return lhs.track_code > rhs.track_code;
-        });
+    trackingList.sortByCode(true);
 
     try
     {
@@ -2031,6 +2914,21 @@ BagError bagSetHomeFolder(const char* metadataFolder)
     return BAG_SUCCESS;
 }
 
+//! Free the metadata schemas kept by earlier validations.
+/*!
+    The next validation parses its schema again.
+
+\return
+    0 if successful.
+    An error code otherwise.
+*/
+BagError bagClearSchemaCache(void)
+{
+    BAG::bagClearSchemaCache();
+
+    return BAG_SUCCESS;
+}
+
 // GeorefMetadataLayer
 //! Create a georeferenced metadata layer.
 /*!
@@ -2069,14 +2967,15 @@ BagError bagCreateGeorefMetadataLayer(
     if (!layerName || !definition || numFields < 1)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    // Get the chunkSize & compressionLevel from the elevation layer.
+    // Get the chunk shape & compression from the elevation layer.
     const auto elevationLayer = handle->dataset->getSimpleLayer(Elevation);
     if (!elevationLayer)
         return BAG_SIMPLE_LAYER_MISSING;
 
     auto pDescriptor = elevationLayer->getDescriptor();
-    const auto chunkSize = pDescriptor->getChunkSize();
-    const auto compressionLevel = pDescriptor->getCompressionLevel();
+    BAG::ChunkShape chunkShape;
+    std::tie(chunkShape.rows, chunkShape.columns) = pDescriptor->getChunkDims();
+    const auto& compression = pDescriptor->getCompressionSpec();
 
     // Convert the FieldDefinition* into a RecordDefinition.
     const BAG::RecordDefinition recordDef(definition, definition + numFields);
@@ -2084,7 +2983,7 @@ BagError bagCreateGeorefMetadataLayer(
     try
     {
         handle->dataset->createGeorefMetadataLayer(indexType, profile, layerName, recordDef,
-                                                   chunkSize, compressionLevel);
+                                                   chunkShape, compression);
     }
     catch(const std::exception& /*e*/)
     {
@@ -2120,21 +3019,22 @@ BAG_EXTERNAL BagError bagCreateMetadataProfileGeorefMetadataLayer(BagHandle* han
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    // Get the chunkSize & compressionLevel from the elevation layer.
+    // Get the chunk shape & compression from the elevation layer.
     const auto elevationLayer = handle->dataset->getSimpleLayer(Elevation);
     if (!elevationLayer)
         return BAG_SIMPLE_LAYER_MISSING;
 
     auto pDescriptor = elevationLayer->getDescriptor();
-    const auto chunkSize = pDescriptor->getChunkSize();
-    const auto compressionLevel = pDescriptor->getCompressionLevel();
+    BAG::ChunkShape chunkShape;
+    std::tie(chunkShape.rows, chunkShape.columns) = pDescriptor->getChunkDims();
+    const auto& compression = pDescriptor->getCompressionSpec();
 
     try
     {
         handle->dataset->createGeorefMetadataLayer(profile,
                                                    layerName,
-                                                   chunkSize,
-                                                   compressionLevel,
+                                                   chunkShape,
+                                                   compression,
                                                    indexType);
     }
     catch(const std::exception& /*e*/)
@@ -2234,39 +3134,65 @@ BagError bagGetGeorefMetadataLayerRecords(
     if (!georefMetadataLayer)
         return BAG_GEOREF_METADATA_LAYER_MISSING;
 
-    const auto& recs = georefMetadataLayer->getValueTable().getRecords();
-    if (recs.size() == 1)  // No user defined records; just the single no data value record.
+    const auto& valueTable = georefMetadataLayer->getValueTable();
+    const auto& definition = valueTable.getDefinition();
+    const auto numRecs = valueTable.getNumRecords();
+
+    *numFields = static_cast<uint32_t>(definition.size());
+
+    if (numRecs <= 1)  // No user defined records; just the single no data value record.
     {
         *numRecords = 0;
-        *numFields = static_cast<uint32_t>(
-            georefMetadataLayer->getValueTable().getDefinition().size());
-
         *records = nullptr;
 
         return BAG_SUCCESS;
     }
 
-    // Convert the Records into a BagCompoundDataType*.
-    *numRecords = static_cast<uint32_t>(recs.size());
-    *numFields = static_cast<uint32_t>(recs[0].size());
+    // Copy the values straight out of the value table, without decoding the
+    // records into CompoundDataTypes first.
+    *numRecords = static_cast<uint32_t>(numRecs);
 
     // Allocate the records.
     auto** pRecords = new BagCompoundDataType*[*numRecords];
-    size_t recordIndex = 0;
 
-    for (const auto& rec : recs)
+    for (size_t recordIndex=0; recordIndex<numRecs; ++recordIndex)
     {
         // Allocate the fields.
         auto pRecord = new BagCompoundDataType[*numFields];
-        pRecords[recordIndex++] = pRecord;
+        pRecords[recordIndex] = pRecord;
 
-        size_t fieldIndex = 0;
-
-        for (const auto& field : rec)
+        for (size_t fieldIndex=0; fieldIndex<definition.size(); ++fieldIndex)
         {
             // Copy the field
-            auto& outField = pRecord[fieldIndex++];
-            outField = getValue(field);
+            auto& outField = pRecord[fieldIndex];
+            outField.type = static_cast<BAG_DATA_TYPE>(
+                definition[fieldIndex].type);
+
+            switch (outField.type)
+            {
+            case DT_FLOAT32:
+                outField.data.f = valueTable.getFloat(recordIndex, fieldIndex);
+                break;
+            case DT_UINT32:
+                outField.data.ui32 = valueTable.getUInt32(recordIndex,
+                    fieldIndex);
+                break;
+            case DT_BOOLEAN:
+                outField.data.b = valueTable.getBool(recordIndex, fieldIndex);
+                break;
+            case DT_STRING:  // Copy the string as it will go out of scope.
+            {
+                const char* const value = valueTable.getString(recordIndex,
+                    fieldIndex);
+                const auto fieldLen = strlen(value) + 1;
+                outField.data.c = new char[fieldLen];
+                memcpy(outField.data.c, value, fieldLen);
+                break;
+            }
+            default:
+                outField.type = DT_UNKNOWN_DATA_TYPE;
+                break;
+            }
         }
     }
 
@@ -2782,18 +3708,18 @@ BagError bagCreateVRLayers(
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    //  Get chunkSize & compressionLevel from the elevation layer.
+    //  Get chunkSize & compression from the elevation layer.
     const auto elevationLayer = handle->dataset->getSimpleLayer(Elevation);
     if (!elevationLayer)
         return BAG_SIMPLE_LAYER_MISSING;
 
     auto pDescriptor = elevationLayer->getDescriptor();
     const auto chunkSize = pDescriptor->getChunkSize();
-    const auto compressionLevel = pDescriptor->getCompressionLevel();
+    const auto& compression = pDescriptor->getCompressionSpec();
 
     try
     {
-        handle->dataset->createVR(chunkSize, compressionLevel, makeNode);
+        handle->dataset->createVR(chunkSize, compression, makeNode);
     }
     catch(const BAG::ReadOnlyError& /*e*/)
     {
@@ -2835,13 +3761,8 @@ BagError bagVRMetadataGetMinDimensions(
     if (!minX || !minY)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto vrMetadata = handle->dataset->getVRMetadata();
-    if (!vrMetadata)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::VRMetadataDescriptor>(
-            vrMetadata->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRMetadataDescriptor>(
+        *handle, VarRes_Metadata);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -2877,17 +3798,12 @@ BagError bagVRMetadataGetMaxDimensions(
     if (!maxX || !maxY)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto vrMetadata = handle->dataset->getVRMetadata();
-    if (!vrMetadata)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::VRMetadataDescriptor>(
-            vrMetadata->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRMetadataDescriptor>(
+        *handle, VarRes_Metadata);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    std::tie(*maxX, *maxY) = pDescriptor->getMinDimensions();
+    std::tie(*maxX, *maxY) = pDescriptor->getMaxDimensions();
 
     return BAG_SUCCESS;
 }
@@ -2919,13 +3835,8 @@ BagError bagVRMetadataGetMinResolution(
     if (!minX || !minY)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto vrMetadata = handle->dataset->getVRMetadata();
-    if (!vrMetadata)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const BAG::VRMetadataDescriptor>(
-            vrMetadata->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRMetadataDescriptor>(
+        *handle, VarRes_Metadata);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -2961,12 +3872,8 @@ BagError bagVRMetadataGetMaxResolution(
     if (!maxX || !maxY)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    const auto vrMetadata = handle->dataset->getVRMetadata();
-    if (!vrMetadata)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<const BAG::VRMetadataDescriptor>(
-        vrMetadata->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRMetadataDescriptor>(
+        *handle, VarRes_Metadata);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3001,10 +3908,7 @@ BagError bagVRMetadataSetMinDimensions(
     if (!vrMetadata)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRMetadataDescriptor>(
-        vrMetadata->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrMetadata->getDescriptor();
 
     pDescriptor->setMinDimensions(minX, minY);
 
@@ -3054,10 +3958,7 @@ BagError bagVRMetadataSetMaxDimensions(
     if (!vrMetadata)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRMetadataDescriptor>(
-        vrMetadata->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrMetadata->getDescriptor();
 
     pDescriptor->setMaxDimensions(maxX, maxY);
 
@@ -3107,10 +4008,7 @@ BagError bagVRMetadataSetMinResolution(
     if (!vrMetadata)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRMetadataDescriptor>(
-        vrMetadata->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrMetadata->getDescriptor();
 
     pDescriptor->setMinResolution(minX, minY);
 
@@ -3160,10 +4058,7 @@ BagError bagVRMetadataSetMaxResolution(
     if (!vrMetadata)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRMetadataDescriptor>(
-        vrMetadata->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrMetadata->getDescriptor();
 
     pDescriptor->setMaxResolution(maxX, maxY);
 
@@ -3215,12 +4110,8 @@ BagError bagVRNodeGetMinMaxHypStrength(
     if (!minHypStr || !maxHypStr)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto vrNode = handle->dataset->getVRNode();
-    if (!vrNode)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRNodeDescriptor>(*handle,
+        VarRes_Node);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3256,12 +4147,8 @@ BagError bagVRNodeGetMinMaxNumHypotheses(
     if (!minNumHyp || !maxNumHyp)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto vrNode = handle->dataset->getVRNode();
-    if (!vrNode)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRNodeDescriptor>(*handle,
+        VarRes_Node);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3297,12 +4184,8 @@ BagError bagVRNodeGetMinMaxNSamples(
     if (!minNSamples || !maxNSamples)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto vrNode = handle->dataset->getVRNode();
-    if (!vrNode)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRNodeDescriptor>(*handle,
+        VarRes_Node);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3333,14 +4216,11 @@ BagError bagVRNodeSetMinMaxHypStrength(
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    auto vrNode = handle->dataset->getVRMetadata();
+    auto vrNode = handle->dataset->getVRNode();
     if (!vrNode)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrNode->getDescriptor();
 
     pDescriptor->setMinMaxHypStrength(minHypStr, maxHypStr);
 
@@ -3386,14 +4266,11 @@ BagError bagVRNodeSetMinMaxNumHypotheses(
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    auto vrNode = handle->dataset->getVRMetadata();
+    auto vrNode = handle->dataset->getVRNode();
     if (!vrNode)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrNode->getDescriptor();
 
     pDescriptor->setMinMaxNumHypotheses(minNumHyp, maxNumHyp);
 
@@ -3439,14 +4316,11 @@ BagError bagVRNodeSetMinMaxNSamples(
     if (!handle)
         return BAG_INVALID_BAG_HANDLE;
 
-    auto vrNode = handle->dataset->getVRMetadata();
+    auto vrNode = handle->dataset->getVRNode();
     if (!vrNode)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRNodeDescriptor>(
-        vrNode->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrNode->getDescriptor();
 
     pDescriptor->setMinMaxNSamples(minNSamples, maxNSamples);
 
@@ -3498,12 +4372,8 @@ BAG_EXTERNAL BagError bagVRRefinementGetMinMaxDepth(
     if (!minDepth || !maxDepth)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto vrRefinement = handle->dataset->getVRRefinements();
-    if (!vrRefinement)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRRefinementsDescriptor>(
-        vrRefinement->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRRefinementsDescriptor>(
+        *handle, VarRes_Refinement);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3539,12 +4409,8 @@ BAG_EXTERNAL BagError bagVRRefinementGetMinMaxUncertainty(
     if (!minUncert || !maxUncert)
         return BAG_INVALID_FUNCTION_ARGUMENT;
 
-    auto vrRefinement = handle->dataset->getVRRefinements();
-    if (!vrRefinement)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
-
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRRefinementsDescriptor>(
-        vrRefinement->getDescriptor());
+    const auto* pDescriptor = findDescriptor<BAG::VRRefinementsDescriptor>(
+        *handle, VarRes_Refinement);
     if (!pDescriptor)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
@@ -3579,10 +4445,7 @@ BAG_EXTERNAL BagError bagVRRefinementSetMinMaxDepth(
     if (!vrRefinement)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRRefinementsDescriptor>(
-        vrRefinement->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrRefinement->getDescriptor();
 
     pDescriptor->setMinMaxDepth(minDepth, maxDepth);
 
@@ -3632,10 +4495,7 @@ BAG_EXTERNAL BagError bagVRRefinementSetMinMaxUncertainty(
     if (!vrRefinement)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    auto pDescriptor = std::dynamic_pointer_cast<BAG::VRRefinementsDescriptor>(
-        vrRefinement->getDescriptor());
-    if (!pDescriptor)
-        return BAG_HDF_DATASET_OPEN_FAILURE;
+    auto pDescriptor = vrRefinement->getDescriptor();
 
     pDescriptor->setMinMaxUncertainty(minUncert, maxUncert);
 
@@ -3729,19 +4589,12 @@ BagError bagReadVRTrackingListNode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::VRTrackingItem> results;
-
-    std::copy_if(cbegin(*vrTrackingList), cend(*vrTrackingList),
-        std::back_inserter(results),
-        [row, col](const BAG::VRTrackingItem& item) {
-            return item.row == row && item.col == col;
-        });
+    const auto results = vrTrackingList->getItemsAtNode(row, col);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::VRTrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -3783,19 +4636,12 @@ BagError bagReadVRTrackingListSubNode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::VRTrackingItem> results;
-
-    std::copy_if(cbegin(*vrTrackingList), cend(*vrTrackingList),
-        std::back_inserter(results),
-        [row, col](const BAG::VRTrackingItem& item) {
-            return item.sub_row == row && item.sub_col == col;
-        });
+    const auto results = vrTrackingList->getItemsAtSubNode(row, col);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::VRTrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -3834,19 +4680,12 @@ BagError bagReadVRTrackingListCode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::VRTrackingItem> results;
-
-    std::copy_if(cbegin(*vrTrackingList), cend(*vrTrackingList),
-        std::back_inserter(results),
-        [code](const BAG::VRTrackingItem& item) {
-            return item.track_code == code;
-        });
+    const auto results = vrTrackingList->getItemsWithCode(code);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::VRTrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -3885,19 +4724,12 @@ BagError bagReadVRTrackingListSeries(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::cbegin;  using std::cend;
-    std::vector<BAG::VRTrackingItem> results;
-
-    std::copy_if(cbegin(*vrTrackingList), cend(*vrTrackingList),
-        std::back_inserter(results),
-        [series](const BAG::VRTrackingItem& item) {
-            return item.list_series == series;
-        });
+    const auto results = vrTrackingList->getItemsInSeries(series);
 
     *numItems = static_cast<uint32_t>(results.size());
 
     *items = new BAG::VRTrackingItem[*numItems];
-    memcpy(*items, results.data(), *numItems);
+    std::copy(results.begin(), results.end(), *items);
 
     return BAG_SUCCESS;
 }
@@ -3971,12 +4803,7 @@ BagError bagSortVRTrackingListByNode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(*vrTrackingList), end(*vrTrackingList),
-        [](const BAG::VRTrackingItem& lhs, const BAG::VRTrackingItem& rhs) {
-            return (lhs.row >= rhs.row) && (lhs.col >= rhs.col);
-        });
+    vrTrackingList->sortByNode(true);
 
     try
     {
@@ -4018,12 +4845,7 @@ BagError bagSortVRTrackingListBySubNode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(*vrTrackingList), end(*vrTrackingList),
-        [](const BAG::VRTrackingItem& lhs, const BAG::VRTrackingItem& rhs) {
-            return (lhs.sub_row >= rhs.sub_row) && (lhs.sub_col >= rhs.sub_col);
-        });
+    vrTrackingList->sortBySubNode(true);
 
     try
     {
@@ -4065,12 +4887,7 @@ BagError bagSortVRTrackingListBySeries(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(*vrTrackingList), end(*vrTrackingList),
-        [](const BAG::VRTrackingItem& lhs, const BAG::VRTrackingItem& rhs) {
-            return lhs.list_series > rhs.list_series;
-        });
+    vrTrackingList->sortBySeries(true);
 
     try
     {
@@ -4112,12 +4929,7 @@ BagError bagSortVRTrackingListByCode(
     if (!vrTrackingList)
         return BAG_HDF_DATASET_OPEN_FAILURE;
 
-    using std::begin;  using std::end;
-
-    std::sort(begin(*vrTrackingList), end(*vrTrackingList),
-        [](const BAG::VRTrackingItem& lhs, const BAG::VRTrackingItem& rhs) {
-            return lhs.track_code > rhs.track_code;
-        });
+    vrTrackingList->sortByCode(true);
 
     try
     {
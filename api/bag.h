@@ -54,6 +54,8 @@
 
 
 typedef struct BagHandle* Handle;
+struct BagCorrectionContext;
+struct BagLayerHandle;
 
 /* Function prototypes */
 
@@ -63,6 +65,8 @@ BAG_EXTERNAL BagError bagCreateFromFile(BagHandle** handle, const char* fileName
 BAG_EXTERNAL BagError bagCreateLayer(BagHandle* handle, BAG_LAYER_TYPE type);
 BAG_EXTERNAL BagError bagFileClose(BagHandle* handle);
 BAG_EXTERNAL BagError bagFileOpen(BagHandle** handle, BAG_OPEN_MODE accessMode, const char* fileName);
+BAG_EXTERNAL BagError bagFileOpenWithOptions(BagHandle** handle, BAG_OPEN_MODE accessMode, const char* fileName, const BagOpenOptions* options);
+BAG_EXTERNAL BagError bagFileOpenShared(BagHandle** handle, const char* fileName);
 BAG_EXTERNAL BagError bagGetGeoCover(BagHandle* handle, double* llx, double* lly, double* urx, double* ury);
 BAG_EXTERNAL BagError bagGetGridDimensions(BagHandle* handle, uint32_t* rows, uint32_t* cols);
 BAG_EXTERNAL BagError bagGetSpacing(BagHandle* handle, double* rowSpacing, double* columnSpacing);
@@ -71,14 +75,28 @@ BAG_EXTERNAL BagError bagGetSpacing(BagHandle* handle, double* rowSpacing, doubl
 BAG_EXTERNAL BagError bagGetNumLayers(BagHandle* handle, uint32_t* numLayers);
 BAG_EXTERNAL bool bagContainsLayer(BagHandle* handle, BAG_LAYER_TYPE type, const char* layerName, BagError* bagError);
 BAG_EXTERNAL BagError bagRead(BagHandle* handle, uint32_t rowStart, uint32_t colStart, uint32_t rowEnd, uint32_t colEnd, BAG_LAYER_TYPE type, const char* layerName, uint8_t** data, double* x, double* y);
+BAG_EXTERNAL BagError bagReadLayers(BagHandle* handle, uint32_t rowStart, uint32_t colStart, uint32_t rowEnd, uint32_t colEnd, const BAG_LAYER_TYPE* types, uint32_t numTypes, BAG_LAYER_LAYOUT layout, uint8_t** data);
+BAG_EXTERNAL BagError bagGetLayerHandle(BagHandle* handle, BAG_LAYER_TYPE type, const char* layerName, BagLayerHandle** layerHandle);
+BAG_EXTERNAL BagError bagFreeLayerHandle(BagLayerHandle* layerHandle);
+BAG_EXTERNAL BagError bagReadInto(BagHandle* handle, const BagLayerHandle* layerHandle, const BagWindow* window, void* data, size_t rowStride);
+BAG_EXTERNAL BagError bagReadBatch(BagHandle* handle, const BagLayerHandle* layerHandle, const BagWindow* windows, uint32_t numWindows, void* const* data, size_t rowStride);
 BAG_EXTERNAL BagError bagWrite(BagHandle* handle, uint32_t rowStart, uint32_t colStart, uint32_t rowEnd, uint32_t colEnd, BAG_LAYER_TYPE type, const char* layerName, uint8_t* data);
 
+/* I/O statistics */
+BAG_EXTERNAL BagError bagSetCollectIoStats(BagHandle* handle, bool collect);
+BAG_EXTERNAL BagError bagGetIoStats(BagHandle* handle, BagIoStats* stats);
+BAG_EXTERNAL BagError bagGetLayerIoStats(BagHandle* handle, BAG_LAYER_TYPE type, const char* layerName, BagIoStats* stats);
+BAG_EXTERNAL BagError bagResetIoStats(BagHandle* handle);
+
 /* Simple layer access */
 BAG_EXTERNAL BagError bagGetMinMaxSimple(BagHandle* handle, BAG_LAYER_TYPE type, float* minValue, float* maxValue);
 BAG_EXTERNAL BagError bagSetMinMaxSimple(BagHandle* handle, BAG_LAYER_TYPE type, float minValue, float maxValue);
+BAG_EXTERNAL BagError bagFindCells(BagHandle* handle, const BagLayerHandle* layerHandle, const BagWindow* window, float minValue, float maxValue, BagCell** cells, uint32_t* numCells);
+BAG_EXTERNAL void bagFreeCells(BagCell* cells);
 
 /* Utilities */
 BAG_EXTERNAL BagError bagGetErrorString(BagError code, uint8_t** error);
+BAG_EXTERNAL BagError bagGetLastError(const char** message);
 BAG_EXTERNAL BagError bagComputePostion(BagHandle* handle, uint32_t row, uint32_t col, double* x, double* y);
 BAG_EXTERNAL BagError bagComputeIndex(BagHandle* handle, double x, double y, uint32_t* row, uint32_t* col);
 BAG_EXTERNAL uint8_t* bagAllocateBuffer(BagHandle* handle, uint32_t numRows, uint32_t numCols, BAG_LAYER_TYPE type, const char* layerName, BagError* bagError);
@@ -92,6 +110,10 @@ BAG_EXTERNAL BagError bagReadCorrectedLayer(BagHandle* handle, uint8_t corrector
 BAG_EXTERNAL BagError bagReadCorrectedRegion(BagHandle* handle, uint32_t rowStart, uint32_t colStart, uint32_t rowEnd, uint32_t colEnd, uint8_t corrector, BAG_LAYER_TYPE type, float** data);
 BAG_EXTERNAL BagError bagReadCorrectedRow(BagHandle* handle, uint32_t row, uint8_t corrector, BAG_LAYER_TYPE type, float** data);
 BAG_EXTERNAL BagError bagReadCorrectedNode(BagHandle* handle, uint32_t row, uint32_t col, uint8_t corrector, BAG_LAYER_TYPE type, float** data);
+BAG_EXTERNAL BagError bagCreateCorrectionContext(BagHandle* handle, BagCorrectionContext** context);
+BAG_EXTERNAL BagError bagFreeCorrectionContext(BagCorrectionContext* context);
+BAG_EXTERNAL BagError bagReadCorrectedRegionInto(BagHandle* handle, const BagCorrectionContext* context, uint32_t rowStart, uint32_t colStart, uint32_t rowEnd, uint32_t colEnd, uint8_t corrector, BAG_LAYER_TYPE type, float* data, uint32_t rowStride);
+BAG_EXTERNAL BagError bagReadCorrectedRowInto(BagHandle* handle, const BagCorrectionContext* context, uint32_t row, uint8_t corrector, BAG_LAYER_TYPE type, float* data);
 BAG_EXTERNAL BagError bagGetNumSurfaceCorrectors(BagHandle* handle, uint8_t* numCorrectors);
 BAG_EXTERNAL BagError bagGetSurfaceCorrectionTopography(BagHandle* handle, BAG_SURFACE_CORRECTION_TOPOGRAPHY* topography);
 BAG_EXTERNAL BagError bagCreateCorrectorLayer(BagHandle* handle, uint8_t numCorrectors, BAG_SURFACE_CORRECTION_TOPOGRAPHY topography);
@@ -113,6 +135,7 @@ BAG_EXTERNAL BagError bagSortTrackingListByCode(BagHandle* handle);
 //BAG_EXTERNAL BagError bagFreeMetadata(BagHandle* handle, BagMetadata* metadata);
 BAG_EXTERNAL const BagMetadata* bagGetMetaData(BagHandle* handle);
 BAG_EXTERNAL BagError bagSetHomeFolder(const char* metadataFolder);
+BAG_EXTERNAL BagError bagClearSchemaCache(void);
 
 /* GeorefMetadataLayer */
 BAG_EXTERNAL BagError bagCreateGeorefMetadataLayer(BagHandle* handle, BAG_DATA_TYPE indexType, GEOREF_METADATA_PROFILE profile, const char* layerName, const FieldDefinition* definition, uint32_t numFields);
@@ -0,0 +1,499 @@
+
+#include "bag_accesstrace.h"
+#include "bag_accesstracer.h"
+#include "bag_exceptions.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <tuple>
+#include <unordered_map>
+
+
+namespace BAG {
+
+namespace {
+
+//! The size of the HDF5 chunk cache when none is set, in bytes.
+constexpr size_t kDefaultChunkCacheSize = 1024 * 1024;
+//! The cost of finding, reading and starting to decode a chunk, in the bytes
+//! it would take to decode instead; it keeps recommendations from chunks so
+//! small that their index grows large and they compress poorly.
+constexpr uint64_t kChunkOverheadBytes = 16 * 1024;
+//! The rows and columns of the chunk shapes recommendLayout() considers.
+constexpr uint32_t kCandidateChunkSizes[] = {16, 32, 64, 128, 256, 512, 1024};
+//! The chunk cache sizes recommendLayout() considers, in MiB.
+constexpr size_t kCandidateCacheSizes[] = {1, 4, 16, 64, 256};
+//! How much more than the least a cost may be, as a fraction, for the
+//! smaller chunk cache to be recommended.
+constexpr double kCacheTolerance = 0.05;
+
+//! Read a value from a stream, as its bytes.
+/*!
+\param stream
+    The stream.
+\param value
+    The value read.
+
+\return
+    \e true if the whole value was read.
+*/
+template <typename T>
+bool readValue(
+    std::istream& stream,
+    T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value),
+        sizeof(T)));
+}
+
+//! Retrieve the rows and columns an access trace covers for a layer.
+/*!
+    The grid of the layer, or more if a window of it was beyond the grid,
+    as those of the variable resolution layers are.
+
+\param trace
+    The access trace.
+\param layer
+    The layer; an index into trace.layers.
+
+\return
+    The number of rows, then columns.
+*/
+std::pair<uint64_t, uint64_t> getExtent(
+    const AccessTrace& trace,
+    uint32_t layer)
+{
+    uint64_t numRows = trace.layers[layer].numRows;
+    uint64_t numColumns = trace.layers[layer].numColumns;
+
+    for (const auto& record : trace.records)
+        if (record.layer == layer)
+        {
+            numRows = std::max<uint64_t>(numRows, uint64_t{record.rowEnd} + 1);
+            numColumns = std::max<uint64_t>(numColumns,
+                uint64_t{record.columnEnd} + 1);
+        }
+
+    return {numRows, numColumns};
+}
+
+//! Replay the accesses of a layer against a chunk shape and cache size.
+/*!
+    The HDF5 chunk cache is modelled as least recently used, holding as many
+    whole chunks as fit; chunks larger than it are not cached.  Writes that
+    cover a whole chunk do not decode it.
+
+\param trace
+    The access trace.
+\param layer
+    The layer; an index into trace.layers.
+\param candidate
+    The chunk shape and cache size.
+\param numRows
+    The rows the trace covers for the layer.
+\param numColumns
+    The columns the trace covers for the layer.
+
+\return
+    The estimated cost of the accesses.
+*/
+ReplayResult replay(
+    const AccessTrace& trace,
+    uint32_t layer,
+    const ReplayCandidate& candidate,
+    uint64_t numRows,
+    uint64_t numColumns)
+{
+    const uint64_t elementSize = trace.layers[layer].elementSize;
+
+    ReplayResult result;
+    result.candidate = candidate;
+
+    const bool chunked = candidate.chunkRows > 0 && candidate.chunkColumns > 0;
+    const uint64_t chunkRows = candidate.chunkRows;
+    const uint64_t chunkColumns = candidate.chunkColumns;
+    const auto chunkBytes = chunkRows * chunkColumns * elementSize;
+    const auto cacheSize = candidate.cacheSize > 0 ? candidate.cacheSize :
+        kDefaultChunkCacheSize;
+    const size_t capacity = chunked && chunkBytes > 0 &&
+        chunkBytes <= cacheSize ? static_cast<size_t>(cacheSize / chunkBytes) :
+        0;
+    const auto numChunkColumns = chunked ? (numColumns - 1) / chunkColumns + 1 :
+        0;
+
+    // The chunks cached, most recently used first.
+    std::list<uint64_t> used;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> cached;
+
+    uint64_t lookups = 0, hits = 0;
+
+    for (const auto& record : trace.records)
+    {
+        if (record.layer != layer)
+            continue;
+
+        const auto windowBytes = (uint64_t{record.rowEnd} - record.rowStart +
+            1) * (uint64_t{record.columnEnd} - record.columnStart + 1) *
+            elementSize;
+
+        ++result.numAccesses;
+        result.bytesRequested += windowBytes;
+
+        // A contiguous layer reads exactly the window.
+        if (!chunked)
+        {
+            if (record.kind == AccessKind::Read)
+                result.bytesDecoded += windowBytes;
+            continue;
+        }
+
+        const bool write = record.kind == AccessKind::Write;
+
+        for (auto chunkRow=record.rowStart / chunkRows;
+            chunkRow<=record.rowEnd / chunkRows; ++chunkRow)
+        {
+            const auto firstRow = chunkRow * chunkRows;
+            const auto lastRow = std::min(firstRow + chunkRows, numRows) - 1;
+
+            for (auto chunkColumn=record.columnStart / chunkColumns;
+                chunkColumn<=record.columnEnd / chunkColumns; ++chunkColumn)
+            {
+                const auto key = chunkRow * numChunkColumns + chunkColumn;
+                ++lookups;
+
+                const auto found = cached.find(key);
+                if (found != cached.end())
+                {
+                    ++hits;
+                    used.splice(used.begin(), used, found->second);
+                    continue;
+                }
+
+                const auto firstColumn = chunkColumn * chunkColumns;
+                const auto lastColumn = std::min(firstColumn + chunkColumns,
+                    numColumns) - 1;
+                const bool covered = write && record.rowStart <= firstRow &&
+                    record.rowEnd >= lastRow &&
+                    record.columnStart <= firstColumn &&
+                    record.columnEnd >= lastColumn;
+
+                if (!covered)
+                {
+                    ++result.chunksDecoded;
+                    result.bytesDecoded += chunkBytes;
+                }
+
+                if (capacity == 0)
+                    continue;
+
+                used.push_front(key);
+                cached.emplace(key, used.begin());
+
+                if (cached.size() > capacity)
+                {
+                    cached.erase(used.back());
+                    used.pop_back();
+                }
+            }
+        }
+    }
+
+    result.cacheHitRate = lookups > 0 ? static_cast<double>(hits) / lookups :
+        0.;
+
+    return result;
+}
+
+//! Retrieve the cost of a replay, for comparing candidates.
+/*!
+\param result
+    The replay.
+
+\return
+    The bytes decoded, and the overhead of each chunk decoded.
+*/
+double getCost(
+    const ReplayResult& result) noexcept
+{
+    return static_cast<double>(result.bytesDecoded) +
+        static_cast<double>(result.chunksDecoded) * kChunkOverheadBytes;
+}
+
+//! Determine if a number is prime.
+/*!
+\param number
+    The number.
+
+\return
+    \e true if it is prime.
+*/
+bool isPrime(
+    size_t number) noexcept
+{
+    if (number < 2)
+        return false;
+
+    for (size_t divisor=2; divisor * divisor <= number; ++divisor)
+        if (number % divisor == 0)
+            return false;
+
+    return true;
+}
+
+}  // namespace
+
+//! Read back an access trace recorded by Dataset::startAccessTrace().
+/*!
+    A truncated last entry, as left by a process that ended without
+    stopping its trace, is ignored.  An InvalidAccessTrace exception is
+    thrown if the file cannot be read, or is not an access trace.
+
+\param fileName
+    The access trace.
+
+\return
+    The layers accessed, and the accesses.
+*/
+AccessTrace loadAccessTrace(
+    const std::string& fileName)
+{
+    std::ifstream file{fileName, std::ios::binary};
+
+    char magic[sizeof(kAccessTraceMagic)] = {};
+    uint32_t version = 0;
+    if (!file.read(magic, sizeof(magic)) || !readValue(file, version) ||
+        std::memcmp(magic, kAccessTraceMagic, sizeof(magic)) != 0 ||
+        version != kAccessTraceVersion)
+        throw InvalidAccessTrace{};
+
+    AccessTrace trace;
+
+    uint8_t tag = 0;
+    while (readValue(file, tag))
+    {
+        if (tag == kAccessTraceLayerEntry)
+        {
+            uint32_t type = 0;
+            uint16_t nameLength = 0;
+            AccessTraceLayer layer;
+
+            if (!readValue(file, type) || !readValue(file, layer.numRows) ||
+                !readValue(file, layer.numColumns) ||
+                !readValue(file, layer.chunkRows) ||
+                !readValue(file, layer.chunkColumns) ||
+                !readValue(file, layer.elementSize) ||
+                !readValue(file, nameLength))
+                break;
+
+            layer.type = static_cast<LayerType>(type);
+            layer.name.resize(nameLength);
+            if (nameLength > 0 && !file.read(&layer.name[0], nameLength))
+                break;
+
+            trace.layers.push_back(std::move(layer));
+        }
+        else if (tag == kAccessTraceAccessEntry)
+        {
+            uint8_t kind = 0;
+            AccessTraceRecord record;
+
+            if (!readValue(file, kind) || !readValue(file, record.layer) ||
+                !readValue(file, record.startNanoseconds) ||
+                !readValue(file, record.durationNanoseconds) ||
+                !readValue(file, record.rowStart) ||
+                !readValue(file, record.columnStart) ||
+                !readValue(file, record.rowEnd) ||
+                !readValue(file, record.columnEnd))
+                break;
+
+            if (kind > static_cast<uint8_t>(AccessKind::Write) ||
+                record.layer >= trace.layers.size() ||
+                record.rowStart > record.rowEnd ||
+                record.columnStart > record.columnEnd)
+                throw InvalidAccessTrace{};
+
+            record.kind = static_cast<AccessKind>(kind);
+            trace.records.push_back(record);
+        }
+        else
+            throw InvalidAccessTrace{};
+    }
+
+    return trace;
+}
+
+//! Estimate the cost of the accesses of a layer with other chunk shapes and
+//! chunk cache sizes.
+/*!
+    The reads and writes of the layer in the trace are replayed, in order,
+    against each candidate: the chunks each window overlaps are looked up in
+    a model of the HDF5 chunk cache, least recently used, and those not
+    found are counted as decoded.  Writes that cover a whole chunk do not
+    decode it.
+
+    A LayerNotFound exception is thrown if the layer is not in the trace.
+
+\param trace
+    The access trace.
+\param layer
+    The layer; an index into trace.layers.
+\param candidates
+    The chunk shapes and chunk cache sizes to replay against.
+
+\return
+    The estimated cost of the accesses with each candidate, in the order of
+    candidates.
+*/
+std::vector<ReplayResult> replayAccessTrace(
+    const AccessTrace& trace,
+    uint32_t layer,
+    const std::vector<ReplayCandidate>& candidates)
+{
+    if (layer >= trace.layers.size())
+        throw LayerNotFound{};
+
+    uint64_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = getExtent(trace, layer);
+
+    std::vector<ReplayResult> results;
+    results.reserve(candidates.size());
+
+    for (const auto& candidate : candidates)
+        results.push_back(replay(trace, layer, candidate, numRows,
+            numColumns));
+
+    return results;
+}
+
+//! Recommend a chunk shape and chunk cache size for a layer, from its
+//! accesses.
+/*!
+    The accesses of the layer are replayed against square and oblong chunks
+    of 16 to 1024 rows and columns (no larger than the grid needs), and the
+    chunks traced, with chunk caches of 1 to 256 MiB.  The chunk shape decoding the fewest bytes,
+    allowing for an overhead for each chunk decoded, is recommended, with
+    the smallest cache within 5% of the best for that shape.  The number of
+    cache slots is a prime about 100 times the chunks the cache holds, as
+    HDF5 advises.
+
+    A layer without accesses keeps the chunk shape it was traced with.  A
+    LayerNotFound exception is thrown if the layer is not in the trace.
+
+\param trace
+    The access trace.
+\param layer
+    The layer; an index into trace.layers.
+
+\return
+    The settings recommended, and their estimated cost with that of the
+    settings traced.
+*/
+LayoutRecommendation recommendLayout(
+    const AccessTrace& trace,
+    uint32_t layer)
+{
+    if (layer >= trace.layers.size())
+        throw LayerNotFound{};
+
+    const auto& traced = trace.layers[layer];
+
+    uint64_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = getExtent(trace, layer);
+
+    LayoutRecommendation recommendation;
+    recommendation.layer = layer;
+    recommendation.traced = replay(trace, layer,
+        ReplayCandidate{traced.chunkRows, traced.chunkColumns, 0}, numRows,
+        numColumns);
+
+    recommendation.chunkShape.layout = ChunkLayout::Tiled;
+    recommendation.chunkShape.rows = traced.chunkRows;
+    recommendation.chunkShape.columns = traced.chunkColumns;
+    recommendation.estimate = recommendation.traced;
+
+    if (recommendation.traced.numAccesses == 0)
+        return recommendation;
+
+    // The chunk sizes needed to cover a dimension; larger ones only add
+    // unused nodes to the chunks.
+    const auto getSizes = [](uint64_t extent) {
+        std::vector<uint32_t> sizes;
+        for (const auto size : kCandidateChunkSizes)
+        {
+            sizes.push_back(size);
+            if (size >= extent)
+                break;
+        }
+
+        return sizes;
+    };
+
+    std::vector<ReplayCandidate> candidates;
+    for (const auto rows : getSizes(numRows))
+        for (const auto columns : getSizes(numColumns))
+            for (const auto cacheSize : kCandidateCacheSizes)
+                candidates.push_back({rows, columns, cacheSize * 1024 * 1024});
+
+    // Keeping the chunk shape traced may be best.
+    if (traced.chunkRows > 0 && traced.chunkColumns > 0)
+        for (const auto cacheSize : kCandidateCacheSizes)
+            candidates.push_back({traced.chunkRows, traced.chunkColumns,
+                cacheSize * 1024 * 1024});
+
+    const auto results = replayAccessTrace(trace, layer, candidates);
+
+    // The shape with the least cost; fewer lookups, then the smaller
+    // cache, break ties.
+    const auto best = std::min_element(results.begin(), results.end(),
+        [](const ReplayResult& lhs, const ReplayResult& rhs) {
+            const auto lhsCost = getCost(lhs), rhsCost = getCost(rhs);
+            if (lhsCost != rhsCost)
+                return lhsCost < rhsCost;
+
+            if (lhs.chunksDecoded != rhs.chunksDecoded)
+                return lhs.chunksDecoded < rhs.chunksDecoded;
+
+            const auto lhsChunk = uint64_t{lhs.candidate.chunkRows} *
+                lhs.candidate.chunkColumns;
+            const auto rhsChunk = uint64_t{rhs.candidate.chunkRows} *
+                rhs.candidate.chunkColumns;
+            if (lhsChunk != rhsChunk)
+                return lhsChunk > rhsChunk;
+
+            return lhs.candidate.cacheSize < rhs.candidate.cacheSize;
+        });
+
+    // The smallest cache nearly as good for that shape; the candidates of a
+    // shape are in increasing cache size.
+    const auto limit = getCost(*best) * (1. + kCacheTolerance);
+    auto chosen = best;
+    for (auto result=results.begin(); result!=results.end(); ++result)
+        if (result->candidate.chunkRows == best->candidate.chunkRows &&
+            result->candidate.chunkColumns == best->candidate.chunkColumns &&
+            getCost(*result) <= limit)
+        {
+            chosen = result;
+            break;
+        }
+
+    recommendation.chunkShape.rows = chosen->candidate.chunkRows;
+    recommendation.chunkShape.columns = chosen->candidate.chunkColumns;
+    recommendation.estimate = *chosen;
+
+    const auto chunkBytes = uint64_t{chosen->candidate.chunkRows} *
+        chosen->candidate.chunkColumns * traced.elementSize;
+    const auto numChunks = chunkBytes > 0 ?
+        static_cast<size_t>(chosen->candidate.cacheSize / chunkBytes) : 0;
+
+    recommendation.chunkCache.size = chosen->candidate.cacheSize;
+    recommendation.chunkCache.slots = std::max<size_t>(numChunks * 100, 521);
+    while (!isPrime(recommendation.chunkCache.slots))
+        ++recommendation.chunkCache.slots;
+
+    return recommendation;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,22 @@
+#ifndef BAG_ACCESSTRACE_H
+#define BAG_ACCESSTRACE_H
+
+#include "bag_config.h"
+#include "bag_types.h"
+
+#include <string>
+#include <vector>
+
+
+namespace BAG {
+
+BAG_API AccessTrace loadAccessTrace(const std::string& fileName);
+BAG_API std::vector<ReplayResult> replayAccessTrace(const AccessTrace& trace,
+    uint32_t layer, const std::vector<ReplayCandidate>& candidates);
+BAG_API LayoutRecommendation recommendLayout(const AccessTrace& trace,
+    uint32_t layer);
+
+}  // namespace BAG
+
+#endif  // BAG_ACCESSTRACE_H
+
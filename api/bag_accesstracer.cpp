@@ -0,0 +1,255 @@
+
+#include "bag_accesstracer.h"
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_layerdescriptor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+
+namespace BAG {
+
+namespace {
+
+//! The size of the buffer of entries, in bytes, written when it fills.
+constexpr size_t kTraceBufferSize = 64 * 1024;
+
+//! Append a value to a buffer, as its bytes.
+/*!
+\param buffer
+    The buffer.
+\param value
+    The value.
+*/
+template <typename T>
+void append(
+    std::vector<uint8_t>& buffer,
+    const T& value)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+//! Convert the time between two points to nanoseconds.
+/*!
+\param from
+    The earlier point.
+\param to
+    The later point.
+
+\return
+    The nanoseconds between them; 0 if to is before from.
+*/
+uint64_t toNanoseconds(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to) noexcept
+{
+    const auto nanoseconds = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(to - from).count();
+
+    return nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0;
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+    An AccessTraceWriteFailed exception is thrown if the log cannot be
+    created.
+
+\param fileName
+    The log to write; it is replaced if it exists.
+*/
+AccessTracer::AccessTracer(
+    const std::string& fileName)
+    : m_file(fileName, std::ios::binary | std::ios::trunc)
+    , m_start(std::chrono::steady_clock::now())
+{
+    m_buffer.reserve(kTraceBufferSize);
+    m_buffer.insert(m_buffer.end(), std::begin(kAccessTraceMagic),
+        std::end(kAccessTraceMagic));
+    append(m_buffer, kAccessTraceVersion);
+
+    this->writeBuffer();
+    if (m_failed)
+        throw AccessTraceWriteFailed{};
+}
+
+//! Destructor.
+/*!
+    Writes the entries not written yet.
+*/
+AccessTracer::~AccessTracer() noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    this->writeBuffer();
+}
+
+//! Record an access of a layer.
+/*!
+    The layer is described in the log the first time it is accessed.  If
+    the entry cannot be recorded, the next flush() throws.
+
+\param descriptor
+    The descriptor of the layer accessed.
+\param numRows
+    The number of rows of the grid.
+\param numColumns
+    The number of columns of the grid.
+\param record
+    The access; its layer and times are filled in.
+\param start
+    When the access began.
+\param end
+    When the access ended.
+*/
+void AccessTracer::record(
+    const LayerDescriptor& descriptor,
+    uint32_t numRows,
+    uint32_t numColumns,
+    AccessTraceRecord record,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end) noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    try
+    {
+        const auto& name = descriptor.getName();
+
+        auto found = m_layers.find(name);
+        if (found == m_layers.end())
+        {
+            uint64_t chunkRows = 0, chunkColumns = 0;
+            std::tie(chunkRows, chunkColumns) = descriptor.getChunkDims();
+
+            const auto nameLength = static_cast<uint16_t>(std::min<size_t>(
+                name.size(), std::numeric_limits<uint16_t>::max()));
+
+            append(m_buffer, kAccessTraceLayerEntry);
+            append(m_buffer, static_cast<uint32_t>(descriptor.getLayerType()));
+            append(m_buffer, numRows);
+            append(m_buffer, numColumns);
+            append(m_buffer, static_cast<uint32_t>(chunkRows));
+            append(m_buffer, static_cast<uint32_t>(chunkColumns));
+            append(m_buffer, descriptor.getElementSize());
+            append(m_buffer, nameLength);
+            m_buffer.insert(m_buffer.end(), name.begin(),
+                name.begin() + nameLength);
+
+            found = m_layers.emplace(name,
+                static_cast<uint32_t>(m_layers.size())).first;
+        }
+
+        append(m_buffer, kAccessTraceAccessEntry);
+        append(m_buffer, static_cast<uint8_t>(record.kind));
+        append(m_buffer, found->second);
+        append(m_buffer, toNanoseconds(m_start, start));
+        append(m_buffer, toNanoseconds(start, end));
+        append(m_buffer, record.rowStart);
+        append(m_buffer, record.columnStart);
+        append(m_buffer, record.rowEnd);
+        append(m_buffer, record.columnEnd);
+    }
+    catch (...)
+    {
+        m_failed = true;
+    }
+
+    if (m_buffer.size() >= kTraceBufferSize)
+        this->writeBuffer();
+}
+
+//! Write the entries recorded to the log.
+/*!
+    An AccessTraceWriteFailed exception is thrown if an entry was lost, or
+    the log could not be written.
+*/
+void AccessTracer::flush()
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    this->writeBuffer();
+    if (!m_failed)
+        m_file.flush();
+
+    if (m_failed || !m_file)
+        throw AccessTraceWriteFailed{};
+}
+
+//! Write the buffer of entries to the log, and empty it.
+void AccessTracer::writeBuffer() noexcept
+{
+    if (!m_buffer.empty() && !m_failed)
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()),
+            static_cast<std::streamsize>(m_buffer.size()));
+
+    m_buffer.clear();
+
+    if (!m_file)
+        m_failed = true;
+}
+
+//! Constructor.
+/*!
+    Starts timing the access if the Dataset is tracing its accesses.
+
+\param dataset
+    The Dataset accessed.
+\param descriptor
+    The descriptor of the layer accessed.
+\param kind
+    Whether the window is read or written.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+*/
+AccessTraceScope::AccessTraceScope(
+    const Dataset& dataset,
+    const LayerDescriptor& descriptor,
+    AccessKind kind,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) noexcept
+    : m_pTracer(dataset.getAccessTracer())
+    , m_dataset(dataset)
+    , m_descriptor(descriptor)
+{
+    if (!m_pTracer)
+        return;
+
+    m_record.kind = kind;
+    m_record.rowStart = rowStart;
+    m_record.columnStart = columnStart;
+    m_record.rowEnd = rowEnd;
+    m_record.columnEnd = columnEnd;
+    m_start = std::chrono::steady_clock::now();
+}
+
+//! Destructor; records the access, whether or not it succeeded.
+AccessTraceScope::~AccessTraceScope() noexcept
+{
+    if (!m_pTracer)
+        return;
+
+    const auto end = std::chrono::steady_clock::now();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = m_dataset.getDescriptor().getDims();
+
+    m_pTracer->record(m_descriptor, numRows, numColumns, m_record, m_start,
+        end);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,105 @@
+#ifndef BAG_ACCESSTRACER_H
+#define BAG_ACCESSTRACER_H
+
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace BAG {
+
+//! The first bytes of an access trace.
+constexpr char kAccessTraceMagic[8] = {'B', 'A', 'G', 'T', 'R', 'A', 'C', 'E'};
+//! The version of the layout of an access trace.
+constexpr uint32_t kAccessTraceVersion = 1;
+//! The tag of an entry describing a layer, the first time it is accessed.
+constexpr uint8_t kAccessTraceLayerEntry = 1;
+//! The tag of an entry recording an access.
+constexpr uint8_t kAccessTraceAccessEntry = 2;
+
+//! Records the reads and writes of the layers of a Dataset to a file.
+/*!
+    The log starts with "BAGTRACE" and a version, followed by entries of
+    fixed size fields in the byte order of the machine: a layer entry the
+    first time a layer is accessed, and an access entry when each read or
+    write ends.  Entries are buffered, and written when the buffer fills or
+    the tracer is flushed.
+
+    Accesses are recorded from every thread that uses the Dataset.
+*/
+class AccessTracer final
+{
+public:
+    explicit AccessTracer(const std::string& fileName);
+    ~AccessTracer() noexcept;
+
+    AccessTracer(const AccessTracer&) = delete;
+    AccessTracer(AccessTracer&&) = delete;
+
+    AccessTracer& operator=(const AccessTracer&) = delete;
+    AccessTracer& operator=(AccessTracer&&) = delete;
+
+    void record(const LayerDescriptor& descriptor, uint32_t numRows,
+        uint32_t numColumns, AccessTraceRecord record,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end) noexcept;
+    void flush();
+
+private:
+    void writeBuffer() noexcept;
+
+    //! The log.
+    std::ofstream m_file;
+    //! When tracing started.
+    std::chrono::steady_clock::time_point m_start;
+    //! The entries not written to the log yet.
+    std::vector<uint8_t> m_buffer;
+    //! The index of each layer accessed, by name.
+    std::unordered_map<std::string, uint32_t> m_layers;
+    //! Has an entry been lost, or the log failed to write?
+    bool m_failed = false;
+    //! Serializes the accesses recorded by several threads.
+    std::mutex m_mutex;
+};
+
+//! Records a read or write of a layer in the access trace of its Dataset,
+//! if it has one, when the scope ends.
+class AccessTraceScope final
+{
+public:
+    AccessTraceScope(const Dataset& dataset, const LayerDescriptor& descriptor,
+        AccessKind kind, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) noexcept;
+    ~AccessTraceScope() noexcept;
+
+    AccessTraceScope(const AccessTraceScope&) = delete;
+    AccessTraceScope(AccessTraceScope&&) = delete;
+
+    AccessTraceScope& operator=(const AccessTraceScope&) = delete;
+    AccessTraceScope& operator=(AccessTraceScope&&) = delete;
+
+private:
+    //! The tracer of the Dataset; null if it is not tracing.
+    std::shared_ptr<AccessTracer> m_pTracer;
+    //! The Dataset accessed.
+    const Dataset& m_dataset;
+    //! The descriptor of the layer accessed.
+    const LayerDescriptor& m_descriptor;
+    //! The access; its layer is filled in by the tracer.
+    AccessTraceRecord m_record;
+    //! When the access began.
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_ACCESSTRACER_H
+
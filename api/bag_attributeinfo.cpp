@@ -1,6 +1,7 @@
 
 #include "bag_attributeinfo.h"
 #include "bag_exceptions.h"
+#include "bag_layertraits.h"
 #include "bag_private.h"
 
 #include <H5Cpp.h>
@@ -8,6 +9,66 @@
 
 namespace BAG {
 
+namespace {
+
+//! Are two strings the same?
+constexpr bool equal(
+    const char* lhs,
+    const char* rhs) noexcept
+{
+    while (*lhs != '\0' && *lhs == *rhs)
+    {
+        ++lhs;
+        ++rhs;
+    }
+
+    return *lhs == *rhs;
+}
+
+//! Check the paths and attribute names of LayerTraits match those the
+//! library uses elsewhere.
+#define BAG_CHECK_LAYER_TRAITS(layerType, path, minName, maxName) \
+    static_assert(equal(LayerTraits<layerType>::getInternalPath(), path), \
+        "The path of " #layerType " differs from " #path); \
+    static_assert(equal(LayerTraits<layerType>::getMinAttributeName(), \
+        minName), "The min attribute of " #layerType " differs from " #minName); \
+    static_assert(equal(LayerTraits<layerType>::getMaxAttributeName(), \
+        maxName), "The max attribute of " #layerType " differs from " #maxName)
+
+BAG_CHECK_LAYER_TRAITS(Elevation, ELEVATION_PATH, MIN_ELEVATION_NAME,
+    MAX_ELEVATION_NAME);
+BAG_CHECK_LAYER_TRAITS(Uncertainty, UNCERTAINTY_PATH, MIN_UNCERTAINTY_NAME,
+    MAX_UNCERTAINTY_NAME);
+BAG_CHECK_LAYER_TRAITS(Hypothesis_Strength, HYPOTHESIS_STRENGTH_PATH,
+    MIN_HYPOTHESIS_STRENGTH, MAX_HYPOTHESIS_STRENGTH);
+BAG_CHECK_LAYER_TRAITS(Num_Hypotheses, NUM_HYPOTHESES_PATH,
+    MIN_NUM_HYPOTHESES, MAX_NUM_HYPOTHESES);
+BAG_CHECK_LAYER_TRAITS(Shoal_Elevation, SHOAL_ELEVATION_PATH,
+    MIN_SHOAL_ELEVATION, MAX_SHOAL_ELEVATION);
+BAG_CHECK_LAYER_TRAITS(Std_Dev, STANDARD_DEV_PATH, MIN_STANDARD_DEV_NAME,
+    MAX_STANDARD_DEV_NAME);
+BAG_CHECK_LAYER_TRAITS(Num_Soundings, NUM_SOUNDINGS_PATH, MIN_NUM_SOUNDINGS,
+    MAX_NUM_SOUNDINGS);
+BAG_CHECK_LAYER_TRAITS(Average_Elevation, AVERAGE_PATH, MIN_AVERAGE,
+    MAX_AVERAGE);
+BAG_CHECK_LAYER_TRAITS(Nominal_Elevation, NOMINAL_ELEVATION_PATH,
+    MIN_NOMINAL_ELEVATION, MAX_NOMINAL_ELEVATION);
+
+#undef BAG_CHECK_LAYER_TRAITS
+
+//! Retrieve the native HDF5 type of a C++ type.
+const ::H5::PredType& getNativeType(float) noexcept
+{
+    return ::H5::PredType::NATIVE_FLOAT;
+}
+
+const ::H5::PredType& getNativeType(uint32_t) noexcept
+{
+    return ::H5::PredType::NATIVE_UINT32;
+}
+
+}  // namespace
+
 //! Retrieve the attribute information about the specified layer type.
 /*!
     This function retrieves the attribute information about the specified Simple
@@ -25,40 +86,14 @@ namespace BAG {
 */
 AttributeInfo getAttributeInfo(LayerType layerType)
 {
-    switch (layerType)
-    {
-    case Elevation:
-        return AttributeInfo(MIN_ELEVATION_NAME, MAX_ELEVATION_NAME,
-            ELEVATION_PATH, ::H5::PredType::NATIVE_FLOAT);
-    case Uncertainty:
-        return AttributeInfo(MIN_UNCERTAINTY_NAME, MAX_UNCERTAINTY_NAME,
-            UNCERTAINTY_PATH, ::H5::PredType::NATIVE_FLOAT);
-    case Hypothesis_Strength:
-        return AttributeInfo(MIN_HYPOTHESIS_STRENGTH, MAX_HYPOTHESIS_STRENGTH,
-            HYPOTHESIS_STRENGTH_PATH, ::H5::PredType::NATIVE_FLOAT);
-    case Num_Hypotheses:
-        return AttributeInfo(MIN_NUM_HYPOTHESES, MAX_NUM_HYPOTHESES,
-            NUM_HYPOTHESES_PATH, ::H5::PredType::NATIVE_UINT32);
-    case Shoal_Elevation:
-        return AttributeInfo(MIN_SHOAL_ELEVATION, MAX_SHOAL_ELEVATION,
-            SHOAL_ELEVATION_PATH, ::H5::PredType::NATIVE_FLOAT);
-    case Std_Dev:
-        return AttributeInfo(MIN_STANDARD_DEV_NAME, MAX_STANDARD_DEV_NAME,
-            STANDARD_DEV_PATH, ::H5::PredType::NATIVE_FLOAT);
-    case Num_Soundings:
-        return AttributeInfo(MIN_NUM_SOUNDINGS, MAX_NUM_SOUNDINGS,
-            NUM_SOUNDINGS_PATH, ::H5::PredType::NATIVE_UINT32);
-    case Average_Elevation:
-        return AttributeInfo(MIN_AVERAGE, MAX_AVERAGE, AVERAGE_PATH,
-            ::H5::PredType::NATIVE_FLOAT);
-    case Nominal_Elevation:
-        return AttributeInfo(MIN_NOMINAL_ELEVATION, MAX_NOMINAL_ELEVATION,
-            NOMINAL_ELEVATION_PATH, ::H5::PredType::NATIVE_FLOAT);
-    default:
-        throw UnsupportedSimpleLayerType{};
-    }
+    return visitLayerTraits(layerType, [](auto traits) {
+        using Traits = decltype(traits);
+
+        return AttributeInfo(Traits::getMinAttributeName(),
+            Traits::getMaxAttributeName(), Traits::getInternalPath(),
+            getNativeType(typename Traits::value_type{}));
+    });
 }
 
 }  // namespace BAG
 
-
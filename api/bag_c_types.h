@@ -1,6 +1,7 @@
 #ifndef BAG_C_TYPES_H
 #define BAG_C_TYPES_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -38,6 +39,57 @@ enum BAG_OPEN_MODE
     BAG_OPEN_READ_WRITE = 2,  //!< Open the BAG for reading and writing.
 };
 
+//! The arrangement of the bands returned when reading several layers at once.
+enum BAG_LAYER_LAYOUT
+{
+    BAG_LAYOUT_PLANAR      = 0,  //!< Each layer is a contiguous block, one after the other.
+    BAG_LAYOUT_INTERLEAVED = 1,  //!< The values of all layers for a node are adjacent.
+};
+
+//! How refinements are combined when resampling a variable resolution BAG.
+enum BAG_VR_RESAMPLE_METHOD
+{
+    BAG_VR_RESAMPLE_NEAREST   = 0,  //!< The nearest refined node.
+    BAG_VR_RESAMPLE_BILINEAR  = 1,  //!< Bilinear interpolation of the surrounding refined nodes.
+    BAG_VR_RESAMPLE_MIN_DEPTH = 2,  //!< The shoalest (smallest) depth under the output node.
+};
+
+//! The options used when opening a BAG.  Only used in the C interface.
+struct BagOpenOptions
+{
+    uint64_t chunkCacheSize;  //!< The size of the chunk cache in bytes; 0 uses the HDF5 default.
+    uint64_t chunkCacheSlots;  //!< The number of chunk slots in the chunk cache; 0 uses the HDF5 default.
+    double chunkCachePreemption;  //!< The chunk preemption policy (0 to 1); negative uses the HDF5 default.
+    uint8_t concurrentReads;  //!< Non zero to allow several threads to read using the handle; requires BAG_OPEN_READONLY.
+    uint64_t pageBufferSize;  //!< The size of the HDF5 page buffer in bytes; 0 does not use one.
+    const char* awsRegion;  //!< The AWS region of a BAG named by a URL; may be NULL.
+    const char* awsAccessKeyId;  //!< The AWS access key id; NULL or empty to read anonymously.
+    const char* awsSecretAccessKey;  //!< The AWS secret access key; may be NULL.
+    uint8_t collectIoStats;  //!< Non zero to count and time the reads and writes of each layer.
+};
+
+//! The I/O counters of a BAG or one of its layers.  Only used in the C interface.
+struct BagIoStats
+{
+    uint64_t numReads;  //!< The number of reads.
+    uint64_t numWrites;  //!< The number of writes.
+    uint64_t bytesRequested;  //!< The bytes asked for by the reads.
+    uint64_t bytesWritten;  //!< The bytes given to the writes.
+    uint64_t bytesDecompressed;  //!< The bytes of the chunks decompressed by the library.
+    uint64_t chunksRead;  //!< The chunks the reads overlapped.
+    uint64_t chunksWritten;  //!< The chunks the writes overlapped.
+    uint64_t numAttributeWrites;  //!< The number of times the layer attributes were written.
+    double readSeconds;  //!< The time spent reading.
+    double writeSeconds;  //!< The time spent writing.
+    double attributeSeconds;  //!< The time spent writing the layer attributes.
+    double selectionSeconds;  //!< The time spent selecting the area read in the file.
+    double hdf5ReadSeconds;  //!< The time spent reading through HDF5.
+    double decompressSeconds;  //!< The time spent decompressing chunks in the library.
+    double metadataCacheHitRate;  //!< The hit rate of the HDF5 metadata cache; only for the BAG.
+    uint64_t pageBufferHits;  //!< The hits in the HDF5 page buffer; only for the BAG.
+    uint64_t pageBufferMisses;  //!< The misses in the HDF5 page buffer; only for the BAG.
+};
+
 //! The types of data known to BAG.
 enum BAG_DATA_TYPE
 {
@@ -68,6 +120,23 @@ enum BAG_GROUP_TYPE
     UNKNOWN_GROUP_TYPE,  //!< Unknown group type.
 };
 
+//! A window of the grid.  Only used in the C interface.
+struct BagWindow
+{
+    uint32_t rowStart;  //!< The starting row.
+    uint32_t colStart;  //!< The starting column.
+    uint32_t rowEnd;  //!< The end row (inclusive).
+    uint32_t colEnd;  //!< The end column (inclusive).
+};
+
+//! A node of a simple layer and its value; found by bagFindCells().
+struct BagCell
+{
+    uint32_t row;  //!< The row of the node.
+    uint32_t col;  //!< The column of the node.
+    float value;  //!< The value of the node.
+};
+
 //! An item in the Tracking List.
 struct BagTrackingItem
 {
@@ -145,6 +214,26 @@ struct BagVRNodeItem
     uint32_t n_samples;
 };
 
+//! A record of the optional elevation solution group of a pre 2.0 BAG.
+struct BagOptElevationSolutionGroup
+{
+    //! The shoal elevation.
+    float shoal_elevation;
+    //! The standard deviation.
+    float stddev;
+    //! Number of soundings.
+    int32_t num_soundings;
+};
+
+//! A record of the optional node group of a pre 2.0 BAG.
+struct BagOptNodeGroup
+{
+    //! Hypotheses strength.
+    float hyp_strength;
+    //! Number of hypotheses.
+    uint32_t num_hypotheses;
+};
+
 //! The surface topography.
 enum BAG_SURFACE_CORRECTION_TOPOGRAPHY {
     BAG_SURFACE_UNKNOWN = 0,        //!< Unknown
@@ -0,0 +1,742 @@
+
+#include "bag_catalog.h"
+#include "bag_dataset.h"
+#include "bag_descriptor.h"
+#include "bag_exceptions.h"
+#include "bag_filestamp.h"
+#include "bag_parallel.h"
+#include "bag_progressscope.h"
+#include "bag_rtree.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <H5Cpp.h>
+#include <iterator>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+
+namespace BAG {
+
+namespace {
+
+//! The first bytes of a catalog file.
+constexpr char kCatalogMagic[8] = {'B', 'A', 'G', 'C', 'A', 'T', 'L', 'G'};
+//! The version of the catalog file format.
+constexpr uint32_t kCatalogVersion = 1;
+//! Written after the version, to detect a file of the other byte order.
+constexpr uint16_t kByteOrderMark = 0x0102;
+//! The work of a stat of a file, in nodes, when sharing out the files of a
+//! crawl between threads; a stat can wait on a network file system.
+constexpr uint32_t kStatCost = 1024;
+
+//! Does a file name end with one of a number of extensions?
+/*!
+\param fileName
+    The file name.
+\param extensions
+    The extensions, compared without regard to case.
+
+\return
+    \e true if the file name ends with one of the extensions.
+*/
+bool hasExtension(
+    const std::string& fileName,
+    const std::vector<std::string>& extensions) noexcept
+{
+    return std::any_of(extensions.begin(), extensions.end(),
+        [&fileName](const std::string& extension) {
+            if (extension.size() > fileName.size())
+                return false;
+
+            return std::equal(extension.begin(), extension.end(),
+                fileName.end() - extension.size(),
+                [](char lhs, char rhs) {
+                    return std::tolower(static_cast<unsigned char>(lhs)) ==
+                        std::tolower(static_cast<unsigned char>(rhs));
+                });
+        });
+}
+
+//! List the files of a directory with one of the extensions of a crawl.
+/*!
+\param directory
+    The directory.
+\param options
+    The extensions looked for, and whether subdirectories are listed.
+\param fileNames
+    The file names found are appended to it.
+*/
+void listDirectory(
+    const std::string& directory,
+    const CatalogOptions& options,
+    std::vector<std::string>& fileNames)
+{
+    std::vector<std::string> subdirectories;
+
+    const auto addEntry = [&](const char* name, bool isSubdirectory) {
+        if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0)
+            return;
+
+        auto path = directory;
+        if (!path.empty() && path.back() != '/' && path.back() != '\\')
+            path += '/';
+        path += name;
+
+        if (isSubdirectory)
+            subdirectories.push_back(std::move(path));
+        else if (hasExtension(path, options.extensions))
+            fileNames.push_back(std::move(path));
+    };
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    const auto handle = ::FindFirstFileA((directory + "\\*").c_str(), &found);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        addEntry(found.cFileName,
+            (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+    } while (::FindNextFileA(handle, &found));
+
+    ::FindClose(handle);
+#else
+    const auto pDirectory = ::opendir(directory.c_str());
+    if (!pDirectory)
+        return;
+
+    while (const auto pEntry = ::readdir(pDirectory))
+    {
+        // Some file systems do not say what an entry is.
+        const auto isSubdirectory = pEntry->d_type == DT_UNKNOWN ||
+            pEntry->d_type == DT_LNK ?
+            isDirectory(directory + '/' + pEntry->d_name) :
+            pEntry->d_type == DT_DIR;
+
+        addEntry(pEntry->d_name, isSubdirectory);
+    }
+
+    ::closedir(pDirectory);
+#endif
+
+    if (!options.recursive)
+        return;
+
+    for (const auto& subdirectory : subdirectories)
+        listDirectory(subdirectory, options, fileNames);
+}
+
+//! Find the BAGs under a number of roots.
+/*!
+\param roots
+    The files, directories and URLs to crawl.  A file or URL is taken as a
+    BAG whatever its extension.
+\param options
+    How the directories are crawled.
+
+\return
+    The file names and URLs found, sorted, each once.
+*/
+std::vector<std::string> crawl(
+    const std::vector<std::string>& roots,
+    const CatalogOptions& options)
+{
+    std::vector<std::string> fileNames;
+
+    for (const auto& root : roots)
+    {
+        if (!isUrl(root) && isDirectory(root))
+            listDirectory(root, options, fileNames);
+        else
+            fileNames.push_back(root);
+    }
+
+    std::sort(fileNames.begin(), fileNames.end());
+    fileNames.erase(std::unique(fileNames.begin(), fileNames.end()),
+        fileNames.end());
+
+    return fileNames;
+}
+
+//! Open a BAG, and describe it.
+/*!
+    Only what the descriptor needs is read; the layers are not opened and
+    the metadata is not parsed in full.
+
+\param fileName
+    The file name or URL of the BAG.
+\param options
+    How a BAG named by a URL is read.
+\param entry
+    Set to what is known of the BAG, except its file stamp and reference
+    system.
+\param referenceSystem
+    Set to the horizontal reference system of the BAG.
+
+\return
+    \e true if the BAG was opened.
+    \e false if it is not a BAG, or cannot be read.
+*/
+bool describeBag(
+    const std::string& fileName,
+    const CatalogOptions& options,
+    CatalogEntry& entry,
+    std::string& referenceSystem)
+{
+    OpenOptions openOptions;
+    openOptions.lazy = true;
+    openOptions.deferMetadata = true;
+    openOptions.remote = options.remote;
+
+    std::shared_ptr<Dataset> pDataset;
+    try
+    {
+        pDataset = Dataset::open(fileName, BAG_OPEN_READONLY, openOptions);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    catch (const H5::Exception&)
+    {
+        return false;
+    }
+
+    if (!pDataset)
+        return false;
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    entry.fileName = fileName;
+    std::tie(entry.rows, entry.columns) = descriptor.getDims();
+    std::tie(entry.rowResolution, entry.columnResolution) =
+        descriptor.getGridSpacing();
+    std::tie(entry.minX, entry.minY, entry.maxX, entry.maxY) =
+        descriptor.getProjectedCover();
+    entry.layerTypes = pDataset->getLayerTypes();
+    entry.isVR = std::find(entry.layerTypes.begin(), entry.layerTypes.end(),
+        VarRes_Metadata) != entry.layerTypes.end();
+    referenceSystem = descriptor.getHorizontalReferenceSystem();
+
+    return true;
+}
+
+//! Append a value to a buffer, in the byte order of the host.
+/*!
+\param buffer
+    The buffer.
+\param value
+    The value.
+*/
+template <typename T>
+void appendValue(
+    std::vector<char>& buffer,
+    T value)
+{
+    const auto* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+//! Append a string to a buffer, after its length.
+/*!
+\param buffer
+    The buffer.
+\param value
+    The string.
+*/
+void appendString(
+    std::vector<char>& buffer,
+    const std::string& value)
+{
+    appendValue(buffer, static_cast<uint32_t>(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+//! Reads the values of a catalog file in turn.
+class CatalogReader final
+{
+public:
+    //! Constructor.
+    /*!
+    \param buffer
+        The contents of the file.
+    */
+    explicit CatalogReader(const std::vector<char>& buffer) noexcept
+        : m_buffer(buffer)
+    {
+    }
+
+    //! Read a value.
+    /*!
+    \return
+        The value.
+    */
+    template <typename T>
+    T readValue()
+    {
+        T value{};
+        std::memcpy(&value, this->take(sizeof(T)), sizeof(T));
+
+        return value;
+    }
+
+    //! Read a string written after its length.
+    /*!
+    \return
+        The string.
+    */
+    std::string readString()
+    {
+        const auto size = this->readValue<uint32_t>();
+        const auto* data = this->take(size);
+
+        return {data, size};
+    }
+
+private:
+    //! Take a number of bytes from the file.
+    /*!
+    \param size
+        The number of bytes.
+
+    \return
+        The first of the bytes.
+    */
+    const char* take(size_t size)
+    {
+        if (size > m_buffer.size() - m_offset)
+            throw CatalogReadFailed{};
+
+        const auto* data = m_buffer.data() + m_offset;
+        m_offset += size;
+
+        return data;
+    }
+
+    //! The contents of the file.
+    const std::vector<char>& m_buffer;
+    //! The offset of the next value.
+    size_t m_offset = 0;
+};
+
+//! Find the index of a string in a table, adding it if it is not there.
+/*!
+\param table
+    The table.
+\param indices
+    The index of each string in the table.
+\param value
+    The string.
+
+\return
+    The index of the string in the table.
+*/
+uint32_t internString(
+    std::vector<std::string>& table,
+    std::map<std::string, uint32_t>& indices,
+    const std::string& value)
+{
+    const auto found = indices.find(value);
+    if (found != indices.end())
+        return found->second;
+
+    const auto index = static_cast<uint32_t>(table.size());
+    table.push_back(value);
+    indices.emplace(value, index);
+
+    return index;
+}
+
+}  // namespace
+
+//! Build a catalog by crawling for BAGs.
+/*!
+    A directory is listed for the files with one of the extensions of the
+    options.  A file, or a URL, is taken as a BAG whatever its extension;
+    object stores are not listed, so each BAG in one must be named.  The
+    files that cannot be opened as BAGs are left out.
+
+\param roots
+    The files, directories and URLs to crawl.
+\param options
+    How the roots are crawled, and the BAGs opened.
+*/
+Catalog::Catalog(
+    const std::vector<std::string>& roots,
+    const CatalogOptions& options)
+    : m_roots(roots)
+{
+    this->refresh(options);
+}
+
+//! Constructor, of an empty catalog.
+Catalog::Catalog() noexcept = default;
+
+//! Destructor.
+Catalog::~Catalog() = default;
+
+//! Move constructor.
+Catalog::Catalog(Catalog&&) noexcept = default;
+
+//! Move assignment.
+Catalog& Catalog::operator=(Catalog&&) noexcept = default;
+
+//! Read a catalog written by write().
+/*!
+\param fileName
+    The name of the catalog file.
+
+\return
+    The catalog.
+*/
+Catalog Catalog::read(
+    const std::string& fileName)
+{
+    std::ifstream file{fileName, std::ios::binary};
+    if (!file)
+        throw CatalogReadFailed{};
+
+    const std::vector<char> buffer{std::istreambuf_iterator<char>{file},
+        std::istreambuf_iterator<char>{}};
+    CatalogReader reader{buffer};
+
+    for (const auto magic : kCatalogMagic)
+        if (reader.readValue<char>() != magic)
+            throw CatalogReadFailed{};
+
+    if (reader.readValue<uint32_t>() != kCatalogVersion ||
+        reader.readValue<uint16_t>() != kByteOrderMark)
+        throw CatalogReadFailed{};
+
+    Catalog catalog;
+
+    catalog.m_roots.resize(reader.readValue<uint32_t>());
+    for (auto& root : catalog.m_roots)
+        root = reader.readString();
+
+    catalog.m_referenceSystems.resize(reader.readValue<uint32_t>());
+    for (auto& referenceSystem : catalog.m_referenceSystems)
+        referenceSystem = reader.readString();
+
+    catalog.m_entries.resize(reader.readValue<uint32_t>());
+    for (auto& entry : catalog.m_entries)
+    {
+        entry.fileName = reader.readString();
+        entry.fileSize = reader.readValue<uint64_t>();
+        entry.modified = reader.readValue<int64_t>();
+        entry.rows = reader.readValue<uint32_t>();
+        entry.columns = reader.readValue<uint32_t>();
+        entry.rowResolution = reader.readValue<double>();
+        entry.columnResolution = reader.readValue<double>();
+        entry.minX = reader.readValue<double>();
+        entry.minY = reader.readValue<double>();
+        entry.maxX = reader.readValue<double>();
+        entry.maxY = reader.readValue<double>();
+
+        // A bit for each type of layer.
+        const auto layers = reader.readValue<uint32_t>();
+        for (uint32_t type=0; type<UNKNOWN_LAYER_TYPE; ++type)
+            if (layers & (1u << type))
+                entry.layerTypes.push_back(static_cast<LayerType>(type));
+
+        entry.isVR = (layers & (1u << VarRes_Metadata)) != 0;
+
+        entry.referenceSystem = reader.readValue<uint32_t>();
+        if (entry.referenceSystem >= catalog.m_referenceSystems.size())
+            throw CatalogReadFailed{};
+    }
+
+    catalog.indexEntries();
+
+    return catalog;
+}
+
+//! Write the catalog to a file.
+/*!
+    The file is in the byte order of the host.
+
+\param fileName
+    The name of the catalog file; replaced if it exists.
+*/
+void Catalog::write(
+    const std::string& fileName) const
+{
+    std::vector<char> buffer{std::begin(kCatalogMagic),
+        std::end(kCatalogMagic)};
+    appendValue(buffer, kCatalogVersion);
+    appendValue(buffer, kByteOrderMark);
+
+    appendValue(buffer, static_cast<uint32_t>(m_roots.size()));
+    for (const auto& root : m_roots)
+        appendString(buffer, root);
+
+    appendValue(buffer, static_cast<uint32_t>(m_referenceSystems.size()));
+    for (const auto& referenceSystem : m_referenceSystems)
+        appendString(buffer, referenceSystem);
+
+    appendValue(buffer, static_cast<uint32_t>(m_entries.size()));
+    for (const auto& entry : m_entries)
+    {
+        appendString(buffer, entry.fileName);
+        appendValue(buffer, entry.fileSize);
+        appendValue(buffer, entry.modified);
+        appendValue(buffer, entry.rows);
+        appendValue(buffer, entry.columns);
+        appendValue(buffer, entry.rowResolution);
+        appendValue(buffer, entry.columnResolution);
+        appendValue(buffer, entry.minX);
+        appendValue(buffer, entry.minY);
+        appendValue(buffer, entry.maxX);
+        appendValue(buffer, entry.maxY);
+
+        uint32_t layers = 0;
+        for (const auto type : entry.layerTypes)
+            if (type < UNKNOWN_LAYER_TYPE)
+                layers |= 1u << type;
+
+        appendValue(buffer, layers);
+        appendValue(buffer, entry.referenceSystem);
+    }
+
+    std::ofstream file{fileName, std::ios::binary | std::ios::trunc};
+    if (!file)
+        throw CatalogWriteFailed{};
+
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file)
+        throw CatalogWriteFailed{};
+}
+
+//! Crawl the roots of the catalog again, and bring it up to date.
+/*!
+    The files are listed, then their sizes and modification times are read
+    on several threads.  Only the files that are new, or whose size or
+    modification time changed, are opened; they are opened one after the
+    other, as HDF5 serializes access to the library.  The files no longer
+    found are dropped.  URLs carry no stamp, so a URL already in the catalog
+    is kept as it is.
+
+    If options.progress is cancelled, the files reached are brought up to
+    date, and the others keep their entries as they were, before an
+    OperationCancelled exception is thrown.
+
+\param options
+    How the roots are crawled, and the BAGs opened.
+
+\return
+    The number of BAGs opened.
+*/
+size_t Catalog::refresh(
+    const CatalogOptions& options)
+{
+    const auto fileNames = crawl(m_roots, options);
+    const auto numFiles = static_cast<uint32_t>(fileNames.size());
+
+    std::vector<FileStamp> stamps(numFiles);
+    if (numFiles > 0)
+        processInBlocks(0, numFiles - 1, kStatCost,
+            [&](uint32_t first, uint32_t last) noexcept {
+                for (auto index=first; index<=last; ++index)
+                    if (!isUrl(fileNames[index]))
+                        stamps[index] = statFile(fileNames[index]);
+            });
+
+    std::vector<CatalogEntry> entries;
+    entries.reserve(numFiles);
+    std::vector<std::string> referenceSystems;
+    std::map<std::string, uint32_t> referenceSystemIndices;
+
+    // The entries are sorted by file name, as the files are.
+    auto existing = m_entries.begin();
+    auto notReached = m_entries.begin();
+    size_t numOpened = 0;
+
+    const auto commit = [&]() {
+        m_entries = std::move(entries);
+        m_referenceSystems = std::move(referenceSystems);
+        this->indexEntries();
+    };
+
+    const ProgressScope progress{options.progress};
+
+    for (uint32_t index=0; index<numFiles; ++index)
+    {
+        try
+        {
+            progress.report(index, numFiles);
+        }
+        catch (const OperationCancelled&)
+        {
+            for (; notReached!=m_entries.end(); ++notReached)
+            {
+                auto entry = std::move(*notReached);
+                entry.referenceSystem = internString(referenceSystems,
+                    referenceSystemIndices,
+                    m_referenceSystems[entry.referenceSystem]);
+                entries.push_back(std::move(entry));
+            }
+
+            commit();
+            throw;
+        }
+
+        const auto& fileName = fileNames[index];
+        const auto& stamp = stamps[index];
+        const auto url = isUrl(fileName);
+
+        // Removed since it was listed.
+        if (!url && !stamp.exists)
+            continue;
+
+        existing = std::lower_bound(existing, m_entries.end(), fileName,
+            [](const CatalogEntry& entry, const std::string& name) {
+                return entry.fileName < name;
+            });
+        notReached = existing != m_entries.end() &&
+            existing->fileName == fileName ? existing + 1 : existing;
+
+        const auto unchanged = existing != m_entries.end() &&
+            existing->fileName == fileName && (url ||
+            (existing->fileSize == stamp.size &&
+                existing->modified == stamp.modified));
+
+        CatalogEntry entry;
+        std::string referenceSystem;
+
+        if (unchanged)
+        {
+            entry = std::move(*existing);
+            referenceSystem = m_referenceSystems[entry.referenceSystem];
+        }
+        else
+        {
+            if (!describeBag(fileName, options, entry, referenceSystem))
+                continue;
+
+            entry.fileSize = stamp.size;
+            entry.modified = stamp.modified;
+            ++numOpened;
+        }
+
+        entry.referenceSystem = internString(referenceSystems,
+            referenceSystemIndices, referenceSystem);
+        entries.push_back(std::move(entry));
+    }
+
+    commit();
+    progress.report(1, 1);
+
+    return numOpened;
+}
+
+//! Find the BAGs whose projected covers meet an area.
+/*!
+    The pointers are valid until the catalog is refreshed.
+
+\param minX
+    The western edge of the area.
+\param minY
+    The southern edge of the area.
+\param maxX
+    The eastern edge of the area.
+\param maxY
+    The northern edge of the area.
+\param referenceSystem
+    The horizontal reference system the area is in, as the BAGs give it; only
+    BAGs in it are found.  Empty to find BAGs in any.
+
+\return
+    The BAGs found, ordered by file name.
+*/
+std::vector<const CatalogEntry*> Catalog::query(
+    double minX,
+    double minY,
+    double maxX,
+    double maxY,
+    const std::string& referenceSystem) const
+{
+    std::vector<const CatalogEntry*> found;
+
+    auto referenceSystemIndex = static_cast<uint32_t>(
+        m_referenceSystems.size());
+    if (!referenceSystem.empty())
+    {
+        const auto known = std::find(m_referenceSystems.begin(),
+            m_referenceSystems.end(), referenceSystem);
+        if (known == m_referenceSystems.end())
+            return found;
+
+        referenceSystemIndex = static_cast<uint32_t>(
+            known - m_referenceSystems.begin());
+    }
+
+    for (const auto index : m_pIndex->search({minX, minY, maxX, maxY}))
+    {
+        const auto& entry = m_entries[index];
+        if (referenceSystem.empty() ||
+            entry.referenceSystem == referenceSystemIndex)
+            found.push_back(&entry);
+    }
+
+    return found;
+}
+
+//! Retrieve the BAGs of the catalog.
+/*!
+\return
+    The BAGs of the catalog, ordered by file name.
+*/
+const std::vector<CatalogEntry>& Catalog::getEntries() const & noexcept
+{
+    return m_entries;
+}
+
+//! Retrieve the horizontal reference systems of the BAGs.
+/*!
+\return
+    The horizontal reference systems of the BAGs, each once; an entry
+    names one by its index.
+*/
+const std::vector<std::string>& Catalog::getReferenceSystems() const & noexcept
+{
+    return m_referenceSystems;
+}
+
+//! Retrieve the files, directories and URLs crawled.
+/*!
+\return
+    The files, directories and URLs crawled.
+*/
+const std::vector<std::string>& Catalog::getRoots() const & noexcept
+{
+    return m_roots;
+}
+
+//! Index the projected covers of the entries.
+void Catalog::indexEntries()
+{
+    std::vector<RTree::Box> covers;
+    covers.reserve(m_entries.size());
+
+    for (const auto& entry : m_entries)
+        covers.push_back({entry.minX, entry.minY, entry.maxX, entry.maxY});
+
+    m_pIndex.reset(new RTree{covers});
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,116 @@
+#ifndef BAG_CATALOG_H
+#define BAG_CATALOG_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! What a Catalog knows of a BAG.
+struct BAG_API CatalogEntry final
+{
+    //! The file name or URL of the BAG.
+    std::string fileName;
+    //! The size of the file, in bytes; 0 for a URL.
+    uint64_t fileSize = 0;
+    //! When the file was last modified, in seconds since the Unix epoch; 0
+    //! for a URL.
+    int64_t modified = 0;
+    //! The number of rows.
+    uint32_t rows = 0;
+    //! The number of columns.
+    uint32_t columns = 0;
+    //! The distance between rows.
+    double rowResolution = 0.;
+    //! The distance between columns.
+    double columnResolution = 0.;
+    //! The western edge of the projected cover.
+    double minX = 0.;
+    //! The southern edge of the projected cover.
+    double minY = 0.;
+    //! The eastern edge of the projected cover.
+    double maxX = 0.;
+    //! The northern edge of the projected cover.
+    double maxY = 0.;
+    //! Is the BAG variable resolution?
+    bool isVR = false;
+    //! The types of the layers of the BAG.
+    std::vector<LayerType> layerTypes;
+    //! The horizontal reference system, as an index into
+    //! Catalog::getReferenceSystems().
+    uint32_t referenceSystem = 0;
+};
+
+//! An index of the footprints of many BAGs, to find those covering an area
+//! without opening any of them.
+/*!
+    A catalog is built by crawling directories (and URLs named one by one)
+    for BAGs.  Each is opened once, reading only what its descriptor needs,
+    and its grid, projected cover, layers and file stamp are kept.  The
+    footprints are indexed in an R-tree for query().
+
+    A catalog is written to a compact binary file, and read back by
+    Catalog::read().  refresh() crawls the roots again and only opens the
+    files that are new or whose size or modification time changed.
+*/
+class BAG_API Catalog final
+{
+public:
+    explicit Catalog(const std::vector<std::string>& roots,
+        const CatalogOptions& options = {});
+    ~Catalog();
+
+    Catalog(const Catalog&) = delete;
+    Catalog(Catalog&&) noexcept;
+    Catalog& operator=(const Catalog&) = delete;
+    Catalog& operator=(Catalog&&) noexcept;
+
+    static Catalog read(const std::string& fileName);
+    void write(const std::string& fileName) const;
+
+    size_t refresh(const CatalogOptions& options = {});
+
+    std::vector<const CatalogEntry*> query(double minX, double minY,
+        double maxX, double maxY,
+        const std::string& referenceSystem = {}) const;
+
+    const std::vector<CatalogEntry>& getEntries() const & noexcept;
+    const std::vector<std::string>& getReferenceSystems() const & noexcept;
+    const std::vector<std::string>& getRoots() const & noexcept;
+
+private:
+    Catalog() noexcept;
+
+    void indexEntries();
+
+    //! The files and directories crawled.
+    std::vector<std::string> m_roots;
+    //! The BAGs, ordered by file name.
+    std::vector<CatalogEntry> m_entries;
+    //! The horizontal reference systems of the BAGs, each once.
+    std::vector<std::string> m_referenceSystems;
+    //! The index of the projected covers of the entries.
+    std::unique_ptr<RTree> m_pIndex;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_CATALOG_H
+
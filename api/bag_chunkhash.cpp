@@ -0,0 +1,753 @@
+
+#include "bag_chunkhash.h"
+#include "bag_dataset.h"
+#include "bag_parallel.h"
+#include "bag_private.h"
+#include "bag_progressscope.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>  // memcpy
+#include <H5Cpp.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! The most bytes of chunks held at once.
+constexpr size_t kHashBatchBytes = 64 * 1024 * 1024;
+//! The most bytes of an unchunked DataSet hashed as one chunk.
+constexpr size_t kUnchunkedBandBytes = 16 * 1024 * 1024;
+//! The dimensions of the chunk offsets kept in the BAG; no DataSet of a BAG
+//! has more.
+constexpr int kPersistedRank = 2;
+//! The number of hashes in a chunk of the DataSet keeping them.
+constexpr hsize_t kPersistedChunkSize = 4096;
+//! The name of the attribute holding the paths of the DataSets hashed.
+constexpr const char* kPathsName = "DataSet Paths";
+
+//! The primes of xxHash64.
+constexpr uint64_t kPrime1 = 11400714785074694791ull;
+constexpr uint64_t kPrime2 = 14029467366897019727ull;
+constexpr uint64_t kPrime3 = 1609587929392839161ull;
+constexpr uint64_t kPrime4 = 9650029242287828579ull;
+constexpr uint64_t kPrime5 = 2870177450012600261ull;
+
+//! A hash as kept in the BAG.
+struct PersistedChunkHash final
+{
+    //! The index of the path of the DataSet in the paths attribute.
+    uint32_t dataSet = 0;
+    //! The number of dimensions of the offset.
+    uint32_t rank = 0;
+    //! The offset of the chunk; dimensions past the rank are 0.
+    uint64_t offset[kPersistedRank] = {};
+    //! The number of bytes hashed.
+    uint64_t size = 0;
+    //! The filters skipped when the chunk was stored.
+    uint32_t filterMask = 0;
+    //! Was the chunk hashed as stored?  1 if it was; 0 otherwise.
+    uint8_t stored = 0;
+    //! The hash.
+    uint64_t hash = 0;
+};
+
+//! A chunk read to be hashed.
+struct HashChunk final
+{
+    //! The first element of the chunk, in each dimension.
+    std::array<hsize_t, H5S_MAX_RANK> offset{};
+    //! The bytes hashed.
+    std::vector<uint8_t> bytes;
+    //! The number of bytes hashed; bytes may hold more.
+    size_t size = 0;
+    //! The filters skipped when the chunk was stored.
+    uint32_t filterMask = 0;
+    //! The hash of the bytes.
+    uint64_t hash = 0;
+};
+
+//! Read 8 bytes, least significant first, whatever the host.
+uint64_t readUInt64(
+    const uint8_t* data) noexcept
+{
+    uint64_t value = 0;
+    for (int i=7; i>=0; --i)
+        value = (value << 8) | data[i];
+
+    return value;
+}
+
+//! Read 4 bytes, least significant first, whatever the host.
+uint64_t readUInt32(
+    const uint8_t* data) noexcept
+{
+    uint64_t value = 0;
+    for (int i=3; i>=0; --i)
+        value = (value << 8) | data[i];
+
+    return value;
+}
+
+//! Rotate the bits of a value left.
+uint64_t rotateLeft(
+    uint64_t value,
+    int bits) noexcept
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+//! Mix 8 bytes into an accumulator of xxHash64.
+uint64_t mixRound(
+    uint64_t accumulator,
+    uint64_t input) noexcept
+{
+    accumulator += input * kPrime2;
+    accumulator = rotateLeft(accumulator, 31);
+
+    return accumulator * kPrime1;
+}
+
+//! Merge an accumulator of xxHash64 into the hash.
+uint64_t mergeRound(
+    uint64_t accumulator,
+    uint64_t value) noexcept
+{
+    accumulator ^= mixRound(0, value);
+
+    return accumulator * kPrime1 + kPrime4;
+}
+
+//! Find where the variable length strings are in an element.
+/*!
+    Only strings that are the element, or a member of compound elements,
+    are found; BAGs hold no other variable length data.
+
+\param h5type
+    The type of the elements in the file.
+
+\return
+    The offsets of the strings in an element.
+*/
+std::vector<size_t> findVariableStrings(
+    const ::H5::DataType& h5type)
+{
+    std::vector<size_t> offsets;
+
+    if (h5type.getClass() == H5T_STRING)
+    {
+        if (::H5::StrType{h5type.getId()}.isVariableStr())
+            offsets.push_back(0);
+    }
+    else if (h5type.getClass() == H5T_COMPOUND)
+    {
+        const ::H5::CompType h5compType{h5type.getId()};
+
+        const auto numMembers = static_cast<unsigned>(
+            h5compType.getNmembers());
+        for (unsigned i=0; i<numMembers; ++i)
+            if (h5compType.getMemberClass(i) == H5T_STRING &&
+                h5compType.getMemberStrType(i).isVariableStr())
+                offsets.push_back(h5compType.getMemberOffset(i));
+    }
+
+    return offsets;
+}
+
+//! Copy elements holding variable length strings to bytes that can be
+//! hashed.
+/*!
+    Each string is replaced by its characters, and a terminating null, so
+    the bytes do not depend on where the strings were in memory.
+
+\param elements
+    The elements, read with their type in the file.
+\param numElements
+    The number of elements.
+\param elementSize
+    The size of an element, in bytes.
+\param stringOffsets
+    The offsets of the strings in an element, in order.
+\param bytes
+    Set to the bytes to hash.
+
+\return
+    The number of bytes.
+*/
+size_t flattenStrings(
+    const uint8_t* elements,
+    size_t numElements,
+    size_t elementSize,
+    const std::vector<size_t>& stringOffsets,
+    std::vector<uint8_t>& bytes)
+{
+    bytes.clear();
+
+    for (size_t i=0; i<numElements; ++i)
+    {
+        const auto* element = elements + i * elementSize;
+        size_t start = 0;
+
+        for (const auto offset : stringOffsets)
+        {
+            bytes.insert(bytes.end(), element + start, element + offset);
+
+            const char* string = nullptr;
+            std::memcpy(&string, element + offset, sizeof(string));
+            if (string)
+                bytes.insert(bytes.end(), string, string + std::strlen(string));
+            bytes.push_back(0);
+
+            start = offset + sizeof(string);
+        }
+
+        bytes.insert(bytes.end(), element + start, element + elementSize);
+    }
+
+    return bytes.size();
+}
+
+//! Create the HDF5 type of a PersistedChunkHash.
+::H5::CompType makePersistedType()
+{
+    const hsize_t offsetDims = kPersistedRank;
+    const ::H5::ArrayType offsetType{::H5::PredType::NATIVE_UINT64, 1,
+        &offsetDims};
+
+    ::H5::CompType h5type{sizeof(PersistedChunkHash)};
+    h5type.insertMember("dataset", HOFFSET(PersistedChunkHash, dataSet),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type.insertMember("rank", HOFFSET(PersistedChunkHash, rank),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type.insertMember("offset", HOFFSET(PersistedChunkHash, offset),
+        offsetType);
+    h5type.insertMember("size", HOFFSET(PersistedChunkHash, size),
+        ::H5::PredType::NATIVE_UINT64);
+    h5type.insertMember("filter_mask", HOFFSET(PersistedChunkHash, filterMask),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type.insertMember("stored", HOFFSET(PersistedChunkHash, stored),
+        ::H5::PredType::NATIVE_UINT8);
+    h5type.insertMember("hash", HOFFSET(PersistedChunkHash, hash),
+        ::H5::PredType::NATIVE_UINT64);
+
+    return h5type;
+}
+
+}  // namespace
+
+//! Hash bytes with the 64 bit xxHash, with a seed of 0.
+/*!
+    The hash is the same on every host.
+
+\param data
+    The bytes.
+\param size
+    The number of bytes.
+
+\return
+    The hash.
+*/
+uint64_t hashBytes(
+    const uint8_t* data,
+    size_t size) noexcept
+{
+    const auto* end = data + size;
+    uint64_t hash = 0;
+
+    if (size >= 32)
+    {
+        std::array<uint64_t, 4> lanes{kPrime1 + kPrime2, kPrime2, 0,
+            0 - kPrime1};
+
+        for (; end - data >= 32; data += 32)
+            for (size_t lane=0; lane<4; ++lane)
+                lanes[lane] = mixRound(lanes[lane],
+                    readUInt64(data + lane * 8));
+
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) +
+            rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+
+        for (const auto lane : lanes)
+            hash = mergeRound(hash, lane);
+    }
+    else
+        hash = kPrime5;
+
+    hash += size;
+
+    for (; end - data >= 8; data += 8)
+    {
+        hash ^= mixRound(0, readUInt64(data));
+        hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+    }
+
+    if (end - data >= 4)
+    {
+        hash ^= readUInt32(data) * kPrime1;
+        hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+    {
+        hash ^= *data * kPrime5;
+        hash = rotateLeft(hash, 11) * kPrime1;
+    }
+
+    // Avalanche.
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+//! Keep the hashes of the chunks of a BAG in it.
+/*!
+    The hashes replace any kept before.  They are kept in a DataSet of their
+    own, which is not hashed, with the paths of the DataSets in an
+    attribute of it.
+
+\param h5file
+    The HDF5 file of the BAG.
+\param hashes
+    The hashes.
+*/
+void writeChunkHashes(
+    ::H5::H5File& h5file,
+    const std::vector<ChunkHash>& hashes)
+{
+    if (H5Lexists(h5file.getId(), CHUNK_HASHES_PATH, H5P_DEFAULT) > 0)
+        h5file.unlink(CHUNK_HASHES_PATH);
+
+    std::vector<std::string> paths;
+    std::vector<PersistedChunkHash> records(hashes.size());
+
+    for (size_t i=0; i<hashes.size(); ++i)
+    {
+        const auto& hash = hashes[i];
+
+        // The hashes of a DataSet are together.
+        if (paths.empty() || paths.back() != hash.path)
+            paths.push_back(hash.path);
+
+        auto& record = records[i];
+        record.dataSet = static_cast<uint32_t>(paths.size() - 1);
+        record.rank = static_cast<uint32_t>(std::min<size_t>(
+            hash.offset.size(), kPersistedRank));
+        std::copy(hash.offset.begin(), hash.offset.begin() + record.rank,
+            record.offset);
+        record.size = hash.size;
+        record.filterMask = hash.filterMask;
+        record.stored = hash.stored ? 1 : 0;
+        record.hash = hash.hash;
+    }
+
+    const hsize_t numRecords = records.size();
+    const hsize_t maxRecords = H5S_UNLIMITED;
+    const ::H5::DataSpace h5dataSpace{1, &numRecords, &maxRecords};
+
+    const hsize_t chunkSize = std::max<hsize_t>(1,
+        std::min(numRecords, kPersistedChunkSize));
+
+    const ::H5::DSetCreatPropList h5createPropList{};
+    h5createPropList.setChunk(1, &chunkSize);
+    h5createPropList.setDeflate(6);
+
+    const auto h5type = makePersistedType();
+    const auto h5dataSet = h5file.createDataSet(CHUNK_HASHES_PATH, h5type,
+        h5dataSpace, h5createPropList);
+
+    if (numRecords > 0)
+        h5dataSet.write(records.data(), h5type);
+
+    std::vector<const char*> pathStrings;
+    for (const auto& path : paths)
+        pathStrings.push_back(path.c_str());
+
+    const hsize_t numPaths = pathStrings.size();
+    const ::H5::StrType h5strType{::H5::PredType::C_S1, H5T_VARIABLE};
+    const auto h5pathsAtt = h5dataSet.createAttribute(kPathsName, h5strType,
+        ::H5::DataSpace{1, &numPaths});
+
+    if (numPaths > 0)
+        h5pathsAtt.write(h5strType, pathStrings.data());
+}
+
+//! Read the hashes of the chunks of a BAG kept in it.
+/*!
+\param h5file
+    The HDF5 file of the BAG.
+
+\return
+    The hashes written by writeChunkHashes(); empty if there are none.
+*/
+std::vector<ChunkHash> readChunkHashes(
+    const ::H5::H5File& h5file)
+{
+    if (H5Lexists(h5file.getId(), CHUNK_HASHES_PATH, H5P_DEFAULT) <= 0)
+        return {};
+
+    const auto h5dataSet = h5file.openDataSet(CHUNK_HASHES_PATH);
+
+    // The paths of the DataSets.
+    std::vector<std::string> paths;
+    {
+        const auto h5pathsAtt = h5dataSet.openAttribute(kPathsName);
+        const auto h5space = h5pathsAtt.getSpace();
+        const auto numPaths = static_cast<size_t>(
+            h5space.getSimpleExtentNpoints());
+
+        if (numPaths > 0)
+        {
+            const ::H5::StrType h5strType{::H5::PredType::C_S1, H5T_VARIABLE};
+            std::vector<char*> pathStrings(numPaths);
+            h5pathsAtt.read(h5strType, pathStrings.data());
+
+            for (const auto* path : pathStrings)
+                paths.emplace_back(path ? path : "");
+
+            ::H5::DataSet::vlenReclaim(pathStrings.data(), h5strType,
+                h5space);
+        }
+    }
+
+    std::vector<PersistedChunkHash> records(static_cast<size_t>(
+        h5dataSet.getSpace().getSimpleExtentNpoints()));
+    if (!records.empty())
+        h5dataSet.read(records.data(), makePersistedType());
+
+    std::vector<ChunkHash> hashes(records.size());
+
+    for (size_t i=0; i<records.size(); ++i)
+    {
+        const auto& record = records[i];
+        auto& hash = hashes[i];
+
+        if (record.dataSet < paths.size())
+            hash.path = paths[record.dataSet];
+        hash.offset.assign(record.offset, record.offset +
+            std::min<uint32_t>(record.rank, kPersistedRank));
+        hash.size = record.size;
+        hash.filterMask = record.filterMask;
+        hash.stored = record.stored != 0;
+        hash.hash = record.hash;
+    }
+
+    return hashes;
+}
+
+//! Constructor.
+/*!
+\param dataset
+    The BAG.
+\param progress
+    Follows the progress of the hashing, and cancels it; may be null.
+*/
+ChunkHasher::ChunkHasher(
+    const Dataset& dataset,
+    ProgressToken* progress) noexcept
+    : m_dataset(dataset)
+    , m_progress(progress)
+{
+}
+
+//! Hash the chunks of the BAG.
+/*!
+\return
+    The hashes, by DataSet in the order HDF5 lists them, then by chunk.
+*/
+std::vector<ChunkHash> ChunkHasher::hash()
+{
+    std::vector<ChunkHash> hashes;
+    std::vector<std::string> paths;
+
+    {
+        const auto lock = m_dataset.lockReads();
+
+        this->findDataSets(m_dataset.getH5file().openGroup("/"), {}, paths);
+    }
+
+    // The hashes kept in the BAG are not hashed.
+    paths.erase(std::remove(paths.begin(), paths.end(),
+        std::string{CHUNK_HASHES_PATH}), paths.end());
+
+    const ProgressScope progress{m_progress};
+    const auto numPaths = static_cast<uint64_t>(paths.size());
+
+    for (uint64_t i=0; i<numPaths; ++i)
+    {
+        this->hashDataSet(paths[i], progress.part(i, i + 1, numPaths), hashes);
+        progress.report(i + 1, numPaths);
+    }
+
+    return hashes;
+}
+
+//! Find the DataSets in a group and its subgroups.
+/*!
+\param h5group
+    The group.
+\param path
+    The path of the group; empty for the root.
+\param paths
+    The paths of the DataSets are added to this.
+*/
+void ChunkHasher::findDataSets(
+    const ::H5::Group& h5group,
+    const std::string& path,
+    std::vector<std::string>& paths) const
+{
+    const hsize_t numObjects = h5group.getNumObjs();
+
+    for (hsize_t i=0; i<numObjects; ++i)
+    {
+        const auto name = h5group.getObjnameByIdx(i);
+        const auto childPath = path + '/' + name;
+
+        switch (h5group.childObjType(name))
+        {
+        case H5O_TYPE_GROUP:
+            this->findDataSets(h5group.openGroup(name), childPath, paths);
+            break;
+        case H5O_TYPE_DATASET:
+            paths.push_back(childPath);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+//! Hash every chunk of a DataSet.
+/*!
+    The chunks are read a batch at a time, holding the lock of the BAG.
+    They are then hashed on several threads without it.
+
+    A chunk is hashed as stored, compressed and read with H5Dread_chunk(),
+    so it can be copied as is.  A chunk never written is not hashed, as it
+    reads as the fill value.  The elements of DataSets that are not chunked,
+    or hold variable length strings, are read through HDF5 and hashed
+    instead; the rows of an unchunked DataSet are hashed in bands, each
+    counted as a chunk.
+
+\param path
+    The path of the DataSet.
+\param progress
+    Reports the progress of the DataSet.
+\param hashes
+    The hashes of the chunks are added to this.
+*/
+void ChunkHasher::hashDataSet(
+    const std::string& path,
+    const ProgressScope& progress,
+    std::vector<ChunkHash>& hashes) const
+{
+    auto lock = m_dataset.lockReads();
+
+    const auto h5dataSet = m_dataset.getH5file().openDataSet(path);
+    const auto h5fileType = h5dataSet.getDataType();
+    const auto h5fileSpace = h5dataSet.getSpace();
+    const auto h5createPropList = h5dataSet.getCreatePlist();
+
+    const size_t elementSize = h5fileType.getSize();
+
+    auto rank = h5fileSpace.getSimpleExtentNdims();
+    const bool scalar = rank == 0;
+
+    std::array<hsize_t, H5S_MAX_RANK> dims{};
+    if (!scalar)
+        h5fileSpace.getSimpleExtentDims(dims.data());
+    else
+    {
+        rank = 1;
+        dims[0] = 1;
+    }
+
+    if (std::any_of(dims.begin(), dims.begin() + rank,
+        [](hsize_t extent) { return extent == 0; }))
+        return;
+
+    std::array<hsize_t, H5S_MAX_RANK> chunkDims{};
+    const bool chunked = h5createPropList.getLayout() == H5D_CHUNKED;
+    if (chunked)
+        h5createPropList.getChunk(rank, chunkDims.data());
+    else
+    {
+        // Bands of whole rows.
+        size_t rowBytes = elementSize;
+        for (int d=1; d<rank; ++d)
+        {
+            chunkDims[d] = dims[d];
+            rowBytes *= static_cast<size_t>(dims[d]);
+        }
+
+        chunkDims[0] = std::min<hsize_t>(dims[0],
+            std::max<size_t>(1, kUnchunkedBandBytes / rowBytes));
+    }
+
+    // Variable length strings are stored as references to a heap, so their
+    // bytes say nothing of the strings.
+    const auto stringOffsets = findVariableStrings(h5fileType);
+
+    // Chunks written through HDF5 may still be in its chunk cache.
+    bool readStored = chunked && stringOffsets.empty() &&
+        H5Dflush(h5dataSet.getId()) >= 0;
+#if !H5_VERSION_GE(1, 10, 5)
+    // H5Dget_chunk_info_by_coord() is not available.
+    readStored = false;
+#endif
+
+    std::array<hsize_t, H5S_MAX_RANK> numChunks{};
+    size_t chunkElements = 1;
+    size_t totalChunks = 1;
+    for (int d=0; d<rank; ++d)
+    {
+        numChunks[d] = (dims[d] + chunkDims[d] - 1) / chunkDims[d];
+        chunkElements *= static_cast<size_t>(chunkDims[d]);
+        totalChunks *= static_cast<size_t>(numChunks[d]);
+    }
+
+    const auto chunkBytes = chunkElements * elementSize;
+    const auto batchSize = std::min(totalChunks,
+        std::max<size_t>(1, kHashBatchBytes / chunkBytes));
+    std::vector<HashChunk> chunks(batchSize);
+    std::vector<uint8_t> elements;
+
+    for (size_t batchStart=0; batchStart<totalChunks; batchStart+=batchSize)
+    {
+        const auto numInBatch = std::min(batchSize, totalChunks - batchStart);
+        size_t numRead = 0;
+
+        // HDF5 reads the chunks, one at a time.
+        for (size_t i=0; i<numInBatch; ++i)
+        {
+            auto& chunk = chunks[numRead];
+            chunk.filterMask = 0;
+
+            auto index = batchStart + i;
+            for (int d=rank - 1; d>=0; --d)
+            {
+                chunk.offset[d] = (index % numChunks[d]) * chunkDims[d];
+                index /= numChunks[d];
+            }
+
+#if H5_VERSION_GE(1, 10, 5)
+            if (chunked)
+            {
+                // A chunk that was never written has no address.
+                haddr_t address = HADDR_UNDEF;
+                hsize_t storedSize = 0;
+                if (H5Dget_chunk_info_by_coord(h5dataSet.getId(),
+                    chunk.offset.data(), &chunk.filterMask, &address,
+                    &storedSize) < 0)
+                    throw ::H5::DataSetIException{"ChunkHasher::hashDataSet",
+                        "H5Dget_chunk_info_by_coord failed"};
+
+                if (address == HADDR_UNDEF)
+                    continue;
+
+                if (readStored)
+                {
+                    chunk.size = static_cast<size_t>(storedSize);
+                    if (chunk.bytes.size() < chunk.size)
+                        chunk.bytes.resize(chunk.size);
+
+                    if (H5Dread_chunk(h5dataSet.getId(), H5P_DEFAULT,
+                        chunk.offset.data(), &chunk.filterMask,
+                        chunk.bytes.data()) < 0)
+                        throw ::H5::DataSetIException{
+                            "ChunkHasher::hashDataSet", "H5Dread_chunk failed"};
+                }
+            }
+#endif
+
+            if (!readStored)
+            {
+                // The elements of the chunk within the DataSet, packed.
+                std::array<hsize_t, H5S_MAX_RANK> counts{};
+                size_t numElements = 1;
+                for (int d=0; d<rank; ++d)
+                {
+                    counts[d] = std::min(chunkDims[d], dims[d] -
+                        chunk.offset[d]);
+                    numElements *= static_cast<size_t>(counts[d]);
+                }
+
+                auto& buffer = stringOffsets.empty() ? chunk.bytes : elements;
+                if (buffer.size() < numElements * elementSize)
+                    buffer.resize(numElements * elementSize);
+
+                const ::H5::DataSpace h5memSpace{rank, counts.data()};
+
+                if (scalar)
+                    h5dataSet.read(buffer.data(), h5fileType);
+                else
+                {
+                    h5fileSpace.selectHyperslab(H5S_SELECT_SET, counts.data(),
+                        chunk.offset.data());
+                    h5dataSet.read(buffer.data(), h5fileType, h5memSpace,
+                        h5fileSpace);
+                }
+
+                if (stringOffsets.empty())
+                    chunk.size = numElements * elementSize;
+                else
+                {
+                    chunk.size = flattenStrings(elements.data(), numElements,
+                        elementSize, stringOffsets, chunk.bytes);
+                    ::H5::DataSet::vlenReclaim(elements.data(), h5fileType,
+                        h5memSpace);
+                }
+            }
+
+            ++numRead;
+        }
+
+        if (numRead > 0)
+        {
+            // Without concurrent reads or writes, the BAG has no lock.
+            const auto locked = lock.owns_lock();
+            if (locked)
+                lock.unlock();
+
+            processInBlocks(0, static_cast<uint32_t>(numRead - 1),
+                static_cast<uint32_t>(std::min<size_t>(chunkElements,
+                    std::numeric_limits<uint32_t>::max())),
+                [&chunks](uint32_t first, uint32_t last) {
+                    for (auto index=first; index<=last; ++index)
+                        chunks[index].hash = hashBytes(
+                            chunks[index].bytes.data(), chunks[index].size);
+                });
+
+            if (locked)
+                lock.lock();
+        }
+
+        for (size_t i=0; i<numRead; ++i)
+        {
+            const auto& chunk = chunks[i];
+
+            ChunkHash hash;
+            hash.path = path;
+            hash.offset.assign(chunk.offset.begin(),
+                chunk.offset.begin() + (scalar ? 0 : rank));
+            hash.size = chunk.size;
+            hash.filterMask = chunk.filterMask;
+            hash.stored = readStored;
+            hash.hash = chunk.hash;
+            hashes.push_back(std::move(hash));
+        }
+
+        progress.report(batchStart + numInBatch, totalChunks);
+    }
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,53 @@
+#ifndef BAG_CHUNKHASH_H
+#define BAG_CHUNKHASH_H
+
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace H5 {
+
+class Group;
+class H5File;
+
+}  // namespace H5
+
+namespace BAG {
+
+class ProgressScope;
+
+//! Hashes every chunk of every DataSet of a BAG; see Dataset::hashChunks().
+class ChunkHasher final
+{
+public:
+    ChunkHasher(const Dataset& dataset, ProgressToken* progress) noexcept;
+
+    std::vector<ChunkHash> hash();
+
+private:
+    void findDataSets(const ::H5::Group& h5group, const std::string& path,
+        std::vector<std::string>& paths) const;
+    void hashDataSet(const std::string& path, const ProgressScope& progress,
+        std::vector<ChunkHash>& hashes) const;
+
+    //! The BAG.
+    const Dataset& m_dataset;
+    //! Follows the progress of the hashing, and cancels it; may be null.
+    ProgressToken* m_progress = nullptr;
+};
+
+uint64_t hashBytes(const uint8_t* data, size_t size) noexcept;
+
+void writeChunkHashes(::H5::H5File& h5file,
+    const std::vector<ChunkHash>& hashes);
+std::vector<ChunkHash> readChunkHashes(const ::H5::H5File& h5file);
+
+}  // namespace BAG
+
+#endif  // BAG_CHUNKHASH_H
+
@@ -93,6 +93,7 @@ public:
         The object to be moved from.
     */
     CompoundDataType(CompoundDataType&& other)
+        : type(other.type)
     {
         switch (type)
         {
@@ -135,9 +136,12 @@ public:
         if (type == DT_STRING)
         {
             if (rhs.type == DT_STRING)
+            {
                 m_data.m_s = rhs.m_data.m_s;
-            else
-                m_data.m_s.~basic_string<char>();
+                return *this;
+            }
+
+            m_data.m_s.~basic_string<char>();
         }
 
         switch (rhs.type)
@@ -172,12 +176,18 @@ public:
     */
     CompoundDataType& operator=(CompoundDataType&& rhs)
     {
+        if (this == &rhs)
+            return *this;
+
         if (type == DT_STRING)
         {
             if (rhs.type == DT_STRING)
+            {
                 m_data.m_s = std::move(rhs.m_data.m_s);
-            else
-                m_data.m_s.~basic_string<char>();
+                return *this;
+            }
+
+            m_data.m_s.~basic_string<char>();
         }
 
         switch (rhs.type)
@@ -192,7 +202,7 @@ public:
             m_data.m_b = rhs.m_data.m_b;
             break;
         case DT_STRING:
-            new(&m_data.m_s) std::string{rhs.m_data.m_s};
+            new(&m_data.m_s) std::string{std::move(rhs.m_data.m_s)};
             break;
         default:
             throw InvalidType{};
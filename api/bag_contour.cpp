@@ -0,0 +1,629 @@
+
+#include "bag_contour.h"
+#include "bag_exceptions.h"
+#include "bag_neighbourhood.h"
+#include "bag_private.h"
+#include "bag_simplelayer.h"
+#include "bag_simplelayerdescriptor.h"
+#include "bag_vrresampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! Is a value read as a float null?
+/*!
+\param value
+    The value.
+\param nullValue
+    The null value of the grid it was read from, as a float.
+
+\return
+    \e true if the value is null or NaN.
+*/
+inline bool isNullValue(
+    float value,
+    float nullValue) noexcept
+{
+    return value == nullValue || value != value;
+}
+
+//! A piece of a contour line crossing a cell of the grid.
+struct Segment final
+{
+    //! The level; an index into the levels, or a multiple of the interval.
+    int64_t level = 0;
+    //! The edge of the cell the segment starts on.
+    uint64_t startEdge = 0;
+    //! The edge of the cell the segment ends on.
+    uint64_t endEdge = 0;
+    //! The position it starts at, in columns and rows.
+    ContourPoint start;
+    //! The position it ends at.
+    ContourPoint end;
+};
+
+//! The end of a contour line being traced: a level, and an edge of a cell.
+struct LineEnd final
+{
+    bool operator==(const LineEnd& rhs) const noexcept
+    {
+        return level == rhs.level && edge == rhs.edge;
+    }
+
+    //! The level.
+    int64_t level = 0;
+    //! The edge.
+    uint64_t edge = 0;
+};
+
+//! Hashes a LineEnd.
+struct LineEndHash final
+{
+    size_t operator()(const LineEnd& end) const noexcept
+    {
+        return std::hash<uint64_t>{}(end.edge ^
+            (static_cast<uint64_t>(end.level) * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+//! Traces the contour lines of a grid a band of chunks at a time.
+/*!
+    The cells of each band are visited with marching squares, a tile a chunk
+    wide at a time, on several threads.  Each tile yields the segments of the
+    lines crossing its cells; they are then joined, in order, to the lines
+    being traced, by the edges of the cells they start and end on.  A line is
+    passed to the callback as soon as neither of its ends can be continued
+    by the next band, so only the lines crossing the boundary of the band are
+    held in memory.
+*/
+class ContourTracer final
+{
+public:
+    ContourTracer(NeighbourhoodScanner& scanner,
+        const ContourOptions& options, const ContourCallback& callback);
+
+    void trace();
+
+private:
+    //! A contour line being traced.
+    struct Line final
+    {
+        //! The level.
+        int64_t level = 0;
+        //! The edge the line starts on.
+        uint64_t startEdge = 0;
+        //! The edge the line ends on.
+        uint64_t endEdge = 0;
+        //! The vertices, in columns and rows.
+        std::deque<ContourPoint> points;
+    };
+
+    double getLevel(int64_t level) const noexcept;
+    template <typename Function>
+    void forEachLevel(double min, double max, Function&& function) const;
+
+    void traceTile(const NeighbourhoodBand& band, uint32_t columnStart,
+        uint32_t columnEnd, std::vector<Segment>& segments) const;
+    void addSegment(const Segment& segment);
+    void emitLines(uint64_t nextRow);
+    void emitLine(const Line& line, bool closed);
+
+    //! The grid traced.
+    NeighbourhoodScanner& m_scanner;
+    //! The options.
+    const ContourOptions& m_options;
+    //! Receives the lines traced.
+    const ContourCallback& m_callback;
+    //! The levels listed, in ascending order without duplicates.
+    std::vector<double> m_levels;
+    //! The number of columns of the grid.
+    uint32_t m_numColumns = 0;
+    //! The null value of the grid.
+    float m_nullValue = 0.f;
+    //! The lines being traced, in the order they were started.
+    std::map<size_t, Line> m_lines;
+    //! The line starting at each end, by line number.
+    std::unordered_map<LineEnd, size_t, LineEndHash> m_starts;
+    //! The line ending at each end.
+    std::unordered_map<LineEnd, size_t, LineEndHash> m_ends;
+    //! The number of the next line started.
+    size_t m_nextLine = 0;
+    //! The line passed to the callback; kept to reuse its vertices.
+    ContourLine m_output;
+};
+
+//! Constructor.
+/*!
+    An InvalidContourLevels exception is thrown if no levels are listed and
+    the interval is not positive, or a level is not finite.
+
+\param scanner
+    The grid traced, with a halo of at least 1.
+\param options
+    The levels traced.
+\param callback
+    Receives the lines traced.
+*/
+ContourTracer::ContourTracer(
+    NeighbourhoodScanner& scanner,
+    const ContourOptions& options,
+    const ContourCallback& callback)
+    : m_scanner(scanner)
+    , m_options(options)
+    , m_callback(callback)
+    , m_levels(options.levels)
+    , m_numColumns(scanner.getNumColumns())
+    , m_nullValue(scanner.getNullValue())
+{
+    if (m_levels.empty())
+    {
+        if (!(m_options.interval > 0.) || !std::isfinite(m_options.interval) ||
+            !std::isfinite(m_options.base))
+            throw InvalidContourLevels{};
+    }
+    else
+    {
+        if (!std::all_of(m_levels.begin(), m_levels.end(),
+            [](double level) { return std::isfinite(level); }))
+            throw InvalidContourLevels{};
+
+        std::sort(m_levels.begin(), m_levels.end());
+        m_levels.erase(std::unique(m_levels.begin(), m_levels.end()),
+            m_levels.end());
+    }
+}
+
+//! Trace the lines, passing each to the callback once it is complete.
+void ContourTracer::trace()
+{
+    const auto numRows = m_scanner.getNumRows();
+
+    std::vector<std::vector<Segment>> tiles;
+    std::mutex mutex;
+    std::exception_ptr pError;
+
+    m_scanner.scan([&](const NeighbourhoodBand& band) {
+        const auto numTiles = (m_numColumns - 1) /
+            m_scanner.getTileColumns() + 1;
+        tiles.resize(numTiles);
+
+        band.forEachTile([&](uint32_t columnStart, uint32_t columnEnd) {
+            auto& segments = tiles[columnStart / m_scanner.getTileColumns()];
+            segments.clear();
+
+            try
+            {
+                this->traceTile(band, columnStart, columnEnd, segments);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard{mutex};
+                pError = std::current_exception();
+            }
+        });
+
+        if (pError)
+            std::rethrow_exception(pError);
+
+        for (const auto& segments : tiles)
+            for (const auto& segment : segments)
+                this->addSegment(segment);
+
+        this->emitLines(uint64_t{band.getRowEnd()} + 1);
+    }, m_options.progress);
+
+    this->emitLines(numRows);
+}
+
+//! Retrieve the value of a level.
+/*!
+\param level
+    An index into the levels listed, or if there are none, the number of
+    intervals from the base.
+
+\return
+    The value of the level.
+*/
+double ContourTracer::getLevel(
+    int64_t level) const noexcept
+{
+    return m_levels.empty() ?
+        m_options.base + static_cast<double>(level) * m_options.interval :
+        m_levels[static_cast<size_t>(level)];
+}
+
+//! Visit the levels crossing a cell.
+/*!
+\param min
+    The lowest value at a corner of the cell.
+\param max
+    The highest value.
+\param function
+    Called with each level above min and at most max, and its value.
+*/
+template <typename Function>
+void ContourTracer::forEachLevel(
+    double min,
+    double max,
+    Function&& function) const
+{
+    if (!m_levels.empty())
+    {
+        const auto first = std::upper_bound(m_levels.begin(), m_levels.end(),
+            min);
+        const auto last = std::upper_bound(first, m_levels.end(), max);
+
+        for (auto level=first; level!=last; ++level)
+            function(level - m_levels.begin(), *level);
+
+        return;
+    }
+
+    // The first and last multiples are checked against the values computed
+    // by getLevel(), so rounding cannot disagree with the other cells.
+    const auto interval = m_options.interval;
+    const auto first = static_cast<int64_t>(
+        std::floor((min - m_options.base) / interval));
+    const auto last = static_cast<int64_t>(
+        std::floor((max - m_options.base) / interval)) + 1;
+
+    for (auto level=first; level<=last; ++level)
+    {
+        const auto value = this->getLevel(level);
+        if (value > min && value <= max)
+            function(level, value);
+    }
+}
+
+//! Trace the segments crossing the cells of a tile of a band.
+/*!
+    A cell has a node of the band at its south west corner.  A corner is
+    above a level if its value is at or above it.  Each segment runs with
+    the corners above on its right, so the end of one is the start of the
+    next.  The cells with a null corner have none; the saddles, with
+    diagonal corners above, are split by the average of the corners.
+
+\param band
+    The band.
+\param columnStart
+    The first column of the tile.
+\param columnEnd
+    The last column of the tile (inclusive).
+\param segments
+    The segments, in the order of their cells and levels.
+*/
+void ContourTracer::traceTile(
+    const NeighbourhoodBand& band,
+    uint32_t columnStart,
+    uint32_t columnEnd,
+    std::vector<Segment>& segments) const
+{
+    const auto numRows = m_scanner.getNumRows();
+    const auto numColumns = uint64_t{m_numColumns};
+    const auto nullValue = m_nullValue;
+    const auto lastColumn = std::min<uint64_t>(columnEnd, numColumns - 2);
+
+    for (uint64_t row=band.getRowStart();
+        row<=band.getRowEnd() && row + 1 < numRows; ++row)
+    {
+        const float* south = band.getRow(static_cast<int64_t>(row));
+        const float* north = band.getRow(static_cast<int64_t>(row) + 1);
+
+        for (uint64_t column=columnStart; column<=lastColumn; ++column)
+        {
+            // The corners counterclockwise from the south west.
+            const float corners[4] = {south[column], south[column + 1],
+                north[column + 1], north[column]};
+
+            if (isNullValue(corners[0], nullValue) ||
+                isNullValue(corners[1], nullValue) ||
+                isNullValue(corners[2], nullValue) ||
+                isNullValue(corners[3], nullValue))
+                continue;
+
+            const auto min = std::min(std::min(corners[0], corners[1]),
+                std::min(corners[2], corners[3]));
+            const auto max = std::max(std::max(corners[0], corners[1]),
+                std::max(corners[2], corners[3]));
+            if (min == max)
+                continue;
+
+            // The edges counterclockwise from the south, from one corner to
+            // the next; the south and north edges of a cell are the
+            // horizontal edges of its row and the next, and the west and east
+            // edges the vertical edges of its column and the next.
+            const auto cell = row * numColumns + column;
+            const uint64_t edges[4] = {cell * 2, (cell + 1) * 2 + 1,
+                (cell + numColumns) * 2, cell * 2 + 1};
+
+            // Where a level crosses an edge.  The position is interpolated
+            // from its south or west corner, so the cells either side agree.
+            const auto crossing = [&](size_t edge, double level) {
+                const auto x = static_cast<double>(column);
+                const auto y = static_cast<double>(row);
+
+                switch (edge)
+                {
+                case 0:
+                    return ContourPoint{x + (level - corners[0]) /
+                        (double{corners[1]} - corners[0]), y};
+                case 1:
+                    return ContourPoint{x + 1., y + (level -
+                        corners[1]) / (double{corners[2]} - corners[1])};
+                case 2:
+                    return ContourPoint{x + (level - corners[3]) /
+                        (double{corners[2]} - corners[3]), y + 1.};
+                case 3:  //[[fallthrough]]
+                default:
+                    return ContourPoint{x, y + (level - corners[0]) /
+                        (double{corners[3]} - corners[0])};
+                }
+            };
+
+            this->forEachLevel(min, max, [&](int64_t level, double value) {
+                bool above[4];
+                for (size_t corner=0; corner<4; ++corner)
+                    above[corner] = corners[corner] >= value;
+
+                // A segment starts on an edge rising counterclockwise, and
+                // ends on the next falling one; in a saddle whose middle is
+                // above, on the one before instead.
+                const auto isSaddle = above[0] == above[2] &&
+                    above[1] == above[3];
+                const auto middleAbove = (double{corners[0]} + corners[1] +
+                    corners[2] + corners[3]) / 4. >= value;
+                const size_t step = isSaddle && middleAbove ? 3 : 1;
+
+                for (size_t edge=0; edge<4; ++edge)
+                {
+                    if (above[edge] || !above[(edge + 1) % 4])
+                        continue;
+
+                    auto end = (edge + step) % 4;
+                    while (!above[end] || above[(end + 1) % 4])
+                        end = (end + step) % 4;
+
+                    Segment segment;
+                    segment.level = level;
+                    segment.startEdge = edges[edge];
+                    segment.endEdge = edges[end];
+                    segment.start = crossing(edge, value);
+                    segment.end = crossing(end, value);
+                    segments.push_back(segment);
+                }
+            });
+        }
+    }
+}
+
+//! Join a segment to the lines being traced.
+/*!
+    A line ending where the segment starts is continued by it, and a line
+    starting where it ends is preceded by it.  If both are the same line,
+    it is a ring and is passed to the callback.
+
+\param segment
+    The segment.
+*/
+void ContourTracer::addSegment(
+    const Segment& segment)
+{
+    const LineEnd start{segment.level, segment.startEdge};
+    const LineEnd end{segment.level, segment.endEdge};
+
+    const auto before = m_ends.find(start);
+    const auto after = m_starts.find(end);
+
+    if (before == m_ends.end() && after == m_starts.end())
+    {
+        auto& line = m_lines[m_nextLine];
+        line.level = segment.level;
+        line.startEdge = segment.startEdge;
+        line.endEdge = segment.endEdge;
+        line.points = {segment.start, segment.end};
+
+        m_starts.emplace(start, m_nextLine);
+        m_ends.emplace(end, m_nextLine);
+        ++m_nextLine;
+        return;
+    }
+
+    if (after == m_starts.end())
+    {
+        const auto number = before->second;
+        auto& line = m_lines[number];
+        line.points.push_back(segment.end);
+        line.endEdge = segment.endEdge;
+
+        m_ends.erase(before);
+        m_ends.emplace(end, number);
+        return;
+    }
+
+    if (before == m_ends.end())
+    {
+        const auto number = after->second;
+        auto& line = m_lines[number];
+        line.points.push_front(segment.start);
+        line.startEdge = segment.startEdge;
+
+        m_starts.erase(after);
+        m_starts.emplace(start, number);
+        return;
+    }
+
+    const auto first = before->second;
+    const auto second = after->second;
+    m_ends.erase(before);
+    m_starts.erase(after);
+
+    if (first == second)
+    {
+        const auto line = m_lines.find(first);
+        line->second.points.push_back(line->second.points.front());
+        this->emitLine(line->second, true);
+        m_lines.erase(line);
+        return;
+    }
+
+    // Join the shorter line to the longer one.
+    auto& firstLine = m_lines[first];
+    auto& secondLine = m_lines[second];
+
+    if (firstLine.points.size() >= secondLine.points.size())
+    {
+        firstLine.points.insert(firstLine.points.end(),
+            secondLine.points.begin(), secondLine.points.end());
+        firstLine.endEdge = secondLine.endEdge;
+        m_ends[{secondLine.level, secondLine.endEdge}] = first;
+        m_lines.erase(second);
+    }
+    else
+    {
+        secondLine.points.insert(secondLine.points.begin(),
+            firstLine.points.begin(), firstLine.points.end());
+        secondLine.startEdge = firstLine.startEdge;
+        m_starts[{firstLine.level, firstLine.startEdge}] = second;
+        m_lines.erase(first);
+    }
+}
+
+//! Pass the lines that cannot be continued to the callback.
+/*!
+\param nextRow
+    The first row of the next band.  Only a line ending on a horizontal edge
+    of this row can be continued.
+*/
+void ContourTracer::emitLines(
+    uint64_t nextRow)
+{
+    const auto numColumns = uint64_t{m_numColumns};
+    const auto canContinue = [nextRow, numColumns](uint64_t edge) {
+        return edge % 2 == 0 && edge / 2 / numColumns == nextRow;
+    };
+
+    for (auto line=m_lines.begin(); line!=m_lines.end();)
+    {
+        if (canContinue(line->second.startEdge) ||
+            canContinue(line->second.endEdge))
+        {
+            ++line;
+            continue;
+        }
+
+        this->emitLine(line->second, false);
+
+        m_starts.erase({line->second.level, line->second.startEdge});
+        m_ends.erase({line->second.level, line->second.endEdge});
+        line = m_lines.erase(line);
+    }
+}
+
+//! Pass a line to the callback, in the units of the grid spacing.
+/*!
+\param line
+    The line.
+\param closed
+    Whether the line is a ring.
+*/
+void ContourTracer::emitLine(
+    const Line& line,
+    bool closed)
+{
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = m_scanner.getOrigin();
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = m_scanner.getSpacing();
+
+    m_output.level = this->getLevel(line.level);
+    m_output.closed = closed;
+    m_output.points.resize(line.points.size());
+    std::transform(line.points.begin(), line.points.end(),
+        m_output.points.begin(), [&](const ContourPoint& point) {
+            return ContourPoint{originX + point.x * spacingX,
+                originY + point.y * spacingY};
+        });
+
+    m_callback(m_output);
+}
+
+}  // namespace
+
+//! Trace the contour lines of a simple layer.
+/*!
+    The layer is read a row of chunks at a time, and the lines are traced
+    with marching squares, a chunk at a time, on several threads.  Each line
+    is passed to the callback once it is complete, so only the lines
+    crossing the current row of chunks are held in memory.  The lines do not
+    cross the cells with a null or NaN corner.
+
+    An InvalidContourLevels exception is thrown if no levels are listed and
+    the interval is not positive, or a level is not finite.  If
+    options.progress is cancelled, an OperationCancelled exception is
+    thrown; the lines passed to the callback so far are complete.
+
+\param layer
+    The layer; typically the elevations.
+\param options
+    The levels traced.
+\param callback
+    Called with each line, on the calling thread.  The line is only valid
+    for the call.
+*/
+void traceContours(
+    const SimpleLayer& layer,
+    const ContourOptions& options,
+    const ContourCallback& callback)
+{
+    NeighbourhoodScanner scanner{layer, 1};
+
+    const TraceScope trace{"traceContours",
+        layer.getDescriptor()->getName().c_str(), scanner.getNumRows(),
+        scanner.getNumColumns()};
+
+    ContourTracer{scanner, options, callback}.trace();
+}
+
+//! Trace the contour lines of the output grid of a VRResampler.
+/*!
+    As traceContours() on a simple layer, with the output grid resampled a
+    row of chunks at a time, so it is never held in memory.  The nodes with
+    no refinement under them are BAG_NULL_ELEVATION.
+
+\param resampler
+    The resampler.
+\param method
+    How the refinements are combined.
+\param options
+    The levels traced.
+\param callback
+    Called with each line, on the calling thread.  The line is only valid
+    for the call.
+*/
+void traceContours(
+    const VRResampler& resampler,
+    VRResampleMethod method,
+    const ContourOptions& options,
+    const ContourCallback& callback)
+{
+    NeighbourhoodScanner scanner{resampler, method, 1};
+
+    const TraceScope trace{"traceContours", "VR", scanner.getNumRows(),
+        scanner.getNumColumns()};
+
+    ContourTracer{scanner, options, callback}.trace();
+}
+
+}  // namespace BAG
@@ -0,0 +1,24 @@
+#ifndef BAG_CONTOUR_H
+#define BAG_CONTOUR_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <functional>
+
+
+namespace BAG {
+
+//! Receives each contour line traced, once it is complete.
+using ContourCallback = std::function<void(const ContourLine&)>;
+
+BAG_API void traceContours(const SimpleLayer& layer,
+    const ContourOptions& options, const ContourCallback& callback);
+BAG_API void traceContours(const VRResampler& resampler,
+    VRResampleMethod method, const ContourOptions& options,
+    const ContourCallback& callback);
+
+}  // namespace BAG
+
+#endif  // BAG_CONTOUR_H
@@ -0,0 +1,1234 @@
+
+#include "bag_copy.h"
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_georefmetadatalayer.h"
+#include "bag_georefmetadatalayerdescriptor.h"
+#include "bag_interleavedlegacylayer.h"
+#include "bag_interleavedlegacylayerdescriptor.h"
+#include "bag_metadata_export.h"
+#include "bag_metadata_import.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayer.h"
+#include "bag_surfacecorrections.h"
+#include "bag_surfacecorrectionsdescriptor.h"
+#include "bag_trackinglist.h"
+#include "bag_valuetable.h"
+#include "bag_vrmetadata.h"
+#include "bag_vrmetadatadescriptor.h"
+#include "bag_vrnode.h"
+#include "bag_vrrefinements.h"
+#include "bag_vrrefinementsdescriptor.h"
+#include "bag_vrtrackinglist.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! The most nodes of a grid copied at once.
+constexpr size_t kCopyBandCells = 1 << 22;
+//! The most refinements (and their nodes and keys) copied at once.
+constexpr size_t kCopyBlockItems = 1 << 20;
+//! How far, in nodes, a node may lie outside a geographic window and still
+//! be copied; it absorbs rounding of the corners.
+constexpr double kGeoWindowTolerance = 1e-6;
+
+//! A window of a grid.
+struct GridWindow final
+{
+    //! The starting row.
+    uint32_t rowStart = 0;
+    //! The starting column.
+    uint32_t columnStart = 0;
+    //! The ending row (inclusive).
+    uint32_t rowEnd = 0;
+    //! The ending column (inclusive).
+    uint32_t columnEnd = 0;
+
+    //! Retrieve the number of rows in the window.
+    uint32_t rows() const noexcept
+    {
+        return rowEnd - rowStart + 1;
+    }
+
+    //! Retrieve the number of columns in the window.
+    uint32_t columns() const noexcept
+    {
+        return columnEnd - columnStart + 1;
+    }
+
+    //! Determine if a node is in the window.
+    bool contains(
+        uint32_t row,
+        uint32_t column) const noexcept
+    {
+        return row >= rowStart && row <= rowEnd &&
+            column >= columnStart && column <= columnEnd;
+    }
+};
+
+//! A run of consecutive refinements of the source.
+struct RefinementRun final
+{
+    //! The first refinement.
+    uint64_t first = 0;
+    //! The number of refinements.
+    uint64_t count = 0;
+};
+
+//! Frees the strings of a BagMetadata when it goes out of scope.
+struct MetadataGuard final
+{
+    ~MetadataGuard() noexcept
+    {
+        bagFreeMetadata(metadata);
+    }
+
+    //! The metadata.
+    BagMetadata& metadata;
+};
+
+//! Find the nodes of a dimension of a grid inside [min, max].
+/*!
+\param min
+    The start of the range.
+\param max
+    The end of the range.
+\param origin
+    The position of the first node.
+\param resolution
+    The distance between two nodes.
+\param numNodes
+    The number of nodes.
+\param first
+    Set to the first node inside the range.
+\param last
+    Set to the last node inside the range.
+
+\return
+    \e true if any node is inside the range.
+*/
+bool findNodes(
+    double min,
+    double max,
+    double origin,
+    double resolution,
+    uint32_t numNodes,
+    uint32_t& first,
+    uint32_t& last) noexcept
+{
+    if (numNodes == 0 || !(resolution > 0.) || !(min <= max))
+        return false;
+
+    const auto from = std::max(0.,
+        std::ceil((min - origin) / resolution - kGeoWindowTolerance));
+    const auto to = std::min(static_cast<double>(numNodes - 1),
+        std::floor((max - origin) / resolution + kGeoWindowTolerance));
+
+    if (from > to)
+        return false;
+
+    first = static_cast<uint32_t>(from);
+    last = static_cast<uint32_t>(to);
+
+    return true;
+}
+
+//! Find the window of the grid of a BAG to copy.
+/*!
+\param source
+    The BAG being copied.
+\param options
+    The options of the copy.
+
+\return
+    The window, clipped to the grid.
+*/
+GridWindow getCopyWindow(
+    const Dataset& source,
+    const CopyOptions& options)
+{
+    const auto& metadata = source.getMetadata();
+    const auto numRows = metadata.rows();
+    const auto numColumns = metadata.columns();
+
+    GridWindow window;
+
+    if (options.useGeoWindow)
+    {
+        // Rows run north, and columns east, from the lower left corner.
+        if (!findNodes(options.minX, options.maxX, metadata.llCornerX(),
+                metadata.columnResolution(), numColumns, window.columnStart,
+                window.columnEnd) ||
+            !findNodes(options.minY, options.maxY, metadata.llCornerY(),
+                metadata.rowResolution(), numRows, window.rowStart,
+                window.rowEnd))
+            throw InvalidCopyWindow{};
+
+        return window;
+    }
+
+    if (numRows == 0 || numColumns == 0 ||
+        options.rowStart >= numRows || options.columnStart >= numColumns ||
+        options.rowStart > options.rowEnd ||
+        options.columnStart > options.columnEnd)
+        throw InvalidCopyWindow{};
+
+    window.rowStart = options.rowStart;
+    window.columnStart = options.columnStart;
+    window.rowEnd = std::min(options.rowEnd, numRows - 1);
+    window.columnEnd = std::min(options.columnEnd, numColumns - 1);
+
+    return window;
+}
+
+//! Make the metadata of a copy of a window of a BAG.
+/*!
+\param source
+    The BAG being copied.
+\param window
+    The window being copied.
+
+\return
+    The metadata of the source, with the dimensions and corners of the
+    window.
+*/
+Metadata makeCopyMetadata(
+    const Dataset& source,
+    const GridWindow& window)
+{
+    const auto xmlBuffer = exportMetadataToXML(source.getMetadata().getStruct());
+
+    BagMetadata metaStruct;
+    bagInitMetadata(metaStruct);
+    const MetadataGuard guard{metaStruct};
+
+    const auto err = bagImportMetadataFromXmlBuffer(xmlBuffer.c_str(),
+        static_cast<int>(xmlBuffer.size()), metaStruct, false);
+    if (err != BAG_SUCCESS)
+        throw ErrorLoadingMetadata{err};
+
+    auto& spatial = *metaStruct.spatialRepresentationInfo;
+    const auto llCornerX = spatial.llCornerX;
+    const auto llCornerY = spatial.llCornerY;
+
+    spatial.numberOfRows = window.rows();
+    spatial.numberOfColumns = window.columns();
+    spatial.llCornerX = llCornerX + window.columnStart * spatial.columnResolution;
+    spatial.llCornerY = llCornerY + window.rowStart * spatial.rowResolution;
+    spatial.urCornerX = llCornerX + window.columnEnd * spatial.columnResolution;
+    spatial.urCornerY = llCornerY + window.rowEnd * spatial.rowResolution;
+
+    Metadata metadata;
+    metadata.loadFromBuffer(exportMetadataToXML(metaStruct));
+
+    return metadata;
+}
+
+//! Split records of the node group of an old BAG into a buffer per field.
+/*!
+\param records
+    The records.
+\param count
+    The number of records.
+\param fields
+    The Hypothesis_Strength and Num_Hypotheses buffers, at the node of the
+    first record.
+*/
+void splitRecords(
+    const BagOptNodeGroup* records,
+    size_t count,
+    const std::array<uint8_t*, 2>& fields) noexcept
+{
+    auto* hypothesisStrength = reinterpret_cast<float*>(fields[0]);
+    auto* numHypotheses = reinterpret_cast<uint32_t*>(fields[1]);
+
+    for (size_t i=0; i<count; ++i)
+    {
+        hypothesisStrength[i] = records[i].hyp_strength;
+        numHypotheses[i] = records[i].num_hypotheses;
+    }
+}
+
+//! Split records of the elevation solution group of an old BAG into a buffer
+//! per field.
+/*!
+\param records
+    The records.
+\param count
+    The number of records.
+\param fields
+    The Shoal_Elevation, Std_Dev and Num_Soundings buffers, at the node of
+    the first record.
+*/
+void splitRecords(
+    const BagOptElevationSolutionGroup* records,
+    size_t count,
+    const std::array<uint8_t*, 3>& fields) noexcept
+{
+    auto* shoalElevation = reinterpret_cast<float*>(fields[0]);
+    auto* stdDev = reinterpret_cast<float*>(fields[1]);
+    auto* numSoundings = reinterpret_cast<uint32_t*>(fields[2]);
+
+    for (size_t i=0; i<count; ++i)
+    {
+        shoalElevation[i] = records[i].shoal_elevation;
+        stdDev[i] = records[i].stddev;
+        numSoundings[i] = static_cast<uint32_t>(records[i].num_soundings);
+    }
+}
+
+//! Pick the chunk shape of a copied layer.
+/*!
+\param descriptor
+    The descriptor of the layer being copied.
+\param window
+    The window of the layer being copied.
+\param options
+    The options of the copy.
+
+\return
+    The new chunk shape if rechunking, otherwise that of the layer; either
+    is clipped to the window, as the layers are a fixed size.
+*/
+ChunkShape getCopyChunkShape(
+    const LayerDescriptor& descriptor,
+    const GridWindow& window,
+    const CopyOptions& options)
+{
+    ChunkShape shape;
+    if (options.rechunk)
+        shape = options.chunkShape;
+    else
+        std::tie(shape.rows, shape.columns) = descriptor.getChunkDims();
+
+    if (shape.layout != ChunkLayout::Tiled || shape.rows == 0)
+        return shape;
+
+    if (shape.columns == 0)
+        shape.columns = shape.rows;
+
+    shape.rows = std::min<uint64_t>(shape.rows, window.rows());
+    shape.columns = std::min<uint64_t>(shape.columns, window.columns());
+
+    return shape;
+}
+
+//! Pick the compression of a copied layer.
+/*!
+\param descriptor
+    The descriptor of the layer being copied.
+\param options
+    The options of the copy.
+
+\return
+    The new compression if recompressing, otherwise that of the layer.
+*/
+const CompressionSpec& getCopyCompression(
+    const LayerDescriptor& descriptor,
+    const CopyOptions& options)
+{
+    return options.recompress ? options.compression :
+        descriptor.getCompressionSpec();
+}
+
+//! Compute the position of a supergrid cell along a Morton (Z order) curve.
+/*!
+\param row
+    The row of the cell.
+\param column
+    The column of the cell.
+
+\return
+    The position; the bits of the row and column interleaved.
+*/
+uint64_t getMortonKey(
+    uint32_t row,
+    uint32_t column) noexcept
+{
+    const auto spread = [](uint64_t value) {
+        value = (value | (value << 16)) & 0x0000ffff0000ffffull;
+        value = (value | (value << 8)) & 0x00ff00ff00ff00ffull;
+        value = (value | (value << 4)) & 0x0f0f0f0f0f0f0f0full;
+        value = (value | (value << 2)) & 0x3333333333333333ull;
+        value = (value | (value << 1)) & 0x5555555555555555ull;
+        return value;
+    };
+
+    return spread(column) | (spread(row) << 1);
+}
+
+//! Compute the position of a supergrid cell along a Hilbert curve.
+/*!
+\param row
+    The row of the cell.
+\param column
+    The column of the cell.
+\param order
+    The curve covers 2^order by 2^order cells; at least 1.
+
+\return
+    The position.
+*/
+uint64_t getHilbertKey(
+    uint32_t row,
+    uint32_t column,
+    uint32_t order) noexcept
+{
+    const auto size = uint64_t{1} << order;
+
+    uint64_t x = column;
+    uint64_t y = row;
+    uint64_t key = 0;
+
+    for (auto quadrant=size/2; quadrant>0; quadrant/=2)
+    {
+        const uint64_t rx = (x & quadrant) != 0 ? 1 : 0;
+        const uint64_t ry = (y & quadrant) != 0 ? 1 : 0;
+        key += quadrant * quadrant * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant, so the curve inside it starts and ends next
+        // to its neighbours.
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = size - 1 - x;
+                y = size - 1 - y;
+            }
+
+            std::swap(x, y);
+        }
+    }
+
+    return key;
+}
+
+}  // namespace
+
+//! Copies a BAG, layer by layer, a band of nodes at a time.
+class DatasetCopier final
+{
+public:
+    DatasetCopier(const Dataset& source, const GridWindow& window,
+        const CopyOptions& options) noexcept;
+
+    std::shared_ptr<Dataset> copy(const std::string& fileName);
+
+private:
+    void copyGrid(const Layer& source, Layer& destination,
+        const GridWindow& window, const ProgressScope& progress) const;
+    void copyGeorefMetadataLayers();
+    void copyLegacyGroup(const InterleavedLegacyLayer& source);
+    template <typename Record, size_t N>
+    void copyLegacyRecords(const InterleavedLegacyLayer& source,
+        GroupType groupType, const std::array<LayerType, N>& types);
+    void copySimpleLayers();
+    void copySurfaceCorrections();
+    void copyTrackingLists();
+    void copyVR();
+    void copyVRAlongCurve();
+    void copyVRItems(const std::vector<RefinementRun>& runs,
+        VRRefinements::AppendWriter& refinementsWriter, uint32_t& next);
+    void finish();
+    ProgressScope nextStep(uint64_t count = 1) noexcept;
+
+    //! The BAG being copied.
+    const Dataset& m_source;
+    //! The window of the grid being copied.
+    GridWindow m_window;
+    //! The options of the copy.
+    const CopyOptions& m_options;
+    //! The copy.
+    std::shared_ptr<Dataset> m_pDestination;
+    //! The georeferenced metadata layers with keys for the refinements, as
+    //! (source, copy) pairs.
+    std::vector<std::pair<const GeorefMetadataLayer*, GeorefMetadataLayer*>>
+        m_vrKeyLayers;
+    //! The number of layers to copy, for the progress of the copy.
+    uint64_t m_numSteps = 0;
+    //! The number of layers copied, or being copied.
+    uint64_t m_step = 0;
+};
+
+//! Constructor.
+/*!
+\param source
+    The BAG to copy.
+\param window
+    The window of the grid to copy.
+\param options
+    The options of the copy.
+*/
+DatasetCopier::DatasetCopier(
+    const Dataset& source,
+    const GridWindow& window,
+    const CopyOptions& options) noexcept
+    : m_source(source)
+    , m_window(window)
+    , m_options(options)
+{
+}
+
+//! Copy the BAG.
+/*!
+\param fileName
+    The name of the copy.
+
+\return
+    The copy, open read/write.
+*/
+std::shared_ptr<Dataset> DatasetCopier::copy(
+    const std::string& fileName)
+{
+    // The elevation and uncertainty layers are made with the BAG.
+    const auto pElevation = m_source.getSimpleLayer(Elevation);
+    if (!pElevation)
+        throw LayerNotFound{};
+
+    const auto& elevationDescriptor = *pElevation->getDescriptor();
+
+    m_pDestination = Dataset::create(fileName,
+        makeCopyMetadata(m_source, m_window),
+        getCopyChunkShape(elevationDescriptor, m_window, m_options),
+        getCopyCompression(elevationDescriptor, m_options),
+        m_options.profile);
+
+    // The attributes of each layer are written once it is copied.
+    m_pDestination->setDeferAttributeWrites(true);
+
+    // The VR layers are made first, so the georeferenced metadata layers
+    // get keys for the refinements.
+    const auto pVRRefinements = m_source.getVRRefinements();
+    if (pVRRefinements)
+    {
+        ++m_numSteps;
+
+        const auto& descriptor = *pVRRefinements->getDescriptor();
+        const auto chunkSize = (m_options.rechunk &&
+            m_options.chunkShape.rows > 0) ? m_options.chunkShape.rows :
+            descriptor.getChunkSize();
+
+        m_pDestination->createVR(chunkSize,
+            getCopyCompression(descriptor, m_options),
+            static_cast<bool>(m_source.getVRNode()));
+    }
+
+    for (const auto& pLayer : m_source.getLayers())
+    {
+        const auto type = pLayer->getDescriptor()->getLayerType();
+        if (type != VarRes_Metadata && type != VarRes_Refinement &&
+            type != VarRes_Node)
+            ++m_numSteps;
+    }
+
+    try
+    {
+        this->copySimpleLayers();
+        this->copyGeorefMetadataLayers();
+        this->copySurfaceCorrections();
+
+        if (pVRRefinements)
+            this->copyVR();
+
+        this->copyTrackingLists();
+    }
+    catch (const OperationCancelled&)
+    {
+        // Keep what was copied; the layers not reached are missing, and
+        // the last one may be copied in part.
+        this->finish();
+        throw;
+    }
+
+    this->finish();
+
+    ProgressScope{m_options.progress}.report(1, 1);
+
+    return m_pDestination;
+}
+
+//! Write what is pending, so the copy is complete and valid.
+void DatasetCopier::finish()
+{
+    // Writing the 1D layers resizes the BAG to their length.
+    m_pDestination->getDescriptor().setDims(m_window.rows(),
+        m_window.columns());
+
+    m_pDestination->flush();
+    m_pDestination->setDeferAttributeWrites(false);
+}
+
+//! Retrieve the part of the progress of the copy of the next layers.
+/*!
+\param count
+    The number of layers.
+
+
+eturn
+    The part of the progress.
+*/
+ProgressScope DatasetCopier::nextStep(
+    uint64_t count) noexcept
+{
+    const auto progress = ProgressScope{m_options.progress}.part(m_step,
+        m_step + count, m_numSteps);
+
+    m_step += count;
+
+    return progress;
+}
+
+//! Copy a window of a layer, a band of rows at a time.
+/*!
+    The bands are whole chunk rows of the copy where they fit, so each chunk
+    is compressed once and, for simple layers, on several threads.
+
+\param source
+    The layer to copy.
+\param destination
+    The layer to copy to, at row 0 and column 0.
+\param window
+    The window of the source to copy.
+\param progress
+    Reports the progress of the copy of the layer; checked after each band.
+*/
+void DatasetCopier::copyGrid(
+    const Layer& source,
+    Layer& destination,
+    const GridWindow& window,
+    const ProgressScope& progress) const
+{
+    const size_t elementSize = source.getDescriptor()->getElementSize();
+    const auto columns = window.columns();
+    const auto rowBytes = columns * elementSize;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) =
+        destination.getDescriptor()->getChunkDims();
+
+    auto bandRows = static_cast<uint32_t>(std::min<size_t>(window.rows(),
+        std::max<size_t>(1, kCopyBandCells / columns)));
+    if (chunkRows > 0 && bandRows > chunkRows)
+        bandRows -= static_cast<uint32_t>(bandRows % chunkRows);
+
+    std::vector<uint8_t> band(bandRows * rowBytes);
+
+    for (uint32_t row=0; row<window.rows(); row+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, window.rows() - row);
+
+        // Layers other than the grid, such as surface corrections, may be
+        // larger than the BAG, so the bounds of Layer::readInto() are skipped.
+        source.readIntoProxy(window.rowStart + row, window.columnStart,
+            window.rowStart + row + numRows - 1, window.columnEnd, band.data(),
+            rowBytes);
+        destination.write(row, 0, row + numRows - 1, columns - 1, band.data());
+
+        progress.report(row + numRows, window.rows());
+    }
+}
+
+//! Copy the georeferenced metadata layers, and their value tables.
+void DatasetCopier::copyGeorefMetadataLayers()
+{
+    for (const auto& pLayer : m_source.getLayers())
+    {
+        const auto* pSource =
+            dynamic_cast<const GeorefMetadataLayer*>(pLayer.get());
+        if (!pSource)
+            continue;
+
+        const auto pDescriptor = pSource->getDescriptor();
+
+        auto& destination = m_pDestination->createGeorefMetadataLayer(
+            pDescriptor->getDataType(), pDescriptor->getProfile(),
+            pDescriptor->getName(), pDescriptor->getDefinition(),
+            getCopyChunkShape(*pDescriptor, m_window, m_options),
+            getCopyCompression(*pDescriptor, m_options));
+
+        // The no data value record is made with the layer.
+        const auto& records = pSource->getValueTable().getRecords();
+        if (records.size() > 1)
+            destination.getValueTable().addRecords(
+                Records(records.begin() + 1, records.end()));
+
+        this->copyGrid(*pSource, destination, m_window, this->nextStep());
+
+        if (pSource->hasVRKeys() && destination.hasVRKeys())
+            m_vrKeyLayers.emplace_back(pSource, &destination);
+    }
+}
+
+//! Copy an interleaved group of an old BAG to a simple layer per field.
+/*!
+\param source
+    Any interleaved layer of the group.
+*/
+void DatasetCopier::copyLegacyGroup(
+    const InterleavedLegacyLayer& source)
+{
+    const auto pDescriptor =
+        std::dynamic_pointer_cast<const InterleavedLegacyLayerDescriptor>(
+            source.getDescriptor());
+    if (!pDescriptor)
+        throw InvalidDescriptor{};
+
+    if (pDescriptor->getGroupType() == NODE)
+        this->copyLegacyRecords<BagOptNodeGroup, 2>(source, NODE,
+            {{Hypothesis_Strength, Num_Hypotheses}});
+    else
+        this->copyLegacyRecords<BagOptElevationSolutionGroup, 3>(source,
+            ELEVATION, {{Shoal_Elevation, Std_Dev, Num_Soundings}});
+}
+
+//! Copy the records of an interleaved group, a band of rows at a time.
+/*!
+    Each band of records is read once, and split into a band of each field,
+    which is written to the simple layer of the field; the writes find the
+    min/max of the layers as they go.  The simple layers take the chunks and
+    compression of the elevation layer, as those of the group were picked for
+    records rather than single values.
+
+\param source
+    Any interleaved layer of the group.
+\param groupType
+    The type of group.
+\param types
+    The simple layers of the fields, in the order splitRecords() fills them.
+*/
+template <typename Record, size_t N>
+void DatasetCopier::copyLegacyRecords(
+    const InterleavedLegacyLayer& source,
+    GroupType groupType,
+    const std::array<LayerType, N>& types)
+{
+    const auto& elevationDescriptor =
+        *m_source.getSimpleLayer(Elevation)->getDescriptor();
+    const auto chunkShape = getCopyChunkShape(elevationDescriptor, m_window,
+        m_options);
+    const auto& compression = getCopyCompression(elevationDescriptor,
+        m_options);
+    const auto progress = this->nextStep(N);
+
+    std::array<Layer*, N> destinations{};
+    for (size_t field=0; field<N; ++field)
+        destinations[field] = &m_pDestination->createSimpleLayer(types[field],
+            chunkShape, compression);
+
+    // Every field is 4 bytes.
+    constexpr size_t kFieldSize = 4;
+    const auto columns = m_window.columns();
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) =
+        destinations[0]->getDescriptor()->getChunkDims();
+
+    auto bandRows = static_cast<uint32_t>(std::min<size_t>(m_window.rows(),
+        std::max<size_t>(1, kCopyBandCells / columns)));
+    if (chunkRows > 0 && bandRows > chunkRows)
+        bandRows -= static_cast<uint32_t>(bandRows % chunkRows);
+
+    std::array<std::vector<uint8_t>, N> bands;
+    for (auto& band : bands)
+        band.resize(static_cast<size_t>(bandRows) * columns * kFieldSize);
+
+    for (uint32_t row=0; row<m_window.rows(); row+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, m_window.rows() - row);
+
+        source.readRecords(groupType, sizeof(Record), m_window.rowStart + row,
+            m_window.columnStart, m_window.rowStart + row + numRows - 1,
+            m_window.columnEnd,
+            [&](uint32_t first, uint32_t rows, const uint8_t* records) {
+                const auto offset = static_cast<size_t>(first) * columns *
+                    kFieldSize;
+
+                std::array<uint8_t*, N> fields{};
+                for (size_t field=0; field<N; ++field)
+                    fields[field] = bands[field].data() + offset;
+
+                splitRecords(reinterpret_cast<const Record*>(records),
+                    static_cast<size_t>(rows) * columns, fields);
+            });
+
+        for (size_t field=0; field<N; ++field)
+            destinations[field]->write(row, 0, row + numRows - 1, columns - 1,
+                bands[field].data());
+
+        progress.report(row + numRows, m_window.rows());
+    }
+}
+
+//! Copy the simple layers, including interleaved layers of old BAGs.
+/*!
+    The fields of an interleaved group are copied together, from one read of
+    its records, as simple layers.
+*/
+void DatasetCopier::copySimpleLayers()
+{
+    bool copiedNode = false;
+    bool copiedElevationSolution = false;
+
+    for (const auto& pLayer : m_source.getLayers())
+    {
+        const auto pDescriptor = pLayer->getDescriptor();
+        const auto type = pDescriptor->getLayerType();
+
+        if (type == Georef_Metadata || type == Surface_Correction ||
+            type == VarRes_Metadata || type == VarRes_Refinement ||
+            type == VarRes_Node)
+            continue;
+
+        const auto* pLegacy =
+            dynamic_cast<const InterleavedLegacyLayer*>(pLayer.get());
+        if (pLegacy)
+        {
+            const bool isNode = type == Hypothesis_Strength ||
+                type == Num_Hypotheses;
+            auto& copied = isNode ? copiedNode : copiedElevationSolution;
+
+            if (!copied)
+                this->copyLegacyGroup(*pLegacy);
+
+            copied = true;
+            continue;
+        }
+
+        if (type == Elevation || type == Uncertainty)
+            this->copyGrid(*pLayer, *m_pDestination->getSimpleLayer(type),
+                m_window, this->nextStep());
+        else
+            this->copyGrid(*pLayer, m_pDestination->createSimpleLayer(type,
+                getCopyChunkShape(*pDescriptor, m_window, m_options),
+                getCopyCompression(*pDescriptor, m_options)), m_window,
+                this->nextStep());
+    }
+}
+
+//! Copy the surface corrections.
+/*!
+    The correctors are placed by their own origin and spacing, or
+    positions, so they are copied whole.
+*/
+void DatasetCopier::copySurfaceCorrections()
+{
+    const auto pSource = m_source.getSurfaceCorrections();
+    if (!pSource)
+        return;
+
+    const auto progress = this->nextStep();
+
+    const auto pSourceDescriptor = pSource->getDescriptor();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pSourceDescriptor->getDims();
+
+    GridWindow window;
+    window.rowEnd = std::max(numRows, 1u) - 1;
+    window.columnEnd = std::max(numColumns, 1u) - 1;
+
+    auto& destination = m_pDestination->createSurfaceCorrections(
+        pSourceDescriptor->getSurfaceType(),
+        pSourceDescriptor->getNumCorrectors(),
+        getCopyChunkShape(*pSourceDescriptor, window, m_options),
+        getCopyCompression(*pSourceDescriptor, m_options));
+
+    double swX = 0., swY = 0.;
+    std::tie(swX, swY) = pSourceDescriptor->getOrigin();
+    double xSpacing = 0., ySpacing = 0.;
+    std::tie(xSpacing, ySpacing) = pSourceDescriptor->getSpacing();
+
+    destination.getDescriptor()->setDims(numRows, numColumns)
+        .setOrigin(swX, swY)
+        .setSpacing(xSpacing, ySpacing)
+        .setVerticalDatums(pSourceDescriptor->getVerticalDatums());
+
+    if (numRows == 0 || numColumns == 0)
+        return;
+
+    this->copyGrid(*pSource, destination, window, progress);
+}
+
+//! Copy the tracking lists, keeping the items of nodes in the window.
+void DatasetCopier::copyTrackingLists()
+{
+    auto& trackingList = m_pDestination->getTrackingList();
+    for (auto item : m_source.getTrackingList())
+    {
+        if (!m_window.contains(item.row, item.col))
+            continue;
+
+        item.row -= m_window.rowStart;
+        item.col -= m_window.columnStart;
+        trackingList.push_back(item);
+    }
+
+    if (!trackingList.empty())
+        trackingList.write();
+
+    const auto pSourceVR = m_source.getVRTrackingList();
+    const auto pDestinationVR = m_pDestination->getVRTrackingList();
+    if (!pSourceVR || !pDestinationVR)
+        return;
+
+    for (auto item : *pSourceVR)
+    {
+        if (!m_window.contains(item.row, item.col))
+            continue;
+
+        item.row -= m_window.rowStart;
+        item.col -= m_window.columnStart;
+        pDestinationVR->push_back(item);
+    }
+
+    if (!pDestinationVR->empty())
+        pDestinationVR->write();
+}
+
+//! Copy the variable resolution metadata of the window, and its refinements.
+/*!
+    The refinements of the supergrid cells in the window are packed in
+    order, so the indices of the cells are renumbered.
+*/
+void DatasetCopier::copyVR()
+{
+    if (m_options.refinementOrder != VRRefinementOrder::RowMajor)
+    {
+        this->copyVRAlongCurve();
+        return;
+    }
+
+    const auto pSource = m_source.getVRMetadata();
+    const auto pDestination = m_pDestination->getVRMetadata();
+    const auto pRefinements = m_pDestination->getVRRefinements();
+    if (!pSource || !pDestination || !pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto columns = m_window.columns();
+    const auto bandRows = static_cast<uint32_t>(std::min<size_t>(
+        m_window.rows(), std::max<size_t>(1, kCopyBandCells / columns)));
+
+    std::vector<VRMetadataItem> band(static_cast<size_t>(bandRows) * columns);
+    std::vector<RefinementRun> runs;
+
+    const auto refinementsWriter = pRefinements->appendWriter();
+    uint32_t next = 0;
+    const auto progress = this->nextStep();
+
+    for (uint32_t row=0; row<m_window.rows(); row+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, m_window.rows() - row);
+        const auto numItems = static_cast<size_t>(numRows) * columns;
+
+        static_cast<const Layer&>(*pSource).readIntoProxy(
+            m_window.rowStart + row, m_window.columnStart,
+            m_window.rowStart + row + numRows - 1, m_window.columnEnd,
+            reinterpret_cast<uint8_t*>(band.data()),
+            columns * sizeof(VRMetadataItem));
+
+        // Find the refinements of the cells, merging neighbours.
+        runs.clear();
+        auto index = next;
+
+        for (size_t i=0; i<numItems; ++i)
+        {
+            auto& item = band[i];
+            const auto count =
+                static_cast<uint64_t>(item.dimensions_x) * item.dimensions_y;
+            if (count == 0)
+                continue;
+
+            if (!runs.empty() && runs.back().first + runs.back().count ==
+                item.index)
+                runs.back().count += count;
+            else
+                runs.push_back({item.index, count});
+
+            item.index = index;
+            index += static_cast<uint32_t>(count);
+        }
+
+        this->copyVRItems(runs, *refinementsWriter, next);
+
+        pDestination->write(row, 0, row + numRows - 1, columns - 1,
+            reinterpret_cast<const uint8_t*>(band.data()));
+
+        // The writer appends the refinements of the bands copied when it is
+        // destroyed, if cancelled.
+        progress.report(row + numRows, m_window.rows());
+    }
+
+    refinementsWriter->close();
+}
+
+//! Copy the variable resolution metadata of the window, and its refinements
+//! in the order of a space filling curve through the supergrid cells.
+/*!
+    The refinements are packed in the order of their supergrid cells along
+    the curve of options.refinementOrder, so the cells of a window of the
+    supergrid have their refinements in a few runs, and the indices of the
+    cells are renumbered.  Refinements no cell of the window uses are
+    dropped.
+
+    The metadata is read twice: to order the refined cells, then to write it
+    renumbered.  Only the refined cells are held in between.
+*/
+void DatasetCopier::copyVRAlongCurve()
+{
+    const auto pSource = m_source.getVRMetadata();
+    const auto pDestination = m_pDestination->getVRMetadata();
+    const auto pRefinements = m_pDestination->getVRRefinements();
+    if (!pSource || !pDestination || !pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto rows = m_window.rows();
+    const auto columns = m_window.columns();
+    const auto bandRows = static_cast<uint32_t>(std::min<size_t>(rows,
+        std::max<size_t>(1, kCopyBandCells / columns)));
+
+    uint32_t order = 1;
+    while ((uint64_t{1} << order) < std::max(rows, columns))
+        ++order;
+
+    //! A supergrid cell with refinements.
+    struct RefinedCell final
+    {
+        //! The position of the cell along the curve.
+        uint64_t key = 0;
+        //! The index of the first refinement of the cell in the source.
+        uint32_t first = 0;
+        //! The number of refinements of the cell.
+        uint32_t count = 0;
+        //! The cell is the ordinal'th refined cell of the window, row by row.
+        uint32_t ordinal = 0;
+    };
+
+    std::vector<VRMetadataItem> band(static_cast<size_t>(bandRows) * columns);
+    std::vector<RefinedCell> cells;
+
+    const auto progress = this->nextStep();
+    const auto copyProgress = progress.part(0, 3, 4);
+    const auto metadataProgress = progress.part(3, 4, 4);
+
+    const auto readBand = [&](uint32_t row, uint32_t numRows) {
+        static_cast<const Layer&>(*pSource).readIntoProxy(
+            m_window.rowStart + row, m_window.columnStart,
+            m_window.rowStart + row + numRows - 1, m_window.columnEnd,
+            reinterpret_cast<uint8_t*>(band.data()),
+            columns * sizeof(VRMetadataItem));
+    };
+
+    // Find the refined cells, and their positions along the curve.
+    for (uint32_t row=0; row<rows; row+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, rows - row);
+        readBand(row, numRows);
+
+        for (uint32_t i=0; i<numRows * columns; ++i)
+        {
+            const auto& item = band[i];
+            const auto count = item.dimensions_x * item.dimensions_y;
+            if (count == 0)
+                continue;
+
+            const auto cellRow = row + i / columns;
+            const auto cellColumn = i % columns;
+
+            RefinedCell cell;
+            cell.key = m_options.refinementOrder == VRRefinementOrder::Morton ?
+                getMortonKey(cellRow, cellColumn) :
+                getHilbertKey(cellRow, cellColumn, order);
+            cell.first = item.index;
+            cell.count = count;
+            cell.ordinal = static_cast<uint32_t>(cells.size());
+            cells.push_back(cell);
+        }
+
+        copyProgress.check();
+    }
+
+    std::sort(cells.begin(), cells.end(),
+        [](const RefinedCell& lhs, const RefinedCell& rhs) {
+            return lhs.key < rhs.key;
+        });
+
+    uint64_t numRefinements = 0;
+    for (const auto& cell : cells)
+        numRefinements += cell.count;
+
+    // Copy the refinements along the curve, a block of runs at a time,
+    // merging neighbours.
+    std::vector<uint32_t> indices(cells.size());
+    std::vector<RefinementRun> runs;
+
+    {
+        const auto refinementsWriter = pRefinements->appendWriter();
+        uint32_t next = 0;
+        uint64_t numBuffered = 0;
+
+        for (size_t i=0; i<cells.size(); ++i)
+        {
+            const auto& cell = cells[i];
+            indices[cell.ordinal] = static_cast<uint32_t>(next + numBuffered);
+
+            if (!runs.empty() && runs.back().first + runs.back().count ==
+                cell.first)
+                runs.back().count += cell.count;
+            else
+                runs.push_back({cell.first, cell.count});
+
+            numBuffered += cell.count;
+            if (numBuffered < kCopyBlockItems && i + 1 < cells.size())
+                continue;
+
+            this->copyVRItems(runs, *refinementsWriter, next);
+            runs.clear();
+            numBuffered = 0;
+
+            // The writer appends the refinements copied when it is
+            // destroyed, if cancelled.
+            copyProgress.report(next, numRefinements);
+        }
+
+        refinementsWriter->close();
+    }
+
+    // Write the metadata, renumbered.
+    uint32_t ordinal = 0;
+
+    for (uint32_t row=0; row<rows; row+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, rows - row);
+        readBand(row, numRows);
+
+        for (uint32_t i=0; i<numRows * columns; ++i)
+        {
+            auto& item = band[i];
+            if (item.dimensions_x != 0 && item.dimensions_y != 0)
+                item.index = indices[ordinal++];
+        }
+
+        pDestination->write(row, 0, row + numRows - 1, columns - 1,
+            reinterpret_cast<const uint8_t*>(band.data()));
+
+        metadataProgress.report(row + numRows, rows);
+    }
+}
+
+//! Copy runs of refinements, with their nodes and georeferenced metadata
+//! keys.
+/*!
+\param runs
+    The runs of refinements of the source.
+\param refinementsWriter
+    Appends the refinements to the copy.
+\param next
+    The index of the next refinement of the copy; advanced past the runs.
+*/
+void DatasetCopier::copyVRItems(
+    const std::vector<RefinementRun>& runs,
+    VRRefinements::AppendWriter& refinementsWriter,
+    uint32_t& next)
+{
+    const auto pSourceRefinements = m_source.getVRRefinements();
+    const auto pSourceNode = m_source.getVRNode();
+    const auto pDestinationNode = m_pDestination->getVRNode();
+
+    std::vector<VRRefinementsItem> refinements;
+    std::vector<VRNodeItem> nodes;
+    std::vector<uint8_t> keys;
+
+    for (const auto& run : runs)
+    {
+        for (uint64_t offset=0; offset<run.count; offset+=kCopyBlockItems)
+        {
+            const auto count = static_cast<uint32_t>(
+                std::min<uint64_t>(kCopyBlockItems, run.count - offset));
+            const auto first = static_cast<uint32_t>(run.first + offset);
+            const auto last = first + count - 1;
+
+            refinements.resize(count);
+            pSourceRefinements->readInto(0, first, 0, last,
+                reinterpret_cast<uint8_t*>(refinements.data()),
+                count * sizeof(VRRefinementsItem));
+            refinementsWriter.append(refinements.data(), count);
+
+            if (pSourceNode && pDestinationNode)
+            {
+                nodes.resize(count);
+                pSourceNode->readInto(0, first, 0, last,
+                    reinterpret_cast<uint8_t*>(nodes.data()),
+                    count * sizeof(VRNodeItem));
+                pDestinationNode->write(0, next, 0, next + count - 1,
+                    reinterpret_cast<const uint8_t*>(nodes.data()));
+            }
+
+            for (const auto& layers : m_vrKeyLayers)
+            {
+                const size_t keySize =
+                    layers.first->getDescriptor()->getElementSize();
+
+                keys.resize(count * keySize);
+                layers.first->readVRInto(first, last, keys.data(),
+                    keys.size());
+                layers.second->writeVR(next, next + count - 1, keys.data());
+            }
+
+            next += count;
+        }
+    }
+}
+
+//! Copy a BAG, optionally rechunking, recompressing or clipping it.
+/*!
+    Every layer is streamed a band of nodes at a time, so memory use is
+    bounded whatever the size of the BAG: the simple layers, georeferenced
+    metadata layers (with their value tables), surface corrections, the
+    variable resolution layers and the tracking lists.  The refinements of
+    the supergrid cells in a window are packed, in the order of
+    options.refinementOrder, and the items of tracking lists outside it
+    dropped.  Surface corrections are copied whole, as
+    they are placed by their own coordinates.
+
+    HDF5 runs one call at a time, so the layers are copied one after the
+    other; the bands are whole chunks of the copy where they fit, which
+    lets chunks be compressed and decompressed on several threads.
+    Nothing else may use the source while it is copied.
+
+    If options.progress is cancelled, the copy stops after the band being
+    copied, and what was copied is written before OperationCancelled is
+    thrown, so the copy is a valid BAG holding the layers reached.
+
+    The interleaved node and elevation solution groups of a pre 2.0 BAG are
+    converted to simple layers, each group read once for all its fields.
+
+\param source
+    The BAG to copy.
+\param fileName
+    The name of the copy.
+\param options
+    How the BAG is copied; by default, it is copied whole with the chunks
+    and compression of each layer.
+
+\return
+    The copy, open read/write.
+*/
+std::shared_ptr<Dataset> copyDataset(
+    const Dataset& source,
+    const std::string& fileName,
+    const CopyOptions& options)
+{
+    return DatasetCopier{source, getCopyWindow(source, options), options}
+        .copy(fileName);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,20 @@
+#ifndef BAG_COPY_H
+#define BAG_COPY_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <memory>
+#include <string>
+
+
+namespace BAG {
+
+BAG_API std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+    const std::string& fileName, const CopyOptions& options = {});
+
+}  // namespace BAG
+
+#endif  // BAG_COPY_H
+
@@ -0,0 +1,142 @@
+
+#include "bag_correctionplan.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace BAG {
+
+//! Find the corrector nodes along one axis that neighbour a position.
+/*!
+    The two nearest corrector nodes are used.  If the position is on a
+    corrector node, the nodes either side of it are used as well.
+
+\param position
+    The position of the BAG row or column.
+\param origin
+    The position of the first corrector row or column.
+\param spacing
+    The distance between corrector rows or columns.
+\param numNodes
+    The number of corrector rows or columns.
+\param scale
+    Scales the distance to each neighbour before squaring it.
+
+\return
+    The neighbouring corrector rows or columns.
+*/
+CorrectionPlan::Neighbours CorrectionPlan::findNeighbours(
+    double position,
+    double origin,
+    double spacing,
+    uint32_t numNodes,
+    double scale) noexcept
+{
+    using std::floor;  using std::fabs;  using std::ceil;
+
+    auto first = static_cast<uint32_t>(fabs(floor((origin - position) / spacing)));
+    auto last = static_cast<uint32_t>(fabs(ceil((origin - position) / spacing)));
+
+    // Enforce dataset limits.
+    if (first > last)
+        std::swap(first, last);
+
+    first = std::min(first, numNodes - 1);
+    last = std::min(last, numNodes - 1);
+
+    if (first == last)
+    {
+        if (first > 0)
+            --first;
+
+        if ((last + 1) < numNodes)
+            ++last;
+    }
+
+    Neighbours neighbours;
+    neighbours.first = first;
+    neighbours.count = last - first + 1;
+
+    for (uint32_t i=0; i<neighbours.count; ++i)
+    {
+        const auto distance = scale * fabs(position - (origin + (first + i) * spacing));
+        neighbours.distSq[i] = distance * distance;
+    }
+
+    return neighbours;
+}
+
+//! Retrieve the first row the plan covers.
+/*!
+\return
+    The first row the plan covers.
+*/
+uint32_t CorrectionPlan::getRowStart() const noexcept
+{
+    return m_rowStart;
+}
+
+//! Retrieve the first column the plan covers.
+/*!
+\return
+    The first column the plan covers.
+*/
+uint32_t CorrectionPlan::getColumnStart() const noexcept
+{
+    return m_columnStart;
+}
+
+//! Retrieve the last row the plan covers.
+/*!
+\return
+    The last row the plan covers (inclusive).
+    Meaningless if the plan is empty.
+*/
+uint32_t CorrectionPlan::getRowEnd() const noexcept
+{
+    return m_rowStart + static_cast<uint32_t>(m_rows.size()) - 1;
+}
+
+//! Retrieve the last column the plan covers.
+/*!
+\return
+    The last column the plan covers (inclusive).
+    Meaningless if the plan is empty.
+*/
+uint32_t CorrectionPlan::getColumnEnd() const noexcept
+{
+    return m_columnStart + static_cast<uint32_t>(m_columns.size()) - 1;
+}
+
+//! Determine if the plan covers an area.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    \e true if every node in the area is covered by the plan.
+    \e false otherwise.
+*/
+bool CorrectionPlan::contains(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const noexcept
+{
+    if (m_rows.empty() || m_columns.empty())
+        return false;
+
+    return rowStart >= m_rowStart && rowEnd <= this->getRowEnd() &&
+        columnStart >= m_columnStart && columnEnd <= this->getColumnEnd() &&
+        rowStart <= rowEnd && columnStart <= columnEnd;
+}
+
+}  // namespace BAG
+
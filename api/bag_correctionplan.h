@@ -0,0 +1,81 @@
+#ifndef BAG_CORRECTIONPLAN_H
+#define BAG_CORRECTIONPLAN_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! The neighbouring corrector nodes of an area of a BAG.
+/*!
+    The corrector nodes used to correct a node of a gridded surface depend
+    only on the position of the node, not on the corrector or the value being
+    corrected.  A plan records, for each row and each column of an area, which
+    corrector rows and columns neighbour it and how far away they are, so
+    applying any number of correctors to the area does not repeat that work.
+
+    Create a plan with SurfaceCorrections::createCorrectionPlan().  The plan
+    is only valid while the corrector origin, spacing and dimensions, and the
+    BAG grid, are unchanged.
+*/
+class BAG_API CorrectionPlan final
+{
+public:
+    CorrectionPlan() = default;
+
+    uint32_t getRowStart() const noexcept;
+    uint32_t getColumnStart() const noexcept;
+    uint32_t getRowEnd() const noexcept;
+    uint32_t getColumnEnd() const noexcept;
+
+    bool contains(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const noexcept;
+
+private:
+    //! The most corrector nodes along one axis that influence a node.
+    static constexpr uint32_t kMaxNeighbours = 3;
+
+    //! The corrector nodes along one axis that influence a row or column.
+    struct Neighbours final
+    {
+        //! The first neighbouring corrector row or column.
+        uint32_t first = 0;
+        //! The number of neighbouring corrector rows or columns.
+        uint32_t count = 0;
+        //! The squared (scaled) distance to each neighbour.
+        std::array<double, kMaxNeighbours> distSq{};
+    };
+
+    static Neighbours findNeighbours(double position, double origin,
+        double spacing, uint32_t numNodes, double scale) noexcept;
+
+    //! The first row of the area.
+    uint32_t m_rowStart = 0;
+    //! The first column of the area.
+    uint32_t m_columnStart = 0;
+    //! The neighbours of each row of the area.
+    std::vector<Neighbours> m_rows;
+    //! The neighbours of each column of the area.
+    std::vector<Neighbours> m_columns;
+
+    friend SurfaceCorrections;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_CORRECTIONPLAN_H
+
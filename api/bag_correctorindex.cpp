@@ -0,0 +1,268 @@
+
+#include "bag_correctorindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace BAG {
+
+//! Constructor.
+/*!
+\param nodes
+    The corrector nodes.  They must outlive the index.
+\param numNodes
+    The number of corrector nodes.
+*/
+CorrectorIndex::CorrectorIndex(
+    const VerticalDatumCorrections* nodes,
+    size_t numNodes)
+    : m_nodes(nodes)
+    , m_numNodes(numNodes)
+{
+    if (numNodes == 0)
+    {
+        m_bucketStarts.assign(2, 0);
+        return;
+    }
+
+    double maxX = nodes[0].x, maxY = nodes[0].y;
+    m_minX = nodes[0].x;
+    m_minY = nodes[0].y;
+
+    for (size_t i=1; i<numNodes; ++i)
+    {
+        m_minX = std::min(m_minX, nodes[i].x);
+        m_minY = std::min(m_minY, nodes[i].y);
+        maxX = std::max(maxX, nodes[i].x);
+        maxY = std::max(maxY, nodes[i].y);
+    }
+
+    // Aim for about one node per bucket, keeping the buckets square.
+    const auto width = maxX - m_minX;
+    const auto height = maxY - m_minY;
+    const auto n = static_cast<double>(numNodes);
+
+    if (width > 0. && height > 0.)
+    {
+        m_numBucketColumns = static_cast<uint32_t>(std::min(n,
+            std::max(1., std::ceil(std::sqrt(n * width / height)))));
+        m_numBucketRows = static_cast<uint32_t>(std::min(n,
+            std::max(1., std::ceil(n / m_numBucketColumns))));
+    }
+    else if (width > 0.)
+        m_numBucketColumns = static_cast<uint32_t>(numNodes);
+    else if (height > 0.)
+        m_numBucketRows = static_cast<uint32_t>(numNodes);
+
+    if (width > 0.)
+        m_bucketWidth = width / m_numBucketColumns;
+    if (height > 0.)
+        m_bucketHeight = height / m_numBucketRows;
+
+    // Group the node indices by bucket (a counting sort).
+    const size_t numBuckets =
+        static_cast<size_t>(m_numBucketColumns) * m_numBucketRows;
+    m_bucketStarts.assign(numBuckets + 1, 0);
+
+    std::vector<uint32_t> buckets(numNodes);
+    for (size_t i=0; i<numNodes; ++i)
+    {
+        buckets[i] = this->getBucketRow(nodes[i].y) * m_numBucketColumns +
+            this->getBucketColumn(nodes[i].x);
+        ++m_bucketStarts[buckets[i] + 1];
+    }
+
+    for (size_t bucket=0; bucket<numBuckets; ++bucket)
+        m_bucketStarts[bucket + 1] += m_bucketStarts[bucket];
+
+    m_nodeIndices.resize(numNodes);
+    std::vector<uint32_t> next{m_bucketStarts.begin(), m_bucketStarts.end() - 1};
+    for (size_t i=0; i<numNodes; ++i)
+        m_nodeIndices[next[buckets[i]]++] = static_cast<uint32_t>(i);
+}
+
+//! Find the bucket column holding an x position.
+/*!
+\param x
+    The x position.
+
+\return
+    The bucket column; positions outside the buckets use the nearest.
+*/
+uint32_t CorrectorIndex::getBucketColumn(
+    double x) const noexcept
+{
+    const auto column = std::floor((x - m_minX) / m_bucketWidth);
+
+    if (!(column > 0.))
+        return 0;
+
+    return static_cast<uint32_t>(std::min(column,
+        static_cast<double>(m_numBucketColumns - 1)));
+}
+
+//! Find the bucket row holding a y position.
+/*!
+\param y
+    The y position.
+
+\return
+    The bucket row; positions outside the buckets use the nearest.
+*/
+uint32_t CorrectorIndex::getBucketRow(
+    double y) const noexcept
+{
+    const auto row = std::floor((y - m_minY) / m_bucketHeight);
+
+    if (!(row > 0.))
+        return 0;
+
+    return static_cast<uint32_t>(std::min(row,
+        static_cast<double>(m_numBucketRows - 1)));
+}
+
+//! Find the nodes nearest to a position.
+/*!
+\param x
+    The x position.
+\param y
+    The y position.
+\param maxNeighbours
+    The most nodes to find.
+\param neighbours
+    Set to the nodes found, nearest first.
+    Must have room for maxNeighbours.
+
+\return
+    The number of nodes found; fewer than maxNeighbours only if the index
+    holds fewer nodes.
+*/
+uint32_t CorrectorIndex::findNearest(
+    double x,
+    double y,
+    uint32_t maxNeighbours,
+    Neighbour* neighbours) const noexcept
+{
+    if (m_numNodes == 0 || maxNeighbours == 0)
+        return 0;
+
+    uint32_t numFound = 0;
+
+    // Keep the neighbours sorted by distance.
+    const auto consider = [&](uint32_t index) {
+        const auto dx = x - m_nodes[index].x;
+        const auto dy = y - m_nodes[index].y;
+        const auto distSq = dx * dx + dy * dy;
+
+        if (numFound == maxNeighbours &&
+            distSq >= neighbours[numFound - 1].distSq)
+            return;
+
+        auto slot = (numFound < maxNeighbours) ? numFound++ : numFound - 1;
+        for (; slot > 0 && neighbours[slot - 1].distSq > distSq; --slot)
+            neighbours[slot] = neighbours[slot - 1];
+
+        neighbours[slot].index = index;
+        neighbours[slot].distSq = distSq;
+    };
+
+    const auto visit = [&](uint32_t row, uint32_t column) {
+        const auto bucket =
+            static_cast<size_t>(row) * m_numBucketColumns + column;
+
+        for (auto i=m_bucketStarts[bucket]; i<m_bucketStarts[bucket + 1]; ++i)
+            consider(m_nodeIndices[i]);
+    };
+
+    const auto centreColumn = static_cast<int64_t>(this->getBucketColumn(x));
+    const auto centreRow = static_cast<int64_t>(this->getBucketRow(y));
+    const int64_t numColumns = m_numBucketColumns;
+    const int64_t numRows = m_numBucketRows;
+
+    // Nodes in ring r + 1 are at least r buckets away along some axis that
+    // has more than one bucket.
+    constexpr auto kInfinity = std::numeric_limits<double>::infinity();
+    const auto ringSpacing = std::min(
+        numColumns > 1 ? m_bucketWidth : kInfinity,
+        numRows > 1 ? m_bucketHeight : kInfinity);
+
+    const auto lastRing = std::max({centreColumn, numColumns - 1 - centreColumn,
+        centreRow, numRows - 1 - centreRow});
+
+    for (int64_t ring=0; ring<=lastRing; ++ring)
+    {
+        const auto rowStart = std::max<int64_t>(centreRow - ring, 0);
+        const auto rowEnd = std::min(centreRow + ring, numRows - 1);
+        const auto columnStart = std::max<int64_t>(centreColumn - ring, 0);
+        const auto columnEnd = std::min(centreColumn + ring, numColumns - 1);
+
+        for (auto row=rowStart; row<=rowEnd; ++row)
+        {
+            const bool isEdgeRow = (row == centreRow - ring) ||
+                (row == centreRow + ring);
+
+            if (isEdgeRow)
+            {
+                for (auto column=columnStart; column<=columnEnd; ++column)
+                    visit(static_cast<uint32_t>(row),
+                        static_cast<uint32_t>(column));
+            }
+            else
+            {
+                // Only the ends of the row are on the ring.
+                if (centreColumn - ring >= 0)
+                    visit(static_cast<uint32_t>(row),
+                        static_cast<uint32_t>(centreColumn - ring));
+
+                if (ring > 0 && centreColumn + ring < numColumns)
+                    visit(static_cast<uint32_t>(row),
+                        static_cast<uint32_t>(centreColumn + ring));
+            }
+        }
+
+        if (ring > 0 && numFound == maxNeighbours)
+        {
+            const auto reach = ring * ringSpacing;
+            if (neighbours[numFound - 1].distSq <= reach * reach)
+                break;
+        }
+    }
+
+    return numFound;
+}
+
+//! Retrieve the indexed nodes.
+/*!
+\return
+    The nodes.
+*/
+const VerticalDatumCorrections* CorrectorIndex::getNodes() const noexcept
+{
+    return m_nodes;
+}
+
+//! Retrieve the number of indexed nodes.
+/*!
+\return
+    The number of nodes.
+*/
+size_t CorrectorIndex::size() const noexcept
+{
+    return m_numNodes;
+}
+
+//! Retrieve the memory held by the index, not counting the nodes.
+/*!
+\return
+    The memory held, in bytes.
+*/
+size_t CorrectorIndex::getMemoryUsage() const noexcept
+{
+    return sizeof(*this) + (m_bucketStarts.capacity() +
+        m_nodeIndices.capacity()) * sizeof(uint32_t);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,64 @@
+#ifndef BAG_CORRECTORINDEX_H
+#define BAG_CORRECTORINDEX_H
+
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace BAG {
+
+//! A spatial index over irregularly spaced corrector nodes.
+/*!
+    The nodes are sorted into a uniform grid of buckets covering their
+    bounding box, with about one node per bucket.  The nearest nodes to a
+    position are found by searching outwards from the bucket holding it, ring
+    by ring, until no unsearched bucket can hold anything nearer.
+*/
+class CorrectorIndex final
+{
+public:
+    //! A node found by a search.
+    struct Neighbour final
+    {
+        //! The index of the node.
+        uint32_t index = 0;
+        //! The squared distance from the search position to the node.
+        double distSq = 0.;
+    };
+
+    CorrectorIndex(const VerticalDatumCorrections* nodes, size_t numNodes);
+
+    uint32_t findNearest(double x, double y, uint32_t maxNeighbours,
+        Neighbour* neighbours) const noexcept;
+
+    const VerticalDatumCorrections* getNodes() const noexcept;
+    size_t size() const noexcept;
+    size_t getMemoryUsage() const noexcept;
+
+private:
+    uint32_t getBucketColumn(double x) const noexcept;
+    uint32_t getBucketRow(double y) const noexcept;
+
+    //! The nodes; not owned.
+    const VerticalDatumCorrections* m_nodes = nullptr;
+    //! The number of nodes.
+    size_t m_numNodes = 0;
+    //! The south west corner of the buckets.
+    double m_minX = 0., m_minY = 0.;
+    //! The size of a bucket.
+    double m_bucketWidth = 1., m_bucketHeight = 1.;
+    //! The number of bucket columns and rows.
+    uint32_t m_numBucketColumns = 1, m_numBucketRows = 1;
+    //! Where each bucket starts in m_nodeIndices; one extra for the end.
+    std::vector<uint32_t> m_bucketStarts;
+    //! The indices of the nodes, grouped by bucket.
+    std::vector<uint32_t> m_nodeIndices;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_CORRECTORINDEX_H
+
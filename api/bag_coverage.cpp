@@ -0,0 +1,263 @@
+
+#include "bag_coverage.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace BAG {
+
+namespace {
+
+//! The most rows of a coverage bitmap read at once by traceFootprint().
+constexpr uint32_t kFootprintBandRows = 1024;
+
+//! The direction of an edge of a ring; each is a left turn from the one
+//! before it.
+enum Direction : uint8_t
+{
+    East,
+    North,
+    West,
+    South,
+};
+
+//! An edge between a covered node and one that is not, with the covered
+//! node on the left.
+struct Edge final
+{
+    //! The corner the edge starts at.
+    uint64_t from = 0;
+    //! The corner the edge ends at.
+    uint64_t to = 0;
+    //! The direction of the edge.
+    Direction direction = East;
+    //! Has the edge been added to a ring?
+    bool used = false;
+};
+
+//! The edges starting at a corner; at most two, where two covered nodes
+//! only touch diagonally.
+struct CornerEdges final
+{
+    //! The indexes of the edges.
+    std::array<uint32_t, 2> edges{};
+    //! The number of edges.
+    uint32_t count = 0;
+};
+
+}  // namespace
+
+//! Trace the outline of the covered nodes of a coverage bitmap.
+/*!
+    The outline follows the edges of the nodes, each node being a cell one
+    unit square; node (r, c) spans columns c to c + 1 and rows r to r + 1.
+    Nodes that only touch at a corner are outlined apart.  Vertices along a
+    straight edge are dropped.
+
+\param rows
+    The number of rows of the layer.
+\param columns
+    The number of columns of the layer.
+\param readRows
+    Reads rows of the bitmap.
+
+\return
+    The rings of the outline, in columns (x) and rows (y) from the corner of
+    the first node; outer rings are counterclockwise, and holes clockwise.
+*/
+std::vector<FootprintRing> traceFootprint(
+    uint32_t rows,
+    uint32_t columns,
+    const CoverageRowReader& readRows)
+{
+    if (rows == 0 || columns == 0)
+        return {};
+
+    const auto rowBytes = getCoverageRowBytes(columns);
+    const uint64_t numCornerColumns = uint64_t{columns} + 1;
+
+    const auto corner = [numCornerColumns](uint64_t x, uint64_t y) {
+        return y * numCornerColumns + x;
+    };
+
+    std::vector<Edge> edges;
+    std::unordered_map<uint64_t, CornerEdges> cornerEdges;
+
+    const auto addEdge = [&](uint64_t fromX, uint64_t fromY, uint64_t toX,
+        uint64_t toY, Direction direction) {
+        Edge edge;
+        edge.from = corner(fromX, fromY);
+        edge.to = corner(toX, toY);
+        edge.direction = direction;
+
+        auto& starting = cornerEdges[edge.from];
+        starting.edges[starting.count++] = static_cast<uint32_t>(edges.size());
+        edges.push_back(edge);
+    };
+
+    // Each band is read with the rows either side of it.
+    std::vector<uint8_t> band;
+    const std::vector<uint8_t> empty(rowBytes, 0);
+
+    for (uint32_t bandStart=0; bandStart<rows; bandStart+=kFootprintBandRows)
+    {
+        const auto bandEnd = std::min(bandStart + kFootprintBandRows, rows) - 1;
+        const auto readStart = bandStart > 0 ? bandStart - 1 : 0;
+        const auto readEnd = std::min(bandEnd + 1, rows - 1);
+
+        band.resize((readEnd - readStart + 1) * rowBytes);
+        readRows(readStart, readEnd, band.data());
+
+        const auto getRow = [&](uint32_t row) {
+            return band.data() + (row - readStart) * rowBytes;
+        };
+
+        for (auto row=bandStart; row<=bandEnd; ++row)
+        {
+            const auto* current = getRow(row);
+            const auto* below = row > 0 ? getRow(row - 1) : empty.data();
+            const auto* above = row + 1 < rows ? getRow(row + 1) : empty.data();
+
+            for (uint32_t column=0; column<columns; ++column)
+            {
+                if (!isCovered(current, column))
+                    continue;
+
+                if (!isCovered(below, column))
+                    addEdge(column, row, column + 1ull, row, East);
+                if (column + 1 == columns || !isCovered(current, column + 1))
+                    addEdge(column + 1ull, row, column + 1ull, row + 1ull,
+                        North);
+                if (!isCovered(above, column))
+                    addEdge(column + 1ull, row + 1ull, column, row + 1ull,
+                        West);
+                if (column == 0 || !isCovered(current, column - 1))
+                    addEdge(column, row + 1ull, column, row, South);
+            }
+        }
+    }
+
+    std::vector<FootprintRing> rings;
+    std::vector<const Edge*> ringEdges;
+
+    for (auto& start : edges)
+    {
+        if (start.used)
+            continue;
+
+        // Follow the edges, turning left where two start at a corner, so
+        // nodes touching at a corner are not joined.
+        ringEdges.clear();
+        auto* pEdge = &start;
+
+        while (pEdge && !pEdge->used)
+        {
+            pEdge->used = true;
+            ringEdges.push_back(pEdge);
+
+            const auto& next = cornerEdges[pEdge->to];
+            Edge* pNext = nullptr;
+
+            for (const auto turn : {1, 0, 3})
+            {
+                for (uint32_t i=0; i<next.count && !pNext; ++i)
+                {
+                    auto& candidate = edges[next.edges[i]];
+                    if (!candidate.used && candidate.direction ==
+                        (pEdge->direction + turn) % 4)
+                        pNext = &candidate;
+                }
+
+                if (pNext)
+                    break;
+            }
+
+            pEdge = pNext;
+        }
+
+        // Only the corners where the direction changes are vertices.
+        FootprintRing ring;
+        const auto numEdges = ringEdges.size();
+
+        for (size_t i=0; i<numEdges; ++i)
+        {
+            const auto* pPrevious = ringEdges[(i + numEdges - 1) % numEdges];
+            if (pPrevious->direction == ringEdges[i]->direction)
+                continue;
+
+            const auto from = ringEdges[i]->from;
+            ring.points.push_back({static_cast<double>(from %
+                numCornerColumns), static_cast<double>(from /
+                numCornerColumns)});
+        }
+
+        if (ring.points.empty())
+            continue;
+
+        ring.points.push_back(ring.points.front());
+
+        // The shoelace formula; a negative area runs clockwise.
+        double area = 0.;
+        for (size_t i=1; i<ring.points.size(); ++i)
+            area += ring.points[i - 1].x * ring.points[i].y -
+                ring.points[i].x * ring.points[i - 1].y;
+
+        ring.hole = area < 0.;
+
+        rings.push_back(std::move(ring));
+    }
+
+    return rings;
+}
+
+//! Count the covered nodes in part of a row of a coverage bitmap.
+/*!
+\param row
+    The row of the bitmap.
+\param columnStart
+    The first column counted.
+\param columnEnd
+    The last column counted (inclusive).
+
+\return
+    The number of nodes covered.
+*/
+uint64_t countCoveredBits(
+    const uint8_t* row,
+    uint32_t columnStart,
+    uint32_t columnEnd) noexcept
+{
+    uint64_t count = 0;
+    auto column = columnStart;
+
+    // The bits before the first whole byte.
+    while (column <= columnEnd && column % 8 != 0)
+        count += isCovered(row, column++);
+
+    // Whole words, then whole bytes.
+    while (columnEnd >= column && columnEnd - column + 1 >= 64)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, row + column / 8, sizeof(word));
+        count += std::bitset<64>{word}.count();
+        column += 64;
+    }
+
+    while (columnEnd >= column && columnEnd - column + 1 >= 8)
+    {
+        count += std::bitset<8>{row[column / 8]}.count();
+        column += 8;
+    }
+
+    while (column <= columnEnd)
+        count += isCovered(row, column++);
+
+    return count;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,60 @@
+#ifndef BAG_COVERAGE_H
+#define BAG_COVERAGE_H
+
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+namespace BAG {
+
+//! Retrieve the number of bytes in a row of a coverage bitmap.
+/*!
+\param columns
+    The number of columns of the layer.
+
+\return
+    The bytes holding a bit for each column.
+*/
+inline size_t getCoverageRowBytes(
+    uint32_t columns) noexcept
+{
+    return (static_cast<size_t>(columns) + 7) / 8;
+}
+
+//! Determine if a node is covered in a row of a coverage bitmap.
+/*!
+    Column c is bit c % 8 (least significant first) of byte c / 8.
+
+\param row
+    The row of the bitmap.
+\param column
+    The column of the node.
+
+\return
+    \e true if the node is not null.
+*/
+inline bool isCovered(
+    const uint8_t* row,
+    uint32_t column) noexcept
+{
+    return (row[column / 8] >> (column % 8)) & 1;
+}
+
+//! Reads whole rows of a coverage bitmap: the first row, the last row
+//! (inclusive), and where to put them.
+using CoverageRowReader = std::function<void(uint32_t, uint32_t, uint8_t*)>;
+
+std::vector<FootprintRing> traceFootprint(uint32_t rows, uint32_t columns,
+    const CoverageRowReader& readRows);
+
+uint64_t countCoveredBits(const uint8_t* row, uint32_t columnStart,
+    uint32_t columnEnd) noexcept;
+
+}  // namespace BAG
+
+#endif  // BAG_COVERAGE_H
+
@@ -1,18 +1,27 @@
 
+#include "bag_accesstracer.h"
 #include "bag_attributeinfo.h"
 #include "bag_georefmetadatalayer.h"
 #include "bag_georefmetadatalayerdescriptor.h"
+#include "bag_chunkhash.h"
 #include "bag_dataset.h"
+#include "bag_datasetsnapshot.h"
 #include "bag_exceptions.h"
+#include "bag_hdfhelper.h"
 #include "bag_interleavedlegacylayer.h"
 #include "bag_interleavedlegacylayerdescriptor.h"
+#include "bag_memorybudget.h"
 #include "bag_metadataprofiles.h"
 #include "bag_metadata_export.h"
+#include "bag_minmax.h"
+#include "bag_mpi.h"
+#include "bag_parallel.h"
 #include "bag_private.h"
 #include "bag_simplelayer.h"
 #include "bag_simplelayerdescriptor.h"
 #include "bag_surfacecorrections.h"
 #include "bag_surfacecorrectionsdescriptor.h"
+#include "bag_verify.h"
 #include "bag_version.h"
 #include "bag_vrmetadata.h"
 #include "bag_vrmetadatadescriptor.h"
@@ -24,7 +33,10 @@
 #include <iostream>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
+#include <cmath>
+#include <cstring>
 #include <H5Cpp.h>
 #include <H5Exception.h>
 #include <map>
@@ -32,6 +44,8 @@
 #include <regex>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 
 namespace BAG {
@@ -40,57 +54,121 @@ using std::cerr;
 
 namespace {
 
-//! Find a layer by type and case-insensitive name.
+//! The amount, in bytes, the memory of a BAG held in memory grows by.
+constexpr size_t kCoreIncrement = 1024 * 1024;
+
+//! The size, in bytes, of the file space pages of a cloud optimized BAG.
 /*!
-\param layers
-    The layers to search.
-\param type
-    The type of layer to find.
-\param name
-    The case-insensitive name of the layer to find.
-    This is optional unless looking for a georeferenced metadata layer.
+    Large enough to hold the metadata of most BAGs in one page, and to make
+    each request to an object store worth its latency.
+*/
+constexpr hsize_t kCloudOptimizedPageSize = 4 * 1024 * 1024;
+
+//! Make a name for a BAG held in memory.
+/*!
+    The HDF5 core driver takes files with the same name to be the same file,
+    so every BAG held in memory gets its own name.
 
 \return
-    The found layer.
-    nullptr if not found.
+    A name no other BAG held in memory uses.
 */
-std::shared_ptr<Layer> getLayer(
-    const std::vector<std::shared_ptr<Layer>>& layers,
-    LayerType type,
-    const std::string& name = {})
+std::string makeInMemoryFileName()
 {
-    if (type == Georef_Metadata && name.empty())
-        throw NameRequired{};
+    static std::atomic<uint64_t> counter{0};
 
-    std::string nameLower{name};
-    std::transform(begin(nameLower), end(nameLower), begin(nameLower),
-        [](char c) noexcept {
-            return static_cast<char>(std::tolower(c));
-        });
+    return "bag_in_memory_" + std::to_string(++counter);
+}
 
-    std::shared_ptr<Layer> foundLayer = nullptr;
-    for (auto layer : layers) {
-        auto pDescriptor = layer->getDescriptor();
-        if (type == pDescriptor->getLayerType()) {
-            if (nameLower.empty()) {
-                foundLayer = layer;
-                break;
-            }
-            std::string foundNameLower{pDescriptor->getName()};
-            std::transform(begin(foundNameLower), end(foundNameLower), begin(foundNameLower),
-                           [](char c) noexcept {
-                               return static_cast<char>(std::tolower(c));
-                           });
-            if (foundNameLower == nameLower) {
-                foundLayer = layer;
-                break;
-            }
-        }
-    }
+//! Determine if a BAG is named by a URL, rather than a file name.
+/*!
+\param fileName
+    The name of the BAG.
+
+\return
+    \e true if the name is an s3://, https:// or http:// URL.
+*/
+bool isRemoteFileName(
+    const std::string& fileName) noexcept
+{
+    for (const auto* scheme : {"s3://", "https://", "http://"})
+        if (fileName.compare(0, std::strlen(scheme), scheme) == 0)
+            return true;
+
+    return false;
+}
 
-    if (foundLayer == nullptr) return {};
+//! Read a BAG named by a URL with the HDF5 read only S3 (ROS3) driver.
+/*!
+    The ROS3 driver only reads http(s) URLs, so an s3:// URL is turned into
+    the virtual hosted URL of the object.
+
+\param fileName
+    The URL of the BAG.
+\param options
+    The region and credentials.
+\param h5accessProps
+    The file access properties to use the ROS3 driver.
+
+\return
+    The URL the ROS3 driver reads.
+*/
+std::string setRemoteAccess(
+    const std::string& fileName,
+    const RemoteOptions& options,
+    ::H5::FileAccPropList& h5accessProps)
+{
+#ifndef H5_HAVE_ROS3_VFD
+    (void)fileName;
+    (void)options;
+    (void)h5accessProps;
+
+    throw RemoteReadsNotAvailable{};
+#else
+    H5FD_ros3_fapl_t ros3Props{};
+    ros3Props.version = H5FD_CURR_ROS3_FAPL_T_VERSION;
+    ros3Props.authenticate = !options.accessKeyId.empty();
+
+    // Longer values are not valid AWS regions or keys anyway.
+    options.region.copy(ros3Props.aws_region, H5FD_ROS3_MAX_REGION_LEN);
+    options.accessKeyId.copy(ros3Props.secret_id, H5FD_ROS3_MAX_SECRET_ID_LEN);
+    options.secretAccessKey.copy(ros3Props.secret_key,
+        H5FD_ROS3_MAX_SECRET_KEY_LEN);
+
+    if (H5Pset_fapl_ros3(h5accessProps.getId(), &ros3Props) < 0)
+        throw RemoteReadsNotAvailable{};
+
+    const std::string s3Scheme{"s3://"};
+    if (fileName.compare(0, s3Scheme.size(), s3Scheme) != 0)
+        return fileName;
+
+    // s3://bucket/key
+    const auto bucketEnd = fileName.find('/', s3Scheme.size());
+    const auto bucket = fileName.substr(s3Scheme.size(),
+        bucketEnd - s3Scheme.size());
+    const auto key = bucketEnd == std::string::npos ? std::string{} :
+        fileName.substr(bucketEnd);
+
+    return "https://" + bucket + ".s3." +
+        (options.region.empty() ? std::string{} : options.region + ".") +
+        "amazonaws.com" + key;
+#endif
+}
+
+//! Determine if an HDF5 link exists, without opening what it links to.
+/*!
+\param h5group
+    The HDF5 group the path is relative to.
+\param path
+    The path of the link.
 
-    return std::shared_ptr<Layer>(foundLayer);
+\return
+    \e true if the link exists, \e false otherwise.
+*/
+bool linkExists(
+    const ::H5::Group& h5group,
+    const std::string& path)
+{
+    return H5Lexists(h5group.getId(), path.c_str(), H5P_DEFAULT) > 0;
 }
 
 //! Get the numerical version.
@@ -141,12 +219,25 @@ uint32_t getNumericalVersion(
 template <typename T>
 using IsNotString = std::enable_if_t<!std::is_same<T, std::string>::value>;
 
+//! Retrieve the native HDF5 type of a C++ type.
+const ::H5::PredType& getNativeType(float) noexcept
+{
+    return ::H5::PredType::NATIVE_FLOAT;
+}
+
+//! Retrieve the native HDF5 type of a C++ type.
+const ::H5::PredType& getNativeType(uint32_t) noexcept
+{
+    return ::H5::PredType::NATIVE_UINT32;
+}
+
 //! Helper to read a non-string attribute from an HDF5 DataSet.
 /*!
-\param h5file
-    The HDF5 file to read.
-\param dataSetName
-    The name of the HDF5 DataSet.
+    HDF5 converts the value, as the attribute may be stored as another type;
+    the minimum and maximum of the node group hypotheses are integers.
+
+\param h5DataSet
+    The HDF5 DataSet to read.
 \param attributeName
     The name of the attribute.
 
@@ -155,15 +246,13 @@ using IsNotString = std::enable_if_t<!std::is_same<T, std::string>::value>;
 */
 template <typename T, typename = IsNotString<T>>
 T readAttributeFromDataSet(
-    const ::H5::H5File& h5file,
-    const std::string& dataSetName,
-    const std::string& attributeName)
+    const ::H5::DataSet& h5DataSet,
+    const char* attributeName)
 {
-    const ::H5::DataSet h5DataSet = h5file.openDataSet(dataSetName);
     const ::H5::Attribute attribute = h5DataSet.openAttribute(attributeName);
 
     T value{};
-    attribute.read(attribute.getDataType(), &value);
+    attribute.read(getNativeType(value), &value);
 
     return value;
 }
@@ -221,6 +310,56 @@ T readAttributeFromGroup(
     return value;
 }
 
+//! Convert a layer name to lower case, as it is compared case-insensitively.
+/*!
+\param name
+    The layer name.
+
+\return
+    The lower case layer name.
+*/
+std::string toLowerCase(
+    std::string name)
+{
+    std::transform(begin(name), end(name), begin(name),
+        [](char c) noexcept {
+            return static_cast<char>(std::tolower(c));
+        });
+
+    return name;
+}
+
+//! Helper to read the XML of the metadata of a BAG.
+/*!
+    A MetadataNotFound exception is thrown if the BAG has no metadata.
+
+\param h5file
+    The HDF5 file to read.
+
+\return
+    The XML of the metadata.
+*/
+std::string readMetadataXML(
+    const ::H5::H5File& h5file)
+{
+    std::unique_ptr<::H5::DataSet> pH5dataSet;
+    try
+    {
+        pH5dataSet = std::make_unique<::H5::DataSet>(
+            h5file.openDataSet(METADATA_PATH));
+    }
+    catch(...)
+    {
+        throw MetadataNotFound{};
+    }
+
+    H5std_string buffer;
+    const ::H5::StrType stringType{*pH5dataSet};
+    pH5dataSet->read(buffer, stringType);
+
+    return buffer;
+}
+
 //! Helper to read a string attribute from an HDF5 Group.
 /*!
 \param h5file
@@ -247,6 +386,244 @@ std::string readStringAttributeFromGroup(
     return value;
 }
 
+//! The attributes of the layer descriptors of a BAG; see
+//! readDescriptorAttributes().
+struct DescriptorAttributes final
+{
+    //! Were the minimum and maximum of a simple or interleaved layer read,
+    //! by layer type?
+    std::array<bool, UNKNOWN_LAYER_TYPE> hasMinMax{};
+    //! The minimum and maximum of the simple and interleaved layers, by
+    //! layer type.
+    std::array<std::tuple<float, float>, UNKNOWN_LAYER_TYPE> minMax{};
+    //! The minimum dimensions of the variable resolution metadata.
+    std::tuple<uint32_t, uint32_t> vrMinDims{};
+    //! The maximum dimensions of the variable resolution metadata.
+    std::tuple<uint32_t, uint32_t> vrMaxDims{};
+    //! The minimum resolution of the variable resolution metadata.
+    std::tuple<float, float> vrMinResolution{};
+    //! The maximum resolution of the variable resolution metadata.
+    std::tuple<float, float> vrMaxResolution{};
+    //! The minimum and maximum depth of the variable resolution refinements.
+    std::tuple<float, float> vrMinMaxDepth{};
+    //! The minimum and maximum uncertainty of the variable resolution
+    //! refinements.
+    std::tuple<float, float> vrMinMaxUncertainty{};
+    //! The minimum and maximum hypothesis strength of the variable
+    //! resolution nodes.
+    std::tuple<float, float> vrMinMaxHypStrength{};
+    //! The minimum and maximum number of hypotheses of the variable
+    //! resolution nodes.
+    std::tuple<uint32_t, uint32_t> vrMinMaxNumHypotheses{};
+    //! The minimum and maximum number of samples of the variable resolution
+    //! nodes.
+    std::tuple<uint32_t, uint32_t> vrMinMaxNSamples{};
+};
+
+//! Helper to read the attributes of the layer descriptors of a BAG.
+/*!
+    All the attributes are read in one pass when the BAG is opened, each
+    HDF5 DataSet being opened once.  The layer descriptors are set from
+    them, so a query of a descriptor never reads HDF5, even for a layer that
+    has not been opened yet (OpenOptions::lazy).  The attributes are written
+    from the descriptors, so the descriptors stay in sync with the file.
+
+\param h5file
+    The HDF5 file of the BAG.
+\param bagVersion
+    The numerical version of the BAG.
+
+\return
+    The attributes; those of layers that do not exist are not read.
+*/
+DescriptorAttributes readDescriptorAttributes(
+    const ::H5::H5File& h5file,
+    uint32_t bagVersion)
+{
+    DescriptorAttributes attributes;
+    const auto bagGroup = h5file.openGroup(ROOT_PATH);
+
+    const auto readMinMax = [&attributes](const ::H5::DataSet& h5dataSet,
+        LayerType type) {
+            try
+            {
+                const auto info = getAttributeInfo(type);
+
+                attributes.minMax[type] = std::make_tuple(
+                    readAttributeFromDataSet<float>(h5dataSet, info.minName),
+                    readAttributeFromDataSet<float>(h5dataSet, info.maxName));
+                attributes.hasMinMax[type] = true;
+            }
+            catch(const UnsupportedSimpleLayerType&)
+            {
+                // No min/max attributes.
+            }
+        };
+
+    for (auto layerType : {Elevation, Uncertainty, Hypothesis_Strength,
+        Num_Hypotheses, Shoal_Elevation, Std_Dev, Num_Soundings,
+        Average_Elevation, Nominal_Elevation})
+    {
+        const std::string internalPath = Layer::getInternalPath(layerType);
+        if (internalPath.empty() || !linkExists(bagGroup, internalPath))
+            continue;
+
+        readMinMax(h5file.openDataSet(internalPath), layerType);
+    }
+
+    // The interleaved layers of a BAG 1.5+ share the DataSet of their group.
+    if (bagVersion >= 1'005'000)
+    {
+        if (linkExists(bagGroup, NODE_GROUP_PATH))
+        {
+            const auto h5dataSet = h5file.openDataSet(NODE_GROUP_PATH);
+
+            for (auto layerType : {Hypothesis_Strength, Num_Hypotheses})
+                readMinMax(h5dataSet, layerType);
+        }
+
+        if (linkExists(bagGroup, ELEVATION_SOLUTION_GROUP_PATH))
+        {
+            const auto h5dataSet = h5file.openDataSet(
+                ELEVATION_SOLUTION_GROUP_PATH);
+
+            for (auto layerType : {Shoal_Elevation, Std_Dev, Num_Soundings})
+                readMinMax(h5dataSet, layerType);
+        }
+    }
+
+    if (!linkExists(bagGroup, VR_TRACKING_LIST_PATH))
+        return attributes;
+
+    {
+        const auto h5dataSet = h5file.openDataSet(VR_METADATA_PATH);
+
+        attributes.vrMinDims = std::make_tuple(
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_METADATA_MIN_DIMS_X),
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_METADATA_MIN_DIMS_Y));
+        attributes.vrMaxDims = std::make_tuple(
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_METADATA_MAX_DIMS_X),
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_METADATA_MAX_DIMS_Y));
+        attributes.vrMinResolution = std::make_tuple(
+            readAttributeFromDataSet<float>(h5dataSet, VR_METADATA_MIN_RES_X),
+            readAttributeFromDataSet<float>(h5dataSet, VR_METADATA_MIN_RES_Y));
+        attributes.vrMaxResolution = std::make_tuple(
+            readAttributeFromDataSet<float>(h5dataSet, VR_METADATA_MAX_RES_X),
+            readAttributeFromDataSet<float>(h5dataSet, VR_METADATA_MAX_RES_Y));
+    }
+
+    {
+        const auto h5dataSet = h5file.openDataSet(VR_REFINEMENT_PATH);
+
+        attributes.vrMinMaxDepth = std::make_tuple(
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_REFINEMENT_MIN_DEPTH),
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_REFINEMENT_MAX_DEPTH));
+        attributes.vrMinMaxUncertainty = std::make_tuple(
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_REFINEMENT_MIN_UNCERTAINTY),
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_REFINEMENT_MAX_UNCERTAINTY));
+    }
+
+    if (linkExists(bagGroup, VR_NODE_PATH))
+    {
+        const auto h5dataSet = h5file.openDataSet(VR_NODE_PATH);
+
+        attributes.vrMinMaxHypStrength = std::make_tuple(
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_NODE_MIN_HYP_STRENGTH),
+            readAttributeFromDataSet<float>(h5dataSet,
+                VR_NODE_MAX_HYP_STRENGTH));
+        attributes.vrMinMaxNumHypotheses = std::make_tuple(
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_NODE_MIN_NUM_HYPOTHESES),
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_NODE_MAX_NUM_HYPOTHESES));
+        attributes.vrMinMaxNSamples = std::make_tuple(
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_NODE_MIN_N_SAMPLES),
+            readAttributeFromDataSet<uint32_t>(h5dataSet,
+                VR_NODE_MAX_N_SAMPLES));
+    }
+
+    return attributes;
+}
+
+//! The most items of a variable resolution layer read at once by
+//! Dataset::recomputeVRStatistics().
+constexpr uint64_t kVRStatisticsBandItems = 1 << 20;
+
+//! Compute the min/max of the items of a variable resolution layer.
+/*!
+    The layer is read a band at a time on the calling thread, as HDF5 is not
+    thread safe.  The min/max of each unit of the band is then computed in
+    parallel, and merged.
+
+\param numItems
+    The number of items in the layer.
+\param unitItems
+    The number of items in a unit: a chunk of a 1D layer, or a row of the
+    VRMetadata layer.  Bands are made of whole units.
+\param readItems
+    Reads a band; called with the first item, the number of items and the
+    buffer to read them into.
+
+\return
+    The min/max of the non null fields of the items.
+*/
+template <typename Item, typename ReadItems>
+auto computeVRMinMax(
+    uint64_t numItems,
+    uint64_t unitItems,
+    const ReadItems& readItems)
+{
+    using Result = decltype(computeMinMax(std::declval<const Item*>(),
+        size_t{}));
+
+    Result result;
+
+    unitItems = std::max<uint64_t>(std::min<uint64_t>(unitItems,
+        kVRStatisticsBandItems), 1);
+    const auto bandItems = kVRStatisticsBandItems / unitItems * unitItems;
+
+    std::vector<Item> items;
+    std::vector<Result> unitResults;
+
+    for (uint64_t bandStart=0; bandStart<numItems; bandStart+=bandItems)
+    {
+        const auto count = std::min(bandItems, numItems - bandStart);
+
+        items.resize(static_cast<size_t>(count));
+        readItems(bandStart, count, items.data());
+
+        const auto numUnits = static_cast<uint32_t>(
+            (count + unitItems - 1) / unitItems);
+        unitResults.assign(numUnits, Result{});
+
+        processInBlocks(0, numUnits - 1, static_cast<uint32_t>(unitItems),
+            [&](uint32_t first, uint32_t last) {
+                for (auto unit=first; unit<=last; ++unit)
+                {
+                    const auto start = unit * unitItems;
+                    unitResults[unit] = computeMinMax(items.data() + start,
+                        static_cast<size_t>(std::min(unitItems,
+                            count - start)));
+                }
+            });
+
+        for (const auto& unitResult : unitResults)
+            merge(result, unitResult);
+    }
+
+    return result;
+}
+
 }  // namespace
 
 //! Open an existing BAG.
@@ -262,58 +639,972 @@ std::string readStringAttributeFromGroup(
 std::shared_ptr<Dataset> Dataset::open(
     const std::string& fileName,
     OpenMode openMode)
+{
+    return Dataset::open(fileName, openMode, OpenOptions{});
+}
+
+//! Open an existing BAG.
+/*!
+    A BAG in a cloud object store can be read, with ranged requests, through
+    an s3:// or https:// URL; see OpenOptions::remote.  A page buffer
+    (OpenOptions::pageBufferSize) cuts the number of requests for BAGs
+    written with paged file space.
+
+\param fileName
+    The name of the BAG, or its URL.
+\param openMode
+    The mode to open the BAG with; BAGs named by a URL are read only.
+\param options
+    The options, such as the chunk cache, to open the BAG with.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::open(
+    const std::string& fileName,
+    OpenMode openMode,
+    const OpenOptions& options)
 {
 #ifdef NDEBUG
     ::H5::Exception::dontPrint();
 #endif
 
+    const TraceScope trace{"Dataset::open"};
+
     std::shared_ptr<Dataset> pDataset{new Dataset};
     try
     {
-        pDataset->readDataset(fileName, openMode);
+        pDataset->readDataset(fileName, openMode, options);
     } catch (H5::FileIException &fileExcept)
     {
-        std::cerr << "\nUnable to open BAG file: " << fileName << " due to error: " << fileExcept.getCDetailMsg();
-        return nullptr;
+        std::cerr << "\nUnable to open BAG file: " << fileName << " due to error: " << fileExcept.getCDetailMsg();
+        return nullptr;
+    }
+
+    return pDataset;
+}
+
+//! Create a BAG.
+/*!
+\param fileName
+    The name of the BAG.
+\param metadata
+    The metadata describing the BAG.
+    This parameter will be moved, and not usable after.
+\param chunkSize
+    The chunk size the HDF5 DataSet will use.
+\param compressionLevel
+    The compression level the HDF5 DataSet will use.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::create(
+    const std::string& fileName,
+    Metadata&& metadata,
+    uint64_t chunkSize,
+    int compressionLevel)
+{
+    return Dataset::create(fileName, std::move(metadata),
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel);
+}
+
+//! Create a BAG, with chunks of a shape other than square.
+/*!
+\param fileName
+    The name of the BAG.
+\param metadata
+    The metadata describing the BAG.
+    This parameter will be moved, and not usable after.
+\param chunkShape
+    The shape of the chunks the elevation and uncertainty layers will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param profile
+    How the file is laid out.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::create(
+    const std::string& fileName,
+    Metadata&& metadata,
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    CreationProfile profile)
+{
+    std::shared_ptr<Dataset> pDataset{new Dataset};
+    pDataset->createDataset(fileName, std::move(metadata), chunkShape,
+        compression, profile);
+
+    return pDataset;
+}
+
+#ifdef BAG_USE_MPI
+//! Create a BAG shared by several processes, through the MPI-IO driver.
+/*!
+    This is collective; every process of the communicator must create the
+    BAG with the same metadata, then create the same layers.  Each process
+    may then write its own window of a simple layer, but every one of them
+    must call Layer::write(), as the write is collective.  The min/max of a
+    simple layer is reduced across the processes after each write.
+
+    The communicator must outlive the Dataset.
+
+\param communicator
+    The processes sharing the BAG.
+\param fileName
+    The name of the BAG.
+\param metadata
+    The metadata describing the BAG.
+    This parameter will be moved, and not usable after.
+\param chunkShape
+    The shape of the chunks the elevation and uncertainty layers will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param profile
+    How the file is laid out.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::create(
+    MPI_Comm communicator,
+    const std::string& fileName,
+    Metadata&& metadata,
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    CreationProfile profile)
+{
+    std::shared_ptr<Dataset> pDataset{new Dataset};
+    pDataset->m_communicator = communicator;
+    pDataset->createDataset(fileName, std::move(metadata), chunkShape,
+        compression, profile);
+
+    return pDataset;
+}
+#endif
+
+//! Open a BAG from an image of its file held in memory.
+/*!
+\param image
+    The bytes of the BAG file.
+\param imageSize
+    The number of bytes in image.
+\param openMode
+    The mode to open the BAG with.  Changes made to a BAG opened read/write
+    are only kept in memory; see getFileImage().
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::openFromMemory(
+    const uint8_t* image,
+    size_t imageSize,
+    OpenMode openMode)
+{
+    return Dataset::openFromMemory(image, imageSize, openMode, OpenOptions{});
+}
+
+//! Open a BAG from an image of its file held in memory.
+/*!
+    The image is copied, so it need not outlive the Dataset.
+
+\param image
+    The bytes of the BAG file.
+\param imageSize
+    The number of bytes in image.
+\param openMode
+    The mode to open the BAG with.  Changes made to a BAG opened read/write
+    are only kept in memory; see getFileImage().
+\param options
+    The options, such as the chunk cache, to open the BAG with.
+
+\return
+    The BAG Dataset.
+    nullptr if the image is not an HDF5 file.
+*/
+std::shared_ptr<Dataset> Dataset::openFromMemory(
+    const uint8_t* image,
+    size_t imageSize,
+    OpenMode openMode,
+    const OpenOptions& options)
+{
+    if (!image || imageSize == 0)
+        throw InvalidBuffer{};
+
+#ifdef NDEBUG
+    ::H5::Exception::dontPrint();
+#endif
+
+    const TraceScope trace{"Dataset::openFromMemory"};
+
+    std::shared_ptr<Dataset> pDataset{new Dataset};
+    try
+    {
+        pDataset->readDataset(makeInMemoryFileName(), openMode, options, image,
+            imageSize);
+    } catch (H5::FileIException &fileExcept)
+    {
+        std::cerr << "\nUnable to open BAG from memory due to error: " << fileExcept.getCDetailMsg();
+        return nullptr;
+    }
+
+    return pDataset;
+}
+
+//! Create a BAG held in memory.
+/*!
+\param metadata
+    The metadata describing the BAG.
+    This parameter will be moved, and not usable after.
+\param chunkSize
+    The chunk size the HDF5 DataSet will use.
+\param compressionLevel
+    The compression level the HDF5 DataSet will use.
+\param persistFileName
+    The name of a file the BAG is written to when it is closed; empty to
+    only keep it in memory.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::createInMemory(
+    Metadata&& metadata,
+    uint64_t chunkSize,
+    int compressionLevel,
+    const std::string& persistFileName)
+{
+    return Dataset::createInMemory(std::move(metadata),
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel,
+        persistFileName);
+}
+
+//! Create a BAG held in memory, with chunks of a shape other than square.
+/*!
+    The BAG is built in memory with the HDF5 core driver; getFileImage()
+    returns the bytes of its file.
+
+\param metadata
+    The metadata describing the BAG.
+    This parameter will be moved, and not usable after.
+\param chunkShape
+    The shape of the chunks the elevation and uncertainty layers will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param persistFileName
+    The name of a file the BAG is written to when it is closed; empty to
+    only keep it in memory.
+\param profile
+    How the file is laid out.
+
+\return
+    The BAG Dataset.
+*/
+std::shared_ptr<Dataset> Dataset::createInMemory(
+    Metadata&& metadata,
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    const std::string& persistFileName,
+    CreationProfile profile)
+{
+    const bool persist = !persistFileName.empty();
+
+    std::shared_ptr<Dataset> pDataset{new Dataset};
+    pDataset->createDataset(persist ? persistFileName : makeInMemoryFileName(),
+        std::move(metadata), chunkShape, compression, profile, true, persist);
+
+    return pDataset;
+}
+
+//! Retrieve the bytes of the BAG file.
+/*!
+    Any deferred layer attributes are written first.  The image can be
+    written to a file, or opened again with openFromMemory().
+
+\return
+    The bytes of the BAG file.
+    Empty if the BAG is closed.
+*/
+std::vector<uint8_t> Dataset::getFileImage()
+{
+    if (!m_pH5file)
+        return {};
+
+    this->flush();
+
+    const auto imageSize = H5Fget_file_image(m_pH5file->getId(), nullptr, 0);
+    if (imageSize < 0)
+        throw ::H5::FileIException{"Dataset::getFileImage",
+            "H5Fget_file_image failed"};
+
+    std::vector<uint8_t> image(static_cast<size_t>(imageSize));
+    if (H5Fget_file_image(m_pH5file->getId(), image.data(), image.size()) < 0)
+        throw ::H5::FileIException{"Dataset::getFileImage",
+            "H5Fget_file_image failed"};
+
+    return image;
+}
+
+//! Determine if a compression filter can be used by new layers.
+/*!
+    Filters other than deflate are usually loaded from an HDF5 filter plugin,
+    found through the HDF5_PLUGIN_PATH environment variable.
+
+\param filter
+    The HDF5 filter id.
+
+\return
+    \e true if the filter is built into HDF5, or its plugin could be loaded.
+*/
+bool Dataset::isCompressionFilterAvailable(
+    int filter) noexcept
+{
+    return BAG::isFilterAvailable(filter);
+}
+
+//! Determine if BAGs named by a URL can be read.
+/*!
+\return
+    \e true if HDF5 was built with the read only S3 (ROS3) driver.
+*/
+bool Dataset::isRemoteReadAvailable() noexcept
+{
+#ifdef H5_HAVE_ROS3_VFD
+    return true;
+#else
+    return false;
+#endif
+}
+
+//! Destructor.
+/*!
+    Any deferred writes are made before the HDF5 file is closed, even those
+    of a batch that was not committed.
+*/
+Dataset::~Dataset()
+{
+    MemoryBudget::global().remove(*this);
+
+    try
+    {
+        this->writeDeferred();
+        this->trimReserved();
+    }
+    catch(...)
+    {}
+}
+
+//! Close a BAG dataset. Closes the underlying HDF5 file.
+/*!
+    Any deferred writes are made before the HDF5 file is closed, even those
+    of a batch that was not committed.
+*/
+void Dataset::close() {
+    if (m_pH5file) {
+        this->writeDeferred();
+        this->trimReserved();
+        m_pH5file->close();
+        m_pH5file.reset(nullptr);
+    }
+}
+
+//! Make any deferred writes, and flush the HDF5 file to disk.
+/*!
+    The writes deferred by a batch are made too; the batch carries on.
+*/
+void Dataset::flush()
+{
+    if (!m_pH5file)
+        return;
+
+    this->writeDeferred();
+    m_pH5file->flush(H5F_SCOPE_GLOBAL);
+}
+
+//! Write the attributes of every layer whose attribute writes were deferred.
+/*!
+    The layers' attributes are written directly, so this is safe to call while
+    the dataset is being destroyed.
+*/
+void Dataset::flushLayerAttributes() const
+{
+    if (!m_pH5file)
+        return;
+
+    for (const auto& layer : m_layers)
+    {
+        if (layer && layer->m_attributesDirty)
+        {
+            layer->writeAttributesProxy();
+            layer->m_attributesDirty = false;
+        }
+    }
+}
+
+//! Make the writes deferred by setDeferAttributeWrites() or a batch.
+/*!
+    The layer attributes are written first, then the tracking lists.
+*/
+void Dataset::writeDeferred() const
+{
+    if (!m_pH5file)
+        return;
+
+    this->flushLayerAttributes();
+
+    if (m_pTrackingList && m_pTrackingList->m_writeDeferred)
+        m_pTrackingList->writeItems();
+
+    if (m_pVRTrackingList && m_pVRTrackingList->m_writeDeferred)
+        m_pVRTrackingList->writeItems();
+}
+
+//! Trim the room reserved for the variable resolution layers and tracking
+//! lists that was not written to.
+/*!
+    See Dataset::createVR() and TrackingList::preallocate().
+*/
+void Dataset::trimReserved()
+{
+    if (!m_pH5file || m_descriptor.isReadOnly())
+        return;
+
+    if (m_pTrackingList)
+        m_pTrackingList->trim();
+
+    if (m_pVRTrackingList)
+        m_pVRTrackingList->trim();
+
+    const auto pRefinements = this->getVRRefinements();
+    if (pRefinements)
+        pRefinements->trim();
+
+    const auto pNode = this->getVRNode();
+    if (pNode)
+        pNode->trim();
+}
+
+//! Determine if the BAG can be read from several threads at once.
+/*!
+\return
+    \e true if the BAG was opened with OpenOptions::concurrentReads.
+    \e false otherwise.
+*/
+bool Dataset::isConcurrentReadEnabled() const noexcept
+{
+    return m_openOptions.concurrentReads;
+}
+
+//! Determine if different layers can be written from different threads.
+/*!
+\return
+    \e true if setConcurrentWrites() enabled it.
+    \e false otherwise (the default).
+*/
+bool Dataset::isConcurrentWriteEnabled() const noexcept
+{
+    return m_concurrentWrites;
+}
+
+//! Set whether different layers can be written from different threads.
+/*!
+    HDF5 can only be called from one thread at a time, so every call to it
+    is then serialized on one lock held by the Dataset, in the order the
+    threads reach it.  The work done before a write reaches HDF5 is not: a
+    simple layer written in whole chunks copies, shuffles and deflates them,
+    and finds their min/max and which of them are only null, outside the
+    lock, so only the commit of the chunks waits for other writers.  Other
+    layers, and areas written in part of a chunk, are written by HDF5 under
+    the lock.
+
+    Each layer must only be written by one thread at a time, and the layers
+    must be created, and other changes to the Dataset made, while no layer
+    is being written.  Reads may be made from any thread.  Set before the
+    threads start writing.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+
+\param enabled
+    \e true to allow concurrent writes to different layers.
+    \e false to write from one thread only (the default).
+*/
+void Dataset::setConcurrentWrites(
+    bool enabled)
+{
+    if (enabled && m_descriptor.isReadOnly())
+        throw ReadOnlyError{};
+
+    m_concurrentWrites = enabled;
+}
+
+//! Determine if the BAG is shared by several processes.
+/*!
+\return
+    \e true if the BAG was opened or created with an MPI communicator, so
+    writes to its simple layers are collective.
+    \e false otherwise, and always if the library was built without
+    BAG_BUILD_MPI.
+*/
+bool Dataset::isParallel() const noexcept
+{
+#ifdef BAG_USE_MPI
+    return m_communicator != MPI_COMM_NULL;
+#else
+    return false;
+#endif
+}
+
+#ifdef BAG_USE_MPI
+//! Retrieve the processes sharing the BAG.
+/*!
+\return
+    The communicator the BAG was opened or created with.
+    MPI_COMM_NULL if it is not shared.
+*/
+MPI_Comm Dataset::getCommunicator() const noexcept
+{
+    return m_communicator;
+}
+#endif
+
+//! Determine if layer attributes are only written when flushed.
+/*!
+\return
+    \e true if writing to a layer defers writing its attributes (such as
+    min/max) until flush(), close() or the dataset is destroyed, or the batch
+    in progress is committed.
+    \e false if the attributes are written after every write (the default).
+*/
+bool Dataset::isDeferringAttributeWrites() const noexcept
+{
+    return m_deferAttributeWrites || m_batchDepth > 0;
+}
+
+//! Set whether layer attributes are only written when flushed.
+/*!
+    Deferring attribute writes avoids rewriting the min/max attributes after
+    every block when streaming many small writes.  Any deferred attributes are
+    written when switching back to immediate writes.
+
+\param defer
+    \e true to defer writing layer attributes until flush(), close() or the
+    dataset is destroyed.
+    \e false to write the attributes after every write.
+*/
+void Dataset::setDeferAttributeWrites(
+    bool defer)
+{
+    if (!defer && m_batchDepth == 0)
+        this->flushLayerAttributes();
+
+    m_deferAttributeWrites = defer;
+}
+
+//! Begin a batch of writes.
+/*!
+    Until the batch is committed, the writes that follow each write to the
+    BAG are deferred: the attributes (such as min/max) of the layers written
+    to, and TrackingList::write() and VRTrackingList::write().  commit() then
+    makes each of them once.  The data of the layers is still written as it
+    comes.  The min/max of the simple layers SimpleLayer::updateMinMax() was
+    called on is then made exact again.
+
+    Batches nest; only committing the outermost one makes the deferred
+    writes.  Closing or destroying the dataset makes them too.
+*/
+void Dataset::beginBatch() noexcept
+{
+    ++m_batchDepth;
+}
+
+//! Commit the batch begun by the last beginBatch().
+/*!
+    A NoBatchInProgress exception is thrown if there is no batch to commit.
+
+\param flushFile
+    \e true to also flush the HDF5 file to disk, once, when the outermost
+    batch is committed.
+    \e false to leave that to HDF5, or a later flush() or close().
+*/
+void Dataset::commit(
+    bool flushFile)
+{
+    if (m_batchDepth == 0)
+        throw NoBatchInProgress{};
+
+    if (--m_batchDepth > 0)
+        return;
+
+    // Layers whose tiles are summarized re-read the tiles written in part.
+    for (const auto& layer : m_layers)
+    {
+        auto* pSimpleLayer = dynamic_cast<SimpleLayer*>(layer.get());
+        if (pSimpleLayer && !pSimpleLayer->m_tileSummaries.empty())
+            pSimpleLayer->updateMinMax();
+    }
+
+    this->writeDeferred();
+
+    if (flushFile && m_pH5file)
+        m_pH5file->flush(H5F_SCOPE_GLOBAL);
+}
+
+//! Determine if a batch of writes is in progress.
+/*!
+\return
+    \e true if beginBatch() was called more times than commit().
+    \e false otherwise.
+*/
+bool Dataset::isInBatch() const noexcept
+{
+    return m_batchDepth > 0;
+}
+
+//! Determine if the layers count and time their reads and writes.
+/*!
+\return
+    \e true if I/O statistics are collected; see getIoStats().
+    \e false if they are not (the default).
+*/
+bool Dataset::isCollectingIoStats() const noexcept
+{
+    return m_collectIoStats;
+}
+
+//! Set whether the layers count and time their reads and writes.
+/*!
+    When not collecting, the only cost to a read or write is checking this
+    setting.  The counters collected so far are kept when collecting stops.
+
+\param collect
+    \e true to collect I/O statistics.
+    \e false to stop collecting them.
+*/
+void Dataset::setCollectIoStats(
+    bool collect) noexcept
+{
+    m_collectIoStats = collect;
+}
+
+//! Retrieve the I/O statistics of this dataset.
+/*!
+    Only layers that have been opened are included.  The HDF5 cache
+    statistics are kept by HDF5 whether or not the layers collect theirs.
+
+\return
+    The I/O counters of each layer, their total, and those of the HDF5
+    metadata cache and page buffer.
+*/
+DatasetIoStats Dataset::getIoStats() const
+{
+    const auto lock = this->lockReads();
+
+    DatasetIoStats stats;
+    stats.layers.reserve(m_layers.size());
+
+    for (const auto& pLayer : m_layers)
+    {
+        if (!pLayer)
+            continue;
+
+        const auto& descriptor = *pLayer->m_pLayerDescriptor;
+        stats.layers.push_back({descriptor.getLayerType(),
+            descriptor.getName(), pLayer->m_ioStats});
+        stats.total += pLayer->m_ioStats;
+    }
+
+    if (H5Fget_mdc_hit_rate(m_pH5file->getId(),
+        &stats.metadataCacheHitRate) < 0)
+        stats.metadataCacheHitRate = 0.;
+
+#if H5_VERSION_GE(1, 10, 1)
+    // HDF5 may have opened the file without the page buffer asked for.
+    if (m_openOptions.pageBufferSize > 0)
+    {
+        std::array<unsigned int, 2> accesses{}, hits{}, misses{}, evictions{},
+            bypasses{};
+        herr_t status = -1;
+
+        H5E_BEGIN_TRY {
+            status = H5Fget_page_buffering_stats(m_pH5file->getId(),
+                accesses.data(), hits.data(), misses.data(), evictions.data(),
+                bypasses.data());
+        } H5E_END_TRY;
+
+        if (status >= 0)
+        {
+            stats.pageBufferHits = static_cast<uint64_t>(hits[0]) + hits[1];
+            stats.pageBufferMisses = static_cast<uint64_t>(misses[0]) +
+                misses[1];
+        }
+    }
+#endif
+
+    return stats;
+}
+
+//! Reset the I/O statistics of this dataset to zero.
+/*!
+    Resets the counters of every opened layer, and the HDF5 cache
+    statistics.
+*/
+void Dataset::resetIoStats()
+{
+    const auto lock = this->lockReads();
+
+    for (const auto& pLayer : m_layers)
+        if (pLayer)
+            pLayer->m_ioStats = {};
+
+    H5Freset_mdc_hit_rate_stats(m_pH5file->getId());
+
+#if H5_VERSION_GE(1, 10, 1)
+    if (m_openOptions.pageBufferSize > 0)
+    {
+        H5E_BEGIN_TRY {
+            H5Freset_page_buffering_stats(m_pH5file->getId());
+        } H5E_END_TRY;
+    }
+#endif
+}
+
+//! Start recording the reads and writes of the layers to a file.
+/*!
+    Each read and write of a window of a layer is recorded, with when it
+    began and how long it took, in a compact binary log, which
+    loadAccessTrace() reads back and replayAccessTrace() and
+    recommendLayout() analyze.  A trace already being recorded is stopped
+    first.
+
+    When not tracing, the only cost to a read or write is checking for a
+    tracer.  An AccessTraceWriteFailed exception is thrown if the log cannot
+    be created.
+
+\param fileName
+    The log to write; it is replaced if it exists.
+*/
+void Dataset::startAccessTrace(
+    const std::string& fileName)
+{
+    this->stopAccessTrace();
+
+    std::atomic_store(&m_pAccessTracer,
+        std::make_shared<AccessTracer>(fileName));
+}
+
+//! Stop recording the reads and writes of the layers, and finish the log.
+/*!
+    Reads and writes still in progress on other threads are recorded when
+    they end.  An AccessTraceWriteFailed exception is thrown if any of the
+    trace could not be written.
+*/
+void Dataset::stopAccessTrace()
+{
+    const auto pTracer = std::atomic_exchange(&m_pAccessTracer,
+        std::shared_ptr<AccessTracer>{});
+    if (pTracer)
+        pTracer->flush();
+}
+
+//! Determine if the reads and writes of the layers are being traced.
+/*!
+\return
+    \e true if startAccessTrace() was called, and stopAccessTrace() not since.
+    \e false otherwise.
+*/
+bool Dataset::isTracingAccess() const noexcept
+{
+    return static_cast<bool>(std::atomic_load(&m_pAccessTracer));
+}
+
+
+//! Retrieve an estimate of the memory held by this dataset.
+/*!
+\return
+    The memory held by each part of the dataset, in bytes.
+*/
+DatasetMemoryUsage Dataset::getMemoryUsage() const
+{
+    const auto lock = this->lockReads();
+
+    DatasetMemoryUsage usage;
+
+    if (m_pMetadata)
+        usage.metadata = m_pMetadata->getXMLlength();
+
+    if (m_pTrackingList)
+    {
+        usage.trackingList = m_pTrackingList->size() *
+            sizeof(TrackingList::value_type);
+        usage.trackingListIndexes = m_pTrackingList->getCacheBytes();
+    }
+
+    if (m_pVRTrackingList)
+    {
+        usage.vrTrackingList = m_pVRTrackingList->size() *
+            sizeof(VRTrackingList::value_type);
+        usage.vrTrackingListIndexes = m_pVRTrackingList->getCacheBytes();
+    }
+
+    if (!m_pH5file)
+        return usage;
+
+    // The layers without a chunk cache of their own use the file's.
+    int numMetadataElements = 0;
+    size_t numSlots = 0, fileChunkCacheBytes = 0;
+    double preemption = 0.0;
+    m_pH5file->getAccessPlist().getCache(numMetadataElements, numSlots,
+        fileChunkCacheBytes, preemption);
+
+    for (const auto& pLayer : m_layers)
+    {
+        if (!pLayer)
+            continue;
+
+        if (const auto* pCorrections =
+            dynamic_cast<const SurfaceCorrections*>(pLayer.get()))
+            usage.correctors += pCorrections->getCacheBytes();
+        else if (const auto* pVRMetadata =
+            dynamic_cast<const VRMetadata*>(pLayer.get()))
+            usage.vrMetadataTable += pVRMetadata->getCacheBytes();
+        else if (const auto* pGeorefMetadata =
+            dynamic_cast<const GeorefMetadataLayer*>(pLayer.get()))
+            usage.valueTables += pGeorefMetadata->m_pValueTable ?
+                pGeorefMetadata->m_pValueTable->getMemoryUsage() : 0;
+
+        const auto& descriptor = *pLayer->m_pLayerDescriptor;
+        if (descriptor.getChunkSize() == 0)
+            continue;
+
+        const auto& layerCaches = m_openOptions.layerChunkCaches;
+        const auto found = layerCaches.find(descriptor.getLayerType());
+        usage.chunkCaches += (found != cend(layerCaches) &&
+            found->second.size > 0) ? found->second.size : fileChunkCacheBytes;
+    }
+
+    size_t maxSize = 0, minClean = 0, curSize = 0;
+    int numEntries = 0;
+    if (H5Fget_mdc_size(m_pH5file->getId(), &maxSize, &minClean, &curSize,
+        &numEntries) >= 0)
+        usage.metadataCache = curSize;
+
+    return usage;
+}
+
+//! Release the caches this dataset rebuilds from the file when next needed.
+/*!
+    Releases the parts counted by DatasetMemoryUsage::getReleasable().
+*/
+void Dataset::releaseCaches() const
+{
+    const auto lock = this->lockReads();
+
+    m_releaseCachesRequested = false;
+    this->releaseCachesLocked();
+    this->reportCacheUsage();
+}
+
+//! Retrieve the memory held by the caches this dataset can release.
+/*!
+\return
+    The memory held, in bytes.
+*/
+uint64_t Dataset::getReleasableBytes() const noexcept
+{
+    uint64_t bytes = 0;
+
+    for (const auto& pLayer : m_layers)
+    {
+        if (const auto* pCorrections =
+            dynamic_cast<const SurfaceCorrections*>(pLayer.get()))
+            bytes += pCorrections->getCacheBytes();
+        else if (const auto* pVRMetadata =
+            dynamic_cast<const VRMetadata*>(pLayer.get()))
+            bytes += pVRMetadata->getCacheBytes();
+    }
+
+    if (m_pTrackingList)
+        bytes += m_pTrackingList->getCacheBytes();
+
+    if (m_pVRTrackingList)
+        bytes += m_pVRTrackingList->getCacheBytes();
+
+    return bytes;
+}
+
+//! Release the caches this dataset can release.
+/*!
+    The caller must hold the lock from lockReads().
+*/
+void Dataset::releaseCachesLocked() const noexcept
+{
+    for (const auto& pLayer : m_layers)
+    {
+        if (const auto* pCorrections =
+            dynamic_cast<const SurfaceCorrections*>(pLayer.get()))
+            pCorrections->releaseCaches();
+        else if (const auto* pVRMetadata =
+            dynamic_cast<const VRMetadata*>(pLayer.get()))
+            pVRMetadata->releaseCaches();
     }
 
-    return pDataset;
+    if (m_pTrackingList)
+        m_pTrackingList->releaseCaches();
+
+    if (m_pVRTrackingList)
+        m_pVRTrackingList->releaseCaches();
 }
 
-//! Create a BAG.
+//! Release the caches of this dataset for the MemoryBudget.
 /*!
-\param fileName
-    The name of the BAG.
-\param metadata
-    The metadata describing the BAG.
-    This parameter will be moved, and not usable after.
-\param chunkSize
-    The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+    Called by the budget, with its mutex held.  The caches are released now
+    if no other thread can be using them; otherwise they are released when
+    this dataset next uses one.
 
 \return
-    The BAG Dataset.
+    The memory the caches still hold, in bytes.
 */
-std::shared_ptr<Dataset> Dataset::create(
-    const std::string& fileName,
-    Metadata&& metadata,
-    uint64_t chunkSize,
-    int compressionLevel)
+uint64_t Dataset::releaseCachesForBudget() const noexcept
 {
-    std::shared_ptr<Dataset> pDataset{new Dataset};
-    pDataset->createDataset(fileName, std::move(metadata), chunkSize,
-        compressionLevel);
+    if (m_openOptions.concurrentReads || m_concurrentWrites)
+    {
+        std::unique_lock<std::recursive_mutex> lock{m_h5Mutex,
+            std::try_to_lock};
+        if (lock.owns_lock())
+        {
+            m_releaseCachesRequested = false;
+            this->releaseCachesLocked();
 
-    return pDataset;
+            return this->getReleasableBytes();
+        }
+    }
+
+    m_releaseCachesRequested = true;
+
+    return 0;
 }
 
-//! Close a BAG dataset. Closes the underlying HDF5 file.
-void Dataset::close() {
-    if (m_pH5file) {
-        m_pH5file->close();
-        m_pH5file.reset(nullptr);
-    }
+//! Release the caches if the MemoryBudget asked for it.
+/*!
+    Called before a cache is used, with the lock from lockReads() held.
+*/
+void Dataset::releaseRequestedCaches() const
+{
+    if (!m_releaseCachesRequested.exchange(false))
+        return;
+
+    this->releaseCachesLocked();
+    this->reportCacheUsage();
+}
+
+//! Report the memory held by the caches to the MemoryBudget.
+/*!
+    Called after a cache is built, with the lock from lockReads() held.
+*/
+void Dataset::reportCacheUsage() const
+{
+    MemoryBudget::global().update(*this, this->getReleasableBytes());
 }
 
 
@@ -333,15 +1624,39 @@ Layer& Dataset::addLayer(
     const auto& layer = m_layers.back();
 
     m_descriptor.addLayerDescriptor(*layer->getDescriptor());
+    this->indexLayer(*layer->getDescriptor());
 
     return *layer;
 }
 
+//! Add a layer to this dataset, that will be opened when first accessed.
+/*!
+\param pDescriptor
+    The descriptor of the layer.
+\param openLayer
+    Opens the layer.
+*/
+void Dataset::addLazyLayer(
+    std::shared_ptr<LayerDescriptor> pDescriptor,
+    std::function<std::shared_ptr<Layer>()> openLayer) &
+{
+    m_descriptor.addLayerDescriptor(*pDescriptor);
+    this->indexLayer(*pDescriptor);
+
+    const auto id = this->getNextId();
+    m_layers.push_back(nullptr);
+    m_lazyLayers.emplace(id, LazyLayer{std::move(pDescriptor),
+        std::move(openLayer)});
+}
+
 //! Create a georeferenced metadata layer.
 /*!
 \param keyType
     The type of key the georeferenced metadata layer will use.
     Valid values are: DT_UINT8, DT_UINT16, DT_UINT32 or DT_UINT64
+    GeorefMetadataLayer::setKeyType() changes it later, and
+    GeorefMetadataLayer::narrowKeyType() picks the narrowest once the
+    records/values are added.
 \param name
     The name of the simple layer this georeferenced metadata layer has metadata for.
 \param definition
@@ -361,6 +1676,35 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
             const RecordDefinition& definition,
             uint64_t chunkSize,
             int compressionLevel) &
+{
+    return this->createGeorefMetadataLayer(keyType, profile, name, definition,
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel);
+}
+
+//! Create a georeferenced metadata layer, with chunks of a shape other than square.
+/*!
+\param keyType
+    The type of key the georeferenced metadata layer will use.
+    Valid values are: DT_UINT8, DT_UINT16, DT_UINT32 or DT_UINT64
+\param name
+    The name of the simple layer this georeferenced metadata layer has metadata for.
+\param definition
+    The list of fields defining a record of the georeferenced metadata layer.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet of the keys will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+
+\return
+    The new georeferenced metadata layer.
+*/
+GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
+            DataType keyType,
+            GeorefMetadataProfile profile,
+            const std::string& name,
+            const RecordDefinition& definition,
+            const ChunkShape& chunkShape,
+            const CompressionSpec& compression) &
 {
     if (m_descriptor.isReadOnly())
         throw ReadOnlyError{};
@@ -372,9 +1716,14 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
         });
 
     // Make sure a corresponding simple layer exists.
-    const bool simpleLayerExists = std::any_of(cbegin(m_layers), cend(m_layers),
-        [&nameLower](const std::shared_ptr<Layer>& layer) {
-            auto pDescriptor = layer->getDescriptor();
+    const auto& layerDescriptors = m_descriptor.getLayerDescriptors();
+    const bool simpleLayerExists = std::any_of(cbegin(layerDescriptors),
+        cend(layerDescriptors),
+        [&nameLower](const std::weak_ptr<const LayerDescriptor>& descriptor) {
+            if (descriptor.expired())
+                return false;
+
+            auto pDescriptor = descriptor.lock();
 
             const auto layerType = pDescriptor->getLayerType();
 
@@ -406,7 +1755,7 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
         H5Gclose(id);
 
     return dynamic_cast<GeorefMetadataLayer&>(this->addLayer(GeorefMetadataLayer::create(
-        keyType, name, profile, *this, definition, chunkSize, compressionLevel)));
+        keyType, name, profile, *this, definition, chunkShape, compression)));
 }
 
 //! Convenience method for creating a georeferenced metadata layer with a known metadata profile.
@@ -437,6 +1786,40 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
         uint64_t chunkSize,
         int compressionLevel,
         DataType keyType) &
+{
+    return this->createGeorefMetadataLayer(profile, name,
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel,
+        keyType);
+}
+
+//! Convenience method for creating a georeferenced metadata layer with a known metadata profile,
+//! with chunks of a shape other than square.
+/*!
+\param profile
+    The metadata profile to assign to the georeferenced metadata layer.
+\param name
+    The name of the simple layer this georeferenced metadata layer has metadata for.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet of the keys will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param keyType
+    The type of key the georeferenced metadata layer will use.
+    Valid values are: DT_UINT8, DT_UINT16, DT_UINT32 or DT_UINT64
+    Default value: DT_UINT16
+
+\return
+    The new georeferenced metadata layer.
+
+\throws
+    UknownMetadataProfile if profile is not a known metadata profile
+*/
+GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
+        GeorefMetadataProfile profile,
+        const std::string& name,
+        const ChunkShape& chunkShape,
+        const CompressionSpec& compression,
+        DataType keyType) &
 {
     BAG::RecordDefinition definition = METADATA_DEFINITION_UNKNOWN;
 
@@ -447,7 +1830,7 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
     }
 
     return createGeorefMetadataLayer(keyType, profile,
-                                     name, definition, chunkSize, compressionLevel);
+                                     name, definition, chunkShape, compression);
 }
 
 //! Create a new Dataset.
@@ -456,23 +1839,60 @@ GeorefMetadataLayer& Dataset::createGeorefMetadataLayer(
     The name of the new BAG.
 \param metadata
     The metadata to be used by the BAG.
-\param chunkSize
-    The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSets will use.
+\param compression
+    The compression the HDF5 DataSets will use.
+\param profile
+    How the file is laid out.
+\param inMemory
+    Hold the BAG in memory with the HDF5 core driver.
+\param persist
+    Write a BAG held in memory to fileName when it is closed.
 */
 void Dataset::createDataset(
     const std::string& fileName,
     Metadata&& metadata,
-    uint64_t chunkSize,
-    int compressionLevel)
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    CreationProfile profile,
+    bool inMemory,
+    bool persist)
 {
 #ifdef NDEBUG
     ::H5::Exception::dontPrint();
 #endif
 
+    m_creationProfile = profile;
+
+    ::H5::FileCreatPropList h5createProps{};
+    ::H5::FileAccPropList h5accessProps{};
+    if (inMemory)
+        h5accessProps.setCore(kCoreIncrement, persist);
+#ifdef BAG_USE_MPI
+    if (m_communicator != MPI_COMM_NULL)
+        setParallelAccess(m_communicator, h5accessProps);
+#endif
+
+    if (profile == CreationProfile::CloudOptimized)
+    {
+        // Allocate the file in pages; metadata and raw data never share one.
+        // The free space is not tracked, as the BAG is written once.
+        if (H5Pset_file_space_strategy(h5createProps.getId(),
+                H5F_FSPACE_STRATEGY_PAGE, false, 1) < 0 ||
+            H5Pset_file_space_page_size(h5createProps.getId(),
+                kCloudOptimizedPageSize) < 0)
+            throw ::H5::FileIException{"Dataset::createDataset",
+                "paged file space could not be set"};
+
+        // The 1.10 file format indexes the chunks of a fixed size DataSet
+        // with one fixed array, rather than a B-tree of many small nodes.
+        h5accessProps.setLibverBounds(H5F_LIBVER_V110, H5F_LIBVER_LATEST);
+    }
+
     m_pH5file = std::unique_ptr<::H5::H5File, DeleteH5File>(new ::H5::H5File{
-        fileName.c_str(), H5F_ACC_EXCL}, DeleteH5File{});
+        fileName.c_str(), H5F_ACC_EXCL, h5createProps, h5accessProps},
+        DeleteH5File{});
 
     // Group: BAG_root
     {
@@ -497,16 +1917,16 @@ void Dataset::createDataset(
 
     // TrackingList
     m_pTrackingList = std::unique_ptr<TrackingList>(new TrackingList{*this,
-        compressionLevel});
+        compression});
 
     // Mandatory Layers
     // Elevation
-    this->addLayer(SimpleLayer::create(*this, Elevation, chunkSize,
-        compressionLevel));
+    this->addLayer(SimpleLayer::create(*this, Elevation, chunkShape,
+        compression, {}));
 
     // Uncertainty
-    this->addLayer(SimpleLayer::create(*this, Uncertainty, chunkSize,
-        compressionLevel));
+    this->addLayer(SimpleLayer::create(*this, Uncertainty, chunkShape,
+        compression, {}));
 }
 
 //! Create an optional simple layer.
@@ -526,12 +1946,39 @@ Layer& Dataset::createSimpleLayer(
     LayerType type,
     uint64_t chunkSize,
     int compressionLevel) &
+{
+    return this->createSimpleLayer(type,
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel);
+}
+
+//! Create an optional simple layer, with chunks of a shape other than square.
+/*!
+\param type
+    The type of layer to create.
+    The layer cannot currently exist.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param quantization
+    How the values are quantized before they are stored, within an absolute
+    error bound; null values are kept exactly.  The layer must be chunked.
+    The mandatory layers are quantized with SimpleLayer::setQuantization().
+
+\return
+    The new layer.
+*/
+Layer& Dataset::createSimpleLayer(
+    LayerType type,
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    const Quantization& quantization) &
 {
     if (m_descriptor.isReadOnly())
         throw ReadOnlyError{};
 
     // Make sure it doesn't already exist.
-    if (BAG::getLayer(m_layers, type))
+    if (m_descriptor.getLayerDescriptor(type, {}))
         throw LayerExists{};
 
     switch (type)
@@ -545,8 +1992,8 @@ Layer& Dataset::createSimpleLayer(
     case Num_Soundings:  //[[fallthrough]];
     case Average_Elevation:  //[[fallthrough]];
     case Nominal_Elevation:
-        return this->addLayer(SimpleLayer::create(*this, type, chunkSize,
-            compressionLevel));
+        return this->addLayer(SimpleLayer::create(*this, type, chunkShape,
+            compression, quantization));
     case Surface_Correction:  //[[fallthrough]];
     case Georef_Metadata:  //[[fallthrough]];
     default:
@@ -574,6 +2021,31 @@ SurfaceCorrections& Dataset::createSurfaceCorrections(
     uint8_t numCorrectors,
     uint64_t chunkSize,
     int compressionLevel) &
+{
+    return this->createSurfaceCorrections(type, numCorrectors,
+        ChunkShape{ChunkLayout::Tiled, chunkSize, chunkSize}, compressionLevel);
+}
+
+//! Create optional surface corrections layer, with chunks of a shape other than square.
+/*!
+\param type
+    The type of topography.
+    Gridded (BAG_SURFACE_GRID_EXTENTS) or sparse (BAG_SURFACE_IRREGULARLY_SPACED).
+\param numCorrectors
+    The number of correctors to use (1-10).
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+
+\return
+    The new surface corrections layer.
+*/
+SurfaceCorrections& Dataset::createSurfaceCorrections(
+    BAG_SURFACE_CORRECTION_TOPOGRAPHY type,
+    uint8_t numCorrectors,
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression) &
 {
     if (m_descriptor.isReadOnly())
         throw ReadOnlyError{};
@@ -583,21 +2055,33 @@ SurfaceCorrections& Dataset::createSurfaceCorrections(
         throw LayerExists{};
 
     return dynamic_cast<SurfaceCorrections&>(this->addLayer(
-        SurfaceCorrections::create(*this, type, numCorrectors, chunkSize,
-            compressionLevel)));
+        SurfaceCorrections::create(*this, type, numCorrectors, chunkShape,
+            compression)));
 }
 
 //! Create optional variable resolution layers.
 /*!
+    Without a size hint, the refinements, nodes and tracking list start
+    empty and grow with each write.  With one, they are made with room for
+    the numbers expected, in chunks sized for them, so writing them does not
+    extend their HDF5 DataSets write after write; chunkSize then only sets
+    the chunks of the VRMetadata.  The room left unused is trimmed when the
+    BAG is closed.
+
 \param chunkSize
     The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param createNode
+    Whether to create the VRNode layer.
+\param sizeHint
+    The expected sizes of the layers; 0 where unknown.
 */
 void Dataset::createVR(
     uint64_t chunkSize,
-    int compressionLevel,
-    bool createNode)
+    const CompressionSpec& compression,
+    bool createNode,
+    const VRSizeHint& sizeHint)
 {
     if (m_descriptor.isReadOnly())
         throw ReadOnlyError{};
@@ -609,13 +2093,168 @@ void Dataset::createVR(
     //TODO Consider a try/catch to undo partial creation.
 
     m_pVRTrackingList = std::make_unique<VRTrackingList>(
-        *this, compressionLevel);
+        *this, compression);
+    if (sizeHint.numTrackingItems > 0)
+        m_pVRTrackingList->preallocate(
+            static_cast<size_t>(sizeHint.numTrackingItems));
 
-    this->addLayer(VRMetadata::create(*this, chunkSize, compressionLevel));
-    this->addLayer(VRRefinements::create(*this, chunkSize, compressionLevel));
+    const auto numRefinements = sizeHint.numRefinements;
+
+    this->addLayer(VRMetadata::create(*this, chunkSize, compression));
+    this->addLayer(VRRefinements::create(*this, numRefinements > 0 ?
+        getHintedChunkSize(numRefinements, sizeof(VRRefinementsItem)) :
+        chunkSize, compression, numRefinements));
 
     if (createNode)
-        this->addLayer(VRNode::create(*this, chunkSize, compressionLevel));
+        this->addLayer(VRNode::create(*this, numRefinements > 0 ?
+            getHintedChunkSize(numRefinements, sizeof(VRNodeItem)) :
+            chunkSize, compression, numRefinements));
+}
+
+//! Recompute the min/max of the variable resolution layers.
+/*!
+    Writing to a variable resolution layer only ever widens the min/max in
+    its descriptor, so overwriting the items holding an extreme leaves it
+    stale.  This reads the VRMetadata, VRRefinements and VRNode layers a
+    band of chunks at a time, computing the min/max of the chunks of each
+    band in parallel.  The min/max dimensions and resolutions, depths and
+    uncertainties, and hypotheses strengths, numbers of hypotheses and
+    numbers of samples are then set to exactly those of the non null items,
+    and the attributes of each layer are written once.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+    A DatasetRequiresVariableResolution exception is thrown if the BAG has
+    no variable resolution layers.
+*/
+void Dataset::recomputeVRStatistics()
+{
+    if (m_descriptor.isReadOnly())
+        throw ReadOnlyError{};
+
+    const auto pMetadata = this->getVRMetadata();
+    const auto pRefinements = this->getVRRefinements();
+    if (!pMetadata || !pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto pNode = this->getVRNode();
+
+    // The metadata is read a band of whole rows at a time.
+    {
+        std::array<hsize_t, H5S_MAX_RANK> dims{};
+        pMetadata->m_pH5dataSet->getSpace().getSimpleExtentDims(dims.data());
+
+        const auto numColumns = static_cast<uint32_t>(dims[1]);
+        const auto rowStrideBytes = numColumns * sizeof(VRMetadataItem);
+
+        const auto mm = computeVRMinMax<VRMetadataItem>(dims[0] * dims[1],
+            numColumns,
+            [this, &pMetadata, numColumns, rowStrideBytes](uint64_t first,
+                uint64_t count, VRMetadataItem* items) {
+                const auto rowStart = static_cast<uint32_t>(first / numColumns);
+                const auto rowEnd = static_cast<uint32_t>(
+                    (first + count) / numColumns - 1);
+
+                const auto lock = this->lockReads();
+                static_cast<const Layer&>(*pMetadata).readIntoProxy(rowStart,
+                    0, rowEnd, numColumns - 1,
+                    reinterpret_cast<uint8_t*>(items), rowStrideBytes);
+            });
+
+        auto& descriptor = *pMetadata->getDescriptor();
+        descriptor.setMinDimensions(mm.dimX.min, mm.dimY.min);
+        descriptor.setMaxDimensions(mm.dimX.max, mm.dimY.max);
+        descriptor.setMinResolution(mm.resX.min, mm.resY.min);
+        descriptor.setMaxResolution(mm.resX.max, mm.resY.max);
+    }
+
+    const auto readItems = [](const Layer& layer, uint64_t first,
+        uint64_t count, void* items) {
+        layer.readInto(0, static_cast<uint32_t>(first), 0,
+            static_cast<uint32_t>(first + count - 1),
+            static_cast<uint8_t*>(items),
+            count * layer.getDescriptor()->getElementSize());
+    };
+
+    // A contiguous layer has no chunks; split it in units worth a thread.
+    const auto getUnitItems = [](const LayerDescriptor& descriptor) {
+        const auto chunkSize = descriptor.getChunkSize();
+        return chunkSize > 0 ? chunkSize : uint64_t{kMinCellsPerThread};
+    };
+
+    {
+        const auto length = pRefinements->m_length;
+
+        auto& descriptor = *pRefinements->getDescriptor();
+        const auto mm = computeVRMinMax<VRRefinementsItem>(length,
+            getUnitItems(descriptor),
+            [&readItems, &pRefinements](uint64_t first, uint64_t count,
+                VRRefinementsItem* items) {
+                readItems(*pRefinements, first, count, items);
+            });
+
+        descriptor.setMinMaxDepth(mm.depth.min, mm.depth.max);
+        descriptor.setMinMaxUncertainty(mm.uncertainty.min,
+            mm.uncertainty.max);
+    }
+
+    if (pNode)
+    {
+        const auto length = pNode->m_length;
+
+        auto& descriptor = *pNode->getDescriptor();
+        const auto mm = computeVRMinMax<VRNodeItem>(length,
+            getUnitItems(descriptor),
+            [&readItems, &pNode](uint64_t first, uint64_t count,
+                VRNodeItem* items) {
+                readItems(*pNode, first, count, items);
+            });
+
+        descriptor.setMinMaxHypStrength(mm.hypStrength.min,
+            mm.hypStrength.max);
+        descriptor.setMinMaxNumHypotheses(mm.numHypotheses.min,
+            mm.numHypotheses.max);
+        descriptor.setMinMaxNSamples(mm.nSamples.min, mm.nSamples.max);
+    }
+
+    pMetadata->writeAttributes();
+    pRefinements->writeAttributes();
+    if (pNode)
+        pNode->writeAttributes();
+}
+
+//! Pick the overview of a simple layer to read for an output resolution.
+/*!
+\param type
+    The type of simple layer.
+\param resolution
+    The size of an output pixel, in the units of the grid spacing.
+
+\return
+    The coarsest overview whose nodes are no further apart than resolution,
+    to pass to SimpleLayer::readOverview(); 0 for the layer itself.
+*/
+uint32_t Dataset::selectOverviewLevel(
+    LayerType type,
+    double resolution) const
+{
+    const auto pLayer = this->getSimpleLayer(type);
+    if (!pLayer)
+        throw LayerNotFound{};
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = m_descriptor.getGridSpacing();
+
+    const auto spacing = std::max(spacingX, spacingY);
+    if (!(spacing > 0.))
+        return 0;
+
+    const auto numOverviews = pLayer->getNumOverviews();
+
+    uint32_t level = 0;
+    while (level < numOverviews && spacing * (2u << level) <= resolution)
+        ++level;
+
+    return level;
 }
 
 //! Convert a geographic location to grid position.
@@ -632,14 +2271,53 @@ std::tuple<uint32_t, uint32_t> Dataset::geoToGrid(
     double x,
     double y) const noexcept
 {
-    const auto row = static_cast<uint32_t>((x - m_pMetadata->llCornerX()) /
-        m_pMetadata->rowResolution());
-    const auto column = static_cast<uint32_t>((y - m_pMetadata->llCornerY()) /
-        m_pMetadata->columnResolution());
+    // The descriptor holds the corner and resolution of the metadata, which
+    // may not have been parsed yet.
+    const auto& transform = m_descriptor.getGridTransform();
+
+    const auto row = static_cast<uint32_t>((x - transform.originX) /
+        transform.xSpacing);
+    const auto column = static_cast<uint32_t>((y - transform.originY) /
+        transform.ySpacing);
 
     return {row, column};
 }
 
+//! Convert many geographic locations to grid positions.
+/*!
+    Each location is converted as geoToGrid(double, double) does; the loop
+    is simple enough for the compiler to vectorize.
+
+\param xs
+    The X of each location.
+\param ys
+    The Y of each location.
+\param count
+    The number of locations.
+\param rows
+    Filled with the row of each location.
+\param columns
+    Filled with the column of each location.
+*/
+void Dataset::geoToGrid(
+    const double* xs,
+    const double* ys,
+    size_t count,
+    uint32_t* rows,
+    uint32_t* columns) const noexcept
+{
+    // Copies, so the writes to rows and columns cannot alias them.
+    const auto transform = m_descriptor.getGridTransform();
+
+    for (size_t i=0; i<count; ++i)
+    {
+        rows[i] = static_cast<uint32_t>((xs[i] - transform.originX) /
+            transform.xSpacing);
+        columns[i] = static_cast<uint32_t>((ys[i] - transform.originY) /
+            transform.ySpacing);
+    }
+}
+
 //! Retrieve an optional georeferenced metadata layer by name.
 /*!
 \param name
@@ -649,9 +2327,9 @@ std::tuple<uint32_t, uint32_t> Dataset::geoToGrid(
     The specified georeferenced metadata layer, if it exists.  nullptr otherwise
 */
 std::shared_ptr<GeorefMetadataLayer> Dataset::getGeorefMetadataLayer(
-    const std::string& name) & noexcept
+    const std::string& name) &
 {
-    return std::dynamic_pointer_cast<GeorefMetadataLayer>(BAG::getLayer(m_layers, Georef_Metadata, name));
+    return std::dynamic_pointer_cast<GeorefMetadataLayer>(this->findLayer(Georef_Metadata, name));
 }
 
 //! Retrieve an optional georeferenced metadata layer by name.
@@ -662,9 +2340,9 @@ std::shared_ptr<GeorefMetadataLayer> Dataset::getGeorefMetadataLayer(
 \return
  x   The specified georeferenced metadata layer, if it exists.  nullptr otherwise
 */
-std::shared_ptr<const GeorefMetadataLayer> Dataset::getGeorefMetadataLayer(const std::string& name) const & noexcept
+std::shared_ptr<const GeorefMetadataLayer> Dataset::getGeorefMetadataLayer(const std::string& name) const &
 {
-    return std::dynamic_pointer_cast<const GeorefMetadataLayer>(BAG::getLayer(m_layers, Georef_Metadata, name));
+    return std::dynamic_pointer_cast<const GeorefMetadataLayer>(this->findLayer(Georef_Metadata, name));
 }
 
 //! Retrieve all the georeferenced metadata layers.
@@ -672,14 +2350,18 @@ std::shared_ptr<const GeorefMetadataLayer> Dataset::getGeorefMetadataLayer(const
 \return
     All the georeferenced metadata layers.
 */
-std::vector<std::shared_ptr<GeorefMetadataLayer>> Dataset::getGeorefMetadataLayers() & noexcept
+std::vector<std::shared_ptr<GeorefMetadataLayer>> Dataset::getGeorefMetadataLayers() &
 {
     std::vector<std::shared_ptr<GeorefMetadataLayer>> layers;
 
-    for (const auto& layer : m_layers)
-        if (layer->getDescriptor()->getLayerType() == Georef_Metadata) {
-            layers.emplace_back(std::dynamic_pointer_cast<GeorefMetadataLayer>(layer));
+    for (const auto& descriptor : m_descriptor.getLayerDescriptors())
+    {
+        const auto pDescriptor = descriptor.lock();
+        if (pDescriptor && pDescriptor->getLayerType() == Georef_Metadata) {
+            layers.emplace_back(std::dynamic_pointer_cast<GeorefMetadataLayer>(
+                this->getOrOpenLayer(pDescriptor->getId())));
         }
+    }
 
     return layers;
 }
@@ -714,6 +2396,47 @@ const Descriptor& Dataset::getDescriptor() const & noexcept
     return *m_pH5file;
 }
 
+//! Retrieve how the BAG was laid out when it was created.
+/*!
+\return
+    The profile the BAG was created with; CreationProfile::Default if it was
+    opened.
+*/
+CreationProfile Dataset::getCreationProfile() const noexcept
+{
+    return m_creationProfile;
+}
+
+//! Retrieve the HDF5 DataSet access properties to open a layer with.
+/*!
+\param type
+    The type of layer being opened.
+
+\return
+    The access properties, including a layer specific chunk cache if one was
+    requested when opening the BAG.  Otherwise the layer uses the file's
+    chunk cache.
+*/
+::H5::DSetAccPropList Dataset::getH5dataSetAccessPropList(
+    LayerType type) const
+{
+    ::H5::DSetAccPropList h5accessProps{};
+
+    const auto& layerCaches = m_openOptions.layerChunkCaches;
+    const auto found = layerCaches.find(type);
+    if (found == cend(layerCaches))
+        return h5accessProps;
+
+    const auto& cache = found->second;
+    h5accessProps.setChunkCache(
+        cache.slots > 0 ? cache.slots : H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+        cache.size > 0 ? cache.size : H5D_CHUNK_CACHE_NBYTES_DEFAULT,
+        cache.preemption >= 0.0 ? cache.preemption :
+            H5D_CHUNK_CACHE_W0_DEFAULT);
+
+    return h5accessProps;
+}
+
 //! Retrieve a layer by its unique id.
 /*!
     Retrieve a layer by its unique id.  If it is not found, an InvalidLayerId
@@ -730,7 +2453,7 @@ Layer& Dataset::getLayer(uint32_t id) &
     if (id >= m_layers.size())
         throw InvalidLayerId{};
 
-    return *m_layers[id];
+    return *this->getOrOpenLayer(id);
 }
 
 //! Retrieve a layer by its unique id.
@@ -749,7 +2472,7 @@ const Layer& Dataset::getLayer(uint32_t id) const &
     if (id >= m_layers.size())
         throw InvalidLayerId{};
 
-    return *m_layers[id];
+    return *this->getOrOpenLayer(id);
 }
 
 //! Retrieve a layer based on type and case-insensitive name.
@@ -768,7 +2491,7 @@ std::shared_ptr<Layer> Dataset::getLayer(
     LayerType type,
     const std::string& name) &
 {
-    return BAG::getLayer(m_layers, type, name);
+    return this->findLayer(type, name);
 }
 
 //! Retrieve a layer based on type and case-insensitive name.
@@ -783,7 +2506,7 @@ std::shared_ptr<const Layer> Dataset::getLayer(
     LayerType type,
     const std::string& name) const &
 {
-    return std::shared_ptr<const Layer>{BAG::getLayer(m_layers, type, name)};
+    return std::shared_ptr<const Layer>{this->findLayer(type, name)};
 }
 
 //! Retrieve all the layers.
@@ -796,8 +2519,9 @@ std::vector<std::shared_ptr<const Layer>> Dataset::getLayers() const &
     std::vector<std::shared_ptr<const Layer>> layers;
     layers.reserve(m_layers.size());
 
-    for (auto&& layer : m_layers)
-        layers.push_back(std::static_pointer_cast<const Layer>(layer));
+    for (uint32_t id=0; id<m_layers.size(); ++id)
+        layers.push_back(std::static_pointer_cast<const Layer>(
+            this->getOrOpenLayer(id)));
 
     return layers;
 }
@@ -815,9 +2539,13 @@ std::vector<LayerType> Dataset::getLayerTypes() const
 
     bool georefMetadataLayerAdded = false;
 
-    for (auto&& layer : m_layers)
+    for (const auto& descriptor : m_descriptor.getLayerDescriptors())
     {
-        const auto type = layer->getDescriptor()->getLayerType();
+        const auto pDescriptor = descriptor.lock();
+        if (!pDescriptor)
+            continue;
+
+        const auto type = pDescriptor->getLayerType();
         if (type == Georef_Metadata)
         {
             if (georefMetadataLayerAdded)
@@ -832,46 +2560,122 @@ std::vector<LayerType> Dataset::getLayerTypes() const
     return types;
 }
 
-//! Retrieve the metadta.
+//! Find a layer by type and case-insensitive name.
 /*!
+    The layer is opened if it has not been yet.
+
+\param type
+    The type of layer to find.
+\param name
+    The case-insensitive name of the layer to find.
+    This is optional unless looking for a georeferenced metadata layer.
+
 \return
-    The metadata.
+    The found layer.
+    nullptr if not found.
+    An exception is thrown if the layer is found but fails to open.
 */
-const Metadata& Dataset::getMetadata() const & noexcept
+std::shared_ptr<Layer> Dataset::findLayer(
+    LayerType type,
+    const std::string& name) const
 {
-    return *m_pMetadata;
+    if (type == Georef_Metadata)
+    {
+        if (name.empty())
+            throw NameRequired{};
+
+        const auto found = m_georefMetadataLayerIds.find(toLowerCase(name));
+        if (found == cend(m_georefMetadataLayerIds))
+            return {};
+
+        return this->getOrOpenLayer(found->second);
+    }
+
+    if (type >= m_layerIdsByType.size())
+        return {};
+
+    // Only one layer of each of these types exists; a name is rarely given,
+    // and is checked by the descriptor.
+    if (!name.empty())
+    {
+        const auto* pDescriptor = m_descriptor.getLayerDescriptor(type, name);
+        if (!pDescriptor)
+            return {};
+
+        return this->getOrOpenLayer(pDescriptor->getId());
+    }
+
+    const auto idPlusOne = m_layerIdsByType[type];
+    if (idPlusOne == 0)
+        return {};
+
+    return this->getOrOpenLayer(idPlusOne - 1);
+}
+
+//! Index a layer added to this dataset, so findLayer() finds it directly.
+/*!
+\param descriptor
+    The descriptor of the layer.
+*/
+void Dataset::indexLayer(
+    const LayerDescriptor& descriptor)
+{
+    const auto type = descriptor.getLayerType();
+    if (type == Georef_Metadata)
+    {
+        m_georefMetadataLayerIds.emplace(toLowerCase(descriptor.getName()),
+            descriptor.getId());
+        return;
+    }
+
+    if (type < m_layerIdsByType.size() && m_layerIdsByType[type] == 0)
+        m_layerIdsByType[type] = descriptor.getId() + 1;
+}
+
+//! Retrieve a layer by its unique id, opening it if it has not been yet.
+/*!
+\param id
+    The unique id of the layer.
+
+\return
+    The layer specified by the id.
+*/
+std::shared_ptr<Layer> Dataset::getOrOpenLayer(
+    uint32_t id) const
+{
+    const auto lock = this->lockReads();
+
+    auto& pLayer = m_layers.at(id);
+    if (pLayer)
+        return pLayer;
+
+    const auto found = m_lazyLayers.find(id);
+    if (found == end(m_lazyLayers))
+        throw InvalidLayerId{};
+
+    pLayer = found->second.open();
+    m_lazyLayers.erase(found);
+
+    return pLayer;
 }
 
-//! Retrieve the minimum and maximum values of a simple layer.
+//! Retrieve the metadta.
 /*!
-\param type
-    The type of simple layer.
-\param path
-    The optional internal HDF5 path to use.
+    The metadata of a BAG opened with OpenOptions::deferMetadata is parsed
+    the first time it is retrieved.  An ErrorLoadingMetadata exception is
+    thrown if that fails.
 
 \return
-    A tuple of results.
-    The first value in the tuple indicates whether a value was found or not.
-    If the first value is true, the second value is the minimum, and the third value is the maximum.
-    If the first value is false, the second and third values are undefined.
+    The metadata.
 */
-std::tuple<bool, float, float> Dataset::getMinMax(
-    LayerType type,
-    const std::string& path) const
+const Metadata& Dataset::getMetadata() const &
 {
-    try
-    {
-        const auto info = getAttributeInfo(type);
-        const auto& thePath = path.empty() ? info.path : path;
+    const auto lock = this->lockReads();
 
-        return {true,
-            readAttributeFromDataSet<float>(*m_pH5file, thePath, info.minName),
-            readAttributeFromDataSet<float>(*m_pH5file, thePath, info.maxName)};
-    }
-    catch(const UnsupportedSimpleLayerType&)
-    {
-        return {false, 0.f, 0.f};  // No min/max attributes.
-    }
+    if (!m_pMetadata)
+        m_pMetadata = std::make_unique<Metadata>(const_cast<Dataset&>(*this));
+
+    return *m_pMetadata;
 }
 
 //! Retrieve the next unique layer id.
@@ -893,9 +2697,14 @@ uint32_t Dataset::getNextId() const noexcept
     The specified simple l ayer.
     nullptr if the layer does not exist.
 */
-std::shared_ptr<SimpleLayer> Dataset::getSimpleLayer(LayerType type) & noexcept
+std::shared_ptr<SimpleLayer> Dataset::getSimpleLayer(LayerType type) &
 {
-    return std::dynamic_pointer_cast<SimpleLayer>(BAG::getLayer(m_layers, type));
+    // A georeferenced metadata layer is never simple, and finding one
+    // requires a name.
+    if (type == Georef_Metadata)
+        return {};
+
+    return std::dynamic_pointer_cast<SimpleLayer>(this->findLayer(type));
 }
 
 //! Retrieve the specified simple layer.
@@ -907,9 +2716,14 @@ std::shared_ptr<SimpleLayer> Dataset::getSimpleLayer(LayerType type) & noexcept
     The specified simple l ayer.
     nullptr if the layer does not exist.
 */
-std::shared_ptr<const SimpleLayer> Dataset::getSimpleLayer(LayerType type) const & noexcept
+std::shared_ptr<const SimpleLayer> Dataset::getSimpleLayer(LayerType type) const &
 {
-    return std::dynamic_pointer_cast<const SimpleLayer>(BAG::getLayer(m_layers, type));
+    // A georeferenced metadata layer is never simple, and finding one
+    // requires a name.
+    if (type == Georef_Metadata)
+        return {};
+
+    return std::dynamic_pointer_cast<const SimpleLayer>(this->findLayer(type));
 }
 
 //! Retrieve the optional surface corrections layer.
@@ -917,9 +2731,9 @@ std::shared_ptr<const SimpleLayer> Dataset::getSimpleLayer(LayerType type) const
 \return
     The optional surface corrections layer.
 */
-std::shared_ptr<SurfaceCorrections> Dataset::getSurfaceCorrections() & noexcept
+std::shared_ptr<SurfaceCorrections> Dataset::getSurfaceCorrections() &
 {
-    return std::dynamic_pointer_cast<SurfaceCorrections>(BAG::getLayer(m_layers, Surface_Correction));
+    return std::dynamic_pointer_cast<SurfaceCorrections>(this->findLayer(Surface_Correction));
 }
 
 //! Retrieve the optional surface corrections layer.
@@ -927,9 +2741,9 @@ std::shared_ptr<SurfaceCorrections> Dataset::getSurfaceCorrections() & noexcept
 \return
     The optional surface corrections layer.
 */
-std::shared_ptr<const SurfaceCorrections> Dataset::getSurfaceCorrections() const & noexcept
+std::shared_ptr<const SurfaceCorrections> Dataset::getSurfaceCorrections() const &
 {
-    return std::dynamic_pointer_cast<const SurfaceCorrections>(BAG::getLayer(m_layers, Surface_Correction));
+    return std::dynamic_pointer_cast<const SurfaceCorrections>(this->findLayer(Surface_Correction));
 }
 
 //! Retrieve the tracking list.
@@ -957,9 +2771,9 @@ const TrackingList& Dataset::getTrackingList() const & noexcept
 \return
     The optional variable resolution metadata.
 */
-std::shared_ptr<VRMetadata> Dataset::getVRMetadata() & noexcept
+std::shared_ptr<VRMetadata> Dataset::getVRMetadata() &
 {
-    return std::dynamic_pointer_cast<VRMetadata>(BAG::getLayer(m_layers, VarRes_Metadata));
+    return std::dynamic_pointer_cast<VRMetadata>(this->findLayer(VarRes_Metadata));
 }
 
 //! Retrieve the optional variable resolution metadata.
@@ -967,9 +2781,9 @@ std::shared_ptr<VRMetadata> Dataset::getVRMetadata() & noexcept
 \return
     The optional variable resolution metadata.
 */
-std::shared_ptr<const VRMetadata> Dataset::getVRMetadata() const & noexcept
+std::shared_ptr<const VRMetadata> Dataset::getVRMetadata() const &
 {
-    return std::dynamic_pointer_cast<const VRMetadata>(BAG::getLayer(m_layers, VarRes_Metadata));
+    return std::dynamic_pointer_cast<const VRMetadata>(this->findLayer(VarRes_Metadata));
 }
 
 //! Retrieve the optional variable resolution node group.
@@ -977,9 +2791,9 @@ std::shared_ptr<const VRMetadata> Dataset::getVRMetadata() const & noexcept
 \return
     The optional variable resolution node group.
 */
-std::shared_ptr<VRNode> Dataset::getVRNode() & noexcept
+std::shared_ptr<VRNode> Dataset::getVRNode() &
 {
-    return std::dynamic_pointer_cast<VRNode>(BAG::getLayer(m_layers, VarRes_Node));
+    return std::dynamic_pointer_cast<VRNode>(this->findLayer(VarRes_Node));
 }
 
 //! Retrieve the optional variable resolution node group.
@@ -987,9 +2801,9 @@ std::shared_ptr<VRNode> Dataset::getVRNode() & noexcept
 \return
     The optional variable resolution node group.
 */
-std::shared_ptr<const VRNode> Dataset::getVRNode() const & noexcept
+std::shared_ptr<const VRNode> Dataset::getVRNode() const &
 {
-    return std::dynamic_pointer_cast<const VRNode>(BAG::getLayer(m_layers, VarRes_Node));
+    return std::dynamic_pointer_cast<const VRNode>(this->findLayer(VarRes_Node));
 }
 
 //! Retrieve the optional variable resolution refinements.
@@ -997,9 +2811,9 @@ std::shared_ptr<const VRNode> Dataset::getVRNode() const & noexcept
 \return
     The optional variable resolution refinements.
 */
-std::shared_ptr<VRRefinements> Dataset::getVRRefinements() & noexcept
+std::shared_ptr<VRRefinements> Dataset::getVRRefinements() &
 {
-    return std::dynamic_pointer_cast<VRRefinements>(BAG::getLayer(m_layers, VarRes_Refinement));
+    return std::dynamic_pointer_cast<VRRefinements>(this->findLayer(VarRes_Refinement));
 }
 
 //! Retrieve the optional variable resolution refinements.
@@ -1007,9 +2821,9 @@ std::shared_ptr<VRRefinements> Dataset::getVRRefinements() & noexcept
 \return
     The optional variable resolution refinements.
 */
-std::shared_ptr<const VRRefinements> Dataset::getVRRefinements() const & noexcept
+std::shared_ptr<const VRRefinements> Dataset::getVRRefinements() const &
 {
-    return std::dynamic_pointer_cast<const VRRefinements>(BAG::getLayer(m_layers, VarRes_Refinement));
+    return std::dynamic_pointer_cast<const VRRefinements>(this->findLayer(VarRes_Refinement));
 }
 
 //! Retrieve the optional variable resolution tracking list.
@@ -1046,39 +2860,697 @@ std::tuple<double, double> Dataset::gridToGeo(
     uint32_t row,
     uint32_t column) const noexcept
 {
-    const auto x = m_pMetadata->llCornerX() +
-        (row * m_pMetadata->rowResolution());
+    const auto& transform = m_descriptor.getGridTransform();
+
+    const auto x = transform.originX + (row * transform.xSpacing);
 
-    const auto y = m_pMetadata->llCornerY() +
-        (column * m_pMetadata->columnResolution());
+    const auto y = transform.originY + (column * transform.ySpacing);
 
     return {x, y};
 }
 
+//! Convert many grid positions to geographic locations.
+/*!
+    Each position is converted as gridToGeo(uint32_t, uint32_t) does; the
+    loop is simple enough for the compiler to vectorize.
+
+\param rows
+    The row of each position.
+\param columns
+    The column of each position.
+\param count
+    The number of positions.
+\param xs
+    Filled with the X of each position.
+\param ys
+    Filled with the Y of each position.
+*/
+void Dataset::gridToGeo(
+    const uint32_t* rows,
+    const uint32_t* columns,
+    size_t count,
+    double* xs,
+    double* ys) const noexcept
+{
+    // Copies, so the writes to xs and ys cannot alias them.
+    const auto transform = m_descriptor.getGridTransform();
+
+    for (size_t i=0; i<count; ++i)
+    {
+        xs[i] = transform.originX + (rows[i] * transform.xSpacing);
+        ys[i] = transform.originY + (columns[i] * transform.ySpacing);
+    }
+}
+
+//! Acquire the lock that serializes reads when concurrent reads are enabled.
+/*!
+    The lock is recursive, so a read may call other reads while holding it.
+    Reads take it too when concurrent writes are enabled, as they would
+    otherwise call HDF5 while a write does.
+
+\return
+    The held lock if the BAG was opened with OpenOptions::concurrentReads,
+    or setConcurrentWrites() enabled concurrent writes.
+    An empty lock otherwise.
+*/
+std::unique_lock<std::recursive_mutex> Dataset::lockReads() const
+{
+    if (!m_openOptions.concurrentReads && !m_concurrentWrites)
+        return {};
+
+    return std::unique_lock<std::recursive_mutex>{m_h5Mutex};
+}
+
+//! Acquire the lock that serializes the calls to HDF5 of writes when
+//! concurrent writes are enabled.
+/*!
+    It is the lock reads take, so it is recursive too.
+
+\return
+    The held lock if setConcurrentWrites() enabled concurrent writes.
+    An empty lock otherwise.
+*/
+std::unique_lock<std::recursive_mutex> Dataset::lockWrites() const
+{
+    if (!m_concurrentWrites)
+        return {};
+
+    return std::unique_lock<std::recursive_mutex>{m_h5Mutex};
+}
+
+//! Retrieve the tracer recording the accesses of the layers.
+/*!
+\return
+    The tracer.
+    nullptr if the accesses are not traced.
+*/
+std::shared_ptr<AccessTracer> Dataset::getAccessTracer() const noexcept
+{
+    return std::atomic_load(&m_pAccessTracer);
+}
+
+//! Read the same area of several layers in one call.
+/*!
+    Each layer is read straight into its place in the returned buffer when
+    the layout is planar, so no intermediate copies are made.  The layers are
+    read one after the other; HDF5 serializes access to the file even in
+    thread-safe builds, so reading them from multiple threads would not
+    overlap the chunk decoding.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param types
+    The types of the layers to read, in the order they are returned.
+\param layout
+    BAG_LAYOUT_PLANAR to return each layer as a contiguous block, one after
+    the other.
+    BAG_LAYOUT_INTERLEAVED to return the values of all layers for a node
+    next to each other.
+
+\return
+    The values of the requested layers.
+*/
+UInt8Array Dataset::readLayers(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const std::vector<LayerType>& types,
+    LayerLayout layout) const
+{
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    std::vector<std::shared_ptr<Layer>> layers;
+    layers.reserve(types.size());
+
+    size_t recordSize = 0;
+    for (const auto type : types)
+    {
+        auto layer = this->findLayer(type);
+        if (!layer)
+            throw LayerNotFound{};
+
+        recordSize += layer->getDescriptor()->getElementSize();
+        layers.push_back(std::move(layer));
+    }
+
+    const size_t numNodes = static_cast<size_t>((rowEnd - rowStart) + 1) *
+        ((columnEnd - columnStart) + 1);
+    auto result = UInt8Array::uninitialized(numNodes * recordSize);
+
+    if (layout == BAG_LAYOUT_PLANAR)
+    {
+        auto* band = result.data();
+
+        for (const auto& layer : layers)
+        {
+            const auto bandSize = numNodes *
+                layer->getDescriptor()->getElementSize();
+
+            layer->readInto(rowStart, columnStart, rowEnd, columnEnd, band,
+                bandSize);
+            band += bandSize;
+        }
+    }
+    else if (layout == BAG_LAYOUT_INTERLEAVED)
+    {
+        size_t fieldOffset = 0;
+
+        for (const auto& layer : layers)
+        {
+            const auto elementSize = layer->getDescriptor()->getElementSize();
+            const auto band = layer->read(rowStart, columnStart, rowEnd,
+                columnEnd);
+
+            const auto* from = band.data();
+            auto* to = result.data() + fieldOffset;
+
+            for (size_t node=0; node<numNodes; ++node, from += elementSize,
+                to += recordSize)
+                std::memcpy(to, from, elementSize);
+
+            fieldOffset += elementSize;
+        }
+    }
+    else
+        throw InvalidLayerLayout{};
+
+    return result;
+}
+
+//! Read the nodes of several layers inside a geographic box.
+/*!
+    The box is snapped to the grid: every node whose cell (the area within
+    half a grid spacing of it) meets the box is read.  The area read is then
+    clipped to the grid.  Locations map to the grid as in geoToGrid().
+
+    An InvalidReadSize exception is thrown if the box is empty, or does not
+    meet the grid.
+
+\param minX
+    The smallest X of the box.
+\param minY
+    The smallest Y of the box.
+\param maxX
+    The largest X of the box.
+\param maxY
+    The largest Y of the box.
+\param types
+    The types of the layers to read, in the order they are returned.
+\param options
+    The layout of the layers read, and whether to read whole chunks.
+
+\return
+    The area of the grid read, and the values of the requested layers.
+*/
+GeoRead Dataset::readGeo(
+    double minX,
+    double minY,
+    double maxX,
+    double maxY,
+    const std::vector<LayerType>& types,
+    const GeoReadOptions& options) const
+{
+    if (!(minX <= maxX) || !(minY <= maxY))
+        throw InvalidReadSize{};
+
+    const auto& transform = m_descriptor.getGridTransform();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = m_descriptor.getDims();
+
+    // The first and last nodes of an axis whose cells meet [from, to],
+    // clipped to the grid; in either order if the spacing is negative.
+    const auto snap = [](double from, double to, double origin,
+        double spacing, uint32_t numNodes) {
+        auto first = std::floor((from - origin) / spacing + 0.5);
+        auto last = std::floor((to - origin) / spacing + 0.5);
+        if (first > last)
+            std::swap(first, last);
+
+        const auto lastNode = static_cast<double>(numNodes) - 1.;
+        if (numNodes == 0 || !(first <= lastNode) || !(last >= 0.))
+            throw InvalidReadSize{};
+
+        return std::make_tuple(static_cast<uint32_t>(std::max(first, 0.)),
+            static_cast<uint32_t>(std::min(last, lastNode)));
+    };
+
+    GeoRead result;
+    std::tie(result.rowStart, result.rowEnd) = snap(minX, maxX,
+        transform.originX, transform.xSpacing, numRows);
+    std::tie(result.columnStart, result.columnEnd) = snap(minY, maxY,
+        transform.originY, transform.ySpacing, numColumns);
+
+    if (options.wholeChunks && !types.empty())
+    {
+        const auto layer = this->findLayer(types.front());
+        if (!layer)
+            throw LayerNotFound{};
+
+        uint64_t chunkRows = 0, chunkColumns = 0;
+        std::tie(chunkRows, chunkColumns) =
+            layer->getDescriptor()->getChunkDims();
+
+        // An unchunked layer has nothing to align to.
+        if (chunkRows > 0 && chunkColumns > 0)
+        {
+            const auto rowsPerChunk = static_cast<uint32_t>(chunkRows);
+            const auto columnsPerChunk = static_cast<uint32_t>(chunkColumns);
+
+            result.rowStart -= result.rowStart % rowsPerChunk;
+            result.columnStart -= result.columnStart % columnsPerChunk;
+            result.rowEnd = static_cast<uint32_t>(std::min<uint64_t>(
+                (result.rowEnd / chunkRows + 1) * chunkRows - 1,
+                numRows - 1));
+            result.columnEnd = static_cast<uint32_t>(std::min<uint64_t>(
+                (result.columnEnd / chunkColumns + 1) * chunkColumns - 1,
+                numColumns - 1));
+        }
+    }
+
+    result.data = this->readLayers(result.rowStart, result.columnStart,
+        result.rowEnd, result.columnEnd, types, options.layout);
+
+    return result;
+}
+
+//! Load some layers into an immutable snapshot in memory.
+/*!
+    Each layer is read whole, through the same path as Layer::read(), which
+    decompresses the chunks on several threads when the library can apply
+    their filters itself.  HDF5 is not thread safe, so the layers are read
+    one after the other.  The tracking list is always loaded, and the
+    variable resolution tracking list with the variable resolution layers.
+
+    Reads of the BAG are held off while the snapshot is loaded, so it is
+    consistent even if other threads read concurrently.
+
+\param types
+    The layers to load: simple layer types, Georef_Metadata for every
+    georeferenced metadata layer, and VarRes_Metadata, VarRes_Refinement or
+    VarRes_Node for all of the variable resolution layers.  Empty to load
+    every one of those; surface corrections are not loaded.
+
+\return
+    The snapshot.
+*/
+std::shared_ptr<const DatasetSnapshot> Dataset::loadSnapshot(
+    const std::vector<LayerType>& types) const
+{
+    const TraceScope trace{"Dataset::loadSnapshot"};
+
+    auto wanted = types;
+    if (wanted.empty())
+    {
+        wanted = this->getLayerTypes();
+        wanted.erase(std::remove(wanted.begin(), wanted.end(),
+            Surface_Correction), wanted.end());
+    }
+
+    std::sort(wanted.begin(), wanted.end());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+    std::shared_ptr<DatasetSnapshot> pSnapshot{new DatasetSnapshot};
+    auto& snapshot = *pSnapshot;
+
+    std::tie(snapshot.m_numRows, snapshot.m_numColumns) =
+        m_descriptor.getDims();
+    const auto numNodes = static_cast<size_t>(snapshot.m_numRows) *
+        snapshot.m_numColumns;
+
+    const auto lock = this->lockReads();
+
+    bool loadGeoref = false, loadVR = false;
+
+    for (const auto type : wanted)
+    {
+        if (type == Georef_Metadata)
+        {
+            loadGeoref = true;
+            continue;
+        }
+
+        if (type == VarRes_Metadata || type == VarRes_Refinement ||
+            type == VarRes_Node)
+        {
+            loadVR = true;
+            continue;
+        }
+
+        const auto pLayer = this->getSimpleLayer(type);
+        if (!pLayer)
+            throw LayerNotFound{};
+
+        DatasetSnapshot::SimpleLayerData layer;
+        layer.type = type;
+        layer.elementSize = pLayer->getDescriptor()->getElementSize();
+        layer.values = UInt8Array::uninitialized(numNodes * layer.elementSize);
+        layer.pValues = layer.values.data();
+
+        if (numNodes > 0)
+            pLayer->readInto(0, 0, snapshot.m_numRows - 1,
+                snapshot.m_numColumns - 1, layer.values.data(),
+                layer.values.size());
+
+        snapshot.m_layers.push_back(std::move(layer));
+    }
+
+    const auto& trackingList = this->getTrackingList();
+    snapshot.m_trackingItems.assign(trackingList.begin(), trackingList.end());
+    std::stable_sort(snapshot.m_trackingItems.begin(),
+        snapshot.m_trackingItems.end(),
+        [](const TrackingItem& lhs, const TrackingItem& rhs) {
+            return std::make_pair(lhs.row, lhs.col) <
+                std::make_pair(rhs.row, rhs.col);
+        });
+
+    if (loadVR)
+    {
+        const auto pMetadata = this->getVRMetadata();
+        const auto pRefinements = this->getVRRefinements();
+        if (!pMetadata || !pRefinements)
+            throw DatasetRequiresVariableResolution{};
+
+        snapshot.m_pVRMetadata = pMetadata->getTable();
+        snapshot.m_pVRIndex.reset(new VRIndex{*this});
+
+        auto length = pRefinements->m_length;
+        snapshot.m_vrRefinements.resize(static_cast<size_t>(length));
+
+        if (length > 0)
+            pRefinements->readInto(0, 0, 0, static_cast<uint32_t>(length - 1),
+                reinterpret_cast<uint8_t*>(snapshot.m_vrRefinements.data()),
+                snapshot.m_vrRefinements.size() * sizeof(VRRefinementsItem));
+
+        const auto pNode = this->getVRNode();
+        if (pNode)
+        {
+            length = pNode->m_length;
+            snapshot.m_vrNodes.resize(static_cast<size_t>(length));
+
+            if (length > 0)
+                pNode->readInto(0, 0, 0, static_cast<uint32_t>(length - 1),
+                    reinterpret_cast<uint8_t*>(snapshot.m_vrNodes.data()),
+                    snapshot.m_vrNodes.size() * sizeof(VRNodeItem));
+        }
+
+        const auto pTrackingList = this->getVRTrackingList();
+        if (pTrackingList)
+            snapshot.m_pVRTrackingTable = pTrackingList->getTable();
+    }
+
+    if (loadGeoref)
+    {
+        for (const auto& descriptor : m_descriptor.getLayerDescriptors())
+        {
+            const auto pDescriptor = descriptor.lock();
+            if (!pDescriptor || pDescriptor->getLayerType() != Georef_Metadata)
+                continue;
+
+            const auto pLayer = this->getGeorefMetadataLayer(
+                pDescriptor->getName());
+            if (!pLayer)
+                throw LayerNotFound{};
+
+            DatasetSnapshot::GeorefLayerData layer;
+            layer.name = pDescriptor->getName();
+            layer.keySize = pDescriptor->getElementSize();
+            layer.keys = UInt8Array::uninitialized(numNodes * layer.keySize);
+
+            if (numNodes > 0)
+                pLayer->readInto(0, 0, snapshot.m_numRows - 1,
+                    snapshot.m_numColumns - 1, layer.keys.data(),
+                    layer.keys.size());
+
+            if (pLayer->hasVRKeys())
+            {
+                hsize_t length = 0;
+                pLayer->m_pH5vrKeyDataSet->getSpace().getSimpleExtentDims(
+                    &length);
+
+                layer.hasVRKeys = true;
+                layer.numVRKeys = static_cast<size_t>(length);
+                layer.vrKeys = UInt8Array::uninitialized(
+                    layer.numVRKeys * layer.keySize);
+
+                if (length > 0)
+                    pLayer->readVRInto(0, static_cast<uint32_t>(length - 1),
+                        layer.vrKeys.data(), layer.vrKeys.size());
+            }
+
+            const auto& valueTable = pLayer->getValueTable();
+            layer.numRecords = valueTable.getNumRecords();
+            layer.columns = valueTable.exportColumns();
+
+            snapshot.m_georefLayers.push_back(std::move(layer));
+        }
+    }
+
+    return pSnapshot;
+}
+
+//! Verify that every chunk of every DataSet of the BAG reads back intact.
+/*!
+    Every DataSet is read whole, a chunk at a time; a DataSet stored without
+    chunks is read in bands of rows, each treated as a chunk.  The chunks
+    are read by HDF5 as stored, then decompressed, their Fletcher32
+    checksums verified and their values checked on several threads.  Chunks
+    filtered other than by byte shuffling, deflate and a checksum are
+    decoded by HDF5 as they are read.
+
+    The values of the simple and interleaved layers, and of the variable
+    resolution refinements and nodes, must be null or within the minimum and
+    maximum of their descriptors; the keys of the georeferenced metadata
+    layers must have records in their value tables, and the refinements of
+    the variable resolution cells must be within the VRRefinements layer.
+
+    Reads of the BAG are held off while each batch of chunks is read, but
+    not while they are checked.
+
+\param options
+    What is checked.
+
+\return
+    What was found wrong, by chunk.
+*/
+VerifyReport Dataset::verify(
+    const VerifyOptions& options) const
+{
+    const TraceScope trace{"Dataset::verify"};
+
+    return DatasetVerifier{*this, options}.verify();
+}
+
+//! Hash every chunk of every HDF5 DataSet of the BAG.
+/*!
+    Replicating a BAG then only needs the chunks whose hashes changed; see
+    diffChunkHashes().  Each chunk is hashed as stored, compressed, so it can
+    be copied as is; the chunks are read a batch at a time and hashed on
+    several threads.  A chunk never written is not hashed, as it reads as
+    the fill value.  DataSets that are not chunked, or hold variable length
+    strings, have their elements read through HDF5 and hashed instead, in
+    bands of rows for the former.  So does every DataSet with HDF5 older
+    than 1.10.5.
+
+    A ReadOnlyError exception is thrown if the hashes are to be kept and the
+    BAG is read only.
+
+\param options
+    Whether to keep the hashes in the BAG, and the progress of the hashing.
+
+\return
+    The hashes, by DataSet, then by chunk.
+*/
+std::vector<ChunkHash> Dataset::hashChunks(
+    const ChunkHashOptions& options)
+{
+    const TraceScope trace{"Dataset::hashChunks"};
+
+    if (options.persist && m_descriptor.isReadOnly())
+        throw ReadOnlyError{};
+
+    auto hashes = ChunkHasher{*this, options.progress}.hash();
+
+    if (options.persist)
+    {
+        const auto lock = this->lockWrites();
+        writeChunkHashes(*m_pH5file, hashes);
+    }
+
+    return hashes;
+}
+
+//! Read the hashes of the chunks kept in the BAG by hashChunks().
+/*!
+    They are as of when they were kept; writes since do not update them.
+
+\return
+    The hashes; empty if none were kept.
+*/
+std::vector<ChunkHash> Dataset::readChunkHashes() const
+{
+    const auto lock = this->lockReads();
+
+    return BAG::readChunkHashes(*m_pH5file);
+}
+
 //! Read an existing BAG.
 /*!
 \param fileName
     The name of the BAG.
 \param openMode
     The mode to open the BAG with.
+\param options
+    The options, such as the chunk cache, to open the BAG with.
+\param image
+    An image of the BAG file to open with the HDF5 core driver, which copies
+    it; nullptr to open fileName.
+\param imageSize
+    The number of bytes in image.
 */
 void Dataset::readDataset(
     const std::string& fileName,
-    OpenMode openMode)
+    OpenMode openMode,
+    const OpenOptions& options,
+    const uint8_t* image,
+    size_t imageSize)
 {
-    m_pH5file = std::unique_ptr<::H5::H5File, DeleteH5File>(new ::H5::H5File{
-        fileName.c_str(),
-        (openMode == BAG_OPEN_READONLY) ? H5F_ACC_RDONLY : H5F_ACC_RDWR},
-        DeleteH5File{});
+    const TraceScope trace{"Dataset::readDataset"};
 
-    m_pMetadata = std::make_unique<Metadata>(*this);
+    if (options.concurrentReads && openMode != BAG_OPEN_READONLY)
+        throw ConcurrentReadsRequireReadOnly{};
 
-    m_descriptor = Descriptor{*m_pMetadata};
+    m_openOptions = options;
+    m_collectIoStats = options.collectIoStats;
+
+#ifdef BAG_USE_MPI
+    // The MPI-IO driver reads a local file, without a page buffer.
+    m_communicator = options.communicator;
+    if (m_communicator != MPI_COMM_NULL && (image || options.concurrentReads ||
+        options.pageBufferSize > 0 || isRemoteFileName(fileName)))
+        throw InvalidParallelOpen{};
+#endif
+
+    // Size the raw data chunk cache, keeping the HDF5 defaults for anything
+    // not specified.
+    ::H5::FileAccPropList h5accessProps{};
+    {
+        int numMetadataElements = 0;
+        size_t numSlots = 0, numBytes = 0;
+        double preemption = 0.0;
+        h5accessProps.getCache(numMetadataElements, numSlots, numBytes,
+            preemption);
+
+        const auto& cache = options.chunkCache;
+        h5accessProps.setCache(numMetadataElements,
+            cache.slots > 0 ? cache.slots : numSlots,
+            cache.size > 0 ? cache.size : numBytes,
+            cache.preemption >= 0.0 ? cache.preemption : preemption);
+    }
+
+#ifdef BAG_USE_MPI
+    if (m_communicator != MPI_COMM_NULL)
+        setParallelAccess(m_communicator, h5accessProps);
+#endif
+
+    // A BAG named by a URL is read with ranged requests.
+    auto h5fileName = fileName;
+    if (isRemoteFileName(fileName))
+    {
+        if (openMode != BAG_OPEN_READONLY)
+            throw RemoteReadsRequireReadOnly{};
+
+        h5fileName = setRemoteAccess(fileName, options.remote, h5accessProps);
+    }
+    else if (image)
+    {
+        h5accessProps.setCore(kCoreIncrement, false);
+
+        // The image is copied, so it is not modified.
+        if (H5Pset_file_image(h5accessProps.getId(),
+            const_cast<uint8_t*>(image), imageSize) < 0)
+            throw ::H5::FileIException{"Dataset::readDataset",
+                "H5Pset_file_image failed"};
+    }
+
+    const auto openH5file = [&]() {
+        const TraceScope openTrace{"Dataset::readDataset/openFile"};
+
+        m_pH5file = std::unique_ptr<::H5::H5File, DeleteH5File>(
+            new ::H5::H5File{h5fileName.c_str(),
+                (openMode == BAG_OPEN_READONLY) ? H5F_ACC_RDONLY : H5F_ACC_RDWR,
+                ::H5::FileCreatPropList::DEFAULT, h5accessProps},
+            DeleteH5File{});
+    };
+
+    if (options.pageBufferSize > 0)
+    {
+        if (H5Pset_page_buffer_size(h5accessProps.getId(),
+            options.pageBufferSize, 0, 0) < 0)
+            throw ::H5::FileIException{"Dataset::readDataset",
+                "H5Pset_page_buffer_size failed"};
+
+        // HDF5 refuses a page buffer for a file without paged file space.
+        try
+        {
+            openH5file();
+        }
+        catch (const ::H5::FileIException&)
+        {
+            H5Pset_page_buffer_size(h5accessProps.getId(), 0, 0, 0);
+            openH5file();
+        }
+    }
+    else
+        openH5file();
+
+    {
+        const TraceScope metadataTrace{"Dataset::readDataset/readMetadata"};
+
+        if (options.deferMetadata)
+        {
+            // Only the spatial parts of the XML are read for the descriptor;
+            // the rest is parsed when the metadata is first retrieved.
+            Metadata spatialMetadata;
+            spatialMetadata.loadSpatialFromBuffer(readMetadataXML(*m_pH5file));
+
+            m_descriptor = Descriptor{spatialMetadata};
+        }
+        else
+        {
+            m_pMetadata = std::make_unique<Metadata>(*this);
+
+            m_descriptor = Descriptor{*m_pMetadata};
+        }
+    }
     m_descriptor.setReadOnly(openMode == BAG_OPEN_READONLY);
     m_descriptor.setVersion(readStringAttributeFromGroup(*m_pH5file,
         ROOT_PATH, BAG_VERSION_NAME));
 
+    const TraceScope layersTrace{"Dataset::readDataset/findLayers"};
     const auto bagGroup = m_pH5file->openGroup(ROOT_PATH);
+    const auto bagVersion = getNumericalVersion(m_descriptor.getVersion());
+
+    // The descriptors are complete before any layer is opened.
+    const auto attributes = readDescriptorAttributes(*m_pH5file, bagVersion);
+
+    // Open a discovered layer now, or when it is first accessed.
+    const auto addFoundLayer = [this, &options](
+        std::shared_ptr<LayerDescriptor> pDescriptor,
+        std::function<std::shared_ptr<Layer>()> openLayer) {
+            if (options.lazy)
+                this->addLazyLayer(std::move(pDescriptor), std::move(openLayer));
+            else
+                this->addLayer(openLayer());
+        };
 
     // Look for the simple layers.
     for (auto layerType : {Elevation, Uncertainty, Hypothesis_Strength,
@@ -1089,112 +3561,130 @@ void Dataset::readDataset(
         if (internalPath.empty())
             continue;
 
-        const hid_t id = H5Dopen2(bagGroup.getLocId(), internalPath.c_str(),
-            H5P_DEFAULT);
-        if (id < 0)
+        if (!linkExists(bagGroup, internalPath))
             continue;
 
-        H5Dclose(id);
-
         auto layerDesc = SimpleLayerDescriptor::open(*this, layerType);
-        this->addLayer(SimpleLayer::open(*this, *layerDesc));
-    }
+        if (attributes.hasMinMax[layerType])
+            layerDesc->setMinMax(std::get<0>(attributes.minMax[layerType]),
+                std::get<1>(attributes.minMax[layerType]));
 
-    const auto bagVersion = getNumericalVersion(m_descriptor.getVersion());
+        addFoundLayer(layerDesc, [this, layerDesc] {
+            return SimpleLayer::open(*this, *layerDesc);
+        });
+    }
 
     // If the BAG is version 1.5+ ...
     if (bagVersion >= 1'005'000)
     {
-        hid_t id = H5Dopen2(bagGroup.getLocId(), NODE_GROUP_PATH, H5P_DEFAULT);
-        if (id >= 0)
+        if (linkExists(bagGroup, NODE_GROUP_PATH))
         {
-            H5Dclose(id);
-
-            // Hypothesis_Strength
-            auto layerDesc = InterleavedLegacyLayerDescriptor::open(*this,
-                Hypothesis_Strength, NODE);
-            this->addLayer(InterleavedLegacyLayer::open(*this, *layerDesc));
-
-            // Num_Hypotheses
-            layerDesc = InterleavedLegacyLayerDescriptor::open(*this, Num_Hypotheses,
-                NODE);
-            this->addLayer(InterleavedLegacyLayer::open(*this, *layerDesc));
+            for (auto layerType : {Hypothesis_Strength, Num_Hypotheses})
+            {
+                auto layerDesc = InterleavedLegacyLayerDescriptor::open(*this,
+                    layerType, NODE);
+                if (attributes.hasMinMax[layerType])
+                    layerDesc->setMinMax(
+                        std::get<0>(attributes.minMax[layerType]),
+                        std::get<1>(attributes.minMax[layerType]));
+
+                addFoundLayer(layerDesc, [this, layerDesc] {
+                    return InterleavedLegacyLayer::open(*this, *layerDesc);
+                });
+            }
         }
 
-        id = H5Dopen2(bagGroup.getLocId(), ELEVATION_SOLUTION_GROUP_PATH,
-            H5P_DEFAULT);
-        if (id >= 0)
+        if (linkExists(bagGroup, ELEVATION_SOLUTION_GROUP_PATH))
         {
-            H5Dclose(id);
-
-            // Shoal_Elevation
-            auto layerDesc = InterleavedLegacyLayerDescriptor::open(*this,
-                Shoal_Elevation, ELEVATION);
-
-            this->addLayer(InterleavedLegacyLayer::open(*this, *layerDesc));
-
-            // Std_Dev
-            layerDesc = InterleavedLegacyLayerDescriptor::open(*this, Std_Dev,
-                ELEVATION);
-            this->addLayer(InterleavedLegacyLayer::open(*this, *layerDesc));
-
-            // Num_Soundings
-            layerDesc = InterleavedLegacyLayerDescriptor::open(*this, Num_Soundings,
-                ELEVATION);
-            this->addLayer(InterleavedLegacyLayer::open(*this, *layerDesc));
+            for (auto layerType : {Shoal_Elevation, Std_Dev, Num_Soundings})
+            {
+                auto layerDesc = InterleavedLegacyLayerDescriptor::open(*this,
+                    layerType, ELEVATION);
+                if (attributes.hasMinMax[layerType])
+                    layerDesc->setMinMax(
+                        std::get<0>(attributes.minMax[layerType]),
+                        std::get<1>(attributes.minMax[layerType]));
+
+                addFoundLayer(layerDesc, [this, layerDesc] {
+                    return InterleavedLegacyLayer::open(*this, *layerDesc);
+                });
+            }
         }
     }
 
     // Read optional VR
-    hid_t id = H5Dopen2(bagGroup.getLocId(), VR_TRACKING_LIST_PATH, H5P_DEFAULT);
-    if (id >= 0)
+    if (linkExists(bagGroup, VR_TRACKING_LIST_PATH))
     {
-        H5Dclose(id);
-
         m_pVRTrackingList = std::make_shared<VRTrackingList>(*this);
 
         {
             auto descriptor = VRMetadataDescriptor::open(*this);
-            this->addLayer(VRMetadata::open(*this, *descriptor));
+            descriptor->setMinDimensions(std::get<0>(attributes.vrMinDims),
+                std::get<1>(attributes.vrMinDims));
+            descriptor->setMaxDimensions(std::get<0>(attributes.vrMaxDims),
+                std::get<1>(attributes.vrMaxDims));
+            descriptor->setMinResolution(
+                std::get<0>(attributes.vrMinResolution),
+                std::get<1>(attributes.vrMinResolution));
+            descriptor->setMaxResolution(
+                std::get<0>(attributes.vrMaxResolution),
+                std::get<1>(attributes.vrMaxResolution));
+
+            addFoundLayer(descriptor, [this, descriptor] {
+                return VRMetadata::open(*this, *descriptor);
+            });
         }
 
         {
             auto descriptor = VRRefinementsDescriptor::open(*this);
-            this->addLayer(VRRefinements::open(*this, *descriptor));
+            descriptor->setMinMaxDepth(std::get<0>(attributes.vrMinMaxDepth),
+                std::get<1>(attributes.vrMinMaxDepth));
+            descriptor->setMinMaxUncertainty(
+                std::get<0>(attributes.vrMinMaxUncertainty),
+                std::get<1>(attributes.vrMinMaxUncertainty));
+
+            addFoundLayer(descriptor, [this, descriptor] {
+                return VRRefinements::open(*this, *descriptor);
+            });
         }
 
         // optional VRNodeLayer
-        id = H5Dopen2(bagGroup.getLocId(), VR_NODE_PATH, H5P_DEFAULT);
-        if (id >= 0)
+        if (linkExists(bagGroup, VR_NODE_PATH))
         {
-            H5Dclose(id);
-
             auto descriptor = VRNodeDescriptor::open(*this);
-            this->addLayer(VRNode::open(*this, *descriptor));
+            descriptor->setMinMaxHypStrength(
+                std::get<0>(attributes.vrMinMaxHypStrength),
+                std::get<1>(attributes.vrMinMaxHypStrength));
+            descriptor->setMinMaxNumHypotheses(
+                std::get<0>(attributes.vrMinMaxNumHypotheses),
+                std::get<1>(attributes.vrMinMaxNumHypotheses));
+            descriptor->setMinMaxNSamples(
+                std::get<0>(attributes.vrMinMaxNSamples),
+                std::get<1>(attributes.vrMinMaxNSamples));
+
+            addFoundLayer(descriptor, [this, descriptor] {
+                return VRNode::open(*this, *descriptor);
+            });
         }
     }
 
     m_pTrackingList = std::unique_ptr<TrackingList>(new TrackingList{*this});
 
     // Read optional Surface Corrections
-    id = H5Dopen2(bagGroup.getLocId(), VERT_DATUM_CORR_PATH, H5P_DEFAULT);
-    if (id >= 0)
+    if (linkExists(bagGroup, VERT_DATUM_CORR_PATH))
     {
-        H5Dclose(id);
-
         auto descriptor = SurfaceCorrectionsDescriptor::open(*this);
-        this->addLayer(SurfaceCorrections::open(*this, *descriptor));
+        addFoundLayer(descriptor, [this, descriptor] {
+            return SurfaceCorrections::open(*this, *descriptor);
+        });
     }
 
     // If the BAG is version 2.0+ ...
     if (bagVersion >= 2'000'000)
     {
         // Add all existing GeorefMetadataLayers
-        id = H5Gopen2(bagGroup.getLocId(), GEOREF_METADATA_PATH, H5P_DEFAULT);
-        if (id >= 0)
+        if (linkExists(bagGroup, GEOREF_METADATA_PATH))
         {
-            H5Gclose(id);
-
             // Look for any subgroups of the GEOREF_METADATA_PATH group.
             const auto group = m_pH5file->openGroup(GEOREF_METADATA_PATH);
             const hsize_t numObjects = group.getNumObjs();
@@ -1206,7 +3696,9 @@ void Dataset::readDataset(
                     const auto name = group.getObjnameByIdx(i);
 
                     auto descriptor = GeorefMetadataLayerDescriptor::open(*this, name);
-                    this->addLayer(GeorefMetadataLayer::open(*this, *descriptor));
+                    addFoundLayer(descriptor, [this, descriptor] {
+                        return GeorefMetadataLayer::open(*this, *descriptor);
+                    });
                 }
                 catch(...)
                 {}
@@ -13,8 +13,11 @@
 #include "bag_types.h"
 #include "bag_vrtrackinglist.h"
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -23,6 +26,7 @@
 
 namespace H5 {
 
+class DSetAccPropList;
 class H5File;
 
 }   //namespace H5
@@ -35,6 +39,21 @@ namespace BAG {
 #pragma warning(disable: 4275)  // non-DLL-interface class used as base class
 #endif
 
+//! An area of several layers read by Dataset::readGeo().
+struct GeoRead final
+{
+    //! The first row read.
+    uint32_t rowStart = 0;
+    //! The first column read.
+    uint32_t columnStart = 0;
+    //! The last row read (inclusive).
+    uint32_t rowEnd = 0;
+    //! The last column read (inclusive).
+    uint32_t columnEnd = 0;
+    //! The values of the layers, as Dataset::readLayers() returns them.
+    UInt8Array data;
+};
+
 //! The interface for the BAG.
 /*!
     This is the BAG Dataset.  It is responsible for creating or reading a BAG.
@@ -43,6 +62,13 @@ namespace BAG {
 
     It is the only way layers can be created.  It is meant to be the interface
     to the BAG, and answer questions about said BAG.
+
+    A Dataset is not thread safe by default.  A BAG opened read only with
+    OpenOptions::concurrentReads set can be shared by several threads; every
+    read, and the lazy opening of layers, is then serialized on one lock held
+    by the Dataset so callers do not need their own.  A writable BAG can
+    have different layers written from different threads once
+    setConcurrentWrites() is called; see there.
 */
 class BAG_API Dataset final
     : public std::enable_shared_from_this<Dataset>
@@ -51,12 +77,45 @@ class BAG_API Dataset final
 public:
     static std::shared_ptr<Dataset> open(const std::string &fileName,
         OpenMode openMode);
+    static std::shared_ptr<Dataset> open(const std::string &fileName,
+        OpenMode openMode, const OpenOptions& options);
 
     static std::shared_ptr<Dataset> create(const std::string &fileName,
         Metadata&& metadata, uint64_t chunkSize = 100,
         int compressionLevel = 5);
+    static std::shared_ptr<Dataset> create(const std::string &fileName,
+        Metadata&& metadata, const ChunkShape& chunkShape,
+        const CompressionSpec& compression = 5,
+        CreationProfile profile = CreationProfile::Default);
+#ifdef BAG_USE_MPI
+    static std::shared_ptr<Dataset> create(MPI_Comm communicator,
+        const std::string &fileName, Metadata&& metadata,
+        const ChunkShape& chunkShape, const CompressionSpec& compression = 5,
+        CreationProfile profile = CreationProfile::Default);
+#endif
+
+    static std::shared_ptr<Dataset> openFromMemory(const uint8_t* image,
+        size_t imageSize, OpenMode openMode);
+    static std::shared_ptr<Dataset> openFromMemory(const uint8_t* image,
+        size_t imageSize, OpenMode openMode, const OpenOptions& options);
+
+    static std::shared_ptr<Dataset> createInMemory(Metadata&& metadata,
+        uint64_t chunkSize = 100, int compressionLevel = 5,
+        const std::string& persistFileName = {});
+    static std::shared_ptr<Dataset> createInMemory(Metadata&& metadata,
+        const ChunkShape& chunkShape, const CompressionSpec& compression = 5,
+        const std::string& persistFileName = {},
+        CreationProfile profile = CreationProfile::Default);
+
+    std::vector<uint8_t> getFileImage();
+
+    static bool isCompressionFilterAvailable(int filter) noexcept;
+    static bool isRemoteReadAvailable() noexcept;
 
     void close();
+    void flush();
+
+    ~Dataset();
 
     Dataset(const Dataset&) = delete;
     Dataset(Dataset&&) = delete;
@@ -85,43 +144,71 @@ public:
 
     std::vector<LayerType> getLayerTypes() const;
 
+    UInt8Array readLayers(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const std::vector<LayerType>& types,
+        LayerLayout layout = BAG_LAYOUT_PLANAR) const;
+    GeoRead readGeo(double minX, double minY, double maxX, double maxY,
+        const std::vector<LayerType>& types,
+        const GeoReadOptions& options = {}) const;
+    std::shared_ptr<const DatasetSnapshot> loadSnapshot(
+        const std::vector<LayerType>& types = {}) const;
+    VerifyReport verify(const VerifyOptions& options = {}) const;
+    std::vector<ChunkHash> hashChunks(const ChunkHashOptions& options = {});
+    std::vector<ChunkHash> readChunkHashes() const;
+
     Layer& createSimpleLayer(LayerType type, uint64_t chunkSize,
         int compressionLevel) &;
+    Layer& createSimpleLayer(LayerType type, const ChunkShape& chunkShape,
+        const CompressionSpec& compression,
+        const Quantization& quantization = {}) &;
     GeorefMetadataLayer& createGeorefMetadataLayer(DataType keyType, GeorefMetadataProfile profile,
                                                    const std::string& name, const RecordDefinition& definition,
                                                    uint64_t chunkSize, int compressionLevel) &;
+    GeorefMetadataLayer& createGeorefMetadataLayer(DataType keyType, GeorefMetadataProfile profile,
+                                                   const std::string& name, const RecordDefinition& definition,
+                                                   const ChunkShape& chunkShape, const CompressionSpec& compression) &;
     GeorefMetadataLayer& createGeorefMetadataLayer(GeorefMetadataProfile profile,
                                                    const std::string& name,
                                                    uint64_t chunkSize, int compressionLevel,
                                                    DataType keyType = DT_UINT16) &;
+    GeorefMetadataLayer& createGeorefMetadataLayer(GeorefMetadataProfile profile,
+                                                   const std::string& name,
+                                                   const ChunkShape& chunkShape, const CompressionSpec& compression,
+                                                   DataType keyType = DT_UINT16) &;
     SurfaceCorrections& createSurfaceCorrections(
         BAG_SURFACE_CORRECTION_TOPOGRAPHY type, uint8_t numCorrectors,
         uint64_t chunkSize, int compressionLevel) &;
-    void createVR(uint64_t chunkSize, int compressionLevel, bool makeNode);
+    SurfaceCorrections& createSurfaceCorrections(
+        BAG_SURFACE_CORRECTION_TOPOGRAPHY type, uint8_t numCorrectors,
+        const ChunkShape& chunkShape, const CompressionSpec& compression) &;
+    void createVR(uint64_t chunkSize, const CompressionSpec& compression,
+        bool makeNode, const VRSizeHint& sizeHint = {});
+    void recomputeVRStatistics();
 
-    const Metadata& getMetadata() const & noexcept;
+    const Metadata& getMetadata() const &;
 
     TrackingList& getTrackingList() & noexcept;
     const TrackingList& getTrackingList() const & noexcept;
 
-    std::shared_ptr<GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) & noexcept;
-    std::shared_ptr<const GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) const & noexcept;
-    std::vector<std::shared_ptr<GeorefMetadataLayer>> getGeorefMetadataLayers() & noexcept;
+    std::shared_ptr<GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) &;
+    std::shared_ptr<const GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) const &;
+    std::vector<std::shared_ptr<GeorefMetadataLayer>> getGeorefMetadataLayers() &;
 
-    std::shared_ptr<SurfaceCorrections> getSurfaceCorrections() & noexcept;
-    std::shared_ptr<const SurfaceCorrections> getSurfaceCorrections() const & noexcept;
+    std::shared_ptr<SurfaceCorrections> getSurfaceCorrections() &;
+    std::shared_ptr<const SurfaceCorrections> getSurfaceCorrections() const &;
 
-    std::shared_ptr<SimpleLayer> getSimpleLayer(LayerType type) & noexcept;
-    std::shared_ptr <const SimpleLayer> getSimpleLayer(LayerType type) const & noexcept;
+    std::shared_ptr<SimpleLayer> getSimpleLayer(LayerType type) &;
+    std::shared_ptr <const SimpleLayer> getSimpleLayer(LayerType type) const &;
 
-    std::shared_ptr<VRMetadata> getVRMetadata() & noexcept;
-    std::shared_ptr<const VRMetadata> getVRMetadata() const & noexcept;
+    std::shared_ptr<VRMetadata> getVRMetadata() &;
+    std::shared_ptr<const VRMetadata> getVRMetadata() const &;
 
-    std::shared_ptr<VRNode> getVRNode() & noexcept;
-    std::shared_ptr<const VRNode> getVRNode() const & noexcept;
+    std::shared_ptr<VRNode> getVRNode() &;
+    std::shared_ptr<const VRNode> getVRNode() const &;
 
-    std::shared_ptr<VRRefinements> getVRRefinements() & noexcept;
-    std::shared_ptr<const VRRefinements> getVRRefinements() const & noexcept;
+    std::shared_ptr<VRRefinements> getVRRefinements() &;
+    std::shared_ptr<const VRRefinements> getVRRefinements() const &;
 
     std::shared_ptr<VRTrackingList> getVRTrackingList() & noexcept;
     std::shared_ptr<const VRTrackingList> getVRTrackingList() const & noexcept;
@@ -129,48 +216,153 @@ public:
     Descriptor& getDescriptor() & noexcept;
     const Descriptor& getDescriptor() const & noexcept;
 
+    bool isConcurrentReadEnabled() const noexcept;
+    bool isConcurrentWriteEnabled() const noexcept;
+    void setConcurrentWrites(bool enabled);
+
+    bool isParallel() const noexcept;
+#ifdef BAG_USE_MPI
+    MPI_Comm getCommunicator() const noexcept;
+#endif
+
+    bool isDeferringAttributeWrites() const noexcept;
+    void setDeferAttributeWrites(bool defer);
+
+    void beginBatch() noexcept;
+    void commit(bool flushFile = false);
+    bool isInBatch() const noexcept;
+
+    bool isCollectingIoStats() const noexcept;
+    void setCollectIoStats(bool collect) noexcept;
+    DatasetIoStats getIoStats() const;
+    void resetIoStats();
+
+    void startAccessTrace(const std::string& fileName);
+    void stopAccessTrace();
+    bool isTracingAccess() const noexcept;
+
+    DatasetMemoryUsage getMemoryUsage() const;
+    void releaseCaches() const;
+
     std::tuple<double, double> gridToGeo(uint32_t row, uint32_t column) const noexcept;
     std::tuple<uint32_t, uint32_t> geoToGrid(double x, double y) const noexcept;
+    void gridToGeo(const uint32_t* rows, const uint32_t* columns, size_t count,
+        double* xs, double* ys) const noexcept;
+    void geoToGrid(const double* xs, const double* ys, size_t count,
+        uint32_t* rows, uint32_t* columns) const noexcept;
+
+    uint32_t selectOverviewLevel(LayerType type, double resolution) const;
 
 private:
     Dataset() = default;
     uint32_t getNextId() const noexcept;
 
-    void readDataset(const std::string& fileName, OpenMode openMode);
+    void readDataset(const std::string& fileName, OpenMode openMode,
+        const OpenOptions& options, const uint8_t* image = nullptr,
+        size_t imageSize = 0);
     void createDataset(const std::string& fileName, Metadata&& metadata,
-        uint64_t chunkSize, int compressionLevel);
-
-    std::tuple<bool, float, float> getMinMax(LayerType type,
-        const std::string& path = {}) const;
+        const ChunkShape& chunkShape, const CompressionSpec& compression,
+        CreationProfile profile, bool inMemory = false, bool persist = false);
 
     ::H5::H5File& getH5file() const & noexcept;
+    CreationProfile getCreationProfile() const noexcept;
+    ::H5::DSetAccPropList getH5dataSetAccessPropList(LayerType type) const;
 
     Layer& addLayer(std::shared_ptr<Layer> layer) &;
+    void flushLayerAttributes() const;
+    void writeDeferred() const;
+    void trimReserved();
+    void addLazyLayer(std::shared_ptr<LayerDescriptor> pDescriptor,
+        std::function<std::shared_ptr<Layer>()> openLayer) &;
+
+    std::shared_ptr<Layer> findLayer(LayerType type,
+        const std::string& name = {}) const;
+    std::shared_ptr<Layer> getOrOpenLayer(uint32_t id) const;
+    void indexLayer(const LayerDescriptor& descriptor);
+
+    std::unique_lock<std::recursive_mutex> lockReads() const;
+    std::unique_lock<std::recursive_mutex> lockWrites() const;
+    std::shared_ptr<AccessTracer> getAccessTracer() const noexcept;
+
+    uint64_t getReleasableBytes() const noexcept;
+    void releaseCachesLocked() const noexcept;
+    uint64_t releaseCachesForBudget() const noexcept;
+    void releaseRequestedCaches() const;
+    void reportCacheUsage() const;
 
     //! Custom deleter to not require knowledge of ::H5::H5File destructor here.
     struct BAG_API DeleteH5File final {
         void operator()(::H5::H5File* ptr) noexcept;
     };
 
+    //! A layer that was discovered, but not opened yet.
+    struct LazyLayer final {
+        //! The descriptor of the layer.
+        std::shared_ptr<LayerDescriptor> pDescriptor;
+        //! Opens the layer.
+        std::function<std::shared_ptr<Layer>()> open;
+    };
+
     //! The HDF5 file that the BAG is stored in.
     std::unique_ptr<::H5::H5File, DeleteH5File> m_pH5file;
     //! The mandatory and optional layers found in the BAG, including ones
-    //! created after opening.
-    std::vector<std::shared_ptr<Layer>> m_layers;
-    //! The metadata.
-    std::unique_ptr<Metadata> m_pMetadata;
+    //! created after opening.  Indexed by layer id; nullptr if not opened yet.
+    mutable std::vector<std::shared_ptr<Layer>> m_layers;
+    //! The layers that have not been opened yet, by layer id.
+    mutable std::unordered_map<uint32_t, LazyLayer> m_lazyLayers;
+    //! One more than the id of the first layer of each type, by type; 0 if
+    //! there is none.  Georeferenced metadata layers are in
+    //! m_georefMetadataLayerIds.
+    std::array<uint32_t, UNKNOWN_LAYER_TYPE> m_layerIdsByType{};
+    //! The ids of the georeferenced metadata layers, by lower case name.
+    std::unordered_map<std::string, uint32_t> m_georefMetadataLayerIds;
+    //! The metadata; nullptr until it is first retrieved when opened with
+    //! OpenOptions::deferMetadata.
+    mutable std::unique_ptr<Metadata> m_pMetadata;
     //! The tracking list.
     std::unique_ptr<TrackingList> m_pTrackingList;
     //! The descriptor.
     Descriptor m_descriptor;
     //! The optional VR tracking list.
     std::shared_ptr<VRTrackingList> m_pVRTrackingList;
-
+    //! The options the BAG was opened with.
+    OpenOptions m_openOptions;
+    //! How the BAG was laid out when created; Default if it was opened.
+    CreationProfile m_creationProfile = CreationProfile::Default;
+    //! Are layer attributes only written when flushed?
+    bool m_deferAttributeWrites = false;
+    //! The number of batches begun and not committed yet.
+    uint32_t m_batchDepth = 0;
+    //! Are the layers counting and timing their reads and writes?
+    bool m_collectIoStats = false;
+    //! May different layers be written from different threads?
+    bool m_concurrentWrites = false;
+    //! Records the reads and writes of the layers; null if they are not
+    //! traced.  Swapped atomically, as layers read it from any thread.
+    std::shared_ptr<AccessTracer> m_pAccessTracer;
+#ifdef BAG_USE_MPI
+    //! The processes sharing the BAG through the MPI-IO driver;
+    //! MPI_COMM_NULL if it is not.
+    MPI_Comm m_communicator = MPI_COMM_NULL;
+#endif
+    //! Serializes access to the HDF5 file when concurrent reads or writes
+    //! are enabled.
+    mutable std::recursive_mutex m_h5Mutex;
+    //! Has the MemoryBudget asked for the caches to be released when next
+    //! used?
+    mutable std::atomic<bool> m_releaseCachesRequested{false};
+
+    friend AccessTraceScope;
+    friend ChunkHasher;
+    friend DatasetVerifier;
     friend GeorefMetadataLayer;
     friend GeorefMetadataLayerDescriptor;
     friend InterleavedLegacyLayer;
     friend InterleavedLegacyLayerDescriptor;
+    friend Layer;
     friend LayerDescriptor;
+    friend LayerDiffer;
+    friend MemoryBudget;
     friend Metadata;
     friend SimpleLayer;
     friend TrackingList;
@@ -178,12 +370,15 @@ private:
     friend SurfaceCorrections;
     friend SurfaceCorrectionsDescriptor;
     friend ValueTable;
+    friend VRCellIterator;
+    friend VRIndex;
     friend VRMetadata;
     friend VRMetadataDescriptor;
     friend VRNode;
     friend VRNodeDescriptor;
     friend VRRefinements;
     friend VRRefinementsDescriptor;
+    friend VRResampler;
     friend VRTrackingList;
 };
 
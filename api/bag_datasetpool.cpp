@@ -0,0 +1,315 @@
+
+#include "bag_dataset.h"
+#include "bag_datasetpool.h"
+#include "bag_filestamp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+//! Constructor.
+/*!
+\param options
+    How the BAGs are kept open.
+*/
+DatasetPool::DatasetPool(
+    const DatasetPoolOptions& options)
+    : m_options(options)
+{
+    // The BAGs are shared by every thread that acquires them.
+    m_options.openOptions.concurrentReads = true;
+
+    if (m_options.reopenInterval > 0)
+        m_thread = std::thread{&DatasetPool::run, this};
+}
+
+//! Destructor.
+/*!
+    The BAGs still held by others stay open until they are released.
+*/
+DatasetPool::~DatasetPool()
+{
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+
+    m_stopRequested.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+//! Acquire a BAG for reading.
+/*!
+    The BAG is opened if it is not open, or if its file changed since it
+    was.  Only one BAG is opened at a time; acquiring a BAG already open
+    does not wait for another to open.
+
+\param fileName
+    The file name or URL of the BAG.
+
+\return
+    The BAG.  It can be read by several threads at once.
+*/
+std::shared_ptr<const Dataset> DatasetPool::acquire(
+    const std::string& fileName)
+{
+    const auto name = canonicalFileName(fileName);
+    const auto url = isUrl(name);
+    const auto stamp = url ? FileStamp{} : statFile(name);
+
+    // Is an open BAG of the file as it is now?  URLs carry no stamp.
+    const auto findCurrent = [&]() -> std::shared_ptr<const Dataset> {
+        const auto found = m_entries.find(name);
+        if (found == m_entries.end() || !(url ||
+            (found->second.fileSize == stamp.size &&
+                found->second.modified == stamp.modified)))
+            return {};
+
+        found->second.lastUse = ++m_clock;
+        ++m_stats.hits;
+
+        return found->second.pDataset;
+    };
+
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (auto pDataset = findCurrent())
+            return pDataset;
+    }
+
+    const std::lock_guard<std::mutex> openLock{m_openMutex};
+
+    // Another thread may have opened it while this one waited.
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (auto pDataset = findCurrent())
+            return pDataset;
+    }
+
+    std::shared_ptr<const Dataset> pDataset;
+    try
+    {
+        pDataset = this->open(name);
+    }
+    catch (...)
+    {
+        // The BAG kept open is of a file that is gone or broken.
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_entries.erase(name);
+
+        throw;
+    }
+
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    auto& entry = m_entries[name];
+    if (entry.pDataset)
+        ++m_stats.reopens;
+    ++m_stats.misses;
+
+    entry.pDataset = pDataset;
+    entry.fileSize = stamp.size;
+    entry.modified = stamp.modified;
+    entry.lastUse = ++m_clock;
+
+    this->trimLocked();
+
+    return pDataset;
+}
+
+//! Close the BAGs used least recently that nobody else holds, until the
+//! pool is within its limits.
+void DatasetPool::trim()
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    this->trimLocked();
+}
+
+//! Close every BAG kept open.
+/*!
+    The BAGs held by others stay open until they are released, but are no
+    longer handed out.
+*/
+void DatasetPool::clear()
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    m_entries.clear();
+}
+
+//! Retrieve the number of BAGs kept open.
+/*!
+\return
+    The number of BAGs kept open.
+*/
+size_t DatasetPool::size() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return m_entries.size();
+}
+
+//! Retrieve what the pool has done.
+/*!
+\return
+    The number of hits, misses, reopens and evictions.
+*/
+DatasetPoolStats DatasetPool::getStats() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return m_stats;
+}
+
+//! Open a BAG.
+/*!
+\param fileName
+    The canonical name of the file of the BAG.
+
+\return
+    The BAG.
+*/
+std::shared_ptr<const Dataset> DatasetPool::open(
+    const std::string& fileName) const
+{
+    return Dataset::open(fileName, BAG_OPEN_READONLY, m_options.openOptions);
+}
+
+//! Close the BAGs used least recently that nobody else holds, until the
+//! pool is within its limits.
+/*!
+    The mutex must be held.
+*/
+void DatasetPool::trimLocked()
+{
+    if (m_options.maxDatasets == 0 && m_options.maxBytes == 0)
+        return;
+
+    // A BAG that may be closed; when it was last acquired, the memory it
+    // holds (if counted) and the canonical name of its file.
+    struct Candidate final
+    {
+        uint64_t lastUse = 0;
+        uint64_t bytes = 0;
+        const std::string* pName = nullptr;
+    };
+
+    std::vector<Candidate> candidates;
+    uint64_t usage = 0;
+
+    for (const auto& item : m_entries)
+    {
+        const auto bytes = m_options.maxBytes > 0 ?
+            item.second.pDataset->getMemoryUsage().getTotal() : 0;
+        usage += bytes;
+
+        // Held by nobody else.
+        if (item.second.pDataset.use_count() == 1)
+            candidates.push_back({item.second.lastUse, bytes, &item.first});
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& lhs, const Candidate& rhs) {
+            return lhs.lastUse < rhs.lastUse;
+        });
+
+    for (const auto& candidate : candidates)
+    {
+        const auto tooMany = m_options.maxDatasets > 0 &&
+            m_entries.size() > m_options.maxDatasets;
+        const auto tooLarge = m_options.maxBytes > 0 &&
+            usage > m_options.maxBytes;
+        if (!tooMany && !tooLarge)
+            break;
+
+        usage -= candidate.bytes;
+        m_entries.erase(*candidate.pName);
+        ++m_stats.evictions;
+    }
+}
+
+//! Check the files of the BAGs kept open every interval, and open those
+//! that changed again; run by the background thread.
+void DatasetPool::run()
+{
+    const std::chrono::milliseconds interval{m_options.reopenInterval};
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    while (!m_stopRequested.wait_for(lock, interval,
+        [this]() { return m_stop; }))
+    {
+        // The files as they were when their BAGs were opened.  URLs carry
+        // no stamp.
+        std::vector<std::pair<std::string, FileStamp>> files;
+        files.reserve(m_entries.size());
+
+        for (const auto& item : m_entries)
+        {
+            if (isUrl(item.first))
+                continue;
+
+            FileStamp stamp;
+            stamp.exists = true;
+            stamp.size = item.second.fileSize;
+            stamp.modified = item.second.modified;
+
+            files.emplace_back(item.first, stamp);
+        }
+
+        lock.unlock();
+
+        for (const auto& file : files)
+        {
+            const auto stamp = statFile(file.first);
+            if (!stamp.exists || stamp == file.second)
+                continue;
+
+            std::shared_ptr<const Dataset> pDataset;
+            {
+                const std::lock_guard<std::mutex> openLock{m_openMutex};
+
+                try
+                {
+                    pDataset = this->open(file.first);
+                }
+                catch (...)
+                {
+                    // Perhaps still being written; it is tried again next
+                    // time.
+                    continue;
+                }
+            }
+
+            const std::lock_guard<std::mutex> entriesLock{m_mutex};
+            if (m_stop)
+                break;
+
+            // Closed, or opened again by an acquisition, meanwhile.
+            const auto found = m_entries.find(file.first);
+            if (found == m_entries.end() ||
+                found->second.fileSize != file.second.size ||
+                found->second.modified != file.second.modified)
+                continue;
+
+            found->second.pDataset = std::move(pDataset);
+            found->second.fileSize = stamp.size;
+            found->second.modified = stamp.modified;
+            ++m_stats.reopens;
+        }
+
+        lock.lock();
+    }
+}
+
+}  // namespace BAG
+
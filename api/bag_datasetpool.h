@@ -0,0 +1,108 @@
+#ifndef BAG_DATASETPOOL_H
+#define BAG_DATASETPOOL_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Keeps BAGs open for reading, to share them between many users.
+/*!
+    A server reading many BAGs acquires each through the pool rather than
+    opening it.  A BAG is opened read only, with concurrent reads, the first
+    time it is acquired, and the same Dataset is handed out until its file
+    changes.  The file is known by its canonical name, so different names of
+    the same file share a Dataset, and by its size and modification time,
+    so a file that was replaced is opened again.  A Dataset handed out
+    remains valid for as long as it is held, whatever the pool does.
+
+    When the pool holds more BAGs, or more memory, than its limits, the BAGs
+    used least recently that nobody else holds are closed.  The limits are
+    kept when a BAG is acquired and by trim(); BAGs still held may keep the
+    pool above them.
+
+    With DatasetPoolOptions::reopenInterval set, a background thread checks
+    the files of the BAGs kept open, and opens those that changed again, so
+    the next acquisition does not wait for it.
+*/
+class BAG_API DatasetPool final
+{
+public:
+    explicit DatasetPool(const DatasetPoolOptions& options = {});
+    ~DatasetPool();
+
+    DatasetPool(const DatasetPool&) = delete;
+    DatasetPool(DatasetPool&&) = delete;
+    DatasetPool& operator=(const DatasetPool&) = delete;
+    DatasetPool& operator=(DatasetPool&&) = delete;
+
+    std::shared_ptr<const Dataset> acquire(const std::string& fileName);
+
+    void trim();
+    void clear();
+
+    size_t size() const noexcept;
+    DatasetPoolStats getStats() const noexcept;
+
+private:
+    //! A BAG kept open.
+    struct Entry final
+    {
+        //! The BAG.
+        std::shared_ptr<const Dataset> pDataset;
+        //! The size of its file when it was opened.
+        uint64_t fileSize = 0;
+        //! When its file was last modified when it was opened.
+        int64_t modified = 0;
+        //! When it was last acquired; larger is more recent.
+        uint64_t lastUse = 0;
+    };
+
+    std::shared_ptr<const Dataset> open(const std::string& fileName) const;
+    void trimLocked();
+    void run();
+
+    //! How the BAGs are kept open.
+    DatasetPoolOptions m_options;
+    //! The BAGs kept open, by the canonical names of their files.
+    std::unordered_map<std::string, Entry> m_entries;
+    //! What the pool has done.
+    DatasetPoolStats m_stats;
+    //! Counts acquisitions, to order them.
+    uint64_t m_clock = 0;
+    //! Has the background thread been told to stop?
+    bool m_stop = false;
+    //! Guards the members.
+    mutable std::mutex m_mutex;
+    //! Serializes opening BAGs; HDF5 is not safe to open files concurrently.
+    std::mutex m_openMutex;
+    //! Signals the background thread to stop.
+    std::condition_variable m_stopRequested;
+    //! The background thread checking for changed files, if there is one.
+    std::thread m_thread;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_DATASETPOOL_H
+
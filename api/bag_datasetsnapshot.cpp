@@ -0,0 +1,1152 @@
+
+#include "bag_datasetsnapshot.h"
+#include "bag_exceptions.h"
+#include "bag_sharedmemory.h"
+#include "bag_vrmetadata.h"
+#include "bag_vrtrackinglist.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+namespace BAG {
+
+namespace {
+
+//! Load a value stored in a byte buffer.
+/*!
+\param bytes
+    The first byte of the value.
+
+\return
+    The value.
+*/
+template <typename T>
+T loadValue(
+    const uint8_t* bytes) noexcept
+{
+    T value{};
+    std::memcpy(&value, bytes, sizeof(T));
+
+    return value;
+}
+
+//! Retrieve a georeferenced metadata key of any supported size.
+/*!
+\param keys
+    The keys.
+\param keySize
+    The size of a key, in bytes.
+\param index
+    The index of the key.
+
+\return
+    The key.
+*/
+uint64_t getKey(
+    const uint8_t* keys,
+    uint8_t keySize,
+    size_t index) noexcept
+{
+    const auto* bytes = keys + index * keySize;
+
+    switch (keySize)
+    {
+    case 1:
+        return *bytes;
+    case 2:
+        return loadValue<uint16_t>(bytes);
+    case 4:
+        return loadValue<uint32_t>(bytes);
+    default:
+        return loadValue<uint64_t>(bytes);
+    }
+}
+
+//! Find an exported column by the name of its field.
+/*!
+    A FieldNotFound exception is thrown if there is no such field.
+
+\param columns
+    The columns.
+\param name
+    The name of the field.
+
+\return
+    The column.
+*/
+const ExportedColumn& getColumn(
+    const std::vector<ExportedColumn>& columns,
+    const std::string& name)
+{
+    const auto found = std::find_if(columns.begin(), columns.end(),
+        [&name](const ExportedColumn& column) {
+            return column.name == name;
+        });
+    if (found == columns.end())
+        throw FieldNotFound{};
+
+    return *found;
+}
+
+//! Look up the values of some fields for a run of keys.
+/*!
+    As ValueTable::resolve(), from the exported columns of a value table.
+
+\param columns
+    The values of every field, in key order.
+\param numRecords
+    The number of records/values.
+\param keys
+    The keys.
+\param keySize
+    The size of a key, in bytes.
+\param numKeys
+    The number of keys.
+\param fieldNames
+    The fields to look up.
+
+\return
+    The values, one column per field in the order of fieldNames, with one
+    value per key.
+*/
+std::vector<ResolvedColumn> resolveKeys(
+    const std::vector<ExportedColumn>& columns,
+    size_t numRecords,
+    const uint8_t* keys,
+    uint8_t keySize,
+    size_t numKeys,
+    const std::vector<std::string>& fieldNames)
+{
+    std::vector<std::pair<uint64_t, size_t>> runs;
+
+    for (size_t i=0; i<numKeys; ++i)
+    {
+        const auto key = getKey(keys, keySize, i);
+        if (key >= numRecords)
+            throw ValueNotFound{};
+
+        if (!runs.empty() && runs.back().first == key)
+            ++runs.back().second;
+        else
+            runs.emplace_back(key, 1);
+    }
+
+    std::vector<ResolvedColumn> resolved;
+    resolved.reserve(fieldNames.size());
+
+    for (const auto& name : fieldNames)
+    {
+        const auto& column = getColumn(columns, name);
+
+        resolved.emplace_back();
+        auto& output = resolved.back();
+        output.name = name;
+        output.type = column.type;
+
+        switch (column.type)
+        {
+        case DT_FLOAT32:
+            output.floats.reserve(numKeys);
+            for (const auto& run : runs)
+                output.floats.insert(output.floats.end(), run.second,
+                    loadValue<float>(column.values.data() +
+                        run.first * sizeof(float)));
+            break;
+        case DT_UINT32:
+            output.uint32s.reserve(numKeys);
+            for (const auto& run : runs)
+                output.uint32s.insert(output.uint32s.end(), run.second,
+                    loadValue<uint32_t>(column.values.data() +
+                        run.first * sizeof(uint32_t)));
+            break;
+        case DT_BOOLEAN:
+            output.bools.reserve(numKeys);
+            for (const auto& run : runs)
+                output.bools.insert(output.bools.end(), run.second,
+                    column.values[run.first]);
+            break;
+        case DT_STRING:
+            output.strings.reserve(numKeys);
+            for (const auto& run : runs)
+            {
+                const auto begin = column.characters.begin() +
+                    column.offsets[run.first];
+                const auto end = column.characters.begin() +
+                    column.offsets[run.first + 1];
+
+                output.strings.insert(output.strings.end(), run.second,
+                    std::string(begin, end));
+            }
+            break;
+        default:
+            throw UnsupportedDataType{};
+        }
+    }
+
+    return resolved;
+}
+
+//! Does a record/value match a query?
+/*!
+    As ValueTable::matches(), from an exported column of a value table.
+
+\param column
+    The values of the field queried.
+\param key
+    The key of the record/value.
+\param query
+    The query.
+
+\return
+    \e true if the value of the field is within the query.
+*/
+bool matches(
+    const ExportedColumn& column,
+    size_t key,
+    const ValueQuery& query)
+{
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+    {
+        const auto value = loadValue<float>(column.values.data() +
+            key * sizeof(float));
+        return value >= query.min.asFloat() && value <= query.max.asFloat();
+    }
+    case DT_UINT32:
+    {
+        const auto value = loadValue<uint32_t>(column.values.data() +
+            key * sizeof(uint32_t));
+        return value >= query.min.asUInt32() && value <= query.max.asUInt32();
+    }
+    case DT_BOOLEAN:
+        return column.values[key] >= (query.min.asBool() ? 1 : 0) &&
+            column.values[key] <= (query.max.asBool() ? 1 : 0);
+    case DT_STRING:
+    {
+        const std::string value(
+            column.characters.begin() + column.offsets[key],
+            column.characters.begin() + column.offsets[key + 1]);
+        return query.min.asString() <= value && value <= query.max.asString();
+    }
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Marks a snapshot in shared memory, and the version of its layout.
+constexpr char kSharedMagic[8] = {'B', 'A', 'G', 'S', 'N', 'A', 'P', '1'};
+//! The alignment, in bytes, of the arrays of a snapshot in shared memory.
+constexpr size_t kSharedAlignment = 64;
+
+//! The start of a snapshot in shared memory.
+struct SharedHeader final
+{
+    //! kSharedMagic; written last, once the rest of the snapshot is.
+    char magic[8];
+    //! The number of rows in the grid.
+    uint32_t numRows;
+    //! The number of columns in the grid.
+    uint32_t numColumns;
+    //! The number of simple layers, which follow the header.
+    uint32_t numLayers;
+    //! Unused.
+    uint32_t padding;
+    //! The number of tracking list items.
+    uint64_t numTrackingItems;
+    //! The offset of the tracking list items.
+    uint64_t trackingItemsOffset;
+};
+
+//! A simple layer of a snapshot in shared memory.
+struct SharedLayer final
+{
+    //! The type of the layer.
+    uint32_t type;
+    //! The size of a value, in bytes.
+    uint32_t elementSize;
+    //! The offset of the values of every node, row major.
+    uint64_t offset;
+};
+
+//! Round an offset in shared memory up to the alignment of an array.
+/*!
+\param offset
+    The offset.
+
+\return
+    The offset, aligned.
+*/
+size_t alignShared(
+    size_t offset) noexcept
+{
+    return (offset + kSharedAlignment - 1) / kSharedAlignment *
+        kSharedAlignment;
+}
+
+}  // namespace
+
+//! Attach to a snapshot exported to shared memory by another process.
+/*!
+    The simple layers are read from the shared memory, which is mapped read
+    only, without copying them; the segment stays mapped while the snapshot
+    exists, even if it is removed.  The tracking list is copied.
+
+    A SharedMemoryUnavailable exception is thrown if there is no such
+    segment, and an InvalidSharedMemorySnapshot exception if it does not
+    hold a whole snapshot.
+
+\param name
+    The name of the shared memory segment.
+
+\return
+    The snapshot.
+*/
+std::shared_ptr<const DatasetSnapshot> DatasetSnapshot::attachSharedMemory(
+    const std::string& name)
+{
+    std::unique_ptr<SharedMemorySegment, DeleteSharedMemorySegment> pSegment{
+        SharedMemorySegment::attach(name).release()};
+    if (!pSegment)
+        throw SharedMemoryUnavailable{};
+
+    const auto* data = pSegment->data();
+    const auto size = pSegment->size();
+
+    SharedHeader header{};
+    if (size < sizeof(header))
+        throw InvalidSharedMemorySnapshot{};
+
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kSharedMagic, sizeof(kSharedMagic)) != 0 ||
+        header.numLayers > (size - sizeof(header)) / sizeof(SharedLayer))
+        throw InvalidSharedMemorySnapshot{};
+
+    std::shared_ptr<DatasetSnapshot> pSnapshot{new DatasetSnapshot};
+    auto& snapshot = *pSnapshot;
+
+    snapshot.m_numRows = header.numRows;
+    snapshot.m_numColumns = header.numColumns;
+    const auto numNodes = static_cast<uint64_t>(header.numRows) *
+        header.numColumns;
+
+    // Check each array lies within the segment.
+    const auto fits = [size](uint64_t offset, uint64_t count,
+        uint64_t elementSize) noexcept {
+        return offset <= size && count <= (size - offset) / elementSize;
+    };
+
+    for (uint32_t i=0; i<header.numLayers; ++i)
+    {
+        SharedLayer shared{};
+        std::memcpy(&shared, data + sizeof(header) + i * sizeof(shared),
+            sizeof(shared));
+
+        if (shared.elementSize == 0 ||
+            shared.elementSize > std::numeric_limits<uint8_t>::max() ||
+            !fits(shared.offset, numNodes, shared.elementSize))
+            throw InvalidSharedMemorySnapshot{};
+
+        SimpleLayerData layer;
+        layer.type = static_cast<LayerType>(shared.type);
+        layer.elementSize = static_cast<uint8_t>(shared.elementSize);
+        layer.pValues = data + shared.offset;
+
+        snapshot.m_layers.push_back(std::move(layer));
+    }
+
+    if (!fits(header.trackingItemsOffset, header.numTrackingItems,
+        sizeof(TrackingItem)))
+        throw InvalidSharedMemorySnapshot{};
+
+    snapshot.m_trackingItems.resize(
+        static_cast<size_t>(header.numTrackingItems));
+    if (!snapshot.m_trackingItems.empty())
+        std::memcpy(snapshot.m_trackingItems.data(),
+            data + header.trackingItemsOffset,
+            snapshot.m_trackingItems.size() * sizeof(TrackingItem));
+
+    snapshot.m_pSharedMemory = std::move(pSegment);
+
+    return pSnapshot;
+}
+
+//! Remove a snapshot exported to shared memory.
+/*!
+    Snapshots attached to it keep reading it until they are destroyed.
+
+\param name
+    The name of the shared memory segment.
+
+\return
+    \e true if the segment was removed.
+    \e false if there was no such segment.
+*/
+bool DatasetSnapshot::removeSharedMemory(
+    const std::string& name) noexcept
+{
+    return SharedMemorySegment::remove(name);
+}
+
+//! Retrieve the number of rows in the grid.
+/*!
+\return
+    The number of rows.
+*/
+uint32_t DatasetSnapshot::getNumRows() const noexcept
+{
+    return m_numRows;
+}
+
+//! Retrieve the number of columns in the grid.
+/*!
+\return
+    The number of columns.
+*/
+uint32_t DatasetSnapshot::getNumColumns() const noexcept
+{
+    return m_numColumns;
+}
+
+//! Retrieve the memory held by the snapshot.
+/*!
+\return
+    The number of bytes held by the layers, tables and lists loaded,
+    including those in shared memory.
+*/
+size_t DatasetSnapshot::getMemoryUsage() const noexcept
+{
+    size_t bytes = m_trackingItems.size() * sizeof(TrackingItem) +
+        m_vrRefinements.size() * sizeof(VRRefinementsItem) +
+        m_vrNodes.size() * sizeof(VRNodeItem);
+
+    const auto numNodes = static_cast<size_t>(m_numRows) * m_numColumns;
+    for (const auto& layer : m_layers)
+        bytes += numNodes * layer.elementSize;
+
+    if (m_pVRMetadata)
+        bytes += m_pVRMetadata->size() * sizeof(VRMetadataItem);
+
+    if (m_pVRTrackingTable)
+        bytes += m_pVRTrackingTable->size() * sizeof(VRTrackingItem);
+
+    for (const auto& layer : m_georefLayers)
+    {
+        bytes += layer.keys.size() + layer.vrKeys.size();
+
+        for (const auto& column : layer.columns)
+            bytes += column.values.size() +
+                column.offsets.size() * sizeof(uint64_t) +
+                column.characters.size();
+    }
+
+    return bytes;
+}
+
+//! Was a simple layer loaded?
+/*!
+\param type
+    The type of the layer.
+
+\return
+    \e true if the layer was loaded.
+*/
+bool DatasetSnapshot::hasLayer(
+    LayerType type) const noexcept
+{
+    return this->findLayer(type) != nullptr;
+}
+
+//! Read an area of a simple layer.
+/*!
+    As Layer::read().
+
+\param type
+    The type of the layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The values of the area, row major.
+*/
+UInt8Array DatasetSnapshot::read(
+    LayerType type,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    return this->readLayers(rowStart, columnStart, rowEnd, columnEnd, {type});
+}
+
+//! Read the same area of several simple layers in one call.
+/*!
+    As Dataset::readLayers().
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param types
+    The types of the layers to read, in the order they are returned.
+\param layout
+    BAG_LAYOUT_PLANAR to return each layer as a contiguous block, one after
+    the other.
+    BAG_LAYOUT_INTERLEAVED to return the values of all layers for a node
+    next to each other.
+
+\return
+    The values of the requested layers.
+*/
+UInt8Array DatasetSnapshot::readLayers(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const std::vector<LayerType>& types,
+    LayerLayout layout) const
+{
+    this->checkWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    if (layout != BAG_LAYOUT_PLANAR && layout != BAG_LAYOUT_INTERLEAVED)
+        throw InvalidLayerLayout{};
+
+    std::vector<const SimpleLayerData*> layers;
+    layers.reserve(types.size());
+
+    size_t recordSize = 0;
+    for (const auto type : types)
+    {
+        const auto* pLayer = this->findLayer(type);
+        if (!pLayer)
+            throw LayerNotFound{};
+
+        recordSize += pLayer->elementSize;
+        layers.push_back(pLayer);
+    }
+
+    const size_t numRows = (rowEnd - rowStart) + 1;
+    const size_t numColumns = (columnEnd - columnStart) + 1;
+    auto result = UInt8Array::uninitialized(numRows * numColumns * recordSize);
+
+    size_t offset = 0;
+    for (const auto* pLayer : layers)
+    {
+        const size_t elementSize = pLayer->elementSize;
+        const auto* from = pLayer->pValues +
+            (static_cast<size_t>(rowStart) * m_numColumns + columnStart) *
+            elementSize;
+
+        for (size_t row=0; row<numRows; ++row, from += m_numColumns * elementSize)
+        {
+            if (layout == BAG_LAYOUT_PLANAR)
+            {
+                std::memcpy(result.data() + offset +
+                    row * numColumns * elementSize, from,
+                    numColumns * elementSize);
+                continue;
+            }
+
+            auto* to = result.data() + offset + row * numColumns * recordSize;
+            for (size_t column=0; column<numColumns; ++column, to += recordSize)
+                std::memcpy(to, from + column * elementSize, elementSize);
+        }
+
+        offset += layout == BAG_LAYOUT_PLANAR ?
+            numRows * numColumns * elementSize : elementSize;
+    }
+
+    return result;
+}
+
+//! Find the tracking list items of a node.
+/*!
+\param row
+    The row of the node.
+\param column
+    The column of the node.
+
+\return
+    The items of the node, in the order of the tracking list.
+*/
+std::vector<TrackingItem> DatasetSnapshot::getTrackingItemsAtNode(
+    uint32_t row,
+    uint32_t column) const
+{
+    TrackingItem node{};
+    node.row = row;
+    node.col = column;
+
+    const auto range = std::equal_range(m_trackingItems.begin(),
+        m_trackingItems.end(), node,
+        [](const TrackingItem& lhs, const TrackingItem& rhs) {
+            return std::make_pair(lhs.row, lhs.col) <
+                std::make_pair(rhs.row, rhs.col);
+        });
+
+    return {range.first, range.second};
+}
+
+//! Were the variable resolution layers loaded?
+/*!
+\return
+    \e true if the variable resolution layers were loaded.
+*/
+bool DatasetSnapshot::isVariableResolution() const noexcept
+{
+    return static_cast<bool>(m_pVRMetadata);
+}
+
+//! Retrieve the VRMetadata layer.
+/*!
+\return
+    The VRMetadata layer; null if variable resolution was not loaded.
+*/
+std::shared_ptr<const VRMetadataTable>
+DatasetSnapshot::getVRMetadataTable() const noexcept
+{
+    return m_pVRMetadata;
+}
+
+//! Retrieve the VRRefinements layer.
+/*!
+\return
+    Every refinement; empty if variable resolution was not loaded.
+*/
+const std::vector<VRRefinementsItem>&
+DatasetSnapshot::getVRRefinements() const & noexcept
+{
+    return m_vrRefinements;
+}
+
+//! Retrieve the VRNode layer.
+/*!
+\return
+    Every VRNode item; empty if there are none or variable resolution was
+    not loaded.
+*/
+const std::vector<VRNodeItem>& DatasetSnapshot::getVRNodes() const & noexcept
+{
+    return m_vrNodes;
+}
+
+//! Retrieve the variable resolution tracking list.
+/*!
+\return
+    The tracking list, grouped by node; null if variable resolution was not
+    loaded.
+*/
+std::shared_ptr<const VRTrackingTable>
+DatasetSnapshot::getVRTrackingTable() const noexcept
+{
+    return m_pVRTrackingTable;
+}
+
+//! Look up the refinement nearest to a position.
+/*!
+    As VRIndex::queryPoint().
+
+\param x
+    The easting.
+\param y
+    The northing.
+
+\return
+    The refinement.
+    VRPointResult::found is \e false if the position is outside the BAG or
+    its supergrid cell is not refined.
+*/
+VRPointResult DatasetSnapshot::queryVRPoint(
+    double x,
+    double y) const
+{
+    if (!m_pVRIndex)
+        throw DatasetRequiresVariableResolution{};
+
+    auto result = m_pVRIndex->locate(x, y);
+    this->fillVRPoint(result);
+
+    return result;
+}
+
+//! Look up the refinements nearest to many positions.
+/*!
+    As VRIndex::queryPoints().
+
+\param points
+    The positions.
+
+\return
+    The refinement of each position, in the same order as points.
+*/
+std::vector<VRPointResult> DatasetSnapshot::queryVRPoints(
+    const std::vector<VRPoint>& points) const
+{
+    if (!m_pVRIndex)
+        throw DatasetRequiresVariableResolution{};
+
+    std::vector<VRPointResult> results;
+    results.reserve(points.size());
+
+    for (const auto& point : points)
+    {
+        results.push_back(m_pVRIndex->locate(point.x, point.y));
+        this->fillVRPoint(results.back());
+    }
+
+    return results;
+}
+
+//! Fill in the refinement and tracking list items of a position found.
+/*!
+\param result
+    The position; left alone if it was not found.
+*/
+void DatasetSnapshot::fillVRPoint(
+    VRPointResult& result) const
+{
+    if (!result.found)
+        return;
+
+    if (result.refinementIndex >= m_vrRefinements.size())
+        throw InvalidReadSize{};
+
+    result.item = m_vrRefinements[result.refinementIndex];
+
+    if (!m_pVRTrackingTable)
+        return;
+
+    const auto items = m_pVRTrackingTable->getItemsAtSubNode(result.row,
+        result.column, result.subRow, result.subColumn);
+
+    result.trackingItems.assign(items.first, items.second);
+}
+
+//! Retrieve the names of the georeferenced metadata layers loaded.
+/*!
+\return
+    The names of the layers.
+*/
+std::vector<std::string> DatasetSnapshot::getGeorefMetadataLayerNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(m_georefLayers.size());
+
+    for (const auto& layer : m_georefLayers)
+        names.push_back(layer.name);
+
+    return names;
+}
+
+//! Read the values of some fields for each node in a region.
+/*!
+    As GeorefMetadataLayer::readResolved().
+
+\param layerName
+    The name of the georeferenced metadata layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param fieldNames
+    The fields to read.
+
+\return
+    The values, one column per field in the order of fieldNames, with one
+    value per node, row major.
+*/
+std::vector<ResolvedColumn> DatasetSnapshot::readResolved(
+    const std::string& layerName,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto& layer = this->getGeorefLayer(layerName);
+    this->checkWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    const uint32_t numColumns = (columnEnd - columnStart) + 1;
+
+    // Gather the keys of the region; the keys of a row are contiguous.
+    UInt8Array keys = UInt8Array::uninitialized(
+        static_cast<size_t>(rowEnd - rowStart + 1) * numColumns *
+        layer.keySize);
+
+    for (auto row=rowStart; row<=rowEnd; ++row)
+        std::memcpy(keys.data() + static_cast<size_t>(row - rowStart) *
+            numColumns * layer.keySize,
+            layer.keys.data() + (static_cast<size_t>(row) * m_numColumns +
+                columnStart) * layer.keySize,
+            static_cast<size_t>(numColumns) * layer.keySize);
+
+    return resolveKeys(layer.columns, layer.numRecords, keys.data(),
+        layer.keySize, keys.size() / layer.keySize, fieldNames);
+}
+
+//! Read the values of some fields for a range of variable resolution nodes.
+/*!
+    As GeorefMetadataLayer::readVRResolved().
+
+\param layerName
+    The name of the georeferenced metadata layer.
+\param indexStart
+    The starting index to read.
+    Must be less than or equal to indexEnd.
+\param indexEnd
+    The ending index to read.  (inclusive)
+\param fieldNames
+    The fields to read.
+
+\return
+    The values, one column per field in the order of fieldNames, with one
+    value per node.
+*/
+std::vector<ResolvedColumn> DatasetSnapshot::readVRResolved(
+    const std::string& layerName,
+    uint32_t indexStart,
+    uint32_t indexEnd,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto& layer = this->getGeorefLayer(layerName);
+    if (!layer.hasVRKeys)
+        throw DatasetRequiresVariableResolution{};
+
+    if (indexStart > indexEnd || indexEnd >= layer.numVRKeys)
+        throw InvalidReadSize{};
+
+    return resolveKeys(layer.columns, layer.numRecords,
+        layer.vrKeys.data() + static_cast<size_t>(indexStart) * layer.keySize,
+        layer.keySize, static_cast<size_t>(indexEnd - indexStart) + 1,
+        fieldNames);
+}
+
+//! Read the refinements of some supergrid cells, joined with the values of
+//! some fields.
+/*!
+    As GeorefMetadataLayer::readVRResolved().  Cells that are not refined,
+    or are outside the supergrid, are left out.
+
+\param layerName
+    The name of the georeferenced metadata layer.
+\param cells
+    The cells, as (row, column).
+\param fieldNames
+    The fields to read.
+
+\return
+    The cells and their refinements, with one value per refinement.
+*/
+VRResolvedRead DatasetSnapshot::readVRResolved(
+    const std::string& layerName,
+    const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto& layer = this->getGeorefLayer(layerName);
+    if (!m_pVRMetadata || !layer.hasVRKeys)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto numRows = m_pVRMetadata->getNumRows();
+    const auto numColumns = m_pVRMetadata->getNumColumns();
+    const auto* items = m_pVRMetadata->data();
+
+    // The refined cells, once each, in the order of their first refinement.
+    std::vector<uint32_t> positions;
+    positions.reserve(cells.size());
+
+    for (const auto& cell : cells)
+    {
+        if (cell.first >= numRows || cell.second >= numColumns)
+            continue;
+
+        const auto position = cell.first * numColumns + cell.second;
+        if (items[position].dimensions_x != 0 &&
+            items[position].dimensions_y != 0)
+            positions.push_back(position);
+    }
+
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+        positions.end());
+    std::stable_sort(positions.begin(), positions.end(),
+        [items](uint32_t lhs, uint32_t rhs) {
+            return items[lhs].index < items[rhs].index;
+        });
+
+    VRResolvedRead result;
+    result.cells.reserve(positions.size());
+
+    std::vector<uint8_t> keys;
+
+    for (const auto position : positions)
+    {
+        const auto& item = items[position];
+        const auto count = item.dimensions_x * item.dimensions_y;
+
+        if (static_cast<uint64_t>(item.index) + count > m_vrRefinements.size() ||
+            static_cast<uint64_t>(item.index) + count > layer.numVRKeys)
+            throw InvalidReadSize{};
+
+        VRResolvedCell resolved;
+        resolved.row = position / numColumns;
+        resolved.column = position % numColumns;
+        resolved.metadata = item;
+        resolved.offset = result.depths.size();
+        resolved.count = count;
+        result.cells.push_back(resolved);
+
+        for (uint32_t i=0; i<count; ++i)
+        {
+            const auto& refinement = m_vrRefinements[item.index + i];
+            result.depths.push_back(refinement.depth);
+            result.uncertainties.push_back(refinement.depth_uncrt);
+        }
+
+        const auto* first = layer.vrKeys.data() +
+            static_cast<size_t>(item.index) * layer.keySize;
+        keys.insert(keys.end(), first, first + count * layer.keySize);
+    }
+
+    result.columns = resolveKeys(layer.columns, layer.numRecords, keys.data(),
+        layer.keySize, result.depths.size(), fieldNames);
+
+    return result;
+}
+
+//! Find the nodes in a region whose record/value matches a query.
+/*!
+    As GeorefMetadataLayer::findCells().  The no data value record never
+    matches.
+
+\param layerName
+    The name of the georeferenced metadata layer.
+\param query
+    The query.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The row and column of each matching node, in row major order.
+*/
+std::vector<std::pair<uint32_t, uint32_t>> DatasetSnapshot::findCells(
+    const std::string& layerName,
+    const ValueQuery& query,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    const auto& layer = this->getGeorefLayer(layerName);
+    this->checkWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    const auto& column = getColumn(layer.columns, query.fieldName);
+    if (query.min.getType() != column.type ||
+        query.max.getType() != column.type)
+        throw InvalidValue{};
+
+    std::vector<bool> matching(layer.numRecords, false);
+    bool anyMatching = false;
+
+    for (size_t key=1; key<layer.numRecords; ++key)
+    {
+        matching[key] = matches(column, key, query);
+        anyMatching = anyMatching || matching[key];
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> cells;
+    if (!anyMatching)
+        return cells;
+
+    for (auto row=rowStart; row<=rowEnd; ++row)
+    {
+        const auto rowOffset = static_cast<size_t>(row) * m_numColumns;
+
+        for (auto c=columnStart; c<=columnEnd; ++c)
+        {
+            const auto key = getKey(layer.keys.data(), layer.keySize,
+                rowOffset + c);
+
+            if (key < matching.size() && matching[static_cast<size_t>(key)])
+                cells.emplace_back(row, c);
+        }
+    }
+
+    return cells;
+}
+
+//! Export the simple layers and tracking list to shared memory.
+/*!
+    Creates a named shared memory segment holding the simple layers and the
+    tracking list, which other processes can attach to with
+    attachSharedMemory().  Variable resolution and georeferenced metadata
+    layers are not exported.  The segment exists until it is removed with
+    removeSharedMemory(), even after this process exits.
+
+    Only available on POSIX systems.  A SharedMemoryUnavailable exception is
+    thrown if the segment already exists, or could not be created.
+
+\param name
+    The name of the shared memory segment.
+*/
+void DatasetSnapshot::exportToSharedMemory(
+    const std::string& name) const
+{
+    const auto numNodes = static_cast<size_t>(m_numRows) * m_numColumns;
+
+    // The header, the layers, then the values of each layer and the
+    // tracking list, each aligned.
+    std::vector<SharedLayer> layers;
+    layers.reserve(m_layers.size());
+
+    auto offset = alignShared(sizeof(SharedHeader) +
+        m_layers.size() * sizeof(SharedLayer));
+    for (const auto& layer : m_layers)
+    {
+        layers.push_back({static_cast<uint32_t>(layer.type),
+            layer.elementSize, offset});
+        offset = alignShared(offset + numNodes * layer.elementSize);
+    }
+
+    SharedHeader header{};
+    header.numRows = m_numRows;
+    header.numColumns = m_numColumns;
+    header.numLayers = static_cast<uint32_t>(layers.size());
+    header.numTrackingItems = m_trackingItems.size();
+    header.trackingItemsOffset = offset;
+
+    const auto pSegment = SharedMemorySegment::create(name,
+        offset + m_trackingItems.size() * sizeof(TrackingItem));
+    if (!pSegment)
+        throw SharedMemoryUnavailable{};
+
+    auto* data = pSegment->data();
+
+    for (size_t i=0; i<layers.size(); ++i)
+    {
+        std::memcpy(data + sizeof(header) + i * sizeof(SharedLayer),
+            &layers[i], sizeof(SharedLayer));
+        if (numNodes > 0)
+            std::memcpy(data + layers[i].offset, m_layers[i].pValues,
+                numNodes * m_layers[i].elementSize);
+    }
+
+    if (!m_trackingItems.empty())
+        std::memcpy(data + header.trackingItemsOffset, m_trackingItems.data(),
+            m_trackingItems.size() * sizeof(TrackingItem));
+
+    // The magic last, so a partly written snapshot is not attached to.
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data, kSharedMagic, sizeof(kSharedMagic));
+}
+
+//! Are the simple layers read from shared memory?
+/*!
+\return
+    \e true if the snapshot was attached to shared memory.
+*/
+bool DatasetSnapshot::isShared() const noexcept
+{
+    return static_cast<bool>(m_pSharedMemory);
+}
+
+//! Find a simple layer.
+/*!
+\param type
+    The type of the layer.
+
+\return
+    The layer; null if it was not loaded.
+*/
+const DatasetSnapshot::SimpleLayerData* DatasetSnapshot::findLayer(
+    LayerType type) const noexcept
+{
+    const auto found = std::find_if(m_layers.begin(), m_layers.end(),
+        [type](const SimpleLayerData& layer) {
+            return layer.type == type;
+        });
+
+    return found == m_layers.end() ? nullptr : &*found;
+}
+
+//! Retrieve a georeferenced metadata layer.
+/*!
+    A LayerNotFound exception is thrown if the layer was not loaded.
+
+\param name
+    The name of the layer.
+
+\return
+    The layer.
+*/
+const DatasetSnapshot::GeorefLayerData& DatasetSnapshot::getGeorefLayer(
+    const std::string& name) const
+{
+    const auto found = std::find_if(m_georefLayers.begin(),
+        m_georefLayers.end(), [&name](const GeorefLayerData& layer) {
+            return layer.name == name;
+        });
+    if (found == m_georefLayers.end())
+        throw LayerNotFound{};
+
+    return *found;
+}
+
+//! Make sure a region is within the grid.
+/*!
+    An InvalidReadSize exception is thrown if it is not.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+*/
+void DatasetSnapshot::checkWindow(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    if (rowStart > rowEnd || columnStart > columnEnd ||
+        rowEnd >= m_numRows || columnEnd >= m_numColumns)
+        throw InvalidReadSize{};
+}
+
+//! Custom deleter to not require knowledge of SharedMemorySegment in the header.
+/*!
+\param ptr
+    The SharedMemorySegment to be deleted.
+*/
+void DatasetSnapshot::DeleteSharedMemorySegment::operator()(
+    SharedMemorySegment* ptr) noexcept
+{
+    delete ptr;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,181 @@
+#ifndef BAG_DATASETSNAPSHOT_H
+#define BAG_DATASETSNAPSHOT_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_georefmetadatalayer.h"
+#include "bag_types.h"
+#include "bag_uint8array.h"
+#include "bag_valuetable.h"
+#include "bag_vrindex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! An immutable copy, in memory, of some layers of a BAG.
+/*!
+    Dataset::loadSnapshot() reads the layers whole, once, and the snapshot
+    then answers reads, variable resolution lookups and georeferenced
+    metadata queries from memory, without calling HDF5.  Nothing in a
+    snapshot changes after it is loaded, so any number of threads can query
+    one at the same time without locking.
+
+    A snapshot does not refer to the BAG it was loaded from, which may be
+    changed or closed afterwards; load a new snapshot to see the changes.
+
+    The simple layers and tracking list of a snapshot can be exported to a
+    named shared memory segment, which other processes attach to, so they
+    share one copy of the decoded layers instead of each reading their own.
+*/
+class BAG_API DatasetSnapshot final
+{
+public:
+    DatasetSnapshot(const DatasetSnapshot&) = delete;
+    DatasetSnapshot(DatasetSnapshot&&) = delete;
+
+    DatasetSnapshot& operator=(const DatasetSnapshot&) = delete;
+    DatasetSnapshot& operator=(DatasetSnapshot&&) = delete;
+
+    static std::shared_ptr<const DatasetSnapshot> attachSharedMemory(
+        const std::string& name);
+    static bool removeSharedMemory(const std::string& name) noexcept;
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+    size_t getMemoryUsage() const noexcept;
+
+    bool hasLayer(LayerType type) const noexcept;
+    UInt8Array read(LayerType type, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+    UInt8Array readLayers(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const std::vector<LayerType>& types,
+        LayerLayout layout = BAG_LAYOUT_PLANAR) const;
+
+    std::vector<TrackingItem> getTrackingItemsAtNode(uint32_t row,
+        uint32_t column) const;
+
+    bool isVariableResolution() const noexcept;
+    std::shared_ptr<const VRMetadataTable> getVRMetadataTable() const noexcept;
+    const std::vector<VRRefinementsItem>& getVRRefinements() const & noexcept;
+    const std::vector<VRNodeItem>& getVRNodes() const & noexcept;
+    std::shared_ptr<const VRTrackingTable> getVRTrackingTable() const noexcept;
+    VRPointResult queryVRPoint(double x, double y) const;
+    std::vector<VRPointResult> queryVRPoints(
+        const std::vector<VRPoint>& points) const;
+
+    std::vector<std::string> getGeorefMetadataLayerNames() const;
+    std::vector<ResolvedColumn> readResolved(const std::string& layerName,
+        uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd, const std::vector<std::string>& fieldNames) const;
+    std::vector<ResolvedColumn> readVRResolved(const std::string& layerName,
+        uint32_t indexStart, uint32_t indexEnd,
+        const std::vector<std::string>& fieldNames) const;
+    VRResolvedRead readVRResolved(const std::string& layerName,
+        const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+        const std::vector<std::string>& fieldNames) const;
+    std::vector<std::pair<uint32_t, uint32_t>> findCells(
+        const std::string& layerName, const ValueQuery& query,
+        uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const;
+
+    void exportToSharedMemory(const std::string& name) const;
+    bool isShared() const noexcept;
+
+private:
+    //! A simple layer.
+    struct SimpleLayerData final
+    {
+        //! The type of the layer.
+        LayerType type = UNKNOWN_LAYER_TYPE;
+        //! The size of a value, in bytes.
+        uint8_t elementSize = 0;
+        //! The values of every node, row major; in values, or in shared
+        //! memory.
+        const uint8_t* pValues = nullptr;
+        //! The values, if the snapshot owns them.
+        UInt8Array values;
+    };
+
+    //! A georeferenced metadata layer.
+    struct GeorefLayerData final
+    {
+        //! The name of the layer.
+        std::string name;
+        //! The size of a key, in bytes.
+        uint8_t keySize = 0;
+        //! The key of every node, row major.
+        UInt8Array keys;
+        //! Does the layer have variable resolution keys?
+        bool hasVRKeys = false;
+        //! The key of every variable resolution node.
+        UInt8Array vrKeys;
+        //! The number of variable resolution keys.
+        size_t numVRKeys = 0;
+        //! The number of records/values, including the no data value record.
+        size_t numRecords = 0;
+        //! The values of every field, in key order.
+        std::vector<ExportedColumn> columns;
+    };
+
+    //! Custom deleter to not require knowledge of SharedMemorySegment here.
+    struct BAG_API DeleteSharedMemorySegment final {
+        void operator()(SharedMemorySegment* ptr) noexcept;
+    };
+
+    DatasetSnapshot() = default;
+
+    const SimpleLayerData* findLayer(LayerType type) const noexcept;
+    const GeorefLayerData& getGeorefLayer(const std::string& name) const;
+    void checkWindow(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const;
+    void fillVRPoint(VRPointResult& result) const;
+
+    //! The number of rows in the grid.
+    uint32_t m_numRows = 0;
+    //! The number of columns in the grid.
+    uint32_t m_numColumns = 0;
+    //! The simple layers.
+    std::vector<SimpleLayerData> m_layers;
+    //! The tracking list, sorted by node.
+    std::vector<TrackingItem> m_trackingItems;
+    //! The VRMetadata layer; null if variable resolution was not loaded.
+    std::shared_ptr<const VRMetadataTable> m_pVRMetadata;
+    //! Locates refinements by position; null as m_pVRMetadata.
+    std::unique_ptr<VRIndex> m_pVRIndex;
+    //! The VRRefinements layer.
+    std::vector<VRRefinementsItem> m_vrRefinements;
+    //! The VRNode layer; empty if there is none.
+    std::vector<VRNodeItem> m_vrNodes;
+    //! The variable resolution tracking list; may be null.
+    std::shared_ptr<const VRTrackingTable> m_pVRTrackingTable;
+    //! The georeferenced metadata layers.
+    std::vector<GeorefLayerData> m_georefLayers;
+    //! The shared memory holding the simple layers; null if they are not
+    //! shared.
+    std::unique_ptr<SharedMemorySegment, DeleteSharedMemorySegment>
+        m_pSharedMemory;
+
+    friend Dataset;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_DATASETSNAPSHOT_H
+
@@ -17,5 +17,27 @@ void DeleteH5dataSet::operator()(::H5::DataSet* ptr) noexcept
     delete ptr;
 }
 
+//! A specialized deleter to avoid needing definitions of HDF5 classes in header
+//! files.
+/*!
+\param ptr
+    A pointer to an HDF5 DataSpace.
+*/
+void DeleteH5dataSpace::operator()(::H5::DataSpace* ptr) noexcept
+{
+    delete ptr;
+}
+
+//! A specialized deleter to avoid needing definitions of HDF5 classes in header
+//! files.
+/*!
+\param ptr
+    A pointer to an HDF5 DataType.
+*/
+void DeleteH5dataType::operator()(::H5::DataType* ptr) noexcept
+{
+    delete ptr;
+}
+
 }  // namespace BAG
 
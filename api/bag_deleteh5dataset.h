@@ -1,6 +1,6 @@
 /*!
 \file bag_deleteh5dataset.h
-\brief Custom deleter to avoid needing a definition for ::H5::DataSet::~DataSet().
+\brief Custom deleters to avoid needing definitions of HDF5 destructors.
 */
 #ifndef BAG_DELETEH5DATASET_H
 #define BAG_DELETEH5DATASET_H
@@ -11,6 +11,8 @@
 namespace H5 {
 
 class DataSet;
+class DataSpace;
+class DataType;
 
 }  // namespace H5
 
@@ -23,6 +25,20 @@ struct BAG_API DeleteH5dataSet final
     void operator()(::H5::DataSet* ptr) noexcept;
 };
 
+//! Custom deleter for use with std::unique_ptr, to keep HDF5 dependencies out
+//! of header files.
+struct BAG_API DeleteH5dataSpace final
+{
+    void operator()(::H5::DataSpace* ptr) noexcept;
+};
+
+//! Custom deleter for use with std::unique_ptr, to keep HDF5 dependencies out
+//! of header files.
+struct BAG_API DeleteH5dataType final
+{
+    void operator()(::H5::DataType* ptr) noexcept;
+};
+
 }  // namespace BAG
 
 #endif  // BAG_DELETEH5DATASET_H
@@ -0,0 +1,452 @@
+
+#include "bag_dataset.h"
+#include "bag_derivatives.h"
+#include "bag_exceptions.h"
+#include "bag_layertraits.h"
+#include "bag_neighbourhood.h"
+#include "bag_private.h"
+#include "bag_simplelayer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! The products of computeDerivatives().
+enum Product
+{
+    kSlope = 0,
+    kAspect,
+    kHillshade,
+    kRugosity,
+    kNumProducts
+};
+
+//! The nodes of a row of a tile computed together; the loops over them are
+//! simple enough for the compiler to vectorize.
+constexpr uint32_t kBlockSize = 64;
+
+//! Degrees in a radian.
+constexpr float kDegrees = static_cast<float>(180. / 3.14159265358979323846);
+
+//! Is a value read as a float null?
+/*!
+\param value
+    The value.
+\param nullValue
+    The null value of the layer it was read from, as a float.
+
+\return
+    \e true if the value is null or NaN.
+*/
+inline bool isNullValue(
+    float value,
+    float nullValue) noexcept
+{
+    return value == nullValue || value != value;
+}
+
+//! Retrieve twice the area of a triangle with a vertex at the origin.
+/*!
+\return
+    The length of the cross product of the other two vertices.
+*/
+inline float getTwiceArea(
+    float x1,
+    float y1,
+    float z1,
+    float x2,
+    float y2,
+    float z2) noexcept
+{
+    const auto cx = y1 * z2 - z1 * y2;
+    const auto cy = z1 * x2 - x1 * z2;
+    const auto cz = x1 * y2 - y1 * x2;
+
+    return std::sqrt(cx * cx + cy * cy + cz * cz);
+}
+
+}  // namespace
+
+//! Computes the derivative products of an elevation layer a band at a time.
+class DerivativeComputer final
+{
+public:
+    DerivativeComputer(const SimpleLayer& elevation,
+        const DerivativeLayers& layers,
+        const DerivativeOptions& options) noexcept;
+
+    void compute();
+
+private:
+    void checkLayers(uint32_t numRows, uint32_t numColumns) const;
+    void computeTile(const NeighbourhoodBand& band, uint32_t columnStart,
+        uint32_t columnEnd) noexcept;
+
+    //! The elevation layer.
+    const SimpleLayer& m_elevation;
+    //! The options of the computation.
+    const DerivativeOptions& m_options;
+    //! The layer each product is written to; nullptr if it is not computed.
+    std::array<SimpleLayer*, kNumProducts> m_layers{};
+    //! The null value of each product layer.
+    std::array<float, kNumProducts> m_nullValues{};
+    //! The nodes of each product in the band, row by row.
+    std::array<std::vector<float>, kNumProducts> m_bands;
+    //! The null value of the elevation layer, as a float.
+    float m_nullElevation = 0.f;
+    //! The number of columns of the layers.
+    uint32_t m_numColumns = 0;
+    //! The distance, in the units of the elevations, between a node and its
+    //! neighbours along a row.
+    float m_dx = 0.f;
+    //! The distance between a node and its neighbours along a column.
+    float m_dy = 0.f;
+    //! Scales the weighted differences of the elevations along a row to a
+    //! gradient.
+    float m_xScale = 0.f;
+    //! Scales the weighted differences along a column to a gradient.
+    float m_yScale = 0.f;
+    //! The sine of the sun's elevation.
+    float m_sunUp = 0.f;
+    //! The sun's direction east, scaled by the cosine of its elevation.
+    float m_sunEast = 0.f;
+    //! The sun's direction north, scaled by the cosine of its elevation.
+    float m_sunNorth = 0.f;
+};
+
+//! Constructor.
+/*!
+\param elevation
+    The elevation layer.
+\param layers
+    The layers the products are written to.
+\param options
+    How the products are computed.
+*/
+DerivativeComputer::DerivativeComputer(
+    const SimpleLayer& elevation,
+    const DerivativeLayers& layers,
+    const DerivativeOptions& options) noexcept
+    : m_elevation(elevation)
+    , m_options(options)
+    , m_layers{{layers.slope, layers.aspect, layers.hillshade,
+        layers.rugosity}}
+{
+}
+
+//! Compute the products.
+void DerivativeComputer::compute()
+{
+    if (m_options.radius == 0)
+        throw InvalidKernelRadius{};
+
+    const auto pDataset = m_elevation.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    uint32_t numRows = 0;
+    std::tie(numRows, m_numColumns) = descriptor.getDims();
+
+    this->checkLayers(numRows, m_numColumns);
+
+    if (std::none_of(m_layers.begin(), m_layers.end(),
+        [](const SimpleLayer* pLayer) { return pLayer != nullptr; }))
+        return;
+
+    for (size_t product=0; product<kNumProducts; ++product)
+        if (m_layers[product])
+            visitLayerTraits(
+                m_layers[product]->getDescriptor()->getLayerType(),
+                [this, product](auto traits) {
+                    m_nullValues[product] = static_cast<float>(
+                        decltype(traits)::getNullValue());
+                });
+
+    // Rows run north and columns east, as in diffLayers().
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+    const auto zFactor = m_options.zFactor;
+    m_dx = static_cast<float>(columnSpacing * m_options.radius / zFactor);
+    m_dy = static_cast<float>(rowSpacing * m_options.radius / zFactor);
+    m_xScale = 1.f / (8.f * m_dx);
+    m_yScale = 1.f / (8.f * m_dy);
+
+    const auto sunAzimuth = m_options.sunAzimuth / kDegrees;
+    const auto sunElevation = m_options.sunElevation / kDegrees;
+    m_sunUp = static_cast<float>(std::sin(sunElevation));
+    m_sunEast = static_cast<float>(std::cos(sunElevation) *
+        std::sin(sunAzimuth));
+    m_sunNorth = static_cast<float>(std::cos(sunElevation) *
+        std::cos(sunAzimuth));
+
+    NeighbourhoodScanner scanner{m_elevation, m_options.radius};
+    m_nullElevation = scanner.getNullValue();
+
+    const TraceScope trace{"computeDerivatives",
+        m_elevation.getDescriptor()->getName().c_str(), numRows, m_numColumns};
+
+    std::array<std::unique_ptr<SimpleLayer::StripWriter>, kNumProducts>
+        writers;
+    for (size_t product=0; product<kNumProducts; ++product)
+        if (m_layers[product])
+            writers[product] = m_layers[product]->stripWriter();
+
+    scanner.scan([&](const NeighbourhoodBand& band) {
+        const auto bandCells = static_cast<size_t>(band.getRowEnd() -
+            band.getRowStart() + 1) * m_numColumns;
+
+        for (size_t product=0; product<kNumProducts; ++product)
+            if (m_layers[product])
+                m_bands[product].resize(bandCells);
+
+        band.forEachTile([&](uint32_t columnStart, uint32_t columnEnd) {
+            this->computeTile(band, columnStart, columnEnd);
+        });
+
+        for (size_t product=0; product<kNumProducts; ++product)
+            if (writers[product])
+                writers[product]->write(band.getRowStart(), 0,
+                    band.getRowEnd(), m_numColumns - 1,
+                    reinterpret_cast<const uint8_t*>(
+                        m_bands[product].data()));
+    }, m_options.progress);
+
+    for (auto& pWriter : writers)
+        if (pWriter)
+            pWriter->close();
+}
+
+//! Check the layers can hold the products.
+/*!
+    An InvalidDerivativeLayer exception is thrown if a layer is not a 32 bit
+    float layer with the grid of the elevation layer, holds another product,
+    or is the elevation layer.
+
+\param numRows
+    The number of rows of the elevation layer.
+\param numColumns
+    The number of columns of the elevation layer.
+*/
+void DerivativeComputer::checkLayers(
+    uint32_t numRows,
+    uint32_t numColumns) const
+{
+    for (size_t product=0; product<kNumProducts; ++product)
+    {
+        const auto* pLayer = m_layers[product];
+        if (!pLayer)
+            continue;
+
+        if (pLayer == &m_elevation ||
+            std::count(m_layers.begin(), m_layers.end(), pLayer) > 1 ||
+            pLayer->getDescriptor()->getDataType() != DT_FLOAT32)
+            throw InvalidDerivativeLayer{};
+
+        const auto pDataset = pLayer->getDataset().lock();
+        if (!pDataset)
+            throw DatasetNotFound{};
+
+        if (pDataset->getDescriptor().getDims() !=
+            std::make_tuple(numRows, numColumns))
+            throw InvalidDerivativeLayer{};
+    }
+}
+
+//! Compute the products of a tile of a band.
+/*!
+    The nodes of a row are computed a block at a time: the gradients of the
+    block first, then each product from them.
+
+\param band
+    The band.
+\param columnStart
+    The first column of the tile.
+\param columnEnd
+    The last column of the tile (inclusive).
+*/
+void DerivativeComputer::computeTile(
+    const NeighbourhoodBand& band,
+    uint32_t columnStart,
+    uint32_t columnEnd) noexcept
+{
+    const auto r = static_cast<int64_t>(m_options.radius);
+    const auto nullElevation = m_nullElevation;
+
+    std::array<float, kBlockSize> gx{};
+    std::array<float, kBlockSize> gy{};
+    std::array<bool, kBlockSize> valid{};
+
+    for (auto row=band.getRowStart(); row<=band.getRowEnd(); ++row)
+    {
+        const auto* north = band.getRow(int64_t{row} + r);
+        const auto* centre = band.getRow(row);
+        const auto* south = band.getRow(int64_t{row} - r);
+        const auto rowOffset = static_cast<size_t>(row - band.getRowStart()) *
+            m_numColumns;
+
+        for (auto blockStart=columnStart; blockStart<=columnEnd;
+            blockStart+=kBlockSize)
+        {
+            const auto n = std::min(kBlockSize, columnEnd - blockStart + 1);
+            const auto* nw = north + blockStart - r;
+            const auto* nn = north + blockStart;
+            const auto* ne = north + blockStart + r;
+            const auto* ww = centre + blockStart - r;
+            const auto* cc = centre + blockStart;
+            const auto* ee = centre + blockStart + r;
+            const auto* sw = south + blockStart - r;
+            const auto* ss = south + blockStart;
+            const auto* se = south + blockStart + r;
+
+            // Horn's weighted differences.
+            for (uint32_t k=0; k<n; ++k)
+            {
+                valid[k] = !(isNullValue(nw[k], nullElevation) ||
+                    isNullValue(nn[k], nullElevation) ||
+                    isNullValue(ne[k], nullElevation) ||
+                    isNullValue(ww[k], nullElevation) ||
+                    isNullValue(cc[k], nullElevation) ||
+                    isNullValue(ee[k], nullElevation) ||
+                    isNullValue(sw[k], nullElevation) ||
+                    isNullValue(ss[k], nullElevation) ||
+                    isNullValue(se[k], nullElevation));
+
+                gx[k] = ((ne[k] + 2.f * ee[k] + se[k]) -
+                    (nw[k] + 2.f * ww[k] + sw[k])) * m_xScale;
+                gy[k] = ((nw[k] + 2.f * nn[k] + ne[k]) -
+                    (sw[k] + 2.f * ss[k] + se[k])) * m_yScale;
+            }
+
+            if (m_layers[kSlope])
+            {
+                auto* out = m_bands[kSlope].data() + rowOffset + blockStart;
+                const auto nullValue = m_nullValues[kSlope];
+
+                for (uint32_t k=0; k<n; ++k)
+                    out[k] = valid[k] ? std::atan(std::sqrt(gx[k] * gx[k] +
+                        gy[k] * gy[k])) * kDegrees : nullValue;
+            }
+
+            if (m_layers[kAspect])
+            {
+                auto* out = m_bands[kAspect].data() + rowOffset + blockStart;
+                const auto nullValue = m_nullValues[kAspect];
+
+                // The slope faces down the gradient.
+                for (uint32_t k=0; k<n; ++k)
+                {
+                    const auto aspect = std::atan2(-gx[k], -gy[k]) * kDegrees;
+                    out[k] = valid[k] && (gx[k] != 0.f || gy[k] != 0.f) ?
+                        (aspect < 0.f ? aspect + 360.f : aspect) : nullValue;
+                }
+            }
+
+            if (m_layers[kHillshade])
+            {
+                auto* out = m_bands[kHillshade].data() + rowOffset +
+                    blockStart;
+                const auto nullValue = m_nullValues[kHillshade];
+
+                // The cosine of the angle between the normal of the surface,
+                // (-gx, -gy, 1), and the sun.
+                for (uint32_t k=0; k<n; ++k)
+                {
+                    const auto light = (m_sunUp - gx[k] * m_sunEast -
+                        gy[k] * m_sunNorth) /
+                        std::sqrt(1.f + gx[k] * gx[k] + gy[k] * gy[k]);
+                    out[k] = valid[k] ? 255.f * std::max(0.f, light) :
+                        nullValue;
+                }
+            }
+
+            if (m_layers[kRugosity])
+            {
+                auto* out = m_bands[kRugosity].data() + rowOffset +
+                    blockStart;
+                const auto nullValue = m_nullValues[kRugosity];
+                const auto dx = m_dx;
+                const auto dy = m_dy;
+
+                // The area of the eight triangles between a node and each
+                // pair of adjacent neighbours, over their planar area.
+                for (uint32_t k=0; k<n; ++k)
+                {
+                    const auto z = cc[k];
+                    const auto zn = nn[k] - z;
+                    const auto zne = ne[k] - z;
+                    const auto ze = ee[k] - z;
+                    const auto zse = se[k] - z;
+                    const auto zs = ss[k] - z;
+                    const auto zsw = sw[k] - z;
+                    const auto zw = ww[k] - z;
+                    const auto znw = nw[k] - z;
+
+                    const auto area =
+                        getTwiceArea(0.f, dy, zn, dx, dy, zne) +
+                        getTwiceArea(dx, dy, zne, dx, 0.f, ze) +
+                        getTwiceArea(dx, 0.f, ze, dx, -dy, zse) +
+                        getTwiceArea(dx, -dy, zse, 0.f, -dy, zs) +
+                        getTwiceArea(0.f, -dy, zs, -dx, -dy, zsw) +
+                        getTwiceArea(-dx, -dy, zsw, -dx, 0.f, zw) +
+                        getTwiceArea(-dx, 0.f, zw, -dx, dy, znw) +
+                        getTwiceArea(-dx, dy, znw, 0.f, dy, zn);
+
+                    out[k] = valid[k] ? area / (8.f * dx * dy) : nullValue;
+                }
+            }
+        }
+    }
+}
+
+//! Compute the slope, aspect, hillshade and rugosity of an elevation layer.
+/*!
+    The products are computed in one pass over the layer, a row of chunks
+    at a time, from the neighbours of each node options.radius nodes away
+    along the rows and columns (and diagonals); the slope and aspect with
+    Horn's method, and the rugosity as the ratio of the area of the surface
+    to its planar area (Jenness).  The elevation layer is read once, as the
+    rows of the neighbourhoods of a band are kept from the band before, and
+    the tiles of a band, a chunk wide, are computed on several threads.
+    The products are written through a SimpleLayer::StripWriter, so each of
+    their chunks is compressed about once.
+
+    A node whose neighbourhood holds a null (or NaN) node or leaves the
+    grid is null in every product.  The grid spacing is in the units of the
+    elevations times options.zFactor; the rows run north and the columns
+    east.
+
+    If options.progress is cancelled, the bands computed so far are kept in
+    the layers.
+
+\param elevation
+    The elevation layer, or any simple layer of heights.
+\param layers
+    The layers the products are written to.  An InvalidDerivativeLayer
+    exception is thrown if one is not a 32 bit float layer with the grid of
+    the elevation layer, is the elevation layer, or is given for two
+    products.
+\param options
+    How the products are computed.  An InvalidKernelRadius exception is
+    thrown if the radius is 0.
+*/
+void computeDerivatives(
+    const SimpleLayer& elevation,
+    const DerivativeLayers& layers,
+    const DerivativeOptions& options)
+{
+    DerivativeComputer{elevation, layers, options}.compute();
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,17 @@
+#ifndef BAG_DERIVATIVES_H
+#define BAG_DERIVATIVES_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+
+namespace BAG {
+
+BAG_API void computeDerivatives(const SimpleLayer& elevation,
+    const DerivativeLayers& layers, const DerivativeOptions& options = {});
+
+}  // namespace BAG
+
+#endif  // BAG_DERIVATIVES_H
+
@@ -83,6 +83,8 @@ Descriptor::Descriptor(
         metadata.urCornerX(), metadata.urCornerY()})
     , m_origin({metadata.llCornerX(), metadata.llCornerY()})
     , m_gridSpacing({metadata.rowResolution(), metadata.columnResolution()})
+    , m_gridTransform{metadata.llCornerX(), metadata.llCornerY(),
+        metadata.rowResolution(), metadata.columnResolution()}
 {
 }
 
@@ -127,6 +129,19 @@ const std::tuple<double, double>& Descriptor::getGridSpacing() const & noexcept
     return m_gridSpacing;
 }
 
+//! Retrieve the transform between the grid and geographic locations.
+/*!
+    It is kept up to date with the origin and grid spacing, so converting a
+    location does not look either up.
+
+\return
+    The transform of the grid.
+*/
+const GridTransform& Descriptor::getGridTransform() const & noexcept
+{
+    return m_gridTransform;
+}
+
 //! Retrieve the horizontal reference system.
 /*!
 \return
@@ -329,6 +344,8 @@ Descriptor& Descriptor::setGridSpacing(
     double ySpacing) & noexcept
 {
     m_gridSpacing = {xSpacing, ySpacing};
+    m_gridTransform.xSpacing = xSpacing;
+    m_gridTransform.ySpacing = ySpacing;
     return *this;
 }
 
@@ -362,6 +379,8 @@ Descriptor& Descriptor::setOrigin(
     double llY) & noexcept
 {
     m_origin = {llX, llY};
+    m_gridTransform.originX = llX;
+    m_gridTransform.originY = llY;
     return *this;
 }
 
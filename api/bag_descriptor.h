@@ -63,6 +63,7 @@ public:
         getProjectedCover() const & noexcept;
     const std::tuple<double, double>& getOrigin() const & noexcept;
     const std::tuple<double, double>& getGridSpacing() const & noexcept;
+    const GridTransform& getGridTransform() const & noexcept;
 
     Descriptor& setVerticalReferenceSystem(
         const std::string& verticalReferenceSystem) & noexcept;
@@ -97,6 +98,8 @@ private:
     std::tuple<double, double> m_origin{};
     //! The grid spacing of the bag.
     std::tuple<double, double> m_gridSpacing{};
+    //! The transform of the grid; from m_origin and m_gridSpacing.
+    GridTransform m_gridTransform;
 
     bool layerDescriptorsEqual(std::vector<std::weak_ptr<const LayerDescriptor>> other) const {
         auto size = m_layerDescriptors.size();
@@ -0,0 +1,763 @@
+
+#include "bag_dataset.h"
+#include "bag_diff.h"
+#include "bag_directchunk.h"
+#include "bag_exceptions.h"
+#include "bag_layertraits.h"
+#include "bag_parallel.h"
+#include "bag_private.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayer.h"
+#include "bag_statistics.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <H5Cpp.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! How far, in nodes, the nodes of two grids may be apart and still line
+//! up; it absorbs rounding of the origins.
+constexpr double kAlignmentTolerance = 1e-6;
+//! How much the spacings of two grids may differ, relative to the spacing.
+constexpr double kSpacingTolerance = 1e-9;
+
+//! The differences found in a tile.
+struct TileDiff final
+{
+    //! The number of nodes not null in either layer.
+    uint64_t count = 0;
+    //! The number of those that differ by more than the threshold.
+    uint64_t numChanged = 0;
+    //! The number of nodes only null in the first layer.
+    uint64_t numAdded = 0;
+    //! The number of nodes only null in the second layer.
+    uint64_t numRemoved = 0;
+    //! The smallest difference.
+    double min = std::numeric_limits<double>::max();
+    //! The largest difference.
+    double max = std::numeric_limits<double>::lowest();
+    //! The moments of the differences.
+    Moments moments;
+    //! The bounding box of the changed, added and removed nodes; numChanged
+    //! is 0 if there are none.
+    DiffRegion region;
+};
+
+//! Is a value read as a float null?
+/*!
+\param value
+    The value.
+\param nullValue
+    The null value of the layer it was read from, as a float.
+
+\return
+    \e true if the value is null or NaN.
+*/
+bool isNullValue(
+    float value,
+    float nullValue) noexcept
+{
+    return value == nullValue || std::isnan(value);
+}
+
+//! Retrieve the null value of a layer as a float.
+/*!
+\param layer
+    The layer.
+
+\return
+    The null value of the layer, converted to a float.
+*/
+float getFloatNullValue(
+    const SimpleLayer& layer)
+{
+    float nullValue = 0.f;
+
+    visitLayerTraits(layer.getDescriptor()->getLayerType(),
+        [&](auto traits) {
+            nullValue = static_cast<float>(decltype(traits)::getNullValue());
+        });
+
+    return nullValue;
+}
+
+//! Retrieve the offset of the nodes of one grid in another, along an axis.
+/*!
+    A GridsNotAligned exception is thrown if the spacings differ, or the
+    nodes do not line up.
+
+\param originA
+    The origin of the first grid.
+\param spacingA
+    The spacing of the first grid.
+\param originB
+    The origin of the second grid.
+\param spacingB
+    The spacing of the second grid.
+
+\return
+    The number of nodes of the first grid node 0 of the second is from its
+    node 0.
+*/
+int64_t getNodeOffset(
+    double originA,
+    double spacingA,
+    double originB,
+    double spacingB)
+{
+    if (!(spacingA > 0.) ||
+        std::abs(spacingB - spacingA) > kSpacingTolerance * spacingA)
+        throw GridsNotAligned{};
+
+    const auto offset = (originB - originA) / spacingA;
+    const auto nodes = std::round(offset);
+    if (std::abs(offset - nodes) > kAlignmentTolerance)
+        throw GridsNotAligned{};
+
+    return static_cast<int64_t>(nodes);
+}
+
+}  // namespace
+
+//! Compares two simple layers a band of tiles at a time.
+class LayerDiffer final
+{
+public:
+    LayerDiffer(const SimpleLayer& a, const SimpleLayer& b,
+        const DiffOptions& options, SimpleLayer* pDifference) noexcept;
+
+    LayerDiff diff();
+
+private:
+    void alignGrids(LayerDiff& result);
+    bool canCompareChunks() const;
+    bool areChunksIdentical(uint32_t row, uint32_t column);
+    void diffBand(uint32_t bandStart, uint32_t bandEnd, LayerDiff& result);
+    void diffTile(uint32_t bandStart, uint32_t bandEnd, uint32_t columnStart,
+        uint32_t columnEnd, bool identical, TileDiff& tile) noexcept;
+
+    //! The first layer.
+    const SimpleLayer& m_a;
+    //! The second layer.
+    const SimpleLayer& m_b;
+    //! The options of the comparison.
+    const DiffOptions& m_options;
+    //! The layer the differences are written to; null if they are not.
+    SimpleLayer* m_pDifference = nullptr;
+    //! The offset, in rows, of row 0 of the second layer in the first.
+    int64_t m_rowOffset = 0;
+    //! The offset, in columns, of column 0 of the second layer in the first.
+    int64_t m_columnOffset = 0;
+    //! The first and last (inclusive) columns of the first layer shared.
+    std::array<uint32_t, 2> m_columns{};
+    //! The rows and columns of a tile; those of the chunks of the first
+    //! layer.
+    std::array<uint32_t, 2> m_tileDims{};
+    //! Are the tiles chunks of both layers, stored alike?
+    bool m_compareChunks = false;
+    //! The null value of the first layer, as a float.
+    float m_nullA = 0.f;
+    //! The null value of the second layer, as a float.
+    float m_nullB = 0.f;
+    //! The null value of the difference layer.
+    float m_nullDifference = 0.f;
+    //! The moments of the differences so far.
+    Moments m_moments;
+    //! The smallest difference so far.
+    double m_min = std::numeric_limits<double>::max();
+    //! The largest difference so far.
+    double m_max = std::numeric_limits<double>::lowest();
+    //! The nodes of the first layer in the band.
+    std::vector<float> m_bandA;
+    //! The nodes of the second layer in the band, at the nodes of the first.
+    std::vector<float> m_bandB;
+    //! The differences in the band.
+    std::vector<float> m_bandDifference;
+    //! A chunk of the first layer, as stored.
+    std::vector<uint8_t> m_storedA;
+    //! A chunk of the second layer, as stored.
+    std::vector<uint8_t> m_storedB;
+};
+
+//! Constructor.
+/*!
+\param a
+    The first layer.
+\param b
+    The second layer.
+\param options
+    The options of the comparison.
+\param pDifference
+    The layer the differences are written to; nullptr if they are not.
+*/
+LayerDiffer::LayerDiffer(
+    const SimpleLayer& a,
+    const SimpleLayer& b,
+    const DiffOptions& options,
+    SimpleLayer* pDifference) noexcept
+    : m_a(a)
+    , m_b(b)
+    , m_options(options)
+    , m_pDifference(pDifference)
+{
+}
+
+//! Compare the layers.
+/*!
+\return
+    The differences.
+*/
+LayerDiff LayerDiffer::diff()
+{
+    LayerDiff result;
+    this->alignGrids(result);
+
+    if (m_pDifference)
+    {
+        if (m_pDifference->getDescriptor()->getDataType() != DT_FLOAT32)
+            throw InvalidType{};
+
+        m_nullDifference = getFloatNullValue(*m_pDifference);
+    }
+
+    m_nullA = getFloatNullValue(m_a);
+    m_nullB = getFloatNullValue(m_b);
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_a.getDescriptor()->getChunkDims();
+
+    if (chunkRows > 0 && chunkColumns > 0)
+        m_tileDims = {static_cast<uint32_t>(chunkRows),
+            static_cast<uint32_t>(chunkColumns)};
+    else
+        m_tileDims = {kDefaultTileSize, kDefaultTileSize};
+
+    m_compareChunks = m_options.skipIdenticalChunks &&
+        this->canCompareChunks();
+
+    const TraceScope trace{"diffLayers",
+        m_a.getDescriptor()->getName().c_str(),
+        result.rowEnd - result.rowStart + 1,
+        result.columnEnd - result.columnStart + 1};
+
+    const ProgressScope progress{m_options.progress};
+    const auto numRows = static_cast<uint64_t>(result.rowEnd) -
+        result.rowStart + 1;
+
+    // A band is a row of tiles of the first layer.
+    for (auto bandStart=result.rowStart; bandStart<=result.rowEnd; )
+    {
+        const auto bandEnd = static_cast<uint32_t>(std::min<uint64_t>(
+            result.rowEnd,
+            (static_cast<uint64_t>(bandStart) / m_tileDims[0] + 1) *
+                m_tileDims[0] - 1));
+
+        this->diffBand(bandStart, bandEnd, result);
+
+        progress.report(static_cast<uint64_t>(bandEnd) - result.rowStart + 1,
+            numRows);
+
+        bandStart = bandEnd + 1;
+        if (bandStart == 0)
+            break;
+    }
+
+    if (result.count > 0)
+    {
+        const auto variance = m_moments.getVariance();
+
+        result.min = m_min;
+        result.max = m_max;
+        result.mean = m_moments.mean;
+        result.standardDeviation = std::sqrt(variance);
+        result.rms = std::sqrt(m_moments.mean * m_moments.mean + variance);
+    }
+
+    return result;
+}
+
+//! Find the nodes the layers share.
+/*!
+    A GridsNotAligned exception is thrown if the grids do not share nodes.
+
+\param result
+    Set to the window of the first layer shared with the second.
+*/
+void LayerDiffer::alignGrids(
+    LayerDiff& result)
+{
+    const auto pDatasetA = m_a.getDataset().lock();
+    const auto pDatasetB = m_b.getDataset().lock();
+    if (!pDatasetA || !pDatasetB)
+        throw DatasetNotFound{};
+
+    const auto& descriptorA = pDatasetA->getDescriptor();
+    const auto& descriptorB = pDatasetB->getDescriptor();
+    // Rows run north and columns east, as in the metadata (and
+    // copyDataset()).
+    double originXA = 0., originYA = 0., originXB = 0., originYB = 0.;
+    std::tie(originXA, originYA) = descriptorA.getOrigin();
+    std::tie(originXB, originYB) = descriptorB.getOrigin();
+
+    double rowSpacingA = 0., columnSpacingA = 0.;
+    double rowSpacingB = 0., columnSpacingB = 0.;
+    std::tie(rowSpacingA, columnSpacingA) = descriptorA.getGridSpacing();
+    std::tie(rowSpacingB, columnSpacingB) = descriptorB.getGridSpacing();
+
+    m_rowOffset = getNodeOffset(originYA, rowSpacingA, originYB, rowSpacingB);
+    m_columnOffset = getNodeOffset(originXA, columnSpacingA, originXB,
+        columnSpacingB);
+
+    uint32_t rowsA = 0, columnsA = 0, rowsB = 0, columnsB = 0;
+    std::tie(rowsA, columnsA) = descriptorA.getDims();
+    std::tie(rowsB, columnsB) = descriptorB.getDims();
+
+    const auto rowStart = std::max<int64_t>(0, m_rowOffset);
+    const auto rowEnd = std::min<int64_t>(int64_t{rowsA} - 1,
+        m_rowOffset + rowsB - 1);
+    const auto columnStart = std::max<int64_t>(0, m_columnOffset);
+    const auto columnEnd = std::min<int64_t>(int64_t{columnsA} - 1,
+        m_columnOffset + columnsB - 1);
+
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw GridsNotAligned{};
+
+    result.rowStart = static_cast<uint32_t>(rowStart);
+    result.rowEnd = static_cast<uint32_t>(rowEnd);
+    result.columnStart = static_cast<uint32_t>(columnStart);
+    result.columnEnd = static_cast<uint32_t>(columnEnd);
+
+    m_columns = {result.columnStart, result.columnEnd};
+}
+
+//! Can tiles be compared by comparing their stored chunks?
+/*!
+    Chunks stored byte for byte the same hold the same values if the layers
+    have the same type, the same chunks and compression, and the chunks of
+    one line up with the chunks of the other.
+
+\return
+    \e true if tiles can be compared by their stored chunks.
+*/
+bool LayerDiffer::canCompareChunks() const
+{
+    const auto pDescriptorA = m_a.getDescriptor();
+    const auto pDescriptorB = m_b.getDescriptor();
+
+    if (pDescriptorA->getDataType() != pDescriptorB->getDataType() ||
+        pDescriptorA->getChunkDims() != pDescriptorB->getChunkDims() ||
+        pDescriptorA->getCompressionLevel() !=
+            pDescriptorB->getCompressionLevel())
+        return false;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = pDescriptorA->getChunkDims();
+    if (chunkRows == 0 || chunkColumns == 0 ||
+        m_rowOffset % static_cast<int64_t>(chunkRows) != 0 ||
+        m_columnOffset % static_cast<int64_t>(chunkColumns) != 0)
+        return false;
+
+    // Stored chunks cannot be read while other processes may write them.
+    const auto pDatasetA = m_a.getDataset().lock();
+    const auto pDatasetB = m_b.getDataset().lock();
+    if (pDatasetA->isParallel() || pDatasetB->isParallel())
+        return false;
+
+    // Chunks still in the chunk caches are not stored yet.
+    {
+        const auto lock = pDatasetA->lockReads();
+        if (H5Dflush(m_a.m_pH5dataSet->getId()) < 0)
+            return false;
+    }
+    {
+        const auto lock = pDatasetB->lockReads();
+        if (H5Dflush(m_b.m_pH5dataSet->getId()) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+//! Are the chunks of the layers at a node stored byte for byte the same?
+/*!
+    Chunks that were never written are not compared, as the layers may be
+    filled with different values.
+
+\param row
+    The first row of the chunk of the first layer.
+\param column
+    The first column of the chunk of the first layer.
+
+\return
+    \e true if the chunks are the same.
+*/
+bool LayerDiffer::areChunksIdentical(
+    uint32_t row,
+    uint32_t column)
+{
+    uint32_t filterMaskA = 0, filterMaskB = 0;
+
+    {
+        const auto lock = m_a.getDataset().lock()->lockReads();
+        if (!readStoredChunk(*m_a.m_pH5dataSet, row, column, m_storedA,
+            filterMaskA))
+            return false;
+    }
+
+    if (m_storedA.empty())
+        return false;
+
+    {
+        const auto lock = m_b.getDataset().lock()->lockReads();
+        if (!readStoredChunk(*m_b.m_pH5dataSet,
+            static_cast<uint64_t>(row - m_rowOffset),
+            static_cast<uint64_t>(column - m_columnOffset), m_storedB,
+            filterMaskB))
+            return false;
+    }
+
+    return filterMaskA == filterMaskB && m_storedA == m_storedB;
+}
+
+//! Compare a band of the layers.
+/*!
+    Each tile of the band is compared on a thread of its own, and the
+    differences are gathered in order of the tiles.
+
+\param bandStart
+    The first row of the band, in the first layer.
+\param bandEnd
+    The last row of the band (inclusive).
+\param result
+    The differences found so far; those of the band are added.
+*/
+void LayerDiffer::diffBand(
+    uint32_t bandStart,
+    uint32_t bandEnd,
+    LayerDiff& result)
+{
+    const auto rows = bandEnd - bandStart + 1;
+    const auto columns = m_columns[1] - m_columns[0] + 1;
+    const auto bandCells = static_cast<size_t>(rows) * columns;
+    const auto rowStrideBytes = columns * sizeof(float);
+
+    const auto firstTileColumn = m_columns[0] / m_tileDims[1];
+    const auto lastTileColumn = m_columns[1] / m_tileDims[1];
+    const auto numTiles = lastTileColumn - firstTileColumn + 1;
+
+    // The first and last columns of each tile, inside the shared window.
+    const auto tileColumns = [&](uint32_t tile) {
+        const auto tileColumn = firstTileColumn + tile;
+        return std::array<uint32_t, 2>{
+            std::max(m_columns[0], tileColumn * m_tileDims[1]),
+            static_cast<uint32_t>(std::min<uint64_t>(m_columns[1],
+                (uint64_t{tileColumn} + 1) * m_tileDims[1] - 1))};
+    };
+
+    std::vector<char> identical(numTiles, 0);
+    if (m_compareChunks)
+        for (uint32_t tile=0; tile<numTiles; ++tile)
+            identical[tile] = this->areChunksIdentical(
+                bandStart / m_tileDims[0] * m_tileDims[0],
+                (firstTileColumn + tile) * m_tileDims[1]);
+
+    m_bandA.resize(bandCells);
+    m_bandB.resize(bandCells);
+    if (m_pDifference)
+        m_bandDifference.resize(bandCells);
+
+    m_a.readAsInto(bandStart, m_columns[0], bandEnd, m_columns[1], DT_FLOAT32,
+        reinterpret_cast<uint8_t*>(m_bandA.data()), rowStrideBytes);
+
+    // The second layer is read in runs of tiles that are not identical.
+    for (uint32_t tile=0; tile<numTiles; )
+    {
+        if (identical[tile])
+        {
+            ++tile;
+            continue;
+        }
+
+        auto last = tile;
+        while (last + 1 < numTiles && !identical[last + 1])
+            ++last;
+
+        const auto columnStart = tileColumns(tile)[0];
+        const auto columnEnd = tileColumns(last)[1];
+
+        m_b.readAsInto(static_cast<uint32_t>(bandStart - m_rowOffset),
+            static_cast<uint32_t>(columnStart - m_columnOffset),
+            static_cast<uint32_t>(bandEnd - m_rowOffset),
+            static_cast<uint32_t>(columnEnd - m_columnOffset), DT_FLOAT32,
+            reinterpret_cast<uint8_t*>(m_bandB.data() +
+                (columnStart - m_columns[0])), rowStrideBytes);
+
+        tile = last + 1;
+    }
+
+    std::vector<TileDiff> tiles(numTiles);
+
+    processInBlocks(0, numTiles - 1, m_tileDims[0] * m_tileDims[1],
+        [&](uint32_t first, uint32_t last) {
+            for (auto tile=first; tile<=last; ++tile)
+            {
+                const auto tileWindow = tileColumns(tile);
+                this->diffTile(bandStart, bandEnd, tileWindow[0],
+                    tileWindow[1], identical[tile] != 0, tiles[tile]);
+            }
+        });
+
+    for (uint32_t tile=0; tile<numTiles; ++tile)
+    {
+        const auto& tileDiff = tiles[tile];
+
+        result.count += tileDiff.count;
+        result.numChanged += tileDiff.numChanged;
+        result.numAdded += tileDiff.numAdded;
+        result.numRemoved += tileDiff.numRemoved;
+        m_moments.merge(tileDiff.moments);
+        m_min = std::min(m_min, tileDiff.min);
+        m_max = std::max(m_max, tileDiff.max);
+
+        if (tileDiff.region.numChanged > 0)
+            result.regions.push_back(tileDiff.region);
+
+        if (identical[tile])
+            ++result.numIdenticalChunks;
+    }
+
+    if (m_pDifference)
+        m_pDifference->write(bandStart, m_columns[0], bandEnd, m_columns[1],
+            reinterpret_cast<const uint8_t*>(m_bandDifference.data()));
+}
+
+//! Compare a tile of a band.
+/*!
+\param bandStart
+    The first row of the band, in the first layer.
+\param bandEnd
+    The last row of the band (inclusive).
+\param columnStart
+    The first column of the tile, in the first layer.
+\param columnEnd
+    The last column of the tile (inclusive).
+\param identical
+    Are the chunks of the tile the same in both layers?  The second layer
+    was not read if they are.
+\param tile
+    Set to the differences found.
+*/
+void LayerDiffer::diffTile(
+    uint32_t bandStart,
+    uint32_t bandEnd,
+    uint32_t columnStart,
+    uint32_t columnEnd,
+    bool identical,
+    TileDiff& tile) noexcept
+{
+    const auto columns = m_columns[1] - m_columns[0] + 1;
+    const auto threshold = m_options.threshold;
+
+    auto& region = tile.region;
+    region.rowStart = std::numeric_limits<uint32_t>::max();
+    region.columnStart = std::numeric_limits<uint32_t>::max();
+
+    for (auto row=bandStart; row<=bandEnd; ++row)
+    {
+        const auto rowOffset = static_cast<size_t>(row - bandStart) * columns;
+
+        for (auto column=columnStart; column<=columnEnd; ++column)
+        {
+            const auto index = rowOffset + (column - m_columns[0]);
+            const auto valueA = m_bandA[index];
+            const bool nullA = isNullValue(valueA, m_nullA);
+
+            float difference = m_nullDifference;
+            bool changed = false;
+
+            if (identical)
+            {
+                if (!nullA)
+                {
+                    difference = 0.f;
+                    ++tile.count;
+                }
+            }
+            else
+            {
+                const auto valueB = m_bandB[index];
+                const bool nullB = isNullValue(valueB, m_nullB);
+
+                if (!nullA && !nullB)
+                {
+                    const auto delta = static_cast<double>(valueB) - valueA;
+                    difference = static_cast<float>(delta);
+
+                    ++tile.count;
+                    tile.moments.add(delta);
+                    tile.min = std::min(tile.min, delta);
+                    tile.max = std::max(tile.max, delta);
+
+                    if (std::abs(delta) > threshold)
+                    {
+                        ++tile.numChanged;
+                        region.maxChange = std::max(region.maxChange,
+                            std::abs(delta));
+                        changed = true;
+                    }
+                }
+                else if (nullA != nullB)
+                {
+                    if (nullA)
+                        ++tile.numAdded;
+                    else
+                        ++tile.numRemoved;
+                    changed = true;
+                }
+            }
+
+            if (m_pDifference)
+                m_bandDifference[index] = difference;
+
+            if (changed)
+            {
+                ++region.numChanged;
+                region.rowStart = std::min(region.rowStart, row);
+                region.rowEnd = std::max(region.rowEnd, row);
+                region.columnStart = std::min(region.columnStart, column);
+                region.columnEnd = std::max(region.columnEnd, column);
+            }
+        }
+    }
+
+    // The nodes of an identical tile all differ by 0.
+    if (identical && tile.count > 0)
+    {
+        tile.moments.count = tile.count;
+        tile.min = 0.;
+        tile.max = 0.;
+    }
+}
+
+//! Compare two simple layers, node by node.
+/*!
+    The grids may be the same, or offset from one another by whole nodes;
+    they are compared where they overlap, at the nodes of the first layer.
+    A GridsNotAligned exception is thrown if their spacings differ, their
+    nodes do not line up, or they do not overlap.  Layers of other than
+    32 bit floats are compared as floats.
+
+    The layers are read in lock step, a row of tiles of the first layer at
+    a time, and the tiles of a row are compared on several threads, so
+    memory use is bounded whatever the size of the layers.  When both
+    layers are chunked alike and their chunks line up, a tile whose chunks
+    are stored byte for byte the same in both is not read from the second
+    layer nor compared; its nodes differ by 0.  The stored chunks are
+    compared whole rather than by a checksum, as they are read either way.
+
+    A node that is null (or NaN) in both layers is not counted.  One null
+    only in the first layer was added, and one null only in the second was
+    removed; both count as changed in the regions.
+
+    If options.progress is cancelled, the differences of the bands compared
+    so far are kept in pDifference.
+
+\param a
+    The first layer.
+\param b
+    The second layer.
+\param options
+    How the layers are compared.
+\param pDifference
+    A 32 bit float layer in a BAG with the grid of the first layer, to write
+    the differences (b - a) at the shared nodes to; null where either layer
+    is.  nullptr if the differences are not written.  It must not be a or b.
+
+\return
+    The differences.
+*/
+LayerDiff diffLayers(
+    const SimpleLayer& a,
+    const SimpleLayer& b,
+    const DiffOptions& options,
+    SimpleLayer* pDifference)
+{
+    return LayerDiffer{a, b, options, pDifference}.diff();
+}
+
+//! Find the chunks that differ between two versions of a BAG.
+/*!
+    Chunks are matched by the path of their DataSet and their offset.  Two
+    chunks differ if their hashes, or how they were hashed, do.  Copying the
+    chunks added and modified from the second BAG, as stored, and removing
+    those removed, makes the first BAG's DataSets match the second's; the
+    DataSets themselves must be alike.
+
+\param from
+    The hashes of the chunks of the first BAG, from Dataset::hashChunks() or
+    Dataset::readChunkHashes().
+\param to
+    The hashes of the chunks of the second BAG.
+
+\return
+    The chunks added and modified, in the order of to, then those removed,
+    in the order of from.
+*/
+std::vector<ChunkDelta> diffChunkHashes(
+    const std::vector<ChunkHash>& from,
+    const std::vector<ChunkHash>& to)
+{
+    using ChunkKey = std::pair<std::string, std::vector<uint64_t>>;
+
+    std::map<ChunkKey, const ChunkHash*> remaining;
+    for (const auto& hash : from)
+        remaining.emplace(ChunkKey{hash.path, hash.offset}, &hash);
+
+    std::vector<ChunkDelta> deltas;
+
+    const auto addDelta = [&deltas](const ChunkHash& hash, ChunkChange change) {
+        ChunkDelta delta;
+        delta.path = hash.path;
+        delta.offset = hash.offset;
+        delta.change = change;
+        deltas.push_back(std::move(delta));
+    };
+
+    for (const auto& hash : to)
+    {
+        const auto found = remaining.find(ChunkKey{hash.path, hash.offset});
+        if (found == remaining.end())
+        {
+            addDelta(hash, ChunkChange::Added);
+            continue;
+        }
+
+        const auto& old = *found->second;
+        if (old.hash != hash.hash || old.size != hash.size ||
+            old.stored != hash.stored || old.filterMask != hash.filterMask)
+            addDelta(hash, ChunkChange::Modified);
+
+        remaining.erase(found);
+    }
+
+    for (const auto& hash : from)
+        if (remaining.count(ChunkKey{hash.path, hash.offset}) > 0)
+            addDelta(hash, ChunkChange::Removed);
+
+    return deltas;
+}
+
+}  // namespace BAG
+
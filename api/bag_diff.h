@@ -0,0 +1,22 @@
+#ifndef BAG_DIFF_H
+#define BAG_DIFF_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <vector>
+
+
+namespace BAG {
+
+BAG_API LayerDiff diffLayers(const SimpleLayer& a, const SimpleLayer& b,
+    const DiffOptions& options = {}, SimpleLayer* pDifference = nullptr);
+
+BAG_API std::vector<ChunkDelta> diffChunkHashes(
+    const std::vector<ChunkHash>& from, const std::vector<ChunkHash>& to);
+
+}  // namespace BAG
+
+#endif  // BAG_DIFF_H
+
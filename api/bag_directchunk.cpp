@@ -0,0 +1,788 @@
+
+#include "bag_directchunk.h"
+#include "bag_parallel.h"
+#include "bag_private.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>  // memcpy
+#include <H5Cpp.h>
+#include <new>
+#include <vector>
+#include <zlib.h>
+
+
+namespace BAG {
+
+namespace {
+
+//! A chunk being decompressed by a direct read.
+struct DirectReadChunk final
+{
+    //! The chunk as stored in the file.
+    std::vector<uint8_t> stored;
+    //! The number of bytes of stored used; 0 if the chunk is not allocated.
+    size_t storedSize = 0;
+    //! The filter mask of the stored chunk.
+    uint32_t filterMask = 0;
+    //! The inflated chunk.
+    std::vector<uint8_t> inflated;
+    //! The unshuffled chunk.
+    std::vector<uint8_t> unshuffled;
+    //! Could the chunk not be decompressed?
+    bool failed = false;
+};
+
+//! A chunk being compressed by a direct write.
+struct DirectWriteChunk final
+{
+    //! The elements of the chunk; the parts past the area written are 0.
+    std::vector<uint8_t> raw;
+    //! The shuffled bytes of raw.
+    std::vector<uint8_t> shuffled;
+    //! The deflated chunk.
+    std::vector<uint8_t> deflated;
+    //! The data to write; one of the above.
+    const uint8_t* data = nullptr;
+    //! The number of bytes of data.
+    size_t size = 0;
+    //! The filter mask of data.
+    uint32_t filterMask = 0;
+    //! Did deflate run out of memory?
+    bool failed = false;
+    //! Is the chunk allocated in the file?
+    bool allocated = true;
+    //! Is the chunk left unallocated, as it holds only the fill value?
+    bool skipped = false;
+};
+
+}  // namespace
+
+//! Find the filters of a DataSet, and whether the library can apply them.
+/*!
+\param h5createPropList
+    The creation property list of the DataSet.
+
+\return
+    The filters.
+*/
+DirectChunkFilters getDirectChunkFilters(
+    const ::H5::DSetCreatPropList& h5createPropList)
+{
+    DirectChunkFilters filters;
+
+    const auto numFilters = h5createPropList.getNfilters();
+    for (int i=0; i<numFilters; ++i)
+    {
+        unsigned int flags = 0;
+        size_t cdNelmts = 10;
+        constexpr size_t nameLen = 64;
+        std::array<unsigned int, 10> cdValues{};
+        std::array<char, 64> name{};
+        unsigned int filterConfig = 0;
+
+        const auto filter = h5createPropList.getFilter(i, flags, cdNelmts,
+            cdValues.data(), nameLen, name.data(), filterConfig);
+
+        if (filter == H5Z_FILTER_SHUFFLE && i == 0)
+        {
+            filters.shuffle = true;
+            filters.shuffleMask = 1u << i;
+        }
+        else if (filter == H5Z_FILTER_DEFLATE && i == numFilters - 1 &&
+            cdNelmts >= 1 && cdValues.front() <= kMaxCompressionLevel)
+        {
+            filters.deflateLevel = static_cast<int>(cdValues.front());
+            filters.deflateOptional = (flags & H5Z_FLAG_OPTIONAL) != 0;
+            filters.deflateMask = 1u << i;
+        }
+        else
+            return filters;
+    }
+
+    filters.supported = true;
+
+    return filters;
+}
+
+//! Shuffle the bytes of elements the way the HDF5 shuffle filter does.
+/*!
+\param source
+    The elements.
+\param size
+    The number of bytes in source.
+\param elementSize
+    The size of an element.
+\param destination
+    Set to the first byte of every element, then the second and so on.
+*/
+void shuffleBytes(
+    const uint8_t* source,
+    size_t size,
+    size_t elementSize,
+    uint8_t* destination) noexcept
+{
+    const auto numElements = size / elementSize;
+
+    for (size_t byte=0; byte<elementSize; ++byte)
+    {
+        auto* to = destination + byte * numElements;
+        for (size_t i=0; i<numElements; ++i)
+            to[i] = source[i * elementSize + byte];
+    }
+
+    // Like the filter, leave any partial element at the end as it is.
+    const auto tail = numElements * elementSize;
+    std::memcpy(destination + tail, source + tail, size - tail);
+}
+
+//! Undo shuffleBytes().
+/*!
+\param source
+    The shuffled bytes.
+\param size
+    The number of bytes in source.
+\param elementSize
+    The size of an element.
+\param destination
+    Set to the elements.
+*/
+void unshuffleBytes(
+    const uint8_t* source,
+    size_t size,
+    size_t elementSize,
+    uint8_t* destination) noexcept
+{
+    const auto numElements = size / elementSize;
+
+    for (size_t byte=0; byte<elementSize; ++byte)
+    {
+        const auto* from = source + byte * numElements;
+        for (size_t i=0; i<numElements; ++i)
+            destination[i * elementSize + byte] = from[i];
+    }
+
+    const auto tail = numElements * elementSize;
+    std::memcpy(destination + tail, source + tail, size - tail);
+}
+
+//! Read an area of a 2D DataSet, decompressing its chunks on several threads.
+/*!
+    HDF5 decompresses the chunks of a read one at a time, on the calling
+    thread.  When the area touches at least kMinDirectReadChunks chunks, and
+    they are deflated (and maybe shuffled), the raw chunks are instead read
+    with H5Dread_chunk() a band of chunk rows at a time, then decompressed
+    and copied into the buffer on several threads.
+
+\param h5dataSet
+    The chunked 2D DataSet.
+\param h5memType
+    The type of the elements in the buffer; it must match the file type.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The buffer to read into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in the buffer;
+    0 if they are packed.
+\param pStats
+    The statistics to add the time spent reading and decompressing to;
+    nullptr if they are not collected.
+
+\return
+    \e true if the area was read.
+    \e false if it must be read through HDF5; the buffer may be partly
+    filled.
+*/
+bool readChunksDirect(
+    const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes,
+    IoStats* pStats)
+{
+#if !H5_VERSION_GE(1, 10, 5)
+    // H5Dget_chunk_info_by_coord() is not available.
+    (void)pStats;
+    return false;
+#else
+    // Direct reads are not converted to the type in memory.
+    if (!(h5dataSet.getDataType() == h5memType))
+        return false;
+
+    const auto h5createPropList = h5dataSet.getCreatePlist();
+    if (h5createPropList.getLayout() != H5D_CHUNKED)
+        return false;
+
+    std::array<hsize_t, kRank> chunkDims{};
+    if (h5createPropList.getChunk(kRank, chunkDims.data()) != kRank)
+        return false;
+
+    // Without deflate there is nothing worth doing on other threads.
+    const auto filters = getDirectChunkFilters(h5createPropList);
+    if (!filters.supported || filters.deflateLevel < 0)
+        return false;
+
+    const uint64_t chunkRows = chunkDims[0];
+    const uint64_t chunkColumns = chunkDims[1];
+    const auto firstChunkRow = rowStart / chunkRows;
+    const auto firstChunkColumn = columnStart / chunkColumns;
+    const auto numChunkRows = static_cast<uint32_t>(
+        rowEnd / chunkRows - firstChunkRow + 1);
+    const auto numChunkColumns = static_cast<uint32_t>(
+        columnEnd / chunkColumns - firstChunkColumn + 1);
+
+    if (static_cast<size_t>(numChunkRows) * numChunkColumns <
+        kMinDirectReadChunks)
+        return false;
+
+    const size_t elementSize = h5memType.getSize();
+    const auto chunkCells = chunkRows * chunkColumns;
+    const auto chunkBytes = static_cast<size_t>(chunkCells * elementSize);
+
+    if (rowStrideBytes == 0)
+        rowStrideBytes = (columnEnd - columnStart + 1) * elementSize;
+
+    // Chunks written through HDF5 may still be in its chunk cache.
+    if (H5Dflush(h5dataSet.getId()) < 0)
+        return false;
+
+    // Chunks that were never written hold the fill value.
+    std::vector<uint8_t> fillValue(elementSize);
+    h5createPropList.getFillValue(h5memType, fillValue.data());
+
+    // A couple of chunks for each thread, in whole chunk rows.
+    const auto maxThreads = getConcurrency();
+    const auto bandChunkRows = std::min(numChunkRows,
+        std::max(1u, (2 * maxThreads + numChunkColumns - 1) / numChunkColumns));
+
+    // Allocate up front, as the threads must not throw.
+    std::vector<DirectReadChunk> chunks(
+        static_cast<size_t>(bandChunkRows) * numChunkColumns);
+    for (auto& chunk : chunks)
+    {
+        chunk.inflated.resize(chunkBytes);
+
+        if (filters.shuffle)
+            chunk.unshuffled.resize(chunkBytes);
+    }
+
+    const auto decodeChunk = [&](DirectReadChunk& chunk, uint64_t chunkRow,
+        uint64_t chunkColumn) noexcept {
+        // The part of the chunk in the area read.
+        const auto chunkRowStart = chunkRow * chunkRows;
+        const auto chunkColumnStart = chunkColumn * chunkColumns;
+        const auto fromRow = std::max<uint64_t>(chunkRowStart, rowStart);
+        const auto toRow = std::min<uint64_t>(chunkRowStart + chunkRows - 1,
+            rowEnd);
+        const auto fromColumn = std::max<uint64_t>(chunkColumnStart,
+            columnStart);
+        const auto toColumn = std::min<uint64_t>(
+            chunkColumnStart + chunkColumns - 1, columnEnd);
+        const auto copyBytes = (toColumn - fromColumn + 1) * elementSize;
+
+        if (chunk.storedSize == 0)
+        {
+            for (auto row=fromRow; row<=toRow; ++row)
+            {
+                auto* to = buffer + (row - rowStart) * rowStrideBytes +
+                    (fromColumn - columnStart) * elementSize;
+                for (size_t offset=0; offset<copyBytes; offset+=elementSize)
+                    std::memcpy(to + offset, fillValue.data(), elementSize);
+            }
+
+            return;
+        }
+
+        const uint8_t* data = chunk.stored.data();
+
+        if ((chunk.filterMask & filters.deflateMask) == 0)
+        {
+            auto inflatedSize = static_cast<uLongf>(chunkBytes);
+            if (uncompress(chunk.inflated.data(), &inflatedSize, data,
+                static_cast<uLong>(chunk.storedSize)) != Z_OK ||
+                inflatedSize != chunkBytes)
+            {
+                chunk.failed = true;
+                return;
+            }
+
+            data = chunk.inflated.data();
+        }
+        else if (chunk.storedSize != chunkBytes)
+        {
+            chunk.failed = true;
+            return;
+        }
+
+        if (filters.shuffle && (chunk.filterMask & filters.shuffleMask) == 0)
+        {
+            unshuffleBytes(data, chunkBytes, elementSize,
+                chunk.unshuffled.data());
+            data = chunk.unshuffled.data();
+        }
+
+        for (auto row=fromRow; row<=toRow; ++row)
+            std::memcpy(buffer + (row - rowStart) * rowStrideBytes +
+                (fromColumn - columnStart) * elementSize,
+                data + ((row - chunkRowStart) * chunkColumns +
+                    (fromColumn - chunkColumnStart)) * elementSize,
+                copyBytes);
+    };
+
+    for (uint32_t bandStart=0; bandStart<numChunkRows; bandStart+=bandChunkRows)
+    {
+        const auto numChunks =
+            std::min(bandChunkRows, numChunkRows - bandStart) * numChunkColumns;
+
+        // HDF5 reads the stored chunks, one at a time.
+        IoTimer readTimer{pStats ? &pStats->hdf5ReadSeconds : nullptr};
+
+        for (uint32_t index=0; index<numChunks; ++index)
+        {
+            auto& chunk = chunks[index];
+            const std::array<hsize_t, kRank> offset{
+                (firstChunkRow + bandStart + index / numChunkColumns) * chunkRows,
+                (firstChunkColumn + index % numChunkColumns) * chunkColumns};
+
+            // A chunk that was never written has no address and size 0.
+            haddr_t address = HADDR_UNDEF;
+            hsize_t storedSize = 0;
+            if (H5Dget_chunk_info_by_coord(h5dataSet.getId(), offset.data(),
+                &chunk.filterMask, &address, &storedSize) < 0)
+                return false;
+
+            chunk.storedSize = static_cast<size_t>(storedSize);
+            chunk.failed = false;
+
+            if (chunk.storedSize == 0)
+                continue;
+
+            if (chunk.stored.size() < chunk.storedSize)
+                chunk.stored.resize(chunk.storedSize);
+
+            if (H5Dread_chunk(h5dataSet.getId(), H5P_DEFAULT, offset.data(),
+                &chunk.filterMask, chunk.stored.data()) < 0)
+                return false;
+
+            if (pStats)
+                pStats->bytesDecompressed += chunkBytes;
+        }
+
+        readTimer.stop();
+        IoTimer decompressTimer{pStats ? &pStats->decompressSeconds : nullptr};
+
+        processInBlocks(0, numChunks - 1, static_cast<uint32_t>(chunkCells),
+            [&](uint32_t first, uint32_t last) {
+                for (auto index=first; index<=last; ++index)
+                    decodeChunk(chunks[index],
+                        firstChunkRow + bandStart + index / numChunkColumns,
+                        firstChunkColumn + index % numChunkColumns);
+            });
+
+        if (std::any_of(chunks.begin(), chunks.begin() + numChunks,
+            [](const DirectReadChunk& chunk) { return chunk.failed; }))
+            return false;
+    }
+
+    return true;
+#endif
+}
+
+//! Write an area of whole chunks of a 2D DataSet, compressing them on
+//! several threads.
+/*!
+    HDF5 compresses the chunks of a write one at a time, on the calling
+    thread.  When the area covers whole chunks, and the only filters are
+    byte shuffling and deflate, the chunks are instead filtered here, a band
+    of chunk rows at a time on several threads, and written in order with
+    H5Dwrite_chunk().
+
+    Chunks at the edge of the DataSet may be partly covered; the rest of
+    them lies outside it.
+
+    A chunk holding only the fill value of the DataSet, which was never
+    written, is left unallocated; reading it returns the fill value all the
+    same.
+
+\param h5dataSet
+    The chunked 2D DataSet; its extent must already cover the area.
+\param h5memType
+    The type of the elements in the buffer; it must match the file type.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The elements to write, row by row.
+
+\return
+    \e true if the area was written.
+    \e false if it must be written through HDF5, and nothing was written.
+*/
+bool writeChunksDirect(
+    const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const uint8_t* buffer)
+{
+#if !H5_VERSION_GE(1, 10, 3)
+    // H5Dwrite_chunk() is not available.
+    return false;
+#else
+    // Direct writes are not converted to the type in the file.
+    if (!(h5dataSet.getDataType() == h5memType))
+        return false;
+
+    const auto h5createPropList = h5dataSet.getCreatePlist();
+    if (h5createPropList.getLayout() != H5D_CHUNKED)
+        return false;
+
+    std::array<hsize_t, kRank> chunkDims{};
+    if (h5createPropList.getChunk(kRank, chunkDims.data()) != kRank)
+        return false;
+
+    std::array<hsize_t, kRank> fileDims{};
+    h5dataSet.getSpace().getSimpleExtentDims(fileDims.data());
+
+    const uint64_t chunkRows = chunkDims[0];
+    const uint64_t chunkColumns = chunkDims[1];
+
+    const auto endsChunk = [](uint64_t end, uint64_t chunk, hsize_t dim) {
+        return (end + 1) % chunk == 0 || end + 1 == dim;
+    };
+
+    if (rowStart % chunkRows != 0 || columnStart % chunkColumns != 0 ||
+        rowEnd >= fileDims[0] || columnEnd >= fileDims[1] ||
+        !endsChunk(rowEnd, chunkRows, fileDims[0]) ||
+        !endsChunk(columnEnd, chunkColumns, fileDims[1]))
+        return false;
+
+    const auto filters = getDirectChunkFilters(h5createPropList);
+    if (!filters.supported)
+        return false;
+
+    const size_t elementSize = h5memType.getSize();
+    const uint64_t rows = (rowEnd - rowStart) + 1;
+    const uint64_t columns = (columnEnd - columnStart) + 1;
+    const auto numChunkRows = static_cast<uint32_t>(
+        (rows + chunkRows - 1) / chunkRows);
+    const auto numChunkColumns = static_cast<uint32_t>(
+        (columns + chunkColumns - 1) / chunkColumns);
+    const auto chunkCells = chunkRows * chunkColumns;
+    const auto chunkBytes = static_cast<size_t>(chunkCells * elementSize);
+
+    // Chunks written through HDF5 may still be in its chunk cache.
+    if (H5Dflush(h5dataSet.getId()) < 0)
+        return false;
+
+    // Chunks holding only the fill value need not be allocated, as they read
+    // back the same.
+    std::vector<uint8_t> fillValue;
+    const bool skipFilled = getUnwrittenChunkValue(h5dataSet, h5memType,
+        fillValue);
+
+    // A couple of chunks for each thread, in whole chunk rows.
+    const auto maxThreads = getConcurrency();
+    const auto bandChunkRows = std::min(numChunkRows,
+        std::max(1u, (2 * maxThreads + numChunkColumns - 1) / numChunkColumns));
+
+    // Allocate up front, as the threads must not throw.
+    std::vector<DirectWriteChunk> chunks(
+        static_cast<size_t>(bandChunkRows) * numChunkColumns);
+    for (auto& chunk : chunks)
+    {
+        chunk.raw.resize(chunkBytes);
+
+        if (filters.shuffle)
+            chunk.shuffled.resize(chunkBytes);
+        if (filters.deflateLevel >= 0)
+            chunk.deflated.resize(compressBound(static_cast<uLong>(chunkBytes)));
+    }
+
+    const auto filterChunk = [&](DirectWriteChunk& chunk, uint64_t firstRow,
+        uint64_t firstColumn) noexcept {
+        const auto numRows = std::min(chunkRows, rows - firstRow);
+        const auto numColumns = std::min(chunkColumns, columns - firstColumn);
+
+        if (numRows < chunkRows || numColumns < chunkColumns)
+            std::fill(chunk.raw.begin(), chunk.raw.end(), uint8_t{0});
+
+        bool filled = skipFilled && !chunk.allocated;
+
+        for (uint64_t row=0; row<numRows; ++row)
+        {
+            const auto* from = buffer + ((firstRow + row) * columns +
+                firstColumn) * elementSize;
+            std::memcpy(chunk.raw.data() + row * chunkColumns * elementSize,
+                from, numColumns * elementSize);
+
+            filled = filled && isFilledWith(from, numColumns * elementSize,
+                fillValue.data(), elementSize);
+        }
+
+        chunk.skipped = filled;
+        if (chunk.skipped)
+            return;
+
+        chunk.data = chunk.raw.data();
+        chunk.size = chunkBytes;
+        chunk.filterMask = 0;
+
+        if (filters.shuffle)
+        {
+            shuffleBytes(chunk.raw.data(), chunkBytes, elementSize,
+                chunk.shuffled.data());
+            chunk.data = chunk.shuffled.data();
+        }
+
+        if (filters.deflateLevel >= 0)
+        {
+            auto deflatedSize = static_cast<uLongf>(chunk.deflated.size());
+            chunk.failed = compress2(chunk.deflated.data(), &deflatedSize,
+                chunk.data, static_cast<uLong>(chunkBytes),
+                filters.deflateLevel) != Z_OK;
+
+            // Like the deflate filter, store a chunk that grew undeflated if
+            // the filter is optional.
+            if (filters.deflateOptional && deflatedSize > chunkBytes)
+                chunk.filterMask = filters.deflateMask;
+            else
+            {
+                chunk.data = chunk.deflated.data();
+                chunk.size = deflatedSize;
+            }
+        }
+    };
+
+    for (uint32_t bandStart=0; bandStart<numChunkRows; bandStart+=bandChunkRows)
+    {
+        const auto numChunks =
+            std::min(bandChunkRows, numChunkRows - bandStart) * numChunkColumns;
+
+        const auto chunkOffset = [&](uint32_t index) {
+            return std::array<hsize_t, kRank>{
+                rowStart + (bandStart + index / numChunkColumns) * chunkRows,
+                columnStart + (index % numChunkColumns) * chunkColumns};
+        };
+
+        // A chunk written before must be overwritten, even with fill values.
+        for (uint32_t index=0; index<numChunks; ++index)
+        {
+            const auto offset = chunkOffset(index);
+            chunks[index].allocated = !skipFilled ||
+                isChunkAllocated(h5dataSet, offset[0], offset[1]);
+        }
+
+        processInBlocks(0, numChunks - 1, static_cast<uint32_t>(chunkCells),
+            [&](uint32_t first, uint32_t last) {
+                for (auto index=first; index<=last; ++index)
+                    filterChunk(chunks[index],
+                        (bandStart + index / numChunkColumns) * chunkRows,
+                        (index % numChunkColumns) * chunkColumns);
+            });
+
+        for (uint32_t index=0; index<numChunks; ++index)
+        {
+            const auto& chunk = chunks[index];
+            if (chunk.failed)
+                throw std::bad_alloc{};
+            if (chunk.skipped)
+                continue;
+
+            const auto offset = chunkOffset(index);
+
+            if (H5Dwrite_chunk(h5dataSet.getId(), H5P_DEFAULT,
+                chunk.filterMask, offset.data(), chunk.size, chunk.data) < 0)
+                throw ::H5::DataSetIException{"writeChunksDirect",
+                    "H5Dwrite_chunk failed"};
+        }
+    }
+
+    return true;
+#endif
+}
+
+//! Read a chunk of a 2D DataSet as it is stored in the file.
+/*!
+    The chunk is not decompressed, so two chunks can be compared without
+    decompressing either.  The DataSet must have been flushed (H5Dflush()),
+    so no chunk is only in the chunk cache.
+
+\param h5dataSet
+    The chunked DataSet.
+\param rowStart
+    The first row of the chunk.
+\param columnStart
+    The first column of the chunk.
+\param stored
+    Set to the chunk as stored; empty if the chunk was never written.
+\param filterMask
+    Set to the filter mask of the chunk.
+
+\return
+    \e true if the chunk was read.
+    \e false if stored chunks cannot be read with this version of HDF5.
+*/
+bool readStoredChunk(
+    const ::H5::DataSet& h5dataSet,
+    uint64_t rowStart,
+    uint64_t columnStart,
+    std::vector<uint8_t>& stored,
+    uint32_t& filterMask)
+{
+#if !H5_VERSION_GE(1, 10, 5)
+    // H5Dget_chunk_info_by_coord() is not available.
+    (void)h5dataSet;
+    (void)rowStart;
+    (void)columnStart;
+    (void)stored;
+    (void)filterMask;
+    return false;
+#else
+    const std::array<hsize_t, kRank> offset{rowStart, columnStart};
+
+    // A chunk that was never written has no address and size 0.
+    haddr_t address = HADDR_UNDEF;
+    hsize_t storedSize = 0;
+    if (H5Dget_chunk_info_by_coord(h5dataSet.getId(), offset.data(),
+        &filterMask, &address, &storedSize) < 0)
+        throw ::H5::DataSetIException{"readStoredChunk",
+            "H5Dget_chunk_info_by_coord failed"};
+
+    stored.resize(static_cast<size_t>(storedSize));
+    if (storedSize == 0)
+        return true;
+
+    if (H5Dread_chunk(h5dataSet.getId(), H5P_DEFAULT, offset.data(),
+        &filterMask, stored.data()) < 0)
+        throw ::H5::DataSetIException{"readStoredChunk",
+            "H5Dread_chunk failed"};
+
+    return true;
+#endif
+}
+
+//! Find the value read from chunks of a DataSet that were never written.
+/*!
+\param h5dataSet
+    The chunked DataSet.
+\param h5memType
+    The type of the elements; it must match the file type.
+\param fillValue
+    Set to the fill value of the DataSet.
+
+\return
+    \e true if chunks never written read as the fill value.
+    \e false if what they read as is undefined, so every chunk must be
+    written.
+*/
+bool getUnwrittenChunkValue(
+    const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType,
+    std::vector<uint8_t>& fillValue)
+{
+    const auto h5createPropList = h5dataSet.getCreatePlist();
+
+    H5D_fill_value_t status = H5D_FILL_VALUE_UNDEFINED;
+    if (H5Pfill_value_defined(h5createPropList.getId(), &status) < 0 ||
+        status == H5D_FILL_VALUE_UNDEFINED ||
+        h5createPropList.getFillTime() == H5D_FILL_TIME_NEVER)
+        return false;
+
+    fillValue.resize(h5memType.getSize());
+    h5createPropList.getFillValue(h5memType, fillValue.data());
+
+    return true;
+}
+
+//! Determine whether a chunk of a 2D DataSet is allocated in the file.
+/*!
+    The DataSet must have been flushed (H5Dflush()), so no chunk is only in
+    the chunk cache.
+
+\param h5dataSet
+    The chunked DataSet.
+\param rowStart
+    The first row of the chunk.
+\param columnStart
+    The first column of the chunk.
+
+\return
+    \e true if the chunk is allocated, or this version of HDF5 cannot tell.
+    \e false if the chunk was never written.
+*/
+bool isChunkAllocated(
+    const ::H5::DataSet& h5dataSet,
+    uint64_t rowStart,
+    uint64_t columnStart)
+{
+#if !H5_VERSION_GE(1, 10, 5)
+    // H5Dget_chunk_info_by_coord() is not available.
+    (void)h5dataSet;
+    (void)rowStart;
+    (void)columnStart;
+    return true;
+#else
+    const std::array<hsize_t, kRank> offset{rowStart, columnStart};
+
+    uint32_t filterMask = 0;
+    haddr_t address = HADDR_UNDEF;
+    hsize_t storedSize = 0;
+    if (H5Dget_chunk_info_by_coord(h5dataSet.getId(), offset.data(),
+        &filterMask, &address, &storedSize) < 0)
+        throw ::H5::DataSetIException{"isChunkAllocated",
+            "H5Dget_chunk_info_by_coord failed"};
+
+    return address != HADDR_UNDEF;
+#endif
+}
+
+//! Determine whether every element of a buffer is the same value.
+/*!
+    The first element is compared to the value, then the buffer to itself
+    shifted by one element; memcmp() compares many bytes at a time.
+
+\param data
+    The elements.
+\param size
+    The number of bytes in data; a multiple of valueSize.
+\param value
+    The value.
+\param valueSize
+    The size of the value.
+
+\return
+    \e true if every element of data is the value.
+*/
+bool isFilledWith(
+    const uint8_t* data,
+    size_t size,
+    const uint8_t* value,
+    size_t valueSize) noexcept
+{
+    if (size < valueSize)
+        return size == 0;
+
+    return std::memcmp(data, value, valueSize) == 0 &&
+        std::memcmp(data, data + valueSize, size - valueSize) == 0;
+}
+
+}  // namespace BAG
@@ -0,0 +1,78 @@
+#ifndef BAG_DIRECTCHUNK_H
+#define BAG_DIRECTCHUNK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+//! Forward declarations of HDF5 classes used, to avoid exposing dependencies
+//! to users of this library.
+namespace H5 {
+
+class DataSet;
+class DataType;
+class DSetCreatPropList;
+
+}  // namespace H5
+
+
+namespace BAG {
+
+struct IoStats;
+
+//! The fewest chunks a read must touch to decompress them on several threads.
+constexpr size_t kMinDirectReadChunks = 8;
+
+//! The filters of a chunked DataSet, if they can be applied by the library.
+/*!
+    The library can apply byte shuffling followed by deflate, or either
+    alone, to read and write raw chunks with H5Dread_chunk() and
+    H5Dwrite_chunk().  That lets the chunks be compressed and decompressed on
+    several threads, where HDF5 filters them one at a time.
+*/
+struct DirectChunkFilters final
+{
+    //! Are all the filters ones the library can apply itself?
+    bool supported = false;
+    //! Are the bytes shuffled before deflating?
+    bool shuffle = false;
+    //! The filter mask of a chunk stored without shuffling it.
+    uint32_t shuffleMask = 0;
+    //! The deflate level; negative if the chunks are not deflated.
+    int deflateLevel = -1;
+    //! May a chunk be stored without deflating it?
+    bool deflateOptional = false;
+    //! The filter mask of a chunk stored without deflating it.
+    uint32_t deflateMask = 0;
+};
+
+DirectChunkFilters getDirectChunkFilters(
+    const ::H5::DSetCreatPropList& h5createPropList);
+
+void shuffleBytes(const uint8_t* source, size_t size, size_t elementSize,
+    uint8_t* destination) noexcept;
+void unshuffleBytes(const uint8_t* source, size_t size, size_t elementSize,
+    uint8_t* destination) noexcept;
+
+bool readChunksDirect(const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType, uint32_t rowStart, uint32_t columnStart,
+    uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+    size_t rowStrideBytes, IoStats* pStats = nullptr);
+bool writeChunksDirect(const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType, uint32_t rowStart, uint32_t columnStart,
+    uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer);
+bool readStoredChunk(const ::H5::DataSet& h5dataSet, uint64_t rowStart,
+    uint64_t columnStart, std::vector<uint8_t>& stored, uint32_t& filterMask);
+
+bool getUnwrittenChunkValue(const ::H5::DataSet& h5dataSet,
+    const ::H5::DataType& h5memType, std::vector<uint8_t>& fillValue);
+bool isChunkAllocated(const ::H5::DataSet& h5dataSet, uint64_t rowStart,
+    uint64_t columnStart);
+bool isFilledWith(const uint8_t* data, size_t size, const uint8_t* value,
+    size_t valueSize) noexcept;
+
+}  // namespace BAG
+
+#endif  // BAG_DIRECTCHUNK_H
+
@@ -0,0 +1,594 @@
+
+#include "bag_dataset.h"
+#include "bag_editsession.h"
+#include "bag_exceptions.h"
+#include "bag_layer.h"
+#include "bag_layerdescriptor.h"
+#include "bag_simplelayer.h"
+#include "bag_trackinglist.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+
+namespace BAG {
+
+namespace {
+
+//! The rows and columns of the chunks edited in a layer that is not chunked.
+constexpr uint32_t kUnchunkedEditSize = 256;
+
+//! Visit the rows of the intersection of a window and a chunk.
+/*!
+\param rowStart
+    The starting row of the window.
+\param columnStart
+    The starting column of the window.
+\param rowEnd
+    The ending row of the window (inclusive).
+\param columnEnd
+    The ending column of the window (inclusive).
+\param firstRow
+    The first row of the chunk.
+\param firstColumn
+    The first column of the chunk.
+\param lastRow
+    The last row of the chunk.
+\param lastColumn
+    The last column of the chunk.
+\param elementSize
+    The size of an element, in bytes.
+\param copy
+    Called with the offset of each row in the window, in the chunk, and its
+    size, all in bytes.
+*/
+template <typename Copy>
+void forEachIntersectionRow(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint32_t firstRow,
+    uint32_t firstColumn,
+    uint32_t lastRow,
+    uint32_t lastColumn,
+    size_t elementSize,
+    Copy copy)
+{
+    const auto windowColumns = size_t{columnEnd} - columnStart + 1;
+    const auto chunkColumns = size_t{lastColumn} - firstColumn + 1;
+
+    const auto column0 = std::max(columnStart, firstColumn);
+    const auto column1 = std::min(columnEnd, lastColumn);
+    const auto rowBytes = (size_t{column1} - column0 + 1) * elementSize;
+
+    for (auto row=std::max(rowStart, firstRow); row<=std::min(rowEnd, lastRow);
+        ++row)
+        copy(((row - rowStart) * windowColumns + (column0 - columnStart)) *
+            elementSize, ((row - firstRow) * chunkColumns +
+            (column0 - firstColumn)) * elementSize, rowBytes);
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+    A ReadOnlyError exception is thrown if the BAG is read only.
+
+\param dataset
+    The BAG to edit.
+*/
+EditSession::EditSession(
+    Dataset& dataset)
+    : m_dataset(dataset)
+{
+    if (m_dataset.getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    std::tie(m_numRows, m_numColumns) = m_dataset.getDescriptor().getDims();
+}
+
+//! Read a section of a simple layer, with the edits made to it.
+/*!
+    The BAG is only read if the section is not all in edited chunks.
+
+    A LayerNotFound exception is thrown if the BAG has no such layer.  An
+    InvalidReadSize exception is thrown if the section is not within the
+    grid.
+
+\param type
+    The type of the simple layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The section, row major.
+*/
+UInt8Array EditSession::read(
+    LayerType type,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    if (!this->isInGrid(rowStart, columnStart, rowEnd, columnEnd))
+        throw InvalidReadSize{};
+
+    const auto found = m_overlays.find(type);
+    if (found == m_overlays.end())
+    {
+        const auto pLayer = m_dataset.getSimpleLayer(type);
+        if (!pLayer)
+            throw LayerNotFound{};
+
+        return pLayer->read(rowStart, columnStart, rowEnd, columnEnd);
+    }
+
+    const auto& overlay = found->second;
+
+    const auto firstChunkRow = rowStart / overlay.chunkRows;
+    const auto lastChunkRow = rowEnd / overlay.chunkRows;
+    const auto firstChunkColumn = columnStart / overlay.chunkColumns;
+    const auto lastChunkColumn = columnEnd / overlay.chunkColumns;
+
+    bool allEdited = true;
+    for (auto chunkRow=firstChunkRow; chunkRow<=lastChunkRow && allEdited;
+        ++chunkRow)
+        for (auto chunkColumn=firstChunkColumn; chunkColumn<=lastChunkColumn;
+            ++chunkColumn)
+            if (!overlay.chunks.count(uint64_t{chunkRow} *
+                overlay.numChunkColumns + chunkColumn))
+            {
+                allEdited = false;
+                break;
+            }
+
+    auto result = allEdited ?
+        UInt8Array::uninitialized((size_t{rowEnd} - rowStart + 1) *
+            (size_t{columnEnd} - columnStart + 1) * overlay.elementSize) :
+        overlay.pLayer->read(rowStart, columnStart, rowEnd, columnEnd);
+
+    for (auto chunkRow=firstChunkRow; chunkRow<=lastChunkRow; ++chunkRow)
+        for (auto chunkColumn=firstChunkColumn; chunkColumn<=lastChunkColumn;
+            ++chunkColumn)
+        {
+            const auto chunk = overlay.chunks.find(uint64_t{chunkRow} *
+                overlay.numChunkColumns + chunkColumn);
+            if (chunk == overlay.chunks.end())
+                continue;
+
+            const auto firstRow = chunkRow * overlay.chunkRows;
+            const auto firstColumn = chunkColumn * overlay.chunkColumns;
+
+            const auto* pChunk = chunk->second.data();
+            auto* pResult = result.data();
+
+            forEachIntersectionRow(rowStart, columnStart, rowEnd, columnEnd,
+                firstRow, firstColumn,
+                std::min(firstRow + overlay.chunkRows, m_numRows) - 1,
+                std::min(firstColumn + overlay.chunkColumns, m_numColumns) - 1,
+                overlay.elementSize,
+                [pChunk, pResult](size_t windowOffset, size_t chunkOffset,
+                    size_t numBytes) {
+                    std::memcpy(pResult + windowOffset, pChunk + chunkOffset,
+                        numBytes);
+                });
+        }
+
+    return result;
+}
+
+//! Write a section of a simple layer, in memory.
+/*!
+    The BAG is written by commit().  The write can be undone.
+
+    A LayerNotFound exception is thrown if the BAG has no such layer.  An
+    InvalidWriteSize exception is thrown if the section is not within the
+    grid, and an InvalidBuffer exception if there is no buffer.
+
+\param type
+    The type of the simple layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The section, row major.
+*/
+void EditSession::write(
+    LayerType type,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const uint8_t* buffer)
+{
+    if (!this->isInGrid(rowStart, columnStart, rowEnd, columnEnd))
+        throw InvalidWriteSize{};
+
+    if (!buffer)
+        throw InvalidBuffer{};
+
+    const auto& overlay = this->getOverlay(type);
+    const auto numBytes = (size_t{rowEnd} - rowStart + 1) *
+        (size_t{columnEnd} - columnStart + 1) * overlay.elementSize;
+
+    const auto before = this->read(type, rowStart, columnStart, rowEnd,
+        columnEnd);
+
+    Edit edit;
+    edit.type = type;
+    edit.rowStart = rowStart;
+    edit.columnStart = columnStart;
+    edit.rowEnd = rowEnd;
+    edit.columnEnd = columnEnd;
+    edit.before.assign(before.data(), before.data() + numBytes);
+    edit.after.assign(buffer, buffer + numBytes);
+
+    this->apply(type, rowStart, columnStart, rowEnd, columnEnd, buffer);
+
+    m_undo.push_back(std::move(edit));
+    m_redo.clear();
+}
+
+//! Add an item to the tracking list, when committed.
+/*!
+    The item can be undone.
+
+\param item
+    The item.
+*/
+void EditSession::addTrackingItem(
+    const BagTrackingItem& item)
+{
+    Edit edit;
+    edit.isWrite = false;
+    edit.item = item;
+
+    m_trackingItems.push_back(item);
+    m_undo.push_back(std::move(edit));
+    m_redo.clear();
+}
+
+//! Retrieve the tracking list items to be added.
+/*!
+\return
+    The items added and not undone, in the order they were added.
+*/
+const std::vector<BagTrackingItem>& EditSession::getTrackingItems() const & noexcept
+{
+    return m_trackingItems;
+}
+
+//! Determine if there is an edit to undo.
+/*!
+\return
+    \e true if undo() can be called.
+*/
+bool EditSession::canUndo() const noexcept
+{
+    return !m_undo.empty();
+}
+
+//! Determine if there is an undone edit to redo.
+/*!
+\return
+    \e true if redo() can be called.
+*/
+bool EditSession::canRedo() const noexcept
+{
+    return !m_redo.empty();
+}
+
+//! Undo the last edit not undone.
+/*!
+    A NothingToUndo exception is thrown if there is none.
+*/
+void EditSession::undo()
+{
+    if (m_undo.empty())
+        throw NothingToUndo{};
+
+    auto& edit = m_undo.back();
+    if (edit.isWrite)
+        this->apply(edit.type, edit.rowStart, edit.columnStart, edit.rowEnd,
+            edit.columnEnd, edit.before.data());
+    else
+        m_trackingItems.pop_back();
+
+    m_redo.push_back(std::move(edit));
+    m_undo.pop_back();
+}
+
+//! Redo the last edit undone.
+/*!
+    A NothingToRedo exception is thrown if there is none, or an edit was
+    made since it was undone.
+*/
+void EditSession::redo()
+{
+    if (m_redo.empty())
+        throw NothingToRedo{};
+
+    auto& edit = m_redo.back();
+    if (edit.isWrite)
+        this->apply(edit.type, edit.rowStart, edit.columnStart, edit.rowEnd,
+            edit.columnEnd, edit.after.data());
+    else
+        m_trackingItems.push_back(edit.item);
+
+    m_undo.push_back(std::move(edit));
+    m_redo.pop_back();
+}
+
+//! Determine if commit() has anything to write.
+/*!
+\return
+    \e true if a chunk was edited, or a tracking list item added.
+*/
+bool EditSession::isDirty() const noexcept
+{
+    return !m_trackingItems.empty() || this->getNumDirtyChunks() > 0;
+}
+
+//! Retrieve the number of chunks commit() will write.
+/*!
+    Chunks stay dirty when their edits are undone; committing them rewrites
+    the values they had.
+
+\return
+    The number of chunks edited, in all layers.
+*/
+size_t EditSession::getNumDirtyChunks() const noexcept
+{
+    size_t numChunks = 0;
+    for (const auto& overlay : m_overlays)
+        numChunks += overlay.second.chunks.size();
+
+    return numChunks;
+}
+
+//! Retrieve the memory held by the session.
+/*!
+\return
+    The bytes held by the chunks edited, the edits that can be undone or
+    redone, and the tracking list items.
+*/
+size_t EditSession::getMemoryUsage() const noexcept
+{
+    size_t numBytes = m_trackingItems.capacity() * sizeof(BagTrackingItem);
+
+    for (const auto& overlay : m_overlays)
+        for (const auto& chunk : overlay.second.chunks)
+            numBytes += chunk.second.capacity();
+
+    for (const auto* pEdits : {&m_undo, &m_redo})
+        for (const auto& edit : *pEdits)
+            numBytes += sizeof(Edit) + edit.before.capacity() +
+                edit.after.capacity();
+
+    return numBytes;
+}
+
+//! Write the edits to the BAG.
+/*!
+    Each chunk edited is written once, in chunk order, and the tracking list
+    items are appended, in one batch (see Dataset::beginBatch()); the
+    attributes of the layers and the tracking list are written once, at the
+    end.  The session is then empty, and its edits can no longer be undone.
+*/
+void EditSession::commit()
+{
+    m_dataset.beginBatch();
+
+    try
+    {
+        for (const auto& entry : m_overlays)
+        {
+            const auto& overlay = entry.second;
+
+            for (const auto& chunk : overlay.chunks)
+            {
+                const auto chunkRow = static_cast<uint32_t>(chunk.first /
+                    overlay.numChunkColumns);
+                const auto chunkColumn = static_cast<uint32_t>(chunk.first %
+                    overlay.numChunkColumns);
+
+                const auto firstRow = chunkRow * overlay.chunkRows;
+                const auto firstColumn = chunkColumn * overlay.chunkColumns;
+
+                overlay.pLayer->write(firstRow, firstColumn,
+                    std::min(firstRow + overlay.chunkRows, m_numRows) - 1,
+                    std::min(firstColumn + overlay.chunkColumns,
+                        m_numColumns) - 1,
+                    chunk.second.data());
+            }
+        }
+
+        if (!m_trackingItems.empty())
+        {
+            auto& trackingList = m_dataset.getTrackingList();
+            trackingList.reserve(trackingList.size() + m_trackingItems.size());
+
+            for (const auto& item : m_trackingItems)
+                trackingList.push_back(item);
+
+            trackingList.write();
+        }
+    }
+    catch (...)
+    {
+        m_dataset.commit();
+        throw;
+    }
+
+    m_dataset.commit();
+
+    this->discard();
+}
+
+//! Forget the edits, without writing them.
+void EditSession::discard() noexcept
+{
+    m_overlays.clear();
+    m_trackingItems.clear();
+    m_undo.clear();
+    m_redo.clear();
+}
+
+//! Retrieve the edited chunks of a simple layer, starting them if needed.
+/*!
+    A LayerNotFound exception is thrown if the BAG has no such layer.
+
+\param type
+    The type of the simple layer.
+
+\return
+    The edited chunks of the layer.
+*/
+EditSession::LayerOverlay& EditSession::getOverlay(
+    LayerType type)
+{
+    const auto found = m_overlays.find(type);
+    if (found != m_overlays.end())
+        return found->second;
+
+    auto pLayer = m_dataset.getSimpleLayer(type);
+    if (!pLayer)
+        throw LayerNotFound{};
+
+    const auto& descriptor = *pLayer->getDescriptor();
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = descriptor.getChunkDims();
+
+    LayerOverlay overlay;
+    overlay.pLayer = std::move(pLayer);
+    overlay.elementSize = descriptor.getElementSize();
+    overlay.chunkRows = chunkRows > 0 ? static_cast<uint32_t>(chunkRows) :
+        kUnchunkedEditSize;
+    overlay.chunkColumns = chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkColumns) : kUnchunkedEditSize;
+    overlay.numChunkColumns = (m_numColumns + overlay.chunkColumns - 1) /
+        overlay.chunkColumns;
+
+    return m_overlays.emplace(type, std::move(overlay)).first->second;
+}
+
+//! Determine if a section is within the grid.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    \e true if the section is within the grid.
+*/
+bool EditSession::isInGrid(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const noexcept
+{
+    return rowStart <= rowEnd && columnStart <= columnEnd &&
+        rowEnd < m_numRows && columnEnd < m_numColumns;
+}
+
+//! Write a section of a simple layer to its edited chunks.
+/*!
+    Chunks not edited yet are read from the BAG first, unless the section
+    covers them.
+
+\param type
+    The type of the simple layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The section, row major.
+*/
+void EditSession::apply(
+    LayerType type,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const uint8_t* buffer)
+{
+    auto& overlay = this->getOverlay(type);
+
+    for (auto chunkRow=rowStart / overlay.chunkRows;
+        chunkRow<=rowEnd / overlay.chunkRows; ++chunkRow)
+    {
+        const auto firstRow = chunkRow * overlay.chunkRows;
+        const auto lastRow = std::min(firstRow + overlay.chunkRows,
+            m_numRows) - 1;
+
+        for (auto chunkColumn=columnStart / overlay.chunkColumns;
+            chunkColumn<=columnEnd / overlay.chunkColumns; ++chunkColumn)
+        {
+            const auto firstColumn = chunkColumn * overlay.chunkColumns;
+            const auto lastColumn = std::min(firstColumn +
+                overlay.chunkColumns, m_numColumns) - 1;
+
+            const auto key = uint64_t{chunkRow} * overlay.numChunkColumns +
+                chunkColumn;
+
+            auto chunk = overlay.chunks.find(key);
+            if (chunk == overlay.chunks.end())
+            {
+                std::vector<uint8_t> values;
+
+                if (rowStart <= firstRow && rowEnd >= lastRow &&
+                    columnStart <= firstColumn && columnEnd >= lastColumn)
+                    values.resize((size_t{lastRow} - firstRow + 1) *
+                        (size_t{lastColumn} - firstColumn + 1) *
+                        overlay.elementSize);
+                else
+                {
+                    const auto original = overlay.pLayer->read(firstRow,
+                        firstColumn, lastRow, lastColumn);
+                    values.assign(original.data(),
+                        original.data() + original.size());
+                }
+
+                chunk = overlay.chunks.emplace(key, std::move(values)).first;
+            }
+
+            auto* pChunk = chunk->second.data();
+
+            forEachIntersectionRow(rowStart, columnStart, rowEnd, columnEnd,
+                firstRow, firstColumn, lastRow, lastColumn,
+                overlay.elementSize,
+                [pChunk, buffer](size_t windowOffset, size_t chunkOffset,
+                    size_t numBytes) {
+                    std::memcpy(pChunk + chunkOffset, buffer + windowOffset,
+                        numBytes);
+                });
+        }
+    }
+}
+
+}  // namespace BAG
+
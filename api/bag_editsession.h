@@ -0,0 +1,140 @@
+#ifndef BAG_EDITSESSION_H
+#define BAG_EDITSESSION_H
+
+#include "bag_c_types.h"
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+#include "bag_uint8array.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Gathers many small edits of a BAG in memory, and writes them at once.
+/*!
+    Writes to the simple layers go to a copy, in memory, of the chunks they
+    touch; a chunk is read from the BAG the first time it is written to,
+    unless the write covers it.  Tracking list items are held until
+    committed.  Reads through the session see the edits over the BAG, which
+    is not changed until commit() writes each chunk edited once, and appends
+    the tracking list items, as a batch (see Dataset::beginBatch()).
+
+    Every write() and addTrackingItem() can be undone, and redone, until the
+    session is committed or discarded.
+
+    The Dataset must outlive the session.  A session is not thread safe.
+*/
+class BAG_API EditSession final
+{
+public:
+    explicit EditSession(Dataset& dataset);
+
+    EditSession(const EditSession&) = delete;
+    EditSession(EditSession&&) = delete;
+
+    EditSession& operator=(const EditSession&) = delete;
+    EditSession& operator=(EditSession&&) = delete;
+
+    UInt8Array read(LayerType type, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+    void write(LayerType type, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer);
+
+    void addTrackingItem(const BagTrackingItem& item);
+    const std::vector<BagTrackingItem>& getTrackingItems() const & noexcept;
+
+    bool canUndo() const noexcept;
+    bool canRedo() const noexcept;
+    void undo();
+    void redo();
+
+    bool isDirty() const noexcept;
+    size_t getNumDirtyChunks() const noexcept;
+    size_t getMemoryUsage() const noexcept;
+
+    void commit();
+    void discard() noexcept;
+
+private:
+    //! The edited chunks of a layer.
+    struct LayerOverlay final
+    {
+        //! The layer.
+        std::shared_ptr<Layer> pLayer;
+        //! The size of an element of the layer, in bytes.
+        uint8_t elementSize = 0;
+        //! The rows of an edited chunk.
+        uint32_t chunkRows = 0;
+        //! The columns of an edited chunk.
+        uint32_t chunkColumns = 0;
+        //! The number of chunks across the grid.
+        uint32_t numChunkColumns = 0;
+        //! The edited chunks, by index in row major order; those at the
+        //! edges of the grid are clipped to it.
+        std::map<uint64_t, std::vector<uint8_t>> chunks;
+    };
+
+    //! An edit, for undo and redo.
+    struct Edit final
+    {
+        //! Is the edit a write, or a tracking list item added?
+        bool isWrite = true;
+        //! The layer written.
+        LayerType type = UNKNOWN_LAYER_TYPE;
+        //! The starting row written.
+        uint32_t rowStart = 0;
+        //! The starting column written.
+        uint32_t columnStart = 0;
+        //! The ending row written (inclusive).
+        uint32_t rowEnd = 0;
+        //! The ending column written (inclusive).
+        uint32_t columnEnd = 0;
+        //! The values of the window before the write.
+        std::vector<uint8_t> before;
+        //! The values of the window written.
+        std::vector<uint8_t> after;
+        //! The tracking list item added.
+        BagTrackingItem item{};
+    };
+
+    LayerOverlay& getOverlay(LayerType type);
+    bool isInGrid(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const noexcept;
+    void apply(LayerType type, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer);
+
+    //! The BAG edited.
+    Dataset& m_dataset;
+    //! The number of rows in the grid.
+    uint32_t m_numRows = 0;
+    //! The number of columns in the grid.
+    uint32_t m_numColumns = 0;
+    //! The edited chunks of each layer written to.
+    std::map<LayerType, LayerOverlay> m_overlays;
+    //! The tracking list items to append.
+    std::vector<BagTrackingItem> m_trackingItems;
+    //! The edits that can be undone, oldest first.
+    std::vector<Edit> m_undo;
+    //! The edits that can be redone, most recently undone last.
+    std::vector<Edit> m_redo;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_EDITSESSION_H
+
@@ -27,6 +27,42 @@ struct BAG_API CompressionNeedsChunkingSet final : virtual std::exception
     }
 };
 
+//! Quantization needs a chunked layer.
+struct BAG_API QuantizationNeedsChunkingSet final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "If quantization is desired, a positive chunk size must be set.";
+    }
+};
+
+//! A layer can only be quantized before it is written.
+struct BAG_API QuantizationNeedsEmptyLayer final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A layer can only be quantized before any of it is written.";
+    }
+};
+
+//! The compression filter is not built into HDF5, and no plugin provides it.
+struct BAG_API CompressionFilterNotAvailable final : virtual std::exception
+{
+    CompressionFilterNotAvailable(int filter) : m_filter(filter)
+    {
+        m_message = "The HDF5 compression filter " + std::to_string(m_filter) +
+                " is not available.";
+    }
+
+    const char* what() const noexcept override
+    {
+        return m_message.c_str();
+    }
+
+    int m_filter = 0;
+    std::string m_message;
+};
+
 // Attribute related.
 //! Attribute type not supported (yet)
 struct BAG_API UnsupportedAttributeType final : virtual std::exception
@@ -66,6 +102,15 @@ struct BAG_API InvalidKeyType final : virtual std::exception
     }
 };
 
+//! The key type of a georeferenced metadata layer cannot hold its keys.
+struct BAG_API KeyTypeTooNarrow final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The key type is too narrow for the keys or the records/values of the georeferenced metadata layer.";
+    }
+};
+
 //! A name is required to find a unique georeferenced metadata layer.
 struct BAG_API NameRequired final : virtual std::exception
 {
@@ -95,6 +140,42 @@ struct BAG_API InvalidLayerId final : virtual std::exception
     }
 };
 
+//! A shared memory segment could not be created or attached.
+struct BAG_API SharedMemoryUnavailable final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The shared memory segment could not be created or attached.";
+    }
+};
+
+//! A shared memory segment does not hold a snapshot.
+struct BAG_API InvalidSharedMemorySnapshot final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The shared memory segment does not hold a snapshot of a BAG.";
+    }
+};
+
+//! An access trace could not be written.
+struct BAG_API AccessTraceWriteFailed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The access trace could not be written.";
+    }
+};
+
+//! An access trace could not be read, or is not one.
+struct BAG_API InvalidAccessTrace final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The file could not be read as an access trace.";
+    }
+};
+
 
 // Group related.
 //! Attempt to use an unknown layer type.
@@ -117,6 +198,15 @@ struct BAG_API InvalidBuffer final : virtual std::exception
     }
 };
 
+//! The positions to sample have a different number of X and Y.
+struct BAG_API InvalidSamplePositions final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The positions sampled must have as many X as Y.";
+    }
+};
+
 //! Invalid dimensions specified for the read.
 struct BAG_API InvalidReadSize final : virtual std::exception
 {
@@ -153,6 +243,107 @@ struct BAG_API LayerNotFound final : virtual std::exception
     }
 };
 
+//! Overviews can only be built for simple layers of floats.
+struct BAG_API UnsupportedOverviewLayer final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Overviews can only be built for simple layers of floats.";
+    }
+};
+
+//! The overview level has not been built.
+struct BAG_API InvalidOverviewLevel final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The specified overview level has not been built.";
+    }
+};
+
+//! The coverage of the layer has not been built.
+struct BAG_API CoverageNotBuilt final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The coverage of the layer has not been built.";
+    }
+};
+
+//! An unknown layout was requested when reading several layers.
+struct BAG_API InvalidLayerLayout final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The layer layout specified is not planar or interleaved.";
+    }
+};
+
+//! Concurrent reads were requested for a BAG that is not read only.
+struct BAG_API ConcurrentReadsRequireReadOnly final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Concurrent reads can only be enabled when opening a BAG read only.";
+    }
+};
+
+//! A BAG named by a URL was opened to be modified.
+struct BAG_API RemoteReadsRequireReadOnly final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A BAG named by a URL can only be opened read only.";
+    }
+};
+
+//! A BAG named by a URL was opened, but HDF5 was built without the read only
+//! S3 (ROS3) driver.
+struct BAG_API RemoteReadsNotAvailable final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "HDF5 was built without the ROS3 driver, so BAGs named by a URL cannot be read.";
+    }
+};
+
+//! The window of a BAG to copy does not cover any of its nodes.
+struct BAG_API InvalidCopyWindow final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The window to copy does not cover any nodes of the BAG.";
+    }
+};
+
+//! The tile size of an export is not a positive multiple of 16.
+struct BAG_API InvalidExportTileSize final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The tile size of an export must be a positive multiple of 16.";
+    }
+};
+
+//! An export could not be written.
+struct BAG_API ExportWriteFailed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The export could not be written.";
+    }
+};
+
+//! A BAG was opened in parallel, through the MPI-IO driver, with options the
+//! driver does not support.
+struct BAG_API InvalidParallelOpen final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A BAG opened in parallel must be a local file, opened without a page buffer or concurrent reads.";
+    }
+};
+
 //! Attempted to modify a read only Dataset.
 struct BAG_API ReadOnlyError final : virtual std::exception
 {
@@ -445,6 +636,148 @@ struct BAG_API InvalidVRRefinementDimensions final : virtual std::exception
     }
 };
 
+//! Attempt to append through a closed VRRefinements::AppendWriter.
+struct BAG_API AppendWriterClosed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Attempted to append refinements through a closed writer.";
+    }
+};
+
+//! Attempt to write through a closed SimpleLayer::StripWriter.
+struct BAG_API StripWriterClosed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Attempted to write through a closed strip writer.";
+    }
+};
+
+//! Attempt to commit a batch of writes that was not begun.
+struct BAG_API NoBatchInProgress final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Attempted to commit without a batch of writes in progress.";
+    }
+};
+
+//! Attempt to undo an edit when there is none to undo.
+struct BAG_API NothingToUndo final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "There is no edit to undo.";
+    }
+};
+
+//! Attempt to redo an edit when there is none undone.
+struct BAG_API NothingToRedo final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "There is no undone edit to redo.";
+    }
+};
+
+//! The resolution or extent of a resampled grid is not usable.
+struct BAG_API InvalidResampleGrid final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The resolution of a resampled grid must be positive, and its "
+            "extent must not be empty.";
+    }
+};
+
+//! A percentile is outside 0 to 100.
+struct BAG_API InvalidPercentile final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A percentile must be from 0 to 100.";
+    }
+};
+
+//! The grids of two layers do not share nodes.
+struct BAG_API GridsNotAligned final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The grids must have the same spacing, their nodes must line "
+            "up, and they must overlap.";
+    }
+};
+
+//! The radius of a neighbourhood is not valid.
+struct BAG_API InvalidKernelRadius final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The radius of a neighbourhood must be at least 1.";
+    }
+};
+
+//! A layer cannot hold a product of computeDerivatives().
+struct BAG_API InvalidDerivativeLayer final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A derivative layer must be a 32 bit float layer with the grid "
+            "of the elevation layer, and not hold another product nor the "
+            "elevations.";
+    }
+};
+
+//! The levels of contours are invalid.
+struct BAG_API InvalidContourLevels final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "Contours need levels, or a positive interval between them, "
+            "and the levels must be finite.";
+    }
+};
+
+//! The sources of a mosaic cannot be mosaicked.
+struct BAG_API InvalidMosaicSources final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "A mosaic needs at least one source, and its sources must "
+            "share a horizontal reference system.";
+    }
+};
+
+//! A catalog file could not be read.
+struct BAG_API CatalogReadFailed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The catalog could not be read; it is missing, truncated, or "
+            "not a catalog of this version and byte order.";
+    }
+};
+
+//! A catalog file could not be written.
+struct BAG_API CatalogWriteFailed final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The catalog could not be written.";
+    }
+};
+
+//! A long operation was cancelled with its ProgressToken.
+struct BAG_API OperationCancelled final : virtual std::exception
+{
+    const char* what() const noexcept override
+    {
+        return "The operation was cancelled.";
+    }
+};
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
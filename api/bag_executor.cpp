@@ -0,0 +1,604 @@
+
+#include "bag_executor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace BAG {
+
+namespace {
+
+//! The executor the calling thread belongs to; null if none.
+thread_local const Executor* tpExecutor = nullptr;
+//! The index of the calling thread in its executor.
+thread_local uint32_t tThreadIndex = 0;
+
+//! Find the number of threads to run.
+/*!
+\param numThreads
+    The number of threads asked for; 0 for one per hardware thread.
+
+\return
+    The number of threads; at least one.
+*/
+uint32_t getThreadCount(
+    uint32_t numThreads) noexcept
+{
+    if (numThreads == 0)
+        numThreads = std::thread::hardware_concurrency();
+
+    return std::max(numThreads, 1u);
+}
+
+//! Read an unsigned integer from an environment variable.
+/*!
+\param name
+    The name of the variable.
+
+\return
+    The value; 0 if the variable is not set, or not a number.
+*/
+uint32_t readEnvironment(
+    const char* name) noexcept
+{
+    const auto* value = std::getenv(name);
+    if (!value)
+        return 0;
+
+    return static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+}
+
+#ifdef __linux__
+
+//! Find the processors of each NUMA node of the host.
+/*!
+\return
+    The processors of each node; empty if they cannot be read.
+*/
+std::vector<std::vector<int>> findNumaNodes()
+{
+    std::vector<std::vector<int>> nodes;
+
+    for (int node=0; ; ++node)
+    {
+        std::ifstream file{"/sys/devices/system/node/node" +
+            std::to_string(node) + "/cpulist"};
+        std::string list;
+        if (!std::getline(file, list))
+            break;
+
+        // Ranges such as "0-3,8-11".
+        std::vector<int> processors;
+        std::istringstream ranges{list};
+        std::string range;
+        while (std::getline(ranges, range, ','))
+        {
+            const auto dash = range.find('-');
+            const auto first = std::atoi(range.c_str());
+            const auto last = dash == std::string::npos ? first :
+                std::atoi(range.c_str() + dash + 1);
+
+            for (auto processor=first; processor<=last; ++processor)
+                processors.push_back(processor);
+        }
+
+        if (!processors.empty())
+            nodes.push_back(std::move(processors));
+    }
+
+    return nodes;
+}
+
+#endif
+
+//! Pin the calling thread to a NUMA node of the host.
+/*!
+    Does nothing if the host has a single node, or its nodes cannot be
+    found.
+
+\param index
+    The index of the thread; threads are spread over the nodes round robin.
+*/
+void pinToNumaNode(
+    uint32_t index) noexcept
+{
+#ifdef __linux__
+    try
+    {
+        static const auto nodes = findNumaNodes();
+        if (nodes.size() < 2)
+            return;
+
+        cpu_set_t processors;
+        CPU_ZERO(&processors);
+        for (const auto processor : nodes[index % nodes.size()])
+            if (processor < CPU_SETSIZE)
+                CPU_SET(processor, &processors);
+
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(processors),
+            &processors);
+    }
+    catch (...)
+    {
+    }
+#else
+    (void)index;
+#endif
+}
+
+}  // namespace
+
+constexpr uint32_t Executor::kMaxThreads;
+
+//! Retrieve the executor the library runs asynchronous operations, and
+//! parallel work, on.
+/*!
+    It has one thread per hardware thread, or the number of threads in the
+    BAG_NUM_THREADS environment variable, until changed with
+    setNumThreads().  Its threads are pinned to the NUMA nodes of the host if
+    the BAG_PIN_THREADS environment variable is 1.  It is never destroyed,
+    so operations still pending at exit do not keep the process from ending.
+
+\return
+    The executor.
+*/
+Executor& Executor::global() noexcept
+{
+    static auto* pExecutor = new Executor{readEnvironment("BAG_NUM_THREADS"),
+        readEnvironment("BAG_PIN_THREADS") == 1};
+
+    return *pExecutor;
+}
+
+//! Constructor.
+/*!
+\param numThreads
+    The number of threads; 0 for one per hardware thread.
+\param pinToNumaNodes
+    Pin the threads to the NUMA nodes of the host, round robin.
+*/
+Executor::Executor(
+    uint32_t numThreads,
+    bool pinToNumaNodes)
+    : m_pinToNumaNodes(pinToNumaNodes)
+{
+    // Never reallocated, so the workers can be read without the lock.
+    m_workers.reserve(kMaxThreads);
+
+    this->setNumThreads(numThreads);
+}
+
+//! Destructor.
+/*!
+    Waits for every task submitted to be done, but for those handed to a
+    runner; those must be done before the executor is destroyed.
+*/
+Executor::~Executor()
+{
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+
+    m_changed.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+//! Retrieve the number of threads.
+/*!
+\return
+    The number of threads; with a runner, the number of threads the library
+    splits its parallel work for.
+*/
+uint32_t Executor::getNumThreads() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return m_numThreads;
+}
+
+//! Change the number of threads.
+/*!
+    Threads removed finish the task they are running first; the tasks queued
+    on them are run by the others.  With a runner, the number is only used
+    to split the parallel work of the library.
+
+\param numThreads
+    The number of threads; 0 for one per hardware thread.
+*/
+void Executor::setNumThreads(
+    uint32_t numThreads)
+{
+    numThreads = std::min(getThreadCount(numThreads), kMaxThreads);
+
+    const std::lock_guard<std::mutex> resizeLock{m_resizeMutex};
+
+    std::vector<std::thread> stopped;
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_numThreads = numThreads;
+        stopped = this->resizeThreads();
+    }
+
+    m_changed.notify_all();
+
+    for (auto& thread : stopped)
+        thread.join();
+}
+
+//! Are the threads pinned to the NUMA nodes of the host?
+/*!
+\return
+    \e true if the threads are pinned.
+*/
+bool Executor::isPinnedToNumaNodes() const noexcept
+{
+    return m_pinToNumaNodes;
+}
+
+//! Hand the tasks to another thread pool, rather than run them on threads of
+//! the executor.
+/*!
+    The threads of the executor stop, and the tasks queued are handed to the
+    runner.  Strands still run their tasks one at a time, in order.  The
+    runner is called from whichever thread posts a task.
+
+\param runner
+    Hands a task to the other thread pool; empty to run the tasks on threads
+    of the executor again.
+*/
+void Executor::setRunner(
+    Runner runner)
+{
+    const std::lock_guard<std::mutex> resizeLock{m_resizeMutex};
+
+    std::vector<std::thread> stopped;
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_runner = std::move(runner);
+        stopped = this->resizeThreads();
+    }
+
+    m_changed.notify_all();
+
+    for (auto& thread : stopped)
+        thread.join();
+
+    if (!stopped.empty())
+    {
+        // Hand the tasks the threads left to the runner.
+        std::deque<std::function<void()>> tasks;
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            tasks.swap(m_tasks);
+
+            for (uint32_t index=0; index<m_numWorkers; ++index)
+            {
+                auto& worker = *m_workers[index];
+                const std::lock_guard<std::mutex> workerLock{worker.mutex};
+                std::move(worker.tasks.begin(), worker.tasks.end(),
+                    std::back_inserter(tasks));
+                worker.tasks.clear();
+            }
+
+            m_numQueued = 0;
+        }
+
+        for (auto& task : tasks)
+            m_runner(std::move(task));
+    }
+}
+
+//! Run a task on a thread of the pool.
+/*!
+    Posted from a thread of the pool, the task goes to the deque of that
+    thread, which runs it before the tasks posted earlier.
+
+\param task
+    The task.  It must not throw; what it throws is ignored.
+*/
+void Executor::post(
+    std::function<void()> task)
+{
+    this->schedule(std::move(task), true);
+}
+
+//! Run a task on a thread of the pool, after the tasks posted to the same
+//! strand before it.
+/*!
+\param strand
+    The strand; any address, usually of the object the task uses.
+\param task
+    The task.  It must not throw; what it throws is ignored.
+*/
+void Executor::post(
+    const void* strand,
+    std::function<void()> task)
+{
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        auto& tasks = m_strands[strand];
+        tasks.push_back(std::move(task));
+
+        // Otherwise, the strand is already queued or running.
+        if (tasks.size() > 1)
+            return;
+    }
+
+    this->schedule([this, strand]() { this->runStrand(strand); }, false);
+}
+
+//! Take the next task for a thread.
+/*!
+    The thread takes the newest task of its own deque, else the oldest task
+    posted from outside the pool, else the oldest task of another thread.
+
+\param index
+    The index of the thread.
+\param task
+    Set to the task.
+
+\return
+    \e true if a task was taken.
+*/
+bool Executor::pop(
+    uint32_t index,
+    std::function<void()>& task)
+{
+    if (m_numQueued == 0)
+        return false;
+
+    const auto numWorkers = m_numWorkers.load();
+
+    if (index < numWorkers)
+    {
+        auto& worker = *m_workers[index];
+        const std::lock_guard<std::mutex> lock{worker.mutex};
+
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            --m_numQueued;
+            return true;
+        }
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (!m_tasks.empty())
+        {
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            --m_numQueued;
+            return true;
+        }
+    }
+
+    for (uint32_t offset=1; offset<numWorkers; ++offset)
+    {
+        auto& worker = *m_workers[(index + offset) % numWorkers];
+        const std::lock_guard<std::mutex> lock{worker.mutex};
+
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            --m_numQueued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//! Start or stop threads to match the number wanted; m_mutex must be held.
+/*!
+    With a runner, every thread stops.
+
+\return
+    The threads stopping, to be joined once the lock is released and the
+    threads told.
+*/
+std::vector<std::thread> Executor::resizeThreads()
+{
+    const auto numThreads = m_runner ? 0u : m_numThreads;
+
+    while (m_workers.size() < numThreads)
+        m_workers.push_back(std::unique_ptr<Worker>{new Worker});
+    m_numWorkers = static_cast<uint32_t>(m_workers.size());
+
+    for (auto index=static_cast<uint32_t>(m_threads.size());
+        index<numThreads; ++index)
+        m_threads.emplace_back(&Executor::run, this, index);
+
+    std::vector<std::thread> stopped;
+    if (m_threads.size() > numThreads)
+    {
+        std::move(m_threads.begin() + numThreads, m_threads.end(),
+            std::back_inserter(stopped));
+        m_threads.resize(numThreads);
+    }
+
+    return stopped;
+}
+
+//! Run tasks until told to stop; run by each thread.
+/*!
+\param index
+    The index of the thread.
+*/
+void Executor::run(
+    uint32_t index)
+{
+    tpExecutor = this;
+    tThreadIndex = index;
+
+    if (m_pinToNumaNodes)
+        pinToNumaNode(index);
+
+    std::function<void()> task;
+
+    while (true)
+    {
+        if (this->pop(index, task))
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+            }
+
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_changed.wait(lock, [this, index]() {
+            return m_stop || m_runner || index >= m_numThreads ||
+                m_numQueued > 0;
+        });
+
+        // The tasks left are run by the other threads, before the executor
+        // is destroyed, or by the runner.
+        if (m_runner || index >= m_numThreads ||
+            (m_stop && m_numQueued == 0))
+            return;
+    }
+}
+
+//! Run the next task of a strand, then queue the strand again if it has
+//! more.
+/*!
+\param strand
+    The strand.
+*/
+void Executor::runStrand(
+    const void* strand)
+{
+    std::function<void()> task;
+    {
+        // The task stays in the strand until it is done, so tasks posted
+        // meanwhile wait for it.
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        task = std::move(m_strands[strand].front());
+    }
+
+    try
+    {
+        task();
+    }
+    catch (...)
+    {
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        const auto found = m_strands.find(strand);
+        found->second.pop_front();
+
+        if (found->second.empty())
+        {
+            m_strands.erase(found);
+            return;
+        }
+    }
+
+    // Behind the tasks posted meanwhile, so a busy strand does not hold back
+    // the others.
+    this->schedule([this, strand]() { this->runStrand(strand); }, false);
+}
+
+//! Queue a task, or hand it to the runner.
+/*!
+\param task
+    The task.
+\param local
+    Queue the task on the deque of the calling thread, if it is a thread of
+    the executor.
+*/
+void Executor::schedule(
+    std::function<void()> task,
+    bool local)
+{
+    if (local && tpExecutor == this && tThreadIndex < m_numWorkers)
+    {
+        // A thread of the executor only runs while there is no runner.
+        auto& worker = *m_workers[tThreadIndex];
+        {
+            const std::lock_guard<std::mutex> lock{worker.mutex};
+            worker.tasks.push_back(std::move(task));
+        }
+
+        ++m_numQueued;
+
+        // Wakes a thread that saw no task, but is not waiting yet.
+        { const std::lock_guard<std::mutex> lock{m_mutex}; }
+        m_changed.notify_one();
+        return;
+    }
+
+    Runner runner;
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (m_runner)
+            runner = m_runner;
+        else
+        {
+            m_tasks.push_back(std::move(task));
+            ++m_numQueued;
+        }
+    }
+
+    if (runner)
+    {
+        runner(std::move(task));
+        return;
+    }
+
+    m_changed.notify_one();
+}
+
+//! Change the number of threads the library runs its parallel work on.
+/*!
+    The threads are those of Executor::global().
+
+\param numThreads
+    The number of threads; 0 for one per hardware thread.
+*/
+void setConcurrency(
+    uint32_t numThreads)
+{
+    Executor::global().setNumThreads(numThreads);
+}
+
+//! Retrieve the number of threads the library runs its parallel work on.
+/*!
+\return
+    The number of threads of Executor::global().
+*/
+uint32_t getConcurrency() noexcept
+{
+    return Executor::global().getNumThreads();
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,199 @@
+#ifndef BAG_EXECUTOR_H
+#define BAG_EXECUTOR_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Runs tasks on a pool of threads; the library runs its asynchronous reads
+//! and writes, and its parallel work, on global().
+/*!
+    Each thread has a deque of tasks.  A task posted from a thread of the
+    pool goes to the back of its deque, and the thread runs the back of its
+    deque first, so work split into tasks stays on the thread, and in the
+    cache, that made it.  Tasks posted from other threads are queued for
+    all, and run in the order posted.  A thread with nothing to run takes
+    the oldest task of another thread's deque.
+
+    Tasks submitted to the same strand are run one at a time, in order; the
+    library submits every asynchronous operation on a Dataset to the strand
+    of that Dataset, as HDF5 does not allow one file to be used by several
+    threads at once.
+
+    The threads can be pinned to the NUMA nodes of the host, round robin, so
+    the memory each touches stays local.  Or, with setRunner(), the tasks can
+    be handed to another thread pool, such as that of TBB or asio, and the
+    executor runs no threads of its own.
+
+    Unless the BAG was opened with OpenOptions::concurrentReads, nothing
+    else may use a Dataset while asynchronous operations on it are pending.
+
+    The operations keep their Dataset open until they are done.
+*/
+class BAG_API Executor final
+{
+public:
+    //! Hands a task to another thread pool; the task must be run once.
+    using Runner = std::function<void(std::function<void()>)>;
+
+    static Executor& global() noexcept;
+
+    explicit Executor(uint32_t numThreads = 0, bool pinToNumaNodes = false);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+
+    Executor& operator=(const Executor&) = delete;
+    Executor& operator=(Executor&&) = delete;
+
+    uint32_t getNumThreads() const noexcept;
+    void setNumThreads(uint32_t numThreads);
+    bool isPinnedToNumaNodes() const noexcept;
+
+    void setRunner(Runner runner);
+
+    void post(std::function<void()> task);
+    void post(const void* strand, std::function<void()> task);
+
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())>;
+    template <typename Function>
+    auto submit(const void* strand, Function&& function)
+        -> std::future<decltype(function())>;
+
+private:
+    //! The tasks of a thread.
+    struct Worker final
+    {
+        //! The tasks not run yet; the thread runs the back first, and the
+        //! others take the front.
+        std::deque<std::function<void()>> tasks;
+        //! Guards tasks.
+        std::mutex mutex;
+    };
+
+    //! The most threads an executor runs.
+    static constexpr uint32_t kMaxThreads = 1024;
+
+    bool pop(uint32_t index, std::function<void()>& task);
+    std::vector<std::thread> resizeThreads();
+    void run(uint32_t index);
+    void runStrand(const void* strand);
+    void schedule(std::function<void()> task, bool local);
+
+    //! The number of threads wanted; threads with a larger index stop.
+    uint32_t m_numThreads = 0;
+    //! The threads, by index.
+    std::vector<std::thread> m_threads;
+    //! The tasks of each thread ever started, by index; never shrinks, so
+    //! the tasks of stopped threads are taken by the others.
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    //! The number of workers; read without the lock.
+    std::atomic<uint32_t> m_numWorkers{0};
+    //! The tasks posted from outside the pool, and the strands ready to run,
+    //! the next first.
+    std::deque<std::function<void()>> m_tasks;
+    //! The number of tasks queued, in m_tasks and the workers.
+    std::atomic<size_t> m_numQueued{0};
+    //! Hands the tasks to another thread pool, if set.
+    Runner m_runner;
+    //! Are the threads pinned to the NUMA nodes of the host?
+    bool m_pinToNumaNodes = false;
+    //! The tasks of each strand not done yet, the one running or queued in
+    //! m_tasks first.
+    std::unordered_map<const void*, std::deque<std::function<void()>>>
+        m_strands;
+    //! Have the threads been told to stop?
+    bool m_stop = false;
+    //! Guards the members, but for the tasks of the workers.
+    mutable std::mutex m_mutex;
+    //! Serializes changing the number of threads, or the runner.
+    std::mutex m_resizeMutex;
+    //! Signals a task, or a change to the number of threads.
+    std::condition_variable m_changed;
+};
+
+BAG_API void setConcurrency(uint32_t numThreads);
+BAG_API uint32_t getConcurrency() noexcept;
+
+//! Run a function on a thread of the pool.
+/*!
+\param function
+    The function; called with no arguments.
+
+\return
+    The result of the function, or the exception it threw.
+*/
+template <typename Function>
+auto Executor::submit(
+    Function&& function) -> std::future<decltype(function())>
+{
+    using Result = decltype(function());
+
+    // std::function must be copyable; the task is not.
+    auto pTask = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function));
+    auto result = pTask->get_future();
+
+    this->post([pTask]() { (*pTask)(); });
+
+    return result;
+}
+
+//! Run a function on a thread of the pool, after the functions submitted to
+//! the same strand before it.
+/*!
+\param strand
+    The strand; any address, usually of the object the function uses.
+\param function
+    The function; called with no arguments.
+
+\return
+    The result of the function, or the exception it threw.
+*/
+template <typename Function>
+auto Executor::submit(
+    const void* strand,
+    Function&& function) -> std::future<decltype(function())>
+{
+    using Result = decltype(function());
+
+    auto pTask = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function));
+    auto result = pTask->get_future();
+
+    this->post(strand, [pTask]() { (*pTask)(); });
+
+    return result;
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_EXECUTOR_H
+
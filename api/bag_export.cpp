@@ -0,0 +1,1236 @@
+
+#include "bag_dataset.h"
+#include "bag_descriptor.h"
+#include "bag_exceptions.h"
+#include "bag_export.h"
+#include "bag_layerdescriptor.h"
+#include "bag_overview.h"
+#include "bag_parallel.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayer.h"
+#include "bag_vrresampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>  // remove
+#include <cstring>  // memcpy
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+
+namespace BAG {
+
+namespace {
+
+//! The value of a node with no data.
+constexpr float kNullValue = BAG_NULL_GENERIC;
+//! The null value, as written to the GDAL_NODATA tag.
+constexpr char kNullValueText[] = "1000000";
+//! The most nodes of a grid read at once when building its overviews.
+constexpr size_t kExportBandCells = size_t{1} << 22;
+//! The most strips of tiles waiting between two stages of an export.
+constexpr size_t kMaxQueuedStrips = 2;
+//! Exports that could be larger than this are written as BigTIFF.
+constexpr uint64_t kMaxClassicTiffSize = (uint64_t{1} << 32) - (1 << 20);
+
+// The TIFF field types.
+constexpr uint16_t kTiffAscii = 2;
+constexpr uint16_t kTiffShort = 3;
+constexpr uint16_t kTiffLong = 4;
+constexpr uint16_t kTiffDouble = 12;
+constexpr uint16_t kTiffLong8 = 16;
+
+// The TIFF and GeoTIFF tags.
+constexpr uint16_t kTagNewSubfileType = 254;
+constexpr uint16_t kTagImageWidth = 256;
+constexpr uint16_t kTagImageLength = 257;
+constexpr uint16_t kTagBitsPerSample = 258;
+constexpr uint16_t kTagCompression = 259;
+constexpr uint16_t kTagPhotometric = 262;
+constexpr uint16_t kTagSamplesPerPixel = 277;
+constexpr uint16_t kTagPlanarConfiguration = 284;
+constexpr uint16_t kTagTileWidth = 322;
+constexpr uint16_t kTagTileLength = 323;
+constexpr uint16_t kTagTileOffsets = 324;
+constexpr uint16_t kTagTileByteCounts = 325;
+constexpr uint16_t kTagSampleFormat = 339;
+constexpr uint16_t kTagModelPixelScale = 33550;
+constexpr uint16_t kTagModelTiepoint = 33922;
+constexpr uint16_t kTagGeoKeyDirectory = 34735;
+constexpr uint16_t kTagGeoAsciiParams = 34737;
+constexpr uint16_t kTagGdalNoData = 42113;
+
+// The GeoTIFF keys.
+constexpr uint16_t kKeyModelType = 1024;
+constexpr uint16_t kKeyRasterType = 1025;
+constexpr uint16_t kKeyCitation = 1026;
+constexpr uint16_t kKeyGeographicType = 2048;
+constexpr uint16_t kKeyProjectedCSType = 3072;
+
+constexpr uint16_t kModelTypeProjected = 1;
+constexpr uint16_t kModelTypeGeographic = 2;
+constexpr uint16_t kRasterPixelIsPoint = 2;
+
+//! A grid of floats being exported.
+struct ExportRaster final
+{
+    //! The number of rows.
+    uint32_t rows = 0;
+    //! The number of columns.
+    uint32_t columns = 0;
+    //! The position of the south west node.
+    double originX = 0., originY = 0.;
+    //! The distance between two nodes.
+    double spacingX = 0., spacingY = 0.;
+    //! The horizontal reference system, as WKT.
+    std::string wkt;
+    //! Read rows rowStart to rowEnd (inclusive), row 0 being the southern
+    //! most, into a packed, row major buffer.
+    std::function<void(uint32_t rowStart, uint32_t rowEnd, float* data)>
+        readRows;
+};
+
+//! A tile of a strip being exported.
+struct ExportTile final
+{
+    //! The nodes of the tile, north row first; padded with the null value.
+    std::vector<float> raw;
+    //! The deflated tile.
+    std::vector<uint8_t> deflated;
+    //! The data to write; one of the above.
+    const uint8_t* data = nullptr;
+    //! The number of bytes of data.
+    size_t size = 0;
+    //! Did deflate run out of memory?
+    bool failed = false;
+};
+
+//! A row of tiles being exported.
+struct TileStrip final
+{
+    //! The row of tiles, 0 being the northern most.
+    uint32_t index = 0;
+    //! The rows of the strip, north row first.
+    uint32_t rows = 0;
+    //! The nodes of the strip, row major.
+    std::vector<float> values;
+    //! The tiles of the strip, west first.
+    std::vector<ExportTile> tiles;
+};
+
+//! A queue of work passed between two threads, holding a few items at most.
+template <typename T>
+class WorkQueue final
+{
+public:
+    //! Constructor.
+    /*!
+    \param capacity
+        The most items held at once.
+    */
+    explicit WorkQueue(size_t capacity) noexcept
+        : m_capacity(capacity)
+    {}
+
+    //! Add an item, waiting for room.
+    /*!
+    \param item
+        The item.
+
+    \return
+        \e false if the queue was closed.
+    */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notFull.wait(lock, [this]() {
+            return m_closed || m_items.size() < m_capacity;
+        });
+
+        if (m_closed)
+            return false;
+
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+
+        return true;
+    }
+
+    //! Take the next item, waiting for one.
+    /*!
+    \param item
+        Set to the item.
+
+    \return
+        \e false if the queue is closed and empty.
+    */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notEmpty.wait(lock, [this]() {
+            return m_closed || !m_items.empty();
+        });
+
+        if (m_items.empty())
+            return false;
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+
+        return true;
+    }
+
+    //! Stop taking new items; the items held can still be taken.
+    void close() noexcept
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_closed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    //! The most items held at once.
+    size_t m_capacity = 0;
+    //! The items.
+    std::deque<T> m_items;
+    //! Has the queue been closed?
+    bool m_closed = false;
+    //! Guards the other members.
+    std::mutex m_mutex;
+    //! Signalled when an item is taken.
+    std::condition_variable m_notFull;
+    //! Signalled when an item is added.
+    std::condition_variable m_notEmpty;
+};
+
+//! Read, encode and write the strips of tiles of a grid.
+/*!
+    The strips are read on one thread, their tiles encoded on several, and
+    written on another, so reading, compression and writing overlap.
+
+\param numStrips
+    The number of strips.
+\param readStrip
+    Called with each strip, in order, to fill its values.
+\param encodeStrip
+    Called with each strip that has been read, to fill its tiles.
+\param writeStrip
+    Called with each strip that has been encoded, in order.
+\param progress
+    Reports each strip encoded, on the calling thread.
+*/
+void pipelineStrips(
+    uint32_t numStrips,
+    const std::function<void(TileStrip&)>& readStrip,
+    const std::function<void(TileStrip&)>& encodeStrip,
+    const std::function<void(const TileStrip&)>& writeStrip,
+    const ProgressScope& progress)
+{
+    WorkQueue<TileStrip> readStrips{kMaxQueuedStrips};
+    WorkQueue<TileStrip> encodedStrips{kMaxQueuedStrips};
+
+    std::exception_ptr readError, encodeError, writeError;
+
+    // A failed stage closes the queues, which stops the others.
+    std::thread reader{[&]() {
+        try
+        {
+            for (uint32_t index=0; index<numStrips; ++index)
+            {
+                TileStrip strip;
+                strip.index = index;
+                readStrip(strip);
+
+                if (!readStrips.push(std::move(strip)))
+                    break;
+            }
+        }
+        catch (...)
+        {
+            readError = std::current_exception();
+            encodedStrips.close();
+        }
+
+        readStrips.close();
+    }};
+
+    std::thread writer;
+    try
+    {
+        writer = std::thread{[&]() {
+            try
+            {
+                TileStrip strip;
+                while (encodedStrips.pop(strip))
+                    writeStrip(strip);
+            }
+            catch (...)
+            {
+                writeError = std::current_exception();
+                readStrips.close();
+            }
+
+            encodedStrips.close();
+        }};
+
+        TileStrip strip;
+        while (readStrips.pop(strip))
+        {
+            encodeStrip(strip);
+
+            const auto index = strip.index;
+            if (!encodedStrips.push(std::move(strip)))
+                break;
+
+            progress.report(index + 1, numStrips);
+        }
+    }
+    catch (...)
+    {
+        encodeError = std::current_exception();
+        readStrips.close();
+    }
+
+    encodedStrips.close();
+
+    reader.join();
+    if (writer.joinable())
+        writer.join();
+
+    for (const auto& error : {readError, encodeError, writeError})
+        if (error)
+            std::rethrow_exception(error);
+}
+
+//! Encode the tiles of a strip.
+/*!
+\param strip
+    The strip; its tiles are filled.
+\param columns
+    The number of columns in the strip.
+\param tileSize
+    The rows and columns in a tile.
+\param compressionLevel
+    The deflate level; 0 leaves the tiles raw.
+*/
+void encodeTiles(
+    TileStrip& strip,
+    uint32_t columns,
+    uint32_t tileSize,
+    int compressionLevel)
+{
+    const auto numTileColumns = (columns + tileSize - 1) / tileSize;
+    const size_t tileCells = static_cast<size_t>(tileSize) * tileSize;
+    const auto tileBytes = tileCells * sizeof(float);
+
+    // Allocated here, so the threads below cannot throw.
+    strip.tiles.resize(numTileColumns);
+    for (auto& tile : strip.tiles)
+    {
+        tile.raw.resize(tileCells);
+        if (compressionLevel > 0)
+            tile.deflated.resize(::compressBound(static_cast<uLong>(tileBytes)));
+    }
+
+    processInBlocks(0, numTileColumns - 1, static_cast<uint32_t>(tileCells),
+        [&](uint32_t first, uint32_t last) {
+            for (auto tileColumn=first; tileColumn<=last; ++tileColumn)
+            {
+                auto& tile = strip.tiles[tileColumn];
+
+                const auto columnStart = tileColumn * tileSize;
+                const auto numColumns = std::min(tileSize, columns - columnStart);
+
+                std::fill(tile.raw.begin(), tile.raw.end(), kNullValue);
+                for (uint32_t row=0; row<strip.rows; ++row)
+                    std::copy_n(strip.values.data() +
+                        static_cast<size_t>(row) * columns + columnStart,
+                        numColumns,
+                        tile.raw.data() + static_cast<size_t>(row) * tileSize);
+
+                tile.data = reinterpret_cast<const uint8_t*>(tile.raw.data());
+                tile.size = tileBytes;
+
+                if (compressionLevel <= 0)
+                    continue;
+
+                auto deflatedSize = static_cast<uLongf>(tile.deflated.size());
+                if (::compress2(tile.deflated.data(), &deflatedSize, tile.data,
+                    static_cast<uLong>(tileBytes), compressionLevel) != Z_OK)
+                {
+                    tile.failed = true;
+                    continue;
+                }
+
+                tile.data = tile.deflated.data();
+                tile.size = deflatedSize;
+            }
+        });
+
+    for (const auto& tile : strip.tiles)
+        if (tile.failed)
+            throw std::bad_alloc{};
+}
+
+//! Read a strip of tiles from a grid whose row 0 is the southern most.
+/*!
+\param strip
+    The strip to fill; its index is set.
+\param rows
+    The number of rows in the grid.
+\param columns
+    The number of columns in the grid.
+\param tileSize
+    The rows and columns in a tile.
+\param readRows
+    Reads rows of the grid, south row first, into a packed buffer.
+*/
+void readStripRows(
+    TileStrip& strip,
+    uint32_t rows,
+    uint32_t columns,
+    uint32_t tileSize,
+    const std::function<void(uint32_t, uint32_t, float*)>& readRows)
+{
+    // The strips run from the north, the rows of a BAG from the south.
+    const auto northRow = strip.index * tileSize;
+    strip.rows = std::min(tileSize, rows - northRow);
+    strip.values.resize(static_cast<size_t>(strip.rows) * columns);
+
+    const auto rowEnd = rows - 1 - northRow;
+    const auto rowStart = rowEnd - (strip.rows - 1);
+    readRows(rowStart, rowEnd, strip.values.data());
+
+    for (uint32_t row=0; row<strip.rows / 2; ++row)
+        std::swap_ranges(
+            strip.values.begin() + static_cast<size_t>(row) * columns,
+            strip.values.begin() + static_cast<size_t>(row + 1) * columns,
+            strip.values.begin() +
+                static_cast<size_t>(strip.rows - 1 - row) * columns);
+}
+
+//! Build the overviews of a GeoTIFF.
+/*!
+\param raster
+    The grid being exported.
+\param options
+    The options of the export.
+\param progress
+    Reports each band of the grid read.
+
+\return
+    The overviews, finest first; each halves the resolution of the one
+    before, until one fits in a tile.
+*/
+std::vector<OverviewGrid> buildExportOverviews(
+    const ExportRaster& raster,
+    const ExportOptions& options,
+    const ProgressScope& progress)
+{
+    std::vector<OverviewGrid> overviews;
+    if (!options.buildOverviews)
+        return overviews;
+
+    auto rows = raster.rows;
+    auto columns = raster.columns;
+
+    while (rows > options.tileSize || columns > options.tileSize)
+    {
+        OverviewGrid overview;
+        overview.rows = (rows + 1) / 2;
+        overview.columns = (columns + 1) / 2;
+        overview.values.resize(
+            static_cast<size_t>(overview.rows) * overview.columns);
+        overview.counts.resize(overview.values.size());
+
+        if (overviews.empty())
+        {
+            // Read the grid a band of row pairs at a time.
+            const auto bandRows = static_cast<uint32_t>(std::max<size_t>(2,
+                kExportBandCells / columns / 2 * 2));
+            std::vector<float> band(static_cast<size_t>(bandRows) * columns);
+
+            for (uint32_t rowStart=0; rowStart<rows; rowStart+=bandRows)
+            {
+                const auto rowEnd = std::min(rowStart + bandRows, rows) - 1;
+
+                raster.readRows(rowStart, rowEnd, band.data());
+                reduceOverview(band.data(), nullptr, rowEnd - rowStart + 1,
+                    columns, options.overviewMethod, overview, rowStart / 2);
+
+                progress.report(rowEnd + 1, rows);
+            }
+        }
+        else
+        {
+            const auto& source = overviews.back();
+            reduceOverview(source.values.data(), source.counts.data(),
+                source.rows, source.columns, options.overviewMethod, overview,
+                0);
+        }
+
+        rows = overview.rows;
+        columns = overview.columns;
+        overviews.push_back(std::move(overview));
+    }
+
+    return overviews;
+}
+
+//! Append the bytes of a value to a buffer, in the byte order of the host.
+template <typename T>
+void appendBytes(
+    std::vector<uint8_t>& bytes,
+    T value)
+{
+    const auto* first = reinterpret_cast<const uint8_t*>(&value);
+    bytes.insert(bytes.end(), first, first + sizeof(T));
+}
+
+//! An image file directory of a TIFF.
+class TiffDirectory final
+{
+public:
+    //! Add an entry of values of one type.
+    template <typename T>
+    void add(
+        uint16_t tag,
+        uint16_t type,
+        const std::vector<T>& values)
+    {
+        std::vector<uint8_t> bytes;
+        for (const auto value : values)
+            appendBytes(bytes, value);
+
+        m_entries.push_back({tag, type, values.size(), std::move(bytes)});
+    }
+
+    //! Add an entry of text.
+    void addText(
+        uint16_t tag,
+        const std::string& text)
+    {
+        std::vector<uint8_t> bytes{text.begin(), text.end()};
+        bytes.push_back(0);
+
+        m_entries.push_back({tag, kTiffAscii, bytes.size(), std::move(bytes)});
+    }
+
+    //! Add an entry of file offsets or sizes.
+    void addOffsets(
+        uint16_t tag,
+        const std::vector<uint64_t>& values,
+        bool bigTiff)
+    {
+        if (bigTiff)
+        {
+            this->add(tag, kTiffLong8, values);
+            return;
+        }
+
+        std::vector<uint32_t> values32(values.size());
+        std::transform(values.begin(), values.end(), values32.begin(),
+            [](uint64_t value) { return static_cast<uint32_t>(value); });
+        this->add(tag, kTiffLong, values32);
+    }
+
+    //! Write the directory, followed by the values too large for its entries.
+    /*!
+    \param offset
+        The offset of the directory in the file.
+    \param nextOffset
+        The offset of the next directory; 0 if this is the last.
+    \param bigTiff
+        Is the file a BigTIFF?
+
+    \return
+        The bytes of the directory.
+    */
+    std::vector<uint8_t> serialize(
+        uint64_t offset,
+        uint64_t nextOffset,
+        bool bigTiff) const
+    {
+        auto entries = m_entries;
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const Entry& lhs, const Entry& rhs) {
+                return lhs.tag < rhs.tag;
+            });
+
+        const size_t valueSize = bigTiff ? 8 : 4;
+        const auto headerSize = bigTiff ?
+            8 + entries.size() * 20 + 8 :
+            2 + entries.size() * 12 + 4;
+
+        std::vector<uint8_t> bytes;
+        std::vector<uint8_t> external;
+
+        if (bigTiff)
+            appendBytes(bytes, static_cast<uint64_t>(entries.size()));
+        else
+            appendBytes(bytes, static_cast<uint16_t>(entries.size()));
+
+        for (const auto& entry : entries)
+        {
+            appendBytes(bytes, entry.tag);
+            appendBytes(bytes, entry.type);
+
+            if (bigTiff)
+                appendBytes(bytes, entry.count);
+            else
+                appendBytes(bytes, static_cast<uint32_t>(entry.count));
+
+            if (entry.values.size() <= valueSize)
+            {
+                // Small values are held in the entry, left justified.
+                bytes.insert(bytes.end(), entry.values.begin(),
+                    entry.values.end());
+                bytes.insert(bytes.end(), valueSize - entry.values.size(), 0);
+                continue;
+            }
+
+            const auto valueOffset = offset + headerSize + external.size();
+            if (bigTiff)
+                appendBytes(bytes, valueOffset);
+            else
+                appendBytes(bytes, static_cast<uint32_t>(valueOffset));
+
+            // Values start on a word boundary.
+            external.insert(external.end(), entry.values.begin(),
+                entry.values.end());
+            if (external.size() % 2 != 0)
+                external.push_back(0);
+        }
+
+        if (bigTiff)
+            appendBytes(bytes, nextOffset);
+        else
+            appendBytes(bytes, static_cast<uint32_t>(nextOffset));
+
+        bytes.insert(bytes.end(), external.begin(), external.end());
+
+        return bytes;
+    }
+
+private:
+    //! An entry of the directory.
+    struct Entry final
+    {
+        //! The tag.
+        uint16_t tag;
+        //! The field type.
+        uint16_t type;
+        //! The number of values.
+        uint64_t count;
+        //! The values.
+        std::vector<uint8_t> values;
+    };
+
+    //! The entries.
+    std::vector<Entry> m_entries;
+};
+
+//! Find the EPSG code of a horizontal reference system.
+/*!
+\param wkt
+    The horizontal reference system, as WKT.
+
+\return
+    The code in the AUTHORITY (or ID) of the outermost node.
+    0 if it has none.
+*/
+uint32_t findEpsgCode(
+    const std::string& wkt) noexcept
+{
+    int depth = 0;
+
+    for (size_t i=0; i<wkt.size(); ++i)
+    {
+        const auto c = wkt[i];
+
+        if (c == '"')
+        {
+            i = wkt.find('"', i + 1);
+            if (i == std::string::npos)
+                return 0;
+
+            continue;
+        }
+
+        if (c == ']' || c == ')')
+        {
+            --depth;
+            continue;
+        }
+
+        if (c != '[' && c != '(')
+            continue;
+
+        ++depth;
+        if (depth != 2)
+            continue;
+
+        // The keyword of the node being opened.
+        auto start = i;
+        while (start > 0 && std::isalpha(static_cast<unsigned char>(wkt[start - 1])))
+            --start;
+
+        const auto keyword = wkt.substr(start, i - start);
+        if (keyword != "AUTHORITY" && keyword != "ID")
+            continue;
+
+        constexpr char kAuthority[] = "\"EPSG\"";
+        if (wkt.compare(i + 1, sizeof(kAuthority) - 1, kAuthority) != 0)
+            continue;
+
+        auto pos = wkt.find_first_of("0123456789", i + sizeof(kAuthority));
+        const auto end = wkt.find_first_of("])", i);
+        if (pos == std::string::npos || pos > end)
+            return 0;
+
+        uint32_t code = 0;
+        for (; pos < wkt.size() &&
+            std::isdigit(static_cast<unsigned char>(wkt[pos])); ++pos)
+            code = code * 10 + static_cast<uint32_t>(wkt[pos] - '0');
+
+        return code;
+    }
+
+    return 0;
+}
+
+//! Describe the horizontal reference system of a GeoTIFF.
+/*!
+    A system with an EPSG code is described by the code.  Any other is
+    held in the citation as an "ESRI PE String", which GDAL reads as WKT.
+
+\param directory
+    The directory of the full resolution image.
+\param wkt
+    The horizontal reference system, as WKT.
+*/
+void addGeoKeys(
+    TiffDirectory& directory,
+    const std::string& wkt)
+{
+    // Each key is its id, the tag holding its value (0 for a short held in
+    // the key), a count and the value or offset.
+    std::vector<std::array<uint16_t, 4>> keys;
+    std::string ascii;
+
+    const auto keyword = wkt.substr(0, wkt.find_first_of("[("));
+    const auto isProjected = keyword == "PROJCS" || keyword == "PROJCRS" ||
+        keyword == "PROJECTEDCRS";
+    const auto isGeographic = keyword == "GEOGCS" || keyword == "GEOGCRS" ||
+        keyword == "GEOGRAPHICCRS";
+
+    if (isProjected)
+        keys.push_back({kKeyModelType, 0, 1, kModelTypeProjected});
+    else if (isGeographic)
+        keys.push_back({kKeyModelType, 0, 1, kModelTypeGeographic});
+
+    keys.push_back({kKeyRasterType, 0, 1, kRasterPixelIsPoint});
+
+    const auto code = findEpsgCode(wkt);
+    if (code > 0 && code <= 0xFFFF && (isProjected || isGeographic))
+        keys.push_back({isProjected ? kKeyProjectedCSType : kKeyGeographicType,
+            0, 1, static_cast<uint16_t>(code)});
+    else if (!wkt.empty())
+    {
+        ascii = "ESRI PE String = " + wkt + "|";
+        keys.push_back({kKeyCitation, kTagGeoAsciiParams,
+            static_cast<uint16_t>(std::min<size_t>(ascii.size(), 0xFFFF)), 0});
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint16_t> values{1, 1, 0, static_cast<uint16_t>(keys.size())};
+    for (const auto& key : keys)
+        values.insert(values.end(), key.begin(), key.end());
+
+    directory.add(kTagGeoKeyDirectory, kTiffShort, values);
+    if (!ascii.empty())
+        directory.addText(kTagGeoAsciiParams, ascii);
+}
+
+//! Make the directory of a level of a GeoTIFF.
+/*!
+\param raster
+    The grid being exported.
+\param rows
+    The rows of the level.
+\param columns
+    The columns of the level.
+\param isOverview
+    Is the level an overview?
+\param offsets
+    The offsets of the tiles of the level.
+\param sizes
+    The sizes of the tiles of the level.
+\param options
+    The options of the export.
+\param bigTiff
+    Is the file a BigTIFF?
+
+\return
+    The directory.
+*/
+TiffDirectory makeTiffDirectory(
+    const ExportRaster& raster,
+    uint32_t rows,
+    uint32_t columns,
+    bool isOverview,
+    const std::vector<uint64_t>& offsets,
+    const std::vector<uint64_t>& sizes,
+    const ExportOptions& options,
+    bool bigTiff)
+{
+    TiffDirectory directory;
+
+    directory.add<uint32_t>(kTagNewSubfileType, kTiffLong, {isOverview ? 1u : 0u});
+    directory.add<uint32_t>(kTagImageWidth, kTiffLong, {columns});
+    directory.add<uint32_t>(kTagImageLength, kTiffLong, {rows});
+    directory.add<uint16_t>(kTagBitsPerSample, kTiffShort, {32});
+    directory.add<uint16_t>(kTagCompression, kTiffShort,
+        {static_cast<uint16_t>(options.compressionLevel > 0 ? 8 : 1)});
+    directory.add<uint16_t>(kTagPhotometric, kTiffShort, {1});
+    directory.add<uint16_t>(kTagSamplesPerPixel, kTiffShort, {1});
+    directory.add<uint16_t>(kTagPlanarConfiguration, kTiffShort, {1});
+    directory.add<uint32_t>(kTagTileWidth, kTiffLong, {options.tileSize});
+    directory.add<uint32_t>(kTagTileLength, kTiffLong, {options.tileSize});
+    directory.addOffsets(kTagTileOffsets, offsets, bigTiff);
+    directory.addOffsets(kTagTileByteCounts, sizes, bigTiff);
+    directory.add<uint16_t>(kTagSampleFormat, kTiffShort, {3});
+    directory.addText(kTagGdalNoData, kNullValueText);
+
+    if (isOverview)
+        return directory;
+
+    // The nodes are points, and the tie point is the north west node.
+    directory.add<double>(kTagModelPixelScale, kTiffDouble,
+        {raster.spacingX, raster.spacingY, 0.});
+    directory.add<double>(kTagModelTiepoint, kTiffDouble,
+        {0., 0., 0., raster.originX,
+        raster.originY + (raster.rows - 1) * raster.spacingY, 0.});
+
+    addGeoKeys(directory, raster.wkt);
+
+    return directory;
+}
+
+//! Write a grid as a Cloud Optimized GeoTIFF.
+/*!
+    The directories of every level come first, then the tiles of the
+    overviews, coarsest first, then the tiles of the full resolution image.
+    The directories are written last, once the tiles have been placed, so
+    a GeoTIFF whose export is cancelled is removed.
+
+\param raster
+    The grid to write.
+\param fileName
+    The name of the GeoTIFF.
+\param options
+    The options of the export.
+*/
+void writeGeoTIFF(
+    const ExportRaster& raster,
+    const std::string& fileName,
+    const ExportOptions& options)
+{
+    // Building the overviews reads the whole grid once more.
+    const ProgressScope progress{options.progress};
+    const auto overviewProgress = options.buildOverviews ?
+        progress.part(0, 1, 2) : ProgressScope{nullptr};
+    const auto writeProgress = options.buildOverviews ?
+        progress.part(1, 2, 2) : progress;
+
+    const auto overviews = buildExportOverviews(raster, options,
+        overviewProgress);
+    const auto tileSize = options.tileSize;
+
+    // Level 0 is the full resolution image.
+    struct Level final
+    {
+        uint32_t rows = 0;
+        uint32_t columns = 0;
+        const OverviewGrid* pOverview = nullptr;
+        std::vector<uint64_t> offsets;
+        std::vector<uint64_t> sizes;
+    };
+
+    std::vector<Level> levels(overviews.size() + 1);
+    uint64_t maxSize = 0;
+
+    for (size_t i=0; i<levels.size(); ++i)
+    {
+        auto& level = levels[i];
+        level.pOverview = i == 0 ? nullptr : &overviews[i - 1];
+        level.rows = i == 0 ? raster.rows : level.pOverview->rows;
+        level.columns = i == 0 ? raster.columns : level.pOverview->columns;
+
+        const uint64_t numTiles =
+            static_cast<uint64_t>((level.rows + tileSize - 1) / tileSize) *
+            ((level.columns + tileSize - 1) / tileSize);
+        level.offsets.resize(numTiles);
+        level.sizes.resize(numTiles);
+
+        // Deflate can grow a tile a little.
+        maxSize += numTiles * (::compressBound(static_cast<uLong>(tileSize) *
+            tileSize * sizeof(float)) + 64);
+    }
+
+    const auto makeDirectory = [&](size_t i, bool bigTiff) {
+        const auto& level = levels[i];
+        return makeTiffDirectory(raster, level.rows, level.columns, i > 0,
+            level.offsets, level.sizes, options, bigTiff);
+    };
+
+    // Decide on BigTIFF from the largest the directories and tiles could be.
+    uint64_t directoriesSize = 0;
+    for (size_t i=0; i<levels.size(); ++i)
+        directoriesSize += makeDirectory(i, true).serialize(0, 0, true).size();
+
+    const auto bigTiff = 16 + directoriesSize + maxSize > kMaxClassicTiffSize;
+    const uint64_t headerSize = bigTiff ? 16 : 8;
+
+    std::vector<uint64_t> directoryOffsets(levels.size());
+    auto offset = headerSize;
+    for (size_t i=0; i<levels.size(); ++i)
+    {
+        directoryOffsets[i] = offset;
+        offset += makeDirectory(i, bigTiff).serialize(0, 0, bigTiff).size();
+    }
+
+    std::ofstream file{fileName, std::ios::binary | std::ios::trunc};
+    if (!file)
+        throw ExportWriteFailed{};
+
+    // The byte order is that of the host, as the tiles are.
+    constexpr uint16_t kProbe = 1;
+    uint8_t probeByte = 0;
+    std::memcpy(&probeByte, &kProbe, 1);
+
+    std::vector<uint8_t> header;
+    header.push_back(probeByte == 1 ? 'I' : 'M');
+    header.push_back(probeByte == 1 ? 'I' : 'M');
+    if (bigTiff)
+    {
+        appendBytes(header, uint16_t{43});
+        appendBytes(header, uint16_t{8});
+        appendBytes(header, uint16_t{0});
+        appendBytes(header, directoryOffsets[0]);
+    }
+    else
+    {
+        appendBytes(header, uint16_t{42});
+        appendBytes(header, static_cast<uint32_t>(directoryOffsets[0]));
+    }
+
+    // Reserve the space of the directories.
+    file.write(reinterpret_cast<const char*>(header.data()),
+        static_cast<std::streamsize>(header.size()));
+    const std::vector<char> padding(offset - headerSize, 0);
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+    // The progress of a level is in proportion to its rows.
+    uint64_t totalRows = 0;
+    for (const auto& level : levels)
+        totalRows += level.rows;
+
+    uint64_t rowsDone = 0;
+
+    for (auto i=levels.size(); i-- > 0;)
+    {
+        auto& level = levels[i];
+
+        const auto numStrips = (level.rows + tileSize - 1) / tileSize;
+        const auto numTileColumns = (level.columns + tileSize - 1) / tileSize;
+
+        const auto readStrip = [&](TileStrip& strip) {
+            if (!level.pOverview)
+            {
+                readStripRows(strip, level.rows, level.columns, tileSize,
+                    raster.readRows);
+                return;
+            }
+
+            readStripRows(strip, level.rows, level.columns, tileSize,
+                [&](uint32_t rowStart, uint32_t rowEnd, float* data) {
+                    const auto& values = level.pOverview->values;
+                    std::copy(
+                        values.begin() + static_cast<size_t>(rowStart) * level.columns,
+                        values.begin() + static_cast<size_t>(rowEnd + 1) * level.columns,
+                        data);
+                });
+        };
+
+        const auto encodeStrip = [&](TileStrip& strip) {
+            encodeTiles(strip, level.columns, tileSize,
+                options.compressionLevel);
+        };
+
+        const auto writeStrip = [&](const TileStrip& strip) {
+            for (uint32_t tileColumn=0; tileColumn<numTileColumns; ++tileColumn)
+            {
+                const auto& tile = strip.tiles[tileColumn];
+                const auto index = static_cast<size_t>(strip.index) *
+                    numTileColumns + tileColumn;
+
+                level.offsets[index] = static_cast<uint64_t>(file.tellp());
+                level.sizes[index] = tile.size;
+
+                file.write(reinterpret_cast<const char*>(tile.data),
+                    static_cast<std::streamsize>(tile.size));
+            }
+
+            if (!file)
+                throw ExportWriteFailed{};
+        };
+
+        try
+        {
+            pipelineStrips(numStrips, readStrip, encodeStrip, writeStrip,
+                writeProgress.part(rowsDone, rowsDone + level.rows,
+                    totalRows));
+        }
+        catch (const OperationCancelled&)
+        {
+            file.close();
+            std::remove(fileName.c_str());
+            throw;
+        }
+
+        rowsDone += level.rows;
+    }
+
+    // Write the directories, now the tiles are placed.
+    file.seekp(static_cast<std::streamoff>(headerSize));
+    for (size_t i=0; i<levels.size(); ++i)
+    {
+        const auto nextOffset = i + 1 < levels.size() ?
+            directoryOffsets[i + 1] : 0;
+        const auto bytes = makeDirectory(i, bigTiff).serialize(
+            directoryOffsets[i], nextOffset, bigTiff);
+
+        file.write(reinterpret_cast<const char*>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+    }
+
+    file.close();
+    if (!file)
+        throw ExportWriteFailed{};
+}
+
+//! Write a grid as a directory of raw tiles.
+/*!
+\param raster
+    The grid to write.
+\param directoryName
+    The directory; made if it does not exist.
+\param options
+    The options of the export.
+*/
+void writeRawTiles(
+    const ExportRaster& raster,
+    const std::string& directoryName,
+    const ExportOptions& options)
+{
+#ifdef _WIN32
+    ::_mkdir(directoryName.c_str());
+#else
+    ::mkdir(directoryName.c_str(), 0777);
+#endif
+
+    const auto tileSize = options.tileSize;
+    const auto numStrips = (raster.rows + tileSize - 1) / tileSize;
+
+    const auto readStrip = [&](TileStrip& strip) {
+        readStripRows(strip, raster.rows, raster.columns, tileSize,
+            raster.readRows);
+    };
+
+    const auto encodeStrip = [&](TileStrip& strip) {
+        encodeTiles(strip, raster.columns, tileSize, 0);
+    };
+
+    const auto writeStrip = [&](const TileStrip& strip) {
+        for (size_t tileColumn=0; tileColumn<strip.tiles.size(); ++tileColumn)
+        {
+            const auto& tile = strip.tiles[tileColumn];
+            const auto tileName = directoryName + "/" +
+                std::to_string(strip.index) + "_" +
+                std::to_string(tileColumn) + ".f32";
+
+            std::ofstream file{tileName, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char*>(tile.data),
+                static_cast<std::streamsize>(tile.size));
+            file.close();
+
+            if (!file)
+                throw ExportWriteFailed{};
+        }
+    };
+
+    // The tiles written are whole, so they are kept if cancelled.
+    pipelineStrips(numStrips, readStrip, encodeStrip, writeStrip,
+        ProgressScope{options.progress});
+}
+
+//! Write a grid in the format of an export.
+/*!
+\param raster
+    The grid to write.
+\param fileName
+    The name of the file, or directory, to write.
+\param options
+    The options of the export.
+*/
+void writeRaster(
+    const ExportRaster& raster,
+    const std::string& fileName,
+    const ExportOptions& options)
+{
+    if (options.tileSize == 0 || options.tileSize % 16 != 0)
+        throw InvalidExportTileSize{};
+
+    if (raster.rows == 0 || raster.columns == 0)
+        throw InvalidReadSize{};
+
+    if (options.format == ExportFormat::RawTiles)
+        writeRawTiles(raster, fileName, options);
+    else
+        writeGeoTIFF(raster, fileName, options);
+}
+
+}  // namespace
+
+//! Export a simple layer as a raster.
+/*!
+    The layer is read, encoded and written a strip of tiles at a time, on
+    separate threads, with the tiles of each strip compressed on several.
+    The GeoTIFF is georeferenced from the origin and grid spacing of the
+    descriptor, with the nodes as points, and the horizontal reference
+    system of the BAG.  Its overviews are built in memory, so they need a
+    quarter of the memory of the layer.
+
+\param dataset
+    The BAG.
+\param type
+    The type of the simple layer; a layer of floats or unsigned integers.
+\param fileName
+    The name of the GeoTIFF, or the directory of the raw tiles.
+\param options
+    The format and layout of the export.
+*/
+void exportLayer(
+    const Dataset& dataset,
+    LayerType type,
+    const std::string& fileName,
+    const ExportOptions& options)
+{
+    const auto pLayer = dataset.getSimpleLayer(type);
+    if (!pLayer)
+        throw LayerNotFound{};
+
+    const auto dataType = pLayer->getDescriptor()->getDataType();
+    if (dataType != DT_FLOAT32 && dataType != DT_UINT32)
+        throw UnsupportedDataType{};
+
+    const auto& descriptor = dataset.getDescriptor();
+
+    ExportRaster raster;
+    std::tie(raster.rows, raster.columns) = descriptor.getDims();
+    std::tie(raster.originX, raster.originY) = descriptor.getOrigin();
+    std::tie(raster.spacingX, raster.spacingY) = descriptor.getGridSpacing();
+    raster.wkt = descriptor.getHorizontalReferenceSystem();
+
+    const auto columns = raster.columns;
+    raster.readRows = [pLayer, dataType, columns](uint32_t rowStart,
+        uint32_t rowEnd, float* data) {
+        const auto numValues =
+            static_cast<size_t>(rowEnd - rowStart + 1) * columns;
+
+        pLayer->readInto(rowStart, 0, rowEnd, columns - 1,
+            reinterpret_cast<uint8_t*>(data), numValues * sizeof(float));
+
+        if (dataType != DT_UINT32)
+            return;
+
+        // The integers are converted in place; both are 4 bytes.
+        for (size_t i=0; i<numValues; ++i)
+        {
+            uint32_t value = 0;
+            std::memcpy(&value, data + i, sizeof(value));
+            data[i] = static_cast<float>(value);
+        }
+    };
+
+    writeRaster(raster, fileName, options);
+}
+
+//! Export the refinements of a variable resolution BAG, resampled onto a
+//! uniform grid, as a raster.
+/*!
+    The grid covers the supergrid at the resolution given; see VRResampler.
+    It is resampled, encoded and written a strip of tiles at a time, as in
+    exportLayer().
+
+\param dataset
+    The variable resolution BAG.
+\param resolutionX
+    The distance between output columns.
+\param resolutionY
+    The distance between output rows.
+\param method
+    How the refinements are combined.
+\param fileName
+    The name of the GeoTIFF, or the directory of the raw tiles.
+\param options
+    The format and layout of the export.
+*/
+void exportVR(
+    const Dataset& dataset,
+    double resolutionX,
+    double resolutionY,
+    VRResampleMethod method,
+    const std::string& fileName,
+    const ExportOptions& options)
+{
+    const auto pResampler = std::make_shared<VRResampler>(dataset, resolutionX,
+        resolutionY);
+
+    ExportRaster raster;
+    raster.rows = pResampler->getNumRows();
+    raster.columns = pResampler->getNumColumns();
+    std::tie(raster.originX, raster.originY) = pResampler->getOrigin();
+    std::tie(raster.spacingX, raster.spacingY) = pResampler->getResolution();
+    raster.wkt = dataset.getDescriptor().getHorizontalReferenceSystem();
+
+    raster.readRows = [pResampler, method](uint32_t rowStart, uint32_t rowEnd,
+        float* data) {
+        pResampler->resampleRowsInto(method, rowStart, rowEnd, data);
+    };
+
+    writeRaster(raster, fileName, options);
+}
+
+}  // namespace BAG
+
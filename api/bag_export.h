@@ -0,0 +1,22 @@
+#ifndef BAG_EXPORT_H
+#define BAG_EXPORT_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <string>
+
+
+namespace BAG {
+
+BAG_API void exportLayer(const Dataset& dataset, LayerType type,
+    const std::string& fileName, const ExportOptions& options = {});
+BAG_API void exportVR(const Dataset& dataset, double resolutionX,
+    double resolutionY, VRResampleMethod method, const std::string& fileName,
+    const ExportOptions& options = {});
+
+}  // namespace BAG
+
+#endif  // BAG_EXPORT_H
+
@@ -0,0 +1,111 @@
+
+#include "bag_filestamp.h"
+
+#include <climits>
+#include <cstdlib>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+namespace BAG {
+
+//! Is a name a URL rather than a file name?
+/*!
+\param name
+    The name.
+
+\return
+    \e true if the name has a scheme, such as s3:// or https://.
+*/
+bool isUrl(
+    const std::string& name) noexcept
+{
+    return name.find("://") != std::string::npos;
+}
+
+//! Is a path a directory?
+/*!
+\param path
+    The path.
+
+\return
+    \e true if the path is a directory.
+*/
+bool isDirectory(
+    const std::string& path) noexcept
+{
+#ifdef _WIN32
+    struct __stat64 status;
+    return ::_stat64(path.c_str(), &status) == 0 &&
+        (status.st_mode & _S_IFDIR) != 0;
+#else
+    struct stat status;
+    return ::stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+#endif
+}
+
+//! Read the size and modification time of a file.
+/*!
+\param fileName
+    The file name.
+
+\return
+    The size and modification time; not existing if the file cannot be
+    found, or is a directory.
+*/
+FileStamp statFile(
+    const std::string& fileName) noexcept
+{
+    FileStamp stamp;
+
+#ifdef _WIN32
+    struct __stat64 status;
+    if (::_stat64(fileName.c_str(), &status) != 0 ||
+        (status.st_mode & _S_IFDIR) != 0)
+        return stamp;
+#else
+    struct stat status;
+    if (::stat(fileName.c_str(), &status) != 0 || S_ISDIR(status.st_mode))
+        return stamp;
+#endif
+
+    stamp.exists = true;
+    stamp.size = static_cast<uint64_t>(status.st_size);
+    stamp.modified = static_cast<int64_t>(status.st_mtime);
+
+    return stamp;
+}
+
+//! Make the absolute name of a file, with links and relative parts resolved.
+/*!
+    Two names of the same file make the same canonical name.
+
+\param fileName
+    The file name; a URL is returned as it is.
+
+\return
+    The canonical name; the file name as given if it cannot be resolved,
+    such as when the file does not exist.
+*/
+std::string canonicalFileName(
+    const std::string& fileName)
+{
+    if (isUrl(fileName))
+        return fileName;
+
+#ifdef _WIN32
+    char resolved[_MAX_PATH];
+    if (!::_fullpath(resolved, fileName.c_str(), _MAX_PATH))
+        return fileName;
+#else
+    char resolved[PATH_MAX];
+    if (!::realpath(fileName.c_str(), resolved))
+        return fileName;
+#endif
+
+    return resolved;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,42 @@
+#ifndef BAG_FILESTAMP_H
+#define BAG_FILESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+
+namespace BAG {
+
+//! The size and modification time of a file, to tell when it changes.
+struct FileStamp final
+{
+    //! Does the file exist?
+    bool exists = false;
+    //! The size, in bytes.
+    uint64_t size = 0;
+    //! When the file was last modified, in seconds since the Unix epoch.
+    int64_t modified = 0;
+
+    //! Are two stamps of the same version of a file?
+    bool operator==(const FileStamp& other) const noexcept
+    {
+        return exists == other.exists && size == other.size &&
+            modified == other.modified;
+    }
+
+    //! Are two stamps of different versions of a file?
+    bool operator!=(const FileStamp& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+bool isUrl(const std::string& name) noexcept;
+bool isDirectory(const std::string& path) noexcept;
+FileStamp statFile(const std::string& fileName) noexcept;
+std::string canonicalFileName(const std::string& fileName);
+
+}  // namespace BAG
+
+#endif  // BAG_FILESTAMP_H
+
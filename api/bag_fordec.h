@@ -6,28 +6,55 @@
 namespace BAG
 {
 
+class AccessTraceScope;
+class AccessTracer;
 class GeorefMetadataLayer;
 class GeorefMetadataLayerDescriptor;
+class Catalog;
+class ChunkHasher;
+class CorrectionPlan;
 class Dataset;
+class DatasetPool;
+class DatasetCopier;
+class DatasetSnapshot;
+class DatasetVerifier;
+class DerivativeComputer;
 class Descriptor;
+class EditSession;
+class Executor;
 class InterleavedLegacyLayer;
 class InterleavedLegacyLayerDescriptor;
 class Layer;
 class LayerDescriptor;
+class LayerDiffer;
+class LayerTiles;
+class MemoryBudget;
 class Metadata;
+class NeighbourhoodScanner;
+class PrefetchReader;
+class ProgressToken;
+class ReadQueue;
+class RTree;
+class SharedMemorySegment;
 class SimpleLayer;
 class SimpleLayerDescriptor;
 class SurfaceCorrections;
 class SurfaceCorrectionsDescriptor;
+class TileCache;
 class TrackingList;
 class ValueTable;
+class VRCellIterator;
+class VRIndex;
 class VRMetadata;
 class VRMetadataDescriptor;
+class VRMetadataTable;
 class VRNode;
 class VRNodeDescriptor;
 class VRRefinements;
 class VRRefinementsDescriptor;
+class VRResampler;
 class VRTrackingList;
+class VRTrackingTable;
 
 }  // namespace BAG
 
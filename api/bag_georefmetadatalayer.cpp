@@ -1,15 +1,26 @@
 
 #include "bag_georefmetadatalayer.h"
 #include "bag_metadataprofiles.h"
+#include "bag_parallel.h"
 #include "bag_georefmetadatalayerdescriptor.h"
 #include "bag_exceptions.h"
+#include "bag_dataset.h"
+#include "bag_directchunk.h"
 #include "bag_hdfhelper.h"
 #include "bag_private.h"
+#include "bag_vrcelliterator.h"
+#include "bag_vrmetadata.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <exception>
 #include <H5Cpp.h>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 
@@ -44,6 +55,638 @@ hsize_t getDataTypeMax(
     }
 }
 
+//! Can a georeferenced metadata layer use the specified DataType for its keys?
+/*!
+\param dataType
+    The type of data.
+
+\return
+    \e true if dataType is DT_UINT8, DT_UINT16, DT_UINT32 or DT_UINT64.
+    \e false otherwise.
+*/
+bool isKeyType(
+    DataType dataType) noexcept
+{
+    return dataType == DT_UINT8 || dataType == DT_UINT16 ||
+        dataType == DT_UINT32 || dataType == DT_UINT64;
+}
+
+//! Convert keys to a type at least as wide.
+/*!
+\param source
+    The keys to convert.
+\param target
+    The converted keys.
+\param numKeys
+    The number of keys.
+*/
+template <typename From, typename To>
+void widenKeys(
+    const uint8_t* source,
+    uint8_t* target,
+    size_t numKeys) noexcept
+{
+    const auto* typedSource = reinterpret_cast<const From*>(source);
+    auto* typedTarget = reinterpret_cast<To*>(target);
+
+    std::transform(typedSource, typedSource + numKeys, typedTarget,
+        [](From key) {
+            return static_cast<To>(key);
+        });
+}
+
+//! Convert keys to a type at least as wide.
+/*!
+\param source
+    The keys to convert.
+\param targetType
+    The type to convert to.
+\param target
+    The converted keys.
+\param numKeys
+    The number of keys.
+*/
+template <typename From>
+void widenKeys(
+    const uint8_t* source,
+    DataType targetType,
+    uint8_t* target,
+    size_t numKeys)
+{
+    switch (targetType)
+    {
+    case DT_UINT8:
+        widenKeys<From, uint8_t>(source, target, numKeys);
+        break;
+    case DT_UINT16:
+        widenKeys<From, uint16_t>(source, target, numKeys);
+        break;
+    case DT_UINT32:
+        widenKeys<From, uint32_t>(source, target, numKeys);
+        break;
+    case DT_UINT64:
+        widenKeys<From, uint64_t>(source, target, numKeys);
+        break;
+    default:
+        throw InvalidKeyType{};
+    }
+}
+
+//! Convert keys to a type at least as wide.
+/*!
+\param sourceType
+    The type of the keys to convert.
+\param source
+    The keys to convert.
+\param targetType
+    The type to convert to.
+
+\return
+    The converted keys.
+*/
+UInt8Array widenKeys(
+    DataType sourceType,
+    const UInt8Array& source,
+    DataType targetType)
+{
+    const auto numKeys = source.size() / Layer::getElementSize(sourceType);
+    auto target = UInt8Array::uninitialized(
+        numKeys * Layer::getElementSize(targetType));
+
+    switch (sourceType)
+    {
+    case DT_UINT8:
+        widenKeys<uint8_t>(source.data(), targetType, target.data(), numKeys);
+        break;
+    case DT_UINT16:
+        widenKeys<uint16_t>(source.data(), targetType, target.data(), numKeys);
+        break;
+    case DT_UINT32:
+        widenKeys<uint32_t>(source.data(), targetType, target.data(), numKeys);
+        break;
+    case DT_UINT64:
+        widenKeys<uint64_t>(source.data(), targetType, target.data(), numKeys);
+        break;
+    default:
+        throw InvalidKeyType{};
+    }
+
+    return target;
+}
+
+//! Find the largest of some keys.
+/*!
+\param keys
+    The keys.
+\param numKeys
+    The number of keys.
+
+\return
+    The largest key; 0 if there are none.
+*/
+template <typename T>
+uint64_t findMaxKey(
+    const uint8_t* keys,
+    size_t numKeys) noexcept
+{
+    const auto* typedKeys = reinterpret_cast<const T*>(keys);
+    const auto* maxKey = std::max_element(typedKeys, typedKeys + numKeys);
+
+    return maxKey == typedKeys + numKeys ? 0 : static_cast<uint64_t>(*maxKey);
+}
+
+//! Find the largest of some keys.
+/*!
+\param keyType
+    The type of the keys.
+\param keys
+    The keys.
+\param numKeys
+    The number of keys.
+
+\return
+    The largest key; 0 if there are none.
+*/
+uint64_t findMaxKey(
+    DataType keyType,
+    const uint8_t* keys,
+    size_t numKeys)
+{
+    switch (keyType)
+    {
+    case DT_UINT8:
+        return findMaxKey<uint8_t>(keys, numKeys);
+    case DT_UINT16:
+        return findMaxKey<uint16_t>(keys, numKeys);
+    case DT_UINT32:
+        return findMaxKey<uint32_t>(keys, numKeys);
+    case DT_UINT64:
+        return findMaxKey<uint64_t>(keys, numKeys);
+    default:
+        throw InvalidKeyType{};
+    }
+}
+
+//! The most bytes of keys held in memory while they are rewritten.
+constexpr size_t kKeyCopyBandSize = 16 * 1024 * 1024;
+
+//! Appended to the name of a DataSet while it is being replaced.
+constexpr const char* kReplacedSuffix = "_replaced";
+
+//! Copy the keys of one DataSet into another of a different key type.
+/*!
+    The keys are copied one band of rows at a time, and HDF5 converts them
+    as they are written.  The target must be at least as large as the
+    source.
+
+\param h5source
+    The DataSet to copy from; single or variable resolution keys.
+\param sourceType
+    The key type of h5source.
+\param h5target
+    The DataSet to copy to.
+\param maxKey
+    The largest key the key type of h5target can hold.
+    KeyTypeTooNarrow is thrown if a larger key is found.
+*/
+void copyKeys(
+    const ::H5::DataSet& h5source,
+    DataType sourceType,
+    const ::H5::DataSet& h5target,
+    uint64_t maxKey)
+{
+    const auto h5sourceSpace = h5source.getSpace();
+    const auto rank = h5sourceSpace.getSimpleExtentNdims();
+    if (rank < 1 || rank > kRank)
+        throw InvalidReadSize{};
+
+    // Variable resolution keys are copied as a single column.
+    std::array<hsize_t, kRank> dims{1, 1};
+    h5sourceSpace.getSimpleExtentDims(dims.data());
+    if (rank == 1)
+        std::swap(dims[0], dims[1]);
+
+    if (dims[0] == 0 || dims[1] == 0)
+        return;
+
+    const auto elementSize = Layer::getElementSize(sourceType);
+    const auto& memDataType = BAG::getH5memoryType(sourceType);
+    const hsize_t bandRows = std::max<hsize_t>(1,
+        kKeyCopyBandSize / (dims[1] * elementSize));
+
+    const auto h5targetSpace = h5target.getSpace();
+    std::vector<uint8_t> buffer;
+
+    for (hsize_t row=0; row<dims[0]; row+=bandRows)
+    {
+        std::array<hsize_t, kRank> count{std::min(bandRows, dims[0] - row),
+            dims[1]};
+        std::array<hsize_t, kRank> offset{row, 0};
+        if (rank == 1)
+        {
+            std::swap(count[0], count[1]);
+            std::swap(offset[0], offset[1]);
+        }
+
+        h5sourceSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+            offset.data());
+        h5targetSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+            offset.data());
+
+        const ::H5::DataSpace h5memSpace{rank, count.data(), count.data()};
+        const auto numKeys = static_cast<size_t>(count[0] * count[1]);
+        buffer.resize(numKeys * elementSize);
+
+        h5source.read(buffer.data(), memDataType, h5memSpace, h5sourceSpace);
+
+        if (findMaxKey(sourceType, buffer.data(), numKeys) > maxKey)
+            throw KeyTypeTooNarrow{};
+
+        h5target.write(buffer.data(), memDataType, h5memSpace, h5targetSpace);
+    }
+}
+
+//! Find the cells whose key is flagged.
+/*!
+\param keys
+    The keys of the cells, in row major order.
+\param matching
+    One flag per key.
+\param rowStart
+    The row of the first key.
+\param columnStart
+    The column of the first key.
+\param numColumns
+    The number of columns of keys.
+\param numKeys
+    The number of keys.
+\param cells
+    The row and column of each flagged cell are appended to this.
+*/
+template <typename T>
+void findFlaggedCells(
+    const uint8_t* keys,
+    const std::vector<bool>& matching,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t numColumns,
+    size_t numKeys,
+    std::vector<std::pair<uint32_t, uint32_t>>& cells)
+{
+    const auto* typedKeys = reinterpret_cast<const T*>(keys);
+
+    for (size_t i=0; i<numKeys; ++i)
+    {
+        const auto key = static_cast<uint64_t>(typedKeys[i]);
+
+        if (key < matching.size() && matching[static_cast<size_t>(key)])
+            cells.emplace_back(rowStart + static_cast<uint32_t>(i / numColumns),
+                columnStart + static_cast<uint32_t>(i % numColumns));
+    }
+}
+
+//! The largest cache of key statistics stored as an attribute, in bytes.
+/*!
+    Attributes are kept in the object header, which must stay under 64 KiB.
+*/
+constexpr size_t kMaxCachedStatisticsSize = 60000;
+
+//! The number of values stored per key in the cached key statistics.
+constexpr hsize_t kNumCachedStatisticsFields = 6;
+
+//! Count where the keys of some nodes are used.
+/*!
+\param keys
+    The keys, in row major order.
+\param rowStart
+    The row of the first key.
+\param columnStart
+    The column of the first key.
+\param rows
+    The number of rows of keys.
+\param columns
+    The number of columns of keys.
+\param statistics
+    The statistics to update, one per key.  Larger keys are ignored.
+*/
+template <typename T>
+void accumulateKeys(
+    const uint8_t* keys,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rows,
+    uint32_t columns,
+    std::vector<KeyStatistics>& statistics) noexcept
+{
+    const auto* typedKeys = reinterpret_cast<const T*>(keys);
+
+    for (uint32_t row=0; row<rows; ++row)
+    {
+        for (uint32_t column=0; column<columns; ++column)
+        {
+            const auto key = static_cast<uint64_t>(
+                typedKeys[static_cast<size_t>(row) * columns + column]);
+            if (key >= statistics.size())
+                continue;
+
+            auto& entry = statistics[static_cast<size_t>(key)];
+            const auto r = rowStart + row;
+            const auto c = columnStart + column;
+
+            if (entry.count++ == 0)
+            {
+                entry.minRow = entry.maxRow = r;
+                entry.minColumn = entry.maxColumn = c;
+                continue;
+            }
+
+            entry.minRow = std::min(entry.minRow, r);
+            entry.maxRow = std::max(entry.maxRow, r);
+            entry.minColumn = std::min(entry.minColumn, c);
+            entry.maxColumn = std::max(entry.maxColumn, c);
+        }
+    }
+}
+
+//! Count where the keys of some nodes are used, for any key type.
+/*!
+\param keyType
+    The type of the keys.
+    Supported types are: DT_UINT8, DT_UINT16, DT_UINT32, DT_UINT64.
+
+\copydetails accumulateKeys
+*/
+void accumulateKeys(
+    DataType keyType,
+    const uint8_t* keys,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rows,
+    uint32_t columns,
+    std::vector<KeyStatistics>& statistics)
+{
+    switch (keyType)
+    {
+    case DT_UINT8:
+        accumulateKeys<uint8_t>(keys, rowStart, columnStart, rows, columns,
+            statistics);
+        break;
+    case DT_UINT16:
+        accumulateKeys<uint16_t>(keys, rowStart, columnStart, rows, columns,
+            statistics);
+        break;
+    case DT_UINT32:
+        accumulateKeys<uint32_t>(keys, rowStart, columnStart, rows, columns,
+            statistics);
+        break;
+    case DT_UINT64:
+        accumulateKeys<uint64_t>(keys, rowStart, columnStart, rows, columns,
+            statistics);
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Find the supergrid cells whose extent overlaps a range of positions.
+/*!
+    A supergrid cell extends half a spacing either side of its node.
+
+\param min
+    The start of the range.
+\param max
+    The end of the range.
+\param origin
+    The position of the first node.
+\param spacing
+    The distance between nodes.
+\param count
+    The number of nodes.
+\param first
+    Set to the first cell overlapping the range.
+\param last
+    Set to the last cell overlapping the range.
+
+\return
+    \e true if any cell overlaps the range.
+*/
+bool findOverlappingCells(
+    double min,
+    double max,
+    double origin,
+    double spacing,
+    uint32_t count,
+    uint32_t& first,
+    uint32_t& last) noexcept
+{
+    if (count == 0 || !(spacing > 0.) || !(min <= max))
+        return false;
+
+    const auto lower = std::max(std::ceil((min - origin) / spacing - 0.5), 0.);
+    const auto upper = std::min(std::floor((max - origin) / spacing + 0.5),
+        static_cast<double>(count - 1));
+
+    if (!(lower <= upper))
+        return false;
+
+    first = static_cast<uint32_t>(lower);
+    last = static_cast<uint32_t>(upper);
+
+    return true;
+}
+
+//! Merge the statistics of one part of a layer into another.
+/*!
+\param from
+    The statistics to merge.
+\param into
+    The statistics to update.  Must have as many keys as from.
+*/
+void mergeKeyStatistics(
+    const std::vector<KeyStatistics>& from,
+    std::vector<KeyStatistics>& into) noexcept
+{
+    for (size_t key=0; key<from.size(); ++key)
+    {
+        const auto& source = from[key];
+        if (source.count == 0)
+            continue;
+
+        auto& target = into[key];
+        if (target.count == 0)
+        {
+            target = source;
+            continue;
+        }
+
+        target.count += source.count;
+        target.minRow = std::min(target.minRow, source.minRow);
+        target.maxRow = std::max(target.maxRow, source.maxRow);
+        target.minColumn = std::min(target.minColumn, source.minColumn);
+        target.maxColumn = std::max(target.maxColumn, source.maxColumn);
+    }
+}
+
+//! Count where the keys of a band of nodes are used, on several threads.
+/*!
+\param keyType
+    The type of the keys.
+\param keys
+    The keys, in row major order.
+\param rowStart
+    The row of the first key.
+\param rows
+    The number of rows of keys.
+\param columns
+    The number of columns of keys.
+\param statistics
+    The statistics to update, one per key.
+*/
+void accumulateBand(
+    DataType keyType,
+    const uint8_t* keys,
+    uint32_t rowStart,
+    uint32_t rows,
+    uint32_t columns,
+    std::vector<KeyStatistics>& statistics)
+{
+    const auto elementSize = Layer::getElementSize(keyType);
+
+    std::mutex mutex;
+    std::exception_ptr pError;
+
+    processInBlocks(0, rows - 1, columns,
+        [&](uint32_t first, uint32_t last) {
+            try
+            {
+                std::vector<KeyStatistics> block(statistics.size());
+                accumulateKeys(keyType,
+                    keys + static_cast<size_t>(first) * columns * elementSize,
+                    rowStart + first, 0, last - first + 1, columns, block);
+
+                std::lock_guard<std::mutex> guard{mutex};
+                mergeKeyStatistics(block, statistics);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard{mutex};
+                pError = std::current_exception();
+            }
+        });
+
+    if (pError)
+        std::rethrow_exception(pError);
+}
+
+//! Read the key statistics cached on a key DataSet.
+/*!
+\param h5dataSet
+    The key DataSet.
+\param numKeys
+    The number of keys to return statistics for.
+\param statistics
+    Set to the cached statistics.
+
+\return
+    \e true if statistics were cached.
+    \e false otherwise.
+*/
+bool readCachedKeyStatistics(
+    const ::H5::DataSet& h5dataSet,
+    size_t numKeys,
+    std::vector<KeyStatistics>& statistics)
+{
+    if (!h5dataSet.attrExists(COMPOUND_KEY_STATISTICS))
+        return false;
+
+    const auto h5attribute = h5dataSet.openAttribute(COMPOUND_KEY_STATISTICS);
+    const auto h5dataSpace = h5attribute.getSpace();
+
+    std::array<hsize_t, kRank> dims{};
+    if (h5dataSpace.getSimpleExtentNdims() != kRank)
+        return false;
+
+    h5dataSpace.getSimpleExtentDims(dims.data());
+    if (dims[1] != kNumCachedStatisticsFields)
+        return false;
+
+    std::vector<uint64_t> values(dims[0] * dims[1]);
+    if (!values.empty())
+        h5attribute.read(::H5::PredType::NATIVE_UINT64, values.data());
+
+    statistics.assign(numKeys, {});
+
+    for (size_t i=0; i<values.size(); i+=kNumCachedStatisticsFields)
+    {
+        const auto key = values[i];
+        if (key >= numKeys)
+            continue;
+
+        auto& entry = statistics[static_cast<size_t>(key)];
+        entry.count = values[i + 1];
+        entry.minRow = static_cast<uint32_t>(values[i + 2]);
+        entry.minColumn = static_cast<uint32_t>(values[i + 3]);
+        entry.maxRow = static_cast<uint32_t>(values[i + 4]);
+        entry.maxColumn = static_cast<uint32_t>(values[i + 5]);
+    }
+
+    return true;
+}
+
+//! Cache key statistics on a key DataSet.
+/*!
+    Only the keys in use are stored.  Nothing is stored if they would not
+    fit in an attribute.
+
+\param h5dataSet
+    The key DataSet.
+\param statistics
+    The statistics, one per key.
+*/
+void writeCachedKeyStatistics(
+    const ::H5::DataSet& h5dataSet,
+    const std::vector<KeyStatistics>& statistics)
+{
+    std::vector<uint64_t> values;
+
+    for (size_t key=0; key<statistics.size(); ++key)
+    {
+        const auto& entry = statistics[key];
+        if (entry.count == 0)
+            continue;
+
+        values.insert(values.end(), {key, entry.count, entry.minRow,
+            entry.minColumn, entry.maxRow, entry.maxColumn});
+    }
+
+    if (values.size() * sizeof(uint64_t) > kMaxCachedStatisticsSize)
+        return;
+
+    if (h5dataSet.attrExists(COMPOUND_KEY_STATISTICS))
+        h5dataSet.removeAttr(COMPOUND_KEY_STATISTICS);
+
+    const std::array<hsize_t, kRank> dims{
+        values.size() / kNumCachedStatisticsFields, kNumCachedStatisticsFields};
+    const ::H5::DataSpace h5dataSpace{kRank, dims.data()};
+
+    const auto h5attribute = h5dataSet.createAttribute(COMPOUND_KEY_STATISTICS,
+        ::H5::PredType::NATIVE_UINT64, h5dataSpace);
+    if (!values.empty())
+        h5attribute.write(::H5::PredType::NATIVE_UINT64, values.data());
+}
+
+//! Remove the key statistics cached on a key DataSet.
+/*!
+\param h5dataSet
+    The key DataSet.
+*/
+void removeCachedKeyStatistics(
+    const ::H5::DataSet& h5dataSet)
+{
+    if (h5dataSet.attrExists(COMPOUND_KEY_STATISTICS))
+        h5dataSet.removeAttr(COMPOUND_KEY_STATISTICS);
+}
+
 }
 
 //! The constructor.
@@ -66,6 +709,7 @@ GeorefMetadataLayer::GeorefMetadataLayer(
         std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5vrKeyDataSet,
         std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5valueDataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5keyDataSet(std::move(pH5keyDataSet))
     , m_pH5vrKeyDataSet(std::move(pH5vrKeyDataSet))
     , m_pH5valueDataSet(std::move(pH5valueDataSet))
@@ -83,10 +727,10 @@ GeorefMetadataLayer::GeorefMetadataLayer(
     The BAG Dataset this georeferenced metadata layer will belong to.
 \param definition
     The list of fields describing a single record/value.
-\param chunkSize
-    The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet of the keys will use.
+\param compression
+    The compression the HDF5 DataSet will use.
 
 \return
     The new georeferenced metadata layer.
@@ -97,21 +741,26 @@ std::shared_ptr<GeorefMetadataLayer> GeorefMetadataLayer::create(
             GeorefMetadataProfile profile,
             Dataset& dataset,
             const RecordDefinition& definition,
-            uint64_t chunkSize,
-            int compressionLevel)
+            const ChunkShape& chunkShape,
+            const CompressionSpec& compression)
 {
-    if (keyType != DT_UINT8 && keyType != DT_UINT16 && keyType != DT_UINT32 &&
-        keyType != DT_UINT64)
+    if (!isKeyType(keyType))
         throw InvalidKeyType{};
 
     auto pDescriptor = GeorefMetadataLayerDescriptor::create(dataset, name, profile, keyType,
-                                                             definition, chunkSize, compressionLevel);
+                                                             definition, chunkShape.rows, compression.level);
+    pDescriptor->setCompressionSpec(compression);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = dataset.getDescriptor().getDims();
+    pDescriptor->setChunkShape(chunkShape, numRows, numColumns);
 
     // Create the H5 Group to hold keys & values.
     const auto& h5file = dataset.getH5file();
     h5file.createGroup(GEOREF_METADATA_PATH + name);
 
-    auto h5keyDataSet = GeorefMetadataLayer::createH5keyDataSet(dataset, *pDescriptor);
+    auto h5keyDataSet = GeorefMetadataLayer::createH5keyDataSet(dataset,
+        *pDescriptor, numRows, numColumns);
 
     // create optional variable resolution keys.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> h5vrKeyDataSet{};
@@ -146,14 +795,20 @@ std::shared_ptr<GeorefMetadataLayer> GeorefMetadataLayer::open(
 {
     const auto& h5file = dataset.getH5file();
     const std::string& internalPath = descriptor.getInternalPath();
+
+    // The keys are the gridded part of the layer, so they use its chunk cache.
+    const auto h5accessProps =
+        dataset.getH5dataSetAccessPropList(descriptor.getLayerType());
     auto h5keyDataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(internalPath + COMPOUND_KEYS)},
+        new ::H5::DataSet{h5file.openDataSet(internalPath + COMPOUND_KEYS,
+            h5accessProps)},
         DeleteH5dataSet{});
 
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> h5vrKeyDataSet{};
     if (dataset.getVRMetadata())
         h5vrKeyDataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-            new ::H5::DataSet{h5file.openDataSet(internalPath + COMPOUND_VR_KEYS)},
+            new ::H5::DataSet{h5file.openDataSet(internalPath + COMPOUND_VR_KEYS,
+                h5accessProps)},
             DeleteH5dataSet{});
 
     auto h5valueDataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
@@ -176,6 +831,10 @@ std::shared_ptr<GeorefMetadataLayer> GeorefMetadataLayer::open(
     The BAG Dataset this layer belongs to.
 \param descriptor
     The descriptor of this layer.
+\param numRows
+    The number of rows of keys.
+\param numColumns
+    The number of columns of keys.
 
 \return
     The HDF5 DataSet containing the single resolution keys of a new georeferenced metadata layer.
@@ -183,15 +842,14 @@ std::shared_ptr<GeorefMetadataLayer> GeorefMetadataLayer::open(
 std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
 GeorefMetadataLayer::createH5keyDataSet(
     const Dataset& dataset,
-    const GeorefMetadataLayerDescriptor& descriptor)
+    const GeorefMetadataLayerDescriptor& descriptor,
+    uint32_t numRows,
+    uint32_t numColumns)
 {
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet;
 
     {
-        // Use the dimensions from the descriptor.
-        uint32_t dim0 = 0, dim1 = 0;
-        std::tie(dim0, dim1) = dataset.getDescriptor().getDims();
-        const std::array<hsize_t, kRank> fileDims{dim0, dim1};
+        const std::array<hsize_t, kRank> fileDims{numRows, numColumns};
 
         // Create the creation property list.
         const ::H5::DSetCreatPropList h5createPropList{};
@@ -204,17 +862,17 @@ GeorefMetadataLayer::createH5keyDataSet(
         h5createPropList.setFillValue(memDataType, fillValue.data());
 
         // Use chunk size and compression level from the descriptor.
-        const auto compressionLevel = descriptor.getCompressionLevel();
-        const auto chunkSize = descriptor.getChunkSize();
-        if (chunkSize > 0)
+        const auto& compression = descriptor.getCompressionSpec();
+        uint64_t chunkRows = 0, chunkColumns = 0;
+        std::tie(chunkRows, chunkColumns) = descriptor.getChunkDims();
+        if (chunkRows > 0 && chunkColumns > 0)
         {
-            const std::array<hsize_t, kRank> chunkDims{chunkSize, chunkSize};
+            const std::array<hsize_t, kRank> chunkDims{chunkRows, chunkColumns};
             h5createPropList.setChunk(kRank, chunkDims.data());
 
-            if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-                h5createPropList.setDeflate(compressionLevel);
+            setCompression(h5createPropList, compression);
         }
-        else if (compressionLevel > 0)
+        else if (compression.isCompressed())
             throw CompressionNeedsChunkingSet{};
 
         const ::H5::DataSpace fileDataSpace{kRank, fileDims.data(), fileDims.data()};
@@ -295,17 +953,16 @@ GeorefMetadataLayer::createH5vrKeyDataSet(
         h5createPropList.setFillTime(H5D_FILL_TIME_ALLOC);
 
         // Use chunk size and compression level from the layer descriptor.
-        const auto compressionLevel = descriptor.getCompressionLevel();
+        const auto& compression = descriptor.getCompressionSpec();
         const auto chunkSize = descriptor.getChunkSize();
         if (chunkSize > 0)
         {
             const auto chunk = static_cast<hsize_t>(chunkSize);
             h5createPropList.setChunk(1, &chunk);
 
-            if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-                h5createPropList.setDeflate(compressionLevel);
+            setCompression(h5createPropList, compression);
         }
-        else if (compressionLevel > 0)
+        else if (compression.isCompressed())
             throw CompressionNeedsChunkingSet{};
         else
             throw LayerRequiresChunkingSet{};
@@ -377,6 +1034,86 @@ const ::H5::DataSet& GeorefMetadataLayer::getValueDataSet() const &
     return *m_pH5valueDataSet;
 }
 
+//! Make sure the key type can address some records/values.
+/*!
+\param numRecords
+    The number of records/values, including the no data value record.
+    KeyTypeTooNarrow is thrown if the key type cannot address them all;
+    setKeyType() can widen it.
+*/
+void GeorefMetadataLayer::checkNumRecords(
+    size_t numRecords) const
+{
+    if (numRecords > getDataTypeMax(m_descriptor.getDataType()))
+        throw KeyTypeTooNarrow{};
+}
+
+//! Copy the values into a new HDF5 DataSet with room for every key.
+/*!
+\param dataset
+    The BAG Dataset this layer belongs to.
+*/
+void GeorefMetadataLayer::rewriteValues(
+    const Dataset& dataset)
+{
+    const auto& h5file = dataset.getH5file();
+    const auto valuesPath = m_descriptor.getInternalPath() + COMPOUND_VALUES;
+    const auto replacedPath = valuesPath + kReplacedSuffix;
+
+    // Keep the old values until they are copied.
+    h5file.moveLink(valuesPath, replacedPath);
+
+    std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5valueDataSet;
+
+    try
+    {
+        pH5valueDataSet = createH5valueDataSet(dataset, m_descriptor);
+
+        hsize_t numValues = 0;
+        m_pH5valueDataSet->getSpace().getSimpleExtentDims(&numValues);
+        pH5valueDataSet->extend(&numValues);
+
+        if (numValues > 0)
+        {
+            const auto& definition = m_descriptor.getDefinition();
+            const auto memDataType = createH5memoryCompType(definition);
+            const ::H5::DataSpace memDataSpace{1, &numValues, &numValues};
+
+            std::vector<uint8_t> buffer(getRecordSize(definition) * numValues);
+            m_pH5valueDataSet->read(buffer.data(), memDataType, memDataSpace);
+
+            // Free the strings HDF5 allocated, even if the write fails.
+            try
+            {
+                pH5valueDataSet->write(buffer.data(), memDataType, memDataSpace);
+            }
+            catch (...)
+            {
+                ::H5::DataSet::vlenReclaim(buffer.data(), memDataType,
+                    memDataSpace);
+                throw;
+            }
+
+            ::H5::DataSet::vlenReclaim(buffer.data(), memDataType,
+                memDataSpace);
+        }
+    }
+    catch (...)
+    {
+        pH5valueDataSet.reset();
+
+        if (H5Lexists(h5file.getId(), valuesPath.c_str(), H5P_DEFAULT) > 0)
+            h5file.unlink(valuesPath);
+
+        h5file.moveLink(replacedPath, valuesPath);
+
+        throw;
+    }
+
+    m_pH5valueDataSet = std::move(pH5valueDataSet);
+    h5file.unlink(replacedPath);
+}
+
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
 /*!
 \return
@@ -385,7 +1122,7 @@ const ::H5::DataSet& GeorefMetadataLayer::getValueDataSet() const &
 */
 std::shared_ptr<GeorefMetadataLayerDescriptor> GeorefMetadataLayer::getDescriptor() & noexcept
 {
-    return std::dynamic_pointer_cast<GeorefMetadataLayerDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<GeorefMetadataLayerDescriptor>(Layer::getDescriptor());
 }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -395,7 +1132,7 @@ std::shared_ptr<GeorefMetadataLayerDescriptor> GeorefMetadataLayer::getDescripto
     Will never be nullptr.
 */
 std::shared_ptr<const GeorefMetadataLayerDescriptor> GeorefMetadataLayer::getDescriptor() const & noexcept {
-    return std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<const GeorefMetadataLayerDescriptor>(Layer::getDescriptor());
 }
 
 //! Retrieve the value table.
@@ -424,6 +1161,28 @@ UInt8Array GeorefMetadataLayer::readProxy(
     uint32_t columnStart,
     uint32_t rowEnd,
     uint32_t columnEnd) const
+{
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    // Allocate the output buffer; the read overwrites all of it.
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
+
+    this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+        buffer.data(), columns * m_descriptor.getElementSize());
+
+    return buffer;
+}
+
+//! \copydoc Layer::readInto
+void GeorefMetadataLayer::readIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
 {
     // Query the file for the specified rows and columns.
     const auto h5fileDataSpace = m_pH5keyDataSet->getSpace();
@@ -439,6 +1198,11 @@ UInt8Array GeorefMetadataLayer::readProxy(
     if ((rowEnd >= fileDims[0]) || (columnEnd >= fileDims[1]))
         throw InvalidReadSize{};
 
+    // Large reads of deflated keys are decompressed on several threads.
+    if (readChunksDirect(*m_pH5keyDataSet, m_pH5keyDataSet->getDataType(),
+        rowStart, columnStart, rowEnd, columnEnd, buffer, rowStrideBytes))
+        return;
+
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
 
@@ -447,27 +1211,500 @@ UInt8Array GeorefMetadataLayer::readProxy(
 
     h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
 
-    // Initialize the output buffer.
-    const auto bufferSize = this->getDescriptor()->getReadBufferSize(rows,
-        columns);
-    UInt8Array buffer{bufferSize};
-
     // Prepare the memory space.
-    const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
+    const auto h5memSpace = createH5memorySpace(rows, columns, rowStrideBytes,
+        m_descriptor.getElementSize());
 
-    m_pH5keyDataSet->read(buffer.data(), H5Dget_type(m_pH5keyDataSet->getId()),
+    m_pH5keyDataSet->read(buffer, m_pH5keyDataSet->getDataType(),
         h5memSpace, h5fileDataSpace);
-
-    return buffer;
 }
 
-//! Read the variable resolution metadata keys.
+//! Count how many nodes use each key, and where.
 /*!
-\param indexStart
-    The starting index to read.
-    Must be less than or equal to indexEnd.
-\param indexEnd
-    The ending index to read.  (inclusive)
+    The keys are read one band of chunks at a time; each band is counted on
+    several threads.
+
+\param cacheResult
+    \e true to store the result as an attribute of the key DataSet, which
+    needs the BAG to be open for writing.  Statistics which are cached are
+    returned without reading the keys, until the keys are written again.
+
+\return
+    The statistics of each key in the value table, indexed by key.
+    Nodes with keys missing from the value table are not counted.
+*/
+std::vector<KeyStatistics> GeorefMetadataLayer::computeKeyStatistics(
+    bool cacheResult) const
+{
+    const auto numKeys = m_pValueTable->getNumRecords();
+
+    std::vector<KeyStatistics> statistics;
+    if (readCachedKeyStatistics(*m_pH5keyDataSet, numKeys, statistics))
+        return statistics;
+
+    statistics.assign(numKeys, {});
+
+    std::array<hsize_t, kRank> dims{};
+    m_pH5keyDataSet->getSpace().getSimpleExtentDims(dims.data());
+
+    const auto rows = static_cast<uint32_t>(dims[0]);
+    const auto columns = static_cast<uint32_t>(dims[1]);
+
+    const auto keyType = m_descriptor.getDataType();
+    const auto bandRows = static_cast<uint32_t>(std::max<uint64_t>(
+        m_descriptor.getChunkSize(), 1));
+
+    if (rows > 0 && columns > 0)
+    {
+        const auto pDataset = this->getDataset().lock();
+
+        UInt8Array buffer{static_cast<size_t>(std::min(bandRows, rows)) *
+            columns * m_descriptor.getElementSize()};
+
+        for (uint32_t rowStart=0; rowStart<rows; rowStart+=bandRows)
+        {
+            const auto rowEnd = std::min(rowStart + bandRows, rows) - 1;
+            const auto bandHeight = rowEnd - rowStart + 1;
+
+            // The dimensions of the BAG may describe the variable resolution
+            // keys, so read the keys directly to the extent of their DataSet.
+            {
+                const auto lock = pDataset ? pDataset->lockReads()
+                    : std::unique_lock<std::recursive_mutex>{};
+                this->readIntoProxy(rowStart, 0, rowEnd, columns - 1,
+                    buffer.data(), static_cast<size_t>(columns) *
+                    m_descriptor.getElementSize());
+            }
+
+            accumulateBand(keyType, buffer.data(), rowStart, bandHeight,
+                columns, statistics);
+        }
+    }
+
+    if (cacheResult)
+        writeCachedKeyStatistics(*m_pH5keyDataSet, statistics);
+
+    return statistics;
+}
+
+//! Count how many variable resolution nodes use each key, and where.
+/*!
+    The keys are read several chunks at a time; each read is counted on
+    several threads.
+
+\param cacheResult
+    \e true to store the result as an attribute of the variable resolution
+    key DataSet, which needs the BAG to be open for writing.  Statistics
+    which are cached are returned without reading the keys, until the keys
+    are written again.
+
+\return
+    The statistics of each key in the value table, indexed by key, with the
+    index of each node as its column.
+    Nodes with keys missing from the value table are not counted.
+*/
+std::vector<KeyStatistics> GeorefMetadataLayer::computeVRKeyStatistics(
+    bool cacheResult) const
+{
+    if (!m_pH5vrKeyDataSet)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto numKeys = m_pValueTable->getNumRecords();
+
+    std::vector<KeyStatistics> statistics;
+    if (readCachedKeyStatistics(*m_pH5vrKeyDataSet, numKeys, statistics))
+        return statistics;
+
+    statistics.assign(numKeys, {});
+
+    hsize_t length = 0;
+    m_pH5vrKeyDataSet->getSpace().getSimpleExtentDims(&length);
+
+    const auto keyType = m_descriptor.getDataType();
+
+    // Read whole chunks, enough of them to keep several threads busy.
+    const auto chunkSize = std::max<uint64_t>(m_descriptor.getChunkSize(), 1);
+    const auto bandLength = static_cast<uint32_t>(std::min<uint64_t>(
+        ((kMinCellsPerThread * 8 + chunkSize - 1) / chunkSize) * chunkSize,
+        std::numeric_limits<uint32_t>::max() / 2));
+
+    if (length > 0)
+    {
+        const auto numIndices = static_cast<uint32_t>(length);
+        const auto pDataset = this->getDataset().lock();
+
+        UInt8Array buffer{static_cast<size_t>(std::min(bandLength, numIndices)) *
+            m_descriptor.getElementSize()};
+
+        for (uint32_t indexStart=0; indexStart<numIndices; indexStart+=bandLength)
+        {
+            const auto indexEnd = std::min(indexStart + bandLength, numIndices) - 1;
+            const auto count = indexEnd - indexStart + 1;
+
+            {
+                const auto lock = pDataset ? pDataset->lockReads()
+                    : std::unique_lock<std::recursive_mutex>{};
+                this->readVRInto(indexStart, indexEnd, buffer.data(),
+                    buffer.size());
+            }
+
+            // Each index is a row of one key, so the band can be split between
+            // threads anywhere; the rows are then swapped into columns.
+            std::vector<KeyStatistics> band(numKeys);
+            accumulateBand(keyType, buffer.data(), indexStart, count, 1, band);
+
+            for (auto& entry : band)
+            {
+                std::swap(entry.minRow, entry.minColumn);
+                std::swap(entry.maxRow, entry.maxColumn);
+            }
+
+            mergeKeyStatistics(band, statistics);
+        }
+    }
+
+    if (cacheResult)
+        writeCachedKeyStatistics(*m_pH5vrKeyDataSet, statistics);
+
+    return statistics;
+}
+
+//! Find the nodes in a region whose record/value matches a query.
+/*!
+    The matching keys are found in the value table first, using the index
+    of the field if there is one, then the keys of the region are scanned.
+
+\param query
+    The query.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The row and column of each matching node, in row major order.
+*/
+std::vector<std::pair<uint32_t, uint32_t>> GeorefMetadataLayer::findCells(
+    const ValueQuery& query,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    std::vector<std::pair<uint32_t, uint32_t>> cells;
+
+    const auto matching = m_pValueTable->findMatchingKeys(query);
+    if (std::find(matching.begin(), matching.end(), true) == matching.end())
+        return cells;
+
+    const auto keys = this->read(rowStart, columnStart, rowEnd, columnEnd);
+    const uint32_t numColumns = columnEnd - columnStart + 1;
+    const size_t numKeys = static_cast<size_t>(rowEnd - rowStart + 1) *
+        numColumns;
+
+    switch (m_descriptor.getDataType())
+    {
+    case DT_UINT8:
+        findFlaggedCells<uint8_t>(keys.data(), matching, rowStart, columnStart,
+            numColumns, numKeys, cells);
+        break;
+    case DT_UINT16:
+        findFlaggedCells<uint16_t>(keys.data(), matching, rowStart, columnStart,
+            numColumns, numKeys, cells);
+        break;
+    case DT_UINT32:
+        findFlaggedCells<uint32_t>(keys.data(), matching, rowStart, columnStart,
+            numColumns, numKeys, cells);
+        break;
+    case DT_UINT64:
+        findFlaggedCells<uint64_t>(keys.data(), matching, rowStart, columnStart,
+            numColumns, numKeys, cells);
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+
+    return cells;
+}
+
+//! Read the values of some fields for each node in a region.
+/*!
+    The keys are read, then the values are looked up in the value table.
+    Each run of the same key along a row is looked up once.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param fieldNames
+    The fields to read.
+
+\return
+    The values, one column per field in the order of fieldNames, with one
+    value per node in row major order.
+*/
+std::vector<ResolvedColumn> GeorefMetadataLayer::readResolved(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto keys = this->read(rowStart, columnStart, rowEnd, columnEnd);
+    const size_t numKeys = static_cast<size_t>(rowEnd - rowStart + 1) *
+        (columnEnd - columnStart + 1);
+
+    return m_pValueTable->resolve(keys.data(),
+        m_descriptor.getDataType(), numKeys, fieldNames);
+}
+
+//! Read the single resolution keys as a key type at least as wide as theirs.
+/*!
+    Code written for one key type can read layers whose keys are stored
+    narrower, as by narrowKeyType().
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param keyType
+    The type to read the keys as.  InvalidKeyType is thrown if it is not a
+    key type, or is narrower than the key type of the layer.
+
+\return
+    The keys, row major.
+*/
+UInt8Array GeorefMetadataLayer::readKeys(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    DataType keyType) const
+{
+    const auto storedKeyType = m_descriptor.getDataType();
+    if (!isKeyType(keyType) ||
+        Layer::getElementSize(keyType) < Layer::getElementSize(storedKeyType))
+        throw InvalidKeyType{};
+
+    auto keys = this->read(rowStart, columnStart, rowEnd, columnEnd);
+    if (keyType == storedKeyType)
+        return keys;
+
+    return widenKeys(storedKeyType, keys, keyType);
+}
+
+//! Read the variable resolution keys as a key type at least as wide as theirs.
+/*!
+\param indexStart
+    The starting index to read.
+    Must be less than or equal to indexEnd.
+\param indexEnd
+    The ending index to read.  (inclusive)
+\param keyType
+    The type to read the keys as.  InvalidKeyType is thrown if it is not a
+    key type, or is narrower than the key type of the layer.
+
+\return
+    The specified keys.
+*/
+UInt8Array GeorefMetadataLayer::readVRKeys(
+    uint32_t indexStart,
+    uint32_t indexEnd,
+    DataType keyType) const
+{
+    const auto storedKeyType = m_descriptor.getDataType();
+    if (!isKeyType(keyType) ||
+        Layer::getElementSize(keyType) < Layer::getElementSize(storedKeyType))
+        throw InvalidKeyType{};
+
+    auto keys = this->readVR(indexStart, indexEnd);
+    if (keyType == storedKeyType)
+        return keys;
+
+    return widenKeys(storedKeyType, keys, keyType);
+}
+
+//! Find the narrowest key type able to address every record/value.
+/*!
+\return
+    The narrowest of DT_UINT8, DT_UINT16, DT_UINT32 and DT_UINT64 able to
+    address the records/values of the value table.
+*/
+DataType GeorefMetadataLayer::getNarrowestKeyType() const
+{
+    const auto numRecords = m_pValueTable->getNumRecords();
+
+    for (const auto keyType : {DT_UINT8, DT_UINT16, DT_UINT32})
+        if (numRecords <= getDataTypeMax(keyType))
+            return keyType;
+
+    return DT_UINT64;
+}
+
+//! Rewrite the keys as the narrowest key type able to address every record/value.
+/*!
+    Key grids are as large as the elevation grid, so a layer created with
+    a wide key type, before its number of records/values was known, halves
+    or quarters the size of its keys once narrowed.  Call this after the
+    records/values are added.
+
+\return
+    The new key type of the layer.
+*/
+DataType GeorefMetadataLayer::narrowKeyType()
+{
+    const auto keyType = this->getNarrowestKeyType();
+
+    this->setKeyType(keyType);
+
+    return keyType;
+}
+
+//! Rewrite the keys as another key type.
+/*!
+    The single and variable resolution keys are copied into new HDF5
+    DataSets of the key type, which replace the old ones.  Widening the keys
+    lets the value table grow past the records/values the old key type can
+    address.  The key statistics cached by computeKeyStatistics() are
+    dropped.
+
+    HDF5 does not reuse the space of the old DataSets until the file is
+    repacked (h5repack).
+
+\param keyType
+    The new key type: DT_UINT8, DT_UINT16, DT_UINT32 or DT_UINT64.
+    KeyTypeTooNarrow is thrown, and the keys are left unchanged, if it
+    cannot hold every key of the layer or address every record/value.
+*/
+void GeorefMetadataLayer::setKeyType(
+    DataType keyType)
+{
+    if (!isKeyType(keyType))
+        throw InvalidKeyType{};
+
+    const auto oldKeyType = m_descriptor.getDataType();
+    if (keyType == oldKeyType)
+        return;
+
+    const auto maxKey = getDataTypeMax(keyType);
+    if (m_pValueTable->getNumRecords() > maxKey)
+        throw KeyTypeTooNarrow{};
+
+    if (this->getDataset().expired())
+        throw DatasetNotFound{};
+
+    const auto pDataset = this->getDataset().lock();
+    const auto lock = pDataset->lockReads();
+
+    const auto& h5file = pDataset->getH5file();
+    const auto keysPath = m_descriptor.getInternalPath() + COMPOUND_KEYS;
+    const auto vrKeysPath = m_descriptor.getInternalPath() + COMPOUND_VR_KEYS;
+
+    // Keep the old keys until they are copied.
+    h5file.moveLink(keysPath, keysPath + kReplacedSuffix);
+    if (m_pH5vrKeyDataSet)
+        h5file.moveLink(vrKeysPath, vrKeysPath + kReplacedSuffix);
+
+    m_descriptor.m_keyType = keyType;
+    m_descriptor.m_elementSize = Layer::getElementSize(keyType);
+
+    std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5keyDataSet;
+    std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5vrKeyDataSet;
+
+    try
+    {
+        // The key grid keeps its dimensions; writeVR() changes those of
+        // the Dataset descriptor.
+        std::array<hsize_t, kRank> dims{};
+        m_pH5keyDataSet->getSpace().getSimpleExtentDims(dims.data());
+
+        pH5keyDataSet = createH5keyDataSet(*pDataset, m_descriptor,
+            static_cast<uint32_t>(dims[0]), static_cast<uint32_t>(dims[1]));
+        copyKeys(*m_pH5keyDataSet, oldKeyType, *pH5keyDataSet, maxKey);
+
+        if (m_pH5vrKeyDataSet)
+        {
+            pH5vrKeyDataSet = createH5vrKeyDataSet(*pDataset, m_descriptor);
+
+            hsize_t length = 0;
+            m_pH5vrKeyDataSet->getSpace().getSimpleExtentDims(&length);
+            pH5vrKeyDataSet->extend(&length);
+
+            copyKeys(*m_pH5vrKeyDataSet, oldKeyType, *pH5vrKeyDataSet, maxKey);
+        }
+    }
+    catch (...)
+    {
+        // Put the old keys back.
+        m_descriptor.m_keyType = oldKeyType;
+        m_descriptor.m_elementSize = Layer::getElementSize(oldKeyType);
+
+        pH5keyDataSet.reset();
+        pH5vrKeyDataSet.reset();
+
+        for (const auto& path : {keysPath, vrKeysPath})
+        {
+            const auto replacedPath = path + kReplacedSuffix;
+            if (H5Lexists(h5file.getId(), replacedPath.c_str(), H5P_DEFAULT) <= 0)
+                continue;
+
+            if (H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) > 0)
+                h5file.unlink(path);
+
+            h5file.moveLink(replacedPath, path);
+        }
+
+        throw;
+    }
+
+    m_pH5keyDataSet = std::move(pH5keyDataSet);
+    h5file.unlink(keysPath + kReplacedSuffix);
+
+    if (pH5vrKeyDataSet)
+    {
+        m_pH5vrKeyDataSet = std::move(pH5vrKeyDataSet);
+        h5file.unlink(vrKeysPath + kReplacedSuffix);
+    }
+
+    // Layers are created with room for as many records/values as their key
+    // type addresses, so a wider key type needs a larger values DataSet.
+    hsize_t numValues = 0, maxNumValues = 0;
+    m_pH5valueDataSet->getSpace().getSimpleExtentDims(&numValues, &maxNumValues);
+    if (maxNumValues != H5S_UNLIMITED && maxNumValues < maxKey)
+        this->rewriteValues(*pDataset);
+}
+
+//! Determine if the layer has keys for the variable resolution refinements.
+/*!
+\return
+    \e true if the layer was created in a variable resolution BAG, so
+    readVR() and writeVR() can be used.
+    \e false otherwise.
+*/
+bool GeorefMetadataLayer::hasVRKeys() const noexcept
+{
+    return static_cast<bool>(m_pH5vrKeyDataSet);
+}
+
+//! Read the variable resolution metadata keys.
+/*!
+\param indexStart
+    The starting index to read.
+    Must be less than or equal to indexEnd.
+\param indexEnd
+    The ending index to read.  (inclusive)
 
 \return
     The specified keys.
@@ -475,15 +1712,46 @@ UInt8Array GeorefMetadataLayer::readProxy(
 UInt8Array GeorefMetadataLayer::readVR(
     uint32_t indexStart,
     uint32_t indexEnd) const
+{
+    if (indexStart > indexEnd)
+        throw InvalidReadSize{};
+
+    // Allocate the output buffer; the read overwrites all of it.
+    const auto bufferSize = m_descriptor.getReadBufferSize(1,
+        (indexEnd - indexStart) + 1);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
+
+    this->readVRInto(indexStart, indexEnd, buffer.data(), bufferSize);
+
+    return buffer;
+}
+
+//! Read the variable resolution metadata keys into a caller owned buffer.
+/*!
+\param indexStart
+    The starting index to read.
+    Must be less than or equal to indexEnd.
+\param indexEnd
+    The ending index to read.  (inclusive)
+\param buffer
+    The buffer to read into.
+\param bufferSize
+    The size of buffer, in bytes.
+*/
+void GeorefMetadataLayer::readVRInto(
+    uint32_t indexStart,
+    uint32_t indexEnd,
+    uint8_t* buffer,
+    size_t bufferSize) const
 {
     // Make sure the variable resolution key dataset is present.
     if (!m_pH5vrKeyDataSet)
         throw DatasetRequiresVariableResolution{};
 
-    auto pDescriptor = std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
+    if (this->getDataset().expired())
+        throw DatasetNotFound{};
+
+    const auto lock = this->getDataset().lock()->lockReads();
 
     // Query the file for the specified rows and columns.
     const auto h5fileDataSpace = m_pH5vrKeyDataSet->getSpace();
@@ -503,21 +1771,182 @@ UInt8Array GeorefMetadataLayer::readVR(
     const hsize_t count = (indexEnd - indexStart) + 1;
     const hsize_t offset = indexStart;
 
+    if (!buffer || bufferSize < count * m_descriptor.getElementSize())
+        throw InvalidBuffer{};
+
     const auto fileDataSpace = m_pH5vrKeyDataSet->getSpace();
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
 
-    // Initialize the output buffer.
-    const auto bufferSize = pDescriptor->getReadBufferSize(1,
-        static_cast<uint32_t>(count));
-    UInt8Array buffer{bufferSize};
-
     // Prepare the memory space.
     const ::H5::DataSpace memDataSpace{1, &count, &count};
 
-    m_pH5vrKeyDataSet->read(buffer.data(),
-        H5Dget_type(m_pH5vrKeyDataSet->getId()), memDataSpace, fileDataSpace);
+    m_pH5vrKeyDataSet->read(buffer,
+        m_pH5vrKeyDataSet->getDataType(), memDataSpace, fileDataSpace);
+}
 
-    return buffer;
+//! Read the values of some fields for a range of variable resolution nodes.
+/*!
+\param indexStart
+    The starting index to read.
+    Must be less than or equal to indexEnd.
+\param indexEnd
+    The ending index to read.  (inclusive)
+\param fieldNames
+    The fields to read.
+
+\return
+    The values, one column per field in the order of fieldNames, with one
+    value per node.
+*/
+std::vector<ResolvedColumn> GeorefMetadataLayer::readVRResolved(
+    uint32_t indexStart,
+    uint32_t indexEnd,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto keys = this->readVR(indexStart, indexEnd);
+
+    return m_pValueTable->resolve(keys.data(),
+        m_descriptor.getDataType(), (indexEnd - indexStart) + 1,
+        fieldNames);
+}
+
+//! Read the refinements of some supergrid cells, joined with the values of
+//! some fields.
+/*!
+    Cells that are not refined, or are outside the supergrid, are left out.
+    The refinements, the keys, and the metadata are read in contiguous
+    blocks, and the keys are resolved at once.
+
+\param cells
+    The cells, as (row, column).
+\param fieldNames
+    The fields to read.
+
+\return
+    The cells and their refinements, with one value per refinement.
+*/
+VRResolvedRead GeorefMetadataLayer::readVRResolved(
+    const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    VRCellIterator iterator{*pDataset, cells};
+
+    return this->readVRResolved(iterator, fieldNames);
+}
+
+//! Read the refinements of the supergrid cells in an area, joined with the
+//! values of some fields.
+/*!
+    Every refined supergrid cell overlapping the area is read whole; its
+    refinements are not clipped to the area.
+
+\param minX
+    The west edge of the area.
+\param minY
+    The south edge of the area.
+\param maxX
+    The east edge of the area.
+\param maxY
+    The north edge of the area.
+\param fieldNames
+    The fields to read.
+
+\return
+    The cells and their refinements, with one value per refinement.
+*/
+VRResolvedRead GeorefMetadataLayer::readVRResolved(
+    double minX,
+    double minY,
+    double maxX,
+    double maxY,
+    const std::vector<std::string>& fieldNames) const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto pMetadata = pDataset->getVRMetadata();
+    if (!pMetadata)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = descriptor.getGridSpacing();
+
+    // Writing variable resolution nodes changes the dimensions of the
+    // descriptor, so use those of the supergrid.
+    const auto pTable = pMetadata->getTable();
+
+    uint32_t rowStart = 0, rowEnd = 0, columnStart = 0, columnEnd = 0;
+    if (!findOverlappingCells(minY, maxY, originY, spacingY,
+            pTable->getNumRows(), rowStart, rowEnd) ||
+        !findOverlappingCells(minX, maxX, originX, spacingX,
+            pTable->getNumColumns(), columnStart, columnEnd))
+        return this->readVRResolved(
+            std::vector<std::pair<uint32_t, uint32_t>>{}, fieldNames);
+
+    VRCellIterator iterator{*pDataset, rowStart, columnStart, rowEnd,
+        columnEnd};
+
+    return this->readVRResolved(iterator, fieldNames);
+}
+
+//! Read the refinements of the cells of a walk, joined with the values of
+//! some fields.
+/*!
+\param iterator
+    The walk; it is started again, reading the keys of this layer.
+\param fieldNames
+    The fields to read.
+
+\return
+    The cells and their refinements, with one value per refinement.
+*/
+VRResolvedRead GeorefMetadataLayer::readVRResolved(
+    VRCellIterator& iterator,
+    const std::vector<std::string>& fieldNames) const
+{
+    iterator.setKeyLayer(this);
+
+    const auto keySize = m_descriptor.getElementSize();
+
+    VRResolvedRead result;
+    result.cells.reserve(iterator.size());
+
+    std::vector<uint8_t> keys;
+
+    VRCell cell;
+    while (iterator.next(cell))
+    {
+        VRResolvedCell resolved;
+        resolved.row = cell.row;
+        resolved.column = cell.column;
+        resolved.metadata = *cell.metadata;
+        resolved.offset = result.depths.size();
+        resolved.count = cell.count;
+        result.cells.push_back(resolved);
+
+        for (uint32_t i=0; i<cell.count; ++i)
+        {
+            result.depths.push_back(cell.refinements[i].depth);
+            result.uncertainties.push_back(cell.refinements[i].depth_uncrt);
+        }
+
+        keys.insert(keys.end(), cell.keys, cell.keys + cell.count * keySize);
+    }
+
+    result.columns = m_pValueTable->resolve(keys.data(),
+        m_descriptor.getDataType(), result.depths.size(),
+        fieldNames);
+
+    return result;
 }
 
 //! Set the value table.
@@ -539,6 +1968,9 @@ void GeorefMetadataLayer::writeProxy(
     uint32_t columnEnd,
     const uint8_t* buffer)
 {
+    // HDF5 writes the keys, so the whole write holds the lock.
+    const auto lock = this->getDataset().lock()->lockWrites();
+
     const auto h5fileDataSpace = m_pH5keyDataSet->getSpace();
 
     // Make sure the area being written to does not exceed the file dimensions.
@@ -562,8 +1994,10 @@ void GeorefMetadataLayer::writeProxy(
     // Prepare the memory space.
     const ::H5::DataSpace h5memDataSpace{kRank, count.data(), count.data()};
 
-    m_pH5keyDataSet->write(buffer, H5Dget_type(m_pH5keyDataSet->getId()),
+    m_pH5keyDataSet->write(buffer, m_pH5keyDataSet->getDataType(),
         h5memDataSpace, h5fileDataSpace);
+
+    removeCachedKeyStatistics(*m_pH5keyDataSet);
 }
 
 //! \copydoc Layer::writeAttributes
@@ -608,11 +2042,6 @@ void GeorefMetadataLayer::writeVR(
     if (indexStart > indexEnd)
         throw InvalidWriteSize{};
 
-    auto pDescriptor = std::dynamic_pointer_cast<GeorefMetadataLayerDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     const hsize_t count = (indexEnd - indexStart) + 1;
     const hsize_t offset = indexStart;
     const ::H5::DataSpace memDataSpace{1, &count, &count};
@@ -625,17 +2054,15 @@ void GeorefMetadataLayer::writeVR(
         m_pH5vrKeyDataSet->extend(&newMaxLength);
 
         h5fileDataSpace = m_pH5vrKeyDataSet->getSpace();
-
-        // Update the dataset's dimensions.
-        auto pDataset = this->getDataset().lock();
-        pDataset->getDescriptor().setDims(1, static_cast<uint32_t>(newMaxLength));
     }
 
     // Write the specified data.
     h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
 
-    m_pH5vrKeyDataSet->write(buffer, H5Dget_type(m_pH5vrKeyDataSet->getId()),
+    m_pH5vrKeyDataSet->write(buffer, m_pH5vrKeyDataSet->getDataType(),
         memDataSpace, h5fileDataSpace);
+
+    removeCachedKeyStatistics(*m_pH5vrKeyDataSet);
 }
 
 }  // namespace BAG
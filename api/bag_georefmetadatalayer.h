@@ -12,6 +12,8 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace H5 {
 
@@ -26,6 +28,57 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! How many nodes of a georeferenced metadata layer use a key, and where.
+/*!
+    For variable resolution keys the row is always 0, and the column is the
+    index of the node.
+*/
+struct BAG_API KeyStatistics final
+{
+    //! The number of nodes using the key.
+    uint64_t count = 0;
+    //! The first row using the key.
+    uint32_t minRow = 0;
+    //! The first column using the key.
+    uint32_t minColumn = 0;
+    //! The last row using the key.
+    uint32_t maxRow = 0;
+    //! The last column using the key.
+    uint32_t maxColumn = 0;
+};
+
+//! A refined supergrid cell read by GeorefMetadataLayer::readVRResolved().
+struct BAG_API VRResolvedCell final
+{
+    //! The supergrid row.
+    uint32_t row = 0;
+    //! The supergrid column.
+    uint32_t column = 0;
+    //! The VRMetadata item of the cell.
+    VRMetadataItem metadata{};
+    //! The position of the first refinement of the cell in the read.
+    size_t offset = 0;
+    //! The number of refinements of the cell.
+    uint32_t count = 0;
+};
+
+//! The refinements of some supergrid cells, joined with their metadata.
+/*!
+    The refinements of each cell are row major, from VRResolvedCell::offset
+    in the depths, the uncertainties and each of the columns.
+*/
+struct BAG_API VRResolvedRead final
+{
+    //! The refined cells, in the order of their first refinement.
+    std::vector<VRResolvedCell> cells;
+    //! The depth of each refinement.
+    std::vector<float> depths;
+    //! The uncertainty of each refinement.
+    std::vector<float> uncertainties;
+    //! The values, one column per field, with one value per refinement.
+    std::vector<ResolvedColumn> columns;
+};
+
 //! The interface for a georeferenced metadata layer (spatial metadata).
 class BAG_API GeorefMetadataLayer final : public Layer
 {
@@ -58,21 +111,54 @@ public:
     ValueTable& getValueTable() & noexcept;
     const ValueTable& getValueTable() const & noexcept;
 
+    std::vector<std::pair<uint32_t, uint32_t>> findCells(
+        const ValueQuery& query, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+
+    std::vector<KeyStatistics> computeKeyStatistics(
+        bool cacheResult = false) const;
+    std::vector<KeyStatistics> computeVRKeyStatistics(
+        bool cacheResult = false) const;
+
+    std::vector<ResolvedColumn> readResolved(uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        const std::vector<std::string>& fieldNames) const;
+
+    UInt8Array readKeys(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, DataType keyType) const;
+    UInt8Array readVRKeys(uint32_t indexStart, uint32_t indexEnd,
+        DataType keyType) const;
+
+    DataType getNarrowestKeyType() const;
+    DataType narrowKeyType();
+    void setKeyType(DataType keyType);
+
+    bool hasVRKeys() const noexcept;
     UInt8Array readVR(uint32_t indexStart, uint32_t indexEnd) const;
+    void readVRInto(uint32_t indexStart, uint32_t indexEnd, uint8_t* buffer,
+        size_t bufferSize) const;
+    std::vector<ResolvedColumn> readVRResolved(uint32_t indexStart,
+        uint32_t indexEnd, const std::vector<std::string>& fieldNames) const;
+    VRResolvedRead readVRResolved(
+        const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+        const std::vector<std::string>& fieldNames) const;
+    VRResolvedRead readVRResolved(double minX, double minY, double maxX,
+        double maxY, const std::vector<std::string>& fieldNames) const;
     void writeVR(uint32_t indexStart, uint32_t indexEnd, const uint8_t* buffer);
 
 protected:
     static std::shared_ptr<GeorefMetadataLayer> create(DataType keyType,
                                                        const std::string& name, GeorefMetadataProfile profile, Dataset& dataset,
-                                                       const RecordDefinition& definition, uint64_t chunkSize,
-                                                       int compressionLevel);
+                                                       const RecordDefinition& definition, const ChunkShape& chunkShape,
+                                                       const CompressionSpec& compression);
     static std::shared_ptr<GeorefMetadataLayer> open(Dataset& dataset,
                                                      GeorefMetadataLayerDescriptor& descriptor);
 
 private:
     static std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
         createH5keyDataSet(const Dataset& inDataSet,
-            const GeorefMetadataLayerDescriptor& descriptor);
+            const GeorefMetadataLayerDescriptor& descriptor, uint32_t numRows,
+            uint32_t numColumns);
 
     static std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
         createH5vrKeyDataSet(const Dataset& inDataSet,
@@ -84,16 +170,28 @@ private:
 
     const ::H5::DataSet& getValueDataSet() const &;
 
+    void checkNumRecords(size_t numRecords) const;
+    void rewriteValues(const Dataset& dataset);
+
+    VRResolvedRead readVRResolved(VRCellIterator& iterator,
+        const std::vector<std::string>& fieldNames) const;
+
     void setValueTable(std::unique_ptr<ValueTable> table) noexcept;
 
     UInt8Array readProxy(uint32_t rowStart, uint32_t columnStart,
         uint32_t rowEnd, uint32_t columnEnd) const override;
 
+    void readIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const override;
+
     void writeProxy(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
         uint32_t columnEnd, const uint8_t* buffer) override;
 
     void writeAttributesProxy() const override;
 
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    GeorefMetadataLayerDescriptor& m_descriptor;
     //! The HDF5 DataSet containing the single resolution keys.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5keyDataSet;
     //! The HDF5 DataSet containing the variable resolution keys.
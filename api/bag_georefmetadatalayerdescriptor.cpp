@@ -138,8 +138,9 @@ std::shared_ptr<GeorefMetadataLayerDescriptor> GeorefMetadataLayerDescriptor::op
     attribute.read(attribute.getDataType(), definition.data());
 
     // Determine chunk size and compression level.
-    const auto chunkSize = BAG::getChunkSize(h5file, internalPath);
-    const auto compressionLevel = BAG::getCompressionLevel(h5file, internalPath);
+    uint64_t chunkSize = 0, chunkColumns = 0;
+    std::tie(chunkSize, chunkColumns) = BAG::getChunkDims(h5file, internalPath);
+    auto compression = BAG::getCompressionSpec(h5file, internalPath);
 
     // Read metadata profile as string from HDF5 file attribute and convert to GeorefMetadataProfile enum value.
     std::string profileString;
@@ -165,9 +166,13 @@ std::shared_ptr<GeorefMetadataLayerDescriptor> GeorefMetadataLayerDescriptor::op
         profile = UNKNOWN_METADATA_PROFILE;
     }
 
-    return std::shared_ptr<GeorefMetadataLayerDescriptor>(
+    std::shared_ptr<GeorefMetadataLayerDescriptor> pDescriptor(
         new GeorefMetadataLayerDescriptor{dataset, name, profile, keyType, definition,
-                                          chunkSize, compressionLevel});
+                                          chunkSize, compression.level});
+    pDescriptor->setChunkDims(chunkSize, chunkColumns);
+    pDescriptor->setCompressionSpec(std::move(compression));
+
+    return pDescriptor;
 }
 
 
@@ -209,7 +214,7 @@ GeorefMetadataLayerDescriptor::getDefinition() const & noexcept
 \return
     The metadata profile type.
  */
-GeorefMetadataProfile GeorefMetadataLayerDescriptor::getProfile() {
+GeorefMetadataProfile GeorefMetadataLayerDescriptor::getProfile() const {
     return m_profile;
 }
 
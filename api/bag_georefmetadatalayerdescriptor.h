@@ -48,7 +48,7 @@ public:
 
     std::weak_ptr<Dataset> getDataset() const &;
     const RecordDefinition& getDefinition() const & noexcept;
-    GeorefMetadataProfile getProfile();
+    GeorefMetadataProfile getProfile() const;
 
 protected:
     GeorefMetadataLayerDescriptor(Dataset& dataset, const std::string& name, GeorefMetadataProfile profile,
@@ -0,0 +1,205 @@
+#ifndef BAG_GRID_H
+#define BAG_GRID_H
+
+#include "bag_c_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace BAG {
+
+//! The DataType of the elements of a Grid, by their C++ type.
+template <typename T>
+struct GridDataType;
+
+template <>
+struct GridDataType<float>
+{
+    //! The DataType.
+    static constexpr BAG_DATA_TYPE value = DT_FLOAT32;
+};
+
+template <>
+struct GridDataType<uint8_t>
+{
+    //! The DataType.
+    static constexpr BAG_DATA_TYPE value = DT_UINT8;
+};
+
+template <>
+struct GridDataType<uint16_t>
+{
+    //! The DataType.
+    static constexpr BAG_DATA_TYPE value = DT_UINT16;
+};
+
+template <>
+struct GridDataType<uint32_t>
+{
+    //! The DataType.
+    static constexpr BAG_DATA_TYPE value = DT_UINT32;
+};
+
+template <>
+struct GridDataType<uint64_t>
+{
+    //! The DataType.
+    static constexpr BAG_DATA_TYPE value = DT_UINT64;
+};
+
+//! The alignment, in bytes, of each row of a Grid.
+constexpr size_t kGridAlignment = 64;
+
+//! An owning, row major grid of elements, as read by Layer::readAs().
+/*!
+    Each row starts on a kGridAlignment byte boundary, so rows are padded to
+    getStride() elements.  T is one of the types a layer can be read as:
+    float, uint8_t, uint16_t, uint32_t or uint64_t.
+*/
+template <typename T>
+class Grid final
+{
+public:
+    //! The type of the elements.
+    using value_type = T;
+
+    Grid() = default;
+
+    //! Constructor.
+    /*!
+        The elements are not initialized.
+
+    \param rows
+        The number of rows.
+    \param columns
+        The number of columns.
+    */
+    Grid(uint32_t rows, uint32_t columns)
+        : m_rows(rows)
+        , m_columns(columns)
+        , m_stride(((columns * sizeof(T) + kGridAlignment - 1) /
+            kGridAlignment) * kGridAlignment / sizeof(T))
+    {
+        const auto numBytes = static_cast<size_t>(rows) * m_stride * sizeof(T);
+        if (numBytes == 0)
+            return;
+
+        m_storage.reset(new uint8_t[numBytes + kGridAlignment - 1]);
+
+        const auto address = reinterpret_cast<uintptr_t>(m_storage.get());
+        m_data = reinterpret_cast<T*>((address + kGridAlignment - 1) /
+            kGridAlignment * kGridAlignment);
+    }
+
+    Grid(const Grid&) = delete;
+    Grid(Grid&& other) noexcept
+        : m_rows(other.m_rows)
+        , m_columns(other.m_columns)
+        , m_stride(other.m_stride)
+        , m_storage(std::move(other.m_storage))
+        , m_data(other.m_data)
+    {
+        other.m_rows = other.m_columns = 0;
+        other.m_stride = 0;
+        other.m_data = nullptr;
+    }
+
+    Grid& operator=(const Grid&) = delete;
+    Grid& operator=(Grid&& rhs) noexcept
+    {
+        if (this == &rhs)
+            return *this;
+
+        m_rows = rhs.m_rows;
+        m_columns = rhs.m_columns;
+        m_stride = rhs.m_stride;
+        m_storage = std::move(rhs.m_storage);
+        m_data = rhs.m_data;
+
+        rhs.m_rows = rhs.m_columns = 0;
+        rhs.m_stride = 0;
+        rhs.m_data = nullptr;
+
+        return *this;
+    }
+
+    //! Retrieve the number of rows.
+    uint32_t getRows() const noexcept
+    {
+        return m_rows;
+    }
+
+    //! Retrieve the number of columns.
+    uint32_t getColumns() const noexcept
+    {
+        return m_columns;
+    }
+
+    //! Retrieve the distance, in elements, between the start of two rows.
+    size_t getStride() const noexcept
+    {
+        return m_stride;
+    }
+
+    //! Is the grid empty?
+    bool empty() const noexcept
+    {
+        return !m_data;
+    }
+
+    //! Retrieve the first element of the first row.
+    T* data() & noexcept
+    {
+        return m_data;
+    }
+
+    //! Retrieve the first element of the first row.
+    const T* data() const & noexcept
+    {
+        return m_data;
+    }
+
+    //! Retrieve the first element of a row.
+    T* row(uint32_t row) & noexcept
+    {
+        return m_data + row * m_stride;
+    }
+
+    //! Retrieve the first element of a row.
+    const T* row(uint32_t row) const & noexcept
+    {
+        return m_data + row * m_stride;
+    }
+
+    //! Retrieve an element.
+    T& operator()(uint32_t row, uint32_t column) & noexcept
+    {
+        return m_data[row * m_stride + column];
+    }
+
+    //! Retrieve an element.
+    const T& operator()(uint32_t row, uint32_t column) const & noexcept
+    {
+        return m_data[row * m_stride + column];
+    }
+
+private:
+    //! The number of rows.
+    uint32_t m_rows = 0;
+    //! The number of columns.
+    uint32_t m_columns = 0;
+    //! The distance, in elements, between the start of two rows.
+    size_t m_stride = 0;
+    //! The memory the elements are in.
+    std::unique_ptr<uint8_t[]> m_storage;
+    //! The first element; aligned within m_storage.
+    T* m_data = nullptr;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_GRID_H
+
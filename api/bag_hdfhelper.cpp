@@ -1,8 +1,11 @@
 
 #include "bag_exceptions.h"
 #include "bag_hdfhelper.h"
+#include "bag_private.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <H5Cpp.h>
 #include <numeric>
 
@@ -80,6 +83,52 @@ namespace BAG {
     return h5type;
 }
 
+//! Create an HDF5 CompType of a whole record of a legacy group.
+/*!
+    The members are those createH5compType() reads one at a time, laid out as
+    BagOptNodeGroup or BagOptElevationSolutionGroup.
+
+\param groupType
+    The type of group; NODE or ELEVATION.
+
+\return
+    The HDF5 CompType of a record in memory.
+*/
+::H5::CompType createH5groupCompType(
+    GroupType groupType)
+{
+    if (groupType == NODE)
+    {
+        ::H5::CompType h5type{sizeof(BagOptNodeGroup)};
+        h5type.insertMember("hyp_strength",
+            HOFFSET(BagOptNodeGroup, hyp_strength),
+            ::H5::PredType::NATIVE_FLOAT);
+        h5type.insertMember("num_hypotheses",
+            HOFFSET(BagOptNodeGroup, num_hypotheses),
+            ::H5::PredType::NATIVE_UINT32);
+
+        return h5type;
+    }
+
+    if (groupType == ELEVATION)
+    {
+        ::H5::CompType h5type{sizeof(BagOptElevationSolutionGroup)};
+        h5type.insertMember("shoal_elevation",
+            HOFFSET(BagOptElevationSolutionGroup, shoal_elevation),
+            ::H5::PredType::NATIVE_FLOAT);
+        h5type.insertMember("stddev",
+            HOFFSET(BagOptElevationSolutionGroup, stddev),
+            ::H5::PredType::NATIVE_FLOAT);
+        h5type.insertMember("num_soundings",
+            HOFFSET(BagOptElevationSolutionGroup, num_soundings),
+            ::H5::PredType::NATIVE_INT32);
+
+        return h5type;
+    }
+
+    throw UnsupportedGroupType{};
+}
+
 //! Create an HDF5 CompType used for file I/O based upon the Record Definition.
 /*!
 \param definition
@@ -130,6 +179,41 @@ namespace BAG {
     return h5type;
 }
 
+//! Create an HDF5 DataSpace describing a (possibly strided) memory buffer.
+/*!
+\param rows
+    The number of rows to read or write.
+\param columns
+    The number of columns to read or write.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in the buffer.
+    Must be a multiple of elementSize.
+\param elementSize
+    The size of one element, in bytes.
+
+\return
+    The memory DataSpace, with the rows and columns selected.
+*/
+::H5::DataSpace createH5memorySpace(
+    uint32_t rows,
+    uint32_t columns,
+    size_t rowStrideBytes,
+    size_t elementSize)
+{
+    const std::array<hsize_t, kRank> count{rows, columns};
+    const std::array<hsize_t, kRank> dims{rows, rowStrideBytes / elementSize};
+
+    ::H5::DataSpace h5memSpace{kRank, dims.data(), dims.data()};
+
+    if (dims[1] != count[1])
+    {
+        const std::array<hsize_t, kRank> offset{0, 0};
+        h5memSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+    }
+
+    return h5memSpace;
+}
+
 //! Get the chunk size from an HDF5 file.
 /*!
 \param h5file
@@ -138,12 +222,31 @@ namespace BAG {
     The path to the HDF5 DataSet.
 
 \return
-    The chunk size of the specified HDF5 DataSet in the HDF5 file.
+    The rows in a chunk of the specified HDF5 DataSet in the HDF5 file.
     0 if the HDF5 DataSet does not use chunking.
 */
 uint64_t getChunkSize(
     const ::H5::H5File& h5file,
     const std::string& path)
+{
+    return std::get<0>(getChunkDims(h5file, path));
+}
+
+//! Get the chunk dimensions from an HDF5 file.
+/*!
+\param h5file
+    The HDF5 file.
+\param path
+    The path to the HDF5 DataSet.
+
+\return
+    The rows and columns in a chunk of the specified HDF5 DataSet in the
+    HDF5 file.
+    0 and 0 if the HDF5 DataSet does not use chunking.
+*/
+std::tuple<uint64_t, uint64_t> getChunkDims(
+    const ::H5::H5File& h5file,
+    const std::string& path)
 {
     //Get the elevation HD5 dataset.
     const auto h5dataset = h5file.openDataSet(path);
@@ -155,15 +258,41 @@ uint64_t getChunkSize(
 
         const int rankChunk = h5pList.getChunk(kRank, maxDims.data());
         if (rankChunk == kRank)
-            // This cast probably only matters on 32-bit systems, but gets rid of a compiler warning from the
-            //  previous code, which was `return {maxDims[0]};
-            return (uint64_t) maxDims[0];
+            return std::make_tuple(static_cast<uint64_t>(maxDims[0]),
+                static_cast<uint64_t>(maxDims[1]));
     }
 
-    return 0;
+    return std::make_tuple(uint64_t{0}, uint64_t{0});
 }
 
-//! Get the compression level from an HDF5 file.
+//! Choose the chunk size of a 1D DataSet for an expected number of items.
+/*!
+    A DataSet grown an item or a few at a time with small chunks ends up
+    with a large chunk index.  The chunks are instead sized for the items
+    expected: a small DataSet is one chunk, and a large one is in chunks of
+    about 512 KiB, which fit the default HDF5 chunk cache.
+
+\param numItems
+    The number of items expected.
+\param itemSize
+    The size of an item, in bytes.
+
+\return
+    The number of items in a chunk; at least 1.
+*/
+uint64_t getHintedChunkSize(
+    uint64_t numItems,
+    size_t itemSize) noexcept
+{
+    constexpr uint64_t kMaxChunkBytes = uint64_t{1} << 19;
+
+    const auto maxItems = std::max<uint64_t>(1,
+        kMaxChunkBytes / std::max<size_t>(itemSize, 1));
+
+    return std::max<uint64_t>(1, std::min(numItems, maxItems));
+}
+
+//! Get the compression of an HDF5 DataSet.
 /*!
 \param h5file
     The HDF5 file.
@@ -171,10 +300,11 @@ uint64_t getChunkSize(
     The path to the HDF5 DataSet.
 
 \return
-    The compression level of the specified HDF5 DataSet in the HDF5 file.
-    0 if the HDF5 DataSet is not compressed.
+    The compression filter, level and shuffling of the specified HDF5 DataSet
+    in the HDF5 file.
+    Deflate at level 0 if the HDF5 DataSet is not compressed.
 */
-int getCompressionLevel(
+CompressionSpec getCompressionSpec(
     const ::H5::H5File& h5file,
     const std::string& path)
 {
@@ -182,22 +312,146 @@ int getCompressionLevel(
     const auto h5dataset = h5file.openDataSet(path);
     const auto h5pList = h5dataset.getCreatePlist();
 
+    CompressionSpec compression;
+
     for (int i=0; i<h5pList.getNfilters(); ++i)
     {
         unsigned int flags = 0;
-        size_t cdNelmts = 10;
+        constexpr size_t kMaxCdValues = 10;
+        size_t cdNelmts = kMaxCdValues;
         constexpr size_t nameLen = 64;
-        std::array<unsigned int, 10> cdValues{};
+        std::array<unsigned int, kMaxCdValues> cdValues{};
         std::array<char, 64> name{};
         unsigned int filterConfig = 0;
 
         const auto filter = h5pList.getFilter(i, flags, cdNelmts,
             cdValues.data(), nameLen, name.data(), filterConfig);
-        if (filter == H5Z_FILTER_DEFLATE && cdNelmts >= 1)
-            return static_cast<int>(cdValues.front());
+        cdNelmts = std::min(cdNelmts, kMaxCdValues);
+
+        switch (filter)
+        {
+        case H5Z_FILTER_SHUFFLE:
+            compression.shuffle = ShuffleMode::Byte;
+            break;
+        case kBitshuffleFilter:
+            compression.shuffle = ShuffleMode::Bit;
+            break;
+        case H5Z_FILTER_DEFLATE:
+            compression.filter = kDeflateFilter;
+            compression.level = cdNelmts >= 1
+                ? static_cast<int>(cdValues.front())
+                : 0;
+            break;
+        case H5Z_FILTER_FLETCHER32:
+        case H5Z_FILTER_NBIT:
+        case H5Z_FILTER_SCALEOFFSET:
+            // Not compression filters.
+            break;
+        default:
+            compression.filter = static_cast<int>(filter);
+            compression.parameters.assign(cdValues.begin(),
+                cdValues.begin() + cdNelmts);
+            compression.level = cdNelmts == 1
+                ? static_cast<int>(cdValues.front())
+                : 0;
+            break;
+        }
     }
 
-    return 0;
+    return compression;
+}
+
+//! Determine if an HDF5 filter is built in, or its plugin can be loaded.
+/*!
+\param filter
+    The HDF5 filter id.
+
+\return
+    \e true if the filter can be used.
+*/
+bool isFilterAvailable(
+    int filter) noexcept
+{
+    return H5Zfilter_avail(static_cast<H5Z_filter_t>(filter)) > 0;
+}
+
+//! Add the compression filters to the creation property list of a DataSet.
+/*!
+\param h5createPropList
+    The creation property list; it must already be chunked.
+\param compression
+    The compression filter, level and shuffling.
+    Deflate levels above kMaxCompressionLevel do not compress.
+*/
+void setCompression(
+    const ::H5::DSetCreatPropList& h5createPropList,
+    const CompressionSpec& compression)
+{
+    if (!compression.isCompressed())
+        return;
+
+    if (compression.filter != kDeflateFilter &&
+        !isFilterAvailable(compression.filter))
+        throw CompressionFilterNotAvailable{compression.filter};
+
+    if (compression.shuffle == ShuffleMode::Byte)
+        h5createPropList.setShuffle();
+    else if (compression.shuffle == ShuffleMode::Bit)
+    {
+        if (!isFilterAvailable(kBitshuffleFilter))
+            throw CompressionFilterNotAvailable{kBitshuffleFilter};
+
+        // The filter picks the block size, and does not compress itself.
+        constexpr std::array<unsigned int, 2> kBitshuffleValues{0, 0};
+        h5createPropList.setFilter(kBitshuffleFilter, H5Z_FLAG_MANDATORY,
+            kBitshuffleValues.size(), kBitshuffleValues.data());
+    }
+
+    if (compression.filter == kDeflateFilter)
+    {
+        if (compression.level <= kMaxCompressionLevel)
+            h5createPropList.setDeflate(compression.level);
+
+        return;
+    }
+
+    const std::vector<unsigned int> levelValues{
+        static_cast<unsigned int>(compression.level)};
+    const auto& cdValues = compression.parameters.empty()
+        ? levelValues
+        : compression.parameters;
+
+    h5createPropList.setFilter(compression.filter, H5Z_FLAG_MANDATORY,
+        cdValues.size(), cdValues.data());
+}
+
+//! Add the scale-offset filter quantizing floats to the creation property list of a DataSet.
+/*!
+    Decimal scaling rounds each value to D decimal digits, an error of at
+    most half of 10^-D, so D is the fewest digits within the error bound.
+    The filter stores the fill value exactly, and values it cannot pack
+    unchanged.  It goes before any compression filter.
+
+\param h5createPropList
+    The creation property list; it must already be chunked.
+\param quantization
+    The quantization.
+*/
+void setQuantization(
+    const ::H5::DSetCreatPropList& h5createPropList,
+    const Quantization& quantization)
+{
+    if (!quantization.isQuantized())
+        return;
+
+    const auto digits = std::max(0, static_cast<int>(
+        std::ceil(-std::log10(2. * quantization.absErrorBound))));
+
+    // The C++ API of HDF5 1.10 does not wrap this filter.
+    if (H5Pset_scaleoffset(h5createPropList.getId(), H5Z_SO_FLOAT_DSCALE,
+        digits) < 0)
+        throw ::H5::PropListIException{"setQuantization",
+            "H5Pset_scaleoffset failed"};
 }
 
 //! Get the size of a record in memory.
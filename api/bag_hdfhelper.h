@@ -8,6 +8,7 @@
 #include "bag_valuetable.h"
 
 #include <string>
+#include <tuple>
 
 
 //! Forward declarations of HDF5 classes used, to avoid exposing dependencies
@@ -18,6 +19,8 @@ class AtomType;
 class Attribute;
 class CompType;
 class DataSet;
+class DataSpace;
+class DSetCreatPropList;
 class H5File;
 class PredType;
 
@@ -28,16 +31,28 @@ namespace BAG {
 
 ::H5::CompType createH5compType(LayerType layerType,
     GroupType groupType);
+::H5::CompType createH5groupCompType(GroupType groupType);
 
 ::H5::CompType createH5fileCompType(const RecordDefinition& definition);
 
 ::H5::CompType createH5memoryCompType(const RecordDefinition& definition);
 
+::H5::DataSpace createH5memorySpace(uint32_t rows, uint32_t columns,
+    size_t rowStrideBytes, size_t elementSize);
+
 uint64_t getChunkSize(const ::H5::H5File& h5file,
     const std::string& path);
+std::tuple<uint64_t, uint64_t> getChunkDims(const ::H5::H5File& h5file,
+    const std::string& path);
+uint64_t getHintedChunkSize(uint64_t numItems, size_t itemSize) noexcept;
 
-int getCompressionLevel(const ::H5::H5File& h5file,
+CompressionSpec getCompressionSpec(const ::H5::H5File& h5file,
     const std::string& path);
+bool isFilterAvailable(int filter) noexcept;
+void setCompression(const ::H5::DSetCreatPropList& h5createPropList,
+    const CompressionSpec& compression);
+void setQuantization(const ::H5::DSetCreatPropList& h5createPropList,
+    const Quantization& quantization);
 
 size_t getRecordSize(const RecordDefinition& definition);
 
@@ -1,15 +1,27 @@
 
+#include "bag_accesstracer.h"
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
 #include "bag_hdfhelper.h"
 #include "bag_interleavedlegacylayer.h"
 #include "bag_interleavedlegacylayerdescriptor.h"
 #include "bag_private.h"
 
+#include <algorithm>
 #include <array>
 #include <H5Cpp.h>
+#include <vector>
 
 
 namespace BAG {
 
+namespace {
+
+//! The most records of a group read at once by readRecords().
+constexpr size_t kRecordBandCells = size_t{1} << 20;
+
+}  // namespace
+
 //! Constructor
 /*
 \param dataset
@@ -24,7 +36,13 @@ InterleavedLegacyLayer::InterleavedLegacyLayer(
     InterleavedLegacyLayerDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(pH5dataSet))
+    , m_pH5memType(new ::H5::CompType{createH5compType(
+        descriptor.getLayerType(), descriptor.getGroupType())},
+        DeleteH5dataType{})
+    , m_pH5recordType(new ::H5::CompType{createH5groupCompType(
+        descriptor.getGroupType())}, DeleteH5dataType{})
 {
 }
 
@@ -33,7 +51,8 @@ InterleavedLegacyLayer::InterleavedLegacyLayer(
 \param dataset
     The BAG Dataset this layer belongs to.
 \param descriptor
-    The descriptor of this layer.
+    The descriptor of this layer; its attributes were read when the BAG
+    was opened.
 */
 std::shared_ptr<InterleavedLegacyLayer> InterleavedLegacyLayer::open(
     Dataset& dataset,
@@ -42,15 +61,10 @@ std::shared_ptr<InterleavedLegacyLayer> InterleavedLegacyLayer::open(
     const auto& h5file = dataset.getH5file();
     const auto& path = descriptor.getInternalPath();
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(path)},
+        new ::H5::DataSet{h5file.openDataSet(path,
+            dataset.getH5dataSetAccessPropList(descriptor.getLayerType()))},
         DeleteH5dataSet{});
 
-    // Read the min/max attribute values.
-    const auto possibleMinMax = dataset.getMinMax(descriptor.getLayerType(), path);
-    if (std::get<0>(possibleMinMax))
-        descriptor.setMinMax(std::get<1>(possibleMinMax),
-            std::get<2>(possibleMinMax));
-
     return std::make_shared<InterleavedLegacyLayer>(dataset,
         descriptor, std::move(h5dataSet));
 }
@@ -63,12 +77,28 @@ UInt8Array InterleavedLegacyLayer::readProxy(
     uint32_t rowEnd,
     uint32_t columnEnd) const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const InterleavedLegacyLayerDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    // Allocate the output buffer; the read overwrites all of it.
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
+
+    this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+        buffer.data(), columns * m_descriptor.getElementSize());
+
+    return buffer;
+}
 
+//! \copydoc Layer::readInto
+void InterleavedLegacyLayer::readIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
     const std::array<hsize_t, kRank> count{rows, columns};
@@ -78,20 +108,210 @@ UInt8Array InterleavedLegacyLayer::readProxy(
     const auto h5fileSpace = m_pH5dataSet->getSpace();
     h5fileSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
 
-    // Initialize the output buffer.
-    const auto bufferSize = pDescriptor->getReadBufferSize(rows, columns);
-    UInt8Array buffer{bufferSize};
-
     // Prepare the memory space.
-    const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
+    const auto h5memSpace = createH5memorySpace(rows, columns, rowStrideBytes,
+        m_descriptor.getElementSize());
 
-    // Set up the type.
-    const auto h5dataType = createH5compType(pDescriptor->getLayerType(),
-        pDescriptor->getGroupType());
+    m_pH5dataSet->read(buffer, *m_pH5memType, h5memSpace, h5fileSpace);
+}
 
-    m_pH5dataSet->read(buffer.data(), h5dataType, h5memSpace, h5fileSpace);
+//! Read whole records of the group this layer is part of.
+/*!
+    The records are read a band of rows at a time, and each band is handed to
+    split() before the next is read.  The area has been checked to be within
+    the layer.
 
-    return buffer;
+\param groupType
+    The type of group the records must be from.
+\param recordSize
+    The size of a record; that of BagOptNodeGroup or
+    BagOptElevationSolutionGroup.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param split
+    Called with the first row of a band (relative to rowStart), the number of
+    rows in it, and its records, row by row, as BagOptNodeGroup or
+    BagOptElevationSolutionGroup.
+*/
+void InterleavedLegacyLayer::readRecords(
+    GroupType groupType,
+    size_t recordSize,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const std::function<void(uint32_t, uint32_t, const uint8_t*)>& split) const
+{
+    if (m_descriptor.getGroupType() != groupType)
+        throw UnsupportedGroupType{};
+
+    const auto pDataset = this->getDataset().lock();
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    const TraceScope trace{"InterleavedLegacyLayer::readRecords",
+        m_descriptor.getName().c_str(), rows, columns};
+    const AccessTraceScope access{*pDataset, m_descriptor, AccessKind::Read,
+        rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+    if (pStats)
+        this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
+    const auto bandRows = static_cast<uint32_t>(std::min<size_t>(rows,
+        std::max<size_t>(1, kRecordBandCells / columns)));
+    std::vector<uint8_t> records(static_cast<size_t>(bandRows) * columns *
+        recordSize);
+
+    const auto h5fileSpace = m_pH5dataSet->getSpace();
+
+    for (uint32_t first=0; first<rows; first+=bandRows)
+    {
+        const auto numRows = std::min(bandRows, rows - first);
+        const std::array<hsize_t, kRank> count{numRows, columns};
+        const std::array<hsize_t, kRank> offset{rowStart + first, columnStart};
+
+        h5fileSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+            offset.data());
+
+        const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
+
+        m_pH5dataSet->read(records.data(), *m_pH5recordType, h5memSpace,
+            h5fileSpace);
+
+        split(first, numRows, records.data());
+    }
+}
+
+//! Read an area of the elevation solution group, a grid per field.
+/*!
+    Each record is read once, where reading Shoal_Elevation, Std_Dev and
+    Num_Soundings through their own layers reads each record three times.
+    Any of the three layers reads the whole group.
+
+    An UnsupportedGroupType exception is thrown if this layer is not part of
+    the elevation solution group.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The fields of the area.
+*/
+ElevationSolutionGrids InterleavedLegacyLayer::readElevationSolution(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    this->checkReadWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    ElevationSolutionGrids grids;
+    grids.shoalElevation = Grid<float>{rows, columns};
+    grids.stdDev = Grid<float>{rows, columns};
+    grids.numSoundings = Grid<uint32_t>{rows, columns};
+
+    this->readRecords(ELEVATION, sizeof(BagOptElevationSolutionGroup),
+        rowStart, columnStart, rowEnd, columnEnd,
+        [&](uint32_t first, uint32_t numRows, const uint8_t* buffer) {
+            const auto* records =
+                reinterpret_cast<const BagOptElevationSolutionGroup*>(buffer);
+
+            for (uint32_t row=0; row<numRows; ++row)
+            {
+                const auto* record = records + static_cast<size_t>(row) * columns;
+                auto* shoalElevation = grids.shoalElevation.row(first + row);
+                auto* stdDev = grids.stdDev.row(first + row);
+                auto* numSoundings = grids.numSoundings.row(first + row);
+
+                for (uint32_t column=0; column<columns; ++column)
+                {
+                    shoalElevation[column] = record[column].shoal_elevation;
+                    stdDev[column] = record[column].stddev;
+                    numSoundings[column] =
+                        static_cast<uint32_t>(record[column].num_soundings);
+                }
+            }
+        });
+
+    return grids;
+}
+
+//! Read an area of the node group, a grid per field.
+/*!
+    Each record is read once, where reading Hypothesis_Strength and
+    Num_Hypotheses through their own layers reads each record twice.  Either
+    layer reads the whole group.
+
+    An UnsupportedGroupType exception is thrown if this layer is not part of
+    the node group.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The fields of the area.
+*/
+NodeGrids InterleavedLegacyLayer::readNode(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    this->checkReadWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    NodeGrids grids;
+    grids.hypothesisStrength = Grid<float>{rows, columns};
+    grids.numHypotheses = Grid<uint32_t>{rows, columns};
+
+    this->readRecords(NODE, sizeof(BagOptNodeGroup), rowStart, columnStart,
+        rowEnd, columnEnd,
+        [&](uint32_t first, uint32_t numRows, const uint8_t* buffer) {
+            const auto* records =
+                reinterpret_cast<const BagOptNodeGroup*>(buffer);
+
+            for (uint32_t row=0; row<numRows; ++row)
+            {
+                const auto* record = records + static_cast<size_t>(row) * columns;
+                auto* hypothesisStrength =
+                    grids.hypothesisStrength.row(first + row);
+                auto* numHypotheses = grids.numHypotheses.row(first + row);
+
+                for (uint32_t column=0; column<columns; ++column)
+                {
+                    hypothesisStrength[column] = record[column].hyp_strength;
+                    numHypotheses[column] = record[column].num_hypotheses;
+                }
+            }
+        });
+
+    return grids;
 }
 
 //! \copydoc Layer::writeAttributes
@@ -7,12 +7,14 @@
 #include "bag_layer.h"
 #include "bag_types.h"
 
+#include <functional>
 #include <memory>
 
 
 namespace H5 {
 
 class DataSet;
+class DataType;
 
 }  // namespace H5
 
@@ -23,6 +25,27 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! An area of the elevation solution group of a pre 2.0 BAG, split into a
+//! grid per field.
+struct ElevationSolutionGrids final
+{
+    //! The Shoal_Elevation values.
+    Grid<float> shoalElevation;
+    //! The Std_Dev values.
+    Grid<float> stdDev;
+    //! The Num_Soundings values.
+    Grid<uint32_t> numSoundings;
+};
+
+//! An area of the node group of a pre 2.0 BAG, split into a grid per field.
+struct NodeGrids final
+{
+    //! The Hypothesis_Strength values.
+    Grid<float> hypothesisStrength;
+    //! The Num_Hypotheses values.
+    Grid<uint32_t> numHypotheses;
+};
+
 //! The interface for an interleaved layer.
 /*!
     This class is only here to support older (pre 2.0) BAGs that have an optional
@@ -53,6 +76,11 @@ public:
         return !(rhs == *this);
     }
 
+    ElevationSolutionGrids readElevationSolution(uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const;
+    NodeGrids readNode(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+
 protected:
     static std::shared_ptr<InterleavedLegacyLayer> open(Dataset& dataset,
         InterleavedLegacyLayerDescriptor& descriptor);
@@ -61,15 +89,31 @@ private:
     UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const override;
 
+    void readIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const override;
+
     void writeProxy(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
         uint32_t columnEnd, const uint8_t *buffer) override;
 
     void writeAttributesProxy() const override;
 
+    void readRecords(GroupType groupType, size_t recordSize,
+        uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd, const std::function<void(uint32_t, uint32_t,
+            const uint8_t*)>& split) const;
+
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    InterleavedLegacyLayerDescriptor& m_descriptor;
     //! The HDF5 DataSet.
     std::unique_ptr<H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! The one member CompType this layer's field is read with.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5memType;
+    //! The CompType of a whole record of the group.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5recordType;
 
     friend Dataset;
+    friend DatasetCopier;
 };
 
 #ifdef _MSC_VER
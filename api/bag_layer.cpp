@@ -1,13 +1,165 @@
 
+#include "bag_accesstracer.h"
 #include "bag_layer.h"
 #include "bag_metadata.h"
 #include "bag_private.h"
 #include "bag_trackinglist.h"
 
 #include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace BAG {
 
+namespace {
+
+//! Read a section of a layer, and copy it row by row into a strided buffer.
+/*!
+\param data
+    The section of data that was read.
+\param rows
+    The number of rows in the section.
+\param buffer
+    The buffer to copy into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer.
+*/
+void copyRows(
+    const UInt8Array& data,
+    uint32_t rows,
+    uint8_t* buffer,
+    size_t rowStrideBytes)
+{
+    const auto rowBytes = data.size() / rows;
+
+    for (uint32_t row=0; row<rows; ++row)
+        std::memcpy(buffer + row * rowStrideBytes, data.data() + row * rowBytes,
+            rowBytes);
+}
+
+//! Convert a number to an unsigned integer, saturating like HDF5 does.
+template <typename Destination, typename Source>
+Destination convertElement(
+    Source value,
+    std::true_type /*floatToInteger*/) noexcept
+{
+    if (std::isnan(value) || value <= Source{0})
+        return 0;
+
+    if (value >= static_cast<Source>(std::numeric_limits<Destination>::max()))
+        return std::numeric_limits<Destination>::max();
+
+    return static_cast<Destination>(value);
+}
+
+//! Convert a number to another type, saturating like HDF5 does.
+template <typename Destination, typename Source>
+Destination convertElement(
+    Source value,
+    std::false_type /*floatToInteger*/) noexcept
+{
+    if (std::is_integral<Destination>::value &&
+        value > static_cast<Source>(std::numeric_limits<Destination>::max()))
+        return std::numeric_limits<Destination>::max();
+
+    return static_cast<Destination>(value);
+}
+
+//! Convert rows of Source elements into rows of Destination elements.
+/*!
+\param data
+    The rows of Source elements, tightly packed.
+\param rows
+    The number of rows.
+\param columns
+    The number of columns.
+\param buffer
+    The buffer to convert into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer.
+*/
+template <typename Destination, typename Source>
+void convertRows(
+    const uint8_t* data,
+    uint32_t rows,
+    uint32_t columns,
+    uint8_t* buffer,
+    size_t rowStrideBytes) noexcept
+{
+    using FloatToInteger = std::integral_constant<bool,
+        std::is_floating_point<Source>::value &&
+        std::is_integral<Destination>::value>;
+
+    const auto* source = reinterpret_cast<const Source*>(data);
+
+    for (uint32_t row=0; row<rows; ++row)
+    {
+        auto* destination = reinterpret_cast<Destination*>(buffer +
+            row * rowStrideBytes);
+
+        for (uint32_t column=0; column<columns; ++column)
+            destination[column] = convertElement<Destination>(
+                source[static_cast<size_t>(row) * columns + column],
+                FloatToInteger{});
+    }
+}
+
+//! Convert rows of elements of one DataType into Destination elements.
+template <typename Destination>
+void convertRowsFrom(
+    DataType sourceType,
+    const uint8_t* data,
+    uint32_t rows,
+    uint32_t columns,
+    uint8_t* buffer,
+    size_t rowStrideBytes)
+{
+    switch (sourceType)
+    {
+    case DT_FLOAT32:
+        return convertRows<Destination, float>(data, rows, columns, buffer,
+            rowStrideBytes);
+    case DT_UINT8:
+        return convertRows<Destination, uint8_t>(data, rows, columns, buffer,
+            rowStrideBytes);
+    case DT_UINT16:
+        return convertRows<Destination, uint16_t>(data, rows, columns, buffer,
+            rowStrideBytes);
+    case DT_UINT32:
+        return convertRows<Destination, uint32_t>(data, rows, columns, buffer,
+            rowStrideBytes);
+    case DT_UINT64:
+        return convertRows<Destination, uint64_t>(data, rows, columns, buffer,
+            rowStrideBytes);
+    default:
+        throw InvalidType{};
+    }
+}
+
+//! Can a layer of this DataType be read as numbers?
+bool isNumeric(
+    DataType type) noexcept
+{
+    switch (type)
+    {
+    case DT_FLOAT32:  // [[fallthrough]];
+    case DT_UINT8:  // [[fallthrough]];
+    case DT_UINT16:  // [[fallthrough]];
+    case DT_UINT32:  // [[fallthrough]];
+    case DT_UINT64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+}  // namespace
+
 //! Constructor.
 /*!
 \param dataset
@@ -210,20 +362,483 @@ UInt8Array Layer::read(
 
     const auto pDataset = m_pBagDataset.lock();
     uint32_t numRows = 0, numColumns = 0;
-    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+    std::tie(numRows, numColumns) = this->getDimsProxy();
 
     if (columnEnd >= numColumns || rowEnd >= numRows)
         throw InvalidReadSize{};
 
+    const TraceScope trace{"Layer::read", m_pLayerDescriptor->getName().c_str(),
+        rowEnd - rowStart + 1, columnEnd - columnStart + 1};
+    const AccessTraceScope access{*pDataset, *m_pLayerDescriptor,
+        AccessKind::Read, rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    if (!pStats)
+        return this->readProxy(rowStart, columnStart, rowEnd, columnEnd);
+
+    const IoTimer timer{&pStats->readSeconds};
+    this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
     return this->readProxy(rowStart, columnStart, rowEnd, columnEnd);
 }
 
+//! Read a section of data from this layer into a caller owned buffer.
+/*!
+    Read data from this layer starting at rowStart, columnStart, and continue
+    until rowEnd, columnEnd (inclusive), directly into buffer.  No memory is
+    allocated when the layer supports reading into a buffer, and the row
+    stride allows writing into a sub-rectangle of a larger buffer, such as a
+    mosaic.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The buffer to read into.
+\param bufferSize
+    The size of buffer, in bytes.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer.
+    Zero means the rows are tightly packed.
+*/
+void Layer::readInto(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t bufferSize,
+    size_t rowStrideBytes) const
+{
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    if (m_pBagDataset.expired())
+        throw DatasetNotFound{};
+
+    if (!buffer)
+        throw InvalidBuffer{};
+
+    const auto pDataset = m_pBagDataset.lock();
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = this->getDimsProxy();
+
+    if (columnEnd >= numColumns || rowEnd >= numRows)
+        throw InvalidReadSize{};
+
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+    const size_t elementSize = m_pLayerDescriptor->getElementSize();
+    const auto rowBytes = columns * elementSize;
+
+    if (rowStrideBytes == 0)
+        rowStrideBytes = rowBytes;
+
+    if (rowStrideBytes < rowBytes ||
+        bufferSize < (rows - 1) * rowStrideBytes + rowBytes)
+        throw InvalidBuffer{};
+
+    const TraceScope trace{"Layer::readInto",
+        m_pLayerDescriptor->getName().c_str(), rows, columns};
+    const AccessTraceScope access{*pDataset, *m_pLayerDescriptor,
+        AccessKind::Read, rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+    if (pStats)
+        this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
+    // HDF5 can only scatter into a buffer whose rows are whole elements apart.
+    if (rowStrideBytes % elementSize != 0)
+    {
+        copyRows(this->readProxy(rowStart, columnStart, rowEnd, columnEnd),
+            rows, buffer, rowStrideBytes);
+        return;
+    }
+
+    this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd, buffer,
+        rowStrideBytes);
+}
+
+//! Retrieve the dimensions of this layer.
+/*!
+    The default implementation returns the dimensions of the dataset's grid.
+
+\return
+    The number of rows and columns in this layer.
+*/
+std::tuple<uint32_t, uint32_t> Layer::getDimsProxy() const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    return pDataset->getDescriptor().getDims();
+}
+
+//! Read a section of data from this layer into a caller owned buffer.
+/*!
+    The default implementation reads into a temporary buffer, and copies it.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The buffer to read into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer.
+*/
+void Layer::readIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    copyRows(this->readProxy(rowStart, columnStart, rowEnd, columnEnd),
+        (rowEnd - rowStart) + 1, buffer, rowStrideBytes);
+}
+
+//! Read a section of data from this layer, converted to another DataType.
+/*!
+    The default implementation reads the section, then converts it.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param type
+    The DataType to convert to; a number.
+\param buffer
+    The buffer to read into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer.
+*/
+void Layer::readConvertedIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    DataType type,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    const auto data = this->readProxy(rowStart, columnStart, rowEnd,
+        columnEnd);
+
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+    const auto sourceType = m_pLayerDescriptor->getDataType();
+
+    switch (type)
+    {
+    case DT_FLOAT32:
+        return convertRowsFrom<float>(sourceType, data.data(), rows, columns,
+            buffer, rowStrideBytes);
+    case DT_UINT8:
+        return convertRowsFrom<uint8_t>(sourceType, data.data(), rows, columns,
+            buffer, rowStrideBytes);
+    case DT_UINT16:
+        return convertRowsFrom<uint16_t>(sourceType, data.data(), rows,
+            columns, buffer, rowStrideBytes);
+    case DT_UINT32:
+        return convertRowsFrom<uint32_t>(sourceType, data.data(), rows,
+            columns, buffer, rowStrideBytes);
+    case DT_UINT64:
+        return convertRowsFrom<uint64_t>(sourceType, data.data(), rows,
+            columns, buffer, rowStrideBytes);
+    default:
+        throw InvalidType{};
+    }
+}
+
+//! Check a section of this layer can be read.
+/*!
+    An InvalidReadSize exception is thrown if the section is empty, or
+    extends past the grid.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+*/
+void Layer::checkReadWindow(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = this->getDimsProxy();
+
+    if (columnEnd >= numColumns || rowEnd >= numRows)
+        throw InvalidReadSize{};
+}
+
+//! Read a checked section of data from this layer as another DataType.
+/*!
+    The layer is checked to hold numbers once, here; the conversion itself
+    is left to readConvertedIntoProxy().
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param type
+    The DataType to read as; a number.
+\param buffer
+    The buffer to read into.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in buffer; a
+    multiple of the size of type.
+*/
+void Layer::readAsInto(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    DataType type,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    const auto layerType = m_pLayerDescriptor->getDataType();
+    if (!isNumeric(layerType) || !isNumeric(type))
+        throw InvalidType{};
+
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const TraceScope trace{"Layer::readAs",
+        m_pLayerDescriptor->getName().c_str(), rowEnd - rowStart + 1,
+        columnEnd - columnStart + 1};
+    const AccessTraceScope access{*pDataset, *m_pLayerDescriptor,
+        AccessKind::Read, rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+    if (pStats)
+        this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
+    if (type == layerType)
+        this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd, buffer,
+            rowStrideBytes);
+    else
+        this->readConvertedIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+            type, buffer, rowStrideBytes);
+}
+
+//! Read several windows of this layer at once.
+/*!
+    The windows are read one after another into one buffer.  Layers that
+    can read them in one pass over the file do, so a chunk shared by several
+    windows is only decoded once; the windows may overlap.
+
+    An InvalidReadSize exception is thrown if a window is not within the
+    grid.
+
+\param windows
+    The windows to read.
+
+\return
+    The windows read, and where each starts.
+*/
+LayerWindowsRead Layer::readWindows(
+    const std::vector<LayerWindow>& windows) const
+{
+    if (m_pBagDataset.expired())
+        throw DatasetNotFound{};
+
+    const auto pDataset = m_pBagDataset.lock();
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = this->getDimsProxy();
+
+    LayerWindowsRead result;
+    result.offsets.reserve(windows.size());
+
+    size_t numBytes = 0;
+    for (const auto& window : windows)
+    {
+        if (window.rowStart > window.rowEnd ||
+            window.columnStart > window.columnEnd ||
+            window.rowEnd >= numRows || window.columnEnd >= numColumns)
+            throw InvalidReadSize{};
+
+        result.offsets.push_back(numBytes);
+        numBytes += (size_t{window.rowEnd} - window.rowStart + 1) *
+            (window.columnEnd - window.columnStart + 1) *
+            m_pLayerDescriptor->getElementSize();
+    }
+
+    result.data = UInt8Array::uninitialized(numBytes);
+    if (windows.empty())
+        return result;
+
+    const TraceScope trace{"Layer::readWindows",
+        m_pLayerDescriptor->getName().c_str()};
+
+    // Each window is traced as a read of its own.
+    std::deque<AccessTraceScope> accesses;
+    for (const auto& window : windows)
+        accesses.emplace_back(*pDataset, *m_pLayerDescriptor, AccessKind::Read,
+            window.rowStart, window.columnStart, window.rowEnd,
+            window.columnEnd);
+
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+
+    if (pStats)
+        for (const auto& window : windows)
+            this->countRead(*pStats, window.rowStart, window.columnStart,
+                window.rowEnd, window.columnEnd);
+
+    this->readWindowsProxy(windows, result.offsets, result.data.data());
+
+    return result;
+}
+
+//! Read several windows of this layer into one buffer.
+/*!
+    The default implementation reads each window in turn.
+
+\param windows
+    The windows to read; each is within the grid.
+\param offsets
+    Where each window starts in buffer, in bytes.
+\param buffer
+    The buffer to read into.
+*/
+void Layer::readWindowsProxy(
+    const std::vector<LayerWindow>& windows,
+    const std::vector<size_t>& offsets,
+    uint8_t* buffer) const
+{
+    for (size_t i=0; i<windows.size(); ++i)
+        this->readIntoProxy(windows[i].rowStart, windows[i].columnStart,
+            windows[i].rowEnd, windows[i].columnEnd, buffer + offsets[i], 0);
+}
+
+//! Read a section of data from this layer on an executor.
+/*!
+    The read runs after the asynchronous operations on the Dataset submitted
+    before it.  The Dataset is kept open until the read is done.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param executor
+    The executor to read on.
+
+\return
+    The section of data specified by the rows and columns, or the exception
+    read() threw.
+*/
+std::future<UInt8Array> Layer::readAsync(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    Executor& executor) const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Holding the Dataset, which owns the layer, keeps the layer alive.
+    return executor.submit(pDataset.get(),
+        [this, pDataset, rowStart, columnStart, rowEnd, columnEnd]() {
+            return this->read(rowStart, columnStart, rowEnd, columnEnd);
+        });
+}
+
+//! Split this layer into chunk aligned tiles.
+/*!
+    The tile boundaries are taken from the chunk layout of the HDF5 DataSet,
+    so reading every tile inflates each chunk exactly once.  If the layer is
+    not chunked, the tiles are kDefaultTileSize square.
+
+    The variable resolution nodes and refinements are a single row of items,
+    so they are split into runs of items instead.
+
+\return
+    An iterable range of the tiles, in chunk order.
+*/
+LayerTiles Layer::tiles() const
+{
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = this->getDimsProxy();
+
+    const auto layerType = m_pLayerDescriptor->getLayerType();
+    if (layerType == VarRes_Node || layerType == VarRes_Refinement)
+    {
+        // A 1D DataSet only has a chunk size; use as many items as a square
+        // tile holds if it is not chunked.
+        const auto chunkSize = m_pLayerDescriptor->getChunkSize();
+        const auto tileColumns = chunkSize > 0 ?
+            static_cast<uint32_t>(chunkSize) :
+            kDefaultTileSize * kDefaultTileSize;
+
+        return {*this, numRows, numColumns, 1, tileColumns};
+    }
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_pLayerDescriptor->getChunkDims();
+
+    const auto tileRows = chunkRows > 0 && chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkRows) : kDefaultTileSize;
+    const auto tileColumns = chunkRows > 0 && chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkColumns) : kDefaultTileSize;
+
+    return {*this, numRows, numColumns, tileRows, tileColumns};
+}
+
 //! Write a section of data to this layer.
 /*!
     Write data to this layer starting at rowStart, columnStart, and continue
     until rowEnd, columnEnd (inclusive).
 
-    After writing the data, write the attributes.
+    After writing the data, write the attributes, unless the dataset defers
+    attribute writes, in which case they are written by flushAttributes().
 
 \param rowStart
     The starting row.
@@ -253,8 +868,83 @@ void Layer::write(
     if (!buffer)
         throw InvalidBuffer{};
 
+    const auto pDataset = m_pBagDataset.lock();
+
+    const TraceScope trace{"Layer::write", m_pLayerDescriptor->getName().c_str(),
+        rowEnd - rowStart + 1, columnEnd - columnStart + 1};
+    const AccessTraceScope access{*pDataset, *m_pLayerDescriptor,
+        AccessKind::Write, rowStart, columnStart, rowEnd, columnEnd};
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->writeSeconds : nullptr};
+
     this->writeProxy(rowStart, columnStart, rowEnd, columnEnd, buffer);
-    this->writeAttributesProxy();
+
+    if (pStats)
+    {
+        ++pStats->numWrites;
+        pStats->bytesWritten += static_cast<uint64_t>(rowEnd - rowStart + 1) *
+            (columnEnd - columnStart + 1) * m_pLayerDescriptor->getElementSize();
+        pStats->chunksWritten += this->countChunks(rowStart, columnStart,
+            rowEnd, columnEnd);
+    }
+
+    if (pDataset->isDeferringAttributeWrites())
+        m_attributesDirty = true;
+    else
+        this->writeAttributes();
+}
+
+//! Write a section of data to this layer on an executor.
+/*!
+    The write runs after the asynchronous operations on the Dataset
+    submitted before it.  The Dataset is kept open until the write is done.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The data to write, row by row; owned by the write until it is done.
+\param executor
+    The executor to write on.
+
+\return
+    Ready once the data is written, or with the exception write() threw.
+*/
+std::future<void> Layer::writeAsync(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    UInt8Array buffer,
+    Executor& executor)
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidWriteSize{};
+
+    if (buffer.size() < static_cast<size_t>(rowEnd - rowStart + 1) *
+        (columnEnd - columnStart + 1) * m_pLayerDescriptor->getElementSize())
+        throw InvalidBuffer{};
+
+    // Some std::packaged_task need a copyable function, so the buffer is
+    // shared.  Holding the Dataset, which owns the layer, keeps the layer
+    // alive.
+    auto pBuffer = std::make_shared<UInt8Array>(std::move(buffer));
+
+    return executor.submit(pDataset.get(),
+        [this, pDataset, rowStart, columnStart, rowEnd, columnEnd, pBuffer]() {
+            this->write(rowStart, columnStart, rowEnd, columnEnd,
+                pBuffer->data());
+        });
 }
 
 //! Write the attributes this layer contains to disk.
@@ -263,7 +953,125 @@ void Layer::writeAttributes() const
     if (m_pBagDataset.expired())
         throw DatasetNotFound{};
 
+    const auto pDataset = m_pBagDataset.lock();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->attributeSeconds : nullptr};
+
+    const auto lock = pDataset->lockWrites();
     this->writeAttributesProxy();
+    m_attributesDirty = false;
+
+    if (pStats)
+        ++pStats->numAttributeWrites;
+}
+
+//! Write the attributes this layer contains to disk, if any writes were
+//! deferred since they were last written.
+void Layer::flushAttributes() const
+{
+    if (m_attributesDirty)
+        this->writeAttributes();
+}
+
+//! Retrieve the I/O counters of this layer.
+/*!
+    The counters only change while the dataset collects them; see
+    Dataset::setCollectIoStats().
+
+\return
+    The I/O counters since the layer was opened or they were last reset.
+*/
+IoStats Layer::getIoStats() const
+{
+    if (m_pBagDataset.expired())
+        throw DatasetNotFound{};
+
+    const auto lock = m_pBagDataset.lock()->lockReads();
+
+    return m_ioStats;
+}
+
+//! Reset the I/O counters of this layer to zero.
+void Layer::resetIoStats() const
+{
+    if (m_pBagDataset.expired())
+        throw DatasetNotFound{};
+
+    const auto lock = m_pBagDataset.lock()->lockReads();
+
+    m_ioStats = {};
+}
+
+//! Retrieve the I/O counters to update, if the dataset collects them.
+/*!
+\param dataset
+    The BAG Dataset this layer belongs to.
+
+\return
+    The I/O counters of this layer if the dataset collects them.
+    nullptr otherwise.
+*/
+IoStats* Layer::getCollectedIoStats(
+    const Dataset& dataset) const noexcept
+{
+    return dataset.isCollectingIoStats() ? &m_ioStats : nullptr;
+}
+
+//! Count the chunks of this layer an area overlaps.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The number of chunks the area overlaps; 0 if the layer is not chunked.
+*/
+uint64_t Layer::countChunks(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_pLayerDescriptor->getChunkDims();
+    if (chunkRows == 0 || chunkColumns == 0)
+        return 0;
+
+    return (rowEnd / chunkRows - rowStart / chunkRows + 1) *
+        (columnEnd / chunkColumns - columnStart / chunkColumns + 1);
+}
+
+//! Count a read of this layer.
+/*!
+\param stats
+    The I/O counters to update.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+*/
+void Layer::countRead(
+    IoStats& stats,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    ++stats.numReads;
+    stats.bytesRequested += static_cast<uint64_t>(rowEnd - rowStart + 1) *
+        (columnEnd - columnStart + 1) * m_pLayerDescriptor->getElementSize();
+    stats.chunksRead += this->countChunks(rowStart, columnStart, rowEnd,
+        columnEnd);
 }
 
 }  // namespace BAG
@@ -2,11 +2,17 @@
 #define BAG_LAYER_H
 
 #include "bag_config.h"
+#include "bag_executor.h"
 #include "bag_fordec.h"
+#include "bag_grid.h"
+#include "bag_layertiles.h"
 #include "bag_types.h"
 #include "bag_uint8array.h"
 
+#include <future>
 #include <memory>
+#include <tuple>
+#include <vector>
 
 
 namespace BAG {
@@ -16,6 +22,28 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! A window of a layer; see Layer::readWindows().
+struct LayerWindow final
+{
+    //! The starting row.
+    uint32_t rowStart = 0;
+    //! The starting column.
+    uint32_t columnStart = 0;
+    //! The ending row (inclusive).
+    uint32_t rowEnd = 0;
+    //! The ending column (inclusive).
+    uint32_t columnEnd = 0;
+};
+
+//! Several windows of a layer read by Layer::readWindows().
+struct LayerWindowsRead final
+{
+    //! Where each window starts in data, in bytes.
+    std::vector<size_t> offsets;
+    //! The windows, one after another, each row major.
+    UInt8Array data;
+};
+
 //! The interface for a layer.
 class BAG_API Layer
 {
@@ -48,10 +76,33 @@ public:
     UInt8Array read(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const;
 
+    void readInto(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd, uint8_t* buffer, size_t bufferSize,
+        size_t rowStrideBytes = 0) const;
+
+    template <typename T>
+    Grid<T> readAs(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const;
+
+    LayerWindowsRead readWindows(const std::vector<LayerWindow>& windows) const;
+
+    std::future<UInt8Array> readAsync(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        Executor& executor = Executor::global()) const;
+
+    LayerTiles tiles() const;
+
     void write(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
         uint32_t columnEnd, const uint8_t* buffer);
+    std::future<void> writeAsync(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, UInt8Array buffer,
+        Executor& executor = Executor::global());
 
     void writeAttributes() const;
+    void flushAttributes() const;
+
+    IoStats getIoStats() const;
+    void resetIoStats() const;
 
 protected:
     Layer(Dataset& dataset, LayerDescriptor& descriptor);
@@ -59,24 +110,101 @@ protected:
     std::weak_ptr<Dataset> getDataset() & noexcept;
     std::weak_ptr<const Dataset> getDataset() const & noexcept;
 
+    IoStats* getCollectedIoStats(const Dataset& dataset) const noexcept;
+    void countRead(IoStats& stats, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+    void checkReadWindow(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+
 private:
+    virtual std::tuple<uint32_t, uint32_t> getDimsProxy() const;
+
     virtual UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const = 0;
 
+    virtual void readIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const;
+
+    virtual void readWindowsProxy(const std::vector<LayerWindow>& windows,
+        const std::vector<size_t>& offsets, uint8_t* buffer) const;
+
+    virtual void readConvertedIntoProxy(uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        DataType type, uint8_t* buffer, size_t rowStrideBytes) const;
+
     virtual void writeProxy(uint32_t rowStart, uint32_t columnStart,
         uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer) = 0;
 
     virtual void writeAttributesProxy() const = 0;
 
+    void readAsInto(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd, DataType type, uint8_t* buffer,
+        size_t rowStrideBytes) const;
+
+    uint64_t countChunks(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+
     //! The HDF5 DataSet this layer is stored in.
     std::weak_ptr<Dataset> m_pBagDataset;
     //! The layer's descriptor (owned).
     std::shared_ptr<LayerDescriptor> m_pLayerDescriptor;
+    //! Have the attributes changed since they were last written?
+    mutable bool m_attributesDirty = false;
+    //! The I/O counters; only updated while the dataset collects them.
+    mutable IoStats m_ioStats;
 
     friend Dataset;
+    friend DatasetCopier;
+    friend DerivativeComputer;
+    friend LayerDiffer;
+    friend NeighbourhoodScanner;
+    friend PrefetchReader;
+    friend ReadQueue;
     friend ValueTable;
 };
 
+//! Read a section of data from this layer as elements of type T.
+/*!
+    Read data from this layer starting at rowStart, columnStart, and continue
+    until rowEnd, columnEnd (inclusive), converting it to T as it is read.
+    Simple layers are converted by HDF5 while reading, so there is no second
+    pass over the data; other layers are read, then converted.
+
+    An InvalidType exception is thrown if the layer does not hold numbers,
+    such as a layer of compound records.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+
+eturn
+    The section of data specified by the rows and columns.
+*/
+template <typename T>
+Grid<T> Layer::readAs(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    this->checkReadWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    Grid<T> grid{(rowEnd - rowStart) + 1, (columnEnd - columnStart) + 1};
+
+    this->readAsInto(rowStart, columnStart, rowEnd, columnEnd,
+        GridDataType<T>::value, reinterpret_cast<uint8_t*>(grid.data()),
+        grid.getStride() * sizeof(T));
+
+    return grid;
+}
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
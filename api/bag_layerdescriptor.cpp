@@ -5,11 +5,23 @@
 #include "bag_layerdescriptor.h"
 #include "bag_private.h"
 
+#include <algorithm>
 #include <H5Cpp.h>
 
 
 namespace BAG {
 
+namespace {
+
+//! The size of a chunk whose shape is picked from the grid, in bytes.
+/*!
+    Several chunks of this size fit the default HDF5 chunk cache of 1MB;
+    a grid of floats gets 256x256 chunks.
+*/
+constexpr uint64_t kAutoChunkBytes = 256 * 1024;
+
+}  // namespace
+
 //! Constructor.
 /*!
 \parm id
@@ -36,8 +48,9 @@ LayerDescriptor::LayerDescriptor(
     , m_layerType(type)
     , m_internalPath(std::move(internalPath))
     , m_name(std::move(name))
-    , m_compressionLevel(compressionLevel)
+    , m_compression(compressionLevel)
     , m_chunkSize(chunkSize)
+    , m_chunkColumns(chunkSize)
     , m_minMax(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest())
 {
 }
@@ -72,21 +85,32 @@ LayerDescriptor::LayerDescriptor(
 
     const auto& h5file = dataset.getH5file();
 
-    m_compressionLevel = BAG::getCompressionLevel(h5file, m_internalPath);
-    m_chunkSize = BAG::getChunkSize(h5file, m_internalPath);
+    m_compression = BAG::getCompressionSpec(h5file, m_internalPath);
+    std::tie(m_chunkSize, m_chunkColumns) = BAG::getChunkDims(h5file,
+        m_internalPath);
 }
 
 
 //! Retrieve the chunk size.
 /*!
 \return
-    The chunk size.
+    The chunk size; the rows in a chunk if they are not square.
 */
 uint64_t LayerDescriptor::getChunkSize() const noexcept
 {
     return m_chunkSize;
 }
 
+//! Retrieve the dimensions of a chunk.
+/*!
+\return
+    The rows and columns in a chunk.
+*/
+std::tuple<uint64_t, uint64_t> LayerDescriptor::getChunkDims() const noexcept
+{
+    return std::make_tuple(m_chunkSize, m_chunkColumns);
+}
+
 //! Retrieve the compression level.
 /*!
 \return
@@ -94,7 +118,17 @@ uint64_t LayerDescriptor::getChunkSize() const noexcept
 */
 int LayerDescriptor::getCompressionLevel() const noexcept
 {
-    return m_compressionLevel;
+    return m_compression.level;
+}
+
+//! Retrieve the compression.
+/*!
+\return
+    The compression filter, level and shuffling of the layer.
+*/
+const CompressionSpec& LayerDescriptor::getCompressionSpec() const & noexcept
+{
+    return m_compression;
 }
 
 //! Retrieve the data type.
@@ -218,6 +252,95 @@ LayerDescriptor& LayerDescriptor::setInternalPath(std::string inPath) & noexcept
     return *this;
 }
 
+//! Set the dimensions of a chunk.
+/*!
+\param rows
+    The rows in a chunk.
+\param columns
+    The columns in a chunk.
+
+\return
+    The descriptor.  Useful for chaining set calls.
+*/
+LayerDescriptor& LayerDescriptor::setChunkDims(
+    uint64_t rows,
+    uint64_t columns) & noexcept
+{
+    m_chunkSize = rows;
+    m_chunkColumns = columns;
+    return *this;
+}
+
+//! Set the dimensions of a chunk from a shape.
+/*!
+    Only Tiled chunks are used as given; the others are sized to fit the
+    grid.  An Auto layer gets square chunks of about kAutoChunkBytes, or
+    strips of whole rows if the grid is narrower than that.
+
+\param shape
+    The shape of a chunk.
+\param numRows
+    The rows in the grid.
+\param numColumns
+    The columns in the grid.
+
+\return
+    The descriptor.  Useful for chaining set calls.
+*/
+LayerDescriptor& LayerDescriptor::setChunkShape(
+    const ChunkShape& shape,
+    uint32_t numRows,
+    uint32_t numColumns) & noexcept
+{
+    const uint64_t rows = std::max(numRows, 1u);
+    const uint64_t columns = std::max(numColumns, 1u);
+    const auto cellsPerChunk = std::max<uint64_t>(
+        kAutoChunkBytes / std::max<uint8_t>(this->getElementSize(), 1), 1);
+
+    switch (shape.layout)
+    {
+    case ChunkLayout::Tiled:
+        return this->setChunkDims(shape.rows,
+            shape.columns > 0 ? shape.columns : shape.rows);
+    case ChunkLayout::RowMajorScan:
+    {
+        const auto stripRows = shape.rows > 0 ? shape.rows
+            : std::max<uint64_t>(cellsPerChunk / columns, 1);
+
+        return this->setChunkDims(std::min(stripRows, rows), columns);
+    }
+    case ChunkLayout::Auto:
+    default:
+    {
+        // The largest power of two whose square fits a chunk.
+        uint64_t side = 1;
+        while (side * side * 4 <= cellsPerChunk)
+            side *= 2;
+
+        if (side >= columns)
+            return this->setChunkDims(std::min(std::max<uint64_t>(
+                cellsPerChunk / columns, 1), rows), columns);
+
+        return this->setChunkDims(std::min(side, rows), side);
+    }
+    }
+}
+
+//! Set the compression of the layer.
+/*!
+\param compression
+    The compression filter, level and shuffling.
+
+\return
+    The descriptor.  Useful for chaining set calls.
+*/
+LayerDescriptor& LayerDescriptor::setCompressionSpec(
+    CompressionSpec compression) & noexcept
+{
+    m_compression = std::move(compression);
+    return *this;
+}
+
 //! Set the name of the layer.
 /*!
 \param inName
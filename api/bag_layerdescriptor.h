@@ -35,8 +35,9 @@ public:
                m_layerType == rhs.m_layerType &&
                m_internalPath == rhs.m_internalPath &&
                m_name == rhs.m_name &&
-               m_compressionLevel == rhs.m_compressionLevel &&
+               m_compression == rhs.m_compression &&
                m_chunkSize == rhs.m_chunkSize &&
+               m_chunkColumns == rhs.m_chunkColumns &&
                m_minMax == rhs.m_minMax;
     }
 
@@ -45,7 +46,9 @@ public:
     }
 
     uint64_t getChunkSize() const noexcept;
+    std::tuple<uint64_t, uint64_t> getChunkDims() const noexcept;
     int getCompressionLevel() const noexcept;
+    const CompressionSpec& getCompressionSpec() const & noexcept;
     DataType getDataType() const noexcept;
     uint8_t getElementSize() const noexcept;
     uint32_t getId() const noexcept;
@@ -66,6 +69,10 @@ protected:
     size_t getReadBufferSize(uint32_t rows, uint32_t columns) const noexcept;
 
     LayerDescriptor& setInternalPath(std::string inPath) & noexcept;
+    LayerDescriptor& setChunkDims(uint64_t rows, uint64_t columns) & noexcept;
+    LayerDescriptor& setChunkShape(const ChunkShape& shape, uint32_t numRows,
+        uint32_t numColumns) & noexcept;
+    LayerDescriptor& setCompressionSpec(CompressionSpec compression) & noexcept;
 
 private:
     virtual DataType getDataTypeProxy() const noexcept = 0;
@@ -79,10 +86,12 @@ private:
     std::string m_internalPath;
     //! The name of the layer.
     std::string m_name;
-    //! The compression level of this layer (0-9).
-    int m_compressionLevel = 0;
-    //! The chunk size of this layer.
+    //! The compression filter, level and shuffling of this layer.
+    CompressionSpec m_compression;
+    //! The rows in a chunk of this layer.
     uint64_t m_chunkSize = 0;
+    //! The columns in a chunk of this layer.
+    uint64_t m_chunkColumns = 0;
     //! The minimum and maximum value of this dataset.
     std::tuple<float, float> m_minMax{};
 
@@ -91,6 +100,8 @@ private:
     friend SurfaceCorrections;
     friend SimpleLayer;
     friend VRMetadata;
+    friend VRNode;
+    friend VRRefinements;
 };
 
 #ifdef _MSC_VER
@@ -6,90 +6,118 @@
 #include "bag_uint8array.h"
 
 #include <cstring>
+#include <memory>
+#include <utility>
 #include <vector>
 
 
 namespace BAG
 {
 
+//! The items read from, or to write to, a layer.
+/*!
+    The items are immutable, so copies share them.  Constructing from an
+    rvalue UInt8Array or std::vector takes its memory without copying it.
+*/
 class LayerItems
 {
 public:
     explicit LayerItems(const UInt8Array& items)
-        : m_data()
     {
-        const auto bufferSize = items.size();
-        m_data.resize(bufferSize);
-        std::memcpy(m_data.data(), items.data(), bufferSize);
+        auto pItems = std::make_shared<std::vector<uint8_t>>(items.data(),
+            items.data() + items.size());
+
+        m_data = pItems->data();
+        m_size = pItems->size();
+        m_pOwner = std::move(pItems);
+    }
+    explicit LayerItems(UInt8Array&& items)
+    {
+        auto pItems = std::make_shared<UInt8Array>(std::move(items));
+
+        m_data = pItems->data();
+        m_size = pItems->size();
+        m_pOwner = std::move(pItems);
     }
     template <typename T>
     explicit LayerItems(const std::vector<T>& items)
+        : LayerItems(std::vector<T>(items))
     {
-        const auto numBytes = sizeof(T) * items.size();
-        m_data.resize(numBytes);
+    }
+    template <typename T>
+    explicit LayerItems(std::vector<T>&& items)
+    {
+        auto pItems = std::make_shared<std::vector<T>>(std::move(items));
 
-        std::memcpy(m_data.data(), items.data(), numBytes);
+        m_data = reinterpret_cast<const uint8_t*>(pItems->data());
+        m_size = sizeof(T) * pItems->size();
+        m_pOwner = std::move(pItems);
     }
 
     //! Convert the item(s) from OldType into NewType.
     template <typename OldType, typename NewType>
     LayerItems convert() const
     {
-        const auto dataSize = m_data.size();
         const auto oldTypeSize = sizeof(OldType);
 
         // Make sure the data's size is an exact multiple of the old type's size.
-        if ((dataSize % oldTypeSize) > 0)
+        if ((m_size % oldTypeSize) > 0)
             throw InvalidCast{};
 
-        const auto numItems = dataSize / oldTypeSize;
-
-        // Turn the current data into an array of NewType.
-        std::vector<OldType> oldType(numItems);
-        std::memcpy(oldType.data(), m_data.data(), dataSize);
+        const auto numItems = m_size / oldTypeSize;
 
         std::vector<NewType> result(numItems);
 
-        // Use the assignment operator to convert from OldType to NewType.
-        std::copy(begin(oldType), end(oldType), begin(result));
+        // Use the assignment operator to convert from OldType to NewType, a
+        // single pass over the items.  The items may not be aligned for
+        // OldType, so each is copied out first.
+        for (size_t i=0; i<numItems; ++i)
+        {
+            OldType item;
+            std::memcpy(&item, m_data + i * oldTypeSize, oldTypeSize);
+
+            result[i] = item;
+        }
 
-        return LayerItems{result};
+        return LayerItems{std::move(result)};
     }
 
     const uint8_t* data() const & noexcept
     {
-        return m_data.data();
+        return m_data;
     }
 
     bool empty() const noexcept
     {
-        return m_data.empty();
+        return m_size == 0;
     }
 
     template <typename T>
     std::vector<T> getAs() const
     {
         const auto recordSize = sizeof(T);
-        if (m_data.size() % recordSize > 0)
+        if (m_size % recordSize > 0)
             throw InvalidCast{};
 
-        const auto numRecords = m_data.size() / recordSize;
+        const auto numRecords = m_size / recordSize;
 
         std::vector<T> result;
         result.resize(numRecords);
 
-        std::memcpy(result.data(), m_data.data(), m_data.size());
+        if (m_size > 0)
+            std::memcpy(result.data(), m_data, m_size);
 
         return result;
     }
 
     size_t size() const noexcept
     {
-        return m_data.size();
+        return m_size;
     }
 
     bool operator==(const LayerItems &rhs) const noexcept {
-        return m_data == rhs.m_data;
+        return m_size == rhs.m_size &&
+            (m_size == 0 || std::memcmp(m_data, rhs.m_data, m_size) == 0);
     }
 
     bool operator!=(const LayerItems &rhs) const noexcept {
@@ -97,7 +125,12 @@ public:
     }
 
 private:
-    std::vector<uint8_t> m_data;
+    //! Keeps the memory of the items alive; shared by copies.
+    std::shared_ptr<const void> m_pOwner;
+    //! The first byte of the items.
+    const uint8_t* m_data = nullptr;
+    //! The number of bytes of the items.
+    size_t m_size = 0;
 };
 
 }
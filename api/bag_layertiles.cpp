@@ -0,0 +1,242 @@
+
+#include "bag_exceptions.h"
+#include "bag_layer.h"
+#include "bag_layertiles.h"
+
+#include <algorithm>
+
+
+namespace BAG {
+
+//! Constructor.
+/*!
+\param layer
+    The layer to split into tiles.
+\param numRows
+    The number of rows in the layer.
+\param numColumns
+    The number of columns in the layer.
+\param tileRows
+    The number of rows in a full tile.
+\param tileColumns
+    The number of columns in a full tile.
+*/
+LayerTiles::LayerTiles(
+    const Layer& layer,
+    uint32_t numRows,
+    uint32_t numColumns,
+    uint32_t tileRows,
+    uint32_t tileColumns) noexcept
+    : m_layer(layer)
+    , m_numRows(numRows)
+    , m_numColumns(numColumns)
+    , m_tileRows(tileRows)
+    , m_tileColumns(tileColumns)
+    , m_numTileRows(tileRows == 0 ? 0 : (numRows + tileRows - 1) / tileRows)
+    , m_numTileColumns(tileColumns == 0 ? 0 :
+        (numColumns + tileColumns - 1) / tileColumns)
+{
+}
+
+//! Retrieve an iterator to the first tile.
+/*!
+\return
+    An iterator to the first tile.
+*/
+LayerTiles::iterator LayerTiles::begin() const noexcept
+{
+    return {*this, 0};
+}
+
+//! Retrieve an iterator past the last tile.
+/*!
+\return
+    An iterator past the last tile.
+*/
+LayerTiles::iterator LayerTiles::end() const noexcept
+{
+    return {*this, this->size()};
+}
+
+//! Retrieve the number of tiles.
+/*!
+\return
+    The number of tiles.
+*/
+uint64_t LayerTiles::size() const noexcept
+{
+    return static_cast<uint64_t>(m_numTileRows) * m_numTileColumns;
+}
+
+//! Retrieve the number of rows in the layer.
+/*!
+\return
+    The number of rows in the layer.
+*/
+uint32_t LayerTiles::getNumRows() const noexcept
+{
+    return m_numRows;
+}
+
+//! Retrieve the number of columns in the layer.
+/*!
+\return
+    The number of columns in the layer.
+*/
+uint32_t LayerTiles::getNumColumns() const noexcept
+{
+    return m_numColumns;
+}
+
+//! Retrieve the number of tiles along the rows.
+/*!
+\return
+    The number of tiles along the rows.
+*/
+uint32_t LayerTiles::getNumTileRows() const noexcept
+{
+    return m_numTileRows;
+}
+
+//! Retrieve the number of tiles along the columns.
+/*!
+\return
+    The number of tiles along the columns.
+*/
+uint32_t LayerTiles::getNumTileColumns() const noexcept
+{
+    return m_numTileColumns;
+}
+
+//! Retrieve the number of rows in a full tile.
+/*!
+\return
+    The number of rows in a full tile.
+    Tiles along the last row may be smaller.
+*/
+uint32_t LayerTiles::getTileRows() const noexcept
+{
+    return m_tileRows;
+}
+
+//! Retrieve the number of columns in a full tile.
+/*!
+\return
+    The number of columns in a full tile.
+    Tiles along the last column may be smaller.
+*/
+uint32_t LayerTiles::getTileColumns() const noexcept
+{
+    return m_tileColumns;
+}
+
+//! Read one tile.
+/*!
+    Only the chunk under the tile is read, so workers splitting a layer
+    between them inflate each chunk once.
+
+\param tileRow
+    The row of the tile, from 0 to getNumTileRows() - 1.
+\param tileColumn
+    The column of the tile, from 0 to getNumTileColumns() - 1.
+
+\return
+    The tile, clipped to the extents of the layer.
+*/
+LayerTile LayerTiles::getTile(
+    uint32_t tileRow,
+    uint32_t tileColumn) const
+{
+    if (tileRow >= m_numTileRows || tileColumn >= m_numTileColumns)
+        throw InvalidReadSize{};
+
+    return this->readTile(static_cast<uint64_t>(tileRow) * m_numTileColumns +
+        tileColumn);
+}
+
+//! Read the specified tile.
+/*!
+\param index
+    The index of the tile (row major).
+
+\return
+    The tile, clipped to the extents of the layer.
+*/
+LayerTile LayerTiles::readTile(
+    uint64_t index) const
+{
+    const auto tileRow = static_cast<uint32_t>(index / m_numTileColumns);
+    const auto tileColumn = static_cast<uint32_t>(index % m_numTileColumns);
+
+    LayerTile tile;
+    tile.rowStart = tileRow * m_tileRows;
+    tile.columnStart = tileColumn * m_tileColumns;
+    tile.rowEnd = std::min(tile.rowStart + m_tileRows, m_numRows) - 1;
+    tile.columnEnd = std::min(tile.columnStart + m_tileColumns,
+        m_numColumns) - 1;
+    tile.data = m_layer.read(tile.rowStart, tile.columnStart, tile.rowEnd,
+        tile.columnEnd);
+
+    return tile;
+}
+
+
+//! Constructor.
+/*!
+\param tiles
+    The tiles being iterated over.
+\param index
+    The index of the current tile.
+*/
+LayerTiles::iterator::iterator(
+    const LayerTiles& tiles,
+    uint64_t index) noexcept
+    : m_pTiles(&tiles)
+    , m_index(index)
+{
+}
+
+//! Retrieve the current tile.
+/*!
+    The tile is read from the layer the first time it is dereferenced.
+
+\return
+    The current tile.
+*/
+LayerTiles::iterator::reference LayerTiles::iterator::operator*() const
+{
+    if (!m_read)
+    {
+        m_tile = m_pTiles->readTile(m_index);
+        m_read = true;
+    }
+
+    return m_tile;
+}
+
+//! Retrieve the current tile.
+/*!
+\return
+    The current tile.
+*/
+LayerTiles::iterator::pointer LayerTiles::iterator::operator->() const
+{
+    return &**this;
+}
+
+//! Move to the next tile.
+/*!
+\return
+    The iterator, now referencing the next tile.
+*/
+LayerTiles::iterator& LayerTiles::iterator::operator++()
+{
+    ++m_index;
+    m_tile = {};
+    m_read = false;
+
+    return *this;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,128 @@
+#ifndef BAG_LAYERTILES_H
+#define BAG_LAYERTILES_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_uint8array.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! A rectangular section of a layer, aligned with the layer's chunks.
+struct BAG_API LayerTile final
+{
+    //! The starting row.
+    uint32_t rowStart = 0;
+    //! The starting column.
+    uint32_t columnStart = 0;
+    //! The ending row (inclusive).
+    uint32_t rowEnd = 0;
+    //! The ending column (inclusive).
+    uint32_t columnEnd = 0;
+    //! The data in the tile.
+    UInt8Array data;
+};
+
+//! An iterable range of the chunk aligned tiles of a layer.
+/*!
+    The tiles are visited in chunk order (row major), so a full scan inflates
+    every chunk of the layer exactly once.
+*/
+class BAG_API LayerTiles final
+{
+public:
+    //! An input iterator over the tiles of a layer.
+    class BAG_API iterator final
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = LayerTile;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const LayerTile*;
+        using reference = const LayerTile&;
+
+        iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        iterator& operator++();
+
+        bool operator==(const iterator& rhs) const noexcept {
+            return m_pTiles == rhs.m_pTiles && m_index == rhs.m_index;
+        }
+
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(rhs == *this);
+        }
+
+    private:
+        iterator(const LayerTiles& tiles, uint64_t index) noexcept;
+
+        //! The tiles being iterated over.
+        const LayerTiles* m_pTiles = nullptr;
+        //! The index of the current tile (row major).
+        uint64_t m_index = 0;
+        //! The current tile; read when first dereferenced.
+        mutable LayerTile m_tile;
+        //! Has the current tile been read?
+        mutable bool m_read = false;
+
+        friend LayerTiles;
+    };
+
+    iterator begin() const noexcept;
+    iterator end() const noexcept;
+
+    uint64_t size() const noexcept;
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+    uint32_t getNumTileRows() const noexcept;
+    uint32_t getNumTileColumns() const noexcept;
+    uint32_t getTileRows() const noexcept;
+    uint32_t getTileColumns() const noexcept;
+
+    LayerTile getTile(uint32_t tileRow, uint32_t tileColumn) const;
+
+private:
+    LayerTiles(const Layer& layer, uint32_t numRows, uint32_t numColumns,
+        uint32_t tileRows, uint32_t tileColumns) noexcept;
+
+    LayerTile readTile(uint64_t index) const;
+
+    //! The layer being tiled.
+    const Layer& m_layer;
+    //! The number of rows in the layer.
+    uint32_t m_numRows = 0;
+    //! The number of columns in the layer.
+    uint32_t m_numColumns = 0;
+    //! The number of rows in a full tile.
+    uint32_t m_tileRows = 0;
+    //! The number of columns in a full tile.
+    uint32_t m_tileColumns = 0;
+    //! The number of tiles along the rows.
+    uint32_t m_numTileRows = 0;
+    //! The number of tiles along the columns.
+    uint32_t m_numTileColumns = 0;
+
+    friend Layer;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_LAYERTILES_H
+
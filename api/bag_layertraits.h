@@ -0,0 +1,225 @@
+#ifndef BAG_LAYERTRAITS_H
+#define BAG_LAYERTRAITS_H
+
+#include "bag_c_types.h"
+#include "bag_exceptions.h"
+#include "bag_grid.h"
+#include "bag_types.h"
+
+#include <cstdint>
+
+
+namespace BAG {
+
+//! The compile time description of the elements of a simple layer.
+/*!
+\tparam T
+    The type of the elements in memory.
+\tparam LT
+    The type of layer.
+\tparam NullValue
+    The value of an empty node.
+*/
+template <typename T, LayerType LT, uint32_t NullValue>
+struct SimpleLayerTraits
+{
+    //! The type of the elements in memory.
+    using value_type = T;
+
+    //! Retrieve the type of layer.
+    static constexpr LayerType getLayerType() noexcept
+    {
+        return LT;
+    }
+
+    //! Retrieve the type of the elements.
+    static constexpr DataType getDataType() noexcept
+    {
+        return GridDataType<T>::value;
+    }
+
+    //! Retrieve the size of an element, in bytes.
+    static constexpr uint8_t getElementSize() noexcept
+    {
+        return static_cast<uint8_t>(sizeof(T));
+    }
+
+    //! Retrieve the value of an empty node.
+    static constexpr T getNullValue() noexcept
+    {
+        return static_cast<T>(NullValue);
+    }
+
+    //! Is the value that of an empty node?
+    static constexpr bool isNull(
+        T value) noexcept
+    {
+        return value == getNullValue();
+    }
+};
+
+//! The compile time description of a simple layer.
+/*!
+    Each specialization provides the members of SimpleLayerTraits, and the
+    path of the layer and the names of its min/max attributes.  They describe
+    the same layers the runtime Layer::getDataType(), Layer::getInternalPath()
+    and getAttributeInfo() do, without a switch on every call.
+*/
+template <LayerType LT>
+struct LayerTraits;
+
+template <>
+struct LayerTraits<Elevation> final
+    : SimpleLayerTraits<float, Elevation, BAG_NULL_ELEVATION>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/elevation"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "Minimum Elevation Value"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "Maximum Elevation Value"; }
+};
+
+template <>
+struct LayerTraits<Uncertainty> final
+    : SimpleLayerTraits<float, Uncertainty, BAG_NULL_UNCERTAINTY>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/uncertainty"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "Minimum Uncertainty Value"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "Maximum Uncertainty Value"; }
+};
+
+template <>
+struct LayerTraits<Hypothesis_Strength> final
+    : SimpleLayerTraits<float, Hypothesis_Strength, BAG_NULL_GENERIC>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/hypotheses_strength"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_hyp_strength"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_hyp_strength"; }
+};
+
+template <>
+struct LayerTraits<Num_Hypotheses> final
+    : SimpleLayerTraits<uint32_t, Num_Hypotheses, BAG_NULL_GENERIC>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/num_hypotheses"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_num_hypotheses"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_num_hypotheses"; }
+};
+
+template <>
+struct LayerTraits<Shoal_Elevation> final
+    : SimpleLayerTraits<float, Shoal_Elevation, BAG_NULL_ELEVATION>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/shoal_elevation"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_shoal_elevation"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_shoal_elevation"; }
+};
+
+template <>
+struct LayerTraits<Std_Dev> final
+    : SimpleLayerTraits<float, Std_Dev, BAG_NULL_GENERIC>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/standard_dev"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_stddev"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_stddev"; }
+};
+
+template <>
+struct LayerTraits<Num_Soundings> final
+    : SimpleLayerTraits<uint32_t, Num_Soundings, BAG_NULL_GENERIC>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/num_soundings"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_num_soundings"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_num_soundings"; }
+};
+
+template <>
+struct LayerTraits<Average_Elevation> final
+    : SimpleLayerTraits<float, Average_Elevation, BAG_NULL_ELEVATION>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/average"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_value"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_value"; }
+};
+
+template <>
+struct LayerTraits<Nominal_Elevation> final
+    : SimpleLayerTraits<float, Nominal_Elevation, BAG_NULL_ELEVATION>
+{
+    static constexpr const char* getInternalPath() noexcept
+    { return "/BAG_root/nominal_elevation"; }
+    static constexpr const char* getMinAttributeName() noexcept
+    { return "min_value"; }
+    static constexpr const char* getMaxAttributeName() noexcept
+    { return "max_value"; }
+};
+
+//! Call a function with the LayerTraits of a simple layer type.
+/*!
+    This turns the runtime layer type into a compile time one once, so the
+    function can be a template specialized for the layer.
+
+\param layerType
+    The type of simple layer.
+\param visitor
+    The function; called with a default constructed LayerTraits<layerType>.
+
+\return
+    What the function returns.
+*/
+template <typename Visitor>
+auto visitLayerTraits(
+    LayerType layerType,
+    Visitor&& visitor) -> decltype(visitor(LayerTraits<Elevation>{}))
+{
+    switch (layerType)
+    {
+    case Elevation:
+        return visitor(LayerTraits<Elevation>{});
+    case Uncertainty:
+        return visitor(LayerTraits<Uncertainty>{});
+    case Hypothesis_Strength:
+        return visitor(LayerTraits<Hypothesis_Strength>{});
+    case Num_Hypotheses:
+        return visitor(LayerTraits<Num_Hypotheses>{});
+    case Shoal_Elevation:
+        return visitor(LayerTraits<Shoal_Elevation>{});
+    case Std_Dev:
+        return visitor(LayerTraits<Std_Dev>{});
+    case Num_Soundings:
+        return visitor(LayerTraits<Num_Soundings>{});
+    case Average_Elevation:
+        return visitor(LayerTraits<Average_Elevation>{});
+    case Nominal_Elevation:
+        return visitor(LayerTraits<Nominal_Elevation>{});
+    default:
+        throw UnsupportedSimpleLayerType{};
+    }
+}
+
+}  // namespace BAG
+
+#endif  // BAG_LAYERTRAITS_H
+
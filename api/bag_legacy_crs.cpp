@@ -11,8 +11,11 @@
 #include <fstream>  // std::ifstream
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -121,12 +124,116 @@ double toDouble(const std::string& value)
     return dblValue;
 }
 
+//! An ellipsoid of ellips.dat.
+struct Ellipsoid final
+{
+    //! The line of ellips.dat the ellipsoid is on, in lower case.
+    std::string line;
+    //! Does the line have the name, id, a, b and inverse flattening?
+    bool valid = false;
+    //! The semi-major axis.
+    double semiMajor = 0.;
+    //! The inverse flattening.
+    double invFlat = 0.;
+};
+
+//! The ellipsoids of an ellips.dat file.
+struct EllipsoidTable final
+{
+    //! The BAG_HOME folder the file is in.
+    std::string home;
+    //! Could the file be opened?
+    bool opened = false;
+    //! The ellipsoids, in the order of the file.
+    std::vector<Ellipsoid> ellipsoids;
+};
+
+//! The ellipsoids of the last ellips.dat read.
+std::shared_ptr<const EllipsoidTable> pEllipsoidTable;
+//! Serializes access to pEllipsoidTable.
+std::mutex ellipsoidTableMutex;
+
+//************************************************************************
+/*!
+\brief Read the ellipsoids of ellips.dat in a BAG_HOME folder.
+
+\param onsHome
+    \li The BAG_HOME folder.
+\return
+    \li The ellipsoids.
+*/
+//************************************************************************
+std::shared_ptr<const EllipsoidTable> readEllipsoidTable(
+    const std::string& onsHome)
+{
+    auto pTable = std::make_shared<EllipsoidTable>();
+    pTable->home = onsHome;
+
+    //Build the full path to the ellips.dat file.
+    std::ifstream file{(onsHome + "/ellips.dat").c_str()};
+    pTable->opened = file.is_open();
+
+    while (file.good())
+    {
+        //Get the current line in lower case.
+        Ellipsoid ellipsoid;
+        std::getline(file, ellipsoid.line);
+
+        std::transform(begin(ellipsoid.line), end(ellipsoid.line),
+            begin(ellipsoid.line),
+            [](unsigned char c) noexcept {
+                return static_cast<char>(std::tolower(c));
+            });
+
+        auto elements = split(ellipsoid.line, ' ');
+        const auto numItems = elements.size();
+
+        //We MUST have at least 5 elements (name, id, a, b, if)
+        ellipsoid.valid = numItems >= 5;
+        if (ellipsoid.valid)
+        {
+            //The last item will be the inverse flattening.
+            ellipsoid.invFlat = atof(elements[numItems - 1].c_str());
+
+            //The third to last item will be the semi-major.
+            ellipsoid.semiMajor = atof(elements[numItems - 3].c_str());
+        }
+
+        pTable->ellipsoids.push_back(std::move(ellipsoid));
+    }
+
+    return pTable;
+}
+
+//************************************************************************
+/*!
+\brief Retrieve the ellipsoids of ellips.dat in a BAG_HOME folder.
+
+The file is only read again when the folder changes.
+
+\param onsHome
+    \li The BAG_HOME folder.
+\return
+    \li The ellipsoids.
+*/
+//************************************************************************
+std::shared_ptr<const EllipsoidTable> getEllipsoidTable(
+    const std::string& onsHome)
+{
+    const std::lock_guard<std::mutex> lock{ellipsoidTableMutex};
+
+    if (!pEllipsoidTable || pEllipsoidTable->home != onsHome)
+        pEllipsoidTable = readEllipsoidTable(onsHome);
+
+    return pEllipsoidTable;
+}
+
 //************************************************************************
 /*!
 \brief Convert the BAG ellipsoid to WKT.
 
 To convert the ellipsoid we need the semi-major and inverse flattening
-ratio. We will open the ellips.dat file to retrieve this information.
+ratio. We will look them up in the ellips.dat file.
 
 \param ellipsoid
     \li The BAG ellipsoid type to convert.
@@ -148,53 +255,27 @@ std::string ellipsoidToWkt(const char* ellipsoid)
             return static_cast<char>(std::tolower(c));
         });
 
-    //Build the full path to the ellips.dat file.
-    std::string ellipFile{onsHome};
-    ellipFile += "/ellips.dat";
-
-    std::ifstream file{ellipFile.c_str()};
-    if (!file.is_open())
+    const auto pTable = getEllipsoidTable(onsHome);
+    if (!pTable->opened)
         throw BAG::InvalidEllipsoidError();
 
-    while (file.good())
-    {
-        //Get the current line in lower case.
-        std::string line;
-        std::getline(file, line);
-
-        std::transform(begin(line), end(line), begin(line),
-            [](unsigned char c) noexcept {
-                return static_cast<char>(std::tolower(c));
-            });
-
-        const size_t index = line.find(ellipsoidName);
-        if (index != 0)
-            continue;
-
-        auto elements = split(line, ' ');
-        const auto numItems = elements.size();
-
-        //We MUST have at least 5 elements (name, id, a, b, if)
-        if (numItems < 5)
-            throw BAG::InvalidEllipsoidError();
-
-        //The last item will be the inverse flattening.
-        const double invFlat = atof(elements[numItems - 1].c_str());
-
-        //The third to last item will be the semi-major.
-        const double semiMajor = atof(elements[numItems - 3].c_str());
-
-        std::stringstream wktStream;
-        (void)wktStream.imbue(std::locale::classic());
-        wktStream << std::fixed << std::setprecision(9) <<
-            R"(SPHEROID[")" << ellipsoid << R"(",)" <<
-            semiMajor << ',' << invFlat << ']';
+    //The first line starting with the name is the ellipsoid.
+    const auto found = std::find_if(cbegin(pTable->ellipsoids),
+        cend(pTable->ellipsoids),
+        [&ellipsoidName](const Ellipsoid& candidate) {
+            return candidate.line.compare(0, ellipsoidName.size(),
+                ellipsoidName) == 0;
+        });
+    if (found == cend(pTable->ellipsoids) || !found->valid)
+        throw BAG::InvalidEllipsoidError();
 
-        return wktStream.str();
-    }
+    std::stringstream wktStream;
+    (void)wktStream.imbue(std::locale::classic());
+    wktStream << std::fixed << std::setprecision(9) <<
+        R"(SPHEROID[")" << ellipsoid << R"(",)" <<
+        found->semiMajor << ',' << found->invFlat << ']';
 
-    //Couldn't find it :(
-    throw BAG::InvalidEllipsoidError();
+    return wktStream.str();
 }
 
 //************************************************************************
@@ -511,6 +592,560 @@ std::string getVDatum(const std::string& wkt)
 
 namespace BAG {
 
+namespace {
+
+//! The most conversions of horizontal reference systems kept.
+constexpr size_t kMaxCachedWkts = 1024;
+
+//! The result of converting a horizontal reference system to WKT.
+struct CachedWkt final
+{
+    //! 0 on success, else an error code.
+    BagError error = 0;
+    //! The WKT.
+    std::string wkt;
+};
+
+//! The conversions of horizontal reference systems, by cacheKey().
+std::unordered_map<std::string, CachedWkt> wktCache;
+//! Serializes access to wktCache.
+std::mutex wktCacheMutex;
+
+//************************************************************************
+/*!
+\brief Build the key of a legacy reference system in the WKT cache.
+
+Every parameter, and the BAG_HOME folder the ellipsoid is looked up in,
+makes up the key.
+
+\param system
+    \li The legacy reference system.
+\return
+    \li The key.
+*/
+//************************************************************************
+std::string cacheKey(const BagLegacyReferenceSystem& system)
+{
+    const auto& parameters = system.geoParameters;
+
+    std::string key;
+    const auto append = [&key](const void* value, size_t size) {
+        key.append(static_cast<const char*>(value), size);
+    };
+
+    append(&system.coordSys, sizeof(system.coordSys));
+    append(&parameters.datum, sizeof(parameters.datum));
+    for (const double value : {parameters.origin_latitude,
+        parameters.central_meridian, parameters.std_parallel_1,
+        parameters.std_parallel_2, parameters.false_easting,
+        parameters.false_northing, parameters.scale_factor,
+        parameters.latitude_of_true_scale, parameters.longitude_down_from_pole,
+        parameters.latitude_of_centre, parameters.longitude_of_centre})
+        append(&value, sizeof(value));
+    append(&parameters.zone, sizeof(parameters.zone));
+    append(&parameters.utm_override, sizeof(parameters.utm_override));
+
+    key += parameters.ellipsoid;
+    key += '\0';
+
+    const char* onsHome = getenv("BAG_HOME");
+    if (onsHome)
+        key += onsHome;
+
+    return key;
+}
+
+//************************************************************************
+/*!
+\brief Copy a WKT string into a buffer, truncating it if needed.
+
+\param wkt
+    \li The WKT string.
+\param buffer
+    \li Modified to contain the WKT string.
+\param bufferSize
+    \li The size of the buffer; greater than 0.
+*/
+//************************************************************************
+void copyWkt(
+    const std::string& wkt,
+    char* buffer,
+    size_t bufferSize) noexcept
+{
+    const auto length = std::min(wkt.size(), bufferSize - 1);
+    std::memcpy(buffer, wkt.c_str(), length);
+    buffer[length] = '\0';
+}
+
+//************************************************************************
+/*!
+\brief Convert a BAG horizontal coordinate system definition to wkt.
+
+\param system
+    \li The projection parameters.
+\param wkt
+    \li Modified to contain the horizontal reference system in the form of
+        a WKT string.
+\return
+    \li 0 on success, else an error code.
+*/
+//************************************************************************
+BagError horizontalToWkt(
+    const BagLegacyReferenceSystem& system,
+    std::string& wkt)
+try
+{
+    std::stringstream wktStream;
+    (void)wktStream.imbue(std::locale::classic());
+
+
+    switch (system.coordSys)
+    {
+    case CoordinateType::Geodetic:
+    {
+        wktStream << datumToWkt(system.geoParameters.datum,
+            system.geoParameters.ellipsoid);
+    }
+    break;
+
+    case CoordinateType::UTM:
+    {
+        //We need to figure out what hemisphere we are in.
+        bool isNorth = false;
+
+        //A false northing of 0.0 means north.
+        if (system.geoParameters.false_northing == 0.0)
+            isNorth = true;
+        //A false northing of 10,000,000 means south.
+        else if (system.geoParameters.false_northing == 10'000'000)
+            isNorth = false;
+        //If we don't have an appropriate false northing, then use the zone.
+        else
+            isNorth = (system.geoParameters.zone >= 0);
+
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["UTM Zone )" << abs(system.geoParameters.zone)
+            << ((isNorth) ? R"(, Northern Hemisphere")" : R"(, Southern Hemisphere")")
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Transverse_Mercator"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << 0 << "],"
+            << R"( PARAMETER["central_meridian",)" << (abs(system.geoParameters.zone) * 6 - 183) << "],"
+            << R"( PARAMETER["scale_factor",)" << 0.9996 << "],"
+            << R"( PARAMETER["false_easting",)" << 500'000 << "],"
+            << R"( PARAMETER["false_northing",)" << ((isNorth) ? 0 : 10'000'000) << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Albers_Equal_Area_Conic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Albers_Conic_Equal_Area"],)"
+            << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
+            << R"( PARAMETER["standard_parallel_2",)" << system.geoParameters.std_parallel_2 << "],"
+            << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
+            << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Azimuthal_Equidistant:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Azimuthal_Equidistant"],)"
+            << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
+            << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Bonne:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Bonne"],)"
+            << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Cassini:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Cassini_Soldner"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Cylindrical_Equal_Area:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Cylindrical_Equal_Area"],)"
+            << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Eckert4:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Eckert_IV"],)"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Eckert6:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Eckert_VI"],)"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Equidistant_Cylindrical:
+    {
+        //Plate Caree, 	Equidistant Cylindrical, and Simple Cylindrical are all
+        //aliases for Equirectangular.
+
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Equirectangular"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Gnomonic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Gnomonic"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Lambert_Conformal_Conic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Lambert_Conformal_Conic_2SP"],)"
+            << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
+            << R"( PARAMETER["standard_parallel_2",)" << system.geoParameters.std_parallel_2 << "],"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Mercator:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Mercator_1SP"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Miller_Cylindrical:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Miller_Cylindrical"],)"
+            << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
+            << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Mollweide:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Mollweide"],)"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::NZMG:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["New_Zealand_Map_Grid"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Orthographic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Orthographic"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Polar_Stereo:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Polar_Stereographic"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Polyconic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Polyconic"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Sinusoidal:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Sinusoidal"],)"
+            << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Stereographic:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Oblique_Stereographic"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Transverse_Mercator:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["Transverse_Mercator"],)"
+            << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    case CoordinateType::Van_der_Grinten:
+    {
+        wktStream << std::fixed << std::setprecision(6)
+            << R"(PROJCS["unnamed")"
+            << ", " << datumToWkt(system.geoParameters.datum,
+                system.geoParameters.ellipsoid)
+            << R"(, PROJECTION["VanDerGrinten"],)"
+            << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
+            << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
+            << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
+            << R"( UNIT["metre",1]])";
+    }
+    break;
+
+    default:
+    {
+        //Currently unsupported type.
+        return BAG_METADTA_INVALID_PROJECTION;
+    }
+
+    }
+
+    wkt = wktStream.str();
+
+    return 0;
+}
+catch (const InvalidDatumError &/*e*/)
+{
+    return BAG_METADTA_INVALID_DATUM;
+}
+catch (const std::exception &/*e*/)
+{
+    //Something bad happened.
+    return BAG_METADTA_INVALID_PROJECTION;
+}
+
+//************************************************************************
+/*!
+\brief Convert a BAG horizontal coordinate system definition to wkt, once.
+
+The conversion of each distinct definition is kept, so converting it again
+does not rebuild the WKT or look the ellipsoid up.
+
+\param system
+    \li The projection parameters.
+\return
+    \li The conversion.
+*/
+//************************************************************************
+CachedWkt cachedHorizontalToWkt(
+    const BagLegacyReferenceSystem& system)
+{
+    auto key = cacheKey(system);
+
+    {
+        const std::lock_guard<std::mutex> lock{wktCacheMutex};
+
+        const auto found = wktCache.find(key);
+        if (found != end(wktCache))
+            return found->second;
+    }
+
+    CachedWkt converted;
+    converted.error = horizontalToWkt(system, converted.wkt);
+
+    const std::lock_guard<std::mutex> lock{wktCacheMutex};
+
+    // Start over rather than grow without bound.
+    if (wktCache.size() >= kMaxCachedWkts)
+        wktCache.clear();
+
+    wktCache.emplace(std::move(key), converted);
+
+    return converted;
+}
+
+//************************************************************************
+/*!
+\brief Convert a BAG vertical datum to wkt.
+
+\param system
+    \li The projection parameters, with the vertical datum.
+\return
+    \li The vertical reference system in the form of a WKT string.
+*/
+//************************************************************************
+std::string verticalToWkt(
+    const BagLegacyReferenceSystem& system)
+{
+    std::stringstream wktStream;
+    (void)wktStream.imbue(std::locale::classic());
+
+    wktStream << R"(VERT_CS[")" << system.geoParameters.vertical_datum <<
+        R"(", VERT_DATUM[")" << system.geoParameters.vertical_datum <<
+        R"(", 2000]])";
+
+    return wktStream.str();
+}
+
+}  // namespace
+
 //************************************************************************
 //      Method name:    bagLegacyToWkt()
 //
@@ -521,6 +1156,8 @@ namespace BAG {
 /*!
 \brief Convert a BAG coordinate system definition to wkt.
 
+The horizontal conversions are cached, see bagClearLegacyWktCache().
+
 \param system
 \li The projection parameters.
 \param hBuffer
@@ -545,411 +1182,87 @@ BagError bagLegacyToWkt(
     size_t vBufferSize)
 try
 {
-    std::stringstream wktStream;
-    (void)wktStream.imbue(std::locale::classic());
-
     //If we want the vertical system then...
     if (vBuffer && vBufferSize > 0 &&
         strlen(system.geoParameters.vertical_datum) != 0)
-    {
-        wktStream << R"(VERT_CS[")" << system.geoParameters.vertical_datum <<
-            R"(", VERT_DATUM[")" << system.geoParameters.vertical_datum <<
-            R"(", 2000]])";
-
-        //Make sure our string is not too large.
-        if (wktStream.str().size() > vBufferSize)
-            wktStream.str().resize(vBufferSize);
-
-        strcpy(vBuffer, wktStream.str().c_str());
-    }
+        copyWkt(verticalToWkt(system), vBuffer, vBufferSize);
 
     //If we want the horizontal system then...
     if (hBuffer && hBufferSize > 0)
     {
-        switch (system.coordSys)
-        {
-        case CoordinateType::Geodetic:
-        {
-            wktStream << datumToWkt(system.geoParameters.datum,
-                system.geoParameters.ellipsoid);
-        }
-        break;
+        const auto converted = cachedHorizontalToWkt(system);
+        if (converted.error)
+            return converted.error;
 
-        case CoordinateType::UTM:
-        {
-            //We need to figure out what hemisphere we are in.
-            bool isNorth = false;
-
-            //A false northing of 0.0 means north.
-            if (system.geoParameters.false_northing == 0.0)
-                isNorth = true;
-            //A false northing of 10,000,000 means south.
-            else if (system.geoParameters.false_northing == 10'000'000)
-                isNorth = false;
-            //If we don't have an appropriate false northing, then use the zone.
-            else
-                isNorth = (system.geoParameters.zone >= 0);
-
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["UTM Zone )" << abs(system.geoParameters.zone)
-                << ((isNorth) ? R"(, Northern Hemisphere")" : R"(, Southern Hemisphere")")
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Transverse_Mercator"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << 0 << "],"
-                << R"( PARAMETER["central_meridian",)" << (abs(system.geoParameters.zone) * 6 - 183) << "],"
-                << R"( PARAMETER["scale_factor",)" << 0.9996 << "],"
-                << R"( PARAMETER["false_easting",)" << 500'000 << "],"
-                << R"( PARAMETER["false_northing",)" << ((isNorth) ? 0 : 10'000'000) << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Albers_Equal_Area_Conic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Albers_Conic_Equal_Area"],)"
-                << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
-                << R"( PARAMETER["standard_parallel_2",)" << system.geoParameters.std_parallel_2 << "],"
-                << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
-                << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Azimuthal_Equidistant:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Azimuthal_Equidistant"],)"
-                << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
-                << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Bonne:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Bonne"],)"
-                << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Cassini:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Cassini_Soldner"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Cylindrical_Equal_Area:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Cylindrical_Equal_Area"],)"
-                << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Eckert4:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Eckert_IV"],)"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Eckert6:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Eckert_VI"],)"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Equidistant_Cylindrical:
-        {
-            //Plate Caree, 	Equidistant Cylindrical, and Simple Cylindrical are all
-            //aliases for Equirectangular.
-
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Equirectangular"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Gnomonic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Gnomonic"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Lambert_Conformal_Conic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Lambert_Conformal_Conic_2SP"],)"
-                << R"( PARAMETER["standard_parallel_1",)" << system.geoParameters.std_parallel_1 << "],"
-                << R"( PARAMETER["standard_parallel_2",)" << system.geoParameters.std_parallel_2 << "],"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Mercator:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Mercator_1SP"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Miller_Cylindrical:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Miller_Cylindrical"],)"
-                << R"( PARAMETER["latitude_of_center",)" << system.geoParameters.latitude_of_centre << "],"
-                << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::Mollweide:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Mollweide"],)"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
-
-        case CoordinateType::NZMG:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["New_Zealand_Map_Grid"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+        copyWkt(converted.wkt, hBuffer, hBufferSize);
+    }
 
-        case CoordinateType::Orthographic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Orthographic"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+    return 0;
+}
+catch (const std::exception &/*e*/)
+{
+    //Something bad happened.
+    return BAG_METADTA_INVALID_PROJECTION;
+}
 
-        case CoordinateType::Polar_Stereo:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Polar_Stereographic"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+//************************************************************************
+/*!
+\brief Convert many BAG coordinate system definitions to wkt.
 
-        case CoordinateType::Polyconic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Polyconic"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+Meant for migrating archives of legacy BAGs, which share a few definitions
+between many files; each distinct definition is converted once.
 
-        case CoordinateType::Sinusoidal:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Sinusoidal"],)"
-                << R"( PARAMETER["longitude_of_center",)" << system.geoParameters.longitude_of_centre << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+\param systems
+\li The projection parameters.
+\return
+\li The conversion of each of \e systems, in order.
+*/
+//************************************************************************
+std::vector<LegacyWkt> bagLegacyToWktBatch(
+    const std::vector<BagLegacyReferenceSystem>& systems)
+{
+    std::vector<LegacyWkt> converted;
+    converted.reserve(systems.size());
 
-        case CoordinateType::Stereographic:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Oblique_Stereographic"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+    for (const auto& system : systems)
+    {
+        LegacyWkt wkt;
 
-        case CoordinateType::Transverse_Mercator:
+        try
         {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["Transverse_Mercator"],)"
-                << R"( PARAMETER["latitude_of_origin",)" << system.geoParameters.origin_latitude << "],"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["scale_factor",)" << system.geoParameters.scale_factor << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
-        }
-        break;
+            if (strlen(system.geoParameters.vertical_datum) != 0)
+                wkt.vertical = verticalToWkt(system);
 
-        case CoordinateType::Van_der_Grinten:
-        {
-            wktStream << std::fixed << std::setprecision(6)
-                << R"(PROJCS["unnamed")"
-                << ", " << datumToWkt(system.geoParameters.datum,
-                    system.geoParameters.ellipsoid)
-                << R"(, PROJECTION["VanDerGrinten"],)"
-                << R"( PARAMETER["central_meridian",)" << system.geoParameters.central_meridian << "],"
-                << R"( PARAMETER["false_easting",)" << system.geoParameters.false_easting << "],"
-                << R"( PARAMETER["false_northing",)" << system.geoParameters.false_northing << "],"
-                << R"( UNIT["metre",1]])";
+            auto horizontal = cachedHorizontalToWkt(system);
+            wkt.error = horizontal.error;
+            wkt.horizontal = std::move(horizontal.wkt);
         }
-        break;
-
-        default:
+        catch (const std::exception &/*e*/)
         {
-            //Currently unsupported type.
-            return BAG_METADTA_INVALID_PROJECTION;
-        }
-
+            wkt.error = BAG_METADTA_INVALID_PROJECTION;
         }
 
-        if (wktStream.str().size() > hBufferSize)
-            wktStream.str().resize(hBufferSize);
-
-        strcpy(hBuffer, wktStream.str().c_str());
+        converted.push_back(std::move(wkt));
     }
 
-    return 0;
-}
-catch (const InvalidDatumError &/*e*/)
-{
-    return BAG_METADTA_INVALID_DATUM;
+    return converted;
 }
-catch (const std::exception &/*e*/)
+
+//************************************************************************
+/*!
+\brief Forget the cached conversions of legacy coordinate systems, and the
+ellipsoids read from ellips.dat.
+*/
+//************************************************************************
+void bagClearLegacyWktCache()
 {
-    //Something bad happened.
-    return BAG_METADTA_INVALID_PROJECTION;
+    {
+        const std::lock_guard<std::mutex> lock{wktCacheMutex};
+        wktCache.clear();
+    }
+
+    const std::lock_guard<std::mutex> lock{ellipsoidTableMutex};
+    pEllipsoidTable.reset();
 }
 
 
@@ -5,6 +5,8 @@
 #include "bag_c_types.h"
 
 #include <cstddef>
+#include <string>
+#include <vector>
 
 
 namespace BAG {
@@ -85,11 +87,22 @@ struct BagLegacyReferenceSystem
     BagProjectionParameters geoParameters;            //!< Parameters for projection information
 };
 
+//! The WKT of a legacy reference system.
+struct LegacyWkt
+{
+    BagError error = 0;                           //!< of the horizontal system; 0 on success
+    std::string horizontal;                       //!< horizontal reference system
+    std::string vertical;                         //!< vertical reference system; empty without a vertical datum
+};
+
 CoordinateType bagCoordsys(const char* str) noexcept;
 BagDatum bagDatumID(const char* str) noexcept;
 
 BagError bagLegacyToWkt(const BagLegacyReferenceSystem& system,
     char* hBuffer, size_t hBufferSize, char* vBuffer, size_t vBufferSize);
+BAG_API std::vector<LegacyWkt> bagLegacyToWktBatch(
+    const std::vector<BagLegacyReferenceSystem>& systems);
+BAG_API void bagClearLegacyWktCache();
 
 }  // namespace BAG
 
@@ -0,0 +1,116 @@
+
+#include "bag_mappedregion.h"
+
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace BAG {
+
+//! Constructor.
+/*!
+\param pMapping
+    The start of the mapping.
+\param mappingSize
+    The size of the mapping.
+\param pData
+    The first byte of the region, within the mapping.
+\param size
+    The number of bytes in the region.
+*/
+MappedRegion::MappedRegion(
+    void* pMapping,
+    size_t mappingSize,
+    const uint8_t* pData,
+    size_t size) noexcept
+    : m_pMapping(pMapping)
+    , m_mappingSize(mappingSize)
+    , m_pData(pData)
+    , m_size(size)
+{
+}
+
+//! Destructor.
+MappedRegion::~MappedRegion() noexcept
+{
+#ifndef _WIN32
+    ::munmap(m_pMapping, m_mappingSize);
+#endif
+}
+
+//! Map part of a file into memory, read only.
+/*!
+\param fileName
+    The file.
+\param offset
+    The offset of the region in the file.
+\param size
+    The number of bytes in the region.
+
+\return
+    The mapped region.
+    nullptr if the file could not be mapped.
+*/
+std::unique_ptr<MappedRegion> MappedRegion::map(
+    const std::string& fileName,
+    uint64_t offset,
+    size_t size) noexcept
+{
+#ifdef _WIN32
+    (void)fileName;
+    (void)offset;
+    (void)size;
+
+    return {};
+#else
+    if (size == 0)
+        return {};
+
+    const auto pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0)
+        return {};
+
+    // The mapping must start on a page.
+    const auto padding = static_cast<size_t>(offset % pageSize);
+    const auto mappingOffset = offset - padding;
+    const auto mappingSize = size + padding;
+
+    const auto fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {};
+
+    // Reading a mapping past the end of the file raises SIGBUS.
+    struct stat status{};
+    if (::fstat(fd, &status) != 0 ||
+        static_cast<uint64_t>(status.st_size) < offset + size)
+    {
+        ::close(fd);
+        return {};
+    }
+
+    // The mapping keeps the file open.
+    auto* pMapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd,
+        static_cast<off_t>(mappingOffset));
+    ::close(fd);
+
+    if (pMapping == MAP_FAILED)
+        return {};
+
+    std::unique_ptr<MappedRegion> pRegion{new (std::nothrow) MappedRegion{
+        pMapping, mappingSize, static_cast<const uint8_t*>(pMapping) + padding,
+        size}};
+    if (!pRegion)
+        ::munmap(pMapping, mappingSize);
+
+    return pRegion;
+#endif
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,68 @@
+#ifndef BAG_MAPPEDREGION_H
+#define BAG_MAPPEDREGION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace BAG {
+
+//! A read only memory map of part of a file.
+/*!
+    Only available on POSIX systems; elsewhere map() always fails, and the
+    callers read through HDF5 instead.
+*/
+class MappedRegion final
+{
+public:
+    static std::unique_ptr<MappedRegion> map(const std::string& fileName,
+        uint64_t offset, size_t size) noexcept;
+
+    ~MappedRegion() noexcept;
+
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion(MappedRegion&&) = delete;
+
+    MappedRegion& operator=(const MappedRegion&) = delete;
+    MappedRegion& operator=(MappedRegion&&) = delete;
+
+    //! Retrieve the first byte of the region.
+    /*!
+    \return
+        The first byte of the region.
+    */
+    const uint8_t* data() const noexcept
+    {
+        return m_pData;
+    }
+
+    //! Retrieve the size of the region.
+    /*!
+    \return
+        The number of bytes in the region.
+    */
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+private:
+    MappedRegion(void* pMapping, size_t mappingSize, const uint8_t* pData,
+        size_t size) noexcept;
+
+    //! The start of the mapping, which is aligned to a page.
+    void* m_pMapping = nullptr;
+    //! The size of the mapping.
+    size_t m_mappingSize = 0;
+    //! The first byte of the region, within the mapping.
+    const uint8_t* m_pData = nullptr;
+    //! The number of bytes in the region.
+    size_t m_size = 0;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_MAPPEDREGION_H
+
@@ -0,0 +1,179 @@
+
+#include "bag_dataset.h"
+#include "bag_memorybudget.h"
+
+#include <algorithm>
+
+
+namespace BAG {
+
+//! Retrieve the budget shared by every Dataset.
+/*!
+    The budget is never destroyed, so datasets destroyed during static
+    destruction can still leave it.
+
+\return
+    The budget.
+*/
+MemoryBudget& MemoryBudget::global() noexcept
+{
+    static auto* pBudget = new MemoryBudget;
+
+    return *pBudget;
+}
+
+//! Retrieve the most the caches may hold.
+/*!
+\return
+    The limit, in bytes; 0 if there is none.
+*/
+uint64_t MemoryBudget::getLimit() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return m_limit;
+}
+
+//! Set the most the caches may hold.
+/*!
+    If the caches already hold more, those used least recently are released
+    until they fit.
+
+\param bytes
+    The limit, in bytes; 0 for no limit.
+*/
+void MemoryBudget::setLimit(
+    uint64_t bytes)
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    m_limit = bytes;
+    this->enforce(nullptr);
+}
+
+//! Retrieve the memory the caches of every Dataset hold.
+/*!
+\return
+    The memory held, in bytes.
+*/
+uint64_t MemoryBudget::getUsage() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return m_usage;
+}
+
+//! Retrieve the number of datasets holding caches.
+/*!
+\return
+    The number of datasets.
+*/
+size_t MemoryBudget::getNumDatasets() const noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    return static_cast<size_t>(std::count_if(m_entries.begin(),
+        m_entries.end(), [](const Entry& entry) { return entry.bytes > 0; }));
+}
+
+//! Record the memory the caches of a Dataset hold, as it just used them.
+/*!
+    If the caches of every dataset then hold more than the limit, those of
+    the other datasets are released, least recently used first.
+
+\param dataset
+    The dataset.
+\param bytes
+    The memory its caches hold, in bytes.
+*/
+void MemoryBudget::update(
+    const Dataset& dataset,
+    uint64_t bytes)
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    auto found = std::find_if(m_entries.begin(), m_entries.end(),
+        [&dataset](const Entry& entry) { return entry.pDataset == &dataset; });
+
+    if (found == m_entries.end())
+    {
+        if (bytes == 0)
+            return;
+
+        m_entries.push_back({&dataset, 0, 0});
+        found = m_entries.end() - 1;
+    }
+
+    m_usage = m_usage - found->bytes + bytes;
+    found->bytes = bytes;
+    found->lastUse = ++m_clock;
+
+    this->enforce(&dataset);
+}
+
+//! Forget a Dataset, as it is being destroyed.
+/*!
+\param dataset
+    The dataset.
+*/
+void MemoryBudget::remove(
+    const Dataset& dataset) noexcept
+{
+    const std::lock_guard<std::mutex> lock{m_mutex};
+
+    const auto found = std::find_if(m_entries.begin(), m_entries.end(),
+        [&dataset](const Entry& entry) { return entry.pDataset == &dataset; });
+    if (found == m_entries.end())
+        return;
+
+    m_usage -= found->bytes;
+    m_entries.erase(found);
+}
+
+//! Release caches, least recently used first, until they fit the limit.
+/*!
+    The mutex must be held.  A dataset that cannot release its caches now
+    releases them when it next uses one, and is not counted until then.
+
+\param pExempt
+    The dataset whose caches are not released, as it is using them;
+    nullptr if there is none.
+*/
+void MemoryBudget::enforce(
+    const Dataset* pExempt)
+{
+    if (m_limit == 0 || m_usage <= m_limit)
+        return;
+
+    std::vector<Entry*> victims;
+    victims.reserve(m_entries.size());
+
+    for (auto& entry : m_entries)
+        if (entry.pDataset != pExempt && entry.bytes > 0)
+            victims.push_back(&entry);
+
+    std::sort(victims.begin(), victims.end(),
+        [](const Entry* lhs, const Entry* rhs) {
+            return lhs->lastUse < rhs->lastUse;
+        });
+
+    for (auto* pVictim : victims)
+    {
+        if (m_usage <= m_limit)
+            break;
+
+        const auto bytes = pVictim->pDataset->releaseCachesForBudget();
+
+        m_usage = m_usage - pVictim->bytes + bytes;
+        pVictim->bytes = bytes;
+    }
+
+    // Forget the datasets without caches.
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+        [pExempt](const Entry& entry) {
+            return entry.bytes == 0 && entry.pDataset != pExempt;
+        }), m_entries.end());
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,89 @@
+#ifndef BAG_MEMORYBUDGET_H
+#define BAG_MEMORYBUDGET_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! A limit on the memory held by the caches of every open Dataset.
+/*!
+    The caches a Dataset builds as it is used, which it can rebuild from the
+    file (see DatasetMemoryUsage::getReleasable()), report their size to the
+    global budget.  When they add up to more than the limit, the caches of
+    the datasets used least recently are released until they fit.
+
+    A Dataset opened with OpenOptions::concurrentReads releases its caches
+    immediately, unless one of its threads is using them.  Any other Dataset
+    may be in use on another thread, so it releases them the next time it
+    uses one, and is not counted against the budget until then.
+
+    There is no limit by default.
+*/
+class BAG_API MemoryBudget final
+{
+public:
+    static MemoryBudget& global() noexcept;
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget(MemoryBudget&&) = delete;
+
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+    uint64_t getLimit() const noexcept;
+    void setLimit(uint64_t bytes);
+
+    uint64_t getUsage() const noexcept;
+    size_t getNumDatasets() const noexcept;
+
+private:
+    MemoryBudget() = default;
+
+    void update(const Dataset& dataset, uint64_t bytes);
+    void remove(const Dataset& dataset) noexcept;
+    void enforce(const Dataset* pExempt);
+
+    //! The caches of a Dataset.
+    struct Entry final
+    {
+        //! The dataset.
+        const Dataset* pDataset = nullptr;
+        //! The bytes its caches hold.
+        uint64_t bytes = 0;
+        //! When its caches were last used; larger is more recent.
+        uint64_t lastUse = 0;
+    };
+
+    //! Guards the members.
+    mutable std::mutex m_mutex;
+    //! The datasets with caches, in no particular order.
+    std::vector<Entry> m_entries;
+    //! The most the caches may hold, in bytes; 0 for no limit.
+    uint64_t m_limit = 0;
+    //! The bytes held by the caches of every dataset.
+    uint64_t m_usage = 0;
+    //! Counts uses of the caches, to order them.
+    uint64_t m_clock = 0;
+
+    friend Dataset;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_MEMORYBUDGET_H
+
@@ -64,6 +64,7 @@ Metadata::Metadata(Dataset& dataset)
     m_pH5dataSet->read(buffer, stringType);
 
     this->loadFromBuffer(buffer);
+    m_writtenXML = std::move(buffer);
 }
 
 //! Destructor.
@@ -103,6 +104,8 @@ uint32_t Metadata::columns() const noexcept
 
 //! Create an HDF5 DataSet to store the metadata.
 /*!
+    The DataSet is created empty; write() sizes it to the XML.
+
 \param dataset
     The BAG Dataset this layer belongs to.
 */
@@ -113,8 +116,7 @@ void Metadata::createH5dataSet(
 
     const auto& h5file = dataset.getH5file();
 
-    const auto buffer = exportMetadataToXML(this->getStruct());
-    const hsize_t xmlLength{buffer.size()};
+    const hsize_t xmlLength = 0;
     const hsize_t kUnlimitedSize = H5F_UNLIMITED;
     const ::H5::DataSpace h5dataSpace{1, &xmlLength, &kUnlimitedSize};
 
@@ -126,7 +128,7 @@ void Metadata::createH5dataSet(
             ::H5::PredType::C_S1, h5dataSpace, h5createPropList)},
             DeleteH5dataSet{});
 
-    m_pH5dataSet->extend(&xmlLength);
+    m_writtenXML.clear();
 }
 
 //! Retrieve the C structure this class wraps.
@@ -194,6 +196,8 @@ double Metadata::llCornerY() const noexcept
 */
 void Metadata::loadFromFile(const std::string& fileName)
 {
+    const TraceScope trace{"Metadata::loadFromFile"};
+
     const BagError err = bagImportMetadataFromXmlFile(fileName.c_str(),
         *m_pMetaStruct, false);
     if (err != BAG_SUCCESS)
@@ -214,6 +218,8 @@ void Metadata::loadFromFile(const std::string& fileName)
 */
 void Metadata::loadFromBuffer(const std::string& xmlBuffer)
 {
+    const TraceScope trace{"Metadata::loadFromBuffer"};
+
     const BagError err = bagImportMetadataFromXmlBuffer(xmlBuffer.c_str(),
         static_cast<int>(xmlBuffer.size()), *m_pMetaStruct, false);
     if (err != BAG_SUCCESS)
@@ -222,6 +228,27 @@ void Metadata::loadFromBuffer(const std::string& xmlBuffer)
     m_xmlLength = xmlBuffer.size();
 }
 
+//! Populate the spatial parts of the metadata from the XML in the specified buffer.
+/*!
+    Read only the spatial representation and the reference systems, which is
+    all a Descriptor needs, from the specified buffer.  An ErrorLoadingMetadata
+    exception is thrown if an error occurs.
+
+\param xmlBuffer
+    The XML buffer.
+*/
+void Metadata::loadSpatialFromBuffer(const std::string& xmlBuffer)
+{
+    const TraceScope trace{"Metadata::loadSpatialFromBuffer"};
+
+    const BagError err = bagImportSpatialMetadataFromXmlBuffer(
+        xmlBuffer.c_str(), static_cast<int>(xmlBuffer.size()), *m_pMetaStruct);
+    if (err != BAG_SUCCESS)
+        throw ErrorLoadingMetadata{err};
+
+    m_xmlLength = xmlBuffer.size();
+}
+
 //! Retrieve the row resolution.
 /*!
 \return
@@ -278,15 +305,25 @@ std::string Metadata::verticalReferenceSystemAsWKT() const
 }
 
 //! Write the metadata to the HDF5 file.
+/*!
+    Nothing is written if the XML is the same as that last written to, or
+    read from, the HDF5 file.
+*/
 void Metadata::write() const
 {
-    const auto buffer = exportMetadataToXML(this->getStruct());
+    auto buffer = exportMetadataToXML(this->getStruct());
+    if (buffer == m_writtenXML)
+        return;
 
     const hsize_t bufferLen = buffer.size();
     const hsize_t kMaxSize = H5F_UNLIMITED;
     const ::H5::DataSpace h5dataSpace{1, &bufferLen, &kMaxSize};
 
+    // Resize the DataSet to the XML, which may have grown or shrunk.
+    m_pH5dataSet->extend(&bufferLen);
     m_pH5dataSet->write(buffer, ::H5::PredType::C_S1, h5dataSpace);
+
+    m_writtenXML = std::move(buffer);
 }
 
 }   //namespace BAG
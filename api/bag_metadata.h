@@ -64,6 +64,7 @@ public:
 
     void loadFromFile(const std::string& fileName);
     void loadFromBuffer(const std::string& xmlBuffer);
+    void loadSpatialFromBuffer(const std::string& xmlBuffer);
 
     size_t getXMLlength() const noexcept;
 
@@ -80,6 +81,8 @@ private:
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
     //! Length of the XML (from file or buffer).
     size_t m_xmlLength = 0;
+    //! The XML last written to, or read from, the HDF5 DataSet.
+    mutable std::string m_writtenXML;
 
     friend Dataset;
 };
@@ -5,129 +5,286 @@
 //************************************************************************
 #include "bag_metadata_export.h"
 
+#include <cstdio>
 #include <cstring>
-#include <iostream>
-#include <libxml/parser.h>
+#include <locale>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 
 namespace BAG {
 
 namespace {
 
-//! Utility class to convert an encoded XML string.
-class EncodedString final
+//! The initial capacity of the exported XML; enough for most BAGs.
+constexpr size_t kInitialXMLCapacity = 16 * 1024;
+
+//! The ISO code lists.
+constexpr char kGmxCodelists[] =
+    "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml";
+
+//! The BAG code lists.
+constexpr char kBagCodelists[] =
+    "http://www.opennavsurf.org/schema/bag/bagCodelists.xml";
+
+//! The language code list.
+constexpr char kLanguageCodelist[] = "http://www.loc.gov/standards/iso639-2/";
+
+//! Utility class to write XML as it goes, without building a document.
+/*!
+    Elements, attributes and text are appended to the output as they are
+    written, escaped as libxml2 escapes them when saving a document, so the
+    XML is the same as it would be had it been built as a DOM and saved.
+*/
+class XmlWriter final
 {
 public:
     //************************************************************************
     //! Constructor
     /*!
-    \param doc
-        \li The XML document that the string is from.
-    \param string
-        \li The string to be converted.
+    \param output
+        \li The string the XML is appended to.
+    */
+    //************************************************************************
+    explicit XmlWriter(std::string& output)
+        : m_output(output)
+    {
+        m_numberStream.imbue(std::locale::classic());
+    }
+
+    //************************************************************************
+    //! Start an element, which may then be given attributes.
+    /*!
+    \param name
+        \li The qualified name of the element.
+    */
+    //************************************************************************
+    void startElement(const char *name)
+    {
+        this->closeStartTag();
+
+        m_output += '<';
+        m_elements.emplace_back(m_output.size(), std::strlen(name));
+        m_output += name;
+        m_startTagOpen = true;
+    }
+
+    //************************************************************************
+    //! Start an element whose prefix and name are separate.
+    /*!
+    \param prefix
+        \li The namespace prefix of the element.
+    \param name
+        \li The local name of the element.
+    */
+    //************************************************************************
+    void startElement(const char *prefix, const char *name)
+    {
+        this->closeStartTag();
+
+        m_output += '<';
+        const auto start = m_output.size();
+        m_output += prefix;
+        m_output += ':';
+        m_output += name;
+        m_elements.emplace_back(start, m_output.size() - start);
+        m_startTagOpen = true;
+    }
+
+    //************************************************************************
+    //! End the most recently started element.
+    //************************************************************************
+    void endElement()
+    {
+        if (m_startTagOpen)
+        {
+            m_output += "/>";
+            m_startTagOpen = false;
+        }
+        else
+        {
+            // The name is copied from the element's start tag.
+            m_output += "</";
+            m_output.append(m_output, m_elements.back().first,
+                m_elements.back().second);
+            m_output += '>';
+        }
+
+        m_elements.pop_back();
+    }
+
+    //************************************************************************
+    //! Add an attribute to the element just started.
+    /*!
+    \param name
+        \li The qualified name of the attribute.
+    \param value
+        \li The value of the attribute; nullptr for an empty one.
+    */
+    //************************************************************************
+    void attribute(const char *name, const char *value)
+    {
+        m_output += ' ';
+        m_output += name;
+        m_output += "=\"";
+        this->escape(value, true);
+        m_output += '"';
+    }
+
+    //************************************************************************
+    //! Add text to the current element.
+    /*!
+    \param content
+        \li The text; nullptr or empty for none.
     */
     //************************************************************************
-    EncodedString(xmlDoc &doc, const char *string)
+    void text(const char *content)
     {
-        this->m_pEncodedString = xmlEncodeEntitiesReentrant(&doc,
-            reinterpret_cast<const xmlChar*>(string));
+        if (!content || !*content)
+            return;
+
+        this->closeStartTag();
+        this->escape(content, false);
     }
 
     //************************************************************************
-    //! Destructor.
+    //! Add a number to the current element, formatted as a stream would.
+    /*!
+    \param value
+        \li The number.
+    */
     //************************************************************************
-    ~EncodedString()
+    void decimal(double value)
     {
-        xmlFree(this->m_pEncodedString);
+        m_numberStream.str({});
+        m_numberStream << value;
+        this->text(m_numberStream.str().c_str());
     }
 
     //************************************************************************
-    //! Conversion operator.
+    //! Write an element holding only text.
     /*!
-    \return
-        \li The encoded string.
+    \param name
+        \li The qualified name of the element.
+    \param content
+        \li The text; nullptr or empty for none.
     */
     //************************************************************************
-    operator xmlChar*() const
+    void element(const char *name, const char *content)
     {
-        return this->m_pEncodedString;
+        this->startElement(name);
+        this->text(content);
+        this->endElement();
     }
 
 private:
-    //! The encoded string.
-    xmlChar* m_pEncodedString = nullptr;
-};
+    //! Close the start tag of the current element, if it is still open.
+    void closeStartTag()
+    {
+        if (!m_startTagOpen)
+            return;
+
+        m_output += '>';
+        m_startTagOpen = false;
+    }
 
-#define XMLCast(value) reinterpret_cast<const xmlChar*>(value)
+    //! Escape text or an attribute value onto the output.
+    void escape(const char *content, bool isAttribute)
+    {
+        if (!content)
+            return;
+
+        // Copy runs of characters that need no escaping in one go.
+        const char* special = isAttribute ? "<>&\r\"\n\t" : "<>&\r";
+        for (const char *c = content; *c; )
+        {
+            const size_t run = std::strcspn(c, special);
+            m_output.append(c, run);
+            c += run;
+            if (!*c)
+                break;
+
+            switch (*c)
+            {
+            case '<': m_output += "&lt;"; break;
+            case '>': m_output += "&gt;"; break;
+            case '&': m_output += "&amp;"; break;
+            case '\r': m_output += "&#13;"; break;
+            case '"': m_output += "&quot;"; break;
+            case '\n': m_output += "&#10;"; break;
+            case '\t': m_output += "&#9;"; break;
+            }
+            ++c;
+        }
+    }
+
+    //! The XML written so far.
+    std::string& m_output;
+    //! Where the names of the elements started but not yet ended are in
+    //! the output, as offsets and lengths.
+    std::vector<std::pair<size_t, size_t>> m_elements;
+    //! Can attributes still be added to the current element?
+    bool m_startTagOpen = false;
+    //! Formats numbers, independent of the global locale.
+    std::ostringstream m_numberStream;
+};
 
 //************************************************************************
-//! Add a CharacterString node to the supplied parent XML node.
+//! Add a CharacterString element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param content
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addCharacterNode(xmlNode &parentNode, const char *content)
+void addCharacterNode(XmlWriter &writer, const char *content)
 {
-    const auto pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the CharacterString node.
-    xmlNode *pCharacterNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("CharacterString"), EncodedString(*parentNode.doc, content));
-    return pCharacterNode;
+    writer.element("gco:CharacterString", content);
 }
 
 //************************************************************************
-//! Add a Date node to the supplied parent XML node.
+//! Add a Date element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param content
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addDateNode(xmlNode &parentNode, const char *content)
+void addDateNode(XmlWriter &writer, const char *content)
 {
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //If the content is nullptr, then we will just add a nilReason.
+    //If the content is nullptr, then we will just add a nilReason to the parent.
     if (content == nullptr)
     {
-        xmlSetProp(&parentNode, XMLCast("gco:nilReason"), XMLCast("unknown"));
-        return nullptr;
+        writer.attribute("gco:nilReason", "unknown");
+        return;
     }
 
-    //Create the Date node.
-    xmlNode *pDateNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("Date"), EncodedString(*parentNode.doc, content));
-    return pDateNode;
+    writer.element("gco:Date", content);
 }
 
 //************************************************************************
-//! Add a DateTime node to the supplied parent XML node.
+//! Add a DateTime element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param content
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addDateTimeNode(xmlNode &parentNode, const char *content)
+void addDateTimeNode(XmlWriter &writer, const char *content)
 {
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the DateTime node.
-    xmlNode *pDateTimeNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("DateTime"), EncodedString(*parentNode.doc, content));
-    return pDateTimeNode;
+    writer.element("gco:DateTime", content);
 }
 
 //************************************************************************
-//! Add a Code value to the supplied parent XML node.
+//! Add a Code value element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param codeNameSpace
     \li The namespace to which the code belongs
 \param codeName
@@ -138,98 +295,75 @@ xmlNode* addDateTimeNode(xmlNode &parentNode, const char *content)
     \li The actual value from the code list.
 */
 //************************************************************************
-xmlNode* addCodeListNode(xmlNode &parentNode, const char *codeNameSpace, const char *codeName,
-                         const char *url, const char *value, bool appendValueToUrl = true)
+void addCodeListNode(XmlWriter &writer, const char *codeNameSpace, const char *codeName,
+                     const char *url, const char *value, bool appendValueToUrl = true)
 {
-    const xmlNsPtr pNamespace = xmlSearchNs(parentNode.doc, &parentNode, EncodedString(*parentNode.doc, codeNameSpace));
-
-    //Create the codeList node.
-    xmlNode *pCodeNode = xmlNewChild(&parentNode, pNamespace, EncodedString(*parentNode.doc, codeName), EncodedString(*parentNode.doc, value));
-
-    std::stringstream fullUrlStream;
-    fullUrlStream << url;
+    writer.startElement(codeNameSpace, codeName);
 
     if (appendValueToUrl)
-        fullUrlStream << "#" << codeName;
-
-    xmlSetProp(pCodeNode, XMLCast("codeList"), EncodedString(*parentNode.doc, fullUrlStream.str().c_str()));
-    xmlSetProp(pCodeNode, XMLCast("codeListValue"), EncodedString(*parentNode.doc, value));
+        writer.attribute("codeList", (std::string{url} + '#' + codeName).c_str());
+    else
+        writer.attribute("codeList", url);
 
-    return pCodeNode;
+    writer.attribute("codeListValue", value);
+    writer.text(value);
+    writer.endElement();
 }
 
 //************************************************************************
-//! Add a Decimal node to the supplied parent XML node.
+//! Add a Decimal element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param value
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addDecimalNode(xmlNode &parentNode, double value)
+void addDecimalNode(XmlWriter &writer, double value)
 {
-    std::stringstream lineStream;
-    lineStream.imbue(std::locale::classic());
-    lineStream << value;
-
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the Decimal node.
-    xmlNode *pDecimalNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("Decimal"), XMLCast(lineStream.str().c_str()));
-    return pDecimalNode;
+    writer.startElement("gco:Decimal");
+    writer.decimal(value);
+    writer.endElement();
 }
 
 //************************************************************************
-//! Add a Integer node to the supplied parent XML node.
+//! Add a Integer element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param value
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addIntegerNode(xmlNode &parentNode, int value)
+void addIntegerNode(XmlWriter &writer, int value)
 {
-    std::stringstream lineStream;
-    lineStream.imbue(std::locale::classic());
-    lineStream << value;
-
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the Integer node.
-    xmlNode *pIntegerNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("Integer"), XMLCast(lineStream.str().c_str()));
-    return pIntegerNode;
+    writer.element("gco:Integer", std::to_string(value).c_str());
 }
 
 //************************************************************************
-//! Add a Measure node to the supplied parent XML node.
+//! Add a Measure element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
+\param uomName
+    \li The unit of measure of \e value.
 \param value
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addMeasureNode(xmlNode &parentNode, const char *uomName, double value)
+void addMeasureNode(XmlWriter &writer, const char *uomName, double value)
 {
-    std::stringstream lineStream;
-    lineStream.imbue(std::locale::classic());
-    lineStream << value;
-
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the Measure node.
-    xmlNode *pMeasureNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("Measure"), XMLCast(lineStream.str().c_str()));
-    xmlSetProp(pMeasureNode, XMLCast("uom"), EncodedString(*parentNode.doc, uomName));
-    return pMeasureNode;
+    writer.startElement("gco:Measure");
+    writer.attribute("uom", uomName);
+    writer.decimal(value);
+    writer.endElement();
 }
 
 //************************************************************************
-//! Add an MD_Dimension node to the supplied parent XML node.
+//! Add an MD_Dimension element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param name
     \li The name for the MD_DimensionNameTypeCode
 \param size
@@ -240,106 +374,79 @@ xmlNode* addMeasureNode(xmlNode &parentNode, const char *uomName, double value)
     \li The units of \e resolution.
 */
 //************************************************************************
-xmlNode* addDimension(xmlNode &parentNode, const char *name, unsigned int size,
-                      double resolution, const char *resolutionUnit)
+void addDimension(XmlWriter &writer, const char *name, unsigned int size,
+                  double resolution, const char *resolutionUnit)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    xmlNode *pDimNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("axisDimensionProperties"), nullptr);
-    pDimNode = xmlNewChild(pDimNode, pGmdNamespace, XMLCast("MD_Dimension"), nullptr);
+    writer.startElement("gmd:axisDimensionProperties");
+    writer.startElement("gmd:MD_Dimension");
 
     //dimensionName
-    {
-        xmlNode *pNode = xmlNewChild(pDimNode, pGmdNamespace, XMLCast("dimensionName"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_DimensionNameTypeCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", name);
-    }
+    writer.startElement("gmd:dimensionName");
+    addCodeListNode(writer, "gmd", "MD_DimensionNameTypeCode", kGmxCodelists, name);
+    writer.endElement();
 
     //dimensionSize
-    {
-        xmlNode *pNode = xmlNewChild(pDimNode, pGmdNamespace, XMLCast("dimensionSize"), nullptr);
-        addIntegerNode(*pNode, size);
-    }
+    writer.startElement("gmd:dimensionSize");
+    addIntegerNode(writer, size);
+    writer.endElement();
 
     //resolution
-    {
-        xmlNode *pNode = xmlNewChild(pDimNode, pGmdNamespace, XMLCast("resolution"), nullptr);
-        addMeasureNode(*pNode, resolutionUnit, resolution);
-    }
+    writer.startElement("gmd:resolution");
+    addMeasureNode(writer, resolutionUnit, resolution);
+    writer.endElement();
 
-    return pDimNode;
+    writer.endElement();
+    writer.endElement();
 }
 
 //************************************************************************
-//! Add a Boolean node to the supplied parent XML node.
+//! Add a Boolean element.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the element to.
 \param value
-    \li The content to be added to \e parentNode.
+    \li The content of the element.
 */
 //************************************************************************
-xmlNode* addBooleanNode(xmlNode &parentNode, bool value)
+void addBooleanNode(XmlWriter &writer, bool value)
 {
-    const std::string valString(value ? "1" : "0");
-
-    const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
-
-    //Create the Integer node.
-    xmlNode *pBoolNode = xmlNewChild(&parentNode, pGcoNamespace, XMLCast("Boolean"), XMLCast(valString.c_str()));
-    return pBoolNode;
+    writer.element("gco:Boolean", value ? "1" : "0");
 }
 
-}  // namespace
-
 
 //************************************************************************
-//! Create a new XML document and configure it for the BAG metadata profile.
+//! Start the root element of the BAG metadata profile.
 /*!
-\return
-    \li The new XML document.
+\param writer
+    \li The writer to start the root element in.
 */
 //************************************************************************
-xmlDoc* createNewDocument()
+void startDocument(XmlWriter &writer)
 {
-    const char version[] = "1.0";
-    const char rootName[] = "MI_Metadata";
-    const char rootNameSpaceUrl[] = "http://www.isotc211.org/2005/gmi";
-
-    //Create the new document.
-    xmlDoc *pDocument = xmlNewDoc(XMLCast(version));
-
-    //Create the root node and assign to the document.
-    xmlNodePtr pRoot = xmlNewDocNode(pDocument, nullptr, XMLCast(rootName), nullptr);
-    xmlDocSetRootElement(pDocument, pRoot);
-
-    //Create the root namespace and assign to the root.
-    xmlNs *pRootNameSpace = xmlNewNs(pRoot, XMLCast(rootNameSpaceUrl), XMLCast("gmi"));
-    xmlSetNs(pRoot, pRootNameSpace);
-
-    //Add the rest of the required namespaces.
-    xmlNewNs(pRoot, XMLCast("http://www.isotc211.org/2005/gmd"), XMLCast("gmd"));
-    xmlNewNs(pRoot, XMLCast("http://www.w3.org/2001/XMLSchema-instance"), XMLCast("xsi"));
-    xmlNewNs(pRoot, XMLCast("http://www.opengis.net/gml/3.2"), XMLCast("gml"));
-    xmlNewNs(pRoot, XMLCast("http://www.isotc211.org/2005/gco"), XMLCast("gco"));
-    xmlNewNs(pRoot, XMLCast("http://www.w3.org/1999/xlink"), XMLCast("xlink"));
-    xmlNewNs(pRoot, XMLCast("http://www.opennavsurf.org/schema/bag"), XMLCast("bag"));
-
-    return pDocument;
+    writer.startElement("gmi:MI_Metadata");
+
+    //The root namespace, then the rest of the required namespaces.
+    writer.attribute("xmlns:gmi", "http://www.isotc211.org/2005/gmi");
+    writer.attribute("xmlns:gmd", "http://www.isotc211.org/2005/gmd");
+    writer.attribute("xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance");
+    writer.attribute("xmlns:gml", "http://www.opengis.net/gml/3.2");
+    writer.attribute("xmlns:gco", "http://www.isotc211.org/2005/gco");
+    writer.attribute("xmlns:xlink", "http://www.w3.org/1999/xlink");
+    writer.attribute("xmlns:bag", "http://www.opennavsurf.org/schema/bag");
 }
 
 //************************************************************************
-//! Add the BagResponsibleParty information to the parent XML node.
+//! Add the BagResponsibleParty information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param responsiblePartyStruct
-    \li The structure to be added to \e parentNode.
+    \li The structure to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addResponsibleParty(xmlNode &parentNode, const BagResponsibleParty &responsiblePartyStruct)
+bool addResponsibleParty(XmlWriter &writer, const BagResponsibleParty &responsiblePartyStruct)
 {
     /* Criteria for this node is that "role must be supplied and at least one of the following fileds must be supplied. */
     if (responsiblePartyStruct.individualName == nullptr &&
@@ -356,46 +463,48 @@ bool addResponsibleParty(xmlNode &parentNode, const BagResponsibleParty &respons
         return false;
     }
 
-    //Find the gmd namespace.
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    //Create the CI_ResponsibleParty node.
-    xmlNode *pPartyNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("CI_ResponsibleParty"), nullptr);
+    //Start the CI_ResponsibleParty element.
+    writer.startElement("gmd:CI_ResponsibleParty");
 
-    /* If an individual name has been supplied, Create the individual node and populate it. */
+    /* If an individual name has been supplied, add the individual element. */
     if (responsiblePartyStruct.individualName != nullptr)
     {
-        xmlNode *pNode = xmlNewChild(pPartyNode, pGmdNamespace, XMLCast("individualName"), nullptr);
-        addCharacterNode(*pNode, (char*)responsiblePartyStruct.individualName);
+        writer.startElement("gmd:individualName");
+        addCharacterNode(writer, responsiblePartyStruct.individualName);
+        writer.endElement();
     }
 
-    /* If an organisation name has been supplied, Create the organisation node and populate it. */
+    /* If an organisation name has been supplied, add the organisation element. */
     if (responsiblePartyStruct.organisationName != nullptr)
     {
-        xmlNode *pNode = xmlNewChild(pPartyNode, pGmdNamespace, XMLCast("organisationName"), nullptr);
-        addCharacterNode(*pNode, (char*)responsiblePartyStruct.organisationName);
+        writer.startElement("gmd:organisationName");
+        addCharacterNode(writer, responsiblePartyStruct.organisationName);
+        writer.endElement();
     }
 
-    /* If a postiion name has been supplied, Create the position node and populate it. */
+    /* If a postiion name has been supplied, add the position element. */
     if (responsiblePartyStruct.positionName != nullptr)
     {
-        xmlNode *pNode = xmlNewChild(pPartyNode, pGmdNamespace, XMLCast("positionName"), nullptr);
-        addCharacterNode(*pNode, (char*)responsiblePartyStruct.positionName);
+        writer.startElement("gmd:positionName");
+        addCharacterNode(writer, responsiblePartyStruct.positionName);
+        writer.endElement();
     }
 
-    //Create the role node and populate it.
-    xmlNode *pNode = xmlNewChild(pPartyNode, pGmdNamespace, XMLCast("role"), nullptr);
-    addCodeListNode(*pNode, "gmd", "CI_RoleCode",
-        "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", (char*)responsiblePartyStruct.role);
+    //Add the role.
+    writer.startElement("gmd:role");
+    addCodeListNode(writer, "gmd", "CI_RoleCode", kGmxCodelists, responsiblePartyStruct.role);
+    writer.endElement();
+
+    writer.endElement();
 
     return true;
 }
 
 //************************************************************************
-//! Add the citation information to the parent XML node.
+//! Add the citation information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param title
     \li The title of the person for the citation.
 \param date
@@ -410,176 +519,149 @@ bool addResponsibleParty(xmlNode &parentNode, const BagResponsibleParty &respons
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addCitation(xmlNode &parentNode, const char *title, const char *date, const char *dateType,
+bool addCitation(XmlWriter &writer, const char *title, const char *date, const char *dateType,
                  const BagResponsibleParty *responsibleParties, uint32_t numberOfParties)
 {
     //CI_citation is optional, so if no title was given just return.
     if (!title)
         return true;
 
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    //Create the CI_Citation node.
-    xmlNode *pCitationNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("CI_Citation"), nullptr);
+    //Start the CI_Citation element.
+    writer.startElement("gmd:CI_Citation");
 
     //Add the title
-    {
-        //Create the title node.
-        xmlNode *pTitleNode = xmlNewChild(pCitationNode, pGmdNamespace, XMLCast("title"), nullptr);
-
-        //Set the title value.
-        addCharacterNode(*pTitleNode, title);
-    }
+    writer.startElement("gmd:title");
+    addCharacterNode(writer, title);
+    writer.endElement();
 
     //Add the date
     {
-        //Create the date nodes.
-        xmlNode *pDateNode = xmlNewChild(pCitationNode, pGmdNamespace, XMLCast("date"), nullptr);
-        pDateNode = xmlNewChild(pDateNode, pGmdNamespace, XMLCast("CI_Date"), nullptr);
+        writer.startElement("gmd:date");
+        writer.startElement("gmd:CI_Date");
 
-        //Create the date node.
-        xmlNode *pDateNode2 = xmlNewChild(pDateNode, pGmdNamespace, XMLCast("date"), nullptr);
+        //Add the date value.
+        writer.startElement("gmd:date");
+        addDateNode(writer, date);
+        writer.endElement();
 
-        //Set the date value.
-        addDateNode(*pDateNode2, date);
+        //Add the date type.
+        writer.startElement("gmd:dateType");
+        addCodeListNode(writer, "gmd", "CI_DateTypeCode", kGmxCodelists, dateType);
+        writer.endElement();
 
-        //Create the dateType node.
-        xmlNode *pDateTypeNode = xmlNewChild(pDateNode, pGmdNamespace, XMLCast("dateType"), nullptr);
-
-        //Set the date type value.
-        addCodeListNode(*pDateTypeNode, "gmd", "CI_DateTypeCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", dateType);
+        writer.endElement();
+        writer.endElement();
     }
 
     //Add the responsible parties
+    for (uint32_t r = 0; r < numberOfParties; r++)
     {
-        for (uint32_t r = 0; r < numberOfParties; r++)
-        {
-            //Create the citedResponsibleParty node.
-            xmlNode *pPartyNode = xmlNewChild(pCitationNode, pGmdNamespace, XMLCast("citedResponsibleParty"), nullptr);
+        writer.startElement("gmd:citedResponsibleParty");
 
-            const bool ret = addResponsibleParty(*pPartyNode, responsibleParties[r]);
-            if (!ret)
-            {
-                fprintf(stderr, "ERROR: responsibleParties[%d]: At least one of the following fields must be supplied. individualName, organisationName, postionName.\n", r);
-                return false;
-            }
+        const bool ret = addResponsibleParty(writer, responsibleParties[r]);
+        if (!ret)
+        {
+            fprintf(stderr, "ERROR: responsibleParties[%d]: At least one of the following fields must be supplied. individualName, organisationName, postionName.\n", r);
+            return false;
         }
+
+        writer.endElement();
     }
 
+    writer.endElement();
+
     return true;
 }
 
 //************************************************************************
-//! Add the BagIdentification information to the parent XML node.
+//! Add the BagIdentification information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param identificationInfo
-    \li The identification information to be added to \e parentNode
+    \li The identification information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addDataIdentification(xmlNode &parentNode, const BagIdentification &identificationInfo)
+bool addDataIdentification(XmlWriter &writer, const BagIdentification &identificationInfo)
 {
-    /* Check for the required fields. If they are not present, return nullptr. */
+    /* Check for the required fields. If they are not present, return false. */
     if (identificationInfo.abstractString == nullptr ||
         identificationInfo.language == nullptr ||
         identificationInfo.verticalUncertaintyType == nullptr)
     {
-	    fprintf(stderr, "ERROR: can not create BAG identificationInfo.  Missing one or more required fields... abstract, language or verticalUncertaintyType. \n");
-	    return false;
+        fprintf(stderr, "ERROR: can not create BAG identificationInfo.  Missing one or more required fields... abstract, language or verticalUncertaintyType. \n");
+        return false;
     }
 
-    //Find the gmd namespace.
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-    const xmlNsPtr pBagNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("bag"));
-
-    //Create the identificationInfo node.
-    xmlNode *pIdentInfoNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("identificationInfo"), nullptr);
-
-    //Create the BAG_DataIdentification node.
-    xmlNode *pBagIdentInfoNode = xmlNewChild(pIdentInfoNode, pBagNamespace, XMLCast("BAG_DataIdentification"), nullptr);
+    //Start the identificationInfo and BAG_DataIdentification elements.
+    writer.startElement("gmd:identificationInfo");
+    writer.startElement("bag:BAG_DataIdentification");
 
     //Citation
     {
-        //Create the citation node.
-        xmlNode *pCitationNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("citation"), nullptr);
+        writer.startElement("gmd:citation");
 
         //Add the citation info.
-        const bool ret = addCitation(*pCitationNode, identificationInfo.title,
+        const bool ret = addCitation(writer, identificationInfo.title,
             identificationInfo.date,
             identificationInfo.dateType,
             identificationInfo.responsibleParties,
             identificationInfo.numberOfResponsibleParties);
         if (!ret)
             return false;
+
+        writer.endElement();
     }
 
     //Abstract
-    {
-        //Add the abstract.
-        xmlNode *pAbstractNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("abstract"), nullptr);
-
-        //Set the value.
-        addCharacterNode(*pAbstractNode, identificationInfo.abstractString);
-    }
+    writer.startElement("gmd:abstract");
+    addCharacterNode(writer, identificationInfo.abstractString);
+    writer.endElement();
 
     //Status (Optional)
     if (identificationInfo.status != nullptr)
     {
-        //Add the status.
-        xmlNode *pStatusNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("status"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pStatusNode, "gmd", "MD_ProgressCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", identificationInfo.status);
+        writer.startElement("gmd:status");
+        addCodeListNode(writer, "gmd", "MD_ProgressCode", kGmxCodelists,
+            identificationInfo.status);
+        writer.endElement();
     }
 
     //spatialRepresentationType (Optional)
     if (identificationInfo.spatialRepresentationType != nullptr)
     {
-        //Add the spatialRepresentationType.
-        xmlNode *pTypeNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("spatialRepresentationType"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pTypeNode, "gmd", "MD_SpatialRepresentationTypeCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", identificationInfo.spatialRepresentationType);
+        writer.startElement("gmd:spatialRepresentationType");
+        addCodeListNode(writer, "gmd", "MD_SpatialRepresentationTypeCode",
+            kGmxCodelists, identificationInfo.spatialRepresentationType);
+        writer.endElement();
     }
 
     //language
-    {
-        //Add the language.
-        xmlNode *pLanguageNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("language"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pLanguageNode, "gmd", "LanguageCode",
-            "http://www.loc.gov/standards/iso639-2/", identificationInfo.language, false);
-    }
+    writer.startElement("gmd:language");
+    addCodeListNode(writer, "gmd", "LanguageCode", kLanguageCodelist,
+        identificationInfo.language, false);
+    writer.endElement();
 
     //characterSet
-    {
-        //Add the characterSet.
-        xmlNode *pCharacterNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("characterSet"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pCharacterNode, "gmd", "MD_CharacterSetCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", identificationInfo.characterSet);
-    }
+    writer.startElement("gmd:characterSet");
+    addCodeListNode(writer, "gmd", "MD_CharacterSetCode", kGmxCodelists,
+        identificationInfo.characterSet);
+    writer.endElement();
 
     //topicCategory
     {
-        //Add the topicCategory.
-        xmlNode *pTopicNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("topicCategory"), nullptr);
+        writer.startElement("gmd:topicCategory");
 
-        //Create the MD_TopicCategoryCode node.
-        xmlNode *pCodeNode = xmlNewChild(pTopicNode, pGmdNamespace, XMLCast("MD_TopicCategoryCode"),
-            EncodedString(*parentNode.doc, identificationInfo.topicCategory));
+        //The MD_TopicCategoryCode element holds the value, then the code.
+        writer.startElement("gmd:MD_TopicCategoryCode");
+        writer.text(identificationInfo.topicCategory);
+        addCodeListNode(writer, "gmd", "MD_TopicCategoryCode", kGmxCodelists,
+            identificationInfo.topicCategory);
+        writer.endElement();
 
-        //Set the value.
-        addCodeListNode(*pCodeNode, "gmd", "MD_TopicCategoryCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", identificationInfo.topicCategory);
+        writer.endElement();
     }
 
     //extent (Optional)
@@ -588,93 +670,84 @@ bool addDataIdentification(xmlNode &parentNode, const BagIdentification &identif
          identificationInfo.southBoundingLatitude != double(INIT_VALUE) &&
          identificationInfo.northBoundingLatitude != double(INIT_VALUE) )
     {
-        //Add the extent.
-        xmlNode *pExtentNode = xmlNewChild(pBagIdentInfoNode, pGmdNamespace, XMLCast("extent"), nullptr);
-
-        //Add the EX_Extent
-        xmlNode *pExtentNode2 = xmlNewChild(pExtentNode, pGmdNamespace, XMLCast("EX_Extent"), nullptr);
+        writer.startElement("gmd:extent");
+        writer.startElement("gmd:EX_Extent");
+        writer.startElement("gmd:geographicElement");
+        writer.startElement("gmd:EX_GeographicBoundingBox");
 
-        //Add the geographicElement
-        xmlNode *pGeoNode = xmlNewChild(pExtentNode2, pGmdNamespace, XMLCast("geographicElement"), nullptr);
+        writer.startElement("gmd:westBoundLongitude");
+        addDecimalNode(writer, identificationInfo.westBoundingLongitude);
+        writer.endElement();
 
-        //Add the EX_GeographicBoundingBox
-        xmlNode *pGeoNode2 = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("EX_GeographicBoundingBox"), nullptr);
+        writer.startElement("gmd:eastBoundLongitude");
+        addDecimalNode(writer, identificationInfo.eastBoundingLongitude);
+        writer.endElement();
 
-        //Add the westBoundLongitude
-        xmlNode *pCoordNode = xmlNewChild(pGeoNode2, pGmdNamespace, XMLCast("westBoundLongitude"), nullptr);
-        addDecimalNode(*pCoordNode, identificationInfo.westBoundingLongitude);
+        writer.startElement("gmd:southBoundLatitude");
+        addDecimalNode(writer, identificationInfo.southBoundingLatitude);
+        writer.endElement();
 
-        //Add the eastBoundLongitude
-        pCoordNode = xmlNewChild(pGeoNode2, pGmdNamespace, XMLCast("eastBoundLongitude"), nullptr);
-        addDecimalNode(*pCoordNode, identificationInfo.eastBoundingLongitude);
+        writer.startElement("gmd:northBoundLatitude");
+        addDecimalNode(writer, identificationInfo.northBoundingLatitude);
+        writer.endElement();
 
-        //Add the southBoundLatitude
-        pCoordNode = xmlNewChild(pGeoNode2, pGmdNamespace, XMLCast("southBoundLatitude"), nullptr);
-        addDecimalNode(*pCoordNode, identificationInfo.southBoundingLatitude);
-
-        //Add the northBoundLatitude
-        pCoordNode = xmlNewChild(pGeoNode2, pGmdNamespace, XMLCast("northBoundLatitude"), nullptr);
-        addDecimalNode(*pCoordNode, identificationInfo.northBoundingLatitude);
+        writer.endElement();
+        writer.endElement();
+        writer.endElement();
+        writer.endElement();
     }
 
     //verticalUncertaintyType
-    {
-        //Add the verticalUncertaintyType.
-        xmlNode *pVertUncertNode = xmlNewChild(pBagIdentInfoNode, pBagNamespace, XMLCast("verticalUncertaintyType"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pVertUncertNode, "bag", "BAG_VertUncertCode",
-            "http://www.opennavsurf.org/schema/bag/bagCodelists.xml", (const char*)identificationInfo.verticalUncertaintyType);
-    }
+    writer.startElement("bag:verticalUncertaintyType");
+    addCodeListNode(writer, "bag", "BAG_VertUncertCode", kBagCodelists,
+        identificationInfo.verticalUncertaintyType);
+    writer.endElement();
 
     //depthCorrectionType (Optional)
     if (identificationInfo.depthCorrectionType != nullptr)
     {
-        //Add the depthCorrectionType.
-        xmlNode *pDepthCorrNode = xmlNewChild(pBagIdentInfoNode, pBagNamespace, XMLCast("depthCorrectionType"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pDepthCorrNode, "bag", "BAG_DepthCorrectCode",
-            "http://www.opennavsurf.org/schema/bag/bagCodelists.xml", (const char*)identificationInfo.depthCorrectionType);
+        writer.startElement("bag:depthCorrectionType");
+        addCodeListNode(writer, "bag", "BAG_DepthCorrectCode", kBagCodelists,
+            identificationInfo.depthCorrectionType);
+        writer.endElement();
     }
 
     //elevationSolutionGroupType (Optional)
     if (identificationInfo.elevationSolutionGroupType != nullptr)
     {
-        //Add the depthCorrectionType.
-        xmlNode *pElevNode = xmlNewChild(pBagIdentInfoNode, pBagNamespace, XMLCast("elevationSolutionGroupType"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pElevNode, "bag", "BAG_OptGroupCode",
-            "http://www.opennavsurf.org/schema/bag/bagCodelists.xml", (const char*)identificationInfo.elevationSolutionGroupType);
+        writer.startElement("bag:elevationSolutionGroupType");
+        addCodeListNode(writer, "bag", "BAG_OptGroupCode", kBagCodelists,
+            identificationInfo.elevationSolutionGroupType);
+        writer.endElement();
     }
 
     //nodeGroupType (Optional)
     if (identificationInfo.nodeGroupType != nullptr)
     {
-        //Add the depthCorrectionType.
-        xmlNode *pNodeGroupNode = xmlNewChild(pBagIdentInfoNode, pBagNamespace, XMLCast("nodeGroupType"), nullptr);
-
-        //Set the value.
-        addCodeListNode(*pNodeGroupNode, "bag", "BAG_OptGroupCode",
-            "http://www.opennavsurf.org/schema/bag/bagCodelists.xml", (const char*)identificationInfo.nodeGroupType);
+        writer.startElement("bag:nodeGroupType");
+        addCodeListNode(writer, "bag", "BAG_OptGroupCode", kBagCodelists,
+            identificationInfo.nodeGroupType);
+        writer.endElement();
     }
 
+    writer.endElement();
+    writer.endElement();
+
     return true;
 }
 
 //************************************************************************
-//! Add the BagSecurityConstraints information to the parent XML node.
+//! Add the BagSecurityConstraints information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param securityConstraints
-    \li The security constraint information to be added to \e parentNode
+    \li The security constraint information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addSecurityConstraints(xmlNode &parentNode, const BagSecurityConstraints &securityConstraints)
+bool addSecurityConstraints(XmlWriter &writer, const BagSecurityConstraints &securityConstraints)
 {
     /* If either the classification or the distribution statement is not supplied, the node should not be created.*/
     if (securityConstraints.classification == nullptr ||
@@ -684,90 +757,74 @@ bool addSecurityConstraints(xmlNode &parentNode, const BagSecurityConstraints &s
         return false;
     }
 
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    //Create the metadataConstraints node.
-    xmlNode *pConstraintNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("metadataConstraints"), nullptr);
-
-    //Create the MD_SecurityConstraints node.
-    xmlNode *pConstraintNode2 = xmlNewChild(pConstraintNode, pGmdNamespace, XMLCast("MD_SecurityConstraints"), nullptr);
+    //Start the metadataConstraints and MD_SecurityConstraints elements.
+    writer.startElement("gmd:metadataConstraints");
+    writer.startElement("gmd:MD_SecurityConstraints");
 
     //classification
-    {
-        //Create the title node.
-        xmlNode *pNode = xmlNewChild(pConstraintNode2, pGmdNamespace, XMLCast("classification"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_ClassificationCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", (char*)securityConstraints.classification);
-    }
+    writer.startElement("gmd:classification");
+    addCodeListNode(writer, "gmd", "MD_ClassificationCode", kGmxCodelists,
+        securityConstraints.classification);
+    writer.endElement();
 
     //userNote
-    {
-        //Create the title node.
-        xmlNode *pNode = xmlNewChild(pConstraintNode2, pGmdNamespace, XMLCast("userNote"), nullptr);
+    writer.startElement("gmd:userNote");
+    addCharacterNode(writer, securityConstraints.userNote);
+    writer.endElement();
 
-        //Set the title value.
-        addCharacterNode(*pNode, (char*)securityConstraints.userNote);
-    }
+    writer.endElement();
+    writer.endElement();
 
     return true;
 }
 
 //************************************************************************
-//! Add the BagLegalConstraints information to the parent XML node.
+//! Add the BagLegalConstraints information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param legalConstraints
-    \li The legal constraint information to be added to \e parentNode
+    \li The legal constraint information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addLegalConstraints(xmlNode &parentNode, const BagLegalConstraints &legalConstraints)
+bool addLegalConstraints(XmlWriter &writer, const BagLegalConstraints &legalConstraints)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    //Create the metadataConstraints node.
-    xmlNode *pConstraintNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("metadataConstraints"), nullptr);
-
-    //Create the MD_LegalConstraints node.
-    xmlNode *pConstraintNode2 = xmlNewChild(pConstraintNode, pGmdNamespace, XMLCast("MD_LegalConstraints"), nullptr);
+    //Start the metadataConstraints and MD_LegalConstraints elements.
+    writer.startElement("gmd:metadataConstraints");
+    writer.startElement("gmd:MD_LegalConstraints");
 
     //useConstraints
-    {
-        //Create the useConstraints node.
-        xmlNode *pNode = xmlNewChild(pConstraintNode2, pGmdNamespace, XMLCast("useConstraints"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_RestrictionCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", (char*)legalConstraints.useConstraints);
-    }
+    writer.startElement("gmd:useConstraints");
+    addCodeListNode(writer, "gmd", "MD_RestrictionCode", kGmxCodelists,
+        legalConstraints.useConstraints);
+    writer.endElement();
 
     //otherConstraints
-    {
-        //Create the title node.
-        xmlNode *pNode = xmlNewChild(pConstraintNode2, pGmdNamespace, XMLCast("otherConstraints"), nullptr);
+    writer.startElement("gmd:otherConstraints");
+    addCharacterNode(writer, legalConstraints.otherConstraints);
+    writer.endElement();
 
-        //Set the title value.
-        addCharacterNode(*pNode, (char*)legalConstraints.otherConstraints);
-    }
+    writer.endElement();
+    writer.endElement();
 
     return true;
 }
 
 //************************************************************************
-//! Add the BagSource information to the parent XML node.
+//! Add the BagSource information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param source
-    \li The process source information to be added to \e parentNode
+    \li The process source information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addProcessSource(xmlNode &parentNode, const BagSource &source)
+bool addProcessSource(XmlWriter &writer, const BagSource &source)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
     //The description is required.
     if (source.description == nullptr)
     {
@@ -775,155 +832,153 @@ bool addProcessSource(xmlNode &parentNode, const BagSource &source)
         return false;
     }
 
-    //Create the source node.
-    xmlNode *pSourceNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("source"), nullptr);
-
-    //Create the LI_Source node.
-    xmlNode *pSourceNode2 = xmlNewChild(pSourceNode, pGmdNamespace, XMLCast("LI_Source"), nullptr);
+    //Start the source and LI_Source elements.
+    writer.startElement("gmd:source");
+    writer.startElement("gmd:LI_Source");
 
     //description
-    {
-        //Create the description node.
-        xmlNode *pNode = xmlNewChild(pSourceNode2, pGmdNamespace, XMLCast("description"), nullptr);
-
-        //Set the title value.
-        addCharacterNode(*pNode, (char*)source.description);
-    }
+    writer.startElement("gmd:description");
+    addCharacterNode(writer, source.description);
+    writer.endElement();
 
     //sourceCitation
     {
-        //Create the sourceCitation node.
-        xmlNode *pNode = xmlNewChild(pSourceNode2, pGmdNamespace, XMLCast("sourceCitation"), nullptr);
+        writer.startElement("gmd:sourceCitation");
 
-        const bool ret = addCitation(*pNode, (char*)source.title, (char*)source.date, (char*)source.dateType,
+        const bool ret = addCitation(writer, source.title, source.date, source.dateType,
             source.responsibleParties, source.numberOfResponsibleParties);
         if (!ret)
             return false;
+
+        writer.endElement();
     }
 
+    writer.endElement();
+    writer.endElement();
+
     return true;
 }
 
 //************************************************************************
-//! Add the BagProcessStep information to the parent XML node.
+//! Add the BagProcessStep information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param processInfo
-    \li The process step information to be added to \e parentNode
+    \li The process step information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addProcessStep(xmlNode &parentNode, const BagProcessStep &processInfo)
+bool addProcessStep(XmlWriter &writer, const BagProcessStep &processInfo)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-    const xmlNsPtr pBagNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("bag"));
-
-    xmlNode *pProcessStepNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("processStep"), nullptr);
-    pProcessStepNode = xmlNewChild(pProcessStepNode, pBagNamespace, XMLCast("BAG_ProcessStep"), nullptr);
+    //Start the processStep and BAG_ProcessStep elements.
+    writer.startElement("gmd:processStep");
+    writer.startElement("bag:BAG_ProcessStep");
 
     //description
-    {
-        //Create the description node.
-        xmlNode *pNode = xmlNewChild(pProcessStepNode, pGmdNamespace, XMLCast("description"), nullptr);
-        addCharacterNode(*pNode, (char*)processInfo.description);
-    }
+    writer.startElement("gmd:description");
+    addCharacterNode(writer, processInfo.description);
+    writer.endElement();
 
     //dateTime
-    {
-        //Create the dateTime node.
-        xmlNode *pNode = xmlNewChild(pProcessStepNode, pGmdNamespace, XMLCast("dateTime"), nullptr);
-        addDateTimeNode(*pNode, (char*)processInfo.dateTime);
-    }
+    writer.startElement("gmd:dateTime");
+    addDateTimeNode(writer, processInfo.dateTime);
+    writer.endElement();
 
     //processor
     for (uint32_t i = 0; i < processInfo.numberOfProcessors; i++)
     {
-        //Create the processor node.
-        xmlNode *pNode = xmlNewChild(pProcessStepNode, pGmdNamespace, XMLCast("processor"), nullptr);
-        addResponsibleParty(*pNode, processInfo.processors[i]);
+        writer.startElement("gmd:processor");
+        addResponsibleParty(writer, processInfo.processors[i]);
+        writer.endElement();
     }
 
     //source
     for (uint32_t i = 0; i < processInfo.numberOfSources; i++)
     {
-        const bool ret = addProcessSource(*pProcessStepNode, processInfo.lineageSources[i]);
+        const bool ret = addProcessSource(writer, processInfo.lineageSources[i]);
         if (!ret)
             return false;
     }
 
     //trackingId
-    {
-        //Create the trackingId node.
-        xmlNode *pNode = xmlNewChild(pProcessStepNode, pBagNamespace, XMLCast("trackingId"), nullptr);
-        addCharacterNode(*pNode, (char*)processInfo.trackingId);
-    }
+    writer.startElement("bag:trackingId");
+    addCharacterNode(writer, processInfo.trackingId);
+    writer.endElement();
+
+    writer.endElement();
+    writer.endElement();
 
     return true;
 }
 
 //************************************************************************
-//! Add the BagDataQuality information to the parent XML node.
+//! Add the BagDataQuality information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param dataQuality
-    \li The data quality information to be added to \e parentNode
+    \li The data quality information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addDataQuality(xmlNode &parentNode, const BagDataQuality &dataQuality)
+bool addDataQuality(XmlWriter &writer, const BagDataQuality &dataQuality)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-
-    //Create the dataQualityInfo node.
-    xmlNode *pQualityNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("dataQualityInfo"), nullptr);
-
-    //Create the DQ_DataQuality node.
-    xmlNode *pQualityNode2 = xmlNewChild(pQualityNode, pGmdNamespace, XMLCast("DQ_DataQuality"), nullptr);
+    //Start the dataQualityInfo and DQ_DataQuality elements.
+    writer.startElement("gmd:dataQualityInfo");
+    writer.startElement("gmd:DQ_DataQuality");
 
     //scope
     {
-        xmlNode *pNode = xmlNewChild(pQualityNode2, pGmdNamespace, XMLCast("scope"), nullptr);
-        pNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("DQ_Scope"), nullptr);
-        pNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("level"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_ScopeCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", (char*)dataQuality.scope);
+        writer.startElement("gmd:scope");
+        writer.startElement("gmd:DQ_Scope");
+        writer.startElement("gmd:level");
+        addCodeListNode(writer, "gmd", "MD_ScopeCode", kGmxCodelists,
+            dataQuality.scope);
+        writer.endElement();
+        writer.endElement();
+        writer.endElement();
     }
 
     //lineage
     {
-        xmlNode *pLineageNode = xmlNewChild(pQualityNode2, pGmdNamespace, XMLCast("lineage"), nullptr);
-        pLineageNode = xmlNewChild(pLineageNode, pGmdNamespace, XMLCast("LI_Lineage"), nullptr);
+        writer.startElement("gmd:lineage");
+        writer.startElement("gmd:LI_Lineage");
 
         //Add each process step.
         for (uint32_t i = 0; i < dataQuality.numberOfProcessSteps; i++)
         {
-            const bool ret = addProcessStep(*pLineageNode, dataQuality.lineageProcessSteps[i]);
+            const bool ret = addProcessStep(writer, dataQuality.lineageProcessSteps[i]);
             if (!ret)
                 return false;
         }
+
+        writer.endElement();
+        writer.endElement();
     }
 
+    writer.endElement();
+    writer.endElement();
+
     return true;
 }
 
 //************************************************************************
-//! Add the BagSpatialRepresentation information to the parent XML node.
+//! Add the BagSpatialRepresentation information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param spatialRepresentationInfo
-    \li The spatial representation information to be added to \e parentNode
+    \li The spatial representation information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addSpatialRepresentation(xmlNode &parentNode, const BagSpatialRepresentation &spatialRepresentationInfo)
+bool addSpatialRepresentation(XmlWriter &writer, const BagSpatialRepresentation &spatialRepresentationInfo)
 {
-    /* Check for required elements. If do not exist, return nullptr*/
+    /* Check for required elements. If do not exist, return false*/
 
     /* Must have specified cellGeometry, transformationParameterAvailability,and checkPointAvailability */
     /* If any of the four corner points equal the INIT_VALUE, this indicates the points have not been populated by the user. */
@@ -945,265 +1000,207 @@ bool addSpatialRepresentation(xmlNode &parentNode, const BagSpatialRepresentatio
 
     }
 
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-    const xmlNsPtr pGmlNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gml"));
-
-    //Create the spatialRepresentationInfo node.
-    xmlNode *pSpatialRepNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("spatialRepresentationInfo"), nullptr);
-
-    //Create the MD_Georectified node.
-    xmlNode *pGeoNode = xmlNewChild(pSpatialRepNode, pGmdNamespace, XMLCast("MD_Georectified"), nullptr);
+    //Start the spatialRepresentationInfo and MD_Georectified elements.
+    writer.startElement("gmd:spatialRepresentationInfo");
+    writer.startElement("gmd:MD_Georectified");
 
     //numberOfDimensions
-    {
-        xmlNode *pNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("numberOfDimensions"), nullptr);
-        addIntegerNode(*pNode, 2);
-    }
+    writer.startElement("gmd:numberOfDimensions");
+    addIntegerNode(writer, 2);
+    writer.endElement();
 
     //axisDimensionProperties
-    addDimension(*pGeoNode, "row", spatialRepresentationInfo.numberOfRows, spatialRepresentationInfo.rowResolution,
+    addDimension(writer, "row", spatialRepresentationInfo.numberOfRows, spatialRepresentationInfo.rowResolution,
         spatialRepresentationInfo.resolutionUnit);
-    addDimension(*pGeoNode, "column", spatialRepresentationInfo.numberOfColumns, spatialRepresentationInfo.columnResolution,
+    addDimension(writer, "column", spatialRepresentationInfo.numberOfColumns, spatialRepresentationInfo.columnResolution,
         spatialRepresentationInfo.resolutionUnit);
 
     //cellGeometry
-    {
-        xmlNode *pNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("cellGeometry"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_CellGeometryCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml", (char*)spatialRepresentationInfo.cellGeometry);
-    }
+    writer.startElement("gmd:cellGeometry");
+    addCodeListNode(writer, "gmd", "MD_CellGeometryCode", kGmxCodelists,
+        spatialRepresentationInfo.cellGeometry);
+    writer.endElement();
 
     //transformationParameterAvailability
-    {
-        xmlNode *pNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("transformationParameterAvailability"), nullptr);
-        addBooleanNode(*pNode, spatialRepresentationInfo.transformationParameterAvailability);
-    }
+    writer.startElement("gmd:transformationParameterAvailability");
+    addBooleanNode(writer, spatialRepresentationInfo.transformationParameterAvailability);
+    writer.endElement();
 
     //checkPointAvailability
-    {
-        xmlNode *pNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("checkPointAvailability"), nullptr);
-        addBooleanNode(*pNode, spatialRepresentationInfo.checkPointAvailability);
-    }
+    writer.startElement("gmd:checkPointAvailability");
+    addBooleanNode(writer, spatialRepresentationInfo.checkPointAvailability);
+    writer.endElement();
 
     //cornerPoints
     {
-        xmlNode *pCornerNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("cornerPoints"), nullptr);
+        writer.startElement("gmd:cornerPoints");
 
-        xmlNode *pPointNode = xmlNewChild(pCornerNode, pGmlNamespace, XMLCast("Point"), nullptr);
-        xmlSetProp(pPointNode, XMLCast("gml:id"), XMLCast("id1"));
+        writer.startElement("gml:Point");
+        writer.attribute("gml:id", "id1");
 
-        char pointsString[88];
-        sprintf(pointsString, "%.12lf,%.12lf %.12lf,%.12lf", spatialRepresentationInfo.llCornerX, spatialRepresentationInfo.llCornerY, spatialRepresentationInfo.urCornerX, spatialRepresentationInfo.urCornerY);
+        char pointsString[256];
+        snprintf(pointsString, sizeof(pointsString), "%.12lf,%.12lf %.12lf,%.12lf", spatialRepresentationInfo.llCornerX, spatialRepresentationInfo.llCornerY, spatialRepresentationInfo.urCornerX, spatialRepresentationInfo.urCornerY);
 
-        xmlNode *pCoordNode = xmlNewChild(pPointNode, pGmlNamespace, XMLCast("coordinates"), EncodedString(*parentNode.doc, pointsString));
-        xmlSetProp(pCoordNode, XMLCast("decimal"), XMLCast("."));
-        xmlSetProp(pCoordNode, XMLCast("cs"), XMLCast(","));
-        xmlSetProp(pCoordNode, XMLCast("ts"), XMLCast(" "));
+        writer.startElement("gml:coordinates");
+        writer.attribute("decimal", ".");
+        writer.attribute("cs", ",");
+        writer.attribute("ts", " ");
+        writer.text(pointsString);
+        writer.endElement();
+
+        writer.endElement();
+        writer.endElement();
     }
 
     //pointInPixel
-    {
-        xmlNode *pNode = xmlNewChild(pGeoNode, pGmdNamespace, XMLCast("pointInPixel"), nullptr);
-        xmlNewChild(pNode, pGmdNamespace, XMLCast("MD_PixelOrientationCode"), XMLCast("center"));
-    }
+    writer.startElement("gmd:pointInPixel");
+    writer.element("gmd:MD_PixelOrientationCode", "center");
+    writer.endElement();
+
+    writer.endElement();
+    writer.endElement();
 
     return true;
 }
 
 //************************************************************************
-//! Add the BagReferenceSystem information to the parent XML node.
+//! Add the BagReferenceSystem information.
 /*!
-\param parentNode
-    \li The parent XML node to be modified.
+\param writer
+    \li The writer to add the information to.
 \param system
-    \li The reference system information to be added to \e parentNode
+    \li The reference system information to be added.
 \return
     \li True if the structure is added, False if an error occurs.
 */
 //************************************************************************
-bool addReferenceSystem(xmlNode &parentNode, const BagReferenceSystem &system)
+bool addReferenceSystem(XmlWriter &writer, const BagReferenceSystem &system)
 {
-    const xmlNsPtr pGmdNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gmd"));
-    //const xmlNsPtr pGcoNamespace = xmlSearchNs(parentNode.doc, &parentNode, XMLCast("gco"));
+    writer.startElement("gmd:referenceSystemInfo");
+    writer.startElement("gmd:MD_ReferenceSystem");
+    writer.startElement("gmd:referenceSystemIdentifier");
+    writer.startElement("gmd:RS_Identifier");
 
-    xmlNode *pNode = xmlNewChild(&parentNode, pGmdNamespace, XMLCast("referenceSystemInfo"), nullptr);
-    pNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("MD_ReferenceSystem"), nullptr);
-    pNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("referenceSystemIdentifier"), nullptr);
-    pNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("RS_Identifier"), nullptr);
+    writer.startElement("gmd:code");
+    addCharacterNode(writer, system.definition);
+    writer.endElement();
 
-    xmlNode *pCodeNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("code"), nullptr);
-    addCharacterNode(*pCodeNode, system.definition);
+    writer.startElement("gmd:codeSpace");
+    addCharacterNode(writer, system.type);
+    writer.endElement();
 
-    xmlNode *pCodeNameNode = xmlNewChild(pNode, pGmdNamespace, XMLCast("codeSpace"), nullptr);
-    addCharacterNode(*pCodeNameNode, system.type);
+    writer.endElement();
+    writer.endElement();
+    writer.endElement();
+    writer.endElement();
 
     return true;
 }
 
+}  // namespace
+
 //************************************************************************
 //! Export the Metadata to a string.
 /*!
+    The XML is written straight into the string as the metadata is walked,
+    without building a document first.
+
 \param metadata
     \li The metadata information to be exported.
 \return
     \li The metadata as XML in a string.
+    \li An empty string if the metadata is missing a required value.
 */
 //************************************************************************
 std::string exportMetadataToXML(
     const BagMetadata& metadata)
 {
-    //Create a new xml document.
-    xmlDoc *pDocument = createNewDocument();
+    std::string result;
+    result.reserve(kInitialXMLCapacity);
+    result += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
 
-    //Get the document's root node.
-    xmlNode *pRoot = xmlDocGetRootElement(pDocument);
+    XmlWriter writer{result};
 
-    //Add the fileIdentifier
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
+    //Start the root element.
+    startDocument(writer);
 
-        //Create the fileIdentifier node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("fileIdentifier"), nullptr);
-        addCharacterNode(*pNode, metadata.fileIdentifier);
-    }
+    //Add the fileIdentifier
+    writer.startElement("gmd:fileIdentifier");
+    addCharacterNode(writer, metadata.fileIdentifier);
+    writer.endElement();
 
     //Add the language
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the language node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("language"), nullptr);
-        addCodeListNode(*pNode, "gmd", "LanguageCode",
-            "http://www.loc.gov/standards/iso639-2/", metadata.language, false);
-    }
+    writer.startElement("gmd:language");
+    addCodeListNode(writer, "gmd", "LanguageCode", kLanguageCodelist,
+        metadata.language, false);
+    writer.endElement();
 
     //Add the characterSet
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the characterSet node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("characterSet"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_CharacterSetCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml",
-            metadata.characterSet);
-    }
+    writer.startElement("gmd:characterSet");
+    addCodeListNode(writer, "gmd", "MD_CharacterSetCode", kGmxCodelists,
+        metadata.characterSet);
+    writer.endElement();
 
     //Add the hierarchyLevel.
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the hierarchyLevel node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("hierarchyLevel"), nullptr);
-        addCodeListNode(*pNode, "gmd", "MD_ScopeCode",
-            "http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml",
-            metadata.hierarchyLevel);
-    }
+    writer.startElement("gmd:hierarchyLevel");
+    addCodeListNode(writer, "gmd", "MD_ScopeCode", kGmxCodelists,
+        metadata.hierarchyLevel);
+    writer.endElement();
 
     //Add the contact
-    {
-         const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the characterSet node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("contact"), nullptr);
-        if (!addResponsibleParty(*pNode, *metadata.contact))
-        {
-            xmlFreeDoc(pDocument);
-            return {};
-        }
-    }
+    writer.startElement("gmd:contact");
+    if (!addResponsibleParty(writer, *metadata.contact))
+        return {};
+    writer.endElement();
 
     //Add the dateStamp
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the hierarchyLevel node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("dateStamp"), nullptr);
-        addDateNode(*pNode, metadata.dateStamp);
-    }
+    writer.startElement("gmd:dateStamp");
+    addDateNode(writer, metadata.dateStamp);
+    writer.endElement();
 
     //Add the metadataStandardName
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the metadataStandardName node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("metadataStandardName"), nullptr);
-        addCharacterNode(*pNode, metadata.metadataStandardName);
-    }
+    writer.startElement("gmd:metadataStandardName");
+    addCharacterNode(writer, metadata.metadataStandardName);
+    writer.endElement();
 
     //Add the metadataStandardVersion
-    {
-        const xmlNsPtr pGmdNamespace = xmlSearchNs(pDocument, pRoot, XMLCast("gmd"));
-
-        //Create the metadataStandardVersion node.
-        xmlNode *pNode = xmlNewChild(pRoot, pGmdNamespace, XMLCast("metadataStandardVersion"), nullptr);
-        addCharacterNode(*pNode, metadata.metadataStandardVersion);
-    }
+    writer.startElement("gmd:metadataStandardVersion");
+    addCharacterNode(writer, metadata.metadataStandardVersion);
+    writer.endElement();
 
     //Add the spatialRepresentationInfo
-    if (!addSpatialRepresentation(*pRoot, *metadata.spatialRepresentationInfo))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addSpatialRepresentation(writer, *metadata.spatialRepresentationInfo))
         return {};
-    }
 
     //Add the horizontal referenceSystemInfo
-    if (!addReferenceSystem(*pRoot, *metadata.horizontalReferenceSystem))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addReferenceSystem(writer, *metadata.horizontalReferenceSystem))
         return {};
-    }
 
     //Add the vertical referenceSystemInfo
-    if (!addReferenceSystem(*pRoot, *metadata.verticalReferenceSystem))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addReferenceSystem(writer, *metadata.verticalReferenceSystem))
         return {};
-    }
 
     //Add the data identification information.
-    if (!addDataIdentification(*pRoot, *metadata.identificationInfo))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addDataIdentification(writer, *metadata.identificationInfo))
         return {};
-    }
 
     //Add the data quality information.
-    if (!addDataQuality(*pRoot, *metadata.dataQualityInfo))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addDataQuality(writer, *metadata.dataQualityInfo))
         return {};
-    }
 
     //Add the legal constraint information.
-    if (!addLegalConstraints(*pRoot, *metadata.legalConstraints))
-    {
-        xmlFreeDoc(pDocument);
+    if (!addLegalConstraints(writer, *metadata.legalConstraints))
         return {};
-    }
 
     //Add the security constraint information.
-    if (!addSecurityConstraints(*pRoot, *metadata.securityConstraints))
-    {
-        xmlFreeDoc(pDocument);
-        return {};
-    }
-
-    //Export to the buffer.
-    int bufferSize = 0;
-    xmlChar *pBuffer = nullptr;
-    xmlDocDumpMemoryEnc(pDocument, &pBuffer, &bufferSize, "UTF-8");
-    xmlFreeDoc(pDocument);
-
-    //If nothing was exported, then just return.
-    if (bufferSize == 0)
+    if (!addSecurityConstraints(writer, *metadata.securityConstraints))
         return {};
 
-    //Copy the buffer to our output string and add a null terminator.
-    std::string result{reinterpret_cast<char*>(pBuffer), static_cast<size_t>(bufferSize)};
+    //End the root element.
+    writer.endElement();
+    result += '\n';
 
-    xmlFree(pBuffer);
     return result;
 }
 
 }  // namespace BAG
-
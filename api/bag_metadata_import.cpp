@@ -14,10 +14,14 @@
 #include <libxml/xmlschemas.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unordered_map>
 #include <vector>
 
 
@@ -29,6 +33,74 @@ static std::string bagHomeFolder;
 //! The relative path from the BAG home folder, to the Bag schema file.
 static std::string ons_schema_location = "ISO19139/bag/bag.xsd";
 
+//! A parsed schema, with the document and parser context it was parsed from.
+class ParsedSchema final
+{
+public:
+    //************************************************************************
+    //! Constructor; takes ownership of the schema, document and context.
+    /*!
+    \param pDocument
+        \li The schema document.
+    \param pContext
+        \li The parser context the schema was parsed with.
+    \param pSchema
+        \li The parsed schema.
+    */
+    //************************************************************************
+    ParsedSchema(
+        xmlDoc* pDocument,
+        xmlSchemaParserCtxt* pContext,
+        xmlSchema* pSchema) noexcept
+        : m_pDocument(pDocument)
+        , m_pContext(pContext)
+        , m_pSchema(pSchema)
+    {
+    }
+
+    ParsedSchema(const ParsedSchema&) = delete;
+    ParsedSchema(ParsedSchema&&) = delete;
+    ParsedSchema& operator=(const ParsedSchema&) = delete;
+    ParsedSchema& operator=(ParsedSchema&&) = delete;
+
+    //************************************************************************
+    //! Destructor.
+    //************************************************************************
+    ~ParsedSchema() noexcept
+    {
+        xmlSchemaFree(m_pSchema);
+        xmlSchemaFreeParserCtxt(m_pContext);
+        xmlFreeDoc(m_pDocument);
+    }
+
+    //************************************************************************
+    //! Retrieve the parsed schema.
+    /*!
+    \return
+        \li The parsed schema; it is not modified by validation, so it may be
+            used by several validation contexts at once.
+    */
+    //************************************************************************
+    xmlSchema* get() const noexcept
+    {
+        return m_pSchema;
+    }
+
+private:
+    //! The schema document.
+    xmlDoc* m_pDocument = nullptr;
+    //! The parser context the schema was parsed with.
+    xmlSchemaParserCtxt* m_pContext = nullptr;
+    //! The parsed schema.
+    xmlSchema* m_pSchema = nullptr;
+};
+
+//! The schemas parsed so far, by the full path of their main file.
+static std::map<std::string, std::shared_ptr<const ParsedSchema>> schemaCache;
+
+//! Guards schemaCache.
+static std::mutex schemaCacheMutex;
+
 //! Utility class to convert an encoded XML string.
 class EncodedString final
 {
@@ -78,6 +150,169 @@ private:
     xmlChar* m_pEncodedString = nullptr;
 };
 
+//! Frees a compiled XPath expression.
+struct DeleteCompiledExpression final
+{
+    void operator()(xmlXPathCompExpr* pExpression) const noexcept
+    {
+        xmlXPathFreeCompExpr(pExpression);
+    }
+};
+
+//! The compiled XPath expressions, by their text.  Prefixes are resolved
+//! when an expression is evaluated, so one compilation serves every document.
+static std::unordered_map<std::string,
+    std::unique_ptr<xmlXPathCompExpr, DeleteCompiledExpression>>
+    compiledExpressions;
+
+//! Guards compiledExpressions.
+static std::mutex compiledExpressionsMutex;
+
+//! An XPath context for a document, with the namespaces of its root node
+//! registered.
+class XPathContext final
+{
+public:
+    //************************************************************************
+    //! Constructor
+    /*!
+    \param doc
+        \li The XML document to search.
+    */
+    //************************************************************************
+    explicit XPathContext(xmlDoc& doc) noexcept
+        : m_pDocument(&doc)
+    {
+        //Get the root node of the document.
+        const xmlNode* pRoot = xmlDocGetRootElement(&doc);
+        if (!pRoot)
+            return;
+
+        m_pContext = xmlXPathNewContext(&doc);
+        if (!m_pContext)
+            return;
+
+        //Register any namespaces with the xPath context.
+        for (const xmlNs* xmlNameSpace = pRoot->nsDef; xmlNameSpace;
+            xmlNameSpace = xmlNameSpace->next)
+        {
+            if (!xmlNameSpace->prefix)
+                continue;
+
+            if (xmlXPathRegisterNs(m_pContext, xmlNameSpace->prefix,
+                xmlNameSpace->href) != 0)
+            {
+                xmlXPathFreeContext(m_pContext);
+                m_pContext = nullptr;
+                return;
+            }
+        }
+    }
+
+    XPathContext(const XPathContext&) = delete;
+    XPathContext(XPathContext&&) = delete;
+    XPathContext& operator=(const XPathContext&) = delete;
+    XPathContext& operator=(XPathContext&&) = delete;
+
+    //************************************************************************
+    //! Destructor.
+    //************************************************************************
+    ~XPathContext() noexcept
+    {
+        xmlXPathFreeContext(m_pContext);
+    }
+
+    //************************************************************************
+    //! Retrieve the document searched.
+    /*!
+    \return
+        \li The document searched.
+    */
+    //************************************************************************
+    const xmlDoc* document() const noexcept
+    {
+        return m_pDocument;
+    }
+
+    //************************************************************************
+    //! Retrieve the context.
+    /*!
+    \return
+        \li The context; nullptr if it could not be set up.
+    */
+    //************************************************************************
+    xmlXPathContext* get() const noexcept
+    {
+        return m_pContext;
+    }
+
+private:
+    //! The document searched.
+    const xmlDoc* m_pDocument = nullptr;
+    //! The context.
+    xmlXPathContext* m_pContext = nullptr;
+};
+
+//! The context of the document being imported on this thread, if any.
+static thread_local const XPathContext* pImportContext = nullptr;
+
+//! Makes a context the one used to search its document on this thread, while
+//! the document is imported.
+class ImportContextScope final
+{
+public:
+    //************************************************************************
+    //! Constructor
+    /*!
+    \param context
+        \li The context of the document being imported.
+    */
+    //************************************************************************
+    explicit ImportContextScope(const XPathContext& context) noexcept
+        : m_pPrevious(pImportContext)
+    {
+        pImportContext = &context;
+    }
+
+    ImportContextScope(const ImportContextScope&) = delete;
+    ImportContextScope(ImportContextScope&&) = delete;
+    ImportContextScope& operator=(const ImportContextScope&) = delete;
+    ImportContextScope& operator=(ImportContextScope&&) = delete;
+
+    //************************************************************************
+    //! Destructor.
+    //************************************************************************
+    ~ImportContextScope() noexcept
+    {
+        pImportContext = m_pPrevious;
+    }
+
+private:
+    //! The context in use before this one.
+    const XPathContext* m_pPrevious = nullptr;
+};
+
+//************************************************************************
+//! Get the compiled form of an XPath expression, compiling it on first use.
+/*!
+\param expression
+    \li The expression.
+\return
+    \li The compiled expression; nullptr if it does not compile.
+*/
+//************************************************************************
+xmlXPathCompExpr* getCompiledExpression(const char* expression)
+{
+    const std::lock_guard<std::mutex> lock{compiledExpressionsMutex};
+
+    auto& pCompiled = compiledExpressions[expression];
+    if (!pCompiled)
+        pCompiled.reset(xmlXPathCompile(
+            reinterpret_cast<const xmlChar*>(expression)));
+
+    return pCompiled.get();
+}
+
 //************************************************************************
 //! Convert a string to a double value.
 /*!
@@ -141,49 +376,30 @@ std::vector<xmlNode*> findNodes(
     xmlNode& relativeNode,
     const char* searchString)
 {
-    //Get the root node of the document.
-    const xmlNode* pRoot = xmlDocGetRootElement(relativeNode.doc);
-    if (!pRoot)
-        return {};
-
-    //If the xPath context has not been initialized yet, do it now.
-    xmlXPathContext* pContext = xmlXPathNewContext(relativeNode.doc);
-    if (!pContext)
-        return {};
-
-    pContext->node = &relativeNode;
-
-    //Register any namespaces with the xPath context.
-    const xmlNs* xmlNameSpace = pRoot->nsDef;
+    //Use the context of the document being imported, or make one.
+    const XPathContext* pContext = pImportContext;
+    std::unique_ptr<XPathContext> pLocalContext;
 
-    while (xmlNameSpace)
+    if (!pContext || pContext->document() != relativeNode.doc)
     {
-        if (xmlNameSpace->prefix)
-        {
-            const int ret = xmlXPathRegisterNs(pContext, xmlNameSpace->prefix,
-                xmlNameSpace->href);
-            if (ret != 0)
-            {
-                //Error
-                 xmlXPathFreeContext(pContext);
-                 return {};
-            }
-        }
-
-        xmlNameSpace = xmlNameSpace->next;
+        pLocalContext.reset(new XPathContext{*relativeNode.doc});
+        pContext = pLocalContext.get();
     }
 
-    //Encode the specified search string.
-    const EncodedString encodedSearch{*relativeNode.doc, searchString};
+    if (!pContext->get())
+        return {};
+
+    xmlXPathCompExpr* pExpression = getCompiledExpression(searchString);
+    if (!pExpression)
+        return {};
+
+    pContext->get()->node = &relativeNode;
 
     //Evaluate the expression.
-    xmlXPathObject* pPathObject = xmlXPathEvalExpression(encodedSearch, pContext);
+    xmlXPathObject* pPathObject = xmlXPathCompiledEval(pExpression,
+        pContext->get());
     if (!pPathObject)
-    {
-        //Error
-        xmlXPathFreeContext(pContext);
         return {};
-    }
 
     std::vector<xmlNode*> retList;
 
@@ -197,7 +413,6 @@ std::vector<xmlNode*> findNodes(
     }
 
     xmlXPathFreeObject(pPathObject);
-    xmlXPathFreeContext(pContext);
 
     return retList;
 }
@@ -476,6 +691,20 @@ void bagSetHomeFolder(const char* homeFolder)
     bagHomeFolder = homeFolder;
 }
 
+//************************************************************************
+//! Free the schemas kept by earlier metadata validations.
+/*!
+    The next validation parses its schema again; call this after changing
+    the schema files.  Validations in progress keep their schema until they
+    are done.
+*/
+//************************************************************************
+void bagClearSchemaCache()
+{
+    const std::lock_guard<std::mutex> lock{schemaCacheMutex};
+    schemaCache.clear();
+}
+
 //************************************************************************
 //! Decode a BagResponsibleParty from the supplied XML node.
 /*!
@@ -1380,6 +1609,9 @@ bool decodeReferenceSystemInfo(
 //************************************************************************
 //! Validate an XML document against the current BAG metadata schema.
 /*!
+    The schema is parsed on first use, and kept for later validations
+    until bagClearSchemaCache() is called.
+
 \param metadataDocument
     \li The document to be validated.
 \return
@@ -1400,53 +1632,70 @@ BagError validateSchema(xmlDoc& metadataDocument)
     schemaFile += "/";
     schemaFile += ons_schema_location;
 
-    // make sure the main schema file exists.
-    struct stat fStat;
-    if (stat(schemaFile.c_str(), &fStat))
-        return BAG_METADTA_SCHEMA_FILE_MISSING;
+    // Parsing the schema takes far longer than validating a document with
+    // it, so each schema is parsed once and kept.
+    std::shared_ptr<const ParsedSchema> pParsedSchema;
+    {
+        const std::lock_guard<std::mutex> lock{schemaCacheMutex};
+
+        auto& pCached = schemaCache[schemaFile];
+        if (!pCached)
+        {
+            // make sure the main schema file exists.
+            struct stat fStat;
+            if (stat(schemaFile.c_str(), &fStat))
+            {
+                schemaCache.erase(schemaFile);
+                return BAG_METADTA_SCHEMA_FILE_MISSING;
+            }
 
-    // Open the schema.
-    xmlDoc *pSchemaDoc = xmlParseFile(schemaFile.c_str());
-    if (!pSchemaDoc)
-        return BAG_METADTA_PARSE_FAILED;
+            // Open the schema.
+            xmlDoc *pSchemaDoc = xmlParseFile(schemaFile.c_str());
+            if (!pSchemaDoc)
+            {
+                schemaCache.erase(schemaFile);
+                return BAG_METADTA_PARSE_FAILED;
+            }
 
-    // Parse the schema.
-    xmlSchemaParserCtxt *pContext = xmlSchemaNewDocParserCtxt(pSchemaDoc);
-    if (!pContext)
-    {
-        xmlFreeDoc(pSchemaDoc);
+            // Parse the schema.
+            xmlSchemaParserCtxt *pContext = xmlSchemaNewDocParserCtxt(pSchemaDoc);
+            if (!pContext)
+            {
+                xmlFreeDoc(pSchemaDoc);
+                schemaCache.erase(schemaFile);
 
-        return BAG_METADTA_SCHEMA_SETUP_FAILED;
-    }
+                return BAG_METADTA_SCHEMA_SETUP_FAILED;
+            }
 
-    // Initialize the schema object.
-    xmlSchema *pSchema = xmlSchemaParse(pContext);
-    if (!pSchema)
-    {
-        xmlSchemaFreeParserCtxt(pContext);
-        xmlFreeDoc(pSchemaDoc);
+            // Initialize the schema object.
+            xmlSchema *pSchema = xmlSchemaParse(pContext);
+            if (!pSchema)
+            {
+                xmlSchemaFreeParserCtxt(pContext);
+                xmlFreeDoc(pSchemaDoc);
+                schemaCache.erase(schemaFile);
+
+                return BAG_METADTA_SCHEMA_SETUP_FAILED;
+            }
 
-        return BAG_METADTA_SCHEMA_SETUP_FAILED;
+            pCached = std::make_shared<const ParsedSchema>(pSchemaDoc,
+                pContext, pSchema);
+        }
+
+        // Held until the validation is done, even if the cache is cleared.
+        pParsedSchema = pCached;
     }
 
     // Create the validation object.
-    xmlSchemaValidCtxt *pValidationContext = xmlSchemaNewValidCtxt(pSchema);
+    xmlSchemaValidCtxt *pValidationContext =
+        xmlSchemaNewValidCtxt(pParsedSchema->get());
     if (!pValidationContext)
-    {
-        xmlSchemaFree(pSchema);
-        xmlSchemaFreeParserCtxt(pContext);
-        xmlFreeDoc(pSchemaDoc);
-
         return BAG_METADTA_SCHEMA_VALIDATION_SETUP_FAILED;
-    }
 
     // Validate the document.
     const int result = xmlSchemaValidateDoc(pValidationContext, &metadataDocument);
 
     xmlSchemaFreeValidCtxt(pValidationContext);
-    xmlSchemaFree(pSchema);
-    xmlSchemaFreeParserCtxt(pContext);
-    xmlFreeDoc(pSchemaDoc);
 
     return (result == 0) ? BAG_SUCCESS : BAG_METADTA_VALIDATE_FAILED;
 }
@@ -1799,6 +2048,10 @@ BagError bagImportMetadataFromXml(
     if (!pRoot)
         return BAG_METADTA_EMPTY_DOCUMENT;
 
+    // Every search of the document shares one XPath context.
+    const XPathContext context{document};
+    const ImportContextScope contextScope{context};
+
     if (doValidation)
     {
         const BagError ret = validateSchema(document);
@@ -1852,6 +2105,82 @@ BagError bagImportMetadataFromXmlBuffer(
     return bagImportMetadataFromXml(*pDocument, metadata, doValidation);
 }
 
+//************************************************************************
+//! Import the spatial parts of the BAG_METADATA from an XML buffer.
+/*!
+    Imports only the spatial representation and the horizontal and vertical
+    reference systems, which are what a Descriptor is made from, from a
+    'version 2' schema; nothing else is searched for.  A 'version 1' schema
+    is imported completely, as its reference systems depend on the rest of
+    it.
+
+\param xmlBuffer
+    \li The character buffer containing the XML document to be used for
+        import.  Input should not be NULL.
+\param bufferSize
+    \li The size in bytes of the \e xmlBuffer.
+\param metadata
+    \li Modified to contain the spatial BAG metadata information from
+        \e xmlBuffer.  Input should not be NULL.
+\return
+    \li BAG_SUCCESS if the information is successfully extracted from \e xmlBuffer,
+        an error code otherwise.
+*/
+//************************************************************************
+BagError bagImportSpatialMetadataFromXmlBuffer(
+    const char* xmlBuffer,
+    int bufferSize,
+    BagMetadata& metadata)
+{
+    std::unique_ptr<xmlDoc, void(*)(xmlDoc*)> pDocument{
+        xmlParseMemory(xmlBuffer, bufferSize), xmlFreeDoc};
+    if (!pDocument)
+        return BAG_METADTA_NOT_INITIALIZED;
+
+    auto* pRoot = xmlDocGetRootElement(pDocument.get());
+    if (!pRoot)
+        return BAG_METADTA_EMPTY_DOCUMENT;
+
+    const XPathContext context{*pDocument};
+    const ImportContextScope contextScope{context};
+
+    if (getNodeName(*pRoot) == "smXML:MD_Metadata")
+        return bagImportMetadataFromXmlV1(*pDocument, metadata);
+
+    //gmd:spatialRepresentationInfo
+    {
+        auto* pNode = findNode(*pRoot,
+            "/gmi:MI_Metadata/gmd:spatialRepresentationInfo/gmd:MD_Georectified/parent::*");
+        if (!pNode)
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+
+        if (!decodeSpatialRepresentationInfo(*pNode, *metadata.spatialRepresentationInfo, 2))
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+    }
+
+    //gmd:referenceSystemInfo (horizontal)
+    {
+        auto* pNode = findNode(*pRoot, "/gmi:MI_Metadata/gmd:referenceSystemInfo[1]");
+        if (!pNode)
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+
+        if (!decodeReferenceSystemInfo(*pNode, *metadata.horizontalReferenceSystem, 2))
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+    }
+
+    //gmd:referenceSystemInfo (vertical)
+    {
+        auto* pNode = findNode(*pRoot, "/gmi:MI_Metadata/gmd:referenceSystemInfo[2]");
+        if (!pNode)
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+
+        if (!decodeReferenceSystemInfo(*pNode, *metadata.verticalReferenceSystem, 2))
+            return BAG_METADTA_MISSING_MANDATORY_ITEM;
+    }
+
+    return BAG_SUCCESS;
+}
+
 //************************************************************************
 //! Import the BAG_METADATA from an XML file.
 /*!
@@ -11,8 +11,11 @@ BagError bagImportMetadataFromXmlFile(const char* fileName,
     BagMetadata& metadata, bool doValidation);
 BagError bagImportMetadataFromXmlBuffer(const char* xmlBuffer, int bufferSize,
     BagMetadata& metadata, bool doValidation);
+BagError bagImportSpatialMetadataFromXmlBuffer(const char* xmlBuffer,
+    int bufferSize, BagMetadata& metadata);
 
 void bagSetHomeFolder(const char* homeFolder);
+void bagClearSchemaCache();
 
 }  // namespace BAG
 
@@ -0,0 +1,312 @@
+
+#include "bag_minmax.h"
+
+#include <array>
+
+
+namespace BAG {
+
+namespace {
+
+//! The number of independent accumulators used by the reduction.
+/*!
+    Splitting the reduction across several lanes removes the loop carried
+    dependency on a single min/max pair, which lets the compiler keep the
+    lanes in vector registers (SSE/AVX/NEON) and the CPU overlap the compares.
+*/
+constexpr size_t kNumLanes = 8;
+
+//! Is the value one that should contribute to the min/max?
+inline bool isValid(
+    float value,
+    float nullValue) noexcept
+{
+    // NaN compares unequal to itself.
+    return value == value && value != nullValue;
+}
+
+inline bool isValid(
+    uint32_t value,
+    uint32_t nullValue) noexcept
+{
+    return value != nullValue;
+}
+
+//! Compute the min/max of every stride'th value, skipping nulls.
+/*!
+\param values
+    The first value.
+\param count
+    The number of values to look at.
+\param stride
+    The distance between consecutive values, in elements of T.
+\param nullValue
+    The value to ignore.
+
+\return
+    The min/max of the non null values; empty if there are none.
+*/
+template <typename T>
+MinMax<T> reduce(
+    const T* values,
+    size_t count,
+    size_t stride,
+    T nullValue) noexcept
+{
+    std::array<T, kNumLanes> mins;
+    std::array<T, kNumLanes> maxs;
+    mins.fill(std::numeric_limits<T>::max());
+    maxs.fill(std::numeric_limits<T>::lowest());
+
+    const size_t numBlocks = count / kNumLanes;
+    const T* value = values;
+
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+        for (size_t lane = 0; lane < kNumLanes; ++lane, value += stride)
+        {
+            const T v = *value;
+            const bool valid = isValid(v, nullValue);
+
+            // Branch free selects; these map onto vector blend/min/max.
+            mins[lane] = (valid && v < mins[lane]) ? v : mins[lane];
+            maxs[lane] = (valid && v > maxs[lane]) ? v : maxs[lane];
+        }
+    }
+
+    for (size_t index = numBlocks * kNumLanes; index < count;
+        ++index, value += stride)
+    {
+        const T v = *value;
+        const bool valid = isValid(v, nullValue);
+
+        mins[0] = (valid && v < mins[0]) ? v : mins[0];
+        maxs[0] = (valid && v > maxs[0]) ? v : maxs[0];
+    }
+
+    MinMax<T> result;
+    for (size_t lane = 0; lane < kNumLanes; ++lane)
+    {
+        result.min = mins[lane] < result.min ? mins[lane] : result.min;
+        result.max = maxs[lane] > result.max ? maxs[lane] : result.max;
+    }
+
+    return result;
+}
+
+//! Retrieve a typed pointer to a field of the first item.
+template <typename T, typename Item>
+const T* field(
+    const Item* items,
+    size_t offset) noexcept
+{
+    return reinterpret_cast<const T*>(
+        reinterpret_cast<const uint8_t*>(items) + offset);
+}
+
+//! The distance between items, in elements of T.
+template <typename T, typename Item>
+constexpr size_t strideOf() noexcept
+{
+    static_assert(sizeof(Item) % sizeof(T) == 0,
+        "item size must be a multiple of the field size");
+
+    return sizeof(Item) / sizeof(T);
+}
+
+}  // namespace
+
+//! Compute the min/max of float values, ignoring nulls and NaN.
+/*!
+\param values
+    The values.
+\param count
+    The number of values.
+\param stride
+    The distance between consecutive values, in floats.
+    Defaults to 1 (contiguous).
+\param nullValue
+    The value that marks a null.
+    Defaults to BAG_NULL_GENERIC.
+
+\return
+    The min/max of the non null values; empty if all values are null.
+*/
+MinMax<float> computeMinMax(
+    const float* values,
+    size_t count,
+    size_t stride,
+    float nullValue) noexcept
+{
+    return reduce(values, count, stride, nullValue);
+}
+
+//! Compute the min/max of unsigned 32 bit values, ignoring nulls.
+/*!
+\param values
+    The values.
+\param count
+    The number of values.
+\param stride
+    The distance between consecutive values, in uint32_t.
+    Defaults to 1 (contiguous).
+\param nullValue
+    The value that marks a null.
+    Defaults to BAG_NULL_GENERIC.
+
+\return
+    The min/max of the non null values; empty if all values are null.
+*/
+MinMax<uint32_t> computeMinMax(
+    const uint32_t* values,
+    size_t count,
+    size_t stride,
+    uint32_t nullValue) noexcept
+{
+    return reduce(values, count, stride, nullValue);
+}
+
+//! Compute the min/max of the depth and uncertainty of refinements.
+/*!
+\param items
+    The refinements.
+\param count
+    The number of refinements.
+
+\return
+    The min/max of the non null depths and uncertainties.
+*/
+VRRefinementsMinMax computeMinMax(
+    const BagVRRefinementsItem* items,
+    size_t count) noexcept
+{
+    constexpr auto stride = strideOf<float, BagVRRefinementsItem>();
+
+    VRRefinementsMinMax result;
+    result.depth = reduce(field<float>(items,
+        offsetof(BagVRRefinementsItem, depth)), count, stride,
+        static_cast<float>(BAG_NULL_ELEVATION));
+    result.uncertainty = reduce(field<float>(items,
+        offsetof(BagVRRefinementsItem, depth_uncrt)), count, stride,
+        static_cast<float>(BAG_NULL_UNCERTAINTY));
+
+    return result;
+}
+
+//! Compute the min/max of the fields of variable resolution nodes.
+/*!
+\param items
+    The nodes.
+\param count
+    The number of nodes.
+
+\return
+    The min/max of the non null hypotheses strengths, number of hypotheses
+    and number of samples.
+*/
+VRNodeMinMax computeMinMax(
+    const BagVRNodeItem* items,
+    size_t count) noexcept
+{
+    constexpr auto floatStride = strideOf<float, BagVRNodeItem>();
+    constexpr auto uint32Stride = strideOf<uint32_t, BagVRNodeItem>();
+
+    VRNodeMinMax result;
+    result.hypStrength = reduce(field<float>(items,
+        offsetof(BagVRNodeItem, hyp_strength)), count, floatStride,
+        static_cast<float>(BAG_NULL_GENERIC));
+    result.numHypotheses = reduce(field<uint32_t>(items,
+        offsetof(BagVRNodeItem, num_hypotheses)), count, uint32Stride,
+        static_cast<uint32_t>(BAG_NULL_GENERIC));
+    result.nSamples = reduce(field<uint32_t>(items,
+        offsetof(BagVRNodeItem, n_samples)), count, uint32Stride,
+        static_cast<uint32_t>(BAG_NULL_GENERIC));
+
+    return result;
+}
+
+//! Compute the min/max of the dimensions and resolutions of VR metadata.
+/*!
+\param items
+    The metadata items.
+\param count
+    The number of metadata items.
+
+\return
+    The min/max of the non null dimensions and resolutions.
+*/
+VRMetadataMinMax computeMinMax(
+    const BagVRMetadataItem* items,
+    size_t count) noexcept
+{
+    constexpr auto floatStride = strideOf<float, BagVRMetadataItem>();
+    constexpr auto uint32Stride = strideOf<uint32_t, BagVRMetadataItem>();
+
+    VRMetadataMinMax result;
+    result.dimX = reduce(field<uint32_t>(items,
+        offsetof(BagVRMetadataItem, dimensions_x)), count, uint32Stride,
+        static_cast<uint32_t>(BAG_NULL_GENERIC));
+    result.dimY = reduce(field<uint32_t>(items,
+        offsetof(BagVRMetadataItem, dimensions_y)), count, uint32Stride,
+        static_cast<uint32_t>(BAG_NULL_GENERIC));
+    result.resX = reduce(field<float>(items,
+        offsetof(BagVRMetadataItem, resolution_x)), count, floatStride,
+        static_cast<float>(BAG_NULL_GENERIC));
+    result.resY = reduce(field<float>(items,
+        offsetof(BagVRMetadataItem, resolution_y)), count, floatStride,
+        static_cast<float>(BAG_NULL_GENERIC));
+
+    return result;
+}
+
+//! Widen the min/max of the fields of refinements to include others.
+/*!
+\param into
+    The min/max to widen.
+\param from
+    The min/max to include.
+*/
+void merge(
+    VRRefinementsMinMax& into,
+    const VRRefinementsMinMax& from) noexcept
+{
+    from.depth.mergeInto(into.depth.min, into.depth.max);
+    from.uncertainty.mergeInto(into.uncertainty.min, into.uncertainty.max);
+}
+
+//! Widen the min/max of the fields of nodes to include others.
+/*!
+\param into
+    The min/max to widen.
+\param from
+    The min/max to include.
+*/
+void merge(
+    VRNodeMinMax& into,
+    const VRNodeMinMax& from) noexcept
+{
+    from.hypStrength.mergeInto(into.hypStrength.min, into.hypStrength.max);
+    from.numHypotheses.mergeInto(into.numHypotheses.min,
+        into.numHypotheses.max);
+    from.nSamples.mergeInto(into.nSamples.min, into.nSamples.max);
+}
+
+//! Widen the min/max of the fields of metadata items to include others.
+/*!
+\param into
+    The min/max to widen.
+\param from
+    The min/max to include.
+*/
+void merge(
+    VRMetadataMinMax& into,
+    const VRMetadataMinMax& from) noexcept
+{
+    from.dimX.mergeInto(into.dimX.min, into.dimX.max);
+    from.dimY.mergeInto(into.dimY.min, into.dimY.max);
+    from.resX.mergeInto(into.resX.min, into.resX.max);
+    from.resY.mergeInto(into.resY.min, into.resY.max);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,94 @@
+#ifndef BAG_MINMAX_H
+#define BAG_MINMAX_H
+
+#include "bag_c_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+
+namespace BAG {
+
+//! The running minimum and maximum of a set of values.
+/*!
+    A default constructed MinMax is empty (min > max), so merging it into an
+    existing range leaves that range unchanged.
+*/
+template <typename T>
+struct MinMax final
+{
+    //! The smallest value seen.
+    T min = std::numeric_limits<T>::max();
+    //! The largest value seen.
+    T max = std::numeric_limits<T>::lowest();
+
+    //! Were no (non null) values seen?
+    bool empty() const noexcept
+    {
+        return min > max;
+    }
+
+    //! Widen the specified range to include this one.
+    /*!
+    \param currentMin
+        The current minimum; updated in place.
+    \param currentMax
+        The current maximum; updated in place.
+    */
+    template <typename U>
+    void mergeInto(
+        U& currentMin,
+        U& currentMax) const noexcept
+    {
+        if (this->empty())
+            return;
+
+        currentMin = static_cast<U>(min) < currentMin ? static_cast<U>(min) : currentMin;
+        currentMax = static_cast<U>(max) > currentMax ? static_cast<U>(max) : currentMax;
+    }
+};
+
+MinMax<float> computeMinMax(const float* values, size_t count,
+    size_t stride = 1, float nullValue = BAG_NULL_GENERIC) noexcept;
+MinMax<uint32_t> computeMinMax(const uint32_t* values, size_t count,
+    size_t stride = 1, uint32_t nullValue = BAG_NULL_GENERIC) noexcept;
+
+//! The min/max of the fields of BagVRRefinementsItem.
+struct VRRefinementsMinMax final
+{
+    MinMax<float> depth;
+    MinMax<float> uncertainty;
+};
+
+//! The min/max of the fields of BagVRNodeItem.
+struct VRNodeMinMax final
+{
+    MinMax<float> hypStrength;
+    MinMax<uint32_t> numHypotheses;
+    MinMax<uint32_t> nSamples;
+};
+
+//! The min/max of the fields of BagVRMetadataItem.
+struct VRMetadataMinMax final
+{
+    MinMax<uint32_t> dimX;
+    MinMax<uint32_t> dimY;
+    MinMax<float> resX;
+    MinMax<float> resY;
+};
+
+VRRefinementsMinMax computeMinMax(const BagVRRefinementsItem* items,
+    size_t count) noexcept;
+VRNodeMinMax computeMinMax(const BagVRNodeItem* items, size_t count) noexcept;
+VRMetadataMinMax computeMinMax(const BagVRMetadataItem* items,
+    size_t count) noexcept;
+
+void merge(VRRefinementsMinMax& into, const VRRefinementsMinMax& from) noexcept;
+void merge(VRNodeMinMax& into, const VRNodeMinMax& from) noexcept;
+void merge(VRMetadataMinMax& into, const VRMetadataMinMax& from) noexcept;
+
+}  // namespace BAG
+
+#endif  // BAG_MINMAX_H
+
@@ -0,0 +1,744 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_metadata.h"
+#include "bag_metadata_export.h"
+#include "bag_metadata_import.h"
+#include "bag_mosaic.h"
+#include "bag_parallel.h"
+#include "bag_progressscope.h"
+#include "bag_rtree.h"
+#include "bag_simplelayer.h"
+#include "bag_vrresampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! How far, in nodes, a node of the mosaic may lie outside the cells of a
+//! source and still be taken from it; it absorbs rounding of the edges.
+constexpr double kFootprintTolerance = 1e-6;
+//! The rank of a node no source has been picked for.
+constexpr uint32_t kNoSource = std::numeric_limits<uint32_t>::max();
+
+//! Frees the strings of a BagMetadata when it goes out of scope.
+struct MetadataGuard final
+{
+    ~MetadataGuard() noexcept
+    {
+        bagFreeMetadata(metadata);
+    }
+
+    //! The metadata.
+    BagMetadata& metadata;
+};
+
+//! A source of a mosaic.
+struct MosaicInput final
+{
+    //! The cells of the source (its supergrid cells if it is variable
+    //! resolution).
+    RTree::Box footprint;
+    //! The first row of the mosaic the source covers.
+    uint32_t rowStart = 0;
+    //! The first column of the mosaic the source covers.
+    uint32_t columnStart = 0;
+    //! The last row of the mosaic the source covers (inclusive).
+    uint32_t rowEnd = 0;
+    //! The last column of the mosaic the source covers (inclusive).
+    uint32_t columnEnd = 0;
+    //! Does the source cover any node of the mosaic?
+    bool covers = false;
+    //! Is the source variable resolution?
+    bool isVR = false;
+    //! The date of the source.
+    std::string date;
+    //! The rank of the source; the lower, the more it is preferred.
+    uint32_t rank = 0;
+    //! The position of node (0, 0) of the source.
+    double originX = 0., originY = 0.;
+    //! The distance between two rows, and two columns, of the source.
+    double rowSpacing = 0., columnSpacing = 0.;
+    //! The number of rows and columns of the source.
+    uint32_t numRows = 0, numColumns = 0;
+    //! The source, while it is open.
+    std::shared_ptr<const Dataset> pDataset;
+    //! The resampler of a variable resolution source, over the nodes of the
+    //! mosaic it covers, while it is open.
+    std::unique_ptr<VRResampler> pResampler;
+};
+
+//! Find the nodes of an axis of the mosaic inside the cells of a source.
+/*!
+    The cells are half open, so a node on the edge between two sources
+    belongs to only one of them.
+
+\param min
+    The start of the cells.
+\param max
+    The end of the cells.
+\param origin
+    The position of the first node of the mosaic.
+\param resolution
+    The distance between two nodes of the mosaic.
+\param numNodes
+    The number of nodes of the mosaic.
+\param first
+    Set to the first node inside the cells.
+\param last
+    Set to the last node inside the cells.
+
+\return
+    \e true if any node is inside the cells.
+*/
+bool findCoveredNodes(
+    double min,
+    double max,
+    double origin,
+    double resolution,
+    uint32_t numNodes,
+    uint32_t& first,
+    uint32_t& last) noexcept
+{
+    const auto low = std::max(0.,
+        std::ceil((min - origin) / resolution - kFootprintTolerance));
+    const auto high = std::min(static_cast<double>(numNodes) - 1.,
+        std::ceil((max - origin) / resolution - kFootprintTolerance) - 1.);
+
+    if (!(low <= high))
+        return false;
+
+    first = static_cast<uint32_t>(low);
+    last = static_cast<uint32_t>(high);
+
+    return true;
+}
+
+//! Find the node of a source nearest a position along an axis.
+/*!
+\param position
+    The position.
+\param origin
+    The position of the first node of the source.
+\param spacing
+    The distance between two nodes of the source.
+\param numNodes
+    The number of nodes of the source.
+
+\return
+    The nearest node, clamped to the source.
+*/
+uint32_t findNearestNode(
+    double position,
+    double origin,
+    double spacing,
+    uint32_t numNodes) noexcept
+{
+    const auto node = std::floor((position - origin) / spacing + 0.5);
+
+    return static_cast<uint32_t>(std::min(std::max(node, 0.),
+        static_cast<double>(numNodes) - 1.));
+}
+
+//! Is an elevation or uncertainty null?
+/*!
+\param value
+    The value.
+\param nullValue
+    The null value of its layer.
+
+\return
+    \e true if the value is null or NaN.
+*/
+bool isNullValue(
+    float value,
+    float nullValue) noexcept
+{
+    return value == nullValue || std::isnan(value);
+}
+
+//! Builds a mosaic a band of tiles at a time.
+class MosaicBuilder final
+{
+public:
+    MosaicBuilder(const std::vector<MosaicSource>& sources,
+        const MosaicOptions& options) noexcept;
+
+    std::shared_ptr<Dataset> build(const std::string& fileName);
+
+private:
+    void buildBand(uint32_t bandStart, uint32_t bandRows,
+        SimpleLayer::StripWriter& elevationWriter,
+        SimpleLayer::StripWriter& uncertaintyWriter,
+        const ProgressScope& progress);
+    void indexSources();
+    void rankSources();
+    Metadata makeMetadata(const Dataset& source) const;
+    void openSource(MosaicInput& input) const;
+    void mergeSource(const MosaicInput& input, uint32_t bandStart,
+        uint32_t bandEnd);
+    bool isPreferred(uint32_t rank, float uncertainty, uint32_t currentRank,
+        float currentUncertainty) const noexcept;
+
+    //! The sources.
+    const std::vector<MosaicSource>& m_sources;
+    //! The grid of the mosaic, and how it is made.
+    const MosaicOptions& m_options;
+    //! What is known of each source.
+    std::vector<MosaicInput> m_inputs;
+    //! The index of the footprints of the sources.
+    std::unique_ptr<RTree> m_pIndex;
+    //! The metadata of the mosaic, as XML.
+    std::string m_metadataXML;
+    //! The elevations of the band.
+    std::vector<float> m_bandElevations;
+    //! The uncertainties of the band.
+    std::vector<float> m_bandUncertainties;
+    //! The rank of the source of each node of the band.
+    std::vector<uint32_t> m_bandRanks;
+    //! The elevations read from a source.
+    std::vector<float> m_sourceElevations;
+    //! The uncertainties read from a source.
+    std::vector<float> m_sourceUncertainties;
+    //! The row of the values read from a source for each row of the window
+    //! of the mosaic being merged.
+    std::vector<uint32_t> m_rowMap;
+    //! The column of the values read from a source for each column of the
+    //! window of the mosaic being merged.
+    std::vector<uint32_t> m_columnMap;
+};
+
+//! Constructor.
+/*!
+\param sources
+    The sources.
+\param options
+    The grid of the mosaic, and how it is made.
+*/
+MosaicBuilder::MosaicBuilder(
+    const std::vector<MosaicSource>& sources,
+    const MosaicOptions& options) noexcept
+    : m_sources(sources)
+    , m_options(options)
+{
+}
+
+//! Build the mosaic.
+/*!
+\param fileName
+    The name of the mosaic.
+
+\return
+    The mosaic, open read/write.
+*/
+std::shared_ptr<Dataset> MosaicBuilder::build(
+    const std::string& fileName)
+{
+    this->indexSources();
+    this->rankSources();
+
+    Metadata metadata;
+    metadata.loadFromBuffer(m_metadataXML);
+
+    auto pMosaic = Dataset::create(fileName, std::move(metadata),
+        m_options.chunkShape, m_options.compression);
+
+    auto& elevationLayer = *pMosaic->getSimpleLayer(Elevation);
+    auto& uncertaintyLayer = *pMosaic->getSimpleLayer(Uncertainty);
+
+    // A band is a row of chunks, so each is compressed once.
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) =
+        elevationLayer.getDescriptor()->getChunkDims();
+    const auto bandRows = chunkRows > 0 ?
+        static_cast<uint32_t>(chunkRows) : kDefaultTileSize;
+
+    auto pElevationWriter = elevationLayer.stripWriter();
+    auto pUncertaintyWriter = uncertaintyLayer.stripWriter();
+
+    const auto bandProgress = ProgressScope{m_options.progress}.part(1, 10,
+        10);
+
+    try
+    {
+        for (uint32_t bandStart=0; bandStart<m_options.rows;
+            bandStart+=bandRows)
+            this->buildBand(bandStart, bandRows, *pElevationWriter,
+                *pUncertaintyWriter, bandProgress);
+    }
+    catch (const OperationCancelled&)
+    {
+        // Keep the bands built so far; the others are null.
+        pElevationWriter->close();
+        pUncertaintyWriter->close();
+        throw;
+    }
+
+    pElevationWriter->close();
+    pUncertaintyWriter->close();
+
+    return pMosaic;
+}
+
+//! Build a band of the mosaic, and write it.
+/*!
+\param bandStart
+    The first row of the band.
+\param bandRows
+    The rows in a band; the last band may have fewer.
+\param elevationWriter
+    Writes the elevation layer of the mosaic.
+\param uncertaintyWriter
+    Writes the uncertainty layer of the mosaic.
+\param progress
+    Reports the band built.
+*/
+void MosaicBuilder::buildBand(
+    uint32_t bandStart,
+    uint32_t bandRows,
+    SimpleLayer::StripWriter& elevationWriter,
+    SimpleLayer::StripWriter& uncertaintyWriter,
+    const ProgressScope& progress)
+{
+    const auto columns = m_options.columns;
+    const auto bandCells = static_cast<size_t>(bandRows) * columns;
+    const auto bandEnd = std::min(m_options.rows - 1,
+        bandStart + (bandRows - 1));
+
+    m_bandElevations.assign(bandCells, BAG_NULL_ELEVATION);
+    m_bandUncertainties.assign(bandCells, BAG_NULL_UNCERTAINTY);
+    m_bandRanks.assign(bandCells, kNoSource);
+
+    const RTree::Box bandBox{
+        m_options.originX - m_options.resolutionX / 2.,
+        m_options.originY + (bandStart - 0.5) * m_options.resolutionY,
+        m_options.originX + (columns - 0.5) * m_options.resolutionX,
+        m_options.originY + (bandEnd + 0.5) * m_options.resolutionY};
+
+    bool merged = false;
+
+    for (const auto index : m_pIndex->search(bandBox))
+    {
+        auto& input = m_inputs[index];
+        if (!input.covers || input.rowStart > bandEnd ||
+            input.rowEnd < bandStart)
+            continue;
+
+        if (!input.pDataset)
+            this->openSource(input);
+
+        this->mergeSource(input, bandStart, bandEnd);
+        merged = true;
+
+        // Close the source once the last band it covers is merged.
+        if (input.rowEnd <= bandEnd)
+        {
+            input.pResampler.reset();
+            input.pDataset.reset();
+        }
+    }
+
+    // Nodes no source covers keep the null fill value.
+    if (merged)
+    {
+        elevationWriter.write(bandStart, 0, bandEnd, columns - 1,
+            reinterpret_cast<const uint8_t*>(m_bandElevations.data()));
+        uncertaintyWriter.write(bandStart, 0, bandEnd, columns - 1,
+            reinterpret_cast<const uint8_t*>(m_bandUncertainties.data()));
+    }
+
+    progress.report(bandEnd + 1, m_options.rows);
+}
+
+//! Find the footprint of each source, and index them.
+/*!
+    Each source is opened in turn and closed again; the sources are only
+    kept open while the bands they cover are built.
+*/
+void MosaicBuilder::indexSources()
+{
+    m_inputs.resize(m_sources.size());
+
+    std::vector<RTree::Box> footprints;
+    footprints.reserve(m_sources.size());
+
+    std::string referenceSystemType, referenceSystem;
+
+    // Opening the sources is a tenth of the progress; the bands, the rest.
+    const auto progress = ProgressScope{m_options.progress}.part(0, 1, 10);
+
+    for (size_t index=0; index<m_sources.size(); ++index)
+    {
+        progress.report(index, m_sources.size());
+
+        const auto& source = m_sources[index];
+        auto& input = m_inputs[index];
+
+        const auto pDataset = Dataset::open(source.fileName,
+            BAG_OPEN_READONLY);
+        const auto& descriptor = pDataset->getDescriptor();
+        const auto& metadata = pDataset->getMetadata().getStruct();
+
+        // The sources must share a horizontal reference system.
+        const auto& horizontal = *metadata.horizontalReferenceSystem;
+        const std::string type{horizontal.type ? horizontal.type : ""};
+        const std::string definition{horizontal.definition ?
+            horizontal.definition : ""};
+
+        if (index == 0)
+        {
+            referenceSystemType = type;
+            referenceSystem = definition;
+            m_metadataXML = exportMetadataToXML(
+                this->makeMetadata(*pDataset).getStruct());
+        }
+        else if (type != referenceSystemType || definition != referenceSystem)
+            throw InvalidMosaicSources{};
+
+        input.isVR = pDataset->getVRMetadata() &&
+            pDataset->getVRRefinements();
+        input.date = !source.date.empty() ? source.date :
+            (metadata.dateStamp ? metadata.dateStamp : "");
+
+        // Rows run north and columns east, as in the metadata.
+        std::tie(input.numRows, input.numColumns) = descriptor.getDims();
+        std::tie(input.originX, input.originY) = descriptor.getOrigin();
+        std::tie(input.rowSpacing, input.columnSpacing) =
+            descriptor.getGridSpacing();
+
+        input.footprint = {
+            input.originX - input.columnSpacing / 2.,
+            input.originY - input.rowSpacing / 2.,
+            input.originX + (input.numColumns - 0.5) * input.columnSpacing,
+            input.originY + (input.numRows - 0.5) * input.rowSpacing};
+        footprints.push_back(input.footprint);
+
+        input.covers =
+            findCoveredNodes(input.footprint.minX, input.footprint.maxX,
+                m_options.originX, m_options.resolutionX, m_options.columns,
+                input.columnStart, input.columnEnd) &&
+            findCoveredNodes(input.footprint.minY, input.footprint.maxY,
+                m_options.originY, m_options.resolutionY, m_options.rows,
+                input.rowStart, input.rowEnd);
+    }
+
+    m_pIndex.reset(new RTree{footprints});
+}
+
+//! Rank the sources by how much they are preferred.
+void MosaicBuilder::rankSources()
+{
+    std::vector<uint32_t> order(m_sources.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    // By priority, then in the order listed; the newest first if the rule
+    // is Newest.
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t lhs, uint32_t rhs) {
+            if (m_options.rule == MosaicRule::Newest &&
+                m_inputs[lhs].date != m_inputs[rhs].date)
+                return m_inputs[lhs].date > m_inputs[rhs].date;
+
+            return m_sources[lhs].priority > m_sources[rhs].priority;
+        });
+
+    for (uint32_t rank=0; rank<order.size(); ++rank)
+        m_inputs[order[rank]].rank = rank;
+}
+
+//! Make the metadata of the mosaic.
+/*!
+    The metadata of the first source, with the grid of the mosaic.
+
+\param source
+    The first source.
+
+\return
+    The metadata of the mosaic.
+*/
+Metadata MosaicBuilder::makeMetadata(
+    const Dataset& source) const
+{
+    const auto xmlBuffer = exportMetadataToXML(source.getMetadata().getStruct());
+
+    BagMetadata metaStruct;
+    bagInitMetadata(metaStruct);
+    const MetadataGuard guard{metaStruct};
+
+    const auto err = bagImportMetadataFromXmlBuffer(xmlBuffer.c_str(),
+        static_cast<int>(xmlBuffer.size()), metaStruct, false);
+    if (err != BAG_SUCCESS)
+        throw ErrorLoadingMetadata{err};
+
+    auto& spatial = *metaStruct.spatialRepresentationInfo;
+    spatial.numberOfRows = m_options.rows;
+    spatial.numberOfColumns = m_options.columns;
+    spatial.rowResolution = m_options.resolutionY;
+    spatial.columnResolution = m_options.resolutionX;
+    spatial.llCornerX = m_options.originX;
+    spatial.llCornerY = m_options.originY;
+    spatial.urCornerX = m_options.originX +
+        (m_options.columns - 1) * m_options.resolutionX;
+    spatial.urCornerY = m_options.originY +
+        (m_options.rows - 1) * m_options.resolutionY;
+
+    Metadata metadata;
+    metadata.loadFromBuffer(exportMetadataToXML(metaStruct));
+
+    return metadata;
+}
+
+//! Open a source.
+/*!
+    A variable resolution source is given a resampler over the nodes of the
+    mosaic it covers.
+
+\param input
+    The source.
+*/
+void MosaicBuilder::openSource(
+    MosaicInput& input) const
+{
+    const auto& source = m_sources[&input - m_inputs.data()];
+
+    input.pDataset = Dataset::open(source.fileName, BAG_OPEN_READONLY);
+
+    if (!input.isVR)
+        return;
+
+    // The resampler puts a node in the middle of each of its cells.
+    const auto resolutionX = m_options.resolutionX;
+    const auto resolutionY = m_options.resolutionY;
+
+    input.pResampler.reset(new VRResampler{*input.pDataset, resolutionX,
+        resolutionY,
+        m_options.originX + (input.columnStart - 0.5) * resolutionX,
+        m_options.originY + (input.rowStart - 0.5) * resolutionY,
+        m_options.originX + (input.columnEnd + 0.5) * resolutionX,
+        m_options.originY + (input.rowEnd + 0.5) * resolutionY});
+}
+
+//! Merge the nodes of a source into the band.
+/*!
+    The nodes of a simple source nearest the nodes of the mosaic are read
+    in one window; those of a variable resolution source are resampled.
+    They are then merged on several threads.
+
+\param input
+    The source; open.
+\param bandStart
+    The first row of the band.
+\param bandEnd
+    The last row of the band (inclusive).
+*/
+void MosaicBuilder::mergeSource(
+    const MosaicInput& input,
+    uint32_t bandStart,
+    uint32_t bandEnd)
+{
+    const auto rowStart = std::max(bandStart, input.rowStart);
+    const auto rowEnd = std::min(bandEnd, input.rowEnd);
+    const auto rows = rowEnd - rowStart + 1;
+    const auto columns = input.columnEnd - input.columnStart + 1;
+
+    m_rowMap.resize(rows);
+    m_columnMap.resize(columns);
+
+    size_t sourceColumns = columns;
+    bool hasUncertainty = false;
+
+    if (input.isVR)
+    {
+        std::iota(m_rowMap.begin(), m_rowMap.end(), 0u);
+        std::iota(m_columnMap.begin(), m_columnMap.end(), 0u);
+
+        m_sourceElevations.resize(static_cast<size_t>(rows) * columns);
+        input.pResampler->resampleRowsInto(m_options.vrMethod,
+            rowStart - input.rowStart, rowEnd - input.rowStart,
+            m_sourceElevations.data());
+    }
+    else
+    {
+        for (uint32_t row=0; row<rows; ++row)
+            m_rowMap[row] = findNearestNode(m_options.originY +
+                (rowStart + row) * m_options.resolutionY, input.originY,
+                input.rowSpacing, input.numRows);
+
+        for (uint32_t column=0; column<columns; ++column)
+            m_columnMap[column] = findNearestNode(m_options.originX +
+                (input.columnStart + column) * m_options.resolutionX,
+                input.originX, input.columnSpacing, input.numColumns);
+
+        const auto sourceRowStart = m_rowMap.front();
+        const auto sourceRowEnd = m_rowMap.back();
+        const auto sourceColumnStart = m_columnMap.front();
+        const auto sourceColumnEnd = m_columnMap.back();
+
+        for (auto& row : m_rowMap)
+            row -= sourceRowStart;
+        for (auto& column : m_columnMap)
+            column -= sourceColumnStart;
+
+        sourceColumns = sourceColumnEnd - sourceColumnStart + 1;
+        const auto sourceCells = (sourceRowEnd - sourceRowStart + 1) *
+            sourceColumns;
+
+        m_sourceElevations.resize(sourceCells);
+        input.pDataset->getLayer(Elevation).readInto(sourceRowStart,
+            sourceColumnStart, sourceRowEnd, sourceColumnEnd,
+            reinterpret_cast<uint8_t*>(m_sourceElevations.data()),
+            sourceCells * sizeof(float));
+
+        const auto pUncertainty = input.pDataset->getSimpleLayer(Uncertainty);
+        hasUncertainty = pUncertainty != nullptr;
+        if (hasUncertainty)
+        {
+            m_sourceUncertainties.resize(sourceCells);
+            pUncertainty->readInto(sourceRowStart, sourceColumnStart,
+                sourceRowEnd, sourceColumnEnd,
+                reinterpret_cast<uint8_t*>(m_sourceUncertainties.data()),
+                sourceCells * sizeof(float));
+        }
+    }
+
+    processInBlocks(0, rows - 1, columns,
+        [&](uint32_t first, uint32_t last) {
+            for (auto row=first; row<=last; ++row)
+            {
+                const auto sourceOffset = m_rowMap[row] * sourceColumns;
+                const auto bandOffset = static_cast<size_t>(
+                    rowStart + row - bandStart) * m_options.columns +
+                    input.columnStart;
+
+                for (uint32_t column=0; column<columns; ++column)
+                {
+                    const auto sourceIndex = sourceOffset + m_columnMap[column];
+
+                    const auto elevation = m_sourceElevations[sourceIndex];
+                    if (isNullValue(elevation, BAG_NULL_ELEVATION))
+                        continue;
+
+                    const auto uncertainty = hasUncertainty ?
+                        m_sourceUncertainties[sourceIndex] :
+                        static_cast<float>(BAG_NULL_UNCERTAINTY);
+
+                    const auto index = bandOffset + column;
+                    if (!this->isPreferred(input.rank, uncertainty,
+                        m_bandRanks[index], m_bandUncertainties[index]))
+                        continue;
+
+                    m_bandElevations[index] = elevation;
+                    m_bandUncertainties[index] = uncertainty;
+                    m_bandRanks[index] = input.rank;
+                }
+            }
+        });
+}
+
+//! Is the node of a source preferred to the node picked so far?
+/*!
+\param rank
+    The rank of the source.
+\param uncertainty
+    The uncertainty of its node.
+\param currentRank
+    The rank of the source picked so far; kNoSource if there is none.
+\param currentUncertainty
+    The uncertainty of the node picked so far.
+
+\return
+    \e true if the node of the source is preferred.
+*/
+bool MosaicBuilder::isPreferred(
+    uint32_t rank,
+    float uncertainty,
+    uint32_t currentRank,
+    float currentUncertainty) const noexcept
+{
+    if (currentRank == kNoSource)
+        return true;
+
+    // A node without an uncertainty has the largest.
+    if (m_options.rule == MosaicRule::LowestUncertainty)
+    {
+        constexpr auto kNone = std::numeric_limits<float>::infinity();
+        const auto value = isNullValue(uncertainty, BAG_NULL_UNCERTAINTY) ?
+            kNone : uncertainty;
+        const auto current = isNullValue(currentUncertainty,
+            BAG_NULL_UNCERTAINTY) ? kNone : currentUncertainty;
+
+        if (value != current)
+            return value < current;
+    }
+
+    return rank < currentRank;
+}
+
+}  // namespace
+
+//! Mosaic many BAGs into one grid.
+/*!
+    The footprints of the sources are indexed in an R-tree, and the mosaic
+    is built a row of chunks (a band) at a time.  Only the sources whose
+    footprints meet a band are read for it, and each source is only open
+    from the first band it covers to the last, so memory use and open files
+    are bounded by the sources overlapping a band, whatever their number.
+    The nodes of each source are merged into a band on several threads, and
+    the band is written through a strip writer, so each chunk of the mosaic
+    is compressed once.
+
+    A node of the mosaic takes the nearest node of a simple source, or the
+    resampled refinements (see VRResampler) of a variable resolution one;
+    nodes that are null in a source are not taken from it.  A node covered
+    by several sources is picked by options.rule.  Variable resolution
+    sources have no uncertainty to pick by, and their nodes carry none.
+
+    If options.progress is cancelled while the bands are built, the bands
+    built so far are written, and the others left null, before an
+    OperationCancelled exception is thrown.
+
+    The metadata of the mosaic is that of the first source, with the grid
+    of the mosaic.  An InvalidMosaicSources exception is thrown if there are
+    no sources, or they do not share a horizontal reference system.  An
+    InvalidResampleGrid exception is thrown if the grid is empty or its
+    resolution not positive.
+
+\param sources
+    The BAGs to mosaic.
+\param fileName
+    The name of the mosaic.
+\param options
+    The grid of the mosaic, in the horizontal reference system of the
+    sources, and how it is made.
+
+\return
+    The mosaic, open read/write.
+*/
+std::shared_ptr<Dataset> mosaicDatasets(
+    const std::vector<MosaicSource>& sources,
+    const std::string& fileName,
+    const MosaicOptions& options)
+{
+    if (sources.empty())
+        throw InvalidMosaicSources{};
+
+    if (options.rows == 0 || options.columns == 0 ||
+        !(options.resolutionX > 0.) || !(options.resolutionY > 0.) ||
+        !std::isfinite(options.originX) || !std::isfinite(options.originY))
+        throw InvalidResampleGrid{};
+
+    return MosaicBuilder{sources, options}.build(fileName);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,22 @@
+#ifndef BAG_MOSAIC_H
+#define BAG_MOSAIC_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace BAG {
+
+BAG_API std::shared_ptr<Dataset> mosaicDatasets(
+    const std::vector<MosaicSource>& sources, const std::string& fileName,
+    const MosaicOptions& options);
+
+}  // namespace BAG
+
+#endif  // BAG_MOSAIC_H
+
@@ -0,0 +1,90 @@
+
+#include "bag_mpi.h"
+
+#ifdef BAG_USE_MPI
+
+#include <array>
+#include <H5Cpp.h>
+
+#ifndef H5_HAVE_PARALLEL
+#error "BAG_BUILD_MPI requires HDF5 built with parallel (MPI-IO) support"
+#endif
+
+
+namespace BAG {
+
+//! Access a file through the MPI-IO driver, shared by several processes.
+/*!
+    Every process opens and creates the same groups, DataSets and attributes,
+    so the metadata is read by one process and broadcast, and is written
+    collectively.
+
+\param communicator
+    The processes sharing the file.
+\param h5accessProps
+    The file access properties to set the driver in.
+*/
+void setParallelAccess(
+    MPI_Comm communicator,
+    ::H5::FileAccPropList& h5accessProps)
+{
+    const auto h5accessPropsId = h5accessProps.getId();
+
+    if (H5Pset_fapl_mpio(h5accessPropsId, communicator, MPI_INFO_NULL) < 0 ||
+        H5Pset_all_coll_metadata_ops(h5accessPropsId, true) < 0 ||
+        H5Pset_coll_metadata_write(h5accessPropsId, true) < 0)
+        throw ::H5::FileIException{"setParallelAccess",
+            "the MPI-IO driver could not be set"};
+}
+
+//! Make the transfer properties of a collective write.
+/*!
+    HDF5 only writes filtered (compressed) chunks collectively, and a
+    collective write lets MPI-IO merge the disjoint windows written by every
+    process into large requests.
+
+\return
+    The transfer properties.
+*/
+::H5::DSetMemXferPropList makeCollectiveTransfer()
+{
+    ::H5::DSetMemXferPropList h5xferProps{};
+
+    if (H5Pset_dxpl_mpio(h5xferProps.getId(), H5FD_MPIO_COLLECTIVE) < 0)
+        throw ::H5::PropListIException{"makeCollectiveTransfer",
+            "H5Pset_dxpl_mpio failed"};
+
+    return h5xferProps;
+}
+
+//! Reduce a min/max across processes.
+/*!
+    Every process must call this, as it is collective.
+
+\param communicator
+    The processes sharing the file.
+\param min
+    The minimum found by this process; set to the minimum of all of them.
+\param max
+    The maximum found by this process; set to the maximum of all of them.
+*/
+void reduceMinMax(
+    MPI_Comm communicator,
+    float& min,
+    float& max)
+{
+    // One reduction finds both, as the largest max is the smallest -max.
+    std::array<float, 2> values{min, -max};
+
+    // The default MPI error handler aborts, rather than returning an error.
+    MPI_Allreduce(MPI_IN_PLACE, values.data(), static_cast<int>(values.size()),
+        MPI_FLOAT, MPI_MIN, communicator);
+
+    min = values[0];
+    max = -values[1];
+}
+
+}  // namespace BAG
+
+#endif  // BAG_USE_MPI
+
@@ -0,0 +1,33 @@
+#ifndef BAG_MPI_H
+#define BAG_MPI_H
+
+#ifdef BAG_USE_MPI
+
+#include <mpi.h>
+
+
+//! Forward declarations of HDF5 classes used, to avoid exposing dependencies
+//! to users of this library.
+namespace H5 {
+
+class DSetMemXferPropList;
+class FileAccPropList;
+
+}  // namespace H5
+
+
+namespace BAG {
+
+void setParallelAccess(MPI_Comm communicator,
+    ::H5::FileAccPropList& h5accessProps);
+
+::H5::DSetMemXferPropList makeCollectiveTransfer();
+
+void reduceMinMax(MPI_Comm communicator, float& min, float& max);
+
+}  // namespace BAG
+
+#endif  // BAG_USE_MPI
+
+#endif  // BAG_MPI_H
+
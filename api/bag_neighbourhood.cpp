@@ -0,0 +1,333 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_layertraits.h"
+#include "bag_neighbourhood.h"
+#include "bag_parallel.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayer.h"
+#include "bag_vrresampler.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+
+namespace BAG {
+
+//! Retrieve the first row of the band.
+/*!
+\return
+    The first row of the band.
+*/
+uint32_t NeighbourhoodBand::getRowStart() const noexcept
+{
+    return m_rowStart;
+}
+
+//! Retrieve the last row of the band.
+/*!
+\return
+    The last row of the band (inclusive).
+*/
+uint32_t NeighbourhoodBand::getRowEnd() const noexcept
+{
+    return m_rowEnd;
+}
+
+//! Retrieve the nodes of a row of the band or its halo.
+/*!
+\param row
+    The row, from the first row of the band less the halo to the last row
+    plus the halo.  It may be outside the grid.
+
+\return
+    The node at column 0 of the row.  The columns from -halo to the number
+    of columns of the grid plus the halo (exclusive) may be read.
+*/
+const float* NeighbourhoodBand::getRow(
+    int64_t row) const noexcept
+{
+    const auto index = row - (int64_t{m_rowStart} - m_halo);
+
+    return m_rows[static_cast<size_t>(index)] + m_halo;
+}
+
+//! Process each tile of the band, on several threads if the band is large.
+/*!
+\param processTile
+    Called with the first and last (inclusive) column of each tile of the
+    band, a chunk wide.  Called concurrently, so it must not throw or modify
+    shared state.
+*/
+void NeighbourhoodBand::forEachTile(
+    const std::function<void(uint32_t, uint32_t)>& processTile) const
+{
+    const auto numTiles = (m_columns - 1) / m_tileColumns + 1;
+    const auto tileCells = (m_rowEnd - m_rowStart + 1) * m_tileColumns;
+
+    processInBlocks(0, numTiles - 1, tileCells,
+        [&](uint32_t first, uint32_t last) {
+            for (auto tile=first; tile<=last; ++tile)
+            {
+                const auto columnStart = tile * m_tileColumns;
+                processTile(columnStart, static_cast<uint32_t>(
+                    std::min<uint64_t>(m_columns - 1,
+                        uint64_t{columnStart} + m_tileColumns - 1)));
+            }
+        });
+}
+
+//! Constructor.
+/*!
+\param layer
+    The layer visited.
+\param halo
+    The distance, in nodes, around each band visited with it.
+*/
+NeighbourhoodScanner::NeighbourhoodScanner(
+    const SimpleLayer& layer,
+    uint32_t halo)
+    : m_halo(halo)
+{
+    const auto pDataset = layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto& descriptor = pDataset->getDescriptor();
+    std::tie(m_numRows, m_numColumns) = descriptor.getDims();
+
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+    m_spacing = std::make_tuple(columnSpacing, rowSpacing);
+    m_origin = descriptor.getOrigin();
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = layer.getDescriptor()->getChunkDims();
+
+    if (chunkRows > 0 && chunkColumns > 0)
+    {
+        m_tileRows = static_cast<uint32_t>(chunkRows);
+        m_tileColumns = static_cast<uint32_t>(chunkColumns);
+    }
+
+    visitLayerTraits(layer.getDescriptor()->getLayerType(),
+        [this](auto traits) {
+            m_nullValue = static_cast<float>(
+                decltype(traits)::getNullValue());
+        });
+
+    const auto lastColumn = m_numColumns - 1;
+    m_readRows = [&layer, lastColumn](uint32_t rowStart, uint32_t rowEnd,
+        float* data, size_t rowStride) {
+            layer.readAsInto(rowStart, 0, rowEnd, lastColumn, DT_FLOAT32,
+                reinterpret_cast<uint8_t*>(data), rowStride * sizeof(float));
+        };
+}
+
+//! Constructor.
+/*!
+\param resampler
+    The resampler whose output grid is visited.  The nodes with no
+    refinement under them are BAG_NULL_ELEVATION.
+\param method
+    How the refinements are combined.
+\param halo
+    The distance, in nodes, around each band visited with it.
+*/
+NeighbourhoodScanner::NeighbourhoodScanner(
+    const VRResampler& resampler,
+    VRResampleMethod method,
+    uint32_t halo)
+    : m_halo(halo)
+    , m_numRows(resampler.getNumRows())
+    , m_numColumns(resampler.getNumColumns())
+    , m_origin(resampler.getOrigin())
+    , m_spacing(resampler.getResolution())
+{
+    m_readRows = [&resampler, method](uint32_t rowStart, uint32_t rowEnd,
+        float* data, size_t rowStride) {
+            resampler.resampleRowsInto(method, rowStart, rowEnd, data,
+                rowStride);
+        };
+}
+
+//! Retrieve the number of rows of the grid.
+/*!
+\return
+    The number of rows of the grid.
+*/
+uint32_t NeighbourhoodScanner::getNumRows() const noexcept
+{
+    return m_numRows;
+}
+
+//! Retrieve the number of columns of the grid.
+/*!
+\return
+    The number of columns of the grid.
+*/
+uint32_t NeighbourhoodScanner::getNumColumns() const noexcept
+{
+    return m_numColumns;
+}
+
+//! Retrieve the number of rows of a band.
+/*!
+\return
+    The number of rows of a band; the last may have fewer.
+*/
+uint32_t NeighbourhoodScanner::getTileRows() const noexcept
+{
+    return m_tileRows;
+}
+
+//! Retrieve the number of columns of a tile.
+/*!
+\return
+    The number of columns of a tile; the last of a band may have fewer.
+*/
+uint32_t NeighbourhoodScanner::getTileColumns() const noexcept
+{
+    return m_tileColumns;
+}
+
+//! Retrieve the null value of the grid.
+/*!
+\return
+    The null value of the grid, as a float.
+*/
+float NeighbourhoodScanner::getNullValue() const noexcept
+{
+    return m_nullValue;
+}
+
+//! Retrieve the position of the node at row 0, column 0.
+/*!
+\return
+    The position of the south west node, x then y.
+*/
+std::tuple<double, double> NeighbourhoodScanner::getOrigin() const noexcept
+{
+    return m_origin;
+}
+
+//! Retrieve the distance between the nodes of the grid.
+/*!
+\return
+    The distance between columns, then between rows.
+*/
+std::tuple<double, double> NeighbourhoodScanner::getSpacing() const noexcept
+{
+    return m_spacing;
+}
+
+//! Visit the grid, a band at a time from row 0.
+/*!
+\param processBand
+    Called with each band, on the calling thread.
+\param progress
+    Follows the progress of the visit, and cancels it; may be nullptr.  An
+    OperationCancelled exception is thrown if it is cancelled.
+*/
+void NeighbourhoodScanner::scan(
+    const std::function<void(const NeighbourhoodBand&)>& processBand,
+    ProgressToken* progress)
+{
+    m_rows.clear();
+    if (m_numRows == 0 || m_numColumns == 0)
+        return;
+
+    const ProgressScope progressScope{progress};
+
+    m_nullRow.assign(m_numColumns + 2 * size_t{m_halo}, m_nullValue);
+
+    NeighbourhoodBand band;
+    band.m_halo = m_halo;
+    band.m_columns = m_numColumns;
+    band.m_tileColumns = m_tileColumns;
+
+    // The first row not read yet.
+    uint64_t nextRow = 0;
+    const auto rowWidth = m_numColumns + 2 * size_t{m_halo};
+
+    for (uint64_t bandStart=0; bandStart<m_numRows; bandStart+=m_tileRows)
+    {
+        const auto bandEnd = std::min<uint64_t>(m_numRows - 1,
+            bandStart + m_tileRows - 1);
+
+        // Read the rows of the halo past the band, a row of chunks at a
+        // time.
+        const auto lastRow = std::min<uint64_t>(m_numRows - 1,
+            bandEnd + m_halo);
+        while (nextRow <= lastRow)
+        {
+            const auto readEnd = std::min<uint64_t>(m_numRows - 1,
+                nextRow + m_tileRows - 1);
+            this->readRows(static_cast<uint32_t>(nextRow),
+                static_cast<uint32_t>(readEnd));
+            nextRow = readEnd + 1;
+        }
+
+        // Drop the rows no longer in the halo.
+        const auto firstRow = static_cast<int64_t>(bandStart) - m_halo;
+        while (!m_rows.empty() &&
+            static_cast<int64_t>(m_rows.front().rowEnd) < firstRow)
+            m_rows.pop_front();
+
+        band.m_rowStart = static_cast<uint32_t>(bandStart);
+        band.m_rowEnd = static_cast<uint32_t>(bandEnd);
+        band.m_rows.resize(static_cast<size_t>(bandEnd - bandStart + 1) +
+            2 * size_t{m_halo});
+
+        auto rows = m_rows.begin();
+        for (size_t i=0; i<band.m_rows.size(); ++i)
+        {
+            const auto row = firstRow + static_cast<int64_t>(i);
+            if (row < 0 || row >= m_numRows)
+            {
+                band.m_rows[i] = m_nullRow.data();
+                continue;
+            }
+
+            while (rows->rowEnd < row)
+                ++rows;
+
+            band.m_rows[i] = rows->values.data() +
+                static_cast<size_t>(row - rows->rowStart) * rowWidth;
+        }
+
+        processBand(band);
+
+        progressScope.report(bandEnd + 1, m_numRows);
+    }
+
+    m_rows.clear();
+}
+
+//! Read rows of the grid, after those read so far.
+/*!
+\param rowStart
+    The first row.
+\param rowEnd
+    The last row (inclusive).
+*/
+void NeighbourhoodScanner::readRows(
+    uint32_t rowStart,
+    uint32_t rowEnd)
+{
+    const auto rowWidth = m_numColumns + 2 * size_t{m_halo};
+
+    Rows rows;
+    rows.rowStart = rowStart;
+    rows.rowEnd = rowEnd;
+    rows.values.assign(static_cast<size_t>(rowEnd - rowStart + 1) * rowWidth,
+        m_nullValue);
+
+    m_readRows(rowStart, rowEnd, rows.values.data() + m_halo, rowWidth);
+
+    m_rows.push_back(std::move(rows));
+}
+
+}  // namespace BAG
+
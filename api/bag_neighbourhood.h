@@ -0,0 +1,125 @@
+#ifndef BAG_NEIGHBOURHOOD_H
+#define BAG_NEIGHBOURHOOD_H
+
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+
+namespace BAG {
+
+//! A band of a grid a row of chunks high, and the nodes around it within
+//! the halo of a NeighbourhoodScanner.
+/*!
+    The nodes are read as 32 bit floats.  Those outside the grid read as
+    its null value.
+*/
+class NeighbourhoodBand final
+{
+public:
+    uint32_t getRowStart() const noexcept;
+    uint32_t getRowEnd() const noexcept;
+
+    const float* getRow(int64_t row) const noexcept;
+
+    void forEachTile(
+        const std::function<void(uint32_t, uint32_t)>& processTile) const;
+
+private:
+    NeighbourhoodBand() = default;
+
+    //! The first row of the band.
+    uint32_t m_rowStart = 0;
+    //! The last row of the band (inclusive).
+    uint32_t m_rowEnd = 0;
+    //! The halo, in nodes.
+    uint32_t m_halo = 0;
+    //! The number of columns of the grid.
+    uint32_t m_columns = 0;
+    //! The number of columns of a tile.
+    uint32_t m_tileColumns = 0;
+    //! The rows of the band and its halo, from m_rowStart - m_halo; each
+    //! points at column -m_halo.
+    std::vector<const float*> m_rows;
+
+    friend class NeighbourhoodScanner;
+};
+
+//! Visits a grid a band of chunks at a time, with the nodes around each
+//! band within a halo, for kernels over the neighbourhood of a node.
+/*!
+    The grid is a simple layer, or the output of a VRResampler.  It is read
+    a row of chunks at a time, ahead of the band visited by the halo, and
+    the rows read are kept until no band's halo reaches them, so each chunk
+    is decoded (or resampled) once however large the halo.  The bands span
+    the grid, so the halo of a column is already in memory.  The tiles of a
+    band, a chunk wide, may be processed on several threads with
+    NeighbourhoodBand::forEachTile().
+*/
+class NeighbourhoodScanner final
+{
+public:
+    NeighbourhoodScanner(const SimpleLayer& layer, uint32_t halo);
+    NeighbourhoodScanner(const VRResampler& resampler,
+        VRResampleMethod method, uint32_t halo);
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+    uint32_t getTileRows() const noexcept;
+    uint32_t getTileColumns() const noexcept;
+    float getNullValue() const noexcept;
+    std::tuple<double, double> getOrigin() const noexcept;
+    std::tuple<double, double> getSpacing() const noexcept;
+
+    void scan(const std::function<void(const NeighbourhoodBand&)>& processBand,
+        ProgressToken* progress = nullptr);
+
+private:
+    //! Rows of the grid read.
+    struct Rows final
+    {
+        //! The first row.
+        uint32_t rowStart = 0;
+        //! The last row (inclusive).
+        uint32_t rowEnd = 0;
+        //! The nodes, with m_halo null columns either side of each row.
+        std::vector<float> values;
+    };
+
+    void readRows(uint32_t rowStart, uint32_t rowEnd);
+
+    //! Reads rows of the grid, as floats, into a buffer with a row stride in
+    //! values.
+    std::function<void(uint32_t, uint32_t, float*, size_t)> m_readRows;
+    //! The distance, in nodes, around a band visited with it.
+    uint32_t m_halo = 0;
+    //! The number of rows of the grid.
+    uint32_t m_numRows = 0;
+    //! The number of columns of the grid.
+    uint32_t m_numColumns = 0;
+    //! The number of rows of a tile; those of the chunks of a layer.
+    uint32_t m_tileRows = kDefaultTileSize;
+    //! The number of columns of a tile.
+    uint32_t m_tileColumns = kDefaultTileSize;
+    //! The null value of the grid, as a float.
+    float m_nullValue = BAG_NULL_ELEVATION;
+    //! The position of node (0, 0), x then y.
+    std::tuple<double, double> m_origin;
+    //! The distance between columns, then rows.
+    std::tuple<double, double> m_spacing;
+    //! The rows read and still in the halo of a band, in order.
+    std::deque<Rows> m_rows;
+    //! A row of null values, for the rows of a halo outside the grid.
+    std::vector<float> m_nullRow;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_NEIGHBOURHOOD_H
+
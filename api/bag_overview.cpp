@@ -0,0 +1,87 @@
+
+#include "bag_overview.h"
+#include "bag_parallel.h"
+
+#include <algorithm>
+
+
+namespace BAG {
+
+//! Combine blocks of 2 by 2 nodes of a grid into the nodes of the next level.
+/*!
+\param source
+    The values of the grid, row by row.
+\param sourceCounts
+    The number of nodes each value stands for; nullptr if one each.
+\param sourceRows
+    The number of rows in source.
+\param sourceColumns
+    The number of columns in source.
+\param method
+    How the values are combined.
+\param destination
+    The next level, whose first row covers the first two rows of source.
+\param destinationRowStart
+    The first row of the destination to fill.
+*/
+void reduceOverview(
+    const float* source,
+    const uint32_t* sourceCounts,
+    uint32_t sourceRows,
+    uint32_t sourceColumns,
+    OverviewMethod method,
+    OverviewGrid& destination,
+    uint32_t destinationRowStart)
+{
+    constexpr float kNull = BAG_NULL_GENERIC;
+
+    const auto destinationRows = (sourceRows + 1) / 2;
+
+    processInBlocks(0, destinationRows - 1, destination.columns * 4,
+        [&](uint32_t first, uint32_t last) {
+            for (auto row=first; row<=last; ++row)
+            {
+                const auto destinationRow = destinationRowStart + row;
+                auto* values = destination.values.data() +
+                    static_cast<size_t>(destinationRow) * destination.columns;
+                auto* counts = destination.counts.data() +
+                    static_cast<size_t>(destinationRow) * destination.columns;
+
+                for (uint32_t column=0; column<destination.columns; ++column)
+                {
+                    double sum = 0.;
+                    uint32_t count = 0;
+                    float best = kNull;
+
+                    for (auto r=row*2; r<std::min(row*2 + 2, sourceRows); ++r)
+                        for (auto c=column*2;
+                            c<std::min(column*2 + 2, sourceColumns); ++c)
+                        {
+                            const auto index =
+                                static_cast<size_t>(r) * sourceColumns + c;
+                            const auto value = source[index];
+                            if (value == kNull)
+                                continue;
+
+                            const auto weight = sourceCounts ?
+                                sourceCounts[index] : 1u;
+
+                            sum += static_cast<double>(value) * weight;
+                            count += weight;
+
+                            if (best == kNull ||
+                                (method == OverviewMethod::Minimum && value < best) ||
+                                (method == OverviewMethod::Shoal && value > best))
+                                best = value;
+                        }
+
+                    counts[column] = count;
+                    values[column] = (count > 0 && method == OverviewMethod::Mean) ?
+                        static_cast<float>(sum / count) : best;
+                }
+            }
+        });
+}
+
+}  // namespace BAG
+
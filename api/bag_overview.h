@@ -0,0 +1,33 @@
+#ifndef BAG_OVERVIEW_H
+#define BAG_OVERVIEW_H
+
+#include "bag_types.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace BAG {
+
+//! A level of overview being built.
+struct OverviewGrid final
+{
+    //! The number of rows.
+    uint32_t rows = 0;
+    //! The number of columns.
+    uint32_t columns = 0;
+    //! The value of each node; the null value if no node below it has one.
+    std::vector<float> values;
+    //! The number of nodes with a value below each node, which weights the
+    //! values when the mean is taken.
+    std::vector<uint32_t> counts;
+};
+
+void reduceOverview(const float* source, const uint32_t* sourceCounts,
+    uint32_t sourceRows, uint32_t sourceColumns, OverviewMethod method,
+    OverviewGrid& destination, uint32_t destinationRowStart);
+
+}  // namespace BAG
+
+#endif  // BAG_OVERVIEW_H
+
@@ -0,0 +1,109 @@
+#ifndef BAG_PARALLEL_H
+#define BAG_PARALLEL_H
+
+#include "bag_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace BAG {
+
+//! The fewest values worth processing on a thread of their own.
+constexpr size_t kMinCellsPerThread = 1 << 16;
+
+//! Process an area in blocks of whole rows, on several threads if it is large.
+/*!
+    The blocks are run on the threads of Executor::global(), so the parallel
+    work of the library shares one pool however many operations run at once.
+    The calling thread runs blocks too, and runs those no thread has started
+    itself, so it only waits for blocks being processed; a block may itself
+    call processInBlocks().
+
+\param rowStart
+    The first row of the area.
+\param rowEnd
+    The last row of the area (inclusive).
+\param columns
+    The number of columns in the area.
+\param processRows
+    Called with the first and last (inclusive) row of each block.
+    Called concurrently, so it must not throw or modify shared state.
+*/
+template <typename ProcessRows>
+void processInBlocks(
+    uint32_t rowStart,
+    uint32_t rowEnd,
+    uint32_t columns,
+    const ProcessRows& processRows)
+{
+    const auto rows = rowEnd - rowStart + 1;
+
+    const size_t numCells = static_cast<size_t>(rows) * columns;
+    const auto numBlocks = static_cast<uint32_t>(std::min<size_t>(
+        {getConcurrency(), rows, numCells / kMinCellsPerThread}));
+
+    if (numBlocks <= 1)
+    {
+        processRows(rowStart, rowEnd);
+        return;
+    }
+
+    const auto rowsPerBlock = (rows + numBlocks - 1) / numBlocks;
+
+    // Shared with the tasks, as those no block is left for may run after
+    // the call returns.
+    struct Blocks final
+    {
+        std::atomic<uint32_t> next{0};
+        std::atomic<uint32_t> numDone{0};
+        std::mutex mutex;
+        std::condition_variable allDone;
+    };
+
+    const auto pBlocks = std::make_shared<Blocks>();
+
+    // Take blocks until none are left.
+    const auto processBlocks = [pBlocks, &processRows, rowStart, rowEnd,
+        rowsPerBlock, numBlocks]() noexcept {
+        auto& blocks = *pBlocks;
+
+        for (auto block=blocks.next++; block<numBlocks; block=blocks.next++)
+        {
+            const auto first = rowStart + block * rowsPerBlock;
+            processRows(first, std::min(first + rowsPerBlock - 1, rowEnd));
+
+            if (++blocks.numDone == numBlocks)
+            {
+                const std::lock_guard<std::mutex> lock{blocks.mutex};
+                blocks.allDone.notify_all();
+            }
+        }
+    };
+
+    // If a task cannot be posted, the calling thread takes its blocks.
+    auto& executor = Executor::global();
+    try
+    {
+        for (uint32_t task=1; task<numBlocks; ++task)
+            executor.post(processBlocks);
+    }
+    catch (...)
+    {
+    }
+
+    processBlocks();
+
+    std::unique_lock<std::mutex> lock{pBlocks->mutex};
+    pBlocks->allDone.wait(lock,
+        [&pBlocks, numBlocks]() { return pBlocks->numDone == numBlocks; });
+}
+
+}  // namespace BAG
+
+#endif  // BAG_PARALLEL_H
@@ -0,0 +1,205 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_layer.h"
+#include "bag_prefetchreader.h"
+
+#include <algorithm>
+
+
+namespace BAG {
+
+//! Split a layer into bands of whole rows.
+/*!
+\param layer
+    The layer.
+\param bandHeight
+    The number of rows in a band.  The last band may be shorter.
+
+\return
+    The bands, from the first row to the last.
+*/
+std::vector<LayerTile> PrefetchReader::makeBands(
+    const Layer& layer,
+    uint32_t bandHeight)
+{
+    if (bandHeight == 0)
+        throw InvalidReadSize{};
+
+    auto pDataset = layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    std::vector<LayerTile> bands;
+    if (numRows == 0 || numColumns == 0)
+        return bands;
+
+    bands.reserve((numRows + bandHeight - 1) / bandHeight);
+
+    for (uint32_t row=0; row<numRows; row+=bandHeight)
+    {
+        LayerTile band;
+        band.rowStart = row;
+        band.columnStart = 0;
+        band.rowEnd = std::min(row + bandHeight, numRows) - 1;
+        band.columnEnd = numColumns - 1;
+
+        bands.push_back(std::move(band));
+    }
+
+    return bands;
+}
+
+//! Constructor.
+/*!
+    Read the layer in bands of whole rows.
+
+\param layer
+    The layer to read.
+\param bandHeight
+    The number of rows in each band.  The last band may be shorter.
+\param depth
+    The maximum number of bands read ahead of the caller.
+*/
+PrefetchReader::PrefetchReader(
+    const Layer& layer,
+    uint32_t bandHeight,
+    size_t depth)
+    : PrefetchReader(layer, makeBands(layer, bandHeight), depth)
+{
+}
+
+//! Constructor.
+/*!
+    Read the specified windows of the layer, in order.  For one dimensional
+    layers, such as the variable resolution refinements, use a row of 0 and
+    the range of indices as the columns.
+
+\param layer
+    The layer to read.
+\param windows
+    The windows to read.  Any data in them is ignored.
+\param depth
+    The maximum number of windows read ahead of the caller.
+*/
+PrefetchReader::PrefetchReader(
+    const Layer& layer,
+    std::vector<LayerTile> windows,
+    size_t depth)
+    : m_layer(layer)
+    , m_windows(std::move(windows))
+    , m_depth(std::max<size_t>(depth, 1))
+{
+    m_thread = std::thread{&PrefetchReader::run, this};
+}
+
+//! Destructor.
+/*!
+    Stop the background thread, discarding anything read ahead.
+*/
+PrefetchReader::~PrefetchReader()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_changed.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+//! Retrieve the next window.
+/*!
+    Blocks until the background thread has read the window.  Any error
+    reading it is thrown here.
+
+\param window
+    Set to the next window, with its data, if there is one.
+
+\return
+    \e true if a window was retrieved.
+    \e false if every window has been retrieved.
+*/
+bool PrefetchReader::next(
+    LayerTile& window)
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    m_changed.wait(lock, [this]() {
+        return !m_ready.empty() || m_error || m_done;
+    });
+
+    if (m_ready.empty())
+    {
+        if (m_error)
+            std::rethrow_exception(m_error);
+
+        return false;
+    }
+
+    window = std::move(m_ready.front());
+    m_ready.pop_front();
+
+    lock.unlock();
+    m_changed.notify_all();
+
+    return true;
+}
+
+//! Retrieve the number of windows.
+/*!
+\return
+    The total number of windows the reader will return.
+*/
+size_t PrefetchReader::size() const noexcept
+{
+    return m_windows.size();
+}
+
+//! Read the windows, staying at most depth windows ahead of the caller.
+void PrefetchReader::run()
+{
+    for (auto& window : m_windows)
+    {
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_changed.wait(lock, [this]() {
+                return m_stop || m_ready.size() < m_depth;
+            });
+
+            if (m_stop)
+                break;
+        }
+
+        try
+        {
+            window.data = m_layer.read(window.rowStart, window.columnStart,
+                window.rowEnd, window.columnEnd);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_error = std::current_exception();
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_ready.push_back(std::move(window));
+        }
+        m_changed.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_done = true;
+    }
+    m_changed.notify_all();
+}
+
+}  // namespace BAG
+
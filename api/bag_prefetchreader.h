@@ -0,0 +1,90 @@
+#ifndef BAG_PREFETCHREADER_H
+#define BAG_PREFETCHREADER_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_layertiles.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Reads the next sections of a layer in a background thread.
+/*!
+    The reader walks a list of windows (by default, bands of whole rows) in
+    order.  A background thread keeps up to \e depth windows read ahead of the
+    caller, so decoding the next windows overlaps the caller's processing of
+    the current one.
+
+    The background thread reads through Layer::read().  Unless the BAG was
+    opened with OpenOptions::concurrentReads, nothing else may use the
+    Dataset while the reader is alive.
+*/
+class BAG_API PrefetchReader final
+{
+public:
+    PrefetchReader(const Layer& layer, uint32_t bandHeight, size_t depth = 2);
+    PrefetchReader(const Layer& layer, std::vector<LayerTile> windows,
+        size_t depth = 2);
+
+    ~PrefetchReader();
+
+    PrefetchReader(const PrefetchReader&) = delete;
+    PrefetchReader(PrefetchReader&&) = delete;
+
+    PrefetchReader& operator=(const PrefetchReader&) = delete;
+    PrefetchReader& operator=(PrefetchReader&&) = delete;
+
+    bool next(LayerTile& window);
+
+    size_t size() const noexcept;
+
+private:
+    static std::vector<LayerTile> makeBands(const Layer& layer,
+        uint32_t bandHeight);
+
+    void run();
+
+    //! The layer being read.
+    const Layer& m_layer;
+    //! The windows to read, in order; the data of each is filled when read.
+    std::vector<LayerTile> m_windows;
+    //! The maximum number of windows read ahead.
+    size_t m_depth = 0;
+    //! The windows read, but not handed to the caller yet.
+    std::deque<LayerTile> m_ready;
+    //! The first error from the background thread.
+    std::exception_ptr m_error;
+    //! Has the reader been told to stop?
+    bool m_stop = false;
+    //! Has the background thread finished?
+    bool m_done = false;
+    //! Guards the queue and flags.
+    std::mutex m_mutex;
+    //! Signals a change to the queue or flags.
+    std::condition_variable m_changed;
+    //! The background thread.
+    std::thread m_thread;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_PREFETCHREADER_H
+
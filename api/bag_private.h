@@ -1,8 +1,11 @@
 #ifndef BAG_PRIVATE_H
 #define BAG_PRIVATE_H
 
+#include "bag_correctionplan.h"
 #include "bag_dataset.h"
+#include "bag_trace.h"
 
+#include <chrono>
 #include <memory>
 
 
@@ -13,12 +16,141 @@ struct BagHandle
     std::shared_ptr<BAG::Dataset> dataset;
 };
 
+//! The state the C interface keeps between corrected reads of one BAG.
+struct BagCorrectionContext
+{
+    //! The BAG the context was created for.
+    const BAG::Dataset* dataset = nullptr;
+    //! Does the BAG have gridded correctors (so plan is used)?
+    bool isGridded = false;
+    //! The plan covering the whole BAG, for gridded correctors.
+    BAG::CorrectionPlan plan;
+};
+
+//! A layer of a BAG the C interface has looked up, for repeated reads.
+struct BagLayerHandle
+{
+    //! The BAG the layer belongs to.
+    const BAG::Dataset* dataset = nullptr;
+    //! The layer.
+    std::shared_ptr<const BAG::Layer> layer;
+};
+
 namespace BAG
 {
 
 //! The maximum compression level supported by HDF5.
 constexpr int kMaxCompressionLevel = 9;
 
+//! Adds the wall time of a scope to an IoStats phase.
+/*!
+    Does nothing, not even read the clock, without a phase to add to, so
+    timing costs nothing when I/O statistics are not collected.
+*/
+class IoTimer final
+{
+public:
+    //! Constructor.
+    /*!
+    \param pSeconds
+        The phase to add the time to; nullptr to not time the scope.
+    */
+    explicit IoTimer(double* pSeconds) noexcept
+        : m_pSeconds(pSeconds)
+    {
+        if (m_pSeconds)
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    //! Destructor; adds the time since construction.
+    ~IoTimer() noexcept
+    {
+        this->stop();
+    }
+
+    //! Add the time since construction now, instead of at the end of the scope.
+    void stop() noexcept
+    {
+        if (m_pSeconds)
+            *m_pSeconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - m_start).count();
+
+        m_pSeconds = nullptr;
+    }
+
+    IoTimer(const IoTimer&) = delete;
+    IoTimer(IoTimer&&) = delete;
+    IoTimer& operator=(const IoTimer&) = delete;
+    IoTimer& operator=(IoTimer&&) = delete;
+
+private:
+    //! The phase to add the time to; nullptr if not timing.
+    double* m_pSeconds = nullptr;
+    //! When the scope started.
+    std::chrono::steady_clock::time_point m_start;
+};
+
+//! Reports the begin and end of a scope to the TraceSink, if one is set.
+/*!
+    Without BAG_USE_TRACING (see the BAG_BUILD_TRACING CMake option) this
+    does nothing, and compiles away.
+*/
+class TraceScope final
+{
+public:
+#ifdef BAG_USE_TRACING
+    //! Constructor.
+    /*!
+    \param name
+        The name of the operation; a string literal.
+    \param layerName
+        The name of the layer operated on; nullptr if there is none.  It must
+        outlive the scope.
+    \param rows
+        The rows of the window read or written; 0 if there is none.
+    \param columns
+        The columns of the window read or written; 0 if there is none.
+    */
+    explicit TraceScope(const char* name, const char* layerName = nullptr,
+        uint32_t rows = 0, uint32_t columns = 0) noexcept
+        : m_pSink(getTraceSink())
+    {
+        if (!m_pSink)
+            return;
+
+        m_event.name = name;
+        m_event.layerName = layerName;
+        m_event.rows = rows;
+        m_event.columns = columns;
+        m_pSink->begin(m_event);
+    }
+
+    //! Destructor; reports the end of the scope.
+    ~TraceScope() noexcept
+    {
+        if (m_pSink)
+            m_pSink->end(m_event);
+    }
+#else
+    explicit TraceScope(const char*, const char* = nullptr, uint32_t = 0,
+        uint32_t = 0) noexcept
+    {}
+#endif
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope(TraceScope&&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    TraceScope& operator=(TraceScope&&) = delete;
+
+#ifdef BAG_USE_TRACING
+private:
+    //! The sink when the scope began; nullptr if not tracing.
+    TraceSink* m_pSink = nullptr;
+    //! The operation.
+    TraceEvent m_event;
+#endif
+};
+
 //! Path names for BAG entities
 #define ROOT_PATH                       "/BAG_root"
 #define METADATA_PATH                   ROOT_PATH "/metadata"
@@ -38,6 +170,10 @@ constexpr int kMaxCompressionLevel = 9;
 #define STANDARD_DEV_PATH	            ROOT_PATH "/standard_dev"
 #define NUM_SOUNDINGS_PATH              ROOT_PATH "/num_soundings"
 #define GEOREF_METADATA_PATH            ROOT_PATH "/georef_metadata/"
+#define OVERVIEWS_PATH                  ROOT_PATH "/overviews/"
+#define ZONE_MAPS_PATH                  ROOT_PATH "/zone_maps/"
+#define COVERAGE_PATH                   ROOT_PATH "/coverage/"
+#define CHUNK_HASHES_PATH               ROOT_PATH "/chunk_hashes"
 
 //! Path names for optional VR BAG entities
 #define VR_TRACKING_LIST_PATH           ROOT_PATH "/varres_tracking_list"
@@ -66,6 +202,7 @@ constexpr int kMaxCompressionLevel = 9;
 #define MAX_NOMINAL_ELEVATION           "max_value"                  /*!< Name for max nominal elevation attribute value*/
 #define MIN_AVERAGE                     "min_value"                  /*!< Name for min average attribute value */
 #define MAX_AVERAGE                     "max_value"                  /*!< Name for max average attribute value */
+#define QUANTIZATION_ERROR_BOUND        "Quantization Error Bound"   /*!< Name for the absolute error bound of a quantized layer */
 
 #define TRACKING_LIST_LENGTH_NAME       "Tracking List Length"       /*!< Name for the tracking list length attribute */
 
@@ -80,6 +217,7 @@ constexpr int kMaxCompressionLevel = 9;
 #define COMPOUND_KEYS                   "/keys"                      /*!<Name of the compound layer keys dataset */
 #define COMPOUND_VR_KEYS                "/varres_keys"               /*!<Name of the compound layer variable resolution keys dataset */
 #define COMPOUND_VALUES                 "/values"                    /*!<Name of the compound layer values dataset */
+#define COMPOUND_KEY_STATISTICS         "Key Statistics"             /*!<Name for the cached key statistics attribute */
 
 #define METADATA_PROFILE_TYPE           "Metadata Profile Type"
 #define METADATA_PROFILE_LEN            32
@@ -0,0 +1,73 @@
+
+#include "bag_exceptions.h"
+#include "bag_progress.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace BAG {
+
+//! Constructor.
+/*!
+\param callback
+    Called as the operation progresses.
+*/
+ProgressToken::ProgressToken(
+    Callback callback)
+    : m_callback(std::move(callback))
+{
+}
+
+//! Cancel the operation.
+/*!
+    The operation stops at the next chunk or band, and throws
+    OperationCancelled.
+*/
+void ProgressToken::cancel() noexcept
+{
+    m_cancelled = true;
+}
+
+//! Has the operation been cancelled?
+/*!
+\return
+    \e true if cancel() was called.
+*/
+bool ProgressToken::isCancelled() const noexcept
+{
+    return m_cancelled;
+}
+
+//! Retrieve the fraction of the operation last reported.
+/*!
+\return
+    The fraction, from 0 to 1.
+*/
+double ProgressToken::getFraction() const noexcept
+{
+    return m_fraction;
+}
+
+//! Report the progress of the operation, and stop it if it was cancelled.
+/*!
+    Called by the operation.
+
+\param fraction
+    The fraction of the operation done; clamped to 0 to 1.
+*/
+void ProgressToken::report(
+    double fraction)
+{
+    fraction = std::min(std::max(fraction, 0.), 1.);
+    m_fraction = fraction;
+
+    if (m_callback)
+        m_callback(fraction);
+
+    if (m_cancelled)
+        throw OperationCancelled{};
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,68 @@
+#ifndef BAG_PROGRESS_H
+#define BAG_PROGRESS_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+
+#include <atomic>
+#include <functional>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Follows the progress of a long operation, and cancels it.
+/*!
+    The long operations of the library (copying, exporting, mosaicking and
+    diffing BAGs, computing statistics, resampling variable resolution BAGs,
+    writing corrected layers, building overviews and catalogs) take an
+    optional token.  Between chunks or bands, they report how far they are,
+    and check whether the token was cancelled; if so, they throw
+    OperationCancelled.  What they wrote up to then is flushed, so a file
+    written by a cancelled operation is valid, with the part done.
+
+    cancel() may be called from any thread.  The callback is called on the
+    thread running the operation, which waits for it.
+*/
+class BAG_API ProgressToken final
+{
+public:
+    //! Called with the fraction of the operation done, from 0 to 1.
+    using Callback = std::function<void(double fraction)>;
+
+    ProgressToken() = default;
+    explicit ProgressToken(Callback callback);
+
+    ProgressToken(const ProgressToken&) = delete;
+    ProgressToken(ProgressToken&&) = delete;
+
+    ProgressToken& operator=(const ProgressToken&) = delete;
+    ProgressToken& operator=(ProgressToken&&) = delete;
+
+    void cancel() noexcept;
+    bool isCancelled() const noexcept;
+
+    double getFraction() const noexcept;
+    void report(double fraction);
+
+private:
+    //! Called as the operation progresses; may be empty.
+    Callback m_callback;
+    //! Has the operation been cancelled?
+    std::atomic<bool> m_cancelled{false};
+    //! The fraction of the operation last reported.
+    std::atomic<double> m_fraction{0.};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_PROGRESS_H
+
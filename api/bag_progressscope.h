@@ -0,0 +1,113 @@
+#ifndef BAG_PROGRESSSCOPE_H
+#define BAG_PROGRESSSCOPE_H
+
+#include "bag_progress.h"
+
+#include <cstdint>
+
+
+namespace BAG {
+
+//! Reports the progress of part of an operation to its ProgressToken.
+/*!
+    The part spans a range of the fraction of the whole operation, so an
+    operation made of steps hands each step a part of its own range.  With
+    no token, reporting does nothing.
+
+    Only the thread running the operation reports, between chunks or bands;
+    never the workers of processInBlocks(), which must not throw.
+*/
+class ProgressScope final
+{
+public:
+    //! Constructor.
+    /*!
+    \param pToken
+        The token of the operation; may be null.
+    \param start
+        The fraction of the operation done when the part starts.
+    \param end
+        The fraction of the operation done when the part ends.
+    */
+    explicit ProgressScope(
+        ProgressToken* pToken,
+        double start = 0.,
+        double end = 1.) noexcept
+        : m_pToken(pToken)
+        , m_start(start)
+        , m_end(end)
+    {
+    }
+
+    //! Retrieve a part of this part.
+    /*!
+    \param start
+        The amount of work done when the part starts.
+    \param end
+        The amount of work done when the part ends.
+    \param total
+        The amount of work in this part.
+
+    \return
+        The part.
+    */
+    ProgressScope part(
+        uint64_t start,
+        uint64_t end,
+        uint64_t total) const noexcept
+    {
+        if (total == 0)
+            return ProgressScope{m_pToken, m_end, m_end};
+
+        const auto span = m_end - m_start;
+
+        return ProgressScope{m_pToken,
+            m_start + span * static_cast<double>(start) / total,
+            m_start + span * static_cast<double>(end) / total};
+    }
+
+    //! Report how much of the part is done, and stop if cancelled.
+    /*!
+        Throws OperationCancelled if the operation was cancelled.
+
+    \param done
+        The amount of work done.
+    \param total
+        The amount of work in the part.
+    */
+    void report(
+        uint64_t done,
+        uint64_t total) const
+    {
+        if (!m_pToken)
+            return;
+
+        const auto fraction = total == 0 ? 1. :
+            static_cast<double>(done) / total;
+
+        m_pToken->report(m_start + (m_end - m_start) * fraction);
+    }
+
+    //! Stop if the operation was cancelled, without reporting progress.
+    /*!
+        Throws OperationCancelled if the operation was cancelled.
+    */
+    void check() const
+    {
+        if (m_pToken && m_pToken->isCancelled())
+            m_pToken->report(m_pToken->getFraction());
+    }
+
+private:
+    //! The token of the operation; may be null.
+    ProgressToken* m_pToken = nullptr;
+    //! The fraction of the operation done when the part starts.
+    double m_start = 0.;
+    //! The fraction of the operation done when the part ends.
+    double m_end = 1.;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_PROGRESSSCOPE_H
+
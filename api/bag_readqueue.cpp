@@ -0,0 +1,229 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_layer.h"
+#include "bag_readqueue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+
+namespace BAG {
+
+//! The reads of a queue; shared with the reads not done yet, so they can
+//! outlive the queue.
+struct ReadQueue::State final
+{
+    //! A read done.
+    struct Done final
+    {
+        //! The index of the window, in the order submitted.
+        size_t index = 0;
+        //! The window, with its data.
+        LayerTile window;
+        //! What the read threw; null if it succeeded.
+        std::exception_ptr error;
+    };
+
+    //! The reads done, but not handed out yet, the first done first.
+    std::deque<Done> done;
+    //! Has the queue been destroyed?
+    bool cancelled = false;
+    //! Guards the members.
+    std::mutex mutex;
+    //! Signals a read done.
+    std::condition_variable readDone;
+};
+
+//! Constructor.
+/*!
+\param executor
+    The executor to read on.
+*/
+ReadQueue::ReadQueue(
+    Executor& executor)
+    : m_executor(executor)
+    , m_pState(std::make_shared<State>())
+{
+}
+
+//! Destructor.
+/*!
+    The reads not started yet are skipped; those running finish on their
+    own.
+*/
+ReadQueue::~ReadQueue()
+{
+    const std::lock_guard<std::mutex> lock{m_pState->mutex};
+    m_pState->cancelled = true;
+}
+
+//! Read a window of a layer.
+/*!
+\param layer
+    The layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The index of the window, in the order submitted.
+*/
+size_t ReadQueue::submit(
+    const Layer& layer,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd)
+{
+    const auto pDataset = layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto index = m_numSubmitted;
+
+    // Holding the Dataset, which owns the layer, keeps the layer alive.
+    m_executor.post(pDataset.get(), [pState = m_pState, pDataset, &layer,
+        index, rowStart, columnStart, rowEnd, columnEnd]() {
+            State::Done done;
+            done.index = index;
+            done.window.rowStart = rowStart;
+            done.window.columnStart = columnStart;
+            done.window.rowEnd = rowEnd;
+            done.window.columnEnd = columnEnd;
+
+            {
+                const std::lock_guard<std::mutex> lock{pState->mutex};
+                if (pState->cancelled)
+                    return;
+            }
+
+            try
+            {
+                done.window.data = layer.read(rowStart, columnStart, rowEnd,
+                    columnEnd);
+            }
+            catch (...)
+            {
+                done.error = std::current_exception();
+            }
+
+            {
+                const std::lock_guard<std::mutex> lock{pState->mutex};
+                pState->done.push_back(std::move(done));
+            }
+
+            pState->readDone.notify_one();
+        });
+
+    ++m_numSubmitted;
+
+    return index;
+}
+
+//! Read windows of a layer.
+/*!
+\param layer
+    The layer.
+\param windows
+    The windows; their data is ignored.
+
+\return
+    The index of the first window, in the order submitted; the others
+    follow.
+*/
+size_t ReadQueue::submit(
+    const Layer& layer,
+    const std::vector<LayerTile>& windows)
+{
+    const auto first = m_numSubmitted;
+
+    for (const auto& window : windows)
+        this->submit(layer, window.rowStart, window.columnStart,
+            window.rowEnd, window.columnEnd);
+
+    return first;
+}
+
+//! Retrieve the next window read.
+/*!
+    Waits for a read to complete if none has.  A read that failed throws
+    what it threw instead; the next call goes on with the other reads.
+
+\param window
+    Set to the window, with its data.
+
+\return
+    \e true if a window was read.
+    \e false if every window submitted has been handed out.
+*/
+bool ReadQueue::next(
+    LayerTile& window)
+{
+    size_t index = 0;
+
+    return this->next(window, index);
+}
+
+//! Retrieve the next window read, and which it was.
+/*!
+    Waits for a read to complete if none has.  A read that failed throws
+    what it threw instead; the next call goes on with the other reads.
+
+\param window
+    Set to the window, with its data.
+\param index
+    Set to the index of the window, in the order submitted.
+
+\return
+    \e true if a window was read.
+    \e false if every window submitted has been handed out.
+*/
+bool ReadQueue::next(
+    LayerTile& window,
+    size_t& index)
+{
+    if (m_numHandedOut == m_numSubmitted)
+        return false;
+
+    State::Done done;
+    {
+        std::unique_lock<std::mutex> lock{m_pState->mutex};
+        m_pState->readDone.wait(lock,
+            [this]() { return !m_pState->done.empty(); });
+
+        done = std::move(m_pState->done.front());
+        m_pState->done.pop_front();
+    }
+
+    ++m_numHandedOut;
+
+    if (done.error)
+        std::rethrow_exception(done.error);
+
+    window = std::move(done.window);
+    index = done.index;
+
+    return true;
+}
+
+//! Retrieve the number of windows submitted.
+/*!
+\return
+    The number of windows submitted.
+*/
+size_t ReadQueue::size() const noexcept
+{
+    return m_numSubmitted;
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,73 @@
+#ifndef BAG_READQUEUE_H
+#define BAG_READQUEUE_H
+
+#include "bag_config.h"
+#include "bag_executor.h"
+#include "bag_fordec.h"
+#include "bag_layertiles.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Reads windows of layers on an executor, and hands them out as they are
+//! read.
+/*!
+    Windows may be submitted from any number of layers and BAGs.  The reads
+    of one Dataset run one at a time, in the order submitted (see Executor);
+    reads of different datasets may complete in any order.  next() waits for
+    the next read to complete, whichever it is.
+
+    Destroying the queue cancels the reads not started yet.
+*/
+class BAG_API ReadQueue final
+{
+public:
+    explicit ReadQueue(Executor& executor = Executor::global());
+    ~ReadQueue();
+
+    ReadQueue(const ReadQueue&) = delete;
+    ReadQueue(ReadQueue&&) = delete;
+
+    ReadQueue& operator=(const ReadQueue&) = delete;
+    ReadQueue& operator=(ReadQueue&&) = delete;
+
+    size_t submit(const Layer& layer, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd);
+    size_t submit(const Layer& layer, const std::vector<LayerTile>& windows);
+
+    bool next(LayerTile& window);
+    bool next(LayerTile& window, size_t& index);
+
+    size_t size() const noexcept;
+
+private:
+    struct State;
+
+    //! The executor the windows are read on.
+    Executor& m_executor;
+    //! The reads, shared with those not done yet.
+    std::shared_ptr<State> m_pState;
+    //! The number of windows submitted.
+    size_t m_numSubmitted = 0;
+    //! The number of windows handed out.
+    size_t m_numHandedOut = 0;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_READQUEUE_H
+
@@ -0,0 +1,186 @@
+
+#include "bag_rtree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+
+namespace BAG {
+
+namespace {
+
+//! The most children of a node.
+constexpr uint32_t kNodeCapacity = 16;
+
+//! Sort items into sort-tile-recursive order.
+/*!
+    The items are cut into about sqrt(n / kNodeCapacity) vertical slices by
+    the X of the centres of their boxes, and each slice is sorted by Y, so
+    each run of kNodeCapacity items covers a compact area.
+
+\param items
+    The items to sort.
+\param getBox
+    Called with an item to retrieve its box.
+*/
+template <typename GetBox>
+void sortTileRecursive(
+    std::vector<uint32_t>& items,
+    const GetBox& getBox)
+{
+    const auto numNodes = (items.size() + kNodeCapacity - 1) / kNodeCapacity;
+    const auto numSlices = static_cast<size_t>(std::ceil(std::sqrt(
+        static_cast<double>(numNodes))));
+    const auto sliceSize = std::max<size_t>(1, numSlices) * kNodeCapacity;
+
+    std::sort(items.begin(), items.end(), [&](uint32_t lhs, uint32_t rhs) {
+        const auto& lhsBox = getBox(lhs);
+        const auto& rhsBox = getBox(rhs);
+        return lhsBox.minX + lhsBox.maxX < rhsBox.minX + rhsBox.maxX;
+    });
+
+    for (size_t start=0; start<items.size(); start+=sliceSize)
+    {
+        const auto end = std::min(start + sliceSize, items.size());
+
+        std::sort(items.begin() + start, items.begin() + end,
+            [&](uint32_t lhs, uint32_t rhs) {
+                const auto& lhsBox = getBox(lhs);
+                const auto& rhsBox = getBox(rhs);
+                return lhsBox.minY + lhsBox.maxY < rhsBox.minY + rhsBox.maxY;
+            });
+    }
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+\param boxes
+    The boxes to index; a search finds a box by its index in boxes.
+*/
+RTree::RTree(
+    const std::vector<Box>& boxes)
+    : m_boxes(boxes)
+{
+    if (boxes.empty())
+        return;
+
+    // Pack runs of items into nodes.
+    const auto pack = [](size_t count, const auto& getBox) {
+        std::vector<Node> nodes;
+        nodes.reserve((count + kNodeCapacity - 1) / kNodeCapacity);
+
+        for (size_t first=0; first<count; first+=kNodeCapacity)
+        {
+            Node node;
+            node.first = static_cast<uint32_t>(first);
+            node.count = static_cast<uint32_t>(std::min<size_t>(kNodeCapacity,
+                count - first));
+            node.bounds = getBox(first);
+
+            for (size_t item=first+1; item<first+node.count; ++item)
+            {
+                const auto& box = getBox(item);
+                node.bounds.minX = std::min(node.bounds.minX, box.minX);
+                node.bounds.minY = std::min(node.bounds.minY, box.minY);
+                node.bounds.maxX = std::max(node.bounds.maxX, box.maxX);
+                node.bounds.maxY = std::max(node.bounds.maxY, box.maxY);
+            }
+
+            nodes.push_back(node);
+        }
+
+        return nodes;
+    };
+
+    m_entries.resize(boxes.size());
+    std::iota(m_entries.begin(), m_entries.end(), 0u);
+    sortTileRecursive(m_entries, [this](uint32_t item) -> const Box& {
+        return m_boxes[item];
+    });
+
+    auto level = pack(m_entries.size(), [this](size_t item) -> const Box& {
+        return m_boxes[m_entries[item]];
+    });
+
+    while (level.size() > 1)
+    {
+        // Order the nodes so each parent holds consecutive children.
+        std::vector<uint32_t> order(level.size());
+        std::iota(order.begin(), order.end(), 0u);
+        sortTileRecursive(order, [&level](uint32_t node) -> const Box& {
+            return level[node].bounds;
+        });
+
+        std::vector<Node> sorted;
+        sorted.reserve(level.size());
+        for (const auto node : order)
+            sorted.push_back(level[node]);
+
+        auto parents = pack(sorted.size(), [&sorted](size_t node) -> const Box& {
+            return sorted[node].bounds;
+        });
+
+        m_levels.push_back(std::move(sorted));
+        level = std::move(parents);
+    }
+
+    m_levels.push_back(std::move(level));
+}
+
+//! Find the boxes that meet a box.
+/*!
+\param box
+    The box searched for.
+
+\return
+    The indices of the boxes that meet it, in ascending order.
+*/
+std::vector<uint32_t> RTree::search(
+    const Box& box) const
+{
+    std::vector<uint32_t> found;
+    if (m_levels.empty())
+        return found;
+
+    // The nodes still to visit, as (level, node) pairs.
+    std::vector<std::pair<size_t, uint32_t>> pending{{m_levels.size() - 1, 0}};
+
+    while (!pending.empty())
+    {
+        const auto level = pending.back().first;
+        const auto& node = m_levels[level][pending.back().second];
+        pending.pop_back();
+
+        if (!node.bounds.intersects(box))
+            continue;
+
+        for (auto child=node.first; child<node.first+node.count; ++child)
+        {
+            if (level > 0)
+                pending.emplace_back(level - 1, child);
+            else if (m_boxes[m_entries[child]].intersects(box))
+                found.push_back(m_entries[child]);
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+
+    return found;
+}
+
+//! Retrieve the number of boxes indexed.
+/*!
+\return
+    The number of boxes indexed.
+*/
+size_t RTree::size() const noexcept
+{
+    return m_boxes.size();
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,72 @@
+#ifndef BAG_RTREE_H
+#define BAG_RTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace BAG {
+
+//! A static spatial index over axis aligned boxes.
+/*!
+    The tree is bulk loaded by sort-tile-recursive packing (Leutenegger et
+    al.): the boxes are cut into vertical slices by the X of their centres,
+    each slice is sorted by Y, and runs of boxes are packed into full nodes.
+    The nodes are packed the same way, level by level, up to a single root.
+    A search only visits the nodes whose bounds meet the box searched for.
+*/
+class RTree final
+{
+public:
+    //! An axis aligned box.
+    struct Box final
+    {
+        //! The western edge.
+        double minX = 0.;
+        //! The southern edge.
+        double minY = 0.;
+        //! The eastern edge.
+        double maxX = 0.;
+        //! The northern edge.
+        double maxY = 0.;
+
+        //! Do two boxes meet?
+        bool intersects(const Box& other) const noexcept
+        {
+            return minX <= other.maxX && other.minX <= maxX &&
+                minY <= other.maxY && other.minY <= maxY;
+        }
+    };
+
+    explicit RTree(const std::vector<Box>& boxes);
+
+    std::vector<uint32_t> search(const Box& box) const;
+
+    size_t size() const noexcept;
+
+private:
+    //! A node of the tree.
+    struct Node final
+    {
+        //! The bounds of the children.
+        Box bounds;
+        //! The first child; a node of the level below, or an entry of a
+        //! leaf.
+        uint32_t first = 0;
+        //! The number of children.
+        uint32_t count = 0;
+    };
+
+    //! The boxes indexed.
+    std::vector<Box> m_boxes;
+    //! The indices of the boxes, in the order of the leaves.
+    std::vector<uint32_t> m_entries;
+    //! The nodes of each level, the leaves first and the root last.
+    std::vector<std::vector<Node>> m_levels;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_RTREE_H
+
@@ -0,0 +1,212 @@
+
+#include "bag_sharedmemory.h"
+
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace BAG {
+
+namespace {
+
+//! Make the name of a segment portable.
+/*!
+\param name
+    The name of the segment.
+
+\return
+    The name, starting with a single slash as POSIX requires.
+*/
+std::string getSegmentName(
+    const std::string& name)
+{
+    return name.empty() || name.front() != '/' ? '/' + name : name;
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+\param pData
+    The first byte of the mapping.
+\param size
+    The number of bytes in the mapping.
+*/
+SharedMemorySegment::SharedMemorySegment(
+    uint8_t* pData,
+    size_t size) noexcept
+    : m_pData(pData)
+    , m_size(size)
+{
+}
+
+//! Destructor.
+/*!
+    Unmaps the segment; it is not removed.
+*/
+SharedMemorySegment::~SharedMemorySegment() noexcept
+{
+#ifndef _WIN32
+    ::munmap(m_pData, m_size);
+#endif
+}
+
+//! Create a segment, to be written to.
+/*!
+    The segment is filled with zeros.  It is readable and writable by the
+    user only.
+
+\param name
+    The name of the segment.
+\param size
+    The number of bytes in the segment.
+
+\return
+    The segment, mapped read and write.
+    nullptr if the segment already exists, or could not be created.
+*/
+std::unique_ptr<SharedMemorySegment> SharedMemorySegment::create(
+    const std::string& name,
+    size_t size) noexcept
+{
+#ifdef _WIN32
+    (void)name;
+    (void)size;
+
+    return {};
+#else
+    if (size == 0)
+        return {};
+
+    std::string segmentName;
+    try
+    {
+        segmentName = getSegmentName(name);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return {};
+    }
+
+    const auto fd = ::shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR,
+        S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return {};
+
+    void* pMapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+        pMapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    ::close(fd);
+
+    if (pMapping == MAP_FAILED)
+    {
+        ::shm_unlink(segmentName.c_str());
+        return {};
+    }
+
+    std::unique_ptr<SharedMemorySegment> pSegment{new (std::nothrow)
+        SharedMemorySegment{static_cast<uint8_t*>(pMapping), size}};
+    if (!pSegment)
+    {
+        ::munmap(pMapping, size);
+        ::shm_unlink(segmentName.c_str());
+    }
+
+    return pSegment;
+#endif
+}
+
+//! Attach to a segment, read only.
+/*!
+\param name
+    The name of the segment.
+
+\return
+    The whole segment, mapped read only.
+    nullptr if there is no such segment, or it could not be mapped.
+*/
+std::unique_ptr<SharedMemorySegment> SharedMemorySegment::attach(
+    const std::string& name) noexcept
+{
+#ifdef _WIN32
+    (void)name;
+
+    return {};
+#else
+    std::string segmentName;
+    try
+    {
+        segmentName = getSegmentName(name);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return {};
+    }
+
+    const auto fd = ::shm_open(segmentName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return {};
+
+    struct stat status{};
+    if (::fstat(fd, &status) != 0 || status.st_size <= 0)
+    {
+        ::close(fd);
+        return {};
+    }
+
+    // The mapping keeps the segment open.
+    const auto size = static_cast<size_t>(status.st_size);
+    auto* pMapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (pMapping == MAP_FAILED)
+        return {};
+
+    std::unique_ptr<SharedMemorySegment> pSegment{new (std::nothrow)
+        SharedMemorySegment{static_cast<uint8_t*>(pMapping), size}};
+    if (!pSegment)
+        ::munmap(pMapping, size);
+
+    return pSegment;
+#endif
+}
+
+//! Remove a segment.
+/*!
+    Processes attached to the segment keep it until they unmap it.
+
+\param name
+    The name of the segment.
+
+\return
+    \e true if the segment was removed.
+    \e false if there was no such segment.
+*/
+bool SharedMemorySegment::remove(
+    const std::string& name) noexcept
+{
+#ifdef _WIN32
+    (void)name;
+
+    return false;
+#else
+    try
+    {
+        return ::shm_unlink(getSegmentName(name).c_str()) == 0;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+#endif
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,72 @@
+#ifndef BAG_SHAREDMEMORY_H
+#define BAG_SHAREDMEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace BAG {
+
+//! A named shared memory segment, mapped into this process.
+/*!
+    A segment is created, filled and left in place by one process, and
+    attached read only by others; it exists until it is removed, even after
+    every process has unmapped it.
+
+    Only available on POSIX systems; elsewhere create() and attach() always
+    fail.
+*/
+class SharedMemorySegment final
+{
+public:
+    static std::unique_ptr<SharedMemorySegment> create(const std::string& name,
+        size_t size) noexcept;
+    static std::unique_ptr<SharedMemorySegment> attach(
+        const std::string& name) noexcept;
+    static bool remove(const std::string& name) noexcept;
+
+    ~SharedMemorySegment() noexcept;
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment(SharedMemorySegment&&) = delete;
+
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(SharedMemorySegment&&) = delete;
+
+    //! Retrieve the first byte of the segment.
+    /*!
+        Only a segment that was created may be written to.
+
+    \return
+        The first byte of the segment.
+    */
+    uint8_t* data() const noexcept
+    {
+        return m_pData;
+    }
+
+    //! Retrieve the size of the segment.
+    /*!
+    \return
+        The number of bytes in the segment.
+    */
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+private:
+    SharedMemorySegment(uint8_t* pData, size_t size) noexcept;
+
+    //! The first byte of the mapping.
+    uint8_t* m_pData = nullptr;
+    //! The number of bytes in the mapping.
+    size_t m_size = 0;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_SHAREDMEMORY_H
+
@@ -1,16 +1,283 @@
 
+#include "bag_accesstracer.h"
 #include "bag_attributeinfo.h"
+#include "bag_coverage.h"
+#include "bag_dataset.h"
+#include "bag_directchunk.h"
+#include "bag_exceptions.h"
+#include "bag_filestamp.h"
+#include "bag_hdfhelper.h"
+#include "bag_layertraits.h"
+#include "bag_mappedregion.h"
+#include "bag_minmax.h"
+#include "bag_mpi.h"
+#include "bag_overview.h"
+#include "bag_parallel.h"
 #include "bag_private.h"
+#include "bag_progressscope.h"
 #include "bag_simplelayer.h"
 #include "bag_simplelayerdescriptor.h"
+#include "bag_statistics.h"
+#include "bag_tilecache.h"
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstring>  // memcpy
 #include <H5Cpp.h>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <zlib.h>
 
 
 namespace BAG {
 
+namespace {
+
+//! A chunk being prepared for a direct write.
+/*!
+\tparam T
+    The type of the elements.
+*/
+template <typename T>
+struct DirectChunk final
+{
+    //! The elements of the chunk; the parts past the area written are 0.
+    std::vector<uint8_t> raw;
+    //! The shuffled bytes of raw.
+    std::vector<uint8_t> shuffled;
+    //! The deflated chunk.
+    std::vector<uint8_t> deflated;
+    //! The data to write; one of the above.
+    const uint8_t* data = nullptr;
+    //! The number of bytes of data.
+    size_t size = 0;
+    //! The filter mask of data.
+    uint32_t filterMask = 0;
+    //! Did deflate run out of memory?
+    bool failed = false;
+    //! Is the chunk allocated in the file?
+    bool allocated = true;
+    //! Is the chunk left unallocated, as it holds only the fill value?
+    bool skipped = false;
+    //! The min/max of the non null elements.
+    MinMax<T> minMax;
+};
+
+//! The most nodes of a layer read at once when building its overviews.
+constexpr size_t kOverviewBandCells = size_t{1} << 22;
+
+//! The most nodes of a layer read at once by updateMinMax().
+constexpr size_t kMinMaxBandCells = size_t{1} << 22;
+
+//! The most nodes of a layer read at once by readDecimated().
+constexpr size_t kDecimateBandCells = size_t{1} << 22;
+
+//! The most nodes of a layer, or bytes of its coverage bitmap, read at once
+//! when building or reading the bitmap.
+constexpr size_t kCoverageBandCells = size_t{1} << 22;
+
+//! The rows, and bytes of a row, of a chunk of a coverage bitmap.
+constexpr hsize_t kCoverageChunkDim = 256;
+
+//! A record of the zone map of a layer; the summary of a tile.
+struct ZoneMapRecord final
+{
+    //! The smallest non null value.
+    float min;
+    //! The largest non null value.
+    float max;
+    //! The number of non null nodes.
+    uint32_t count;
+    //! Non zero if min, max and count are only bounds.
+    uint8_t dirty;
+};
+
+//! Create the HDF5 type of a ZoneMapRecord.
+/*!
+\return
+    The compound type, used in memory and in the file.
+*/
+::H5::CompType createZoneMapType()
+{
+    ::H5::CompType h5type{sizeof(ZoneMapRecord)};
+    h5type.insertMember("min", HOFFSET(ZoneMapRecord, min),
+        ::H5::PredType::NATIVE_FLOAT);
+    h5type.insertMember("max", HOFFSET(ZoneMapRecord, max),
+        ::H5::PredType::NATIVE_FLOAT);
+    h5type.insertMember("count", HOFFSET(ZoneMapRecord, count),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type.insertMember("dirty", HOFFSET(ZoneMapRecord, dirty),
+        ::H5::PredType::NATIVE_UINT8);
+
+    return h5type;
+}
+
+//! The most nodes of a layer read at once by computeStatistics().
+constexpr size_t kStatisticsBandCells = size_t{1} << 22;
+
+//! The statistics of a tile of a layer, being gathered by
+//! computeStatistics().
+struct TileStatistics final
+{
+    //! The number of null nodes.
+    uint64_t nullCount = 0;
+    //! The smallest non null value.
+    double min = std::numeric_limits<double>::max();
+    //! The largest non null value.
+    double max = std::numeric_limits<double>::lowest();
+    //! The count, mean and variance of the non null values.
+    Moments moments;
+    //! The histogram of the non null values.
+    Histogram histogram;
+    //! The digest of the non null values; only added to if percentiles
+    //! were asked for.
+    TDigest digest;
+    //! Did the digest run out of memory?
+    bool failed = false;
+};
+
+//! The most nodes of a layer read at once by findCells().
+constexpr size_t kFindCellsBandCells = size_t{1} << 22;
+
+//! The number of values findCells() compares at once, before looking at
+//! them one by one if any is in the range.
+constexpr uint32_t kFindCellsBlockSize = 8;
+
+//! The nodes of a tile found by findCells().
+struct TileCells final
+{
+    //! The nodes, in row major order.
+    std::vector<LayerCell> cells;
+    //! Did adding a node run out of memory?
+    bool failed = false;
+};
+
+//! Write a statistic as an attribute of a layer, replacing any already there.
+/*!
+\param h5dataSet
+    The HDF5 DataSet of the layer.
+\param name
+    The name of the attribute.
+\param h5type
+    The HDF5 type of the values, in memory and in the file.
+\param values
+    The values.
+\param count
+    The number of values; the attribute is a scalar if it is 1.
+*/
+void writeStatisticsAttribute(
+    const ::H5::DataSet& h5dataSet,
+    const char* name,
+    const ::H5::PredType& h5type,
+    const void* values,
+    size_t count)
+{
+    if (h5dataSet.attrExists(name))
+        h5dataSet.removeAttr(name);
+
+    const hsize_t dims = count;
+    const auto h5dataSpace = count == 1 ? ::H5::DataSpace{} :
+        ::H5::DataSpace{1, &dims};
+
+    const auto attribute = h5dataSet.createAttribute(name, h5type,
+        h5dataSpace);
+    if (count > 0)
+        attribute.write(h5type, values);
+}
+
+//! The most chunks between those a batch of samples needs that are read
+//! with them, rather than starting another read.
+constexpr uint32_t kMaxSampleGapChunks = 2;
+
+//! The nodes around a position sampled by SimpleLayer::sampleInto().
+struct SamplePosition final
+{
+    //! The row of the south west node.
+    uint32_t row = 0;
+    //! The column of the south west node.
+    uint32_t column = 0;
+    //! How far north of the node the position is, in rows; 0 for the nearest
+    //! node.
+    double rowFraction = 0.;
+    //! How far east of the node the position is, in columns.
+    double columnFraction = 0.;
+};
+
+//! The chunks of a row of chunks decoded by SimpleLayer::sampleInto().
+struct SampledChunkRow final
+{
+    //! Forget the chunks decoded, and start on another row of chunks.
+    /*!
+    \param chunkRow
+        The row of chunks.
+    \param numChunkColumns
+        The number of chunks in a row.
+    */
+    void reset(
+        uint32_t chunkRow,
+        uint32_t numChunkColumns)
+    {
+        index = chunkRow;
+        reads.clear();
+        chunks.assign(numChunkColumns, nullptr);
+        strides.assign(numChunkColumns, 0);
+    }
+
+    //! The row of chunks.
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    //! The nodes of each read, row by row.
+    std::vector<std::vector<float>> reads;
+    //! The first node of each chunk decoded, at its first row and column;
+    //! nullptr if the chunk is not decoded.
+    std::vector<const float*> chunks;
+    //! The distance, in nodes, between the rows of each chunk decoded.
+    std::vector<size_t> strides;
+};
+
+//! Set the bits of a row of a coverage bitmap from the nodes of the row.
+/*!
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param values
+    The nodes of the row.
+\param columnStart
+    The column of the first node.
+\param columns
+    The number of nodes.
+\param row
+    The row of the bitmap, from the byte holding columnStart; the bits of
+    the nodes are set if they are not null, and cleared otherwise.
+*/
+template <typename Traits>
+void packCoverage(
+    const typename Traits::value_type* values,
+    uint32_t columnStart,
+    uint32_t columns,
+    uint8_t* row) noexcept
+{
+    const auto firstBit = columnStart % 8;
+
+    for (uint32_t column=0; column<columns; ++column)
+    {
+        const auto bit = firstBit + column;
+        const auto mask = static_cast<uint8_t>(1u << (bit % 8));
+
+        if (Traits::isNull(values[column]))
+            row[bit / 8] &= static_cast<uint8_t>(~mask);
+        else
+            row[bit / 8] |= mask;
+    }
+}
+
+}  // namespace
+
 //! Constructor.
 /*!
 \param dataset
@@ -25,8 +292,16 @@ SimpleLayer::SimpleLayer(
     SimpleLayerDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(pH5dataSet))
 {
+    m_pH5fileType = std::unique_ptr<::H5::DataType, DeleteH5dataType>(
+        new ::H5::DataType{m_pH5dataSet->getDataType()}, DeleteH5dataType{});
+    m_pH5memType = std::unique_ptr<::H5::DataType, DeleteH5dataType>(
+        new ::H5::DataType{H5Tget_native_type(m_pH5fileType->getId(),
+            H5T_DIR_ASCEND)}, DeleteH5dataType{});
+    m_pH5fileDataSpace = std::unique_ptr<::H5::DataSpace, DeleteH5dataSpace>(
+        new ::H5::DataSpace{m_pH5dataSet->getSpace()}, DeleteH5dataSpace{});
 }
 
 //! Create a new simple layer.
@@ -35,10 +310,12 @@ SimpleLayer::SimpleLayer(
     The BAG Dataset this layer belongs to.
 \param type
     The type of layer.
-\param chunkSize
-    The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param quantization
+    How the values are quantized before they are stored.
 
 \return
     The new simple layer.
@@ -46,11 +323,18 @@ SimpleLayer::SimpleLayer(
 std::shared_ptr<SimpleLayer> SimpleLayer::create(
     Dataset& dataset,
     LayerType type,
-    uint64_t chunkSize,
-    int compressionLevel)
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression,
+    const Quantization& quantization)
 {
-    auto descriptor = SimpleLayerDescriptor::create(dataset, type, chunkSize,
-        compressionLevel);
+    auto descriptor = SimpleLayerDescriptor::create(dataset, type,
+        chunkShape.rows, compression.level);
+    descriptor->setCompressionSpec(compression);
+    descriptor->setQuantization(quantization);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = dataset.getDescriptor().getDims();
+    descriptor->setChunkShape(chunkShape, numRows, numColumns);
     auto h5dataSet = SimpleLayer::createH5dataSet(dataset, *descriptor);
 
     return std::make_shared<SimpleLayer>(dataset, *descriptor, std::move(h5dataSet));
@@ -61,7 +345,8 @@ std::shared_ptr<SimpleLayer> SimpleLayer::create(
 \param dataset
     The BAG Dataset this layer belongs to.
 \param descriptor
-    The descriptor of this layer.
+    The descriptor of this layer; its attributes were read when the BAG
+    was opened.
 
 \return
     The specified simple layer.
@@ -72,16 +357,15 @@ std::shared_ptr<SimpleLayer> SimpleLayer::open(
 {
     const auto& h5file = dataset.getH5file();
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(descriptor.getInternalPath())},
+        new ::H5::DataSet{h5file.openDataSet(descriptor.getInternalPath(),
+            dataset.getH5dataSetAccessPropList(descriptor.getLayerType()))},
         DeleteH5dataSet{});
 
-    // Read the min/max attribute values.
-    const auto possibleMinMax = dataset.getMinMax(descriptor.getLayerType());
-    if (std::get<0>(possibleMinMax))
-        descriptor.setMinMax(std::get<1>(possibleMinMax),
-            std::get<2>(possibleMinMax));
+    auto pLayer = std::make_shared<SimpleLayer>(dataset, descriptor,
+        std::move(h5dataSet));
+    pLayer->loadZoneMap(h5file);
 
-    return std::make_shared<SimpleLayer>(dataset, descriptor,std::move(h5dataSet));
+    return pLayer;
 }
 
 
@@ -118,18 +402,27 @@ SimpleLayer::createH5dataSet(
     h5createPropList.setFillValue(h5dataType, &kFillValue);
 
     // Use chunk size and compression level from the descriptor.
-    const auto compressionLevel = descriptor.getCompressionLevel();
-    const auto chunkSize = descriptor.getChunkSize();
-    if (chunkSize > 0)
+    const auto& compression = descriptor.getCompressionSpec();
+    const auto& quantization = descriptor.getQuantization();
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = descriptor.getChunkDims();
+    if (chunkRows > 0 && chunkColumns > 0)
     {
-        const std::array<hsize_t, kRank> chunkDims{chunkSize, chunkSize};
+        const std::array<hsize_t, kRank> chunkDims{chunkRows, chunkColumns};
         h5createPropList.setChunk(kRank, chunkDims.data());
 
-        if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-            h5createPropList.setDeflate(compressionLevel);
+        BAG::setQuantization(h5createPropList, quantization);
+        setCompression(h5createPropList, compression);
     }
-    else if (compressionLevel > 0)
+    else if (compression.isCompressed())
         throw CompressionNeedsChunkingSet{};
+    else if (quantization.isQuantized())
+        throw QuantizationNeedsChunkingSet{};
+    else if (dataset.getCreationProfile() == CreationProfile::NoFill)
+        // The whole layer is allocated by its first write; the caller writes
+        // every node, so do not fill it first.  The fill value is still
+        // recorded.
+        h5createPropList.setFillTime(H5D_FILL_TIME_NEVER);
 
     // Create the DataSet using the above.
     const auto& h5file = dataset.getH5file();
@@ -157,9 +450,60 @@ SimpleLayer::createH5dataSet(
     constexpr float maxElev = std::numeric_limits<float>::lowest();
     maxElevAtt.write(attInfo.h5type, &maxElev);
 
+    // Record the error bound of a quantized layer.
+    if (quantization.isQuantized())
+    {
+        const auto errorBoundAtt = pH5dataSet->createAttribute(
+            QUANTIZATION_ERROR_BOUND, ::H5::PredType::NATIVE_DOUBLE,
+            ::H5::DataSpace{});
+        errorBoundAtt.write(::H5::PredType::NATIVE_DOUBLE,
+            &quantization.absErrorBound);
+    }
+
     return pH5dataSet;
 }
 
+//! Quantize the values of a layer which has not been written yet.
+/*!
+    The mandatory Elevation and Uncertainty layers are created with the
+    Dataset, so they are quantized with this before they are written.
+    HDF5 filters are fixed when a DataSet is created, so the DataSet of the
+    layer is created again.
+
+\param quantization
+    How the values are quantized before they are stored.
+    QuantizationNeedsChunkingSet is thrown if the layer is not chunked.
+*/
+void SimpleLayer::setQuantization(
+    const Quantization& quantization)
+{
+    if (this->getDataset().expired())
+        throw DatasetNotFound{};
+
+    const auto pDataset = this->getDataset().lock();
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    if (quantization == m_descriptor.getQuantization())
+        return;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+    if (quantization.isQuantized() && (chunkRows == 0 || chunkColumns == 0))
+        throw QuantizationNeedsChunkingSet{};
+
+    const auto lock = pDataset->lockReads();
+
+    // A chunked DataSet stores nothing until it is written.
+    if (m_pH5dataSet->getStorageSize() > 0)
+        throw QuantizationNeedsEmptyLayer{};
+
+    pDataset->getH5file().unlink(m_descriptor.getInternalPath());
+
+    m_descriptor.setQuantization(quantization);
+    m_pH5dataSet = SimpleLayer::createH5dataSet(*pDataset, m_descriptor);
+}
+
 //! \copydoc Layer::read
 UInt8Array SimpleLayer::readProxy(
     uint32_t rowStart,
@@ -167,112 +511,3749 @@ UInt8Array SimpleLayer::readProxy(
     uint32_t rowEnd,
     uint32_t columnEnd) const
 {
-    // Query the file for the specified rows and columns.
-    const auto h5fileDataSpace = m_pH5dataSet->getSpace();
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    // Allocate the output buffer; the read overwrites all of it.
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
+
+    this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+        buffer.data(), columns * m_descriptor.getElementSize());
+
+    return buffer;
+}
+
+//! \copydoc Layer::readInto
+void SimpleLayer::readIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    // Uncompressed, contiguous layers of read only BAGs are copied straight
+    // from a memory map of the file.
+    if (const auto* mappedData = this->getMappedData())
+    {
+        const size_t elementSize = m_descriptor.getElementSize();
+        const auto rowBytes = (columnEnd - columnStart + 1) * elementSize;
+
+        if (rowStrideBytes == 0)
+            rowStrideBytes = rowBytes;
+
+        for (auto row=rowStart; row<=rowEnd; ++row)
+            std::memcpy(buffer + (row - rowStart) * rowStrideBytes,
+                mappedData + row * m_mappedRowBytes + columnStart * elementSize,
+                rowBytes);
+
+        return;
+    }
+
+    if (this->readCachedTiles(rowStart, columnStart, rowEnd, columnEnd,
+        buffer, rowStrideBytes))
+        return;
+
+    this->readFromFile(rowStart, columnStart, rowEnd, columnEnd, buffer,
+        rowStrideBytes);
+}
+
+//! Read an area of the layer from the file.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    Where the elements are read to, row by row.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in the buffer; 0
+    if the rows are packed.
+*/
+void SimpleLayer::readFromFile(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    const auto pDataset = this->getDataset().lock();
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+
+    // Large reads of deflated layers are decompressed on several threads,
+    // unless the chunks may be written by other processes.
+    if (!pDataset->isParallel() &&
+        readChunksDirect(*m_pH5dataSet, *m_pH5memType, rowStart, columnStart,
+            rowEnd, columnEnd, buffer, rowStrideBytes, pStats))
+        return;
 
+    // Query the file for the specified rows and columns.
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
     const std::array<hsize_t, kRank> count{rows, columns};
     const std::array<hsize_t, kRank> offset{rowStart, columnStart};
 
-    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
-
-    // Initialize the output buffer.
-    const auto bufferSize = this->getDescriptor()->getReadBufferSize(rows,
-        columns);
-    UInt8Array buffer{bufferSize};
+    IoTimer selectionTimer{pStats ? &pStats->selectionSeconds : nullptr};
 
-    // Prepare the memory space.
-    const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
+    m_pH5fileDataSpace->selectHyperslab(H5S_SELECT_SET, count.data(),
+        offset.data());
+    const auto& h5memDataSpace = this->getH5memDataSpace(rows, columns,
+        rowStrideBytes);
 
-    m_pH5dataSet->read(buffer.data(), H5Dget_type(m_pH5dataSet->getId()),
-        h5memSpace, h5fileDataSpace);
+    selectionTimer.stop();
+    IoTimer readTimer{pStats ? &pStats->hdf5ReadSeconds : nullptr};
 
-    return buffer;
+    m_pH5dataSet->read(buffer, *m_pH5memType, h5memDataSpace,
+        *m_pH5fileDataSpace);
 }
 
-//! \copydoc Layer::writeAttributes
-void SimpleLayer::writeAttributesProxy() const
+//! \copydoc Layer::readWindowsProxy
+/*!
+    Unless the layer is read from a memory map or through the TileCache, the
+    windows are read in one HDF5 read of the union of them, so every chunk
+    they touch is decoded once, and copied from it to their places.
+*/
+void SimpleLayer::readWindowsProxy(
+    const std::vector<LayerWindow>& windows,
+    const std::vector<size_t>& offsets,
+    uint8_t* buffer) const
 {
-    auto pDescriptor = this->getDescriptor();
-    const auto attInfo = getAttributeInfo(pDescriptor->getLayerType());
+    if (windows.size() < 2 || this->getMappedData() ||
+        (TileCache::global().getLimit() > 0 &&
+            this->getTileCacheLayerId() != 0))
+    {
+        for (size_t i=0; i<windows.size(); ++i)
+            this->readIntoProxy(windows[i].rowStart, windows[i].columnStart,
+                windows[i].rowEnd, windows[i].columnEnd, buffer + offsets[i],
+                0);
 
-    // Write any attributes, from the layer descriptor.
-    // min value
-    const auto minMax = pDescriptor->getMinMax();
+        return;
+    }
 
-    const auto minAtt = m_pH5dataSet->openAttribute(attInfo.minName);
-    minAtt.write(attInfo.h5type, &std::get<0>(minMax));
+    // A run of columns selected in a row, and where it is read to.
+    struct Run final
+    {
+        uint32_t columnStart;
+        uint32_t columnEnd;
+        size_t offset;
+    };
 
-    // max value
-    const auto maxAtt = m_pH5dataSet->openAttribute(attInfo.maxName);
-    maxAtt.write(attInfo.h5type, &std::get<1>(minMax));
+    // HDF5 reads a union of hyperslabs row by row, each row's columns in
+    // order, once however many windows select them.
+    std::map<uint32_t, std::vector<Run>> rowRuns;
+    for (const auto& window : windows)
+        for (auto row=window.rowStart; row<=window.rowEnd; ++row)
+            rowRuns[row].push_back({window.columnStart, window.columnEnd, 0});
+
+    size_t numElements = 0;
+    for (auto& entry : rowRuns)
+    {
+        auto& runs = entry.second;
+        std::sort(runs.begin(), runs.end(), [](const Run& lhs, const Run& rhs) {
+            return lhs.columnStart < rhs.columnStart;
+        });
+
+        size_t numMerged = 0;
+        for (const auto& run : runs)
+        {
+            if (numMerged > 0 &&
+                run.columnStart <= runs[numMerged - 1].columnEnd + 1)
+                runs[numMerged - 1].columnEnd = std::max(
+                    runs[numMerged - 1].columnEnd, run.columnEnd);
+            else
+                runs[numMerged++] = run;
+        }
+        runs.resize(numMerged);
+
+        for (auto& run : runs)
+        {
+            run.offset = numElements;
+            numElements += run.columnEnd - run.columnStart + 1;
+        }
+    }
+
+    const auto pDataset = this->getDataset().lock();
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+
+    IoTimer selectionTimer{pStats ? &pStats->selectionSeconds : nullptr};
+
+    for (size_t i=0; i<windows.size(); ++i)
+    {
+        const auto& window = windows[i];
+        const std::array<hsize_t, kRank> count{
+            hsize_t{window.rowEnd} - window.rowStart + 1,
+            hsize_t{window.columnEnd} - window.columnStart + 1};
+        const std::array<hsize_t, kRank> offset{window.rowStart,
+            window.columnStart};
+
+        m_pH5fileDataSpace->selectHyperslab(i == 0 ? H5S_SELECT_SET :
+            H5S_SELECT_OR, count.data(), offset.data());
+    }
+
+    const hsize_t memCount = numElements;
+    const ::H5::DataSpace h5memDataSpace{1, &memCount};
+
+    selectionTimer.stop();
+
+    const size_t elementSize = m_descriptor.getElementSize();
+    auto selected = UInt8Array::uninitialized(numElements * elementSize);
+
+    {
+        const IoTimer readTimer{pStats ? &pStats->hdf5ReadSeconds : nullptr};
+
+        m_pH5dataSet->read(selected.data(), *m_pH5memType, h5memDataSpace,
+            *m_pH5fileDataSpace);
+    }
+
+    for (size_t i=0; i<windows.size(); ++i)
+    {
+        const auto& window = windows[i];
+        const auto rowBytes = (window.columnEnd - window.columnStart + 1) *
+            elementSize;
+        auto* pWindow = buffer + offsets[i];
+
+        for (auto row=window.rowStart; row<=window.rowEnd; ++row)
+        {
+            // The run holding the window's columns in the row.
+            const auto& runs = rowRuns[row];
+            const auto run = std::prev(std::upper_bound(runs.begin(),
+                runs.end(), window.columnStart,
+                [](uint32_t column, const Run& other) {
+                    return column < other.columnStart;
+                }));
+
+            std::memcpy(pWindow + (row - window.rowStart) * rowBytes,
+                selected.data() + (run->offset + window.columnStart -
+                    run->columnStart) * elementSize, rowBytes);
+        }
+    }
 }
 
-//! \copydoc Layer::write
-void SimpleLayer::writeProxy(
+//! Read an area of the layer through the TileCache.
+/*!
+    The tiles of the chunks covering the area are looked for in the cache.
+    Those missing are read from the file in one read of the chunks around
+    them, and cached.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    Where the elements are read to, row by row.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in the buffer; 0
+    if the rows are packed.
+
+\return
+    \e true if the area was read.
+    \e false if it must be read from the file, as there is no cache, the
+    tiles of the layer are not cached, or the area is too large to cache.
+*/
+bool SimpleLayer::readCachedTiles(
     uint32_t rowStart,
     uint32_t columnStart,
     uint32_t rowEnd,
     uint32_t columnEnd,
-    const uint8_t* buffer)
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
 {
-    auto h5fileDataSpace = m_pH5dataSet->getSpace();
+    auto& cache = TileCache::global();
+
+    const auto limit = cache.getLimit();
+    if (limit == 0)
+        return false;
+
+    const auto layerId = this->getTileCacheLayerId();
+    if (layerId == 0)
+        return false;
+
+    const size_t elementSize = m_descriptor.getElementSize();
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
 
-    // Make sure the area being written to does not exceed the file dimensions.
     std::array<hsize_t, kRank> fileDims{};
-    h5fileDataSpace.getSimpleExtentDims(fileDims.data());
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
 
-    if ((rowEnd >= fileDims[0]) || (columnEnd >= fileDims[1]))
-        throw InvalidWriteSize{};
+    const auto firstChunkRow = static_cast<uint32_t>(rowStart / chunkRows);
+    const auto lastChunkRow = static_cast<uint32_t>(rowEnd / chunkRows);
+    const auto firstChunkColumn =
+        static_cast<uint32_t>(columnStart / chunkColumns);
+    const auto lastChunkColumn =
+        static_cast<uint32_t>(columnEnd / chunkColumns);
+    const size_t numChunkRows = lastChunkRow - firstChunkRow + 1;
+    const size_t numChunkColumns = lastChunkColumn - firstChunkColumn + 1;
+
+    // A large read would push out the tiles in use.
+    if (numChunkRows * chunkRows * numChunkColumns * chunkColumns *
+        elementSize > limit / 4)
+        return false;
+
+    // The rows and columns of a chunk inside the layer.
+    const auto getTileRows = [&](uint32_t chunkRow) {
+        return static_cast<uint32_t>(std::min<uint64_t>(chunkRows,
+            fileDims[0] - chunkRow * chunkRows));
+    };
+    const auto getTileColumns = [&](uint32_t chunkColumn) {
+        return static_cast<uint32_t>(std::min<uint64_t>(chunkColumns,
+            fileDims[1] - chunkColumn * chunkColumns));
+    };
+
+    // Find the cached tiles, and the chunks around those missing.
+    std::vector<TileCache::Tile> tiles(numChunkRows * numChunkColumns);
+    uint32_t firstMissingRow = lastChunkRow, lastMissingRow = firstChunkRow;
+    uint32_t firstMissingColumn = lastChunkColumn;
+    uint32_t lastMissingColumn = firstChunkColumn;
+    bool missing = false;
+
+    for (auto chunkRow=firstChunkRow; chunkRow<=lastChunkRow; ++chunkRow)
+        for (auto chunkColumn=firstChunkColumn; chunkColumn<=lastChunkColumn;
+            ++chunkColumn)
+        {
+            auto& tile = tiles[(chunkRow - firstChunkRow) * numChunkColumns +
+                chunkColumn - firstChunkColumn];
+
+            tile = cache.find(layerId, chunkRow, chunkColumn);
+            if (tile)
+                continue;
+
+            missing = true;
+            firstMissingRow = std::min(firstMissingRow, chunkRow);
+            lastMissingRow = std::max(lastMissingRow, chunkRow);
+            firstMissingColumn = std::min(firstMissingColumn, chunkColumn);
+            lastMissingColumn = std::max(lastMissingColumn, chunkColumn);
+        }
+
+    if (missing)
+    {
+        // Read whole chunks, so each is decoded once.
+        const auto boxRowStart =
+            static_cast<uint32_t>(firstMissingRow * chunkRows);
+        const auto boxColumnStart =
+            static_cast<uint32_t>(firstMissingColumn * chunkColumns);
+        const auto boxRowEnd = boxRowStart - 1 + static_cast<uint32_t>(
+            (lastMissingRow - firstMissingRow) * chunkRows) +
+            getTileRows(lastMissingRow);
+        const auto boxColumnEnd = boxColumnStart - 1 +
+            static_cast<uint32_t>(
+                (lastMissingColumn - firstMissingColumn) * chunkColumns) +
+            getTileColumns(lastMissingColumn);
+        const auto boxRowBytes =
+            (boxColumnEnd - boxColumnStart + 1) * elementSize;
+
+        std::vector<uint8_t> box(
+            (boxRowEnd - boxRowStart + 1) * boxRowBytes);
+        this->readFromFile(boxRowStart, boxColumnStart, boxRowEnd,
+            boxColumnEnd, box.data(), boxRowBytes);
+
+        for (auto chunkRow=firstMissingRow; chunkRow<=lastMissingRow;
+            ++chunkRow)
+            for (auto chunkColumn=firstMissingColumn;
+                chunkColumn<=lastMissingColumn; ++chunkColumn)
+            {
+                auto& tile = tiles[(chunkRow - firstChunkRow) *
+                    numChunkColumns + chunkColumn - firstChunkColumn];
+                if (tile)
+                    continue;
+
+                const auto tileRows = getTileRows(chunkRow);
+                const auto tileRowBytes =
+                    getTileColumns(chunkColumn) * elementSize;
+                const auto* source = box.data() +
+                    (chunkRow - firstMissingRow) * chunkRows * boxRowBytes +
+                    (chunkColumn - firstMissingColumn) * chunkColumns *
+                        elementSize;
+
+                auto pTile = std::make_shared<std::vector<uint8_t>>(
+                    tileRows * tileRowBytes);
+                for (uint32_t row=0; row<tileRows; ++row)
+                    std::memcpy(pTile->data() + row * tileRowBytes,
+                        source + row * boxRowBytes, tileRowBytes);
+
+                tile = std::move(pTile);
+                cache.insert(layerId, chunkRow, chunkColumn, tile);
+            }
+    }
+
+    // Copy the part of each tile inside the area.
+    if (rowStrideBytes == 0)
+        rowStrideBytes = (columnEnd - columnStart + 1) * elementSize;
+
+    for (auto chunkRow=firstChunkRow; chunkRow<=lastChunkRow; ++chunkRow)
+    {
+        const auto tileRowStart = static_cast<uint32_t>(chunkRow * chunkRows);
+        const auto copyRowStart = std::max(rowStart, tileRowStart);
+        const auto copyRowEnd =
+            std::min(rowEnd, tileRowStart + getTileRows(chunkRow) - 1);
+
+        for (auto chunkColumn=firstChunkColumn; chunkColumn<=lastChunkColumn;
+            ++chunkColumn)
+        {
+            const auto& tile = *tiles[(chunkRow - firstChunkRow) *
+                numChunkColumns + chunkColumn - firstChunkColumn];
+
+            const auto tileColumnStart =
+                static_cast<uint32_t>(chunkColumn * chunkColumns);
+            const auto tileRowBytes =
+                getTileColumns(chunkColumn) * elementSize;
+            const auto copyColumnStart = std::max(columnStart,
+                tileColumnStart);
+            const auto copyColumnEnd = std::min(columnEnd,
+                tileColumnStart + getTileColumns(chunkColumn) - 1);
+            const auto copyBytes =
+                (copyColumnEnd - copyColumnStart + 1) * elementSize;
+
+            for (auto row=copyRowStart; row<=copyRowEnd; ++row)
+                std::memcpy(buffer + (row - rowStart) * rowStrideBytes +
+                        (copyColumnStart - columnStart) * elementSize,
+                    tile.data() + (row - tileRowStart) * tileRowBytes +
+                        (copyColumnStart - tileColumnStart) * elementSize,
+                    copyBytes);
+        }
+    }
+
+    return true;
+}
+
+//! Retrieve the id of the layer in the TileCache.
+/*!
+    The layers of BAGs read only with the default (sec2) file driver are
+    known by their file and path, so every Dataset opened on the same file
+    shares their tiles.  Other layers are known by this object.
+
+\return
+    The id of the layer.
+    0 if its tiles are not cached, as it is not chunked, or may be written
+    by other processes.
+*/
+uint64_t SimpleLayer::getTileCacheLayerId() const
+{
+    if (m_tileCacheLayerIdFound)
+        return m_tileCacheLayerId;
+
+    m_tileCacheLayerIdFound = true;
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset || pDataset->isParallel())
+        return 0;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+    if (chunkRows == 0 || chunkColumns == 0)
+        return 0;
+
+    auto& cache = TileCache::global();
+    const auto& h5file = pDataset->getH5file();
+
+    unsigned int intent = 0;
+    if (H5Fget_intent(h5file.getId(), &intent) >= 0 &&
+        intent == H5F_ACC_RDONLY &&
+        H5Pget_driver(h5file.getAccessPlist().getId()) == H5FD_SEC2)
+    {
+        // The size and modification time tell a file replaced apart.
+        const auto fileName = canonicalFileName(h5file.getFileName());
+        const auto stamp = statFile(fileName);
+
+        if (stamp.exists)
+        {
+            m_tileCacheLayerId = cache.getLayerId(fileName + '\n' +
+                std::to_string(stamp.size) + '\n' +
+                std::to_string(stamp.modified) + '\n' +
+                m_descriptor.getInternalPath());
+
+            return m_tileCacheLayerId;
+        }
+    }
+
+    m_tileCacheLayerId = cache.makeLayerId();
+
+    return m_tileCacheLayerId;
+}
+
+//! \copydoc Layer::readConvertedIntoProxy
+/*!
+    HDF5 converts the elements as it reads them, so there is no second pass
+    over the data.
+*/
+void SimpleLayer::readConvertedIntoProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    DataType type,
+    uint8_t* buffer,
+    size_t rowStrideBytes) const
+{
+    const auto pDataset = this->getDataset().lock();
+    auto* pStats = this->getCollectedIoStats(*pDataset);
 
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
     const std::array<hsize_t, kRank> count{rows, columns};
     const std::array<hsize_t, kRank> offset{rowStart, columnStart};
 
-    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+    IoTimer selectionTimer{pStats ? &pStats->selectionSeconds : nullptr};
 
-    // Prepare the memory space.
-    const ::H5::DataSpace h5memDataSpace{kRank, count.data(), count.data()};
+    m_pH5fileDataSpace->selectHyperslab(H5S_SELECT_SET, count.data(),
+        offset.data());
+    const auto h5memDataSpace = createH5memorySpace(rows, columns,
+        rowStrideBytes, Layer::getElementSize(type));
 
-    m_pH5dataSet->write(buffer, H5Dget_type(m_pH5dataSet->getId()),
-        h5memDataSpace, h5fileDataSpace);
+    selectionTimer.stop();
+    IoTimer readTimer{pStats ? &pStats->hdf5ReadSeconds : nullptr};
 
-    // Update min/max attributes
-    auto pDescriptor = this->getDescriptor();
-    const auto attInfo = getAttributeInfo(pDescriptor->getLayerType());
-    float min = 0.f, max = 0.f;
+    m_pH5dataSet->read(buffer, getH5memoryType(type), h5memDataSpace,
+        *m_pH5fileDataSpace);
+}
 
-    if (attInfo.h5type == ::H5::PredType::NATIVE_FLOAT)
-    {
-        const auto* floatBuffer = reinterpret_cast<const float*>(buffer);
+//! Retrieve a memory DataSpace describing a buffer.
+/*!
+    The DataSpace is reused while consecutive reads and writes use the same
+    shape, which is the common case for tiled and point queries.
 
-        const auto begin = floatBuffer;
-        const auto end = floatBuffer + rows * columns;
+\param rows
+    The number of rows in the buffer.
+\param columns
+    The number of columns in the buffer.
+\param rowStrideBytes
+    The distance, in bytes, between the start of two rows in the buffer.
+
+\return
+    The memory DataSpace.
+*/
+const ::H5::DataSpace& SimpleLayer::getH5memDataSpace(
+    uint32_t rows,
+    uint32_t columns,
+    size_t rowStrideBytes) const
+{
+    const std::array<size_t, 3> shape{rows, columns, rowStrideBytes};
 
-        const auto mm = std::minmax_element(begin, end);
-        min = *std::get<0>(mm);
-        max = *std::get<1>(mm);
+    if (!m_pH5memDataSpace || shape != m_memDataSpaceShape)
+    {
+        m_pH5memDataSpace = std::unique_ptr<::H5::DataSpace, DeleteH5dataSpace>(
+            new ::H5::DataSpace{createH5memorySpace(rows, columns,
+                rowStrideBytes, m_descriptor.getElementSize())},
+            DeleteH5dataSpace{});
+        m_memDataSpaceShape = shape;
     }
-    else if (attInfo.h5type == ::H5::PredType::NATIVE_UINT32)
+
+    return *m_pH5memDataSpace;
+}
+
+//! Retrieve the elements of the layer mapped into memory.
+/*!
+    The layer is mapped on the first read, if the BAG is opened read only
+    with the default (sec2) file driver, and the elements are stored
+    contiguously in their native type.  Nothing else can change them then,
+    nor cache changes to them in HDF5.
+
+\return
+    The elements of the layer, row by row.
+    nullptr if the layer must be read through HDF5.
+*/
+const uint8_t* SimpleLayer::getMappedData() const
+{
+    if (!m_mappingTried)
     {
-        const auto* uint32Buffer = reinterpret_cast<const uint32_t*>(buffer);
+        m_mappingTried = true;
+
+        const auto pDataset = this->getDataset().lock();
+        if (!pDataset)
+            return nullptr;
+
+        const auto& h5file = pDataset->getH5file();
+
+        unsigned int intent = 0;
+        if (H5Fget_intent(h5file.getId(), &intent) < 0 ||
+            intent != H5F_ACC_RDONLY)
+            return nullptr;
+
+        if (H5Pget_driver(h5file.getAccessPlist().getId()) != H5FD_SEC2)
+            return nullptr;
+
+        if (m_pH5dataSet->getCreatePlist().getLayout() != H5D_CONTIGUOUS ||
+            !(*m_pH5fileType == *m_pH5memType))
+            return nullptr;
+
+        // Storage is only allocated once something is written.
+        const auto offset = H5Dget_offset(m_pH5dataSet->getId());
+        if (offset == HADDR_UNDEF)
+            return nullptr;
+
+        std::array<hsize_t, kRank> fileDims{};
+        m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
 
-        const auto begin = uint32Buffer;
-        const auto end = uint32Buffer + rows * columns;
+        const size_t elementSize = m_descriptor.getElementSize();
+        const auto rowBytes = static_cast<size_t>(fileDims[1]) * elementSize;
+        const auto size = static_cast<size_t>(fileDims[0]) * rowBytes;
 
-        const auto mm = std::minmax_element(begin, end);
-        min = static_cast<float>(*std::get<0>(mm));
-        max = static_cast<float>(*std::get<1>(mm));
+        if (m_pH5dataSet->getStorageSize() != size)
+            return nullptr;
+
+        m_pMappedData = std::unique_ptr<MappedRegion, DeleteMappedRegion>(
+            MappedRegion::map(h5file.getFileName(), offset, size).release(),
+            DeleteMappedRegion{});
+        m_mappedRowBytes = rowBytes;
     }
-    else
-        throw UnsupportedAttributeType{};
 
-    const float currentMin = std::get<0>(pDescriptor->getMinMax());
-    const float currentMax = std::get<1>(pDescriptor->getMinMax());
+    return m_pMappedData ? m_pMappedData->data() : nullptr;
+}
+
+//! Build overviews of the layer, each half the resolution of the one before.
+/*!
+    An overview node combines the nodes of the layer below it that have a
+    value; it is null if none do.  Overview i (counting from 1) is stored in
+    OVERVIEWS_PATH as <layer>_<2^i>x, chunked and compressed like the layer.
+    Any overviews already built are replaced.
+
+    If cancelled, the overviews built so far are kept.
+
+\param numLevels
+    The number of overviews; fewer are built if the coarsest would be a
+    single node.
+\param method
+    How the nodes are combined.
+\param progress
+    Follows the progress of the overviews, and cancels them; may be null.
+*/
+void SimpleLayer::buildOverviews(
+    uint32_t numLevels,
+    OverviewMethod method,
+    ProgressToken* progress)
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    if (m_descriptor.getDataType() != DT_FLOAT32)
+        throw UnsupportedOverviewLayer{};
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    const auto rows = static_cast<uint32_t>(fileDims[0]);
+    const auto columns = static_cast<uint32_t>(fileDims[1]);
+
+    auto& h5file = pDataset->getH5file();
+
+    const auto overviewsGroup = std::string{OVERVIEWS_PATH};
+    if (H5Lexists(h5file.getId(), overviewsGroup.c_str(), H5P_DEFAULT) <= 0)
+        h5file.createGroup(overviewsGroup);
+
+    // Remove the existing overviews.
+    this->openOverviews();
+    for (uint32_t level=1; level<=m_overviews.size(); ++level)
+        h5file.unlink(this->getOverviewPath(level));
+    m_overviews.clear();
+
+    ::H5::FloatType h5dataType;
+    h5dataType.copy(::H5::PredType::NATIVE_FLOAT);
+    h5dataType.setOrder(H5T_ORDER_LE);
+
+    constexpr float kFillValue = BAG_NULL_GENERIC;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+
+    OverviewGrid source;
+    source.rows = rows;
+    source.columns = columns;
+
+    // Reading the layer for the first overview is most of the work.
+    const ProgressScope readProgress{progress, 0., 0.5};
+    const ProgressScope levelProgress{progress, 0.5, 1.};
 
-    pDescriptor->setMinMax(std::min(currentMin, min), std::max(currentMax, max));
+    for (uint32_t level=1; level<=numLevels; ++level)
+    {
+        if (source.rows <= 1 && source.columns <= 1)
+            break;
+
+        OverviewGrid overview;
+        overview.rows = (source.rows + 1) / 2;
+        overview.columns = (source.columns + 1) / 2;
+        overview.values.resize(
+            static_cast<size_t>(overview.rows) * overview.columns);
+        overview.counts.resize(overview.values.size());
+
+        if (level == 1)
+        {
+            // Read the layer a band of row pairs at a time.
+            const auto bandRows = static_cast<uint32_t>(std::max<size_t>(2,
+                kOverviewBandCells / columns / 2 * 2));
+            std::vector<float> band(static_cast<size_t>(bandRows) * columns);
+
+            for (uint32_t rowStart=0; rowStart<rows; rowStart+=bandRows)
+            {
+                const auto rowEnd = std::min(rowStart + bandRows, rows) - 1;
+
+                this->readIntoProxy(rowStart, 0, rowEnd, columns - 1,
+                    reinterpret_cast<uint8_t*>(band.data()),
+                    columns * sizeof(float));
+
+                reduceOverview(band.data(), nullptr, rowEnd - rowStart + 1,
+                    columns, method, overview, rowStart / 2);
+
+                readProgress.report(rowEnd + 1, rows);
+            }
+        }
+        else
+            reduceOverview(source.values.data(), source.counts.data(),
+                source.rows, source.columns, method, overview, 0);
+
+        // Store the overview like the layer.
+        const std::array<hsize_t, kRank> overviewDims{overview.rows,
+            overview.columns};
+        const ::H5::DataSpace h5dataSpace{kRank, overviewDims.data(),
+            overviewDims.data()};
+
+        // The overview is written whole as soon as it is created, so its
+        // storage is not filled first.
+        const ::H5::DSetCreatPropList h5createPropList{};
+        h5createPropList.setFillTime(H5D_FILL_TIME_NEVER);
+        h5createPropList.setFillValue(h5dataType, &kFillValue);
+
+        if (chunkRows > 0 && chunkColumns > 0)
+        {
+            const std::array<hsize_t, kRank> chunkDims{
+                std::min<hsize_t>(chunkRows, overview.rows),
+                std::min<hsize_t>(chunkColumns, overview.columns)};
+            h5createPropList.setChunk(kRank, chunkDims.data());
+
+            setCompression(h5createPropList,
+                m_descriptor.getCompressionSpec());
+        }
+
+        auto pH5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
+            new ::H5::DataSet{h5file.createDataSet(this->getOverviewPath(level),
+                h5dataType, h5dataSpace, h5createPropList)},
+            DeleteH5dataSet{});
+
+        pH5dataSet->write(overview.values.data(), ::H5::PredType::NATIVE_FLOAT);
+
+        m_overviews.push_back(std::move(pH5dataSet));
+
+        source = std::move(overview);
+
+        levelProgress.report(level, numLevels);
+    }
+
+    levelProgress.report(1, 1);
+}
+
+//! Retrieve the number of overviews built for the layer.
+/*!
+\return
+    The number of overviews; 0 if none have been built.
+*/
+uint32_t SimpleLayer::getNumOverviews() const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+
+    this->openOverviews();
+
+    return static_cast<uint32_t>(m_overviews.size());
+}
+
+//! Retrieve the dimensions of an overview.
+/*!
+\param level
+    The overview; 0 is the layer itself.
+
+\return
+    The rows and columns of the overview.
+*/
+std::tuple<uint32_t, uint32_t> SimpleLayer::getOverviewDims(
+    uint32_t level) const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+
+    std::array<hsize_t, kRank> dims{};
+
+    if (level == 0)
+        m_pH5fileDataSpace->getSimpleExtentDims(dims.data());
+    else
+    {
+        this->openOverviews();
+        if (level > m_overviews.size())
+            throw InvalidOverviewLevel{};
+
+        m_overviews[level - 1]->getSpace().getSimpleExtentDims(dims.data());
+    }
+
+    return std::make_tuple(static_cast<uint32_t>(dims[0]),
+        static_cast<uint32_t>(dims[1]));
+}
+
+//! Read an area of an overview.
+/*!
+\param level
+    The overview; 0 reads the layer itself.
+\param rowStart
+    The starting row, in the rows of the overview.
+\param columnStart
+    The starting column, in the columns of the overview.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The floats of the area read, row by row.
+*/
+UInt8Array SimpleLayer::readOverview(
+    uint32_t level,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    if (level == 0)
+        return this->read(rowStart, columnStart, rowEnd, columnEnd);
+
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = this->getOverviewDims(level);
+
+    if (rowEnd >= numRows || columnEnd >= numColumns)
+        throw InvalidReadSize{};
+
+    const auto lock = this->getDataset().lock()->lockReads();
+
+    const auto& h5dataSet = *m_overviews[level - 1];
+    auto h5fileDataSpace = h5dataSet.getSpace();
+
+    const auto rows = (rowEnd - rowStart) + 1;
+    const auto columns = (columnEnd - columnStart) + 1;
+    const std::array<hsize_t, kRank> count{rows, columns};
+    const std::array<hsize_t, kRank> offset{rowStart, columnStart};
+
+    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+        offset.data());
+
+    auto buffer = UInt8Array::uninitialized(static_cast<size_t>(rows) *
+        columns * sizeof(float));
+
+    h5dataSet.read(buffer.data(), ::H5::PredType::NATIVE_FLOAT,
+        createH5memorySpace(rows, columns, columns * sizeof(float),
+            sizeof(float)),
+        h5fileDataSpace);
+
+    return buffer;
+}
+
+//! Read a section of the layer at a lower resolution.
+/*!
+    The section is split into blocks of rowStep by columnStep nodes (smaller
+    along the last row and column), and each block is reduced to one node.
+    Sampling reads only the first node of each block, leaving HDF5 to select
+    them.  The other methods read the section a band of whole blocks at a
+    time, and reduce each band as soon as it is read, so the whole section
+    is never held at full resolution.  They ignore null nodes; a block whose
+    nodes are all null is null.
+
+    An InvalidReadSize exception is thrown if the section is empty, extends
+    past the grid, or a step is 0.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param rowStep
+    The number of rows in a block.
+\param columnStep
+    The number of columns in a block.
+\param method
+    How each block is reduced to one node.
+
+\return
+    A node per block, row by row, in the type of the layer;
+    (rowEnd - rowStart) / rowStep + 1 rows of
+    (columnEnd - columnStart) / columnStep + 1 columns.
+*/
+UInt8Array SimpleLayer::readDecimated(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint32_t rowStep,
+    uint32_t columnStep,
+    DecimationMethod method) const
+{
+    if (rowStep == 0 || columnStep == 0)
+        throw InvalidReadSize{};
+
+    this->checkReadWindow(rowStart, columnStart, rowEnd, columnEnd);
+
+    const auto pDataset = this->getDataset().lock();
+    const auto rows = (rowEnd - rowStart) / rowStep + 1;
+    const auto columns = (columnEnd - columnStart) / columnStep + 1;
+
+    const TraceScope trace{"SimpleLayer::readDecimated",
+        m_descriptor.getName().c_str(), rows, columns};
+    const AccessTraceScope access{*pDataset, m_descriptor, AccessKind::Read,
+        rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = pDataset->lockReads();
+
+    auto* pStats = this->getCollectedIoStats(*pDataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+    if (pStats)
+        this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
+    auto buffer = UInt8Array::uninitialized(static_cast<size_t>(rows) *
+        columns * m_descriptor.getElementSize());
+
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [&](auto traits) {
+            using Traits = decltype(traits);
+
+            this->decimateTyped<Traits>(rowStart, columnStart, rowEnd,
+                columnEnd, rowStep, columnStep, method,
+                reinterpret_cast<typename Traits::value_type*>(buffer.data()));
+        });
+
+    return buffer;
+}
+
+//! Read a section of a layer whose type is known at compile time at a lower
+//! resolution.
+/*!
+    The section and steps have been checked.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param rowStep
+    The number of rows in a block.
+\param columnStep
+    The number of columns in a block.
+\param method
+    How each block is reduced to one node.
+\param decimated
+    Filled with a node per block, row by row.
+*/
+template <typename Traits>
+void SimpleLayer::decimateTyped(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint32_t rowStep,
+    uint32_t columnStep,
+    DecimationMethod method,
+    typename Traits::value_type* decimated) const
+{
+    using T = typename Traits::value_type;
+
+    const auto rows = (rowEnd - rowStart) / rowStep + 1;
+    const auto columns = (columnEnd - columnStart) / columnStep + 1;
+    const auto sectionColumns = columnEnd - columnStart + 1;
+
+    if (method == DecimationMethod::Sample)
+    {
+        if (const auto* mappedData = this->getMappedData())
+        {
+            for (uint32_t row=0; row<rows; ++row)
+            {
+                const auto* from = mappedData +
+                    static_cast<size_t>(rowStart + row * rowStep) *
+                        m_mappedRowBytes + columnStart * sizeof(T);
+                auto* to = decimated + static_cast<size_t>(row) * columns;
+
+                for (uint32_t column=0; column<columns; ++column)
+                    std::memcpy(to + column, from +
+                        static_cast<size_t>(column) * columnStep * sizeof(T),
+                        sizeof(T));
+            }
+
+            return;
+        }
+
+        const std::array<hsize_t, kRank> count{rows, columns};
+        const std::array<hsize_t, kRank> offset{rowStart, columnStart};
+        const std::array<hsize_t, kRank> stride{rowStep, columnStep};
+
+        m_pH5fileDataSpace->selectHyperslab(H5S_SELECT_SET, count.data(),
+            offset.data(), stride.data());
+        m_pH5dataSet->read(decimated, *m_pH5memType,
+            createH5memorySpace(rows, columns, columns * sizeof(T), sizeof(T)),
+            *m_pH5fileDataSpace);
+
+        return;
+    }
+
+    // Each band holds whole blocks of rows.
+    const auto bandBlocks = static_cast<uint32_t>(std::max<size_t>(1,
+        kDecimateBandCells / (static_cast<size_t>(rowStep) * sectionColumns)));
+    const auto blockCells = static_cast<uint32_t>(std::min<uint64_t>(
+        static_cast<uint64_t>(rowStep) * sectionColumns,
+        std::numeric_limits<uint32_t>::max()));
+
+    std::vector<T> band;
+
+    for (uint32_t firstBlock=0; firstBlock<rows; firstBlock+=bandBlocks)
+    {
+        const auto numBlocks = std::min(bandBlocks, rows - firstBlock);
+        const auto bandStart = rowStart + firstBlock * rowStep;
+        const auto bandEnd = static_cast<uint32_t>(std::min<uint64_t>(
+            bandStart + static_cast<uint64_t>(numBlocks) * rowStep - 1,
+            rowEnd));
+        const auto bandRows = bandEnd - bandStart + 1;
+
+        band.resize(static_cast<size_t>(bandRows) * sectionColumns);
+        this->readIntoProxy(bandStart, columnStart, bandEnd, columnEnd,
+            reinterpret_cast<uint8_t*>(band.data()),
+            sectionColumns * sizeof(T));
+
+        processInBlocks(0, numBlocks - 1, blockCells,
+            [&](uint32_t first, uint32_t last) {
+                for (auto block=first; block<=last; ++block)
+                {
+                    const auto blockStart = block * rowStep;
+                    const auto blockEnd = blockStart +
+                        std::min(rowStep, bandRows - blockStart);
+                    auto* to = decimated +
+                        static_cast<size_t>(firstBlock + block) * columns;
+
+                    for (uint32_t column=0; column<columns; ++column)
+                    {
+                        const auto columnFrom = column * columnStep;
+                        const auto columnTo = columnFrom +
+                            std::min(columnStep, sectionColumns - columnFrom);
+
+                        double sum = 0.;
+                        uint32_t count = 0;
+                        auto best = Traits::getNullValue();
+
+                        for (auto row=blockStart; row<blockEnd; ++row)
+                        {
+                            const auto* values = band.data() +
+                                static_cast<size_t>(row) * sectionColumns;
+
+                            for (auto c=columnFrom; c<columnTo; ++c)
+                            {
+                                const auto value = values[c];
+
+                                // NaN compares unequal to itself.
+                                if (Traits::isNull(value) || value != value)
+                                    continue;
+
+                                if (count == 0 ||
+                                    (method == DecimationMethod::Minimum &&
+                                        value < best) ||
+                                    (method == DecimationMethod::Maximum &&
+                                        value > best))
+                                    best = value;
+
+                                sum += static_cast<double>(value);
+                                ++count;
+                            }
+                        }
+
+                        if (count > 0 && method == DecimationMethod::Mean)
+                        {
+                            const auto mean = sum / count;
+                            best = static_cast<T>(std::is_integral<T>::value ?
+                                std::round(mean) : mean);
+                        }
+
+                        to[column] = best;
+                    }
+                }
+            });
+    }
+}
+
+//! Sample the layer at many positions.
+/*!
+    As sampleInto(), into a new vector.
+
+    An InvalidSamplePositions exception is thrown if xs and ys are not the
+    same size.
+
+\param xs
+    The easting of each position.
+\param ys
+    The northing of each position.
+\param method
+    How the value at a position is found from the nodes around it.
+
+\return
+    The value at each position, in the order of the positions.
+*/
+std::vector<float> SimpleLayer::sample(
+    const std::vector<double>& xs,
+    const std::vector<double>& ys,
+    SampleMethod method) const
+{
+    if (xs.size() != ys.size())
+        throw InvalidSamplePositions{};
+
+    std::vector<float> values(xs.size());
+    if (!values.empty())
+        this->sampleInto(xs.data(), ys.data(), values.size(), method,
+            values.data());
+
+    return values;
+}
+
+//! Sample the layer at many positions, into a buffer.
+/*!
+    The positions are converted to the grid in one pass, then sorted by the
+    chunk they fall in.  The chunks are read a row of chunks at a time, each
+    run of chunks needed (with small gaps between them) in one read, so each
+    chunk is decoded once, several at a time by a read spanning many.  The
+    values are then found from the chunks on several threads.  Only two rows
+    of chunks are held at a time.
+
+    Rows run north and columns east from the origin.  A position is sampled
+    if it is within half a node of the grid; the values of the others are
+    the null value of the layer.  Bilinear interpolation between the outer
+    nodes and the edge uses the outer nodes.  Null and NaN nodes are left
+    out of the interpolation; a position with only null nodes around it is
+    null.
+
+    An InvalidBuffer exception is thrown if a buffer is nullptr.
+
+\param xs
+    The easting of each position.
+\param ys
+    The northing of each position.
+\param numPositions
+    The number of positions.
+\param method
+    How the value at a position is found from the nodes around it.
+\param values
+    Filled with the value at each position, as a float, in the order of the
+    positions.
+*/
+void SimpleLayer::sampleInto(
+    const double* xs,
+    const double* ys,
+    size_t numPositions,
+    SampleMethod method,
+    float* values) const
+{
+    if (numPositions == 0)
+        return;
+
+    if (!xs || !ys || !values)
+        throw InvalidBuffer{};
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = descriptor.getDims();
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+    float nullValue = 0.f;
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [&nullValue](auto traits) {
+            nullValue = static_cast<float>(decltype(traits)::getNullValue());
+        });
+
+    const TraceScope trace{"SimpleLayer::sample",
+        m_descriptor.getName().c_str(), static_cast<uint32_t>(
+            std::min<size_t>(numPositions,
+                std::numeric_limits<uint32_t>::max())), 1};
+
+    // Convert the positions to the grid; the loop is simple enough for the
+    // compiler to vectorize.
+    std::vector<double> rows(numPositions);
+    std::vector<double> columns(numPositions);
+    {
+        const auto rowScale = 1. / rowSpacing;
+        const auto columnScale = 1. / columnSpacing;
+
+        for (size_t i=0; i<numPositions; ++i)
+        {
+            columns[i] = (xs[i] - originX) * columnScale;
+            rows[i] = (ys[i] - originY) * rowScale;
+        }
+    }
+
+    // Find the nodes around each position.
+    const bool bilinear = method == SampleMethod::Bilinear;
+    const auto lastRow = numRows - 1;
+    const auto lastColumn = numColumns - 1;
+
+    std::vector<SamplePosition> positions(numPositions);
+    std::vector<size_t> order;
+    order.reserve(numPositions);
+
+    for (size_t i=0; i<numPositions; ++i)
+    {
+        const auto row = rows[i];
+        const auto column = columns[i];
+
+        // NaN fails the comparisons too.
+        if (!(row >= -0.5 && row < numRows - 0.5 &&
+            column >= -0.5 && column < numColumns - 0.5))
+        {
+            values[i] = nullValue;
+            continue;
+        }
+
+        auto& position = positions[i];
+
+        if (bilinear)
+        {
+            const auto clampedRow = std::min(std::max(row, 0.),
+                static_cast<double>(lastRow));
+            const auto clampedColumn = std::min(std::max(column, 0.),
+                static_cast<double>(lastColumn));
+
+            // The south west node, so the north east one is in the grid.
+            position.row = std::min(static_cast<uint32_t>(clampedRow),
+                lastRow > 0 ? lastRow - 1 : 0u);
+            position.column = std::min(static_cast<uint32_t>(clampedColumn),
+                lastColumn > 0 ? lastColumn - 1 : 0u);
+            position.rowFraction = clampedRow - position.row;
+            position.columnFraction = clampedColumn - position.column;
+        }
+        else
+        {
+            position.row = std::min(static_cast<uint32_t>(
+                std::max(row + 0.5, 0.)), lastRow);
+            position.column = std::min(static_cast<uint32_t>(
+                std::max(column + 0.5, 0.)), lastColumn);
+        }
+
+        order.push_back(i);
+    }
+
+    rows = {};
+    columns = {};
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+    const auto tileRows = chunkRows > 0 ?
+        static_cast<uint32_t>(chunkRows) : kDefaultTileSize;
+    const auto tileColumns = chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkColumns) : kDefaultTileSize;
+    const auto numTileColumns = lastColumn / tileColumns + 1;
+
+    std::sort(order.begin(), order.end(),
+        [&positions, tileRows, tileColumns](size_t lhs, size_t rhs) {
+            const auto& a = positions[lhs];
+            const auto& b = positions[rhs];
+
+            return std::make_tuple(a.row / tileRows, a.column / tileColumns) <
+                std::make_tuple(b.row / tileRows, b.column / tileColumns);
+        });
+
+    // The nodes north and east of the south west node of a position; the
+    // same node on the last row or column.
+    const auto getNorthRow = [bilinear, lastRow](
+        const SamplePosition& position) noexcept {
+            return bilinear ? std::min(position.row + 1, lastRow) :
+                position.row;
+        };
+    const auto getEastColumn = [bilinear, lastColumn](
+        const SamplePosition& position) noexcept {
+            return bilinear ? std::min(position.column + 1, lastColumn) :
+                position.column;
+        };
+
+    // The row of chunks of the positions sampled, and the row north of it.
+    std::array<SampledChunkRow, 2> decoded;
+    std::array<std::vector<uint8_t>, 2> needed;
+
+    for (size_t begin=0; begin<order.size(); )
+    {
+        const auto tileRow = positions[order[begin]].row / tileRows;
+
+        auto end = begin + 1;
+        while (end < order.size() &&
+            positions[order[end]].row / tileRows == tileRow)
+            ++end;
+
+        // The chunks north of the last positions may be needed again.
+        if (decoded[1].index == tileRow)
+            std::swap(decoded[0], decoded[1]);
+        if (decoded[0].index != tileRow)
+            decoded[0].reset(tileRow, numTileColumns);
+        if (decoded[1].index != tileRow + 1)
+            decoded[1].reset(tileRow + 1, numTileColumns);
+
+        for (auto& chunks : needed)
+            chunks.assign(numTileColumns, 0);
+
+        for (auto i=begin; i<end; ++i)
+        {
+            const auto& position = positions[order[i]];
+            const auto west = position.column / tileColumns;
+            const auto east = getEastColumn(position) / tileColumns;
+            auto& north = needed[getNorthRow(position) / tileRows - tileRow];
+
+            needed[0][west] = needed[0][east] = 1;
+            north[west] = north[east] = 1;
+        }
+
+        // Read the chunks needed and not decoded yet, a run at a time.
+        for (size_t k=0; k<decoded.size(); ++k)
+        {
+            auto& chunkRow = decoded[k];
+            const auto& chunks = needed[k];
+
+            const auto rowStart = uint64_t{chunkRow.index} * tileRows;
+            if (rowStart > lastRow)
+                continue;
+
+            const auto rowEnd = static_cast<uint32_t>(std::min<uint64_t>(
+                rowStart + tileRows - 1, lastRow));
+
+            for (uint32_t first=0; first<numTileColumns; )
+            {
+                if (!chunks[first] || chunkRow.chunks[first])
+                {
+                    ++first;
+                    continue;
+                }
+
+                // Bridge small gaps; reading a few chunks not needed is
+                // cheaper than another read.
+                auto last = first;
+                for (auto next=first + 1; next<numTileColumns &&
+                    next - last <= kMaxSampleGapChunks + 1 &&
+                    !chunkRow.chunks[next]; ++next)
+                    if (chunks[next])
+                        last = next;
+
+                const auto columnStart = first * tileColumns;
+                const auto columnEnd = static_cast<uint32_t>(
+                    std::min<uint64_t>((uint64_t{last} + 1) * tileColumns - 1,
+                        lastColumn));
+                const size_t stride = columnEnd - columnStart + 1;
+
+                chunkRow.reads.emplace_back(
+                    static_cast<size_t>(rowEnd - rowStart + 1) * stride);
+                auto& read = chunkRow.reads.back();
+
+                this->readSampledChunks(*pDataset,
+                    static_cast<uint32_t>(rowStart), columnStart, rowEnd,
+                    columnEnd, read.data(), stride);
+
+                for (auto chunk=first; chunk<=last; ++chunk)
+                {
+                    chunkRow.chunks[chunk] = read.data() +
+                        static_cast<size_t>(chunk - first) * tileColumns;
+                    chunkRow.strides[chunk] = stride;
+                }
+
+                first = last + 1;
+            }
+        }
+
+        const auto getNode = [&decoded, tileRow, tileRows, tileColumns](
+            uint32_t row, uint32_t column) noexcept {
+                const auto& chunkRow = decoded[row / tileRows - tileRow];
+                const auto chunk = column / tileColumns;
+
+                return chunkRow.chunks[chunk][(row % tileRows) *
+                    chunkRow.strides[chunk] + column % tileColumns];
+            };
+
+        processInBlocks(0, static_cast<uint32_t>(end - begin - 1), 1,
+            [&](uint32_t first, uint32_t last) noexcept {
+                for (auto i=begin + first; i<=begin + last; ++i)
+                {
+                    const auto& position = positions[order[i]];
+
+                    if (!bilinear)
+                    {
+                        values[order[i]] = getNode(position.row,
+                            position.column);
+                        continue;
+                    }
+
+                    const auto northRow = getNorthRow(position);
+                    const auto eastColumn = getEastColumn(position);
+                    const auto tx = position.columnFraction;
+                    const auto ty = position.rowFraction;
+
+                    double sum = 0., sumWeights = 0.;
+
+                    const auto add = [&](uint32_t row, uint32_t column,
+                        double weight) noexcept {
+                        const auto value = getNode(row, column);
+
+                        // NaN compares unequal to itself.
+                        if (weight > 0. && value != nullValue &&
+                            value == value)
+                        {
+                            sum += weight * value;
+                            sumWeights += weight;
+                        }
+                    };
+
+                    add(position.row, position.column,
+                        (1. - tx) * (1. - ty));
+                    add(position.row, eastColumn, tx * (1. - ty));
+                    add(northRow, position.column, (1. - tx) * ty);
+                    add(northRow, eastColumn, tx * ty);
+
+                    values[order[i]] = sumWeights > 0. ?
+                        static_cast<float>(sum / sumWeights) : nullValue;
+                }
+            });
+
+        begin = end;
+    }
+}
+
+//! Read the chunks of a run needed by sampleInto(), as floats.
+/*!
+\param dataset
+    The dataset of the layer.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param values
+    Filled with the nodes, row by row.
+\param rowStride
+    The distance, in values, between the rows of values.
+*/
+void SimpleLayer::readSampledChunks(
+    const Dataset& dataset,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    float* values,
+    size_t rowStride) const
+{
+    const AccessTraceScope access{dataset, m_descriptor, AccessKind::Read,
+        rowStart, columnStart, rowEnd, columnEnd};
+    const auto lock = dataset.lockReads();
+
+    auto* pStats = this->getCollectedIoStats(dataset);
+    const IoTimer timer{pStats ? &pStats->readSeconds : nullptr};
+    if (pStats)
+        this->countRead(*pStats, rowStart, columnStart, rowEnd, columnEnd);
+
+    auto* buffer = reinterpret_cast<uint8_t*>(values);
+    if (m_descriptor.getDataType() == DT_FLOAT32)
+        this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd, buffer,
+            rowStride * sizeof(float));
+    else
+        this->readConvertedIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+            DT_FLOAT32, buffer, rowStride * sizeof(float));
+}
+
+//! Retrieve the path of an overview of the layer.
+/*!
+\param level
+    The overview, counting from 1.
+
+\return
+    The path of the HDF5 DataSet of the overview.
+*/
+std::string SimpleLayer::getOverviewPath(
+    uint32_t level) const
+{
+    const auto& path = m_descriptor.getInternalPath();
+    const auto name = path.substr(path.rfind('/') + 1);
+
+    return OVERVIEWS_PATH + name + "_" + std::to_string(1u << level) + "x";
+}
+
+//! Open the overviews of the layer in the file, the first time they are needed.
+void SimpleLayer::openOverviews() const
+{
+    if (m_overviewsOpened)
+        return;
+
+    m_overviewsOpened = true;
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        return;
+
+    const auto& h5file = pDataset->getH5file();
+
+    const auto overviewsGroup = std::string{OVERVIEWS_PATH};
+    if (H5Lexists(h5file.getId(), overviewsGroup.c_str(), H5P_DEFAULT) <= 0)
+        return;
+
+    for (uint32_t level=1; level<32; ++level)
+    {
+        const auto path = this->getOverviewPath(level);
+        if (H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) <= 0)
+            break;
+
+        m_overviews.emplace_back(new ::H5::DataSet{h5file.openDataSet(path)},
+            DeleteH5dataSet{});
+    }
+}
+
+//! Build the coverage bitmap of the layer.
+/*!
+    The bitmap holds a bit per node, set if the node is not null, so the
+    coverage of the layer can be measured, outlined or masked without
+    reading the layer.  It is stored in COVERAGE_PATH under the name of the
+    layer, a row of packed bits per row of the layer, chunked and
+    compressed.  Any bitmap already built is replaced.
+
+    The layer is read a band at a time, and the bits of each band are packed
+    on several threads.  Once built, the bitmap is kept up to date by writes
+    to the layer, except those of processes sharing the BAG through MPI.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+
+\param progress
+    Follows the progress of the build, and cancels it; may be null.  A
+    cancelled build leaves no bitmap.
+*/
+void SimpleLayer::buildCoverage(
+    ProgressToken* progress)
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    const auto rows = static_cast<uint32_t>(fileDims[0]);
+    const auto columns = static_cast<uint32_t>(fileDims[1]);
+    const auto rowBytes = getCoverageRowBytes(columns);
+
+    auto& h5file = pDataset->getH5file();
+
+    const auto coverageGroup = std::string{COVERAGE_PATH};
+    if (H5Lexists(h5file.getId(), coverageGroup.c_str(), H5P_DEFAULT) <= 0)
+        h5file.createGroup(coverageGroup);
+
+    const auto path = this->getCoveragePath();
+    m_pCoverage.reset();
+    m_coverageOpened = true;
+    if (H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) > 0)
+        h5file.unlink(path);
+
+    const std::array<hsize_t, kRank> dims{rows, rowBytes};
+    const ::H5::DataSpace h5dataSpace{kRank, dims.data(), dims.data()};
+
+    constexpr uint8_t kFillValue = 0;
+
+    const ::H5::DSetCreatPropList h5createPropList{};
+    h5createPropList.setFillValue(::H5::PredType::NATIVE_UINT8, &kFillValue);
+
+    const std::array<hsize_t, kRank> chunkDims{
+        std::max<hsize_t>(1, std::min<hsize_t>(kCoverageChunkDim, rows)),
+        std::max<hsize_t>(1, std::min<hsize_t>(kCoverageChunkDim, rowBytes))};
+    h5createPropList.setChunk(kRank, chunkDims.data());
+    h5createPropList.setDeflate(6);
+
+    auto pCoverage = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
+        new ::H5::DataSet{h5file.createDataSet(path,
+            ::H5::PredType::STD_U8LE, h5dataSpace, h5createPropList)},
+        DeleteH5dataSet{});
+
+    const ProgressScope buildProgress{progress, 0., 1.};
+
+    try
+    {
+        visitLayerTraits(m_descriptor.getLayerType(),
+            [&](auto traits) {
+                using Traits = decltype(traits);
+                using T = typename Traits::value_type;
+
+                // Read the layer a band of whole chunks of the bitmap at a
+                // time.
+                const auto bandRows = static_cast<uint32_t>(std::max<size_t>(
+                    chunkDims[0], kCoverageBandCells / std::max(columns, 1u) /
+                    chunkDims[0] * chunkDims[0]));
+
+                std::vector<T> values(static_cast<size_t>(std::min(bandRows,
+                    rows)) * columns);
+                std::vector<uint8_t> bits(values.size() / std::max(columns,
+                    1u) * rowBytes);
+
+                for (uint32_t rowStart=0; rowStart<rows; rowStart+=bandRows)
+                {
+                    const auto rowEnd = std::min(rowStart + bandRows, rows) - 1;
+                    const auto numRows = rowEnd - rowStart + 1;
+
+                    this->readIntoProxy(rowStart, 0, rowEnd, columns - 1,
+                        reinterpret_cast<uint8_t*>(values.data()),
+                        columns * sizeof(T));
+
+                    processInBlocks(0, numRows - 1, columns,
+                        [&](uint32_t first, uint32_t last) {
+                            for (auto row=first; row<=last; ++row)
+                                packCoverage<Traits>(values.data() +
+                                    static_cast<size_t>(row) * columns, 0,
+                                    columns, bits.data() + row * rowBytes);
+                        });
+
+                    const std::array<hsize_t, kRank> count{numRows, rowBytes};
+                    const std::array<hsize_t, kRank> offset{rowStart, 0};
+
+                    auto h5fileDataSpace = pCoverage->getSpace();
+                    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET,
+                        count.data(), offset.data());
+
+                    pCoverage->write(bits.data(), ::H5::PredType::NATIVE_UINT8,
+                        ::H5::DataSpace{kRank, count.data()},
+                        h5fileDataSpace);
+
+                    buildProgress.report(rowEnd + 1, rows);
+                }
+            });
+    }
+    catch (...)
+    {
+        pCoverage.reset();
+        h5file.unlink(path);
+        throw;
+    }
+
+    m_pCoverage = std::move(pCoverage);
+}
+
+//! Determine if the layer has a coverage bitmap.
+/*!
+\return
+    \e true if buildCoverage() was called, or the BAG holds the coverage
+    bitmap of the layer.
+    \e false otherwise.
+*/
+bool SimpleLayer::hasCoverage() const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+
+    this->openCoverage();
+
+    return m_pCoverage != nullptr;
+}
+
+//! Count the nodes of a window of the layer that are not null.
+/*!
+    Only the coverage bitmap is read.  The window is clipped to the grid.
+
+    A CoverageNotBuilt exception is thrown if the layer has no coverage
+    bitmap (see buildCoverage()), and an InvalidReadSize exception if the
+    window is empty or starts past the grid.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The number of nodes that are not null.
+*/
+uint64_t SimpleLayer::countCoveredNodes(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto lastRow = static_cast<uint32_t>(std::min<hsize_t>(rowEnd,
+        fileDims[0] - 1));
+    const auto lastColumn = static_cast<uint32_t>(std::min<hsize_t>(
+        columnEnd, fileDims[1] - 1));
+    if (fileDims[0] == 0 || fileDims[1] == 0 ||
+        rowStart > lastRow || columnStart > lastColumn)
+        throw InvalidReadSize{};
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+
+    this->openCoverage();
+    if (!m_pCoverage)
+        throw CoverageNotBuilt{};
+
+    const auto byteStart = columnStart / 8;
+    const auto byteEnd = lastColumn / 8;
+    const size_t width = byteEnd - byteStart + 1;
+
+    // The columns counted, from the first byte read.
+    const auto first = columnStart - byteStart * 8;
+    const auto last = lastColumn - byteStart * 8;
+
+    const auto bandRows = static_cast<uint32_t>(std::max<size_t>(1,
+        kCoverageBandCells / width));
+    std::vector<uint8_t> band(std::min<size_t>(bandRows,
+        lastRow - rowStart + 1) * width);
+
+    uint64_t count = 0;
+
+    for (auto row=rowStart; row<=lastRow; )
+    {
+        const auto bandEnd = static_cast<uint32_t>(std::min<uint64_t>(
+            uint64_t{row} + bandRows - 1, lastRow));
+
+        this->readCoverageBytes(row, byteStart, bandEnd, byteEnd, band.data());
+
+        for (uint32_t i=0; i<=bandEnd - row; ++i)
+            count += countCoveredBits(band.data() + i * width, first, last);
+
+        if (bandEnd == lastRow)
+            break;
+
+        row = bandEnd + 1;
+    }
+
+    return count;
+}
+
+//! Retrieve the share of the nodes of the layer that are not null.
+/*!
+    Only the coverage bitmap is read.
+
+    A CoverageNotBuilt exception is thrown if the layer has no coverage
+    bitmap (see buildCoverage()).
+
+\return
+    The percentage of the nodes that are not null.
+*/
+double SimpleLayer::getCoveragePercentage() const
+{
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto numNodes = static_cast<double>(fileDims[0] * fileDims[1]);
+    if (numNodes == 0.)
+        return 0.;
+
+    return 100. * static_cast<double>(this->countCoveredNodes()) / numNodes;
+}
+
+//! Read which nodes of a window of the layer are not null.
+/*!
+    Only the coverage bitmap is read, so a window is masked without reading,
+    or decompressing, the layer.
+
+    A CoverageNotBuilt exception is thrown if the layer has no coverage
+    bitmap (see buildCoverage()), and an InvalidReadSize exception if the
+    window is empty or extends past the grid.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    A byte per node, row by row; 1 if the node is not null, and 0 if it is.
+*/
+UInt8Array SimpleLayer::readCoverage(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    if (rowStart > rowEnd || columnStart > columnEnd ||
+        rowEnd >= fileDims[0] || columnEnd >= fileDims[1])
+        throw InvalidReadSize{};
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+
+    this->openCoverage();
+    if (!m_pCoverage)
+        throw CoverageNotBuilt{};
+
+    const auto rows = rowEnd - rowStart + 1;
+    const auto columns = columnEnd - columnStart + 1;
+    const auto byteStart = columnStart / 8;
+    const size_t width = columnEnd / 8 - byteStart + 1;
+
+    std::vector<uint8_t> bits(static_cast<size_t>(rows) * width);
+    this->readCoverageBytes(rowStart, byteStart, rowEnd, columnEnd / 8,
+        bits.data());
+
+    auto mask = UInt8Array::uninitialized(static_cast<size_t>(rows) * columns);
+    const auto first = columnStart - byteStart * 8;
+
+    for (uint32_t row=0; row<rows; ++row)
+    {
+        const auto* bitRow = bits.data() + row * width;
+        auto* maskRow = mask.data() + static_cast<size_t>(row) * columns;
+
+        for (uint32_t column=0; column<columns; ++column)
+            maskRow[column] = isCovered(bitRow, first + column) ? 1 : 0;
+    }
+
+    return mask;
+}
+
+//! Outline the nodes of the layer that are not null.
+/*!
+    Each node is taken as the cell of the grid around it, so the outline
+    follows the edges of the cells, half a node outside the nodes at the
+    edge of the coverage.  Nodes touching only at a corner are outlined
+    apart.  Only the coverage bitmap is read, a band of rows at a time.
+
+    A CoverageNotBuilt exception is thrown if the layer has no coverage
+    bitmap (see buildCoverage()).
+
+\return
+    The rings of the outline, in the projected coordinates of the BAG; outer
+    rings run counterclockwise, and holes clockwise.
+*/
+std::vector<FootprintRing> SimpleLayer::getFootprint() const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    const auto rows = static_cast<uint32_t>(fileDims[0]);
+    const auto columns = static_cast<uint32_t>(fileDims[1]);
+    const auto lastByte = static_cast<uint32_t>(
+        getCoverageRowBytes(columns)) - 1;
+
+    std::vector<FootprintRing> rings;
+    {
+        const auto lock = pDataset->lockReads();
+
+        this->openCoverage();
+        if (!m_pCoverage)
+            throw CoverageNotBuilt{};
+
+        rings = traceFootprint(rows, columns,
+            [this, lastByte](uint32_t first, uint32_t last, uint8_t* buffer) {
+                this->readCoverageBytes(first, 0, last, lastByte, buffer);
+            });
+    }
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+    // The corners of the cells are half a node before the nodes.
+    for (auto& ring : rings)
+        for (auto& point : ring.points)
+        {
+            point.x = originX + (point.x - 0.5) * columnSpacing;
+            point.y = originY + (point.y - 0.5) * rowSpacing;
+        }
+
+    return rings;
+}
+
+//! Retrieve the path of the coverage bitmap of the layer.
+/*!
+\return
+    The path of the HDF5 DataSet of the coverage bitmap.
+*/
+std::string SimpleLayer::getCoveragePath() const
+{
+    const auto& path = m_descriptor.getInternalPath();
+
+    return COVERAGE_PATH + path.substr(path.rfind('/') + 1);
+}
+
+//! Open the coverage bitmap of the layer in the file, the first time it is
+//! needed.
+void SimpleLayer::openCoverage() const
+{
+    if (m_coverageOpened)
+        return;
+
+    m_coverageOpened = true;
+
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        return;
+
+    const auto& h5file = pDataset->getH5file();
+
+    const auto coverageGroup = std::string{COVERAGE_PATH};
+    if (H5Lexists(h5file.getId(), coverageGroup.c_str(), H5P_DEFAULT) <= 0)
+        return;
+
+    const auto path = this->getCoveragePath();
+    if (H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) <= 0)
+        return;
+
+    m_pCoverage.reset(new ::H5::DataSet{h5file.openDataSet(path)});
+}
+
+//! Read whole bytes of rows of the coverage bitmap.
+/*!
+\param rowStart
+    The starting row.
+\param byteStart
+    The starting byte of each row.
+\param rowEnd
+    The ending row (inclusive).
+\param byteEnd
+    The ending byte of each row (inclusive).
+\param buffer
+    Where to read the bytes, row by row.
+*/
+void SimpleLayer::readCoverageBytes(
+    uint32_t rowStart,
+    uint32_t byteStart,
+    uint32_t rowEnd,
+    uint32_t byteEnd,
+    uint8_t* buffer) const
+{
+    const std::array<hsize_t, kRank> count{rowEnd - rowStart + 1,
+        byteEnd - byteStart + 1};
+    const std::array<hsize_t, kRank> offset{rowStart, byteStart};
+
+    auto h5fileDataSpace = m_pCoverage->getSpace();
+    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+        offset.data());
+
+    m_pCoverage->read(buffer, ::H5::PredType::NATIVE_UINT8,
+        ::H5::DataSpace{kRank, count.data()}, h5fileDataSpace);
+}
+
+//! Bring the coverage bitmap up to date with a write to the layer.
+/*!
+    Nothing is done if the layer has no coverage bitmap.  The bytes of the
+    bitmap the write touches are rewritten; they are read first only if the
+    write starts or ends part way through a byte.
+
+    Processes sharing the BAG through MPI do not update the bitmap.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param rowStart
+    The starting row written.
+\param columnStart
+    The starting column written.
+\param rowEnd
+    The ending row written (inclusive).
+\param columnEnd
+    The ending column written (inclusive).
+\param buffer
+    The elements written, row by row.
+*/
+template <typename Traits>
+void SimpleLayer::updateCoverage(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const typename Traits::value_type* buffer)
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset || pDataset->isParallel())
+        return;
+
+    const auto rows = rowEnd - rowStart + 1;
+    const auto columns = columnEnd - columnStart + 1;
+    const auto byteStart = columnStart / 8;
+    const auto byteEnd = columnEnd / 8;
+    const size_t width = byteEnd - byteStart + 1;
+
+    std::vector<uint8_t> bits;
+
+    {
+        const auto lock = pDataset->lockWrites();
+
+        this->openCoverage();
+        if (!m_pCoverage)
+            return;
+
+        std::array<hsize_t, kRank> fileDims{};
+        m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+        bits.resize(static_cast<size_t>(rows) * width);
+
+        if (columnStart % 8 != 0 ||
+            ((columnEnd + 1) % 8 != 0 && columnEnd + 1 != fileDims[1]))
+            this->readCoverageBytes(rowStart, byteStart, rowEnd, byteEnd,
+                bits.data());
+    }
+
+    for (uint32_t row=0; row<rows; ++row)
+        packCoverage<Traits>(buffer + static_cast<size_t>(row) * columns,
+            columnStart, columns, bits.data() + row * width);
+
+    const auto lock = pDataset->lockWrites();
+
+    const std::array<hsize_t, kRank> count{rows, width};
+    const std::array<hsize_t, kRank> offset{rowStart, byteStart};
+
+    auto h5fileDataSpace = m_pCoverage->getSpace();
+    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+        offset.data());
+
+    m_pCoverage->write(bits.data(), ::H5::PredType::NATIVE_UINT8,
+        ::H5::DataSpace{kRank, count.data()}, h5fileDataSpace);
+}
+
+//! \copydoc Layer::writeAttributes
+void SimpleLayer::writeAttributesProxy() const
+{
+    const auto attInfo = getAttributeInfo(m_descriptor.getLayerType());
+
+    // Write any attributes, from the layer descriptor.
+    // min value
+    const auto minMax = m_descriptor.getMinMax();
+
+    const auto minAtt = m_pH5dataSet->openAttribute(attInfo.minName);
+    minAtt.write(attInfo.h5type, &std::get<0>(minMax));
+
+    // max value
+    const auto maxAtt = m_pH5dataSet->openAttribute(attInfo.maxName);
+    maxAtt.write(attInfo.h5type, &std::get<1>(minMax));
+
+    this->writeZoneMap();
+}
+
+//! \copydoc Layer::write
+void SimpleLayer::writeProxy(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const uint8_t* buffer)
+{
+    // Make sure the area being written to does not exceed the file dimensions.
+    std::array<hsize_t, kRank> fileDims{};
+    {
+        const auto lock = this->getDataset().lock()->lockWrites();
+        m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    }
+
+    if ((rowEnd >= fileDims[0]) || (columnEnd >= fileDims[1]))
+        throw InvalidWriteSize{};
+
+    // Switch on the layer type once; the rest of the write is specialized.
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [&](auto traits) {
+            using Traits = decltype(traits);
+
+            this->writeTyped<Traits>(rowStart, columnStart, rowEnd, columnEnd,
+                reinterpret_cast<const typename Traits::value_type*>(buffer));
+        });
+}
+
+//! Write an area of a layer whose type is known at compile time.
+/*!
+    The area has been checked to be within the layer.
+
+    When the Dataset writes concurrently, only the calls to HDF5 hold its
+    lock; finding the min/max, and updating the tile summaries and coverage
+    bitmap from the elements written, do not.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The elements to write, row by row.
+*/
+template <typename Traits>
+void SimpleLayer::writeTyped(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const typename Traits::value_type* buffer)
+{
+    // Update min/max attributes
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) = m_descriptor.getMinMax();
+
+    // Processes sharing the BAG write their windows collectively, and HDF5
+    // does not write raw chunks in parallel.
+    const auto pDataset = this->getDataset().lock();
+
+    if (pDataset->isParallel() ||
+        !this->writeChunksDirect<Traits>(rowStart, columnStart, rowEnd,
+            columnEnd, buffer, min, max))
+    {
+        const auto rows = (rowEnd - rowStart) + 1;
+        const auto columns = (columnEnd - columnStart) + 1;
+        const std::array<hsize_t, kRank> count{rows, columns};
+        const std::array<hsize_t, kRank> offset{rowStart, columnStart};
+
+        {
+            const auto lock = pDataset->lockWrites();
+
+            m_pH5fileDataSpace->selectHyperslab(H5S_SELECT_SET, count.data(),
+                offset.data());
+
+#ifdef BAG_USE_MPI
+            if (pDataset->isParallel())
+                m_pH5dataSet->write(buffer, *m_pH5memType,
+                    this->getH5memDataSpace(rows, columns,
+                        columns * Traits::getElementSize()),
+                    *m_pH5fileDataSpace, makeCollectiveTransfer());
+            else
+#endif
+            m_pH5dataSet->write(buffer, *m_pH5memType,
+                this->getH5memDataSpace(rows, columns,
+                    columns * Traits::getElementSize()),
+                *m_pH5fileDataSpace);
+        }
+
+        // Null cells do not contribute to the min/max.
+        computeMinMax(buffer, rows * columns, 1,
+            Traits::getNullValue()).mergeInto(min, max);
+    }
+
+#ifdef BAG_USE_MPI
+    // Every process writes the same min/max attributes.
+    if (pDataset->isParallel())
+        reduceMinMax(pDataset->getCommunicator(), min, max);
+#endif
+
+    m_descriptor.setMinMax(min, max);
+
+    // Drop the cached tiles written to.
+    if (m_tileCacheLayerIdFound && m_tileCacheLayerId != 0)
+    {
+        uint64_t chunkRows = 0, chunkColumns = 0;
+        std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+
+        TileCache::global().invalidate(m_tileCacheLayerId,
+            static_cast<uint32_t>(rowStart / chunkRows),
+            static_cast<uint32_t>(columnStart / chunkColumns),
+            static_cast<uint32_t>(rowEnd / chunkRows),
+            static_cast<uint32_t>(columnEnd / chunkColumns));
+    }
+
+    this->updateTileSummaries<Traits>(rowStart, columnStart, rowEnd,
+        columnEnd, buffer);
+    this->updateCoverage<Traits>(rowStart, columnStart, rowEnd, columnEnd,
+        buffer);
+}
+
+//! Write an area of whole chunks, filtering the chunks on several threads.
+/*!
+    HDF5 compresses the chunks of a write one at a time, on the calling
+    thread.  When the area covers whole chunks, and the only filters are
+    byte shuffling and deflate, the chunks are instead filtered here, a band
+    of chunk rows at a time on several threads, and written in order with
+    H5Dwrite_chunk().  The min/max is found in the same pass.
+
+    Chunks at the edge of the grid may be partly covered; the rest of them
+    lies outside the DataSet.
+
+    Much of a survey is often null.  A chunk holding only the null (fill)
+    value, which was never written, is left unallocated, so it is neither
+    compressed nor stored; reading it returns the fill value all the same.
+
+    When the Dataset writes concurrently, the chunks are filtered without
+    its lock, which is only held to call HDF5.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The elements to write, row by row.
+\param min
+    The current minimum; widened to the non null elements written.
+\param max
+    The current maximum; widened to the non null elements written.
+
+\return
+    \e true if the area was written.
+    \e false if it must be written through HDF5, and nothing was written.
+*/
+template <typename Traits>
+bool SimpleLayer::writeChunksDirect(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const typename Traits::value_type* buffer,
+    float& min,
+    float& max)
+{
+#if !H5_VERSION_GE(1, 10, 3)
+    // H5Dwrite_chunk() is not available.
+    return false;
+#else
+    using T = typename Traits::value_type;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+    if (chunkRows == 0 || chunkColumns == 0)
+        return false;
+
+    const auto pDataset = this->getDataset().lock();
+
+    // Everything from here to filtering the chunks calls HDF5.
+    auto lock = pDataset->lockWrites();
+
+    // Direct writes are not converted to the type in the file.
+    if (!(*m_pH5fileType == *m_pH5memType))
+        return false;
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto endsChunk = [](uint64_t end, uint64_t chunk, hsize_t dim) {
+        return (end + 1) % chunk == 0 || end + 1 == dim;
+    };
+
+    if (rowStart % chunkRows != 0 || columnStart % chunkColumns != 0 ||
+        !endsChunk(rowEnd, chunkRows, fileDims[0]) ||
+        !endsChunk(columnEnd, chunkColumns, fileDims[1]))
+        return false;
+
+    const auto filters = getDirectChunkFilters(m_pH5dataSet->getCreatePlist());
+    if (!filters.supported)
+        return false;
+
+    constexpr size_t elementSize = sizeof(T);
+    const uint64_t rows = (rowEnd - rowStart) + 1;
+    const uint64_t columns = (columnEnd - columnStart) + 1;
+    const auto numChunkRows = static_cast<uint32_t>(
+        (rows + chunkRows - 1) / chunkRows);
+    const auto numChunkColumns = static_cast<uint32_t>(
+        (columns + chunkColumns - 1) / chunkColumns);
+    const auto chunkCells = chunkRows * chunkColumns;
+    const auto chunkBytes = static_cast<size_t>(chunkCells * elementSize);
+
+    // Chunks holding only the fill value need not be allocated, as they read
+    // back the same.  Finding which chunks are allocated needs the ones
+    // written through HDF5 out of its chunk cache.
+    std::vector<uint8_t> fillValue;
+    const bool skipFilled = getUnwrittenChunkValue(*m_pH5dataSet,
+        *m_pH5memType, fillValue) && H5Dflush(m_pH5dataSet->getId()) >= 0;
+
+    // A couple of chunks for each thread, in whole chunk rows.
+    const auto maxThreads = getConcurrency();
+    const auto bandChunkRows = std::min(numChunkRows,
+        std::max(1u, (2 * maxThreads + numChunkColumns - 1) / numChunkColumns));
+
+    // Allocate up front, as the threads must not throw.
+    std::vector<DirectChunk<T>> chunks(
+        static_cast<size_t>(bandChunkRows) * numChunkColumns);
+    for (auto& chunk : chunks)
+    {
+        chunk.raw.resize(chunkBytes);
+
+        if (filters.shuffle)
+            chunk.shuffled.resize(chunkBytes);
+        if (filters.deflateLevel >= 0)
+            chunk.deflated.resize(compressBound(static_cast<uLong>(chunkBytes)));
+    }
+
+    const auto filterChunk = [&](DirectChunk<T>& chunk, uint64_t firstRow,
+        uint64_t firstColumn) noexcept {
+        const auto numRows = std::min(chunkRows, rows - firstRow);
+        const auto numColumns = std::min(chunkColumns, columns - firstColumn);
+
+        if (numRows < chunkRows || numColumns < chunkColumns)
+            std::fill(chunk.raw.begin(), chunk.raw.end(), uint8_t{0});
+
+        chunk.minMax = {};
+
+        bool filled = skipFilled && !chunk.allocated;
+
+        for (uint64_t row=0; row<numRows; ++row)
+        {
+            const auto* from = buffer + (firstRow + row) * columns +
+                firstColumn;
+            std::memcpy(chunk.raw.data() + row * chunkColumns * elementSize,
+                from, numColumns * elementSize);
+
+            // Null cells do not contribute to the min/max.
+            computeMinMax(from, numColumns, 1,
+                Traits::getNullValue()).mergeInto(chunk.minMax.min,
+                    chunk.minMax.max);
+
+            filled = filled && isFilledWith(
+                reinterpret_cast<const uint8_t*>(from),
+                numColumns * elementSize, fillValue.data(), elementSize);
+        }
+
+        chunk.skipped = filled;
+        if (chunk.skipped)
+            return;
+
+        chunk.data = chunk.raw.data();
+        chunk.size = chunkBytes;
+        chunk.filterMask = 0;
+
+        if (filters.shuffle)
+        {
+            shuffleBytes(chunk.raw.data(), chunkBytes, elementSize,
+                chunk.shuffled.data());
+            chunk.data = chunk.shuffled.data();
+        }
+
+        if (filters.deflateLevel >= 0)
+        {
+            auto deflatedSize = static_cast<uLongf>(chunk.deflated.size());
+            chunk.failed = compress2(chunk.deflated.data(), &deflatedSize,
+                chunk.data, static_cast<uLong>(chunkBytes),
+                filters.deflateLevel) != Z_OK;
+
+            // Like the deflate filter, store a chunk that grew undeflated if
+            // the filter is optional.
+            if (filters.deflateOptional && deflatedSize > chunkBytes)
+                chunk.filterMask = filters.deflateMask;
+            else
+            {
+                chunk.data = chunk.deflated.data();
+                chunk.size = deflatedSize;
+            }
+        }
+    };
+
+    for (uint32_t bandStart=0; bandStart<numChunkRows; bandStart+=bandChunkRows)
+    {
+        const auto numChunks =
+            std::min(bandChunkRows, numChunkRows - bandStart) * numChunkColumns;
+
+        const auto chunkOffset = [&](uint32_t index) {
+            return std::array<hsize_t, kRank>{
+                rowStart + (bandStart + index / numChunkColumns) * chunkRows,
+                columnStart + (index % numChunkColumns) * chunkColumns};
+        };
+
+        // A chunk written before must be overwritten, even with nulls.
+        if (!lock.owns_lock() && lock.mutex())
+            lock.lock();
+
+        for (uint32_t index=0; index<numChunks; ++index)
+        {
+            const auto offset = chunkOffset(index);
+            chunks[index].allocated = !skipFilled ||
+                isChunkAllocated(*m_pH5dataSet, offset[0], offset[1]);
+        }
+
+        // Other layers' writers may call HDF5 while this band is filtered.
+        if (lock.owns_lock())
+            lock.unlock();
+
+        processInBlocks(0, numChunks - 1, static_cast<uint32_t>(chunkCells),
+            [&](uint32_t first, uint32_t last) {
+                for (auto index=first; index<=last; ++index)
+                    filterChunk(chunks[index],
+                        (bandStart + index / numChunkColumns) * chunkRows,
+                        (index % numChunkColumns) * chunkColumns);
+            });
+
+        if (lock.mutex())
+            lock.lock();
+
+        for (uint32_t index=0; index<numChunks; ++index)
+        {
+            const auto& chunk = chunks[index];
+            if (chunk.failed)
+                throw std::bad_alloc{};
+
+            chunk.minMax.mergeInto(min, max);
+
+            if (chunk.skipped)
+                continue;
+
+            const auto offset = chunkOffset(index);
+
+            if (H5Dwrite_chunk(m_pH5dataSet->getId(), H5P_DEFAULT,
+                chunk.filterMask, offset.data(), chunk.size, chunk.data) < 0)
+                throw ::H5::DataSetIException{"SimpleLayer::writeChunksDirect",
+                    "H5Dwrite_chunk failed"};
+        }
+    }
+
+    return true;
+#endif
+}
+
+//! Set the min/max of the layer to exactly that of its nodes.
+/*!
+    Writing to a layer only ever widens its min/max, so overwriting the
+    nodes holding an extreme leaves it stale.  This finds the min/max again
+    from the summary of each tile of the layer (see LayerTiles), reading
+    only the tiles written in part since they were last summarized.  The
+    first call reads the whole layer, unless it has a zone map; from then on
+    the layer keeps the summaries up to date, and Dataset::commit() calls
+    this too.
+
+    When the BAG is shared by several processes every tile is read, as other
+    processes write to it too.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+*/
+void SimpleLayer::updateMinMax()
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    if (m_tileSummaries.empty())
+        this->initTileSummaries();
+    else if (pDataset->isParallel())
+        for (auto& tile : m_tileSummaries)
+            tile = {};
+
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [this](auto traits) {
+            this->summarizeDirtyTiles<decltype(traits)>();
+        });
+
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+
+    for (const auto& tile : m_tileSummaries)
+    {
+        if (tile.count == 0)
+            continue;
+
+        min = std::min(min, tile.min);
+        max = std::max(max, tile.max);
+    }
+
+    m_descriptor.setMinMax(min, max);
+    this->writeAttributes();
+}
+
+//! Summarize each tile of the layer in a zone map, stored in the BAG.
+/*!
+    The zone map holds the min, max and number of non null nodes of each
+    tile of the layer (see LayerTiles), so findTiles() can skip the tiles
+    that cannot hold the values looked for, or that are empty, without
+    reading them.  It is stored in ZONE_MAPS_PATH, named after the layer,
+    and read when the layer is opened.
+
+    Writes to the layer keep the zone map up to date; it is written to the
+    BAG along with the layer's min/max attributes.  A tile written in part
+    only has its min/max widened, and its count raised, until it is read
+    again by updateMinMax() or Dataset::commit().
+
+    Any zone map already built is brought up to date.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+*/
+void SimpleLayer::buildZoneMap()
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    if (m_tileSummaries.empty())
+        this->initTileSummaries();
+
+    // A layer without nodes has no tiles.
+    if (m_tileSummaries.empty())
+        return;
+
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [this](auto traits) {
+            this->summarizeDirtyTiles<decltype(traits)>();
+        });
+
+    if (!m_pZoneMap)
+    {
+        auto& h5file = pDataset->getH5file();
+
+        const auto zoneMapsGroup = std::string{ZONE_MAPS_PATH};
+        if (H5Lexists(h5file.getId(), zoneMapsGroup.c_str(), H5P_DEFAULT) <= 0)
+            h5file.createGroup(zoneMapsGroup);
+
+        const auto path = this->getZoneMapPath();
+        if (H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) > 0)
+            h5file.unlink(path);
+
+        const std::array<hsize_t, kRank> dims{
+            m_tileSummaries.size() / m_numTileColumns, m_numTileColumns};
+        const ::H5::DataSpace h5dataSpace{kRank, dims.data(), dims.data()};
+
+        m_pZoneMap = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
+            new ::H5::DataSet{h5file.createDataSet(path, createZoneMapType(),
+                h5dataSpace)}, DeleteH5dataSet{});
+    }
+
+    m_changedTileRows = {0,
+        static_cast<uint32_t>(m_tileSummaries.size() / m_numTileColumns) - 1};
+    this->writeZoneMap();
+}
+
+//! Determine if the layer has a zone map.
+/*!
+\return
+    \e true if buildZoneMap() was called, or the BAG holds a zone map of the
+    layer.
+    \e false otherwise.
+*/
+bool SimpleLayer::hasZoneMap() const noexcept
+{
+    return m_pZoneMap != nullptr;
+}
+
+//! Find the tiles of the layer that may hold values in a range.
+/*!
+    The tiles are those of LayerTiles, so each can be read with
+    LayerTiles::getTile().  Tiles whose summary shows they are empty, or that
+    all their values are outside the range, are left out.  Without summaries
+    (see buildZoneMap() and updateMinMax()) every tile is returned.
+
+\param minValue
+    The smallest value looked for.
+\param maxValue
+    The largest value looked for.
+
+\return
+    The row and column of each tile, in row major order.
+*/
+std::vector<std::tuple<uint32_t, uint32_t>> SimpleLayer::findTiles(
+    float minValue,
+    float maxValue) const
+{
+    std::vector<std::tuple<uint32_t, uint32_t>> found;
+
+    if (m_tileSummaries.empty())
+    {
+        const auto allTiles = this->tiles();
+        for (uint32_t tileRow=0; tileRow<allTiles.getNumTileRows(); ++tileRow)
+            for (uint32_t tileColumn=0;
+                tileColumn<allTiles.getNumTileColumns(); ++tileColumn)
+                found.emplace_back(tileRow, tileColumn);
+
+        return found;
+    }
+
+    // Summaries of the values written may be off the stored, quantized
+    // values by the error bound.
+    const auto slack = static_cast<float>(
+        m_descriptor.getQuantization().absErrorBound);
+
+    for (size_t index=0; index<m_tileSummaries.size(); ++index)
+    {
+        const auto& tile = m_tileSummaries[index];
+        if (tile.count > 0 && tile.max + slack >= minValue &&
+            tile.min - slack <= maxValue)
+            found.emplace_back(static_cast<uint32_t>(index / m_numTileColumns),
+                static_cast<uint32_t>(index % m_numTileColumns));
+    }
+
+    return found;
+}
+
+//! Find the nodes of a window of the layer whose values are in a range.
+/*!
+    Only the tiles findTiles() returns are read, so with a zone map (see
+    buildZoneMap()) a search for rare values reads little of the layer.  The
+    tiles read are searched on several threads.
+
+    An InvalidReadSize exception is thrown if the window is outside the
+    layer.
+
+\param minValue
+    The smallest value looked for.
+\param maxValue
+    The largest value looked for.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive); clipped to the layer.
+\param columnEnd
+    The ending column (inclusive); clipped to the layer.
+
+\return
+    The non null nodes whose values are from minValue to maxValue, in row
+    major order.
+*/
+std::vector<LayerCell> SimpleLayer::findCells(
+    float minValue,
+    float maxValue,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto lastRow = static_cast<uint32_t>(std::min<hsize_t>(rowEnd,
+        fileDims[0] - 1));
+    const auto lastColumn = static_cast<uint32_t>(std::min<hsize_t>(
+        columnEnd, fileDims[1] - 1));
+    if (fileDims[0] == 0 || fileDims[1] == 0 ||
+        rowStart > lastRow || columnStart > lastColumn)
+        throw InvalidReadSize{};
+
+    std::vector<LayerCell> found;
+
+    // No value is in an empty range.
+    if (!(minValue <= maxValue))
+        return found;
+
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [&](auto traits) {
+            found = this->findCellsTyped<decltype(traits)>(minValue, maxValue,
+                rowStart, columnStart, lastRow, lastColumn);
+        });
+
+    return found;
+}
+
+//! Find the nodes of a window of a layer whose type is known at compile
+//! time whose values are in a range.
+/*!
+    The window has been checked to be within the layer, and the range to
+    not be empty.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param minValue
+    The smallest value looked for.
+\param maxValue
+    The largest value looked for.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The nodes found, in row major order.
+*/
+template <typename Traits>
+std::vector<LayerCell> SimpleLayer::findCellsTyped(
+    float minValue,
+    float maxValue,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    using T = typename Traits::value_type;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) =
+        m_descriptor.getChunkDims();
+    const auto tileRows = chunkRows > 0 ?
+        static_cast<uint32_t>(chunkRows) : kDefaultTileSize;
+    const auto tileColumns = chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkColumns) : kDefaultTileSize;
+
+    // The tiles are those of the summaries, as in findTiles().
+    const auto slack = static_cast<float>(
+        m_descriptor.getQuantization().absErrorBound);
+    const auto mayHoldRange = [&](uint32_t tileRow, uint32_t tileColumn) {
+        if (m_tileSummaries.empty())
+            return true;
+
+        const auto& tile = m_tileSummaries[
+            static_cast<size_t>(tileRow) * m_numTileColumns + tileColumn];
+        return tile.count > 0 && tile.max + slack >= minValue &&
+            tile.min - slack <= maxValue;
+    };
+
+    const auto inRange = [minValue, maxValue](float value) noexcept {
+        // NaN is never in the range.
+        return (value >= minValue) & (value <= maxValue);
+    };
+
+    const auto maxRunTiles = static_cast<uint32_t>(std::max<size_t>(1,
+        kFindCellsBandCells / (static_cast<size_t>(tileRows) * tileColumns)));
+    const auto lastTile = columnEnd / tileColumns;
+
+    std::vector<LayerCell> found;
+    std::vector<T> band;
+    std::vector<TileCells> tiles;
+
+    for (auto bandStart=rowStart; bandStart<=rowEnd; )
+    {
+        const auto bandEnd = std::min(
+            (bandStart / tileRows + 1) * tileRows - 1, rowEnd);
+        const auto numRows = bandEnd - bandStart + 1;
+        const auto tileRow = bandStart / tileRows;
+        const auto bandFound = found.size();
+
+        for (auto runStart=columnStart; runStart<=columnEnd; )
+        {
+            // Skip the tiles that cannot hold a value in the range, and read
+            // the next tiles that may, together.
+            const auto firstTile = runStart / tileColumns;
+            if (!mayHoldRange(tileRow, firstTile))
+            {
+                runStart = (firstTile + 1) * tileColumns;
+                continue;
+            }
+
+            auto lastRunTile = firstTile;
+            while (lastRunTile < lastTile &&
+                lastRunTile - firstTile + 1 < maxRunTiles &&
+                mayHoldRange(tileRow, lastRunTile + 1))
+                ++lastRunTile;
+
+            const auto runEnd = std::min((lastRunTile + 1) * tileColumns - 1,
+                columnEnd);
+            const auto numColumns = runEnd - runStart + 1;
+            const auto numTiles = lastRunTile - firstTile + 1;
+
+            band.resize(static_cast<size_t>(numRows) * numColumns);
+            this->readIntoProxy(bandStart, runStart, bandEnd, runEnd,
+                reinterpret_cast<uint8_t*>(band.data()),
+                numColumns * sizeof(T));
+
+            tiles.assign(numTiles, TileCells{});
+
+            const auto searchTile = [&](uint32_t index) noexcept {
+                auto& tile = tiles[index];
+
+                // The first tile of the run may start part way into a chunk.
+                const auto tileStart = std::max((firstTile + index) *
+                    tileColumns, runStart);
+                const auto tileEnd = std::min((firstTile + index + 1) *
+                    tileColumns - 1, runEnd);
+
+                const auto addIfFound = [&](uint32_t row, uint32_t column,
+                    T value) {
+                    if (inRange(static_cast<float>(value)) &&
+                        !Traits::isNull(value))
+                        tile.cells.push_back({bandStart + row, column,
+                            static_cast<float>(value)});
+                };
+
+                try
+                {
+                    for (uint32_t row=0; row<numRows; ++row)
+                    {
+                        const auto* values = band.data() +
+                            static_cast<size_t>(row) * numColumns +
+                            (tileStart - runStart);
+                        const auto numValues = tileEnd - tileStart + 1;
+
+                        // Compare a block without branching, and only look
+                        // at its values one by one if any is in the range;
+                        // most blocks have none.
+                        uint32_t i = 0;
+                        for (; numValues - i >= kFindCellsBlockSize;
+                            i += kFindCellsBlockSize)
+                        {
+                            bool any = false;
+                            for (uint32_t j=0; j<kFindCellsBlockSize; ++j)
+                                any |= inRange(
+                                    static_cast<float>(values[i + j]));
+
+                            if (!any)
+                                continue;
+
+                            for (uint32_t j=0; j<kFindCellsBlockSize; ++j)
+                                addIfFound(row, tileStart + i + j,
+                                    values[i + j]);
+                        }
+
+                        for (; i<numValues; ++i)
+                            addIfFound(row, tileStart + i, values[i]);
+                    }
+                }
+                catch (...)
+                {
+                    tile.failed = true;
+                }
+            };
+
+            processInBlocks(0, numTiles - 1,
+                static_cast<uint32_t>(numRows) * tileColumns,
+                [&](uint32_t first, uint32_t last) {
+                    for (auto index=first; index<=last; ++index)
+                        searchTile(index);
+                });
+
+            for (const auto& tile : tiles)
+            {
+                if (tile.failed)
+                    throw std::bad_alloc{};
+
+                found.insert(found.end(), tile.cells.begin(),
+                    tile.cells.end());
+            }
+
+            runStart = runEnd + 1;
+        }
+
+        // Each tile is in row major order; that of the band interleaves them.
+        std::sort(found.begin() + bandFound, found.end(),
+            [](const LayerCell& lhs, const LayerCell& rhs) {
+                return lhs.row != rhs.row ? lhs.row < rhs.row :
+                    lhs.col < rhs.col;
+            });
+
+        bandStart = bandEnd + 1;
+    }
+
+    return found;
+}
+
+//! Start keeping a summary of each tile of the layer.
+/*!
+    The tiles are those of LayerTiles.  Every tile starts unsummarized.
+*/
+void SimpleLayer::initTileSummaries()
+{
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) =
+        m_descriptor.getChunkDims();
+
+    if (chunkRows > 0 && chunkColumns > 0)
+        m_tileDims = {static_cast<uint32_t>(chunkRows),
+            static_cast<uint32_t>(chunkColumns)};
+    else
+        m_tileDims = {kDefaultTileSize, kDefaultTileSize};
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto numTileRows = static_cast<uint32_t>(
+        (fileDims[0] + m_tileDims[0] - 1) / m_tileDims[0]);
+    m_numTileColumns = static_cast<uint32_t>(
+        (fileDims[1] + m_tileDims[1] - 1) / m_tileDims[1]);
+
+    m_tileSummaries.assign(static_cast<size_t>(numTileRows) *
+        m_numTileColumns, TileSummary{});
+}
+
+//! Update the summaries of the tiles an area of the layer overlaps, after
+//! it was written.
+/*!
+    A tile the area covers is summarized exactly.  A tile it covers in part
+    has its min/max widened and its count raised, and is marked to be read
+    again by updateMinMax().  Nothing is kept until the summaries are
+    started.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The elements written, row by row.
+*/
+template <typename Traits>
+void SimpleLayer::updateTileSummaries(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const typename Traits::value_type* buffer)
+{
+    if (m_tileSummaries.empty())
+        return;
+
+    const auto firstTileRow = rowStart / m_tileDims[0];
+    const auto lastTileRow = rowEnd / m_tileDims[0];
+    this->noteTileRowsChanged(firstTileRow, lastTileRow);
+
+    // Other processes write to the layer too, so nothing is known of it.
+    const auto pDataset = this->getDataset().lock();
+    if (pDataset->isParallel())
+    {
+        for (auto& tile : m_tileSummaries)
+            tile = {};
+
+        this->noteTileRowsChanged(0, static_cast<uint32_t>(
+            m_tileSummaries.size() / m_numTileColumns) - 1);
+        return;
+    }
+
+    std::array<hsize_t, kRank> fileDims{};
+    {
+        const auto lock = pDataset->lockWrites();
+        m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    }
+
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    for (auto tileRow=firstTileRow; tileRow<=lastTileRow; ++tileRow)
+    {
+        const auto tileRowStart = tileRow * m_tileDims[0];
+        const auto tileRowEnd = static_cast<uint32_t>(std::min<hsize_t>(
+            tileRowStart + m_tileDims[0], fileDims[0]) - 1);
+        const auto first = std::max(rowStart, tileRowStart);
+        const auto last = std::min(rowEnd, tileRowEnd);
+
+        for (auto tileColumn=columnStart / m_tileDims[1];
+            tileColumn<=columnEnd / m_tileDims[1]; ++tileColumn)
+        {
+            const auto tileColumnStart = tileColumn * m_tileDims[1];
+            const auto tileColumnEnd = static_cast<uint32_t>(
+                std::min<hsize_t>(tileColumnStart + m_tileDims[1],
+                    fileDims[1]) - 1);
+            const auto left = std::max(columnStart, tileColumnStart);
+            const auto right = std::min(columnEnd, tileColumnEnd);
+
+            MinMax<typename Traits::value_type> minMax;
+            uint64_t count = 0;
+
+            for (auto row=first; row<=last; ++row)
+            {
+                const auto* values = buffer +
+                    static_cast<size_t>(row - rowStart) * columns +
+                    (left - columnStart);
+                const auto width = right - left + 1;
+
+                // Null cells do not contribute to the min/max.
+                computeMinMax(values, width, 1, Traits::getNullValue())
+                    .mergeInto(minMax.min, minMax.max);
+                count += std::count_if(values, values + width,
+                    [](typename Traits::value_type value) {
+                        return !Traits::isNull(value) && value == value;
+                    });
+            }
+
+            auto& tile = m_tileSummaries[static_cast<size_t>(tileRow) *
+                m_numTileColumns + tileColumn];
+
+            if (first == tileRowStart && last == tileRowEnd &&
+                left == tileColumnStart && right == tileColumnEnd)
+            {
+                tile.min = std::numeric_limits<float>::max();
+                tile.max = std::numeric_limits<float>::lowest();
+                tile.count = static_cast<uint32_t>(count);
+                tile.dirty = false;
+            }
+            else
+            {
+                tile.count = static_cast<uint32_t>(std::min<uint64_t>(
+                    uint64_t{tile.count} + count,
+                    std::numeric_limits<uint32_t>::max()));
+                tile.dirty = true;
+            }
+
+            minMax.mergeInto(tile.min, tile.max);
+        }
+    }
+}
+
+//! Summarize the tiles not summarized exactly.
+/*!
+    Runs of such tiles along a row of tiles are read at once.
+
+\tparam Traits
+    The LayerTraits of the layer.
+*/
+template <typename Traits>
+void SimpleLayer::summarizeDirtyTiles()
+{
+    using T = typename Traits::value_type;
+
+    if (m_tileSummaries.empty())
+        return;
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    const auto rows = static_cast<uint32_t>(fileDims[0]);
+    const auto columns = static_cast<uint32_t>(fileDims[1]);
+
+    const auto tileRows = m_tileDims[0];
+    const auto tileColumns = m_tileDims[1];
+    const auto maxRunTiles = static_cast<uint32_t>(std::max<size_t>(1,
+        kMinMaxBandCells / (static_cast<size_t>(tileRows) * tileColumns)));
+    const auto numTileRows = static_cast<uint32_t>(
+        m_tileSummaries.size() / m_numTileColumns);
+
+    std::vector<T> band;
+
+    for (uint32_t tileRow=0; tileRow<numTileRows; ++tileRow)
+    {
+        auto* tiles = m_tileSummaries.data() +
+            static_cast<size_t>(tileRow) * m_numTileColumns;
+        const auto rowStart = tileRow * tileRows;
+        const auto rowEnd = std::min(rowStart + tileRows, rows) - 1;
+        const auto numRows = rowEnd - rowStart + 1;
+
+        for (uint32_t first=0; first<m_numTileColumns; )
+        {
+            if (!tiles[first].dirty)
+            {
+                ++first;
+                continue;
+            }
+
+            auto last = first;
+            while (last + 1 < m_numTileColumns && tiles[last + 1].dirty &&
+                last + 1 - first < maxRunTiles)
+                ++last;
+
+            const auto columnStart = first * tileColumns;
+            const auto columnEnd = std::min((last + 1) * tileColumns,
+                columns) - 1;
+            const auto numColumns = columnEnd - columnStart + 1;
+
+            band.resize(static_cast<size_t>(numRows) * numColumns);
+            this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+                reinterpret_cast<uint8_t*>(band.data()),
+                numColumns * sizeof(T));
+
+            for (auto index=first; index<=last; ++index)
+            {
+                const auto offset = (index - first) * tileColumns;
+                const auto width = std::min(tileColumns, numColumns - offset);
+
+                MinMax<T> minMax;
+                uint32_t count = 0;
+
+                for (uint32_t row=0; row<numRows; ++row)
+                {
+                    const auto* values = band.data() +
+                        static_cast<size_t>(row) * numColumns + offset;
+
+                    computeMinMax(values, width, 1, Traits::getNullValue())
+                        .mergeInto(minMax.min, minMax.max);
+                    count += static_cast<uint32_t>(std::count_if(values,
+                        values + width, [](T value) {
+                            return !Traits::isNull(value) && value == value;
+                        }));
+                }
+
+                auto& tile = tiles[index];
+                tile.min = std::numeric_limits<float>::max();
+                tile.max = std::numeric_limits<float>::lowest();
+                minMax.mergeInto(tile.min, tile.max);
+                tile.count = count;
+                tile.dirty = false;
+            }
+
+            this->noteTileRowsChanged(tileRow, tileRow);
+            first = last + 1;
+        }
+    }
+}
+
+//! Note that the summaries of some rows of tiles changed, so the zone map
+//! must be written.
+/*!
+\param firstTileRow
+    The first row of tiles that changed.
+\param lastTileRow
+    The last row of tiles that changed (inclusive).
+*/
+void SimpleLayer::noteTileRowsChanged(
+    uint32_t firstTileRow,
+    uint32_t lastTileRow) noexcept
+{
+    if (!m_pZoneMap)
+        return;
+
+    m_changedTileRows[0] = std::min(m_changedTileRows[0], firstTileRow);
+    m_changedTileRows[1] = std::max(m_changedTileRows[1], lastTileRow);
+}
+
+//! Retrieve the path of the zone map of the layer.
+/*!
+\return
+    The path of the HDF5 DataSet of the zone map.
+*/
+std::string SimpleLayer::getZoneMapPath() const
+{
+    const auto& path = m_descriptor.getInternalPath();
+
+    return ZONE_MAPS_PATH + path.substr(path.rfind('/') + 1);
+}
+
+//! Read the zone map of the layer, if the BAG holds one.
+/*!
+    A zone map that does not match the tiles of the layer is ignored.
+
+\param h5file
+    The HDF5 file of the BAG.
+*/
+void SimpleLayer::loadZoneMap(
+    const ::H5::H5File& h5file)
+{
+    const auto path = this->getZoneMapPath();
+    if (H5Lexists(h5file.getId(), ZONE_MAPS_PATH, H5P_DEFAULT) <= 0 ||
+        H5Lexists(h5file.getId(), path.c_str(), H5P_DEFAULT) <= 0)
+        return;
+
+    auto pZoneMap = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
+        new ::H5::DataSet{h5file.openDataSet(path)}, DeleteH5dataSet{});
+
+    this->initTileSummaries();
+
+    std::array<hsize_t, kRank> dims{};
+    const auto h5dataSpace = pZoneMap->getSpace();
+    if (h5dataSpace.getSimpleExtentNdims() != kRank)
+        return;
+
+    h5dataSpace.getSimpleExtentDims(dims.data());
+    if (dims[0] * dims[1] != m_tileSummaries.size() ||
+        dims[1] != m_numTileColumns)
+    {
+        m_tileSummaries.clear();
+        return;
+    }
+
+    std::vector<ZoneMapRecord> records(m_tileSummaries.size());
+    pZoneMap->read(records.data(), createZoneMapType());
+
+    for (size_t index=0; index<records.size(); ++index)
+    {
+        auto& tile = m_tileSummaries[index];
+        tile.min = records[index].min;
+        tile.max = records[index].max;
+        tile.count = records[index].count;
+        tile.dirty = records[index].dirty != 0;
+    }
+
+    m_pZoneMap = std::move(pZoneMap);
+}
+
+//! Write the rows of the zone map that changed since it was last written.
+void SimpleLayer::writeZoneMap() const
+{
+    if (!m_pZoneMap || m_changedTileRows[0] > m_changedTileRows[1])
+        return;
+
+    const auto firstTileRow = m_changedTileRows[0];
+    const auto numTileRows = m_changedTileRows[1] - firstTileRow + 1;
+
+    std::vector<ZoneMapRecord> records(
+        static_cast<size_t>(numTileRows) * m_numTileColumns);
+    const auto* tile = m_tileSummaries.data() +
+        static_cast<size_t>(firstTileRow) * m_numTileColumns;
+
+    for (auto& record : records)
+    {
+        record.min = tile->min;
+        record.max = tile->max;
+        record.count = tile->count;
+        record.dirty = tile->dirty ? 1 : 0;
+        ++tile;
+    }
+
+    const std::array<hsize_t, kRank> count{numTileRows, m_numTileColumns};
+    const std::array<hsize_t, kRank> offset{firstTileRow, 0};
+
+    const auto h5fileSpace = m_pZoneMap->getSpace();
+    h5fileSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+    const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
+
+    m_pZoneMap->write(records.data(), createZoneMapType(), h5memSpace,
+        h5fileSpace);
+
+    m_changedTileRows = {std::numeric_limits<uint32_t>::max(), 0};
+}
+
+//! Compute the statistics of the non null nodes of the layer.
+/*!
+    The layer is read a row of chunks (or tiles of kDefaultTileSize, if it is
+    not chunked) at a time.  The nodes of each chunk are gathered on several
+    threads into a summary of their own, and the summaries are then merged
+    in order: the mean and standard deviation with Welford's method, and the
+    percentiles from a t-digest.  Nodes that are null (such as
+    BAG_NULL_ELEVATION and BAG_NULL_UNCERTAINTY), or NaN, are only counted.
+
+    If asked to, the statistics are written as attributes of the layer:
+    "Statistics Count", "Statistics Null Count", "Statistics Mean",
+    "Statistics Standard Deviation", "Statistics Histogram" with
+    "Statistics Histogram Range", and "Statistics Percentiles" with
+    "Statistics Percentile Values".
+
+    An InvalidReadSize exception is thrown if the window is outside the
+    layer, an InvalidPercentile exception if a percentile is outside 0 to
+    100, and a ReadOnlyError exception if the attributes are to be written
+    to a read only BAG.  If options.progress is cancelled, an
+    OperationCancelled exception is thrown, and no attributes are written.
+
+\param options
+    What to compute, and from which nodes.
+
+
+\return
+    The statistics.
+*/
+LayerStatistics SimpleLayer::computeStatistics(
+    const StatsOptions& options) const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (options.writeAttributes && pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    for (const auto percentile : options.percentiles)
+        if (!(percentile >= 0. && percentile <= 100.))
+            throw InvalidPercentile{};
+
+    std::array<hsize_t, kRank> fileDims{};
+    m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+
+    const auto rowEnd = static_cast<uint32_t>(std::min<hsize_t>(
+        options.rowEnd, fileDims[0] - 1));
+    const auto columnEnd = static_cast<uint32_t>(std::min<hsize_t>(
+        options.columnEnd, fileDims[1] - 1));
+    if (fileDims[0] == 0 || fileDims[1] == 0 ||
+        options.rowStart > rowEnd || options.columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    LayerStatistics statistics;
+
+    visitLayerTraits(m_descriptor.getLayerType(),
+        [&](auto traits) {
+            statistics = this->computeStatisticsTyped<decltype(traits)>(
+                options, options.rowStart, options.columnStart, rowEnd,
+                columnEnd);
+        });
+
+    if (options.writeAttributes)
+        this->writeStatisticsAttributes(statistics, options);
+
+    return statistics;
+}
+
+//! Compute the statistics of a window of a layer whose type is known at
+//! compile time.
+/*!
+    The window has been checked to be within the layer.
+
+\tparam Traits
+    The LayerTraits of the layer.
+
+\param options
+    What to compute.
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+
+\return
+    The statistics.
+*/
+template <typename Traits>
+LayerStatistics SimpleLayer::computeStatisticsTyped(
+    const StatsOptions& options,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    using T = typename Traits::value_type;
+
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = m_descriptor.getChunkDims();
+    const auto tileRows = chunkRows > 0 ?
+        static_cast<uint32_t>(chunkRows) : kDefaultTileSize;
+    const auto tileColumns = chunkColumns > 0 ?
+        static_cast<uint32_t>(chunkColumns) : kDefaultTileSize;
+
+    // Without a range, the histogram spans the min/max of the layer, which
+    // holds every value.
+    double histogramMin = options.histogramMin;
+    double histogramMax = options.histogramMax;
+    if (!(histogramMin < histogramMax))
+    {
+        float min = 0.f, max = 0.f;
+        std::tie(min, max) = m_descriptor.getMinMax();
+        histogramMin = min;
+        histogramMax = max;
+    }
+
+    const auto numBins = histogramMin <= histogramMax ? options.numBins : 0u;
+    const bool wantPercentiles = !options.percentiles.empty();
+
+    TileStatistics total;
+    total.histogram = Histogram{histogramMin, histogramMax, numBins};
+    total.digest = TDigest{options.digestCompression};
+
+    // Tiles are aligned to the chunks, so each chunk is read once.
+    const auto maxRunTiles = static_cast<uint32_t>(std::max<size_t>(1,
+        kStatisticsBandCells / (static_cast<size_t>(tileRows) * tileColumns)));
+
+    std::vector<T> band;
+    std::vector<TileStatistics> tiles;
+
+    const ProgressScope progress{options.progress};
+
+    for (auto bandStart=rowStart; bandStart<=rowEnd; )
+    {
+        const auto bandEnd = std::min(
+            (bandStart / tileRows + 1) * tileRows - 1, rowEnd);
+        const auto numRows = bandEnd - bandStart + 1;
+
+        for (auto runStart=columnStart; runStart<=columnEnd; )
+        {
+            const auto firstTile = runStart / tileColumns;
+            const auto lastTile = std::min(firstTile + maxRunTiles - 1,
+                columnEnd / tileColumns);
+            const auto runEnd = std::min((lastTile + 1) * tileColumns - 1,
+                columnEnd);
+            const auto numColumns = runEnd - runStart + 1;
+            const auto numTiles = lastTile - firstTile + 1;
+
+            band.resize(static_cast<size_t>(numRows) * numColumns);
+            this->readIntoProxy(bandStart, runStart, bandEnd, runEnd,
+                reinterpret_cast<uint8_t*>(band.data()),
+                numColumns * sizeof(T));
+
+            tiles.assign(numTiles, TileStatistics{});
+            for (auto& tile : tiles)
+            {
+                tile.histogram = Histogram{histogramMin, histogramMax, numBins};
+                tile.digest = TDigest{options.digestCompression};
+            }
+
+            const auto summarizeTile = [&](uint32_t index) noexcept {
+                auto& tile = tiles[index];
+
+                // The first tile of the run may start part way into a chunk.
+                const auto tileStart = std::max((firstTile + index) *
+                    tileColumns, runStart);
+                const auto tileEnd = std::min((firstTile + index + 1) *
+                    tileColumns - 1, runEnd);
+
+                try
+                {
+                    for (uint32_t row=0; row<numRows; ++row)
+                    {
+                        const auto* values = band.data() +
+                            static_cast<size_t>(row) * numColumns +
+                            (tileStart - runStart);
+
+                        for (auto column=tileStart; column<=tileEnd; ++column)
+                        {
+                            const auto value = *values++;
+
+                            // NaN compares unequal to itself.
+                            if (Traits::isNull(value) || value != value)
+                            {
+                                ++tile.nullCount;
+                                continue;
+                            }
+
+                            const auto asDouble = static_cast<double>(value);
+                            tile.min = std::min(tile.min, asDouble);
+                            tile.max = std::max(tile.max, asDouble);
+                            tile.moments.add(asDouble);
+                            tile.histogram.add(asDouble);
+
+                            if (wantPercentiles)
+                                tile.digest.add(asDouble);
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    tile.failed = true;
+                }
+            };
+
+            processInBlocks(0, numTiles - 1,
+                static_cast<uint32_t>(numRows) * tileColumns,
+                [&](uint32_t first, uint32_t last) {
+                    for (auto index=first; index<=last; ++index)
+                        summarizeTile(index);
+                });
+
+            // Merge in order, so the results do not depend on the threads.
+            for (const auto& tile : tiles)
+            {
+                if (tile.failed)
+                    throw std::bad_alloc{};
+
+                total.nullCount += tile.nullCount;
+                total.min = std::min(total.min, tile.min);
+                total.max = std::max(total.max, tile.max);
+                total.moments.merge(tile.moments);
+                total.histogram.merge(tile.histogram);
+
+                if (wantPercentiles)
+                    total.digest.merge(tile.digest);
+            }
+
+            runStart = runEnd + 1;
+        }
+
+        progress.report(bandEnd - rowStart + 1, rowEnd - rowStart + 1);
+
+        bandStart = bandEnd + 1;
+    }
+
+    LayerStatistics statistics;
+    statistics.count = total.moments.count;
+    statistics.nullCount = total.nullCount;
+
+    if (statistics.count > 0)
+    {
+        statistics.min = total.min;
+        statistics.max = total.max;
+        statistics.mean = total.moments.mean;
+        statistics.standardDeviation =
+            std::sqrt(total.moments.getVariance());
+    }
+
+    statistics.histogramMin = histogramMin;
+    statistics.histogramMax = histogramMax;
+    statistics.histogram = std::move(total.histogram.counts);
+
+    for (const auto percentile : options.percentiles)
+        statistics.percentiles.push_back(
+            total.digest.getQuantile(percentile / 100.));
+
+    return statistics;
+}
+
+//! Write the statistics of the layer as attributes of it.
+/*!
+\param statistics
+    The statistics.
+\param options
+    What the statistics were computed with.
+*/
+void SimpleLayer::writeStatisticsAttributes(
+    const LayerStatistics& statistics,
+    const StatsOptions& options) const
+{
+    const auto& h5dataSet = *m_pH5dataSet;
+    const auto& h5uint64 = ::H5::PredType::NATIVE_UINT64;
+    const auto& h5double = ::H5::PredType::NATIVE_DOUBLE;
+
+    writeStatisticsAttribute(h5dataSet, "Statistics Count", h5uint64,
+        &statistics.count, 1);
+    writeStatisticsAttribute(h5dataSet, "Statistics Null Count", h5uint64,
+        &statistics.nullCount, 1);
+    writeStatisticsAttribute(h5dataSet, "Statistics Mean", h5double,
+        &statistics.mean, 1);
+    writeStatisticsAttribute(h5dataSet, "Statistics Standard Deviation",
+        h5double, &statistics.standardDeviation, 1);
+
+    if (!statistics.histogram.empty())
+    {
+        const std::array<double, 2> range{statistics.histogramMin,
+            statistics.histogramMax};
+
+        writeStatisticsAttribute(h5dataSet, "Statistics Histogram", h5uint64,
+            statistics.histogram.data(), statistics.histogram.size());
+        writeStatisticsAttribute(h5dataSet, "Statistics Histogram Range",
+            h5double, range.data(), range.size());
+    }
+
+    if (!statistics.percentiles.empty())
+    {
+        writeStatisticsAttribute(h5dataSet, "Statistics Percentiles",
+            h5double, options.percentiles.data(), options.percentiles.size());
+        writeStatisticsAttribute(h5dataSet, "Statistics Percentile Values",
+            h5double, statistics.percentiles.data(),
+            statistics.percentiles.size());
+    }
+}
+
+//! Start writing the layer a band of whole chunk rows at a time.
+/*!
+\return
+    The writer.  Close it, or let it go out of scope, when done.
+*/
+std::unique_ptr<SimpleLayer::StripWriter> SimpleLayer::stripWriter()
+{
+    return std::unique_ptr<StripWriter>(new StripWriter{*this});
+}
+
+//! Constructor.
+/*!
+\param layer
+    The layer to write to.
+*/
+SimpleLayer::StripWriter::StripWriter(
+    SimpleLayer& layer)
+    : m_layer(layer)
+{
+    std::array<hsize_t, kRank> fileDims{};
+    layer.m_pH5fileDataSpace->getSimpleExtentDims(fileDims.data());
+    m_rows = static_cast<uint32_t>(fileDims[0]);
+    m_columns = static_cast<uint32_t>(fileDims[1]);
+    m_elementSize = layer.m_descriptor.getElementSize();
+
+    // A layer that is not chunked is written as it comes.
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = layer.m_descriptor.getChunkDims();
+    m_bandRows = static_cast<uint32_t>(std::min<uint64_t>(chunkRows, m_rows));
+
+    if (m_bandRows > 0)
+    {
+        m_band.resize(static_cast<size_t>(m_bandRows) * m_columns *
+            m_elementSize);
+        m_rowsWritten.resize(m_bandRows);
+    }
+}
+
+//! Destructor.
+/*!
+    Closes the writer if it is still open.  Errors are lost; call close()
+    to see them.
+*/
+SimpleLayer::StripWriter::~StripWriter() noexcept
+{
+    try
+    {
+        this->close();
+    }
+    catch (...)
+    {
+    }
+}
+
+//! Write a section of the layer.
+/*!
+    The section is gathered into the band it falls in, and written with the
+    band.  A section outside the band writes the band first.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param buffer
+    The elements to write, row by row.
+*/
+void SimpleLayer::StripWriter::write(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    const uint8_t* buffer)
+{
+    if (m_closed)
+        throw StripWriterClosed{};
+
+    if (!buffer)
+        throw InvalidBuffer{};
+
+    if (rowStart > rowEnd || columnStart > columnEnd || rowEnd >= m_rows ||
+        columnEnd >= m_columns)
+        throw InvalidWriteSize{};
+
+    if (m_bandRows == 0)
+    {
+        m_layer.write(rowStart, columnStart, rowEnd, columnEnd, buffer);
+        return;
+    }
+
+    const bool wholeRows = columnStart == 0 && columnEnd == m_columns - 1;
+    const auto rowBytes = (columnEnd - columnStart + 1) * m_elementSize;
+    const auto bandRowBytes = m_columns * m_elementSize;
+
+    for (auto row=rowStart; row<=rowEnd; )
+    {
+        if (m_bandSize == 0 || row < m_bandStart ||
+            row >= m_bandStart + m_bandSize)
+        {
+            this->flush();
+            this->startBand(row);
+        }
+
+        // The nodes of a partly written row come from the layer.
+        if (!wholeRows && !m_bandLoaded)
+            this->loadBand();
+
+        const auto last = std::min(rowEnd, m_bandStart + m_bandSize - 1);
+
+        for (; row<=last; ++row)
+        {
+            const auto bandRow = row - m_bandStart;
+
+            std::memcpy(m_band.data() + bandRow * bandRowBytes +
+                columnStart * m_elementSize,
+                buffer + (row - rowStart) * rowBytes, rowBytes);
+
+            if (wholeRows && !m_rowsWritten[bandRow])
+            {
+                m_rowsWritten[bandRow] = true;
+                ++m_numRowsWritten;
+            }
+        }
+
+        m_bandDirty = true;
+
+        if (m_numRowsWritten == m_bandSize)
+            this->flush();
+    }
+}
+
+//! Write what is buffered.
+/*!
+    Does nothing if the writer is already closed.
+*/
+void SimpleLayer::StripWriter::close()
+{
+    if (m_closed)
+        return;
+
+    this->flush();
+
+    m_closed = true;
+}
+
+//! Write the band to the layer, and forget it.
+void SimpleLayer::StripWriter::flush()
+{
+    if (m_bandDirty)
+    {
+        if (!m_bandLoaded && m_numRowsWritten < m_bandSize)
+            this->loadBand();
+
+        m_layer.write(m_bandStart, 0, m_bandStart + m_bandSize - 1,
+            m_columns - 1, m_band.data());
+    }
+
+    m_bandSize = 0;
+    m_bandDirty = false;
+}
+
+//! Read the rows of the band not written whole from the layer.
+void SimpleLayer::StripWriter::loadBand()
+{
+    const auto bandRowBytes = m_columns * m_elementSize;
+
+    for (uint32_t first=0; first<m_bandSize; )
+    {
+        if (m_rowsWritten[first])
+        {
+            ++first;
+            continue;
+        }
+
+        auto last = first;
+        while (last + 1 < m_bandSize && !m_rowsWritten[last + 1])
+            ++last;
+
+        m_layer.readInto(m_bandStart + first, 0, m_bandStart + last,
+            m_columns - 1, m_band.data() + first * bandRowBytes,
+            (last - first + 1) * bandRowBytes);
+
+        first = last + 1;
+    }
+
+    m_bandLoaded = true;
+}
+
+//! Start gathering the band a row is in.
+/*!
+\param row
+    The row.
+*/
+void SimpleLayer::StripWriter::startBand(
+    uint32_t row)
+{
+    m_bandStart = row - row % m_bandRows;
+    m_bandSize = std::min(m_bandRows, m_rows - m_bandStart);
+    std::fill(m_rowsWritten.begin(), m_rowsWritten.end(), false);
+    m_numRowsWritten = 0;
+    m_bandDirty = false;
+    m_bandLoaded = false;
+}
+
+void SimpleLayer::DeleteMappedRegion::operator()(MappedRegion* ptr) noexcept
+{
+    delete ptr;
 }
 
 }   //namespace BAG
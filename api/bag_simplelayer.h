@@ -7,17 +7,29 @@
 #include "bag_layer.h"
 #include "bag_types.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
 
 
 namespace H5 {
 
 class DataSet;
+class DataSpace;
+class DataType;
+class H5File;
 
 }  // namespace H5
 
 namespace BAG {
 
+class MappedRegion;
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
@@ -44,9 +56,118 @@ public:
         return !(rhs == *this);
     }
 
+    //! Writes a layer a band of whole chunk rows at a time.
+    /*!
+        Each write of part of a chunk makes HDF5 read, modify and recompress
+        the chunk, so writing a layer a row at a time compresses every chunk
+        once per row in it.  The writer instead gathers the writes into a
+        band one chunk row high and as wide as the grid, and writes the band
+        once it is complete, or when a write falls outside it; each chunk is
+        then compressed about once, on several threads.
+
+        Nodes of a band that are not written keep their value in the file.
+        Closing the writer writes what is buffered.
+
+        Nothing else may write to the layer while the writer is open.
+    */
+    class BAG_API StripWriter final
+    {
+    public:
+        ~StripWriter() noexcept;
+
+        StripWriter(const StripWriter&) = delete;
+        StripWriter(StripWriter&&) = delete;
+
+        StripWriter& operator=(const StripWriter&) = delete;
+        StripWriter& operator=(StripWriter&&) = delete;
+
+        void write(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+            uint32_t columnEnd, const uint8_t* buffer);
+        void close();
+
+    private:
+        explicit StripWriter(SimpleLayer& layer);
+
+        void flush();
+        void loadBand();
+        void startBand(uint32_t row);
+
+        //! The layer written to.
+        SimpleLayer& m_layer;
+        //! The number of rows in the layer.
+        uint32_t m_rows = 0;
+        //! The number of columns in the layer.
+        uint32_t m_columns = 0;
+        //! The size of an element, in bytes.
+        size_t m_elementSize = 0;
+        //! The number of rows in a band; the rows of a chunk.
+        uint32_t m_bandRows = 0;
+        //! The first row of the band.
+        uint32_t m_bandStart = 0;
+        //! The number of rows of the band inside the layer.
+        uint32_t m_bandSize = 0;
+        //! The nodes of the band.
+        std::vector<uint8_t> m_band;
+        //! Has each row of the band been written whole?
+        std::vector<bool> m_rowsWritten;
+        //! The number of rows of the band written whole.
+        uint32_t m_numRowsWritten = 0;
+        //! Does the band hold anything to write?
+        bool m_bandDirty = false;
+        //! Has the band been read from the layer?
+        bool m_bandLoaded = false;
+        //! Has the writer been closed?
+        bool m_closed = false;
+
+        friend SimpleLayer;
+    };
+
+    std::unique_ptr<StripWriter> stripWriter();
+
+    void updateMinMax();
+    void buildZoneMap();
+    bool hasZoneMap() const noexcept;
+    std::vector<std::tuple<uint32_t, uint32_t>> findTiles(float minValue,
+        float maxValue) const;
+    std::vector<LayerCell> findCells(float minValue, float maxValue,
+        uint32_t rowStart = 0, uint32_t columnStart = 0,
+        uint32_t rowEnd = std::numeric_limits<uint32_t>::max(),
+        uint32_t columnEnd = std::numeric_limits<uint32_t>::max()) const;
+    LayerStatistics computeStatistics(const StatsOptions& options = {}) const;
+
+    void setQuantization(const Quantization& quantization);
+
+    void buildOverviews(uint32_t numLevels, OverviewMethod method,
+        ProgressToken* progress = nullptr);
+    uint32_t getNumOverviews() const;
+    std::tuple<uint32_t, uint32_t> getOverviewDims(uint32_t level) const;
+    UInt8Array readOverview(uint32_t level, uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const;
+    UInt8Array readDecimated(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint32_t rowStep,
+        uint32_t columnStep,
+        DecimationMethod method = DecimationMethod::Sample) const;
+
+    std::vector<float> sample(const std::vector<double>& xs,
+        const std::vector<double>& ys,
+        SampleMethod method = SampleMethod::Bilinear) const;
+    void sampleInto(const double* xs, const double* ys, size_t numPositions,
+        SampleMethod method, float* values) const;
+
+    void buildCoverage(ProgressToken* progress = nullptr);
+    bool hasCoverage() const;
+    uint64_t countCoveredNodes(uint32_t rowStart = 0, uint32_t columnStart = 0,
+        uint32_t rowEnd = std::numeric_limits<uint32_t>::max(),
+        uint32_t columnEnd = std::numeric_limits<uint32_t>::max()) const;
+    double getCoveragePercentage() const;
+    UInt8Array readCoverage(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+    std::vector<FootprintRing> getFootprint() const;
+
 protected:
     static std::shared_ptr<SimpleLayer> create(Dataset& dataset,
-        LayerType type, uint64_t chunkSize, int compressionLevel);
+        LayerType type, const ChunkShape& chunkShape,
+        const CompressionSpec& compression, const Quantization& quantization);
 
     static std::shared_ptr<SimpleLayer> open(Dataset& dataset,
         SimpleLayerDescriptor& descriptor);
@@ -59,15 +180,156 @@ private:
     UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const override;
 
+    void readIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const override;
+    bool readCachedTiles(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const;
+    void readFromFile(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const;
+    uint64_t getTileCacheLayerId() const;
+    void readWindowsProxy(const std::vector<LayerWindow>& windows,
+        const std::vector<size_t>& offsets, uint8_t* buffer) const override;
+
+    void readConvertedIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, DataType type, uint8_t* buffer,
+        size_t rowStrideBytes) const override;
+    void readSampledChunks(const Dataset& dataset, uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        float* values, size_t rowStride) const;
+
     void writeProxy(uint32_t rowStart, uint32_t columnStart,
         uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer) override;
+    template <typename Traits>
+    void writeTyped(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const typename Traits::value_type* buffer);
+    template <typename Traits>
+    bool writeChunksDirect(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const typename Traits::value_type* buffer, float& min, float& max);
 
     void writeAttributesProxy() const override;
 
+    void initTileSummaries();
+    template <typename Traits>
+    void updateTileSummaries(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const typename Traits::value_type* buffer);
+    template <typename Traits>
+    void summarizeDirtyTiles();
+    void noteTileRowsChanged(uint32_t firstTileRow,
+        uint32_t lastTileRow) noexcept;
+    std::string getZoneMapPath() const;
+    void loadZoneMap(const ::H5::H5File& h5file);
+    void writeZoneMap() const;
+    template <typename Traits>
+    std::vector<LayerCell> findCellsTyped(float minValue, float maxValue,
+        uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const;
+    template <typename Traits>
+    LayerStatistics computeStatisticsTyped(const StatsOptions& options,
+        uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+        uint32_t columnEnd) const;
+    void writeStatisticsAttributes(const LayerStatistics& statistics,
+        const StatsOptions& options) const;
+
+    const ::H5::DataSpace& getH5memDataSpace(uint32_t rows, uint32_t columns,
+        size_t rowStrideBytes) const;
+    const uint8_t* getMappedData() const;
+    std::string getOverviewPath(uint32_t level) const;
+    template <typename Traits>
+    void decimateTyped(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint32_t rowStep,
+        uint32_t columnStep, DecimationMethod method,
+        typename Traits::value_type* decimated) const;
+    void openOverviews() const;
+    std::string getCoveragePath() const;
+    void openCoverage() const;
+    void readCoverageBytes(uint32_t rowStart, uint32_t byteStart,
+        uint32_t rowEnd, uint32_t byteEnd, uint8_t* buffer) const;
+    template <typename Traits>
+    void updateCoverage(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const typename Traits::value_type* buffer);
+
+    //! The summary of a tile of the layer.
+    /*!
+        Until the tile is summarized exactly, min and max bound its values,
+        and count bounds its non null nodes.
+    */
+    struct TileSummary final
+    {
+        //! The smallest non null value.
+        float min = std::numeric_limits<float>::lowest();
+        //! The largest non null value.
+        float max = std::numeric_limits<float>::max();
+        //! The number of non null nodes.
+        uint32_t count = std::numeric_limits<uint32_t>::max();
+        //! Are min, max and count only bounds?
+        bool dirty = true;
+    };
+
+    //! Custom deleter to not require knowledge of MappedRegion here.
+    struct BAG_API DeleteMappedRegion final {
+        void operator()(MappedRegion* ptr) noexcept;
+    };
+
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    SimpleLayerDescriptor& m_descriptor;
     //! The HDF5 DataSet.
     std::unique_ptr<H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! The type of the elements in the HDF5 file.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5fileType;
+    //! The native type of the elements in memory.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5memType;
+    //! The DataSpace of the HDF5 DataSet (the extent of a simple layer is
+    //! fixed, so it is shared by every read and write).
+    std::unique_ptr<::H5::DataSpace, DeleteH5dataSpace> m_pH5fileDataSpace;
+    //! The memory DataSpace of the last read or write.
+    mutable std::unique_ptr<::H5::DataSpace, DeleteH5dataSpace> m_pH5memDataSpace;
+    //! The rows, columns and row stride m_pH5memDataSpace describes.
+    mutable std::array<size_t, 3> m_memDataSpaceShape{};
+    //! The elements of an uncompressed, contiguous layer of a read only BAG,
+    //! mapped into memory; null if the layer is read through HDF5.
+    mutable std::unique_ptr<MappedRegion, DeleteMappedRegion> m_pMappedData;
+    //! The number of bytes in a row of m_pMappedData.
+    mutable size_t m_mappedRowBytes = 0;
+    //! Has mapping the layer into memory been tried?
+    mutable bool m_mappingTried = false;
+    //! The id of the layer in the TileCache; 0 if its tiles are not cached.
+    mutable uint64_t m_tileCacheLayerId = 0;
+    //! Has m_tileCacheLayerId been found?
+    mutable bool m_tileCacheLayerIdFound = false;
+    //! The overviews, coarsest last; overview i halves the resolution i + 1
+    //! times.
+    mutable std::vector<std::unique_ptr<::H5::DataSet, DeleteH5dataSet>>
+        m_overviews;
+    //! Have the overviews in the file been opened?
+    mutable bool m_overviewsOpened = false;
+    //! The coverage bitmap DataSet; null if the layer has none.
+    mutable std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pCoverage;
+    //! Has the coverage bitmap in the file been opened?
+    mutable bool m_coverageOpened = false;
+    //! The summary of each tile of the layer, row by row; empty until
+    //! updateMinMax() or buildZoneMap() is first called, or a zone map is
+    //! read.
+    std::vector<TileSummary> m_tileSummaries;
+    //! The rows and columns of a tile; those of LayerTiles.
+    std::array<uint32_t, 2> m_tileDims{};
+    //! The number of tiles across the layer.
+    uint32_t m_numTileColumns = 0;
+    //! The zone map DataSet; null if the layer has none.
+    std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pZoneMap;
+    //! The first and last rows of tiles changed since the zone map was last
+    //! written; none if the first is after the last.
+    mutable std::array<uint32_t, 2> m_changedTileRows{
+        std::numeric_limits<uint32_t>::max(), 0};
 
     friend Dataset;
+    friend LayerDiffer;
 };
 
 #ifdef _MSC_VER
@@ -1,7 +1,10 @@
 
 #include "bag_dataset.h"
+#include "bag_private.h"
 #include "bag_simplelayerdescriptor.h"
 
+#include <H5Cpp.h>
+
 
 namespace BAG {
 
@@ -40,6 +43,11 @@ SimpleLayerDescriptor::SimpleLayerDescriptor(
     : LayerDescriptor(dataset, type)
     , m_elementSize(Layer::getElementSize(Layer::getDataType(type)))
 {
+    const auto h5dataSet = dataset.getH5file().openDataSet(
+        this->getInternalPath());
+    if (h5dataSet.attrExists(QUANTIZATION_ERROR_BOUND))
+        h5dataSet.openAttribute(QUANTIZATION_ERROR_BOUND).read(
+            ::H5::PredType::NATIVE_DOUBLE, &m_quantization.absErrorBound);
 }
 
 //! Create a new simple layer descriptor.
@@ -85,6 +93,32 @@ std::shared_ptr<SimpleLayerDescriptor> SimpleLayerDescriptor::open(
         new SimpleLayerDescriptor{dataset, type});
 }
 
+//! Retrieve how the values are quantized before they are stored.
+/*!
+\return
+    The quantization; not quantized unless the layer was created quantized.
+*/
+const Quantization& SimpleLayerDescriptor::getQuantization() const & noexcept
+{
+    return m_quantization;
+}
+
+//! Set how the values are quantized before they are stored.
+/*!
+    Only used when the HDF5 DataSet of the layer is created.
+
+\param quantization
+    The quantization.
+
+\return
+    The descriptor.  Useful for chaining set calls.
+*/
+SimpleLayerDescriptor& SimpleLayerDescriptor::setQuantization(
+    const Quantization& quantization) & noexcept
+{
+    m_quantization = quantization;
+    return *this;
+}
 
 //! \copydoc LayerDescriptor::getDataType
 DataType SimpleLayerDescriptor::getDataTypeProxy() const noexcept
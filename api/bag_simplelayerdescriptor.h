@@ -35,6 +35,9 @@ public:
         return !(rhs == *this);
     }
 
+    const Quantization& getQuantization() const & noexcept;
+    SimpleLayerDescriptor& setQuantization(const Quantization& quantization) & noexcept;
+
 protected:
     SimpleLayerDescriptor(uint32_t id, LayerType type, uint64_t chunkSize,
         int compressionLevel);
@@ -46,6 +49,8 @@ private:
 
     //! The size of a single node in the HDF5 file.
     uint8_t m_elementSize = 0;
+    //! How the values are quantized before they are stored.
+    Quantization m_quantization;
 };
 
 }  // namespace BAG
@@ -0,0 +1,288 @@
+
+#include "bag_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+
+namespace BAG {
+
+namespace {
+
+//! How many values, per unit of compression, a TDigest gathers before
+//! merging them into its centroids.
+constexpr size_t kPendingPerCompression = 5;
+
+}  // namespace
+
+//! Add a value.
+/*!
+\param value
+    The value to add.
+*/
+void Moments::add(
+    double value) noexcept
+{
+    ++count;
+
+    const auto delta = value - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+}
+
+//! Add the values of another set.
+/*!
+\param other
+    The other set.
+*/
+void Moments::merge(
+    const Moments& other) noexcept
+{
+    if (other.count == 0)
+        return;
+
+    if (count == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    const auto total = static_cast<double>(count + other.count);
+    const auto delta = other.mean - mean;
+
+    mean += delta * static_cast<double>(other.count) / total;
+    m2 += other.m2 + delta * delta *
+        (static_cast<double>(count) * static_cast<double>(other.count) / total);
+    count += other.count;
+}
+
+//! Retrieve the (population) variance of the values.
+/*!
+\return
+    The variance; 0 if there are no values.
+*/
+double Moments::getVariance() const noexcept
+{
+    return count > 0 ? m2 / static_cast<double>(count) : 0.;
+}
+
+//! Constructor.
+/*!
+\param min
+    The lower edge of the first bin.
+\param max
+    The upper edge of the last bin.
+\param numBins
+    The number of bins.
+*/
+Histogram::Histogram(
+    double min,
+    double max,
+    uint32_t numBins)
+    : min(min)
+    , max(max)
+    , counts(numBins)
+{
+}
+
+//! Count a value.
+/*!
+    A value equal to max is counted in the last bin.
+
+\param value
+    The value to count.
+*/
+void Histogram::add(
+    double value) noexcept
+{
+    if (counts.empty() || !(value >= min && value <= max))
+        return;
+
+    const auto numBins = counts.size();
+    const auto width = max - min;
+    const auto bin = width > 0. ?
+        static_cast<size_t>((value - min) / width * static_cast<double>(numBins)) :
+        size_t{0};
+
+    ++counts[std::min(bin, numBins - 1)];
+}
+
+//! Add the counts of another histogram with the same bins.
+/*!
+\param other
+    The other histogram.
+*/
+void Histogram::merge(
+    const Histogram& other) noexcept
+{
+    const auto numBins = std::min(counts.size(), other.counts.size());
+    for (size_t bin=0; bin<numBins; ++bin)
+        counts[bin] += other.counts[bin];
+}
+
+//! Constructor.
+/*!
+\param compression
+    The larger, the more centroids are kept, and the more accurate the
+    quantiles; about compression / 2 to compression centroids are kept.
+*/
+TDigest::TDigest(
+    double compression)
+    : m_compression(std::max(compression, 10.))
+{
+}
+
+//! Add a value.
+/*!
+\param value
+    The value to add.
+*/
+void TDigest::add(
+    double value)
+{
+    m_pending.push_back({value, 1.});
+
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+
+    if (m_pending.size() >= kPendingPerCompression *
+        static_cast<size_t>(m_compression))
+        this->compress();
+}
+
+//! Add the values summarized by another digest.
+/*!
+\param other
+    The other digest.
+*/
+void TDigest::merge(
+    const TDigest& other)
+{
+    m_pending.insert(m_pending.end(), other.m_centroids.begin(),
+        other.m_centroids.end());
+    m_pending.insert(m_pending.end(), other.m_pending.begin(),
+        other.m_pending.end());
+
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+
+    if (m_pending.size() >= kPendingPerCompression *
+        static_cast<size_t>(m_compression))
+        this->compress();
+}
+
+//! Merge the pending values into the centroids.
+/*!
+    Neighbouring centroids are merged while the merged centroid holds no
+    more than 4 * n * q * (1 - q) / compression of the n values, q being
+    the quantile of its centre.
+*/
+void TDigest::compress()
+{
+    if (m_pending.empty())
+        return;
+
+    const auto byMean = [](const Centroid& lhs, const Centroid& rhs) {
+        return lhs.mean < rhs.mean;
+    };
+
+    std::sort(m_pending.begin(), m_pending.end(), byMean);
+
+    std::vector<Centroid> sorted;
+    sorted.reserve(m_centroids.size() + m_pending.size());
+    std::merge(m_centroids.begin(), m_centroids.end(), m_pending.begin(),
+        m_pending.end(), std::back_inserter(sorted), byMean);
+    m_pending.clear();
+
+    double totalWeight = 0.;
+    for (const auto& centroid : sorted)
+        totalWeight += centroid.weight;
+
+    m_centroids.clear();
+
+    auto current = sorted.front();
+    double weightSoFar = 0.;
+
+    for (size_t i=1; i<sorted.size(); ++i)
+    {
+        const auto& next = sorted[i];
+        const auto proposed = current.weight + next.weight;
+        const auto q = (weightSoFar + proposed / 2.) / totalWeight;
+        const auto limit = 4. * totalWeight * q * (1. - q) / m_compression;
+
+        if (proposed <= limit)
+        {
+            current.mean += (next.mean - current.mean) * next.weight / proposed;
+            current.weight = proposed;
+        }
+        else
+        {
+            weightSoFar += current.weight;
+            m_centroids.push_back(current);
+            current = next;
+        }
+    }
+
+    m_centroids.push_back(current);
+}
+
+//! Estimate a quantile of the values.
+/*!
+    The estimate interpolates between the centres of the centroids, and
+    between the smallest and largest values and the outermost centroids.
+
+\param quantile
+    The quantile, from 0 to 1.
+
+\return
+    The estimated value; NaN if no values were added.
+*/
+double TDigest::getQuantile(
+    double quantile)
+{
+    this->compress();
+
+    if (m_centroids.empty())
+        return std::nan("");
+
+    if (m_centroids.size() == 1)
+        return m_centroids.front().mean;
+
+    double totalWeight = 0.;
+    for (const auto& centroid : m_centroids)
+        totalWeight += centroid.weight;
+
+    const auto target = std::min(std::max(quantile, 0.), 1.) * totalWeight;
+
+    // Below the centre of the first centroid.
+    const auto& first = m_centroids.front();
+    if (target < first.weight / 2.)
+        return m_min + (first.mean - m_min) * target / (first.weight / 2.);
+
+    // Above the centre of the last centroid.
+    const auto& last = m_centroids.back();
+    if (target > totalWeight - last.weight / 2.)
+        return m_max - (m_max - last.mean) *
+            (totalWeight - target) / (last.weight / 2.);
+
+    double centre = first.weight / 2.;
+
+    for (size_t i=1; i<m_centroids.size(); ++i)
+    {
+        const auto& previous = m_centroids[i - 1];
+        const auto& next = m_centroids[i];
+        const auto nextCentre = centre + (previous.weight + next.weight) / 2.;
+
+        if (target <= nextCentre)
+            return previous.mean + (next.mean - previous.mean) *
+                (target - centre) / (nextCentre - centre);
+
+        centre = nextCentre;
+    }
+
+    return last.mean;
+}
+
+}  // namespace BAG
+
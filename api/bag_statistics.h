@@ -0,0 +1,96 @@
+#ifndef BAG_STATISTICS_H
+#define BAG_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace BAG {
+
+//! The count, mean and variance of a set of values.
+/*!
+    Values are added with Welford's method, and two sets are merged with the
+    pairwise update of Chan et al., so neither loses precision to a large
+    running sum of squares.
+*/
+struct Moments final
+{
+    //! The number of values.
+    uint64_t count = 0;
+    //! The mean of the values.
+    double mean = 0.;
+    //! The sum of the squared differences of the values from the mean.
+    double m2 = 0.;
+
+    void add(double value) noexcept;
+    void merge(const Moments& other) noexcept;
+
+    double getVariance() const noexcept;
+};
+
+//! A histogram of bins of equal width.
+struct Histogram final
+{
+    Histogram() = default;
+    Histogram(double min, double max, uint32_t numBins);
+
+    void add(double value) noexcept;
+    void merge(const Histogram& other) noexcept;
+
+    //! The lower edge of the first bin.
+    double min = 0.;
+    //! The upper edge of the last bin.
+    double max = 0.;
+    //! The number of values in each bin; values outside [min, max] are not
+    //! counted.
+    std::vector<uint64_t> counts;
+};
+
+//! A t-digest; a summary of a set of values that quantiles are estimated
+//! from.
+/*!
+    The values are clustered into centroids that are small near the tails of
+    the distribution and larger towards the middle, so extreme quantiles are
+    estimated more accurately than central ones.  Digests merge, so a set of
+    values can be summarized in parts.  See Dunning and Ertl, "Computing
+    extremely accurate quantiles using t-digests".
+*/
+class TDigest final
+{
+public:
+    TDigest() = default;
+    explicit TDigest(double compression);
+
+    void add(double value);
+    void merge(const TDigest& other);
+
+    double getQuantile(double quantile);
+
+private:
+    //! The mean of a cluster of values, and how many there are.
+    struct Centroid final
+    {
+        double mean = 0.;
+        double weight = 0.;
+    };
+
+    void compress();
+
+    //! The larger, the more centroids are kept.
+    double m_compression = 100.;
+    //! The merged centroids, in order of mean.
+    std::vector<Centroid> m_centroids;
+    //! The values and centroids added since the last compress().
+    std::vector<Centroid> m_pending;
+    //! The smallest value added.
+    double m_min = std::numeric_limits<double>::max();
+    //! The largest value added.
+    double m_max = std::numeric_limits<double>::lowest();
+};
+
+}  // namespace BAG
+
+#endif  // BAG_STATISTICS_H
+
@@ -1,14 +1,24 @@
 
+#include "bag_correctionplan.h"
+#include "bag_correctorindex.h"
 #include "bag_dataset.h"
+#include "bag_directchunk.h"
+#include "bag_exceptions.h"
+#include "bag_hdfhelper.h"
+#include "bag_parallel.h"
 #include "bag_private.h"
+#include "bag_progressscope.h"
 #include "bag_simplelayer.h"
 #include "bag_surfacecorrections.h"
 #include "bag_surfacecorrectionsdescriptor.h"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstring>  // memset
+#include <limits>
 #include <memory>
+#include <vector>
 #include <H5Cpp.h>
 
 
@@ -16,8 +26,8 @@ namespace BAG {
 
 //! The maximum length of the list of datums.
 constexpr uint16_t kMaxDatumsLength = 256;
-//! The radius to use while searching for nearest neighbours.
-constexpr int32_t kSearchRadius = 3;
+//! The number of irregularly spaced correctors used to correct a node.
+constexpr uint32_t kNumIrregularNeighbours = 4;
 
 namespace {
 
@@ -54,6 +64,33 @@ namespace {
     return h5memDataType;
 }
 
+//! Compute the size of a buffer holding an area of floats.
+/*!
+\param rowStart
+    The first row of the area.
+\param columnStart
+    The first column of the area.
+\param rowEnd
+    The last row of the area (inclusive).
+\param columnEnd
+    The last column of the area (inclusive).
+\param rowStride
+    The distance, in values, between the start of two rows.
+
+\return
+    The size of the buffer, in bytes.
+*/
+size_t getBufferSize(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    size_t rowStride) noexcept
+{
+    return ((rowEnd - rowStart) * rowStride + (columnEnd - columnStart + 1)) *
+        sizeof(float);
+}
+
 }  // namespace
 
 //! Constructor.
@@ -70,6 +107,7 @@ SurfaceCorrections::SurfaceCorrections(
     SurfaceCorrectionsDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(pH5dataSet))
 {
 }
@@ -83,10 +121,10 @@ SurfaceCorrections::SurfaceCorrections(
 \param numCorrectors
     The number of correctors provided.
     Valid range is 1-10.
-\param chunkSize
-    The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param chunkShape
+    The shape of the chunks the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
 
 \return
     The new surface corrections layer.
@@ -95,11 +133,16 @@ std::shared_ptr<SurfaceCorrections> SurfaceCorrections::create(
     Dataset& dataset,
     BAG_SURFACE_CORRECTION_TOPOGRAPHY type,
     uint8_t numCorrectors,
-    uint64_t chunkSize,
-    int compressionLevel)
+    const ChunkShape& chunkShape,
+    const CompressionSpec& compression)
 {
     auto descriptor = SurfaceCorrectionsDescriptor::create(dataset, type,
-        numCorrectors, chunkSize, compressionLevel);
+        numCorrectors, chunkShape.rows, compression.level);
+    descriptor->setCompressionSpec(compression);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = dataset.getDescriptor().getDims();
+    descriptor->setChunkShape(chunkShape, numRows, numColumns);
 
     auto h5dataSet = SurfaceCorrections::createH5dataSet(dataset, *descriptor);
 
@@ -123,7 +166,8 @@ std::shared_ptr<SurfaceCorrections> SurfaceCorrections::open(
 {
     const auto& h5file = dataset.getH5file();
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(descriptor.getInternalPath())},
+        new ::H5::DataSet{h5file.openDataSet(descriptor.getInternalPath(),
+            dataset.getH5dataSetAccessPropList(Surface_Correction))},
         DeleteH5dataSet{});
 
     return std::make_shared<SurfaceCorrections>(dataset,
@@ -151,21 +195,21 @@ SurfaceCorrections::createH5dataSet(
     const ::H5::DataSpace h5fileDataSpace{kRank, fileDims.data(), kMaxFileDims.data()};
 
     // Use chunk size and compression level from the descriptor.
-    const auto compressionLevel = descriptor.getCompressionLevel();
+    const auto& compression = descriptor.getCompressionSpec();
 
     // Create the creation property list.
     const ::H5::DSetCreatPropList h5createPropList{};
 
-    const auto chunkSize = descriptor.getChunkSize();
-    if (chunkSize > 0)
+    uint64_t chunkRows = 0, chunkColumns = 0;
+    std::tie(chunkRows, chunkColumns) = descriptor.getChunkDims();
+    if (chunkRows > 0 && chunkColumns > 0)
     {
-    	const std::array<hsize_t, kRank> chunkDims{chunkSize, chunkSize};
+        const std::array<hsize_t, kRank> chunkDims{chunkRows, chunkColumns};
         h5createPropList.setChunk(kRank, chunkDims.data());
 
-        if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-            h5createPropList.setDeflate(compressionLevel);
+        setCompression(h5createPropList, compression);
     }
-    else if (compressionLevel > 0)
+    else if (compression.isCompressed())
         throw CompressionNeedsChunkingSet{};
     else
         throw LayerRequiresChunkingSet{};
@@ -228,6 +272,104 @@ const ::H5::DataSet& SurfaceCorrections::getH5dataSet() const & noexcept
     return *m_pH5dataSet;
 }
 
+//! Retrieve all the correctors, reading them the first time.
+/*!
+    The correctors are small compared to the layers they correct, so they are
+    read once in full rather than a few nodes at a time per corrected cell.
+    Writing to the layer, or releasing the caches of the dataset, discards
+    the copy; the copy handed out stays valid.
+
+\return
+    The correctors, row major, as read by readProxy().
+*/
+std::shared_ptr<const UInt8Array> SurfaceCorrections::getCorrectors() const
+{
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+    pDataset->releaseRequestedCaches();
+
+    if (!m_pCorrectors)
+    {
+        uint32_t numRows = 0, numColumns = 0;
+        std::tie(numRows, numColumns) = m_descriptor.getDims();
+
+        if (numRows == 0 || numColumns == 0)
+            throw InvalidReadSize{};
+
+        m_pCorrectors = std::make_shared<const UInt8Array>(
+            this->readProxy(0, 0, numRows - 1, numColumns - 1));
+        pDataset->reportCacheUsage();
+    }
+
+    return m_pCorrectors;
+}
+
+//! Retrieve the index over the irregularly spaced correctors.
+/*!
+    The index is built the first time it is needed, and again after the
+    layer is written to.  It keeps the correctors it indexes alive.
+
+\return
+    The index.
+*/
+std::shared_ptr<const CorrectorIndex> SurfaceCorrections::getCorrectorIndex() const
+{
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto lock = pDataset->lockReads();
+    pDataset->releaseRequestedCaches();
+
+    if (!m_pCorrectorIndex)
+    {
+        auto pCorrectors = this->getCorrectors();
+        const auto* nodes = reinterpret_cast<const VerticalDatumCorrections*>(
+            pCorrectors->data());
+        const auto numNodes = pCorrectors->size() /
+            sizeof(VerticalDatumCorrections);
+
+        m_pCorrectorIndex = std::shared_ptr<const CorrectorIndex>(
+            new CorrectorIndex{nodes, numNodes},
+            [pCorrectors](const CorrectorIndex* pIndex) { delete pIndex; });
+        pDataset->reportCacheUsage();
+    }
+
+    return m_pCorrectorIndex;
+}
+
+//! Retrieve the memory held by the correctors read, and the index over them.
+/*!
+\return
+    The memory held, in bytes.
+*/
+uint64_t SurfaceCorrections::getCacheBytes() const noexcept
+{
+    uint64_t bytes = 0;
+
+    if (m_pCorrectors)
+        bytes += m_pCorrectors->size();
+
+    if (m_pCorrectorIndex)
+        bytes += m_pCorrectorIndex->getMemoryUsage();
+
+    return bytes;
+}
+
+//! Discard the correctors read, and the index over them.
+/*!
+    They are read and built again when next needed.  Copies handed out stay
+    valid.
+*/
+void SurfaceCorrections::releaseCaches() const noexcept
+{
+    m_pCorrectors.reset();
+    m_pCorrectorIndex.reset();
+}
+
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
 /*!
 \return
@@ -236,7 +378,7 @@ const ::H5::DataSet& SurfaceCorrections::getH5dataSet() const & noexcept
 */
 std::shared_ptr<SurfaceCorrectionsDescriptor> SurfaceCorrections::getDescriptor() & noexcept
 {
-    return std::dynamic_pointer_cast<SurfaceCorrectionsDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<SurfaceCorrectionsDescriptor>(Layer::getDescriptor());
 }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -246,11 +388,224 @@ std::shared_ptr<SurfaceCorrectionsDescriptor> SurfaceCorrections::getDescriptor(
     Will never be nullptr.
 */
 std::shared_ptr<const SurfaceCorrectionsDescriptor> SurfaceCorrections::getDescriptor() const & noexcept {
-    return std::dynamic_pointer_cast<const SurfaceCorrectionsDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<const SurfaceCorrectionsDescriptor>(Layer::getDescriptor());
+}
+
+//! Replace the gridded correctors of the layer.
+/*!
+    The grid is written in one pass, its chunks compressed on several
+    threads, and kept in memory so correcting with it does not read it back.
+    Set the origin and spacing of the correctors in the descriptor first.
+
+    An UnsupportedSurfaceType exception is thrown if the layer is not of
+    BAG_SURFACE_GRID_EXTENTS.
+
+\param correctors
+    The correctors, row by row.
+\param rows
+    The number of rows of correctors.
+\param columns
+    The number of columns of correctors.
+
+\return
+    A plan for correcting the whole BAG with the correctors; see
+    createCorrectionPlan().
+*/
+CorrectionPlan SurfaceCorrections::load(
+    const VerticalDatumCorrectionsGridded* correctors,
+    uint32_t rows,
+    uint32_t columns)
+{
+    this->loadCorrectors(BAG_SURFACE_GRID_EXTENTS,
+        reinterpret_cast<const uint8_t*>(correctors), rows, columns);
+
+    return this->createCorrectionPlan();
+}
+
+//! Replace the irregularly spaced correctors of the layer.
+/*!
+    The correctors are written in one pass, as a single row, their chunks
+    compressed on several threads.  They are kept in memory, and indexed, so
+    correcting with them does not read them back.
+
+    An UnsupportedSurfaceType exception is thrown if the layer is not of
+    BAG_SURFACE_IRREGULARLY_SPACED.
+
+\param correctors
+    The correctors.
+\param numNodes
+    The number of correctors.
+*/
+void SurfaceCorrections::load(
+    const VerticalDatumCorrections* correctors,
+    uint32_t numNodes)
+{
+    this->loadCorrectors(BAG_SURFACE_IRREGULARLY_SPACED,
+        reinterpret_cast<const uint8_t*>(correctors), 1, numNodes);
+
+    // Build the index now, rather than on the first correction.
+    this->getCorrectorIndex();
+}
+
+//! Replace the correctors of the layer, and keep them in memory.
+/*!
+\param surfaceType
+    The type of surface the correctors are for.
+\param buffer
+    The correctors, row by row.
+\param rows
+    The number of rows of correctors.
+\param columns
+    The number of columns of correctors.
+*/
+void SurfaceCorrections::loadCorrectors(
+    BAG_SURFACE_CORRECTION_TOPOGRAPHY surfaceType,
+    const uint8_t* buffer,
+    uint32_t rows,
+    uint32_t columns)
+{
+    if (m_descriptor.getSurfaceType() != surfaceType)
+        throw UnsupportedSurfaceType{};
+
+    if (!buffer)
+        throw InvalidBuffer{};
+
+    if (rows == 0 || columns == 0)
+        throw InvalidWriteSize{};
+
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Drop any correctors past the new ones, so the write covers the layer;
+    // writing grows it as usual.
+    std::array<hsize_t, kRank> dims{};
+    m_pH5dataSet->getSpace().getSimpleExtentDims(dims.data());
+
+    if (dims[0] > rows || dims[1] > columns)
+    {
+        dims[0] = std::min<hsize_t>(dims[0], rows);
+        dims[1] = std::min<hsize_t>(dims[1], columns);
+        m_pH5dataSet->extend(dims.data());
+    }
+
+    this->write(0, 0, rows - 1, columns - 1, buffer);
+
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
+    auto correctors = UInt8Array::uninitialized(bufferSize);
+    std::memcpy(correctors.data(), buffer, bufferSize);
+
+    const auto lock = pDataset->lockReads();
+
+    m_pCorrectors = std::make_shared<const UInt8Array>(std::move(correctors));
+    pDataset->reportCacheUsage();
+}
+
+//! Create a plan for correcting the whole BAG.
+/*!
+\return
+    The plan, covering every node of the BAG.
+*/
+CorrectionPlan SurfaceCorrections::createCorrectionPlan() const
+{
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    if (numRows == 0 || numColumns == 0)
+        throw InvalidReadSize{};
+
+    return this->createCorrectionPlan(0, 0, numRows - 1, numColumns - 1);
+}
+
+//! Create a plan for correcting an area of the BAG.
+/*!
+    The plan can be used to apply any of the correctors to the area, or to
+    any part of it, without recomputing which corrector nodes are involved.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+
+\return
+    The plan.
+*/
+CorrectionPlan SurfaceCorrections::createCorrectionPlan(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd) const
+{
+    if (m_descriptor.getSurfaceType() != BAG_SURFACE_GRID_EXTENTS)
+        throw UnsupportedSurfaceType{};
+
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    if (columnEnd >= numColumns || rowEnd >= numRows || rowStart > rowEnd
+        || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    uint32_t correctorRows = 0, correctorColumns = 0;
+    std::tie(correctorRows, correctorColumns) = m_descriptor.getDims();
+
+    if (correctorRows == 0 || correctorColumns == 0)
+        throw InvalidReadSize{};
+
+    // Obtain cell resolution and SW origin (0,1,1,0).
+    double swCornerX = 0., swCornerY = 0.;
+    std::tie(swCornerX, swCornerY) = m_descriptor.getOrigin();
+
+    double nodeSpacingX = 0., nodeSpacingY = 0.;
+    std::tie(nodeSpacingX, nodeSpacingY) = m_descriptor.getSpacing();
+
+    const auto resratio = nodeSpacingX / nodeSpacingY;
+
+    double swCornerXsimple = 0., swCornerYsimple = 0.;
+    std::tie(swCornerXsimple, swCornerYsimple) =
+        pDataset->getDescriptor().getOrigin();
+
+    double nodeSpacingXsimple = 0., nodeSpacingYsimple = 0.;
+    std::tie(nodeSpacingXsimple, nodeSpacingYsimple) =
+        pDataset->getDescriptor().getGridSpacing();
+
+    CorrectionPlan plan;
+    plan.m_rowStart = rowStart;
+    plan.m_columnStart = columnStart;
+
+    plan.m_rows.reserve(rowEnd - rowStart + 1);
+    for (auto row=rowStart; row<=rowEnd; ++row)
+        plan.m_rows.push_back(CorrectionPlan::findNeighbours(
+            swCornerYsimple + row * nodeSpacingYsimple, swCornerY,
+            nodeSpacingY, correctorRows, resratio));
+
+    plan.m_columns.reserve(columnEnd - columnStart + 1);
+    for (auto column=columnStart; column<=columnEnd; ++column)
+        plan.m_columns.push_back(CorrectionPlan::findNeighbours(
+            swCornerXsimple + column * nodeSpacingXsimple, swCornerX,
+            nodeSpacingX, correctorColumns, 1.0));
+
+    return plan;
 }
 
 //! Read a corrected region from a simple layer using the specified corrector.
 /*!
+    Gridded correctors are interpolated from the surrounding corrector nodes.
+    Irregularly spaced correctors are interpolated from the nearest few
+    correctors, found with a spatial index built on first use.
+
 \param rowStart
     The starting row.
 \param columnStart
@@ -276,45 +631,218 @@ UInt8Array SurfaceCorrections::readCorrected(
     uint8_t corrector,
     const SimpleLayer& layer) const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const SurfaceCorrectionsDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
-
-    auto weakDataset = this->getDataset();
-    if (weakDataset.expired())
-        throw DatasetNotFound{};
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
 
-    auto dataset = weakDataset.lock();
+    const TraceScope trace{"SurfaceCorrections::readCorrected",
+        layer.getDescriptor()->getName().c_str(), rowEnd - rowStart + 1,
+        columnEnd - columnStart + 1};
 
-    uint32_t ncols = 0, nrows = 0;
-    std::tie(ncols, nrows) = dataset->getDescriptor().getDims();
+    UInt8Array data{static_cast<size_t>(rowEnd - rowStart + 1) *
+        (columnEnd - columnStart + 1) * sizeof(float)};
 
-    if (columnEnd >= ncols || rowEnd >= nrows || rowStart > rowEnd
-        || columnStart > columnEnd)
+    this->readCorrectedInto(rowStart, columnStart, rowEnd, columnEnd,
+        corrector, layer, reinterpret_cast<float*>(data.data()));
+
+    return data;
+}
+
+//! Read a corrected region from a simple layer using a plan.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param layer
+    The simple layer to correct.
+\param plan
+    A plan covering the region, from createCorrectionPlan().
+
+\return
+    The corrected date from the simple layer using the specified corrector.
+*/
+UInt8Array SurfaceCorrections::readCorrected(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const SimpleLayer& layer,
+    const CorrectionPlan& plan) const
+{
+    if (!plan.contains(rowStart, columnStart, rowEnd, columnEnd))
         throw InvalidReadSize{};
 
-    UInt8Array data{(columnEnd - columnStart + 1) * (rowEnd - rowStart + 1)
-        * sizeof(float)};
+    const TraceScope trace{"SurfaceCorrections::readCorrected",
+        layer.getDescriptor()->getName().c_str(), rowEnd - rowStart + 1,
+        columnEnd - columnStart + 1};
 
-    for (uint32_t f=0, i=0; i<nrows; ++i)
-    {
-        if (i >= rowStart && i <= rowEnd)
-        {
-            //! By row at a time, fill the whole buffer
-            auto sepData = this->readCorrectedRow(i, columnStart, columnEnd,
-                corrector, layer);
+    UInt8Array data{static_cast<size_t>(rowEnd - rowStart + 1) *
+        (columnEnd - columnStart + 1) * sizeof(float)};
 
-            //! For each column in the transfer set
-            for (uint32_t j=0; j<columnEnd-columnStart + 1; ++j)
-                data[(columnEnd - columnStart + 1) * f + j] = sepData[j];
+    this->readCorrectedInto(rowStart, columnStart, rowEnd, columnEnd,
+        corrector, layer, plan, reinterpret_cast<float*>(data.data()));
 
-            f++;
-        }
+    return data;
+}
+
+//! Read a corrected region from a simple layer on an executor.
+/*!
+    The read runs after the asynchronous operations on the Dataset submitted
+    before it.  The Dataset is kept open until the read is done; the layer
+    must be one of its layers.
+
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param layer
+    The simple layer to correct.
+\param executor
+    The executor to read on.
+
+\return
+    The corrected data, or the exception readCorrected() threw.
+*/
+std::future<UInt8Array> SurfaceCorrections::readCorrectedAsync(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const SimpleLayer& layer,
+    Executor& executor) const
+{
+    const auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Holding the Dataset, which owns the layers, keeps them alive.
+    return executor.submit(pDataset.get(),
+        [this, pDataset, rowStart, columnStart, rowEnd, columnEnd, corrector,
+            &layer]() {
+            return this->readCorrected(rowStart, columnStart, rowEnd,
+                columnEnd, corrector, layer);
+        });
+}
+
+//! Read a corrected region from a simple layer into a caller owned buffer.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param layer
+    The simple layer to correct.
+\param data
+    The buffer to read into.  Must hold every row of the region, rowStride
+    values apart.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+    Zero means the rows are tightly packed.
+*/
+void SurfaceCorrections::readCorrectedInto(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const SimpleLayer& layer,
+    float* data,
+    size_t rowStride) const
+{
+    if (m_descriptor.getSurfaceType() == BAG_SURFACE_GRID_EXTENTS)
+    {
+        this->readCorrectedInto(rowStart, columnStart, rowEnd, columnEnd,
+            corrector, layer, this->createCorrectionPlan(rowStart, columnStart,
+                rowEnd, columnEnd), data, rowStride);
+        return;
     }
 
-    return data;
+    if (rowStart > rowEnd || columnStart > columnEnd)
+        throw InvalidReadSize{};
+
+    if (rowStride == 0)
+        rowStride = columnEnd - columnStart + 1;
+
+    layer.readInto(rowStart, columnStart, rowEnd, columnEnd,
+        reinterpret_cast<uint8_t*>(data),
+        getBufferSize(rowStart, columnStart, rowEnd, columnEnd, rowStride),
+        rowStride * sizeof(float));
+
+    this->applyIrregularCorrection(rowStart, columnStart, rowEnd, columnEnd,
+        corrector, data, rowStride);
+}
+
+//! Read a corrected region from a simple layer into a caller owned buffer.
+/*!
+\param rowStart
+    The starting row.
+\param columnStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param columnEnd
+    The ending column (inclusive).
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param layer
+    The simple layer to correct.
+\param plan
+    A plan covering the region, from createCorrectionPlan().
+\param data
+    The buffer to read into.  Must hold every row of the region, rowStride
+    values apart.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+    Zero means the rows are tightly packed.
+*/
+void SurfaceCorrections::readCorrectedInto(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const SimpleLayer& layer,
+    const CorrectionPlan& plan,
+    float* data,
+    size_t rowStride) const
+{
+    if (!plan.contains(rowStart, columnStart, rowEnd, columnEnd))
+        throw InvalidReadSize{};
+
+    if (rowStride == 0)
+        rowStride = columnEnd - columnStart + 1;
+
+    layer.readInto(rowStart, columnStart, rowEnd, columnEnd,
+        reinterpret_cast<uint8_t*>(data),
+        getBufferSize(rowStart, columnStart, rowEnd, columnEnd, rowStride),
+        rowStride * sizeof(float));
+
+    this->applyCorrection(plan, rowStart, columnStart, rowEnd, columnEnd,
+        corrector, data, rowStride);
 }
 
 //! Read a corrected row from a simple layer using the specified corrector.
@@ -341,203 +869,399 @@ UInt8Array SurfaceCorrections::readCorrectedRow(
     uint8_t corrector,
     const SimpleLayer& layer) const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const SurfaceCorrectionsDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
-
-    const auto surfaceType = pDescriptor->getSurfaceType();  // aka topography
+    return this->readCorrected(row, columnStart, row, columnEnd, corrector,
+        layer);
+}
 
-    if (surfaceType != BAG_SURFACE_GRID_EXTENTS)
-        throw UnsupportedSurfaceType{};
+//! Read a corrected row from a simple layer using a plan.
+/*!
+\param row
+    The row.
+\param columnStart
+    The starting column.
+\param columnEnd
+    The ending column (inclusive).
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param layer
+    The simple layer to correct.
+\param plan
+    A plan covering the row, from createCorrectionPlan().
 
-    if (corrector < 1 || corrector > pDescriptor->getNumCorrectors())
-        throw InvalidCorrector{};
+\return
+    The corrected date from the simple layer using the specified corrector.
+*/
+UInt8Array SurfaceCorrections::readCorrectedRow(
+    uint32_t row,
+    uint32_t columnStart,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const SimpleLayer& layer,
+    const CorrectionPlan& plan) const
+{
+    return this->readCorrected(row, columnStart, row, columnEnd, corrector,
+        layer, plan);
+}
 
-    --corrector;  // This is 0 based when used.
+//! Write a corrected copy of a simple layer into another layer.
+/*!
+    The source is corrected in bands of whole rows, one chunk of the source
+    high, so only one band is held in memory at a time.  The destination
+    layer is created, using the chunk size and compression level of the
+    source, if the destination does not have it.  The min/max attributes of
+    the destination are written once every band has been written.
 
-    auto originalRow = layer.read(row, row, columnStart, columnEnd);
-    auto* data = reinterpret_cast<float*>(originalRow.data());
+    The destination may be the BAG the source is from, including the source
+    layer itself.
 
-    // Obtain cell resolution and SW origin (0,1,1,0).
-    double swCornerX = 0., swCornerY = 0.;
-    std::tie(swCornerX, swCornerY) = pDescriptor->getOrigin();
+    If cancelled, the bands written so far are kept, with the min/max
+    attributes of their nodes.
 
-    double nodeSpacingX = 0., nodeSpacingY = 0.;
-    std::tie(nodeSpacingX, nodeSpacingY) = pDescriptor->getSpacing();
+\param source
+    The simple layer to correct.
+\param corrector
+    The corrector to use when applying a correction.
+    Valid values are 1-10.
+\param destination
+    The BAG to write the corrected layer into.
+    Must have the same dimensions as the BAG of the source.
+\param destinationType
+    The type of simple layer to write.
+    Must store floats.
+\param progress
+    Follows the progress of the write, and cancels it; may be null.
 
-    const auto resratio = nodeSpacingX / nodeSpacingY;
+\return
+    The destination layer.
+*/
+SimpleLayer& SurfaceCorrections::writeCorrectedLayer(
+    const SimpleLayer& source,
+    uint8_t corrector,
+    Dataset& destination,
+    LayerType destinationType,
+    ProgressToken* progress) const
+{
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
 
-    uint32_t ncols = 0, nrows = 0;
-    std::tie(nrows, ncols) = pDescriptor->getDims();
+    if (Layer::getDataType(destinationType) != DT_FLOAT32)
+        throw UnsupportedDataType{};
 
-    std::array<int32_t, 2> lastP{-1, -1};
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
 
-    auto weakDataset = this->getDataset();
-    if (weakDataset.expired())
-        throw DatasetNotFound{};
+    if (destination.getDescriptor().getDims() !=
+        std::make_tuple(numRows, numColumns))
+        throw InvalidWriteSize{};
 
-    auto dataset = weakDataset.lock();
+    const auto pSourceDescriptor = source.getDescriptor();
 
-    double swCornerXsimple = 0., swCornerYsimple = 0.;
-    std::tie(swCornerXsimple, swCornerYsimple) =
-        dataset->getDescriptor().getOrigin();
+    if (!destination.getSimpleLayer(destinationType))
+    {
+        ChunkShape chunkShape;
+        std::tie(chunkShape.rows, chunkShape.columns) =
+            pSourceDescriptor->getChunkDims();
 
-    double nodeSpacingXsimple = 0., nodeSpacingYsimple = 0.;
-    std::tie(nodeSpacingXsimple, nodeSpacingYsimple) =
-        dataset->getDescriptor().getGridSpacing();
+        destination.createSimpleLayer(destinationType, chunkShape,
+            pSourceDescriptor->getCompressionSpec());
+    }
 
-    using std::floor;  using std::fabs;  using std::ceil;
+    auto pDestination = destination.getSimpleLayer(destinationType);
+    if (!pDestination)
+        throw LayerNotFound{};
 
-    // Compute an SEP for each cell in the row.
-    for (auto j=columnStart; j<=columnEnd; ++j)
-    {
-        const uint32_t rowIndex = j - columnStart;
+    // Every node is replaced, so the old min/max no longer applies.
+    pDestination->getDescriptor()->setMinMax(
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
 
-        if (data[rowIndex] == BAG_NULL_GENERIC ||
-            data[rowIndex] == BAG_NULL_ELEVATION ||
-            data[rowIndex] == BAG_NULL_UNCERTAINTY)
-            continue;
+    const bool isGridded = m_descriptor.getSurfaceType() ==
+        BAG_SURFACE_GRID_EXTENTS;
+    const auto plan = isGridded ? this->createCorrectionPlan() : CorrectionPlan{};
 
-        std::array<uint32_t, 2> rowRange{0, 0};
-        std::array<uint32_t, 2> colRange{0, 0};
+    // Keep the bands aligned with the chunks of the source.
+    const auto bandHeight = static_cast<uint32_t>(std::max<uint64_t>(
+        std::min<uint64_t>(pSourceDescriptor->getChunkSize(), numRows), 1));
 
-        //! Determine the X and Y values of given cell.
-        const double nodeX = swCornerXsimple + j * nodeSpacingXsimple;
-        const double nodeY = swCornerYsimple + row * nodeSpacingYsimple;
+    const ProgressScope bandProgress{progress};
 
-#if 0  // Dead code (see logic above); saved from C code for now.
-        if (surfaceType == BAG_SURFACE_IRREGULARLY_SPACED)
-        {
-            if (lastP[0] == -1 || lastP[1] == -1)
-            {
-                colRange[0] = 0;
-                colRange[1] = ncols -1;
-                rowRange[0] = 0;
-                rowRange[1] = nrows -1;
-            }
-            else
-            {
-                colRange[0] = lastP[0] - kSearchRadius;
-                colRange[1] = lastP[0] + kSearchRadius;
-                rowRange[0] = lastP[1] - kSearchRadius;
-                rowRange[1] = lastP[1] + kSearchRadius;
-            }
-        }
-        else
-#endif
-        if (surfaceType == BAG_SURFACE_GRID_EXTENTS)
+    try
+    {
+        for (uint32_t row=0; row<numRows; row+=bandHeight)
         {
-            //! A simple calculation for 4 nearest corrector nodes.
-            colRange[0] = static_cast<uint32_t>(fabs(floor((swCornerX - nodeX) / nodeSpacingX)));
-            colRange[1] = static_cast<uint32_t>(fabs(ceil((swCornerX - nodeX) / nodeSpacingX)));
-            rowRange[0] = static_cast<uint32_t>(fabs(floor((swCornerY - nodeY) / nodeSpacingY)));
-            rowRange[1] = static_cast<uint32_t>(fabs(ceil((swCornerY - nodeY) / nodeSpacingY)));
+            const auto rowEnd = std::min(row + bandHeight, numRows) - 1;
+
+            const auto band = isGridded
+                ? this->readCorrected(row, 0, rowEnd, numColumns - 1,
+                    corrector, source, plan)
+                : this->readCorrected(row, 0, rowEnd, numColumns - 1,
+                    corrector, source);
+
+            pDestination->write(row, 0, rowEnd, numColumns - 1, band.data());
+
+            bandProgress.report(rowEnd + 1, numRows);
         }
+    }
+    catch (const OperationCancelled&)
+    {
+        pDestination->writeAttributes();
+        throw;
+    }
 
-        //! Enforce dataset limits.
-        if (colRange[0] > colRange[1])
-            std::swap(colRange[0], colRange[1]);
+    pDestination->writeAttributes();
 
-        if (colRange[0] >= ncols)
-            colRange[0] = ncols -1;
+    return *pDestination;
+}
 
-        if (colRange[1] >= ncols)
-            colRange[1] = ncols -1;
+//! Apply a corrector to an area of values.
+/*!
+    The area is split into blocks of whole rows that are corrected on
+    separate threads.  Small areas are corrected on the calling thread.
 
-        if (rowRange[0] > rowRange[1])
-            std::swap(rowRange[0], rowRange[1]);
+\param plan
+    The plan covering the area.
+\param rowStart
+    The row of the first value.
+\param columnStart
+    The column of the first value.
+\param rowEnd
+    The row of the last value (inclusive).
+\param columnEnd
+    The column of the last value (inclusive).
+\param corrector
+    The corrector to apply.
+    Valid values are 1-10.
+\param data
+    The values to correct in place, row major.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+*/
+void SurfaceCorrections::applyCorrection(
+    const CorrectionPlan& plan,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    float* data,
+    size_t rowStride) const
+{
+    if (corrector < 1 || corrector > m_descriptor.getNumCorrectors())
+        throw InvalidCorrector{};
 
-        if (rowRange[0] >= nrows)
-            rowRange[0] = nrows -1;
+    const auto numCorrectorColumns = std::get<1>(m_descriptor.getDims());
+    const auto pCorrectors = this->getCorrectors();
+    const auto* correctorGrid =
+        reinterpret_cast<const VerticalDatumCorrectionsGridded*>(
+            pCorrectors->data());
 
-        if (rowRange[1] >= nrows)
-            rowRange[1] = nrows -1;
+    const auto columns = columnEnd - columnStart + 1;
 
-        if (colRange[1] == colRange[0])
-        {
-            if (colRange[0] > 0)
-                --colRange[0];
+    // Only the corrector grid and the plan are shared between threads, and
+    // both are read only from here on.
+    const auto correctRows = [&](uint32_t first, uint32_t last) {
+        auto* values = data + (first - rowStart) * rowStride;
 
-            if ((colRange[1] + 1) < ncols)
-                ++colRange[1];
-        }
-        if (rowRange[1] == rowRange[0])
-        {
+        for (auto row=first; row<=last; ++row, values += rowStride)
+            correctRow(plan, row, columnStart, columnEnd, corrector,
+                correctorGrid, numCorrectorColumns, values);
+    };
 
-            if (rowRange[0] > 0)
-                --rowRange[0];
+    processInBlocks(rowStart, rowEnd, columns, correctRows);
+}
 
-            if ((rowRange[1] + 1) < nrows)
-                ++rowRange[1];
-        }
+//! Apply a corrector to a row of values.
+/*!
+    Each value is moved by the inverse distance weighted average of the
+    neighbouring correctors recorded in the plan.  Null values are left alone.
+    Values coinciding with a corrector node take that node's corrector.
 
-        //std::cerr << "INDX: " << rowIndex << " Row: " << row << " RC:  " << rowRange[0] << "  / "<< rowRange[1] << '\n';
+\param plan
+    The plan covering the row.
+\param row
+    The row the values are from.
+\param columnStart
+    The column of the first value.
+\param columnEnd
+    The column of the last value (inclusive).
+\param corrector
+    The corrector to apply.
+    Valid values are 1-10.
+\param correctorGrid
+    The gridded correctors.
+\param numCorrectorColumns
+    The number of columns in the corrector grid.
+\param data
+    The values to correct in place.
+*/
+void SurfaceCorrections::correctRow(
+    const CorrectionPlan& plan,
+    uint32_t row,
+    uint32_t columnStart,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    const VerticalDatumCorrectionsGridded* correctorGrid,
+    uint32_t numCorrectorColumns,
+    float* data) noexcept
+{
+    --corrector;  // This is 0 based when used.
+
+    const auto& rowNeighbours = plan.m_rows[row - plan.m_rowStart];
+    const auto* columnNeighbours =
+        plan.m_columns.data() + (columnStart - plan.m_columnStart);
+
+    // Compute an SEP for each cell in the row.
+    for (auto j=columnStart; j<=columnEnd; ++j, ++data, ++columnNeighbours)
+    {
+        if (*data == BAG_NULL_GENERIC ||
+            *data == BAG_NULL_ELEVATION ||
+            *data == BAG_NULL_UNCERTAINTY)
+            continue;
 
         bool isZeroDistance = false;
         double sum_sep = 0.0;
         double sum = 0.0;
-        double leastDistSq = std::numeric_limits<double>::max();
 
         // Look through the SEPs and calculate the weighted average between them and this position.
-        for (auto q=rowRange[0]; !isZeroDistance && q <= rowRange[1]; ++q)
+        for (uint32_t a=0; !isZeroDistance && a<rowNeighbours.count; ++a)
         {
-            // The SEP should be accessed, up to entire row of all columns of Surface_Correction.
-            const auto buffer = this->read(q, q, colRange[0], colRange[1]);
-            const auto* readbuf = reinterpret_cast<const BagVerticalDatumCorrectionsGridded*>(buffer.data());
-            const auto y1 = swCornerY + q * nodeSpacingY;
+            const auto* vertCorr = correctorGrid +
+                static_cast<size_t>(rowNeighbours.first + a) * numCorrectorColumns +
+                columnNeighbours->first;
+            const auto distSqY = rowNeighbours.distSq[a];
 
-            for (auto u=colRange[0]; u<=colRange[1]; ++u)
+            for (uint32_t b=0; b<columnNeighbours->count; ++b, ++vertCorr)
             {
-                const auto* vertCorr = readbuf + (u - colRange[0]);
-
                 const auto z1 = vertCorr->z[corrector];
-                const auto x1 = swCornerX + u * nodeSpacingX;
+                const auto distSq = columnNeighbours->distSq[b] + distSqY;
 
-                double distSq = 0.;
-
-                if (nodeX ==  x1 && nodeY == y1)
+                if (distSq == 0.0)
                 {
                     isZeroDistance = true;
-                    distSq = 1.0;
-                    data[rowIndex] += z1;
+                    *data += z1;
 
                     break;
                 }
 
-                // Calculate distance weight between nodeX/nodeY and y1/x1
-                distSq = std::pow(fabs(static_cast<double>(nodeX - x1)), 2.0) +
-                    std::pow(resratio * fabs(static_cast<double>(nodeY - y1)), 2.0);
-
-
-                if (leastDistSq > distSq)
-                {
-                    leastDistSq = distSq;
-                    lastP[0] = u;
-                    lastP[1] = q;
-                }
-
                 // Inverse distance calculation
-                sum_sep += z1 / distSq;
-                sum += 1.0 / distSq;
+                const auto weight = 1.0 / distSq;
+                sum_sep += z1 * weight;
+                sum += weight;
             }
         }
 
-        //std::cerr << "sum sum " << sum_sep << " / " << sum << " =  " << sum_sep / sum << " : " << data[rowIndex] << '\n';
-
         if (!isZeroDistance)
         {
             // is not a constant SEP with one point?
             if (sum_sep != 0.0 && sum != 0.0)
-                data[rowIndex] += static_cast<float>(sum_sep / sum);
+                *data += static_cast<float>(sum_sep / sum);
             else
-                data[rowIndex] = BAG_NULL_GENERIC;
+                *data = BAG_NULL_GENERIC;
         }
-
     }
+}
+
+//! Apply an irregularly spaced corrector to an area of values.
+/*!
+    Each value is moved by the inverse distance weighted average of the
+    nearest correctors.  Null values are left alone.  Values coinciding with
+    a corrector take that corrector.
+
+\param rowStart
+    The row of the first value.
+\param columnStart
+    The column of the first value.
+\param rowEnd
+    The row of the last value (inclusive).
+\param columnEnd
+    The column of the last value (inclusive).
+\param corrector
+    The corrector to apply.
+    Valid values are 1-10.
+\param data
+    The values to correct in place, row major.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+*/
+void SurfaceCorrections::applyIrregularCorrection(
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint8_t corrector,
+    float* data,
+    size_t rowStride) const
+{
+    if (corrector < 1 || corrector > m_descriptor.getNumCorrectors())
+        throw InvalidCorrector{};
+
+    --corrector;  // This is 0 based when used.
+
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    double swCornerX = 0., swCornerY = 0.;
+    std::tie(swCornerX, swCornerY) = pDataset->getDescriptor().getOrigin();
+
+    double nodeSpacingX = 0., nodeSpacingY = 0.;
+    std::tie(nodeSpacingX, nodeSpacingY) =
+        pDataset->getDescriptor().getGridSpacing();
+
+    const auto pIndex = this->getCorrectorIndex();
+    const auto& index = *pIndex;
+    const auto* nodes = index.getNodes();
+    const auto columns = columnEnd - columnStart + 1;
+
+    // Only the index is shared between threads, and it is read only.
+    const auto correctRows = [&](uint32_t first, uint32_t last) {
+        std::array<CorrectorIndex::Neighbour, kNumIrregularNeighbours> neighbours;
+
+        for (auto row=first; row<=last; ++row)
+        {
+            const auto nodeY = swCornerY + row * nodeSpacingY;
+            auto* values = data + (row - rowStart) * rowStride;
+
+            for (auto column=columnStart; column<=columnEnd; ++column, ++values)
+            {
+                if (*values == BAG_NULL_GENERIC ||
+                    *values == BAG_NULL_ELEVATION ||
+                    *values == BAG_NULL_UNCERTAINTY)
+                    continue;
 
-    return originalRow;
+                const auto nodeX = swCornerX + column * nodeSpacingX;
+                const auto numFound = index.findNearest(nodeX, nodeY,
+                    kNumIrregularNeighbours, neighbours.data());
+
+                // The nearest corrector is first.
+                if (numFound > 0 && neighbours[0].distSq == 0.0)
+                {
+                    *values += nodes[neighbours[0].index].z[corrector];
+                    continue;
+                }
+
+                double sum_sep = 0.0;
+                double sum = 0.0;
+
+                // Inverse distance calculation
+                for (uint32_t i=0; i<numFound; ++i)
+                {
+                    const auto weight = 1.0 / neighbours[i].distSq;
+                    sum_sep += nodes[neighbours[i].index].z[corrector] * weight;
+                    sum += weight;
+                }
+
+                // is not a constant SEP with one point?
+                if (sum_sep != 0.0 && sum != 0.0)
+                    *values += static_cast<float>(sum_sep / sum);
+                else
+                    *values = BAG_NULL_GENERIC;
+            }
+        }
+    };
+
+    processInBlocks(rowStart, rowEnd, columns, correctRows);
 }
 
 //! \copydoc Layer::read
@@ -557,18 +1281,12 @@ UInt8Array SurfaceCorrections::readProxy(
 
     h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const SurfaceCorrectionsDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
-    const auto bufferSize = pDescriptor->getReadBufferSize(rows, columns);
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
     UInt8Array buffer{bufferSize};
 
     const ::H5::DataSpace h5memSpace{kRank, count.data(), count.data()};
 
-    const auto h5memDataType = getCompoundType(*pDescriptor);
+    const auto h5memDataType = getCompoundType(m_descriptor);
 
     m_pH5dataSet->read(buffer.data(), h5memDataType, h5memSpace, h5fileDataSpace);
 
@@ -578,21 +1296,15 @@ UInt8Array SurfaceCorrections::readProxy(
 //! \copydoc Layer::writeAttributes
 void SurfaceCorrections::writeAttributesProxy() const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const SurfaceCorrectionsDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
-
     // Write any attributes, from the layer descriptor.
     // surface type
     auto att = m_pH5dataSet->openAttribute(VERT_DATUM_CORR_SURFACE_TYPE);
-    const auto surfaceType = pDescriptor->getSurfaceType();
+    const auto surfaceType = m_descriptor.getSurfaceType();
     const auto tmpSurfaceType = static_cast<uint8_t>(surfaceType);
     att.write(::H5::PredType::NATIVE_UINT8, &tmpSurfaceType);
 
     // vertical datums
-    auto tmpDatums = pDescriptor->getVerticalDatums();
+    auto tmpDatums = m_descriptor.getVerticalDatums();
     if (tmpDatums.size() > kMaxDatumsLength)
         tmpDatums.resize(kMaxDatumsLength);
 
@@ -604,7 +1316,7 @@ void SurfaceCorrections::writeAttributesProxy() const
     {
         // sw corner x
         att = m_pH5dataSet->openAttribute(VERT_DATUM_CORR_SWX);
-        const auto origin = pDescriptor->getOrigin();
+        const auto origin = m_descriptor.getOrigin();
         att.write(::H5::PredType::NATIVE_DOUBLE, &std::get<0>(origin));
 
         // sw corner y
@@ -612,7 +1324,7 @@ void SurfaceCorrections::writeAttributesProxy() const
         att.write(::H5::PredType::NATIVE_DOUBLE, &std::get<1>(origin));
 
         // node spacing x
-        const auto spacing = pDescriptor->getSpacing();
+        const auto spacing = m_descriptor.getSpacing();
         att = m_pH5dataSet->openAttribute(VERT_DATUM_CORR_NSX);
         att.write(::H5::PredType::NATIVE_DOUBLE, &std::get<0>(spacing));
 
@@ -630,10 +1342,7 @@ void SurfaceCorrections::writeProxy(
     uint32_t columnEnd,
     const uint8_t* buffer)
 {
-    auto pDescriptor = std::dynamic_pointer_cast<SurfaceCorrectionsDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
+    const auto lock = this->getDataset().lock()->lockWrites();
 
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
@@ -659,20 +1368,37 @@ void SurfaceCorrections::writeProxy(
 
         h5fileDataSpace = m_pH5dataSet->getSpace();
 
-        // Update the dataset's dimensions.
+        // Grow the dataset's dimensions so the new nodes can be read back,
+        // but never shrink them below the size of the other layers.
         if (this->getDataset().expired())
             throw DatasetNotFound{};
 
         auto pDataset = this->getDataset().lock();
-        pDataset->getDescriptor().setDims(static_cast<uint32_t>(newDims[0]),
-            static_cast<uint32_t>(newDims[1]));
+
+        uint32_t datasetRows = 0, datasetColumns = 0;
+        std::tie(datasetRows, datasetColumns) =
+            pDataset->getDescriptor().getDims();
+
+        pDataset->getDescriptor().setDims(
+            std::max(datasetRows, static_cast<uint32_t>(newDims[0])),
+            std::max(datasetColumns, static_cast<uint32_t>(newDims[1])));
     }
 
-    h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+    const auto h5memDataType = getCompoundType(m_descriptor);
 
-    const auto h5memDataType = getCompoundType(*pDescriptor);
+    // Whole chunks are compressed on several threads.
+    if (!writeChunksDirect(*m_pH5dataSet, h5memDataType, rowStart,
+        columnStart, rowEnd, columnEnd, buffer))
+    {
+        h5fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(),
+            offset.data());
+
+        m_pH5dataSet->write(buffer, h5memDataType, h5memDataSpace,
+            h5fileDataSpace);
+    }
 
-    m_pH5dataSet->write(buffer, h5memDataType, h5memDataSpace, h5fileDataSpace);
+    // The cached correctors, and the index over them, are now stale.
+    this->releaseCaches();
 
     // Update descriptor.
     const auto h5Space = m_pH5dataSet->getSpace();
@@ -680,7 +1406,7 @@ void SurfaceCorrections::writeProxy(
     std::array<hsize_t, kRank> dims{};
     h5Space.getSimpleExtentDims(dims.data());
 
-    pDescriptor->setDims(static_cast<uint32_t>(dims[0]),
+    m_descriptor.setDims(static_cast<uint32_t>(dims[0]),
         static_cast<uint32_t>(dims[1]));
 }
 
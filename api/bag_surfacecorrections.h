@@ -2,16 +2,21 @@
 #define BAG_SURFACECORRECTIONS_H
 
 #include "bag_config.h"
+#include "bag_correctionplan.h"
 #include "bag_deleteh5dataset.h"
+#include "bag_executor.h"
 #include "bag_fordec.h"
 #include "bag_layer.h"
 #include "bag_types.h"
 
+#include <future>
 #include <memory>
 
 
 namespace BAG {
 
+class CorrectorIndex;
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
@@ -42,16 +47,46 @@ public:
     std::shared_ptr<SurfaceCorrectionsDescriptor> getDescriptor() & noexcept;
     std::shared_ptr<const SurfaceCorrectionsDescriptor> getDescriptor() const & noexcept;
 
+    CorrectionPlan load(const VerticalDatumCorrectionsGridded* correctors,
+        uint32_t rows, uint32_t columns);
+    void load(const VerticalDatumCorrections* correctors, uint32_t numNodes);
+
+    CorrectionPlan createCorrectionPlan() const;
+    CorrectionPlan createCorrectionPlan(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+
     UInt8Array readCorrected(uint32_t rowStart, uint32_t columnStart,
         uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
         const SimpleLayer& layer) const;
+    UInt8Array readCorrected(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+        const SimpleLayer& layer, const CorrectionPlan& plan) const;
+    std::future<UInt8Array> readCorrectedAsync(uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        uint8_t corrector, const SimpleLayer& layer,
+        Executor& executor = Executor::global()) const;
     UInt8Array readCorrectedRow(uint32_t row, uint32_t columnStart,
         uint32_t columnEnd, uint8_t corrector, const SimpleLayer& layer) const;
+    UInt8Array readCorrectedRow(uint32_t row, uint32_t columnStart,
+        uint32_t columnEnd, uint8_t corrector, const SimpleLayer& layer,
+        const CorrectionPlan& plan) const;
+
+    void readCorrectedInto(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+        const SimpleLayer& layer, float* data, size_t rowStride = 0) const;
+    void readCorrectedInto(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+        const SimpleLayer& layer, const CorrectionPlan& plan, float* data,
+        size_t rowStride = 0) const;
+
+    SimpleLayer& writeCorrectedLayer(const SimpleLayer& source,
+        uint8_t corrector, Dataset& destination, LayerType destinationType,
+        ProgressToken* progress = nullptr) const;
 
 protected:
     static std::shared_ptr<SurfaceCorrections> create(Dataset& dataset,
         BAG_SURFACE_CORRECTION_TOPOGRAPHY type, uint8_t numCorrectors,
-        uint64_t chunkSize, int compressionLevel);
+        const ChunkShape& chunkShape, const CompressionSpec& compression);
 
     static std::shared_ptr<SurfaceCorrections> open(Dataset& dataset,
         SurfaceCorrectionsDescriptor& descriptor);
@@ -63,6 +98,27 @@ private:
 
     const ::H5::DataSet& getH5dataSet() const & noexcept;
 
+    void loadCorrectors(BAG_SURFACE_CORRECTION_TOPOGRAPHY surfaceType,
+        const uint8_t* buffer, uint32_t rows, uint32_t columns);
+
+    std::shared_ptr<const UInt8Array> getCorrectors() const;
+    std::shared_ptr<const CorrectorIndex> getCorrectorIndex() const;
+    uint64_t getCacheBytes() const noexcept;
+    void releaseCaches() const noexcept;
+
+    void applyCorrection(const CorrectionPlan& plan, uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        uint8_t corrector, float* data, size_t rowStride) const;
+
+    static void correctRow(const CorrectionPlan& plan, uint32_t row,
+        uint32_t columnStart, uint32_t columnEnd, uint8_t corrector,
+        const VerticalDatumCorrectionsGridded* correctorGrid,
+        uint32_t numCorrectorColumns, float* data) noexcept;
+
+    void applyIrregularCorrection(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+        float* data, size_t rowStride) const;
+
     UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const override;
 
@@ -71,8 +127,14 @@ private:
 
     void writeAttributesProxy() const override;
 
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    SurfaceCorrectionsDescriptor& m_descriptor;
     //! The HDF5 DataSet this class relates to.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! All the correctors, read when first needed to apply a correction.
+    mutable std::shared_ptr<const UInt8Array> m_pCorrectors;
+    //! The index over irregularly spaced correctors, built with m_pCorrectors.
+    mutable std::shared_ptr<const CorrectorIndex> m_pCorrectorIndex;
 
     friend Dataset;
     friend SurfaceCorrectionsDescriptor;
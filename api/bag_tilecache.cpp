@@ -0,0 +1,362 @@
+
+#include "bag_tilecache.h"
+
+
+
+namespace BAG {
+
+namespace {
+
+//! The bytes a tile holds besides its elements; its place in the lists and
+//! maps of its shard.
+constexpr uint64_t kTileOverhead = 128;
+
+//! Find the bytes a tile holds.
+/*!
+\param tile
+    The elements of the tile.
+
+\return
+    The bytes the tile holds.
+*/
+uint64_t getTileBytes(
+    const std::vector<uint8_t>& tile) noexcept
+{
+    return tile.size() + kTileOverhead;
+}
+
+}  // namespace
+
+constexpr size_t TileCache::kNumShards;
+
+//! Hash the key of a tile.
+/*!
+\param key
+    The key.
+
+\return
+    The hash.
+*/
+size_t TileCache::KeyHash::operator()(
+    const Key& key) const noexcept
+{
+    // Mix the fields, so neighbouring tiles land in different shards.
+    auto hash = key.layer * 0x9E3779B97F4A7C15ull;
+    hash ^= (static_cast<uint64_t>(key.row) << 32 | key.column) +
+        0x7F4A7C159E3779B9ull + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 29;
+
+    return static_cast<size_t>(hash);
+}
+
+//! Retrieve the cache shared by every Dataset.
+/*!
+    The cache is never destroyed, so datasets destroyed during static
+    destruction can still use it.
+
+\return
+    The cache.
+*/
+TileCache& TileCache::global() noexcept
+{
+    static auto* pCache = new TileCache;
+
+    return *pCache;
+}
+
+//! Retrieve the most the tiles may hold.
+/*!
+\return
+    The limit, in bytes; 0 if there is no cache.
+*/
+uint64_t TileCache::getLimit() const noexcept
+{
+    return m_limit.load();
+}
+
+//! Set the most the tiles may hold.
+/*!
+    If the tiles already hold more, those used least recently are dropped
+    until they fit.
+
+\param bytes
+    The limit, in bytes; 0 to not cache tiles, and drop those cached.
+*/
+void TileCache::setLimit(
+    uint64_t bytes)
+{
+    m_limit = bytes;
+
+    for (auto& shard : m_shards)
+    {
+        const std::lock_guard<std::mutex> lock{shard.mutex};
+        this->trim(shard, bytes / kNumShards);
+    }
+}
+
+//! Retrieve the memory the tiles hold.
+/*!
+\return
+    The memory held, in bytes.
+*/
+uint64_t TileCache::getUsage() const noexcept
+{
+    uint64_t usage = 0;
+
+    for (const auto& shard : m_shards)
+    {
+        const std::lock_guard<std::mutex> lock{shard.mutex};
+        usage += shard.usage;
+    }
+
+    return usage;
+}
+
+//! Retrieve the number of tiles cached.
+/*!
+\return
+    The number of tiles.
+*/
+size_t TileCache::getNumTiles() const noexcept
+{
+    size_t numTiles = 0;
+
+    for (const auto& shard : m_shards)
+    {
+        const std::lock_guard<std::mutex> lock{shard.mutex};
+        numTiles += shard.positions.size();
+    }
+
+    return numTiles;
+}
+
+//! Retrieve what the cache has done.
+/*!
+\return
+    The number of hits, misses, evictions and invalidations.
+*/
+TileCacheStats TileCache::getStats() const noexcept
+{
+    TileCacheStats stats;
+
+    for (const auto& shard : m_shards)
+    {
+        const std::lock_guard<std::mutex> lock{shard.mutex};
+        stats.hits += shard.stats.hits;
+        stats.misses += shard.stats.misses;
+        stats.evictions += shard.stats.evictions;
+        stats.invalidations += shard.stats.invalidations;
+    }
+
+    return stats;
+}
+
+//! Drop every tile.
+/*!
+    The statistics are kept.
+*/
+void TileCache::clear() noexcept
+{
+    for (auto& shard : m_shards)
+    {
+        const std::lock_guard<std::mutex> lock{shard.mutex};
+        shard.tiles.clear();
+        shard.positions.clear();
+        shard.usage = 0;
+    }
+}
+
+//! Retrieve the id of a layer known by its file and path.
+/*!
+\param name
+    The canonical name and stamp of the file, and the path of the layer.
+
+\return
+    The id of the layer; the same for the same name.
+*/
+uint64_t TileCache::getLayerId(
+    const std::string& name)
+{
+    const std::lock_guard<std::mutex> lock{m_layersMutex};
+
+    const auto found = m_layerIds.find(name);
+    if (found != m_layerIds.end())
+        return found->second;
+
+    const auto id = this->makeLayerId();
+    m_layerIds.emplace(name, id);
+
+    return id;
+}
+
+//! Make an id for a layer that shares its tiles with no other.
+/*!
+\return
+    The id of the layer.
+*/
+uint64_t TileCache::makeLayerId() noexcept
+{
+    return m_nextLayerId++;
+}
+
+//! Look for a tile, and mark it used.
+/*!
+\param layer
+    The id of the layer.
+\param row
+    The row of the chunk.
+\param column
+    The column of the chunk.
+
+\return
+    The tile; null if it is not cached.
+*/
+TileCache::Tile TileCache::find(
+    uint64_t layer,
+    uint32_t row,
+    uint32_t column)
+{
+    const Key key{layer, row, column};
+    auto& shard = this->getShard(key);
+
+    const std::lock_guard<std::mutex> lock{shard.mutex};
+
+    const auto found = shard.positions.find(key);
+    if (found == shard.positions.end())
+    {
+        ++shard.stats.misses;
+        return {};
+    }
+
+    shard.tiles.splice(shard.tiles.begin(), shard.tiles, found->second);
+    ++shard.stats.hits;
+
+    return found->second->second;
+}
+
+//! Cache a tile, as the most recently used.
+/*!
+    The tiles used least recently are dropped if the shard of the tile then
+    holds more than its part of the limit.
+
+\param layer
+    The id of the layer.
+\param row
+    The row of the chunk.
+\param column
+    The column of the chunk.
+\param tile
+    The elements of the tile, row by row; replaces the tile cached.
+*/
+void TileCache::insert(
+    uint64_t layer,
+    uint32_t row,
+    uint32_t column,
+    Tile tile)
+{
+    const auto limit = m_limit.load() / kNumShards;
+    const auto bytes = getTileBytes(*tile);
+    if (bytes > limit)
+        return;
+
+    const Key key{layer, row, column};
+    auto& shard = this->getShard(key);
+
+    const std::lock_guard<std::mutex> lock{shard.mutex};
+
+    const auto found = shard.positions.find(key);
+    if (found != shard.positions.end())
+    {
+        shard.usage -= getTileBytes(*found->second->second);
+        shard.tiles.erase(found->second);
+        shard.positions.erase(found);
+    }
+
+    shard.tiles.emplace_front(key, std::move(tile));
+    shard.positions.emplace(key, shard.tiles.begin());
+    shard.usage += bytes;
+
+    this->trim(shard, limit);
+}
+
+//! Drop the tiles of an area of a layer, as it was written.
+/*!
+\param layer
+    The id of the layer.
+\param firstRow
+    The first row of chunks.
+\param firstColumn
+    The first column of chunks.
+\param lastRow
+    The last row of chunks (inclusive).
+\param lastColumn
+    The last column of chunks (inclusive).
+*/
+void TileCache::invalidate(
+    uint64_t layer,
+    uint32_t firstRow,
+    uint32_t firstColumn,
+    uint32_t lastRow,
+    uint32_t lastColumn)
+{
+    for (auto row=firstRow; row<=lastRow; ++row)
+        for (auto column=firstColumn; column<=lastColumn; ++column)
+        {
+            const Key key{layer, row, column};
+            auto& shard = this->getShard(key);
+
+            const std::lock_guard<std::mutex> lock{shard.mutex};
+
+            const auto found = shard.positions.find(key);
+            if (found == shard.positions.end())
+                continue;
+
+            shard.usage -= getTileBytes(*found->second->second);
+            shard.tiles.erase(found->second);
+            shard.positions.erase(found);
+            ++shard.stats.invalidations;
+        }
+}
+
+//! Find the shard of a tile.
+/*!
+\param key
+    The key of the tile.
+
+\return
+    The shard.
+*/
+TileCache::Shard& TileCache::getShard(
+    const Key& key) noexcept
+{
+    return m_shards[KeyHash{}(key) % kNumShards];
+}
+
+//! Drop the tiles of a shard used least recently until they fit a limit.
+/*!
+    The mutex of the shard must be held.
+
+\param shard
+    The shard.
+\param limit
+    The most its tiles may hold, in bytes.
+*/
+void TileCache::trim(
+    Shard& shard,
+    uint64_t limit) noexcept
+{
+    while (shard.usage > limit && !shard.tiles.empty())
+    {
+        const auto& oldest = shard.tiles.back();
+
+        shard.usage -= getTileBytes(*oldest.second);
+        shard.positions.erase(oldest.first);
+        shard.tiles.pop_back();
+        ++shard.stats.evictions;
+    }
+}
+
+}  // namespace BAG
+
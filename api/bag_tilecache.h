@@ -0,0 +1,152 @@
+#ifndef BAG_TILECACHE_H
+#define BAG_TILECACHE_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! A cache of the decoded chunks (tiles) of simple layers, shared by every
+//! thread and every Dataset.
+/*!
+    HDF5 keeps a chunk cache per layer, only used under the lock of the BAG,
+    so the same chunks are decoded again by every reader that does not share
+    the layer.  With a limit set, the reads of chunked simple layers keep the
+    chunks they decode here, and a read whose chunks are all cached is
+    copied from memory without calling HDF5.
+
+    A tile is known by its layer and its position.  The layers of BAGs read
+    only from local files are known by the file (its canonical name, size
+    and modification time) and their path, so every Dataset opened on the
+    same file shares their tiles; other layers are known by the layer
+    object.  Writing to a layer drops the tiles it changes.
+
+    The tiles are spread over shards, each with its own lock and least
+    recently used order, so threads rarely wait for one another.  A read
+    larger than a quarter of the limit bypasses the cache, so a scan does
+    not push out the tiles in use.
+
+    There is no limit, and so no cache, by default.
+*/
+class BAG_API TileCache final
+{
+public:
+    static TileCache& global() noexcept;
+
+    TileCache(const TileCache&) = delete;
+    TileCache(TileCache&&) = delete;
+
+    TileCache& operator=(const TileCache&) = delete;
+    TileCache& operator=(TileCache&&) = delete;
+
+    uint64_t getLimit() const noexcept;
+    void setLimit(uint64_t bytes);
+
+    uint64_t getUsage() const noexcept;
+    size_t getNumTiles() const noexcept;
+    TileCacheStats getStats() const noexcept;
+
+    void clear() noexcept;
+
+private:
+    //! The number of shards.
+    static constexpr size_t kNumShards = 16;
+
+    //! The elements of a tile, row by row.
+    using Tile = std::shared_ptr<const std::vector<uint8_t>>;
+
+    //! Where a tile is.
+    struct Key final
+    {
+        //! The layer.
+        uint64_t layer = 0;
+        //! The row of the chunk.
+        uint32_t row = 0;
+        //! The column of the chunk.
+        uint32_t column = 0;
+
+        //! Are two keys of the same tile?
+        bool operator==(const Key& other) const noexcept
+        {
+            return layer == other.layer && row == other.row &&
+                column == other.column;
+        }
+    };
+
+    //! Hashes a Key.
+    struct KeyHash final
+    {
+        //! Hash a key.
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    //! A part of the cache with its own lock.
+    struct Shard final
+    {
+        //! Guards the members.
+        mutable std::mutex mutex;
+        //! The tiles, the most recently used first.
+        std::list<std::pair<Key, Tile>> tiles;
+        //! The position of each tile in tiles.
+        std::unordered_map<Key, std::list<std::pair<Key, Tile>>::iterator,
+            KeyHash> positions;
+        //! The bytes held by the tiles.
+        uint64_t usage = 0;
+        //! What the shard has done.
+        TileCacheStats stats;
+    };
+
+    TileCache() = default;
+
+    uint64_t getLayerId(const std::string& name);
+    uint64_t makeLayerId() noexcept;
+
+    Tile find(uint64_t layer, uint32_t row, uint32_t column);
+    void insert(uint64_t layer, uint32_t row, uint32_t column, Tile tile);
+    void invalidate(uint64_t layer, uint32_t firstRow, uint32_t firstColumn,
+        uint32_t lastRow, uint32_t lastColumn);
+
+    Shard& getShard(const Key& key) noexcept;
+    void trim(Shard& shard, uint64_t limit) noexcept;
+
+    //! The shards; a tile is in the shard its key hashes to.
+    std::array<Shard, kNumShards> m_shards;
+    //! The most the tiles may hold, in bytes; 0 for no cache.
+    std::atomic<uint64_t> m_limit{0};
+    //! Guards m_layerIds.
+    std::mutex m_layersMutex;
+    //! The id of each layer known by its file and path.
+    std::unordered_map<std::string, uint64_t> m_layerIds;
+    //! The next layer id; 0 is not used.
+    std::atomic<uint64_t> m_nextLayerId{1};
+
+    friend SimpleLayer;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_TILECACHE_H
+
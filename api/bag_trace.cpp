@@ -0,0 +1,41 @@
+
+#include "bag_trace.h"
+
+#include <atomic>
+
+
+namespace BAG {
+
+namespace {
+
+//! The sink reported to; nullptr if tracing is off.
+std::atomic<TraceSink*> g_pTraceSink{nullptr};
+
+}  // namespace
+
+//! Set the sink the operations of the library are reported to.
+/*!
+    The sink is not owned; it must outlive every operation started while it
+    is set.
+
+\param pSink
+    The sink; nullptr to stop reporting.
+*/
+void setTraceSink(
+    TraceSink* pSink) noexcept
+{
+    g_pTraceSink.store(pSink, std::memory_order_release);
+}
+
+//! Retrieve the sink the operations of the library are reported to.
+/*!
+\return
+    The sink; nullptr if there is none.
+*/
+TraceSink* getTraceSink() noexcept
+{
+    return g_pTraceSink.load(std::memory_order_acquire);
+}
+
+}  // namespace BAG
+
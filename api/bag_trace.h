@@ -0,0 +1,54 @@
+#ifndef BAG_TRACE_H
+#define BAG_TRACE_H
+
+#include "bag_config.h"
+
+#include <cstdint>
+
+
+namespace BAG {
+
+//! An operation of the library, reported to a TraceSink.
+struct BAG_API TraceEvent final
+{
+    //! The name of the operation, such as "Layer::read"; a string literal.
+    const char* name = nullptr;
+    //! The name of the layer operated on; nullptr if there is none.
+    const char* layerName = nullptr;
+    //! The rows of the window read or written; 0 if there is none.
+    uint32_t rows = 0;
+    //! The columns of the window read or written; 0 if there is none.
+    uint32_t columns = 0;
+};
+
+//! Receives the begin and end of the operations of the library.
+/*!
+    Derive from this to forward the operations of the library to a profiler,
+    such as Perfetto, Tracy or OpenTelemetry, and install it with
+    setTraceSink().  Operations nest, and each begin() is followed by an end()
+    with the same event on the same thread, even when the operation throws.
+
+    Events are reported from every thread that uses the library, so the sink
+    must be thread safe.  It must not throw, nor call back into the library.
+
+    When the library is built without BAG_BUILD_TRACING, no events are
+    reported.
+*/
+class BAG_API TraceSink
+{
+public:
+    virtual ~TraceSink() = default;
+
+    //! An operation began.
+    virtual void begin(const TraceEvent& event) noexcept = 0;
+    //! An operation ended.
+    virtual void end(const TraceEvent& event) noexcept = 0;
+};
+
+BAG_API void setTraceSink(TraceSink* pSink) noexcept;
+BAG_API TraceSink* getTraceSink() noexcept;
+
+}  // namespace BAG
+
+#endif  // BAG_TRACE_H
+
@@ -7,6 +7,7 @@
 #include "bag_types.h"
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 
@@ -67,6 +68,7 @@ public:
     const_reference back() const &;
     void reserve(size_t newCapacity);
     void resize(size_t count);
+    void preallocate(size_t numItems);
     value_type* data() & noexcept;
     const value_type* data() const & noexcept;
 
@@ -75,22 +77,72 @@ public:
     reference operator[](size_t index) & noexcept;
     const_reference operator[](size_t index) const & noexcept;
 
+    std::vector<value_type> getItemsAtNode(uint32_t row, uint32_t col) const;
+    std::vector<value_type> getItemsWithCode(uint8_t code) const;
+    std::vector<value_type> getItemsInSeries(uint16_t series) const;
+    std::vector<value_type> getItemsInWindow(uint32_t rowStart,
+        uint32_t colStart, uint32_t rowEnd, uint32_t colEnd) const;
+
+    void sortByNode(bool descending = false);
+    void sortByCode(bool descending = false);
+    void sortBySeries(bool descending = false);
+
     void write() const;
 
 protected:
     explicit TrackingList(const Dataset& dataset);
-    TrackingList(const Dataset& dataset, int compressionLevel);
+    TrackingList(const Dataset& dataset, const CompressionSpec& compression);
 
 private:
+    //! What the items are sorted by.
+    enum class SortKey
+    {
+        none,
+        node,
+        code,
+        series,
+    };
 
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> createH5dataSet(
-        int compressionLevel);
+        const CompressionSpec& compression, size_t numReserved = 0);
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> openH5dataSet();
 
+    void markChanged(size_t firstChanged) noexcept;
+    void applySort(SortKey key, bool descending,
+        const std::vector<uint32_t>& order);
+    void updateIndex() const;
+    std::unique_lock<std::recursive_mutex> lockIndex() const;
+
+    uint64_t getCacheBytes() const noexcept;
+    void releaseCaches() const noexcept;
+    void writeItems() const;
+    void trim();
+
     //! The associated BAG Dataset.
     std::weak_ptr<const Dataset> m_pBagDataset;
     //! The items in the tracking list.
     std::vector<value_type> m_items;
+    //! The position of each item, sorted by node.
+    mutable std::vector<uint32_t> m_nodeOrder;
+    //! The position of each item, sorted by track code.
+    mutable std::vector<uint32_t> m_codeOrder;
+    //! The position of each item, sorted by list series.
+    mutable std::vector<uint32_t> m_seriesOrder;
+    //! Are the sorted positions up to date with the items?
+    mutable bool m_isIndexed = false;
+    //! What the items are known to be sorted by.
+    SortKey m_sortKey = SortKey::none;
+    //! Are the items sorted from the largest key to the smallest?
+    bool m_sortDescending = false;
+    //! The number of leading items known to match the HDF5 DataSet.
+    mutable size_t m_numWritten = 0;
+    //! Was a write() deferred until the batch it was made in is committed?
+    mutable bool m_writeDeferred = false;
+    //! The number of items room was made for in the HDF5 DataSet by
+    //! preallocate(); 0 once trimmed.
+    size_t m_numReserved = 0;
+    //! The HDF5 type of an item.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5itemType;
     //! The HDF5 DataSet this class wraps.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
 
@@ -126,6 +178,7 @@ private:
 template <typename... Args>
 void TrackingList::emplace_back(Args&&... args) &
 {
+    this->markChanged(m_items.size());
     m_items.emplace_back(std::forward<Args>(args)...);
 }
 
@@ -0,0 +1,314 @@
+#ifndef BAG_TRACKINGLISTINDEX_H
+#define BAG_TRACKINGLISTINDEX_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+
+namespace BAG {
+
+//! Pack a node position into one key that sorts by row, then column.
+/*!
+\param row
+    The row.
+\param column
+    The column.
+
+\return
+    The key.
+*/
+inline uint64_t makeNodeKey(
+    uint32_t row,
+    uint32_t column) noexcept
+{
+    return (static_cast<uint64_t>(row) << 32) | column;
+}
+
+//! Stably sort positions of tracking list items by a key, with a radix sort.
+/*!
+    Only the bytes of the key that differ between items are sorted on, so
+    a node key costs as many passes as the rows and columns need bytes.
+    Applying several keys in turn, the least significant first, sorts by
+    all of them.
+
+\param items
+    The tracking list items.
+\param getKey
+    Returns the key of an item, as an unsigned integer of up to 64 bits.
+\param descending
+    \e true to sort from the largest key to the smallest.
+\param order
+    The positions of the items to sort; sorted in place.
+*/
+template <typename Item, typename GetKey>
+void radixSortTrackingItems(
+    const std::vector<Item>& items,
+    const GetKey& getKey,
+    bool descending,
+    std::vector<uint32_t>& order)
+{
+    const auto count = order.size();
+    if (count < 2)
+        return;
+
+    std::vector<uint64_t> keys(count);
+    uint64_t anyBits = 0;
+    uint64_t allBits = ~uint64_t{0};
+
+    for (size_t i=0; i<count; ++i)
+    {
+        const auto key = static_cast<uint64_t>(getKey(items[order[i]]));
+        keys[i] = descending ? ~key : key;
+        anyBits |= keys[i];
+        allBits &= keys[i];
+    }
+
+    const auto differingBits = anyBits ^ allBits;
+
+    std::vector<uint64_t> nextKeys(count);
+    std::vector<uint32_t> nextOrder(count);
+
+    for (unsigned int shift=0; shift<64; shift+=8)
+    {
+        if (((differingBits >> shift) & 0xFF) == 0)
+            continue;
+
+        std::array<size_t, 256> starts{};
+        for (const auto key : keys)
+            ++starts[(key >> shift) & 0xFF];
+
+        size_t start = 0;
+        for (auto& bucket : starts)
+        {
+            const auto bucketSize = bucket;
+            bucket = start;
+            start += bucketSize;
+        }
+
+        for (size_t i=0; i<count; ++i)
+        {
+            const auto to = starts[(keys[i] >> shift) & 0xFF]++;
+            nextKeys[to] = keys[i];
+            nextOrder[to] = order[i];
+        }
+
+        keys.swap(nextKeys);
+        order.swap(nextOrder);
+    }
+}
+
+//! Sort the positions of tracking list items by a key.
+/*!
+    Items with the same key keep their order in the list.
+
+\param items
+    The tracking list items.
+\param getKey
+    Returns the key of an item.
+\param order
+    Set to the position of each item in the list, in order of their keys.
+\param descending
+    \e true to sort from the largest key to the smallest.
+*/
+template <typename Item, typename GetKey>
+void sortTrackingItems(
+    const std::vector<Item>& items,
+    const GetKey& getKey,
+    std::vector<uint32_t>& order,
+    bool descending = false)
+{
+    order.resize(items.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    radixSortTrackingItems(items, getKey, descending, order);
+}
+
+//! Find the positions of tracking list items by a key the list is sorted by.
+/*!
+    The same as sortTrackingItems(), without sorting.
+
+\param items
+    The tracking list items, sorted by the key.
+\param getKey
+    Returns the key of an item.
+\param descending
+    \e true if the items are sorted from the largest key to the smallest.
+\param order
+    Set to the position of each item in the list, in order of their keys.
+*/
+template <typename Item, typename GetKey>
+void orderSortedTrackingItems(
+    const std::vector<Item>& items,
+    const GetKey& getKey,
+    bool descending,
+    std::vector<uint32_t>& order)
+{
+    const auto count = static_cast<uint32_t>(items.size());
+
+    order.resize(count);
+
+    if (!descending)
+    {
+        std::iota(order.begin(), order.end(), 0u);
+        return;
+    }
+
+    // Take the runs of equal keys from the end, keeping the items of each
+    // run in list order.
+    auto to = order.begin();
+
+    for (auto runEnd=count; runEnd>0; )
+    {
+        auto runStart = runEnd - 1;
+        while (runStart > 0 && getKey(items[runStart - 1]) ==
+            getKey(items[runEnd - 1]))
+            --runStart;
+
+        for (auto index=runStart; index<runEnd; ++index)
+            *to++ = index;
+
+        runEnd = runStart;
+    }
+}
+
+//! Find the positions of tracking list items in order of a key.
+/*!
+\param items
+    The tracking list items.
+\param getKey
+    Returns the key of an item.
+\param isSorted
+    \e true if the items are already sorted by the key.
+\param descending
+    \e true if the items are sorted from the largest key to the smallest.
+\param order
+    Set to the position of each item in the list, in ascending order of
+    their keys.
+*/
+template <typename Item, typename GetKey>
+void indexTrackingItems(
+    const std::vector<Item>& items,
+    const GetKey& getKey,
+    bool isSorted,
+    bool descending,
+    std::vector<uint32_t>& order)
+{
+    if (isSorted)
+        orderSortedTrackingItems(items, getKey, descending, order);
+    else
+        sortTrackingItems(items, getKey, order);
+}
+
+//! Reorder tracking list items.
+/*!
+\param items
+    The tracking list items; reordered.
+\param order
+    The position in the list of each item, in the new order.
+
+\return
+    The first position whose item changed, or the number of items if none
+    did.
+*/
+template <typename Item>
+size_t reorderTrackingItems(
+    std::vector<Item>& items,
+    const std::vector<uint32_t>& order)
+{
+    size_t firstMoved = 0;
+    while (firstMoved < order.size() && order[firstMoved] == firstMoved)
+        ++firstMoved;
+
+    if (firstMoved == order.size())
+        return firstMoved;
+
+    std::vector<Item> reordered;
+    reordered.reserve(items.size());
+
+    for (const auto index : order)
+        reordered.push_back(items[index]);
+
+    items.swap(reordered);
+
+    return firstMoved;
+}
+
+//! Find the tracking list items whose key is in a range.
+/*!
+\param items
+    The tracking list items.
+\param order
+    The position of each item, in order of their keys.
+\param first
+    The smallest key to find.
+\param last
+    The largest key to find.
+\param getKey
+    Returns the key of an item.
+\param accept
+    Returns \e true for each item in the key range to return.
+
+\return
+    The items found, ordered by key, then by position in the list.
+*/
+template <typename Item, typename Key, typename GetKey, typename Accept>
+std::vector<Item> findTrackingItems(
+    const std::vector<Item>& items,
+    const std::vector<uint32_t>& order,
+    const Key& first,
+    const Key& last,
+    const GetKey& getKey,
+    const Accept& accept)
+{
+    const auto begin = std::lower_bound(order.begin(), order.end(), first,
+        [&items, &getKey](uint32_t index, const Key& key) {
+            return getKey(items[index]) < key;
+        });
+    const auto end = std::upper_bound(begin, order.end(), last,
+        [&items, &getKey](const Key& key, uint32_t index) {
+            return key < getKey(items[index]);
+        });
+
+    std::vector<Item> found;
+    found.reserve(static_cast<size_t>(end - begin));
+
+    for (auto iter = begin; iter != end; ++iter)
+        if (accept(items[*iter]))
+            found.push_back(items[*iter]);
+
+    return found;
+}
+
+//! Find the tracking list items with a key.
+/*!
+\param items
+    The tracking list items.
+\param order
+    The position of each item, in order of their keys.
+\param key
+    The key to find.
+\param getKey
+    Returns the key of an item.
+
+\return
+    The items found, in the order of the list.
+*/
+template <typename Item, typename Key, typename GetKey>
+std::vector<Item> findTrackingItems(
+    const std::vector<Item>& items,
+    const std::vector<uint32_t>& order,
+    const Key& key,
+    const GetKey& getKey)
+{
+    return findTrackingItems(items, order, key, key, getKey,
+        [](const Item&) { return true; });
+}
+
+}  // namespace BAG
+
+#endif  // BAG_TRACKINGLISTINDEX_H
+
@@ -0,0 +1,188 @@
+#ifndef BAG_TYPEDSIMPLELAYER_H
+#define BAG_TYPEDSIMPLELAYER_H
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_grid.h"
+#include "bag_layertraits.h"
+#include "bag_simplelayer.h"
+#include "bag_simplelayerdescriptor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace BAG {
+
+//! A simple layer whose type is known at compile time.
+/*!
+    This reads and writes the elements of the layer as
+    LayerTraits<LT>::value_type, rather than as bytes.  The layer itself is
+    still available, through getLayer(), for the dynamic Layer interface.
+
+\tparam LT
+    The type of simple layer; one with a LayerTraits specialization.
+*/
+template <LayerType LT>
+class TypedSimpleLayer final
+{
+public:
+    //! The compile time description of the layer.
+    using Traits = LayerTraits<LT>;
+    //! The type of the elements in memory.
+    using value_type = typename Traits::value_type;
+
+    //! Constructor.
+    /*!
+        A LayerNotFound exception is thrown if the dataset does not have the
+        layer.
+
+    \param dataset
+        The BAG Dataset the layer belongs to.
+    */
+    explicit TypedSimpleLayer(Dataset& dataset)
+        : m_pLayer(dataset.getSimpleLayer(LT))
+    {
+        if (!m_pLayer)
+            throw LayerNotFound{};
+    }
+
+    //! Constructor.
+    /*!
+        An InvalidLayerId exception is thrown if the layer is not of type LT.
+
+    \param pLayer
+        The simple layer.
+    */
+    explicit TypedSimpleLayer(std::shared_ptr<SimpleLayer> pLayer)
+        : m_pLayer(std::move(pLayer))
+    {
+        if (!m_pLayer)
+            throw LayerNotFound{};
+
+        if (m_pLayer->getDescriptor()->getLayerType() != LT)
+            throw InvalidLayerId{};
+    }
+
+    //! Retrieve the value of an empty node.
+    static constexpr value_type getNullValue() noexcept
+    {
+        return Traits::getNullValue();
+    }
+
+    //! Is the value that of an empty node?
+    static constexpr bool isNull(
+        value_type value) noexcept
+    {
+        return Traits::isNull(value);
+    }
+
+    //! Retrieve the layer.
+    SimpleLayer& getLayer() & noexcept
+    {
+        return *m_pLayer;
+    }
+
+    //! Retrieve the layer.
+    const SimpleLayer& getLayer() const & noexcept
+    {
+        return *m_pLayer;
+    }
+
+    //! Read a section of the layer.
+    /*!
+        See Layer::readAs(); the elements are read without conversion.
+
+    \param rowStart
+        The starting row.
+    \param columnStart
+        The starting column.
+    \param rowEnd
+        The ending row (inclusive).
+    \param columnEnd
+        The ending column (inclusive).
+
+    \return
+        The elements read.
+    */
+    Grid<value_type> read(
+        uint32_t rowStart,
+        uint32_t columnStart,
+        uint32_t rowEnd,
+        uint32_t columnEnd) const
+    {
+        return m_pLayer->template readAs<value_type>(rowStart, columnStart,
+            rowEnd, columnEnd);
+    }
+
+    //! Read a section of the layer into a buffer.
+    /*!
+        See Layer::readInto().
+
+    \param rowStart
+        The starting row.
+    \param columnStart
+        The starting column.
+    \param rowEnd
+        The ending row (inclusive).
+    \param columnEnd
+        The ending column (inclusive).
+    \param buffer
+        Where to read the elements to.
+    \param bufferSize
+        The number of elements buffer holds.
+    \param rowStride
+        The distance, in elements, between the start of two rows in buffer;
+        0 if the rows are packed.
+    */
+    void readInto(
+        uint32_t rowStart,
+        uint32_t columnStart,
+        uint32_t rowEnd,
+        uint32_t columnEnd,
+        value_type* buffer,
+        size_t bufferSize,
+        size_t rowStride = 0) const
+    {
+        m_pLayer->readInto(rowStart, columnStart, rowEnd, columnEnd,
+            reinterpret_cast<uint8_t*>(buffer),
+            bufferSize * sizeof(value_type), rowStride * sizeof(value_type));
+    }
+
+    //! Write a section of the layer.
+    /*!
+        See Layer::write().
+
+    \param rowStart
+        The starting row.
+    \param columnStart
+        The starting column.
+    \param rowEnd
+        The ending row (inclusive).
+    \param columnEnd
+        The ending column (inclusive).
+    \param buffer
+        The elements to write, row by row.
+    */
+    void write(
+        uint32_t rowStart,
+        uint32_t columnStart,
+        uint32_t rowEnd,
+        uint32_t columnEnd,
+        const value_type* buffer)
+    {
+        m_pLayer->write(rowStart, columnStart, rowEnd, columnEnd,
+            reinterpret_cast<const uint8_t*>(buffer));
+    }
+
+private:
+    //! The layer.
+    std::shared_ptr<SimpleLayer> m_pLayer;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_TYPEDSIMPLELAYER_H
+
@@ -2,6 +2,7 @@
 #define BAG_TYPES_H
 
 #include "bag_c_types.h"
+#include "bag_fordec.h"
 
 #include <memory>
 #include <limits>
@@ -9,6 +10,11 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <utility>
+
+#ifdef BAG_USE_MPI
+#include <mpi.h>
+#endif
 
 
 namespace BAG
@@ -20,10 +26,17 @@ constexpr static int kRank = 2;
 //! An invalid layer id.
 constexpr static uint32_t kInvalidLayerId = std::numeric_limits<uint32_t>::max();
 
+//! The tile size used when iterating over a layer that is not chunked.
+constexpr static uint32_t kDefaultTileSize = 100;
+
 //! The types of data
 using DataType = BAG_DATA_TYPE;
 //! The types of layers.
 using LayerType = BAG_LAYER_TYPE;
+//! The arrangement of layers read together.
+using LayerLayout = BAG_LAYER_LAYOUT;
+//! How refinements are combined when resampling a variable resolution BAG.
+using VRResampleMethod = BAG_VR_RESAMPLE_METHOD;
 //! The group types.
 using GroupType = BAG_GROUP_TYPE;
 //! The open mode when opening a BAG.
@@ -31,6 +44,8 @@ using OpenMode = BAG_OPEN_MODE;
 
 //! The type of item in a tracking list.
 using TrackingItem = BagTrackingItem;
+//! A node of a simple layer and its value.
+using LayerCell = BagCell;
 
 using VerticalDatumCorrections = BagVerticalDatumCorrections;
 using VerticalDatumCorrectionsGridded = BagVerticalDatumCorrectionsGridded;
@@ -77,6 +92,1053 @@ inline bool operator==(const RecordDefinition &lhs, const RecordDefinition &rhs)
 
 using GeorefMetadataProfile = GEOREF_METADATA_PROFILE;
 
+//! The settings of an HDF5 raw data chunk cache.
+struct ChunkCacheOptions final
+{
+    //! The size of the chunk cache in bytes; 0 uses the HDF5 default.
+    size_t size = 0;
+    //! The number of chunk slots in the chunk cache; 0 uses the HDF5 default.
+    size_t slots = 0;
+    //! The chunk preemption policy (0 to 1); negative uses the HDF5 default.
+    double preemption = -1.0;
+};
+
+//! How the chunks of a new layer are shaped.
+enum class ChunkLayout
+{
+    //! Chunks of ChunkShape::rows by ChunkShape::columns.
+    Tiled,
+    //! Strips of whole rows, for reading or writing a row at a time.
+    RowMajorScan,
+    //! Picked from the dimensions of the grid and the size of an element.
+    Auto,
+};
+
+//! The shape of the chunks of a new layer.
+struct ChunkShape final
+{
+    //! How the chunks are shaped.
+    ChunkLayout layout = ChunkLayout::Tiled;
+    //! The rows in a chunk; 0 does not chunk a Tiled layer, and picks the
+    //! rows of a RowMajorScan layer from the width of the grid.
+    uint64_t rows = 0;
+    //! The columns in a Tiled chunk; 0 is the same as rows.
+    uint64_t columns = 0;
+};
+
+//! The HDF5 id of the deflate (gzip) filter, built into every HDF5 library.
+constexpr static int kDeflateFilter = 1;
+//! The registered HDF5 ids of some compression filters loaded from plugins.
+constexpr static int kBloscFilter = 32001;
+constexpr static int kLz4Filter = 32004;
+constexpr static int kBitshuffleFilter = 32008;
+constexpr static int kZstdFilter = 32015;
+
+//! How the bytes of the elements are rearranged before compressing them.
+enum class ShuffleMode
+{
+    //! Not rearranged.
+    None,
+    //! Byte shuffling, with the shuffle filter built into HDF5.
+    Byte,
+    //! Bit shuffling, with the bitshuffle filter plugin.
+    Bit,
+};
+
+//! The compression of a new layer.
+/*!
+    Any HDF5 filter may be used if it is built in or its plugin can be
+    found; readers decompress them through the HDF5 filter pipeline.
+*/
+struct CompressionSpec final
+{
+    CompressionSpec() = default;
+    //! Deflate compression at a level; not explicit, so a level converts.
+    CompressionSpec(int deflateLevel) noexcept
+        : level(deflateLevel)
+    {}
+    CompressionSpec(int inFilter, int inLevel,
+        ShuffleMode inShuffle = ShuffleMode::None,
+        std::vector<unsigned int> inParameters = {})
+        : filter(inFilter)
+        , level(inLevel)
+        , shuffle(inShuffle)
+        , parameters(std::move(inParameters))
+    {}
+
+    //! Is any compression filter used?
+    bool isCompressed() const noexcept
+    {
+        return filter > 0 && (filter != kDeflateFilter || level > 0);
+    }
+
+    //! The HDF5 id of the compression filter; 0 does not compress.
+    int filter = kDeflateFilter;
+    //! The compression level; 0 does not compress with deflate.
+    int level = 0;
+    //! How the bytes are rearranged before compressing them.
+    ShuffleMode shuffle = ShuffleMode::None;
+    //! The parameters passed to a filter other than deflate; the level is
+    //! passed if there are none.
+    std::vector<unsigned int> parameters;
+};
+
+inline bool operator==(
+    const CompressionSpec& lhs,
+    const CompressionSpec& rhs) noexcept
+{
+    return lhs.filter == rhs.filter &&
+        lhs.level == rhs.level &&
+        lhs.shuffle == rhs.shuffle &&
+        lhs.parameters == rhs.parameters;
+}
+
+//! How the values of a new simple layer are quantized before they are stored.
+/*!
+    A quantized layer is stored with the HDF5 scale-offset filter, which
+    rounds each value to a number of decimal digits and packs the values of a
+    chunk into as few bits as they need, before any compression.  Null values
+    are kept exactly.  Readers get the rounded values through the HDF5 filter
+    pipeline.
+*/
+struct Quantization final
+{
+    //! Are the values quantized?
+    bool isQuantized() const noexcept
+    {
+        return absErrorBound > 0.;
+    }
+
+    //! The largest difference allowed between a value written and the value
+    //! stored; 0 does not quantize.
+    double absErrorBound = 0.;
+};
+
+inline bool operator==(
+    const Quantization& lhs,
+    const Quantization& rhs) noexcept
+{
+    return lhs.absErrorBound == rhs.absErrorBound;
+}
+
+//! How the nodes of a simple layer are combined into the nodes of an overview.
+enum class OverviewMethod
+{
+    //! The smallest value.
+    Minimum,
+    //! The mean of the values.
+    Mean,
+    //! The shoalest value; the largest, as elevations are positive up.
+    Shoal,
+};
+
+//! How SimpleLayer::readDecimated() reduces each block of nodes to one.
+enum class DecimationMethod
+{
+    //! The first node of the block.
+    Sample,
+    //! The smallest non null value.
+    Minimum,
+    //! The largest non null value.
+    Maximum,
+    //! The mean of the non null values.
+    Mean,
+};
+
+//! How SimpleLayer::sample() and VRIndex::sample() find the value at a
+//! position.
+enum class SampleMethod
+{
+    //! The value of the nearest node.
+    Nearest,
+    //! Interpolated from the four nodes around the position.  Null nodes are
+    //! left out, and the weights of the rest rescaled.
+    Bilinear,
+};
+
+//! How the file of a new BAG is laid out.
+enum class CreationProfile
+{
+    //! The HDF5 defaults, readable by HDF5 1.8 and later.
+    Default,
+    //! For reading from a cloud object store, readable by HDF5 1.10 and later.
+    //! The file space is allocated in pages, with the metadata gathered in
+    //! pages of its own, so a reader with a page buffer (see
+    //! OpenOptions::pageBufferSize) gets it with a few large requests.  The
+    //! chunks of each layer are indexed by a single fixed array.
+    CloudOptimized,
+    //! The HDF5 defaults, but the storage of a new unchunked simple layer is
+    //! not set to the null value when it is allocated, by its first write;
+    //! for a large layer that is written whole, this about halves the time
+    //! and I/O it takes.  Every node of such a layer must be written, as the
+    //! nodes that are not have no defined value.  A chunked layer allocates
+    //! and fills each chunk only when it is first written, in any profile,
+    //! so chunks that are never written take no space and read as null.
+    NoFill,
+};
+
+//! The order in which the refinements of the supergrid cells of a variable
+//! resolution BAG are stored.
+enum class VRRefinementOrder
+{
+    //! The order of the supergrid cells, row by row.
+    RowMajor,
+    //! The order of the supergrid cells along a Morton (Z order) curve, so
+    //! the refinements of a window of cells lie in a few runs.
+    Morton,
+    //! The order of the supergrid cells along a Hilbert curve; more runs are
+    //! longer than with Morton, as consecutive cells are always neighbours.
+    Hilbert,
+};
+
+//! The expected sizes of the variable resolution layers of a BAG; see
+//! Dataset::createVR().
+struct VRSizeHint final
+{
+    //! The number of refinements expected; also the number of nodes.
+    uint64_t numRefinements = 0;
+    //! The number of variable resolution tracking list items expected.
+    uint64_t numTrackingItems = 0;
+};
+
+//! The settings used to read a BAG named by an s3:// or https:// URL.
+struct RemoteOptions final
+{
+    //! The AWS region of the bucket; it also names the host of s3:// URLs.
+    std::string region;
+    //! The AWS access key id; empty to read anonymously.
+    std::string accessKeyId;
+    //! The AWS secret access key.
+    std::string secretAccessKey;
+};
+
+//! The options used when opening a BAG.
+struct OpenOptions final
+{
+    //! The chunk cache shared by all the layers of the BAG.
+    ChunkCacheOptions chunkCache;
+    //! Layer specific chunk caches, which take precedence over chunkCache.
+    std::unordered_map<LayerType, ChunkCacheOptions> layerChunkCaches;
+    //! Only discover the layers when opening; each layer's HDF5 DataSets,
+    //! min/max attributes and value table are read when it is first accessed,
+    //! so the Dataset's layer getters throw if a layer then fails to open.
+    bool lazy = false;
+    //! Only read the dimensions, corners, resolution and reference systems
+    //! from the XML metadata when opening, for the descriptor; the rest of
+    //! it is parsed when Dataset::getMetadata() is first called.
+    bool deferMetadata = false;
+    //! Allow the BAG to be shared by several threads that read from it.
+    //! Only valid with BAG_OPEN_READONLY; see Dataset::lockReads().
+    bool concurrentReads = false;
+    //! How a BAG named by a URL is read.
+    RemoteOptions remote;
+    //! The size, in bytes, of the HDF5 page buffer, which keeps whole file
+    //! space pages so nearby small reads (such as those of the metadata when
+    //! opening) cost one fetch; 0 does not use one.  Only BAGs written with
+    //! paged file space have pages; others are opened without it.
+    size_t pageBufferSize = 0;
+    //! Count the reads and writes of each layer, and time them; see
+    //! Dataset::getIoStats().
+    bool collectIoStats = false;
+#ifdef BAG_USE_MPI
+    //! The processes opening the BAG together through the MPI-IO driver, to
+    //! write disjoint windows of its simple layers collectively; every one
+    //! of them must make the same calls.  MPI_COMM_NULL opens it in this
+    //! process alone.  It must be a local file, without a page buffer or
+    //! concurrent reads.
+    MPI_Comm communicator = MPI_COMM_NULL;
+#endif
+};
+
+//! The I/O counters of a layer, or of several added together.
+/*!
+    The times are wall clock seconds.  The time spent in the library's own
+    code is readSeconds less selectionSeconds, hdf5ReadSeconds and
+    decompressSeconds.  Reads the library makes of a layer for its own use,
+    such as by a VRIndex, add to the phase times but not to numReads.
+*/
+struct IoStats final
+{
+    //! The number of read() and readInto() calls.
+    uint64_t numReads = 0;
+    //! The number of write() calls.
+    uint64_t numWrites = 0;
+    //! The bytes the reads returned.
+    uint64_t bytesRequested = 0;
+    //! The bytes the writes were given.
+    uint64_t bytesWritten = 0;
+    //! The bytes of whole chunks decompressed by the library's parallel
+    //! reads; chunks HDF5 decompresses itself are not seen.
+    uint64_t bytesDecompressed = 0;
+    //! The chunks the reads overlapped.
+    uint64_t chunksRead = 0;
+    //! The chunks the writes overlapped.
+    uint64_t chunksWritten = 0;
+    //! The number of times the attributes (such as min/max) were written.
+    uint64_t numAttributeWrites = 0;
+    //! The time spent in reads.
+    double readSeconds = 0.;
+    //! The time spent in writes, including any attribute writes they made.
+    double writeSeconds = 0.;
+    //! The time spent writing attributes.
+    double attributeSeconds = 0.;
+    //! The time reads spent selecting hyperslabs of the HDF5 DataSets.
+    double selectionSeconds = 0.;
+    //! The time reads spent in HDF5 reading (and decompressing) data.
+    double hdf5ReadSeconds = 0.;
+    //! The time reads spent decompressing chunks on several threads.
+    double decompressSeconds = 0.;
+
+    //! Add the counters of another layer.
+    IoStats& operator+=(const IoStats& other) noexcept
+    {
+        numReads += other.numReads;
+        numWrites += other.numWrites;
+        bytesRequested += other.bytesRequested;
+        bytesWritten += other.bytesWritten;
+        bytesDecompressed += other.bytesDecompressed;
+        chunksRead += other.chunksRead;
+        chunksWritten += other.chunksWritten;
+        numAttributeWrites += other.numAttributeWrites;
+        readSeconds += other.readSeconds;
+        writeSeconds += other.writeSeconds;
+        attributeSeconds += other.attributeSeconds;
+        selectionSeconds += other.selectionSeconds;
+        hdf5ReadSeconds += other.hdf5ReadSeconds;
+        decompressSeconds += other.decompressSeconds;
+
+        return *this;
+    }
+};
+
+//! The I/O counters of one layer of a BAG.
+struct LayerIoStats final
+{
+    //! The type of the layer.
+    LayerType type = UNKNOWN_LAYER_TYPE;
+    //! The name of the layer.
+    std::string name;
+    //! The counters.
+    IoStats stats;
+};
+
+//! The I/O counters of a BAG; see Dataset::getIoStats().
+struct DatasetIoStats final
+{
+    //! The counters of all the layers added together.
+    IoStats total;
+    //! The counters of each layer that has been opened, in layer id order.
+    std::vector<LayerIoStats> layers;
+    //! The hit rate (0 to 1) of the HDF5 metadata cache, which holds the
+    //! chunk indexes among other things.  HDF5 does not count the hits of
+    //! its raw data chunk cache.
+    double metadataCacheHitRate = 0.;
+    //! The accesses served by the HDF5 page buffer, if there is one.
+    uint64_t pageBufferHits = 0;
+    //! The accesses the HDF5 page buffer had to fetch, if there is one.
+    uint64_t pageBufferMisses = 0;
+};
+
+//! Whether an access recorded in an access trace read or wrote.
+enum class AccessKind : uint8_t
+{
+    //! A read of a window of a layer.
+    Read,
+    //! A write of a window of a layer.
+    Write,
+};
+
+//! A layer whose accesses were recorded in an access trace.
+struct AccessTraceLayer final
+{
+    //! The type of the layer.
+    LayerType type = UNKNOWN_LAYER_TYPE;
+    //! The name of the layer.
+    std::string name;
+    //! The number of rows of the grid.
+    uint32_t numRows = 0;
+    //! The number of columns of the grid.
+    uint32_t numColumns = 0;
+    //! The size of a value, in bytes.
+    uint8_t elementSize = 0;
+    //! The rows of a chunk of the layer when traced; 0 if not chunked.
+    uint32_t chunkRows = 0;
+    //! The columns of a chunk of the layer when traced; 0 if not chunked.
+    uint32_t chunkColumns = 0;
+};
+
+//! A read or write of a window of a layer, recorded in an access trace.
+struct AccessTraceRecord final
+{
+    //! When the access began, in nanoseconds since the trace started.
+    uint64_t startNanoseconds = 0;
+    //! How long the access took, in nanoseconds.
+    uint64_t durationNanoseconds = 0;
+    //! The layer accessed; an index into AccessTrace::layers.
+    uint32_t layer = 0;
+    //! Whether the window was read or written.
+    AccessKind kind = AccessKind::Read;
+    //! The starting row.
+    uint32_t rowStart = 0;
+    //! The starting column.
+    uint32_t columnStart = 0;
+    //! The ending row (inclusive).
+    uint32_t rowEnd = 0;
+    //! The ending column (inclusive).
+    uint32_t columnEnd = 0;
+};
+
+//! The accesses recorded by Dataset::startAccessTrace(); see
+//! loadAccessTrace().
+struct AccessTrace final
+{
+    //! The layers accessed, in the order they were first accessed.
+    std::vector<AccessTraceLayer> layers;
+    //! The accesses, in the order they ended.
+    std::vector<AccessTraceRecord> records;
+};
+
+//! A chunk shape and chunk cache size to replay the accesses of a layer
+//! against; see replayAccessTrace().
+struct ReplayCandidate final
+{
+    //! The rows of a chunk; 0, with chunkColumns, for a contiguous layer.
+    uint32_t chunkRows = 0;
+    //! The columns of a chunk.
+    uint32_t chunkColumns = 0;
+    //! The size of the chunk cache, in bytes; 0 for the HDF5 default of
+    //! 1 MiB.
+    size_t cacheSize = 0;
+};
+
+//! The estimated cost of the accesses of a layer with a candidate chunk
+//! shape and chunk cache size.
+struct ReplayResult final
+{
+    //! The chunk shape and cache size replayed.
+    ReplayCandidate candidate;
+    //! The number of reads and writes replayed.
+    uint64_t numAccesses = 0;
+    //! The bytes the accesses read or wrote.
+    uint64_t bytesRequested = 0;
+    //! The chunks read and decoded because they were not in the cache,
+    //! including those partly overwritten.
+    uint64_t chunksDecoded = 0;
+    //! The bytes of the chunks decoded, uncompressed; the bytes read from the
+    //! file are this times the compression ratio of the layer.
+    uint64_t bytesDecoded = 0;
+    //! The chunk lookups found in the cache, over all chunk lookups (0 to 1).
+    double cacheHitRate = 0.;
+};
+
+//! The settings recommendLayout() suggests for a layer.
+struct LayoutRecommendation final
+{
+    //! The layer; an index into AccessTrace::layers.
+    uint32_t layer = 0;
+    //! The chunk shape to create the layer with; see
+    //! Dataset::createSimpleLayer().
+    ChunkShape chunkShape;
+    //! The chunk cache to open the layer with; see
+    //! OpenOptions::layerChunkCaches.
+    ChunkCacheOptions chunkCache;
+    //! The estimated cost of the accesses with these settings.
+    ReplayResult estimate;
+    //! The estimated cost of the accesses with the chunk shape the layer was
+    //! traced with, and the HDF5 default chunk cache.
+    ReplayResult traced;
+};
+
+//! The memory held by a BAG; see Dataset::getMemoryUsage().
+/*!
+    The sizes are estimates, in bytes, of the memory the library holds for
+    the BAG.  The releasable parts are caches that are rebuilt from the file
+    when next needed; see Dataset::releaseCaches() and MemoryBudget.
+*/
+struct DatasetMemoryUsage final
+{
+    //! The parsed metadata, estimated by the size of its XML.
+    uint64_t metadata = 0;
+    //! The items of the tracking list.
+    uint64_t trackingList = 0;
+    //! The items of the variable resolution tracking list.
+    uint64_t vrTrackingList = 0;
+    //! The values of the georeferenced metadata layers opened, and the
+    //! records decoded from them.
+    uint64_t valueTables = 0;
+    //! The tracking list items, sorted by each key; releasable.
+    uint64_t trackingListIndexes = 0;
+    //! The variable resolution tracking list items, sorted by each key, and
+    //! grouped by node; releasable.
+    uint64_t vrTrackingListIndexes = 0;
+    //! The whole VRMetadata layer, as used by VRIndex and VRResampler;
+    //! releasable.
+    uint64_t vrMetadataTable = 0;
+    //! The surface correctors, and the index over irregularly spaced ones;
+    //! releasable.
+    uint64_t correctors = 0;
+    //! The most the HDF5 raw data chunk caches of the opened layers may hold.
+    //! HDF5 does not report how much of them is in use.
+    uint64_t chunkCaches = 0;
+    //! The HDF5 metadata cache.
+    uint64_t metadataCache = 0;
+
+    //! The bytes held by the caches Dataset::releaseCaches() releases.
+    uint64_t getReleasable() const noexcept
+    {
+        return trackingListIndexes + vrTrackingListIndexes + vrMetadataTable +
+            correctors;
+    }
+
+    //! The bytes held altogether.
+    uint64_t getTotal() const noexcept
+    {
+        return metadata + trackingList + vrTrackingList + valueTables +
+            this->getReleasable() + chunkCaches + metadataCache;
+    }
+};
+
+//! What the TileCache has done; see TileCache::getStats().
+struct TileCacheStats final
+{
+    //! The tiles found in the cache.
+    uint64_t hits = 0;
+    //! The tiles looked for, but not found.
+    uint64_t misses = 0;
+    //! The tiles dropped to keep within the limit.
+    uint64_t evictions = 0;
+    //! The tiles dropped because their part of a layer was written.
+    uint64_t invalidations = 0;
+};
+
+//! How copyDataset() copies a BAG.
+struct CopyOptions final
+{
+    //! Rechunk the grid layers with chunkShape, rather than keep the chunks
+    //! of the source.
+    bool rechunk = false;
+    //! The shape of the chunks of the copied layers, if rechunk is set.
+    ChunkShape chunkShape;
+    //! Recompress the layers with compression, rather than keep the
+    //! compression of the source.
+    bool recompress = false;
+    //! The compression of the copied layers, if recompress is set.
+    CompressionSpec compression;
+    //! How the copy is laid out.
+    CreationProfile profile = CreationProfile::Default;
+    //! The order the refinements of a variable resolution BAG are packed
+    //! in.
+    VRRefinementOrder refinementOrder = VRRefinementOrder::RowMajor;
+    //! The first row of the window of the grid to copy.
+    uint32_t rowStart = 0;
+    //! The first column of the window of the grid to copy.
+    uint32_t columnStart = 0;
+    //! The last row of the window (inclusive); clipped to the grid.
+    uint32_t rowEnd = std::numeric_limits<uint32_t>::max();
+    //! The last column of the window (inclusive); clipped to the grid.
+    uint32_t columnEnd = std::numeric_limits<uint32_t>::max();
+    //! Copy the nodes inside the box from (minX, minY) to (maxX, maxY), in
+    //! the horizontal reference system of the BAG, rather than the window.
+    bool useGeoWindow = false;
+    //! The west edge of the box.
+    double minX = 0.;
+    //! The south edge of the box.
+    double minY = 0.;
+    //! The east edge of the box.
+    double maxX = 0.;
+    //! The north edge of the box.
+    double maxY = 0.;
+    //! Follows the progress of the copy, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! The file format of an export.
+enum class ExportFormat
+{
+    //! A single band, tiled, Cloud Optimized GeoTIFF of 32 bit floats, with
+    //! internal overviews.
+    GeoTIFF,
+    //! A directory of raw tiles of 32 bit floats, named
+    //! <tile row>_<tile column>.f32 with tile row 0 the northern most.
+    RawTiles,
+};
+
+//! The settings used to export a layer as a raster.
+struct ExportOptions final
+{
+    //! The file format.
+    ExportFormat format = ExportFormat::GeoTIFF;
+    //! The rows and columns in a tile; a multiple of 16.
+    uint32_t tileSize = 256;
+    //! The deflate level of the GeoTIFF tiles, from 0 (none) to 9.
+    int compressionLevel = 6;
+    //! Add overviews to the GeoTIFF, each half the resolution of the one
+    //! before, until one fits in a tile.
+    bool buildOverviews = true;
+    //! How the nodes are combined into the nodes of the overviews.
+    OverviewMethod overviewMethod = OverviewMethod::Mean;
+    //! Follows the progress of the export, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! What SimpleLayer::computeStatistics() computes, and from which nodes.
+struct StatsOptions final
+{
+    //! The first row of the window of the layer to use.
+    uint32_t rowStart = 0;
+    //! The first column of the window.
+    uint32_t columnStart = 0;
+    //! The last row of the window (inclusive); clipped to the layer.
+    uint32_t rowEnd = std::numeric_limits<uint32_t>::max();
+    //! The last column of the window (inclusive); clipped to the layer.
+    uint32_t columnEnd = std::numeric_limits<uint32_t>::max();
+    //! The number of bins of the histogram; 0 for none.
+    uint32_t numBins = 0;
+    //! The lower edge of the histogram.  If it is not below histogramMax,
+    //! the histogram spans the min/max of the layer (see
+    //! LayerDescriptor::getMinMax()).
+    double histogramMin = 0.;
+    //! The upper edge of the histogram.
+    double histogramMax = 0.;
+    //! The percentiles to estimate, each from 0 to 100.
+    std::vector<double> percentiles;
+    //! The compression of the t-digest the percentiles are estimated from;
+    //! the larger, the more accurate and the slower.
+    double digestCompression = 100.;
+    //! Also write the statistics as attributes of the layer.
+    bool writeAttributes = false;
+    //! Follows the progress of the statistics, and cancels them; may be
+    //! null.
+    ProgressToken* progress = nullptr;
+};
+
+//! The statistics of the non null nodes of a simple layer.
+struct LayerStatistics final
+{
+    //! The number of non null nodes.
+    uint64_t count = 0;
+    //! The number of null nodes.
+    uint64_t nullCount = 0;
+    //! The smallest value; NaN if there are no non null nodes.
+    double min = std::numeric_limits<double>::quiet_NaN();
+    //! The largest value.
+    double max = std::numeric_limits<double>::quiet_NaN();
+    //! The mean.
+    double mean = std::numeric_limits<double>::quiet_NaN();
+    //! The (population) standard deviation.
+    double standardDeviation = std::numeric_limits<double>::quiet_NaN();
+    //! The lower edge of the histogram.
+    double histogramMin = 0.;
+    //! The upper edge of the histogram.
+    double histogramMax = 0.;
+    //! The number of values in each bin of the histogram; values outside it
+    //! are not counted.
+    std::vector<uint64_t> histogram;
+    //! The estimated value of each of StatsOptions::percentiles.
+    std::vector<double> percentiles;
+};
+
+//! The affine transform between the grid of a BAG and geographic
+//! locations.
+/*!
+    A node at (row, column) is at X = originX + row * xSpacing and
+    Y = originY + column * ySpacing.
+*/
+struct GridTransform final
+{
+    //! The X of node (0, 0).
+    double originX = 0.;
+    //! The Y of node (0, 0).
+    double originY = 0.;
+    //! The distance in X between two nodes.
+    double xSpacing = 0.;
+    //! The distance in Y between two nodes.
+    double ySpacing = 0.;
+};
+
+//! How Dataset::readGeo() reads an area.
+struct GeoReadOptions final
+{
+    //! The arrangement of the layers read.
+    LayerLayout layout = BAG_LAYOUT_PLANAR;
+    //! Grow the area read to whole chunks (those of the first layer), so no
+    //! chunk is read in part.
+    bool wholeChunks = false;
+};
+
+//! How diffLayers() compares two layers.
+struct DiffOptions final
+{
+    //! A node has changed if its values differ by more than this.
+    double threshold = 0.;
+    //! Skip the tiles whose chunks are stored byte for byte the same in both
+    //! layers, rather than read and compare their nodes.
+    bool skipIdenticalChunks = true;
+    //! Follows the progress of the comparison, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! A region of the first layer of diffLayers() where nodes changed.
+struct DiffRegion final
+{
+    //! The first row of the region, in the grid of the first layer.
+    uint32_t rowStart = 0;
+    //! The first column of the region.
+    uint32_t columnStart = 0;
+    //! The last row of the region (inclusive).
+    uint32_t rowEnd = 0;
+    //! The last column of the region (inclusive).
+    uint32_t columnEnd = 0;
+    //! The number of nodes in the region that changed, were added or were
+    //! removed.
+    uint64_t numChanged = 0;
+    //! The largest absolute difference of a node in the region that is not
+    //! null in either layer; 0 if there is none.
+    double maxChange = 0.;
+};
+
+//! The differences between two layers found by diffLayers().
+/*!
+    Differences are the value in the second layer less the value in the
+    first.
+*/
+struct LayerDiff final
+{
+    //! The first row of the nodes the layers share, in the grid of the
+    //! first layer.
+    uint32_t rowStart = 0;
+    //! The first column of the shared nodes.
+    uint32_t columnStart = 0;
+    //! The last row of the shared nodes (inclusive).
+    uint32_t rowEnd = 0;
+    //! The last column of the shared nodes (inclusive).
+    uint32_t columnEnd = 0;
+    //! The number of shared nodes not null in either layer.
+    uint64_t count = 0;
+    //! The number of those that differ by more than the threshold.
+    uint64_t numChanged = 0;
+    //! The number of shared nodes only null in the first layer.
+    uint64_t numAdded = 0;
+    //! The number of shared nodes only null in the second layer.
+    uint64_t numRemoved = 0;
+    //! The smallest difference; NaN if count is 0.
+    double min = std::numeric_limits<double>::quiet_NaN();
+    //! The largest difference.
+    double max = std::numeric_limits<double>::quiet_NaN();
+    //! The mean difference.
+    double mean = std::numeric_limits<double>::quiet_NaN();
+    //! The root mean square of the differences.
+    double rms = std::numeric_limits<double>::quiet_NaN();
+    //! The (population) standard deviation of the differences.
+    double standardDeviation = std::numeric_limits<double>::quiet_NaN();
+    //! The changed regions, at most one per tile of the first layer, in row
+    //! major order of the tiles.
+    std::vector<DiffRegion> regions;
+    //! The number of tiles skipped because their chunks are the same in both
+    //! layers.
+    uint32_t numIdenticalChunks = 0;
+};
+
+//! What Dataset::verify() checks.
+struct VerifyOptions final
+{
+    //! Check the values of the layers, not only that their chunks decode.
+    bool checkValues = true;
+    //! Follows the progress of the verification, and cancels it; may be
+    //! null.
+    ProgressToken* progress = nullptr;
+};
+
+//! What is wrong with a chunk found by Dataset::verify().
+enum class VerifyProblem
+{
+    //! HDF5 could not read the chunk.
+    Unreadable,
+    //! The Fletcher32 checksum of the chunk does not match its contents.
+    ChecksumMismatch,
+    //! The chunk does not decompress to the size of a chunk.
+    DecompressionFailed,
+    //! A value that is not null is outside the minimum and maximum of its
+    //! layer, or is NaN.
+    ValueOutOfRange,
+    //! A key of a georeferenced metadata layer has no record in its value
+    //! table.
+    KeyOutOfRange,
+    //! The refinements of a variable resolution cell run past the end of
+    //! the VRRefinements layer.
+    IndexOutOfRange,
+};
+
+//! A chunk found wrong by Dataset::verify().
+struct ChunkProblem final
+{
+    //! The path of the HDF5 DataSet.
+    std::string path;
+    //! The first element of the chunk, in each dimension of the DataSet.
+    std::vector<uint64_t> offset;
+    //! What is wrong.
+    VerifyProblem problem = VerifyProblem::Unreadable;
+    //! The number of values of the chunk that are wrong; 0 if the chunk
+    //! could not be read.
+    uint64_t numValues = 0;
+    //! A description of the problem, naming the first wrong value.
+    std::string message;
+};
+
+//! The outcome of Dataset::verify().
+struct VerifyReport final
+{
+    //! Was nothing found wrong?
+    bool isValid() const noexcept
+    {
+        return problems.empty();
+    }
+
+    //! The number of HDF5 DataSets verified.
+    uint64_t numDataSets = 0;
+    //! The number of chunks read.  The rows of an unchunked DataSet are
+    //! read in bands, each counted as a chunk.
+    uint64_t numChunks = 0;
+    //! The number of chunks never written, which read as the fill value.
+    uint64_t numUnallocatedChunks = 0;
+    //! The problems, by DataSet in the order they are found, then by chunk.
+    std::vector<ChunkProblem> problems;
+};
+
+//! What Dataset::hashChunks() does with the hashes.
+struct ChunkHashOptions final
+{
+    //! Keep the hashes in the BAG, replacing any kept before, so
+    //! Dataset::readChunkHashes() returns them.  The BAG must be writable.
+    bool persist = false;
+    //! Follows the progress of the hashing, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! The hash of a chunk of an HDF5 DataSet of a BAG; see
+//! Dataset::hashChunks().
+struct ChunkHash final
+{
+    //! The path of the HDF5 DataSet.
+    std::string path;
+    //! The first element of the chunk, in each dimension of the DataSet.
+    std::vector<uint64_t> offset;
+    //! The number of bytes hashed.
+    uint64_t size = 0;
+    //! The filters skipped when the chunk was stored; see H5Dread_chunk().
+    uint32_t filterMask = 0;
+    //! Was the chunk hashed as stored, compressed?  If not, its elements
+    //! were read through HDF5 and hashed; see Dataset::hashChunks().
+    bool stored = true;
+    //! The 64 bit xxHash of the bytes.
+    uint64_t hash = 0;
+};
+
+//! How a chunk differs between two BAGs; see diffChunkHashes().
+enum class ChunkChange
+{
+    //! The chunk is only in the second BAG.
+    Added,
+    //! The chunk is only in the first BAG; it was never written in the
+    //! second, so it reads as the fill value.
+    Removed,
+    //! The chunk is in both BAGs, with different bytes.
+    Modified,
+};
+
+//! A chunk that differs between two BAGs; see diffChunkHashes().
+struct ChunkDelta final
+{
+    //! The path of the HDF5 DataSet.
+    std::string path;
+    //! The first element of the chunk, in each dimension of the DataSet.
+    std::vector<uint64_t> offset;
+    //! How the chunk differs.
+    ChunkChange change = ChunkChange::Modified;
+};
+
+//! The layers computeDerivatives() writes its products to.
+/*!
+    Each is a 32 bit float layer with the grid of the elevation layer, or
+    nullptr if the product is not computed.
+*/
+struct DerivativeLayers final
+{
+    //! The slope, in degrees from horizontal.
+    SimpleLayer* slope = nullptr;
+    //! The direction the slope faces, in degrees clockwise from grid north;
+    //! null where the surface is flat.
+    SimpleLayer* aspect = nullptr;
+    //! The surface lit by the sun, from 0 (in shadow) to 255.
+    SimpleLayer* hillshade = nullptr;
+    //! The ratio of the area of the surface to its planar area; 1 where it
+    //! is flat.
+    SimpleLayer* rugosity = nullptr;
+};
+
+//! How computeDerivatives() computes its products.
+struct DerivativeOptions final
+{
+    //! The distance, in nodes, of the neighbours of a node used; the products
+    //! of a larger radius are of a coarser scale.
+    uint32_t radius = 1;
+    //! The elevations are multiplied by this, to bring them to the units of
+    //! the grid spacing.
+    double zFactor = 1.;
+    //! The direction of the sun for the hillshade, in degrees clockwise from
+    //! grid north.
+    double sunAzimuth = 315.;
+    //! The elevation of the sun above the horizon, in degrees.
+    double sunElevation = 45.;
+    //! Follows the progress of the computation, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! The levels traceContours() traces.
+/*!
+    The levels are those listed, or if none are, every multiple of the
+    interval from the base.
+*/
+struct ContourOptions final
+{
+    //! The distance between levels, if none are listed.
+    double interval = 0.;
+    //! A level, if the levels are a multiple of the interval apart.
+    double base = 0.;
+    //! The levels; in any order.
+    std::vector<double> levels;
+    //! Follows the progress of the tracing, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! A vertex of a contour line.
+struct ContourPoint final
+{
+    //! The position east, in the units of the grid spacing.
+    double x = 0.;
+    //! The position north.
+    double y = 0.;
+};
+
+//! A contour line traced by traceContours().
+struct ContourLine final
+{
+    //! The level of the line.
+    double level = 0.;
+    //! Whether the line is a ring; its last vertex is then its first.
+    bool closed = false;
+    //! The vertices, with the nodes at or above the level on the right.
+    std::vector<ContourPoint> points;
+};
+
+//! A ring of the outline of the nodes of a layer that are not null; see
+//! SimpleLayer::getFootprint().
+struct FootprintRing final
+{
+    //! Whether the ring bounds a hole in the nodes; its vertices then run
+    //! clockwise, and counterclockwise otherwise.
+    bool hole = false;
+    //! The vertices, on the edges of the nodes; the last is the first.
+    std::vector<ContourPoint> points;
+};
+
+//! How mosaicDatasets() picks the value of a node covered by several
+//! sources.
+enum class MosaicRule
+{
+    //! The source with the highest priority.
+    Priority,
+    //! The most recent source.
+    Newest,
+    //! The source with the lowest uncertainty at the node.
+    LowestUncertainty,
+};
+
+//! A BAG mosaicked by mosaicDatasets().
+struct MosaicSource final
+{
+    //! The name of the BAG; simple or variable resolution.
+    std::string fileName;
+    //! The priority of the source; the higher, the more it is preferred.
+    int priority = 0;
+    //! The date of the source, as an ISO 8601 date (YYYY-MM-DD); empty to
+    //! use the date stamp of its metadata.
+    std::string date;
+};
+
+//! The grid of a mosaic made by mosaicDatasets(), and how it is made.
+struct MosaicOptions final
+{
+    //! The X of the south west node.
+    double originX = 0.;
+    //! The Y of the south west node.
+    double originY = 0.;
+    //! The distance between two columns.
+    double resolutionX = 1.;
+    //! The distance between two rows.
+    double resolutionY = 1.;
+    //! The number of rows; row 0 is the southern most.
+    uint32_t rows = 0;
+    //! The number of columns.
+    uint32_t columns = 0;
+    //! How a node covered by several sources is picked.  Sources of equal
+    //! rank are preferred by priority, then in the order they are listed.
+    MosaicRule rule = MosaicRule::Priority;
+    //! How variable resolution sources are resampled onto the grid.
+    VRResampleMethod vrMethod = BAG_VR_RESAMPLE_NEAREST;
+    //! The shape of the chunks of the mosaic.
+    ChunkShape chunkShape{ChunkLayout::Tiled, 100, 100};
+    //! The compression of the mosaic.
+    CompressionSpec compression = 5;
+    //! Follows the progress of the mosaic, and cancels it; may be null.
+    ProgressToken* progress = nullptr;
+};
+
+//! How a Catalog finds and opens the BAGs it indexes.
+struct CatalogOptions final
+{
+    //! The extensions of the files indexed in a directory, compared without
+    //! regard to case.
+    std::vector<std::string> extensions{".bag"};
+    //! Also index the files in the subdirectories of a directory.
+    bool recursive = true;
+    //! How BAGs named by a URL are read.
+    RemoteOptions remote;
+    //! Follows the progress of adding a directory, and cancels it; may be
+    //! null.
+    ProgressToken* progress = nullptr;
+};
+
+//! How a DatasetPool keeps BAGs open.
+struct DatasetPoolOptions final
+{
+    //! The most BAGs kept open; 0 for no limit.
+    size_t maxDatasets = 64;
+    //! The most memory, in bytes, the BAGs kept open may hold, as given by
+    //! Dataset::getMemoryUsage(); 0 for no limit.
+    uint64_t maxBytes = 0;
+    //! How the BAGs are opened; they are always opened read only, with
+    //! concurrentReads set.
+    OpenOptions openOptions;
+    //! How often, in milliseconds, a background thread checks whether the
+    //! files of the BAGs kept open changed, and reopens those that did; 0 to
+    //! only check when a BAG is acquired.
+    uint32_t reopenInterval = 0;
+};
+
+//! What a DatasetPool has done; see DatasetPool::getStats().
+struct DatasetPoolStats final
+{
+    //! The acquisitions of a BAG already open.
+    uint64_t hits = 0;
+    //! The acquisitions that opened a BAG.
+    uint64_t misses = 0;
+    //! The BAGs opened again because their files changed.
+    uint64_t reopens = 0;
+    //! The BAGs closed to keep within the limits.
+    uint64_t evictions = 0;
+};
+
 //! A default layer name for each layer.
 const std::unordered_map<LayerType, std::string> kLayerTypeMapString {
     {Elevation, "Elevation"},
@@ -0,0 +1,184 @@
+
+#include "bag_uint8array.h"
+
+#include <array>
+#include <vector>
+
+
+namespace BAG {
+
+namespace {
+
+//! Buffers smaller than this are not pooled; allocating them is cheap.
+constexpr size_t kMinPooledSize = 4 * 1024;
+//! Buffers larger than this are not pooled.
+constexpr size_t kMaxPooledSize = 64 * 1024 * 1024;
+//! The most buffers of one size kept by a thread.
+constexpr size_t kMaxPooledBuffers = 4;
+//! The most bytes of buffers kept by a thread.
+constexpr size_t kMaxPooledBytes = 128 * 1024 * 1024;
+
+//! The buffers a thread has freed, to reuse, by size class (a power of 2).
+class BufferPool final
+{
+public:
+    BufferPool() = default;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+
+    ~BufferPool() noexcept
+    {
+        for (const auto& buffers : m_buffers)
+            for (auto* buffer : buffers)
+                delete[] buffer;
+
+        destroyed = true;
+    }
+
+    BufferPool& operator=(const BufferPool&) = delete;
+    BufferPool& operator=(BufferPool&&) = delete;
+
+    //! Retrieve an uninitialized buffer.
+    /*!
+    \param sizeClass
+        The size class of the buffer.
+
+    \return
+        The buffer, of 2^sizeClass bytes.
+    */
+    uint8_t* acquire(
+        size_t sizeClass)
+    {
+        auto& buffers = m_buffers[sizeClass];
+        if (buffers.empty())
+            return new uint8_t[size_t{1} << sizeClass];
+
+        auto* buffer = buffers.back();
+        buffers.pop_back();
+        m_numBytes -= size_t{1} << sizeClass;
+
+        return buffer;
+    }
+
+    //! Keep a buffer for reuse, or free it if the pool is full.
+    /*!
+    \param buffer
+        The buffer.
+    \param sizeClass
+        The size class of the buffer.
+    */
+    void release(
+        uint8_t* buffer,
+        size_t sizeClass) noexcept
+    {
+        const auto capacity = size_t{1} << sizeClass;
+        auto& buffers = m_buffers[sizeClass];
+
+        if (buffers.size() < kMaxPooledBuffers &&
+            m_numBytes + capacity <= kMaxPooledBytes)
+        {
+            try
+            {
+                buffers.push_back(buffer);
+                m_numBytes += capacity;
+                return;
+            }
+            catch(...)
+            {}
+        }
+
+        delete[] buffer;
+    }
+
+    //! Has the pool of this thread been destroyed (the thread is exiting)?
+    static thread_local bool destroyed;
+
+private:
+    //! The buffers, by size class.
+    std::array<std::vector<uint8_t*>, 64> m_buffers;
+    //! The total size of the buffers.
+    size_t m_numBytes = 0;
+};
+
+thread_local bool BufferPool::destroyed = false;
+
+//! Retrieve the pool of this thread.
+/*!
+\return
+    The pool of this thread.
+*/
+BufferPool& getPool()
+{
+    static thread_local BufferPool pool;
+
+    return pool;
+}
+
+//! Determine the size class of a buffer.
+/*!
+\param len
+    The size of the buffer, in bytes.
+
+\return
+    The smallest power of 2 that holds len bytes.
+*/
+size_t getSizeClass(
+    size_t len) noexcept
+{
+    size_t sizeClass = 0;
+    while ((size_t{1} << sizeClass) < len)
+        ++sizeClass;
+
+    return sizeClass;
+}
+
+}  // namespace
+
+//! Free a buffer, or return it to the pool of the thread.
+/*!
+\param ptr
+    The buffer.
+*/
+void UInt8ArrayDeleter::operator()(
+    uint8_t* ptr) const noexcept
+{
+    if (!ptr)
+        return;
+
+    if (capacity == 0 || BufferPool::destroyed)
+    {
+        delete[] ptr;
+        return;
+    }
+
+    getPool().release(ptr, getSizeClass(capacity));
+}
+
+//! Create an array whose contents are not initialized.
+/*!
+    Meant for buffers that are about to be overwritten, such as by an HDF5
+    read.  Buffers of the same size are reused by the thread that frees them,
+    so reading the same window size repeatedly does not allocate.  A
+    released() buffer can still be freed with delete[].
+
+\param len
+    The size of the array, in bytes.
+
+\return
+    The array.
+*/
+UInt8Array UInt8Array::uninitialized(
+    size_t len)
+{
+    if (len < kMinPooledSize || len > kMaxPooledSize || BufferPool::destroyed)
+        return {new uint8_t[len], len, UInt8ArrayDeleter{}};
+
+    const auto sizeClass = getSizeClass(len);
+
+    return {getPool().acquire(sizeClass), len,
+        UInt8ArrayDeleter{size_t{1} << sizeClass}};
+}
+
+}  // namespace BAG
+
@@ -1,6 +1,9 @@
 #ifndef BAG_UINT8ARRAY_H
 #define BAG_UINT8ARRAY_H
 
+#include "bag_config.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
@@ -9,15 +12,26 @@
 namespace BAG
 {
 
+//! Frees the buffer of a UInt8Array, or returns it to the pool of the thread.
+struct BAG_API UInt8ArrayDeleter final
+{
+    void operator()(uint8_t* ptr) const noexcept;
+
+    //! The size of the pooled buffer; 0 if it is not pooled.
+    size_t capacity = 0;
+};
+
 //! Class to get past SWIG not being able to handle std::unique_ptr<uint8_t[]>.
 class UInt8Array final
 {
 public:
     UInt8Array() = default;
     explicit UInt8Array(size_t len)
-        : m_array(std::make_unique<uint8_t[]>(len)), m_len(len)
+        : m_array(new uint8_t[len]()), m_len(len)
     {}
 
+    BAG_API static UInt8Array uninitialized(size_t len);
+
     UInt8Array(const UInt8Array&) = delete;
     UInt8Array(UInt8Array&&) = default;
 
@@ -86,7 +100,11 @@ public:
     }
 
 private:
-    std::unique_ptr<uint8_t[]> m_array;
+    UInt8Array(uint8_t* array, size_t len, UInt8ArrayDeleter deleter) noexcept
+        : m_array(array, deleter), m_len(len)
+    {}
+
+    std::unique_ptr<uint8_t[], UInt8ArrayDeleter> m_array;
     size_t m_len = 0;
 };
 
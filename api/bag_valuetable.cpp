@@ -9,6 +9,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdlib>  // free
+#include <cstring>  // memcpy, strlen
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <H5Cpp.h>
 
 
@@ -16,71 +22,9 @@ namespace BAG {
 
 namespace {
 
-//! Convert a chunk of memory and a definition into a Record.
-/*!
-\param buffer
-    A chunk of memory representing a Record for a georeferenced metadata layer.
-\param definition
-    The definition of the Record for a georeferenced metadata layer.
-
-\return
-    A georeferenced metadata layer record using the buffer and definition.
-*/
-Record convertMemoryToRecord(
-    const uint8_t* const buffer,
-    const RecordDefinition& definition)
-{
-    if (!buffer)
-        return {};
-
-    Record record;
-    record.reserve(definition.size());
-
-    size_t fieldOffset = 0;
-
-    for (const auto& field : definition)
-    {
-        const auto fieldType = static_cast<DataType>(field.type);
-        CompoundDataType value;
-        const char* str = nullptr;
-
-        switch(fieldType)
-        {
-        case DT_BOOLEAN:
-            value = *reinterpret_cast<const bool*>(buffer + fieldOffset);
-            break;
-        case DT_FLOAT32:
-            value = *reinterpret_cast<const float*>(buffer + fieldOffset);
-            break;
-        case DT_UINT32:
-            value = *reinterpret_cast<const uint32_t*>(buffer + fieldOffset);
-            break;
-        case DT_STRING:
-        {
-            const auto address =
-                *reinterpret_cast<const std::uintptr_t*>(buffer + fieldOffset);
-            str = reinterpret_cast<const char*>(address);
-            value = std::string{str ? str : ""};
-
-            // Clean up the char* allocated by HDF reading.
-            free(const_cast<char*>(str));
-            break;
-        }
-        case DT_UINT8:  //[[fallthrough]]
-        case DT_UINT16:  //[[fallthrough]]
-        case DT_UINT64:  //[[fallthrough]]
-        case DT_COMPOUND:  //[[fallthrough]]
-        case DT_UNKNOWN_DATA_TYPE:  //[[fallthrough]]
-        default:
-            throw UnsupportedDataType{};
-        }
-
-        record.emplace_back(value);
-        fieldOffset += Layer::getElementSize(fieldType);
-    }
-
-    return record;
-}
+//! The number of records/values an appender writes at once if the HDF5
+//! DataSet is not chunked.
+constexpr hsize_t kDefaultAppendBatchSize = 1024;
 
 //! Convert a Record into a chunk of memory.
 /*!
@@ -128,6 +72,38 @@ void convertRecordToMemory(
     }
 }
 
+//! Split keys into runs of the same key.
+/*!
+\param keys
+    The keys.
+\param numKeys
+    The number of keys.
+
+\return
+    Each run, as its key and length.
+*/
+template <typename T>
+std::vector<std::pair<uint64_t, size_t>> findKeyRuns(
+    const uint8_t* keys,
+    size_t numKeys)
+{
+    std::vector<std::pair<uint64_t, size_t>> runs;
+
+    const auto* typedKeys = reinterpret_cast<const T*>(keys);
+
+    for (size_t i=0; i<numKeys; ++i)
+    {
+        const uint64_t key = typedKeys[i];
+
+        if (!runs.empty() && runs.back().first == key)
+            ++runs.back().second;
+        else
+            runs.emplace_back(key, 1);
+    }
+
+    return runs;
+}
+
 }  // namespace
 
 //! Constructor.
@@ -139,6 +115,9 @@ ValueTable::ValueTable(
     const GeorefMetadataLayer& layer)
     : m_layer(layer)
 {
+    const TraceScope trace{"ValueTable::ValueTable",
+        m_layer.getDescriptor()->getName().c_str()};
+
     // Read the Records DataSet.
     const auto& h5valueDataSet = m_layer.getValueDataSet();
 
@@ -148,18 +127,31 @@ ValueTable::ValueTable(
     if (numDims != 1)
         throw InvalidValueSize{};
 
-    m_records.resize(numRecords);
+    const auto& definition = m_layer.m_descriptor.getDefinition();
+
+    m_columns.resize(definition.size());
+    m_indexes.resize(definition.size());
+    for (size_t fieldIndex=0; fieldIndex<definition.size(); ++fieldIndex)
+        m_columns[fieldIndex].type =
+            static_cast<DataType>(definition[fieldIndex].type);
+
+    if (numRecords == 0)
+        return;
 
     if (numRecords == 1)  // No user defined records.
+    {
+        // The no data value record holds default values.
+        const size_t recordSize = getRecordSize(definition);
+        const std::vector<uint8_t> noDataRecord(recordSize, 0);
+
+        this->appendToColumns(noDataRecord.data());
+
         return;
+    }
 
     constexpr hsize_t startIndex = 0;
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &numRecords, &startIndex);
 
-    auto pDescriptor = std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-        m_layer.getDescriptor());
-    const auto& definition = pDescriptor->getDefinition();
-
     const size_t recordSize = getRecordSize(definition);
     std::vector<uint8_t> buffer(recordSize * numRecords, 0);
 
@@ -169,15 +161,30 @@ ValueTable::ValueTable(
 
     h5valueDataSet.read(buffer.data(), memDataType, memDataSpace, fileDataSpace);
 
-    // Convert the raw memory into Records.
-    size_t rawIndex = 0;
-
-    for (auto& record : m_records)
+    for (auto& column : m_columns)
     {
-        record = convertMemoryToRecord(buffer.data() + (rawIndex * recordSize),
-            definition);
-        ++rawIndex;
+        switch (column.type)
+        {
+        case DT_FLOAT32:
+            column.floats.reserve(numRecords);
+            break;
+        case DT_UINT32:
+            column.uint32s.reserve(numRecords);
+            break;
+        case DT_BOOLEAN:
+            column.bools.reserve(numRecords);
+            break;
+        case DT_STRING:
+            column.strings.reserve(numRecords);
+            break;
+        default:
+            throw UnsupportedDataType{};
+        }
     }
+
+    // Move the raw memory into the columns.
+    for (size_t rawIndex=0; rawIndex<numRecords; ++rawIndex)
+        this->appendToColumns(buffer.data() + (rawIndex * recordSize));
 }
 
 //! Add a record/value to the end of the list.
@@ -194,10 +201,32 @@ size_t ValueTable::addRecord(
     if (!this->validateRecord(record))
         throw InvalidValue{};
 
-    const auto newKey = m_records.size();
+    const auto newKey = m_numRecords;
     this->writeRecord(newKey, record);
 
-    m_records.emplace_back(record);
+    this->appendToColumns(record);
+
+    return newKey;
+}
+
+//! Add a record/value to the end of the list, taking ownership of it.
+/*!
+    The record/value is kept as the decoded copy, so reading it back does
+    not decode it again.
+
+\param record
+    The record/value.
+
+\return
+    The index of the added record.
+*/
+size_t ValueTable::addRecord(
+    Record&& record)
+{
+    const auto newKey = this->addRecord(static_cast<const Record&>(record));
+
+    m_records[newKey] = std::move(record);
+    m_isDecoded[newKey] = true;
 
     return newKey;
 }
@@ -207,140 +236,923 @@ size_t ValueTable::addRecord(
 \param records
     The records/values.
 */
-void ValueTable::addRecords(
-    const Records& records)
+void ValueTable::addRecords(
+    const Records& records)
+{
+    if (records.empty())
+        return;
+
+    const bool allValid = std::all_of(cbegin(records), cend(records),
+        [this](const auto& record) {
+            return this->validateRecord(record);
+        });
+    if (!allValid)
+        throw InvalidValue{};
+
+    this->writeRecords(records);
+
+    for (const auto& record : records)
+        this->appendToColumns(record);
+}
+
+//! Add multiple records/values to the end of the list, taking ownership of them.
+/*!
+    The records/values are kept as the decoded copies, so reading them back
+    does not decode them again.
+
+\param records
+    The records/values.
+*/
+void ValueTable::addRecords(
+    Records&& records)
+{
+    const auto firstKey = m_numRecords;
+
+    this->addRecords(static_cast<const Records&>(records));
+
+    for (size_t i=0; i<records.size(); ++i)
+    {
+        m_records[firstKey + i] = std::move(records[i]);
+        m_isDecoded[firstKey + i] = true;
+    }
+
+    records.clear();
+}
+
+//! Add multiple records/values to the end of the list on an executor.
+/*!
+    The records/values are added after the asynchronous operations on the
+    Dataset submitted before, and before those submitted after.  The Dataset
+    is kept open until they are added.
+
+\param records
+    The records/values.
+\param executor
+    The executor to add them on.
+
+\return
+    Ready once they are added, or with the exception addRecords() threw.
+*/
+std::future<void> ValueTable::addRecordsAsync(
+    Records records,
+    Executor& executor)
+{
+    const auto pDataset = m_layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Some std::packaged_task need a copyable function, so the records are
+    // shared.  Holding the Dataset, which owns the table, keeps it alive.
+    auto pRecords = std::make_shared<Records>(std::move(records));
+
+    return executor.submit(pDataset.get(), [this, pDataset, pRecords]() {
+        this->addRecords(std::move(*pRecords));
+    });
+}
+
+//! Copy a string into the string arena.
+/*!
+\param str
+    The string; \e nullptr is treated as an empty string.
+
+\return
+    The offset of the string in the arena.
+*/
+size_t ValueTable::addString(
+    const char* str)
+{
+    const auto offset = m_strings.size();
+
+    if (str)
+        m_strings.insert(m_strings.end(), str, str + std::strlen(str));
+
+    m_strings.push_back('\0');
+
+    return offset;
+}
+
+//! Add a record/value to the end of the columns.
+/*!
+\param record
+    The record/value; it must match the definition.
+*/
+void ValueTable::appendToColumns(
+    const Record& record)
+{
+    for (size_t fieldIndex=0; fieldIndex<m_columns.size(); ++fieldIndex)
+    {
+        auto& column = m_columns[fieldIndex];
+        const auto& value = record[fieldIndex];
+
+        switch (column.type)
+        {
+        case DT_FLOAT32:
+            column.floats.push_back(value.asFloat());
+            break;
+        case DT_UINT32:
+            column.uint32s.push_back(value.asUInt32());
+            break;
+        case DT_BOOLEAN:
+            column.bools.push_back(value.asBool() ? 1 : 0);
+            break;
+        case DT_STRING:
+            column.strings.push_back(this->addString(value.asString().c_str()));
+            break;
+        default:
+            throw UnsupportedDataType{};
+        }
+    }
+
+    ++m_numRecords;
+    m_records.emplace_back();
+    m_isDecoded.push_back(false);
+
+    for (size_t fieldIndex=0; fieldIndex<m_indexes.size(); ++fieldIndex)
+        this->addToIndex(m_numRecords - 1, fieldIndex);
+}
+
+//! Add a record/value read from the HDF5 DataSet to the end of the columns.
+/*!
+    The strings allocated by HDF5 while reading are freed.
+
+\param buffer
+    The record/value, laid out as described by the definition.
+*/
+void ValueTable::appendToColumns(
+    const uint8_t* buffer)
+{
+    size_t fieldOffset = 0;
+
+    for (auto& column : m_columns)
+    {
+        switch (column.type)
+        {
+        case DT_FLOAT32:
+            column.floats.push_back(
+                *reinterpret_cast<const float*>(buffer + fieldOffset));
+            break;
+        case DT_UINT32:
+            column.uint32s.push_back(
+                *reinterpret_cast<const uint32_t*>(buffer + fieldOffset));
+            break;
+        case DT_BOOLEAN:
+            column.bools.push_back(
+                *reinterpret_cast<const bool*>(buffer + fieldOffset) ? 1 : 0);
+            break;
+        case DT_STRING:
+        {
+            const auto address =
+                *reinterpret_cast<const std::uintptr_t*>(buffer + fieldOffset);
+            auto* str = reinterpret_cast<char*>(address);
+
+            column.strings.push_back(this->addString(str));
+
+            // Clean up the char* allocated by HDF reading.
+            free(str);
+            break;
+        }
+        default:
+            throw UnsupportedDataType{};
+        }
+
+        fieldOffset += Layer::getElementSize(column.type);
+    }
+
+    ++m_numRecords;
+    m_records.emplace_back();
+    m_isDecoded.push_back(false);
+
+    for (size_t fieldIndex=0; fieldIndex<m_indexes.size(); ++fieldIndex)
+        this->addToIndex(m_numRecords - 1, fieldIndex);
+}
+
+//! Store a value in the columns.
+/*!
+\param key
+    The record key.
+\param fieldIndex
+    The index of the field.
+\param value
+    The value; it must match the type of the field.
+*/
+void ValueTable::setColumnValue(
+    size_t key,
+    size_t fieldIndex,
+    const CompoundDataType& value)
+{
+    this->removeFromIndex(key, fieldIndex);
+
+    auto& column = m_columns[fieldIndex];
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        column.floats[key] = value.asFloat();
+        break;
+    case DT_UINT32:
+        column.uint32s[key] = value.asUInt32();
+        break;
+    case DT_BOOLEAN:
+        column.bools[key] = value.asBool() ? 1 : 0;
+        break;
+    case DT_STRING:
+        // The old string stays in the arena until the table is reloaded.
+        column.strings[key] = this->addString(value.asString().c_str());
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+
+    this->addToIndex(key, fieldIndex);
+}
+
+//! Add a record/value to the index of a field.
+/*!
+    Does nothing if the field is not indexed, or for the no data value record.
+
+\param key
+    The record key.
+\param fieldIndex
+    The index of the field.
+*/
+void ValueTable::addToIndex(
+    size_t key,
+    size_t fieldIndex)
+{
+    auto* pIndex = m_indexes[fieldIndex].get();
+    if (!pIndex || key == 0)
+        return;
+
+    const auto& column = m_columns[fieldIndex];
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        pIndex->sorted.emplace(column.floats[key], key);
+        break;
+    case DT_UINT32:
+        pIndex->integers[column.uint32s[key]].push_back(key);
+        pIndex->sorted.emplace(column.uint32s[key], key);
+        break;
+    case DT_BOOLEAN:
+        pIndex->integers[column.bools[key]].push_back(key);
+        break;
+    case DT_STRING:
+        pIndex->strings[m_strings.data() + column.strings[key]].push_back(key);
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Remove a record/value from the index of a field.
+/*!
+    Does nothing if the field is not indexed, or for the no data value record.
+
+\param key
+    The record key.
+\param fieldIndex
+    The index of the field.
+*/
+void ValueTable::removeFromIndex(
+    size_t key,
+    size_t fieldIndex)
+{
+    auto* pIndex = m_indexes[fieldIndex].get();
+    if (!pIndex || key == 0)
+        return;
+
+    const auto eraseKey = [key](auto& map, const auto& value) {
+        auto found = map.find(value);
+        if (found == map.end())
+            return;
+
+        auto& keys = found->second;
+        keys.erase(std::remove(keys.begin(), keys.end(), key), keys.end());
+
+        if (keys.empty())
+            map.erase(found);
+    };
+
+    const auto eraseSorted = [key, pIndex](double value) {
+        auto range = pIndex->sorted.equal_range(value);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (iter->second == key)
+            {
+                pIndex->sorted.erase(iter);
+                return;
+            }
+        }
+    };
+
+    const auto& column = m_columns[fieldIndex];
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        eraseSorted(column.floats[key]);
+        break;
+    case DT_UINT32:
+        eraseKey(pIndex->integers, column.uint32s[key]);
+        eraseSorted(column.uint32s[key]);
+        break;
+    case DT_BOOLEAN:
+        eraseKey(pIndex->integers, column.bools[key]);
+        break;
+    case DT_STRING:
+        eraseKey(pIndex->strings,
+            std::string{m_strings.data() + column.strings[key]});
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Decode a value from the columns.
+/*!
+\param key
+    The record key.
+\param fieldIndex
+    The index of the field.
+
+\return
+    The value.
+*/
+CompoundDataType ValueTable::decodeValue(
+    size_t key,
+    size_t fieldIndex) const
+{
+    const auto& column = m_columns[fieldIndex];
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        return CompoundDataType{column.floats[key]};
+    case DT_UINT32:
+        return CompoundDataType{column.uint32s[key]};
+    case DT_BOOLEAN:
+        return CompoundDataType{column.bools[key] != 0};
+    case DT_STRING:
+        return CompoundDataType{std::string{m_strings.data() +
+            column.strings[key]}};
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Decode a record/value from the columns.
+/*!
+\param key
+    The record key.
+
+\return
+    The record/value.
+*/
+Record ValueTable::decodeRecord(
+    size_t key) const
+{
+    Record record;
+    record.reserve(m_columns.size());
+
+    for (size_t fieldIndex=0; fieldIndex<m_columns.size(); ++fieldIndex)
+        record.emplace_back(this->decodeValue(key, fieldIndex));
+
+    return record;
+}
+
+//! Retrieve a record/value, decoding it the first time.
+/*!
+\param key
+    The record key.
+
+\return
+    The decoded record/value.
+*/
+const Record& ValueTable::getDecodedRecord(
+    size_t key) const
+{
+    const auto pDataset = m_layer.getDataset().lock();
+    const auto lock = pDataset ? pDataset->lockReads()
+        : std::unique_lock<std::recursive_mutex>{};
+
+    if (!m_isDecoded[key])
+    {
+        m_records[key] = this->decodeRecord(key);
+        m_isDecoded[key] = true;
+    }
+
+    return m_records[key];
+}
+
+//! Look up the values of some fields for many keys.
+/*!
+    The field indices are found once, and each run of the same key is looked
+    up once.
+
+\param keys
+    The keys.
+\param keyType
+    The type of the keys.
+    Supported types are: DT_UINT8, DT_UINT16, DT_UINT32, DT_UINT64.
+\param numKeys
+    The number of keys.
+\param fieldNames
+    The fields to look up.
+
+\return
+    The values, one column per field in the order of fieldNames.
+    Key 0 resolves to the no data value record.
+*/
+std::vector<ResolvedColumn> ValueTable::resolve(
+    const uint8_t* keys,
+    DataType keyType,
+    size_t numKeys,
+    const std::vector<std::string>& fieldNames) const
+{
+    std::vector<std::pair<uint64_t, size_t>> runs;
+
+    switch (keyType)
+    {
+    case DT_UINT8:
+        runs = findKeyRuns<uint8_t>(keys, numKeys);
+        break;
+    case DT_UINT16:
+        runs = findKeyRuns<uint16_t>(keys, numKeys);
+        break;
+    case DT_UINT32:
+        runs = findKeyRuns<uint32_t>(keys, numKeys);
+        break;
+    case DT_UINT64:
+        runs = findKeyRuns<uint64_t>(keys, numKeys);
+        break;
+    default:
+        throw UnsupportedDataType{};
+    }
+
+    for (const auto& run : runs)
+        if (run.first >= m_numRecords)
+            throw ValueNotFound{};
+
+    std::vector<ResolvedColumn> resolved;
+    resolved.reserve(fieldNames.size());
+
+    for (const auto& name : fieldNames)
+    {
+        const auto& column = m_columns[this->getFieldIndex(name)];
+
+        resolved.emplace_back();
+        auto& output = resolved.back();
+        output.name = name;
+        output.type = column.type;
+
+        switch (column.type)
+        {
+        case DT_FLOAT32:
+            output.floats.reserve(numKeys);
+            for (const auto& run : runs)
+                output.floats.insert(output.floats.end(), run.second,
+                    column.floats[run.first]);
+            break;
+        case DT_UINT32:
+            output.uint32s.reserve(numKeys);
+            for (const auto& run : runs)
+                output.uint32s.insert(output.uint32s.end(), run.second,
+                    column.uint32s[run.first]);
+            break;
+        case DT_BOOLEAN:
+            output.bools.reserve(numKeys);
+            for (const auto& run : runs)
+                output.bools.insert(output.bools.end(), run.second,
+                    column.bools[run.first]);
+            break;
+        case DT_STRING:
+            output.strings.reserve(numKeys);
+            for (const auto& run : runs)
+                output.strings.insert(output.strings.end(), run.second,
+                    std::string{m_strings.data() + column.strings[run.first]});
+            break;
+        default:
+            throw UnsupportedDataType{};
+        }
+    }
+
+    return resolved;
+}
+
+//! Convert a record/value to a chunk of memory.
+/*!
+\param record
+    The record/value to convert.
+
+\return
+    A copy of the record/value as a chunk of memory.
+*/
+std::vector<uint8_t> ValueTable::convertRecordToRaw(
+    const Record& record) const
+{
+    const auto& descriptor = m_layer.m_descriptor;
+
+    std::vector<uint8_t> buffer(getRecordSize(descriptor.getDefinition()), 0);
+
+    convertRecordToMemory(record, buffer.data());
+
+    return buffer;
+}
+
+//! Convert multiple records/values to a chunk of memory.
+/*!
+\param records
+    The records/values to convert.
+
+\return
+    A copy of the records/values as a chunk of memory.
+*/
+std::vector<uint8_t> ValueTable::convertRecordsToRaw(
+    const std::vector<Record>& records) const
+{
+    if (records.empty())
+        return {};
+
+    const auto& descriptor = m_layer.m_descriptor;
+
+    const auto recordSize = getRecordSize(descriptor.getDefinition());
+    std::vector<uint8_t> buffer(recordSize * records.size(), 0);
+
+    // Write values into memory.
+    size_t offset = 0;
+
+    for (const auto& record : records)
+    {
+        convertRecordToMemory(record, buffer.data() + offset);
+        offset += recordSize;
+    }
+
+    return buffer;
+}
+
+//! Retrieve the record/value definition.
+/*!
+\return
+    The list of fields that define the record/value.
+*/
+const RecordDefinition& ValueTable::getDefinition() const & noexcept
+{
+    return m_layer.m_descriptor.getDefinition();
+}
+
+//! Retrieve the value of a specific field in a specific record.
+/*!
+\param key
+    The key of the record/value.
+    Must be greater than 0.
+\param name
+    The name of the field.
+
+\return
+    The value specified.
+    An exception is thrown if the key or field name is invalid.
+*/
+const CompoundDataType& ValueTable::getValue(
+    size_t key,
+    const std::string& name) const &
+{
+    if (key == 0 || key >= m_numRecords)
+        throw ValueNotFound{};
+
+    const size_t fieldIndex = this->getFieldIndex(name);
+
+    return this->getValue(key, fieldIndex);
+}
+
+//! Retrieve the value of a specific field in a specific record/value.
+/*!
+\param key
+    The key of the record/value.
+    Must be greater than 0.
+\param fieldIndex
+    The index of the field.
+
+\return
+    The value specified.
+    An exception is thrown if the record index or field index are invalid.
+*/
+const CompoundDataType& ValueTable::getValue(
+    size_t key,
+    size_t fieldIndex) const &
+{
+    if (key == 0 || key >= m_numRecords)
+        throw ValueNotFound{};
+
+    const auto& definition = this->getDefinition();
+    if (fieldIndex >= definition.size())
+        throw FieldNotFound{};
+
+    return this->getDecodedRecord(key)[fieldIndex];
+}
+
+//! Index a field.
+/*!
+    Does nothing if the field is already indexed.
+
+\param fieldName
+    The name of the field.
+*/
+void ValueTable::createIndex(
+    const std::string& fieldName)
+{
+    const auto fieldIndex = this->getFieldIndex(fieldName);
+    if (m_indexes[fieldIndex])
+        return;
+
+    m_indexes[fieldIndex].reset(new FieldIndex);
+
+    for (size_t key=1; key<m_numRecords; ++key)
+        this->addToIndex(key, fieldIndex);
+}
+
+//! Remove the index of a field.
+/*!
+\param fieldName
+    The name of the field.
+*/
+void ValueTable::dropIndex(
+    const std::string& fieldName)
+{
+    m_indexes[this->getFieldIndex(fieldName)].reset();
+}
+
+//! Determine if a field is indexed.
+/*!
+\param fieldName
+    The name of the field.
+
+\return
+    \e true if the field is indexed.
+    \e false otherwise.
+*/
+bool ValueTable::hasIndex(
+    const std::string& fieldName) const
+{
+    return static_cast<bool>(m_indexes[this->getFieldIndex(fieldName)]);
+}
+
+//! Determine if a record/value matches a query.
+/*!
+\param key
+    The record key.
+\param fieldIndex
+    The index of the queried field.
+\param query
+    The query.
+
+\return
+    \e true if the field is between the minimum and maximum of the query.
+    \e false otherwise.
+*/
+bool ValueTable::matches(
+    size_t key,
+    size_t fieldIndex,
+    const ValueQuery& query) const
+{
+    const auto& column = m_columns[fieldIndex];
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        return column.floats[key] >= query.min.asFloat() &&
+            column.floats[key] <= query.max.asFloat();
+    case DT_UINT32:
+        return column.uint32s[key] >= query.min.asUInt32() &&
+            column.uint32s[key] <= query.max.asUInt32();
+    case DT_BOOLEAN:
+        return column.bools[key] >= (query.min.asBool() ? 1 : 0) &&
+            column.bools[key] <= (query.max.asBool() ? 1 : 0);
+    case DT_STRING:
+    {
+        const char* value = m_strings.data() + column.strings[key];
+        return query.min.asString() <= value && value <= query.max.asString();
+    }
+    default:
+        throw UnsupportedDataType{};
+    }
+}
+
+//! Find the records/values matching a query.
+/*!
+    The index of the field is used if it suits the query; otherwise every
+    record/value is tested.  The no data value record never matches.
+
+\param query
+    The query.
+
+\return
+    One flag per key, set if the record/value matches.
+*/
+std::vector<bool> ValueTable::findMatchingKeys(
+    const ValueQuery& query) const
 {
-    if (records.empty())
-        return;
+    const auto fieldIndex = this->getFieldIndex(query.fieldName);
+    const auto type = m_columns[fieldIndex].type;
 
-    const bool allValid = std::all_of(cbegin(records), cend(records),
-        [this](const auto& record) {
-            return this->validateRecord(record);
-        });
-    if (!allValid)
+    if (query.min.getType() != type || query.max.getType() != type)
         throw InvalidValue{};
 
-    this->writeRecords(records);
+    std::vector<bool> matching(m_numRecords, false);
+
+    const auto* pIndex = m_indexes[fieldIndex].get();
+    const bool isSingleValue = query.min == query.max;
+
+    const auto markKeys = [&matching](const auto& map, const auto& value) {
+        const auto found = map.find(value);
+        if (found != map.end())
+            for (const auto key : found->second)
+                matching[key] = true;
+    };
+
+    if (pIndex && isSingleValue && type == DT_STRING)
+        markKeys(pIndex->strings, query.min.asString());
+    else if (pIndex && isSingleValue && type == DT_UINT32)
+        markKeys(pIndex->integers, query.min.asUInt32());
+    else if (pIndex && isSingleValue && type == DT_BOOLEAN)
+        markKeys(pIndex->integers, query.min.asBool() ? 1u : 0u);
+    else if (pIndex && (type == DT_FLOAT32 || type == DT_UINT32))
+    {
+        const double min = type == DT_FLOAT32 ? query.min.asFloat()
+            : query.min.asUInt32();
+        const double max = type == DT_FLOAT32 ? query.max.asFloat()
+            : query.max.asUInt32();
+
+        const auto end = pIndex->sorted.upper_bound(max);
+        for (auto iter = pIndex->sorted.lower_bound(min); iter != end; ++iter)
+            matching[iter->second] = true;
+    }
+    else
+    {
+        for (size_t key=1; key<m_numRecords; ++key)
+            matching[key] = this->matches(key, fieldIndex, query);
+    }
 
-    m_records.insert(end(m_records), cbegin(records), cend(records));
+    return matching;
 }
 
-//! Convert a record/value to a chunk of memory.
+//! Find the keys of the records/values matching a query.
 /*!
-\param record
-    The record/value to convert.
+\param query
+    The query.
 
 \return
-    A copy of the record/value as a chunk of memory.
+    The matching keys, in increasing order.
+    The no data value record never matches.
 */
-std::vector<uint8_t> ValueTable::convertRecordToRaw(
-    const Record& record) const
+std::vector<size_t> ValueTable::findKeys(
+    const ValueQuery& query) const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-            m_layer.getDescriptor());
-
-    std::vector<uint8_t> buffer(getRecordSize(pDescriptor->getDefinition()), 0);
+    const auto matching = this->findMatchingKeys(query);
 
-    convertRecordToMemory(record, buffer.data());
+    std::vector<size_t> keys;
+    for (size_t key=1; key<matching.size(); ++key)
+        if (matching[key])
+            keys.push_back(key);
 
-    return buffer;
+    return keys;
 }
 
-//! Convert multiple records/values to a chunk of memory.
+//! Find the keys of the records/values matching a query on an executor.
 /*!
-\param records
-    The records/values to convert.
+    The query runs after the asynchronous operations on the Dataset
+    submitted before it, so it sees the records/values they add.
+
+\param query
+    The query.
+\param executor
+    The executor to search on.
 
 \return
-    A copy of the records/values as a chunk of memory.
+    The matching keys, in increasing order, or the exception findKeys()
+    threw.
 */
-std::vector<uint8_t> ValueTable::convertRecordsToRaw(
-    const std::vector<Record>& records) const
+std::future<std::vector<size_t>> ValueTable::findKeysAsync(
+    ValueQuery query,
+    Executor& executor) const
 {
-    if (records.empty())
-        return {};
+    const auto pDataset = m_layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Holding the Dataset, which owns the table, keeps it alive.
+    return executor.submit(pDataset.get(),
+        [this, pDataset, query]() {
+            return this->findKeys(query);
+        });
+}
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-            m_layer.getDescriptor());
+//! Find the column of a field, checking the key and type.
+/*!
+\param key
+    The key of the record/value.
+\param fieldIndex
+    The index of the field.
+\param type
+    The type the field must have.
 
-    const auto recordSize = getRecordSize(pDescriptor->getDefinition());
-    std::vector<uint8_t> buffer(recordSize * records.size(), 0);
+\return
+    The column of the field.
+*/
+const ValueTable::Column& ValueTable::getColumn(
+    size_t key,
+    size_t fieldIndex,
+    DataType type) const
+{
+    if (key >= m_numRecords)
+        throw ValueNotFound{};
 
-    // Write values into memory.
-    size_t offset = 0;
+    if (fieldIndex >= m_columns.size())
+        throw FieldNotFound{};
 
-    for (const auto& record : records)
-    {
-        convertRecordToMemory(record, buffer.data() + offset);
-        offset += recordSize;
-    }
+    const auto& column = m_columns[fieldIndex];
+    if (column.type != type)
+        throw InvalidType{};
 
-    return buffer;
+    return column;
 }
 
-//! Retrieve the record/value definition.
+//! Retrieve the value of a float field, without decoding the record/value.
 /*!
+\param key
+    The key of the record/value; 0 is the no data value record.
+\param fieldIndex
+    The index of the field.
+
 \return
-    The list of fields that define the record/value.
+    The value.
+    An exception is thrown if the key or field index are invalid, or the
+    field is not a float.
 */
-const RecordDefinition& ValueTable::getDefinition() const & noexcept
+float ValueTable::getFloat(
+    size_t key,
+    size_t fieldIndex) const
 {
-    return std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-        m_layer.getDescriptor())->getDefinition();
+    return this->getColumn(key, fieldIndex, DT_FLOAT32).floats[key];
 }
 
-//! Retrieve the value of a specific field in a specific record.
+//! Retrieve the value of a 32 bit unsigned integer field, without decoding the record/value.
 /*!
 \param key
-    The key of the record/value.
-    Must be greater than 0.
-\param name
-    The name of the field.
+    The key of the record/value; 0 is the no data value record.
+\param fieldIndex
+    The index of the field.
 
 \return
-    The value specified.
-    An exception is thrown if the key or field name is invalid.
+    The value.
+    An exception is thrown if the key or field index are invalid, or the
+    field is not a 32 bit unsigned integer.
 */
-const CompoundDataType& ValueTable::getValue(
+uint32_t ValueTable::getUInt32(
     size_t key,
-    const std::string& name) const &
+    size_t fieldIndex) const
 {
-    if (key == 0 || key >= m_records.size())
-        throw ValueNotFound{};
+    return this->getColumn(key, fieldIndex, DT_UINT32).uint32s[key];
+}
 
-    const size_t fieldIndex = this->getFieldIndex(name);
+//! Retrieve the value of a boolean field, without decoding the record/value.
+/*!
+\param key
+    The key of the record/value; 0 is the no data value record.
+\param fieldIndex
+    The index of the field.
 
-    return this->getValue(key, fieldIndex);
+\return
+    The value.
+    An exception is thrown if the key or field index are invalid, or the
+    field is not a boolean.
+*/
+bool ValueTable::getBool(
+    size_t key,
+    size_t fieldIndex) const
+{
+    return this->getColumn(key, fieldIndex, DT_BOOLEAN).bools[key] != 0;
 }
 
-//! Retrieve the value of a specific field in a specific record/value.
+//! Retrieve the value of a string field, without decoding the record/value.
 /*!
 \param key
-    The key of the record/value.
-    Must be greater than 0.
+    The key of the record/value; 0 is the no data value record.
 \param fieldIndex
     The index of the field.
 
 \return
-    The value specified.
-    An exception is thrown if the record index or field index are invalid.
+    The value, in the string storage of the value table.  It is only valid
+    until a record/value is added or changed.
+    An exception is thrown if the key or field index are invalid, or the
+    field is not a string.
 */
-const CompoundDataType& ValueTable::getValue(
+const char* ValueTable::getString(
     size_t key,
     size_t fieldIndex) const &
 {
-    if (key == 0 || key >= m_records.size())
-        throw ValueNotFound{};
-
-    const auto& definition = this->getDefinition();
-    if (fieldIndex >= definition.size())
-        throw FieldNotFound{};
-
-    const auto& record = m_records[key];
-
-    return record[fieldIndex];
+    return m_strings.data() +
+        this->getColumn(key, fieldIndex, DT_STRING).strings[key];
 }
 
 //! Retrieve the field index of the named field.
@@ -386,17 +1198,144 @@ const char* ValueTable::getFieldName(
     return definition[index].name;
 }
 
+//! Export the values of one field of every record/value.
+/*!
+    The values are copied straight from the column of the field, without
+    decoding any records/values.
+
+\param fieldIndex
+    The index of the field.
+
+\return
+    The values of the field, starting with the no data value record.
+*/
+ExportedColumn ValueTable::exportColumn(
+    size_t fieldIndex) const
+{
+    if (fieldIndex >= m_columns.size())
+        throw FieldNotFound{};
+
+    const auto& column = m_columns[fieldIndex];
+
+    ExportedColumn exported;
+    exported.name = this->getFieldName(fieldIndex);
+    exported.type = column.type;
+
+    const auto copyValues = [&exported](const void* values, size_t numBytes) {
+        exported.values.resize(numBytes);
+        if (numBytes > 0)
+            std::memcpy(exported.values.data(), values, numBytes);
+    };
+
+    switch (column.type)
+    {
+    case DT_FLOAT32:
+        copyValues(column.floats.data(), column.floats.size() * sizeof(float));
+        break;
+    case DT_UINT32:
+        copyValues(column.uint32s.data(),
+            column.uint32s.size() * sizeof(uint32_t));
+        break;
+    case DT_BOOLEAN:
+        exported.values = column.bools;
+        break;
+    case DT_STRING:
+    {
+        exported.offsets.reserve(column.strings.size() + 1);
+        exported.offsets.push_back(0);
+
+        for (const auto offset : column.strings)
+        {
+            const char* str = m_strings.data() + offset;
+            exported.characters.insert(exported.characters.end(), str,
+                str + std::strlen(str));
+            exported.offsets.push_back(exported.characters.size());
+        }
+        break;
+    }
+    default:
+        throw UnsupportedDataType{};
+    }
+
+    return exported;
+}
+
+//! Export the values of every field of every record/value.
+/*!
+    One column is exported per field, in the order of the definition; see
+    exportColumn().
+
+\return
+    The values of every field.
+*/
+std::vector<ExportedColumn> ValueTable::exportColumns() const
+{
+    std::vector<ExportedColumn> columns;
+    columns.reserve(m_columns.size());
+
+    for (size_t fieldIndex=0; fieldIndex<m_columns.size(); ++fieldIndex)
+        columns.push_back(this->exportColumn(fieldIndex));
+
+    return columns;
+}
+
 //! Retrieve all the records/values.
 /*!
+    Every record/value not decoded yet is decoded.
+
 \return
     All the records/values.
     NOTE!  This includes the no data value record at index 0.
 */
-const Records& ValueTable::getRecords() const & noexcept
+const Records& ValueTable::getRecords() const &
 {
+    for (size_t key=0; key<m_numRecords; ++key)
+        this->getDecodedRecord(key);
+
     return m_records;
 }
 
+//! Retrieve the number of records/values.
+/*!
+\return
+    The number of records/values.
+    NOTE!  This includes the no data value record at index 0.
+*/
+size_t ValueTable::getNumRecords() const noexcept
+{
+    return m_numRecords;
+}
+
+//! Retrieve an estimate of the memory held by the records/values.
+/*!
+    Counts the stored values, the records/values decoded from them, and the
+    field indexes by their keys.
+
+\return
+    The memory held, in bytes.
+*/
+size_t ValueTable::getMemoryUsage() const noexcept
+{
+    size_t bytes = m_strings.capacity();
+
+    for (const auto& column : m_columns)
+        bytes += column.floats.capacity() * sizeof(float) +
+            column.uint32s.capacity() * sizeof(uint32_t) +
+            column.bools.capacity() +
+            column.strings.capacity() * sizeof(size_t);
+
+    bytes += m_records.capacity() * sizeof(Record) + m_isDecoded.capacity() / 8;
+    for (size_t key=0; key<m_records.size(); ++key)
+        if (m_isDecoded[key])
+            bytes += m_records[key].capacity() * sizeof(CompoundDataType);
+
+    for (const auto& pIndex : m_indexes)
+        if (pIndex)
+            bytes += (pIndex->sorted.size() + m_numRecords) * sizeof(size_t);
+
+    return bytes;
+}
+
 //! Set a value in a specific field in a specific record.
 /*!
 \param key
@@ -412,7 +1351,7 @@ void ValueTable::setValue(
     const std::string& name,
     const CompoundDataType& value)
 {
-    if (key == 0 || key >= m_records.size())
+    if (key == 0 || key >= m_numRecords)
         throw ValueNotFound{};
 
     const size_t fieldIndex = this->getFieldIndex(name);
@@ -435,13 +1374,24 @@ void ValueTable::setValue(
     size_t fieldIndex,
     const CompoundDataType& value)
 {
-    if (key == 0 || key >= m_records.size())
+    if (key == 0 || key >= m_numRecords)
         throw ValueNotFound{};
 
-    auto& record = m_records[key];
+    if (fieldIndex >= m_columns.size())
+        throw FieldNotFound{};
+
+    if (value.getType() != m_columns[fieldIndex].type)
+        throw InvalidValue{};
+
+    auto record = this->decodeRecord(key);
     record[fieldIndex] = value;
 
     this->writeRecord(key, record);
+
+    this->setColumnValue(key, fieldIndex, value);
+
+    if (m_isDecoded[key])
+        m_records[key][fieldIndex] = value;
 }
 
 //! Determine if the specified record/value matches the definition used by the value table.
@@ -456,13 +1406,9 @@ void ValueTable::setValue(
 bool ValueTable::validateRecord(
     const Record& record) const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-            m_layer.getDescriptor());
-    if (!pDescriptor)
-        throw InvalidDescriptor{};
+    const auto& descriptor = m_layer.m_descriptor;
 
-    const auto& definition = pDescriptor->getDefinition();
+    const auto& definition = descriptor.getDefinition();
 
     if (record.size() != definition.size())
         return false;
@@ -497,7 +1443,7 @@ void ValueTable::writeRecord(
     size_t key,
     const Record& record)
 {
-    if (key == 0 || key > m_records.size())
+    if (key == 0 || key > m_numRecords)
         throw InvalidValueKey{};
 
     const hsize_t fileRecordIndex = key;
@@ -505,11 +1451,9 @@ void ValueTable::writeRecord(
     // Prepare the memory details.
     const auto rawMemory = this->convertRecordToRaw(record);
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-            m_layer.getDescriptor());
+    const auto& descriptor = m_layer.m_descriptor;
 
-    const auto memDataType = createH5memoryCompType(pDescriptor->getDefinition());
+    const auto memDataType = createH5memoryCompType(descriptor.getDefinition());
 
     constexpr hsize_t one = 1;
     ::H5::DataSpace memDataSpace(1, &one, &one);
@@ -517,10 +1461,11 @@ void ValueTable::writeRecord(
     // Prepare the file details.
     const auto& h5valueDataSet = m_layer.getValueDataSet();
 
-    if (key == m_records.size())
+    if (key == m_numRecords)
     {
         // Make room for a new record.
         const hsize_t newNumRecords = fileRecordIndex + 1;
+        m_layer.checkNumRecords(newNumRecords);
         h5valueDataSet.extend(&newNumRecords);
     }
 
@@ -547,11 +1492,9 @@ void ValueTable::writeRecords(
     // Prepare the memory details.
     const auto rawMemory = this->convertRecordsToRaw(records);
 
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const GeorefMetadataLayerDescriptor>(
-            m_layer.getDescriptor());
+    const auto& descriptor = m_layer.m_descriptor;
 
-    const auto memDataType = createH5memoryCompType(pDescriptor->getDefinition());
+    const auto memDataType = createH5memoryCompType(descriptor.getDefinition());
 
     const hsize_t numRecords = records.size();
     ::H5::DataSpace memDataSpace(1, &numRecords, &numRecords);
@@ -560,18 +1503,201 @@ void ValueTable::writeRecords(
     const auto& h5valueDataSet = m_layer.getValueDataSet();
 
     // Make room for the new records.
-    const hsize_t newNumRecords = m_records.size() + numRecords;
+    const hsize_t newNumRecords = m_numRecords + numRecords;
+    m_layer.checkNumRecords(newNumRecords);
     h5valueDataSet.extend(&newNumRecords);
 
     const auto fileDataSpace = h5valueDataSet.getSpace();
 
     // Specify the key to begin writing to.
-    const hsize_t keyToModify = m_records.size();
+    const hsize_t keyToModify = m_numRecords;
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &numRecords, &keyToModify);
 
     h5valueDataSet.write(rawMemory.data(), memDataType, memDataSpace,
         fileDataSpace);
 }
 
-}  // namespace BAG
+//! Start appending many records/values at once.
+/*!
+\return
+    The appender.  Commit it to add the records/values to the value table.
+*/
+std::unique_ptr<ValueTable::Appender> ValueTable::beginAppend()
+{
+    return std::unique_ptr<Appender>(new Appender{*this});
+}
+
+//! Constructor.
+/*!
+\param table
+    The value table to append to.
+*/
+ValueTable::Appender::Appender(
+    ValueTable& table)
+    : m_table(table)
+{
+    const auto& h5valueDataSet = m_table.m_layer.getValueDataSet();
+
+    hsize_t length = 0, maxLength = 0;
+    const auto numDims = h5valueDataSet.getSpace().getSimpleExtentDims(&length,
+        &maxLength);
+    if (numDims != 1)
+        throw InvalidValueSize{};
+
+    m_extent = length;
+    m_maxExtent = maxLength;
+
+    hsize_t chunkSize = kDefaultAppendBatchSize;
+    const auto h5createPropList = h5valueDataSet.getCreatePlist();
+    if (h5createPropList.getLayout() == H5D_CHUNKED)
+        h5createPropList.getChunk(1, &chunkSize);
+
+    m_batchSize = static_cast<size_t>(std::max<hsize_t>(chunkSize, 1));
+    m_buffer.reserve(m_batchSize);
+}
+
+//! Destructor.
+/*!
+    Discards the records/values if the appender was not committed.  Errors
+    are lost.
+*/
+ValueTable::Appender::~Appender() noexcept
+{
+    if (m_committed)
+        return;
+
+    try
+    {
+        this->resize(m_table.m_numRecords);
+    }
+    catch (...)
+    {
+    }
+}
+
+//! Append a record/value.
+/*!
+\param record
+    The record/value.
+
+\return
+    The key the record/value will have once committed.
+*/
+size_t ValueTable::Appender::addRecord(
+    const Record& record)
+{
+    if (m_committed)
+        throw InvalidValueKey{};
+
+    if (!m_table.validateRecord(record))
+        throw InvalidValue{};
+
+    const auto key = this->size();
+    m_table.m_layer.checkNumRecords(key + 1);
+    if (key >= m_maxExtent)
+        throw InvalidValueKey{};
+
+    m_buffer.push_back(record);
+
+    if (m_buffer.size() == m_batchSize)
+        this->flush();
+
+    return key;
+}
+
+//! Append multiple records/values.
+/*!
+\param records
+    The records/values.
+*/
+void ValueTable::Appender::addRecords(
+    const Records& records)
+{
+    for (const auto& record : records)
+        this->addRecord(record);
+}
+
+//! Write what is buffered and add the records/values to the value table.
+/*!
+    Does nothing if the appender is already committed.
+*/
+void ValueTable::Appender::commit()
+{
+    if (m_committed)
+        return;
+
+    this->flush();
+
+    const auto length = m_table.m_numRecords + m_written.size();
+    if (m_extent != length)
+        this->resize(length);
+
+    m_committed = true;
+
+    for (const auto& record : m_written)
+        m_table.appendToColumns(record);
+
+    m_written.clear();
+}
+
+//! Retrieve the number of records/values the value table will have.
+/*!
+\return
+    The number of records/values, including those appended and the no data
+    value record.
+*/
+size_t ValueTable::Appender::size() const noexcept
+{
+    return m_table.m_numRecords + m_written.size() + m_buffer.size();
+}
+
+//! Write the buffered records/values to the HDF5 DataSet.
+/*!
+    The DataSet is at least doubled whenever it has to grow.
+*/
+void ValueTable::Appender::flush()
+{
+    if (m_buffer.empty())
+        return;
+
+    const hsize_t offset = m_table.m_numRecords + m_written.size();
+    const hsize_t count = m_buffer.size();
+
+    if (offset + count > m_extent)
+        this->resize(std::min<uint64_t>(m_maxExtent,
+            std::max<uint64_t>({offset + count, m_extent * 2, m_batchSize})));
+
+    const auto rawMemory = m_table.convertRecordsToRaw(m_buffer);
+    const auto memDataType = createH5memoryCompType(m_table.getDefinition());
+    const ::H5::DataSpace memDataSpace(1, &count, &count);
+
+    const auto& h5valueDataSet = m_table.m_layer.getValueDataSet();
 
+    const auto fileDataSpace = h5valueDataSet.getSpace();
+    fileDataSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+
+    h5valueDataSet.write(rawMemory.data(), memDataType, memDataSpace,
+        fileDataSpace);
+
+    std::move(m_buffer.begin(), m_buffer.end(), std::back_inserter(m_written));
+    m_buffer.clear();
+}
+
+//! Change the length of the HDF5 DataSet.
+/*!
+\param length
+    The new length.
+*/
+void ValueTable::Appender::resize(
+    uint64_t length)
+{
+    if (length == m_extent)
+        return;
+
+    const hsize_t newLength = length;
+    m_table.m_layer.getValueDataSet().extend(&newLength);
+
+    m_extent = length;
+}
+
+}  // namespace BAG
@@ -4,8 +4,16 @@
 #include "bag_config.h"
 #include "bag_fordec.h"
 #include "bag_compounddatatype.h"
+#include "bag_executor.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 namespace BAG {
@@ -15,7 +23,79 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! The values of one field for a run of georeferenced metadata keys.
+/*!
+    Only the vector matching the type of the field is filled in, with one
+    value per key, in the order of the keys.
+*/
+struct BAG_API ResolvedColumn final
+{
+    //! The name of the field.
+    std::string name;
+    //! The type of the field.
+    DataType type = DT_UNKNOWN_DATA_TYPE;
+    //! The values, if the field is a float.
+    std::vector<float> floats;
+    //! The values, if the field is a 32 bit unsigned integer.
+    std::vector<uint32_t> uint32s;
+    //! The values, if the field is a boolean.
+    std::vector<uint8_t> bools;
+    //! The values, if the field is a string.
+    std::vector<std::string> strings;
+};
+
+//! The values of one field of every record/value, laid out for columnar consumers.
+/*!
+    The values are in key order, starting with the no data value record.
+    Numbers are packed into values in native byte order: 4 byte floats or
+    unsigned integers, or 1 byte booleans.  Strings use the Arrow large
+    string layout: the characters of every value back to back, without null
+    terminators, and the offset of each value into them.
+*/
+struct BAG_API ExportedColumn final
+{
+    //! The name of the field.
+    std::string name;
+    //! The type of the field.
+    DataType type = DT_UNKNOWN_DATA_TYPE;
+    //! The packed values, if the field is not a string.
+    std::vector<uint8_t> values;
+    //! The offset of each string into characters, and the end of the last
+    //! one; one more than the number of values.  Empty if not a string.
+    std::vector<uint64_t> offsets;
+    //! The characters of the strings, if the field is a string.
+    std::vector<char> characters;
+};
+
+//! A query on one field of the records/values in a value table.
+/*!
+    Matches the records/values whose field is between min and max
+    (inclusive).  Set max equal to min to match a single value.  Both must
+    have the type of the field.
+*/
+struct BAG_API ValueQuery final
+{
+    //! The name of the field.
+    std::string fieldName;
+    //! The smallest matching value.
+    CompoundDataType min;
+    //! The largest matching value.
+    CompoundDataType max;
+};
+
 //! The interface for the values of the spatial metadata in the georeferenced metadata layer.
+/*!
+    The values are held by field: one contiguous array per field, with the
+    characters of every string in one shared arena.  Records/values are only
+    turned into CompoundDataTypes when asked for, and are kept once decoded.
+    The typed getters, such as getString(), read the columns directly and
+    never allocate.
+
+    Fields can be indexed to speed up findKeys().  String, unsigned integer
+    and boolean fields get a hash index for matching single values; float
+    and unsigned integer fields get a sorted index for matching ranges.
+    Indexes are kept up to date as records/values are added or changed.
+*/
 class BAG_API ValueTable final
 {
 public:
@@ -28,18 +108,91 @@ public:
     // Don't overload == because there is a circular reference between GeorefMetadataLayer
     //   ValueTable and implementing == on ValueTable causes compilers problems.
 
-    const Records& getRecords() const & noexcept;
+    const Records& getRecords() const &;
+    size_t getNumRecords() const noexcept;
+    size_t getMemoryUsage() const noexcept;
     const RecordDefinition& getDefinition() const & noexcept;
     const CompoundDataType& getValue(size_t key,
         const std::string& name) const &;
     const CompoundDataType& getValue(size_t key,
         size_t fieldIndex) const &;
 
+    float getFloat(size_t key, size_t fieldIndex) const;
+    uint32_t getUInt32(size_t key, size_t fieldIndex) const;
+    bool getBool(size_t key, size_t fieldIndex) const;
+    const char* getString(size_t key, size_t fieldIndex) const &;
+
     size_t getFieldIndex(const std::string& name) const;
     const char* getFieldName(size_t index) const &;
 
+    ExportedColumn exportColumn(size_t fieldIndex) const;
+    std::vector<ExportedColumn> exportColumns() const;
+
     size_t addRecord(const Record& record);
+    size_t addRecord(Record&& record);
     void addRecords(const Records& records);
+    void addRecords(Records&& records);
+    std::future<void> addRecordsAsync(Records records,
+        Executor& executor = Executor::global());
+
+    void createIndex(const std::string& fieldName);
+    void dropIndex(const std::string& fieldName);
+    bool hasIndex(const std::string& fieldName) const;
+
+    std::vector<size_t> findKeys(const ValueQuery& query) const;
+    std::future<std::vector<size_t>> findKeysAsync(ValueQuery query,
+        Executor& executor = Executor::global()) const;
+
+    //! Appends many records/values to a value table in one transaction.
+    /*!
+        Records/values are written to the HDF5 DataSet in chunk sized batches,
+        and the DataSet grows geometrically.  They only appear in the value
+        table once committed.  Destroying the appender without committing
+        discards them.
+
+        Nothing else may add to the value table while the appender is open.
+    */
+    class BAG_API Appender final
+    {
+    public:
+        ~Appender() noexcept;
+
+        Appender(const Appender&) = delete;
+        Appender(Appender&&) = delete;
+
+        Appender& operator=(const Appender&) = delete;
+        Appender& operator=(Appender&&) = delete;
+
+        size_t addRecord(const Record& record);
+        void addRecords(const Records& records);
+        void commit();
+        size_t size() const noexcept;
+
+    private:
+        explicit Appender(ValueTable& table);
+
+        void flush();
+        void resize(uint64_t length);
+
+        //! The value table appended to.
+        ValueTable& m_table;
+        //! The records/values not written yet.
+        Records m_buffer;
+        //! The records/values written, but not committed.
+        Records m_written;
+        //! The number of records/values written at once.
+        size_t m_batchSize = 0;
+        //! The length of the HDF5 DataSet, including room not written yet.
+        uint64_t m_extent = 0;
+        //! The most records/values the HDF5 DataSet can hold.
+        uint64_t m_maxExtent = 0;
+        //! Has the appender been committed?
+        bool m_committed = false;
+
+        friend ValueTable;
+    };
+
+    std::unique_ptr<Appender> beginAppend();
     void setValue(size_t key, const std::string& name,
         const CompoundDataType& value);
     void setValue(size_t key, size_t fieldIndex,
@@ -49,6 +202,51 @@ protected:
     explicit ValueTable(const GeorefMetadataLayer& layer);
 
 private:
+    //! One field of every record/value, stored contiguously.
+    struct Column final
+    {
+        //! The type of the field.
+        DataType type = DT_UNKNOWN_DATA_TYPE;
+        //! The values, if the field is a float.
+        std::vector<float> floats;
+        //! The values, if the field is a 32 bit unsigned integer.
+        std::vector<uint32_t> uint32s;
+        //! The values, if the field is a boolean.
+        std::vector<uint8_t> bools;
+        //! The offset of each value into the string arena, if the field is a string.
+        std::vector<size_t> strings;
+    };
+
+    //! The keys of the records/values, organised by the value of one field.
+    struct FieldIndex final
+    {
+        //! The keys of each value, if the field is a string.
+        std::unordered_map<std::string, std::vector<size_t>> strings;
+        //! The keys of each value, if the field is an integer or boolean.
+        std::unordered_map<uint32_t, std::vector<size_t>> integers;
+        //! The keys ordered by value, if the field is numeric.
+        std::multimap<double, size_t> sorted;
+    };
+
+    size_t addString(const char* str);
+    void addToIndex(size_t key, size_t fieldIndex);
+    void removeFromIndex(size_t key, size_t fieldIndex);
+    bool matches(size_t key, size_t fieldIndex, const ValueQuery& query) const;
+    std::vector<bool> findMatchingKeys(const ValueQuery& query) const;
+    void appendToColumns(const Record& record);
+    void appendToColumns(const uint8_t* buffer);
+    void setColumnValue(size_t key, size_t fieldIndex,
+        const CompoundDataType& value);
+
+    CompoundDataType decodeValue(size_t key, size_t fieldIndex) const;
+    Record decodeRecord(size_t key) const;
+    const Record& getDecodedRecord(size_t key) const;
+    const Column& getColumn(size_t key, size_t fieldIndex,
+        DataType type) const;
+
+    std::vector<ResolvedColumn> resolve(const uint8_t* keys, DataType keyType,
+        size_t numKeys, const std::vector<std::string>& fieldNames) const;
+
     std::vector<uint8_t> convertRecordToRaw(const Record& record) const;
     std::vector<uint8_t> convertRecordsToRaw(
         const std::vector<Record>& records) const;
@@ -60,8 +258,18 @@ private:
 
     //! The layer these records pertain to.
     const GeorefMetadataLayer& m_layer;
-    //! The stored values.
-    Records m_records;
+    //! The stored values, one column per field.
+    std::vector<Column> m_columns;
+    //! The index of each field; null if the field is not indexed.
+    std::vector<std::unique_ptr<FieldIndex>> m_indexes;
+    //! The characters of every string value, each null terminated.
+    std::vector<char> m_strings;
+    //! The number of records/values, including the no data value record.
+    size_t m_numRecords = 0;
+    //! The records/values decoded so far; the rest are empty.
+    mutable Records m_records;
+    //! Which records/values have been decoded.
+    mutable std::vector<bool> m_isDecoded;
 
     friend GeorefMetadataLayer;
 };
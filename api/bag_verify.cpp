@@ -0,0 +1,1186 @@
+
+#include "bag_dataset.h"
+#include "bag_directchunk.h"
+#include "bag_georefmetadatalayerdescriptor.h"
+#include "bag_hdfhelper.h"
+#include "bag_interleavedlegacylayerdescriptor.h"
+#include "bag_parallel.h"
+#include "bag_private.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayerdescriptor.h"
+#include "bag_verify.h"
+#include "bag_vrnodedescriptor.h"
+#include "bag_vrrefinementsdescriptor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>  // memcpy
+#include <H5Cpp.h>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <zlib.h>
+
+
+namespace BAG {
+
+namespace {
+
+//! The most bytes of chunks, as stored and decoded, held at once.
+constexpr size_t kVerifyBatchBytes = 64 * 1024 * 1024;
+//! The most bytes of an unchunked DataSet read as one chunk.
+constexpr size_t kUnchunkedBandBytes = 16 * 1024 * 1024;
+//! The size of the Fletcher32 checksum at the end of a chunk.
+constexpr size_t kChecksumSize = 4;
+
+//! How a field is stored; only fields in the byte order of the host are
+//! checked.
+enum class FieldType
+{
+    Unsupported,
+    Float32,
+    Float64,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+};
+
+//! The filters of a chunked DataSet the verifier undoes itself.
+/*!
+    Byte shuffling, deflate and a Fletcher32 checksum are undone on several
+    threads, if they are in that order; chunks filtered any other way are
+    read through HDF5, one at a time.
+*/
+struct Pipeline final
+{
+    //! Can the chunks be read as stored and decoded by the verifier?
+    bool supported = false;
+    //! The filter mask of a chunk stored without shuffling it; 0 if the
+    //! bytes are not shuffled.
+    uint32_t shuffleMask = 0;
+    //! The filter mask of a chunk stored without deflating it; 0 if the
+    //! chunks are not deflated.
+    uint32_t deflateMask = 0;
+    //! The filter mask of a chunk stored without a checksum; 0 if the
+    //! chunks have none.
+    uint32_t checksumMask = 0;
+};
+
+//! How the elements of a DataSet are laid out, and read a chunk at a time.
+struct DataSetLayout final
+{
+    //! The number of dimensions; a scalar DataSet has one of one element.
+    int rank = 1;
+    //! The extent of each dimension.
+    std::array<hsize_t, H5S_MAX_RANK> dims{};
+    //! The extent of a chunk in each dimension.  An unchunked DataSet is
+    //! read in bands of its first dimension.
+    std::array<hsize_t, H5S_MAX_RANK> chunkDims{};
+    //! The number of chunks along each dimension.
+    std::array<hsize_t, H5S_MAX_RANK> numChunks{};
+    //! Is the DataSet stored in chunks?
+    bool chunked = false;
+    //! Is the DataSet scalar?
+    bool scalar = false;
+    //! The size of an element, in bytes.
+    size_t elementSize = 0;
+    //! The number of elements in a chunk.
+    size_t chunkElements = 0;
+    //! The filters the chunks are read through.
+    Pipeline pipeline;
+};
+
+//! A check of a DataSet, with its fields located in an element.
+struct ResolvedCheck final
+{
+    //! What is wrong with an element failing the check.
+    VerifyProblem problem = VerifyProblem::ValueOutOfRange;
+    //! The name of the field checked.
+    std::string field;
+    //! The smallest valid value.
+    double min = 0.;
+    //! The largest valid value; for IndexOutOfRange, the number of
+    //! refinements.
+    double max = 0.;
+    //! Are null values valid?
+    bool allowNull = true;
+    //! The offset of the field in an element.
+    size_t offset = 0;
+    //! How the field is stored.
+    FieldType type = FieldType::Unsupported;
+    //! The offsets of the fields holding the number of refinements of a
+    //! variable resolution cell along x and y; only for IndexOutOfRange.
+    std::array<size_t, 2> dimsOffsets{};
+    //! How those fields are stored.
+    std::array<FieldType, 2> dimsTypes{};
+};
+
+//! The elements of a chunk failing a check.
+struct CheckResult final
+{
+    //! The number of elements failing the check.
+    uint64_t count = 0;
+    //! The index, in the chunk, of the first.
+    size_t firstIndex = 0;
+    //! The value of its field.
+    double firstValue = 0.;
+};
+
+//! A chunk being verified.
+struct VerifyChunk final
+{
+    //! The first element of the chunk in each dimension.
+    std::array<hsize_t, H5S_MAX_RANK> offset{};
+    //! The chunk as stored in the file.
+    std::vector<uint8_t> stored;
+    //! The number of bytes of stored used.
+    size_t storedSize = 0;
+    //! The filter mask of the stored chunk.
+    uint32_t filterMask = 0;
+    //! The decoded elements, laid out as a whole chunk.
+    std::vector<uint8_t> decoded;
+    //! The inflated chunk, before it is unshuffled.
+    std::vector<uint8_t> inflated;
+    //! The decoded elements; null if the chunk was not decoded.
+    const uint8_t* data = nullptr;
+    //! Must the stored chunk be decoded?
+    bool mustDecode = false;
+    //! Was the chunk found wrong as a whole?
+    bool failed = false;
+    //! What is wrong with it, if it was.
+    VerifyProblem problem = VerifyProblem::Unreadable;
+    //! Why HDF5 could not read it, if it could not.
+    std::string hdf5Message;
+    //! The elements failing each check.
+    std::vector<CheckResult> results;
+};
+
+//! Find how a field is stored.
+/*!
+\param h5type
+    The HDF5 type of the field in the file.
+
+\return
+    How the field is stored; Unsupported if it is not a number in the byte
+    order of the host.
+*/
+FieldType getFieldType(
+    const ::H5::DataType& h5type)
+{
+    const auto h5class = h5type.getClass();
+    if (h5class != H5T_FLOAT && h5class != H5T_INTEGER)
+        return FieldType::Unsupported;
+
+    const std::array<std::tuple<const ::H5::PredType*, FieldType>, 10> kTypes{{
+        {&::H5::PredType::NATIVE_FLOAT, FieldType::Float32},
+        {&::H5::PredType::NATIVE_DOUBLE, FieldType::Float64},
+        {&::H5::PredType::NATIVE_INT8, FieldType::Int8},
+        {&::H5::PredType::NATIVE_INT16, FieldType::Int16},
+        {&::H5::PredType::NATIVE_INT32, FieldType::Int32},
+        {&::H5::PredType::NATIVE_INT64, FieldType::Int64},
+        {&::H5::PredType::NATIVE_UINT8, FieldType::UInt8},
+        {&::H5::PredType::NATIVE_UINT16, FieldType::UInt16},
+        {&::H5::PredType::NATIVE_UINT32, FieldType::UInt32},
+        {&::H5::PredType::NATIVE_UINT64, FieldType::UInt64},
+    }};
+
+    for (const auto& type : kTypes)
+        if (h5type == *std::get<0>(type))
+            return std::get<1>(type);
+
+    return FieldType::Unsupported;
+}
+
+//! Locate a field in the elements of a DataSet.
+/*!
+\param h5dataSet
+    The DataSet.
+\param field
+    The name of a member of the compound elements; empty for the whole
+    element.
+\param offset
+    Set to the offset of the field in an element.
+
+\return
+    How the field is stored; Unsupported if the field is not a number, or
+    is missing.
+*/
+FieldType findField(
+    const ::H5::DataSet& h5dataSet,
+    const std::string& field,
+    size_t& offset)
+{
+    offset = 0;
+
+    if (field.empty())
+        return getFieldType(h5dataSet.getDataType());
+
+    if (h5dataSet.getTypeClass() != H5T_COMPOUND)
+        return FieldType::Unsupported;
+
+    const auto h5compType = h5dataSet.getCompType();
+
+    const auto index = H5Tget_member_index(h5compType.getId(), field.c_str());
+    if (index < 0)
+        return FieldType::Unsupported;
+
+    offset = h5compType.getMemberOffset(static_cast<unsigned>(index));
+
+    return getFieldType(h5compType.getMemberDataType(
+        static_cast<unsigned>(index)));
+}
+
+//! Read a field of an element.
+/*!
+\param data
+    The field.
+\param type
+    How the field is stored; not Unsupported.
+
+\return
+    The value of the field.
+*/
+double readField(
+    const uint8_t* data,
+    FieldType type) noexcept
+{
+    const auto read = [data](auto value) {
+        std::memcpy(&value, data, sizeof(value));
+        return static_cast<double>(value);
+    };
+
+    switch (type)
+    {
+    case FieldType::Float32:
+        return read(float{});
+    case FieldType::Float64:
+        return read(double{});
+    case FieldType::Int8:
+        return read(int8_t{});
+    case FieldType::Int16:
+        return read(int16_t{});
+    case FieldType::Int32:
+        return read(int32_t{});
+    case FieldType::Int64:
+        return read(int64_t{});
+    case FieldType::UInt8:
+        return read(uint8_t{});
+    case FieldType::UInt16:
+        return read(uint16_t{});
+    case FieldType::UInt32:
+        return read(uint32_t{});
+    case FieldType::UInt64:
+        return read(uint64_t{});
+    case FieldType::Unsupported:  //[[fallthrough]]
+    default:
+        return 0.;
+    }
+}
+
+//! Find the filters of a chunked DataSet the verifier can undo itself.
+/*!
+\param h5createPropList
+    The creation property list of the DataSet.
+
+\return
+    The filters.
+*/
+Pipeline getPipeline(
+    const ::H5::DSetCreatPropList& h5createPropList)
+{
+    Pipeline pipeline;
+
+    // Each filter must come after those before it in this order.
+    int stage = 0;
+
+    const auto numFilters = h5createPropList.getNfilters();
+    for (int i=0; i<numFilters; ++i)
+    {
+        unsigned int flags = 0;
+        size_t cdNelmts = 10;
+        constexpr size_t nameLen = 64;
+        std::array<unsigned int, 10> cdValues{};
+        std::array<char, 64> name{};
+        unsigned int filterConfig = 0;
+
+        const auto filter = h5createPropList.getFilter(i, flags, cdNelmts,
+            cdValues.data(), nameLen, name.data(), filterConfig);
+
+        if (filter == H5Z_FILTER_SHUFFLE && stage < 1)
+        {
+            pipeline.shuffleMask = 1u << i;
+            stage = 1;
+        }
+        else if (filter == H5Z_FILTER_DEFLATE && stage < 2)
+        {
+            pipeline.deflateMask = 1u << i;
+            stage = 2;
+        }
+        else if (filter == H5Z_FILTER_FLETCHER32 && stage < 3)
+        {
+            pipeline.checksumMask = 1u << i;
+            stage = 3;
+        }
+        else
+            return pipeline;
+    }
+
+    pipeline.supported = true;
+
+    return pipeline;
+}
+
+//! Compute the Fletcher32 checksum of data the way the HDF5 filter does.
+/*!
+    The data is summed as big endian 16 bit words; an odd last byte is the
+    high byte of a word.
+
+\param data
+    The data.
+\param size
+    The number of bytes of data.
+
+\return
+    The checksum.
+*/
+uint32_t computeFletcher32(
+    const uint8_t* data,
+    size_t size) noexcept
+{
+    uint32_t sum1 = 0;
+    uint32_t sum2 = 0;
+
+    // Sums of 360 words cannot overflow before they are folded.
+    for (auto words=size / 2; words > 0; )
+    {
+        const auto blockWords = std::min<size_t>(words, 360);
+        words -= blockWords;
+
+        for (size_t i=0; i<blockWords; ++i, data+=2)
+        {
+            sum1 += (static_cast<uint32_t>(data[0]) << 8) | data[1];
+            sum2 += sum1;
+        }
+
+        sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+        sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+    }
+
+    if (size % 2 != 0)
+    {
+        sum1 += static_cast<uint32_t>(*data) << 8;
+        sum2 += sum1;
+        sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+        sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+    }
+
+    sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+    sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+
+    return (sum2 << 16) | sum1;
+}
+
+//! Undo the filters of a chunk read as stored.
+/*!
+\param layout
+    The layout of the DataSet.
+\param chunk
+    The chunk; its data is set to the decoded elements, or it is marked
+    failed.
+*/
+void decodeChunk(
+    const DataSetLayout& layout,
+    VerifyChunk& chunk) noexcept
+{
+    const auto chunkBytes = layout.chunkElements * layout.elementSize;
+    const auto& pipeline = layout.pipeline;
+
+    const uint8_t* data = chunk.stored.data();
+    auto size = chunk.storedSize;
+
+    if (pipeline.checksumMask != 0 &&
+        (chunk.filterMask & pipeline.checksumMask) == 0)
+    {
+        if (size < kChecksumSize)
+        {
+            chunk.failed = true;
+            chunk.problem = VerifyProblem::ChecksumMismatch;
+            return;
+        }
+
+        size -= kChecksumSize;
+
+        // The checksum is stored little endian.  HDF5 before 1.6.3 swapped
+        // the bytes of each half, and still accepts that.
+        const auto* stored = data + size;
+        const auto expected = static_cast<uint32_t>(stored[0]) |
+            (static_cast<uint32_t>(stored[1]) << 8) |
+            (static_cast<uint32_t>(stored[2]) << 16) |
+            (static_cast<uint32_t>(stored[3]) << 24);
+        const auto checksum = computeFletcher32(data, size);
+        const auto swapped = ((checksum & 0x00ff00ffu) << 8) |
+            ((checksum >> 8) & 0x00ff00ffu);
+
+        if (expected != checksum && expected != swapped)
+        {
+            chunk.failed = true;
+            chunk.problem = VerifyProblem::ChecksumMismatch;
+            return;
+        }
+    }
+
+    const auto shuffled = pipeline.shuffleMask != 0 &&
+        (chunk.filterMask & pipeline.shuffleMask) == 0;
+
+    if (pipeline.deflateMask != 0 &&
+        (chunk.filterMask & pipeline.deflateMask) == 0)
+    {
+        auto* inflated = shuffled ? chunk.inflated.data() :
+            chunk.decoded.data();
+        auto inflatedSize = static_cast<uLongf>(chunkBytes);
+        if (uncompress(inflated, &inflatedSize, data,
+            static_cast<uLong>(size)) != Z_OK)
+        {
+            chunk.failed = true;
+            chunk.problem = VerifyProblem::DecompressionFailed;
+            return;
+        }
+
+        data = inflated;
+        size = inflatedSize;
+    }
+
+    if (size != chunkBytes)
+    {
+        chunk.failed = true;
+        chunk.problem = VerifyProblem::DecompressionFailed;
+        return;
+    }
+
+    if (shuffled)
+    {
+        unshuffleBytes(data, chunkBytes, layout.elementSize,
+            chunk.decoded.data());
+        data = chunk.decoded.data();
+    }
+
+    chunk.data = data;
+}
+
+//! Call a function with the index of each element of a chunk inside the
+//! DataSet.
+/*!
+    Chunks at the edges of the DataSet are partly outside it.
+
+\param layout
+    The layout of the DataSet.
+\param offset
+    The first element of the chunk in each dimension.
+\param visit
+    Called with the index of each element in the chunk, in order.
+*/
+template <typename Visit>
+void forEachElement(
+    const DataSetLayout& layout,
+    const std::array<hsize_t, H5S_MAX_RANK>& offset,
+    const Visit& visit) noexcept
+{
+    const auto rank = layout.rank;
+
+    std::array<hsize_t, H5S_MAX_RANK> counts{};
+    for (int d=0; d<rank; ++d)
+        counts[d] = std::min(layout.chunkDims[d], layout.dims[d] - offset[d]);
+
+    // The elements are visited a run along the last dimension at a time.
+    std::array<hsize_t, H5S_MAX_RANK> position{};
+    const auto run = counts[rank - 1];
+
+    while (true)
+    {
+        size_t first = 0;
+        for (int d=0; d<rank - 1; ++d)
+            first = (first + position[d]) * layout.chunkDims[d + 1];
+
+        for (size_t i=0; i<run; ++i)
+            visit(first + i);
+
+        int d = rank - 2;
+        while (d >= 0 && ++position[d] == counts[d])
+            position[d--] = 0;
+
+        if (d < 0)
+            break;
+    }
+}
+
+//! Check the values of a decoded chunk.
+/*!
+\param layout
+    The layout of the DataSet.
+\param checks
+    The checks.
+\param chunk
+    The chunk; its results are set.
+*/
+void checkChunk(
+    const DataSetLayout& layout,
+    const std::vector<ResolvedCheck>& checks,
+    VerifyChunk& chunk) noexcept
+{
+    const auto nullValue = static_cast<double>(BAG_NULL_GENERIC);
+
+    for (size_t c=0; c<checks.size(); ++c)
+    {
+        const auto& check = checks[c];
+        auto& result = chunk.results[c];
+        result = {};
+
+        forEachElement(layout, chunk.offset, [&](size_t index) {
+            const auto* element = chunk.data + index * layout.elementSize;
+            const auto value = readField(element + check.offset, check.type);
+
+            bool valid = false;
+            if (check.problem == VerifyProblem::IndexOutOfRange)
+            {
+                const auto dimsX = readField(element + check.dimsOffsets[0],
+                    check.dimsTypes[0]);
+                const auto dimsY = readField(element + check.dimsOffsets[1],
+                    check.dimsTypes[1]);
+
+                // A cell of no refinements has no index.
+                valid = dimsX == 0. || dimsY == 0. ||
+                    (value >= 0. && value + dimsX * dimsY <= check.max);
+            }
+            else
+                valid = (value >= check.min && value <= check.max) ||
+                    (check.allowNull && value == nullValue);
+
+            if (valid)
+                return;
+
+            if (result.count++ == 0)
+            {
+                result.firstIndex = index;
+                result.firstValue = value;
+            }
+        });
+    }
+}
+
+//! Describe a problem of a chunk.
+/*!
+\param layout
+    The layout of the DataSet.
+\param check
+    The check the chunk failed; null if it failed as a whole.
+\param chunk
+    The chunk.
+\param result
+    The elements failing the check; ignored without one.
+
+\return
+    The description.
+*/
+std::string describeProblem(
+    const DataSetLayout& layout,
+    const ResolvedCheck* check,
+    const VerifyChunk& chunk,
+    const CheckResult& result)
+{
+    std::ostringstream message;
+
+    if (!check)
+    {
+        switch (chunk.problem)
+        {
+        case VerifyProblem::ChecksumMismatch:
+            message << "the Fletcher32 checksum does not match the chunk";
+            break;
+        case VerifyProblem::DecompressionFailed:
+            message << "the chunk does not decompress to " <<
+                layout.chunkElements * layout.elementSize << " bytes";
+            break;
+        case VerifyProblem::Unreadable:  //[[fallthrough]]
+        default:
+            message << "the chunk could not be read: " << chunk.hdf5Message;
+            break;
+        }
+
+        return message.str();
+    }
+
+    message << result.count << ' ';
+
+    switch (check->problem)
+    {
+    case VerifyProblem::KeyOutOfRange:
+        message << "keys have no record in the " << check->max + 1 <<
+            " records of the value table; the first, " << result.firstValue;
+        break;
+    case VerifyProblem::IndexOutOfRange:
+        message << "cells refer past the " << check->max <<
+            " refinements; the first, at index " << result.firstValue;
+        break;
+    case VerifyProblem::ValueOutOfRange:  //[[fallthrough]]
+    default:
+        message << "values";
+        if (!check->field.empty())
+            message << " of " << check->field;
+        message << " are outside [" << check->min << ", " << check->max <<
+            "]; the first, " << result.firstValue;
+        break;
+    }
+
+    // The position of the first, in the DataSet.
+    std::array<hsize_t, H5S_MAX_RANK> position{};
+    auto index = result.firstIndex;
+    for (int d=layout.rank - 1; d>=0; --d)
+    {
+        position[d] = chunk.offset[d] + index % layout.chunkDims[d];
+        index /= layout.chunkDims[d];
+    }
+
+    message << ", is at (";
+    for (int d=0; d<layout.rank; ++d)
+        message << (d > 0 ? ", " : "") << position[d];
+    message << ')';
+
+    return message.str();
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+\param dataset
+    The BAG.
+\param options
+    The options of the verification.
+*/
+DatasetVerifier::DatasetVerifier(
+    const Dataset& dataset,
+    const VerifyOptions& options) noexcept
+    : m_dataset(dataset)
+    , m_options(options)
+{
+}
+
+//! Verify the BAG.
+/*!
+\return
+    What was found.
+*/
+VerifyReport DatasetVerifier::verify()
+{
+    VerifyReport report;
+    std::vector<std::string> paths;
+
+    {
+        const auto lock = m_dataset.lockReads();
+
+        if (m_options.checkValues)
+            this->addLayerChecks();
+
+        this->findDataSets(m_dataset.getH5file().openGroup("/"), {}, paths);
+    }
+
+    const ProgressScope progress{m_options.progress};
+    const auto numPaths = static_cast<uint64_t>(paths.size());
+
+    for (uint64_t i=0; i<numPaths; ++i)
+    {
+        this->verifyDataSet(paths[i], progress.part(i, i + 1, numPaths),
+            report);
+        progress.report(i + 1, numPaths);
+    }
+
+    return report;
+}
+
+//! Check that the values of a field of a DataSet are in a range.
+/*!
+    Null values are in any range.  A range whose minimum is greater than its
+    maximum was never set, and is not checked.
+
+\param path
+    The path of the DataSet.
+\param field
+    The name of the member of the compound elements; empty if the elements
+    are not compound.
+\param min
+    The smallest valid value.
+\param max
+    The largest valid value.
+\param tolerance
+    How far outside the range a value may be.
+*/
+void DatasetVerifier::addRangeCheck(
+    const std::string& path,
+    const std::string& field,
+    double min,
+    double max,
+    double tolerance)
+{
+    if (min > max)
+        return;
+
+    ValueCheck check;
+    check.field = field;
+    check.min = min - tolerance;
+    check.max = max + tolerance;
+
+    m_checks[path].push_back(std::move(check));
+}
+
+//! Find the checks of the values of the layers.
+/*!
+    Simple and interleaved layers, and the variable resolution refinements
+    and nodes, are checked against the minimum and maximum of their
+    descriptors.  The keys of georeferenced metadata layers must have a
+    record in their value table, and the refinements of variable resolution
+    cells must be in the VRRefinements layer.
+*/
+void DatasetVerifier::addLayerChecks()
+{
+    const auto& h5file = m_dataset.getH5file();
+
+    // The number of elements of a DataSet.
+    const auto getNumElements = [&h5file](const std::string& path) {
+        return static_cast<double>(
+            h5file.openDataSet(path).getSpace().getSimpleExtentNpoints());
+    };
+
+    for (const auto& pLayer : m_dataset.getLayers())
+    {
+        const auto pDescriptor = pLayer->getDescriptor();
+        const auto& path = pDescriptor->getInternalPath();
+        const auto layerType = pDescriptor->getLayerType();
+
+        float min = 0.f, max = 0.f;
+        std::tie(min, max) = pDescriptor->getMinMax();
+
+        switch (layerType)
+        {
+        case Georef_Metadata:
+        {
+            // Key 0 is the no data value record.
+            const auto numRecords = getNumElements(path + COMPOUND_VALUES);
+
+            for (const auto* keys : {COMPOUND_KEYS, COMPOUND_VR_KEYS})
+            {
+                const auto keysPath = path + keys;
+                if (H5Lexists(h5file.getId(), keysPath.c_str(),
+                    H5P_DEFAULT) <= 0)
+                    continue;
+
+                ValueCheck check;
+                check.problem = VerifyProblem::KeyOutOfRange;
+                check.max = numRecords - 1;
+                check.allowNull = false;
+                m_checks[keysPath].push_back(std::move(check));
+            }
+            break;
+        }
+        case VarRes_Metadata:
+        {
+            if (H5Lexists(h5file.getId(), VR_REFINEMENT_PATH,
+                H5P_DEFAULT) <= 0)
+                break;
+
+            ValueCheck check;
+            check.problem = VerifyProblem::IndexOutOfRange;
+            check.field = "index";
+            check.max = getNumElements(VR_REFINEMENT_PATH);
+            check.allowNull = false;
+            m_checks[path].push_back(std::move(check));
+            break;
+        }
+        case VarRes_Refinement:
+        {
+            const auto& descriptor =
+                dynamic_cast<const VRRefinementsDescriptor&>(*pDescriptor);
+
+            std::tie(min, max) = descriptor.getMinMaxDepth();
+            this->addRangeCheck(path, "depth", min, max);
+            std::tie(min, max) = descriptor.getMinMaxUncertainty();
+            this->addRangeCheck(path, "depth_uncrt", min, max);
+            break;
+        }
+        case VarRes_Node:
+        {
+            const auto& descriptor =
+                dynamic_cast<const VRNodeDescriptor&>(*pDescriptor);
+
+            std::tie(min, max) = descriptor.getMinMaxHypStrength();
+            this->addRangeCheck(path, "hyp_strength", min, max);
+
+            uint32_t minCount = 0, maxCount = 0;
+            std::tie(minCount, maxCount) = descriptor.getMinMaxNumHypotheses();
+            this->addRangeCheck(path, "num_hypotheses", minCount, maxCount);
+            std::tie(minCount, maxCount) = descriptor.getMinMaxNSamples();
+            this->addRangeCheck(path, "n_samples", minCount, maxCount);
+            break;
+        }
+        case Surface_Correction:
+            break;
+        default:
+            if (const auto* simpleDescriptor =
+                dynamic_cast<const SimpleLayerDescriptor*>(pDescriptor.get()))
+            {
+                // Quantized values are within the bound of those written.
+                this->addRangeCheck(path, {}, min, max,
+                    simpleDescriptor->getQuantization().absErrorBound);
+            }
+            else if (const auto* interleavedDescriptor =
+                dynamic_cast<const InterleavedLegacyLayerDescriptor*>(
+                    pDescriptor.get()))
+            {
+                const auto field = createH5compType(layerType,
+                    interleavedDescriptor->getGroupType()).getMemberName(0);
+                this->addRangeCheck(path, field, min, max);
+            }
+            break;
+        }
+    }
+}
+
+//! Find the DataSets in a group and its subgroups.
+/*!
+\param h5group
+    The group.
+\param path
+    The path of the group; empty for the root.
+\param paths
+    The paths of the DataSets are added to this.
+*/
+void DatasetVerifier::findDataSets(
+    const ::H5::Group& h5group,
+    const std::string& path,
+    std::vector<std::string>& paths) const
+{
+    const hsize_t numObjects = h5group.getNumObjs();
+
+    for (hsize_t i=0; i<numObjects; ++i)
+    {
+        const auto name = h5group.getObjnameByIdx(i);
+        const auto childPath = path + '/' + name;
+
+        switch (h5group.childObjType(name))
+        {
+        case H5O_TYPE_GROUP:
+            this->findDataSets(h5group.openGroup(name), childPath, paths);
+            break;
+        case H5O_TYPE_DATASET:
+            paths.push_back(childPath);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+//! Read every chunk of a DataSet, and check its values.
+/*!
+    The chunks are read a batch at a time, holding the lock of the BAG.
+    They are then decoded and checked on several threads without it.
+
+\param path
+    The path of the DataSet.
+\param progress
+    Reports the progress of the DataSet.
+\param report
+    The problems found are added to this.
+*/
+void DatasetVerifier::verifyDataSet(
+    const std::string& path,
+    const ProgressScope& progress,
+    VerifyReport& report) const
+{
+    auto lock = m_dataset.lockReads();
+
+    const auto h5dataSet = m_dataset.getH5file().openDataSet(path);
+    const auto h5fileType = h5dataSet.getDataType();
+    const auto h5fileSpace = h5dataSet.getSpace();
+    const auto h5createPropList = h5dataSet.getCreatePlist();
+
+    DataSetLayout layout;
+    layout.elementSize = h5fileType.getSize();
+
+    const auto rank = h5fileSpace.getSimpleExtentNdims();
+    layout.scalar = rank == 0;
+    if (!layout.scalar)
+    {
+        layout.rank = rank;
+        h5fileSpace.getSimpleExtentDims(layout.dims.data());
+    }
+    else
+        layout.dims[0] = 1;
+
+    ++report.numDataSets;
+
+    if (std::any_of(layout.dims.begin(), layout.dims.begin() + layout.rank,
+        [](hsize_t extent) { return extent == 0; }))
+        return;
+
+    layout.chunked = h5createPropList.getLayout() == H5D_CHUNKED;
+    if (layout.chunked)
+    {
+        h5createPropList.getChunk(layout.rank, layout.chunkDims.data());
+        layout.pipeline = getPipeline(h5createPropList);
+    }
+    else
+    {
+        // Bands of whole rows.
+        size_t rowBytes = layout.elementSize;
+        for (int d=1; d<layout.rank; ++d)
+        {
+            layout.chunkDims[d] = layout.dims[d];
+            rowBytes *= static_cast<size_t>(layout.dims[d]);
+        }
+
+        layout.chunkDims[0] = std::min<hsize_t>(layout.dims[0],
+            std::max<size_t>(1, kUnchunkedBandBytes / rowBytes));
+    }
+
+#if !H5_VERSION_GE(1, 10, 5)
+    // H5Dget_chunk_info_by_coord() is not available.
+    layout.pipeline.supported = false;
+#endif
+
+    layout.chunkElements = 1;
+    size_t numChunks = 1;
+    for (int d=0; d<layout.rank; ++d)
+    {
+        layout.numChunks[d] = (layout.dims[d] + layout.chunkDims[d] - 1) /
+            layout.chunkDims[d];
+        layout.chunkElements *= static_cast<size_t>(layout.chunkDims[d]);
+        numChunks *= static_cast<size_t>(layout.numChunks[d]);
+    }
+
+    const auto chunkBytes = layout.chunkElements * layout.elementSize;
+
+    // Locate the fields checked.
+    std::vector<ResolvedCheck> checks;
+    const auto found = m_checks.find(path);
+    if (found != m_checks.end())
+    {
+        for (const auto& check : found->second)
+        {
+            ResolvedCheck resolved;
+            resolved.problem = check.problem;
+            resolved.field = check.field;
+            resolved.min = check.min;
+            resolved.max = check.max;
+            resolved.allowNull = check.allowNull;
+            resolved.type = findField(h5dataSet, check.field,
+                resolved.offset);
+
+            if (check.problem == VerifyProblem::IndexOutOfRange)
+            {
+                resolved.dimsTypes[0] = findField(h5dataSet, "dimensions_x",
+                    resolved.dimsOffsets[0]);
+                resolved.dimsTypes[1] = findField(h5dataSet, "dimensions_y",
+                    resolved.dimsOffsets[1]);
+                if (resolved.dimsTypes[0] == FieldType::Unsupported ||
+                    resolved.dimsTypes[1] == FieldType::Unsupported)
+                    continue;
+            }
+
+            if (resolved.type != FieldType::Unsupported)
+                checks.push_back(std::move(resolved));
+        }
+    }
+
+    // Variable length data is stored as references to a heap, so it is read
+    // through HDF5, which allocates it.
+    const auto hasVariableLength = h5fileType.detectClass(H5T_VLEN) ||
+        h5fileType.detectClass(H5T_STRING);
+    if (hasVariableLength)
+        layout.pipeline.supported = false;
+
+    // Chunks written through HDF5 may still be in its chunk cache.
+    if (layout.pipeline.supported && H5Dflush(h5dataSet.getId()) < 0)
+        layout.pipeline.supported = false;
+
+    // Each chunk holds its stored, inflated and decoded bytes.
+    const auto batchSize = std::min(numChunks,
+        std::max<size_t>(1, kVerifyBatchBytes / (3 * chunkBytes)));
+    std::vector<VerifyChunk> chunks(batchSize);
+
+    const ::H5::DataSpace h5memSpace{layout.rank, layout.chunkDims.data()};
+
+    for (size_t batchStart=0; batchStart<numChunks; batchStart+=batchSize)
+    {
+        const auto numInBatch = std::min(batchSize, numChunks - batchStart);
+        size_t numRead = 0;
+
+        // HDF5 reads the chunks, one at a time.
+        for (size_t i=0; i<numInBatch; ++i)
+        {
+            auto& chunk = chunks[numRead];
+            chunk.data = nullptr;
+            chunk.mustDecode = false;
+            chunk.failed = false;
+            chunk.hdf5Message.clear();
+
+            auto index = batchStart + i;
+            for (int d=layout.rank - 1; d>=0; --d)
+            {
+                chunk.offset[d] = (index % layout.numChunks[d]) *
+                    layout.chunkDims[d];
+                index /= layout.numChunks[d];
+            }
+
+            try
+            {
+#if H5_VERSION_GE(1, 10, 5)
+                if (layout.chunked)
+                {
+                    // A chunk that was never written has no address.
+                    haddr_t address = HADDR_UNDEF;
+                    hsize_t storedSize = 0;
+                    if (H5Dget_chunk_info_by_coord(h5dataSet.getId(),
+                        chunk.offset.data(), &chunk.filterMask, &address,
+                        &storedSize) < 0)
+                        throw ::H5::DataSetIException{"verifyDataSet",
+                            "H5Dget_chunk_info_by_coord failed"};
+
+                    if (address == HADDR_UNDEF)
+                    {
+                        ++report.numUnallocatedChunks;
+                        continue;
+                    }
+
+                    if (layout.pipeline.supported)
+                    {
+                        chunk.storedSize = static_cast<size_t>(storedSize);
+                        if (chunk.stored.size() < chunk.storedSize)
+                            chunk.stored.resize(chunk.storedSize);
+
+                        if (H5Dread_chunk(h5dataSet.getId(), H5P_DEFAULT,
+                            chunk.offset.data(), &chunk.filterMask,
+                            chunk.stored.data()) < 0)
+                            throw ::H5::DataSetIException{"verifyDataSet",
+                                "H5Dread_chunk failed"};
+
+                        chunk.mustDecode = true;
+                    }
+                }
+#endif
+
+                chunk.decoded.resize(chunkBytes);
+
+                if (!chunk.mustDecode)
+                {
+                    // HDF5 filters the chunk, and verifies its checksum.
+                    if (layout.scalar)
+                        h5dataSet.read(chunk.decoded.data(), h5fileType);
+                    else
+                    {
+                        std::array<hsize_t, H5S_MAX_RANK> counts{};
+                        for (int d=0; d<layout.rank; ++d)
+                            counts[d] = std::min(layout.chunkDims[d],
+                                layout.dims[d] - chunk.offset[d]);
+
+                        const std::array<hsize_t, H5S_MAX_RANK> origin{};
+                        h5fileSpace.selectHyperslab(H5S_SELECT_SET,
+                            counts.data(), chunk.offset.data());
+                        h5memSpace.selectHyperslab(H5S_SELECT_SET,
+                            counts.data(), origin.data());
+
+                        h5dataSet.read(chunk.decoded.data(), h5fileType,
+                            h5memSpace, h5fileSpace);
+
+                        if (hasVariableLength)
+                            ::H5::DataSet::vlenReclaim(chunk.decoded.data(),
+                                h5fileType, h5memSpace);
+                    }
+
+                    chunk.data = chunk.decoded.data();
+                }
+                else if (layout.pipeline.shuffleMask != 0 &&
+                    layout.pipeline.deflateMask != 0)
+                    chunk.inflated.resize(chunkBytes);
+            }
+            catch (const ::H5::Exception& e)
+            {
+                chunk.failed = true;
+                chunk.problem = VerifyProblem::Unreadable;
+                chunk.hdf5Message = e.getDetailMsg();
+            }
+
+            chunk.results.resize(checks.size());
+            ++numRead;
+        }
+
+        report.numChunks += numRead;
+
+        if (numRead > 0)
+        {
+            // Without concurrent reads, the BAG has no lock.
+            const auto locked = lock.owns_lock();
+            if (locked)
+                lock.unlock();
+
+            processInBlocks(0, static_cast<uint32_t>(numRead - 1),
+                static_cast<uint32_t>(std::min<size_t>(layout.chunkElements,
+                    std::numeric_limits<uint32_t>::max())),
+                [&](uint32_t first, uint32_t last) {
+                    for (auto index=first; index<=last; ++index)
+                    {
+                        auto& chunk = chunks[index];
+                        if (chunk.mustDecode && !chunk.failed)
+                            decodeChunk(layout, chunk);
+
+                        if (chunk.data)
+                            checkChunk(layout, checks, chunk);
+                    }
+                });
+
+            if (locked)
+                lock.lock();
+        }
+
+        for (size_t i=0; i<numRead; ++i)
+        {
+            const auto& chunk = chunks[i];
+
+            const auto addProblem = [&](VerifyProblem problem,
+                const ResolvedCheck* check, const CheckResult& result) {
+                ChunkProblem chunkProblem;
+                chunkProblem.path = path;
+                chunkProblem.offset.assign(chunk.offset.begin(),
+                    chunk.offset.begin() + (layout.scalar ? 0 : layout.rank));
+                chunkProblem.problem = problem;
+                chunkProblem.numValues = result.count;
+                chunkProblem.message = describeProblem(layout, check, chunk,
+                    result);
+                report.problems.push_back(std::move(chunkProblem));
+            };
+
+            if (chunk.failed)
+            {
+                addProblem(chunk.problem, nullptr, {});
+                continue;
+            }
+
+            for (size_t c=0; c<checks.size(); ++c)
+                if (chunk.results[c].count > 0)
+                    addProblem(checks[c].problem, &checks[c],
+                        chunk.results[c]);
+        }
+
+        progress.report(batchStart + numInBatch, numChunks);
+    }
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,69 @@
+#ifndef BAG_VERIFY_H
+#define BAG_VERIFY_H
+
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace H5 {
+
+class Group;
+
+}  // namespace H5
+
+namespace BAG {
+
+class ProgressScope;
+
+//! Reads every chunk of every DataSet of a BAG, and checks the values of its
+//! layers; see Dataset::verify().
+class DatasetVerifier final
+{
+public:
+    DatasetVerifier(const Dataset& dataset,
+        const VerifyOptions& options) noexcept;
+
+    VerifyReport verify();
+
+private:
+    //! A check of a field of every element of a DataSet.
+    struct ValueCheck final
+    {
+        //! What is wrong with an element failing the check.
+        VerifyProblem problem = VerifyProblem::ValueOutOfRange;
+        //! The name of the field checked; empty if the elements are not
+        //! compound.
+        std::string field;
+        //! The smallest valid value.
+        double min = 0.;
+        //! The largest valid value; for IndexOutOfRange, the number of
+        //! refinements.
+        double max = 0.;
+        //! Are null values valid?  Only for ValueOutOfRange.
+        bool allowNull = true;
+    };
+
+    void addRangeCheck(const std::string& path, const std::string& field,
+        double min, double max, double tolerance = 0.);
+    void addLayerChecks();
+    void findDataSets(const ::H5::Group& h5group, const std::string& path,
+        std::vector<std::string>& paths) const;
+    void verifyDataSet(const std::string& path, const ProgressScope& progress,
+        VerifyReport& report) const;
+
+    //! The BAG.
+    const Dataset& m_dataset;
+    //! The options of the verification.
+    const VerifyOptions& m_options;
+    //! The checks of the values of each DataSet, by path.
+    std::unordered_map<std::string, std::vector<ValueCheck>> m_checks;
+};
+
+}  // namespace BAG
+
+#endif  // BAG_VERIFY_H
+
@@ -0,0 +1,290 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_georefmetadatalayer.h"
+#include "bag_vrcelliterator.h"
+#include "bag_vrmetadata.h"
+#include "bag_vrnode.h"
+#include "bag_vrrefinements.h"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace BAG {
+
+constexpr uint32_t VRCellIterator::kDefaultBlockSize;
+
+//! Constructor.
+/*!
+    Walks every refined cell of the supergrid.
+
+\param dataset
+    The variable resolution BAG to walk.
+\param blockSize
+    The number of refinements read at a time; a cell with more is read
+    whole.
+*/
+VRCellIterator::VRCellIterator(
+    const Dataset& dataset,
+    uint32_t blockSize)
+    : VRCellIterator(dataset, 0, 0, std::numeric_limits<uint32_t>::max(),
+        std::numeric_limits<uint32_t>::max(), blockSize)
+{
+}
+
+//! Constructor.
+/*!
+    Walks the refined cells of a window of the supergrid.
+
+\param dataset
+    The variable resolution BAG to walk.
+\param rowStart
+    The first supergrid row of the window.
+\param columnStart
+    The first supergrid column of the window.
+\param rowEnd
+    The last supergrid row of the window (inclusive); clipped to the
+    supergrid.
+\param columnEnd
+    The last supergrid column of the window (inclusive); clipped to the
+    supergrid.
+\param blockSize
+    The number of refinements read at a time; a cell with more is read
+    whole.
+*/
+VRCellIterator::VRCellIterator(
+    const Dataset& dataset,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd,
+    uint32_t blockSize)
+    : m_pBagDataset(dataset.shared_from_this())
+    , m_blockSize(std::max(blockSize, 1u))
+    , m_hasNodes(static_cast<bool>(dataset.getVRNode()))
+{
+    const auto pMetadata = dataset.getVRMetadata();
+    if (!pMetadata || !dataset.getVRRefinements())
+        throw DatasetRequiresVariableResolution{};
+
+    m_pMetadata = pMetadata->getTable();
+
+    const auto numRows = m_pMetadata->getNumRows();
+    const auto numColumns = m_pMetadata->getNumColumns();
+    if (numRows == 0 || numColumns == 0)
+        return;
+
+    rowEnd = std::min(rowEnd, numRows - 1);
+    columnEnd = std::min(columnEnd, numColumns - 1);
+
+    for (auto row=rowStart; row<=rowEnd; ++row)
+    {
+        for (auto column=columnStart; column<=columnEnd; ++column)
+        {
+            const auto& item = m_pMetadata->get(row, column);
+            if (item.dimensions_x != 0 && item.dimensions_y != 0)
+                m_cells.push_back(row * numColumns + column);
+        }
+    }
+
+    this->sortCells();
+}
+
+//! Constructor.
+/*!
+    Walks a list of supergrid cells.  Cells that are not refined, or are
+    outside the supergrid, are left out, as are repeats.
+
+\param dataset
+    The variable resolution BAG to walk.
+\param cells
+    The cells, as (row, column).
+\param blockSize
+    The number of refinements read at a time; a cell with more is read
+    whole.
+*/
+VRCellIterator::VRCellIterator(
+    const Dataset& dataset,
+    const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+    uint32_t blockSize)
+    : m_pBagDataset(dataset.shared_from_this())
+    , m_blockSize(std::max(blockSize, 1u))
+    , m_hasNodes(static_cast<bool>(dataset.getVRNode()))
+{
+    const auto pMetadata = dataset.getVRMetadata();
+    if (!pMetadata || !dataset.getVRRefinements())
+        throw DatasetRequiresVariableResolution{};
+
+    m_pMetadata = pMetadata->getTable();
+
+    const auto numRows = m_pMetadata->getNumRows();
+    const auto numColumns = m_pMetadata->getNumColumns();
+
+    for (const auto& cell : cells)
+    {
+        if (cell.first >= numRows || cell.second >= numColumns)
+            continue;
+
+        const auto& item = m_pMetadata->get(cell.first, cell.second);
+        if (item.dimensions_x != 0 && item.dimensions_y != 0)
+            m_cells.push_back(cell.first * numColumns + cell.second);
+    }
+
+    std::sort(m_cells.begin(), m_cells.end());
+    m_cells.erase(std::unique(m_cells.begin(), m_cells.end()), m_cells.end());
+
+    this->sortCells();
+}
+
+//! Order the cells by their first refinement.
+void VRCellIterator::sortCells()
+{
+    // Cells are usually written in index order, so this is mostly sorted.
+    const auto* items = m_pMetadata->data();
+
+    std::stable_sort(m_cells.begin(), m_cells.end(),
+        [items](uint32_t lhs, uint32_t rhs) {
+            return items[lhs].index < items[rhs].index;
+        });
+}
+
+//! Retrieve the number of refined supergrid cells.
+/*!
+\return
+    The number of cells a walk visits.
+*/
+size_t VRCellIterator::size() const noexcept
+{
+    return m_cells.size();
+}
+
+//! Also read the keys of a georeferenced metadata layer.
+/*!
+    The keys of each cell are then in VRCell::keys.  The walk starts again
+    from the first cell.
+
+\param pLayer
+    The layer, which must have variable resolution keys; null to stop
+    reading keys.
+*/
+void VRCellIterator::setKeyLayer(
+    const GeorefMetadataLayer* pLayer)
+{
+    if (pLayer && !pLayer->hasVRKeys())
+        throw DatasetRequiresVariableResolution{};
+
+    m_pKeyLayer = pLayer;
+    m_keySize = pLayer ? pLayer->getDescriptor()->getElementSize() : 0;
+    m_keys.clear();
+
+    this->reset();
+}
+
+//! Move to the next refined supergrid cell.
+/*!
+\param cell
+    Set to the cell; its views remain valid until the next call.
+
+\return
+    \e true if there was another cell.
+    \e false if all the cells were visited.
+*/
+bool VRCellIterator::next(
+    VRCell& cell)
+{
+    if (m_next >= m_cells.size())
+        return false;
+
+    if (m_next >= m_blockEnd)
+        this->readBlock();
+
+    const auto position = m_cells[m_next++];
+    const auto& item = m_pMetadata->data()[position];
+    const auto offset = item.index - m_blockFirst;
+
+    cell.row = position / m_pMetadata->getNumColumns();
+    cell.column = position % m_pMetadata->getNumColumns();
+    cell.metadata = &item;
+    cell.refinements = m_refinements.data() + offset;
+    cell.nodes = m_hasNodes ? m_nodes.data() + offset : nullptr;
+    cell.keys = m_pKeyLayer ? m_keys.data() + offset * m_keySize : nullptr;
+    cell.count = item.dimensions_x * item.dimensions_y;
+
+    return true;
+}
+
+//! Start the walk again from the first cell.
+void VRCellIterator::reset() noexcept
+{
+    m_next = 0;
+    m_blockEnd = 0;
+}
+
+//! Read the refinements of the cells visited next.
+/*!
+    The block spans the next cell and as many of the following cells as
+    fit in the block size, with any refinements between them.
+*/
+void VRCellIterator::readBlock()
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto pRefinements = pDataset->getVRRefinements();
+    if (!pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto pNode = m_hasNodes ? pDataset->getVRNode() : nullptr;
+    if (m_hasNodes && !pNode)
+        throw DatasetRequiresVariableResolution{};
+
+    const auto* items = m_pMetadata->data();
+    const auto lastOf = [items](uint32_t position) {
+        const auto& item = items[position];
+        return static_cast<uint64_t>(item.index) +
+            static_cast<uint64_t>(item.dimensions_x) * item.dimensions_y - 1;
+    };
+
+    const auto first = items[m_cells[m_next]].index;
+    auto last = lastOf(m_cells[m_next]);
+
+    auto end = m_next + 1;
+    for (; end<m_cells.size(); ++end)
+    {
+        const auto cellLast = std::max(last, lastOf(m_cells[end]));
+        if (cellLast - first + 1 > m_blockSize)
+            break;
+
+        last = cellLast;
+    }
+
+    const auto count = static_cast<size_t>(last - first + 1);
+
+    m_refinements.resize(count);
+    if (m_hasNodes)
+        m_nodes.resize(count);
+
+    pRefinements->readInto(0, first, 0, static_cast<uint32_t>(last),
+        reinterpret_cast<uint8_t*>(m_refinements.data()),
+        count * sizeof(VRRefinementsItem));
+
+    if (pNode)
+        pNode->readInto(0, first, 0, static_cast<uint32_t>(last),
+            reinterpret_cast<uint8_t*>(m_nodes.data()),
+            count * sizeof(VRNodeItem));
+
+    if (m_pKeyLayer)
+    {
+        m_keys.resize(count * m_keySize);
+        m_pKeyLayer->readVRInto(first, static_cast<uint32_t>(last),
+            m_keys.data(), m_keys.size());
+    }
+
+    m_blockFirst = first;
+    m_blockEnd = end;
+}
+
+}  // namespace BAG
+
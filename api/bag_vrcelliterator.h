@@ -0,0 +1,131 @@
+#ifndef BAG_VRCELLITERATOR_H
+#define BAG_VRCELLITERATOR_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! A refined supergrid cell of a variable resolution BAG.
+/*!
+    The pointers are views into the buffers of the VRCellIterator that
+    yielded the cell; they remain valid until its next call to next() or
+    reset().  The metadata remains valid as long as the iterator.
+*/
+struct BAG_API VRCell final
+{
+    //! The supergrid row.
+    uint32_t row = 0;
+    //! The supergrid column.
+    uint32_t column = 0;
+    //! The VRMetadata item of the cell.
+    const VRMetadataItem* metadata = nullptr;
+    //! The refinements of the cell, row major; count of them.
+    const VRRefinementsItem* refinements = nullptr;
+    //! The VRNode items of the cell, as the refinements; null if the BAG
+    //! has no VRNode layer.
+    const VRNodeItem* nodes = nullptr;
+    //! The keys of the cell in the georeferenced metadata layer set by
+    //! VRCellIterator::setKeyLayer(), as the refinements; null if none is
+    //! set.
+    const uint8_t* keys = nullptr;
+    //! The number of refinements (and nodes and keys) of the cell.
+    uint32_t count = 0;
+};
+
+//! Walks the refined supergrid cells of a variable resolution BAG.
+/*!
+    The whole VRMetadata layer is loaded when the iterator is created, and
+    the refined cells, of the whole supergrid, a window of it or a list of
+    cells, are visited in the order of their first refinement.  The
+    refinements, the VRNode items if there are any, and the keys of a
+    georeferenced metadata layer if one is set, are read in contiguous
+    blocks spanning the cells visited next, so a walk of the BAG costs one
+    read per block instead of one per cell.  Cells are handed out as views
+    into the blocks, without copying them.
+
+    The iterator keeps the VRMetadataTable it was created with; create a
+    new one after writing to the VRMetadata layer.
+*/
+class BAG_API VRCellIterator final
+{
+public:
+    //! The default number of refinements read at a time.
+    static constexpr uint32_t kDefaultBlockSize = 65536;
+
+    explicit VRCellIterator(const Dataset& dataset,
+        uint32_t blockSize = kDefaultBlockSize);
+    VRCellIterator(const Dataset& dataset, uint32_t rowStart,
+        uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd,
+        uint32_t blockSize = kDefaultBlockSize);
+    VRCellIterator(const Dataset& dataset,
+        const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+        uint32_t blockSize = kDefaultBlockSize);
+
+    VRCellIterator(const VRCellIterator&) = delete;
+    VRCellIterator(VRCellIterator&&) = delete;
+
+    VRCellIterator& operator=(const VRCellIterator&) = delete;
+    VRCellIterator& operator=(VRCellIterator&&) = delete;
+
+    size_t size() const noexcept;
+
+    void setKeyLayer(const GeorefMetadataLayer* pLayer);
+
+    bool next(VRCell& cell);
+    void reset() noexcept;
+
+private:
+    void sortCells();
+    void readBlock();
+
+    //! The dataset.
+    std::weak_ptr<const Dataset> m_pBagDataset;
+    //! The VRMetadata layer.
+    std::shared_ptr<const VRMetadataTable> m_pMetadata;
+    //! The positions in the VRMetadata layer of the refined cells, in the
+    //! order of their first refinement.
+    std::vector<uint32_t> m_cells;
+    //! The number of refinements read at a time, unless a cell has more.
+    uint32_t m_blockSize = kDefaultBlockSize;
+    //! Does the BAG have a VRNode layer?
+    bool m_hasNodes = false;
+    //! The next cell, in m_cells.
+    size_t m_next = 0;
+    //! The end of the cells whose refinements are in the block, in m_cells.
+    size_t m_blockEnd = 0;
+    //! The index of the first refinement of the block.
+    uint32_t m_blockFirst = 0;
+    //! The refinements of the block.
+    std::vector<VRRefinementsItem> m_refinements;
+    //! The VRNode items of the block; empty if there are none.
+    std::vector<VRNodeItem> m_nodes;
+    //! The georeferenced metadata layer whose keys are read; may be null.
+    const GeorefMetadataLayer* m_pKeyLayer = nullptr;
+    //! The size of a key of the key layer, in bytes.
+    size_t m_keySize = 0;
+    //! The keys of the block; empty if there is no key layer.
+    std::vector<uint8_t> m_keys;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_VRCELLITERATOR_H
+
@@ -0,0 +1,454 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_vrindex.h"
+#include "bag_vrmetadata.h"
+#include "bag_vrrefinements.h"
+#include "bag_vrtrackinglist.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace BAG {
+
+namespace {
+
+//! The largest gap, in refinements, bridged when merging batch reads.
+/*!
+    Reading a few unwanted refinements is cheaper than another HDF5 read.
+*/
+constexpr uint32_t kMaxReadGap = 512;
+
+//! Find the nearest of a number of evenly spaced positions.
+/*!
+\param position
+    The position.
+\param origin
+    The first of the evenly spaced positions.
+\param spacing
+    The distance between the evenly spaced positions.
+\param count
+    The number of evenly spaced positions.
+\param index
+    Set to the index of the nearest evenly spaced position.
+
+\return
+    \e true if the position is within half a spacing of one of them.
+    \e false otherwise.
+*/
+bool findNearest(
+    double position,
+    double origin,
+    double spacing,
+    uint32_t count,
+    uint32_t& index) noexcept
+{
+    if (count == 0 || !(spacing > 0.))
+        return false;
+
+    const auto nearest = std::floor((position - origin) / spacing + 0.5);
+    if (!(nearest >= 0.) || nearest >= count)
+        return false;
+
+    index = static_cast<uint32_t>(nearest);
+
+    return true;
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+\param dataset
+    The variable resolution BAG to index.
+*/
+VRIndex::VRIndex(
+    const Dataset& dataset)
+    : m_pBagDataset(dataset.shared_from_this())
+{
+    const auto pMetadata = dataset.getVRMetadata();
+    if (!pMetadata || !dataset.getVRRefinements())
+        throw DatasetRequiresVariableResolution{};
+
+    const auto& descriptor = dataset.getDescriptor();
+
+    std::tie(m_originX, m_originY) = descriptor.getOrigin();
+    std::tie(m_spacingX, m_spacingY) = descriptor.getGridSpacing();
+
+    m_pMetadata = pMetadata->getTable();
+
+    const auto pTrackingList = dataset.getVRTrackingList();
+    if (pTrackingList)
+        m_pTrackingTable = pTrackingList->getTable();
+}
+
+//! Find the refinement nearest to a position, without reading it.
+/*!
+    The position is first placed in the supergrid cell whose node is
+    nearest, then on the nearest refined node of that cell.
+
+\param x
+    The easting.
+\param y
+    The northing.
+
+\return
+    The supergrid cell and refinement index; the item and tracking list
+    items are not filled in.
+    VRPointResult::found is \e false if the position is outside the BAG or
+    its supergrid cell is not refined.
+*/
+VRPointResult VRIndex::locate(
+    double x,
+    double y) const noexcept
+{
+    VRPointResult result;
+
+    if (!findNearest(x, m_originX, m_spacingX, m_pMetadata->getNumColumns(),
+            result.column) ||
+        !findNearest(y, m_originY, m_spacingY, m_pMetadata->getNumRows(),
+            result.row))
+        return result;
+
+    const auto& item = m_pMetadata->get(result.row, result.column);
+
+    if (item.dimensions_x == 0 || item.dimensions_y == 0)
+        return result;
+
+    // The refined nodes start sw_corner from the south west corner of the
+    // supergrid cell, which is half a cell from its node.
+    const auto cellX = m_originX + result.column * m_spacingX - m_spacingX / 2.;
+    const auto cellY = m_originY + result.row * m_spacingY - m_spacingY / 2.;
+
+    const auto refinedX = (x - (cellX + item.sw_corner_x)) / item.resolution_x;
+    const auto refinedY = (y - (cellY + item.sw_corner_y)) / item.resolution_y;
+
+    if (!std::isfinite(refinedX) || !std::isfinite(refinedY))
+        return result;
+
+    const auto column = static_cast<uint32_t>(std::min(std::max(
+        std::floor(refinedX + 0.5), 0.), item.dimensions_x - 1.));
+    const auto row = static_cast<uint32_t>(std::min(std::max(
+        std::floor(refinedY + 0.5), 0.), item.dimensions_y - 1.));
+
+    result.found = true;
+    result.subRow = row;
+    result.subColumn = column;
+    result.refinementIndex = item.index + row * item.dimensions_x + column;
+
+    return result;
+}
+
+//! Look up the refinement nearest to a position.
+/*!
+\param x
+    The easting.
+\param y
+    The northing.
+
+\return
+    The refinement.
+    VRPointResult::found is \e false if the position is outside the BAG or
+    its supergrid cell is not refined.
+*/
+VRPointResult VRIndex::queryPoint(
+    double x,
+    double y) const
+{
+    auto result = this->locate(x, y);
+
+    if (result.found)
+    {
+        const auto buffer = this->readRefinements(result.refinementIndex,
+            result.refinementIndex);
+        result.item = *reinterpret_cast<const VRRefinementsItem*>(buffer.data());
+
+        this->addTrackingItems(result);
+    }
+
+    return result;
+}
+
+//! Look up the refinements nearest to many positions.
+/*!
+    The refinements are read in order of their index, with nearby indices
+    merged into one read, so positions close to each other cost one read.
+
+\param points
+    The positions.
+
+\return
+    The refinement of each position, in the same order as points.
+*/
+std::vector<VRPointResult> VRIndex::queryPoints(
+    const std::vector<VRPoint>& points) const
+{
+    std::vector<VRPointResult> results;
+    results.reserve(points.size());
+
+    std::vector<size_t> order;
+    order.reserve(points.size());
+
+    for (const auto& point : points)
+    {
+        results.push_back(this->locate(point.x, point.y));
+
+        if (results.back().found)
+            order.push_back(results.size() - 1);
+    }
+
+    std::sort(order.begin(), order.end(), [&results](size_t lhs, size_t rhs) {
+        return results[lhs].refinementIndex < results[rhs].refinementIndex;
+    });
+
+    for (size_t begin=0; begin<order.size(); )
+    {
+        const auto first = results[order[begin]].refinementIndex;
+        auto last = first;
+
+        auto end = begin + 1;
+        for (; end<order.size(); ++end)
+        {
+            const auto index = results[order[end]].refinementIndex;
+            if (index - last > kMaxReadGap)
+                break;
+
+            last = index;
+        }
+
+        const auto buffer = this->readRefinements(first, last);
+        const auto* items =
+            reinterpret_cast<const VRRefinementsItem*>(buffer.data());
+
+        for (; begin<end; ++begin)
+        {
+            auto& result = results[order[begin]];
+            result.item = items[result.refinementIndex - first];
+
+            this->addTrackingItems(result);
+        }
+    }
+
+    return results;
+}
+
+//! Sample the refinements at many positions.
+/*!
+    Each position is placed in the supergrid cell whose node is nearest, and
+    sampled from the refined nodes of that cell only; positions between the
+    outer refined nodes of a cell and its edge use the nearest outer nodes,
+    as VRResampler does.  The refinements needed are read in order of their
+    index, with nearby indices merged into one read.
+
+    The depth and uncertainty are interpolated on their own: null refined
+    nodes are left out, and the weights of the rest rescaled.  A position
+    outside the BAG, in an unrefined cell, or with only null nodes around it
+    is BAG_NULL_ELEVATION and BAG_NULL_UNCERTAINTY.
+
+    An InvalidSamplePositions exception is thrown if xs and ys are not the
+    same size.
+
+\param xs
+    The easting of each position.
+\param ys
+    The northing of each position.
+\param method
+    How the value at a position is found from the refined nodes around it.
+
+\return
+    The depth and uncertainty at each position, in the order of the
+    positions.
+*/
+std::vector<VRRefinementsItem> VRIndex::sample(
+    const std::vector<double>& xs,
+    const std::vector<double>& ys,
+    SampleMethod method) const
+{
+    if (xs.size() != ys.size())
+        throw InvalidSamplePositions{};
+
+    constexpr size_t kNumCorners = 4;
+    const auto numPositions = xs.size();
+
+    // The refinements around each position, and their weights; a weight of 0
+    // leaves the refinement out.
+    std::vector<uint32_t> indices(numPositions * kNumCorners, 0);
+    std::vector<double> weights(numPositions * kNumCorners, 0.);
+
+    for (size_t i=0; i<numPositions; ++i)
+    {
+        uint32_t row = 0, column = 0;
+        if (!findNearest(xs[i], m_originX, m_spacingX,
+                m_pMetadata->getNumColumns(), column) ||
+            !findNearest(ys[i], m_originY, m_spacingY,
+                m_pMetadata->getNumRows(), row))
+            continue;
+
+        const auto& item = m_pMetadata->get(row, column);
+        if (item.dimensions_x == 0 || item.dimensions_y == 0)
+            continue;
+
+        const auto cellX = m_originX + column * m_spacingX - m_spacingX / 2.;
+        const auto cellY = m_originY + row * m_spacingY - m_spacingY / 2.;
+
+        const auto refinedX = (xs[i] - (cellX + item.sw_corner_x)) /
+            item.resolution_x;
+        const auto refinedY = (ys[i] - (cellY + item.sw_corner_y)) /
+            item.resolution_y;
+
+        if (!std::isfinite(refinedX) || !std::isfinite(refinedY))
+            continue;
+
+        const auto fx = std::min(std::max(refinedX, 0.),
+            item.dimensions_x - 1.);
+        const auto fy = std::min(std::max(refinedY, 0.),
+            item.dimensions_y - 1.);
+
+        auto* cornerIndices = indices.data() + i * kNumCorners;
+        auto* cornerWeights = weights.data() + i * kNumCorners;
+
+        if (method == SampleMethod::Nearest)
+        {
+            cornerIndices[0] = item.index +
+                static_cast<uint32_t>(std::floor(fy + 0.5)) *
+                    item.dimensions_x +
+                static_cast<uint32_t>(std::floor(fx + 0.5));
+            cornerWeights[0] = 1.;
+            continue;
+        }
+
+        const auto column0 = static_cast<uint32_t>(fx);
+        const auto row0 = static_cast<uint32_t>(fy);
+        const auto column1 = std::min(column0 + 1, item.dimensions_x - 1);
+        const auto row1 = std::min(row0 + 1, item.dimensions_y - 1);
+
+        const auto tx = fx - column0;
+        const auto ty = fy - row0;
+
+        cornerIndices[0] = item.index + row0 * item.dimensions_x + column0;
+        cornerIndices[1] = item.index + row0 * item.dimensions_x + column1;
+        cornerIndices[2] = item.index + row1 * item.dimensions_x + column0;
+        cornerIndices[3] = item.index + row1 * item.dimensions_x + column1;
+        cornerWeights[0] = (1. - tx) * (1. - ty);
+        cornerWeights[1] = tx * (1. - ty);
+        cornerWeights[2] = (1. - tx) * ty;
+        cornerWeights[3] = tx * ty;
+    }
+
+    std::vector<size_t> order;
+    for (size_t corner=0; corner<weights.size(); ++corner)
+        if (weights[corner] > 0.)
+            order.push_back(corner);
+
+    std::sort(order.begin(), order.end(), [&indices](size_t lhs, size_t rhs) {
+        return indices[lhs] < indices[rhs];
+    });
+
+    std::vector<VRRefinementsItem> corners(indices.size());
+
+    for (size_t begin=0; begin<order.size(); )
+    {
+        const auto first = indices[order[begin]];
+        auto last = first;
+
+        auto end = begin + 1;
+        for (; end<order.size(); ++end)
+        {
+            const auto index = indices[order[end]];
+            if (index - last > kMaxReadGap)
+                break;
+
+            last = index;
+        }
+
+        const auto buffer = this->readRefinements(first, last);
+        const auto* items =
+            reinterpret_cast<const VRRefinementsItem*>(buffer.data());
+
+        for (; begin<end; ++begin)
+            corners[order[begin]] = items[indices[order[begin]] - first];
+    }
+
+    std::vector<VRRefinementsItem> results(numPositions,
+        VRRefinementsItem{BAG_NULL_ELEVATION, BAG_NULL_UNCERTAINTY});
+
+    for (size_t i=0; i<numPositions; ++i)
+    {
+        double depth = 0., depthWeights = 0.;
+        double uncertainty = 0., uncertaintyWeights = 0.;
+
+        for (size_t corner=i * kNumCorners; corner<(i + 1) * kNumCorners;
+            ++corner)
+        {
+            const auto weight = weights[corner];
+            if (!(weight > 0.))
+                continue;
+
+            const auto& item = corners[corner];
+            if (item.depth != BAG_NULL_ELEVATION)
+            {
+                depth += weight * item.depth;
+                depthWeights += weight;
+            }
+            if (item.depth_uncrt != BAG_NULL_UNCERTAINTY)
+            {
+                uncertainty += weight * item.depth_uncrt;
+                uncertaintyWeights += weight;
+            }
+        }
+
+        if (depthWeights > 0.)
+            results[i].depth = static_cast<float>(depth / depthWeights);
+        if (uncertaintyWeights > 0.)
+            results[i].depth_uncrt = static_cast<float>(uncertainty /
+                uncertaintyWeights);
+    }
+
+    return results;
+}
+
+//! Fill in the tracking list items of a refinement that was found.
+/*!
+\param result
+    The refinement.
+*/
+void VRIndex::addTrackingItems(
+    VRPointResult& result) const
+{
+    if (!m_pTrackingTable)
+        return;
+
+    const auto items = m_pTrackingTable->getItemsAtSubNode(result.row,
+        result.column, result.subRow, result.subColumn);
+
+    result.trackingItems.assign(items.first, items.second);
+}
+
+//! Read a range of refinements.
+/*!
+\param first
+    The first refinement.
+\param last
+    The last refinement (inclusive).
+
+\return
+    The refinements.
+*/
+UInt8Array VRIndex::readRefinements(
+    uint32_t first,
+    uint32_t last) const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto pRefinements = pDataset->getVRRefinements();
+    if (!pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    return pRefinements->read(0, first, 0, last);
+}
+
+}  // namespace BAG
+
@@ -0,0 +1,108 @@
+#ifndef BAG_VRINDEX_H
+#define BAG_VRINDEX_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+#include "bag_uint8array.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! A geographic position to look up in a variable resolution BAG.
+struct BAG_API VRPoint final
+{
+    //! The easting.
+    double x = 0.;
+    //! The northing.
+    double y = 0.;
+};
+
+//! The refinement nearest to a geographic position.
+struct BAG_API VRPointResult final
+{
+    //! Is the position in a refined supergrid cell?
+    bool found = false;
+    //! The supergrid row.
+    uint32_t row = 0;
+    //! The supergrid column.
+    uint32_t column = 0;
+    //! The row of the refinement within the refined grid of the cell.
+    uint32_t subRow = 0;
+    //! The column of the refinement within the refined grid of the cell.
+    uint32_t subColumn = 0;
+    //! The index of the refinement in the VRRefinements layer.
+    uint32_t refinementIndex = 0;
+    //! The refinement.
+    VRRefinementsItem item{};
+    //! The tracking list items of the refinement, in the order of the list.
+    std::vector<VRTrackingItem> trackingItems;
+};
+
+//! Looks up the refinements of a variable resolution BAG by position.
+/*!
+    The whole VRMetadata layer is loaded when the index is created, so
+    locating the refinement under a position needs no further reads.  Only
+    the refinements themselves are read per query.  The tracking list items
+    of each refinement found come from the VRTrackingTable of the tracking
+    list.
+
+    The index keeps the VRMetadataTable and VRTrackingTable it was created
+    with; create a new one after writing to the VRMetadata layer or changing
+    the tracking list.
+*/
+class BAG_API VRIndex final
+{
+public:
+    explicit VRIndex(const Dataset& dataset);
+
+    VRIndex(const VRIndex&) = delete;
+    VRIndex(VRIndex&&) = delete;
+
+    VRIndex& operator=(const VRIndex&) = delete;
+    VRIndex& operator=(VRIndex&&) = delete;
+
+    VRPointResult queryPoint(double x, double y) const;
+    std::vector<VRPointResult> queryPoints(
+        const std::vector<VRPoint>& points) const;
+
+    VRPointResult locate(double x, double y) const noexcept;
+
+    std::vector<VRRefinementsItem> sample(const std::vector<double>& xs,
+        const std::vector<double>& ys,
+        SampleMethod method = SampleMethod::Bilinear) const;
+
+private:
+    UInt8Array readRefinements(uint32_t first, uint32_t last) const;
+    void addTrackingItems(VRPointResult& result) const;
+
+    //! The dataset.
+    std::weak_ptr<const Dataset> m_pBagDataset;
+    //! The VRMetadata layer.
+    std::shared_ptr<const VRMetadataTable> m_pMetadata;
+    //! The tracking list, grouped by node; null if there is none.
+    std::shared_ptr<const VRTrackingTable> m_pTrackingTable;
+    //! The position of the south west supergrid node.
+    double m_originX = 0., m_originY = 0.;
+    //! The supergrid spacing.
+    double m_spacingX = 0., m_spacingY = 0.;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_VRINDEX_H
+
@@ -1,5 +1,7 @@
 
+#include "bag_dataset.h"
 #include "bag_hdfhelper.h"
+#include "bag_minmax.h"
 #include "bag_private.h"
 #include "bag_vrmetadata.h"
 #include "bag_vrmetadatadescriptor.h"
@@ -40,30 +42,6 @@ namespace {
     return memDataType;
 }
 
-//! Read an HDF5 attribute.
-/*!
-\param h5file
-    The HDF5 file.
-\param name
-    The name of the attribute.
-
-\return
-    The value in the attribute.
-*/
-template<typename T>
-T readAttribute(
-    const ::H5::H5File& h5file,
-    const char* const name)
-{
-    const auto h5DataSet = h5file.openDataSet(VR_METADATA_PATH);
-    const auto attribute = h5DataSet.openAttribute(name);
-
-    T value{};
-    attribute.read(attribute.getDataType(), &value);
-
-    return value;
-}
-
 }  // namespace
 
 //! Constructor
@@ -80,6 +58,7 @@ VRMetadata::VRMetadata(
     VRMetadataDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(pH5dataSet))
 {
 }
@@ -92,7 +71,7 @@ VRMetadata::VRMetadata(
 */
 std::shared_ptr<VRMetadataDescriptor> VRMetadata::getDescriptor() & noexcept
 {
-    return std::dynamic_pointer_cast<VRMetadataDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<VRMetadataDescriptor>(Layer::getDescriptor());
 }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -102,7 +81,7 @@ std::shared_ptr<VRMetadataDescriptor> VRMetadata::getDescriptor() & noexcept
     Will never be nullptr.
 */
 std::shared_ptr<const VRMetadataDescriptor> VRMetadata::getDescriptor() const & noexcept {
-    return std::dynamic_pointer_cast<const VRMetadataDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<const VRMetadataDescriptor>(Layer::getDescriptor());
 }
 
 //! Create a new variable resolution metadata layer.
@@ -111,8 +90,8 @@ std::shared_ptr<const VRMetadataDescriptor> VRMetadata::getDescriptor() const &
     The BAG Dataset this layer belongs to.
 \param chunkSize
     The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
 
 \return
     The new variable resolution metadata.
@@ -120,10 +99,11 @@ std::shared_ptr<const VRMetadataDescriptor> VRMetadata::getDescriptor() const &
 std::shared_ptr<VRMetadata> VRMetadata::create(
     Dataset& dataset,
     uint64_t chunkSize,
-    int compressionLevel)
+    const CompressionSpec& compression)
 {
     auto descriptor = VRMetadataDescriptor::create(dataset, chunkSize,
-        compressionLevel);
+        compression.level);
+    descriptor->setCompressionSpec(compression);
 
     auto h5dataSet = VRMetadata::createH5dataSet(dataset, *descriptor);
 
@@ -136,7 +116,8 @@ std::shared_ptr<VRMetadata> VRMetadata::create(
 \param dataset
     The BAG Dataset this layer belongs to.
 \param descriptor
-    The descriptor of this layer.
+    The descriptor of this layer; its attributes were read when the BAG
+    was opened.
 
 \return
     The variable resolution metadata.
@@ -147,29 +128,9 @@ std::shared_ptr<VRMetadata> VRMetadata::open(
 {
     auto& h5file = dataset.getH5file();
 
-    // Read the attribute values from the file and set in the descriptor.
-    const auto minDimsX = readAttribute<uint32_t>(h5file, VR_METADATA_MIN_DIMS_X);
-    const auto minDimsY = readAttribute<uint32_t>(h5file, VR_METADATA_MIN_DIMS_Y);
-
-    descriptor.setMinDimensions(minDimsX, minDimsY);
-
-    const auto maxDimsX = readAttribute<uint32_t>(h5file, VR_METADATA_MAX_DIMS_X);
-    const auto maxDimsY = readAttribute<uint32_t>(h5file, VR_METADATA_MAX_DIMS_Y);
-
-    descriptor.setMaxDimensions(maxDimsX, maxDimsY);
-
-    const auto minResX = readAttribute<float>(h5file, VR_METADATA_MIN_RES_X);
-    const auto minResY = readAttribute<float>(h5file, VR_METADATA_MIN_RES_Y);
-
-    descriptor.setMinResolution(minResX, minResY);
-
-    const auto maxResX = readAttribute<float>(h5file, VR_METADATA_MAX_RES_X);
-    const auto maxResY = readAttribute<float>(h5file, VR_METADATA_MAX_RES_Y);
-
-    descriptor.setMaxResolution(maxResX, maxResY);
-
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(VR_METADATA_PATH)},
+        new ::H5::DataSet{h5file.openDataSet(VR_METADATA_PATH,
+            dataset.getH5dataSetAccessPropList(VarRes_Metadata))},
             DeleteH5dataSet{});
 
     return std::make_shared<VRMetadata>(dataset,
@@ -200,17 +161,16 @@ VRMetadata::createH5dataSet(
     const ::H5::DSetCreatPropList h5createPropList{};
 
     // Use chunk size and compression level from the descriptor.
-    const auto compressionLevel = descriptor.getCompressionLevel();
+    const auto& compression = descriptor.getCompressionSpec();
     const auto chunkSize = descriptor.getChunkSize();
     if (chunkSize > 0)
     {
     	std::array<hsize_t, kRank> chunkDims{chunkSize, chunkSize};
         h5createPropList.setChunk(kRank, chunkDims.data());
 
-        if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-            h5createPropList.setDeflate(compressionLevel);
+        setCompression(h5createPropList, compression);
     }
-    else if (compressionLevel > 0)
+    else if (compression.isCompressed())
         throw CompressionNeedsChunkingSet{};
     else
         throw LayerRequiresChunkingSet{};
@@ -261,11 +221,6 @@ UInt8Array VRMetadata::readProxy(
     uint32_t rowEnd,
     uint32_t columnEnd) const
 {
-    auto pDescriptor = std::dynamic_pointer_cast<const VRMetadataDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     // Query the file for the specified rows and columns.
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
@@ -275,8 +230,8 @@ UInt8Array VRMetadata::readProxy(
     const auto fileDataSpace = m_pH5dataSet->getSpace();
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
 
-    const auto bufferSize = pDescriptor->getReadBufferSize(rows, columns);
-    UInt8Array buffer{bufferSize};
+    const auto bufferSize = m_descriptor.getReadBufferSize(rows, columns);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
 
     const ::H5::DataSpace memDataSpace{kRank, count.data(), count.data()};
 
@@ -290,14 +245,9 @@ UInt8Array VRMetadata::readProxy(
 //! \copydoc Layer::writeAttributes
 void VRMetadata::writeAttributesProxy() const
 {
-    auto pDescriptor = std::dynamic_pointer_cast<const VRMetadataDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     // Write the attributes from the layer descriptor.
     // min X,Y dimensions
-    const auto minDims = pDescriptor->getMinDimensions();
+    const auto minDims = m_descriptor.getMinDimensions();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_UINT32,
         std::get<0>(minDims), VR_METADATA_MIN_DIMS_X);
 
@@ -305,7 +255,7 @@ void VRMetadata::writeAttributesProxy() const
         std::get<1>(minDims), VR_METADATA_MIN_DIMS_Y);
 
     // max X,Y dimensions
-    const auto maxDims = pDescriptor->getMaxDimensions();
+    const auto maxDims = m_descriptor.getMaxDimensions();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_UINT32,
         std::get<0>(maxDims), VR_METADATA_MAX_DIMS_X);
 
@@ -313,7 +263,7 @@ void VRMetadata::writeAttributesProxy() const
         std::get<1>(maxDims), VR_METADATA_MAX_DIMS_Y);
 
     // min X,Y resolution
-    const auto minRes = pDescriptor->getMinResolution();
+    const auto minRes = m_descriptor.getMinResolution();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_FLOAT,
         std::get<0>(minRes), VR_METADATA_MIN_RES_X);
 
@@ -321,7 +271,7 @@ void VRMetadata::writeAttributesProxy() const
         std::get<1>(minRes), VR_METADATA_MIN_RES_Y);
 
     // max X,Y resolution
-    const auto maxRes = pDescriptor->getMaxResolution();
+    const auto maxRes = m_descriptor.getMaxResolution();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_FLOAT,
         std::get<0>(maxRes), VR_METADATA_MAX_RES_X);
 
@@ -337,10 +287,7 @@ void VRMetadata::writeProxy(
     uint32_t columnEnd,
     const uint8_t* buffer)
 {
-    auto pDescriptor = std::dynamic_pointer_cast<VRMetadataDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
+    const auto lock = this->getDataset().lock()->lockWrites();
 
     const auto rows = (rowEnd - rowStart) + 1;
     const auto columns = (columnEnd - columnStart) + 1;
@@ -381,46 +328,232 @@ void VRMetadata::writeProxy(
 
     m_pH5dataSet->write(buffer, memDataType, memDataSpace, fileDataSpace);
 
+    // Tables already handed out keep the old metadata.
+    m_pTable.reset();
+
     // Update any attributes that are affected by the data being written.
     // Get the current min/max from descriptor.
     uint32_t minDimX = 0, minDimY = 0;
-    std::tie(minDimX, minDimY) = pDescriptor->getMinDimensions();
+    std::tie(minDimX, minDimY) = m_descriptor.getMinDimensions();
 
     uint32_t maxDimX = 0, maxDimY = 0;
-    std::tie(maxDimX, maxDimY) = pDescriptor->getMaxDimensions();
+    std::tie(maxDimX, maxDimY) = m_descriptor.getMaxDimensions();
 
     float minResX = 0.f, minResY = 0.f;
-    std::tie(minResX, minResY) = pDescriptor->getMinResolution();
+    std::tie(minResX, minResY) = m_descriptor.getMinResolution();
 
     float maxResX = 0.f, maxResY = 0.f;
-    std::tie(maxResX, maxResY) = pDescriptor->getMaxResolution();
+    std::tie(maxResX, maxResY) = m_descriptor.getMaxResolution();
+
+    // Update the min/max from new data, ignoring nulls.
+    const auto mm = computeMinMax(
+        reinterpret_cast<const VRMetadataItem*>(buffer), rows * columns);
+
+    mm.dimX.mergeInto(minDimX, maxDimX);
+    mm.dimY.mergeInto(minDimY, maxDimY);
+    mm.resX.mergeInto(minResX, maxResX);
+    mm.resY.mergeInto(minResY, maxResY);
+
+    m_descriptor.setMinDimensions(minDimX, minDimY);
+    m_descriptor.setMaxDimensions(maxDimX, maxDimY);
+    m_descriptor.setMinResolution(minResX, minResY);
+    m_descriptor.setMaxResolution(maxResX, maxResY);
+}
+
+//! Retrieve the whole layer, reading it the first time.
+/*!
+    The layer is read in one go, covering the dimensions of the HDF5 DataSet
+    rather than those of the BAG.  Later calls share the same table until
+    the layer is written to.
 
-    // Update the min/max from new data.
-    const auto* items = reinterpret_cast<const VRMetadataItem*>(buffer);
+\return
+    The table.
+*/
+std::shared_ptr<const VRMetadataTable> VRMetadata::getTable() const
+{
+    auto pDataset = this->getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
 
-    auto* item = items;
-    const auto end = items + rows * columns;
+    const auto lock = pDataset->lockReads();
+    pDataset->releaseRequestedCaches();
 
-    for (; item != end; ++item)
+    if (!m_pTable)
     {
-        minDimX = item->dimensions_x < minDimX ? item->dimensions_x : minDimX;
-        minDimY = item->dimensions_y < minDimY ? item->dimensions_y : minDimY;
+        std::array<hsize_t, kRank> fileDims{};
+        m_pH5dataSet->getSpace().getSimpleExtentDims(fileDims.data());
 
-        maxDimX = item->dimensions_x > maxDimX ? item->dimensions_x : maxDimX;
-        maxDimY = item->dimensions_y > maxDimY ? item->dimensions_y : maxDimY;
+        const auto numRows = static_cast<uint32_t>(fileDims[0]);
+        const auto numColumns = static_cast<uint32_t>(fileDims[1]);
 
-        minResX = item->resolution_x < minResX ? item->resolution_x : minResX;
-        minResY = item->resolution_y < minResY ? item->resolution_y : minResY;
+        UInt8Array items;
+        if (numRows > 0 && numColumns > 0)
+            items = this->readProxy(0, 0, numRows - 1, numColumns - 1);
 
-        maxResX = item->resolution_x > maxResX ? item->resolution_x : maxResX;
-        maxResY = item->resolution_y > maxResY ? item->resolution_y : maxResY;
+        m_pTable = std::shared_ptr<const VRMetadataTable>(new VRMetadataTable{
+            std::move(items), numRows, numColumns});
+        pDataset->reportCacheUsage();
     }
 
-    pDescriptor->setMinDimensions(minDimX, minDimY);
-    pDescriptor->setMaxDimensions(maxDimX, maxDimY);
-    pDescriptor->setMinResolution(minResX, minResY);
-    pDescriptor->setMaxResolution(maxResX, maxResY);
+    return m_pTable;
 }
 
-}   //namespace BAG
+//! Retrieve the memory held by the table of the whole layer.
+/*!
+\return
+    The memory held, in bytes; 0 if the table has not been read.
+*/
+uint64_t VRMetadata::getCacheBytes() const noexcept
+{
+    if (!m_pTable)
+        return 0;
+
+    return sizeof(VRMetadataTable) + m_pTable->m_items.size() +
+        m_pTable->m_refinementOffsets.capacity() * sizeof(uint64_t);
+}
 
+//! Discard the table of the whole layer.
+/*!
+    It is read again when next needed.  Tables handed out stay valid.
+*/
+void VRMetadata::releaseCaches() const noexcept
+{
+    m_pTable.reset();
+}
+
+//! Constructor.
+/*!
+\param items
+    The items, row major.
+\param numRows
+    The number of supergrid rows.
+\param numColumns
+    The number of supergrid columns.
+*/
+VRMetadataTable::VRMetadataTable(
+    UInt8Array items,
+    uint32_t numRows,
+    uint32_t numColumns)
+    : m_items(std::move(items))
+    , m_numRows(numRows)
+    , m_numColumns(numColumns)
+{
+    const auto numItems = this->size();
+    const auto* pItems = this->data();
+
+    m_refinementOffsets.resize(numItems + 1);
+    m_refinementOffsets[0] = 0;
+
+    for (size_t i=0; i<numItems; ++i)
+        m_refinementOffsets[i + 1] = m_refinementOffsets[i] +
+            static_cast<uint64_t>(pItems[i].dimensions_x) * pItems[i].dimensions_y;
+}
+
+//! Retrieve the items.
+/*!
+\return
+    The items, row major.
+*/
+const VRMetadataItem* VRMetadataTable::data() const noexcept
+{
+    return reinterpret_cast<const VRMetadataItem*>(m_items.data());
+}
+
+//! Retrieve the first item.
+/*!
+\return
+    The first item.
+*/
+const VRMetadataItem* VRMetadataTable::begin() const noexcept
+{
+    return this->data();
+}
+
+//! Retrieve one past the last item.
+/*!
+\return
+    One past the last item.
+*/
+const VRMetadataItem* VRMetadataTable::end() const noexcept
+{
+    return this->data() + this->size();
+}
+
+//! Retrieve the number of items.
+/*!
+\return
+    The number of items; one per supergrid cell.
+*/
+size_t VRMetadataTable::size() const noexcept
+{
+    return static_cast<size_t>(m_numRows) * m_numColumns;
+}
+
+//! Retrieve the number of supergrid rows.
+/*!
+\return
+    The number of supergrid rows.
+*/
+uint32_t VRMetadataTable::getNumRows() const noexcept
+{
+    return m_numRows;
+}
+
+//! Retrieve the number of supergrid columns.
+/*!
+\return
+    The number of supergrid columns.
+*/
+uint32_t VRMetadataTable::getNumColumns() const noexcept
+{
+    return m_numColumns;
+}
+
+//! Retrieve the item of a supergrid cell.
+/*!
+\param row
+    The supergrid row.
+\param column
+    The supergrid column.
+
+\return
+    The item.
+*/
+const VRMetadataItem& VRMetadataTable::get(
+    uint32_t row,
+    uint32_t column) const noexcept
+{
+    return this->data()[static_cast<size_t>(row) * m_numColumns + column];
+}
+
+//! Count the refinements of the cells before a supergrid cell.
+/*!
+    Cells are counted in row major order.  In a BAG whose refinements are
+    stored in that order, this is where the refinements of the cell start.
+
+\param row
+    The supergrid row.
+\param column
+    The supergrid column.
+
+\return
+    The number of refinements of the cells before it.
+*/
+uint64_t VRMetadataTable::getRefinementOffset(
+    uint32_t row,
+    uint32_t column) const noexcept
+{
+    return m_refinementOffsets[static_cast<size_t>(row) * m_numColumns + column];
+}
+
+//! Count the refinements of every supergrid cell.
+/*!
+\return
+    The number of refinements.
+*/
+uint64_t VRMetadataTable::getNumRefinements() const noexcept
+{
+    return m_refinementOffsets.back();
+}
+
+}   //namespace BAG
@@ -5,8 +5,13 @@
 #include "bag_deleteh5dataset.h"
 #include "bag_fordec.h"
 #include "bag_layer.h"
+#include "bag_types.h"
+#include "bag_uint8array.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 
 namespace BAG {
@@ -16,6 +21,49 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! A read only, in memory copy of the whole variable resolution metadata.
+/*!
+    The items are row major, one per supergrid cell.  A running total of the
+    refinements of each cell is kept alongside, so the refinements of a
+    block of cells can be sized without visiting every item again.
+*/
+class BAG_API VRMetadataTable final
+{
+public:
+    VRMetadataTable(const VRMetadataTable&) = delete;
+    VRMetadataTable(VRMetadataTable&&) = delete;
+
+    VRMetadataTable& operator=(const VRMetadataTable&) = delete;
+    VRMetadataTable& operator=(VRMetadataTable&&) = delete;
+
+    const VRMetadataItem* data() const noexcept;
+    const VRMetadataItem* begin() const noexcept;
+    const VRMetadataItem* end() const noexcept;
+    size_t size() const noexcept;
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+
+    const VRMetadataItem& get(uint32_t row, uint32_t column) const noexcept;
+
+    uint64_t getRefinementOffset(uint32_t row, uint32_t column) const noexcept;
+    uint64_t getNumRefinements() const noexcept;
+
+private:
+    VRMetadataTable(UInt8Array items, uint32_t numRows, uint32_t numColumns);
+
+    //! The items, row major.
+    UInt8Array m_items;
+    //! The number of supergrid rows.
+    uint32_t m_numRows = 0;
+    //! The number of supergrid columns.
+    uint32_t m_numColumns = 0;
+    //! The number of refinements before each item; one extra for the total.
+    std::vector<uint64_t> m_refinementOffsets;
+
+    friend VRMetadata;
+};
+
 //! The interface for variable resolution metadata.
 class BAG_API VRMetadata final : public Layer
 {
@@ -41,9 +89,11 @@ public:
     std::shared_ptr<VRMetadataDescriptor> getDescriptor() & noexcept;
     std::shared_ptr<const VRMetadataDescriptor> getDescriptor() const & noexcept;
 
+    std::shared_ptr<const VRMetadataTable> getTable() const;
+
 protected:
     static std::shared_ptr<VRMetadata> create(Dataset& dataset,
-        uint64_t chunkSize, int compressionLevel);
+        uint64_t chunkSize, const CompressionSpec& compression);
 
     static std::shared_ptr<VRMetadata> open(Dataset& dataset,
         VRMetadataDescriptor& descriptor);
@@ -61,8 +111,15 @@ private:
 
     void writeAttributesProxy() const override;
 
+    uint64_t getCacheBytes() const noexcept;
+    void releaseCaches() const noexcept;
+
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    VRMetadataDescriptor& m_descriptor;
     //! The HDF5 DataSet the metadata wraps.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! The whole layer, read the first time it is needed.
+    mutable std::shared_ptr<const VRMetadataTable> m_pTable;
 
     friend Dataset;
 };
@@ -1,5 +1,6 @@
 
 #include "bag_hdfhelper.h"
+#include "bag_minmax.h"
 #include "bag_private.h"
 #include "bag_vrnode.h"
 #include "bag_vrnodedescriptor.h"
@@ -33,30 +34,6 @@ namespace {
     return memDataType;
 }
 
-//! Read an attribute from an HDF5 DataSet.
-/*!
-\param h5file
-    The HDF5 file.
-\param name
-    The name of the attribute.
-
-\return
-    The value in the specified attribute.
-*/
-template<typename T>
-T readAttribute(
-    const ::H5::H5File& h5file,
-    const char* const name)
-{
-    const auto h5DataSet = h5file.openDataSet(VR_NODE_PATH);
-    const auto attribute = h5DataSet.openAttribute(name);
-
-    T value{};
-    attribute.read(attribute.getDataType(), &value);
-
-    return value;
-}
-
 }  // namespace
 
 //! Constructor.
@@ -73,8 +50,12 @@ VRNode::VRNode(
     VRNodeDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> pH5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(pH5dataSet))
 {
+    hsize_t length = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&length);
+    m_length = length;
 }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -85,7 +66,7 @@ VRNode::VRNode(
 */
 std::shared_ptr<VRNodeDescriptor> VRNode::getDescriptor() & noexcept
 {
-    return std::dynamic_pointer_cast<VRNodeDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<VRNodeDescriptor>(Layer::getDescriptor());
 }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -95,7 +76,7 @@ std::shared_ptr<VRNodeDescriptor> VRNode::getDescriptor() & noexcept
     Will never be nullptr.
 */
 std::shared_ptr<const VRNodeDescriptor> VRNode::getDescriptor() const & noexcept {
-    return std::dynamic_pointer_cast<const VRNodeDescriptor>(Layer::getDescriptor());
+    return std::static_pointer_cast<const VRNodeDescriptor>(Layer::getDescriptor());
 }
 
 //! Create a variable resolution node.
@@ -104,8 +85,11 @@ std::shared_ptr<const VRNodeDescriptor> VRNode::getDescriptor() const & noexcept
     The BAG Dataset that this layer belongs to.
 \param chunkSize
     The chunk size in the HDF5 DataSet.
-\param compressionLevel
-    The compression level in the HDF5 DataSet.
+\param compression
+    The compression in the HDF5 DataSet.
+\param numReserved
+    The number of nodes to make room for, so writing them does not extend
+    the HDF5 DataSet; the room left is trimmed when the BAG is closed.
 
 \return
     The new variable resolution node.
@@ -113,15 +97,21 @@ std::shared_ptr<const VRNodeDescriptor> VRNode::getDescriptor() const & noexcept
 std::shared_ptr<VRNode> VRNode::create(
     Dataset& dataset,
     uint64_t chunkSize,
-    int compressionLevel)
+    const CompressionSpec& compression,
+    uint64_t numReserved)
 {
     auto descriptor = VRNodeDescriptor::create(dataset, chunkSize,
-        compressionLevel);
+        compression.level);
+    descriptor->setCompressionSpec(compression);
 
-    auto h5dataSet = VRNode::createH5dataSet(dataset, *descriptor);
+    auto h5dataSet = VRNode::createH5dataSet(dataset, *descriptor,
+        numReserved);
 
-    return std::make_shared<VRNode>(dataset,
+    auto pLayer = std::make_shared<VRNode>(dataset,
         *descriptor, std::move(h5dataSet));
+    pLayer->m_length = 0;
+
+    return pLayer;
 }
 
 //! Open an existing variable resolution node.
@@ -129,7 +119,8 @@ std::shared_ptr<VRNode> VRNode::create(
 \param dataset
     The BAG Dataset that this layer belongs to.
 \param descriptor
-    The descriptor of this layer.
+    The descriptor of this layer; its attributes were read when the BAG
+    was opened.
 
 \return
     The specified variable resolution node.
@@ -140,33 +131,9 @@ std::shared_ptr<VRNode> VRNode::open(
 {
     auto& h5file = dataset.getH5file();
 
-    // Read the attribute values from the file and set in the descriptor.
-    // min/max hyp strength
-    const auto minHypStrength = readAttribute<float>(h5file,
-        VR_NODE_MIN_HYP_STRENGTH);
-    const auto maxHypStrength = readAttribute<float>(h5file,
-        VR_NODE_MAX_HYP_STRENGTH);
-
-    descriptor.setMinMaxHypStrength(minHypStrength, maxHypStrength);
-
-    // min/max num hypotheses
-    const auto minNumHypotheses = readAttribute<uint32_t>(h5file,
-        VR_NODE_MIN_NUM_HYPOTHESES);
-    const auto maxNumHypotheses = readAttribute<uint32_t>(h5file,
-        VR_NODE_MAX_NUM_HYPOTHESES);
-
-    descriptor.setMinMaxNumHypotheses(minNumHypotheses, maxNumHypotheses);
-
-    // min/max n samples
-    const auto minNSamples = readAttribute<uint32_t>(h5file,
-        VR_NODE_MIN_N_SAMPLES);
-    const auto maxNSamples = readAttribute<uint32_t>(h5file,
-        VR_NODE_MAX_N_SAMPLES);
-
-    descriptor.setMinMaxNSamples(minNSamples, maxNSamples);
-
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(VR_REFINEMENT_PATH)},
+        new ::H5::DataSet{h5file.openDataSet(VR_NODE_PATH,
+            dataset.getH5dataSetAccessPropList(VarRes_Node))},
             DeleteH5dataSet{});
 
     return std::make_unique<VRNode>(dataset,
@@ -180,6 +147,8 @@ std::shared_ptr<VRNode> VRNode::open(
     The BAG Dataset that this layer belongs to.
 \param descriptor
     The descriptor of this layer.
+\param numReserved
+    The length of the new HDF5 DataSet.
 
 \return
     The new HDF5 DataSet.
@@ -187,9 +156,10 @@ std::shared_ptr<VRNode> VRNode::open(
 std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
 VRNode::createH5dataSet(
     const Dataset& dataset,
-    const VRNodeDescriptor& descriptor)
+    const VRNodeDescriptor& descriptor,
+    uint64_t numReserved)
 {
-    const hsize_t fileLength = 0;
+    const hsize_t fileLength = numReserved;
     const hsize_t kMaxFileLength = H5S_UNLIMITED;
     const ::H5::DataSpace h5fileDataSpace{1, &fileLength, &kMaxFileLength};
 
@@ -198,15 +168,14 @@ VRNode::createH5dataSet(
 
     // Use chunk size and compression level from the descriptor.
     const hsize_t chunkSize = descriptor.getChunkSize();
-    const auto compressionLevel = descriptor.getCompressionLevel();
+    const auto& compression = descriptor.getCompressionSpec();
     if (chunkSize > 0)
     {
         h5createPropList.setChunk(1, &chunkSize);
 
-        if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-            h5createPropList.setDeflate(compressionLevel);
+        setCompression(h5createPropList, compression);
     }
-    else if (compressionLevel > 0)
+    else if (compression.isCompressed())
         throw CompressionNeedsChunkingSet{};
     else
         throw LayerRequiresChunkingSet{};
@@ -246,6 +215,14 @@ VRNode::createH5dataSet(
         new ::H5::DataSet{h5dataSet}, DeleteH5dataSet{});
 }
 
+//! \copydoc Layer::getDimsProxy
+//! The layer is a single row of nodes, which may be longer or shorter than
+//! a row of the dataset's grid.
+std::tuple<uint32_t, uint32_t> VRNode::getDimsProxy() const
+{
+    return std::make_tuple(1u, static_cast<uint32_t>(m_length));
+}
+
 //! \copydoc Layer::read
 //! The rowStart and rowEnd are ignored since the data is 1 dimensional.
 UInt8Array VRNode::readProxy(
@@ -254,11 +231,6 @@ UInt8Array VRNode::readProxy(
     uint32_t /*rowEnd*/,
     uint32_t columnEnd) const
 {
-    auto pDescriptor = std::dynamic_pointer_cast<const VRNodeDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     // Query the file for the specified rows and columns.
     const hsize_t columns = (columnEnd - columnStart) + 1;
     const hsize_t offset = columnStart;
@@ -266,9 +238,9 @@ UInt8Array VRNode::readProxy(
     const auto fileDataSpace = m_pH5dataSet->getSpace();
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &columns, &offset);
 
-    const auto bufferSize = pDescriptor->getReadBufferSize(1,
+    const auto bufferSize = m_descriptor.getReadBufferSize(1,
         static_cast<uint32_t>(columns));
-    UInt8Array buffer{bufferSize};
+    auto buffer = UInt8Array::uninitialized(bufferSize);
 
     const ::H5::DataSpace memDataSpace{1, &columns, &columns};
 
@@ -282,14 +254,9 @@ UInt8Array VRNode::readProxy(
 //! \copydoc Layer::writeAttributes
 void VRNode::writeAttributesProxy() const
 {
-    auto pDescriptor = std::dynamic_pointer_cast<const VRNodeDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     // Write the attributes from the layer descriptor.
     // min/max hyp strength
-    const auto minMaxHypStrength = pDescriptor->getMinMaxHypStrength();
+    const auto minMaxHypStrength = m_descriptor.getMinMaxHypStrength();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_FLOAT,
         std::get<0>(minMaxHypStrength), VR_NODE_MIN_HYP_STRENGTH);
 
@@ -297,7 +264,7 @@ void VRNode::writeAttributesProxy() const
         std::get<1>(minMaxHypStrength), VR_NODE_MAX_HYP_STRENGTH);
 
     // min/max num hypotheses
-    const auto minMaxNumHypotheses = pDescriptor->getMinMaxNumHypotheses();
+    const auto minMaxNumHypotheses = m_descriptor.getMinMaxNumHypotheses();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_UINT32,
         std::get<0>(minMaxNumHypotheses), VR_NODE_MIN_NUM_HYPOTHESES);
 
@@ -305,7 +272,7 @@ void VRNode::writeAttributesProxy() const
         std::get<1>(minMaxNumHypotheses), VR_NODE_MAX_NUM_HYPOTHESES);
 
     // min/max n samples
-    const auto minMaxNSamples = pDescriptor->getMinMaxNSamples();
+    const auto minMaxNSamples = m_descriptor.getMinMaxNSamples();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_UINT32,
         std::get<0>(minMaxNSamples), VR_NODE_MIN_N_SAMPLES);
 
@@ -322,10 +289,7 @@ void VRNode::writeProxy(
     uint32_t columnEnd,
     const uint8_t* buffer)
 {
-    auto pDescriptor = std::dynamic_pointer_cast<VRNodeDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
+    const auto lock = this->getDataset().lock()->lockWrites();
 
     const hsize_t columns = (columnEnd - columnStart) + 1;
     const hsize_t offset = columnStart;
@@ -348,15 +312,12 @@ void VRNode::writeProxy(
         m_pH5dataSet->extend(&newMaxLength);
 
         fileDataSpace = m_pH5dataSet->getSpace();
-
-        // Update the dataset's dimensions.
-        if (this->getDataset().expired())
-            throw DatasetNotFound{};
-
-        auto pDataset = this->getDataset().lock();
-        pDataset->getDescriptor().setDims(1, static_cast<uint32_t>(newMaxLength));
     }
 
+    // Writing into the room reserved does not extend the DataSet.
+    if (m_length < (columnEnd + 1))
+        m_length = columnEnd + 1;
+
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &columns, &offset);
 
     const auto memDataType = makeDataType();
@@ -366,35 +327,42 @@ void VRNode::writeProxy(
     // Update min/max attributes
     // Get the current min/max from descriptor.
     float minHypStr = 0.f, maxHypStr = 0.f;
-    std::tie(minHypStr, maxHypStr) = pDescriptor->getMinMaxHypStrength();
+    std::tie(minHypStr, maxHypStr) = m_descriptor.getMinMaxHypStrength();
 
     uint32_t minNumHyp = 0, maxNumHyp = 0;
-    std::tie(minNumHyp, maxNumHyp) = pDescriptor->getMinMaxNumHypotheses();
+    std::tie(minNumHyp, maxNumHyp) = m_descriptor.getMinMaxNumHypotheses();
 
     uint32_t minNSamples = 0, maxNSamples = 0;
-    std::tie(minNSamples, maxNSamples) = pDescriptor->getMinMaxNSamples();
+    std::tie(minNSamples, maxNSamples) = m_descriptor.getMinMaxNSamples();
 
-    // Update the min/max from new data.
-    const auto* items = reinterpret_cast<const BagVRNodeItem*>(buffer);
+    // Update the min/max from new data, ignoring nulls.
+    const auto mm = computeMinMax(
+        reinterpret_cast<const BagVRNodeItem*>(buffer), columns);
 
-    auto* item = items;
-    const auto end = items + columns;
+    mm.hypStrength.mergeInto(minHypStr, maxHypStr);
+    mm.numHypotheses.mergeInto(minNumHyp, maxNumHyp);
+    mm.nSamples.mergeInto(minNSamples, maxNSamples);
 
-    for (; item != end; ++item)
-    {
-        minHypStr = item->hyp_strength < minHypStr ? item->hyp_strength : minHypStr;
-        maxHypStr = item->hyp_strength > maxHypStr ? item->hyp_strength : maxHypStr;
+    m_descriptor.setMinMaxHypStrength(minHypStr, maxHypStr);
+    m_descriptor.setMinMaxNumHypotheses(minNumHyp, maxNumHyp);
+    m_descriptor.setMinMaxNSamples(minNSamples, maxNSamples);
+}
 
-        minNumHyp = item->num_hypotheses < minNumHyp ? item->num_hypotheses : minNumHyp;
-        maxNumHyp = item->num_hypotheses > maxNumHyp ? item->num_hypotheses : maxNumHyp;
+//! Trim the HDF5 DataSet to the nodes in the layer.
+/*!
+    Drops the room reserved when the layer was created that was not written
+    to; called when the BAG is closed.
+*/
+void VRNode::trim()
+{
+    hsize_t fileLength = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&fileLength);
 
-        minNSamples = item->n_samples < minNSamples ? item->n_samples : minNSamples;
-        maxNSamples = item->n_samples > maxNSamples ? item->n_samples : maxNSamples;
+    if (fileLength > m_length)
+    {
+        const hsize_t length = m_length;
+        m_pH5dataSet->extend(&length);
     }
-
-    pDescriptor->setMinMaxHypStrength(minHypStr, maxHypStr);
-    pDescriptor->setMinMaxNumHypotheses(minNumHyp, maxNumHyp);
-    pDescriptor->setMinMaxNSamples(minNSamples, maxNSamples);
 }
 
 }   //namespace BAG
@@ -43,7 +43,8 @@ public:
 
 protected:
     static std::shared_ptr<VRNode> create(Dataset& dataset,
-        uint64_t chunkSize, int compressionLevel);
+        uint64_t chunkSize, const CompressionSpec& compression,
+        uint64_t numReserved = 0);
 
     static std::shared_ptr<VRNode> open(Dataset& dataset,
         VRNodeDescriptor& descriptor);
@@ -51,7 +52,9 @@ protected:
 private:
     static std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
         createH5dataSet(const Dataset& dataset,
-            const VRNodeDescriptor& descriptor);
+            const VRNodeDescriptor& descriptor, uint64_t numReserved);
+
+    std::tuple<uint32_t, uint32_t> getDimsProxy() const override;
 
     UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const override;
@@ -61,8 +64,15 @@ private:
 
     void writeAttributesProxy() const override;
 
+    void trim();
+
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    VRNodeDescriptor& m_descriptor;
     //! The HDF5 DataSet this layer wraps.
     std::unique_ptr<H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! The number of nodes in the layer; the DataSet is longer while it
+    //! holds the room reserved when it was created.
+    uint64_t m_length = 0;
 
     friend Dataset;
 };
@@ -1,11 +1,14 @@
 
 #include "bag_hdfhelper.h"
+#include "bag_minmax.h"
 #include "bag_private.h"
 #include "bag_vrrefinements.h"
 #include "bag_vrrefinementsdescriptor.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>  //memset
+#include <limits>
 #include <H5Cpp.h>
 
 
@@ -30,27 +33,6 @@ namespace {
     return memDataType;
 }
 
-//! Read an attribute from an HDF5 DataSet.
-/*!
-\param h5file
-    The HDF5 file.
-\param name
-    The attribute name.
-*/
-template<typename T>
-T readAttribute(
-    const ::H5::H5File& h5file,
-    const char* const name)
-{
-    const auto h5DataSet = h5file.openDataSet(VR_REFINEMENT_PATH);
-    const auto attribute = h5DataSet.openAttribute(name);
-
-    T value{};
-    attribute.read(attribute.getDataType(), &value);
-
-    return value;
-}
-
 }  // namespace
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -61,7 +43,7 @@ T readAttribute(
 */
     std::shared_ptr<VRRefinementsDescriptor> VRRefinements::getDescriptor() & noexcept
     {
-        return std::dynamic_pointer_cast<VRRefinementsDescriptor>(Layer::getDescriptor());
+        return std::static_pointer_cast<VRRefinementsDescriptor>(Layer::getDescriptor());
     }
 
 //! Retrieve the layer's descriptor. Note: this shadows BAG::Layer.getDescriptor()
@@ -71,7 +53,7 @@ T readAttribute(
     Will never be nullptr.
 */
     std::shared_ptr<const VRRefinementsDescriptor> VRRefinements::getDescriptor() const & noexcept {
-        return std::dynamic_pointer_cast<const VRRefinementsDescriptor>(Layer::getDescriptor());
+        return std::static_pointer_cast<const VRRefinementsDescriptor>(Layer::getDescriptor());
     }
 
 //! Constructor.
@@ -88,8 +70,12 @@ VRRefinements::VRRefinements(
     VRRefinementsDescriptor& descriptor,
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> h5dataSet)
     : Layer(dataset, descriptor)
+    , m_descriptor(descriptor)
     , m_pH5dataSet(std::move(h5dataSet))
 {
+    hsize_t length = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&length);
+    m_length = length;
 }
 
 //! Create a new variable resolution refinements layer.
@@ -98,8 +84,12 @@ VRRefinements::VRRefinements(
     The BAG Dataset this layer belongs to.
 \param chunkSize
     The chunk size the HDF5 DataSet will use.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param numReserved
+    The number of refinements to make room for, so writing them does not
+    extend the HDF5 DataSet; the room left is trimmed when the BAG is
+    closed.
 
 \return
     The new variable resolution refinements layer.
@@ -107,15 +97,22 @@ VRRefinements::VRRefinements(
 std::unique_ptr<VRRefinements> VRRefinements::create(
     Dataset& dataset,
     uint64_t chunkSize,
-    int compressionLevel)
+    const CompressionSpec& compression,
+    uint64_t numReserved)
 {
     auto descriptor = VRRefinementsDescriptor::create(dataset, chunkSize,
-        compressionLevel);
+        compression.level);
+    descriptor->setCompressionSpec(compression);
 
-    auto h5dataSet = VRRefinements::createH5dataSet(dataset, *descriptor);
+    auto h5dataSet = VRRefinements::createH5dataSet(dataset, *descriptor,
+        numReserved);
 
-    return std::unique_ptr<VRRefinements>(new VRRefinements{dataset,
+    auto pLayer = std::unique_ptr<VRRefinements>(new VRRefinements{dataset,
         *descriptor, std::move(h5dataSet)});
+    pLayer->m_length = 0;
+    pLayer->m_numReserved = numReserved;
+
+    return pLayer;
 }
 
 //! Open an existing variable resolution refinements layer.
@@ -123,7 +120,8 @@ std::unique_ptr<VRRefinements> VRRefinements::create(
 \param dataset
     The BAG Dataset this layer belongs to.
 \param descriptor
-    The descriptor of this layer.
+    The descriptor of this layer; its attributes were read when the BAG
+    was opened.
 
 \return
     The existing variable resolution refinements layer.
@@ -134,21 +132,9 @@ std::unique_ptr<VRRefinements> VRRefinements::open(
 {
     auto& h5file = dataset.getH5file();
 
-    // Read the attribute values from the file and set in the descriptor.
-    const auto minDepth = readAttribute<float>(h5file, VR_REFINEMENT_MIN_DEPTH);
-    const auto maxDepth = readAttribute<float>(h5file, VR_REFINEMENT_MAX_DEPTH);
-
-    descriptor.setMinMaxDepth(minDepth, maxDepth);
-
-    const auto minUncertainty = readAttribute<float>(h5file,
-        VR_REFINEMENT_MIN_UNCERTAINTY);
-    const auto maxUncertainty = readAttribute<float>(h5file,
-        VR_REFINEMENT_MAX_UNCERTAINTY);
-
-    descriptor.setMinMaxUncertainty(minUncertainty, maxUncertainty);
-
     auto h5dataSet = std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
-        new ::H5::DataSet{h5file.openDataSet(VR_REFINEMENT_PATH)},
+        new ::H5::DataSet{h5file.openDataSet(VR_REFINEMENT_PATH,
+            dataset.getH5dataSetAccessPropList(VarRes_Refinement))},
             DeleteH5dataSet{});
 
     return std::unique_ptr<VRRefinements>(new VRRefinements{dataset,
@@ -162,6 +148,8 @@ std::unique_ptr<VRRefinements> VRRefinements::open(
     The BAG Dataset this layer belongs to.
 \param descriptor
     The descriptor of this layer.
+\param numReserved
+    The length of the new HDF5 DataSet.
 
 \return
     A new HDF5 DataSet.
@@ -169,9 +157,10 @@ std::unique_ptr<VRRefinements> VRRefinements::open(
 std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
 VRRefinements::createH5dataSet(
     const Dataset& dataset,
-    const VRRefinementsDescriptor& descriptor)
+    const VRRefinementsDescriptor& descriptor,
+    uint64_t numReserved)
 {
-    constexpr hsize_t fileLength = 0;
+    const hsize_t fileLength = numReserved;
     constexpr hsize_t kMaxFileLength = H5S_UNLIMITED;
     const ::H5::DataSpace h5fileDataSpace{1, &fileLength, &kMaxFileLength};
 
@@ -180,15 +169,14 @@ VRRefinements::createH5dataSet(
 
     // Use chunk size and compression level from the descriptor.
     const hsize_t chunkSize = descriptor.getChunkSize();
-    const auto compressionLevel = descriptor.getCompressionLevel();
+    const auto& compression = descriptor.getCompressionSpec();
     if (chunkSize > 0)
     {
         h5createPropList.setChunk(1, &chunkSize);
 
-        if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-            h5createPropList.setDeflate(compressionLevel);
+        setCompression(h5createPropList, compression);
     }
-    else if (compressionLevel > 0)
+    else if (compression.isCompressed())
         throw CompressionNeedsChunkingSet{};
     else
         throw LayerRequiresChunkingSet{};
@@ -220,19 +208,43 @@ VRRefinements::createH5dataSet(
         new ::H5::DataSet{h5dataSet}, DeleteH5dataSet{});
 }
 
+//! \copydoc Layer::getDimsProxy
+//! The layer is a single row of refinements, which may be longer or shorter than
+//! a row of the dataset's grid.
+std::tuple<uint32_t, uint32_t> VRRefinements::getDimsProxy() const
+{
+    return std::make_tuple(1u, static_cast<uint32_t>(m_length));
+}
+
 //! \copydoc Layer::read
 //! Ignore rows since the data is 1 dimensional.
 UInt8Array VRRefinements::readProxy(
-    uint32_t /*rowStart*/,
+    uint32_t rowStart,
     uint32_t columnStart,
-    uint32_t /*rowEnd*/,
+    uint32_t rowEnd,
     uint32_t columnEnd) const
 {
-    auto pDescriptor = std::dynamic_pointer_cast<const VRRefinementsDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
+    const auto columns = (columnEnd - columnStart) + 1;
+
+    const auto bufferSize = m_descriptor.getReadBufferSize(1, columns);
+    auto buffer = UInt8Array::uninitialized(bufferSize);
+
+    this->readIntoProxy(rowStart, columnStart, rowEnd, columnEnd,
+        buffer.data(), bufferSize);
 
+    return buffer;
+}
+
+//! \copydoc Layer::readInto
+//! Ignore rows since the data is 1 dimensional.
+void VRRefinements::readIntoProxy(
+    uint32_t /*rowStart*/,
+    uint32_t columnStart,
+    uint32_t /*rowEnd*/,
+    uint32_t columnEnd,
+    uint8_t* buffer,
+    size_t /*rowStrideBytes*/) const
+{
     // Query the file for the specified rows and columns.
     const hsize_t columns = (columnEnd - columnStart) + 1;
     const hsize_t offset = columnStart;
@@ -240,31 +252,19 @@ UInt8Array VRRefinements::readProxy(
     const auto fileDataSpace = m_pH5dataSet->getSpace();
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &columns, &offset);
 
-    const auto bufferSize = pDescriptor->getReadBufferSize(1,
-        static_cast<uint32_t>(columns));
-    UInt8Array buffer{bufferSize};
-
     const ::H5::DataSpace memDataSpace{1, &columns, &columns};
 
     const auto memDataType = makeDataType();
 
-    m_pH5dataSet->read(buffer.data(), memDataType, memDataSpace, fileDataSpace);
-
-    return buffer;
+    m_pH5dataSet->read(buffer, memDataType, memDataSpace, fileDataSpace);
 }
 
 //! \copydoc Layer::writeAttributes
 void VRRefinements::writeAttributesProxy() const
 {
-    auto pDescriptor =
-        std::dynamic_pointer_cast<const VRRefinementsDescriptor>(
-            this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
-
     // Write the attributes from the layer descriptor.
     // min/max depth
-    const auto minMaxDepth = pDescriptor->getMinMaxDepth();
+    const auto minMaxDepth = m_descriptor.getMinMaxDepth();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_FLOAT,
         std::get<0>(minMaxDepth), VR_REFINEMENT_MIN_DEPTH);
 
@@ -272,7 +272,7 @@ void VRRefinements::writeAttributesProxy() const
         std::get<1>(minMaxDepth), VR_REFINEMENT_MAX_DEPTH);
 
     // min/max uncertainty
-    const auto minMaxUncertainty = pDescriptor->getMinMaxUncertainty();
+    const auto minMaxUncertainty = m_descriptor.getMinMaxUncertainty();
     writeAttribute(*m_pH5dataSet, ::H5::PredType::NATIVE_FLOAT,
         std::get<0>(minMaxUncertainty), VR_REFINEMENT_MIN_UNCERTAINTY);
 
@@ -289,10 +289,7 @@ void VRRefinements::writeProxy(
     uint32_t columnEnd,
     const uint8_t* buffer)
 {
-    auto pDescriptor = std::dynamic_pointer_cast<VRRefinementsDescriptor>(
-        this->getDescriptor());
-    if (!pDescriptor)
-        throw InvalidLayerDescriptor{};
+    const auto lock = this->getDataset().lock()->lockWrites();
 
     const hsize_t columns = (columnEnd - columnStart) + 1;
     const hsize_t offset = columnStart;
@@ -315,15 +312,12 @@ void VRRefinements::writeProxy(
         m_pH5dataSet->extend(&newMaxLength);
 
         fileDataSpace = m_pH5dataSet->getSpace();
-
-        // Update the dataset's dimensions.
-        if (this->getDataset().expired())
-            throw DatasetNotFound{};
-
-        auto pDataset = this->getDataset().lock();
-        pDataset->getDescriptor().setDims(1, static_cast<uint32_t>(newMaxLength));
     }
 
+    // Writing into the room reserved does not extend the DataSet.
+    if (m_length < (columnEnd + 1))
+        m_length = columnEnd + 1;
+
     fileDataSpace.selectHyperslab(H5S_SELECT_SET, &columns, &offset);
 
     const auto memDataType = makeDataType();
@@ -333,28 +327,240 @@ void VRRefinements::writeProxy(
     // Update min/max attributes
     // Get the current min/max from descriptor.
     float minDepth = 0.f, maxDepth = 0.f;
-    std::tie(minDepth, maxDepth) = pDescriptor->getMinMaxDepth();
+    std::tie(minDepth, maxDepth) = m_descriptor.getMinMaxDepth();
 
     float minUncert = 0.f, maxUncert = 0.f;
-    std::tie(minUncert, maxUncert) = pDescriptor->getMinMaxUncertainty();
+    std::tie(minUncert, maxUncert) = m_descriptor.getMinMaxUncertainty();
+
+    // Update the min/max from new data, ignoring null depths/uncertainties.
+    const auto mm = computeMinMax(
+        reinterpret_cast<const BagVRRefinementsItem*>(buffer), columns);
+
+    mm.depth.mergeInto(minDepth, maxDepth);
+    mm.uncertainty.mergeInto(minUncert, maxUncert);
+
+    m_descriptor.setMinMaxDepth(minDepth, maxDepth);
+    m_descriptor.setMinMaxUncertainty(minUncert, maxUncert);
+}
 
-    // Update the min/max from new data.
-    const auto* items = reinterpret_cast<const BagVRRefinementsItem*>(buffer);
+//! Trim the HDF5 DataSet to the refinements in the layer.
+/*!
+    Drops the room reserved when the layer was created that was not written
+    to; called when the BAG is closed.
+*/
+void VRRefinements::trim()
+{
+    m_numReserved = 0;
 
-    auto* item = items;
-    const auto end = items + columns;
+    hsize_t fileLength = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&fileLength);
 
-    for (; item != end; ++item)
+    if (fileLength > m_length)
     {
-        minDepth = item->depth < minDepth ? item->depth : minDepth;
-        maxDepth = item->depth > maxDepth ? item->depth : maxDepth;
+        const hsize_t length = m_length;
+        m_pH5dataSet->extend(&length);
+    }
+}
+
+//! Start appending refinements to the end of the layer.
+/*!
+\return
+    The writer.  Close it, or let it go out of scope, when done.
+*/
+std::unique_ptr<VRRefinements::AppendWriter> VRRefinements::appendWriter()
+{
+    return std::unique_ptr<AppendWriter>(new AppendWriter{*this});
+}
+
+//! Constructor.
+/*!
+\param layer
+    The layer to append to.
+*/
+VRRefinements::AppendWriter::AppendWriter(
+    VRRefinements& layer)
+    : m_layer(layer)
+{
+    m_chunkSize = std::max<uint64_t>(layer.m_descriptor.getChunkSize(), 1);
 
-        minUncert = item->depth_uncrt < minUncert ? item->depth_uncrt : minUncert;
-        maxUncert = item->depth_uncrt > maxUncert ? item->depth_uncrt : maxUncert;
+    const auto pDataset = layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    std::array<hsize_t, H5S_MAX_RANK> fileLength{};
+    int numDims = 0;
+    {
+        const auto lock = pDataset->lockWrites();
+        numDims = layer.m_pH5dataSet->getSpace().getSimpleExtentDims(
+            fileLength.data());
     }
+    if (numDims != 1)
+        throw InvalidVRRefinementDimensions{};
+
+    m_length = layer.m_length;
+    m_extent = fileLength[0];
+
+    // Fill the rest of the last chunk first, so later writes are whole chunks.
+    m_bufferCapacity = static_cast<size_t>(m_chunkSize - m_length % m_chunkSize);
+    m_buffer.reserve(m_bufferCapacity);
+}
+
+//! Destructor.
+/*!
+    Closes the writer if it is still open.  Errors are lost; call close()
+    to see them.
+*/
+VRRefinements::AppendWriter::~AppendWriter() noexcept
+{
+    try
+    {
+        this->close();
+    }
+    catch (...)
+    {
+    }
+}
+
+//! Append refinements.
+/*!
+\param items
+    The refinements to append.
+\param count
+    The number of refinements to append.
+
+\return
+    The index of the first refinement appended; the index to store in the
+    VRMetadata of the supergrid cell they refine.
+*/
+uint32_t VRRefinements::AppendWriter::append(
+    const VRRefinementsItem* items,
+    size_t count)
+{
+    if (m_closed)
+        throw AppendWriterClosed{};
+
+    if (count > 0 && !items)
+        throw InvalidBuffer{};
+
+    const auto first = m_length + m_buffer.size();
+    if (first + count > std::numeric_limits<uint32_t>::max())
+        throw InvalidWriteSize{};
+
+    while (count > 0)
+    {
+        const auto numToCopy = std::min(count,
+            m_bufferCapacity - m_buffer.size());
+
+        m_buffer.insert(m_buffer.end(), items, items + numToCopy);
+        items += numToCopy;
+        count -= numToCopy;
+
+        if (m_buffer.size() == m_bufferCapacity)
+            this->flush();
+    }
+
+    return static_cast<uint32_t>(first);
+}
+
+//! Write what is buffered, trim the layer and write its attributes.
+/*!
+    Does nothing if the writer is already closed.
+*/
+void VRRefinements::AppendWriter::close()
+{
+    if (m_closed)
+        return;
+
+    this->flush();
+
+    m_closed = true;
+
+    auto pDataset = m_layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    // Keep the room reserved by Dataset::createVR() for later writes.
+    const auto length = std::max(m_length, m_layer.m_numReserved);
+    if (m_extent > length)
+    {
+        const auto lock = pDataset->lockWrites();
+
+        const hsize_t newExtent = length;
+        m_layer.m_pH5dataSet->extend(&newExtent);
+        m_extent = length;
+    }
+
+    m_layer.writeAttributes();
+}
+
+//! Retrieve the number of refinements in the layer.
+/*!
+\return
+    The number of refinements, including those appended but not written yet.
+*/
+uint32_t VRRefinements::AppendWriter::size() const noexcept
+{
+    return static_cast<uint32_t>(m_length + m_buffer.size());
+}
+
+//! Write the buffered refinements to the end of the layer.
+/*!
+    The DataSet is at least doubled whenever it has to grow.
+*/
+void VRRefinements::AppendWriter::flush()
+{
+    if (m_buffer.empty())
+        return;
+
+    const auto pDataset = m_layer.getDataset().lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const hsize_t count = m_buffer.size();
+    const hsize_t offset = m_length;
+
+    // Only the write to HDF5 waits for the other layers' writers; the
+    // min/max is found after.
+    {
+        const auto lock = pDataset->lockWrites();
+
+        if (m_length + count > m_extent)
+        {
+            const hsize_t newExtent = std::max<uint64_t>({m_length + count,
+                m_extent * 2, m_chunkSize});
+
+            m_layer.m_pH5dataSet->extend(&newExtent);
+            m_extent = newExtent;
+        }
+
+        auto fileDataSpace = m_layer.m_pH5dataSet->getSpace();
+        fileDataSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+
+        const ::H5::DataSpace memDataSpace{1, &count, &count};
+
+        m_layer.m_pH5dataSet->write(m_buffer.data(), makeDataType(),
+            memDataSpace, fileDataSpace);
+    }
+
+    float minDepth = 0.f, maxDepth = 0.f;
+    std::tie(minDepth, maxDepth) = m_layer.m_descriptor.getMinMaxDepth();
+
+    float minUncert = 0.f, maxUncert = 0.f;
+    std::tie(minUncert, maxUncert) = m_layer.m_descriptor.getMinMaxUncertainty();
+
+    const auto mm = computeMinMax(m_buffer.data(), m_buffer.size());
+
+    mm.depth.mergeInto(minDepth, maxDepth);
+    mm.uncertainty.mergeInto(minUncert, maxUncert);
+
+    m_layer.m_descriptor.setMinMaxDepth(minDepth, maxDepth);
+    m_layer.m_descriptor.setMinMaxUncertainty(minUncert, maxUncert);
 
-    pDescriptor->setMinMaxDepth(minDepth, maxDepth);
-    pDescriptor->setMinMaxUncertainty(minUncert, maxUncert);
+    m_length += count;
+    m_layer.m_length = std::max(m_layer.m_length, m_length);
+    m_buffer.clear();
+    m_bufferCapacity = static_cast<size_t>(m_chunkSize);
+    m_buffer.reserve(m_bufferCapacity);
 }
 
 }  // namespace BAG
@@ -6,7 +6,10 @@
 #include "bag_fordec.h"
 #include "bag_layer.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 
 namespace BAG {
@@ -37,13 +40,65 @@ public:
     std::shared_ptr<VRRefinementsDescriptor> getDescriptor() & noexcept;
     std::shared_ptr<const VRRefinementsDescriptor> getDescriptor() const & noexcept;
 
+    //! Appends refinements to the end of the layer.
+    /*!
+        Refinements are buffered until a whole chunk is full, and the HDF5
+        DataSet grows geometrically, so appending many small runs costs
+        about the same as one large write.  Closing the writer writes what
+        is buffered, trims the DataSet to the refinements appended (keeping
+        any room reserved by Dataset::createVR()), and writes the min/max
+        attributes.
+
+        Nothing else may write to the layer while the writer is open.
+    */
+    class BAG_API AppendWriter final
+    {
+    public:
+        ~AppendWriter() noexcept;
+
+        AppendWriter(const AppendWriter&) = delete;
+        AppendWriter(AppendWriter&&) = delete;
+
+        AppendWriter& operator=(const AppendWriter&) = delete;
+        AppendWriter& operator=(AppendWriter&&) = delete;
+
+        uint32_t append(const VRRefinementsItem* items, size_t count);
+        void close();
+        uint32_t size() const noexcept;
+
+    private:
+        explicit AppendWriter(VRRefinements& layer);
+
+        void flush();
+
+        //! The layer appended to.
+        VRRefinements& m_layer;
+        //! The refinements not written yet.
+        std::vector<VRRefinementsItem> m_buffer;
+        //! The number of refinements to buffer before writing.
+        size_t m_bufferCapacity = 0;
+        //! The chunk size of the layer.
+        uint64_t m_chunkSize = 0;
+        //! The number of refinements written to the DataSet.
+        uint64_t m_length = 0;
+        //! The length of the DataSet, including room not written yet.
+        uint64_t m_extent = 0;
+        //! Has the writer been closed?
+        bool m_closed = false;
+
+        friend VRRefinements;
+    };
+
+    std::unique_ptr<AppendWriter> appendWriter();
+
 protected:
     VRRefinements(Dataset& dataset,
         VRRefinementsDescriptor& descriptor,
         std::unique_ptr<::H5::DataSet, DeleteH5dataSet> h5dataSet);
 
     static std::unique_ptr<VRRefinements> create(Dataset& dataset,
-        uint64_t chunkSize, int compressionLevel);
+        uint64_t chunkSize, const CompressionSpec& compression,
+        uint64_t numReserved = 0);
 
     static std::unique_ptr<VRRefinements> open(Dataset& dataset,
         VRRefinementsDescriptor& descriptor);
@@ -51,18 +106,33 @@ protected:
 private:
     static std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
         createH5dataSet(const Dataset& dataset,
-            const VRRefinementsDescriptor& descriptor);
+            const VRRefinementsDescriptor& descriptor, uint64_t numReserved);
+
+    std::tuple<uint32_t, uint32_t> getDimsProxy() const override;
 
     UInt8Array readProxy(uint32_t rowStart,
         uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const override;
 
+    void readIntoProxy(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd, uint8_t* buffer,
+        size_t rowStrideBytes) const override;
+
     void writeProxy(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
         uint32_t columnEnd, const uint8_t *buffer) override;
 
     void writeAttributesProxy() const override;
 
+    void trim();
+
+    //! The layer's descriptor, typed; held by Layer::m_pLayerDescriptor.
+    VRRefinementsDescriptor& m_descriptor;
     //! The HDF5 DataSet this layer wraps.
     std::unique_ptr<H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
+    //! The number of refinements in the layer; the DataSet is longer while
+    //! it holds the room reserved when it was created.
+    uint64_t m_length = 0;
+    //! The number of refinements room was reserved for; 0 once trimmed.
+    uint64_t m_numReserved = 0;
 
     friend Dataset;
 };
@@ -0,0 +1,932 @@
+
+#include "bag_dataset.h"
+#include "bag_exceptions.h"
+#include "bag_parallel.h"
+#include "bag_progressscope.h"
+#include "bag_simplelayer.h"
+#include "bag_simplelayerdescriptor.h"
+#include "bag_vrmetadata.h"
+#include "bag_vrrefinements.h"
+#include "bag_vrresampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+
+namespace BAG {
+
+namespace {
+
+//! The value of output nodes with no refinement under them.
+constexpr float kNullDepth = BAG_NULL_ELEVATION;
+
+//! The number of supergrid rows covered by each band of output rows.
+/*!
+    Each band reads its refinements in one range, so taller bands mean fewer,
+    larger reads at the cost of holding more refinements at once.
+*/
+constexpr double kSuperRowsPerBand = 8.;
+
+//! How far an extent may exceed a whole number of resolutions and still not
+//! be given another row or column.
+constexpr double kCountTolerance = 1e-9;
+
+//! Find the supergrid index of the cell holding a position.
+/*!
+\param position
+    The position.
+\param origin
+    The position of the first supergrid node.
+\param spacing
+    The supergrid spacing.
+
+\return
+    The index of the cell, which may be outside the supergrid.
+*/
+int64_t getCellIndex(
+    double position,
+    double origin,
+    double spacing) noexcept
+{
+    // Keep the cast defined for positions far outside the supergrid.
+    constexpr double kLimit = 1e15;
+
+    return static_cast<int64_t>(std::min(std::max(
+        std::floor((position - origin) / spacing + 0.5), -kLimit), kLimit));
+}
+
+//! Count the output nodes along one axis of an extent.
+/*!
+\param extent
+    The length of the extent.
+\param resolution
+    The output resolution.
+
+\return
+    The number of output nodes.
+*/
+uint32_t countNodes(
+    double extent,
+    double resolution)
+{
+    const auto count = std::ceil(extent / resolution - kCountTolerance);
+    if (!(count >= 1.) ||
+        count > static_cast<double>(std::numeric_limits<uint32_t>::max()))
+        throw InvalidResampleGrid{};
+
+    return static_cast<uint32_t>(count);
+}
+
+//! Find the area covered by the supergrid cells of a BAG.
+/*!
+\param descriptor
+    The descriptor of the BAG.
+
+\return
+    The western, southern, eastern and northern edges of the supergrid.
+*/
+std::array<double, 4> getSupergridExtent(
+    const Descriptor& descriptor) noexcept
+{
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = descriptor.getDims();
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = descriptor.getGridSpacing();
+
+    return {{originX - spacingX / 2., originY - spacingY / 2.,
+        originX + (numColumns - 0.5) * spacingX,
+        originY + (numRows - 0.5) * spacingY}};
+}
+
+//! The range of refined nodes along one axis of a refined cell within a span.
+/*!
+    The span is half open, so a refined node on the boundary between two
+    output nodes belongs to only one of them.
+
+\param low
+    The start of the span.
+\param high
+    The end of the span (exclusive).
+\param first
+    The position of the first refined node.
+\param resolution
+    The distance between refined nodes.
+\param count
+    The number of refined nodes.
+\param start
+    Set to the first refined node in the span.
+\param end
+    Set to one past the last refined node in the span.
+
+\return
+    \e true if any refined node is in the span.
+    \e false otherwise.
+*/
+bool getRefinedRange(
+    double low,
+    double high,
+    double first,
+    double resolution,
+    uint32_t count,
+    uint32_t& start,
+    uint32_t& end) noexcept
+{
+    if (!(resolution > 0.))
+        return false;
+
+    const auto lowIndex = std::max(std::ceil((low - first) / resolution), 0.);
+    const auto highIndex = std::min(std::ceil((high - first) / resolution),
+        static_cast<double>(count));
+
+    if (!(lowIndex < highIndex))
+        return false;
+
+    start = static_cast<uint32_t>(lowIndex);
+    end = static_cast<uint32_t>(highIndex);
+
+    return true;
+}
+
+}  // namespace
+
+//! The refinements under a band of output rows.
+struct VRResampler::RefinementBlock final
+{
+    //! The refinements, starting at first.
+    const VRRefinementsItem* items = nullptr;
+    //! The index of the first refinement held.
+    uint32_t first = 0;
+    //! The supergrid cells whose refinements are held (inclusive).
+    uint32_t rowStart = 0, columnStart = 0, rowEnd = 0, columnEnd = 0;
+};
+
+//! Constructor.
+/*!
+    The output grid covers the whole supergrid.
+
+\param dataset
+    The variable resolution BAG to resample.
+\param resolutionX
+    The distance between output columns.
+\param resolutionY
+    The distance between output rows.
+*/
+VRResampler::VRResampler(
+    const Dataset& dataset,
+    double resolutionX,
+    double resolutionY)
+    : VRResampler(dataset, resolutionX, resolutionY,
+        getSupergridExtent(dataset.getDescriptor()))
+{
+}
+
+//! Constructor.
+/*!
+\param dataset
+    The variable resolution BAG to resample.
+\param resolutionX
+    The distance between output columns.
+\param resolutionY
+    The distance between output rows.
+\param extent
+    The western, southern, eastern and northern edges of the output grid.
+*/
+VRResampler::VRResampler(
+    const Dataset& dataset,
+    double resolutionX,
+    double resolutionY,
+    const std::array<double, 4>& extent)
+    : VRResampler(dataset, resolutionX, resolutionY, extent[0], extent[1],
+        extent[2], extent[3])
+{
+}
+
+//! Constructor.
+/*!
+\param dataset
+    The variable resolution BAG to resample.
+\param resolutionX
+    The distance between output columns.
+\param resolutionY
+    The distance between output rows.
+\param minX
+    The western edge of the output grid.
+\param minY
+    The southern edge of the output grid.
+\param maxX
+    The eastern edge of the output grid.  Rounded out to a whole number of
+    columns.
+\param maxY
+    The northern edge of the output grid.  Rounded out to a whole number of
+    rows.
+*/
+VRResampler::VRResampler(
+    const Dataset& dataset,
+    double resolutionX,
+    double resolutionY,
+    double minX,
+    double minY,
+    double maxX,
+    double maxY)
+    : m_pBagDataset(dataset.shared_from_this())
+    , m_minX(minX)
+    , m_minY(minY)
+    , m_resolutionX(resolutionX)
+    , m_resolutionY(resolutionY)
+{
+    const auto pMetadata = dataset.getVRMetadata();
+    if (!pMetadata || !dataset.getVRRefinements())
+        throw DatasetRequiresVariableResolution{};
+
+    if (!(resolutionX > 0.) || !(resolutionY > 0.) ||
+        !std::isfinite(minX) || !std::isfinite(minY) ||
+        !std::isfinite(maxX) || !std::isfinite(maxY))
+        throw InvalidResampleGrid{};
+
+    m_numColumns = countNodes(maxX - minX, resolutionX);
+    m_numRows = countNodes(maxY - minY, resolutionY);
+
+    const auto& descriptor = dataset.getDescriptor();
+
+    std::tie(m_superOriginX, m_superOriginY) = descriptor.getOrigin();
+    std::tie(m_superSpacingX, m_superSpacingY) = descriptor.getGridSpacing();
+
+    m_pMetadata = pMetadata->getTable();
+    m_numSuperRows = m_pMetadata->getNumRows();
+    m_numSuperColumns = m_pMetadata->getNumColumns();
+}
+
+//! Retrieve the number of output rows.
+/*!
+\return
+    The number of output rows.
+*/
+uint32_t VRResampler::getNumRows() const noexcept
+{
+    return m_numRows;
+}
+
+//! Retrieve the number of output columns.
+/*!
+\return
+    The number of output columns.
+*/
+uint32_t VRResampler::getNumColumns() const noexcept
+{
+    return m_numColumns;
+}
+
+//! Retrieve the position of the south west output node.
+/*!
+\return
+    The position of the south west output node.
+*/
+std::tuple<double, double> VRResampler::getOrigin() const noexcept
+{
+    return std::make_tuple(m_minX + m_resolutionX / 2.,
+        m_minY + m_resolutionY / 2.);
+}
+
+//! Retrieve the output resolution.
+/*!
+\return
+    The distance between output columns and rows.
+*/
+std::tuple<double, double> VRResampler::getResolution() const noexcept
+{
+    return std::make_tuple(m_resolutionX, m_resolutionY);
+}
+
+//! Resample the whole output grid.
+/*!
+\param method
+    How the refinements are combined.
+
+\return
+    The output grid, as floats, row major.
+*/
+UInt8Array VRResampler::resample(
+    VRResampleMethod method) const
+{
+    UInt8Array result{static_cast<size_t>(m_numRows) * m_numColumns *
+        sizeof(float)};
+
+    this->resampleInto(method, reinterpret_cast<float*>(result.data()));
+
+    return result;
+}
+
+//! Resample the whole output grid into a caller supplied buffer.
+/*!
+\param method
+    How the refinements are combined.
+\param data
+    The buffer to fill, row major.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+    0 means the rows are packed.
+\param progress
+    Follows the progress of the resampling, and cancels it; may be null.
+    If cancelled, the bands resampled so far are filled.
+*/
+void VRResampler::resampleInto(
+    VRResampleMethod method,
+    float* data,
+    size_t rowStride,
+    ProgressToken* progress) const
+{
+    if (!data)
+        throw InvalidBuffer{};
+
+    if (rowStride == 0)
+        rowStride = m_numColumns;
+    else if (rowStride < m_numColumns)
+        throw InvalidReadSize{};
+
+    const auto bandHeight = this->getBandHeight();
+    const ProgressScope bandProgress{progress};
+
+    for (uint32_t row=0; row<m_numRows; row+=bandHeight)
+    {
+        const auto rowEnd = std::min(row + bandHeight, m_numRows) - 1;
+
+        this->resampleBand(method, row, rowEnd, data + row * rowStride,
+            rowStride);
+
+        bandProgress.report(rowEnd + 1, m_numRows);
+    }
+}
+
+//! Resample a band of rows of the output grid into a caller supplied buffer.
+/*!
+\param method
+    How the refinements are combined.
+\param rowStart
+    The first row of the band.
+\param rowEnd
+    The last row of the band (inclusive).
+\param data
+    The buffer to fill with the band, row major.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+    0 means the rows are packed.
+*/
+void VRResampler::resampleRowsInto(
+    VRResampleMethod method,
+    uint32_t rowStart,
+    uint32_t rowEnd,
+    float* data,
+    size_t rowStride) const
+{
+    if (!data)
+        throw InvalidBuffer{};
+
+    if (rowStart > rowEnd || rowEnd >= m_numRows)
+        throw InvalidReadSize{};
+
+    if (rowStride == 0)
+        rowStride = m_numColumns;
+    else if (rowStride < m_numColumns)
+        throw InvalidReadSize{};
+
+    const auto bandHeight = this->getBandHeight();
+
+    for (auto row=rowStart; row<=rowEnd; row+=bandHeight)
+    {
+        const auto bandEnd = std::min(row + bandHeight - 1, rowEnd);
+
+        this->resampleBand(method, row, bandEnd,
+            data + (row - rowStart) * rowStride, rowStride);
+    }
+}
+
+//! Resample the whole output grid into a simple layer.
+/*!
+    The layer is written band by band, so the whole output grid is never
+    held in memory.  If cancelled, the bands written so far are kept, with
+    the min/max attributes of their nodes.
+
+\param method
+    How the refinements are combined.
+\param destination
+    The dataset to write to.  Its dimensions must match the output grid.
+\param type
+    The type of layer to write.  It is created if the destination does not
+    have it, chunked and compressed like the elevation of the source.
+\param progress
+    Follows the progress of the write, and cancels it; may be null.
+
+\return
+    The layer written.
+*/
+SimpleLayer& VRResampler::writeLayer(
+    VRResampleMethod method,
+    Dataset& destination,
+    LayerType type,
+    ProgressToken* progress) const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    if (Layer::getDataType(type) != DT_FLOAT32)
+        throw UnsupportedDataType{};
+
+    if (destination.getDescriptor().getDims() !=
+        std::make_tuple(m_numRows, m_numColumns))
+        throw InvalidWriteSize{};
+
+    if (!destination.getSimpleLayer(type))
+    {
+        ChunkShape chunkShape{ChunkLayout::Tiled, kDefaultTileSize,
+            kDefaultTileSize};
+        CompressionSpec compression;
+
+        const auto pElevation = pDataset->getSimpleLayer(Elevation);
+        if (pElevation)
+        {
+            const auto pDescriptor = pElevation->getDescriptor();
+            std::tie(chunkShape.rows, chunkShape.columns) =
+                pDescriptor->getChunkDims();
+            compression = pDescriptor->getCompressionSpec();
+        }
+
+        destination.createSimpleLayer(type, chunkShape, compression);
+    }
+
+    auto pDestination = destination.getSimpleLayer(type);
+    if (!pDestination)
+        throw LayerNotFound{};
+
+    // Every node is replaced, so the old min/max no longer applies.
+    pDestination->getDescriptor()->setMinMax(
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+
+    const auto bandHeight = this->getBandHeight();
+    UInt8Array band{static_cast<size_t>(bandHeight) * m_numColumns *
+        sizeof(float)};
+
+    const ProgressScope bandProgress{progress};
+
+    try
+    {
+        for (uint32_t row=0; row<m_numRows; row+=bandHeight)
+        {
+            const auto rowEnd = std::min(row + bandHeight, m_numRows) - 1;
+
+            this->resampleBand(method, row, rowEnd,
+                reinterpret_cast<float*>(band.data()), m_numColumns);
+
+            pDestination->write(row, 0, rowEnd, m_numColumns - 1,
+                band.data());
+
+            bandProgress.report(rowEnd + 1, m_numRows);
+        }
+    }
+    catch (const OperationCancelled&)
+    {
+        pDestination->writeAttributes();
+        throw;
+    }
+
+    pDestination->writeAttributes();
+
+    return *pDestination;
+}
+
+//! Determine how many output rows are produced at once.
+/*!
+\return
+    The number of output rows in a band.
+*/
+uint32_t VRResampler::getBandHeight() const noexcept
+{
+    const auto rows = std::ceil(kSuperRowsPerBand * m_superSpacingY /
+        m_resolutionY);
+
+    if (!(rows > 1.))
+        return 1;
+
+    return static_cast<uint32_t>(std::min(rows,
+        static_cast<double>(std::max(m_numRows, 1u))));
+}
+
+//! Resample a band of output rows.
+/*!
+    The refinements of every supergrid cell the band can touch are read in
+    one range, then the rows are rasterized on several threads.
+
+\param method
+    How the refinements are combined.
+\param rowStart
+    The first output row.
+\param rowEnd
+    The last output row (inclusive).
+\param data
+    The buffer to fill, starting with rowStart.
+\param rowStride
+    The distance, in values, between the start of two rows in data.
+*/
+void VRResampler::resampleBand(
+    VRResampleMethod method,
+    uint32_t rowStart,
+    uint32_t rowEnd,
+    float* data,
+    size_t rowStride) const
+{
+    const auto fillNull = [&]() {
+        for (auto row=rowStart; row<=rowEnd; ++row)
+            std::fill_n(data + (row - rowStart) * rowStride, m_numColumns,
+                kNullDepth);
+    };
+
+    if (m_numSuperRows == 0 || m_numSuperColumns == 0)
+    {
+        fillNull();
+        return;
+    }
+
+    // The supergrid cells under the band, including the footprint of the
+    // output nodes on its edges.
+    const auto south = m_minY + rowStart * m_resolutionY;
+    const auto north = m_minY + (rowEnd + 1) * m_resolutionY;
+    const auto west = m_minX;
+    const auto east = m_minX + m_numColumns * m_resolutionX;
+
+    const auto firstRow = getCellIndex(south, m_superOriginY, m_superSpacingY);
+    const auto lastRow = getCellIndex(north, m_superOriginY, m_superSpacingY);
+    const auto firstColumn = getCellIndex(west, m_superOriginX, m_superSpacingX);
+    const auto lastColumn = getCellIndex(east, m_superOriginX, m_superSpacingX);
+
+    if (lastRow < 0 || firstRow >= m_numSuperRows ||
+        lastColumn < 0 || firstColumn >= m_numSuperColumns)
+    {
+        fillNull();
+        return;
+    }
+
+    RefinementBlock block;
+    block.rowStart = static_cast<uint32_t>(std::max<int64_t>(firstRow, 0));
+    block.rowEnd = static_cast<uint32_t>(std::min<int64_t>(lastRow,
+        m_numSuperRows - 1));
+    block.columnStart = static_cast<uint32_t>(std::max<int64_t>(firstColumn, 0));
+    block.columnEnd = static_cast<uint32_t>(std::min<int64_t>(lastColumn,
+        m_numSuperColumns - 1));
+
+    // Find the range of refinements those cells use.
+    uint64_t first = std::numeric_limits<uint64_t>::max();
+    uint64_t last = 0;
+
+    for (auto row=block.rowStart; row<=block.rowEnd; ++row)
+    {
+        for (auto column=block.columnStart; column<=block.columnEnd; ++column)
+        {
+            const auto& item = this->getItem(row, column);
+            if (item.dimensions_x == 0 || item.dimensions_y == 0)
+                continue;
+
+            first = std::min<uint64_t>(first, item.index);
+            last = std::max<uint64_t>(last, static_cast<uint64_t>(item.index) +
+                static_cast<uint64_t>(item.dimensions_x) * item.dimensions_y - 1);
+        }
+    }
+
+    if (first > last)
+    {
+        fillNull();
+        return;
+    }
+
+    const auto refinements = this->readRefinements(static_cast<uint32_t>(first),
+        static_cast<uint32_t>(last));
+
+    block.items = reinterpret_cast<const VRRefinementsItem*>(refinements.data());
+    block.first = static_cast<uint32_t>(first);
+
+    // Only the metadata and the block are shared between threads, and both
+    // are read only.
+    const auto resampleRows = [&](uint32_t start, uint32_t end) {
+        for (auto row=start; row<=end; ++row)
+        {
+            auto* values = data + (row - rowStart) * rowStride;
+            const auto y = m_minY + (row + 0.5) * m_resolutionY;
+
+            for (uint32_t column=0; column<m_numColumns; ++column)
+            {
+                const auto x = m_minX + (column + 0.5) * m_resolutionX;
+
+                switch (method)
+                {
+                case BAG_VR_RESAMPLE_BILINEAR:
+                    values[column] = this->sampleBilinear(x, y, block);
+                    break;
+                case BAG_VR_RESAMPLE_MIN_DEPTH:
+                    values[column] = this->sampleMinDepth(x, y, block);
+                    break;
+                case BAG_VR_RESAMPLE_NEAREST:
+                default:
+                    values[column] = this->sampleNearest(x, y, block);
+                    break;
+                }
+            }
+        }
+    };
+
+    processInBlocks(rowStart, rowEnd, m_numColumns, resampleRows);
+}
+
+//! Read a range of refinements.
+/*!
+\param first
+    The first refinement.
+\param last
+    The last refinement (inclusive).
+
+\return
+    The refinements.
+*/
+UInt8Array VRResampler::readRefinements(
+    uint32_t first,
+    uint32_t last) const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    if (!pDataset)
+        throw DatasetNotFound{};
+
+    const auto pRefinements = pDataset->getVRRefinements();
+    if (!pRefinements)
+        throw DatasetRequiresVariableResolution{};
+
+    return pRefinements->read(0, first, 0, last);
+}
+
+//! Find the refined supergrid cell holding a position.
+/*!
+\param x
+    The easting.
+\param y
+    The northing.
+\param block
+    The refinements available.
+\param row
+    Set to the supergrid row.
+\param column
+    Set to the supergrid column.
+
+\return
+    \e true if the position is in a refined cell whose refinements are in
+    the block.
+    \e false otherwise.
+*/
+bool VRResampler::findCell(
+    double x,
+    double y,
+    const RefinementBlock& block,
+    uint32_t& row,
+    uint32_t& column) const noexcept
+{
+    const auto cellRow = getCellIndex(y, m_superOriginY, m_superSpacingY);
+    const auto cellColumn = getCellIndex(x, m_superOriginX, m_superSpacingX);
+
+    if (cellRow < block.rowStart || cellRow > block.rowEnd ||
+        cellColumn < block.columnStart || cellColumn > block.columnEnd)
+        return false;
+
+    row = static_cast<uint32_t>(cellRow);
+    column = static_cast<uint32_t>(cellColumn);
+
+    const auto& item = this->getItem(row, column);
+
+    return item.dimensions_x > 0 && item.dimensions_y > 0;
+}
+
+//! Retrieve the metadata of a supergrid cell.
+/*!
+\param row
+    The supergrid row.
+\param column
+    The supergrid column.
+
+\return
+    The metadata of the cell.
+*/
+const VRMetadataItem& VRResampler::getItem(
+    uint32_t row,
+    uint32_t column) const noexcept
+{
+    return m_pMetadata->get(row, column);
+}
+
+//! Sample the refined node nearest to a position.
+/*!
+\param x
+    The easting.
+\param y
+    The northing.
+\param block
+    The refinements available.
+
+\return
+    The depth of the nearest refined node in the cell holding the position.
+*/
+float VRResampler::sampleNearest(
+    double x,
+    double y,
+    const RefinementBlock& block) const noexcept
+{
+    uint32_t row = 0, column = 0;
+    if (!this->findCell(x, y, block, row, column))
+        return kNullDepth;
+
+    const auto& item = this->getItem(row, column);
+
+    // The refined nodes start sw_corner from the south west corner of the
+    // supergrid cell, which is half a cell from its node.
+    const auto cellX = m_superOriginX + column * m_superSpacingX -
+        m_superSpacingX / 2.;
+    const auto cellY = m_superOriginY + row * m_superSpacingY -
+        m_superSpacingY / 2.;
+
+    const auto refinedX = (x - (cellX + item.sw_corner_x)) / item.resolution_x;
+    const auto refinedY = (y - (cellY + item.sw_corner_y)) / item.resolution_y;
+
+    if (!std::isfinite(refinedX) || !std::isfinite(refinedY))
+        return kNullDepth;
+
+    const auto refinedColumn = static_cast<uint32_t>(std::min(std::max(
+        std::floor(refinedX + 0.5), 0.), item.dimensions_x - 1.));
+    const auto refinedRow = static_cast<uint32_t>(std::min(std::max(
+        std::floor(refinedY + 0.5), 0.), item.dimensions_y - 1.));
+
+    return block.items[item.index - block.first +
+        refinedRow * item.dimensions_x + refinedColumn].depth;
+}
+
+//! Interpolate the refined nodes around a position.
+/*!
+    Each supergrid cell is interpolated on its own, so positions between the
+    outer refined nodes of a cell and its edge use the nearest outer nodes.
+    Null refined nodes are left out, and the weights of the rest rescaled.
+
+\param x
+    The easting.
+\param y
+    The northing.
+\param block
+    The refinements available.
+
+\return
+    The interpolated depth.
+*/
+float VRResampler::sampleBilinear(
+    double x,
+    double y,
+    const RefinementBlock& block) const noexcept
+{
+    uint32_t row = 0, column = 0;
+    if (!this->findCell(x, y, block, row, column))
+        return kNullDepth;
+
+    const auto& item = this->getItem(row, column);
+
+    const auto cellX = m_superOriginX + column * m_superSpacingX -
+        m_superSpacingX / 2.;
+    const auto cellY = m_superOriginY + row * m_superSpacingY -
+        m_superSpacingY / 2.;
+
+    const auto refinedX = (x - (cellX + item.sw_corner_x)) / item.resolution_x;
+    const auto refinedY = (y - (cellY + item.sw_corner_y)) / item.resolution_y;
+
+    if (!std::isfinite(refinedX) || !std::isfinite(refinedY))
+        return kNullDepth;
+
+    const auto fx = std::min(std::max(refinedX, 0.), item.dimensions_x - 1.);
+    const auto fy = std::min(std::max(refinedY, 0.), item.dimensions_y - 1.);
+
+    const auto column0 = static_cast<uint32_t>(fx);
+    const auto row0 = static_cast<uint32_t>(fy);
+    const auto column1 = std::min(column0 + 1, item.dimensions_x - 1);
+    const auto row1 = std::min(row0 + 1, item.dimensions_y - 1);
+
+    const auto tx = fx - column0;
+    const auto ty = fy - row0;
+
+    const auto* items = block.items + (item.index - block.first);
+
+    double sum = 0., sumWeights = 0.;
+
+    const auto add = [&](uint32_t refinedRow, uint32_t refinedColumn,
+        double weight) {
+        const auto depth = items[refinedRow * item.dimensions_x +
+            refinedColumn].depth;
+
+        if (weight > 0. && depth != kNullDepth)
+        {
+            sum += weight * depth;
+            sumWeights += weight;
+        }
+    };
+
+    add(row0, column0, (1. - tx) * (1. - ty));
+    add(row0, column1, tx * (1. - ty));
+    add(row1, column0, (1. - tx) * ty);
+    add(row1, column1, tx * ty);
+
+    if (!(sumWeights > 0.))
+        return this->sampleNearest(x, y, block);
+
+    return static_cast<float>(sum / sumWeights);
+}
+
+//! Find the shoalest refined node under the footprint of an output node.
+/*!
+    The footprint is the output cell centred on the position, and may span
+    several supergrid cells.  If no refined node is under it, the nearest
+    refined node is used.
+
+\param x
+    The easting.
+\param y
+    The northing.
+\param block
+    The refinements available.
+
+\return
+    The smallest depth under the footprint.
+*/
+float VRResampler::sampleMinDepth(
+    double x,
+    double y,
+    const RefinementBlock& block) const noexcept
+{
+    const auto west = x - m_resolutionX / 2.;
+    const auto east = x + m_resolutionX / 2.;
+    const auto south = y - m_resolutionY / 2.;
+    const auto north = y + m_resolutionY / 2.;
+
+    const auto firstRow = std::max<int64_t>(
+        getCellIndex(south, m_superOriginY, m_superSpacingY), block.rowStart);
+    const auto lastRow = std::min<int64_t>(
+        getCellIndex(north, m_superOriginY, m_superSpacingY), block.rowEnd);
+    const auto firstColumn = std::max<int64_t>(
+        getCellIndex(west, m_superOriginX, m_superSpacingX), block.columnStart);
+    const auto lastColumn = std::min<int64_t>(
+        getCellIndex(east, m_superOriginX, m_superSpacingX), block.columnEnd);
+
+    bool found = false;
+    float minDepth = std::numeric_limits<float>::max();
+
+    for (auto row=firstRow; row<=lastRow; ++row)
+    {
+        const auto cellY = m_superOriginY + row * m_superSpacingY -
+            m_superSpacingY / 2.;
+
+        for (auto column=firstColumn; column<=lastColumn; ++column)
+        {
+            const auto& item = this->getItem(static_cast<uint32_t>(row),
+                static_cast<uint32_t>(column));
+            if (item.dimensions_x == 0 || item.dimensions_y == 0)
+                continue;
+
+            const auto cellX = m_superOriginX + column * m_superSpacingX -
+                m_superSpacingX / 2.;
+
+            uint32_t columnStart = 0, columnEnd = 0, rowStart = 0, rowEnd = 0;
+            if (!getRefinedRange(west, east, cellX + item.sw_corner_x,
+                    item.resolution_x, item.dimensions_x, columnStart,
+                    columnEnd) ||
+                !getRefinedRange(south, north, cellY + item.sw_corner_y,
+                    item.resolution_y, item.dimensions_y, rowStart, rowEnd))
+                continue;
+
+            const auto* items = block.items + (item.index - block.first);
+
+            for (auto refinedRow=rowStart; refinedRow<rowEnd; ++refinedRow)
+            {
+                for (auto refinedColumn=columnStart; refinedColumn<columnEnd;
+                    ++refinedColumn)
+                {
+                    const auto depth = items[refinedRow * item.dimensions_x +
+                        refinedColumn].depth;
+
+                    if (depth != kNullDepth && depth < minDepth)
+                    {
+                        minDepth = depth;
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return found ? minDepth : this->sampleNearest(x, y, block);
+}
+
+}  // namespace BAG
+
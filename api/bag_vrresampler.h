@@ -0,0 +1,115 @@
+#ifndef BAG_VRRESAMPLER_H
+#define BAG_VRRESAMPLER_H
+
+#include "bag_config.h"
+#include "bag_fordec.h"
+#include "bag_types.h"
+#include "bag_uint8array.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+
+
+namespace BAG {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
+#endif
+
+//! Resamples the refinements of a variable resolution BAG onto a uniform grid.
+/*!
+    The output grid covers an extent at a fixed resolution, with a node in
+    the middle of each of its cells; row 0 is the southern most.  Nodes with
+    no refinement under them are BAG_NULL_ELEVATION.
+
+    The whole VRMetadata layer is loaded when the resampler is created.
+    The output is then produced in bands of rows.  The refinements under each
+    band are read in one contiguous range, and the band is rasterized on
+    several threads.
+
+    The resampler keeps the VRMetadataTable it was created with; create a new
+    one after writing to the VRMetadata layer.
+*/
+class BAG_API VRResampler final
+{
+public:
+    VRResampler(const Dataset& dataset, double resolutionX,
+        double resolutionY);
+    VRResampler(const Dataset& dataset, double resolutionX, double resolutionY,
+        double minX, double minY, double maxX, double maxY);
+
+    VRResampler(const VRResampler&) = delete;
+    VRResampler(VRResampler&&) = delete;
+
+    VRResampler& operator=(const VRResampler&) = delete;
+    VRResampler& operator=(VRResampler&&) = delete;
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+    std::tuple<double, double> getOrigin() const noexcept;
+    std::tuple<double, double> getResolution() const noexcept;
+
+    UInt8Array resample(VRResampleMethod method) const;
+    void resampleInto(VRResampleMethod method, float* data,
+        size_t rowStride = 0, ProgressToken* progress = nullptr) const;
+    void resampleRowsInto(VRResampleMethod method, uint32_t rowStart,
+        uint32_t rowEnd, float* data, size_t rowStride = 0) const;
+    SimpleLayer& writeLayer(VRResampleMethod method, Dataset& destination,
+        LayerType type, ProgressToken* progress = nullptr) const;
+
+private:
+    struct RefinementBlock;
+
+    VRResampler(const Dataset& dataset, double resolutionX, double resolutionY,
+        const std::array<double, 4>& extent);
+
+    uint32_t getBandHeight() const noexcept;
+    void resampleBand(VRResampleMethod method, uint32_t rowStart,
+        uint32_t rowEnd, float* data, size_t rowStride) const;
+    UInt8Array readRefinements(uint32_t first, uint32_t last) const;
+
+    bool findCell(double x, double y, const RefinementBlock& block,
+        uint32_t& row, uint32_t& column) const noexcept;
+    const VRMetadataItem& getItem(uint32_t row, uint32_t column) const noexcept;
+
+    float sampleNearest(double x, double y,
+        const RefinementBlock& block) const noexcept;
+    float sampleBilinear(double x, double y,
+        const RefinementBlock& block) const noexcept;
+    float sampleMinDepth(double x, double y,
+        const RefinementBlock& block) const noexcept;
+
+    //! The dataset.
+    std::weak_ptr<const Dataset> m_pBagDataset;
+    //! The VRMetadata layer.
+    std::shared_ptr<const VRMetadataTable> m_pMetadata;
+    //! The number of supergrid rows.
+    uint32_t m_numSuperRows = 0;
+    //! The number of supergrid columns.
+    uint32_t m_numSuperColumns = 0;
+    //! The position of the south west supergrid node.
+    double m_superOriginX = 0., m_superOriginY = 0.;
+    //! The supergrid spacing.
+    double m_superSpacingX = 0., m_superSpacingY = 0.;
+    //! The south west corner of the output grid.
+    double m_minX = 0., m_minY = 0.;
+    //! The output resolution.
+    double m_resolutionX = 0., m_resolutionY = 0.;
+    //! The number of output rows.
+    uint32_t m_numRows = 0;
+    //! The number of output columns.
+    uint32_t m_numColumns = 0;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace BAG
+
+#endif  // BAG_VRRESAMPLER_H
+
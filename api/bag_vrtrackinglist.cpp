@@ -1,10 +1,14 @@
 
 #include "bag_dataset.h"
 #include "bag_exceptions.h"
+#include "bag_hdfhelper.h"
 #include "bag_private.h"
+#include "bag_trackinglistindex.h"
 #include "bag_vrtrackinglist.h"
 
+#include <algorithm>
 #include <array>
+#include <mutex>
 #include <H5Cpp.h>
 
 
@@ -13,6 +17,67 @@ namespace BAG {
 //! The HDF5 DataSet chunk size.
 constexpr hsize_t kChunkSize = 1024;
 
+namespace {
+
+//! Create the HDF5 type of a variable resolution tracking list item.
+/*!
+\return
+    The HDF5 compound type.
+*/
+std::unique_ptr<::H5::DataType, DeleteH5dataType> createH5itemType()
+{
+    using value_type = VRTrackingList::value_type;
+
+    auto* h5type = new ::H5::CompType{sizeof(value_type)};
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> pH5type{h5type,
+        DeleteH5dataType{}};
+
+    h5type->insertMember("row", HOFFSET(value_type, row),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type->insertMember("col", HOFFSET(value_type, col),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type->insertMember("sub_row", HOFFSET(value_type, sub_row),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type->insertMember("sub_col", HOFFSET(value_type, sub_col),
+        ::H5::PredType::NATIVE_UINT32);
+    h5type->insertMember("depth", HOFFSET(value_type, depth),
+        ::H5::PredType::NATIVE_FLOAT);
+    h5type->insertMember("uncertainty", HOFFSET(value_type, uncertainty),
+        ::H5::PredType::NATIVE_FLOAT);
+    h5type->insertMember("track_code", HOFFSET(value_type, track_code),
+        ::H5::PredType::NATIVE_UINT8);
+    h5type->insertMember("list_series", HOFFSET(value_type, list_series),
+        ::H5::PredType::NATIVE_UINT16);
+
+    return pH5type;
+}
+
+//! The node of a variable resolution tracking list item, as a key.
+uint64_t getNodeKey(const VRTrackingItem& item) noexcept
+{
+    return makeNodeKey(item.row, item.col);
+}
+
+//! The sub node of a variable resolution tracking list item, as a key.
+uint64_t getSubNodeKey(const VRTrackingItem& item) noexcept
+{
+    return makeNodeKey(item.sub_row, item.sub_col);
+}
+
+//! The track code of a variable resolution tracking list item, as a key.
+uint8_t getCodeKey(const VRTrackingItem& item) noexcept
+{
+    return item.track_code;
+}
+
+//! The list series of a variable resolution tracking list item, as a key.
+uint16_t getSeriesKey(const VRTrackingItem& item) noexcept
+{
+    return item.list_series;
+}
+
+}  // namespace
+
 //! Constructor.
 /*!
 \param dataset
@@ -21,6 +86,7 @@ constexpr hsize_t kChunkSize = 1024;
 VRTrackingList::VRTrackingList(
     const Dataset& dataset)
     : m_pBagDataset(dataset.shared_from_this())
+    , m_pH5itemType(createH5itemType())
 {
     m_pH5dataSet = openH5dataSet();
 }
@@ -29,15 +95,16 @@ VRTrackingList::VRTrackingList(
 /*!
 \param dataset
     The BAG Dataset this variable resolution tracking list belongs to.
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
 */
 VRTrackingList::VRTrackingList(
     const Dataset& dataset,
-    int compressionLevel)
+    const CompressionSpec& compression)
     : m_pBagDataset(dataset.shared_from_this())
+    , m_pH5itemType(createH5itemType())
 {
-    m_pH5dataSet = createH5dataSet(compressionLevel);
+    m_pH5dataSet = createH5dataSet(compression);
 }
 
 
@@ -48,6 +115,7 @@ VRTrackingList::VRTrackingList(
 */
 VRTrackingList::iterator VRTrackingList::begin() & noexcept
 {
+    this->markChanged(0);
     return std::begin(m_items);
 }
 
@@ -99,6 +167,7 @@ bool VRTrackingList::empty() const noexcept
 */
 VRTrackingList::iterator VRTrackingList::end() & noexcept
 {
+    this->markChanged(0);
     return std::end(m_items);
 }
 
@@ -119,6 +188,7 @@ VRTrackingList::const_iterator VRTrackingList::end() const & noexcept
 */
 VRTrackingList::reference VRTrackingList::operator[](size_t index) & noexcept
 {
+    this->markChanged(index);
     return m_items[index];
 }
 
@@ -146,6 +216,7 @@ size_t VRTrackingList::size() const noexcept
 //! Empty the tracking list.
 void VRTrackingList::clear() noexcept
 {
+    this->markChanged(0);
     m_items.clear();
 }
 
@@ -156,6 +227,7 @@ void VRTrackingList::clear() noexcept
 */
 void VRTrackingList::push_back(const value_type& value)
 {
+    this->markChanged(m_items.size());
     m_items.push_back(value);
 }
 
@@ -166,6 +238,7 @@ void VRTrackingList::push_back(const value_type& value)
 */
 void VRTrackingList::push_back(value_type&& value)
 {
+    this->markChanged(m_items.size());
     m_items.push_back(value);
 }
 
@@ -176,6 +249,7 @@ void VRTrackingList::push_back(value_type&& value)
 */
 VRTrackingList::reference VRTrackingList::front() &
 {
+    this->markChanged(0);
     return m_items.front();
 }
 
@@ -196,6 +270,7 @@ VRTrackingList::const_reference VRTrackingList::front() const &
 */
 VRTrackingList::reference VRTrackingList::back() &
 {
+    this->markChanged(m_items.empty() ? 0 : m_items.size() - 1);
     return m_items.back();
 }
 
@@ -229,9 +304,56 @@ void VRTrackingList::reserve(size_t newCapacity)
 */
 void VRTrackingList::resize(size_t count)
 {
+    this->markChanged(count);
     m_items.resize(count);
 }
 
+//! Make room in the HDF5 DataSet for an expected number of items.
+/*!
+    The items are reserved in memory too.  Until the list is first written
+    its DataSet is empty, and it is made again with chunks sized for that
+    many items, as the default chunks are small.  The DataSet is extended to
+    hold them, so writing up to that many items does not extend it again.
+    The room left unused is trimmed when the BAG is closed.
+
+    A ReadOnlyError exception is thrown if the BAG is read only.
+
+\param numItems
+    The number of items expected.
+*/
+void VRTrackingList::preallocate(
+    size_t numItems)
+{
+    if (m_pBagDataset.expired() || !m_pH5dataSet)
+        throw DatasetNotFound{};
+
+    const auto pDataset = m_pBagDataset.lock();
+    if (pDataset->getDescriptor().isReadOnly())
+        throw ReadOnlyError{};
+
+    m_items.reserve(numItems);
+
+    hsize_t fileLength = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&fileLength);
+
+    if (fileLength == 0 && numItems > 0)
+    {
+        const auto& h5file = pDataset->getH5file();
+        const auto compression = getCompressionSpec(h5file, VR_TRACKING_LIST_PATH);
+
+        m_pH5dataSet.reset();
+        h5file.unlink(VR_TRACKING_LIST_PATH);
+        m_pH5dataSet = this->createH5dataSet(compression, numItems);
+    }
+    else if (fileLength < numItems)
+    {
+        const hsize_t length = numItems;
+        m_pH5dataSet->extend(&length);
+    }
+
+    m_numReserved = std::max(m_numReserved, numItems);
+}
+
 //! Retrieve a pointer to the first item in the tracking list.
 /*!
 \return
@@ -239,6 +361,7 @@ void VRTrackingList::resize(size_t count)
 */
 VRTrackingList::value_type* VRTrackingList::data() & noexcept
 {
+    this->markChanged(0);
     return m_items.data();
 }
 
@@ -254,15 +377,19 @@ const VRTrackingList::value_type* VRTrackingList::data() const & noexcept
 
 //! Create the HDF5 DataSet the tracking list wraps.
 /*!
-\param compressionLevel
-    The compression level the HDF5 DataSet will use.
+\param compression
+    The compression the HDF5 DataSet will use.
+\param numReserved
+    The number of items to make room for; the length of the DataSet, whose
+    chunks are sized for them.  0 for an empty DataSet in small chunks.
 
 \return
     The HDF5 DataSet the tracking list wraps.
 */
 std::unique_ptr<::H5::DataSet, DeleteH5dataSet>
 VRTrackingList::createH5dataSet(
-    int compressionLevel)
+    const CompressionSpec& compression,
+    size_t numReserved)
 {
     if (m_pBagDataset.expired())
         throw DatasetNotFound{};
@@ -270,37 +397,20 @@ VRTrackingList::createH5dataSet(
     const auto pDataset = m_pBagDataset.lock();
     const auto& h5file = pDataset->getH5file();
 
-    constexpr hsize_t numEntries = 0;
+    const hsize_t numEntries = numReserved;
     constexpr hsize_t kUnlimitedSize = H5F_UNLIMITED;
     const ::H5::DataSpace h5dataSpace{1, &numEntries, &kUnlimitedSize};
 
-    const ::H5::CompType h5dataType{sizeof(value_type)};
-
-    h5dataType.insertMember("row", HOFFSET(value_type, row),
-        ::H5::PredType::NATIVE_UINT32);
-    h5dataType.insertMember("col", HOFFSET(value_type, col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5dataType.insertMember("sub_row", HOFFSET(value_type, sub_row),
-        ::H5::PredType::NATIVE_UINT32);
-    h5dataType.insertMember("sub_col", HOFFSET(value_type, sub_col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5dataType.insertMember("depth", HOFFSET(value_type, depth),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5dataType.insertMember("uncertainty", HOFFSET(value_type, uncertainty),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5dataType.insertMember("track_code", HOFFSET(value_type, track_code),
-        ::H5::PredType::NATIVE_UINT8);
-    h5dataType.insertMember("list_series", HOFFSET(value_type, list_series),
-        ::H5::PredType::NATIVE_UINT16);
+    const hsize_t chunkSize = numReserved > 0 ?
+        getHintedChunkSize(numReserved, sizeof(value_type)) : kChunkSize;
 
     const ::H5::DSetCreatPropList h5createPropList{};
-    h5createPropList.setChunk(1, &kChunkSize);
+    h5createPropList.setChunk(1, &chunkSize);
 
-    if (compressionLevel > 0 && compressionLevel <= kMaxCompressionLevel)
-        h5createPropList.setDeflate(compressionLevel);
+    setCompression(h5createPropList, compression);
 
     const auto h5dataSet = h5file.createDataSet(VR_TRACKING_LIST_PATH,
-        h5dataType, h5dataSpace, h5createPropList);
+        *m_pH5itemType, h5dataSpace, h5createPropList);
 
     const ::H5::DataSpace listLengthDataSpace{};
     const auto listLengthAtt = h5dataSet.createAttribute(
@@ -351,77 +461,608 @@ VRTrackingList::openH5dataSet()
     for (int i=0; i<ndims; ++i)
         numItems *= dims[i];
 
-    m_items.resize(numItems);
+    // A list not trimmed when its BAG was closed (see preallocate()) holds
+    // room past its items.
+    const hsize_t count = std::min<size_t>(numItems, length);
+    m_items.resize(static_cast<size_t>(count));
 
-    // Set up the structure for reading.
-    ::H5::CompType h5type(sizeof(value_type));
+    const hsize_t offset = 0;
+    h5dataSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
 
-    h5type.insertMember("row", HOFFSET(value_type, row),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("col", HOFFSET(value_type, col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("sub_row", HOFFSET(value_type, sub_row),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("sub_col", HOFFSET(value_type, sub_col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("depth", HOFFSET(value_type, depth),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5type.insertMember("uncertainty", HOFFSET(value_type, uncertainty),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5type.insertMember("track_code", HOFFSET(value_type, track_code),
-        ::H5::PredType::NATIVE_UINT8);
-    h5type.insertMember("list_series", HOFFSET(value_type, list_series),
-        ::H5::PredType::NATIVE_UINT16);
+    h5dataSet.read(m_items.data(), *m_pH5itemType, ::H5::DataSpace{1, &count},
+        h5dataSpace);
 
-    h5dataSet.read(m_items.data(), h5type);
+    m_numWritten = m_items.size();
 
     return std::unique_ptr<::H5::DataSet, DeleteH5dataSet>(
         new ::H5::DataSet{h5dataSet}, DeleteH5dataSet{});
 }
 
+//! Note that items may be about to change.
+/*!
+    Called by everything that can change the items.  The sorted positions
+    of the items and the VRTrackingTable become out of date, the items are
+    no longer known to be sorted, and the items from firstChanged on are
+    written by the next write().
+
+\param firstChanged
+    The first item that may change.
+*/
+void VRTrackingList::markChanged(
+    size_t firstChanged) noexcept
+{
+    m_isIndexed = false;
+    m_numWritten = std::min(m_numWritten, firstChanged);
+    m_sortKey = SortKey::none;
+    m_pTable.reset();
+}
+
+//! Sort the positions of the items, if they are out of date.
+void VRTrackingList::updateIndex() const
+{
+    if (m_isIndexed)
+        return;
+
+    // The order of the key the items are sorted by comes for free.
+    indexTrackingItems(m_items, getNodeKey, m_sortKey == SortKey::node,
+        m_sortDescending, m_nodeOrder);
+    indexTrackingItems(m_items, getSubNodeKey, m_sortKey == SortKey::subNode,
+        m_sortDescending, m_subNodeOrder);
+    indexTrackingItems(m_items, getCodeKey, m_sortKey == SortKey::code,
+        m_sortDescending, m_codeOrder);
+    indexTrackingItems(m_items, getSeriesKey, m_sortKey == SortKey::series,
+        m_sortDescending, m_seriesOrder);
+
+    m_isIndexed = true;
+}
+
+//! Lock the BAG Dataset for reading, and bring the sorted positions up to date.
+/*!
+\return
+    The lock.
+*/
+std::unique_lock<std::recursive_mutex> VRTrackingList::lockIndex() const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    auto lock = pDataset ? pDataset->lockReads()
+        : std::unique_lock<std::recursive_mutex>{};
+    if (!pDataset)
+    {
+        this->updateIndex();
+        return lock;
+    }
+
+    pDataset->releaseRequestedCaches();
+
+    if (!m_isIndexed)
+    {
+        this->updateIndex();
+        pDataset->reportCacheUsage();
+    }
+
+    return lock;
+}
+
+//! Retrieve the memory held by the sorted positions, and the table, of the
+//! items.
+/*!
+\return
+    The memory held, in bytes.
+*/
+uint64_t VRTrackingList::getCacheBytes() const noexcept
+{
+    uint64_t bytes = (m_nodeOrder.capacity() + m_subNodeOrder.capacity() +
+        m_codeOrder.capacity() + m_seriesOrder.capacity()) * sizeof(uint32_t);
+
+    if (m_pTable)
+        bytes += sizeof(VRTrackingTable) +
+            m_pTable->m_items.capacity() * sizeof(value_type) +
+            m_pTable->m_nodeKeys.capacity() * sizeof(uint64_t) +
+            m_pTable->m_nodeOffsets.capacity() * sizeof(uint32_t);
+
+    return bytes;
+}
+
+//! Discard the sorted positions, and the table, of the items.
+/*!
+    They are made again when next needed.  Tables handed out stay valid.
+*/
+void VRTrackingList::releaseCaches() const noexcept
+{
+    std::vector<uint32_t>{}.swap(m_nodeOrder);
+    std::vector<uint32_t>{}.swap(m_subNodeOrder);
+    std::vector<uint32_t>{}.swap(m_codeOrder);
+    std::vector<uint32_t>{}.swap(m_seriesOrder);
+    m_isIndexed = false;
+    m_pTable.reset();
+}
+
+//! Find the items of a node.
+/*!
+    The items are sorted by node the first time they are searched, and again
+    after they change.
+
+\param row
+    The row of the node.
+\param col
+    The column of the node.
+
+\return
+    The items of the node, in the order of the variable resolution tracking list.
+*/
+std::vector<VRTrackingList::value_type> VRTrackingList::getItemsAtNode(
+    uint32_t row,
+    uint32_t col) const
+{
+    const auto lock = this->lockIndex();
+
+    return findTrackingItems(m_items, m_nodeOrder, makeNodeKey(row, col),
+        getNodeKey);
+}
+
+//! Find the items of a sub node.
+/*!
+\param subRow
+    The row within the refined grid.
+\param subCol
+    The column within the refined grid.
+
+\return
+    The items of the sub node, in the order of the variable resolution tracking list.
+*/
+std::vector<VRTrackingList::value_type> VRTrackingList::getItemsAtSubNode(
+    uint32_t subRow,
+    uint32_t subCol) const
+{
+    const auto lock = this->lockIndex();
+
+    return findTrackingItems(m_items, m_subNodeOrder,
+        makeNodeKey(subRow, subCol), getSubNodeKey);
+}
+
+//! Find the items with a track code.
+/*!
+\param code
+    The track code.
+
+\return
+    The items with the track code, in the order of the variable resolution tracking list.
+*/
+std::vector<VRTrackingList::value_type> VRTrackingList::getItemsWithCode(
+    uint8_t code) const
+{
+    const auto lock = this->lockIndex();
+
+    return findTrackingItems(m_items, m_codeOrder, code,
+        getCodeKey);
+}
+
+//! Find the items in a list series.
+/*!
+\param series
+    The list series.
+
+\return
+    The items in the list series, in the order of the variable resolution tracking list.
+*/
+std::vector<VRTrackingList::value_type> VRTrackingList::getItemsInSeries(
+    uint16_t series) const
+{
+    const auto lock = this->lockIndex();
+
+    return findTrackingItems(m_items, m_seriesOrder, series,
+        getSeriesKey);
+}
+
+//! Find the items of the nodes in a region.
+/*!
+\param rowStart
+    The starting row.
+\param colStart
+    The starting column.
+\param rowEnd
+    The ending row (inclusive).
+\param colEnd
+    The ending column (inclusive).
+
+\return
+    The items of the nodes in the region, ordered by row, then column, then
+    by their order in the variable resolution tracking list.
+*/
+std::vector<VRTrackingList::value_type> VRTrackingList::getItemsInWindow(
+    uint32_t rowStart,
+    uint32_t colStart,
+    uint32_t rowEnd,
+    uint32_t colEnd) const
+{
+    if (rowStart > rowEnd || colStart > colEnd)
+        throw InvalidReadSize{};
+
+    const auto lock = this->lockIndex();
+
+    // The rows between the corners are contiguous in node order; only the
+    // columns need checking.
+    return findTrackingItems(m_items, m_nodeOrder,
+        makeNodeKey(rowStart, colStart), makeNodeKey(rowEnd, colEnd),
+        getNodeKey,
+        [colStart, colEnd](const value_type& item) {
+            return item.col >= colStart && item.col <= colEnd;
+        });
+}
+
+//! Retrieve the items grouped by node.
+/*!
+    The table is made the first time it is needed, and again after the
+    items change.  A table already handed out keeps the items it was made
+    from.
+
+\return
+    The items grouped by node.
+*/
+std::shared_ptr<const VRTrackingTable> VRTrackingList::getTable() const
+{
+    const auto pDataset = m_pBagDataset.lock();
+    const auto lock = pDataset ? pDataset->lockReads()
+        : std::unique_lock<std::recursive_mutex>{};
+    if (pDataset)
+        pDataset->releaseRequestedCaches();
+
+    if (!m_pTable)
+    {
+        std::vector<value_type> items;
+
+        if (m_sortKey == SortKey::node && !m_sortDescending)
+            items = m_items;
+        else
+        {
+            std::vector<uint32_t> order;
+            sortTrackingItems(m_items, getSubNodeKey, order);
+            radixSortTrackingItems(m_items, getNodeKey, false, order);
+
+            items.reserve(order.size());
+            for (const auto index : order)
+                items.push_back(m_items[index]);
+        }
+
+        m_pTable = std::shared_ptr<const VRTrackingTable>(new VRTrackingTable{
+            std::move(items)});
+
+        if (pDataset)
+            pDataset->reportCacheUsage();
+    }
+
+    return m_pTable;
+}
+
+//! Sort the items by node; by row, column, sub row, then sub column.
+/*!
+    Items of the same refined node keep their order.  Sorting a list that
+    is already sorted the same way, and not changed since, does nothing.
+
+\param descending
+    \e true to sort from the last node to the first.
+*/
+void VRTrackingList::sortByNode(
+    bool descending)
+{
+    if (m_sortKey == SortKey::node && m_sortDescending == descending)
+        return;
+
+    // Sort by the sub node, then the node; each pass keeps the order of the
+    // last.
+    std::vector<uint32_t> order;
+    sortTrackingItems(m_items, getSubNodeKey, order, descending);
+    radixSortTrackingItems(m_items, getNodeKey, descending, order);
+
+    this->applySort(SortKey::node, descending, order);
+}
+
+//! Sort the items by sub node; by sub row, then sub column.
+/*!
+    Items of the same sub node keep their order.  Sorting a list that is
+    already sorted the same way, and not changed since, does nothing.
+
+\param descending
+    \e true to sort from the last sub node to the first.
+*/
+void VRTrackingList::sortBySubNode(
+    bool descending)
+{
+    if (m_sortKey == SortKey::subNode && m_sortDescending == descending)
+        return;
+
+    std::vector<uint32_t> order;
+    sortTrackingItems(m_items, getSubNodeKey, order, descending);
+
+    this->applySort(SortKey::subNode, descending, order);
+}
+
+//! Sort the items by track code.
+/*!
+    Items with the same track code keep their order.  Sorting a list that
+    is already sorted the same way, and not changed since, does nothing.
+
+\param descending
+    \e true to sort from the largest track code to the smallest.
+*/
+void VRTrackingList::sortByCode(
+    bool descending)
+{
+    if (m_sortKey == SortKey::code && m_sortDescending == descending)
+        return;
+
+    std::vector<uint32_t> order;
+    sortTrackingItems(m_items, getCodeKey, order, descending);
+
+    this->applySort(SortKey::code, descending, order);
+}
+
+//! Sort the items by list series.
+/*!
+    Items in the same list series keep their order.  Sorting a list that
+    is already sorted the same way, and not changed since, does nothing.
+
+\param descending
+    \e true to sort from the largest list series to the smallest.
+*/
+void VRTrackingList::sortBySeries(
+    bool descending)
+{
+    if (m_sortKey == SortKey::series && m_sortDescending == descending)
+        return;
+
+    std::vector<uint32_t> order;
+    sortTrackingItems(m_items, getSeriesKey, order, descending);
+
+    this->applySort(SortKey::series, descending, order);
+}
+
+//! Reorder the items, and remember what they are sorted by.
+/*!
+\param key
+    What the items are sorted by.
+\param descending
+    \e true if they are sorted from the largest key to the smallest.
+\param order
+    The position in the list of each item, in sorted order.
+*/
+void VRTrackingList::applySort(
+    SortKey key,
+    bool descending,
+    const std::vector<uint32_t>& order)
+{
+    const auto firstMoved = reorderTrackingItems(m_items, order);
+    if (firstMoved < m_items.size())
+        this->markChanged(firstMoved);
+
+    m_sortKey = key;
+    m_sortDescending = descending;
+}
+
 //! Write the tracking list to the HDF5 DataSet.
+/*!
+    Only the items added, or reachable through a non-const accessor, since
+    the last write are written.  During a batch (see Dataset::beginBatch())
+    the write is deferred to Dataset::commit(), so it is made once however
+    many times this is called.
+*/
 void VRTrackingList::write() const
 {
     if (m_pBagDataset.expired() || !m_pH5dataSet)
         throw DatasetNotFound{};
 
+    if (m_pBagDataset.lock()->isInBatch())
+    {
+        m_writeDeferred = true;
+        return;
+    }
+
+    this->writeItems();
+}
+
+//! Write the tracking list to the HDF5 DataSet now.
+void VRTrackingList::writeItems() const
+{
     // Write the Attribute.
-    const ::H5::DataSpace listLengthDataSpace{};
     const ::H5::Attribute listLengthAtt = m_pH5dataSet->openAttribute(
         VR_TRACKING_LIST_LENGTH_NAME);
 
     const uint32_t length = static_cast<uint32_t>(m_items.size());
     listLengthAtt.write(::H5::PredType::NATIVE_UINT32, &length);
 
-    // Resize the DataSet to reflect the new data size.
+    // Resize the DataSet to reflect the new data size, keeping the room
+    // made by preallocate().
     const hsize_t numItems = length;
-    m_pH5dataSet->extend(&numItems);
+    const hsize_t extent = std::max<hsize_t>(numItems, m_numReserved);
+    hsize_t fileLength = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&fileLength);
 
-    // Write the data.
-    const ::H5::CompType h5type{sizeof(value_type)};
+    if (fileLength != extent)
+        m_pH5dataSet->extend(&extent);
 
-    h5type.insertMember("row", HOFFSET(value_type, row),
-::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("col", HOFFSET(value_type, col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("sub_row", HOFFSET(value_type, sub_row),
-::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("sub_col", HOFFSET(value_type, sub_col),
-        ::H5::PredType::NATIVE_UINT32);
-    h5type.insertMember("depth", HOFFSET(value_type, depth),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5type.insertMember("uncertainty", HOFFSET(value_type, uncertainty),
-        ::H5::PredType::NATIVE_FLOAT);
-    h5type.insertMember("track_code", HOFFSET(value_type, track_code),
-        ::H5::PredType::NATIVE_UINT8);
-    h5type.insertMember("list_series", HOFFSET(value_type, list_series),
-        ::H5::PredType::NATIVE_UINT16);
+    // Write the items changed since the last write.
+    if (m_numWritten < m_items.size())
+    {
+        const hsize_t offset = m_numWritten;
+        const hsize_t count = numItems - offset;
+
+        const ::H5::DataSpace h5memSpace{1, &count};
+
+        const auto h5fileSpace = m_pH5dataSet->getSpace();
+        h5fileSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+
+        m_pH5dataSet->write(m_items.data() + m_numWritten, *m_pH5itemType,
+            h5memSpace, h5fileSpace);
+    }
+
+    m_numWritten = m_items.size();
+    m_writeDeferred = false;
+}
 
-    constexpr hsize_t kMaxSize = H5F_UNLIMITED;
-    ::H5::DataSpace h5memSpace{1, &numItems, &kMaxSize};
-    ::H5::DataSpace h5fileSpace{1, &numItems, &kMaxSize};
+//! Trim the HDF5 DataSet to the items written.
+/*!
+    Drops the room made by preallocate() that was not written to; called
+    when the BAG is closed.
+*/
+void VRTrackingList::trim()
+{
+    if (m_numReserved == 0 || !m_pH5dataSet)
+        return;
+
+    m_numReserved = 0;
+
+    const auto listLengthAtt = m_pH5dataSet->openAttribute(
+        VR_TRACKING_LIST_LENGTH_NAME);
+
+    uint32_t length = 0;
+    listLengthAtt.read(::H5::PredType::NATIVE_UINT32, &length);
+
+    hsize_t fileLength = 0;
+    m_pH5dataSet->getSpace().getSimpleExtentDims(&fileLength);
+
+    if (fileLength > length)
+    {
+        const hsize_t numItems = length;
+        m_pH5dataSet->extend(&numItems);
+    }
+}
+
+//! Constructor.
+/*!
+\param items
+    The items, sorted by node, then sub node.
+*/
+VRTrackingTable::VRTrackingTable(
+    std::vector<value_type> items)
+    : m_items(std::move(items))
+{
+    // One pass over the items, starting a node wherever the key changes.
+    for (size_t i=0; i<m_items.size(); ++i)
+    {
+        const auto key = getNodeKey(m_items[i]);
+
+        if (m_nodeKeys.empty() || m_nodeKeys.back() != key)
+        {
+            m_nodeKeys.push_back(key);
+            m_nodeOffsets.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    m_nodeOffsets.push_back(static_cast<uint32_t>(m_items.size()));
+}
+
+//! Retrieve the items.
+/*!
+\return
+    The items, sorted by node, then sub node.
+*/
+const VRTrackingItem* VRTrackingTable::data() const noexcept
+{
+    return m_items.data();
+}
+
+//! Retrieve the first item.
+/*!
+\return
+    The first item.
+*/
+const VRTrackingItem* VRTrackingTable::begin() const noexcept
+{
+    return this->data();
+}
+
+//! Retrieve one past the last item.
+/*!
+\return
+    One past the last item.
+*/
+const VRTrackingItem* VRTrackingTable::end() const noexcept
+{
+    return this->data() + this->size();
+}
+
+//! Retrieve the number of items.
+/*!
+\return
+    The number of items.
+*/
+size_t VRTrackingTable::size() const noexcept
+{
+    return m_items.size();
+}
+
+//! Retrieve the number of nodes with any items.
+/*!
+\return
+    The number of nodes with any items.
+*/
+size_t VRTrackingTable::getNumNodes() const noexcept
+{
+    return m_nodeKeys.size();
+}
+
+//! Retrieve the items of a node.
+/*!
+\param row
+    The row of the node.
+\param col
+    The column of the node.
+
+\return
+    The first and one past the last item of the node, sorted by sub node;
+    an empty range if the node has no items.
+*/
+VRTrackingTable::range VRTrackingTable::getItemsAtNode(
+    uint32_t row,
+    uint32_t col) const noexcept
+{
+    const auto key = makeNodeKey(row, col);
+
+    const auto found = std::lower_bound(m_nodeKeys.begin(), m_nodeKeys.end(),
+        key);
+    if (found == m_nodeKeys.end() || *found != key)
+        return {this->end(), this->end()};
 
-    m_pH5dataSet->write(m_items.data(), h5type, h5memSpace, h5fileSpace);
+    const auto node = static_cast<size_t>(found - m_nodeKeys.begin());
+
+    return {this->data() + m_nodeOffsets[node],
+        this->data() + m_nodeOffsets[node + 1]};
+}
+
+//! Retrieve the items of a sub node.
+/*!
+\param row
+    The row of the node.
+\param col
+    The column of the node.
+\param subRow
+    The row within the refined grid of the node.
+\param subCol
+    The column within the refined grid of the node.
+
+\return
+    The first and one past the last item of the sub node, in the order of
+    the tracking list; an empty range if the sub node has no items.
+*/
+VRTrackingTable::range VRTrackingTable::getItemsAtSubNode(
+    uint32_t row,
+    uint32_t col,
+    uint32_t subRow,
+    uint32_t subCol) const noexcept
+{
+    const auto node = this->getItemsAtNode(row, col);
+    const auto key = makeNodeKey(subRow, subCol);
+
+    const auto first = std::lower_bound(node.first, node.second, key,
+        [](const value_type& item, uint64_t subNodeKey) {
+            return getSubNodeKey(item) < subNodeKey;
+        });
+    const auto last = std::upper_bound(first, node.second, key,
+        [](uint64_t subNodeKey, const value_type& item) {
+            return subNodeKey < getSubNodeKey(item);
+        });
+
+    return {first, last};
 }
 
 }   //namespace BAG
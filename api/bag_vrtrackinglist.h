@@ -6,7 +6,11 @@
 #include "bag_fordec.h"
 #include "bag_types.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 
@@ -23,6 +27,48 @@ namespace BAG {
 #pragma warning(disable: 4251)  // std classes do not have DLL-interface when exporting
 #endif
 
+//! The items of a variable resolution tracking list, grouped by node.
+/*!
+    The items are sorted by node, then sub node, and the first item of
+    each node with any items is kept alongside, so the items of a node, or
+    of one of its sub nodes, are found without visiting the others.
+*/
+class BAG_API VRTrackingTable final
+{
+public:
+    using value_type = VRTrackingItem;
+    using range = std::pair<const value_type*, const value_type*>;
+
+    VRTrackingTable(const VRTrackingTable&) = delete;
+    VRTrackingTable(VRTrackingTable&&) = delete;
+
+    VRTrackingTable& operator=(const VRTrackingTable&) = delete;
+    VRTrackingTable& operator=(VRTrackingTable&&) = delete;
+
+    const value_type* data() const noexcept;
+    const value_type* begin() const noexcept;
+    const value_type* end() const noexcept;
+    size_t size() const noexcept;
+
+    size_t getNumNodes() const noexcept;
+
+    range getItemsAtNode(uint32_t row, uint32_t col) const noexcept;
+    range getItemsAtSubNode(uint32_t row, uint32_t col, uint32_t subRow,
+        uint32_t subCol) const noexcept;
+
+private:
+    explicit VRTrackingTable(std::vector<value_type> items);
+
+    //! The items, sorted by node, then sub node.
+    std::vector<value_type> m_items;
+    //! The nodes with any items, sorted.
+    std::vector<uint64_t> m_nodeKeys;
+    //! The first item of each node; one extra for the total.
+    std::vector<uint32_t> m_nodeOffsets;
+
+    friend VRTrackingList;
+};
+
 //! The interface for the variable resolution tracking list.
 class BAG_API VRTrackingList final
 {
@@ -33,7 +79,7 @@ public:
     using reference = value_type&;
     using const_reference = const value_type&;
 
-    VRTrackingList(const Dataset& dataset, int compressionLevel);
+    VRTrackingList(const Dataset& dataset, const CompressionSpec& compression);
     VRTrackingList(const VRTrackingList&) = delete;
     VRTrackingList(VRTrackingList&&) = delete;
     // Allow std::make_shared() to call our constructor
@@ -70,6 +116,7 @@ public:
     const_reference back() const &;
     void reserve(size_t newCapacity);
     void resize(size_t count);
+    void preallocate(size_t numItems);
     value_type* data() & noexcept;
     const value_type* data() const & noexcept;
 
@@ -78,19 +125,80 @@ public:
     reference operator[](size_t index) & noexcept;
     const_reference operator[](size_t index) const & noexcept;
 
+    std::vector<value_type> getItemsAtNode(uint32_t row, uint32_t col) const;
+    std::vector<value_type> getItemsAtSubNode(uint32_t subRow,
+        uint32_t subCol) const;
+    std::vector<value_type> getItemsWithCode(uint8_t code) const;
+    std::vector<value_type> getItemsInSeries(uint16_t series) const;
+    std::vector<value_type> getItemsInWindow(uint32_t rowStart,
+        uint32_t colStart, uint32_t rowEnd, uint32_t colEnd) const;
+
+    std::shared_ptr<const VRTrackingTable> getTable() const;
+
+    void sortByNode(bool descending = false);
+    void sortBySubNode(bool descending = false);
+    void sortByCode(bool descending = false);
+    void sortBySeries(bool descending = false);
+
     void write() const;
 
 protected:
 
 private:
+    //! What the items are sorted by.
+    enum class SortKey
+    {
+        none,
+        node,
+        subNode,
+        code,
+        series,
+    };
+
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> createH5dataSet(
-        int compressionLevel);
+        const CompressionSpec& compression, size_t numReserved = 0);
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> openH5dataSet();
 
+    void markChanged(size_t firstChanged) noexcept;
+    void applySort(SortKey key, bool descending,
+        const std::vector<uint32_t>& order);
+    void updateIndex() const;
+    std::unique_lock<std::recursive_mutex> lockIndex() const;
+
+    uint64_t getCacheBytes() const noexcept;
+    void releaseCaches() const noexcept;
+    void writeItems() const;
+    void trim();
+
     //! The associated BAG Dataset.
     std::weak_ptr<const Dataset> m_pBagDataset;
     //! The items making up the tracking list.
     std::vector<value_type> m_items;
+    //! The position of each item, sorted by node.
+    mutable std::vector<uint32_t> m_nodeOrder;
+    //! The position of each item, sorted by sub node.
+    mutable std::vector<uint32_t> m_subNodeOrder;
+    //! The position of each item, sorted by track code.
+    mutable std::vector<uint32_t> m_codeOrder;
+    //! The position of each item, sorted by list series.
+    mutable std::vector<uint32_t> m_seriesOrder;
+    //! Are the sorted positions up to date with the items?
+    mutable bool m_isIndexed = false;
+    //! The items grouped by node, made the first time they are needed.
+    mutable std::shared_ptr<const VRTrackingTable> m_pTable;
+    //! What the items are known to be sorted by.
+    SortKey m_sortKey = SortKey::none;
+    //! Are the items sorted from the largest key to the smallest?
+    bool m_sortDescending = false;
+    //! The number of leading items known to match the HDF5 DataSet.
+    mutable size_t m_numWritten = 0;
+    //! Was a write() deferred until the batch it was made in is committed?
+    mutable bool m_writeDeferred = false;
+    //! The number of items room was made for in the HDF5 DataSet by
+    //! preallocate(); 0 once trimmed.
+    size_t m_numReserved = 0;
+    //! The HDF5 type of an item.
+    std::unique_ptr<::H5::DataType, DeleteH5dataType> m_pH5itemType;
     //! The HDF5 DataSet this class relates to.
     std::unique_ptr<::H5::DataSet, DeleteH5dataSet> m_pH5dataSet;
 
@@ -126,6 +234,7 @@ private:
 template <typename... Args>
 void VRTrackingList::emplace_back(Args&&... args) &
 {
+    this->markChanged(m_items.size());
     m_items.emplace_back(std::forward<Args>(args)...);
 }
 
@@ -12,6 +12,7 @@
 #include "bag_dataset.h"
 %}
 
+%import "bag_datasetsnapshot.i"
 %import "bag_layer.i"
 %import "bag_georefmetadatalayer.i"
 %import "bag_descriptor.i"
@@ -47,12 +48,37 @@ public:
     %rename(openDataset) open(const std::string &, OpenMode);
     static std::shared_ptr<Dataset> open(const std::string & fileName,
         OpenMode openMode);
+    %rename(openDataset) open(const std::string &, OpenMode,
+        const OpenOptions&);
+    static std::shared_ptr<Dataset> open(const std::string & fileName,
+        OpenMode openMode, const OpenOptions& options);
 
     static std::shared_ptr<Dataset> create(const std::string& fileName,
         Metadata&& metadata, uint64_t chunkSize, int compressionLevel);
+    static std::shared_ptr<Dataset> create(const std::string& fileName,
+        Metadata&& metadata, const ChunkShape& chunkShape,
+        const CompressionSpec& compression);
+    static std::shared_ptr<Dataset> createInMemory(Metadata&& metadata,
+        uint64_t chunkSize, int compressionLevel,
+        const std::string& persistFileName);
+    static std::shared_ptr<Dataset> createInMemory(Metadata&& metadata,
+        const ChunkShape& chunkShape, const CompressionSpec& compression,
+        const std::string& persistFileName);
+
+    static bool isCompressionFilterAvailable(int filter) noexcept;
 
     void close();
 
+    bool isConcurrentReadEnabled() const noexcept;
+
+    bool isCollectingIoStats() const noexcept;
+    void setCollectIoStats(bool collect) noexcept;
+    DatasetIoStats getIoStats() const;
+    void resetIoStats();
+
+    DatasetMemoryUsage getMemoryUsage() const;
+    void releaseCaches() const;
+
     Dataset(const Dataset&) = delete;
     Dataset(Dataset&&) = delete;
 
@@ -70,11 +96,20 @@ public:
 
     std::vector<LayerType> getLayerTypes() const;
 
+    std::shared_ptr<const DatasetSnapshot> loadSnapshot(
+        const std::vector<LayerType>& types = {}) const;
+
     Layer& createSimpleLayer(LayerType type, uint64_t chunkSize,
         int compressionLevel) &;
+    Layer& createSimpleLayer(LayerType type, const ChunkShape& chunkShape,
+        const CompressionSpec& compression,
+        const Quantization& quantization = {}) &;
     GeorefMetadataLayer& createGeorefMetadataLayer(DataType indexType, GeorefMetadataProfile profile,
         const std::string& name, const RecordDefinition& definition,
         uint64_t chunkSize, int compressionLevel) &;
+    GeorefMetadataLayer& createGeorefMetadataLayer(DataType indexType, GeorefMetadataProfile profile,
+        const std::string& name, const RecordDefinition& definition,
+        const ChunkShape& chunkShape, const CompressionSpec& compression) &;
     %rename(createMetadataProfileGeorefMetadataLayer) createGeorefMetadataLayer(GeorefMetadataProfile profile,
                                                                                 const std::string& name,
                                                                                 uint64_t chunkSize,
@@ -87,25 +122,30 @@ public:
     SurfaceCorrections& createSurfaceCorrections(
         BAG_SURFACE_CORRECTION_TOPOGRAPHY type, uint8_t numCorrectors,
         uint64_t chunkSize, int compressionLevel) &;
+    SurfaceCorrections& createSurfaceCorrections(
+        BAG_SURFACE_CORRECTION_TOPOGRAPHY type, uint8_t numCorrectors,
+        const ChunkShape& chunkShape, const CompressionSpec& compression) &;
 
     void createVR(uint64_t chunkSize, int compressionLevel, bool makeNode);
+    void createVR(uint64_t chunkSize, const CompressionSpec& compression,
+        bool makeNode);
 
     const Metadata& getMetadata() const & noexcept;
 
     TrackingList& getTrackingList() & noexcept;
 
-    std::shared_ptr<GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) & noexcept;
-    std::vector<std::shared_ptr<GeorefMetadataLayer>> getGeorefMetadataLayers() & noexcept;
+    std::shared_ptr<GeorefMetadataLayer> getGeorefMetadataLayer(const std::string& name) &;
+    std::vector<std::shared_ptr<GeorefMetadataLayer>> getGeorefMetadataLayers() &;
 
-    std::shared_ptr<SurfaceCorrections> getSurfaceCorrections() & noexcept;
+    std::shared_ptr<SurfaceCorrections> getSurfaceCorrections() &;
 
-    std::shared_ptr<SimpleLayer> getSimpleLayer(LayerType type) & noexcept;
+    std::shared_ptr<SimpleLayer> getSimpleLayer(LayerType type) &;
 
-    std::shared_ptr<VRMetadata> getVRMetadata() & noexcept;
+    std::shared_ptr<VRMetadata> getVRMetadata() &;
 
-    std::shared_ptr<VRNode> getVRNode() & noexcept;
+    std::shared_ptr<VRNode> getVRNode() &;
 
-    std::shared_ptr<VRRefinements> getVRRefinements() & noexcept;
+    std::shared_ptr<VRRefinements> getVRRefinements() &;
 
     std::shared_ptr<VRTrackingList> getVRTrackingList() & noexcept;
 
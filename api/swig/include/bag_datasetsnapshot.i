@@ -0,0 +1,70 @@
+%begin %{
+#ifdef _MSC_VER
+#ifdef SWIGPYTHON
+#define SWIG_PYTHON_INTERPRETER_NO_DEBUG
+#endif
+#endif
+%}
+
+%module bag_datasetsnapshot
+
+%{
+#include "bag_datasetsnapshot.h"
+%}
+
+#define final
+
+%import "bag_trackinglist.i"
+%import "bag_types.i"
+%import "bag_uint8array.i"
+%import "bag_exceptions.i"
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <stdint.i>
+%shared_ptr(BAG::DatasetSnapshot)
+
+BAG_ALLOW_THREADS(BAG::DatasetSnapshot::readLayers)
+BAG_ALLOW_THREADS(BAG::DatasetSnapshot::exportToSharedMemory)
+BAG_ALLOW_THREADS(BAG::DatasetSnapshot::attachSharedMemory)
+
+namespace BAG {
+
+%nodefaultctor DatasetSnapshot;
+
+// Only the simple layers and tracking list, which a snapshot shared between
+// processes holds, are exposed.
+class DatasetSnapshot final
+{
+public:
+    DatasetSnapshot(const DatasetSnapshot&) = delete;
+    DatasetSnapshot(DatasetSnapshot&&) = delete;
+
+    DatasetSnapshot& operator=(const DatasetSnapshot&) = delete;
+    DatasetSnapshot& operator=(DatasetSnapshot&&) = delete;
+
+    static std::shared_ptr<const DatasetSnapshot> attachSharedMemory(
+        const std::string& name);
+    static bool removeSharedMemory(const std::string& name) noexcept;
+
+    uint32_t getNumRows() const noexcept;
+    uint32_t getNumColumns() const noexcept;
+    size_t getMemoryUsage() const noexcept;
+
+    bool hasLayer(LayerType type) const noexcept;
+    UInt8Array read(LayerType type, uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd) const;
+    UInt8Array readLayers(uint32_t rowStart, uint32_t columnStart,
+        uint32_t rowEnd, uint32_t columnEnd,
+        const std::vector<LayerType>& types,
+        LayerLayout layout = BAG_LAYOUT_PLANAR) const;
+
+    std::vector<TrackingItem> getTrackingItemsAtNode(uint32_t row,
+        uint32_t column) const;
+
+    void exportToSharedMemory(const std::string& name) const;
+    bool isShared() const noexcept;
+};
+
+}  // namespace BAG
+
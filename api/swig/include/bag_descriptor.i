@@ -72,6 +72,7 @@ namespace BAG {
         //getProjectedCover() const & noexcept;
         //const std::tuple<double, double>& getOrigin() const & noexcept;
         //const std::tuple<double, double>& getGridSpacing() const & noexcept;
+        const GridTransform& getGridTransform() const & noexcept;
 
         Descriptor& setVerticalReferenceSystem(
             const std::string& verticalReferenceSystem) & noexcept;
@@ -30,15 +30,23 @@
 // should be in "derived first" order
 #define FOR_EACH_EXCEPTION(ACTION) \
    ACTION(BAG,CompressionNeedsChunkingSet) \
+   ACTION(BAG,QuantizationNeedsChunkingSet) \
+   ACTION(BAG,QuantizationNeedsEmptyLayer) \
    ACTION(BAG,UnsupportedAttributeType) \
    ACTION(BAG,InvalidType) \
    ACTION(BAG,InvalidDescriptor) \
    ACTION(BAG,InvalidKeyType) \
+   ACTION(BAG,KeyTypeTooNarrow) \
    ACTION(BAG,NameRequired) \
    ACTION(BAG,DatasetNotFound) \
    ACTION(BAG,InvalidLayerId) \
+   ACTION(BAG,SharedMemoryUnavailable) \
+   ACTION(BAG,InvalidSharedMemorySnapshot) \
+   ACTION(BAG,AccessTraceWriteFailed) \
+   ACTION(BAG,InvalidAccessTrace) \
    ACTION(BAG,UnsupportedGroupType) \
    ACTION(BAG,InvalidBuffer) \
+   ACTION(BAG,InvalidSamplePositions) \
    ACTION(BAG,InvalidReadSize) \
    ACTION(BAG,InvalidWriteSize) \
    ACTION(BAG,LayerExists) \
@@ -91,6 +99,59 @@
         SWIG_fail;
     }
 }
+
+%{
+namespace BAG {
+
+//! Releases the GIL while it is alive, so other Python threads can run.
+/*!
+    The GIL is taken back when the object is destroyed, including while an
+    exception is unwinding, so the handlers can raise the Python exception.
+*/
+class AllowPythonThreads final
+{
+public:
+    AllowPythonThreads() noexcept
+        : m_pState(PyEval_SaveThread())
+    {}
+    ~AllowPythonThreads()
+    {
+        PyEval_RestoreThread(m_pState);
+    }
+
+    AllowPythonThreads(const AllowPythonThreads&) = delete;
+    AllowPythonThreads& operator=(const AllowPythonThreads&) = delete;
+
+private:
+    //! The state of the calling thread.
+    PyThreadState* m_pState = nullptr;
+};
+
+}  // namespace BAG
+%}
+
+// Run a wrapped function without holding the GIL.  The function must not
+// touch Python objects; its arguments have already been converted.
+// Concurrent calls on one Dataset need it opened with
+// OpenOptions::concurrentReads, as they do from C++.
+%define BAG_ALLOW_THREADS(Function)
+%exception Function {
+    try {
+        BAG::AllowPythonThreads allowThreads;
+        $action
+    }
+    FOR_EACH_EXCEPTION(CATCH_PE)
+    catch (const std::exception& e) {
+        SWIG_exception(SWIG_RuntimeError, e.what());
+    } catch (...) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        SWIG_fail;
+    }
+}
+%enddef
+#else
+%define BAG_ALLOW_THREADS(Function)
+%enddef
 #endif
 
 %include "bag_exceptions.h"
@@ -18,10 +18,14 @@
 %import "bag_layeritems.i"
 %import "bag_uint8array.i"
 %import "bag_valuetable.i"
+%import "bag_exceptions.i"
 
 %include <std_shared_ptr.i>
 %shared_ptr(BAG::GeorefMetadataLayer)
 
+BAG_ALLOW_THREADS(BAG::GeorefMetadataLayer::readVR)
+BAG_ALLOW_THREADS(BAG::GeorefMetadataLayer::writeVR)
+
 namespace BAG {
 
 class GeorefMetadataLayerDescriptor;
@@ -43,6 +47,10 @@ public:
     ValueTable& getValueTable() & noexcept;
     %ignore getValueTable() const& noexcept;
 
+    DataType getNarrowestKeyType() const;
+    DataType narrowKeyType();
+    void setKeyType(DataType keyType);
+
     //UInt8Array readVR(uint32_t indexStart, uint32_t indexEnd) const;
     //void writeVR(uint32_t indexStart, uint32_t indexEnd, const uint8_t* buffer);
 };
@@ -63,6 +71,26 @@ public:
     {
         $self->writeVR(indexStart, indexEnd, items.data());
     }
+
+    LayerItems readKeys(
+        uint32_t rowStart,
+        uint32_t columnStart,
+        uint32_t rowEnd,
+        uint32_t columnEnd,
+        DataType keyType) const
+    {
+        return BAG::LayerItems{$self->readKeys(rowStart, columnStart, rowEnd,
+            columnEnd, keyType)};
+    }
+
+    LayerItems readVRKeys(
+        uint32_t indexStart,
+        uint32_t indexEnd,
+        DataType keyType) const
+    {
+        return BAG::LayerItems{$self->readVRKeys(indexStart, indexEnd,
+            keyType)};
+    }
 }
 
 }
@@ -19,6 +19,7 @@
 %import "bag_types.i"
 %import "bag_uint8array.i"
 %import "bag_layeritems.i"
+%import "bag_exceptions.i"
 
 %include <std_string.i>
 %include <stdint.i>
@@ -27,6 +28,10 @@
 %shared_ptr(BAG::Layer)
 %shared_ptr(BAG::LayerDescriptor)
 
+BAG_ALLOW_THREADS(BAG::Layer::read)
+BAG_ALLOW_THREADS(BAG::Layer::readBuffer)
+BAG_ALLOW_THREADS(BAG::Layer::write)
+BAG_ALLOW_THREADS(BAG::Layer::readBlockBuffer)
 
 namespace BAG {
 
@@ -58,6 +63,9 @@ public:
     //    uint32_t columnEnd, const uint8_t* buffer);
 
     void writeAttributes() const;
+
+    IoStats getIoStats() const;
+    void resetIoStats() const;
 };
 
 %extend Layer
@@ -72,6 +80,17 @@ public:
             columnEnd)};
     }
 
+    %newobject readBuffer;
+    UInt8Array* readBuffer(
+        uint32_t rowStart,
+        uint32_t columnStart,
+        uint32_t rowEnd,
+        uint32_t columnEnd) const
+    {
+        return new BAG::UInt8Array{$self->read(rowStart, columnStart, rowEnd,
+            columnEnd)};
+    }
+
     void write(
         uint32_t rowStart,
         uint32_t columnStart,
@@ -81,6 +100,141 @@ public:
     {
         $self->write(rowStart, columnStart, rowEnd, columnEnd, items.data());
     }
+
+    std::pair<uint32_t, uint32_t> getDims() const
+    {
+        const auto tiles = $self->tiles();
+        return {tiles.getNumRows(), tiles.getNumColumns()};
+    }
+
+    std::pair<uint32_t, uint32_t> getChunkShape() const
+    {
+        const auto tiles = $self->tiles();
+        return {tiles.getTileRows(), tiles.getTileColumns()};
+    }
+
+    std::pair<uint32_t, uint32_t> getNumChunks() const
+    {
+        const auto tiles = $self->tiles();
+        return {tiles.getNumTileRows(), tiles.getNumTileColumns()};
+    }
+
+    %newobject readBlockBuffer;
+    UInt8Array* readBlockBuffer(
+        uint32_t chunkRow,
+        uint32_t chunkColumn) const
+    {
+        return new BAG::UInt8Array{std::move(
+            $self->tiles().getTile(chunkRow, chunkColumn).data)};
+    }
+
+#ifdef SWIGPYTHON
+    %pythoncode %{
+
+    def numpyDataType(self):
+        """
+          The NumPy dtype of one item of this layer
+        """
+        import numpy
+
+        descriptor = self.getDescriptor()
+        layerType = descriptor.getLayerType()
+        elementSize = descriptor.getElementSize()
+
+        simpleTypes = {
+            DT_FLOAT32: '<f4',
+            DT_UINT32: '<u4',
+            DT_UINT8: '|u1',
+            DT_UINT16: '<u2',
+            DT_UINT64: '<u8',
+            DT_BOOLEAN: '|b1',
+        }
+        dataType = descriptor.getDataType()
+        if dataType in simpleTypes:
+            dtype = numpy.dtype(simpleTypes[dataType])
+        elif layerType == VarRes_Metadata:
+            dtype = numpy.dtype([('index', '<u4'), ('dimensions_x', '<u4'),
+                ('dimensions_y', '<u4'), ('resolution_x', '<f4'),
+                ('resolution_y', '<f4'), ('sw_corner_x', '<f4'),
+                ('sw_corner_y', '<f4')])
+        elif layerType == VarRes_Refinement:
+            dtype = numpy.dtype([('depth', '<f4'), ('depth_uncrt', '<f4')])
+        elif layerType == VarRes_Node:
+            dtype = numpy.dtype([('hyp_strength', '<f4'),
+                ('num_hypotheses', '<u4'), ('n_samples', '<u4')])
+        elif layerType == Surface_Correction:
+            gridded = numpy.dtype([('z', '<f4', (BAG_SURFACE_CORRECTOR_LIMIT,))])
+            dtype = gridded if gridded.itemsize == elementSize else \
+                numpy.dtype([('x', '<f8'), ('y', '<f8'),
+                    ('z', '<f4', (BAG_SURFACE_CORRECTOR_LIMIT,))], align=True)
+        else:
+            dtype = numpy.dtype(('V', elementSize))
+
+        # Anything that does not match the stored items is viewed as raw bytes.
+        if dtype.itemsize != elementSize:
+            dtype = numpy.dtype(('V', elementSize))
+
+        return dtype
+
+    def readArray(self, rowStart, columnStart, rowEnd, columnEnd):
+        """
+          Read a region as a NumPy array of rows x columns (or just columns
+          for the variable resolution node and refinement layers).
+          The array owns the buffer that was read; nothing is copied.
+        """
+        buffer = self.readBuffer(rowStart, columnStart, rowEnd, columnEnd)
+        dtype = self.numpyDataType()
+
+        rows = rowEnd - rowStart + 1
+        columns = columnEnd - columnStart + 1
+        numItems = buffer.size() // dtype.itemsize
+        shape = (rows, columns) if rows * columns == numItems else (numItems,)
+
+        return buffer.asarray(dtype, shape)
+
+    def _chunkSpans(self):
+        numRows, numColumns = self.getDims()
+        chunkRows, chunkColumns = self.getChunkShape()
+
+        rowSpans = tuple(min(chunkRows, numRows - row)
+            for row in range(0, numRows, chunkRows))
+        columnSpans = tuple(min(chunkColumns, numColumns - column)
+            for column in range(0, numColumns, chunkColumns))
+
+        return rowSpans, columnSpans
+
+    def readBlock(self, chunkRow, chunkColumn):
+        """
+          Read the HDF5 chunk at (chunkRow, chunkColumn) of a grid layer as a
+          NumPy array; the chunks along the last row and column are clipped
+          to the grid.  Only that chunk is inflated, and nothing is copied.
+        """
+        buffer = self.readBlockBuffer(chunkRow, chunkColumn)
+        rowSpans, columnSpans = self._chunkSpans()
+
+        return buffer.asarray(self.numpyDataType(),
+            (rowSpans[chunkRow], columnSpans[chunkColumn]))
+
+    def toDask(self):
+        """
+          A lazy dask array of a grid layer, with one dask chunk per HDF5
+          chunk, so each task inflates exactly one chunk.
+          The tasks read through this layer, so the Dataset must stay open
+          until they have run, and be opened with OpenOptions.concurrentReads
+          unless a single threaded scheduler is used.
+        """
+        import dask.array
+        import numpy
+
+        dtype = self.numpyDataType()
+
+        def readBlock(block_id=None):
+            return self.readBlock(*block_id)
+
+        return dask.array.map_blocks(readBlock, dtype=dtype,
+            chunks=self._chunkSpans(), meta=numpy.empty((0, 0), dtype))
+    %}
+#endif
 }
 
 }  // namespace BAG
@@ -43,7 +43,10 @@ public:
     bool operator!=(const LayerDescriptor &rhs) const noexcept;
 
     uint64_t getChunkSize() const noexcept;
+    //! Exposed with std::pair below.
+    //std::tuple<uint64_t, uint64_t> getChunkDims() const noexcept;
     int getCompressionLevel() const noexcept;
+    const CompressionSpec& getCompressionSpec() const & noexcept;
     DataType getDataType() const noexcept;
     uint8_t getElementSize() const noexcept;
     uint32_t getId() const noexcept;
@@ -69,6 +72,13 @@ public:
         std::tie(min, max) = self->getMinMax();
         return std::pair<float, float>(min, max);
     }
+
+    std::pair<uint64_t, uint64_t> getChunkDims() const noexcept
+    {
+        uint64_t rows=0, columns=0;
+        std::tie(rows, columns) = self->getChunkDims();
+        return std::pair<uint64_t, uint64_t>(rows, columns);
+    }
 }
 
 }  // namespace BAG
@@ -65,8 +65,27 @@ public:
         return $self->data()[pos];
     }
 
+    /**
+     * The address of the items, for the NumPy array interface.
+     */
+    uintptr_t _address() const {
+        return reinterpret_cast<uintptr_t>($self->data());
+    }
+
     %pythoncode %{
 
+    @property
+    def __array_interface__(self):
+        """
+          Expose the items to NumPy, read only, without copying them
+        """
+        return {
+            'shape': (self.size(),),
+            'typestr': '|u1',
+            'data': (self._address(), True),
+            'version': 3,
+        }
+
     def __iter__(self):
         """
           Implement iterator using yield
@@ -0,0 +1,46 @@
+%begin %{
+#ifdef _MSC_VER
+#ifdef SWIGPYTHON
+#define SWIG_PYTHON_INTERPRETER_NO_DEBUG
+#endif
+#endif
+%}
+
+%module bag_memorybudget
+
+%{
+#include "bag_memorybudget.h"
+%}
+
+%include <stdint.i>
+
+
+#define final
+
+namespace BAG
+{
+
+%nodefaultctor MemoryBudget;
+// "global" is a keyword in Python.
+%rename(getGlobal) MemoryBudget::global;
+
+class MemoryBudget final
+{
+public:
+    static MemoryBudget& global() noexcept;
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget(MemoryBudget&&) = delete;
+
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+    uint64_t getLimit() const noexcept;
+    void setLimit(uint64_t bytes);
+
+    uint64_t getUsage() const noexcept;
+    size_t getNumDatasets() const noexcept;
+};
+
+}  // namespace BAG
+
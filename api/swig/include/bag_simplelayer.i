@@ -16,10 +16,15 @@
 
 %import "bag_layer.i"
 %import "bag_types.i"
+%import "bag_uint8array.i"
+%import "bag_exceptions.i"
 
 %include <std_shared_ptr.i>
 %shared_ptr(BAG::SimpleLayer)
 
+BAG_ALLOW_THREADS(BAG::SimpleLayer::readDecimatedBuffer)
+BAG_ALLOW_THREADS(BAG::SimpleLayer::sample)
+
 namespace BAG {
     class SimpleLayer final : public Layer
     {
@@ -30,5 +35,31 @@ namespace BAG {
         SimpleLayer& operator=(SimpleLayer&&) = delete;
         bool operator==(const SimpleLayer &rhs) const noexcept;
         bool operator!=(const SimpleLayer &rhs) const noexcept;
+
+        std::vector<BagCell> findCells(float minValue, float maxValue) const;
+        std::vector<BagCell> findCells(float minValue, float maxValue,
+            uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+            uint32_t columnEnd) const;
+
+        std::vector<float> sample(const std::vector<double>& xs,
+            const std::vector<double>& ys,
+            SampleMethod method = SampleMethod::Bilinear) const;
     };
+
+    %extend SimpleLayer
+    {
+        %newobject readDecimatedBuffer;
+        UInt8Array* readDecimatedBuffer(
+            uint32_t rowStart,
+            uint32_t columnStart,
+            uint32_t rowEnd,
+            uint32_t columnEnd,
+            uint32_t rowStep,
+            uint32_t columnStep,
+            DecimationMethod method = DecimationMethod::Sample) const
+        {
+            return new BAG::UInt8Array{$self->readDecimated(rowStart,
+                columnStart, rowEnd, columnEnd, rowStep, columnStep, method)};
+        }
+    }
 }
\ No newline at end of file
@@ -19,11 +19,15 @@
 %import "bag_simplelayer.i"
 %import "bag_types.i"
 %import "bag_uint8array.i"
+%import "bag_exceptions.i"
 
 %include <stdint.i>
 %include <std_shared_ptr.i>
 %shared_ptr(BAG::SurfaceCorrections)
 
+BAG_ALLOW_THREADS(BAG::SurfaceCorrections::readCorrected)
+BAG_ALLOW_THREADS(BAG::SurfaceCorrections::readCorrectedRow)
+
 
 namespace BAG {
 
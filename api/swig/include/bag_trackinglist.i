@@ -68,6 +68,16 @@ namespace BAG
         %rename(at) operator[](size_t index) & noexcept;
         reference operator[](size_t index) & noexcept;
 
+        std::vector<value_type> getItemsAtNode(uint32_t row, uint32_t col) const;
+        std::vector<value_type> getItemsWithCode(uint8_t code) const;
+        std::vector<value_type> getItemsInSeries(uint16_t series) const;
+        std::vector<value_type> getItemsInWindow(uint32_t rowStart,
+            uint32_t colStart, uint32_t rowEnd, uint32_t colEnd) const;
+
+        void sortByNode(bool descending = false);
+        void sortByCode(bool descending = false);
+        void sortBySeries(bool descending = false);
+
         void write() const;
     };
 }
@@ -24,6 +24,9 @@ namespace std
     %template(LayerTypeVector) vector<BAG::LayerType>;
     %template(LayerTypeMap) unordered_map<BAG::LayerType, std::string>;
     %template(RecordDefinition) vector<FieldDefinition>;
+    %template(LayerIoStatsVector) vector<BAG::LayerIoStats>;
+    %template(LayerCellVector) vector<BagCell>;
+    %template(DoubleVector) vector<double>;
 }
 
 %inline
@@ -48,5 +48,44 @@ public:
     size_t size() const noexcept;
 };
 
+#ifdef SWIGPYTHON
+%extend UInt8Array {
+    /**
+     * The address of the buffer, for the NumPy array interface.
+     */
+    uintptr_t _address() const {
+        return reinterpret_cast<uintptr_t>($self->data());
+    }
+
+    %pythoncode %{
+
+    @property
+    def __array_interface__(self):
+        """
+          Expose the buffer to NumPy without copying it
+        """
+        return {
+            'shape': (self.size(),),
+            'typestr': '|u1',
+            'data': (self._address(), False),
+            'version': 3,
+        }
+
+    def asarray(self, dtype=None, shape=None):
+        """
+          A NumPy view of the buffer; the view keeps this array alive
+        """
+        import numpy
+
+        array = numpy.asarray(self)
+        if dtype is not None:
+            array = array.view(dtype)
+        if shape is not None:
+            array = array.reshape(shape)
+        return array
+    %}
+};
+#endif
+
 }  // namespace BAG
 
@@ -14,13 +14,120 @@
 %}
 
 %include "bag_compounddatatype.i"
+%import "bag_exceptions.i"
 
 %include <std_string.i>
 %include <stdint.i>
 
+BAG_ALLOW_THREADS(BAG::ValueTable::getRecords)
+BAG_ALLOW_THREADS(BAG::ValueTable::addRecord)
+BAG_ALLOW_THREADS(BAG::ValueTable::addRecords)
+BAG_ALLOW_THREADS(BAG::ValueTable::setValue)
+BAG_ALLOW_THREADS(BAG::ValueTable::_exportColumn)
 
 namespace BAG {
 
+struct ExportedColumn final
+{
+    std::string name;
+    DataType type;
+};
+
+#ifdef SWIGPYTHON
+%extend ExportedColumn {
+    /**
+     * The addresses and sizes of the buffers, for the NumPy array interface.
+     */
+    uintptr_t _valuesAddress() const {
+        return reinterpret_cast<uintptr_t>($self->values.data());
+    }
+    size_t _valuesSize() const {
+        return $self->values.size();
+    }
+    uintptr_t _offsetsAddress() const {
+        return reinterpret_cast<uintptr_t>($self->offsets.data());
+    }
+    size_t _numOffsets() const {
+        return $self->offsets.size();
+    }
+    uintptr_t _charactersAddress() const {
+        return reinterpret_cast<uintptr_t>($self->characters.data());
+    }
+    size_t _charactersSize() const {
+        return $self->characters.size();
+    }
+
+    %pythoncode %{
+
+    class _Buffer(object):
+        """
+          A read only view of one buffer of a column, for numpy.asarray();
+          it keeps the column alive
+        """
+        def __init__(self, column, typestr, address, count):
+            self.column = column
+            self.__array_interface__ = {
+                'shape': (count,),
+                'typestr': typestr,
+                'data': (address, True),
+                'version': 3,
+            }
+
+    def values(self):
+        """
+          The values as a NumPy array, without copying them; None for strings
+        """
+        import numpy
+
+        typestrs = {DT_FLOAT32: '<f4', DT_UINT32: '<u4', DT_BOOLEAN: '|b1'}
+        if self.type not in typestrs:
+            return None
+
+        typestr = typestrs[self.type]
+        count = self._valuesSize() // numpy.dtype(typestr).itemsize
+        return numpy.asarray(self._Buffer(self, typestr,
+            self._valuesAddress(), count))
+
+    def offsets(self):
+        """
+          The offsets of the strings into characters(), without copying them;
+          None if not a string
+        """
+        import numpy
+
+        if self.type != DT_STRING:
+            return None
+
+        return numpy.asarray(self._Buffer(self, '<u8', self._offsetsAddress(),
+            self._numOffsets()))
+
+    def characters(self):
+        """
+          The characters of the strings as a NumPy byte array, without
+          copying them; None if not a string
+        """
+        import numpy
+
+        if self.type != DT_STRING:
+            return None
+
+        return numpy.asarray(self._Buffer(self, '|u1',
+            self._charactersAddress(), self._charactersSize()))
+
+    def strings(self):
+        """
+          The strings as a NumPy array of Python strings
+        """
+        import numpy
+
+        offsets = self.offsets()
+        characters = self.characters().tobytes()
+        return numpy.array([characters[offsets[i]:offsets[i + 1]].decode()
+            for i in range(len(offsets) - 1)], dtype=object)
+    %}
+};
+#endif
+
 class ValueTable final
 {
 public:
@@ -30,13 +137,19 @@ public:
     ValueTable& operator=(const ValueTable&) = delete;
     ValueTable& operator=(ValueTable&&) = delete;
 
-    const Records& getRecords() const & noexcept;
+    const Records& getRecords() const &;
+    size_t getNumRecords() const noexcept;
     const RecordDefinition& getDefinition() const & noexcept;
     const CompoundDataType& getValue(size_t recordIndex,
         const std::string& name) const &;
     const CompoundDataType& getValue(size_t recordIndex,
         size_t fieldIndex) const &;
 
+    float getFloat(size_t key, size_t fieldIndex) const;
+    uint32_t getUInt32(size_t key, size_t fieldIndex) const;
+    bool getBool(size_t key, size_t fieldIndex) const;
+    const char* getString(size_t key, size_t fieldIndex) const &;
+
     size_t getFieldIndex(const std::string& name) const;
     const char* getFieldName(size_t index) const &;
 
@@ -54,7 +167,64 @@ public:
 
 #ifdef SWIGPYTHON
 %extend ValueTable {
+    %newobject _exportColumn;
+    ExportedColumn* _exportColumn(size_t fieldIndex) const
+    {
+        return new BAG::ExportedColumn($self->exportColumn(fieldIndex));
+    }
+
     %pythoncode %{
+        def exportColumns(self):
+            """
+              The values of every field, as ExportedColumns by field name,
+              with one call per field.  NOTE!  Each includes the no data
+              value record at index 0.
+            """
+            columns = {}
+            for fieldIndex in range(len(self.getDefinition())):
+                column = self._exportColumn(fieldIndex)
+                columns[column.name] = column
+            return columns
+
+        def toStructuredArray(self):
+            """
+              The records/values as a NumPy structured array; one vectorized
+              copy per field.  Strings are Python objects.
+            """
+            import numpy
+
+            columns = self.exportColumns()
+            arrays = [column.values() if column.type != DT_STRING
+                else column.strings() for column in columns.values()]
+            array = numpy.empty(self.getNumRecords(),
+                dtype=[(name, values.dtype) for name, values in
+                    zip(columns.keys(), arrays)])
+            for name, values in zip(columns.keys(), arrays):
+                array[name] = values
+            return array
+
+        def toArrow(self):
+            """
+              The records/values as a pyarrow Table.  The buffers of the
+              numeric and string fields are shared, not copied; Arrow packs
+              booleans into bits, so they are converted.
+            """
+            import pyarrow
+
+            names = []
+            arrays = []
+            for name, column in self.exportColumns().items():
+                if column.type == DT_STRING:
+                    array = pyarrow.Array.from_buffers(pyarrow.large_string(),
+                        len(column.offsets()) - 1, [None,
+                        pyarrow.py_buffer(column.offsets()),
+                        pyarrow.py_buffer(column.characters())])
+                else:
+                    array = pyarrow.array(column.values())
+                names.append(name)
+                arrays.append(array)
+            return pyarrow.Table.from_arrays(arrays, names=names)
+
         def addRecord(self, record):
             """
               Override addRecord to get around SWIG mis-handling (which may be due to
@@ -81,6 +81,19 @@ public:
     //%rename(__getitem__) operator[](size_t index) const & noexcept;
     //const_reference operator[](size_t index) const & noexcept;
 
+    std::vector<value_type> getItemsAtNode(uint32_t row, uint32_t col) const;
+    std::vector<value_type> getItemsAtSubNode(uint32_t subRow,
+        uint32_t subCol) const;
+    std::vector<value_type> getItemsWithCode(uint8_t code) const;
+    std::vector<value_type> getItemsInSeries(uint16_t series) const;
+    std::vector<value_type> getItemsInWindow(uint32_t rowStart,
+        uint32_t colStart, uint32_t rowEnd, uint32_t colEnd) const;
+
+    void sortByNode(bool descending = false);
+    void sortBySubNode(bool descending = false);
+    void sortByCode(bool descending = false);
+    void sortBySeries(bool descending = false);
+
     void write() const;
 };
 
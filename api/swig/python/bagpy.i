@@ -68,7 +68,9 @@ namespace std
 %include "../include/bag_vrtrackinglist.i"
 %include "../include/bag_descriptor.i"
 
+%include "../include/bag_datasetsnapshot.i"
 %include "../include/bag_dataset.i"
+%include "../include/bag_memorybudget.i"
 %include "../include/bag_metadata.i"
 %include "../include/bag_metadataprofiles.i"
 
@@ -0,0 +1,43 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_types.h>
+
+#include <benchmark/benchmark.h>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! Open and close a BAG.
+/*!
+    Args: the rows and columns in the grid, the number of georeferenced
+    metadata records and whether the layers are opened lazily.
+*/
+void BM_DatasetOpen(benchmark::State& state)
+{
+    BagSpec spec;
+    spec.rows = spec.columns = static_cast<uint32_t>(state.range(0));
+    spec.numGeorefRecords = static_cast<uint32_t>(state.range(1));
+
+    BAG::OpenOptions options;
+    options.lazy = state.range(2) != 0;
+
+    const auto& fileName = BenchUtils::getBag(spec);
+
+    for (auto _ : state)
+    {
+        auto pDataset = Dataset::open(fileName, BAG_OPEN_READONLY, options);
+        benchmark::DoNotOptimize(pDataset);
+        pDataset->close();
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_DatasetOpen)
+    ->ArgNames({"grid", "records", "lazy"})
+    ->ArgsProduct({{256, 2048}, {0, 10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,140 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_layer.h>
+#include <bag_metadata.h>
+#include <bag_types.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! The rows and columns in the grid read by the layer benchmarks.
+constexpr uint32_t kGridSize = 2048;
+
+//! Read the whole elevation layer at once.
+/*!
+    Args: the chunk size and the compression level.
+*/
+void BM_ReadFullLayer(benchmark::State& state)
+{
+    BagSpec spec;
+    spec.rows = spec.columns = kGridSize;
+    spec.chunkSize = static_cast<uint64_t>(state.range(0));
+    spec.compressionLevel = static_cast<int>(state.range(1));
+
+    const auto pDataset = Dataset::open(BenchUtils::getBag(spec),
+        BAG_OPEN_READONLY);
+    const auto& layer = pDataset->getLayer(Elevation);
+
+    for (auto _ : state)
+    {
+        auto buffer = layer.read(0, 0, kGridSize - 1, kGridSize - 1);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(kGridSize) * kGridSize, sizeof(float));
+}
+
+//! Read square windows of the elevation layer, marching across the grid.
+/*!
+    Args: the chunk size, the compression level and the window size.
+*/
+void BM_ReadWindow(benchmark::State& state)
+{
+    BagSpec spec;
+    spec.rows = spec.columns = kGridSize;
+    spec.chunkSize = static_cast<uint64_t>(state.range(0));
+    spec.compressionLevel = static_cast<int>(state.range(1));
+    const auto windowSize = static_cast<uint32_t>(state.range(2));
+
+    const auto pDataset = Dataset::open(BenchUtils::getBag(spec),
+        BAG_OPEN_READONLY);
+    const auto& layer = pDataset->getLayer(Elevation);
+
+    // Windows are not aligned with the chunks, as with a viewer panning.
+    constexpr uint32_t kStep = 97;
+    uint32_t row = 0, column = 0;
+
+    for (auto _ : state)
+    {
+        auto buffer = layer.read(row, column, row + windowSize - 1,
+            column + windowSize - 1);
+        benchmark::DoNotOptimize(buffer.data());
+
+        column = (column + kStep) % (kGridSize - windowSize);
+        if (column < kStep)
+            row = (row + kStep) % (kGridSize - windowSize);
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(windowSize) * windowSize, sizeof(float));
+}
+
+//! Write the elevation layer of a new BAG in strips of whole rows.
+/*!
+    Args: the chunk size, the compression level and the rows in a strip.
+*/
+void BM_WriteStrips(benchmark::State& state)
+{
+    const auto chunkSize = static_cast<uint64_t>(state.range(0));
+    const auto compressionLevel = static_cast<int>(state.range(1));
+    const auto stripRows = static_cast<uint32_t>(state.range(2));
+
+    std::vector<float> strip(static_cast<size_t>(stripRows) * kGridSize);
+    for (size_t i=0; i<strip.size(); ++i)
+        strip[i] = -20.f - .001f * static_cast<float>(i % 10007);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const BenchUtils::TempFile fileName;
+        {
+            BAG::Metadata metadata;
+            metadata.loadFromBuffer(BenchUtils::makeMetadataXML(kGridSize,
+                kGridSize));
+
+            auto pDataset = Dataset::create(fileName, std::move(metadata),
+                chunkSize, compressionLevel);
+            auto& layer = pDataset->getLayer(Elevation);
+            state.ResumeTiming();
+
+            for (uint32_t row=0; row<kGridSize; row+=stripRows)
+                layer.write(row, 0, std::min(row + stripRows, kGridSize) - 1,
+                    kGridSize - 1,
+                    reinterpret_cast<const uint8_t*>(strip.data()));
+
+            pDataset->close();
+            state.PauseTiming();
+        }
+        state.ResumeTiming();
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(kGridSize) * kGridSize, sizeof(float));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ReadFullLayer)
+    ->ArgNames({"chunk", "level"})
+    ->ArgsProduct({{64, 256, 1024}, {0, 1, 6}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReadWindow)
+    ->ArgNames({"chunk", "level", "window"})
+    ->ArgsProduct({{64, 256, 1024}, {0, 6}, {32, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_WriteStrips)
+    ->ArgNames({"chunk", "level", "rows"})
+    ->ArgsProduct({{64, 256}, {0, 1, 6}, {1, 64}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,160 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_simplelayer.h>
+#include <bag_surfacecorrections.h>
+#include <bag_types.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! The rows and columns in the grid read by the surface correction benchmarks.
+constexpr uint32_t kGridSize = 1024;
+
+//! The BAG with surface corrections read by the benchmarks.
+BagSpec correctedSpec()
+{
+    BagSpec spec;
+    spec.rows = spec.columns = kGridSize;
+    spec.surfaceCorrections = true;
+    return spec;
+}
+
+//! Read corrected elevations a window at a time.
+/*!
+    Args: the window size, and whether a correction plan made up front is
+    reused by every read.
+*/
+void BM_SurfaceCorrectionsReadCorrected(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(correctedSpec()), BAG_OPEN_READONLY);
+    const auto pCorrections = pDataset->getSurfaceCorrections();
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+
+    const auto windowSize = static_cast<uint32_t>(state.range(0));
+    const bool usePlan = state.range(1) != 0;
+
+    const auto plan = pCorrections->createCorrectionPlan();
+
+    for (auto _ : state)
+    {
+        auto buffer = usePlan ?
+            pCorrections->readCorrected(0, 0, windowSize - 1, windowSize - 1,
+                1, *pElevation, plan) :
+            pCorrections->readCorrected(0, 0, windowSize - 1, windowSize - 1,
+                1, *pElevation);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(windowSize) * windowSize, sizeof(float));
+}
+
+//! Read corrected elevations a row at a time, as a scanline renderer would.
+void BM_SurfaceCorrectionsReadCorrectedRow(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(correctedSpec()), BAG_OPEN_READONLY);
+    const auto pCorrections = pDataset->getSurfaceCorrections();
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+
+    const auto plan = pCorrections->createCorrectionPlan();
+    uint32_t row = 0;
+
+    for (auto _ : state)
+    {
+        auto buffer = pCorrections->readCorrectedRow(row, 0, kGridSize - 1, 1,
+            *pElevation, plan);
+        benchmark::DoNotOptimize(buffer.data());
+
+        row = (row + 1) % kGridSize;
+    }
+
+    BenchUtils::setThroughput(state, kGridSize, sizeof(float));
+}
+
+//! Read the corrected elevation of random cells, one at a time, as a point
+//! query would.
+/*!
+    Args: whether a correction plan made up front is reused by every read.
+*/
+void BM_SurfaceCorrectionsReadCorrectedCell(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(correctedSpec()), BAG_OPEN_READONLY);
+    const auto pCorrections = pDataset->getSurfaceCorrections();
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+
+    const bool usePlan = state.range(0) != 0;
+
+    const auto plan = pCorrections->createCorrectionPlan();
+
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<uint32_t> cell{0, kGridSize - 1};
+
+    for (auto _ : state)
+    {
+        const auto row = cell(generator);
+        const auto column = cell(generator);
+
+        auto buffer = usePlan ?
+            pCorrections->readCorrected(row, column, row, column, 1,
+                *pElevation, plan) :
+            pCorrections->readCorrected(row, column, row, column, 1,
+                *pElevation);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    BenchUtils::setThroughput(state, 1, sizeof(float));
+}
+
+//! Read the corrected elevations of the whole grid into a buffer reused by
+//! every iteration, so only the reading and correcting are measured.
+void BM_SurfaceCorrectionsReadCorrectedGrid(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(correctedSpec()), BAG_OPEN_READONLY);
+    const auto pCorrections = pDataset->getSurfaceCorrections();
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+
+    const auto plan = pCorrections->createCorrectionPlan();
+    std::vector<float> buffer(static_cast<size_t>(kGridSize) * kGridSize);
+
+    for (auto _ : state)
+    {
+        pCorrections->readCorrectedInto(0, 0, kGridSize - 1, kGridSize - 1, 1,
+            *pElevation, plan, buffer.data());
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(kGridSize) * kGridSize, sizeof(float));
+}
+
+}  // namespace
+
+BENCHMARK(BM_SurfaceCorrectionsReadCorrected)
+    ->ArgNames({"window", "plan"})
+    ->ArgsProduct({{64, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SurfaceCorrectionsReadCorrectedRow)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_SurfaceCorrectionsReadCorrectedCell)
+    ->ArgName("plan")
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_SurfaceCorrectionsReadCorrectedGrid)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,118 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_trackinglist.h>
+#include <bag_types.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! The rows and columns in the grid the tracking list items are spread over.
+constexpr uint32_t kGridSize = 1024;
+
+//! The BAG with a tracking list of numItems items.
+BagSpec trackingSpec(uint32_t numItems)
+{
+    BagSpec spec;
+    spec.rows = spec.columns = kGridSize;
+    spec.numTrackingItems = numItems;
+    return spec;
+}
+
+//! Find the items of random nodes.
+/*!
+    The first lookup builds the index of the list, so this mostly measures
+    the lookups themselves.
+    Args: the number of items in the list.
+*/
+void BM_TrackingListItemsAtNode(benchmark::State& state)
+{
+    const auto numItems = static_cast<uint32_t>(state.range(0));
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(trackingSpec(numItems)), BAG_OPEN_READONLY);
+    const auto& trackingList = pDataset->getTrackingList();
+
+    std::mt19937 generator{7};
+    std::uniform_int_distribution<uint32_t> node{0, kGridSize - 1};
+
+    for (auto _ : state)
+    {
+        auto items = trackingList.getItemsAtNode(node(generator),
+            node(generator));
+        benchmark::DoNotOptimize(items.data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+//! Find the items in windows of the grid.
+/*!
+    Args: the number of items in the list and the window size.
+*/
+void BM_TrackingListItemsInWindow(benchmark::State& state)
+{
+    const auto numItems = static_cast<uint32_t>(state.range(0));
+    const auto windowSize = static_cast<uint32_t>(state.range(1));
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(trackingSpec(numItems)), BAG_OPEN_READONLY);
+    const auto& trackingList = pDataset->getTrackingList();
+
+    std::mt19937 generator{7};
+    std::uniform_int_distribution<uint32_t> corner{0, kGridSize - windowSize};
+
+    for (auto _ : state)
+    {
+        const auto row = corner(generator);
+        const auto column = corner(generator);
+        auto items = trackingList.getItemsInWindow(row, column,
+            row + windowSize - 1, column + windowSize - 1);
+        benchmark::DoNotOptimize(items.data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+//! Sort the list by node, then by series.
+/*!
+    Args: the number of items in the list.
+*/
+void BM_TrackingListSort(benchmark::State& state)
+{
+    const auto numItems = static_cast<uint32_t>(state.range(0));
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(trackingSpec(numItems)), BAG_OPEN_READONLY);
+    auto& trackingList = pDataset->getTrackingList();
+
+    for (auto _ : state)
+    {
+        trackingList.sortByNode();
+        trackingList.sortBySeries();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(numItems) * 2 *
+        static_cast<int64_t>(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_TrackingListItemsAtNode)
+    ->ArgName("items")
+    ->Arg(1000)->Arg(1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_TrackingListItemsInWindow)
+    ->ArgNames({"items", "window"})
+    ->ArgsProduct({{1000, 1000000}, {16, 256}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_TrackingListSort)
+    ->ArgName("items")
+    ->Arg(1000)->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
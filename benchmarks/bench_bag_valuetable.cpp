@@ -0,0 +1,111 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_georefmetadatalayer.h>
+#include <bag_types.h>
+#include <bag_valuetable.h>
+
+#include <benchmark/benchmark.h>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! The BAG with a georeferenced metadata layer of numRecords records.
+BagSpec georefSpec(uint32_t numRecords)
+{
+    BagSpec spec;
+    spec.rows = spec.columns = 256;
+    spec.numGeorefRecords = numRecords;
+    return spec;
+}
+
+//! Load the value table of a georeferenced metadata layer.
+/*!
+    The BAG is opened lazily, so only the layer and its value table are read.
+    Args: the number of records.
+*/
+void BM_ValueTableLoad(benchmark::State& state)
+{
+    const auto numRecords = static_cast<uint32_t>(state.range(0));
+    const auto& fileName = BenchUtils::getBag(georefSpec(numRecords));
+
+    BAG::OpenOptions options;
+    options.lazy = true;
+
+    for (auto _ : state)
+    {
+        auto pDataset = Dataset::open(fileName, BAG_OPEN_READONLY, options);
+        const auto pLayer = pDataset->getGeorefMetadataLayer(
+            BenchUtils::kGeorefMetadataLayerName);
+        benchmark::DoNotOptimize(pLayer->getValueTable().getNumRecords());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(numRecords) *
+        static_cast<int64_t>(state.iterations()));
+}
+
+//! Decode every record of a loaded value table.
+/*!
+    Args: the number of records.
+*/
+void BM_ValueTableGetRecords(benchmark::State& state)
+{
+    const auto numRecords = static_cast<uint32_t>(state.range(0));
+    const auto& fileName = BenchUtils::getBag(georefSpec(numRecords));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto pDataset = Dataset::open(fileName, BAG_OPEN_READONLY);
+        const auto pLayer = pDataset->getGeorefMetadataLayer(
+            BenchUtils::kGeorefMetadataLayerName);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(pLayer->getValueTable().getRecords().data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(numRecords) *
+        static_cast<int64_t>(state.iterations()));
+}
+
+//! Export every field of a loaded value table to columns.
+/*!
+    Args: the number of records.
+*/
+void BM_ValueTableExportColumns(benchmark::State& state)
+{
+    const auto numRecords = static_cast<uint32_t>(state.range(0));
+    const auto pDataset = Dataset::open(
+        BenchUtils::getBag(georefSpec(numRecords)), BAG_OPEN_READONLY);
+    const auto& valueTable = pDataset->getGeorefMetadataLayer(
+        BenchUtils::kGeorefMetadataLayerName)->getValueTable();
+
+    for (auto _ : state)
+    {
+        auto columns = valueTable.exportColumns();
+        benchmark::DoNotOptimize(columns.data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(numRecords) *
+        static_cast<int64_t>(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ValueTableLoad)
+    ->ArgName("records")
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ValueTableGetRecords)
+    ->ArgName("records")
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ValueTableExportColumns)
+    ->ArgName("records")
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,134 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_types.h>
+#include <bag_vrindex.h>
+#include <bag_vrresampler.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+
+using BAG::Dataset;
+using BenchUtils::BagSpec;
+
+namespace {
+
+//! The rows and columns in the variable resolution grid.
+constexpr uint32_t kGridSize = 256;
+
+//! The variable resolution BAG read by the benchmarks.
+BagSpec vrSpec()
+{
+    BagSpec spec;
+    spec.rows = spec.columns = kGridSize;
+    spec.variableResolution = true;
+    return spec;
+}
+
+//! Open a variable resolution BAG and create its index, which loads the whole
+//! VRMetadata layer.  The dataset caches the layer, so it is reopened each
+//! iteration.
+void BM_VRIndexCreate(benchmark::State& state)
+{
+    const auto& fileName = BenchUtils::getBag(vrSpec());
+
+    for (auto _ : state)
+    {
+        const auto pDataset = Dataset::open(fileName, BAG_OPEN_READONLY);
+        const BAG::VRIndex index{*pDataset};
+        benchmark::DoNotOptimize(&index);
+    }
+
+    BenchUtils::setThroughput(state,
+        static_cast<uint64_t>(kGridSize) * kGridSize,
+        sizeof(BAG::VRMetadataItem));
+}
+
+//! Look up the refinement under random points.
+/*!
+    Args: the number of points looked up at once.
+*/
+void BM_VRIndexQuery(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(BenchUtils::getBag(vrSpec()),
+        BAG_OPEN_READONLY);
+    const BAG::VRIndex index{*pDataset};
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<double> x{originX,
+        originX + spacingX * (kGridSize - 1)};
+    std::uniform_real_distribution<double> y{originY,
+        originY + spacingY * (kGridSize - 1)};
+
+    std::vector<BAG::VRPoint> points(static_cast<size_t>(state.range(0)));
+    for (auto& point : points)
+        point = {x(generator), y(generator)};
+
+    for (auto _ : state)
+    {
+        auto results = index.queryPoints(points);
+        benchmark::DoNotOptimize(results.data());
+    }
+
+    BenchUtils::setThroughput(state, points.size(),
+        sizeof(BAG::VRRefinementsItem));
+}
+
+//! Flatten every refinement onto a uniform grid at the refinement spacing.
+/*!
+    The resampler walks the whole VRMetadata layer, and reads the refinements
+    under each band of rows from the VRRefinements layer.
+
+    Args: the VRResampleMethod.
+*/
+void BM_VRResamplerFlatten(benchmark::State& state)
+{
+    const auto pDataset = Dataset::open(BenchUtils::getBag(vrSpec()),
+        BAG_OPEN_READONLY);
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    // Each supergrid cell is refined 2x2.
+    const BAG::VRResampler resampler{*pDataset, spacingX / 2., spacingY / 2.};
+    const auto method = static_cast<BAG::VRResampleMethod>(state.range(0));
+
+    std::vector<float> buffer(static_cast<size_t>(resampler.getNumRows()) *
+        resampler.getNumColumns());
+
+    for (auto _ : state)
+    {
+        resampler.resampleInto(method, buffer.data());
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+
+    BenchUtils::setThroughput(state, buffer.size(),
+        sizeof(BAG::VRRefinementsItem));
+}
+
+}  // namespace
+
+BENCHMARK(BM_VRIndexCreate)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_VRIndexQuery)
+    ->ArgName("points")
+    ->Arg(1)->Arg(1024)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_VRResamplerFlatten)
+    ->ArgName("method")
+    ->Arg(BAG_VR_RESAMPLE_NEAREST)
+    ->Arg(BAG_VR_RESAMPLE_BILINEAR)
+    ->Arg(BAG_VR_RESAMPLE_MIN_DEPTH)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Record and check baselines of the BAG benchmarks.
+
+A baseline is the JSON output of bag_benchmarks, kept in
+benchmarks/baselines/<name>.json.  Record one on a quiet machine from a
+Release build:
+
+    bench_baseline.py record build/benchmarks/bag_benchmarks
+
+then check a later build against it:
+
+    bench_baseline.py compare build/benchmarks/bag_benchmarks
+
+compare prints the change in the median time of each benchmark, and exits
+with 1 if any is slower than the baseline by more than the threshold.
+Compare only against a baseline recorded on the same machine.
+"""
+
+import argparse
+import json
+import os
+import pathlib
+import subprocess
+import sys
+import tempfile
+
+
+BASELINE_DIR = pathlib.Path(__file__).parent.absolute() / "baselines"
+
+#: The benchmarks of the surface corrections and variable resolution paths.
+DEFAULT_FILTER = "SurfaceCorrections|VRIndex|VRResampler"
+DEFAULT_NAME = "vr_surfacecorrections"
+
+#: Nanoseconds per Google Benchmark time unit.
+TIME_UNITS = {"ns": 1., "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def run_benchmarks(executable, benchmark_filter, repetitions):
+    """Run the benchmarks, and return their JSON output."""
+    with tempfile.TemporaryDirectory() as directory:
+        out_file = os.path.join(directory, "results.json")
+        subprocess.run([
+            executable,
+            "--benchmark_filter=" + benchmark_filter,
+            "--benchmark_repetitions=" + str(repetitions),
+            "--benchmark_report_aggregates_only=true",
+            "--benchmark_out_format=json",
+            "--benchmark_out=" + out_file,
+        ], check=True)
+
+        with open(out_file) as f:
+            return json.load(f)
+
+
+def medians(results):
+    """The median run of each benchmark in the results."""
+    # Without repetitions there are no aggregates; use the only run.
+    return [benchmark for benchmark in results["benchmarks"]
+            if benchmark.get("run_type") != "aggregate" or
+            benchmark.get("aggregate_name") == "median"]
+
+
+def median_times(results):
+    """Map the name of each benchmark to its median real time in ns."""
+    times = {}
+    for benchmark in medians(results):
+        name = benchmark.get("run_name", benchmark["name"])
+        times[name] = benchmark["real_time"] * \
+            TIME_UNITS[benchmark.get("time_unit", "ns")]
+
+    return times
+
+
+def record(args):
+    results = run_benchmarks(args.executable, args.filter, args.repetitions)
+    results["benchmarks"] = medians(results)
+
+    BASELINE_DIR.mkdir(exist_ok=True)
+    baseline_file = BASELINE_DIR / (args.name + ".json")
+    with open(baseline_file, "w") as f:
+        json.dump(results, f, indent=2)
+        f.write("\n")
+
+    print("Recorded {} benchmarks in {}".format(
+        len(median_times(results)), baseline_file))
+    return 0
+
+
+def compare(args):
+    baseline_file = BASELINE_DIR / (args.name + ".json")
+    with open(baseline_file) as f:
+        baseline_results = json.load(f)
+    baseline = median_times(baseline_results)
+
+    context = baseline_results["context"]
+    print("Baseline recorded {} on {} CPU(s) at {} MHz.".format(
+        context.get("date"), context.get("num_cpus"),
+        context.get("mhz_per_cpu")))
+
+    if args.results:
+        with open(args.results) as f:
+            current = median_times(json.load(f))
+    else:
+        current = median_times(run_benchmarks(args.executable, args.filter,
+                                              args.repetitions))
+
+    regressions = []
+    width = max((len(name) for name in baseline.keys() | current.keys()),
+                default=0)
+
+    print("{:<{}}  {:>12}  {:>12}  {:>8}".format("Benchmark", width,
+          "Baseline ms", "Current ms", "Change"))
+
+    for name in sorted(baseline.keys() | current.keys()):
+        if name not in current:
+            print("{:<{}}  {:>12.3f}  {:>12}".format(name, width,
+                  baseline[name] / 1e6, "missing"))
+            continue
+
+        if name not in baseline:
+            print("{:<{}}  {:>12}  {:>12.3f}".format(name, width, "new",
+                  current[name] / 1e6))
+            continue
+
+        change = (current[name] - baseline[name]) / baseline[name]
+        flag = ""
+        if change > args.threshold:
+            regressions.append(name)
+            flag = "  REGRESSION"
+
+        print("{:<{}}  {:>12.3f}  {:>12.3f}  {:>+7.1%}{}".format(name, width,
+              baseline[name] / 1e6, current[name] / 1e6, change, flag))
+
+    if regressions:
+        print("\n{} benchmark(s) slower than the baseline by more than "
+              "{:.0%}.".format(len(regressions), args.threshold))
+        return 1
+
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", default=DEFAULT_NAME,
+                        help="the name of the baseline (default: %(default)s)")
+    parser.add_argument("--filter", default=DEFAULT_FILTER,
+                        help="the benchmarks run (default: %(default)s)")
+    parser.add_argument("--repetitions", type=int, default=5,
+                        help="the runs of each benchmark, of which the median "
+                             "is kept (default: %(default)s)")
+
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    record_parser = subparsers.add_parser(
+        "record", help="run the benchmarks and store them as the baseline")
+    record_parser.add_argument("executable", help="the bag_benchmarks program")
+    record_parser.set_defaults(func=record)
+
+    compare_parser = subparsers.add_parser(
+        "compare", help="run the benchmarks and compare them to the baseline")
+    compare_parser.add_argument("executable", nargs="?",
+                                help="the bag_benchmarks program")
+    compare_parser.add_argument("--results",
+                                help="compare this JSON output of "
+                                     "bag_benchmarks instead of running it")
+    compare_parser.add_argument("--threshold", type=float, default=0.15,
+                                help="the slowdown flagged, as a fraction "
+                                     "(default: %(default)s)")
+    compare_parser.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    if args.command == "compare" and not args.executable and not args.results:
+        parser.error("compare needs the bag_benchmarks program or --results")
+
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+#include <H5Cpp.h>
+
+/**
+ * BAG benchmark runner.
+ * The BAGs read by the benchmarks are generated into temporary files the
+ * first time they are needed, and removed when the runner exits.
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, char** argv)
+{
+    ::H5::Exception::dontPrint();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,669 @@
+#include "bench_utils.h"
+
+#include <bag_dataset.h>
+#include <bag_georefmetadatalayer.h>
+#include <bag_metadata.h>
+#include <bag_surfacecorrections.h>
+#include <bag_surfacecorrectionsdescriptor.h>
+#include <bag_trackinglist.h>
+#include <bag_types.h>
+#include <bag_valuetable.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrrefinements.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>  // std::remove
+#include <cstdlib>  // std::getenv
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>  // stat
+#include <tuple>
+#include <vector>
+
+
+namespace BenchUtils {
+
+namespace {
+
+//! The metadata of a BAG, with the dimensions and corners to fill in.
+const std::string kMetadataXML{R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>
+<gmi:MI_Metadata xmlns:gmi="http://www.isotc211.org/2005/gmi"
+    xmlns:bag="http://www.opennavsurf.org/schema/bag"
+    xmlns:gco="http://www.isotc211.org/2005/gco"
+    xmlns:gmd="http://www.isotc211.org/2005/gmd"
+    xmlns:gml="http://www.opengis.net/gml/3.2"
+    xmlns:xlink="http://www.w3.org/1999/xlink"
+    xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.opennavsurf.org/schema/bag http://www.opennavsurf.org/schema/bag/bag.xsd">
+    <gmd:fileIdentifier>
+        <gco:CharacterString>Unique Identifier</gco:CharacterString>
+    </gmd:fileIdentifier>
+    <gmd:language>
+        <gmd:LanguageCode codeList="http://www.loc.gov/standards/iso639-2/" codeListValue="eng">eng</gmd:LanguageCode>
+    </gmd:language>
+    <gmd:characterSet>
+        <gmd:MD_CharacterSetCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CharacterSetCode" codeListValue="utf8">utf8</gmd:MD_CharacterSetCode>
+    </gmd:characterSet>
+    <gmd:hierarchyLevel>
+        <gmd:MD_ScopeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ScopeCode" codeListValue="dataset">dataset</gmd:MD_ScopeCode>
+    </gmd:hierarchyLevel>
+    <gmd:contact>
+        <gmd:CI_ResponsibleParty>
+            <gmd:individualName>
+                <gco:CharacterString>Name of individual responsible for the BAG</gco:CharacterString>
+            </gmd:individualName>
+            <gmd:role>
+                <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="pointOfContact">pointOfContact</gmd:CI_RoleCode>
+            </gmd:role>
+        </gmd:CI_ResponsibleParty>
+    </gmd:contact>
+    <gmd:dateStamp>
+        <gco:Date>2012-01-27</gco:Date>
+    </gmd:dateStamp>
+    <gmd:metadataStandardName>
+        <gco:CharacterString>ISO 19115</gco:CharacterString>
+    </gmd:metadataStandardName>
+    <gmd:metadataStandardVersion>
+        <gco:CharacterString>2003/Cor.1:2006</gco:CharacterString>
+    </gmd:metadataStandardVersion>
+    <gmd:spatialRepresentationInfo>
+        <gmd:MD_Georectified>
+            <gmd:numberOfDimensions>
+                <gco:Integer>2</gco:Integer>
+            </gmd:numberOfDimensions>
+            <gmd:axisDimensionProperties>
+                <gmd:MD_Dimension>
+                    <gmd:dimensionName>
+                        <gmd:MD_DimensionNameTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_DimensionNameTypeCode" codeListValue="row">row</gmd:MD_DimensionNameTypeCode>
+                    </gmd:dimensionName>
+                    <gmd:dimensionSize>
+                        <gco:Integer>@ROWS@</gco:Integer>
+                    </gmd:dimensionSize>
+                    <gmd:resolution>
+                        <gco:Measure uom="Metres">10</gco:Measure>
+                    </gmd:resolution>
+                </gmd:MD_Dimension>
+            </gmd:axisDimensionProperties>
+            <gmd:axisDimensionProperties>
+                <gmd:MD_Dimension>
+                    <gmd:dimensionName>
+                        <gmd:MD_DimensionNameTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_DimensionNameTypeCode" codeListValue="column">column</gmd:MD_DimensionNameTypeCode>
+                    </gmd:dimensionName>
+                    <gmd:dimensionSize>
+                        <gco:Integer>@COLUMNS@</gco:Integer>
+                    </gmd:dimensionSize>
+                    <gmd:resolution>
+                        <gco:Measure uom="Metres">10</gco:Measure>
+                    </gmd:resolution>
+                </gmd:MD_Dimension>
+            </gmd:axisDimensionProperties>
+            <gmd:cellGeometry>
+                <gmd:MD_CellGeometryCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CellGeometryCode" codeListValue="point">point</gmd:MD_CellGeometryCode>
+            </gmd:cellGeometry>
+            <gmd:transformationParameterAvailability>
+                <gco:Boolean>1</gco:Boolean>
+            </gmd:transformationParameterAvailability>
+            <gmd:checkPointAvailability>
+                <gco:Boolean>0</gco:Boolean>
+            </gmd:checkPointAvailability>
+            <gmd:cornerPoints>
+                <gml:Point gml:id="id1">
+                    <gml:coordinates cs="," decimal="." ts=" ">@CORNERS@</gml:coordinates>
+                </gml:Point>
+            </gmd:cornerPoints>
+            <gmd:pointInPixel>
+                <gmd:MD_PixelOrientationCode>center</gmd:MD_PixelOrientationCode>
+            </gmd:pointInPixel>
+        </gmd:MD_Georectified>
+    </gmd:spatialRepresentationInfo>
+    <gmd:referenceSystemInfo>
+        <gmd:MD_ReferenceSystem>
+            <gmd:referenceSystemIdentifier>
+                <gmd:RS_Identifier>
+                    <gmd:code>
+                        <gco:CharacterString>PROJCS["UTM-19N-Nad83",
+    GEOGCS["unnamed",
+        DATUM["North_American_Datum_1983",
+            SPHEROID["North_American_Datum_1983",6378137,298.2572201434276],
+            TOWGS84[0,0,0,0,0,0,0]],
+        PRIMEM["Greenwich",0],
+        UNIT["degree",0.0174532925199433],
+        EXTENSION["Scaler","0,0,0,0.02,0.02,0.001"],
+        EXTENSION["Source","CARIS"]],
+    PROJECTION["Transverse_Mercator"],
+    PARAMETER["latitude_of_origin",0],
+    PARAMETER["central_meridian",-69],
+    PARAMETER["scale_factor",0.9996],
+    PARAMETER["false_easting",500000],
+    PARAMETER["false_northing",0],
+    UNIT["metre",1]]</gco:CharacterString>
+                    </gmd:code>
+                    <gmd:codeSpace>
+                        <gco:CharacterString>WKT</gco:CharacterString>
+                    </gmd:codeSpace>
+                </gmd:RS_Identifier>
+            </gmd:referenceSystemIdentifier>
+        </gmd:MD_ReferenceSystem>
+    </gmd:referenceSystemInfo>
+    <gmd:referenceSystemInfo>
+        <gmd:MD_ReferenceSystem>
+            <gmd:referenceSystemIdentifier>
+                <gmd:RS_Identifier>
+                    <gmd:code>
+                        <gco:CharacterString>VERT_CS["Alicante height",
+    VERT_DATUM["Alicante",2000]]</gco:CharacterString>
+                    </gmd:code>
+                    <gmd:codeSpace>
+                        <gco:CharacterString>WKT</gco:CharacterString>
+                    </gmd:codeSpace>
+                </gmd:RS_Identifier>
+            </gmd:referenceSystemIdentifier>
+        </gmd:MD_ReferenceSystem>
+    </gmd:referenceSystemInfo>
+    <gmd:identificationInfo>
+        <bag:BAG_DataIdentification>
+            <gmd:citation>
+                <gmd:CI_Citation>
+                    <gmd:title>
+                        <gco:CharacterString>Name of dataset input</gco:CharacterString>
+                    </gmd:title>
+                    <gmd:date>
+                        <gmd:CI_Date>
+                            <gmd:date>
+                                <gco:Date>2008-10-21</gco:Date>
+                            </gmd:date>
+                            <gmd:dateType>
+                                <gmd:CI_DateTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_DateTypeCode" codeListValue="creation">creation</gmd:CI_DateTypeCode>
+                            </gmd:dateType>
+                        </gmd:CI_Date>
+                    </gmd:date>
+                    <gmd:citedResponsibleParty>
+                        <gmd:CI_ResponsibleParty>
+                            <gmd:individualName>
+                                <gco:CharacterString>Person responsible for input data</gco:CharacterString>
+                            </gmd:individualName>
+                            <gmd:role>
+                                <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="originator">originator</gmd:CI_RoleCode>
+                            </gmd:role>
+                        </gmd:CI_ResponsibleParty>
+                    </gmd:citedResponsibleParty>
+                </gmd:CI_Citation>
+            </gmd:citation>
+            <gmd:abstract>
+                <gco:CharacterString>Sample Metadata</gco:CharacterString>
+            </gmd:abstract>
+            <gmd:status>
+                <gmd:MD_ProgressCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ProgressCode" codeListValue="completed">completed</gmd:MD_ProgressCode>
+            </gmd:status>
+            <gmd:spatialRepresentationType>
+                <gmd:MD_SpatialRepresentationTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_SpatialRepresentationTypeCode" codeListValue="grid">grid</gmd:MD_SpatialRepresentationTypeCode>
+            </gmd:spatialRepresentationType>
+            <gmd:language>
+                <gmd:LanguageCode codeList="http://www.loc.gov/standards/iso639-2/" codeListValue="eng">eng</gmd:LanguageCode>
+            </gmd:language>
+            <gmd:characterSet>
+                <gmd:MD_CharacterSetCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CharacterSetCode" codeListValue="utf8">utf8</gmd:MD_CharacterSetCode>
+            </gmd:characterSet>
+            <gmd:topicCategory>
+                <gmd:MD_TopicCategoryCode>elevation</gmd:MD_TopicCategoryCode>
+            </gmd:topicCategory>
+            <gmd:extent>
+                <gmd:EX_Extent>
+                    <gmd:geographicElement>
+                        <gmd:EX_GeographicBoundingBox>
+                            <gmd:westBoundLongitude>
+                                <gco:Decimal>-66.371629</gco:Decimal>
+                            </gmd:westBoundLongitude>
+                            <gmd:eastBoundLongitude>
+                                <gco:Decimal>-66.316454</gco:Decimal>
+                            </gmd:eastBoundLongitude>
+                            <gmd:southBoundLatitude>
+                                <gco:Decimal>50.114053</gco:Decimal>
+                            </gmd:southBoundLatitude>
+                            <gmd:northBoundLatitude>
+                                <gco:Decimal>50.180077</gco:Decimal>
+                            </gmd:northBoundLatitude>
+                        </gmd:EX_GeographicBoundingBox>
+                    </gmd:geographicElement>
+                </gmd:EX_Extent>
+            </gmd:extent>
+            <bag:verticalUncertaintyType>
+                <bag:BAG_VertUncertCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_VertUncertCode" codeListValue="rawStdDev">rawStdDev</bag:BAG_VertUncertCode>
+            </bag:verticalUncertaintyType>
+            <bag:depthCorrectionType>
+                <bag:BAG_DepthCorrectCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_DepthCorrectCode" codeListValue="trueDepth">trueDepth</bag:BAG_DepthCorrectCode>
+            </bag:depthCorrectionType>
+            <bag:elevationSolutionGroupType>
+                <bag:BAG_OptGroupCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_OptGroupCode" codeListValue="cube">cube</bag:BAG_OptGroupCode>
+            </bag:elevationSolutionGroupType>
+            <bag:nodeGroupType>
+                <bag:BAG_OptGroupCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_OptGroupCode" codeListValue="product">product</bag:BAG_OptGroupCode>
+            </bag:nodeGroupType>
+        </bag:BAG_DataIdentification>
+    </gmd:identificationInfo>
+    <gmd:dataQualityInfo>
+        <gmd:DQ_DataQuality>
+            <gmd:scope>
+                <gmd:DQ_Scope>
+                    <gmd:level>
+                        <gmd:MD_ScopeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ScopeCode" codeListValue="dataset">dataset</gmd:MD_ScopeCode>
+                    </gmd:level>
+                </gmd:DQ_Scope>
+            </gmd:scope>
+            <gmd:lineage>
+                <gmd:LI_Lineage>
+                    <gmd:processStep>
+                        <bag:BAG_ProcessStep>
+                            <gmd:description>
+                                <gco:CharacterString>List to be determined by WG. I.e. Product Creation</gco:CharacterString>
+                            </gmd:description>
+                            <gmd:dateTime>
+                                <gco:DateTime>2008-10-21T12:21:53</gco:DateTime>
+                            </gmd:dateTime>
+                            <gmd:processor>
+                                <gmd:CI_ResponsibleParty>
+                                    <gmd:individualName>
+                                        <gco:CharacterString>Name of the processor</gco:CharacterString>
+                                    </gmd:individualName>
+                                    <gmd:role>
+                                        <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="processor">processor</gmd:CI_RoleCode>
+                                    </gmd:role>
+                                </gmd:CI_ResponsibleParty>
+                            </gmd:processor>
+                            <gmd:source>
+                                <gmd:LI_Source>
+                                    <gmd:description>
+                                        <gco:CharacterString>Source</gco:CharacterString>
+                                    </gmd:description>
+                                    <gmd:sourceCitation>
+                                        <gmd:CI_Citation>
+                                            <gmd:title>
+                                                <gco:CharacterString>Name of dataset input</gco:CharacterString>
+                                            </gmd:title>
+                                            <gmd:date>
+                                                <gmd:CI_Date>
+                                                    <gmd:date gco:nilReason="unknown"/>
+                                                    <gmd:dateType>
+                                                        <gmd:CI_DateTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_DateTypeCode" codeListValue="creation">creation</gmd:CI_DateTypeCode>
+                                                    </gmd:dateType>
+                                                </gmd:CI_Date>
+                                            </gmd:date>
+                                        </gmd:CI_Citation>
+                                    </gmd:sourceCitation>
+                                </gmd:LI_Source>
+                            </gmd:source>
+                            <bag:trackingId>
+                                <gco:CharacterString>1</gco:CharacterString>
+                            </bag:trackingId>
+                        </bag:BAG_ProcessStep>
+                    </gmd:processStep>
+                </gmd:LI_Lineage>
+            </gmd:lineage>
+        </gmd:DQ_DataQuality>
+    </gmd:dataQualityInfo>
+    <gmd:metadataConstraints>
+        <gmd:MD_LegalConstraints>
+            <gmd:useConstraints>
+                <gmd:MD_RestrictionCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_RestrictionCode" codeListValue="otherRestrictions">otherRestrictions</gmd:MD_RestrictionCode>
+            </gmd:useConstraints>
+            <gmd:otherConstraints>
+                <gco:CharacterString>some other constraints</gco:CharacterString>
+            </gmd:otherConstraints>
+        </gmd:MD_LegalConstraints>
+    </gmd:metadataConstraints>
+    <gmd:metadataConstraints>
+        <gmd:MD_SecurityConstraints>
+            <gmd:classification>
+                <gmd:MD_ClassificationCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ClassificationCode" codeListValue="unclassified">unclassified</gmd:MD_ClassificationCode>
+            </gmd:classification>
+            <gmd:userNote>
+                <gco:CharacterString>some user node</gco:CharacterString>
+            </gmd:userNote>
+        </gmd:MD_SecurityConstraints>
+    </gmd:metadataConstraints>
+</gmi:MI_Metadata>
+)"};
+
+//! The lower left corner of a generated BAG.
+constexpr double kLowerLeftX = 687910.;
+constexpr double kLowerLeftY = 5554620.;
+//! The spacing of the nodes of a generated BAG.
+constexpr double kNodeSpacing = 10.;
+
+//! Replace the first occurrence of a placeholder in a string.
+void replace(
+    std::string& str,
+    const std::string& placeholder,
+    const std::string& value)
+{
+    const auto pos = str.find(placeholder);
+    if (pos != std::string::npos)
+        str.replace(pos, placeholder.size(), value);
+}
+
+//! Order BagSpecs, so they can key a map.
+struct BagSpecLess final
+{
+    bool operator()(const BagSpec& lhs, const BagSpec& rhs) const noexcept
+    {
+        return std::tie(lhs.rows, lhs.columns, lhs.chunkSize,
+                lhs.compressionLevel, lhs.variableResolution,
+                lhs.numGeorefRecords, lhs.surfaceCorrections,
+                lhs.numTrackingItems) <
+            std::tie(rhs.rows, rhs.columns, rhs.chunkSize,
+                rhs.compressionLevel, rhs.variableResolution,
+                rhs.numGeorefRecords, rhs.surfaceCorrections,
+                rhs.numTrackingItems);
+    }
+};
+
+//! Write a gently sloping, noisy surface to the elevation and uncertainty
+//! layers, a chunk high strip at a time.
+void writeSurface(
+    BAG::Dataset& dataset,
+    const BagSpec& spec,
+    std::mt19937& generator)
+{
+    std::normal_distribution<float> noise{0.f, .25f};
+
+    const auto stripRows = static_cast<uint32_t>(
+        std::min<uint64_t>(std::max<uint64_t>(spec.chunkSize, 1), spec.rows));
+    std::vector<float> elevations(static_cast<size_t>(stripRows) * spec.columns);
+    std::vector<float> uncertainties(elevations.size());
+
+    auto& elevation = dataset.getLayer(Elevation);
+    auto& uncertainty = dataset.getLayer(Uncertainty);
+
+    for (uint32_t rowStart=0; rowStart<spec.rows; rowStart+=stripRows)
+    {
+        const auto rowEnd = std::min(rowStart + stripRows, spec.rows) - 1;
+
+        size_t i = 0;
+        for (uint32_t row=rowStart; row<=rowEnd; ++row)
+            for (uint32_t column=0; column<spec.columns; ++column, ++i)
+            {
+                elevations[i] = -20.f - .01f * static_cast<float>(row + column) +
+                    noise(generator);
+                uncertainties[i] = .5f + .1f * std::abs(noise(generator));
+            }
+
+        elevation.write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+        uncertainty.write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(uncertainties.data()));
+    }
+}
+
+//! Refine every cell of the grid 2x2.
+void writeVariableResolution(
+    BAG::Dataset& dataset,
+    const BagSpec& spec,
+    std::mt19937& generator)
+{
+    dataset.createVR(spec.chunkSize, spec.compressionLevel, false);
+
+    std::uniform_real_distribution<float> depth{-40.f, -20.f};
+
+    const uint64_t numCells = static_cast<uint64_t>(spec.rows) * spec.columns;
+    {
+        auto pWriter = dataset.getVRRefinements()->appendWriter();
+
+        std::vector<BAG::VRRefinementsItem> refinements(4);
+        for (uint64_t cell=0; cell<numCells; ++cell)
+        {
+            for (auto& refinement : refinements)
+                refinement = {depth(generator), .5f};
+
+            pWriter->append(refinements.data(), refinements.size());
+        }
+
+        pWriter->close();
+    }
+
+    const auto spacing = static_cast<float>(kNodeSpacing / 2.);
+    std::vector<BAG::VRMetadataItem> items(spec.columns);
+    for (uint32_t row=0; row<spec.rows; ++row)
+    {
+        for (uint32_t column=0; column<spec.columns; ++column)
+            items[column] = {static_cast<uint32_t>(
+                (static_cast<uint64_t>(row) * spec.columns + column) * 4),
+                2, 2, spacing, spacing, spacing / 2.f, spacing / 2.f};
+
+        dataset.getVRMetadata()->write(row, 0, row, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(items.data()));
+    }
+}
+
+//! Add a georeferenced metadata layer, keying the nodes round robin.
+void writeGeorefMetadata(
+    BAG::Dataset& dataset,
+    const BagSpec& spec)
+{
+    BAG::RecordDefinition definition(3);
+    definition[0].name = "depth";
+    definition[0].type = DT_FLOAT32;
+    definition[1].name = "source";
+    definition[1].type = DT_UINT32;
+    definition[2].name = "survey";
+    definition[2].type = DT_STRING;
+
+    auto& layer = dataset.createGeorefMetadataLayer(DT_UINT32,
+        UNKNOWN_METADATA_PROFILE, kGeorefMetadataLayerName, definition,
+        spec.chunkSize, spec.compressionLevel);
+
+    BAG::Records records;
+    records.reserve(spec.numGeorefRecords);
+    for (uint32_t i=0; i<spec.numGeorefRecords; ++i)
+        records.push_back({BAG::CompoundDataType{static_cast<float>(i)},
+            BAG::CompoundDataType{i % 17},
+            BAG::CompoundDataType{"survey " + std::to_string(i)}});
+
+    layer.getValueTable().addRecords(std::move(records));
+
+    std::vector<uint32_t> keys(spec.columns);
+    for (uint32_t row=0; row<spec.rows; ++row)
+    {
+        for (uint32_t column=0; column<spec.columns; ++column)
+            keys[column] = static_cast<uint32_t>(
+                (static_cast<uint64_t>(row) * spec.columns + column) %
+                    spec.numGeorefRecords) + 1;
+
+        layer.write(row, 0, row, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(keys.data()));
+    }
+}
+
+//! Add gridded surface corrections, one corrector node per
+//! kCorrectorSpacing cells.
+void writeSurfaceCorrections(
+    BAG::Dataset& dataset,
+    const BagSpec& spec)
+{
+    auto& corrections = dataset.createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, kNumCorrectors, spec.chunkSize,
+        spec.compressionLevel);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = dataset.getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = dataset.getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * kCorrectorSpacing, spacingY * kCorrectorSpacing);
+
+    const auto rows = std::min(spec.rows / kCorrectorSpacing + 1, spec.rows);
+    const auto columns = std::min(spec.columns / kCorrectorSpacing + 1,
+        spec.columns);
+
+    std::vector<BagVerticalDatumCorrectionsGridded> grid(
+        static_cast<size_t>(rows) * columns, BagVerticalDatumCorrectionsGridded{});
+    for (size_t i=0; i<grid.size(); ++i)
+    {
+        grid[i].z[0] = .001f * static_cast<float>(i % 1000);
+        grid[i].z[1] = -1.f + .002f * static_cast<float>(i % 500);
+    }
+
+    corrections.write(0, 0, rows - 1, columns - 1,
+        reinterpret_cast<const uint8_t*>(grid.data()));
+}
+
+//! Fill the tracking list with edits of nodes spread over the grid.
+void writeTrackingList(
+    BAG::Dataset& dataset,
+    const BagSpec& spec,
+    std::mt19937& generator)
+{
+    std::uniform_int_distribution<uint32_t> row{0, spec.rows - 1};
+    std::uniform_int_distribution<uint32_t> column{0, spec.columns - 1};
+
+    auto& trackingList = dataset.getTrackingList();
+    trackingList.reserve(spec.numTrackingItems);
+
+    for (uint32_t i=0; i<spec.numTrackingItems; ++i)
+        trackingList.push_back(BAG::TrackingItem{row(generator),
+            column(generator), -25.f, .5f, static_cast<uint8_t>(i % 8),
+            static_cast<uint16_t>(i % 100)});
+
+    trackingList.write();
+}
+
+}  // namespace
+
+//! Constructor.
+/*!
+    Picks a random name in the temporary directory.
+*/
+TempFile::TempFile()
+{
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    std::ostringstream fnameStream;
+#ifdef _WIN32
+    fnameStream << std::getenv("TEMP") << "\\";
+#else
+    fnameStream << "/tmp/";
+#endif
+    fnameStream << "bagbenchfile-" << gen();
+    m_fileName = fnameStream.str();
+}
+
+//! Destructor.
+/*!
+    Removes the file if it exists.
+*/
+TempFile::~TempFile() noexcept
+{
+    struct stat buffer;
+
+    if (stat(m_fileName.c_str(), &buffer) == 0)
+        std::remove(m_fileName.c_str());
+}
+
+//! Make the metadata of a BAG.
+/*!
+\param rows
+    The number of rows in the grid.
+\param columns
+    The number of columns in the grid.
+
+\return
+    The XML metadata of a grid of rows by columns nodes, kNodeSpacing apart.
+*/
+std::string makeMetadataXML(
+    uint32_t rows,
+    uint32_t columns)
+{
+    std::string xml{kMetadataXML};
+
+    replace(xml, "@ROWS@", std::to_string(rows));
+    replace(xml, "@COLUMNS@", std::to_string(columns));
+
+    std::ostringstream corners;
+    corners.setf(std::ios::fixed);
+    corners << kLowerLeftX << ',' << kLowerLeftY << ' '
+        << kLowerLeftX + (columns - 1) * kNodeSpacing << ','
+        << kLowerLeftY + (rows - 1) * kNodeSpacing;
+    replace(xml, "@CORNERS@", corners.str());
+
+    return xml;
+}
+
+//! Retrieve a generated BAG.
+/*!
+    Each BAG is only generated once per process, with the same random seed,
+    into a temporary file that is removed when the process exits.
+
+\param spec
+    What the BAG contains.
+
+\return
+    The file name of the BAG.
+*/
+const std::string& getBag(
+    const BagSpec& spec)
+{
+    static std::map<BagSpec, std::unique_ptr<TempFile>, BagSpecLess> bags;
+
+    auto& pFile = bags[spec];
+    if (pFile)
+        return *pFile;
+
+    pFile = std::make_unique<TempFile>();
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(makeMetadataXML(spec.rows, spec.columns));
+
+    const auto pDataset = BAG::Dataset::create(*pFile, std::move(metadata),
+        spec.chunkSize, spec.compressionLevel);
+
+    std::mt19937 generator{20240601};
+
+    writeSurface(*pDataset, spec, generator);
+
+    if (spec.variableResolution)
+        writeVariableResolution(*pDataset, spec, generator);
+
+    if (spec.numGeorefRecords > 0)
+        writeGeorefMetadata(*pDataset, spec);
+
+    if (spec.surfaceCorrections)
+        writeSurfaceCorrections(*pDataset, spec);
+
+    if (spec.numTrackingItems > 0)
+        writeTrackingList(*pDataset, spec, generator);
+
+    pDataset->close();
+
+    return *pFile;
+}
+
+//! Report the throughput of a benchmark.
+/*!
+    Sets the bytes processed, reported as bytes/s, and a "cells" rate
+    counter, reported as cells/s.
+
+\param state
+    The state of the benchmark, after its timing loop.
+\param cellsPerIteration
+    The number of cells processed by each iteration.
+\param bytesPerCell
+    The number of bytes in a cell.
+*/
+void setThroughput(
+    benchmark::State& state,
+    uint64_t cellsPerIteration,
+    size_t bytesPerCell)
+{
+    const auto cells = static_cast<int64_t>(cellsPerIteration) *
+        static_cast<int64_t>(state.iterations());
+
+    state.SetBytesProcessed(cells * static_cast<int64_t>(bytesPerCell));
+    state.counters["cells"] = benchmark::Counter(static_cast<double>(cells),
+        benchmark::Counter::kIsRate);
+}
+
+}  // namespace BenchUtils
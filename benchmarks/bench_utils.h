@@ -0,0 +1,72 @@
+#ifndef BAG_BENCH_UTILS_H
+#define BAG_BENCH_UTILS_H
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace BenchUtils {
+
+//! A temporary file name; the file is removed when the instance leaves scope.
+struct TempFile final
+{
+    TempFile();
+    ~TempFile() noexcept;
+
+    TempFile(const TempFile&) = delete;
+    TempFile(TempFile&&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    TempFile& operator=(TempFile&&) = delete;
+
+    //! Implicit conversion to a const std::string&.
+    operator const std::string&() const & noexcept
+    {
+        return m_fileName;
+    }
+
+    std::string m_fileName;
+};
+
+//! What a generated BAG contains.
+struct BagSpec final
+{
+    //! The number of rows in the grid.
+    uint32_t rows = 1024;
+    //! The number of columns in the grid.
+    uint32_t columns = 1024;
+    //! The rows and columns in a chunk.
+    uint64_t chunkSize = 256;
+    //! The deflate compression level; 0 does not compress.
+    int compressionLevel = 6;
+    //! Add variable resolution layers, refining every cell 2x2?
+    bool variableResolution = false;
+    //! The number of records in a georeferenced metadata layer named
+    //! kGeorefMetadataLayerName; 0 does not add one.
+    uint32_t numGeorefRecords = 0;
+    //! Add gridded surface corrections with kNumCorrectors correctors?
+    bool surfaceCorrections = false;
+    //! The number of items in the tracking list.
+    uint32_t numTrackingItems = 0;
+};
+
+//! The name of the georeferenced metadata layer of a generated BAG; that of
+//! the simple layer it has metadata for.
+constexpr const char* kGeorefMetadataLayerName = "elevation";
+//! The number of correctors of the surface corrections of a generated BAG.
+constexpr uint8_t kNumCorrectors = 2;
+//! The cells along each side of a surface corrections grid cell.
+constexpr uint32_t kCorrectorSpacing = 16;
+
+std::string makeMetadataXML(uint32_t rows, uint32_t columns);
+
+const std::string& getBag(const BagSpec& spec);
+
+void setThroughput(benchmark::State& state, uint64_t cellsPerIteration,
+    size_t bytesPerCell);
+
+}  // namespace BenchUtils
+
+#endif  // BAG_BENCH_UTILS_H
@@ -0,0 +1,145 @@
+/*! \file bag_convert.cpp
+ * \brief Copy a BAG, rechunking, recompressing or clipping it on the way.
+ *
+ * Every layer is copied a band of nodes at a time, so BAGs far larger than
+ * memory can be converted.  The refinements of a variable resolution BAG
+ * are packed, optionally along a space filling curve so windows of the
+ * supergrid read few runs of them.
+ */
+
+#include "getopt.h"
+
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+enum Cmd {
+    INPUT_BAG = 1,
+    OUTPUT_BAG,
+    ARGC_EXPECTED
+};
+
+constexpr const char* kOptions = "c:z:w:g:o:h";
+
+}  // namespace
+
+
+int main(
+    int argc,
+    char* argv[])
+{
+    bool generateHelp = false;
+    bool badOption = false;
+    BAG::CopyOptions options;
+
+    int c = getopt(argc, argv, const_cast<char *>(kOptions));
+
+    while (c != EOF)
+    {
+        switch (c)
+        {
+        case 'c':
+        {
+            unsigned long long rows = 0, columns = 0;
+            const auto numRead = std::sscanf(optarg, "%llux%llu", &rows,
+                &columns);
+            if (numRead < 1)
+            {
+                badOption = true;
+                break;
+            }
+
+            options.rechunk = true;
+            options.chunkShape.rows = rows;
+            options.chunkShape.columns = numRead == 2 ? columns : rows;
+            break;
+        }
+        case 'z':
+            options.recompress = true;
+            options.compression = std::atoi(optarg);
+            break;
+        case 'w':
+            if (std::sscanf(optarg, "%u,%u,%u,%u", &options.rowStart,
+                &options.columnStart, &options.rowEnd,
+                &options.columnEnd) != 4)
+                badOption = true;
+            break;
+        case 'g':
+            options.useGeoWindow = true;
+            if (std::sscanf(optarg, "%lf,%lf,%lf,%lf", &options.minX,
+                &options.minY, &options.maxX, &options.maxY) != 4)
+                badOption = true;
+            break;
+        case 'o':
+            if (std::strcmp(optarg, "row") == 0)
+                options.refinementOrder = BAG::VRRefinementOrder::RowMajor;
+            else if (std::strcmp(optarg, "morton") == 0)
+                options.refinementOrder = BAG::VRRefinementOrder::Morton;
+            else if (std::strcmp(optarg, "hilbert") == 0)
+                options.refinementOrder = BAG::VRRefinementOrder::Hilbert;
+            else
+                badOption = true;
+            break;
+        case 'h':
+            generateHelp = true;
+            break;
+        case '?':  //[[fallthrough]]
+        default:
+            std::cerr << "error: unknown option flag '" << +optopt << "'\n";
+            badOption = true;
+            break;
+        }
+
+        c = getopt(argc, argv, const_cast<char *>(kOptions));
+    }
+
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != ARGC_EXPECTED || generateHelp || badOption)
+    {
+        std::cout << "bag_convert [" << __DATE__ << R"(] - Copy a BAG, rechunking, recompressing or clipping it.
+Syntax: bag_convert [opt] <input_file> <output_file>
+Options:
+ -c <rows>[x<columns>]  Rechunk the layers into chunks of this shape.
+ -z <level>  Recompress the layers with deflate at this level (0 to 9).
+ -w <row_start>,<column_start>,<row_end>,<column_end>  Copy a window of the grid (inclusive).
+ -g <min_x>,<min_y>,<max_x>,<max_y>  Copy the nodes inside a box, in the horizontal reference system of the BAG.
+ -o <row|morton|hilbert>  Pack the variable resolution refinements in this order of the supergrid cells.
+ -h Generate this help information.
+)";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const auto source = BAG::Dataset::open(argv[INPUT_BAG],
+            BAG_OPEN_READONLY);
+
+        const auto copy = BAG::copyDataset(*source, argv[OUTPUT_BAG], options);
+
+        uint32_t rows = 0;
+        uint32_t columns = 0;
+        std::tie(rows, columns) = copy->getDescriptor().getDims();
+
+        std::cout << "Copied " << argv[INPUT_BAG] << " to " << argv[OUTPUT_BAG]
+            << " (" << rows << ", " << columns << ") cells.\n";
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,558 @@
+/*! \file bag_generate.cpp
+ * \brief Generate a large synthetic BAG for benchmarking and load testing.
+ *
+ * The grid, its nulls, variable resolution refinements, georeferenced
+ * metadata, surface corrections and tracking list are all drawn from a seed,
+ * so the same options always produce the same layers.  Each band of nodes is
+ * drawn from its own generator, seeded by the seed, the layer and the band,
+ * so nothing depends on the order the bands are written in.
+ *
+ * Layers are written a band of whole chunk rows at a time, which lets
+ * SimpleLayer::write() compress the chunks of each band on several threads.
+ * Only one band is held in memory, so BAGs far larger than memory can be
+ * generated.
+ */
+
+#include "getopt.h"
+
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_georefmetadatalayer.h>
+#include <bag_metadata.h>
+#include <bag_metadata_export.h>
+#include <bag_simplelayer.h>
+#include <bag_surfacecorrections.h>
+#include <bag_surfacecorrectionsdescriptor.h>
+#include <bag_trackinglist.h>
+#include <bag_types.h>
+#include <bag_valuetable.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrrefinements.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace {
+
+enum Cmd {
+    TEMPLATE_XML = 1,
+    OUTPUT_BAG,
+    ARGC_EXPECTED
+};
+
+constexpr const char* kOptions = "s:S:c:z:n:v:g:k:t:h";
+
+//! The streams of random numbers, one per kind of data.
+enum Stream : uint32_t {
+    SURFACE_STREAM = 1,
+    VR_STREAM,
+    GEOREF_STREAM,
+    CORRECTIONS_STREAM,
+    TRACKING_STREAM,
+};
+
+//! The name of the georeferenced metadata layer; that of the simple layer it
+//! has metadata for.
+constexpr const char* kGeorefMetadataLayerName = "elevation";
+//! The nodes along each side of a surface corrections grid cell.
+constexpr uint32_t kCorrectorSpacing = 16;
+
+//! What to generate.
+struct GeneratorSpec final
+{
+    //! The seed of every random number.
+    uint32_t seed = 1;
+    //! The number of rows in the grid.
+    uint32_t rows = 10000;
+    //! The number of columns in the grid.
+    uint32_t columns = 10000;
+    //! The rows and columns in a chunk.
+    uint64_t chunkSize = 256;
+    //! The deflate compression level; 0 does not compress.
+    int compressionLevel = 6;
+    //! The fraction of the nodes that are null.
+    double nullFraction = 0.;
+    //! The fraction of the non null nodes that are refined; 0 does not add
+    //! variable resolution layers.
+    double vrDensity = 0.;
+    //! The most refinements along each side of a refined node.
+    uint32_t maxRefinementDims = 4;
+    //! The number of records of a georeferenced metadata layer; 0 does not
+    //! add one.
+    uint32_t numGeorefRecords = 0;
+    //! The number of surface correctors; 0 does not add surface corrections.
+    uint32_t numCorrectors = 0;
+    //! The number of items in the tracking list.
+    uint32_t numTrackingItems = 0;
+};
+
+//! The random number generator of a band of nodes.
+/*!
+\param spec
+    What to generate.
+\param stream
+    The kind of data the band is for.
+\param band
+    The index of the band.
+
+\return
+    A generator that only depends on the seed, stream and band.
+*/
+std::mt19937_64 makeGenerator(
+    const GeneratorSpec& spec,
+    Stream stream,
+    uint64_t band)
+{
+    std::seed_seq seq{spec.seed, static_cast<uint32_t>(stream),
+        static_cast<uint32_t>(band), static_cast<uint32_t>(band >> 32)};
+
+    return std::mt19937_64{seq};
+}
+
+//! The rows in a band; those of a row of chunks.
+uint32_t bandRows(
+    const GeneratorSpec& spec)
+{
+    return static_cast<uint32_t>(std::min<uint64_t>(
+        std::max<uint64_t>(spec.chunkSize, 1), spec.rows));
+}
+
+//! Load the template metadata, resized to the grid of the spec.
+/*!
+    The spacing, reference systems and everything else come from the
+    template; the lower left corner is kept and the upper right one moved.
+*/
+BAG::Metadata makeMetadata(
+    const std::string& templateFileName,
+    const GeneratorSpec& spec)
+{
+    BAG::Metadata templateMetadata;
+    templateMetadata.loadFromFile(templateFileName);
+
+    auto bagMetadata = templateMetadata.getStruct();
+    auto spatial = *bagMetadata.spatialRepresentationInfo;
+
+    spatial.numberOfRows = spec.rows;
+    spatial.numberOfColumns = spec.columns;
+    spatial.urCornerX = spatial.llCornerX +
+        (spec.columns - 1) * spatial.columnResolution;
+    spatial.urCornerY = spatial.llCornerY +
+        (spec.rows - 1) * spatial.rowResolution;
+    bagMetadata.spatialRepresentationInfo = &spatial;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(BAG::exportMetadataToXML(bagMetadata));
+
+    return metadata;
+}
+
+//! Is a node null?
+/*!
+    Nulls are drawn per node, so each band must ask in the same order.
+*/
+bool isNull(
+    const GeneratorSpec& spec,
+    std::mt19937_64& generator)
+{
+    return spec.nullFraction > 0. &&
+        std::uniform_real_distribution<double>{}(generator) < spec.nullFraction;
+}
+
+//! Write a rolling, noisy surface with nulls to the elevation and uncertainty
+//! layers.
+void writeSurface(
+    BAG::Dataset& dataset,
+    const GeneratorSpec& spec)
+{
+    const auto rows = bandRows(spec);
+    std::vector<float> elevations(static_cast<size_t>(rows) * spec.columns);
+    std::vector<float> uncertainties(elevations.size());
+
+    auto pElevation = dataset.getSimpleLayer(Elevation);
+    auto pUncertainty = dataset.getSimpleLayer(Uncertainty);
+
+    std::normal_distribution<float> noise{0.f, .25f};
+
+    for (uint32_t rowStart=0; rowStart<spec.rows; rowStart+=rows)
+    {
+        const auto rowEnd = std::min(rowStart + rows, spec.rows) - 1;
+        auto generator = makeGenerator(spec, SURFACE_STREAM, rowStart / rows);
+
+        size_t i = 0;
+        for (uint32_t row=rowStart; row<=rowEnd; ++row)
+            for (uint32_t column=0; column<spec.columns; ++column, ++i)
+            {
+                if (isNull(spec, generator))
+                {
+                    elevations[i] = BAG_NULL_ELEVATION;
+                    uncertainties[i] = BAG_NULL_UNCERTAINTY;
+                    continue;
+                }
+
+                elevations[i] = -50.f +
+                    10.f * std::sin(static_cast<float>(row) * .002f) +
+                    10.f * std::cos(static_cast<float>(column) * .003f) +
+                    noise(generator);
+                uncertainties[i] = .5f + .1f * std::abs(noise(generator));
+            }
+
+        pElevation->write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+        pUncertainty->write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(uncertainties.data()));
+    }
+}
+
+//! Refine a fraction of the nodes, each into 2 to maxRefinementDims
+//! refinements along each side.
+/*!
+\return
+    The number of refinements.
+*/
+uint64_t writeVariableResolution(
+    BAG::Dataset& dataset,
+    const GeneratorSpec& spec)
+{
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = dataset.getDescriptor().getGridSpacing();
+
+    auto pVRMetadata = dataset.getVRMetadata();
+    auto pWriter = dataset.getVRRefinements()->appendWriter();
+
+    std::uniform_int_distribution<uint32_t> dims{2,
+        std::max(spec.maxRefinementDims, 2u)};
+    std::uniform_real_distribution<float> depth{-60.f, -40.f};
+
+    const auto rows = bandRows(spec);
+    std::vector<BAG::VRMetadataItem> items(
+        static_cast<size_t>(rows) * spec.columns);
+    std::vector<BAG::VRRefinementsItem> refinements;
+    uint64_t numRefinements = 0;
+
+    for (uint32_t rowStart=0; rowStart<spec.rows; rowStart+=rows)
+    {
+        const auto rowEnd = std::min(rowStart + rows, spec.rows) - 1;
+        auto generator = makeGenerator(spec, VR_STREAM, rowStart / rows);
+
+        size_t i = 0;
+        for (uint32_t row=rowStart; row<=rowEnd; ++row)
+            for (uint32_t column=0; column<spec.columns; ++column, ++i)
+            {
+                auto& item = items[i];
+                item = {};
+
+                if (isNull(spec, generator) ||
+                    std::uniform_real_distribution<double>{}(generator) >=
+                        spec.vrDensity)
+                    continue;
+
+                const auto dimsX = dims(generator);
+                const auto dimsY = dims(generator);
+
+                // The refinement index is 32 bits.
+                if (numRefinements + dimsX * dimsY >
+                    std::numeric_limits<uint32_t>::max())
+                    throw std::runtime_error{
+                        "Too many refinements; lower the VR density."};
+
+                item.index = static_cast<uint32_t>(numRefinements);
+                item.dimensions_x = dimsX;
+                item.dimensions_y = dimsY;
+                item.resolution_x = static_cast<float>(spacingX / dimsX);
+                item.resolution_y = static_cast<float>(spacingY / dimsY);
+                item.sw_corner_x = item.resolution_x / 2.f;
+                item.sw_corner_y = item.resolution_y / 2.f;
+
+                refinements.resize(static_cast<size_t>(dimsX) * dimsY);
+                for (auto& refinement : refinements)
+                    refinement = {depth(generator), .5f};
+
+                pWriter->append(refinements.data(), refinements.size());
+                numRefinements += refinements.size();
+            }
+
+        pVRMetadata->write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(items.data()));
+    }
+
+    pWriter->close();
+
+    return numRefinements;
+}
+
+//! Add a georeferenced metadata layer, keying each non null node to a random
+//! record.
+void writeGeorefMetadata(
+    BAG::Dataset& dataset,
+    const GeneratorSpec& spec)
+{
+    BAG::RecordDefinition definition(3);
+    definition[0].name = "depth";
+    definition[0].type = DT_FLOAT32;
+    definition[1].name = "source";
+    definition[1].type = DT_UINT32;
+    definition[2].name = "survey";
+    definition[2].type = DT_STRING;
+
+    auto& layer = dataset.createGeorefMetadataLayer(DT_UINT32,
+        UNKNOWN_METADATA_PROFILE, kGeorefMetadataLayerName, definition,
+        spec.chunkSize, spec.compressionLevel);
+
+    {
+        auto generator = makeGenerator(spec, GEOREF_STREAM,
+            std::numeric_limits<uint64_t>::max());
+        std::uniform_real_distribution<float> depth{-60.f, -40.f};
+
+        BAG::Records records;
+        records.reserve(spec.numGeorefRecords);
+        for (uint32_t i=0; i<spec.numGeorefRecords; ++i)
+            records.push_back({BAG::CompoundDataType{depth(generator)},
+                BAG::CompoundDataType{i % 17},
+                BAG::CompoundDataType{"survey " + std::to_string(i)}});
+
+        layer.getValueTable().addRecords(std::move(records));
+    }
+
+    std::uniform_int_distribution<uint32_t> key{1, spec.numGeorefRecords};
+
+    const auto rows = bandRows(spec);
+    std::vector<uint32_t> keys(static_cast<size_t>(rows) * spec.columns);
+
+    for (uint32_t rowStart=0; rowStart<spec.rows; rowStart+=rows)
+    {
+        const auto rowEnd = std::min(rowStart + rows, spec.rows) - 1;
+        auto generator = makeGenerator(spec, GEOREF_STREAM, rowStart / rows);
+
+        size_t i = 0;
+        for (uint32_t row=rowStart; row<=rowEnd; ++row)
+            for (uint32_t column=0; column<spec.columns; ++column, ++i)
+                keys[i] = isNull(spec, generator) ? 0 : key(generator);
+
+        layer.write(rowStart, 0, rowEnd, spec.columns - 1,
+            reinterpret_cast<const uint8_t*>(keys.data()));
+    }
+}
+
+//! Add gridded surface corrections, one corrector node per
+//! kCorrectorSpacing nodes.
+void writeSurfaceCorrections(
+    BAG::Dataset& dataset,
+    const GeneratorSpec& spec)
+{
+    const auto rows = std::min(spec.rows / kCorrectorSpacing + 1, spec.rows);
+    const auto columns = std::min(spec.columns / kCorrectorSpacing + 1,
+        spec.columns);
+
+    // HDF5 does not allow chunks larger than the corrector grid.
+    const auto chunkSize = std::min<uint64_t>(spec.chunkSize,
+        std::min(rows, columns));
+
+    auto& corrections = dataset.createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, static_cast<uint8_t>(spec.numCorrectors),
+        chunkSize, spec.compressionLevel);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = dataset.getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = dataset.getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * kCorrectorSpacing, spacingY * kCorrectorSpacing);
+
+    std::uniform_real_distribution<float> offset{-1.f, 1.f};
+    std::vector<BagVerticalDatumCorrectionsGridded> band(columns);
+
+    for (uint32_t row=0; row<rows; ++row)
+    {
+        auto generator = makeGenerator(spec, CORRECTIONS_STREAM, row);
+
+        for (auto& item : band)
+        {
+            item = {};
+            for (uint32_t corrector=0; corrector<spec.numCorrectors;
+                ++corrector)
+                item.z[corrector] = offset(generator);
+        }
+
+        corrections.write(row, 0, row, columns - 1,
+            reinterpret_cast<const uint8_t*>(band.data()));
+    }
+}
+
+//! Fill the tracking list with edits of nodes spread over the grid.
+void writeTrackingList(
+    BAG::Dataset& dataset,
+    const GeneratorSpec& spec)
+{
+    auto generator = makeGenerator(spec, TRACKING_STREAM, 0);
+
+    std::uniform_int_distribution<uint32_t> row{0, spec.rows - 1};
+    std::uniform_int_distribution<uint32_t> column{0, spec.columns - 1};
+    std::uniform_real_distribution<float> depth{-60.f, -40.f};
+
+    auto& trackingList = dataset.getTrackingList();
+    trackingList.reserve(spec.numTrackingItems);
+
+    for (uint32_t i=0; i<spec.numTrackingItems; ++i)
+        trackingList.push_back(BAG::TrackingItem{row(generator),
+            column(generator), depth(generator), .5f,
+            static_cast<uint8_t>(i % 8), static_cast<uint16_t>(i % 100)});
+
+    trackingList.write();
+}
+
+}  // namespace
+
+
+int main(
+    int argc,
+    char* argv[])
+{
+    bool generateHelp = false;
+    bool badOption = false;
+    GeneratorSpec spec;
+
+    int c = getopt(argc, argv, const_cast<char *>(kOptions));
+
+    while (c != EOF)
+    {
+        switch (c)
+        {
+        case 's':
+        {
+            const auto numRead = std::sscanf(optarg, "%ux%u", &spec.rows,
+                &spec.columns);
+            if (numRead < 1)
+                badOption = true;
+            else if (numRead == 1)
+                spec.columns = spec.rows;
+            break;
+        }
+        case 'S':
+            spec.seed = static_cast<uint32_t>(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'c':
+            spec.chunkSize = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 'z':
+            spec.compressionLevel = std::atoi(optarg);
+            break;
+        case 'n':
+            spec.nullFraction = std::atof(optarg);
+            break;
+        case 'v':
+            if (std::sscanf(optarg, "%lf,%u", &spec.vrDensity,
+                &spec.maxRefinementDims) < 1)
+                badOption = true;
+            break;
+        case 'g':
+            spec.numGeorefRecords = static_cast<uint32_t>(
+                std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'k':
+            spec.numCorrectors = static_cast<uint32_t>(
+                std::strtoul(optarg, nullptr, 10));
+            break;
+        case 't':
+            spec.numTrackingItems = static_cast<uint32_t>(
+                std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'h':
+            generateHelp = true;
+            break;
+        case '?':  //[[fallthrough]]
+        default:
+            std::cerr << "error: unknown option flag '" << +optopt << "'\n";
+            badOption = true;
+            break;
+        }
+
+        c = getopt(argc, argv, const_cast<char *>(kOptions));
+    }
+
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (spec.rows < 2 || spec.columns < 2 || spec.nullFraction < 0. ||
+        spec.nullFraction > 1. || spec.vrDensity < 0. ||
+        spec.vrDensity > 1. || spec.numCorrectors > BAG_SURFACE_CORRECTOR_LIMIT)
+        badOption = true;
+
+    if (argc != ARGC_EXPECTED || generateHelp || badOption)
+    {
+        std::cout << "bag_generate [" << __DATE__ << R"(] - Generate a synthetic BAG for benchmarking.
+Syntax: bag_generate [opt] <template_xml_file> <output_file>
+The metadata comes from the template, resized to the grid.
+Options:
+ -s <rows>[x<columns>]  The size of the grid (default 10000).
+ -S <seed>  The seed of the random numbers (default 1).
+ -c <chunk_size>  The rows and columns in a chunk (default 256).
+ -z <level>  Compress the layers with deflate at this level (0 to 9; default 6).
+ -n <fraction>  The fraction of the nodes that are null (default 0).
+ -v <density>[,<max_dims>]  Add variable resolution layers, refining this fraction of the nodes into 2 to max_dims (default 4) refinements along each side.
+ -g <records>  Add a georeferenced metadata layer with this many records.
+ -k <correctors>  Add gridded surface corrections with this many correctors (1 to 10).
+ -t <items>  Add this many items to the tracking list.
+ -h Generate this help information.
+)";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto pDataset = BAG::Dataset::create(argv[OUTPUT_BAG],
+            makeMetadata(argv[TEMPLATE_XML], spec), spec.chunkSize,
+            spec.compressionLevel);
+
+        writeSurface(*pDataset, spec);
+
+        // Georeferenced metadata layers only get variable resolution keys
+        // when the VR layers already exist.
+        if (spec.vrDensity > 0.)
+            pDataset->createVR(spec.chunkSize, spec.compressionLevel, false);
+
+        if (spec.numGeorefRecords > 0)
+            writeGeorefMetadata(*pDataset, spec);
+
+        if (spec.numCorrectors > 0)
+            writeSurfaceCorrections(*pDataset, spec);
+
+        if (spec.numTrackingItems > 0)
+            writeTrackingList(*pDataset, spec);
+
+        uint64_t numRefinements = 0;
+        if (spec.vrDensity > 0.)
+            numRefinements = writeVariableResolution(*pDataset, spec);
+
+        pDataset->close();
+
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::cout << "Generated " << argv[OUTPUT_BAG] << " (" << spec.rows
+            << ", " << spec.columns << ") cells, " << numRefinements
+            << " refinements, in " << elapsed.count() << " s.\n";
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
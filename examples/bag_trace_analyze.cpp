@@ -0,0 +1,137 @@
+/*! \file bag_trace_analyze.cpp
+ * \brief Recommend chunk shapes and chunk caches from an access trace.
+ *
+ * The reads and writes recorded by BAG::Dataset::startAccessTrace() are
+ * replayed against candidate chunk shapes and chunk cache sizes, and for
+ * each layer the chunks and bytes decoded with the settings traced are
+ * reported beside those with the settings recommended.
+ */
+
+#include "getopt.h"
+
+#include <bag_accesstrace.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+enum Cmd {
+    INPUT_TRACE = 1,
+    ARGC_EXPECTED
+};
+
+constexpr const char* kOptions = "l:h";
+
+//! Print the estimated cost of the accesses of a layer.
+void printResult(
+    const char* label,
+    const BAG::ReplayResult& result)
+{
+    std::cout << "  " << label << ": ";
+
+    if (result.candidate.chunkRows == 0 || result.candidate.chunkColumns == 0)
+        std::cout << "contiguous";
+    else
+        std::cout << result.candidate.chunkRows << " x " <<
+            result.candidate.chunkColumns << " chunks";
+
+    std::cout << ", " << (result.candidate.cacheSize > 0 ?
+        std::to_string(result.candidate.cacheSize) : std::string{"default"}) <<
+        " byte cache; " << result.chunksDecoded << " chunks, " <<
+        result.bytesDecoded << " bytes decoded; " <<
+        result.cacheHitRate * 100. << "% cache hits\n";
+}
+
+}  // namespace
+
+
+int main(
+    int argc,
+    char* argv[])
+{
+    bool generateHelp = false;
+    bool badOption = false;
+    std::string layerName;
+
+    int c = getopt(argc, argv, const_cast<char *>(kOptions));
+
+    while (c != EOF)
+    {
+        switch (c)
+        {
+        case 'l':
+            layerName = optarg;
+            break;
+        case 'h':
+            generateHelp = true;
+            break;
+        case '?':  //[[fallthrough]]
+        default:
+            std::cerr << "error: unknown option flag '" << +optopt << "'\n";
+            badOption = true;
+            break;
+        }
+
+        c = getopt(argc, argv, const_cast<char *>(kOptions));
+    }
+
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != ARGC_EXPECTED || generateHelp || badOption)
+    {
+        std::cout << "bag_trace_analyze [" << __DATE__ << R"(] - Recommend chunk shapes and chunk caches from an access trace.
+Syntax: bag_trace_analyze [opt] <input_trace>
+Options:
+ -l <layer>  Only analyze the layer with this name.
+ -h Generate this help information.
+)";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const auto trace = BAG::loadAccessTrace(argv[INPUT_TRACE]);
+
+        std::cout << "Loaded " << trace.records.size() << " accesses of " <<
+            trace.layers.size() << " layers.\n";
+
+        for (uint32_t layer=0; layer<trace.layers.size(); ++layer)
+        {
+            const auto& traced = trace.layers[layer];
+            if (!layerName.empty() && traced.name != layerName)
+                continue;
+
+            uint64_t numReads = 0, numWrites = 0, nanoseconds = 0;
+            for (const auto& record : trace.records)
+                if (record.layer == layer)
+                {
+                    ++(record.kind == BAG::AccessKind::Read ? numReads :
+                        numWrites);
+                    nanoseconds += record.durationNanoseconds;
+                }
+
+            const auto recommendation = BAG::recommendLayout(trace, layer);
+
+            std::cout << '\n' << traced.name << " (" << traced.numRows <<
+                " x " << traced.numColumns << "): " << numReads <<
+                " reads, " << numWrites << " writes, " <<
+                nanoseconds / 1000000. << " ms\n";
+            printResult("traced", recommendation.traced);
+            printResult("recommended", recommendation.estimate);
+            std::cout << "  cache slots: " <<
+                recommendation.chunkCache.slots << '\n';
+        }
+
+        return EXIT_SUCCESS;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,138 @@
+/*! \file bag_verify.cpp
+ * \brief Check that every chunk of a BAG decompresses, and holds sane values.
+ *
+ * The chunks of every layer are decompressed on several threads, their
+ * Fletcher32 checksums verified where they have one, and the values of the
+ * layers checked against the minimum and maximum of their descriptors, the
+ * keys of georeferenced metadata layers against their value tables and the
+ * refinements of variable resolution cells against the VRRefinements layer.
+ */
+
+#include "getopt.h"
+
+#include <bag_dataset.h>
+#include <bag_executor.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+enum Cmd {
+    INPUT_BAG = 1,
+    ARGC_EXPECTED
+};
+
+constexpr const char* kOptions = "t:dh";
+
+//! Retrieve the name of a problem.
+const char* getProblemName(
+    BAG::VerifyProblem problem)
+{
+    switch (problem)
+    {
+    case BAG::VerifyProblem::ChecksumMismatch:
+        return "checksum mismatch";
+    case BAG::VerifyProblem::DecompressionFailed:
+        return "decompression failed";
+    case BAG::VerifyProblem::ValueOutOfRange:
+        return "value out of range";
+    case BAG::VerifyProblem::KeyOutOfRange:
+        return "key out of range";
+    case BAG::VerifyProblem::IndexOutOfRange:
+        return "index out of range";
+    case BAG::VerifyProblem::Unreadable:  //[[fallthrough]]
+    default:
+        return "unreadable";
+    }
+}
+
+}  // namespace
+
+
+int main(
+    int argc,
+    char* argv[])
+{
+    bool generateHelp = false;
+    bool badOption = false;
+    BAG::VerifyOptions options;
+
+    int c = getopt(argc, argv, const_cast<char *>(kOptions));
+
+    while (c != EOF)
+    {
+        switch (c)
+        {
+        case 't':
+        {
+            const auto numThreads = std::atoi(optarg);
+            if (numThreads <= 0)
+                badOption = true;
+            else
+                BAG::setConcurrency(static_cast<uint32_t>(numThreads));
+            break;
+        }
+        case 'd':
+            options.checkValues = false;
+            break;
+        case 'h':
+            generateHelp = true;
+            break;
+        case '?':  //[[fallthrough]]
+        default:
+            std::cerr << "error: unknown option flag '" << +optopt << "'\n";
+            badOption = true;
+            break;
+        }
+
+        c = getopt(argc, argv, const_cast<char *>(kOptions));
+    }
+
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (argc != ARGC_EXPECTED || generateHelp || badOption)
+    {
+        std::cout << "bag_verify [" << __DATE__ << R"(] - Check that every chunk of a BAG decompresses, and holds sane values.
+Syntax: bag_verify [opt] <input_file>
+Options:
+ -t <threads>  Decompress and check the chunks on this many threads.
+ -d  Only check that the chunks decompress, and their checksums.
+ -h Generate this help information.
+)";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const auto dataset = BAG::Dataset::open(argv[INPUT_BAG],
+            BAG_OPEN_READONLY);
+
+        const auto report = dataset->verify(options);
+
+        for (const auto& problem : report.problems)
+        {
+            std::cout << problem.path << " (";
+            for (size_t i=0; i<problem.offset.size(); ++i)
+                std::cout << (i > 0 ? ", " : "") << problem.offset[i];
+            std::cout << "): " << getProblemName(problem.problem) << ": " <<
+                problem.message << '\n';
+        }
+
+        std::cout << "Verified " << report.numChunks << " chunks of " <<
+            report.numDataSets << " DataSets (" <<
+            report.numUnallocatedChunks << " never written); " <<
+            report.problems.size() << " problems found.\n";
+
+        return report.isValid() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
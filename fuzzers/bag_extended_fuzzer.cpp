@@ -1,114 +1,281 @@
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <iomanip>
+#include <utility>
 
 #include <stddef.h>
 #include <stdint.h>
-#include <unistd.h>
+
+#include <H5Cpp.h>
 
 #include "bag_dataset.h"
+#include "bag_georefmetadatalayer.h"
+#include "bag_simplelayer.h"
+#include "bag_valuetable.h"
+#include "bag_vrcelliterator.h"
+#include "bag_vrmetadata.h"
 
 using BAG::Dataset;
 
 
+namespace {
+
+//! The most rows and columns read from each layer of an input.
+constexpr uint32_t kMaxReadSize = 16;
+
+//! The most refined cells walked in an input.
+constexpr size_t kMaxVRCells = 64;
+
+//! Where the details of each input are written.
+/*!
+    Writing to the terminal dominates the time of an execution, so the
+    details are only written when BAG_FUZZER_VERBOSE is set; otherwise the
+    stream discards them.
+*/
+std::ostream& out()
+{
+    static std::ostream discard{nullptr};
+    static const bool verbose = std::getenv("BAG_FUZZER_VERBOSE") != nullptr;
+
+    return verbose ? std::cout : discard;
+}
+
 void printLayerDescriptor(
         const BAG::LayerDescriptor& descriptor)
 {
-    std::cout << "\t\tchunkSize == " << descriptor.getChunkSize() << '\n';
-    std::cout << "\t\tcompression level == " << descriptor.getCompressionLevel() << '\n';
-    std::cout << "\t\tdata type == " << descriptor.getDataType() << '\n';
-    std::cout << "\t\telement size == " << +descriptor.getElementSize() << '\n';
-    std::cout << "\t\tinternalPath == " << descriptor.getInternalPath() << '\n';
-    std::cout << "\t\tlayer type == " << descriptor.getLayerType() << '\n';
+    out() << "\t\tchunkSize == " << descriptor.getChunkSize() << '\n';
+    out() << "\t\tcompression level == " << descriptor.getCompressionLevel() << '\n';
+    out() << "\t\tdata type == " << descriptor.getDataType() << '\n';
+    out() << "\t\telement size == " << +descriptor.getElementSize() << '\n';
+    out() << "\t\tinternalPath == " << descriptor.getInternalPath() << '\n';
+    out() << "\t\tlayer type == " << descriptor.getLayerType() << '\n';
 
     const auto minMax = descriptor.getMinMax();
-    std::cout << "\t\tmin max == (" << std::get<0>(minMax) << ", " <<
+    out() << "\t\tmin max == (" << std::get<0>(minMax) << ", " <<
               std::get<1>(minMax) << ")\n";
 }
 
-
-extern "C" int LLVMFuzzerTestOneInput(const uint8_t *buf, size_t len) {
-
-    char filename[256];
-    snprintf(filename, 255, "/tmp/libfuzzer.%d", getpid());
-
-    // Save input file to temporary file so that we can read it.
-    FILE *fp = fopen(filename, "wb");
-    if (!fp) {
-        return 0;
-    }
-    fwrite(buf, len, 1, fp);
-    fclose(fp);
-
-    auto pDataset = Dataset::open(filename, BAG_OPEN_READONLY);
-    if (pDataset == NULL) {
-        return EXIT_FAILURE;
-    }
-
-    const auto& descriptor = pDataset->getDescriptor();
+//! Print the descriptor, layers and tracking list of a BAG opened eagerly.
+void exerciseEager(
+        const Dataset& dataset)
+{
+    const auto& descriptor = dataset.getDescriptor();
     uint64_t numRows = 0, numCols = 0;
     std::tie(numRows, numCols) = descriptor.getDims();
-    std::cout << "\trows, columns == " << numRows << ", " << numCols << '\n';
+    out() << "\trows, columns == " << numRows << ", " << numCols << '\n';
 
     double minX = 0., minY = 0., maxX = 0., maxY = 0.;
-    std::tie(minX, minY) = pDataset->gridToGeo(0, 0);
-    std::tie(maxX, maxY) = pDataset->gridToGeo(numRows - 1, numCols - 1);
+    std::tie(minX, minY) = dataset.gridToGeo(0, 0);
+    std::tie(maxX, maxY) = dataset.gridToGeo(numRows - 1, numCols - 1);
 
-    std::cout << "\tgrid cover (llx, lly), (urx, ury) == (" <<
+    out() << "\tgrid cover (llx, lly), (urx, ury) == (" <<
               std::setprecision(10) << minX << ", " << minY << "), (" << maxX <<
               ", " << maxY << ")\n";
 
     const auto& dims = descriptor.getDims();
-    std::cout << "\tdims == (" << std::get<0>(dims) << ", " <<
+    out() << "\tdims == (" << std::get<0>(dims) << ", " <<
               std::get<1>(dims) << ")\n";
 
     const auto& gridSpacing = descriptor.getGridSpacing();
-    std::cout << "\tgrid spacing == (" << std::get<0>(gridSpacing) << ", " <<
+    out() << "\tgrid spacing == (" << std::get<0>(gridSpacing) << ", " <<
               std::get<1>(gridSpacing) << ")\n";
 
     const auto& origin = descriptor.getOrigin();
-    std::cout << "\torigin == (" << std::get<0>(origin) << ", "
+    out() << "\torigin == (" << std::get<0>(origin) << ", "
               << std::get<1>(origin) << ")\n";
 
     const auto& projCover = descriptor.getProjectedCover();
-    std::cout << "\tprojected cover (llx, lly), (urx, ury) == (" << std::get<0>(projCover) << ", " <<
+    out() << "\tprojected cover (llx, lly), (urx, ury) == (" << std::get<0>(projCover) << ", " <<
               std::get<1>(projCover) << "), (" << std::get<2>(projCover) << ", " <<
               std::get<3>(projCover) << ")\n";
 
-    std::cout << "\tversion == " << descriptor.getVersion() << '\n';
+    out() << "\tversion == " << descriptor.getVersion() << '\n';
 
-    std::cout << "\thorizontal reference system ==\n" <<
+    out() << "\thorizontal reference system ==\n" <<
               descriptor.getHorizontalReferenceSystem() << "\n\n";
 
-    std::cout << "\tvertical reference system ==\n" << descriptor.getVerticalReferenceSystem() << '\n';
+    out() << "\tvertical reference system ==\n" << descriptor.getVerticalReferenceSystem() << '\n';
 
-    std::cout << "\nLayers:\n";
+    out() << "\nLayers:\n";
 
-    for (const auto& layer : pDataset->getLayers())
+    for (const auto& layer : dataset.getLayers())
     {
         auto pDescriptor = layer->getDescriptor();
 
-        std::cout << "\t" << pDescriptor->getName() << " Layer .. id(" <<
+        out() << "\t" << pDescriptor->getName() << " Layer .. id(" <<
                   pDescriptor->getId() << ")\n";
 
         printLayerDescriptor(*pDescriptor);
     }
 
-    const auto& trackingList = pDataset->getTrackingList();
-    std::cout << "\nTracking List:  (" << trackingList.size() << " items)\n";
+    const auto& trackingList = dataset.getTrackingList();
+    out() << "\nTracking List:  (" << trackingList.size() << " items)\n";
 
     size_t itemNum = 0;
     for (const auto& item : trackingList)
     {
-        std::cout << "\tTracking list item #" << itemNum++ << '\n';
-        std::cout << "\t\trow == " << item.row << '\n';
-        std::cout << "\t\tcol == " << item.col << '\n';
-        std::cout << "\t\tdepth == " << item.depth << '\n';
-        std::cout << "\t\tuncertainty == " << item.uncertainty << '\n';
-        std::cout << "\t\ttrack_code == " << item.track_code << '\n';
-        std::cout << "\t\tlist_series == " << item.list_series << '\n';
+        out() << "\tTracking list item #" << itemNum++ << '\n';
+        out() << "\t\trow == " << item.row << '\n';
+        out() << "\t\tcol == " << item.col << '\n';
+        out() << "\t\tdepth == " << item.depth << '\n';
+        out() << "\t\tuncertainty == " << item.uncertainty << '\n';
+        out() << "\t\ttrack_code == " << item.track_code << '\n';
+        out() << "\t\tlist_series == " << item.list_series << '\n';
+    }
+}
+
+//! Open each layer of a lazily opened BAG on first use, and read from it.
+void exerciseLazy(
+        const Dataset& dataset)
+{
+    uint32_t numRows = 0, numCols = 0;
+    std::tie(numRows, numCols) = dataset.getDescriptor().getDims();
+    if (numRows == 0 || numCols == 0)
+        return;
+
+    const auto rowEnd = std::min(numRows, kMaxReadSize) - 1;
+    const auto columnEnd = std::min(numCols, kMaxReadSize) - 1;
+
+    for (const auto type : dataset.getLayerTypes())
+    {
+        const auto pLayer = dataset.getSimpleLayer(type);
+        if (!pLayer)
+            continue;
+
+        const auto buffer = pLayer->read(0, 0, rowEnd, columnEnd);
+        out() << "\tread " << buffer.size() << " bytes of layer " << type << '\n';
+    }
+
+    // The metadata is only parsed now, as it was deferred.
+    out() << "\tmetadata XML == " << dataset.getMetadata().getXMLlength() <<
+              " bytes\n";
+}
+
+//! Walk the refined cells of a variable resolution BAG.
+void exerciseVR(
+        const Dataset& dataset)
+{
+    if (!dataset.getVRMetadata() || !dataset.getVRRefinements())
+        return;
+
+    // A small block size reads several blocks even from a small input.
+    BAG::VRCellIterator iterator{dataset, 16};
+
+    BAG::VRCell cell;
+    size_t numCells = 0;
+    float depthSum = 0.f;
+    while (numCells < kMaxVRCells && iterator.next(cell))
+    {
+        for (uint32_t i=0; i<cell.count; ++i)
+            depthSum += cell.refinements[i].depth;
+
+        ++numCells;
+    }
+
+    out() << "\twalked " << numCells << " of " << iterator.size() <<
+              " refined cells; depth sum == " << depthSum << '\n';
+}
+
+//! Read the georeferenced metadata layers by column.
+void exerciseValueTables(
+        Dataset& dataset)
+{
+    uint32_t numRows = 0, numCols = 0;
+    std::tie(numRows, numCols) = dataset.getDescriptor().getDims();
+
+    for (const auto& pLayer : dataset.getGeorefMetadataLayers())
+    {
+        const auto& name = pLayer->getDescriptor()->getName();
+        const auto& valueTable = pLayer->getValueTable();
+        const auto columns = valueTable.exportColumns();
+        out() << "\t" << name << ": " << valueTable.getNumRecords() <<
+                  " records, " << columns.size() << " columns\n";
+
+        std::vector<std::string> fieldNames;
+        for (const auto& column : columns)
+            fieldNames.push_back(column.name);
+
+        if (numRows > 0 && numCols > 0)
+            pLayer->readResolved(0, 0, std::min(numRows, kMaxReadSize) - 1,
+                std::min(numCols, kMaxReadSize) - 1, fieldNames);
+
+        if (pLayer->hasVRKeys() && dataset.getVRMetadata())
+            pLayer->readVRResolved(0, 0, 0, 0, fieldNames);
+    }
+}
+
+//! Run an exercise, carrying on past the exceptions a malformed BAG raises.
+/*!
+    HDF5 exceptions do not derive from std::exception, so both are caught.
+*/
+template <typename Exercise, typename... Args>
+void run(
+        const char* name,
+        Exercise exercise,
+        Args&&... args)
+{
+    try
+    {
+        exercise(std::forward<Args>(args)...);
+    }
+    catch (const std::exception& e)
+    {
+        out() << name << " exception: " << e.what() << '\n';
+    }
+    catch (const ::H5::Exception& e)
+    {
+        out() << name << " HDF5 exception: " << e.getDetailMsg() << '\n';
     }
+}
+
+//! Open the input as a BAG held in memory, and exercise it.
+void exerciseAll(
+        const uint8_t* buf,
+        size_t len)
+{
+    auto pDataset = Dataset::openFromMemory(buf, len, BAG_OPEN_READONLY);
+    if (pDataset == NULL)
+        return;
+
+    run("eager", exerciseEager, *pDataset);
+    run("vr", exerciseVR, *pDataset);
+    run("value table", exerciseValueTables, *pDataset);
+    pDataset->close();
+}
+
+//! Open the input lazily, so each layer is opened when first used.
+void exerciseAllLazily(
+        const uint8_t* buf,
+        size_t len)
+{
+    BAG::OpenOptions options;
+    options.lazy = true;
+    options.deferMetadata = true;
+
+    auto pDataset = Dataset::openFromMemory(buf, len, BAG_OPEN_READONLY,
+        options);
+    if (pDataset == NULL)
+        return;
 
+    run("lazy", exerciseLazy, *pDataset);
+    run("lazy value table", exerciseValueTables, *pDataset);
     pDataset->close();
+}
+
+}  // namespace
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *buf, size_t len) {
+
+    if (len == 0) {
+        return 0;
+    }
+
+    // libFuzzer runs every input in this process, without a temporary file.
+    run("open", exerciseAll, buf, len);
+    run("lazy open", exerciseAllLazily, buf, len);
 
-    return EXIT_SUCCESS;
+    return 0;
 }
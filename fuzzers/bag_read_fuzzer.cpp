@@ -1,6 +1,5 @@
 #include <stddef.h>
 #include <stdint.h>
-#include <unistd.h>
 
 #include "bag_dataset.h"
 
@@ -9,18 +8,12 @@ using BAG::Dataset;
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *buf, size_t len) {
 
-    char filename[256];
-    snprintf(filename, 255, "/tmp/libfuzzer.%d", getpid());
-
-    // Save input file to temporary file so that we can read it.
-    FILE *fp = fopen(filename, "wb");
-    if (!fp) {
+    if (len == 0) {
         return 0;
     }
-    fwrite(buf, len, 1, fp);
-    fclose(fp);
 
-    auto pDataset = Dataset::open(filename, BAG_OPEN_READONLY);
+    // Open the input as a BAG held in memory, without a temporary file.
+    auto pDataset = Dataset::openFromMemory(buf, len, BAG_OPEN_READONLY);
     if (pDataset != NULL) {
         pDataset->close();
     }
@@ -161,6 +161,43 @@ class TestDataset(unittest.TestCase):
         self.assertIsNotNone(descriptor)
         self.assertEqual(descriptor.isReadOnly(), False)
 
+    def testIoStats(self):
+        bagFileName = datapath + "/sample.bag"
+        options = OpenOptions()
+        options.collectIoStats = True
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY, options)
+        self.assertIsNotNone(dataset)
+        self.assertTrue(dataset.isCollectingIoStats())
+
+        layer = dataset.getLayer(Elevation)
+        layer.read(0, 0, 9, 9)
+
+        layerStats = layer.getIoStats()
+        self.assertEqual(layerStats.numReads, 1)
+        self.assertEqual(layerStats.bytesRequested, 400)
+
+        stats = dataset.getIoStats()
+        self.assertEqual(stats.total.numReads, 1)
+        self.assertIn(Elevation, [layerStats.type for layerStats in stats.layers])
+
+        dataset.resetIoStats()
+        self.assertEqual(layer.getIoStats().numReads, 0)
+
+
+    def testMemoryUsage(self):
+        bagFileName = datapath + "/sample.bag"
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY)
+        self.assertIsNotNone(dataset)
+
+        usage = dataset.getMemoryUsage()
+        self.assertGreater(usage.metadata, 0)
+        self.assertGreaterEqual(usage.getTotal(), usage.getReleasable())
+
+        dataset.releaseCaches()
+        self.assertEqual(dataset.getMemoryUsage().getReleasable(), 0)
+
+        budget = MemoryBudget.getGlobal()
+        self.assertEqual(budget.getLimit(), 0)
 
 if __name__ == '__main__':
     unittest.main(
@@ -54,6 +54,102 @@ class TestSimpleLayer(unittest.TestCase):
         for actual, expected in zip(buffer, kExpectedBuffer):
             self.assertAlmostEqual(actual, expected, places=5)
 
+    def testReadArray(self):
+        import numpy
+
+        bagFileName = datapath + "/NAVO_data/JD211_public_Release_1-4_UTM.bag"
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY)
+        self.assertIsNotNone(dataset)
+
+        elevLayer = dataset.getLayer(Elevation)
+        self.assertIsNotNone(elevLayer)
+
+        result = elevLayer.readArray(288, 249, 289, 251) # 2x3
+        self.assertEqual(result.dtype, numpy.float32)
+        self.assertEqual(result.shape, (2, 3))
+
+        kExpectedBuffer = ((1000000.0, -52.161003, -52.172005),
+            (1000000.0, -52.177002, -52.174004))
+
+        numpy.testing.assert_allclose(result, kExpectedBuffer, rtol=1e-6)
+
+        # The array must keep the buffer alive after the layer is gone.
+        del elevLayer
+        del dataset
+        self.assertAlmostEqual(float(result[1, 2]), -52.174004, places=5)
+
+    def testReadBlock(self):
+        import numpy
+
+        bagFileName = datapath + "/NAVO_data/JD211_public_Release_1-4_UTM.bag"
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY)
+        self.assertIsNotNone(dataset)
+
+        elevLayer = dataset.getLayer(Elevation)
+        self.assertIsNotNone(elevLayer)
+
+        numRows, numColumns = elevLayer.getDims()
+        chunkRows, chunkColumns = elevLayer.getChunkShape()
+        numChunkRows, numChunkColumns = elevLayer.getNumChunks()
+        self.assertEqual(numChunkRows, -(-numRows // chunkRows))
+        self.assertEqual(numChunkColumns, -(-numColumns // chunkColumns))
+
+        # The last chunk is clipped to the grid.
+        block = elevLayer.readBlock(numChunkRows - 1, numChunkColumns - 1)
+        rowStart = (numChunkRows - 1) * chunkRows
+        columnStart = (numChunkColumns - 1) * chunkColumns
+        expected = elevLayer.readArray(rowStart, columnStart, numRows - 1,
+            numColumns - 1)
+        self.assertEqual(block.shape, expected.shape)
+        numpy.testing.assert_array_equal(block, expected)
+
+    def testToDask(self):
+        try:
+            import dask
+        except ImportError:
+            self.skipTest("dask is not installed")
+        import numpy
+
+        bagFileName = datapath + "/NAVO_data/JD211_public_Release_1-4_UTM.bag"
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY)
+        elevLayer = dataset.getLayer(Elevation)
+
+        array = elevLayer.toDask()
+        self.assertEqual(array.shape, elevLayer.getDims())
+        self.assertEqual(array.chunks, elevLayer._chunkSpans())
+
+        window = array[288:290, 249:252].compute(scheduler='synchronous')
+        numpy.testing.assert_array_equal(window,
+            elevLayer.readArray(288, 249, 289, 251))
+
+    def testConcurrentRead(self):
+        from concurrent.futures import ThreadPoolExecutor
+
+        bagFileName = datapath + "/NAVO_data/JD211_public_Release_1-4_UTM.bag"
+        options = OpenOptions()
+        options.concurrentReads = True
+        dataset = Dataset.openDataset(bagFileName, BAG_OPEN_READONLY, options)
+        self.assertIsNotNone(dataset)
+        self.assertTrue(dataset.isConcurrentReadEnabled())
+
+        elevLayer = dataset.getLayer(Elevation)
+        self.assertIsNotNone(elevLayer)
+
+        # The reads release the GIL, so they run on the pool at the same time.
+        def readBlock(_):
+            return elevLayer.read(288, 249, 289, 251).asFloatItems()
+
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            results = list(pool.map(readBlock, range(16)))
+
+        kExpectedBuffer = (1000000.0, -52.161003, -52.172005,
+            1000000.0, -52.177002, -52.174004)
+
+        for buffer in results:
+            self.assertEqual(len(buffer), len(kExpectedBuffer))
+            for actual, expected in zip(buffer, kExpectedBuffer):
+                self.assertAlmostEqual(actual, expected, places=5)
+
     def testWrite(self):
         kLayerType = Elevation
         kExpectedNumNodes = 12
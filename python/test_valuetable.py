@@ -399,6 +399,51 @@ class TestValueTable(unittest.TestCase):
 
         del dataset #ensure dataset is deleted before tmpFile
 
+    def testExportColumns(self):
+        import numpy
+
+        tmpFile = testUtils.RandomFileGuard("name")
+
+        metadata = Metadata()
+        metadata.loadFromBuffer(bagMetadataSamples.kMetadataXML)
+        dataset = Dataset.create(tmpFile.getName(), metadata, chunkSize, compressionLevel)
+        self.assertIsNotNone(dataset)
+
+        definition = RecordDefinition(3)
+        definition[0].name = "depth"
+        definition[0].type = DT_FLOAT32
+        definition[1].name = "name"
+        definition[1].type = DT_STRING
+        definition[2].name = "valid"
+        definition[2].type = DT_BOOLEAN
+
+        layer = dataset.createGeorefMetadataLayer(DT_UINT16, UNKNOWN_METADATA_PROFILE,
+                                                  "elevation", definition, chunkSize, compressionLevel)
+        valueTable = layer.getValueTable()
+
+        record = Record(3)
+        record[0] = CompoundDataType(12.5)
+        record[1] = CompoundDataType("survey")
+        record[2] = CompoundDataType(True)
+        valueTable.addRecord(record)
+
+        columns = valueTable.exportColumns()
+        self.assertEqual(list(columns.keys()), ["depth", "name", "valid"])
+
+        # The no data value record comes first.
+        numpy.testing.assert_array_equal(columns["depth"].values(),
+            numpy.array([0.0, 12.5], dtype=numpy.float32))
+        numpy.testing.assert_array_equal(columns["valid"].values(), [False, True])
+        numpy.testing.assert_array_equal(columns["name"].offsets(), [0, 0, 6])
+        self.assertEqual(columns["name"].characters().tobytes(), b"survey")
+
+        array = valueTable.toStructuredArray()
+        self.assertEqual(array.dtype.names, ("depth", "name", "valid"))
+        self.assertEqual(array["name"][1], "survey")
+        self.assertEqual(float(array["depth"][1]), 12.5)
+
+        del dataset #ensure dataset is deleted before tmpFile
+
     def testVRMetadata(self):
         tmpFile = testUtils.RandomFileGuard("name")
 
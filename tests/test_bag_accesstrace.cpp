@@ -0,0 +1,234 @@
+
+#include "test_utils.h"
+#include <bag_accesstrace.h>
+#include <bag_dataset.h>
+#include <bag_exceptions.h>
+#include <bag_metadata.h>
+#include <bag_simplelayer.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+using BAG::AccessKind;
+using BAG::AccessTrace;
+using BAG::Dataset;
+using BAG::ReplayCandidate;
+
+namespace {
+
+//! Make a trace of one layer, 100 nodes square of 4 byte floats in chunks 10
+//! nodes square.
+AccessTrace makeTrace(
+    const std::vector<BAG::AccessTraceRecord>& records)
+{
+    AccessTrace trace;
+
+    BAG::AccessTraceLayer layer;
+    layer.type = Elevation;
+    layer.name = "elevation";
+    layer.numRows = 100;
+    layer.numColumns = 100;
+    layer.elementSize = 4;
+    layer.chunkRows = 10;
+    layer.chunkColumns = 10;
+    trace.layers.push_back(layer);
+
+    trace.records = records;
+
+    return trace;
+}
+
+//! Make a record of an access of the first layer.
+BAG::AccessTraceRecord makeRecord(
+    AccessKind kind,
+    uint32_t rowStart,
+    uint32_t columnStart,
+    uint32_t rowEnd,
+    uint32_t columnEnd)
+{
+    BAG::AccessTraceRecord record;
+    record.kind = kind;
+    record.rowStart = rowStart;
+    record.columnStart = columnStart;
+    record.rowEnd = rowEnd;
+    record.columnEnd = columnEnd;
+
+    return record;
+}
+
+}  // namespace
+
+//  void startAccessTrace(const std::string& fileName);
+//  void stopAccessTrace();
+//  bool isTracingAccess() const noexcept;
+//  AccessTrace loadAccessTrace(const std::string& fileName);
+TEST_CASE("test access trace record", "[accesstrace][startAccessTrace][loadAccessTrace]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const TestUtils::RandomFileGuard traceFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromFile(std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.xml");
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 6);
+    REQUIRE(pDataset);
+    CHECK_FALSE(pDataset->isTracingAccess());
+
+    pDataset->startAccessTrace(traceFileName);
+    CHECK(pDataset->isTracingAccess());
+
+    auto& elevation = pDataset->getLayer(Elevation);
+    const std::vector<float> values(100, 1.5f);
+    elevation.write(0, 0, 9, 9, reinterpret_cast<const uint8_t*>(
+        values.data()));
+    elevation.read(5, 5, 24, 14);
+    pDataset->getLayer(Uncertainty).read(0, 0, 0, 99);
+
+    pDataset->stopAccessTrace();
+    CHECK_FALSE(pDataset->isTracingAccess());
+
+    // Accesses after the trace stopped are not recorded.
+    elevation.read(0, 0, 0, 0);
+
+    const auto trace = BAG::loadAccessTrace(traceFileName);
+
+    REQUIRE(trace.layers.size() == 2);
+    CHECK(trace.layers[0].type == Elevation);
+    CHECK(trace.layers[0].name == elevation.getDescriptor()->getName());
+    CHECK(trace.layers[0].numRows == 100);
+    CHECK(trace.layers[0].numColumns == 100);
+    CHECK(trace.layers[0].elementSize == 4);
+    CHECK(trace.layers[0].chunkRows == 10);
+    CHECK(trace.layers[0].chunkColumns == 10);
+    CHECK(trace.layers[1].type == Uncertainty);
+
+    REQUIRE(trace.records.size() == 3);
+    CHECK(trace.records[0].kind == AccessKind::Write);
+    CHECK(trace.records[0].layer == 0);
+    CHECK(trace.records[0].rowEnd == 9);
+    CHECK(trace.records[0].columnEnd == 9);
+
+    CHECK(trace.records[1].kind == AccessKind::Read);
+    CHECK(trace.records[1].layer == 0);
+    CHECK(trace.records[1].rowStart == 5);
+    CHECK(trace.records[1].columnStart == 5);
+    CHECK(trace.records[1].rowEnd == 24);
+    CHECK(trace.records[1].columnEnd == 14);
+    CHECK(trace.records[1].startNanoseconds >=
+        trace.records[0].startNanoseconds);
+
+    CHECK(trace.records[2].layer == 1);
+    CHECK(trace.records[2].columnEnd == 99);
+}
+
+//  AccessTrace loadAccessTrace(const std::string& fileName);
+TEST_CASE("test access trace invalid", "[accesstrace][loadAccessTrace]")
+{
+    const TestUtils::RandomFileGuard traceFileName;
+
+    UNSCOPED_INFO("Check a missing trace is invalid.");
+    REQUIRE_THROWS_AS(BAG::loadAccessTrace(traceFileName),
+        BAG::InvalidAccessTrace);
+
+    UNSCOPED_INFO("Check a file that is not a trace is invalid.");
+    {
+        std::ofstream file{traceFileName.m_fileName, std::ios::binary};
+        file << "This is not an access trace.";
+    }
+    REQUIRE_THROWS_AS(BAG::loadAccessTrace(traceFileName),
+        BAG::InvalidAccessTrace);
+}
+
+//  std::vector<ReplayResult> replayAccessTrace(const AccessTrace& trace,
+//      uint32_t layer, const std::vector<ReplayCandidate>& candidates);
+TEST_CASE("test access trace replay", "[accesstrace][replayAccessTrace]")
+{
+    // The same window of four chunks, twice.
+    const auto trace = makeTrace({makeRecord(AccessKind::Read, 0, 0, 19, 19),
+        makeRecord(AccessKind::Read, 0, 0, 19, 19)});
+
+    const auto results = BAG::replayAccessTrace(trace, 0,
+        {ReplayCandidate{10, 10, 0}, ReplayCandidate{10, 10, 400},
+        ReplayCandidate{0, 0, 0}, ReplayCandidate{20, 20, 0}});
+    REQUIRE(results.size() == 4);
+
+    UNSCOPED_INFO("Check the second read is from the cache.");
+    CHECK(results[0].numAccesses == 2);
+    CHECK(results[0].bytesRequested == 2 * 20 * 20 * 4);
+    CHECK(results[0].chunksDecoded == 4);
+    CHECK(results[0].bytesDecoded == 4 * 10 * 10 * 4);
+    CHECK(results[0].cacheHitRate == Catch::Approx(0.5));
+
+    UNSCOPED_INFO("Check a cache of one chunk decodes every chunk each read.");
+    CHECK(results[1].candidate.cacheSize == 400);
+    CHECK(results[1].chunksDecoded == 8);
+    CHECK(results[1].cacheHitRate == Catch::Approx(0.));
+
+    UNSCOPED_INFO("Check a contiguous layer reads exactly the windows.");
+    CHECK(results[2].chunksDecoded == 0);
+    CHECK(results[2].bytesDecoded == 2 * 20 * 20 * 4);
+
+    UNSCOPED_INFO("Check a chunk matching the window is decoded once.");
+    CHECK(results[3].chunksDecoded == 1);
+
+    UNSCOPED_INFO("Check writes of whole chunks decode nothing.");
+    {
+        const auto writes = makeTrace({
+            makeRecord(AccessKind::Write, 0, 0, 9, 19),
+            makeRecord(AccessKind::Write, 95, 0, 99, 4)});
+
+        const auto written = BAG::replayAccessTrace(writes, 0,
+            {ReplayCandidate{10, 10, 0}});
+        REQUIRE(written.size() == 1);
+        CHECK(written[0].chunksDecoded == 1);
+    }
+
+    UNSCOPED_INFO("Check a layer not in the trace is rejected.");
+    REQUIRE_THROWS_AS(BAG::replayAccessTrace(trace, 1, {}),
+        BAG::LayerNotFound);
+}
+
+//  LayoutRecommendation recommendLayout(const AccessTrace& trace,
+//      uint32_t layer);
+TEST_CASE("test access trace recommend layout", "[accesstrace][recommendLayout]")
+{
+    // Every row, a row at a time.
+    std::vector<BAG::AccessTraceRecord> records;
+    for (uint32_t row=0; row<100; ++row)
+        records.push_back(makeRecord(AccessKind::Read, row, 0, row, 99));
+
+    const auto trace = makeTrace(records);
+
+    const auto recommendation = BAG::recommendLayout(trace, 0);
+
+    CHECK(recommendation.layer == 0);
+    CHECK(recommendation.traced.candidate.chunkRows == 10);
+    CHECK(recommendation.traced.candidate.chunkColumns == 10);
+    CHECK(recommendation.traced.chunksDecoded == 100);
+
+    UNSCOPED_INFO("Check the recommendation decodes fewer chunks.");
+    CHECK(recommendation.chunkShape.layout == BAG::ChunkLayout::Tiled);
+    CHECK(recommendation.chunkShape.rows > 0);
+    CHECK(recommendation.chunkShape.columns >= 100);
+    CHECK(recommendation.estimate.numAccesses == 100);
+    CHECK(recommendation.estimate.chunksDecoded <
+        recommendation.traced.chunksDecoded);
+
+    UNSCOPED_INFO("Check the smallest cache is enough.");
+    CHECK(recommendation.chunkCache.size == 1024 * 1024);
+    CHECK(recommendation.chunkCache.slots >= 521);
+
+    UNSCOPED_INFO("Check a layer without accesses keeps its chunk shape.");
+    {
+        const auto unused = BAG::recommendLayout(makeTrace({}), 0);
+        CHECK(unused.chunkShape.rows == 10);
+        CHECK(unused.chunkShape.columns == 10);
+        CHECK(unused.estimate.numAccesses == 0);
+    }
+}
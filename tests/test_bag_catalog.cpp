@@ -0,0 +1,164 @@
+
+#include "test_utils.h"
+#include <bag_catalog.h>
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+using BAG::Catalog;
+using BAG::CatalogEntry;
+using BAG::Dataset;
+
+namespace {
+
+//! Find the entry of a file in a catalog.
+const CatalogEntry* findEntry(
+    const Catalog& catalog,
+    const std::string& fileName)
+{
+    const auto& entries = catalog.getEntries();
+    const auto found = std::find_if(entries.begin(), entries.end(),
+        [&fileName](const CatalogEntry& entry) {
+            return entry.fileName == fileName;
+        });
+
+    return found == entries.end() ? nullptr : &*found;
+}
+
+}  // namespace
+
+//  explicit Catalog(const std::vector<std::string>& roots,
+//      const CatalogOptions& options = {});
+//  static Catalog read(const std::string& fileName);
+//  void write(const std::string& fileName) const;
+//  size_t refresh(const CatalogOptions& options = {});
+//  std::vector<const CatalogEntry*> query(double minX, double minY,
+//      double maxX, double maxY,
+//      const std::string& referenceSystem = {}) const;
+TEST_CASE("test catalog", "[catalog][constructor][read][write][refresh][query]")
+{
+    const std::string samplesPath{std::getenv("BAG_SAMPLES_PATH")};
+    const std::string bagFileName{samplesPath + "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+    const auto& descriptor = pDataset->getDescriptor();
+
+    double minX = 0., minY = 0., maxX = 0., maxY = 0.;
+    std::tie(minX, minY, maxX, maxY) = descriptor.getProjectedCover();
+
+    SECTION("crawl a directory")
+    {
+        const Catalog catalog{{samplesPath}};
+
+        // The sample data holds several BAGs, and other files.
+        CHECK(catalog.getEntries().size() > 1);
+        CHECK(catalog.getRoots() == std::vector<std::string>{samplesPath});
+
+        const auto* pEntry = findEntry(catalog, bagFileName);
+        REQUIRE(pEntry);
+        CHECK(std::make_tuple(pEntry->rows, pEntry->columns) ==
+            descriptor.getDims());
+        CHECK(std::make_tuple(pEntry->minX, pEntry->minY, pEntry->maxX,
+            pEntry->maxY) == descriptor.getProjectedCover());
+        CHECK_FALSE(pEntry->isVR);
+        CHECK(pEntry->layerTypes == pDataset->getLayerTypes());
+        CHECK(catalog.getReferenceSystems()[pEntry->referenceSystem] ==
+            descriptor.getHorizontalReferenceSystem());
+        CHECK(pEntry->fileSize > 0);
+    }
+
+    SECTION("query")
+    {
+        const Catalog catalog{{bagFileName}};
+        REQUIRE(catalog.getEntries().size() == 1);
+
+        const auto centreX = (minX + maxX) / 2.;
+        const auto centreY = (minY + maxY) / 2.;
+
+        const auto found = catalog.query(centreX, centreY, centreX, centreY);
+        REQUIRE(found.size() == 1);
+        CHECK(found[0]->fileName == bagFileName);
+
+        CHECK(catalog.query(centreX, centreY, centreX, centreY,
+            descriptor.getHorizontalReferenceSystem()).size() == 1);
+        CHECK(catalog.query(centreX, centreY, centreX, centreY,
+            "an unknown reference system").empty());
+        CHECK(catalog.query(maxX + 1., maxY + 1., maxX + 2., maxY + 2.)
+            .empty());
+    }
+
+    SECTION("write and read")
+    {
+        const Catalog catalog{{samplesPath}};
+
+        const TestUtils::RandomFileGuard tmpCatalogFile;
+        catalog.write(tmpCatalogFile);
+
+        const auto readCatalog = Catalog::read(tmpCatalogFile);
+        CHECK(readCatalog.getRoots() == catalog.getRoots());
+        CHECK(readCatalog.getReferenceSystems() ==
+            catalog.getReferenceSystems());
+        REQUIRE(readCatalog.getEntries().size() ==
+            catalog.getEntries().size());
+
+        for (size_t index=0; index<catalog.getEntries().size(); ++index)
+        {
+            const auto& expected = catalog.getEntries()[index];
+            const auto& entry = readCatalog.getEntries()[index];
+
+            CHECK(entry.fileName == expected.fileName);
+            CHECK(entry.fileSize == expected.fileSize);
+            CHECK(entry.modified == expected.modified);
+            CHECK(entry.rows == expected.rows);
+            CHECK(entry.columns == expected.columns);
+            CHECK(entry.minX == expected.minX);
+            CHECK(entry.maxY == expected.maxY);
+            CHECK(entry.isVR == expected.isVR);
+            CHECK(entry.layerTypes.size() == expected.layerTypes.size());
+            CHECK(entry.referenceSystem == expected.referenceSystem);
+        }
+
+        CHECK(readCatalog.query(minX, minY, maxX, maxY).size() ==
+            catalog.query(minX, minY, maxX, maxY).size());
+    }
+
+    SECTION("refresh")
+    {
+        // The BAG does not exist when the catalog is built.
+        const TestUtils::RandomFileGuard tmpBagFile;
+
+        Catalog catalog{{tmpBagFile}};
+        CHECK(catalog.getEntries().empty());
+
+        BAG::copyDataset(*pDataset, tmpBagFile);
+
+        CHECK(catalog.refresh() == 1);
+        REQUIRE(catalog.getEntries().size() == 1);
+        CHECK(catalog.getEntries()[0].fileName ==
+            static_cast<const std::string&>(tmpBagFile));
+
+        // Nothing changed.
+        CHECK(catalog.refresh() == 0);
+        CHECK(catalog.getEntries().size() == 1);
+        CHECK(catalog.query(minX, minY, maxX, maxY).size() == 1);
+    }
+
+    SECTION("read a file that is not a catalog")
+    {
+        CHECK_THROWS_AS(Catalog::read(bagFileName), BAG::CatalogReadFailed);
+
+        const TestUtils::RandomFileGuard tmpCatalogFile;
+        CHECK_THROWS_AS(Catalog::read(tmpCatalogFile), BAG::CatalogReadFailed);
+    }
+}
+
@@ -114,6 +114,34 @@ TEST_CASE("test compound data type assignment operators",
     }
 }
 
+TEST_CASE("test compound data type copy and move",
+    "[compounddatatype][constructor][assignment]")
+{
+    UNSCOPED_INFO("Check moving keeps the type and value.");
+    CompoundDataType source{std::string{"moved"}};
+    const CompoundDataType moved{std::move(source)};
+    CHECK(moved.getType() == DT_STRING);
+    CHECK(moved.asString() == "moved");
+
+    const CompoundDataType number{42u};
+    const CompoundDataType movedNumber{CompoundDataType{number}};
+    CHECK(movedNumber == number);
+
+    UNSCOPED_INFO("Check assigning a string to a string replaces it.");
+    CompoundDataType target{std::string{"before"}};
+    const CompoundDataType other{std::string{"after"}};
+    target = other;
+    CHECK(target.asString() == "after");
+
+    target = CompoundDataType{std::string{"moved again"}};
+    CHECK(target.asString() == "moved again");
+
+    UNSCOPED_INFO("Check assigning a number over a string changes the type.");
+    target = number;
+    CHECK(target.getType() == DT_UINT32);
+    CHECK(target.asUInt32() == 42u);
+}
+
 TEST_CASE("test compound data type invalid cases",
     "[compounddatatype][constructor][getType][get]")
 {
@@ -0,0 +1,208 @@
+
+#include "test_utils.h"
+#include <bag_contour.h>
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_simplelayer.h>
+
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+using BAG::ContourLine;
+using BAG::ContourOptions;
+using BAG::Dataset;
+
+//  void traceContours(const SimpleLayer& layer,
+//      const ContourOptions& options, const ContourCallback& callback);
+TEST_CASE("test trace contours", "[contour][traceContours]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    // A copy in small chunks, so the lines cross many tiles and bands.
+    BAG::CopyOptions copyOptions;
+    copyOptions.rechunk = true;
+    copyOptions.chunkShape.rows = 8;
+    copyOptions.chunkShape.columns = 8;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+    const auto pDataset = BAG::copyDataset(*pSource, tmpFileName,
+        copyOptions);
+    REQUIRE(pDataset);
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = descriptor.getDims();
+    REQUIRE(numRows > 32);
+    REQUIRE(numColumns > 32);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+    auto& elevation = *pDataset->getSimpleLayer(Elevation);
+
+    // Write the elevations, a function of the column and row.
+    const auto writeSurface = [&](float (*surface)(uint32_t, uint32_t)) {
+        std::vector<float> elevations(static_cast<size_t>(numRows) *
+            numColumns);
+        for (uint32_t row=0; row<numRows; ++row)
+            for (uint32_t column=0; column<numColumns; ++column)
+                elevations[static_cast<size_t>(row) * numColumns + column] =
+                    surface(column, row);
+
+        elevation.write(0, 0, numRows - 1, numColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+    };
+
+    std::vector<ContourLine> lines;
+    const auto collect = [&lines](const ContourLine& line) {
+        lines.push_back(line);
+    };
+
+    ContourOptions options;
+
+    SECTION("a plane")
+    {
+        // Rising east, one metre a column.
+        writeSurface([](uint32_t column, uint32_t) {
+            return static_cast<float>(column);
+        });
+
+        options.interval = 5.;
+        options.base = 2.5;
+        BAG::traceContours(elevation, options, collect);
+
+        UNSCOPED_INFO("Check each level is one line, stitched across bands.");
+        const auto numLevels = static_cast<size_t>(
+            (numColumns - 1 - 2.5) / 5.) + 1;
+        REQUIRE(lines.size() == numLevels);
+
+        for (size_t i=0; i<lines.size(); ++i)
+        {
+            const auto& line = lines[i];
+            CHECK(line.level == Catch::Approx(2.5 + 5. * i));
+            CHECK_FALSE(line.closed);
+            REQUIRE(line.points.size() == numRows);
+
+            const auto x = originX + line.level * columnSpacing;
+            uint32_t numWrong = 0;
+            for (size_t point=0; point<line.points.size(); ++point)
+            {
+                numWrong += !(line.points[point].x == Catch::Approx(x));
+
+                // Higher ground, east, on the right: the line runs north.
+                numWrong += !(line.points[point].y == Catch::Approx(originY +
+                    point * rowSpacing));
+            }
+            CHECK(numWrong == 0);
+        }
+    }
+
+    SECTION("a cone")
+    {
+        // Rising with the distance, in nodes, from node (16, 16).
+        writeSurface([](uint32_t column, uint32_t row) {
+            return static_cast<float>(std::hypot(column - 16., row - 16.));
+        });
+
+        options.levels = {10.5, 3.5, 6.5, 3.5};
+        BAG::traceContours(elevation, options, collect);
+
+        UNSCOPED_INFO("Check each level is a ring around the apex.");
+        REQUIRE(lines.size() == 3);
+
+        std::vector<double> levels;
+        for (const auto& line : lines)
+        {
+            levels.push_back(line.level);
+            CHECK(line.closed);
+            REQUIRE(line.points.size() > 4);
+            CHECK(line.points.front().x == line.points.back().x);
+            CHECK(line.points.front().y == line.points.back().y);
+
+            // Linear interpolation cuts the corners of the circle.
+            uint32_t numWrong = 0;
+            double area = 0.;
+            for (size_t i=0; i<line.points.size(); ++i)
+            {
+                const auto column = (line.points[i].x - originX) /
+                    columnSpacing;
+                const auto row = (line.points[i].y - originY) / rowSpacing;
+                const auto radius = std::hypot(column - 16., row - 16.);
+                numWrong += radius > line.level + 1e-6 ||
+                    radius < line.level - 0.1;
+
+                if (i > 0)
+                    area += line.points[i - 1].x * line.points[i].y -
+                        line.points[i].x * line.points[i - 1].y;
+            }
+            CHECK(numWrong == 0);
+
+            // Higher ground, outside, on the right: the ring is
+            // counterclockwise.
+            CHECK(area > 0.);
+        }
+
+        std::sort(levels.begin(), levels.end());
+        CHECK(levels == std::vector<double>{3.5, 6.5, 10.5});
+    }
+
+    SECTION("null nodes")
+    {
+        writeSurface([](uint32_t column, uint32_t) {
+            return static_cast<float>(column);
+        });
+
+        // A null and a NaN on the line of level 10.5.
+        const float nullValue = BAG_NULL_ELEVATION;
+        elevation.write(12, 10, 12, 10,
+            reinterpret_cast<const uint8_t*>(&nullValue));
+        const float nan = std::nanf("");
+        elevation.write(20, 11, 20, 11,
+            reinterpret_cast<const uint8_t*>(&nan));
+
+        options.levels = {10.5};
+        BAG::traceContours(elevation, options, collect);
+
+        UNSCOPED_INFO("Check the line is broken around the nulls.");
+        REQUIRE(lines.size() == 3);
+
+        size_t numPoints = 0;
+        for (const auto& line : lines)
+        {
+            CHECK_FALSE(line.closed);
+            numPoints += line.points.size();
+        }
+
+        // The line crosses every row but those of the nulls.
+        CHECK(numPoints == numRows - 2);
+    }
+
+    SECTION("invalid levels")
+    {
+        REQUIRE_THROWS_AS(BAG::traceContours(elevation, options, collect),
+            BAG::InvalidContourLevels);
+
+        options.interval = -1.;
+        REQUIRE_THROWS_AS(BAG::traceContours(elevation, options, collect),
+            BAG::InvalidContourLevels);
+
+        options.levels = {1., std::nan("")};
+        REQUIRE_THROWS_AS(BAG::traceContours(elevation, options, collect),
+            BAG::InvalidContourLevels);
+    }
+}
@@ -0,0 +1,383 @@
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_layer.h>
+#include <bag_layerdescriptor.h>
+#include <bag_metadata.h>
+#include <bag_simplelayer.h>
+#include <bag_trackinglist.h>
+#include <bag_vrcelliterator.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrnode.h>
+#include <bag_vrrefinements.h>
+
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::CopyOptions;
+
+namespace {
+
+//! Check the nodes of a window of a layer of the source match a copy.
+void checkWindow(
+    const Dataset& source,
+    const Dataset& copy,
+    BAG::LayerType type,
+    uint32_t rowStart,
+    uint32_t columnStart)
+{
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = copy.getDescriptor().getDims();
+
+    const auto expected = source.getLayer(type).read(rowStart, columnStart,
+        rowStart + numRows - 1, columnStart + numColumns - 1);
+    const auto actual = copy.getLayer(type).read(0, 0, numRows - 1,
+        numColumns - 1);
+
+    REQUIRE(expected.size() == actual.size());
+    CHECK(std::equal(expected.data(), expected.data() + expected.size(),
+        actual.data()));
+}
+
+}  // namespace
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset rechunk recompress", "[copy][copyDataset]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    CopyOptions options;
+    options.rechunk = true;
+    options.chunkShape.rows = 8;
+    options.chunkShape.columns = 16;
+    options.recompress = true;
+    options.compression = 9;
+
+    UNSCOPED_INFO("Copy the whole BAG into new chunks and compression.");
+    {
+        const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+        REQUIRE(pCopy);
+    }
+
+    const auto pCopy = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pCopy);
+
+    const auto& descriptor = pCopy->getDescriptor();
+    CHECK(descriptor.getDims() == pSource->getDescriptor().getDims());
+    CHECK(descriptor.getOrigin() == pSource->getDescriptor().getOrigin());
+    CHECK(descriptor.getGridSpacing() ==
+        pSource->getDescriptor().getGridSpacing());
+
+    for (const auto type : {Elevation, Uncertainty})
+    {
+        const auto& layerDescriptor = *pCopy->getLayer(type).getDescriptor();
+        CHECK(layerDescriptor.getChunkDims() ==
+            std::make_tuple(uint64_t{8}, uint64_t{16}));
+        CHECK(layerDescriptor.getCompressionLevel() == 9);
+
+        checkWindow(*pSource, *pCopy, type, 0, 0);
+    }
+
+    CHECK(pCopy->getTrackingList().size() ==
+        pSource->getTrackingList().size());
+}
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset window", "[copy][copyDataset]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    constexpr uint32_t kRowStart = 2;
+    constexpr uint32_t kColumnStart = 3;
+    constexpr uint32_t kRowEnd = 6;
+    constexpr uint32_t kColumnEnd = 9;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    CopyOptions options;
+    options.rowStart = kRowStart;
+    options.columnStart = kColumnStart;
+    options.rowEnd = kRowEnd;
+    options.columnEnd = kColumnEnd;
+
+    UNSCOPED_INFO("Copy a window of the grid.");
+    {
+        const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+        REQUIRE(pCopy);
+    }
+
+    const auto pCopy = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pCopy);
+
+    const auto& descriptor = pCopy->getDescriptor();
+    CHECK(descriptor.getDims() == std::make_tuple(kRowEnd - kRowStart + 1,
+        kColumnEnd - kColumnStart + 1));
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    const auto& metadata = pSource->getMetadata();
+    CHECK(originX == Catch::Approx(metadata.llCornerX() +
+        kColumnStart * metadata.columnResolution()));
+    CHECK(originY == Catch::Approx(metadata.llCornerY() +
+        kRowStart * metadata.rowResolution()));
+
+    checkWindow(*pSource, *pCopy, Elevation, kRowStart, kColumnStart);
+    checkWindow(*pSource, *pCopy, Uncertainty, kRowStart, kColumnStart);
+
+    UNSCOPED_INFO("Only the tracking list items in the window are copied.");
+    const auto& trackingList = pCopy->getTrackingList();
+    CHECK(trackingList.size() == pSource->getTrackingList().getItemsInWindow(
+        kRowStart, kColumnStart, kRowEnd, kColumnEnd).size());
+    for (const auto& item : trackingList)
+    {
+        CHECK(item.row <= kRowEnd - kRowStart);
+        CHECK(item.col <= kColumnEnd - kColumnStart);
+    }
+}
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset geo window", "[copy][copyDataset]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    // Rows 1 to 5, and columns 4 to 10.
+    const auto& metadata = pSource->getMetadata();
+    const auto minX = metadata.llCornerX() + 4 * metadata.columnResolution();
+    const auto minY = metadata.llCornerY() + 1 * metadata.rowResolution();
+    const auto maxX = metadata.llCornerX() + 10 * metadata.columnResolution();
+    const auto maxY = metadata.llCornerY() + 5 * metadata.rowResolution();
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    CopyOptions options;
+    options.useGeoWindow = true;
+    options.minX = minX;
+    options.minY = minY;
+    options.maxX = maxX;
+    options.maxY = maxY;
+
+    UNSCOPED_INFO("Copy the nodes inside a box.");
+    {
+        const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+        REQUIRE(pCopy);
+    }
+
+    const auto pCopy = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pCopy);
+
+    CHECK(pCopy->getDescriptor().getDims() == std::make_tuple(5u, 7u));
+    checkWindow(*pSource, *pCopy, Elevation, 1, 4);
+
+    UNSCOPED_INFO("A box outside the grid covers no nodes.");
+    const TestUtils::RandomFileGuard outsideFileName;
+    options.minX = maxX + 1e6;
+    options.maxX = maxX + 2e6;
+    REQUIRE_THROWS_AS(BAG::copyDataset(*pSource, outsideFileName, options),
+        BAG::InvalidCopyWindow);
+
+    UNSCOPED_INFO("A window outside the grid covers no nodes.");
+    CopyOptions windowOptions;
+    windowOptions.rowStart = std::get<0>(pSource->getDescriptor().getDims());
+    REQUIRE_THROWS_AS(BAG::copyDataset(*pSource, outsideFileName,
+        windowOptions), BAG::InvalidCopyWindow);
+}
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset splits legacy groups", "[copy][copyDataset]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/example_w_qc_layers.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    constexpr uint32_t kRowStart = 200;
+    constexpr uint32_t kColumnStart = 300;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    CopyOptions options;
+    options.rowStart = kRowStart;
+    options.columnStart = kColumnStart;
+    options.rowEnd = 499;
+    options.columnEnd = 449;
+
+    UNSCOPED_INFO("Copy the interleaved node and elevation solution groups.");
+    {
+        const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+        REQUIRE(pCopy);
+    }
+
+    const auto pCopy = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pCopy);
+
+    for (const auto type : {Hypothesis_Strength, Num_Hypotheses,
+        Shoal_Elevation, Std_Dev, Num_Soundings})
+    {
+        UNSCOPED_INFO("Each field is a simple layer of the copy.");
+        const auto pLayer = pCopy->getSimpleLayer(type);
+        REQUIRE(pLayer);
+        CHECK(pLayer->getDescriptor()->getChunkDims() ==
+            pCopy->getSimpleLayer(Elevation)->getDescriptor()->getChunkDims());
+
+        checkWindow(*pSource, *pCopy, type, kRowStart, kColumnStart);
+    }
+
+    UNSCOPED_INFO("The min/max of a split layer is found as it is written.");
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) =
+        pCopy->getSimpleLayer(Shoal_Elevation)->getDescriptor()->getMinMax();
+    CHECK(min <= max);
+    CHECK(max < BAG_NULL_ELEVATION);
+}
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset refinement order", "[copy][copyDataset][VRRefinementOrder]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSample = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSample);
+
+    // A variable resolution BAG of 10 by 10 supergrid cells.
+    const TestUtils::RandomFileGuard tmpSourceFileName;
+
+    CopyOptions windowOptions;
+    windowOptions.rowEnd = 9;
+    windowOptions.columnEnd = 9;
+
+    const auto pSource = BAG::copyDataset(*pSample, tmpSourceFileName,
+        windowOptions);
+    REQUIRE(pSource);
+    pSource->createVR(100, 5, true);
+
+    // Six cells of two refinements each, stored out of order with gaps.
+    // Refinements and nodes hold their own index.
+    const std::vector<std::pair<uint32_t, uint32_t>> kCells{{0, 0}, {0, 1},
+        {0, 2}, {1, 0}, {1, 1}, {5, 5}};
+    const std::vector<uint32_t> kSourceIndices{20, 0, 24, 10, 4, 14};
+    constexpr uint32_t kNumRefinements = 26;
+
+    std::vector<BAG::VRRefinementsItem> refinements(kNumRefinements);
+    std::vector<BAG::VRNodeItem> nodes(kNumRefinements);
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+    {
+        refinements[i] = {static_cast<float>(i), 0.5f};
+        nodes[i] = {1.f, 1, i};
+    }
+
+    pSource->getVRRefinements()->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(refinements.data()));
+    pSource->getVRNode()->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(nodes.data()));
+
+    std::vector<BAG::VRMetadataItem> items(10 * 10, BAG::VRMetadataItem{});
+    for (size_t i=0; i<kCells.size(); ++i)
+        items[kCells[i].first * 10 + kCells[i].second] =
+            {kSourceIndices[i], 1, 2, 1.f, 1.f, 0.f, 0.f};
+
+    pSource->getVRMetadata()->write(0, 0, 9, 9,
+        reinterpret_cast<const uint8_t*>(items.data()));
+
+    // Copy, and walk the cells of the copy in the order of their
+    // refinements.
+    const auto copyCells = [&](BAG::VRRefinementOrder order) {
+        const TestUtils::RandomFileGuard tmpFileName;
+
+        CopyOptions options;
+        options.refinementOrder = order;
+        const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+        REQUIRE(pCopy);
+
+        std::vector<std::pair<uint32_t, uint32_t>> cells;
+        uint32_t next = 0;
+
+        BAG::VRCellIterator iterator{*pCopy};
+        BAG::VRCell cell;
+        while (iterator.next(cell))
+        {
+            UNSCOPED_INFO("Check the refinements are packed, without gaps.");
+            CHECK(cell.metadata->index == next);
+            REQUIRE(cell.count == 2);
+            next += cell.count;
+
+            const auto expected = kSourceIndices[std::find(kCells.begin(),
+                kCells.end(), std::make_pair(cell.row, cell.column)) -
+                kCells.begin()];
+            REQUIRE(cell.nodes);
+            for (uint32_t i=0; i<cell.count; ++i)
+            {
+                CHECK(cell.refinements[i].depth ==
+                    static_cast<float>(expected + i));
+                CHECK(cell.nodes[i].n_samples == expected + i);
+            }
+
+            cells.emplace_back(cell.row, cell.column);
+        }
+
+        CHECK(next == 12);
+
+        return cells;
+    };
+
+    SECTION("row major")
+    {
+        CHECK(copyCells(BAG::VRRefinementOrder::RowMajor) == kCells);
+    }
+
+    SECTION("morton")
+    {
+        const std::vector<std::pair<uint32_t, uint32_t>> expected{{0, 0},
+            {0, 1}, {1, 0}, {1, 1}, {0, 2}, {5, 5}};
+        CHECK(copyCells(BAG::VRRefinementOrder::Morton) == expected);
+    }
+
+    SECTION("hilbert")
+    {
+        const auto cells = copyCells(BAG::VRRefinementOrder::Hilbert);
+        REQUIRE(cells.size() == kCells.size());
+
+        UNSCOPED_INFO("Check the cells of the block at the origin come first, "
+            "each next to the one before.");
+        CHECK(cells[0] == std::make_pair(0u, 0u));
+        for (size_t i=1; i<4; ++i)
+        {
+            CHECK(cells[i].first <= 1);
+            CHECK(cells[i].second <= 1);
+            const auto distance =
+                std::max(cells[i].first, cells[i - 1].first) -
+                std::min(cells[i].first, cells[i - 1].first) +
+                std::max(cells[i].second, cells[i - 1].second) -
+                std::min(cells[i].second, cells[i - 1].second);
+            CHECK(distance == 1);
+        }
+    }
+}
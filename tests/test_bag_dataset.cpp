@@ -1,10 +1,26 @@
 
 #include "test_utils.h"
+#include <bag_copy.h>
 #include <bag_dataset.h>
-
+#include <bag_memorybudget.h>
+#include <bag_simplelayer.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrmetadatadescriptor.h>
+#include <bag_vrnode.h>
+#include <bag_vrnodedescriptor.h>
+#include <bag_vrrefinements.h>
+#include <bag_vrrefinementsdescriptor.h>
+
+#include <algorithm>
+#include <array>
 #include <catch2/catch_all.hpp>
 #include <cstdlib>  // std::getenv
+#include <cstring>  // std::memcmp
+#include <H5Cpp.h>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 
 using Catch::Approx;
@@ -360,6 +376,164 @@ TEST_CASE("test dataset reading", "[dataset][open][getLayerTypes][createLayer]")
     }
 }
 
+//  static std::shared_ptr<Dataset> open(const std::string &fileName,
+//      OpenMode openMode, const OpenOptions& options);
+TEST_CASE("test dataset reading with open options", "[dataset][open][OpenOptions]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.chunkCache.size = 16 * 1024 * 1024;
+    options.chunkCache.slots = 10007;
+    options.chunkCache.preemption = 1.0;
+    options.layerChunkCaches[Uncertainty].size = 4 * 1024 * 1024;
+
+    const auto defaultDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(defaultDataset);
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+    REQUIRE(dataset);
+
+    CHECK(dataset->getLayerTypes() == defaultDataset->getLayerTypes());
+
+    UNSCOPED_INFO("Check the cache settings do not change what is read.");
+    for (const auto type : {Elevation, Uncertainty})
+    {
+        const auto expected = defaultDataset->getLayer(type).read(0, 0, 9, 9);
+        const auto actual = dataset->getLayer(type).read(0, 0, 9, 9);
+        REQUIRE(expected.size() == actual.size());
+
+        CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+    }
+}
+
+TEST_CASE("test dataset layer chunk caches", "[dataset][open][OpenOptions]")
+{
+    const std::string samplesPath{std::getenv("BAG_SAMPLES_PATH")};
+
+    UNSCOPED_INFO("Check an interleaved legacy layer is opened with its chunk cache.");
+    {
+        const std::string bagFileName{samplesPath + "/example_w_qc_layers.bag"};
+
+        BAG::OpenOptions options;
+        options.layerChunkCaches[Hypothesis_Strength].size = 4 * 1024 * 1024;
+
+        const auto defaultDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(defaultDataset);
+
+        const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+        REQUIRE(dataset);
+
+        const auto expected =
+            defaultDataset->getLayer(Hypothesis_Strength).read(240, 330, 250, 345);
+        const auto actual =
+            dataset->getLayer(Hypothesis_Strength).read(240, 330, 250, 345);
+        REQUIRE(expected.size() == actual.size());
+
+        CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+    }
+
+    UNSCOPED_INFO("Check a georeferenced metadata layer is opened with its chunk cache.");
+    {
+        const std::string bagFileName{samplesPath + "/bag_georefmetadata_layer.bag"};
+
+        BAG::OpenOptions options;
+        options.layerChunkCaches[Georef_Metadata].size = 4 * 1024 * 1024;
+
+        const auto defaultDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(defaultDataset);
+
+        const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+        REQUIRE(dataset);
+
+        const auto expectedLayers = defaultDataset->getGeorefMetadataLayers();
+        const auto layers = dataset->getGeorefMetadataLayers();
+        REQUIRE(layers.size() == expectedLayers.size());
+        REQUIRE_FALSE(layers.empty());
+
+        const auto expected = expectedLayers.front()->read(0, 0, 9, 9);
+        const auto actual = layers.front()->read(0, 0, 9, 9);
+        REQUIRE(expected.size() == actual.size());
+
+        CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+    }
+}
+
+TEST_CASE("test dataset lazy reading", "[dataset][open][OpenOptions][lazy]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.lazy = true;
+
+    const auto eagerDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(eagerDataset);
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+    REQUIRE(dataset);
+
+    UNSCOPED_INFO("Check the layers are discovered without being opened.");
+    CHECK(dataset->getLayerTypes() == eagerDataset->getLayerTypes());
+    CHECK(dataset->getDescriptor().getLayerIds() ==
+        eagerDataset->getDescriptor().getLayerIds());
+
+    UNSCOPED_INFO("Check a layer is opened on first access.");
+    const auto pElevation = dataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+    CHECK(pElevation == dataset->getSimpleLayer(Elevation));
+    CHECK(pElevation->getDescriptor()->getMinMax() ==
+        eagerDataset->getSimpleLayer(Elevation)->getDescriptor()->getMinMax());
+
+    const auto expected = eagerDataset->getLayer(Elevation).read(0, 0, 9, 9);
+    const auto actual = pElevation->read(0, 0, 9, 9);
+    REQUIRE(expected.size() == actual.size());
+    CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+
+    UNSCOPED_INFO("Check a georeferenced metadata layer is never simple.");
+    CHECK_FALSE(dataset->getSimpleLayer(Georef_Metadata));
+
+    UNSCOPED_INFO("Check the remaining layers can be opened.");
+    CHECK(dataset->getSurfaceCorrections());
+    CHECK(dataset->getLayers().size() == eagerDataset->getLayers().size());
+}
+
+TEST_CASE("test dataset deferred metadata", "[dataset][open][OpenOptions][metadata]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.deferMetadata = true;
+
+    const auto eagerDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(eagerDataset);
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+    REQUIRE(dataset);
+
+    UNSCOPED_INFO("Check the descriptor is read without the full metadata.");
+    const auto& descriptor = dataset->getDescriptor();
+    const auto& eagerDescriptor = eagerDataset->getDescriptor();
+    CHECK(descriptor.getDims() == eagerDescriptor.getDims());
+    CHECK(descriptor.getOrigin() == eagerDescriptor.getOrigin());
+    CHECK(descriptor.getGridSpacing() == eagerDescriptor.getGridSpacing());
+    CHECK(descriptor.getProjectedCover() == eagerDescriptor.getProjectedCover());
+    CHECK(descriptor.getHorizontalReferenceSystem() ==
+        eagerDescriptor.getHorizontalReferenceSystem());
+    CHECK(descriptor.getVerticalReferenceSystem() ==
+        eagerDescriptor.getVerticalReferenceSystem());
+    CHECK(dataset->gridToGeo(10, 20) == eagerDataset->gridToGeo(10, 20));
+
+    UNSCOPED_INFO("Check the metadata is parsed when it is first retrieved.");
+    const auto& metadata = dataset->getMetadata();
+    CHECK(&metadata == &dataset->getMetadata());
+    CHECK(metadata.getXMLlength() == eagerDataset->getMetadata().getXMLlength());
+    CHECK(std::string{metadata.getStruct().fileIdentifier} ==
+        eagerDataset->getMetadata().getStruct().fileIdentifier);
+}
+
 //  static std::shared_ptr<Dataset> create(const std::string &fileName,
 //      const Metadata& metadata);
 TEST_CASE("test dataset creation", "[dataset][create][getLayerTypes][open]")
@@ -579,3 +753,1097 @@ TEST_CASE("test get descriptor", "[dataset][getDescriptor]")
 
     CHECK(descriptor.isReadOnly() == false);
 }
+
+//  UInt8Array readLayers(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd,
+//      const std::vector<LayerType>& types, LayerLayout layout) const;
+TEST_CASE("test dataset read layers", "[dataset][readLayers]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    // Write a 2x3 window to both mandatory layers.
+    constexpr uint32_t kRowStart = 10, kColumnStart = 20;
+    constexpr uint32_t kRowEnd = 11, kColumnEnd = 22;
+    constexpr size_t kNumNodes = 6;
+
+    const std::array<float, kNumNodes> elevations{1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    const std::array<float, kNumNodes> uncertainties{.1f, .2f, .3f, .4f, .5f, .6f};
+
+    pDataset->getLayer(Elevation).write(kRowStart, kColumnStart, kRowEnd,
+        kColumnEnd, reinterpret_cast<const uint8_t*>(elevations.data()));
+    pDataset->getLayer(Uncertainty).write(kRowStart, kColumnStart, kRowEnd,
+        kColumnEnd, reinterpret_cast<const uint8_t*>(uncertainties.data()));
+
+    SECTION("planar")
+    {
+        const auto buffer = pDataset->readLayers(kRowStart, kColumnStart,
+            kRowEnd, kColumnEnd, {Uncertainty, Elevation}, BAG_LAYOUT_PLANAR);
+        REQUIRE(buffer.size() == kNumNodes * 2 * sizeof(float));
+
+        const auto* values = reinterpret_cast<const float*>(buffer.data());
+        for (size_t i=0; i<kNumNodes; ++i)
+        {
+            CHECK(values[i] == uncertainties[i]);
+            CHECK(values[kNumNodes + i] == elevations[i]);
+        }
+    }
+
+    SECTION("interleaved")
+    {
+        const auto buffer = pDataset->readLayers(kRowStart, kColumnStart,
+            kRowEnd, kColumnEnd, {Elevation, Uncertainty},
+            BAG_LAYOUT_INTERLEAVED);
+        REQUIRE(buffer.size() == kNumNodes * 2 * sizeof(float));
+
+        const auto* values = reinterpret_cast<const float*>(buffer.data());
+        for (size_t i=0; i<kNumNodes; ++i)
+        {
+            CHECK(values[i * 2] == elevations[i]);
+            CHECK(values[i * 2 + 1] == uncertainties[i]);
+        }
+    }
+
+    SECTION("missing layer")
+    {
+        REQUIRE_THROWS_AS(pDataset->readLayers(kRowStart, kColumnStart,
+            kRowEnd, kColumnEnd, {Elevation, Std_Dev}), BAG::LayerNotFound);
+    }
+}
+
+//  GeoRead readGeo(double minX, double minY, double maxX, double maxY,
+//      const std::vector<LayerType>& types,
+//      const GeoReadOptions& options) const;
+TEST_CASE("test dataset read geo", "[dataset][readGeo]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 5);
+    REQUIRE(pDataset);
+
+    const auto& transform = pDataset->getDescriptor().getGridTransform();
+    CHECK(transform.originX == Approx(687910.0));
+    CHECK(transform.originY == Approx(5554620.0));
+    CHECK(transform.xSpacing == Approx(10.0));
+    CHECK(transform.ySpacing == Approx(10.0));
+
+    // Each node holds its index.
+    constexpr uint32_t kGridSize = 100;
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (uint32_t index=0; index<kGridSize * kGridSize; ++index)
+        elevations[index] = static_cast<float>(index);
+
+    pDataset->getLayer(Elevation).write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const double x0 = transform.originX;
+    const double y0 = transform.originY;
+
+    SECTION("snapped to the cells the box meets")
+    {
+        const auto read = pDataset->readGeo(x0 + 16., y0 + 45., x0 + 31.,
+            y0 + 64.9, {Elevation});
+        CHECK(read.rowStart == 2);
+        CHECK(read.rowEnd == 3);
+        CHECK(read.columnStart == 5);
+        CHECK(read.columnEnd == 6);
+        REQUIRE(read.data.size() == 4 * sizeof(float));
+
+        const auto* values = reinterpret_cast<const float*>(read.data.data());
+        CHECK(values[0] == 205.f);
+        CHECK(values[1] == 206.f);
+        CHECK(values[2] == 305.f);
+        CHECK(values[3] == 306.f);
+    }
+
+    SECTION("clipped to the grid")
+    {
+        const auto read = pDataset->readGeo(x0 - 1000., y0 + 984.,
+            x0 + 4., y0 + 5000., {Elevation, Uncertainty});
+        CHECK(read.rowStart == 0);
+        CHECK(read.rowEnd == 0);
+        CHECK(read.columnStart == 98);
+        CHECK(read.columnEnd == 99);
+        CHECK(read.data.size() == 2 * 2 * sizeof(float));
+    }
+
+    SECTION("whole chunks")
+    {
+        BAG::GeoReadOptions options;
+        options.wholeChunks = true;
+
+        const auto read = pDataset->readGeo(x0 + 16., y0 + 45., x0 + 31.,
+            y0 + 104., {Elevation}, options);
+        CHECK(read.rowStart == 0);
+        CHECK(read.rowEnd == 9);
+        CHECK(read.columnStart == 0);
+        CHECK(read.columnEnd == 19);
+        CHECK(read.data.size() == 10 * 20 * sizeof(float));
+    }
+
+    SECTION("outside the grid")
+    {
+        REQUIRE_THROWS_AS(pDataset->readGeo(x0 - 100., y0, x0 - 50., y0,
+            {Elevation}), BAG::InvalidReadSize);
+        REQUIRE_THROWS_AS(pDataset->readGeo(x0 + 10., y0, x0, y0,
+            {Elevation}), BAG::InvalidReadSize);
+    }
+}
+
+//  void geoToGrid(const double* xs, const double* ys, size_t count,
+//      uint32_t* rows, uint32_t* columns) const noexcept;
+//  void gridToGeo(const uint32_t* rows, const uint32_t* columns,
+//      size_t count, double* xs, double* ys) const noexcept;
+TEST_CASE("test dataset batch grid conversions", "[dataset][geoToGrid][gridToGeo]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(dataset);
+
+    constexpr size_t kCount = 1000;
+    std::vector<uint32_t> rows(kCount), columns(kCount);
+    for (size_t i=0; i<kCount; ++i)
+    {
+        rows[i] = static_cast<uint32_t>(i % 37);
+        columns[i] = static_cast<uint32_t>(i % 101);
+    }
+
+    std::vector<double> xs(kCount), ys(kCount);
+    dataset->gridToGeo(rows.data(), columns.data(), kCount, xs.data(),
+        ys.data());
+
+    std::vector<uint32_t> toRows(kCount), toColumns(kCount);
+    dataset->geoToGrid(xs.data(), ys.data(), kCount, toRows.data(),
+        toColumns.data());
+
+    for (size_t i=0; i<kCount; ++i)
+    {
+        double x = 0., y = 0.;
+        std::tie(x, y) = dataset->gridToGeo(rows[i], columns[i]);
+        CHECK(xs[i] == x);
+        CHECK(ys[i] == y);
+
+        uint32_t row = 0, column = 0;
+        std::tie(row, column) = dataset->geoToGrid(xs[i], ys[i]);
+        CHECK(toRows[i] == row);
+        CHECK(toColumns[i] == column);
+    }
+}
+
+TEST_CASE("test dataset concurrent reads", "[dataset][open][concurrentReads]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.concurrentReads = true;
+
+    SECTION("requires read only")
+    {
+        REQUIRE_THROWS_AS(Dataset::open(bagFileName, BAG_OPEN_READ_WRITE,
+            options), BAG::ConcurrentReadsRequireReadOnly);
+    }
+
+    SECTION("threads share one dataset")
+    {
+        options.lazy = true;
+
+        const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+            options);
+        REQUIRE(dataset);
+        CHECK(dataset->isConcurrentReadEnabled());
+
+        uint32_t numRows = 0, numColumns = 0;
+        std::tie(numRows, numColumns) = dataset->getDescriptor().getDims();
+
+        const auto expected = Dataset::open(bagFileName,
+            BAG_OPEN_READONLY)->getLayer(Uncertainty).read(0, 0, numRows - 1,
+                numColumns - 1);
+
+        // Every thread opens the (lazy) layer and reads it a row at a time.
+        constexpr size_t kNumThreads = 4;
+        std::array<bool, kNumThreads> matches{};
+        std::vector<std::thread> threads;
+
+        for (size_t t=0; t<kNumThreads; ++t)
+            threads.emplace_back([&, t]() {
+                const auto layer = dataset->getLayer(Uncertainty, {});
+                const auto rowSize = numColumns * sizeof(float);
+                bool match = true;
+
+                for (uint32_t row=0; row<numRows; ++row)
+                {
+                    const auto actual = layer->read(row, 0, row, numColumns - 1);
+                    match = match && std::memcmp(actual.data(),
+                        expected.data() + row * rowSize, rowSize) == 0;
+                }
+
+                matches[t] = match;
+            });
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (const auto match : matches)
+            CHECK(match);
+    }
+}
+
+//  static std::shared_ptr<Dataset> createInMemory(Metadata&& metadata,
+//      uint64_t chunkSize, int compressionLevel,
+//      const std::string& persistFileName);
+//  static std::shared_ptr<Dataset> openFromMemory(const uint8_t* image,
+//      size_t imageSize, OpenMode openMode);
+//  std::vector<uint8_t> getFileImage();
+TEST_CASE("test dataset in memory", "[dataset][create][open][inMemory]")
+{
+    // The dimensions in kMetadataXML.
+    constexpr uint32_t kRows = 100, kColumns = 100;
+
+    std::vector<float> elevations(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = 0.5f * i;
+
+    const auto checkElevations = [&](const Dataset& dataset) {
+        const auto buffer = dataset.getLayer(Elevation).read(0, 0, kRows - 1,
+            kColumns - 1);
+        REQUIRE(buffer);
+        const auto* floats = reinterpret_cast<const float*>(buffer.data());
+        CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+    };
+
+    std::vector<uint8_t> image;
+
+    {
+        UNSCOPED_INFO("Create a BAG in memory, and take an image of its file.");
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::createInMemory(std::move(metadata), 10,
+            5);
+        REQUIRE(pDataset);
+
+        pDataset->getLayer(Elevation).write(0, 0, kRows - 1, kColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        image = pDataset->getFileImage();
+        CHECK_FALSE(image.empty());
+    }
+
+    {
+        UNSCOPED_INFO("Open the image read only.");
+        const auto pDataset = Dataset::openFromMemory(image.data(),
+            image.size(), BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        CHECK(pDataset->getDescriptor().getDims() ==
+            std::make_tuple(kRows, kColumns));
+        checkElevations(*pDataset);
+    }
+
+    {
+        UNSCOPED_INFO("Changes to an image opened read/write stay in memory.");
+        const auto pDataset = Dataset::openFromMemory(image.data(),
+            image.size(), BAG_OPEN_READ_WRITE);
+        REQUIRE(pDataset);
+
+        const float value = -1.f;
+        pDataset->getLayer(Elevation).write(0, 0, 0, 0,
+            reinterpret_cast<const uint8_t*>(&value));
+
+        const auto changedImage = pDataset->getFileImage();
+        const auto changed = Dataset::openFromMemory(changedImage.data(),
+            changedImage.size(), BAG_OPEN_READONLY);
+        REQUIRE(changed);
+        const auto buffer = changed->getLayer(Elevation).read(0, 0, 0, 0);
+        CHECK(*reinterpret_cast<const float*>(buffer.data()) == value);
+
+        const auto original = Dataset::openFromMemory(image.data(),
+            image.size(), BAG_OPEN_READONLY);
+        REQUIRE(original);
+        checkElevations(*original);
+    }
+
+    CHECK(Dataset::openFromMemory(image.data(), 16, BAG_OPEN_READONLY) ==
+        nullptr);
+    CHECK_THROWS_AS(Dataset::openFromMemory(nullptr, 0, BAG_OPEN_READONLY),
+        BAG::InvalidBuffer);
+
+    {
+        UNSCOPED_INFO("Create a BAG in memory, persisted to a file when closed.");
+        const TestUtils::RandomFileGuard tmpFileName;
+
+        {
+            BAG::Metadata metadata;
+            metadata.loadFromBuffer(kMetadataXML);
+
+            const auto pDataset = Dataset::createInMemory(std::move(metadata),
+                10, 5, tmpFileName);
+            REQUIRE(pDataset);
+
+            pDataset->getLayer(Elevation).write(0, 0, kRows - 1, kColumns - 1,
+                reinterpret_cast<const uint8_t*>(elevations.data()));
+        }
+
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+        checkElevations(*pDataset);
+    }
+}
+
+//  static std::shared_ptr<Dataset> open(const std::string &fileName,
+//      OpenMode openMode, const OpenOptions& options);
+TEST_CASE("test dataset open remote", "[dataset][open][remote]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    {
+        UNSCOPED_INFO("A page buffer is ignored for a BAG without paged file space.");
+        BAG::OpenOptions options;
+        options.pageBufferSize = 1024 * 1024;
+
+        const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+            options);
+        REQUIRE(dataset);
+        CHECK(dataset->getLayer(Elevation).read(0, 0, 0, 0));
+    }
+
+    // Nothing listens on port 1, so the request fails without a network.
+    const std::string url{"https://127.0.0.1:1/sample.bag"};
+
+    CHECK_THROWS_AS(Dataset::open(url, BAG_OPEN_READ_WRITE),
+        BAG::RemoteReadsRequireReadOnly);
+
+    CHECK_THROWS_AS(Dataset::open("s3://bucket/sample.bag",
+        BAG_OPEN_READ_WRITE), BAG::RemoteReadsRequireReadOnly);
+
+    if (Dataset::isRemoteReadAvailable())
+        CHECK(Dataset::open(url, BAG_OPEN_READONLY) == nullptr);
+    else
+        CHECK_THROWS_AS(Dataset::open(url, BAG_OPEN_READONLY),
+            BAG::RemoteReadsNotAvailable);
+}
+
+//  static std::shared_ptr<Dataset> create(const std::string &fileName,
+//      Metadata&& metadata, const ChunkShape& chunkShape,
+//      const CompressionSpec& compression, CreationProfile profile);
+TEST_CASE("test dataset create cloud optimized", "[dataset][create][cloudOptimized]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    // The dimensions in kMetadataXML.
+    constexpr uint32_t kRows = 100, kColumns = 100;
+
+    std::vector<float> elevations(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = 0.25f * i;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            BAG::ChunkShape{BAG::ChunkLayout::Tiled, 50, 50}, 5,
+            BAG::CreationProfile::CloudOptimized);
+        REQUIRE(pDataset);
+
+        pDataset->getLayer(Elevation).write(0, 0, kRows - 1, kColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+    }
+
+    UNSCOPED_INFO("The file space is paged.");
+    {
+        const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+        const auto h5createProps = h5file.getCreatePlist();
+
+        H5F_fspace_strategy_t strategy = H5F_FSPACE_STRATEGY_FSM_AGGR;
+        hbool_t persist = true;
+        hsize_t threshold = 0;
+        REQUIRE(H5Pget_file_space_strategy(h5createProps.getId(), &strategy,
+            &persist, &threshold) >= 0);
+        CHECK(strategy == H5F_FSPACE_STRATEGY_PAGE);
+    }
+
+    UNSCOPED_INFO("Read it back through a page buffer.");
+    BAG::OpenOptions options;
+    options.pageBufferSize = 8 * 1024 * 1024;
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY,
+        options);
+    REQUIRE(pDataset);
+
+    const auto buffer = pDataset->getLayer(Elevation).read(0, 0, kRows - 1,
+        kColumns - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+    CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+}
+
+TEST_CASE("test dataset create no fill", "[dataset][create][noFill]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    // The dimensions in kMetadataXML.
+    constexpr uint32_t kRows = 100, kColumns = 100;
+
+    std::vector<float> elevations(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = 0.25f * i;
+
+    std::string elevationPath, stdDevPath;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        // Unchunked, so uncompressed.
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            BAG::ChunkShape{}, 0, BAG::CreationProfile::NoFill);
+        REQUIRE(pDataset);
+
+        auto& elevationLayer = pDataset->getLayer(Elevation);
+        elevationLayer.write(0, 0, kRows - 1, kColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+        elevationPath = elevationLayer.getDescriptor()->getInternalPath();
+
+        const auto& stdDevLayer = pDataset->createSimpleLayer(Std_Dev,
+            BAG::ChunkShape{BAG::ChunkLayout::Tiled, 50, 50}, 0);
+        stdDevPath = stdDevLayer.getDescriptor()->getInternalPath();
+    }
+
+    UNSCOPED_INFO("Only the unchunked layer is not filled.");
+    {
+        const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+
+        CHECK(h5file.openDataSet(elevationPath).getCreatePlist().getFillTime() ==
+            H5D_FILL_TIME_NEVER);
+        CHECK(h5file.openDataSet(stdDevPath).getCreatePlist().getFillTime() ==
+            H5D_FILL_TIME_ALLOC);
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto buffer = pDataset->getLayer(Elevation).read(0, 0, kRows - 1,
+        kColumns - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+    CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+
+    UNSCOPED_INFO("Chunks never written read as null.");
+    const auto pStdDevLayer = pDataset->getSimpleLayer(Std_Dev);
+    REQUIRE(pStdDevLayer);
+    const auto stdDevBuffer = pStdDevLayer->read(kRows - 1, kColumns - 1,
+        kRows - 1, kColumns - 1);
+    REQUIRE(stdDevBuffer);
+    CHECK(*reinterpret_cast<const float*>(stdDevBuffer.data()) ==
+        BAG_NULL_ELEVATION);
+}
+
+//  void beginBatch() noexcept;
+//  void commit(bool flushFile = false);
+//  bool isInBatch() const noexcept;
+TEST_CASE("test dataset batch", "[dataset][beginBatch][commit]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr float kMinValue = -12.5f;
+    constexpr float kMaxValue = 37.25f;
+
+    // Read what is in the file, rather than what the dataset holds.
+    const auto readFileAttribute = [&](const char* path, const char* name,
+        const ::H5::PredType& type, void* value) {
+            const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+            h5file.openDataSet(path).openAttribute(name).read(type, value);
+        };
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    CHECK_FALSE(pDataset->isInBatch());
+    CHECK_THROWS_AS(pDataset->commit(), BAG::NoBatchInProgress);
+
+    pDataset->beginBatch();
+    CHECK(pDataset->isInBatch());
+    CHECK(pDataset->isDeferringAttributeWrites());
+
+    auto& elevationLayer = pDataset->getLayer(Elevation);
+    auto& trackingList = pDataset->getTrackingList();
+
+    std::array<float, 10> strip;
+    for (uint32_t row=0; row<4; ++row)
+    {
+        strip.fill(kMinValue + row);
+        strip[row] = kMaxValue;
+        elevationLayer.write(row, 0, row, 9,
+            reinterpret_cast<const uint8_t*>(strip.data()));
+
+        trackingList.push_back(
+            BAG::TrackingList::value_type{row, 0, 1.f, 0.1f, 1, 10});
+        trackingList.write();
+    }
+
+    UNSCOPED_INFO("A nested batch does not make the deferred writes.");
+    pDataset->beginBatch();
+    pDataset->commit();
+    CHECK(pDataset->isInBatch());
+
+    float maxElevation = 0.f;
+    uint32_t trackingListLength = 0;
+    readFileAttribute("/BAG_root/elevation", "Maximum Elevation Value",
+        ::H5::PredType::NATIVE_FLOAT, &maxElevation);
+    readFileAttribute("/BAG_root/tracking_list", "Tracking List Length",
+        ::H5::PredType::NATIVE_UINT32, &trackingListLength);
+    CHECK(maxElevation != kMaxValue);
+    CHECK(trackingListLength == 0);
+
+    UNSCOPED_INFO("Committing the outermost batch makes them.");
+    pDataset->commit(true);
+    CHECK_FALSE(pDataset->isInBatch());
+    CHECK_FALSE(pDataset->isDeferringAttributeWrites());
+
+    readFileAttribute("/BAG_root/elevation", "Maximum Elevation Value",
+        ::H5::PredType::NATIVE_FLOAT, &maxElevation);
+    readFileAttribute("/BAG_root/tracking_list", "Tracking List Length",
+        ::H5::PredType::NATIVE_UINT32, &trackingListLength);
+    CHECK(maxElevation == kMaxValue);
+    CHECK(trackingListLength == 4);
+}
+
+//  void recomputeVRStatistics();
+TEST_CASE("test dataset recompute vr statistics", "[dataset][recomputeVRStatistics]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    UNSCOPED_INFO("Check recomputing needs variable resolution layers.");
+    CHECK_THROWS_AS(pDataset->recomputeVRStatistics(),
+        BAG::DatasetRequiresVariableResolution);
+
+    pDataset->createVR(100, 5, true);
+
+    const auto pMetadata = pDataset->getVRMetadata();
+    const auto pRefinements = pDataset->getVRRefinements();
+    const auto pNode = pDataset->getVRNode();
+    REQUIRE(pMetadata);
+    REQUIRE(pRefinements);
+    REQUIRE(pNode);
+
+    // Write extremes, then overwrite them, leaving the ranges stale.
+    constexpr uint32_t kNumRefinements = 250;
+    std::vector<BAG::VRRefinementsItem> refinements(kNumRefinements);
+    std::vector<BAG::VRNodeItem> nodes(kNumRefinements);
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+    {
+        refinements[i] = {-1000.f, 50.f};
+        nodes[i] = {100.f, 1000, 1000};
+    }
+
+    pRefinements->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(refinements.data()));
+    pNode->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(nodes.data()));
+
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+    {
+        refinements[i] = {static_cast<float>(i), 0.5f + i % 3};
+        nodes[i] = {0.25f * (i % 8), i % 5 + 1, i + 10};
+    }
+    refinements[7].depth = BAG_NULL_ELEVATION;
+    refinements[8].depth_uncrt = BAG_NULL_UNCERTAINTY;
+
+    pRefinements->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(refinements.data()));
+    pNode->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(nodes.data()));
+
+    // Every supergrid cell is written, as unwritten cells hold zeros.
+    uint32_t rows = 0, columns = 0;
+    std::tie(rows, columns) = pDataset->getDescriptor().getDims();
+
+    std::vector<BAG::VRMetadataItem> items(rows * columns,
+        {0, 8, 8, 2.f, 2.f, 0.f, 0.f});
+    items[6] = {64, 3, 5, 1.5f, 4.f, 0.f, 0.f};
+    pMetadata->write(0, 0, rows - 1, columns - 1,
+        reinterpret_cast<const uint8_t*>(items.data()));
+
+    items[6] = {64, 8, 8, 2.f, 2.f, 0.f, 0.f};
+    pMetadata->write(0, 0, rows - 1, columns - 1,
+        reinterpret_cast<const uint8_t*>(items.data()));
+
+    float minDepth = 0.f, maxDepth = 0.f;
+    std::tie(minDepth, maxDepth) = pRefinements->getDescriptor()->getMinMaxDepth();
+    CHECK(minDepth == -1000.f);
+
+    pDataset->recomputeVRStatistics();
+
+    std::tie(minDepth, maxDepth) = pRefinements->getDescriptor()->getMinMaxDepth();
+    CHECK(minDepth == 0.f);
+    CHECK(maxDepth == static_cast<float>(kNumRefinements - 1));
+
+    float minUncertainty = 0.f, maxUncertainty = 0.f;
+    std::tie(minUncertainty, maxUncertainty) =
+        pRefinements->getDescriptor()->getMinMaxUncertainty();
+    CHECK(minUncertainty == 0.5f);
+    CHECK(maxUncertainty == 2.5f);
+
+    const auto& nodeDescriptor = *pNode->getDescriptor();
+    CHECK(nodeDescriptor.getMinMaxHypStrength() ==
+        std::make_tuple(0.f, 1.75f));
+    CHECK(nodeDescriptor.getMinMaxNumHypotheses() ==
+        std::make_tuple(1u, 5u));
+    CHECK(nodeDescriptor.getMinMaxNSamples() ==
+        std::make_tuple(10u, kNumRefinements + 9));
+
+    const auto& metadataDescriptor = *pMetadata->getDescriptor();
+    CHECK(metadataDescriptor.getMinDimensions() == std::make_tuple(8u, 8u));
+    CHECK(metadataDescriptor.getMaxDimensions() == std::make_tuple(8u, 8u));
+    CHECK(metadataDescriptor.getMinResolution() == std::make_tuple(2.f, 2.f));
+    CHECK(metadataDescriptor.getMaxResolution() == std::make_tuple(2.f, 2.f));
+
+    UNSCOPED_INFO("Check the attributes were written to the file.");
+    pDataset->flush();
+
+    float fileMinDepth = 0.f;
+    const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+    h5file.openDataSet("/BAG_root/varres_refinements").openAttribute(
+        "min_depth").read(::H5::PredType::NATIVE_FLOAT, &fileMinDepth);
+    CHECK(fileMinDepth == 0.f);
+}
+
+//  bool isParallel() const noexcept;
+TEST_CASE("test dataset is parallel", "[dataset][isParallel]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    UNSCOPED_INFO("A BAG opened without a communicator is not shared.");
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+    CHECK_FALSE(pDataset->isParallel());
+
+#ifdef BAG_USE_MPI
+    UNSCOPED_INFO("The MPI-IO driver does not support concurrent reads.");
+    BAG::OpenOptions options;
+    options.communicator = MPI_COMM_WORLD;
+    options.concurrentReads = true;
+    REQUIRE_THROWS_AS(Dataset::open(bagFileName, BAG_OPEN_READONLY, options),
+        BAG::InvalidParallelOpen);
+#endif
+}
+
+//  bool isCollectingIoStats() const noexcept;
+//  void setCollectIoStats(bool collect) noexcept;
+//  DatasetIoStats getIoStats() const;
+//  void resetIoStats();
+TEST_CASE("test dataset io stats", "[dataset][open][OpenOptions][getIoStats]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    UNSCOPED_INFO("I/O statistics are not collected by default.");
+    {
+        const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+        CHECK_FALSE(pDataset->isCollectingIoStats());
+
+        pDataset->getLayer(Elevation).read(0, 0, 9, 9);
+        CHECK(pDataset->getIoStats().total.numReads == 0);
+    }
+
+    BAG::OpenOptions options;
+    options.collectIoStats = true;
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+        options);
+    REQUIRE(pDataset);
+    CHECK(pDataset->isCollectingIoStats());
+
+    const auto& elevation = pDataset->getLayer(Elevation);
+    elevation.read(0, 0, 9, 9);
+    elevation.read(10, 0, 19, 4);
+
+    UNSCOPED_INFO("Each read is counted by the layer read.");
+    const auto elevationStats = elevation.getIoStats();
+    CHECK(elevationStats.numReads == 2);
+    CHECK(elevationStats.bytesRequested == (100 + 50) * sizeof(float));
+    CHECK(elevationStats.numWrites == 0);
+    CHECK(elevationStats.readSeconds >= 0.);
+
+    const auto stats = pDataset->getIoStats();
+    CHECK(stats.total.numReads == 2);
+    CHECK(stats.metadataCacheHitRate >= 0.);
+    CHECK(stats.metadataCacheHitRate <= 1.);
+
+    const auto found = std::find_if(stats.layers.begin(), stats.layers.end(),
+        [](const BAG::LayerIoStats& layerStats) {
+            return layerStats.type == Elevation;
+        });
+    REQUIRE(found != stats.layers.end());
+    CHECK(found->stats.numReads == 2);
+
+    UNSCOPED_INFO("Reads are not counted once collecting stops.");
+    pDataset->setCollectIoStats(false);
+    elevation.read(0, 0, 0, 0);
+    CHECK(elevation.getIoStats().numReads == 2);
+
+    UNSCOPED_INFO("Resetting sets the counters of every layer to zero.");
+    pDataset->resetIoStats();
+    CHECK(elevation.getIoStats().numReads == 0);
+    CHECK(pDataset->getIoStats().total.bytesRequested == 0);
+}
+
+//  DatasetMemoryUsage getMemoryUsage() const;
+//  void releaseCaches() const;
+TEST_CASE("test dataset memory usage", "[dataset][getMemoryUsage][releaseCaches][MemoryBudget]")
+{
+    const TestUtils::RandomFileGuard tmpFileName1, tmpFileName2;
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+    const auto pDataset1 = Dataset::create(tmpFileName1, BAG::Metadata{},
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset1);
+    const auto pDataset2 = Dataset::create(tmpFileName2, BAG::Metadata{},
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset2);
+
+    for (const auto& pDataset : {pDataset1, pDataset2})
+        for (uint32_t i=0; i<100; ++i)
+            pDataset->getTrackingList().push_back(
+                BAG::TrackingList::value_type{i % 10, i % 10, 1.f, 0.1f, 1, 10});
+
+    auto& budget = BAG::MemoryBudget::global();
+    CHECK(budget.getLimit() == 0);
+
+    UNSCOPED_INFO("Check the items are counted, but not indexed until searched.");
+    auto usage = pDataset1->getMemoryUsage();
+    CHECK(usage.trackingList == 100 * sizeof(BAG::TrackingList::value_type));
+    CHECK(usage.trackingListIndexes == 0);
+    CHECK(usage.getReleasable() == 0);
+    CHECK(usage.getTotal() >= usage.trackingList);
+
+    UNSCOPED_INFO("Check searching builds the index, and counts it against the budget.");
+    const auto usageBefore = budget.getUsage();
+    CHECK(pDataset1->getTrackingList().getItemsAtNode(2, 2).size() == 10);
+    usage = pDataset1->getMemoryUsage();
+    CHECK(usage.trackingListIndexes > 0);
+    CHECK(budget.getUsage() == usageBefore + usage.getReleasable());
+
+    UNSCOPED_INFO("Check releasing the caches releases the index.");
+    pDataset1->releaseCaches();
+    CHECK(pDataset1->getMemoryUsage().getReleasable() == 0);
+    CHECK(budget.getUsage() == usageBefore);
+
+    UNSCOPED_INFO("Check the least recently used caches are released over the limit.");
+    CHECK(pDataset1->getTrackingList().getItemsAtNode(2, 2).size() == 10);
+    budget.setLimit(usageBefore + 1);
+    CHECK(pDataset2->getTrackingList().getItemsAtNode(2, 2).size() == 10);
+    CHECK(budget.getUsage() ==
+        usageBefore + pDataset2->getMemoryUsage().getReleasable());
+
+    UNSCOPED_INFO("Check released caches are rebuilt when next used.");
+    CHECK(pDataset1->getTrackingList().getItemsAtNode(2, 2).size() == 10);
+    CHECK(pDataset1->getMemoryUsage().trackingListIndexes > 0);
+
+    budget.setLimit(0);
+}
+
+TEST_CASE("benchmark dataset concurrent reads", "[dataset][concurrentReads][.benchmark]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.concurrentReads = true;
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+    REQUIRE(dataset);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = dataset->getDescriptor().getDims();
+
+    const auto& layer = dataset->getLayer(Elevation);
+    const auto maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Each thread reads the whole layer; throughput is threads / time.
+    for (unsigned int numThreads=1; numThreads<=maxThreads; numThreads*=2)
+    {
+        BENCHMARK("read layer, " + std::to_string(numThreads) + " thread(s)")
+        {
+            std::vector<std::thread> threads;
+            for (unsigned int t=0; t<numThreads; ++t)
+                threads.emplace_back([&]() {
+                    for (uint32_t row=0; row<numRows; ++row)
+                        layer.read(row, 0, row, numColumns - 1);
+                });
+
+            for (auto& thread : threads)
+                thread.join();
+        };
+    }
+}
+
+//  VerifyReport verify(const VerifyOptions& options = {}) const;
+TEST_CASE("test dataset verify", "[dataset][verify]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    // A copy chunked and compressed, so its chunks are decompressed.
+    BAG::CopyOptions copyOptions;
+    copyOptions.rechunk = true;
+    copyOptions.chunkShape.rows = 4;
+    copyOptions.chunkShape.columns = 4;
+    copyOptions.recompress = true;
+    copyOptions.compression = 6;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+    REQUIRE(BAG::copyDataset(*pSource, tmpFileName, copyOptions));
+
+    SECTION("intact")
+    {
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        const auto report = pDataset->verify();
+        CHECK(report.isValid());
+        CHECK(report.problems.empty());
+        CHECK(report.numDataSets > 2);
+        CHECK(report.numChunks > 2);
+    }
+
+    SECTION("a chunk that does not decompress")
+    {
+        {
+            const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDWR};
+            const auto h5dataSet = h5file.openDataSet("/BAG_root/elevation");
+
+            const hsize_t offset[2] = {0, 0};
+            const std::array<uint8_t, 16> garbage{{1, 2, 3, 4, 5, 6, 7, 8, 9,
+                10, 11, 12, 13, 14, 15, 16}};
+            REQUIRE(H5Dwrite_chunk(h5dataSet.getId(), H5P_DEFAULT, 0, offset,
+                garbage.size(), garbage.data()) >= 0);
+        }
+
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        BAG::VerifyOptions options;
+        options.checkValues = false;
+        const auto report = pDataset->verify(options);
+        CHECK_FALSE(report.isValid());
+        REQUIRE(report.problems.size() == 1);
+
+        const auto& problem = report.problems.front();
+        CHECK(problem.path == "/BAG_root/elevation");
+        CHECK(problem.offset == std::vector<uint64_t>{0, 0});
+        CHECK(problem.problem == BAG::VerifyProblem::DecompressionFailed);
+        CHECK_FALSE(problem.message.empty());
+    }
+
+    SECTION("a value outside the range of the layer")
+    {
+        {
+            const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDWR};
+            const auto h5dataSet = h5file.openDataSet("/BAG_root/elevation");
+
+            const hsize_t start[2] = {5, 6};
+            const hsize_t count[2] = {1, 1};
+            auto h5fileSpace = h5dataSet.getSpace();
+            h5fileSpace.selectHyperslab(H5S_SELECT_SET, count, start);
+            const ::H5::DataSpace h5memSpace{2, count};
+
+            const float value = 50000.f;
+            h5dataSet.write(&value, ::H5::PredType::NATIVE_FLOAT, h5memSpace,
+                h5fileSpace);
+        }
+
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        const auto report = pDataset->verify();
+        REQUIRE(report.problems.size() == 1);
+
+        const auto& problem = report.problems.front();
+        CHECK(problem.path == "/BAG_root/elevation");
+        CHECK(problem.offset == std::vector<uint64_t>{4, 4});
+        CHECK(problem.problem == BAG::VerifyProblem::ValueOutOfRange);
+        CHECK(problem.numValues == 1);
+
+        UNSCOPED_INFO("Check only decompressing the chunks finds nothing wrong.");
+        BAG::VerifyOptions options;
+        options.checkValues = false;
+        CHECK(pDataset->verify(options).isValid());
+    }
+}
+
+//  bool isConcurrentWriteEnabled() const noexcept;
+//  void setConcurrentWrites(bool enabled);
+TEST_CASE("test dataset concurrent writes", "[dataset][setConcurrentWrites]")
+{
+    UNSCOPED_INFO("Check a read only BAG cannot be written concurrently.");
+    {
+        const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+            "/sample.bag"};
+
+        const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+        CHECK_FALSE(pDataset->isConcurrentWriteEnabled());
+        REQUIRE_THROWS_AS(pDataset->setConcurrentWrites(true),
+            BAG::ReadOnlyError);
+    }
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    // The dimensions in kMetadataXML.
+    constexpr uint32_t kRows = 100, kColumns = 100;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 5);
+    REQUIRE(pDataset);
+
+    pDataset->setConcurrentWrites(true);
+    CHECK(pDataset->isConcurrentWriteEnabled());
+
+    auto& elevation = pDataset->getLayer(Elevation);
+    auto& uncertainty = pDataset->getLayer(Uncertainty);
+
+    std::vector<float> elevations(kRows * kColumns);
+    std::vector<float> uncertainties(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+    {
+        elevations[i] = 0.5f * i;
+        uncertainties[i] = 1.f + 0.25f * (i % 7);
+    }
+
+    UNSCOPED_INFO("Write whole chunks of one layer and rows of the other at once.");
+    {
+        std::thread elevationWriter{[&]() {
+            for (uint32_t row=0; row<kRows; row+=10)
+                elevation.write(row, 0, row + 9, kColumns - 1,
+                    reinterpret_cast<const uint8_t*>(elevations.data() +
+                        row * kColumns));
+        }};
+        std::thread uncertaintyWriter{[&]() {
+            for (uint32_t row=0; row<kRows; ++row)
+                uncertainty.write(row, 0, row, kColumns - 1,
+                    reinterpret_cast<const uint8_t*>(uncertainties.data() +
+                        row * kColumns));
+        }};
+
+        elevationWriter.join();
+        uncertaintyWriter.join();
+    }
+
+    const auto elevationRead = elevation.read(0, 0, kRows - 1, kColumns - 1);
+    CHECK(std::memcmp(elevationRead.data(), elevations.data(),
+        elevations.size() * sizeof(float)) == 0);
+
+    const auto uncertaintyRead = uncertainty.read(0, 0, kRows - 1,
+        kColumns - 1);
+    CHECK(std::memcmp(uncertaintyRead.data(), uncertainties.data(),
+        uncertainties.size() * sizeof(float)) == 0);
+
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) = elevation.getDescriptor()->getMinMax();
+    CHECK(min == 0.f);
+    CHECK(max == 0.5f * (kRows * kColumns - 1));
+
+    std::tie(min, max) = uncertainty.getDescriptor()->getMinMax();
+    CHECK(min == 1.f);
+    CHECK(max == 2.5f);
+}
+
+TEST_CASE("test dataset descriptor attributes", "[dataset][open][OpenOptions][lazy][getDescriptor]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    BAG::OpenOptions options;
+    options.lazy = true;
+
+    UNSCOPED_INFO("Check the descriptors are complete before the layers are opened.");
+    {
+        const auto eagerDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(eagerDataset);
+
+        const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+            options);
+        REQUIRE(dataset);
+
+        for (const auto type : eagerDataset->getLayerTypes())
+        {
+            const auto* pDescriptor =
+                dataset->getDescriptor().getLayerDescriptor(type, {});
+            REQUIRE(pDescriptor);
+
+            CHECK(pDescriptor->getMinMax() == eagerDataset->getDescriptor()
+                .getLayerDescriptor(type, {})->getMinMax());
+        }
+    }
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    // The dimensions in kMetadataXML.
+    constexpr uint32_t kRows = 100, kColumns = 100;
+
+    std::vector<float> elevations(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = 0.5f * i - 10.f;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            10, 5);
+        REQUIRE(pDataset);
+
+        pDataset->getLayer(Elevation).write(0, 0, kRows - 1, kColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+    }
+
+    UNSCOPED_INFO("Check the written min/max is read with the descriptor.");
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY,
+        options);
+    REQUIRE(pDataset);
+
+    const auto* pDescriptor =
+        pDataset->getDescriptor().getLayerDescriptor(Elevation, {});
+    REQUIRE(pDescriptor);
+
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) = pDescriptor->getMinMax();
+    CHECK(min == -10.f);
+    CHECK(max == 0.5f * (kRows * kColumns - 1) - 10.f);
+}
@@ -0,0 +1,135 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_datasetpool.h>
+#include <bag_descriptor.h>
+
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+
+using BAG::Dataset;
+using BAG::DatasetPool;
+using BAG::DatasetPoolOptions;
+
+//  std::shared_ptr<const Dataset> acquire(const std::string& fileName);
+//  void trim();
+//  void clear();
+//  size_t size() const noexcept;
+//  DatasetPoolStats getStats() const noexcept;
+TEST_CASE("test dataset pool", "[datasetpool][acquire][trim][getStats]")
+{
+    const std::string samplesPath{std::getenv("BAG_SAMPLES_PATH")};
+    const std::string bagFileName{samplesPath + "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    // Replace a file with a copy of the first rows of the sample.
+    const auto writeCopy = [&pSource](const std::string& fileName,
+        uint32_t rows) {
+        std::remove(fileName.c_str());
+
+        BAG::CopyOptions options;
+        options.rowEnd = rows - 1;
+        BAG::copyDataset(*pSource, fileName, options);
+    };
+
+    SECTION("share a dataset")
+    {
+        DatasetPool pool;
+
+        const auto pDataset = pool.acquire(bagFileName);
+        REQUIRE(pDataset);
+
+        // Another name of the same file.
+        CHECK(pool.acquire(samplesPath + "/./sample.bag") == pDataset);
+        CHECK(pool.acquire(bagFileName) == pDataset);
+        CHECK(pool.size() == 1);
+
+        const auto stats = pool.getStats();
+        CHECK(stats.misses == 1);
+        CHECK(stats.hits == 2);
+        CHECK(stats.evictions == 0);
+    }
+
+    SECTION("evict the least recently used")
+    {
+        const TestUtils::RandomFileGuard tmpFirstFile;
+        const TestUtils::RandomFileGuard tmpSecondFile;
+        writeCopy(tmpFirstFile, 10);
+        writeCopy(tmpSecondFile, 20);
+
+        DatasetPoolOptions options;
+        options.maxDatasets = 1;
+        DatasetPool pool{options};
+
+        // Only the pool holds the first.
+        pool.acquire(tmpFirstFile);
+        const auto pSecond = pool.acquire(tmpSecondFile);
+        CHECK(pool.size() == 1);
+        CHECK(pool.getStats().evictions == 1);
+
+        // The second is held, so it is kept above the limit.
+        const auto pFirst = pool.acquire(tmpFirstFile);
+        CHECK(pool.size() == 2);
+        CHECK(pool.getStats().misses == 3);
+
+        pool.clear();
+        CHECK(pool.size() == 0);
+        CHECK(std::get<0>(pFirst->getDescriptor().getDims()) == 10);
+    }
+
+    SECTION("reopen a changed file")
+    {
+        const TestUtils::RandomFileGuard tmpBagFile;
+        writeCopy(tmpBagFile, 10);
+
+        DatasetPool pool;
+
+        const auto pOld = pool.acquire(tmpBagFile);
+        REQUIRE(pOld);
+
+        writeCopy(tmpBagFile, 20);
+
+        const auto pNew = pool.acquire(tmpBagFile);
+        REQUIRE(pNew);
+        CHECK(pNew != pOld);
+        CHECK(std::get<0>(pNew->getDescriptor().getDims()) == 20);
+        CHECK(pool.getStats().reopens == 1);
+
+        // The old dataset is still valid.
+        CHECK(std::get<0>(pOld->getDescriptor().getDims()) == 10);
+    }
+
+    SECTION("reopen a changed file in the background")
+    {
+        const TestUtils::RandomFileGuard tmpBagFile;
+        writeCopy(tmpBagFile, 10);
+
+        DatasetPoolOptions options;
+        options.reopenInterval = 10;
+        DatasetPool pool{options};
+
+        pool.acquire(tmpBagFile);
+        writeCopy(tmpBagFile, 20);
+
+        const auto start = std::chrono::steady_clock::now();
+        while (pool.getStats().reopens == 0 &&
+            std::chrono::steady_clock::now() - start < std::chrono::seconds{10})
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+        CHECK(pool.getStats().reopens == 1);
+
+        // Already open, as the file is now.
+        const auto pDataset = pool.acquire(tmpBagFile);
+        CHECK(std::get<0>(pDataset->getDescriptor().getDims()) == 20);
+        CHECK(pool.getStats().misses == 1);
+    }
+}
+
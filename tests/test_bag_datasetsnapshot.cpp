@@ -0,0 +1,370 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_datasetsnapshot.h>
+#include <bag_exceptions.h>
+#include <bag_georefmetadatalayer.h>
+#include <bag_vrindex.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrnode.h>
+#include <bag_vrrefinements.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::DatasetSnapshot;
+
+//  std::shared_ptr<const DatasetSnapshot> loadSnapshot(
+//      const std::vector<LayerType>& types = {}) const;
+//  UInt8Array read(LayerType type, uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+//  UInt8Array readLayers(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd,
+//      const std::vector<LayerType>& types,
+//      LayerLayout layout = BAG_LAYOUT_PLANAR) const;
+TEST_CASE("test dataset snapshot read", "[datasetsnapshot][loadSnapshot][read][readLayers]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pSnapshot = pDataset->loadSnapshot({Elevation, Uncertainty});
+    REQUIRE(pSnapshot);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+    CHECK(pSnapshot->getNumRows() == numRows);
+    CHECK(pSnapshot->getNumColumns() == numColumns);
+    CHECK(pSnapshot->hasLayer(Elevation));
+    CHECK_FALSE(pSnapshot->hasLayer(Std_Dev));
+    CHECK_FALSE(pSnapshot->isVariableResolution());
+    CHECK(pSnapshot->getMemoryUsage() >=
+        static_cast<size_t>(numRows) * numColumns * 2 * sizeof(float));
+
+    UNSCOPED_INFO("Check reads match those of the BAG.");
+    {
+        const auto expected = pDataset->getLayer(Elevation).read(10, 20, 29, 49);
+        const auto data = pSnapshot->read(Elevation, 10, 20, 29, 49);
+        REQUIRE(data.size() == expected.size());
+        CHECK(std::memcmp(data.data(), expected.data(), data.size()) == 0);
+    }
+
+    for (const auto layout : {BAG_LAYOUT_PLANAR, BAG_LAYOUT_INTERLEAVED})
+    {
+        const auto expected = pDataset->readLayers(5, 0, 14, 9,
+            {Uncertainty, Elevation}, layout);
+        const auto data = pSnapshot->readLayers(5, 0, 14, 9,
+            {Uncertainty, Elevation}, layout);
+        REQUIRE(data.size() == expected.size());
+        CHECK(std::memcmp(data.data(), expected.data(), data.size()) == 0);
+    }
+
+    UNSCOPED_INFO("Check the tracking list matches that of the BAG.");
+    const auto& trackingList = pDataset->getTrackingList();
+    if (!trackingList.empty())
+    {
+        const auto& first = *trackingList.begin();
+        const auto expected = trackingList.getItemsAtNode(first.row, first.col);
+        const auto items = pSnapshot->getTrackingItemsAtNode(first.row,
+            first.col);
+        REQUIRE(items.size() == expected.size());
+        for (size_t i=0; i<items.size(); ++i)
+            CHECK(items[i].list_series == expected[i].list_series);
+    }
+
+    UNSCOPED_INFO("Check reads outside the grid or of other layers throw.");
+    CHECK_THROWS_AS(pSnapshot->read(Elevation, 0, 0, numRows, 0),
+        BAG::InvalidReadSize);
+    CHECK_THROWS_AS(pSnapshot->read(Std_Dev, 0, 0, 0, 0), BAG::LayerNotFound);
+    CHECK_THROWS_AS(pSnapshot->queryVRPoint(0., 0.),
+        BAG::DatasetRequiresVariableResolution);
+    CHECK_THROWS_AS(pSnapshot->readResolved("missing", 0, 0, 0, 0, {}),
+        BAG::LayerNotFound);
+}
+
+//  VRPointResult queryVRPoint(double x, double y) const;
+//  std::vector<ResolvedColumn> readResolved(const std::string& layerName,
+//      uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd, const std::vector<std::string>& fieldNames) const;
+//  std::vector<ResolvedColumn> readVRResolved(const std::string& layerName,
+//      uint32_t indexStart, uint32_t indexEnd,
+//      const std::vector<std::string>& fieldNames) const;
+//  VRResolvedRead readVRResolved(const std::string& layerName,
+//      const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+//      const std::vector<std::string>& fieldNames) const;
+//  std::vector<std::pair<uint32_t, uint32_t>> findCells(
+//      const std::string& layerName, const ValueQuery& query,
+//      uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd) const;
+TEST_CASE("test dataset snapshot variable resolution and georeferenced metadata", "[datasetsnapshot][loadSnapshot][queryVRPoint][readResolved][readVRResolved][findCells]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+    const std::string kLayerName{"elevation"};
+
+    using BAG::CompoundDataType;
+
+    const BAG::Records kRecords{
+        {CompoundDataType{1.5f}, CompoundDataType{std::string{"survey a"}}},
+        {CompoundDataType{2.5f}, CompoundDataType{std::string{"survey b"}}},
+    };
+
+    // Refinement i has key i % 3.
+    constexpr uint32_t kNumRefinements = 12;
+    std::vector<uint16_t> vrKeys(kNumRefinements);
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+        vrKeys[i] = static_cast<uint16_t>(i % 3);
+
+    const std::vector<uint16_t> kKeys{1, 1, 2, 0, 2, 2};
+
+    // A variable resolution BAG of 10 by 10 supergrid cells.
+    const TestUtils::RandomFileGuard tmpFileName;
+    {
+        const auto pSample = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(pSample);
+
+        BAG::CopyOptions options;
+        options.rowEnd = 9;
+        options.columnEnd = 9;
+
+        const auto pDataset = BAG::copyDataset(*pSample, tmpFileName, options);
+        REQUIRE(pDataset);
+        pDataset->createVR(100, 5, true);
+
+        // Created before the refinements are written, which changes the
+        // dimensions of the descriptor.
+        BAG::RecordDefinition definition(2);
+        definition[0].name = "float";
+        definition[0].type = DT_FLOAT32;
+        definition[1].name = "source";
+        definition[1].type = DT_STRING;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+            UNKNOWN_METADATA_PROFILE, kLayerName, definition, 10, 5);
+        layer.getValueTable().addRecords(kRecords);
+
+        std::vector<BAG::VRRefinementsItem> refinements(kNumRefinements);
+        std::vector<BAG::VRNodeItem> nodes(kNumRefinements);
+        for (uint32_t i=0; i<kNumRefinements; ++i)
+        {
+            refinements[i] = {static_cast<float>(i), 0.5f * i};
+            nodes[i] = {1.f, 1, i};
+        }
+
+        pDataset->getVRRefinements()->write(0, 0, 0, kNumRefinements - 1,
+            reinterpret_cast<const uint8_t*>(refinements.data()));
+        pDataset->getVRNode()->write(0, 0, 0, kNumRefinements - 1,
+            reinterpret_cast<const uint8_t*>(nodes.data()));
+
+        // (4, 6) is 2x2 at 6, and (4, 7) is 3x2 at 0.
+        std::vector<BAG::VRMetadataItem> items(10 * 10, BAG::VRMetadataItem{});
+        items[4 * 10 + 6] = {6, 2, 2, 1.f, 1.f, 0.f, 0.f};
+        items[4 * 10 + 7] = {0, 3, 2, 1.f, 1.f, 0.f, 0.f};
+
+        pDataset->getVRMetadata()->write(0, 0, 9, 9,
+            reinterpret_cast<const uint8_t*>(items.data()));
+
+        layer.write(0, 0, 1, 2, reinterpret_cast<const uint8_t*>(kKeys.data()));
+        layer.writeVR(0, kNumRefinements - 1,
+            reinterpret_cast<const uint8_t*>(vrKeys.data()));
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pSnapshot = pDataset->loadSnapshot();
+    REQUIRE(pSnapshot);
+    REQUIRE(pSnapshot->isVariableResolution());
+    CHECK(pSnapshot->getVRRefinements().size() == kNumRefinements);
+    CHECK(pSnapshot->getVRNodes().size() == kNumRefinements);
+    CHECK(pSnapshot->getGeorefMetadataLayerNames() ==
+        std::vector<std::string>{kLayerName});
+
+    const auto pLayer = pDataset->getGeorefMetadataLayer(kLayerName);
+    REQUIRE(pLayer);
+
+    UNSCOPED_INFO("Check positions find the refinements the BAG does.");
+    {
+        const BAG::VRIndex index{*pDataset};
+
+        double originX = 0., originY = 0.;
+        std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+        double spacingX = 0., spacingY = 0.;
+        std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+        std::vector<BAG::VRPoint> points;
+        for (int row=0; row<40; ++row)
+            for (int column=0; column<40; ++column)
+                points.push_back({originX + column * spacingX / 4.,
+                    originY + row * spacingY / 4.});
+
+        const auto expected = index.queryPoints(points);
+        const auto results = pSnapshot->queryVRPoints(points);
+        REQUIRE(results.size() == expected.size());
+
+        size_t numFound = 0;
+        for (size_t i=0; i<results.size(); ++i)
+        {
+            CHECK(results[i].found == expected[i].found);
+            if (!expected[i].found)
+                continue;
+
+            ++numFound;
+            CHECK(results[i].refinementIndex == expected[i].refinementIndex);
+            CHECK(results[i].item.depth == expected[i].item.depth);
+        }
+        CHECK(numFound > 0);
+    }
+
+    UNSCOPED_INFO("Check resolved reads match those of the layer.");
+    {
+        const auto expected = pLayer->readResolved(0, 0, 2, 3,
+            {"source", "float"});
+        const auto columns = pSnapshot->readResolved(kLayerName, 0, 0, 2, 3,
+            {"source", "float"});
+        REQUIRE(columns.size() == 2);
+        CHECK(columns[0].strings == expected[0].strings);
+        CHECK(columns[1].floats == expected[1].floats);
+    }
+
+    {
+        const auto expected = pLayer->readVRResolved(2, 9, {"float"});
+        const auto columns = pSnapshot->readVRResolved(kLayerName, 2, 9,
+            {"float"});
+        REQUIRE(columns.size() == 1);
+        CHECK(columns[0].floats == expected[0].floats);
+    }
+
+    const std::vector<std::pair<uint32_t, uint32_t>> kCells{{4, 6}, {0, 0},
+        {4, 7}};
+    const auto checkCells = [&](const BAG::VRResolvedRead& read) {
+        const auto expected = pLayer->readVRResolved(kCells, {"source"});
+        REQUIRE(read.cells.size() == expected.cells.size());
+        for (size_t i=0; i<read.cells.size(); ++i)
+        {
+            CHECK(read.cells[i].row == expected.cells[i].row);
+            CHECK(read.cells[i].column == expected.cells[i].column);
+            CHECK(read.cells[i].offset == expected.cells[i].offset);
+            CHECK(read.cells[i].count == expected.cells[i].count);
+        }
+        CHECK(read.depths == expected.depths);
+        CHECK(read.uncertainties == expected.uncertainties);
+        REQUIRE(read.columns.size() == 1);
+        CHECK(read.columns[0].strings == expected.columns[0].strings);
+    };
+
+    checkCells(pSnapshot->readVRResolved(kLayerName, kCells, {"source"}));
+
+    {
+        BAG::ValueQuery query;
+        query.fieldName = "source";
+        query.min = CompoundDataType{std::string{"survey b"}};
+        query.max = query.min;
+
+        const auto expected = pLayer->findCells(query, 0, 0, 9, 9);
+        CHECK(pSnapshot->findCells(kLayerName, query, 0, 0, 9, 9) == expected);
+        CHECK(expected.size() == 3);
+    }
+
+    UNSCOPED_INFO("Check threads can query the snapshot at the same time.");
+    {
+        std::vector<BAG::VRResolvedRead> reads(4);
+        std::vector<std::thread> threads;
+        for (auto& read : reads)
+            threads.emplace_back([&pSnapshot, &kLayerName, &kCells, &read]() {
+                for (int i=0; i<50; ++i)
+                    read = pSnapshot->readVRResolved(kLayerName, kCells,
+                        {"source"});
+            });
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (const auto& read : reads)
+            checkCells(read);
+    }
+}
+
+#ifndef _WIN32
+//  void exportToSharedMemory(const std::string& name) const;
+//  static std::shared_ptr<const DatasetSnapshot> attachSharedMemory(
+//      const std::string& name);
+//  static bool removeSharedMemory(const std::string& name) noexcept;
+TEST_CASE("test dataset snapshot shared memory", "[datasetsnapshot][exportToSharedMemory][attachSharedMemory][removeSharedMemory]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pSnapshot = pDataset->loadSnapshot({Elevation, Uncertainty});
+    REQUIRE(pSnapshot);
+    CHECK_FALSE(pSnapshot->isShared());
+
+    const std::string name{"bagsnapshot-" +
+        std::to_string(std::random_device{}())};
+    DatasetSnapshot::removeSharedMemory(name);
+
+    pSnapshot->exportToSharedMemory(name);
+
+    UNSCOPED_INFO("Check a segment is not exported over.");
+    CHECK_THROWS_AS(pSnapshot->exportToSharedMemory(name),
+        BAG::SharedMemoryUnavailable);
+
+    const auto pShared = DatasetSnapshot::attachSharedMemory(name);
+    REQUIRE(pShared);
+    CHECK(pShared->isShared());
+
+    UNSCOPED_INFO("Check the snapshot attached stays readable once removed.");
+    CHECK(DatasetSnapshot::removeSharedMemory(name));
+    CHECK_FALSE(DatasetSnapshot::removeSharedMemory(name));
+    CHECK_THROWS_AS(DatasetSnapshot::attachSharedMemory(name),
+        BAG::SharedMemoryUnavailable);
+
+    const auto numRows = pSnapshot->getNumRows();
+    const auto numColumns = pSnapshot->getNumColumns();
+    CHECK(pShared->getNumRows() == numRows);
+    CHECK(pShared->getNumColumns() == numColumns);
+    CHECK(pShared->hasLayer(Elevation));
+    CHECK(pShared->hasLayer(Uncertainty));
+    CHECK_FALSE(pShared->hasLayer(Std_Dev));
+    CHECK(pShared->getMemoryUsage() == pSnapshot->getMemoryUsage());
+
+    UNSCOPED_INFO("Check reads match those of the snapshot exported.");
+    for (const auto layout : {BAG_LAYOUT_PLANAR, BAG_LAYOUT_INTERLEAVED})
+    {
+        const auto expected = pSnapshot->readLayers(0, 0, numRows - 1,
+            numColumns - 1, {Uncertainty, Elevation}, layout);
+        const auto data = pShared->readLayers(0, 0, numRows - 1,
+            numColumns - 1, {Uncertainty, Elevation}, layout);
+        REQUIRE(data.size() == expected.size());
+        CHECK(std::memcmp(data.data(), expected.data(), data.size()) == 0);
+    }
+
+    UNSCOPED_INFO("Check the tracking list matches that of the snapshot.");
+    const auto& trackingList = pDataset->getTrackingList();
+    if (!trackingList.empty())
+    {
+        const auto& first = *trackingList.begin();
+        const auto expected = pSnapshot->getTrackingItemsAtNode(first.row,
+            first.col);
+        const auto items = pShared->getTrackingItemsAtNode(first.row,
+            first.col);
+        REQUIRE(items.size() == expected.size());
+        for (size_t i=0; i<items.size(); ++i)
+            CHECK(items[i].list_series == expected[i].list_series);
+    }
+}
+#endif
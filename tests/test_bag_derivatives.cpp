@@ -0,0 +1,209 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_derivatives.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_simplelayer.h>
+
+#include <array>
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::CopyOptions;
+using BAG::DerivativeLayers;
+using BAG::DerivativeOptions;
+
+//  void computeDerivatives(const SimpleLayer& elevation,
+//      const DerivativeLayers& layers, const DerivativeOptions& options = {});
+TEST_CASE("test compute derivatives", "[derivatives][computeDerivatives]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    // A copy in small chunks, so a neighbourhood spans several.
+    CopyOptions copyOptions;
+    copyOptions.rechunk = true;
+    copyOptions.chunkShape.rows = 8;
+    copyOptions.chunkShape.columns = 8;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+    const auto pDataset = BAG::copyDataset(*pSource, tmpFileName,
+        copyOptions);
+    REQUIRE(pDataset);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+    REQUIRE(numRows > 24);
+    REQUIRE(numColumns > 24);
+
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) =
+        pDataset->getDescriptor().getGridSpacing();
+
+    // A plane rising east and falling north.
+    constexpr double kEast = 0.3;
+    constexpr double kNorth = -0.2;
+
+    std::vector<float> elevations(static_cast<size_t>(numRows) * numColumns);
+    for (uint32_t row=0; row<numRows; ++row)
+        for (uint32_t column=0; column<numColumns; ++column)
+            elevations[static_cast<size_t>(row) * numColumns + column] =
+                static_cast<float>(kEast * columnSpacing * column +
+                    kNorth * rowSpacing * row);
+
+    auto& elevation = *pDataset->getSimpleLayer(Elevation);
+    elevation.write(0, 0, numRows - 1, numColumns - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    BAG::ChunkShape chunkShape;
+    chunkShape.rows = 8;
+    chunkShape.columns = 8;
+    for (const auto type : {Std_Dev, Average_Elevation, Nominal_Elevation,
+        Shoal_Elevation})
+        if (!pDataset->getSimpleLayer(type))
+            pDataset->createSimpleLayer(type, chunkShape,
+                BAG::CompressionSpec{});
+
+    DerivativeLayers layers;
+    layers.slope = pDataset->getSimpleLayer(Std_Dev).get();
+    layers.aspect = pDataset->getSimpleLayer(Average_Elevation).get();
+    layers.hillshade = pDataset->getSimpleLayer(Nominal_Elevation).get();
+    layers.rugosity = pDataset->getSimpleLayer(Shoal_Elevation).get();
+
+    DerivativeOptions options;
+
+    const auto degrees = 180. / std::acos(-1.);
+    const auto gradient = std::sqrt(kEast * kEast + kNorth * kNorth);
+    const auto expectedSlope = std::atan(gradient) * degrees;
+    const auto expectedAspect = std::atan2(-kEast, -kNorth) * degrees + 360.;
+    const auto sunAzimuth = options.sunAzimuth / degrees;
+    const auto sunElevation = options.sunElevation / degrees;
+    const auto expectedHillshade = 255. * (std::sin(sunElevation) -
+        kEast * std::cos(sunElevation) * std::sin(sunAzimuth) -
+        kNorth * std::cos(sunElevation) * std::cos(sunAzimuth)) /
+        std::sqrt(1. + gradient * gradient);
+    const auto expectedRugosity = std::sqrt(1. + gradient * gradient);
+
+    // Check the products are those of the plane, except within radius of
+    // the edges, or where a null is a neighbour.
+    const auto checkProducts = [&](uint32_t radius,
+        const std::vector<std::pair<uint32_t, uint32_t>>& nulls) {
+        const auto isNeighbour = [radius](int64_t offset) {
+            return offset == 0 || std::abs(offset) == radius;
+        };
+
+        const auto isNull = [&](uint32_t row, uint32_t column) {
+            if (row < radius || column < radius ||
+                row + radius >= numRows || column + radius >= numColumns)
+                return true;
+
+            for (const auto& node : nulls)
+                if (isNeighbour(int64_t{row} - node.first) &&
+                    isNeighbour(int64_t{column} - node.second))
+                    return true;
+
+            return false;
+        };
+
+        const std::array<std::pair<const BAG::SimpleLayer*, double>, 4>
+            products{{{layers.slope, expectedSlope},
+                {layers.aspect, expectedAspect},
+                {layers.hillshade, expectedHillshade},
+                {layers.rugosity, expectedRugosity}}};
+
+        for (const auto& product : products)
+        {
+            const auto values = product.first->readAs<float>(0, 0,
+                numRows - 1, numColumns - 1);
+
+            uint32_t numWrong = 0;
+            for (uint32_t row=0; row<numRows; ++row)
+                for (uint32_t column=0; column<numColumns; ++column)
+                {
+                    const auto value = values(row, column);
+                    if (isNull(row, column))
+                        numWrong += value != BAG_NULL_GENERIC;
+                    else
+                        numWrong += !(value ==
+                            Catch::Approx(product.second).epsilon(1e-4));
+                }
+
+            CHECK(numWrong == 0);
+        }
+    };
+
+    SECTION("radius 1")
+    {
+        BAG::computeDerivatives(elevation, layers, options);
+        checkProducts(1, {});
+
+        UNSCOPED_INFO("Check the attributes of the products are updated.");
+        float min = 0.f, max = 0.f;
+        std::tie(min, max) = layers.slope->getDescriptor()->getMinMax();
+        CHECK(min == Catch::Approx(expectedSlope).epsilon(1e-4));
+        CHECK(max == Catch::Approx(expectedSlope).epsilon(1e-4));
+    }
+
+    SECTION("a radius larger than a chunk")
+    {
+        options.radius = 11;
+        BAG::computeDerivatives(elevation, layers, options);
+        checkProducts(11, {});
+    }
+
+    SECTION("null nodes")
+    {
+        const float nullValue = BAG_NULL_ELEVATION;
+        elevation.write(12, 9, 12, 9,
+            reinterpret_cast<const uint8_t*>(&nullValue));
+        const float nan = std::nanf("");
+        elevation.write(20, 16, 20, 16, reinterpret_cast<const uint8_t*>(&nan));
+
+        options.radius = 2;
+        BAG::computeDerivatives(elevation, layers, options);
+        checkProducts(2, {{12, 9}, {20, 16}});
+    }
+
+    SECTION("only some products")
+    {
+        DerivativeLayers slopeOnly;
+        slopeOnly.slope = layers.slope;
+        BAG::computeDerivatives(elevation, slopeOnly, options);
+
+        const auto values = layers.aspect->readAs<float>(0, 0, numRows - 1,
+            numColumns - 1);
+        CHECK(values(numRows / 2, numColumns / 2) == BAG_NULL_ELEVATION);
+
+        const auto slopes = layers.slope->readAs<float>(0, 0, numRows - 1,
+            numColumns - 1);
+        CHECK(slopes(numRows / 2, numColumns / 2) ==
+            Catch::Approx(expectedSlope).epsilon(1e-4));
+    }
+
+    SECTION("invalid")
+    {
+        options.radius = 0;
+        REQUIRE_THROWS_AS(BAG::computeDerivatives(elevation, layers, options),
+            BAG::InvalidKernelRadius);
+
+        options.radius = 1;
+        layers.aspect = &elevation;
+        REQUIRE_THROWS_AS(BAG::computeDerivatives(elevation, layers, options),
+            BAG::InvalidDerivativeLayer);
+
+        layers.aspect = layers.slope;
+        REQUIRE_THROWS_AS(BAG::computeDerivatives(elevation, layers, options),
+            BAG::InvalidDerivativeLayer);
+    }
+}
@@ -0,0 +1,270 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_diff.h>
+#include <bag_exceptions.h>
+#include <bag_layerdescriptor.h>
+#include <bag_simplelayer.h>
+
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::CopyOptions;
+using BAG::DiffOptions;
+
+//  LayerDiff diffLayers(const SimpleLayer& a, const SimpleLayer& b,
+//      const DiffOptions& options = {}, SimpleLayer* pDifference = nullptr);
+TEST_CASE("test diff layers", "[diff][diffLayers]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pSource->getDescriptor().getDims();
+
+    // Two copies chunked alike, so their chunks can be compared.
+    CopyOptions options;
+    options.rechunk = true;
+    options.chunkShape.rows = 4;
+    options.chunkShape.columns = 4;
+    options.recompress = true;
+    options.compression = 6;
+
+    const TestUtils::RandomFileGuard tmpFileNameA;
+    const TestUtils::RandomFileGuard tmpFileNameB;
+
+    const auto pA = BAG::copyDataset(*pSource, tmpFileNameA, options);
+    const auto pB = BAG::copyDataset(*pSource, tmpFileNameB, options);
+    REQUIRE(pA);
+    REQUIRE(pB);
+
+    const auto& a = *pA->getSimpleLayer(Elevation);
+    auto& b = *pB->getSimpleLayer(Elevation);
+
+    const auto numTiles = ((numRows + 3) / 4) * ((numColumns + 3) / 4);
+    const auto count = a.computeStatistics().count;
+    REQUIRE(count > 0);
+
+    // A node that is not null.
+    const auto values = a.readAs<float>(0, 0, numRows - 1, numColumns - 1);
+    uint32_t changedRow = 0, changedColumn = 0;
+    for (uint32_t row=0; row<numRows; ++row)
+        for (uint32_t column=0; column<numColumns; ++column)
+            if (values(row, column) != BAG_NULL_ELEVATION)
+                std::tie(changedRow, changedColumn) = std::make_tuple(row,
+                    column);
+
+    SECTION("identical layers")
+    {
+        const auto diff = BAG::diffLayers(a, b);
+        CHECK(diff.rowStart == 0);
+        CHECK(diff.columnStart == 0);
+        CHECK(diff.rowEnd == numRows - 1);
+        CHECK(diff.columnEnd == numColumns - 1);
+        CHECK(diff.count == count);
+        CHECK(diff.numChanged == 0);
+        CHECK(diff.numAdded == 0);
+        CHECK(diff.numRemoved == 0);
+        CHECK(diff.mean == 0.);
+        CHECK(diff.rms == 0.);
+        CHECK(diff.regions.empty());
+        CHECK(diff.numIdenticalChunks == numTiles);
+
+        DiffOptions diffOptions;
+        diffOptions.skipIdenticalChunks = false;
+
+        const auto compared = BAG::diffLayers(a, b, diffOptions);
+        CHECK(compared.count == count);
+        CHECK(compared.numChanged == 0);
+        CHECK(compared.numIdenticalChunks == 0);
+    }
+
+    SECTION("a changed node")
+    {
+        const float changed = values(changedRow, changedColumn) + 2.5f;
+        b.write(changedRow, changedColumn, changedRow, changedColumn,
+            reinterpret_cast<const uint8_t*>(&changed));
+
+        const TestUtils::RandomFileGuard tmpFileNameDifference;
+        const auto pDifference = BAG::copyDataset(*pSource,
+            tmpFileNameDifference, options);
+        REQUIRE(pDifference);
+
+        const auto diff = BAG::diffLayers(a, b, {},
+            pDifference->getSimpleLayer(Elevation).get());
+        CHECK(diff.count == count);
+        CHECK(diff.numChanged == 1);
+        CHECK(diff.max == Catch::Approx(2.5));
+        CHECK(diff.min == 0.);
+        CHECK(diff.numIdenticalChunks == numTiles - 1);
+        REQUIRE(diff.regions.size() == 1);
+        CHECK(diff.regions[0].rowStart == changedRow);
+        CHECK(diff.regions[0].rowEnd == changedRow);
+        CHECK(diff.regions[0].columnStart == changedColumn);
+        CHECK(diff.regions[0].columnEnd == changedColumn);
+        CHECK(diff.regions[0].numChanged == 1);
+        CHECK(diff.regions[0].maxChange == Catch::Approx(2.5));
+
+        const auto differences = pDifference->getLayer(Elevation).readAs<float>(
+            0, 0, numRows - 1, numColumns - 1);
+        CHECK(differences(changedRow, changedColumn) == Catch::Approx(2.5f));
+        for (uint32_t row=0; row<numRows; ++row)
+            for (uint32_t column=0; column<numColumns; ++column)
+                if (row != changedRow || column != changedColumn)
+                    CHECK(differences(row, column) ==
+                        (values(row, column) == BAG_NULL_ELEVATION ?
+                            BAG_NULL_ELEVATION : 0.f));
+
+        DiffOptions diffOptions;
+        diffOptions.threshold = 3.;
+
+        const auto small = BAG::diffLayers(a, b, diffOptions);
+        CHECK(small.numChanged == 0);
+        CHECK(small.regions.empty());
+        CHECK(small.max == Catch::Approx(2.5));
+    }
+
+    SECTION("offset grids")
+    {
+        CopyOptions windowOptions;
+        windowOptions.rowStart = 2;
+        windowOptions.columnStart = 3;
+
+        const TestUtils::RandomFileGuard tmpFileNameWindow;
+        const auto pWindow = BAG::copyDataset(*pSource, tmpFileNameWindow,
+            windowOptions);
+        REQUIRE(pWindow);
+
+        const auto diff = BAG::diffLayers(a,
+            *pWindow->getSimpleLayer(Elevation));
+        CHECK(diff.rowStart == 2);
+        CHECK(diff.columnStart == 3);
+        CHECK(diff.rowEnd == numRows - 1);
+        CHECK(diff.columnEnd == numColumns - 1);
+        CHECK(diff.numChanged == 0);
+        CHECK(diff.numAdded == 0);
+        CHECK(diff.numRemoved == 0);
+        CHECK(diff.numIdenticalChunks == 0);
+
+        // The same nodes, seen from the window.
+        const auto reversed = BAG::diffLayers(
+            *pWindow->getSimpleLayer(Elevation), a);
+        CHECK(reversed.rowStart == 0);
+        CHECK(reversed.columnStart == 0);
+        CHECK(reversed.count == diff.count);
+    }
+
+    SECTION("grids not aligned")
+    {
+        double originX = 0., originY = 0.;
+        std::tie(originX, originY) = pB->getDescriptor().getOrigin();
+        double rowSpacing = 0., columnSpacing = 0.;
+        std::tie(rowSpacing, columnSpacing) =
+            pB->getDescriptor().getGridSpacing();
+
+        pB->getDescriptor().setOrigin(originX + columnSpacing / 2., originY);
+        CHECK_THROWS_AS(BAG::diffLayers(a, b), BAG::GridsNotAligned);
+
+        pB->getDescriptor().setOrigin(originX + columnSpacing * numColumns,
+            originY);
+        CHECK_THROWS_AS(BAG::diffLayers(a, b), BAG::GridsNotAligned);
+    }
+}
+
+//  std::vector<ChunkHash> Dataset::hashChunks(const ChunkHashOptions& options = {});
+//  std::vector<ChunkHash> Dataset::readChunkHashes() const;
+//  std::vector<ChunkDelta> diffChunkHashes(const std::vector<ChunkHash>& from,
+//      const std::vector<ChunkHash>& to);
+TEST_CASE("test diff chunk hashes", "[diff][diffChunkHashes][hashChunks]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    UNSCOPED_INFO("Check the hashes of a read only BAG cannot be kept in it.");
+    {
+        BAG::ChunkHashOptions hashOptions;
+        hashOptions.persist = true;
+        REQUIRE_THROWS_AS(pSource->hashChunks(hashOptions), BAG::ReadOnlyError);
+        CHECK(pSource->readChunkHashes().empty());
+    }
+
+    CopyOptions options;
+    options.rechunk = true;
+    options.chunkShape.rows = 4;
+    options.chunkShape.columns = 4;
+    options.recompress = true;
+    options.compression = 6;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    const auto pCopy = BAG::copyDataset(*pSource, tmpFileName, options);
+    REQUIRE(pCopy);
+
+    const auto before = pCopy->hashChunks();
+    REQUIRE_FALSE(before.empty());
+
+    UNSCOPED_INFO("Check the chunks of a layer are hashed as stored.");
+    const auto isElevation = [](const BAG::ChunkHash& hash) {
+        return hash.path == "/BAG_root/elevation";
+    };
+    const auto numElevationChunks = std::count_if(before.begin(),
+        before.end(), isElevation);
+    CHECK(numElevationChunks > 0);
+    for (const auto& hash : before)
+        if (isElevation(hash))
+        {
+            CHECK(hash.stored);
+            CHECK(hash.offset.size() == 2);
+            CHECK(hash.size > 0);
+        }
+
+    UNSCOPED_INFO("Check hashing again finds no change.");
+    CHECK(BAG::diffChunkHashes(before, pCopy->hashChunks()).empty());
+
+    UNSCOPED_INFO("Check changing a node modifies its chunk only.");
+    const float elevation = 123.f;
+    pCopy->getLayer(Elevation).write(5, 6, 5, 6,
+        reinterpret_cast<const uint8_t*>(&elevation));
+
+    BAG::ChunkHashOptions hashOptions;
+    hashOptions.persist = true;
+    const auto after = pCopy->hashChunks(hashOptions);
+
+    auto deltas = BAG::diffChunkHashes(before, after);
+    deltas.erase(std::remove_if(deltas.begin(), deltas.end(),
+        [](const BAG::ChunkDelta& delta) {
+            return delta.path != "/BAG_root/elevation";
+        }), deltas.end());
+
+    REQUIRE(deltas.size() == 1);
+    CHECK(deltas[0].change == BAG::ChunkChange::Modified);
+    CHECK(deltas[0].offset == std::vector<uint64_t>{4, 4});
+
+    UNSCOPED_INFO("Check the hashes kept are read back.");
+    const auto kept = pCopy->readChunkHashes();
+    REQUIRE(kept.size() == after.size());
+    CHECK(BAG::diffChunkHashes(after, kept).empty());
+
+    UNSCOPED_INFO("Check chunks only on one side are added or removed.");
+    const std::vector<BAG::ChunkHash> none;
+    const auto added = BAG::diffChunkHashes(none, after);
+    REQUIRE(added.size() == after.size());
+    CHECK(added[0].change == BAG::ChunkChange::Added);
+
+    const auto removed = BAG::diffChunkHashes(after, none);
+    REQUIRE(removed.size() == after.size());
+    CHECK(removed[0].change == BAG::ChunkChange::Removed);
+}
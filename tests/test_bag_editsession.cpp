@@ -0,0 +1,202 @@
+
+#include "test_utils.h"
+#include <bag_dataset.h>
+#include <bag_editsession.h>
+#include <bag_exceptions.h>
+#include <bag_metadata.h>
+#include <bag_trackinglist.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::EditSession;
+
+namespace {
+
+//! Retrieve the elevations of a window from a buffer read.
+std::vector<float> toFloats(
+    const BAG::UInt8Array& buffer)
+{
+    std::vector<float> values(buffer.size() / sizeof(float));
+    std::memcpy(values.data(), buffer.data(), buffer.size());
+
+    return values;
+}
+
+//! Create a BAG 100 nodes square, in chunks 10 nodes square, of elevations
+//! of 1.
+std::shared_ptr<Dataset> createDataset(
+    const std::string& fileName)
+{
+    BAG::Metadata metadata;
+    metadata.loadFromFile(std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.xml");
+
+    auto pDataset = Dataset::create(fileName, std::move(metadata), 10, 6);
+
+    const std::vector<float> elevations(100 * 100, 1.f);
+    pDataset->getLayer(Elevation).write(0, 0, 99, 99,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    return pDataset;
+}
+
+}  // namespace
+
+//  UInt8Array read(LayerType type, uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+//  void write(LayerType type, uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, const uint8_t* buffer);
+//  void commit();
+TEST_CASE("test edit session write", "[editsession][read][write][commit]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    const auto pDataset = createDataset(tmpFileName);
+    REQUIRE(pDataset);
+
+    EditSession session{*pDataset};
+    CHECK_FALSE(session.isDirty());
+
+    // A window across four chunks.
+    const std::vector<float> edits(5 * 5, 2.f);
+    session.write(Elevation, 8, 8, 12, 12,
+        reinterpret_cast<const uint8_t*>(edits.data()));
+
+    CHECK(session.isDirty());
+    CHECK(session.getNumDirtyChunks() == 4);
+    CHECK(session.getMemoryUsage() >= 4 * 10 * 10 * sizeof(float));
+
+    UNSCOPED_INFO("Check the session sees the edits over the BAG.");
+    {
+        const auto values = toFloats(session.read(Elevation, 7, 7, 13, 13));
+        REQUIRE(values.size() == 7 * 7);
+        CHECK(values[0] == 1.f);
+        CHECK(values[1 * 7 + 1] == 2.f);
+        CHECK(values[5 * 7 + 5] == 2.f);
+        CHECK(values[6 * 7 + 6] == 1.f);
+    }
+
+    UNSCOPED_INFO("Check a window of edited chunks only is read from them.");
+    {
+        const auto values = toFloats(session.read(Elevation, 10, 10, 11, 11));
+        CHECK(values == std::vector<float>(4, 2.f));
+    }
+
+    UNSCOPED_INFO("Check the BAG is not written until committed.");
+    CHECK(toFloats(pDataset->getLayer(Elevation).read(10, 10, 10, 10))[0] ==
+        1.f);
+
+    UNSCOPED_INFO("Check committing writes each chunk edited once.");
+    {
+        pDataset->setCollectIoStats(true);
+        session.commit();
+
+        const auto stats = pDataset->getIoStats();
+        CHECK(stats.total.numWrites == 4);
+        CHECK(stats.total.chunksWritten == 4);
+
+        CHECK_FALSE(session.isDirty());
+        CHECK_FALSE(session.canUndo());
+
+        const auto values = toFloats(pDataset->getLayer(Elevation).read(7, 7,
+            13, 13));
+        CHECK(values[0] == 1.f);
+        CHECK(values[1 * 7 + 1] == 2.f);
+        CHECK(values[5 * 7 + 5] == 2.f);
+    }
+
+    UNSCOPED_INFO("Check windows beyond the grid are rejected.");
+    REQUIRE_THROWS_AS(session.read(Elevation, 0, 0, 100, 0),
+        BAG::InvalidReadSize);
+    REQUIRE_THROWS_AS(session.write(Elevation, 5, 0, 4, 0,
+        reinterpret_cast<const uint8_t*>(edits.data())),
+        BAG::InvalidWriteSize);
+    REQUIRE_THROWS_AS(session.write(Std_Dev, 0, 0, 0, 0,
+        reinterpret_cast<const uint8_t*>(edits.data())), BAG::LayerNotFound);
+}
+
+//  void addTrackingItem(const BagTrackingItem& item);
+//  void undo();
+//  void redo();
+//  void discard() noexcept;
+TEST_CASE("test edit session undo", "[editsession][undo][redo][addTrackingItem]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    const auto pDataset = createDataset(tmpFileName);
+    REQUIRE(pDataset);
+
+    EditSession session{*pDataset};
+    CHECK_FALSE(session.canUndo());
+    REQUIRE_THROWS_AS(session.undo(), BAG::NothingToUndo);
+    REQUIRE_THROWS_AS(session.redo(), BAG::NothingToRedo);
+
+    const float first = 2.f, second = 3.f;
+    session.write(Elevation, 50, 50, 50, 50,
+        reinterpret_cast<const uint8_t*>(&first));
+    session.write(Elevation, 50, 50, 50, 50,
+        reinterpret_cast<const uint8_t*>(&second));
+
+    BagTrackingItem item{};
+    item.row = 50;
+    item.col = 50;
+    item.depth = 1.f;
+    item.track_code = 7;
+    session.addTrackingItem(item);
+    REQUIRE(session.getTrackingItems().size() == 1);
+
+    const auto elevationAt = [&session]() {
+        return toFloats(session.read(Elevation, 50, 50, 50, 50))[0];
+    };
+
+    CHECK(elevationAt() == 3.f);
+
+    session.undo();
+    CHECK(session.getTrackingItems().empty());
+    session.undo();
+    CHECK(elevationAt() == 2.f);
+    session.undo();
+    CHECK(elevationAt() == 1.f);
+    CHECK_FALSE(session.canUndo());
+    CHECK(session.canRedo());
+
+    session.redo();
+    CHECK(elevationAt() == 2.f);
+
+    UNSCOPED_INFO("Check a new edit forgets the edits undone.");
+    session.addTrackingItem(item);
+    CHECK_FALSE(session.canRedo());
+    CHECK(session.getTrackingItems().size() == 1);
+
+    const auto numItems = pDataset->getTrackingList().size();
+    session.commit();
+    CHECK(pDataset->getTrackingList().size() == numItems + 1);
+    CHECK(pDataset->getTrackingList().back().track_code == 7);
+    CHECK(toFloats(pDataset->getLayer(Elevation).read(50, 50, 50, 50))[0] ==
+        2.f);
+
+    UNSCOPED_INFO("Check discarded edits are not written.");
+    session.write(Elevation, 50, 50, 50, 50,
+        reinterpret_cast<const uint8_t*>(&second));
+    session.discard();
+    CHECK_FALSE(session.isDirty());
+    CHECK(elevationAt() == 2.f);
+}
+
+//  explicit EditSession(Dataset& dataset);
+TEST_CASE("test edit session read only", "[editsession][constructor]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    REQUIRE_THROWS_AS(EditSession{*pDataset}, BAG::ReadOnlyError);
+}
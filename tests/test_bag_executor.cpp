@@ -0,0 +1,283 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_executor.h>
+#include <bag_layer.h>
+#include <bag_readqueue.h>
+
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::Executor;
+using BAG::LayerTile;
+using BAG::ReadQueue;
+using BAG::UInt8Array;
+
+//  template <typename Function>
+//  auto submit(Function&& function) -> std::future<decltype(function())>;
+//  template <typename Function>
+//  auto submit(const void* strand, Function&& function)
+//      -> std::future<decltype(function())>;
+//  void setNumThreads(uint32_t numThreads);
+TEST_CASE("test executor", "[executor][submit][setNumThreads]")
+{
+    Executor executor{4};
+    CHECK(executor.getNumThreads() == 4);
+
+    SECTION("run tasks")
+    {
+        std::vector<std::future<int>> results;
+        for (int i=0; i<100; ++i)
+            results.push_back(executor.submit([i]() { return i * i; }));
+
+        for (int i=0; i<100; ++i)
+            CHECK(results[i].get() == i * i);
+
+        auto failed = executor.submit([]() -> int {
+            throw std::runtime_error{"failed"};
+        });
+        CHECK_THROWS_AS(failed.get(), std::runtime_error);
+    }
+
+    SECTION("run the tasks of a strand one at a time, in order")
+    {
+        const int strand = 0;
+        std::atomic<int> running{0};
+        std::atomic<bool> overlapped{false};
+        std::vector<int> order;
+
+        std::vector<std::future<void>> results;
+        for (int i=0; i<100; ++i)
+            results.push_back(executor.submit(&strand, [&, i]() {
+                if (++running > 1)
+                    overlapped = true;
+
+                order.push_back(i);
+                --running;
+            }));
+
+        for (auto& result : results)
+            result.get();
+
+        CHECK_FALSE(overlapped);
+        REQUIRE(order.size() == 100);
+        for (int i=0; i<100; ++i)
+            CHECK(order[i] == i);
+    }
+
+    SECTION("change the number of threads")
+    {
+        executor.setNumThreads(1);
+        CHECK(executor.getNumThreads() == 1);
+        CHECK(executor.submit([]() { return 1; }).get() == 1);
+
+        executor.setNumThreads(8);
+        CHECK(executor.getNumThreads() == 8);
+        CHECK(executor.submit([]() { return 2; }).get() == 2);
+    }
+}
+
+//  void setRunner(Runner runner);
+//  void setConcurrency(uint32_t numThreads);
+//  uint32_t getConcurrency() noexcept;
+TEST_CASE("test executor runner and concurrency",
+    "[executor][setRunner][setConcurrency]")
+{
+    SECTION("run tasks posted from tasks")
+    {
+        Executor executor{4};
+
+        // Posted to the deque of the thread running the outer task, and
+        // taken by the others.
+        std::atomic<int> count{0};
+        std::vector<std::future<void>> inner(100);
+        executor.submit([&]() {
+            for (auto& result : inner)
+                result = executor.submit([&count]() { ++count; });
+        }).get();
+
+        for (auto& result : inner)
+            result.get();
+
+        CHECK(count == 100);
+    }
+
+    SECTION("hand the tasks to a runner")
+    {
+        Executor executor{2};
+
+        std::vector<std::function<void()>> handed;
+        executor.setRunner([&handed](std::function<void()> task) {
+            handed.push_back(std::move(task));
+        });
+        CHECK(executor.getNumThreads() == 2);
+
+        const int strand = 0;
+        auto first = executor.submit([]() { return 1; });
+        auto second = executor.submit(&strand, []() { return 2; });
+        auto third = executor.submit(&strand, []() { return 3; });
+
+        // The strand hands its second task once the first is done.
+        REQUIRE(handed.size() == 2);
+        for (size_t i=0; i<2; ++i)
+        {
+            const auto task = std::move(handed[i]);
+            task();
+        }
+
+        REQUIRE(handed.size() == 3);
+        handed[2]();
+
+        CHECK(first.get() == 1);
+        CHECK(second.get() == 2);
+        CHECK(third.get() == 3);
+
+        // Back on the threads of the executor.
+        executor.setRunner({});
+        CHECK(executor.submit([]() { return 4; }).get() == 4);
+    }
+
+    SECTION("change the concurrency of the library")
+    {
+        const auto concurrency = BAG::getConcurrency();
+
+        BAG::setConcurrency(3);
+        CHECK(BAG::getConcurrency() == 3);
+        CHECK(Executor::global().getNumThreads() == 3);
+
+        BAG::setConcurrency(concurrency);
+        CHECK(BAG::getConcurrency() == concurrency);
+    }
+}
+
+//  std::future<UInt8Array> readAsync(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd,
+//      Executor& executor = Executor::global()) const;
+//  std::future<void> writeAsync(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, UInt8Array buffer,
+//      Executor& executor = Executor::global());
+TEST_CASE("test layer read and write async", "[executor][readAsync][writeAsync]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    SECTION("read")
+    {
+        // Read here while the read on the executor may run.
+        BAG::OpenOptions options;
+        options.concurrentReads = true;
+
+        const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+            options);
+        REQUIRE(pDataset);
+
+        const auto& layer = pDataset->getLayer(Elevation);
+        auto result = layer.readAsync(10, 10, 19, 29);
+
+        const auto expected = layer.read(10, 10, 19, 29);
+        const auto data = result.get();
+        REQUIRE(data.size() == expected.size());
+        CHECK(std::memcmp(data.data(), expected.data(), data.size()) == 0);
+
+        // Outside the grid.
+        CHECK_THROWS(layer.readAsync(0, 0, 0, 100000).get());
+    }
+
+    SECTION("write")
+    {
+        const TestUtils::RandomFileGuard tmpBagFile;
+        {
+            const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+            REQUIRE(pSource);
+            BAG::copyDataset(*pSource, tmpBagFile, {});
+        }
+
+        const auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READ_WRITE);
+        REQUIRE(pDataset);
+        auto& layer = pDataset->getLayer(Elevation);
+
+        UInt8Array buffer{2 * 3 * sizeof(float)};
+        const float values[6] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+        std::memcpy(buffer.data(), values, sizeof(values));
+
+        auto written = layer.writeAsync(4, 5, 5, 7, std::move(buffer));
+
+        // Runs after the write, as it was submitted after it.
+        auto read = layer.readAsync(4, 5, 5, 7);
+
+        written.get();
+        const auto data = read.get();
+        REQUIRE(data.size() == sizeof(values));
+        CHECK(std::memcmp(data.data(), values, sizeof(values)) == 0);
+
+        // Too small a buffer.
+        CHECK_THROWS_AS(layer.writeAsync(0, 0, 9, 9, UInt8Array{4}),
+            BAG::InvalidBuffer);
+    }
+}
+
+//  size_t submit(const Layer& layer, uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd);
+//  size_t submit(const Layer& layer, const std::vector<LayerTile>& windows);
+//  bool next(LayerTile& window, size_t& index);
+TEST_CASE("test read queue", "[readqueue][submit][next]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    // Read here while the reads on the executor may run.
+    BAG::OpenOptions options;
+    options.concurrentReads = true;
+
+    const auto pFirst = Dataset::open(bagFileName, BAG_OPEN_READONLY, options);
+    REQUIRE(pFirst);
+    const auto pSecond = Dataset::open(bagFileName, BAG_OPEN_READONLY,
+        options);
+    REQUIRE(pSecond);
+
+    const auto& first = pFirst->getLayer(Elevation);
+    const auto& second = pSecond->getLayer(Elevation);
+
+    ReadQueue queue;
+
+    std::vector<LayerTile> windows(3);
+    for (uint32_t i=0; i<3; ++i)
+    {
+        windows[i].rowStart = i * 10;
+        windows[i].rowEnd = i * 10 + 9;
+        windows[i].columnEnd = 49;
+    }
+
+    CHECK(queue.submit(first, windows) == 0);
+    CHECK(queue.submit(second, 30, 0, 39, 49) == 3);
+    CHECK(queue.size() == 4);
+
+    std::set<size_t> indexes;
+    LayerTile window;
+    size_t index = 0;
+    while (queue.next(window, index))
+    {
+        indexes.insert(index);
+
+        const auto expected = first.read(window.rowStart, window.columnStart,
+            window.rowEnd, window.columnEnd);
+        REQUIRE(window.data.size() == expected.size());
+        CHECK(std::memcmp(window.data.data(), expected.data(),
+            expected.size()) == 0);
+    }
+
+    CHECK(indexes == std::set<size_t>{0, 1, 2, 3});
+    CHECK_FALSE(queue.next(window));
+}
+
@@ -0,0 +1,272 @@
+#include "test_utils.h"
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_export.h>
+#include <bag_simplelayer.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::ExportOptions;
+
+namespace {
+
+//! The entries of an image file directory of a classic TIFF, by tag.
+struct TiffImage final
+{
+    std::map<uint16_t, std::vector<uint64_t>> values;
+    std::map<uint16_t, std::vector<double>> doubles;
+};
+
+//! Read a file.
+std::vector<uint8_t> readFile(const std::string& fileName)
+{
+    std::ifstream file{fileName, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file},
+        std::istreambuf_iterator<char>{}};
+}
+
+template <typename T>
+T get(const std::vector<uint8_t>& bytes, uint64_t offset)
+{
+    T value{};
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+//! Read the directories of a classic TIFF in the byte order of the host.
+std::vector<TiffImage> readTiff(const std::vector<uint8_t>& bytes)
+{
+    std::vector<TiffImage> images;
+
+    for (auto offset = uint64_t{get<uint32_t>(bytes, 4)}; offset != 0;)
+    {
+        TiffImage image;
+
+        const auto numEntries = get<uint16_t>(bytes, offset);
+        for (uint16_t i=0; i<numEntries; ++i)
+        {
+            const auto entry = offset + 2 + i * 12;
+            const auto tag = get<uint16_t>(bytes, entry);
+            const auto type = get<uint16_t>(bytes, entry + 2);
+            const auto count = get<uint32_t>(bytes, entry + 4);
+
+            const size_t size = type == 3 ? 2 : (type == 12 ? 8 :
+                (type == 2 ? 1 : 4));
+            const auto valueOffset = size * count <= 4 ? entry + 8 :
+                get<uint32_t>(bytes, entry + 8);
+
+            for (uint32_t j=0; j<count; ++j)
+            {
+                const auto at = valueOffset + j * size;
+                if (type == 3)
+                    image.values[tag].push_back(get<uint16_t>(bytes, at));
+                else if (type == 4)
+                    image.values[tag].push_back(get<uint32_t>(bytes, at));
+                else if (type == 12)
+                    image.doubles[tag].push_back(get<double>(bytes, at));
+            }
+        }
+
+        images.push_back(std::move(image));
+        offset = get<uint32_t>(bytes, offset + 2 + numEntries * 12);
+    }
+
+    return images;
+}
+
+}  // namespace
+
+//  void exportLayer(const Dataset& dataset, LayerType type,
+//      const std::string& fileName, const ExportOptions& options = {});
+TEST_CASE("test export layer geotiff", "[export][exportLayer]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    ExportOptions options;
+    options.tileSize = 16;
+    options.compressionLevel = 0;
+
+    UNSCOPED_INFO("Export the elevations, uncompressed.");
+    REQUIRE_NOTHROW(BAG::exportLayer(*pDataset, Elevation, tmpFileName,
+        options));
+
+    const auto bytes = readFile(tmpFileName);
+    REQUIRE(bytes.size() > 8);
+    CHECK(get<uint16_t>(bytes, 2) == 42);
+
+    const auto images = readTiff(bytes);
+    REQUIRE(images.size() > 1);
+
+    const auto& image = images.front();
+    CHECK(image.values.at(256).front() == numColumns);
+    CHECK(image.values.at(257).front() == numRows);
+    CHECK(image.values.at(259).front() == 1);
+    CHECK(image.values.at(322).front() == 16);
+    CHECK(image.values.at(339).front() == 3);
+
+    const auto& offsets = image.values.at(324);
+    CHECK(offsets.size() ==
+        ((numRows + 15) / 16) * ((numColumns + 15) / 16));
+
+    UNSCOPED_INFO("The overviews halve the resolution until one fits a tile.");
+    const auto& coarsest = images.back();
+    CHECK(coarsest.values.at(254).front() == 1);
+    CHECK(coarsest.values.at(256).front() <= 16);
+    CHECK(coarsest.values.at(257).front() <= 16);
+
+    UNSCOPED_INFO("The overview tiles come before the full resolution tiles.");
+    for (size_t i=1; i<images.size(); ++i)
+        CHECK(images[i].values.at(324).back() < offsets.front());
+
+    UNSCOPED_INFO("The tie point is the north west node.");
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    const auto& tiePoint = image.doubles.at(33922);
+    REQUIRE(tiePoint.size() == 6);
+    CHECK(tiePoint[3] == Catch::Approx(originX));
+    CHECK(tiePoint[4] == Catch::Approx(originY + (numRows - 1) * spacingY));
+    CHECK(image.doubles.at(33550)[0] == Catch::Approx(spacingX));
+
+    UNSCOPED_INFO("The first tile starts with the north west node.");
+    const auto northRow = pDataset->getLayer(Elevation).read(numRows - 1, 0,
+        numRows - 1, 15);
+    CHECK(std::memcmp(bytes.data() + offsets.front(), northRow.data(),
+        16 * sizeof(float)) == 0);
+}
+
+//  void exportLayer(const Dataset& dataset, LayerType type,
+//      const std::string& fileName, const ExportOptions& options = {});
+TEST_CASE("test export layer compressed geotiff", "[export][exportLayer]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const TestUtils::RandomFileGuard rawFileName;
+    const TestUtils::RandomFileGuard deflatedFileName;
+
+    ExportOptions options;
+    options.tileSize = 32;
+    options.compressionLevel = 0;
+    REQUIRE_NOTHROW(BAG::exportLayer(*pDataset, Uncertainty, rawFileName,
+        options));
+
+    options.compressionLevel = 9;
+    REQUIRE_NOTHROW(BAG::exportLayer(*pDataset, Uncertainty, deflatedFileName,
+        options));
+
+    const auto rawBytes = readFile(rawFileName);
+    const auto deflatedBytes = readFile(deflatedFileName);
+    CHECK(deflatedBytes.size() < rawBytes.size());
+
+    const auto images = readTiff(deflatedBytes);
+    REQUIRE_FALSE(images.empty());
+    CHECK(images.front().values.at(259).front() == 8);
+}
+
+//  void exportLayer(const Dataset& dataset, LayerType type,
+//      const std::string& fileName, const ExportOptions& options = {});
+TEST_CASE("test export layer raw tiles", "[export][exportLayer]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    const TestUtils::RandomFileGuard tmpDirectoryName;
+    const std::string& directoryName = tmpDirectoryName;
+
+    ExportOptions options;
+    options.format = BAG::ExportFormat::RawTiles;
+    options.tileSize = 16;
+    REQUIRE_NOTHROW(BAG::exportLayer(*pDataset, Elevation, directoryName,
+        options));
+
+    const auto numTileRows = (numRows + 15) / 16;
+    const auto numTileColumns = (numColumns + 15) / 16;
+
+    UNSCOPED_INFO("Every tile is whole, padded with the null value.");
+    for (uint32_t tileRow=0; tileRow<numTileRows; ++tileRow)
+        for (uint32_t tileColumn=0; tileColumn<numTileColumns; ++tileColumn)
+        {
+            const auto tileName = directoryName + "/" +
+                std::to_string(tileRow) + "_" + std::to_string(tileColumn) +
+                ".f32";
+            const auto bytes = readFile(tileName);
+            CHECK(bytes.size() == 16 * 16 * sizeof(float));
+
+            if (tileRow == 0 && tileColumn == 0)
+            {
+                const auto northRow = pDataset->getLayer(Elevation).read(
+                    numRows - 1, 0, numRows - 1, 15);
+                CHECK(std::memcmp(bytes.data(), northRow.data(),
+                    16 * sizeof(float)) == 0);
+            }
+
+            if (tileRow == numTileRows - 1 && numRows % 16 != 0)
+                CHECK(get<float>(bytes, 15 * 16 * sizeof(float)) ==
+                    BAG_NULL_GENERIC);
+
+            std::remove(tileName.c_str());
+        }
+}
+
+//  void exportLayer(const Dataset& dataset, LayerType type,
+//      const std::string& fileName, const ExportOptions& options = {});
+//  void exportVR(const Dataset& dataset, double resolutionX,
+//      double resolutionY, VRResampleMethod method,
+//      const std::string& fileName, const ExportOptions& options = {});
+TEST_CASE("test export invalid", "[export][exportLayer][exportVR]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    UNSCOPED_INFO("Tiles must be a multiple of 16.");
+    ExportOptions options;
+    options.tileSize = 40;
+    REQUIRE_THROWS_AS(BAG::exportLayer(*pDataset, Elevation, tmpFileName,
+        options), BAG::InvalidExportTileSize);
+
+    UNSCOPED_INFO("Only layers in the BAG can be exported.");
+    REQUIRE_THROWS_AS(BAG::exportLayer(*pDataset, Std_Dev, tmpFileName),
+        BAG::LayerNotFound);
+
+    UNSCOPED_INFO("Only a variable resolution BAG can be resampled.");
+    REQUIRE_THROWS_AS(BAG::exportVR(*pDataset, 1., 1.,
+        BAG_VR_RESAMPLE_NEAREST, tmpFileName),
+        BAG::DatasetRequiresVariableResolution);
+}
@@ -1,6 +1,7 @@
 
 #include "test_utils.h"
 #include <bag_dataset.h>
+#include <bag_exceptions.h>
 #include <bag_interleavedlegacylayer.h>
 #include <bag_types.h>
 
@@ -8,6 +9,7 @@
 #include <catch2/catch_all.hpp>
 #include <cstdlib>  // std::getenv
 #include <string>
+#include <type_traits>
 
 
 using Catch::Approx;
@@ -43,3 +45,66 @@ TEST_CASE("test interleaved legacy layer read", "[interleavedlegacylayer][read]"
         CHECK(kExpectedBuffer[i] == Approx(floats[i]));
 }
 
+
+//  ElevationSolutionGrids readElevationSolution(uint32_t rowStart,
+//      uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const;
+//  NodeGrids readNode(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+TEST_CASE("test interleaved legacy layer read group",
+    "[interleavedlegacylayer][readElevationSolution][readNode]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/example_w_qc_layers.bag"};
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(dataset);
+
+    constexpr uint32_t rowStart = 240;
+    constexpr uint32_t rowEnd = 250;
+    constexpr uint32_t columnStart = 330;
+    constexpr uint32_t columnEnd = 345;
+    constexpr uint32_t kRows = (rowEnd - rowStart) + 1;
+    constexpr uint32_t kColumns = (columnEnd - columnStart) + 1;
+
+    // Check a grid of the group matches reading the layer of its field.
+    const auto checkField = [&](BAG::LayerType layerType, const auto& grid) {
+        REQUIRE(grid.getRows() == kRows);
+        REQUIRE(grid.getColumns() == kColumns);
+
+        const auto buffer = dataset->getLayer(layerType).read(rowStart,
+            columnStart, rowEnd, columnEnd);
+        REQUIRE(buffer);
+
+        using T = typename std::decay<decltype(grid)>::type::value_type;
+        const auto* expected = reinterpret_cast<const T*>(buffer.data());
+
+        for (uint32_t row=0; row<kRows; ++row)
+            for (uint32_t column=0; column<kColumns; ++column)
+                CHECK(grid(row, column) == expected[row * kColumns + column]);
+    };
+
+    UNSCOPED_INFO("Read the elevation solution group once, from any of its layers.");
+    const auto& stdDev = dynamic_cast<const BAG::InterleavedLegacyLayer&>(
+        dataset->getLayer(Std_Dev));
+
+    const auto elevationSolution = stdDev.readElevationSolution(rowStart,
+        columnStart, rowEnd, columnEnd);
+    checkField(Shoal_Elevation, elevationSolution.shoalElevation);
+    checkField(Std_Dev, elevationSolution.stdDev);
+    checkField(Num_Soundings, elevationSolution.numSoundings);
+
+    UNSCOPED_INFO("Read the node group.");
+    const auto& hypStrength = dynamic_cast<const BAG::InterleavedLegacyLayer&>(
+        dataset->getLayer(Hypothesis_Strength));
+
+    const auto node = hypStrength.readNode(rowStart, columnStart, rowEnd,
+        columnEnd);
+    checkField(Hypothesis_Strength, node.hypothesisStrength);
+    checkField(Num_Hypotheses, node.numHypotheses);
+
+    UNSCOPED_INFO("A layer only reads its own group.");
+    REQUIRE_THROWS_AS(hypStrength.readElevationSolution(rowStart, columnStart,
+        rowEnd, columnEnd), BAG::UnsupportedGroupType);
+    REQUIRE_THROWS_AS(stdDev.readNode(rowEnd, columnStart, rowStart,
+        columnEnd), BAG::InvalidReadSize);
+}
@@ -0,0 +1,61 @@
+#include <bag_layeritems.h>
+#include <bag_uint8array.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+using BAG::LayerItems;
+using BAG::UInt8Array;
+
+//  explicit LayerItems(UInt8Array&& items);
+TEST_CASE("test layer items move from uint8array", "[layeritems][constructor]")
+{
+    UInt8Array array{16};
+    array[3] = 42;
+    const auto* address = array.data();
+
+    const LayerItems items{std::move(array)};
+    CHECK(items.size() == 16);
+    CHECK(items.data() == address);
+    CHECK(items.data()[3] == 42);
+
+    UNSCOPED_INFO("Copies share the items.");
+    const LayerItems copy{items};
+    CHECK(copy.data() == address);
+    CHECK(copy == items);
+}
+
+//  template <typename T>
+//  explicit LayerItems(std::vector<T>&& items);
+TEST_CASE("test layer items move from vector", "[layeritems][constructor]")
+{
+    std::vector<uint32_t> values{1, 2, 70000};
+    const auto* address = reinterpret_cast<const uint8_t*>(values.data());
+
+    const LayerItems items{std::move(values)};
+    CHECK(items.size() == 3 * sizeof(uint32_t));
+    CHECK(items.data() == address);
+    CHECK(items.getAs<uint32_t>() == std::vector<uint32_t>({1, 2, 70000}));
+
+    UNSCOPED_INFO("Constructing from an lvalue copies it.");
+    const std::vector<uint32_t> other{1, 2, 70000};
+    const LayerItems copied{other};
+    CHECK(copied.data() != reinterpret_cast<const uint8_t*>(other.data()));
+    CHECK(copied == items);
+}
+
+//  template <typename OldType, typename NewType>
+//  LayerItems convert() const;
+TEST_CASE("test layer items convert", "[layeritems][convert]")
+{
+    const LayerItems items{std::vector<uint32_t>{1, 2, 300}};
+
+    const auto converted = items.convert<uint32_t, uint16_t>();
+    CHECK(converted.getAs<uint16_t>() == std::vector<uint16_t>({1, 2, 300}));
+
+    REQUIRE_THROWS_AS((LayerItems{std::vector<uint8_t>(3)}.convert<uint16_t,
+        uint32_t>()), BAG::InvalidCast);
+}
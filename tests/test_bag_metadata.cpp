@@ -1,12 +1,16 @@
 
 #include "test_utils.h"
 #include <bag_dataset.h>
+#include <bag_legacy_crs.h>
 #include <bag_metadata.h>
+#include <bag_metadata_export.h>
+#include <bag_metadata_import.h>
 
 #include <catch2/catch_all.hpp>
 #include <cstdlib>  // std::getenv
 #include <fstream>  // std::ofstream
 #include <string>
+#include <vector>
 
 
 using Catch::Approx;
@@ -420,3 +424,139 @@ TEST_CASE("test load from buffer",
     CHECK(metadata.columns() == 100);
 }
 
+//  std::string exportMetadataToXML(const BagMetadata& metadata);
+TEST_CASE("test export to XML",
+    "[metadata][exportMetadataToXML][loadFromBuffer]")
+{
+    // Text that must be escaped, in the abstract.
+    auto xmlBuffer = kXMLv2MetadataBuffer;
+    const std::string abstract{"Sample Metadata"};
+    xmlBuffer.replace(xmlBuffer.find(abstract), abstract.size(),
+        "Depths &lt; 10 &amp; \"shoal\" areas");
+
+    Metadata metadata;
+    REQUIRE_NOTHROW(metadata.loadFromBuffer(xmlBuffer));
+
+    const auto xml = BAG::exportMetadataToXML(metadata.getStruct());
+    REQUIRE(!xml.empty());
+    CHECK(xml.compare(0, 38, R"(<?xml version="1.0" encoding="UTF-8"?>)") == 0);
+    CHECK(xml.find("<gco:CharacterString>Depths &lt; 10 &amp; \"shoal\" areas</gco:CharacterString>") !=
+        std::string::npos);
+
+    UNSCOPED_INFO("Check the exported XML loads back to the same metadata.");
+    Metadata exported;
+    REQUIRE_NOTHROW(exported.loadFromBuffer(xml));
+
+    const auto& original = metadata.getStruct();
+    const auto& reloaded = exported.getStruct();
+    CHECK(std::string{reloaded.fileIdentifier} == original.fileIdentifier);
+    CHECK(std::string{reloaded.identificationInfo->abstractString} ==
+        "Depths < 10 & \"shoal\" areas");
+    CHECK(std::string{reloaded.horizontalReferenceSystem->definition} ==
+        original.horizontalReferenceSystem->definition);
+    CHECK(exported.rows() == metadata.rows());
+    CHECK(exported.columns() == metadata.columns());
+    CHECK(exported.llCornerX() == Approx{metadata.llCornerX()});
+    CHECK(exported.urCornerY() == Approx{metadata.urCornerY()});
+
+    UNSCOPED_INFO("Check exporting again gives the same XML.");
+    CHECK(BAG::exportMetadataToXML(reloaded) == xml);
+}
+
+//  BagError bagImportMetadataFromXmlBuffer(const char* xmlBuffer,
+//      int bufferSize, BagMetadata& metadata, bool doValidation);
+//  void bagClearSchemaCache();
+TEST_CASE("test validate with cached schema",
+    "[metadata][bagImportMetadataFromXmlBuffer][bagClearSchemaCache]")
+{
+    const std::string bagHome{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/../../configdata"};
+    BAG::bagSetHomeFolder(bagHome.c_str());
+
+    const auto validate = []() {
+        BagMetadata metadata;
+        bagInitMetadata(metadata);
+
+        const auto err = BAG::bagImportMetadataFromXmlBuffer(
+            kXMLv2MetadataBuffer.c_str(),
+            static_cast<int>(kXMLv2MetadataBuffer.size()), metadata, true);
+
+        bagFreeMetadata(metadata);
+
+        return err;
+    };
+
+    UNSCOPED_INFO("The schema parsed by the first validation is reused.");
+    REQUIRE(validate() == BAG_SUCCESS);
+    CHECK(validate() == BAG_SUCCESS);
+
+    UNSCOPED_INFO("The schema is parsed again after clearing the cache.");
+    BAG::bagClearSchemaCache();
+    CHECK(validate() == BAG_SUCCESS);
+
+    UNSCOPED_INFO("The cache is keyed by the home folder.");
+    BAG::bagSetHomeFolder("/missing/bag/home");
+    CHECK(validate() == BAG_METADTA_SCHEMA_FILE_MISSING);
+
+    BAG::bagSetHomeFolder("");
+    BAG::bagClearSchemaCache();
+}
+
+//  std::vector<LegacyWkt> bagLegacyToWktBatch(
+//      const std::vector<BagLegacyReferenceSystem>& systems);
+//  void bagClearLegacyWktCache();
+TEST_CASE("test legacy reference system batch conversion",
+    "[metadata][bagLegacyToWktBatch][bagClearLegacyWktCache]")
+{
+    using BAG::BagDatum;
+    using BAG::BagLegacyReferenceSystem;
+    using BAG::CoordinateType;
+
+    BagLegacyReferenceSystem geodetic;
+    geodetic.coordSys = CoordinateType::Geodetic;
+    geodetic.geoParameters.datum = BagDatum::wgs84;
+
+    BagLegacyReferenceSystem utm;
+    utm.coordSys = CoordinateType::UTM;
+    utm.geoParameters.datum = BagDatum::nad83;
+    utm.geoParameters.zone = 18;
+
+    BagLegacyReferenceSystem vertical;
+    strncpy(vertical.geoParameters.vertical_datum, "MLLW", 256);
+
+    const std::vector<BagLegacyReferenceSystem> systems{geodetic, utm,
+        geodetic, vertical};
+
+    BAG::bagClearLegacyWktCache();
+    const auto converted = BAG::bagLegacyToWktBatch(systems);
+    REQUIRE(converted.size() == systems.size());
+
+    UNSCOPED_INFO("Check the batch matches converting one at a time.");
+    for (size_t i = 0; i < 3; ++i)
+    {
+        char buffer[2048];
+        REQUIRE(BAG::bagLegacyToWkt(systems[i], buffer, sizeof(buffer),
+            nullptr, 0) == BAG_SUCCESS);
+
+        CHECK(converted[i].error == BAG_SUCCESS);
+        CHECK(converted[i].horizontal == buffer);
+        CHECK(converted[i].vertical.empty());
+    }
+    CHECK(converted[0].horizontal.find("WGS 84") != std::string::npos);
+    CHECK(converted[1].horizontal.find("UTM Zone 18") != std::string::npos);
+
+    UNSCOPED_INFO("Check a vertical datum alone has no horizontal system.");
+    char buffer[1024];
+    REQUIRE(BAG::bagLegacyToWkt(vertical, nullptr, 0, buffer,
+        sizeof(buffer)) == BAG_SUCCESS);
+    CHECK(converted[3].vertical == buffer);
+    CHECK(converted[3].error == BAG_METADTA_INVALID_PROJECTION);
+
+    UNSCOPED_INFO("Check a conversion truncates to the buffer.");
+    char small[16];
+    REQUIRE(BAG::bagLegacyToWkt(utm, small, sizeof(small), nullptr, 0) ==
+        BAG_SUCCESS);
+    CHECK(std::string{small} == converted[1].horizontal.substr(0, 15));
+
+    BAG::bagClearLegacyWktCache();
+}
@@ -0,0 +1,194 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_layer.h>
+#include <bag_mosaic.h>
+#include <bag_simplelayer.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::CopyOptions;
+using BAG::MosaicOptions;
+using BAG::MosaicSource;
+
+//  std::shared_ptr<Dataset> mosaicDatasets(
+//      const std::vector<MosaicSource>& sources, const std::string& fileName,
+//      const MosaicOptions& options);
+TEST_CASE("test mosaic datasets", "[mosaic][mosaicDatasets]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pSource->getDescriptor().getDims();
+    REQUIRE(numRows > 60);
+
+    // The south of the grid, and the north with every node 7 m with an
+    // uncertainty of 1 cm; they overlap from row 40 to row 59.
+    constexpr uint32_t kSouthEnd = 59;
+    constexpr uint32_t kNorthStart = 40;
+    constexpr float kNorthElevation = 7.f;
+    constexpr float kNorthUncertainty = 0.01f;
+
+    const TestUtils::RandomFileGuard tmpSouthFile;
+    const TestUtils::RandomFileGuard tmpNorthFile;
+
+    {
+        CopyOptions options;
+        options.rowEnd = kSouthEnd;
+        BAG::copyDataset(*pSource, tmpSouthFile, options);
+
+        options.rowStart = kNorthStart;
+        options.rowEnd = numRows - 1;
+        const auto pNorth = BAG::copyDataset(*pSource, tmpNorthFile, options);
+        REQUIRE(pNorth);
+
+        const auto northRows = numRows - kNorthStart;
+        const std::vector<float> elevations(northRows * numColumns,
+            kNorthElevation);
+        const std::vector<float> uncertainties(northRows * numColumns,
+            kNorthUncertainty);
+
+        pNorth->getLayer(Elevation).write(0, 0, northRows - 1, numColumns - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+        pNorth->getLayer(Uncertainty).write(0, 0, northRows - 1,
+            numColumns - 1,
+            reinterpret_cast<const uint8_t*>(uncertainties.data()));
+    }
+
+    const auto expected = pSource->getLayer(Elevation).readAs<float>(0, 0,
+        numRows - 1, numColumns - 1);
+
+    // The grid of the source, in chunks that straddle the overlap.
+    MosaicOptions options;
+    std::tie(options.originX, options.originY) =
+        pSource->getDescriptor().getOrigin();
+    std::tie(options.resolutionY, options.resolutionX) =
+        pSource->getDescriptor().getGridSpacing();
+    options.rows = numRows;
+    options.columns = numColumns;
+    options.chunkShape.rows = 16;
+    options.chunkShape.columns = 16;
+
+    std::vector<MosaicSource> sources{{tmpSouthFile, 0, "2020-01-01"},
+        {tmpNorthFile, 1, "2019-01-01"}};
+
+    const TestUtils::RandomFileGuard tmpMosaicFile;
+
+    // Check the mosaic takes the north from northFrom on, and the south below.
+    auto checkMosaic = [&](uint32_t northFrom) {
+        const auto pMosaic = BAG::mosaicDatasets(sources, tmpMosaicFile,
+            options);
+        REQUIRE(pMosaic);
+        CHECK(pMosaic->getDescriptor().getDims() ==
+            std::make_tuple(numRows, numColumns));
+
+        const auto mosaic = pMosaic->getLayer(Elevation).readAs<float>(0, 0,
+            numRows - 1, numColumns - 1);
+
+        uint32_t numWrong = 0;
+        for (uint32_t row=0; row<numRows; ++row)
+            for (uint32_t column=0; column<numColumns; ++column)
+                numWrong += mosaic(row, column) != (row >= northFrom ?
+                    kNorthElevation : expected(row, column));
+
+        CHECK(numWrong == 0);
+    };
+
+    SECTION("priority")
+    {
+        checkMosaic(kNorthStart);
+    }
+
+    SECTION("priority of the south")
+    {
+        sources[0].priority = 2;
+        checkMosaic(kSouthEnd + 1);
+    }
+
+    SECTION("newest")
+    {
+        options.rule = BAG::MosaicRule::Newest;
+        checkMosaic(kSouthEnd + 1);
+    }
+
+    SECTION("lowest uncertainty")
+    {
+        // Priority alone would pick the south.
+        options.rule = BAG::MosaicRule::LowestUncertainty;
+        sources[0].priority = 2;
+
+        const auto pMosaic = BAG::mosaicDatasets(sources, tmpMosaicFile,
+            options);
+        REQUIRE(pMosaic);
+
+        // Each node of the overlap has the lower of the two uncertainties.
+        const auto southUncertainties = pSource->getLayer(
+            Uncertainty).readAs<float>(kNorthStart, 0, kSouthEnd,
+            numColumns - 1);
+        const auto uncertainties = pMosaic->getLayer(Uncertainty).readAs<float>(
+            kNorthStart, 0, kSouthEnd, numColumns - 1);
+
+        uint32_t numWrong = 0, numNorth = 0;
+        for (uint32_t row=0; row<=kSouthEnd-kNorthStart; ++row)
+            for (uint32_t column=0; column<numColumns; ++column)
+            {
+                const bool north = expected(kNorthStart + row, column) ==
+                    BAG_NULL_ELEVATION ||
+                    southUncertainties(row, column) > kNorthUncertainty;
+
+                numNorth += north;
+                numWrong += uncertainties(row, column) != (north ?
+                    kNorthUncertainty : southUncertainties(row, column));
+            }
+
+        CHECK(numNorth > 0);
+        CHECK(numWrong == 0);
+    }
+
+    SECTION("coarser grid")
+    {
+        // Every other node of the source, over the south only.
+        options.resolutionX *= 2.;
+        options.resolutionY *= 2.;
+        options.rows = 20;
+        options.columns = numColumns / 2;
+
+        const auto pMosaic = BAG::mosaicDatasets(sources, tmpMosaicFile,
+            options);
+        REQUIRE(pMosaic);
+
+        const auto mosaic = pMosaic->getLayer(Elevation).readAs<float>(0, 0,
+            options.rows - 1, options.columns - 1);
+
+        uint32_t numWrong = 0;
+        for (uint32_t row=0; row<options.rows; ++row)
+            for (uint32_t column=0; column<options.columns; ++column)
+                numWrong += mosaic(row, column) !=
+                    expected(row * 2, column * 2);
+
+        CHECK(numWrong == 0);
+    }
+
+    SECTION("invalid")
+    {
+        CHECK_THROWS_AS(BAG::mosaicDatasets({}, tmpMosaicFile, options),
+            BAG::InvalidMosaicSources);
+
+        options.rows = 0;
+        CHECK_THROWS_AS(BAG::mosaicDatasets(sources, tmpMosaicFile, options),
+            BAG::InvalidResampleGrid);
+    }
+}
+
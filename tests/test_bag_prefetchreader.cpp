@@ -0,0 +1,104 @@
+
+#include <bag_dataset.h>
+#include <bag_prefetchreader.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>  // std::getenv
+#include <cstring>  // std::memcmp
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::LayerTile;
+using BAG::PrefetchReader;
+
+//  PrefetchReader(const Layer& layer, uint32_t bandHeight, size_t depth);
+//  bool next(LayerTile& window);
+TEST_CASE("test prefetch reader bands", "[prefetchreader][next]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(dataset);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = dataset->getDescriptor().getDims();
+
+    const auto& layer = dataset->getLayer(Elevation);
+    const auto expected = layer.read(0, 0, numRows - 1, numColumns - 1);
+
+    constexpr uint32_t kBandHeight = 7;
+    PrefetchReader reader{layer, kBandHeight, 3};
+    CHECK(reader.size() == (numRows + kBandHeight - 1) / kBandHeight);
+
+    // The bands arrive in order and tile the layer exactly.
+    uint32_t nextRow = 0;
+    LayerTile band;
+    while (reader.next(band))
+    {
+        CHECK(band.rowStart == nextRow);
+        CHECK(band.columnStart == 0);
+        CHECK(band.columnEnd == numColumns - 1);
+
+        const auto rows = band.rowEnd - band.rowStart + 1;
+        const auto rowSize = numColumns * sizeof(float);
+        REQUIRE(band.data.size() == rows * rowSize);
+        CHECK(std::memcmp(band.data.data(),
+            expected.data() + band.rowStart * rowSize, band.data.size()) == 0);
+
+        nextRow = band.rowEnd + 1;
+    }
+
+    CHECK(nextRow == numRows);
+    CHECK_FALSE(reader.next(band));
+}
+
+//  PrefetchReader(const Layer& layer, std::vector<LayerTile> windows,
+//      size_t depth);
+TEST_CASE("test prefetch reader windows", "[prefetchreader][next]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(dataset);
+
+    std::vector<LayerTile> windows(2);
+    windows[0].rowEnd = 1;
+    windows[0].columnEnd = 1;
+    windows[1].rowStart = 1;
+    windows[1].rowEnd = 5000000;  // past the end of the layer
+    windows[1].columnEnd = 1;
+
+    const auto& layer = dataset->getLayer(Uncertainty);
+    PrefetchReader reader{layer, std::move(windows)};
+
+    // Windows read before an error are still handed out.
+    LayerTile window;
+    REQUIRE(reader.next(window));
+    CHECK(window.data.size() == 4 * sizeof(float));
+
+    REQUIRE_THROWS_AS(reader.next(window), BAG::InvalidReadSize);
+}
+
+//  ~PrefetchReader();
+TEST_CASE("test prefetch reader stops early", "[prefetchreader][destructor]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto dataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(dataset);
+
+    LayerTile band;
+    {
+        PrefetchReader reader{dataset->getLayer(Elevation), 1, 2};
+        REQUIRE(reader.next(band));
+    }
+
+    // The dataset is still usable once the reader is gone.
+    const auto data = dataset->getLayer(Elevation).read(0, 0, 0, 0);
+    CHECK(data.size() == sizeof(float));
+}
@@ -0,0 +1,120 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_exceptions.h>
+#include <bag_layer.h>
+#include <bag_progress.h>
+#include <bag_simplelayer.h>
+
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+using BAG::CopyOptions;
+using BAG::Dataset;
+using BAG::OperationCancelled;
+using BAG::ProgressToken;
+
+//  void cancel() noexcept;
+//  bool isCancelled() const noexcept;
+//  double getFraction() const noexcept;
+//  void report(double fraction);
+TEST_CASE("test progress token", "[progress][report][cancel]")
+{
+    std::vector<double> fractions;
+    ProgressToken token{[&fractions](double fraction) {
+        fractions.push_back(fraction);
+    }};
+
+    token.report(0.25);
+    CHECK(token.getFraction() == 0.25);
+
+    // Clamped.
+    token.report(2.);
+    CHECK(token.getFraction() == 1.);
+    CHECK(fractions == std::vector<double>{0.25, 1.});
+
+    CHECK_FALSE(token.isCancelled());
+    token.cancel();
+    CHECK(token.isCancelled());
+    CHECK_THROWS_AS(token.report(0.5), OperationCancelled);
+}
+
+//  std::shared_ptr<Dataset> copyDataset(const Dataset& source,
+//      const std::string& fileName, const CopyOptions& options = {});
+TEST_CASE("test copy dataset progress", "[progress][copyDataset]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pSource);
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    SECTION("report")
+    {
+        std::vector<double> fractions;
+        ProgressToken token{[&fractions](double fraction) {
+            fractions.push_back(fraction);
+        }};
+
+        CopyOptions options;
+        options.progress = &token;
+        BAG::copyDataset(*pSource, tmpFileName, options);
+
+        REQUIRE_FALSE(fractions.empty());
+        CHECK(std::is_sorted(fractions.begin(), fractions.end()));
+        CHECK(fractions.back() == 1.);
+    }
+
+    SECTION("cancel")
+    {
+        // Cancelled once the first band is copied.
+        ProgressToken* pProgress = nullptr;
+        ProgressToken progress{[&pProgress](double) { pProgress->cancel(); }};
+        pProgress = &progress;
+
+        CopyOptions options;
+        options.progress = &progress;
+        CHECK_THROWS_AS(BAG::copyDataset(*pSource, tmpFileName, options),
+            OperationCancelled);
+
+        // The copy is a valid BAG, with the grid of the source.
+        const auto pCopy = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pCopy);
+        CHECK(pCopy->getDescriptor().getDims() ==
+            pSource->getDescriptor().getDims());
+        CHECK(pCopy->getSimpleLayer(Elevation));
+    }
+}
+
+//  LayerStatistics computeStatistics(const StatsOptions& options = {}) const;
+TEST_CASE("test statistics progress", "[progress][computeStatistics]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    ProgressToken token;
+
+    BAG::StatsOptions options;
+    options.progress = &token;
+
+    const auto statistics = pElevation->computeStatistics(options);
+    CHECK(statistics.count == pElevation->computeStatistics().count);
+    CHECK(token.getFraction() == 1.);
+
+    token.cancel();
+    CHECK_THROWS_AS(pElevation->computeStatistics(options), OperationCancelled);
+}
@@ -3,12 +3,22 @@
 #include <bag_dataset.h>
 #include <bag_metadata.h>
 #include <bag_simplelayer.h>
+#include <bag_simplelayerdescriptor.h>
+#include <bag_typedsimplelayer.h>
 #include <bag_types.h>
 
+#include <algorithm>
 #include <array>
 #include <catch2/catch_all.hpp>
+#include <cmath>
 #include <cstdlib>  // std::getenv
+#include <H5Cpp.h>
+#include <limits>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 using BAG::Dataset;
@@ -619,3 +629,1763 @@ TEST_CASE("test simple layer write attributes", "[simplelayer][write]")
     CHECK(actualMinMax == std::make_tuple(kExpectedMin, kExpectedMax));
 }
 
+
+//  LayerTiles tiles() const;
+TEST_CASE("test simple layer tiles", "[simplelayer][tiles]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr BAG::LayerType kLayerType = Elevation;
+    constexpr uint64_t kChunkSize = 30;
+    constexpr uint32_t kGridSize = 100;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        kChunkSize, 5);
+    REQUIRE(pDataset);
+
+    auto& elevLayer = pDataset->getLayer(kLayerType);
+
+    // Write a unique value into every node.
+    std::vector<float> grid(kGridSize * kGridSize);
+    for (size_t i=0; i<grid.size(); ++i)
+        grid[i] = static_cast<float>(i);
+
+    REQUIRE_NOTHROW(elevLayer.write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(grid.data())));
+
+    UNSCOPED_INFO("Check the tiles follow the chunk layout.");
+    const auto tiles = elevLayer.tiles();
+    CHECK(tiles.getTileRows() == kChunkSize);
+    CHECK(tiles.getTileColumns() == kChunkSize);
+    CHECK(tiles.getNumTileRows() == 4);
+    CHECK(tiles.getNumTileColumns() == 4);
+    CHECK(tiles.size() == 16);
+
+    UNSCOPED_INFO("Check every node is visited exactly once with the right value.");
+    std::vector<int> visited(grid.size(), 0);
+    size_t numTiles = 0;
+
+    for (const auto& tile : tiles)
+    {
+        REQUIRE(tile.data);
+        CHECK(tile.rowStart % kChunkSize == 0);
+        CHECK(tile.columnStart % kChunkSize == 0);
+
+        const uint32_t columns = tile.columnEnd - tile.columnStart + 1;
+        const auto* floats = reinterpret_cast<const float*>(tile.data.data());
+
+        for (uint32_t row=tile.rowStart; row<=tile.rowEnd; ++row)
+            for (uint32_t column=tile.columnStart; column<=tile.columnEnd; ++column)
+            {
+                const size_t index = row * kGridSize + column;
+                ++visited[index];
+                CHECK(floats[(row - tile.rowStart) * columns +
+                    (column - tile.columnStart)] == grid[index]);
+            }
+
+        ++numTiles;
+    }
+
+    CHECK(numTiles == 16);
+    CHECK(std::all_of(begin(visited), end(visited),
+        [](int count) { return count == 1; }));
+
+    UNSCOPED_INFO("Check a single clipped tile can be read by position.");
+    const auto tile = tiles.getTile(3, 1);
+    CHECK(tile.rowStart == 90);
+    CHECK(tile.rowEnd == kGridSize - 1);
+    CHECK(tile.columnStart == 30);
+    CHECK(tile.columnEnd == 59);
+    REQUIRE(tile.data.size() == 10 * 30 * sizeof(float));
+    CHECK(reinterpret_cast<const float*>(tile.data.data())[0] ==
+        grid[90 * kGridSize + 30]);
+
+    REQUIRE_THROWS_AS(tiles.getTile(4, 0), BAG::InvalidReadSize);
+}
+
+//  void readInto(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd, uint8_t* buffer, size_t bufferSize,
+//      size_t rowStrideBytes = 0) const;
+TEST_CASE("test simple layer read into", "[simplelayer][readInto]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/NAVO_data/JD211_public_Release_1-4_UTM.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& elevLayer = pDataset->getLayer(Elevation);
+
+    constexpr uint32_t rowStart = 288;
+    constexpr uint32_t rowEnd = 289;
+    constexpr uint32_t columnStart = 249;
+    constexpr uint32_t columnEnd = 251;
+    constexpr size_t kRows = (rowEnd - rowStart) + 1;
+    constexpr size_t kColumns = (columnEnd - columnStart) + 1;
+
+    const auto expected = elevLayer.read(rowStart, columnStart, rowEnd,
+        columnEnd);
+    REQUIRE(expected);
+    const auto* expectedFloats = reinterpret_cast<const float*>(expected.data());
+
+    UNSCOPED_INFO("Read into a tightly packed buffer.");
+    {
+        std::array<float, kRows * kColumns> buffer{};
+
+        REQUIRE_NOTHROW(elevLayer.readInto(rowStart, columnStart, rowEnd,
+            columnEnd, reinterpret_cast<uint8_t*>(buffer.data()),
+            sizeof(buffer)));
+
+        for (size_t i=0; i<buffer.size(); ++i)
+            CHECK(buffer[i] == expectedFloats[i]);
+    }
+
+    UNSCOPED_INFO("Read into a sub-rectangle of a larger mosaic.");
+    {
+        constexpr size_t kMosaicColumns = 8;
+        constexpr size_t kMosaicRows = 4;
+        constexpr float kSentinel = -1.f;
+        std::array<float, kMosaicRows * kMosaicColumns> mosaic;
+        mosaic.fill(kSentinel);
+
+        // Place the window at row 1, column 2 of the mosaic.
+        auto* dst = reinterpret_cast<uint8_t*>(&mosaic[1 * kMosaicColumns + 2]);
+        const auto dstSize = sizeof(mosaic) -
+            (1 * kMosaicColumns + 2) * sizeof(float);
+
+        REQUIRE_NOTHROW(elevLayer.readInto(rowStart, columnStart, rowEnd,
+            columnEnd, dst, dstSize, kMosaicColumns * sizeof(float)));
+
+        for (size_t row=0; row<kMosaicRows; ++row)
+            for (size_t column=0; column<kMosaicColumns; ++column)
+            {
+                const auto value = mosaic[row * kMosaicColumns + column];
+                if (row >= 1 && row < 1 + kRows && column >= 2 &&
+                    column < 2 + kColumns)
+                    CHECK(value == expectedFloats[(row - 1) * kColumns +
+                        (column - 2)]);
+                else
+                    CHECK(value == kSentinel);
+            }
+    }
+
+    UNSCOPED_INFO("Reject buffers that are too small.");
+    {
+        std::array<float, kRows * kColumns> buffer{};
+
+        REQUIRE_THROWS(elevLayer.readInto(rowStart, columnStart, rowEnd,
+            columnEnd, reinterpret_cast<uint8_t*>(buffer.data()),
+            sizeof(buffer) - 1));
+        REQUIRE_THROWS(elevLayer.readInto(rowStart, columnStart, rowEnd,
+            columnEnd, nullptr, sizeof(buffer)));
+    }
+}
+
+// Regression benchmark for the per-call overhead of small reads.
+// Hidden by default; run with: bag_tests "[simplelayer][.benchmark]"
+//  template <typename T>
+//  Grid<T> readAs(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd) const;
+TEST_CASE("test simple layer read as", "[simplelayer][readAs]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/example_w_qc_layers.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    constexpr uint32_t rowStart = 0;
+    constexpr uint32_t rowEnd = 4;
+    constexpr uint32_t columnStart = 1;
+    constexpr uint32_t columnEnd = 3;
+    constexpr uint32_t kRows = (rowEnd - rowStart) + 1;
+    constexpr uint32_t kColumns = (columnEnd - columnStart) + 1;
+
+    UNSCOPED_INFO("Read a layer as its own type.");
+    {
+        const auto& elevLayer = pDataset->getLayer(Elevation);
+
+        const auto expected = elevLayer.read(rowStart, columnStart, rowEnd,
+            columnEnd);
+        const auto* expectedFloats = reinterpret_cast<const float*>(
+            expected.data());
+
+        const auto grid = elevLayer.readAs<float>(rowStart, columnStart,
+            rowEnd, columnEnd);
+        REQUIRE(grid.getRows() == kRows);
+        REQUIRE(grid.getColumns() == kColumns);
+        CHECK(grid.getStride() >= kColumns);
+        CHECK(reinterpret_cast<uintptr_t>(grid.data()) %
+            BAG::kGridAlignment == 0);
+
+        for (uint32_t row=0; row<kRows; ++row)
+            for (uint32_t column=0; column<kColumns; ++column)
+                CHECK(grid(row, column) == expectedFloats[row * kColumns +
+                    column]);
+    }
+
+    UNSCOPED_INFO("Read an integer layer as floats.");
+    {
+        const auto& numSoundings = pDataset->getLayer(Num_Soundings);
+        REQUIRE(numSoundings.getDescriptor()->getDataType() == DT_UINT32);
+
+        const auto expected = numSoundings.read(rowStart, columnStart, rowEnd,
+            columnEnd);
+        const auto* expectedCounts = reinterpret_cast<const uint32_t*>(
+            expected.data());
+
+        const auto grid = numSoundings.readAs<float>(rowStart, columnStart,
+            rowEnd, columnEnd);
+        REQUIRE(grid.getRows() == kRows);
+
+        for (uint32_t row=0; row<kRows; ++row)
+            for (uint32_t column=0; column<kColumns; ++column)
+                CHECK(grid.row(row)[column] == static_cast<float>(
+                    expectedCounts[row * kColumns + column]));
+    }
+
+    UNSCOPED_INFO("Reject sections outside the grid.");
+    {
+        const auto& elevLayer = pDataset->getLayer(Elevation);
+
+        REQUIRE_THROWS_AS(elevLayer.readAs<float>(rowEnd, 0, rowStart, 0),
+            BAG::InvalidReadSize);
+        REQUIRE_THROWS_AS(elevLayer.readAs<float>(0, 0, 0,
+            std::numeric_limits<uint32_t>::max()), BAG::InvalidReadSize);
+    }
+}
+
+TEST_CASE("test typed simple layer", "[simplelayer][TypedSimpleLayer]")
+{
+    static_assert(std::is_same<BAG::LayerTraits<Elevation>::value_type,
+        float>::value, "Elevation is float");
+    static_assert(std::is_same<BAG::LayerTraits<Num_Soundings>::value_type,
+        uint32_t>::value, "Num_Soundings is uint32_t");
+    static_assert(BAG::LayerTraits<Num_Hypotheses>::getDataType() == DT_UINT32,
+        "Num_Hypotheses is DT_UINT32");
+    static_assert(BAG::LayerTraits<Uncertainty>::getNullValue() ==
+        BAG_NULL_UNCERTAINTY, "Uncertainty null");
+
+    UNSCOPED_INFO("The traits match the runtime description of each layer.");
+    for (const auto layerType : {Elevation, Uncertainty, Hypothesis_Strength,
+        Num_Hypotheses, Shoal_Elevation, Std_Dev, Num_Soundings,
+        Average_Elevation, Nominal_Elevation})
+        BAG::visitLayerTraits(layerType, [layerType](auto traits) {
+            using Traits = decltype(traits);
+
+            CHECK(Traits::getLayerType() == layerType);
+            CHECK(Traits::getDataType() == BAG::Layer::getDataType(layerType));
+            CHECK(Traits::getElementSize() ==
+                BAG::Layer::getElementSize(Traits::getDataType()));
+            CHECK(Traits::getInternalPath() ==
+                BAG::Layer::getInternalPath(layerType));
+        });
+
+    REQUIRE_THROWS_AS(BAG::visitLayerTraits(Surface_Correction,
+        [](auto) {}), BAG::UnsupportedSimpleLayerType);
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 6);
+    REQUIRE(pDataset);
+
+    uint32_t rows = 0, columns = 0;
+    std::tie(rows, columns) = pDataset->getDescriptor().getDims();
+
+    UNSCOPED_INFO("Write the whole grid; null nodes do not set the min/max.");
+    BAG::TypedSimpleLayer<Elevation> elevation{*pDataset};
+
+    std::vector<float> values(static_cast<size_t>(rows) * columns,
+        elevation.getNullValue());
+    values[0] = -12.5f;
+    values[values.size() - 1] = 40.25f;
+
+    elevation.write(0, 0, rows - 1, columns - 1, values.data());
+
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) = elevation.getLayer().getDescriptor()->getMinMax();
+    CHECK(min == -12.5f);
+    CHECK(max == 40.25f);
+
+    UNSCOPED_INFO("Read it back as floats.");
+    const auto grid = elevation.read(0, 0, rows - 1, columns - 1);
+    REQUIRE(grid.getRows() == rows);
+    REQUIRE(grid.getColumns() == columns);
+    CHECK(grid(0, 0) == -12.5f);
+    CHECK(grid(rows - 1, columns - 1) == 40.25f);
+    CHECK(elevation.isNull(grid(0, 1)));
+
+    std::vector<float> readBack(columns);
+    elevation.readInto(0, 0, 0, columns - 1, readBack.data(), readBack.size());
+    CHECK(readBack[0] == -12.5f);
+
+    UNSCOPED_INFO("The layer must be of the right type, and exist.");
+    REQUIRE_THROWS_AS(BAG::TypedSimpleLayer<Uncertainty>{
+        pDataset->getSimpleLayer(Elevation)}, BAG::InvalidLayerId);
+    REQUIRE_THROWS_AS(BAG::TypedSimpleLayer<Num_Soundings>{*pDataset},
+        BAG::LayerNotFound);
+}
+
+TEST_CASE("benchmark simple layer small reads", "[simplelayer][read][.benchmark]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/NAVO_data/JD211_public_Release_1-4_UTM.bag"};
+
+    const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& elevLayer = pDataset->getLayer(Elevation);
+
+    std::array<float, 16 * 16> buffer{};
+    auto* dst = reinterpret_cast<uint8_t*>(buffer.data());
+
+    BENCHMARK("read 1x1")
+    {
+        return elevLayer.read(288, 250, 288, 250);
+    };
+
+    BENCHMARK("read 16x16")
+    {
+        return elevLayer.read(280, 240, 295, 255);
+    };
+
+    BENCHMARK("readInto 1x1")
+    {
+        elevLayer.readInto(288, 250, 288, 250, dst, sizeof(buffer));
+        return buffer[0];
+    };
+
+    BENCHMARK("readInto 16x16")
+    {
+        elevLayer.readInto(280, 240, 295, 255, dst, sizeof(buffer));
+        return buffer[0];
+    };
+}
+
+//  void Dataset::setDeferAttributeWrites(bool defer);
+TEST_CASE("test simple layer write with deferred attributes", "[simplelayer][write][flushAttributes]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr BAG::LayerType kLayerType = Elevation;
+    constexpr float kMinValue = -12.5f;
+    constexpr float kMaxValue = 37.25f;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            100, 5);
+        REQUIRE(pDataset);
+
+        pDataset->setDeferAttributeWrites(true);
+        CHECK(pDataset->isDeferringAttributeWrites());
+
+        auto& elevLayer = pDataset->getLayer(kLayerType);
+
+        // Stream a few strips; the attributes are only tracked in memory.
+        std::array<float, 10> strip;
+        for (uint32_t row=0; row<4; ++row)
+        {
+            strip.fill(kMinValue + row);
+            strip[row] = kMaxValue;
+            REQUIRE_NOTHROW(elevLayer.write(row, 0, row, 9,
+                reinterpret_cast<const uint8_t*>(strip.data())));
+        }
+
+        CHECK(elevLayer.getDescriptor()->getMinMax() ==
+            std::make_tuple(kMinValue, kMaxValue));
+
+        // The attributes are written when the dataset is destroyed.
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& elevLayer = pDataset->getLayer(kLayerType);
+    CHECK(elevLayer.getDescriptor()->getMinMax() ==
+        std::make_tuple(kMinValue, kMaxValue));
+}
+
+//  void write(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd, const uint8_t* buffer);
+TEST_CASE("test simple layer write ignores null values", "[simplelayer][write]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    auto& elevLayer = pDataset->getLayer(Elevation);
+
+    // A row with only nulls leaves the min/max untouched.
+    std::array<float, 20> row;
+    row.fill(BAG_NULL_ELEVATION);
+    REQUIRE_NOTHROW(elevLayer.write(0, 0, 0, 19,
+        reinterpret_cast<const uint8_t*>(row.data())));
+
+    CHECK(elevLayer.getDescriptor()->getMinMax() ==
+        std::make_tuple(std::numeric_limits<float>::max(),
+            std::numeric_limits<float>::lowest()));
+
+    // Mix nulls and NaN in with real values.
+    for (size_t i=0; i<row.size(); ++i)
+        row[i] = (i % 3 == 0) ? -5.f + i : BAG_NULL_ELEVATION;
+    row[4] = std::numeric_limits<float>::quiet_NaN();
+
+    REQUIRE_NOTHROW(elevLayer.write(1, 0, 1, 19,
+        reinterpret_cast<const uint8_t*>(row.data())));
+
+    CHECK(elevLayer.getDescriptor()->getMinMax() ==
+        std::make_tuple(-5.f, 13.f));
+}
+
+TEST_CASE("test simple layer write whole chunks", "[simplelayer][write][writeChunks]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    // Chunks that do not divide the grid evenly leave partial edge chunks.
+    const BAG::ChunkShape kChunkShape{BAG::ChunkLayout::Tiled, 32, 24};
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = (i % 7 == 0) ? BAG_NULL_ELEVATION : -0.5f * i;
+
+    std::vector<float> band(32 * kGridSize);
+    for (size_t i=0; i<band.size(); ++i)
+        band[i] = 10.f + i % 13;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            kChunkShape, BAG::CompressionSpec{BAG::kDeflateFilter, 6,
+                BAG::ShuffleMode::Byte});
+        REQUIRE(pDataset);
+
+        UNSCOPED_INFO("Write the whole of a shuffled and deflated layer.");
+        auto& elevLayer = pDataset->getLayer(Elevation);
+        REQUIRE_NOTHROW(elevLayer.write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data())));
+
+        CHECK(elevLayer.getDescriptor()->getMinMax() ==
+            std::make_tuple(-0.5f * (kGridSize * kGridSize - 1), -0.5f));
+
+        UNSCOPED_INFO("Write a band of whole chunk rows of an uncompressed layer.");
+        auto& stdDevLayer = pDataset->createSimpleLayer(Std_Dev, kChunkShape, 0);
+        REQUIRE_NOTHROW(stdDevLayer.write(32, 0, 63, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(band.data())));
+
+        CHECK(stdDevLayer.getDescriptor()->getMinMax() ==
+            std::make_tuple(10.f, 22.f));
+    }
+
+    UNSCOPED_INFO("Check what was written is read back.");
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto buffer = pDataset->getLayer(Elevation).read(0, 0,
+        kGridSize - 1, kGridSize - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+    CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+
+    const auto bandBuffer = pDataset->getLayer(Std_Dev, {})->read(32, 0, 63,
+        kGridSize - 1);
+    REQUIRE(bandBuffer);
+    const auto* bandFloats = reinterpret_cast<const float*>(bandBuffer.data());
+    CHECK(std::equal(band.begin(), band.end(), bandFloats));
+
+    // Rows outside the band keep the fill value.
+    const auto outside = pDataset->getLayer(Std_Dev, {})->read(64, 0, 64, 0);
+    REQUIRE(outside);
+    CHECK(*reinterpret_cast<const float*>(outside.data()) == BAG_NULL_ELEVATION);
+}
+
+TEST_CASE("test simple layer write skips null chunks", "[simplelayer][write][writeChunks]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+    constexpr uint32_t kChunkSize = 20;
+
+    // Only the chunks of the first chunk row hold values.
+    std::vector<float> elevations(kGridSize * kGridSize, BAG_NULL_ELEVATION);
+    for (uint32_t row=0; row<kChunkSize; ++row)
+        for (uint32_t column=0; column<kGridSize; ++column)
+            elevations[row * kGridSize + column] = -1.f - column;
+
+    const std::vector<float> nulls(kChunkSize * kChunkSize, BAG_NULL_ELEVATION);
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            kChunkSize, 6);
+        REQUIRE(pDataset);
+
+        auto& elevLayer = pDataset->getLayer(Elevation);
+        REQUIRE_NOTHROW(elevLayer.write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data())));
+
+        CHECK(elevLayer.getDescriptor()->getMinMax() ==
+            std::make_tuple(-100.f, -1.f));
+
+        UNSCOPED_INFO("A chunk written before is overwritten with nulls.");
+        REQUIRE_NOTHROW(elevLayer.write(0, 0, kChunkSize - 1, kChunkSize - 1,
+            reinterpret_cast<const uint8_t*>(nulls.data())));
+        std::fill_n(elevations.begin(), kChunkSize * kGridSize,
+            BAG_NULL_ELEVATION);
+        for (uint32_t row=0; row<kChunkSize; ++row)
+            for (uint32_t column=kChunkSize; column<kGridSize; ++column)
+                elevations[row * kGridSize + column] = -1.f - column;
+    }
+
+    UNSCOPED_INFO("The null chunks read back as nulls.");
+    {
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        const auto buffer = pDataset->getLayer(Elevation).read(0, 0,
+            kGridSize - 1, kGridSize - 1);
+        REQUIRE(buffer);
+        const auto* floats = reinterpret_cast<const float*>(buffer.data());
+        CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+    }
+
+#if H5_VERSION_GE(1, 10, 5)
+    UNSCOPED_INFO("Only the chunks of the first chunk row are allocated.");
+    const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+    const auto h5dataSet = h5file.openDataSet("/BAG_root/elevation");
+
+    hsize_t numChunks = 0;
+    REQUIRE(H5Dget_num_chunks(h5dataSet.getId(), h5dataSet.getSpace().getId(),
+        &numChunks) >= 0);
+    CHECK(numChunks == kGridSize / kChunkSize);
+#endif
+}
+
+//  void readInto(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd, uint8_t* buffer, size_t bufferSize,
+//      size_t rowStrideBytes) const;
+TEST_CASE("test simple layer read whole chunks", "[simplelayer][read][readChunks]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+    constexpr uint32_t kRowsWritten = 70;
+
+    // Chunks that do not divide the grid evenly leave partial edge chunks.
+    const BAG::ChunkShape kChunkShape{BAG::ChunkLayout::Tiled, 32, 24};
+
+    std::vector<float> elevations(kRowsWritten * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = (i % 7 == 0) ? BAG_NULL_ELEVATION : -0.5f * i;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            kChunkShape, BAG::CompressionSpec{BAG::kDeflateFilter, 6,
+                BAG::ShuffleMode::Byte});
+        REQUIRE(pDataset);
+
+        // Leave part of a chunk row, and the last chunk row, unwritten.
+        auto& elevLayer = pDataset->getLayer(Elevation);
+        REQUIRE_NOTHROW(elevLayer.write(0, 0, kRowsWritten - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data())));
+
+        UNSCOPED_INFO("Read back chunks that may still be in the chunk cache.");
+        const auto buffer = elevLayer.read(0, 0, kRowsWritten - 1,
+            kGridSize - 1);
+        REQUIRE(buffer);
+        const auto* floats = reinterpret_cast<const float*>(buffer.data());
+        CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& elevLayer = pDataset->getLayer(Elevation);
+
+    const auto expected = [&](uint32_t row, uint32_t column) {
+        return row < kRowsWritten ? elevations[row * kGridSize + column] :
+            BAG_NULL_ELEVATION;
+    };
+
+    UNSCOPED_INFO("Read the whole layer.");
+    const auto buffer = elevLayer.read(0, 0, kGridSize - 1, kGridSize - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+
+    bool allMatch = true;
+    for (uint32_t row=0; row<kGridSize; ++row)
+        for (uint32_t column=0; column<kGridSize; ++column)
+            allMatch &= floats[row * kGridSize + column] ==
+                expected(row, column);
+    CHECK(allMatch);
+
+    UNSCOPED_INFO("Read a window not aligned to the chunks, with padded rows.");
+    constexpr uint32_t rowStart = 5, columnStart = 3;
+    constexpr uint32_t rowEnd = 98, columnEnd = 97;
+    constexpr uint32_t columns = columnEnd - columnStart + 1;
+    constexpr uint32_t stride = columns + 2;
+    constexpr float kPadding = 1234.f;
+
+    std::vector<float> window((rowEnd - rowStart + 1) * stride, kPadding);
+    REQUIRE_NOTHROW(elevLayer.readInto(rowStart, columnStart, rowEnd,
+        columnEnd, reinterpret_cast<uint8_t*>(window.data()),
+        window.size() * sizeof(float), stride * sizeof(float)));
+
+    allMatch = true;
+    for (uint32_t row=rowStart; row<=rowEnd; ++row)
+    {
+        const auto* windowRow = window.data() + (row - rowStart) * stride;
+
+        for (uint32_t column=columnStart; column<=columnEnd; ++column)
+            allMatch &= windowRow[column - columnStart] ==
+                expected(row, column);
+
+        allMatch &= windowRow[columns] == kPadding &&
+            windowRow[columns + 1] == kPadding;
+    }
+    CHECK(allMatch);
+}
+
+//  void readInto(uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd, uint8_t* buffer, size_t bufferSize,
+//      size_t rowStrideBytes) const;
+TEST_CASE("test simple layer read contiguous", "[simplelayer][read][readContiguous]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = -0.25f * i;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        // Neither chunked nor compressed, so the layer is stored contiguously.
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            0, 0);
+        REQUIRE(pDataset);
+
+        auto& elevLayer = pDataset->getLayer(Elevation);
+        REQUIRE_NOTHROW(elevLayer.write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data())));
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& elevLayer = pDataset->getLayer(Elevation);
+
+    UNSCOPED_INFO("Read a single node.");
+    const auto point = elevLayer.read(42, 17, 42, 17);
+    REQUIRE(point);
+    CHECK(*reinterpret_cast<const float*>(point.data()) ==
+        elevations[42 * kGridSize + 17]);
+
+    UNSCOPED_INFO("Read a window, with padded rows.");
+    constexpr uint32_t rowStart = 5, columnStart = 3;
+    constexpr uint32_t rowEnd = 60, columnEnd = 97;
+    constexpr uint32_t columns = columnEnd - columnStart + 1;
+    constexpr uint32_t stride = columns + 1;
+    constexpr float kPadding = 1234.f;
+
+    std::vector<float> window((rowEnd - rowStart + 1) * stride, kPadding);
+    REQUIRE_NOTHROW(elevLayer.readInto(rowStart, columnStart, rowEnd,
+        columnEnd, reinterpret_cast<uint8_t*>(window.data()),
+        window.size() * sizeof(float), stride * sizeof(float)));
+
+    bool allMatch = true;
+    for (uint32_t row=rowStart; row<=rowEnd; ++row)
+    {
+        const auto* windowRow = window.data() + (row - rowStart) * stride;
+
+        for (uint32_t column=columnStart; column<=columnEnd; ++column)
+            allMatch &= windowRow[column - columnStart] ==
+                elevations[row * kGridSize + column];
+
+        allMatch &= windowRow[columns] == kPadding;
+    }
+    CHECK(allMatch);
+
+    UNSCOPED_INFO("Read the whole layer.");
+    const auto buffer = elevLayer.read(0, 0, kGridSize - 1, kGridSize - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+    CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+}
+
+//  std::unique_ptr<StripWriter> stripWriter();
+TEST_CASE("test simple layer strip writer", "[simplelayer][write][StripWriter]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = -0.5f * (i % 97) - 0.25f * (i / 131);
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            32, 6);
+        REQUIRE(pDataset);
+
+        auto pLayer = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pLayer);
+
+        auto pWriter = pLayer->stripWriter();
+        REQUIRE(pWriter);
+
+        UNSCOPED_INFO("Write a row at a time, but for a window of the last band.");
+        for (uint32_t row=0; row<96; ++row)
+            pWriter->write(row, 0, row, kGridSize - 1,
+                reinterpret_cast<const uint8_t*>(
+                    elevations.data() + row * kGridSize));
+
+        std::vector<float> window(4 * 10);
+        for (uint32_t row=96; row<kGridSize; ++row)
+            std::copy_n(elevations.data() + row * kGridSize + 40, 10,
+                window.data() + (row - 96) * 10);
+        pWriter->write(96, 40, 99, 49,
+            reinterpret_cast<const uint8_t*>(window.data()));
+
+        pWriter->close();
+
+        CHECK_THROWS_AS(pWriter->write(0, 0, 0, 0,
+            reinterpret_cast<const uint8_t*>(elevations.data())),
+            BAG::StripWriterClosed);
+
+        UNSCOPED_INFO("Nodes outside the window keep their value in the file.");
+        for (uint32_t row=96; row<kGridSize; ++row)
+            for (uint32_t column=0; column<kGridSize; ++column)
+                if (column < 40 || column > 49)
+                    elevations[row * kGridSize + column] = BAG_NULL_ELEVATION;
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+
+    const auto buffer = pLayer->read(0, 0, kGridSize - 1, kGridSize - 1);
+    REQUIRE(buffer);
+    const auto* floats = reinterpret_cast<const float*>(buffer.data());
+    CHECK(std::equal(elevations.begin(), elevations.end(), floats));
+
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) = pLayer->getDescriptor()->getMinMax();
+    float expectedMin = 0.f;
+    for (const auto value : elevations)
+        if (value != BAG_NULL_ELEVATION)
+            expectedMin = std::min(expectedMin, value);
+    CHECK(min == expectedMin);
+    CHECK(max == 0.f);
+}
+
+//  void buildOverviews(uint32_t numLevels, OverviewMethod method);
+//  UInt8Array readOverview(uint32_t level, uint32_t rowStart,
+//      uint32_t columnStart, uint32_t rowEnd, uint32_t columnEnd) const;
+TEST_CASE("test simple layer overviews", "[simplelayer][overviews]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+    constexpr uint32_t kNumLevels = 3;
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = (i % 7 == 0) ? BAG_NULL_ELEVATION :
+            -0.5f * (i % 97) - 0.25f * (i / 131);
+
+    // Combine the nodes under an overview node of a level directly.
+    const auto expected = [&](uint32_t level, uint32_t row, uint32_t column,
+        BAG::OverviewMethod method) {
+            const auto factor = 1u << level;
+            double sum = 0.;
+            uint32_t count = 0;
+            float best = BAG_NULL_ELEVATION;
+
+            for (auto r=row*factor; r<std::min((row + 1)*factor, kGridSize); ++r)
+                for (auto c=column*factor;
+                    c<std::min((column + 1)*factor, kGridSize); ++c)
+                {
+                    const auto value = elevations[r * kGridSize + c];
+                    if (value == BAG_NULL_ELEVATION)
+                        continue;
+
+                    sum += value;
+                    ++count;
+
+                    if (best == BAG_NULL_ELEVATION ||
+                        (method == BAG::OverviewMethod::Minimum && value < best) ||
+                        (method == BAG::OverviewMethod::Shoal && value > best))
+                        best = value;
+                }
+
+            return (count > 0 && method == BAG::OverviewMethod::Mean) ?
+                static_cast<float>(sum / count) : best;
+        };
+
+    const auto checkOverviews = [&](const BAG::SimpleLayer& layer,
+        BAG::OverviewMethod method) {
+            REQUIRE(layer.getNumOverviews() == kNumLevels);
+
+            for (uint32_t level=1; level<=kNumLevels; ++level)
+            {
+                const auto size = (kGridSize + (1u << level) - 1) >> level;
+                CHECK(layer.getOverviewDims(level) == std::make_tuple(size, size));
+
+                const auto buffer = layer.readOverview(level, 0, 0, size - 1,
+                    size - 1);
+                REQUIRE(buffer);
+                const auto* floats = reinterpret_cast<const float*>(buffer.data());
+
+                bool allMatch = true;
+                for (uint32_t row=0; row<size; ++row)
+                    for (uint32_t column=0; column<size; ++column)
+                        allMatch &= std::abs(floats[row * size + column] -
+                            expected(level, row, column, method)) < 1e-3f;
+                CHECK(allMatch);
+            }
+        };
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            32, 6);
+        REQUIRE(pDataset);
+
+        auto pLayer = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pLayer);
+        pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        UNSCOPED_INFO("A layer without overviews reads only its own level.");
+        CHECK(pLayer->getNumOverviews() == 0);
+        CHECK(pDataset->selectOverviewLevel(Elevation, 1000.) == 0);
+        CHECK_THROWS_AS(pLayer->readOverview(1, 0, 0, 0, 0),
+            BAG::InvalidOverviewLevel);
+        CHECK(pLayer->readOverview(0, 0, 0, 0, 0));
+
+        UNSCOPED_INFO("Build each kind of overview; the last one stays.");
+        for (const auto method : {BAG::OverviewMethod::Minimum,
+            BAG::OverviewMethod::Shoal, BAG::OverviewMethod::Mean})
+        {
+            pLayer->buildOverviews(kNumLevels, method);
+            checkOverviews(*pLayer, method);
+        }
+
+        CHECK_THROWS_AS(pDataset->selectOverviewLevel(Num_Hypotheses, 10.),
+            BAG::LayerNotFound);
+    }
+
+    UNSCOPED_INFO("Reopen, and pick levels by output resolution.");
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    checkOverviews(*pLayer, BAG::OverviewMethod::Mean);
+
+    // The grid spacing is 10 metres.
+    CHECK(pDataset->selectOverviewLevel(Elevation, 5.) == 0);
+    CHECK(pDataset->selectOverviewLevel(Elevation, 45.) == 2);
+    CHECK(pDataset->selectOverviewLevel(Elevation, 1000.) == kNumLevels);
+
+    CHECK_THROWS_AS(pLayer->readOverview(1, 0, 0, 50, 0), BAG::InvalidReadSize);
+}
+
+//  void updateMinMax();
+TEST_CASE("test simple layer update min max", "[simplelayer][updateMinMax]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    uint64_t chunkSize = 32;
+    int compressionLevel = 6;
+
+    SECTION("unchunked")
+    {
+        chunkSize = 0;
+        compressionLevel = 0;
+    }
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+
+    std::vector<float> elevations(kGridSize * kGridSize, -10.f);
+    elevations[50 * kGridSize + 50] = -100.f;
+    elevations[99 * kGridSize + 99] = 5.f;
+    pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto checkMinMax = [&](float expectedMin, float expectedMax) {
+        float min = 0.f, max = 0.f;
+        std::tie(min, max) = pLayer->getDescriptor()->getMinMax();
+        CHECK(min == expectedMin);
+        CHECK(max == expectedMax);
+    };
+
+    pLayer->updateMinMax();
+    checkMinMax(-100.f, 5.f);
+
+    UNSCOPED_INFO("Overwriting the extremes only widens the min/max.");
+    const float shallow = -20.f;
+    pLayer->write(50, 50, 50, 50, reinterpret_cast<const uint8_t*>(&shallow));
+    const float empty = BAG_NULL_ELEVATION;
+    pLayer->write(99, 99, 99, 99, reinterpret_cast<const uint8_t*>(&empty));
+    checkMinMax(-100.f, 5.f);
+
+    UNSCOPED_INFO("Committing a batch makes the min/max exact again.");
+    pDataset->beginBatch();
+    const float deep = -30.f;
+    pLayer->write(10, 90, 10, 90, reinterpret_cast<const uint8_t*>(&deep));
+    pDataset->commit();
+    checkMinMax(-30.f, -10.f);
+
+    UNSCOPED_INFO("Whole chunk writes are summarized as they are written.");
+    std::fill(elevations.begin(), elevations.end(), -1.f);
+    pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+    pLayer->updateMinMax();
+    checkMinMax(-1.f, -1.f);
+
+    UNSCOPED_INFO("The min/max attributes are written too.");
+    pDataset->close();
+
+    const auto pReopened = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pReopened);
+
+    float min = 0.f, max = 0.f;
+    std::tie(min, max) =
+        pReopened->getSimpleLayer(Elevation)->getDescriptor()->getMinMax();
+    CHECK(min == -1.f);
+    CHECK(max == -1.f);
+
+    CHECK_THROWS_AS(pReopened->getSimpleLayer(Elevation)->updateMinMax(),
+        BAG::ReadOnlyError);
+}
+
+//  LayerStatistics computeStatistics(const StatsOptions& options = {}) const;
+TEST_CASE("test simple layer compute statistics", "[simplelayer][computeStatistics]")
+{
+    using Catch::Approx;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    uint64_t chunkSize = 32;
+    int compressionLevel = 6;
+
+    SECTION("unchunked")
+    {
+        chunkSize = 0;
+        compressionLevel = 0;
+    }
+
+    // The first row is empty.
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = i < kGridSize ? BAG_NULL_ELEVATION : static_cast<float>(i);
+
+    double expectedMean = 0.;
+    for (size_t i=kGridSize; i<elevations.size(); ++i)
+        expectedMean += elevations[i];
+    expectedMean /= elevations.size() - kGridSize;
+
+    double expectedVariance = 0.;
+    for (size_t i=kGridSize; i<elevations.size(); ++i)
+        expectedVariance += (elevations[i] - expectedMean) *
+            (elevations[i] - expectedMean);
+    expectedVariance /= elevations.size() - kGridSize;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        auto pLayer = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pLayer);
+
+        pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        BAG::StatsOptions options;
+        options.numBins = 10;
+        options.histogramMin = 0.;
+        options.histogramMax = 10000.;
+        options.percentiles = {0., 50., 100.};
+        options.writeAttributes = true;
+
+        const auto statistics = pLayer->computeStatistics(options);
+        CHECK(statistics.count == 9900);
+        CHECK(statistics.nullCount == 100);
+        CHECK(statistics.min == 100.);
+        CHECK(statistics.max == 9999.);
+        CHECK(statistics.mean == Approx(expectedMean));
+        CHECK(statistics.standardDeviation == Approx(std::sqrt(expectedVariance)));
+
+        REQUIRE(statistics.histogram.size() == 10);
+        CHECK(statistics.histogram[0] == 900);
+        for (size_t bin=1; bin<10; ++bin)
+            CHECK(statistics.histogram[bin] == 1000);
+
+        REQUIRE(statistics.percentiles.size() == 3);
+        CHECK(statistics.percentiles[0] == 100.);
+        CHECK(statistics.percentiles[1] == Approx(5049.5).epsilon(0.01));
+        CHECK(statistics.percentiles[2] == 9999.);
+
+        UNSCOPED_INFO("Restrict the statistics to a window.");
+        BAG::StatsOptions windowOptions;
+        windowOptions.rowStart = 10;
+        windowOptions.columnStart = 0;
+        windowOptions.rowEnd = 19;
+        windowOptions.columnEnd = 9;
+
+        const auto window = pLayer->computeStatistics(windowOptions);
+        CHECK(window.count == 100);
+        CHECK(window.nullCount == 0);
+        CHECK(window.min == 1000.);
+        CHECK(window.max == 1909.);
+        CHECK(window.histogram.empty());
+        CHECK(window.percentiles.empty());
+
+        UNSCOPED_INFO("Without a range, the histogram spans the layer's min/max.");
+        BAG::StatsOptions rangeOptions;
+        rangeOptions.numBins = 4;
+        const auto ranged = pLayer->computeStatistics(rangeOptions);
+        CHECK(ranged.histogramMin == 100.);
+        CHECK(ranged.histogramMax == 9999.);
+        CHECK(ranged.histogram.size() == 4);
+
+        windowOptions.rowStart = kGridSize;
+        CHECK_THROWS_AS(pLayer->computeStatistics(windowOptions),
+            BAG::InvalidReadSize);
+
+        BAG::StatsOptions badOptions;
+        badOptions.percentiles = {101.};
+        CHECK_THROWS_AS(pLayer->computeStatistics(badOptions),
+            BAG::InvalidPercentile);
+    }
+
+    UNSCOPED_INFO("The statistics were written as attributes.");
+    const ::H5::H5File h5file{tmpFileName.m_fileName, H5F_ACC_RDONLY};
+    const auto h5dataSet = h5file.openDataSet("/BAG_root/elevation");
+
+    double mean = 0.;
+    h5dataSet.openAttribute("Statistics Mean").read(
+        ::H5::PredType::NATIVE_DOUBLE, &mean);
+    CHECK(mean == Approx(expectedMean));
+
+    uint64_t nullCount = 0;
+    h5dataSet.openAttribute("Statistics Null Count").read(
+        ::H5::PredType::NATIVE_UINT64, &nullCount);
+    CHECK(nullCount == 100);
+
+    std::array<uint64_t, 10> histogram{};
+    h5dataSet.openAttribute("Statistics Histogram").read(
+        ::H5::PredType::NATIVE_UINT64, histogram.data());
+    CHECK(histogram[9] == 1000);
+}
+
+//  void buildZoneMap();
+//  bool hasZoneMap() const noexcept;
+//  std::vector<std::tuple<uint32_t, uint32_t>> findTiles(float minValue,
+//      float maxValue) const;
+TEST_CASE("test simple layer zone map", "[simplelayer][buildZoneMap][findTiles]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+    constexpr uint32_t kTileSize = 10;
+
+    using Tiles = std::vector<std::tuple<uint32_t, uint32_t>>;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            kTileSize, 6);
+        REQUIRE(pDataset);
+
+        // Each tile holds minus its index; the last row of tiles is empty.
+        std::vector<float> elevations(kGridSize * kGridSize);
+        for (uint32_t row=0; row<kGridSize; ++row)
+            for (uint32_t column=0; column<kGridSize; ++column)
+                elevations[row * kGridSize + column] =
+                    row / kTileSize == 9 ? BAG_NULL_ELEVATION :
+                    -static_cast<float>(row / kTileSize * 10 + column / kTileSize);
+
+        auto pLayer = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pLayer);
+        pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        UNSCOPED_INFO("Without a zone map every tile may match.");
+        CHECK_FALSE(pLayer->hasZoneMap());
+        CHECK(pLayer->findTiles(1.f, 2.f).size() == 100);
+
+        pLayer->buildZoneMap();
+        CHECK(pLayer->hasZoneMap());
+
+        CHECK(pLayer->findTiles(-5.5f, -2.5f) ==
+            (Tiles{{0, 3}, {0, 4}, {0, 5}}));
+        CHECK(pLayer->findTiles(1.f, 2.f).empty());
+
+        UNSCOPED_INFO("Empty tiles never match.");
+        CHECK(pLayer->findTiles(std::numeric_limits<float>::lowest(),
+            std::numeric_limits<float>::max()).size() == 90);
+
+        UNSCOPED_INFO("Writing part of a tile widens its summary.");
+        const float deep = -50.f;
+        pLayer->write(0, 0, 0, 0, reinterpret_cast<const uint8_t*>(&deep));
+        CHECK(pLayer->findTiles(-50.f, -50.f) == (Tiles{{0, 0}, {5, 0}}));
+
+        UNSCOPED_INFO("Writing a whole tile replaces its summary.");
+        std::vector<float> tile(kTileSize * kTileSize, BAG_NULL_ELEVATION);
+        pLayer->write(0, 30, kTileSize - 1, 39,
+            reinterpret_cast<const uint8_t*>(tile.data()));
+
+        // The first tile now spans -50 to 0.
+        CHECK(pLayer->findTiles(-5.5f, -2.5f) ==
+            (Tiles{{0, 0}, {0, 4}, {0, 5}}));
+    }
+
+    UNSCOPED_INFO("The zone map is read with the layer.");
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    CHECK(pLayer->hasZoneMap());
+    CHECK(pLayer->findTiles(-50.f, -50.f) == (Tiles{{0, 0}, {5, 0}}));
+    CHECK(pLayer->findTiles(-5.5f, -2.5f) ==
+        (Tiles{{0, 0}, {0, 4}, {0, 5}}));
+
+    const auto tiles = pLayer->tiles();
+    CHECK(tiles.getTileRows() == kTileSize);
+    CHECK(tiles.getNumTileColumns() == 10);
+
+    CHECK_FALSE(pDataset->getSimpleLayer(Uncertainty)->hasZoneMap());
+    CHECK_THROWS_AS(pLayer->buildZoneMap(), BAG::ReadOnlyError);
+}
+
+//  std::vector<LayerCell> findCells(float minValue, float maxValue,
+//      uint32_t rowStart, uint32_t columnStart, uint32_t rowEnd,
+//      uint32_t columnEnd) const;
+TEST_CASE("test simple layer find cells", "[simplelayer][findCells]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+    constexpr uint32_t kTileSize = 10;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        kTileSize, 6);
+    REQUIRE(pDataset);
+
+    // Each node holds its index; one is null.
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (uint32_t index=0; index<kGridSize * kGridSize; ++index)
+        elevations[index] = static_cast<float>(index);
+    elevations[12 * kGridSize + 40] = BAG_NULL_ELEVATION;
+
+    auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto expectedCells = [&](float minValue, float maxValue) {
+        std::vector<BAG::LayerCell> cells;
+        for (uint32_t index=0; index<kGridSize * kGridSize; ++index)
+            if (elevations[index] >= minValue && elevations[index] <= maxValue
+                && elevations[index] != BAG_NULL_ELEVATION)
+                cells.push_back({index / kGridSize, index % kGridSize,
+                    elevations[index]});
+
+        return cells;
+    };
+
+    const auto sameCells = [](const std::vector<BAG::LayerCell>& lhs,
+        const std::vector<BAG::LayerCell>& rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(),
+            rhs.begin(), [](const BAG::LayerCell& a, const BAG::LayerCell& b) {
+                return a.row == b.row && a.col == b.col && a.value == b.value;
+            });
+    };
+
+    for (const bool zoneMap : {false, true})
+    {
+        if (zoneMap)
+            pLayer->buildZoneMap();
+
+        UNSCOPED_INFO("zoneMap: " << zoneMap);
+
+        UNSCOPED_INFO("The cells of several tiles are in row major order.");
+        const auto cells = pLayer->findCells(1234.f, 1256.f);
+        CHECK(cells.size() == 22);
+        CHECK(sameCells(cells, expectedCells(1234.f, 1256.f)));
+
+        CHECK(sameCells(pLayer->findCells(1295.f, 1305.f),
+            expectedCells(1295.f, 1305.f)));
+        CHECK(sameCells(pLayer->findCells(100.5f, 8888.5f),
+            expectedCells(100.5f, 8888.5f)));
+
+        UNSCOPED_INFO("Only the window is searched.");
+        const auto windowCells = pLayer->findCells(0.f, 1.e6f, 10, 10, 11, 12);
+        REQUIRE(windowCells.size() == 6);
+        CHECK(windowCells.front().row == 10);
+        CHECK(windowCells.front().col == 10);
+        CHECK(windowCells.back().row == 11);
+        CHECK(windowCells.back().col == 12);
+        CHECK(windowCells.back().value == 1112.f);
+
+        CHECK(pLayer->findCells(-2.f, -1.f).empty());
+        CHECK(pLayer->findCells(2.f, 1.f).empty());
+    }
+
+    CHECK_THROWS_AS(pLayer->findCells(0.f, 1.f, kGridSize, 0),
+        BAG::InvalidReadSize);
+}
+
+//  UInt8Array readDecimated(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, uint32_t rowStep,
+//      uint32_t columnStep, DecimationMethod method) const;
+TEST_CASE("test simple layer read decimated", "[simplelayer][readDecimated]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 6);
+    REQUIRE(pDataset);
+
+    // Each node holds its index; the first 8 by 8 block is null.
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (uint32_t row=0; row<kGridSize; ++row)
+        for (uint32_t column=0; column<kGridSize; ++column)
+            elevations[row * kGridSize + column] = row < 8 && column < 8 ?
+                BAG_NULL_ELEVATION :
+                static_cast<float>(row * kGridSize + column);
+
+    auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    // 100 rows and columns in blocks of 8 are 13 blocks, the last of 4.
+    constexpr uint32_t kStep = 8;
+    constexpr uint32_t kBlocks = 13;
+
+    const auto value = [](const BAG::UInt8Array& buffer, uint32_t row,
+        uint32_t column) {
+        return reinterpret_cast<const float*>(buffer.data())[
+            row * kBlocks + column];
+    };
+
+    SECTION("sample")
+    {
+        const auto buffer = pLayer->readDecimated(0, 0, kGridSize - 1,
+            kGridSize - 1, kStep, kStep);
+        REQUIRE(buffer.size() == kBlocks * kBlocks * sizeof(float));
+
+        CHECK(value(buffer, 0, 0) == BAG_NULL_ELEVATION);
+        CHECK(value(buffer, 1, 2) == 816.f);
+        CHECK(value(buffer, 12, 12) == 9696.f);
+    }
+
+    SECTION("minimum")
+    {
+        const auto buffer = pLayer->readDecimated(0, 0, kGridSize - 1,
+            kGridSize - 1, kStep, kStep, BAG::DecimationMethod::Minimum);
+
+        UNSCOPED_INFO("A block of null nodes is null.");
+        CHECK(value(buffer, 0, 0) == BAG_NULL_ELEVATION);
+        CHECK(value(buffer, 1, 2) == 816.f);
+        CHECK(value(buffer, 12, 12) == 9696.f);
+    }
+
+    SECTION("maximum")
+    {
+        const auto buffer = pLayer->readDecimated(0, 0, kGridSize - 1,
+            kGridSize - 1, kStep, kStep, BAG::DecimationMethod::Maximum);
+
+        CHECK(value(buffer, 0, 0) == BAG_NULL_ELEVATION);
+        CHECK(value(buffer, 1, 2) == 1523.f);
+        CHECK(value(buffer, 12, 12) == 9999.f);
+    }
+
+    SECTION("mean")
+    {
+        const auto buffer = pLayer->readDecimated(0, 0, kGridSize - 1,
+            kGridSize - 1, kStep, kStep, BAG::DecimationMethod::Mean);
+
+        CHECK(value(buffer, 0, 0) == BAG_NULL_ELEVATION);
+        CHECK(value(buffer, 1, 2) == Approx(1169.5f));
+        CHECK(value(buffer, 12, 12) == Approx(9847.5f));
+
+        UNSCOPED_INFO("Null nodes are left out of the mean.");
+        const auto partial = pLayer->readDecimated(0, 0, 8, 8, 9, 9,
+            BAG::DecimationMethod::Mean);
+        REQUIRE(partial.size() == sizeof(float));
+
+        double sum = 0.;
+        uint32_t count = 0;
+        for (uint32_t row=0; row<9; ++row)
+            for (uint32_t column=0; column<9; ++column)
+                if (row == 8 || column == 8)
+                {
+                    sum += row * kGridSize + column;
+                    ++count;
+                }
+
+        CHECK(reinterpret_cast<const float*>(partial.data())[0] ==
+            Approx(sum / count));
+    }
+
+    SECTION("invalid")
+    {
+        CHECK_THROWS_AS(pLayer->readDecimated(0, 0, kGridSize - 1,
+            kGridSize - 1, 0, kStep), BAG::InvalidReadSize);
+        CHECK_THROWS_AS(pLayer->readDecimated(0, 0, kGridSize,
+            kGridSize - 1, kStep, kStep), BAG::InvalidReadSize);
+    }
+}
+
+//  LayerWindowsRead readWindows(const std::vector<LayerWindow>& windows) const;
+TEST_CASE("test simple layer read windows", "[simplelayer][readWindows]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 6);
+    REQUIRE(pDataset);
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = static_cast<float>(i);
+
+    auto& layer = pDataset->getLayer(Elevation);
+    layer.write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    // Disjoint windows, two in one chunk, two overlapping each other, and
+    // one adjacent to another in the same rows.
+    const std::vector<BAG::LayerWindow> windows{{0, 0, 3, 3}, {5, 5, 6, 8},
+        {50, 20, 69, 39}, {60, 30, 79, 49}, {99, 99, 99, 99}, {50, 40, 55, 41},
+        {12, 90, 12, 99}};
+
+    const auto read = layer.readWindows(windows);
+    REQUIRE(read.offsets.size() == windows.size());
+
+    size_t numBytes = 0;
+    for (size_t i=0; i<windows.size(); ++i)
+    {
+        const auto& window = windows[i];
+        CHECK(read.offsets[i] == numBytes);
+
+        const auto expected = layer.read(window.rowStart, window.columnStart,
+            window.rowEnd, window.columnEnd);
+        numBytes += expected.size();
+
+        REQUIRE(read.data.size() >= numBytes);
+        CHECK(std::equal(expected.data(), expected.data() + expected.size(),
+            read.data.data() + read.offsets[i]));
+    }
+    CHECK(read.data.size() == numBytes);
+
+    UNSCOPED_INFO("Check no windows read nothing.");
+    {
+        const auto none = layer.readWindows({});
+        CHECK(none.offsets.empty());
+        CHECK(none.data.size() == 0);
+    }
+
+    UNSCOPED_INFO("Check a window beyond the grid is rejected.");
+    REQUIRE_THROWS_AS(layer.readWindows({{0, 0, 0, 0},
+        {0, 0, kGridSize, 0}}), BAG::InvalidReadSize);
+}
+
+//  void buildCoverage(ProgressToken* progress = nullptr);
+//  uint64_t countCoveredNodes(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+//  UInt8Array readCoverage(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+//  std::vector<FootprintRing> getFootprint() const;
+TEST_CASE("test simple layer coverage", "[simplelayer][buildCoverage][getFootprint]")
+{
+    using Catch::Approx;
+
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            10, 6);
+        REQUIRE(pDataset);
+
+        // Rows 10 to 59 and columns 20 to 79 have values, but for a hole of
+        // rows 30 to 39 and columns 40 to 49.
+        std::vector<float> elevations(kGridSize * kGridSize,
+            BAG_NULL_ELEVATION);
+        for (uint32_t row=10; row<60; ++row)
+            for (uint32_t column=20; column<80; ++column)
+                if (row < 30 || row >= 40 || column < 40 || column >= 50)
+                    elevations[row * kGridSize + column] = -1.f;
+
+        auto pLayer = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pLayer);
+        pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        CHECK_FALSE(pLayer->hasCoverage());
+        REQUIRE_THROWS_AS(pLayer->getCoveragePercentage(),
+            BAG::CoverageNotBuilt);
+
+        pLayer->buildCoverage();
+        REQUIRE(pLayer->hasCoverage());
+
+        CHECK(pLayer->countCoveredNodes() == 2900);
+        CHECK(pLayer->getCoveragePercentage() == Approx(29.));
+        CHECK(pLayer->countCoveredNodes(30, 40, 39, 49) == 0);
+        CHECK(pLayer->countCoveredNodes(0, 21, 99, 99) == 2850);
+
+        UNSCOPED_INFO("Check the mask matches the nodes.");
+        {
+            const auto mask = pLayer->readCoverage(29, 39, 30, 41);
+            REQUIRE(mask.size() == 6);
+            CHECK(std::vector<uint8_t>(mask.data(), mask.data() + 6) ==
+                (std::vector<uint8_t>{1, 1, 1, 1, 0, 0}));
+        }
+
+        UNSCOPED_INFO("Check the footprint is a square with a hole in it.");
+        {
+            const auto& descriptor = pDataset->getDescriptor();
+
+            double originX = 0., originY = 0.;
+            std::tie(originX, originY) = descriptor.getOrigin();
+            double rowSpacing = 0., columnSpacing = 0.;
+            std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+            const auto rings = pLayer->getFootprint();
+            REQUIRE(rings.size() == 2);
+
+            const auto& outer = rings[0].hole ? rings[1] : rings[0];
+            const auto& hole = rings[0].hole ? rings[0] : rings[1];
+            CHECK_FALSE(outer.hole);
+            CHECK(hole.hole);
+            REQUIRE(outer.points.size() == 5);
+            REQUIRE(hole.points.size() == 5);
+            CHECK(outer.points.front().x == outer.points.back().x);
+            CHECK(outer.points.front().y == outer.points.back().y);
+
+            const auto minX = std::min_element(outer.points.begin(),
+                outer.points.end(), [](const auto& a, const auto& b) {
+                    return a.x < b.x;
+                })->x;
+            const auto maxY = std::max_element(outer.points.begin(),
+                outer.points.end(), [](const auto& a, const auto& b) {
+                    return a.y < b.y;
+                })->y;
+            CHECK(minX == Approx(originX + 19.5 * columnSpacing));
+            CHECK(maxY == Approx(originY + 59.5 * rowSpacing));
+        }
+
+        UNSCOPED_INFO("Check writes keep the coverage up to date.");
+        const float elevation = -2.f;
+        pLayer->write(0, 0, 0, 0, reinterpret_cast<const uint8_t*>(&elevation));
+        const std::vector<float> nulls(3, BAG_NULL_ELEVATION);
+        pLayer->write(10, 20, 10, 22,
+            reinterpret_cast<const uint8_t*>(nulls.data()));
+
+        CHECK(pLayer->countCoveredNodes() == 2898);
+        CHECK(pLayer->readCoverage(0, 0, 0, 0).data()[0] == 1);
+        CHECK(pLayer->readCoverage(10, 22, 10, 23).data()[0] == 0);
+        CHECK(pLayer->readCoverage(10, 22, 10, 23).data()[1] == 1);
+        CHECK(pLayer->getFootprint().size() == 3);
+
+        REQUIRE_THROWS_AS(pLayer->readCoverage(0, 0, kGridSize, 0),
+            BAG::InvalidReadSize);
+    }
+
+    UNSCOPED_INFO("The coverage is read with the layer.");
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    CHECK(pLayer->hasCoverage());
+    CHECK(pLayer->countCoveredNodes() == 2898);
+
+    CHECK_FALSE(pDataset->getSimpleLayer(Uncertainty)->hasCoverage());
+    CHECK_THROWS_AS(pDataset->getSimpleLayer(Uncertainty)->readCoverage(0, 0,
+        0, 0), BAG::CoverageNotBuilt);
+    CHECK_THROWS_AS(pLayer->buildCoverage(), BAG::ReadOnlyError);
+}
+
+//  std::vector<float> sample(const std::vector<double>& xs,
+//      const std::vector<double>& ys,
+//      SampleMethod method = SampleMethod::Bilinear) const;
+TEST_CASE("test simple layer sample", "[simplelayer][sample]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 100;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        10, 6);
+    REQUIRE(pDataset);
+
+    // A plane rising east and north, so bilinear interpolation is exact.
+    const auto plane = [](double row, double column) {
+        return 2. * column + 3. * row;
+    };
+
+    std::vector<float> elevations(kGridSize * kGridSize);
+    for (uint32_t row=0; row<kGridSize; ++row)
+        for (uint32_t column=0; column<kGridSize; ++column)
+            elevations[row * kGridSize + column] =
+                static_cast<float>(plane(row, column));
+
+    auto pLayer = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pLayer);
+    pLayer->write(0, 0, kGridSize - 1, kGridSize - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto& descriptor = pDataset->getDescriptor();
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = descriptor.getOrigin();
+    double rowSpacing = 0., columnSpacing = 0.;
+    std::tie(rowSpacing, columnSpacing) = descriptor.getGridSpacing();
+
+    // Rows, then columns, in nodes, of the positions sampled; several
+    // straddle the chunks, 10 nodes square, and they are out of order.
+    const std::vector<std::pair<double, double>> nodes{{55.5, 3.25},
+        {9.5, 9.5}, {0., 0.}, {99., 99.}, {29.75, 70.2}, {10., 19.99},
+        {9.5, 9.5}, {88.1, 42.6}};
+
+    std::vector<double> xs, ys;
+    for (const auto& node : nodes)
+    {
+        xs.push_back(originX + node.second * columnSpacing);
+        ys.push_back(originY + node.first * rowSpacing);
+    }
+
+    SECTION("bilinear")
+    {
+        const auto values = pLayer->sample(xs, ys);
+        REQUIRE(values.size() == nodes.size());
+
+        UNSCOPED_INFO("Check the values are those of the plane, in order.");
+        for (size_t i=0; i<nodes.size(); ++i)
+            CHECK(values[i] == Approx(plane(nodes[i].first, nodes[i].second)));
+    }
+
+    SECTION("nearest")
+    {
+        const auto values = pLayer->sample(xs, ys, BAG::SampleMethod::Nearest);
+        REQUIRE(values.size() == nodes.size());
+
+        CHECK(values[0] == static_cast<float>(plane(56., 3.)));
+        CHECK(values[2] == static_cast<float>(plane(0., 0.)));
+        CHECK(values[3] == static_cast<float>(plane(99., 99.)));
+        CHECK(values[4] == static_cast<float>(plane(30., 70.)));
+        CHECK(values[5] == static_cast<float>(plane(10., 20.)));
+        CHECK(values[7] == static_cast<float>(plane(88., 43.)));
+    }
+
+    SECTION("outside the grid")
+    {
+        UNSCOPED_INFO("Check positions more than half a node out are null.");
+        const std::vector<double> outsideX{originX - columnSpacing,
+            originX - 0.25 * columnSpacing, originX, std::nan("")};
+        const std::vector<double> outsideY{originY, originY,
+            originY + kGridSize * rowSpacing, originY};
+
+        const auto values = pLayer->sample(outsideX, outsideY);
+        REQUIRE(values.size() == 4);
+        CHECK(values[0] == BAG_NULL_ELEVATION);
+        CHECK(values[1] == Approx(plane(0., 0.)));
+        CHECK(values[2] == BAG_NULL_ELEVATION);
+        CHECK(values[3] == BAG_NULL_ELEVATION);
+    }
+
+    SECTION("null nodes")
+    {
+        const float nullValue = BAG_NULL_ELEVATION;
+        pLayer->write(10, 10, 10, 10,
+            reinterpret_cast<const uint8_t*>(&nullValue));
+
+        UNSCOPED_INFO("Check null nodes are left out of the interpolation.");
+        const std::vector<double> x{originX + 9.5 * columnSpacing};
+        const std::vector<double> y{originY + 9.5 * rowSpacing};
+        const auto values = pLayer->sample(x, y);
+        REQUIRE(values.size() == 1);
+        CHECK(values[0] == Approx((plane(9., 9.) + plane(9., 10.) +
+            plane(10., 9.)) / 3.));
+
+        UNSCOPED_INFO("Check a position on a null node is null.");
+        const std::vector<double> onNullX{originX + 10. * columnSpacing};
+        const std::vector<double> onNullY{originY + 10. * rowSpacing};
+        CHECK(pLayer->sample(onNullX, onNullY)[0] == BAG_NULL_ELEVATION);
+        CHECK(pLayer->sample(onNullX, onNullY,
+            BAG::SampleMethod::Nearest)[0] == BAG_NULL_ELEVATION);
+    }
+
+    SECTION("invalid")
+    {
+        ys.pop_back();
+        CHECK_THROWS_AS(pLayer->sample(xs, ys), BAG::InvalidSamplePositions);
+        CHECK(pLayer->sample({}, {}).empty());
+    }
+}
+
+TEST_CASE("test simple layer quantization", "[simplelayer][quantization]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint32_t kGridSize = 50;
+    constexpr double kElevationBound = 0.01;
+    constexpr double kStdDevBound = 0.005;
+
+    std::vector<float> values(kGridSize * kGridSize);
+    for (size_t i=0; i<values.size(); ++i)
+        values[i] = (i % 11 == 0) ? BAG_NULL_ELEVATION :
+            -100.f + 0.0137f * static_cast<float>(i);
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            10, 6);
+        REQUIRE(pDataset);
+
+        UNSCOPED_INFO("Quantize the mandatory elevation layer before writing it.");
+        auto pElevation = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pElevation);
+        REQUIRE_NOTHROW(pElevation->setQuantization(
+            BAG::Quantization{kElevationBound}));
+        REQUIRE_NOTHROW(pElevation->write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(values.data())));
+
+        UNSCOPED_INFO("A layer written to cannot be quantized.");
+        CHECK_THROWS_AS(pElevation->setQuantization(BAG::Quantization{0.1}),
+            BAG::QuantizationNeedsEmptyLayer);
+
+        UNSCOPED_INFO("Create an optional layer quantized.");
+        auto& stdDevLayer = pDataset->createSimpleLayer(Std_Dev,
+            BAG::ChunkShape{BAG::ChunkLayout::Tiled, 10, 10}, 6,
+            BAG::Quantization{kStdDevBound});
+        REQUIRE_NOTHROW(stdDevLayer.write(0, 0, kGridSize - 1, kGridSize - 1,
+            reinterpret_cast<const uint8_t*>(values.data())));
+
+        UNSCOPED_INFO("Quantization needs a chunked layer.");
+        CHECK_THROWS_AS(pDataset->createSimpleLayer(Num_Hypotheses,
+            BAG::ChunkShape{}, 0, BAG::Quantization{kStdDevBound}),
+            BAG::QuantizationNeedsChunkingSet);
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    for (const auto& expected : {std::make_pair(Elevation, kElevationBound),
+        std::make_pair(Std_Dev, kStdDevBound)})
+    {
+        const auto pLayer = pDataset->getSimpleLayer(expected.first);
+        REQUIRE(pLayer);
+
+        UNSCOPED_INFO("The error bound is kept with the layer.");
+        const auto& descriptor = dynamic_cast<const BAG::SimpleLayerDescriptor&>(
+            *pLayer->getDescriptor());
+        CHECK(descriptor.getQuantization().absErrorBound == expected.second);
+
+        const auto buffer = pLayer->read(0, 0, kGridSize - 1, kGridSize - 1);
+        REQUIRE(buffer.size() == values.size() * sizeof(float));
+        const auto* floats = reinterpret_cast<const float*>(buffer.data());
+
+        size_t numOutOfBound = 0, numNullsChanged = 0, numExact = 0;
+        for (size_t i=0; i<values.size(); ++i)
+        {
+            if (values[i] == BAG_NULL_ELEVATION)
+                numNullsChanged += floats[i] != BAG_NULL_ELEVATION;
+            else
+            {
+                // Allow for the rounding of the float read back.
+                numOutOfBound += std::abs(floats[i] - values[i]) >
+                    expected.second + 1e-4;
+                numExact += floats[i] == values[i];
+            }
+        }
+
+        CHECK(numOutOfBound == 0);
+        CHECK(numNullsChanged == 0);
+
+        UNSCOPED_INFO("The values are not stored exactly.");
+        CHECK(numExact < values.size() / 2);
+    }
+}
@@ -2,6 +2,7 @@
 #include "test_utils.h"
 #include <bag_dataset.h>
 #include <bag_descriptor.h>
+#include <bag_exceptions.h>
 #include <bag_layer.h>
 #include <bag_metadata.h>
 #include <bag_simplelayerdescriptor.h>
@@ -564,6 +565,65 @@ TEST_CASE("test descriptor get chunk size",
     CHECK(pDescriptor->getChunkSize() == kExpectedChunkSize);
 }
 
+//  std::tuple<uint64_t, uint64_t> getChunkDims() const noexcept;
+TEST_CASE("test descriptor get chunk dims",
+    "[simplelayerdescriptor][getChunkDims]")
+{
+    TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr unsigned int kExpectedCompressionLevel = 6;
+
+    {
+        Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        // Row strips 4 rows high across the 100 columns of the grid.
+        auto pDataset = Dataset::create(tmpBagFile, std::move(metadata),
+            BAG::ChunkShape{BAG::ChunkLayout::RowMajorScan, 4},
+            kExpectedCompressionLevel);
+        REQUIRE(pDataset);
+
+        UNSCOPED_INFO("Check row strips span the width of the grid.");
+        const auto& elevation = pDataset->getLayer(Elevation, {});
+        REQUIRE(elevation);
+        uint64_t rows = 0, columns = 0;
+        std::tie(rows, columns) = elevation->getDescriptor()->getChunkDims();
+        CHECK(rows == 4);
+        CHECK(columns == 100);
+        CHECK(elevation->getDescriptor()->getChunkSize() == 4);
+
+        UNSCOPED_INFO("Check tiles are used as given.");
+        const auto& layer = pDataset->createSimpleLayer(Std_Dev,
+            BAG::ChunkShape{BAG::ChunkLayout::Tiled, 10, 50},
+            kExpectedCompressionLevel);
+        std::tie(rows, columns) = layer.getDescriptor()->getChunkDims();
+        CHECK(rows == 10);
+        CHECK(columns == 50);
+
+        UNSCOPED_INFO("Check automatic chunks fit a grid narrower than a tile.");
+        const auto& autoLayer = pDataset->createSimpleLayer(Num_Soundings,
+            BAG::ChunkShape{BAG::ChunkLayout::Auto}, kExpectedCompressionLevel);
+        std::tie(rows, columns) = autoLayer.getDescriptor()->getChunkDims();
+        CHECK(rows == 100);
+        CHECK(columns == 100);
+    }
+
+    UNSCOPED_INFO("Check the chunk dimensions are read back from the file.");
+    const auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    uint64_t rows = 0, columns = 0;
+    std::tie(rows, columns) =
+        pDataset->getLayer(Elevation, {})->getDescriptor()->getChunkDims();
+    CHECK(rows == 4);
+    CHECK(columns == 100);
+
+    std::tie(rows, columns) =
+        pDataset->getLayer(Std_Dev, {})->getDescriptor()->getChunkDims();
+    CHECK(rows == 10);
+    CHECK(columns == 50);
+}
+
 //  unsigned int getCompressionLevel() const noexcept;
 TEST_CASE("test descriptor get compression level",
     "[simplelayerdescriptor][getCompressionLevel]")
@@ -592,4 +652,64 @@ TEST_CASE("test descriptor get compression level",
     CHECK(pDescriptor->getCompressionLevel() == kExpectedCompressionLevel);
 }
 
+//  const CompressionSpec& getCompressionSpec() const & noexcept;
+TEST_CASE("test descriptor get compression spec",
+    "[simplelayerdescriptor][getCompressionSpec]")
+{
+    TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr uint64_t kExpectedChunkSize = 100;
+    constexpr int kExpectedCompressionLevel = 6;
+
+    // An id from the range HDF5 reserves for testing, which no plugin has.
+    constexpr int kMissingFilter = 300;
+
+    UNSCOPED_INFO("Check deflate is always available, and a missing filter is not.");
+    CHECK(Dataset::isCompressionFilterAvailable(BAG::kDeflateFilter));
+    CHECK_FALSE(Dataset::isCompressionFilterAvailable(kMissingFilter));
+
+    {
+        Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        auto pDataset = Dataset::create(tmpBagFile, std::move(metadata),
+            kExpectedChunkSize, kExpectedCompressionLevel);
+        REQUIRE(pDataset);
+
+        UNSCOPED_INFO("Check a compression level is deflate at that level.");
+        const auto& elevation = pDataset->getLayer(Elevation, {});
+        REQUIRE(elevation);
+        const auto& compression = elevation->getDescriptor()->getCompressionSpec();
+        CHECK(compression.filter == BAG::kDeflateFilter);
+        CHECK(compression.level == kExpectedCompressionLevel);
+        CHECK(compression.shuffle == BAG::ShuffleMode::None);
+
+        UNSCOPED_INFO("Check byte shuffling is kept with the descriptor.");
+        const BAG::ChunkShape chunkShape{BAG::ChunkLayout::Tiled,
+            kExpectedChunkSize};
+        const auto& layer = pDataset->createSimpleLayer(Std_Dev, chunkShape,
+            BAG::CompressionSpec{BAG::kDeflateFilter, kExpectedCompressionLevel,
+                BAG::ShuffleMode::Byte});
+        CHECK(layer.getDescriptor()->getCompressionSpec().shuffle ==
+            BAG::ShuffleMode::Byte);
+
+        UNSCOPED_INFO("Check a filter that is not available throws.");
+        REQUIRE_THROWS_AS(pDataset->createSimpleLayer(Num_Soundings,
+            chunkShape, BAG::CompressionSpec{kMissingFilter, 1}),
+            BAG::CompressionFilterNotAvailable);
+    }
+
+    UNSCOPED_INFO("Check the compression is read back from the file.");
+    const auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& compression =
+        pDataset->getLayer(Std_Dev, {})->getDescriptor()->getCompressionSpec();
+    CHECK(compression.filter == BAG::kDeflateFilter);
+    CHECK(compression.level == kExpectedCompressionLevel);
+    CHECK(compression.shuffle == BAG::ShuffleMode::Byte);
+    CHECK(pDataset->getLayer(Std_Dev, {})->getDescriptor()->getCompressionLevel() ==
+        kExpectedCompressionLevel);
+}
+
 
@@ -1,13 +1,18 @@
 
 #include "test_utils.h"
 #include <bag_dataset.h>
+#include <bag_simplelayer.h>
 #include <bag_surfacecorrections.h>
 #include <bag_surfacecorrectionsdescriptor.h>
 
+#include <algorithm>
 #include <array>
 #include <catch2/catch_all.hpp>
 #include <cstdlib>  // std::getenv
+#include <cstring>  // std::memcmp
+#include <limits>
 #include <string>
+#include <vector>
 
 
 using BAG::Dataset;
@@ -586,3 +591,675 @@ TEST_CASE("test surface corrections create, write, read two gridded records",
     CHECK(res[1].z[2] == kExpectedItems[1].z[2]);
 }
 
+
+//  UInt8Array readCorrectedRow(uint32_t row, uint32_t columnStart,
+//      uint32_t columnEnd, uint8_t corrector, const SimpleLayer& layer) const;
+TEST_CASE("test surface corrections read corrected row gridded",
+    "[surfacecorrections][readCorrectedRow][BAG_SURFACE_GRID_EXTENTS]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    // A 4x4 corrector grid covering the whole dataset.
+    constexpr uint8_t kNumCorrectors = 3;
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, kNumCorrectors, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * 33, spacingY * 33);
+
+    const auto writeCorrectors = [&corrections](float offset) {
+        std::array<BagVerticalDatumCorrectionsGridded, 16> grid{};
+        for (auto& node : grid)
+        {
+            node.z[0] = 1.5f + offset;
+            node.z[1] = -2.f + offset;
+            node.z[2] = .25f + offset;
+        }
+
+        corrections.write(0, 0, 3, 3,
+            reinterpret_cast<const uint8_t*>(grid.data()));
+    };
+    writeCorrectors(0.f);
+
+    // Write a few elevations, leaving column 15 null.
+    constexpr uint32_t kRow = 3;
+    constexpr uint32_t kColumnStart = 10;
+    constexpr uint32_t kColumnEnd = 15;
+
+    const std::array<float, 5> elevations{10.f, 11.f, 12.f, 13.f, 14.f};
+    pDataset->getLayer(Elevation).write(kRow, kColumnStart, kRow,
+        kColumnStart + 4, reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    auto result = corrections.readCorrectedRow(kRow, kColumnStart, kColumnEnd,
+        2, *pElevation);
+    REQUIRE(result.size() == 6 * sizeof(float));
+
+    const auto* corrected = reinterpret_cast<const float*>(result.data());
+    for (size_t i=0; i<elevations.size(); ++i)
+        CHECK(corrected[i] == Approx(elevations[i] - 2.f));
+
+    CHECK(corrected[5] == BAG_NULL_ELEVATION);
+
+    // Rewriting the correctors is picked up by the next read.
+    writeCorrectors(1.f);
+
+    result = corrections.readCorrectedRow(kRow, kColumnStart, kColumnEnd, 3,
+        *pElevation);
+    corrected = reinterpret_cast<const float*>(result.data());
+
+    for (size_t i=0; i<elevations.size(); ++i)
+        CHECK(corrected[i] == Approx(elevations[i] + 1.25f));
+}
+
+//  CorrectionPlan createCorrectionPlan(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd) const;
+//  UInt8Array readCorrected(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+//      const SimpleLayer& layer, const CorrectionPlan& plan) const;
+TEST_CASE("test surface corrections read corrected with plan",
+    "[surfacecorrections][readCorrected][createCorrectionPlan][BAG_SURFACE_GRID_EXTENTS]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    // A 3x3 corrector grid with a different value at every node.
+    constexpr uint8_t kNumCorrectors = 2;
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, kNumCorrectors, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * 40, spacingY * 40);
+
+    std::array<BagVerticalDatumCorrectionsGridded, 9> grid{};
+    for (size_t i=0; i<grid.size(); ++i)
+    {
+        grid[i].z[0] = 1.f + i;
+        grid[i].z[1] = -.5f * (i + 1);
+    }
+    corrections.write(0, 0, 2, 2, reinterpret_cast<const uint8_t*>(grid.data()));
+
+    constexpr uint32_t kRowStart = 30, kColumnStart = 35;
+    constexpr uint32_t kRowEnd = 49, kColumnEnd = 44;
+    constexpr size_t kNumNodes = 20 * 10;
+
+    std::array<float, kNumNodes> elevations;
+    for (size_t i=0; i<kNumNodes; ++i)
+        elevations[i] = -10.f - i * .1f;
+
+    pDataset->getLayer(Elevation).write(kRowStart, kColumnStart, kRowEnd,
+        kColumnEnd, reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    const auto plan = corrections.createCorrectionPlan();
+    CHECK(plan.contains(kRowStart, kColumnStart, kRowEnd, kColumnEnd));
+
+    for (uint8_t corrector=1; corrector<=kNumCorrectors; ++corrector)
+    {
+        const auto expected = corrections.readCorrected(kRowStart,
+            kColumnStart, kRowEnd, kColumnEnd, corrector, *pElevation);
+        const auto actual = corrections.readCorrected(kRowStart, kColumnStart,
+            kRowEnd, kColumnEnd, corrector, *pElevation, plan);
+        REQUIRE(actual.size() == kNumNodes * sizeof(float));
+        REQUIRE(expected.size() == actual.size());
+
+        const auto* expectedValues = reinterpret_cast<const float*>(expected.data());
+        const auto* actualValues = reinterpret_cast<const float*>(actual.data());
+
+        for (size_t i=0; i<kNumNodes; ++i)
+        {
+            CHECK(actualValues[i] == expectedValues[i]);
+
+            // The correction is a weighted average of the correctors.
+            const auto correction = actualValues[i] - elevations[i];
+            const auto bound0 = grid.front().z[corrector - 1];
+            const auto bound1 = grid.back().z[corrector - 1];
+            CHECK(correction >= std::min(bound0, bound1) - 1e-4f);
+            CHECK(correction <= std::max(bound0, bound1) + 1e-4f);
+        }
+
+        // Each row matches correcting that row on its own.
+        const auto row = corrections.readCorrectedRow(kRowStart + 3,
+            kColumnStart, kColumnEnd, corrector, *pElevation, plan);
+        CHECK(std::memcmp(row.data(), actual.data() + 3 * 10 * sizeof(float),
+            row.size()) == 0);
+    }
+
+    const auto smallPlan = corrections.createCorrectionPlan(kRowStart,
+        kColumnStart, kRowStart, kColumnEnd);
+    REQUIRE_THROWS_AS(corrections.readCorrected(kRowStart, kColumnStart,
+        kRowEnd, kColumnEnd, 1, *pElevation, smallPlan), BAG::InvalidReadSize);
+}
+
+//  UInt8Array readCorrected(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+//      const SimpleLayer& layer) const;
+TEST_CASE("test surface corrections read corrected large area",
+    "[surfacecorrections][readCorrected][BAG_SURFACE_GRID_EXTENTS]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    // Large enough to be corrected on several threads.
+    constexpr uint32_t kDim = 512;
+    auto xml = kMetadataXML;
+    const std::string kDimensionSize{"<gco:Integer>100</gco:Integer>"};
+    for (auto pos = xml.find(kDimensionSize); pos != std::string::npos;
+        pos = xml.find(kDimensionSize, pos))
+        xml.replace(pos, kDimensionSize.size(),
+            "<gco:Integer>" + std::to_string(kDim) + "</gco:Integer>");
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(xml);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        128, 1);
+    REQUIRE(pDataset);
+    REQUIRE(pDataset->getDescriptor().getDims() ==
+        std::make_tuple(kDim, kDim));
+
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, 1, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * 100, spacingY * 100);
+
+    std::array<BagVerticalDatumCorrectionsGridded, 36> grid{};
+    for (size_t i=0; i<grid.size(); ++i)
+        grid[i].z[0] = 1.f + i;
+
+    corrections.write(0, 0, 5, 5, reinterpret_cast<const uint8_t*>(grid.data()));
+
+    std::vector<float> elevations(static_cast<size_t>(kDim) * kDim);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = -1.f * (i % 997);
+
+    pDataset->getLayer(Elevation).write(0, 0, kDim - 1, kDim - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    const auto all = corrections.readCorrected(0, 0, kDim - 1, kDim - 1, 1,
+        *pElevation);
+    REQUIRE(all.size() == elevations.size() * sizeof(float));
+
+    // Every row matches correcting that row on its own.
+    const auto plan = corrections.createCorrectionPlan();
+    for (uint32_t row=0; row<kDim; row+=37)
+    {
+        const auto expected = corrections.readCorrectedRow(row, 0, kDim - 1, 1,
+            *pElevation, plan);
+        CHECK(std::memcmp(expected.data(),
+            all.data() + static_cast<size_t>(row) * kDim * sizeof(float),
+            expected.size()) == 0);
+    }
+}
+
+//  SimpleLayer& writeCorrectedLayer(const SimpleLayer& source,
+//      uint8_t corrector, Dataset& destination, LayerType destinationType) const;
+TEST_CASE("test surface corrections write corrected layer",
+    "[surfacecorrections][writeCorrectedLayer][BAG_SURFACE_GRID_EXTENTS]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const TestUtils::RandomFileGuard tmpDestinationFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    // A chunk size that does not divide the rows, so the last band is short.
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        30, 1);
+    REQUIRE(pDataset);
+
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, 1, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * 40, spacingY * 40);
+
+    std::array<BagVerticalDatumCorrectionsGridded, 9> grid{};
+    for (size_t i=0; i<grid.size(); ++i)
+        grid[i].z[0] = 1.f + i;
+
+    corrections.write(0, 0, 2, 2, reinterpret_cast<const uint8_t*>(grid.data()));
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    std::vector<float> elevations(static_cast<size_t>(numRows) * numColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = -20.f + (i % 13);
+    elevations[7] = BAG_NULL_ELEVATION;
+
+    pDataset->getLayer(Elevation).write(0, 0, numRows - 1, numColumns - 1,
+        reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    const auto expected = corrections.readCorrected(0, 0, numRows - 1,
+        numColumns - 1, 1, *pElevation);
+    const auto* expectedValues = reinterpret_cast<const float*>(expected.data());
+
+    float expectedMin = std::numeric_limits<float>::max();
+    float expectedMax = std::numeric_limits<float>::lowest();
+    for (size_t i=0; i<elevations.size(); ++i)
+    {
+        if (expectedValues[i] == BAG_NULL_ELEVATION)
+            continue;
+
+        expectedMin = std::min(expectedMin, expectedValues[i]);
+        expectedMax = std::max(expectedMax, expectedValues[i]);
+    }
+
+    SECTION("into another BAG")
+    {
+        BAG::Metadata destinationMetadata;
+        destinationMetadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDestination = Dataset::create(tmpDestinationFileName,
+            std::move(destinationMetadata), 100, 5);
+        REQUIRE(pDestination);
+
+        auto& layer = corrections.writeCorrectedLayer(*pElevation, 1,
+            *pDestination, Elevation);
+
+        const auto actual = layer.read(0, 0, numRows - 1, numColumns - 1);
+        REQUIRE(actual.size() == expected.size());
+        CHECK(std::memcmp(actual.data(), expected.data(), actual.size()) == 0);
+
+        float min = 0.f, max = 0.f;
+        std::tie(min, max) = layer.getDescriptor()->getMinMax();
+        CHECK(min == expectedMin);
+        CHECK(max == expectedMax);
+    }
+
+    SECTION("into a new layer of the same BAG")
+    {
+        REQUIRE_FALSE(pDataset->getSimpleLayer(Nominal_Elevation));
+
+        auto& layer = corrections.writeCorrectedLayer(*pElevation, 1,
+            *pDataset, Nominal_Elevation);
+
+        CHECK(pDataset->getSimpleLayer(Nominal_Elevation));
+        CHECK(layer.getDescriptor()->getChunkSize() == 30);
+
+        const auto actual = layer.read(0, 0, numRows - 1, numColumns - 1);
+        CHECK(std::memcmp(actual.data(), expected.data(), actual.size()) == 0);
+    }
+
+    SECTION("into a layer that does not store floats")
+    {
+        REQUIRE_THROWS_AS(corrections.writeCorrectedLayer(*pElevation, 1,
+            *pDataset, Num_Hypotheses), BAG::UnsupportedDataType);
+    }
+}
+
+//  UInt8Array readCorrected(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+//      const SimpleLayer& layer) const;
+TEST_CASE("test surface corrections read corrected irregular",
+    "[surfacecorrections][readCorrected][BAG_SURFACE_IRREGULARLY_SPACED]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    constexpr uint8_t kNumCorrectors = 2;
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_IRREGULARLY_SPACED, kNumCorrectors, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    // Scatter the correctors over (and a little beyond) the grid; the first
+    // is on a node.
+    constexpr size_t kNumNodes = 50;
+    std::array<BAG::VerticalDatumCorrections, kNumNodes> nodes{};
+    uint32_t seed = 12345;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 8) & 0xffff) / 65535.0;
+    };
+
+    for (size_t i=0; i<kNumNodes; ++i)
+    {
+        nodes[i].x = originX + (random() * 1.2 - .1) * numColumns * spacingX;
+        nodes[i].y = originY + (random() * 1.2 - .1) * numRows * spacingY;
+        nodes[i].z[0] = 1.f + i;
+        nodes[i].z[1] = -.25f * i;
+    }
+    nodes[0].x = originX + 10 * spacingX;
+    nodes[0].y = originY + 20 * spacingY;
+
+    corrections.write(0, 0, 0, kNumNodes - 1,
+        reinterpret_cast<const uint8_t*>(nodes.data()));
+    REQUIRE(pDataset->getDescriptor().getDims() ==
+        std::make_tuple(numRows, numColumns));
+
+    constexpr uint32_t kRowStart = 15, kColumnStart = 5;
+    constexpr uint32_t kRowEnd = 39, kColumnEnd = 64;
+    constexpr uint32_t kColumns = kColumnEnd - kColumnStart + 1;
+
+    std::vector<float> elevations(
+        static_cast<size_t>(kRowEnd - kRowStart + 1) * kColumns, -30.f);
+    elevations[3] = BAG_NULL_ELEVATION;
+
+    pDataset->getLayer(Elevation).write(kRowStart, kColumnStart, kRowEnd,
+        kColumnEnd, reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    for (uint8_t corrector=1; corrector<=kNumCorrectors; ++corrector)
+    {
+        const auto result = corrections.readCorrected(kRowStart, kColumnStart,
+            kRowEnd, kColumnEnd, corrector, *pElevation);
+        REQUIRE(result.size() == elevations.size() * sizeof(float));
+
+        const auto* values = reinterpret_cast<const float*>(result.data());
+
+        CHECK(values[3] == BAG_NULL_ELEVATION);
+        CHECK(values[(20 - kRowStart) * kColumns + (10 - kColumnStart)] ==
+            Approx(-30.f + nodes[0].z[corrector - 1]));
+
+        // Compare with a brute force inverse distance weighting of the four
+        // nearest correctors.
+        for (uint32_t row=kRowStart; row<=kRowEnd; ++row)
+        {
+            for (uint32_t column=kColumnStart; column<=kColumnEnd; column+=7)
+            {
+                const auto x = originX + column * spacingX;
+                const auto y = originY + row * spacingY;
+
+                std::array<std::pair<double, size_t>, kNumNodes> byDistance;
+                for (size_t i=0; i<kNumNodes; ++i)
+                    byDistance[i] = {(nodes[i].x - x) * (nodes[i].x - x) +
+                        (nodes[i].y - y) * (nodes[i].y - y), i};
+                std::partial_sort(byDistance.begin(), byDistance.begin() + 4,
+                    byDistance.end());
+
+                if (byDistance[0].first == 0.)
+                    continue;
+
+                double sumSep = 0., sum = 0.;
+                for (size_t i=0; i<4; ++i)
+                {
+                    sumSep += nodes[byDistance[i].second].z[corrector - 1] /
+                        byDistance[i].first;
+                    sum += 1. / byDistance[i].first;
+                }
+
+                const auto index = (row - kRowStart) * kColumns +
+                    (column - kColumnStart);
+                if (index == 3)
+                    continue;
+
+                CHECK(values[index] == Approx(-30.f + sumSep / sum).margin(1e-4));
+            }
+        }
+    }
+}
+
+//  void readCorrectedInto(uint32_t rowStart, uint32_t columnStart,
+//      uint32_t rowEnd, uint32_t columnEnd, uint8_t corrector,
+//      const SimpleLayer& layer, const CorrectionPlan& plan, float* data,
+//      size_t rowStride = 0) const;
+TEST_CASE("test surface corrections read corrected into buffer",
+    "[surfacecorrections][readCorrectedInto][BAG_SURFACE_GRID_EXTENTS]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    auto& corrections = pDataset->createSurfaceCorrections(
+        BAG_SURFACE_GRID_EXTENTS, 1, 100, 5);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    corrections.getDescriptor()->setOrigin(originX, originY)
+        .setSpacing(spacingX * 40, spacingY * 40);
+
+    std::array<BagVerticalDatumCorrectionsGridded, 9> grid{};
+    for (size_t i=0; i<grid.size(); ++i)
+        grid[i].z[0] = 2.f * i - 3.f;
+
+    corrections.write(0, 0, 2, 2, reinterpret_cast<const uint8_t*>(grid.data()));
+
+    constexpr uint32_t kRowStart = 10, kColumnStart = 20;
+    constexpr uint32_t kRowEnd = 17, kColumnEnd = 31;
+    constexpr uint32_t kRows = kRowEnd - kRowStart + 1;
+    constexpr uint32_t kColumns = kColumnEnd - kColumnStart + 1;
+
+    std::vector<float> elevations(kRows * kColumns);
+    for (size_t i=0; i<elevations.size(); ++i)
+        elevations[i] = -5.f - i;
+
+    pDataset->getLayer(Elevation).write(kRowStart, kColumnStart, kRowEnd,
+        kColumnEnd, reinterpret_cast<const uint8_t*>(elevations.data()));
+
+    const auto pElevation = pDataset->getSimpleLayer(Elevation);
+    REQUIRE(pElevation);
+
+    const auto expected = corrections.readCorrected(kRowStart, kColumnStart,
+        kRowEnd, kColumnEnd, 1, *pElevation);
+    const auto* expectedValues = reinterpret_cast<const float*>(expected.data());
+
+    // Leave a gap after each row that must not be touched.
+    constexpr uint32_t kStride = kColumns + 5;
+    constexpr float kPadding = 123.f;
+    std::vector<float> buffer(kRows * kStride, kPadding);
+
+    const auto plan = corrections.createCorrectionPlan();
+
+    SECTION("with a plan")
+    {
+        corrections.readCorrectedInto(kRowStart, kColumnStart, kRowEnd,
+            kColumnEnd, 1, *pElevation, plan, buffer.data(), kStride);
+    }
+    SECTION("without a plan")
+    {
+        corrections.readCorrectedInto(kRowStart, kColumnStart, kRowEnd,
+            kColumnEnd, 1, *pElevation, buffer.data(), kStride);
+    }
+
+    for (uint32_t row=0; row<kRows; ++row)
+    {
+        for (uint32_t column=0; column<kColumns; ++column)
+            CHECK(buffer[row * kStride + column] ==
+                expectedValues[row * kColumns + column]);
+
+        for (uint32_t column=kColumns; column<kStride; ++column)
+            CHECK(buffer[row * kStride + column] == kPadding);
+    }
+
+    // A stride shorter than a row is rejected.
+    REQUIRE_THROWS_AS(corrections.readCorrectedInto(kRowStart, kColumnStart,
+        kRowEnd, kColumnEnd, 1, *pElevation, plan, buffer.data(), kColumns - 1),
+        BAG::InvalidBuffer);
+}
+
+//  CorrectionPlan load(const VerticalDatumCorrectionsGridded* correctors,
+//      uint32_t rows, uint32_t columns);
+//  void load(const VerticalDatumCorrections* correctors, uint32_t numNodes);
+TEST_CASE("test surface corrections load",
+    "[surfacecorrections][load][BAG_SURFACE_GRID_EXTENTS][BAG_SURFACE_IRREGULARLY_SPACED]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        100, 5);
+    REQUIRE(pDataset);
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    SECTION("gridded")
+    {
+        // Chunks of 16, so the grid ends part way through a chunk.
+        constexpr uint8_t kNumCorrectors = 2;
+        auto& corrections = pDataset->createSurfaceCorrections(
+            BAG_SURFACE_GRID_EXTENTS, kNumCorrectors, 16, 5);
+        corrections.getDescriptor()->setOrigin(originX, originY)
+            .setSpacing(spacingX * 2, spacingY * 2);
+
+        constexpr uint32_t kRows = 50, kColumns = 40;
+        std::vector<BagVerticalDatumCorrectionsGridded> grid(kRows * kColumns);
+        for (size_t i=0; i<grid.size(); ++i)
+        {
+            grid[i].z[0] = 1.f + i;
+            grid[i].z[1] = -.5f * i;
+        }
+
+        const auto plan = corrections.load(grid.data(), kRows, kColumns);
+        CHECK(corrections.getDescriptor()->getDims() ==
+            std::make_tuple(kRows, kColumns));
+        CHECK(plan.contains(0, 0, 99, 99));
+
+        UNSCOPED_INFO("The correctors read back as loaded.");
+        const auto result = corrections.read(0, 0, kRows - 1, kColumns - 1);
+        REQUIRE(result.size() == grid.size() * sizeof(grid.front()));
+        const auto* values =
+            reinterpret_cast<const BagVerticalDatumCorrectionsGridded*>(
+                result.data());
+
+        bool allMatch = true;
+        for (size_t i=0; i<grid.size(); ++i)
+            allMatch &= values[i].z[0] == grid[i].z[0] &&
+                values[i].z[1] == grid[i].z[1];
+        CHECK(allMatch);
+
+        UNSCOPED_INFO("The plan corrects like a new one.");
+        std::vector<float> elevations(100 * 100, -10.f);
+        pDataset->getLayer(Elevation).write(0, 0, 99, 99,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        const auto pElevation = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pElevation);
+
+        const auto expected = corrections.readCorrected(10, 20, 59, 79, 2,
+            *pElevation);
+        const auto actual = corrections.readCorrected(10, 20, 59, 79, 2,
+            *pElevation, plan);
+        REQUIRE(expected.size() == actual.size());
+        CHECK(std::memcmp(expected.data(), actual.data(), expected.size()) == 0);
+
+        UNSCOPED_INFO("Loading a smaller grid replaces the correctors.");
+        corrections.load(grid.data(), 3, 3);
+        CHECK(corrections.getDescriptor()->getDims() == std::make_tuple(3u, 3u));
+
+        REQUIRE_THROWS_AS(corrections.load(
+            static_cast<const VerticalDatumCorrections*>(nullptr), 1),
+            BAG::UnsupportedSurfaceType);
+    }
+    SECTION("irregular")
+    {
+        constexpr uint8_t kNumCorrectors = 1;
+        auto& corrections = pDataset->createSurfaceCorrections(
+            BAG_SURFACE_IRREGULARLY_SPACED, kNumCorrectors, 16, 5);
+
+        constexpr uint32_t kNumNodes = 40;
+        std::vector<VerticalDatumCorrections> nodes(kNumNodes);
+        for (uint32_t i=0; i<kNumNodes; ++i)
+        {
+            nodes[i].x = originX + (i % 8) * 12 * spacingX;
+            nodes[i].y = originY + (i / 8) * 20 * spacingY;
+            nodes[i].z[0] = .25f * i;
+        }
+
+        corrections.load(nodes.data(), kNumNodes);
+        CHECK(corrections.getDescriptor()->getDims() ==
+            std::make_tuple(1u, kNumNodes));
+
+        const auto result = corrections.read(0, 0, 0, kNumNodes - 1);
+        REQUIRE(result.size() == nodes.size() * sizeof(nodes.front()));
+        const auto* values =
+            reinterpret_cast<const VerticalDatumCorrections*>(result.data());
+
+        bool allMatch = true;
+        for (uint32_t i=0; i<kNumNodes; ++i)
+            allMatch &= values[i].x == nodes[i].x && values[i].y == nodes[i].y &&
+                values[i].z[0] == nodes[i].z[0];
+        CHECK(allMatch);
+
+        UNSCOPED_INFO("A node on a corrector takes its value.");
+        std::vector<float> elevations(100 * 100, -10.f);
+        pDataset->getLayer(Elevation).write(0, 0, 99, 99,
+            reinterpret_cast<const uint8_t*>(elevations.data()));
+
+        const auto pElevation = pDataset->getSimpleLayer(Elevation);
+        REQUIRE(pElevation);
+
+        const auto corrected = corrections.readCorrected(20, 12, 20, 12, 1,
+            *pElevation);
+        CHECK(*reinterpret_cast<const float*>(corrected.data()) ==
+            Approx(-10.f + nodes[9].z[0]));
+    }
+}
@@ -0,0 +1,114 @@
+
+#include "test_utils.h"
+#include <bag_copy.h>
+#include <bag_dataset.h>
+#include <bag_descriptor.h>
+#include <bag_layer.h>
+#include <bag_tilecache.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+using BAG::Dataset;
+using BAG::TileCache;
+
+//  static TileCache& global() noexcept;
+//  void setLimit(uint64_t bytes);
+//  uint64_t getUsage() const noexcept;
+//  size_t getNumTiles() const noexcept;
+//  TileCacheStats getStats() const noexcept;
+//  void clear() noexcept;
+TEST_CASE("test tile cache", "[tilecache][global][setLimit][getStats]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    // A copy of the sample in chunks of 10 by 10 nodes.
+    const TestUtils::RandomFileGuard tmpBagFile;
+    {
+        const auto pSource = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(pSource);
+
+        BAG::CopyOptions options;
+        options.rechunk = true;
+        options.chunkShape.rows = 10;
+        options.chunkShape.columns = 10;
+        BAG::copyDataset(*pSource, tmpBagFile, options);
+    }
+
+    auto& cache = TileCache::global();
+    cache.clear();
+    cache.setLimit(16 * 1024 * 1024);
+
+    const auto before = cache.getStats();
+
+    SECTION("share tiles between datasets")
+    {
+        const auto pFirst = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+        REQUIRE(pFirst);
+        const auto pSecond = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+        REQUIRE(pSecond);
+
+        // Spans parts of four chunks.
+        const auto first = pFirst->getLayer(Elevation).read(5, 5, 14, 14);
+        CHECK(cache.getNumTiles() == 4);
+        CHECK(cache.getStats().misses - before.misses == 4);
+
+        const auto second = pSecond->getLayer(Elevation).read(5, 5, 14,
+            14);
+        CHECK(cache.getStats().hits - before.hits == 4);
+        CHECK(cache.getNumTiles() == 4);
+        CHECK(cache.getUsage() > 4 * 10 * 10 * sizeof(float));
+
+        REQUIRE(first.size() == second.size());
+        CHECK(std::memcmp(first.data(), second.data(), first.size()) == 0);
+
+        // The cache does not change what is read.
+        cache.setLimit(0);
+        CHECK(cache.getNumTiles() == 0);
+
+        const auto uncached = pFirst->getLayer(Elevation).read(5, 5, 14,
+            14);
+        REQUIRE(uncached.size() == first.size());
+        CHECK(std::memcmp(uncached.data(), first.data(), first.size()) == 0);
+    }
+
+    SECTION("drop the tiles written")
+    {
+        const auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READ_WRITE);
+        REQUIRE(pDataset);
+
+        auto& layer = pDataset->getLayer(Elevation);
+        layer.read(0, 0, 19, 19);
+        CHECK(cache.getNumTiles() == 4);
+
+        const float value = 42.f;
+        layer.write(3, 3, 3, 3, reinterpret_cast<const uint8_t*>(&value));
+        CHECK(cache.getNumTiles() == 3);
+        CHECK(cache.getStats().invalidations - before.invalidations == 1);
+
+        const auto buffer = layer.read(3, 3, 3, 3);
+        float read = 0.f;
+        std::memcpy(&read, buffer.data(), sizeof(read));
+        CHECK(read == value);
+        CHECK(cache.getNumTiles() == 4);
+    }
+
+    SECTION("bypass the cache for large reads")
+    {
+        cache.setLimit(1024);
+
+        const auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        pDataset->getLayer(Elevation).read(0, 0, 19, 19);
+        CHECK(cache.getNumTiles() == 0);
+        CHECK(cache.getStats().misses == before.misses);
+    }
+
+    cache.setLimit(0);
+}
+
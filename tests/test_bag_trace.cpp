@@ -0,0 +1,114 @@
+
+#include <bag_dataset.h>
+#include <bag_layer.h>
+#include <bag_trace.h>
+
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+
+namespace {
+
+//! Records the events reported, as "+name" and "-name".
+class RecordingSink final : public BAG::TraceSink
+{
+public:
+    void begin(const BAG::TraceEvent& event) noexcept override
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_events.push_back(std::string{"+"} + event.name);
+
+        if (event.layerName)
+            m_lastLayerName = event.layerName;
+        m_lastRows = event.rows;
+        m_lastColumns = event.columns;
+    }
+
+    void end(const BAG::TraceEvent& event) noexcept override
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        m_events.push_back(std::string{"-"} + event.name);
+    }
+
+    bool contains(const std::string& event) const
+    {
+        return std::find(m_events.begin(), m_events.end(), event) !=
+            m_events.end();
+    }
+
+    std::mutex m_mutex;
+    std::vector<std::string> m_events;
+    std::string m_lastLayerName;
+    uint32_t m_lastRows = 0;
+    uint32_t m_lastColumns = 0;
+};
+
+//! Installs a sink for the scope.
+struct SinkGuard final
+{
+    explicit SinkGuard(BAG::TraceSink& sink) noexcept
+    {
+        BAG::setTraceSink(&sink);
+    }
+
+    ~SinkGuard() noexcept
+    {
+        BAG::setTraceSink(nullptr);
+    }
+};
+
+}  // namespace
+
+//  void setTraceSink(TraceSink* pSink) noexcept;
+//  TraceSink* getTraceSink() noexcept;
+TEST_CASE("test trace sink", "[trace][setTraceSink][getTraceSink]")
+{
+    const std::string bagFileName{std::string{std::getenv("BAG_SAMPLES_PATH")} +
+        "/sample.bag"};
+
+    RecordingSink sink;
+
+    UNSCOPED_INFO("There is no sink by default.");
+    CHECK(BAG::getTraceSink() == nullptr);
+
+    {
+        const SinkGuard guard{sink};
+        CHECK(BAG::getTraceSink() == &sink);
+
+        const auto pDataset = Dataset::open(bagFileName, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        pDataset->getLayer(Elevation).read(0, 0, 9, 19);
+    }
+
+    CHECK(BAG::getTraceSink() == nullptr);
+
+#ifdef BAG_USE_TRACING
+    UNSCOPED_INFO("Opening and reading the BAG is reported.");
+    CHECK(sink.contains("+Dataset::open"));
+    CHECK(sink.contains("+Metadata::loadFromBuffer"));
+    CHECK(sink.contains("+Layer::read"));
+
+    UNSCOPED_INFO("The open ends after the phases of reading the BAG.");
+    REQUIRE(sink.m_events.size() >= 2);
+    CHECK(sink.m_events.front() == "+Dataset::open");
+    CHECK(std::count(sink.m_events.begin(), sink.m_events.end(),
+        "-Dataset::open") == 1);
+
+    UNSCOPED_INFO("The read carries the layer name and window size.");
+    CHECK(sink.m_events.back() == "-Layer::read");
+    CHECK(sink.m_lastLayerName == "Elevation");
+    CHECK(sink.m_lastRows == 10);
+    CHECK(sink.m_lastColumns == 20);
+#else
+    UNSCOPED_INFO("Without tracing built in, nothing is reported.");
+    CHECK(sink.m_events.empty());
+#endif
+}
+
@@ -452,3 +452,196 @@ TEST_CASE("test tracking list construction (create)", "[trackinglist][constructo
     CHECK(kExpectedItem1.list_series == item1.list_series);
 }
 
+
+TEST_CASE("test tracking list queries", "[trackinglist][getItemsAtNode][getItemsWithCode][getItemsInSeries][getItemsInWindow]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+    const auto pDataset = Dataset::create(tmpFileName, BAG::Metadata{},
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    auto& trackingList = pDataset->getTrackingList();
+
+    // Items added out of node order; node (2, 3) has two items.
+    trackingList.emplace_back(TrackingList::value_type{5, 1, 1.f, 0.1f, 1, 10});
+    trackingList.emplace_back(TrackingList::value_type{2, 3, 2.f, 0.2f, 2, 10});
+    trackingList.emplace_back(TrackingList::value_type{0, 7, 3.f, 0.3f, 1, 20});
+    trackingList.emplace_back(TrackingList::value_type{2, 3, 4.f, 0.4f, 3, 20});
+    trackingList.emplace_back(TrackingList::value_type{3, 9, 5.f, 0.5f, 1, 10});
+
+    const auto& constList = pDataset->getTrackingList();
+
+    UNSCOPED_INFO("Check the items of a node are found in list order.");
+    auto items = constList.getItemsAtNode(2, 3);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0].depth == 2.f);
+    CHECK(items[1].depth == 4.f);
+    CHECK(constList.getItemsAtNode(2, 4).empty());
+
+    UNSCOPED_INFO("Check the items are found by track code and list series.");
+    items = constList.getItemsWithCode(1);
+    REQUIRE(items.size() == 3);
+    CHECK(items[0].depth == 1.f);
+    CHECK(items[1].depth == 3.f);
+    CHECK(items[2].depth == 5.f);
+    CHECK(constList.getItemsInSeries(20).size() == 2);
+
+    UNSCOPED_INFO("Check the items are found in a window.");
+    items = constList.getItemsInWindow(2, 1, 5, 3);
+    REQUIRE(items.size() == 3);
+    CHECK(items[0].depth == 2.f);
+    CHECK(items[1].depth == 4.f);
+    CHECK(items[2].depth == 1.f);
+
+    UNSCOPED_INFO("Check changing the items updates the queries.");
+    trackingList[0].row = 2;
+    trackingList[0].col = 3;
+    trackingList.push_back(TrackingList::value_type{2, 3, 6.f, 0.6f, 1, 30});
+
+    items = constList.getItemsAtNode(2, 3);
+    REQUIRE(items.size() == 4);
+    CHECK(items[0].depth == 1.f);
+    CHECK(items[3].depth == 6.f);
+    CHECK(constList.getItemsInSeries(30).size() == 1);
+
+    trackingList.resize(2);
+    CHECK(constList.getItemsAtNode(2, 3).size() == 2);
+    CHECK(constList.getItemsWithCode(3).empty());
+}
+
+TEST_CASE("test tracking list incremental write", "[trackinglist][write]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        auto& trackingList = pDataset->getTrackingList();
+
+        // Write one item at a time, as bagWriteTrackingListItem() does.
+        for (uint32_t i=0; i<25; ++i)
+        {
+            trackingList.push_back(TrackingList::value_type{i, i + 1,
+                static_cast<float>(i), 0.5f, 1, 2});
+            REQUIRE_NOTHROW(trackingList.write());
+        }
+
+        // Change an item that was already written, then shrink the list.
+        trackingList[3].depth = 100.f;
+        trackingList.resize(20);
+        REQUIRE_NOTHROW(trackingList.write());
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto& trackingList = pDataset->getTrackingList();
+
+    UNSCOPED_INFO("Check every write reached the file.");
+    REQUIRE(trackingList.size() == 20);
+
+    for (uint32_t i=0; i<20; ++i)
+    {
+        CHECK(trackingList[i].row == i);
+        CHECK(trackingList[i].col == i + 1);
+        CHECK(trackingList[i].depth == (i == 3 ? 100.f : static_cast<float>(i)));
+    }
+}
+
+TEST_CASE("test tracking list sort", "[trackinglist][sortByNode][sortByCode][sortBySeries]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        auto& trackingList = pDataset->getTrackingList();
+
+        // Node (2, 3) has two items, and row 2 spans more than one byte of
+        // column.
+        trackingList.emplace_back(TrackingList::value_type{5, 1, 1.f, 0.1f, 1, 10});
+        trackingList.emplace_back(TrackingList::value_type{2, 300, 2.f, 0.2f, 2, 10});
+        trackingList.emplace_back(TrackingList::value_type{0, 7, 3.f, 0.3f, 1, 20});
+        trackingList.emplace_back(TrackingList::value_type{2, 3, 4.f, 0.4f, 3, 20});
+        trackingList.emplace_back(TrackingList::value_type{2, 3, 5.f, 0.5f, 1, 10});
+
+        UNSCOPED_INFO("Check sorting by node orders by row, then column.");
+        trackingList.sortByNode();
+
+        const auto& constList = pDataset->getTrackingList();
+        REQUIRE(constList.size() == 5);
+        CHECK(constList[0].depth == 3.f);
+        CHECK(constList[1].depth == 4.f);
+        CHECK(constList[2].depth == 5.f);
+        CHECK(constList[3].depth == 2.f);
+        CHECK(constList[4].depth == 1.f);
+
+        UNSCOPED_INFO("Check the queries use the sorted items.");
+        auto items = constList.getItemsAtNode(2, 3);
+        REQUIRE(items.size() == 2);
+        CHECK(items[0].depth == 4.f);
+        CHECK(items[1].depth == 5.f);
+
+        UNSCOPED_INFO("Check sorting descending keeps the order of equal items.");
+        trackingList.sortByNode(true);
+        CHECK(constList[0].depth == 1.f);
+        CHECK(constList[1].depth == 2.f);
+        CHECK(constList[2].depth == 4.f);
+        CHECK(constList[3].depth == 5.f);
+        CHECK(constList[4].depth == 3.f);
+
+        items = constList.getItemsAtNode(2, 3);
+        REQUIRE(items.size() == 2);
+        CHECK(items[0].depth == 4.f);
+        CHECK(items[1].depth == 5.f);
+
+        items = constList.getItemsInWindow(0, 0, 2, 299);
+        REQUIRE(items.size() == 3);
+        CHECK(items[0].depth == 3.f);
+        CHECK(items[1].depth == 4.f);
+        CHECK(items[2].depth == 5.f);
+
+        UNSCOPED_INFO("Check sorting by track code and list series.");
+        trackingList.sortByCode();
+        CHECK(constList[0].track_code == 1);
+        CHECK(constList[0].depth == 1.f);
+        CHECK(constList[2].depth == 3.f);
+        CHECK(constList[4].track_code == 3);
+
+        trackingList.sortBySeries(true);
+        CHECK(constList[0].list_series == 20);
+        CHECK(constList[1].list_series == 20);
+        CHECK(constList[2].list_series == 10);
+        CHECK(constList.getItemsInSeries(10).size() == 3);
+
+        REQUIRE_NOTHROW(trackingList.write());
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    UNSCOPED_INFO("Check the sorted order reached the file.");
+    const auto& trackingList = pDataset->getTrackingList();
+    REQUIRE(trackingList.size() == 5);
+    CHECK(trackingList[0].list_series == 20);
+    CHECK(trackingList[4].list_series == 10);
+}
@@ -0,0 +1,52 @@
+#include <bag_uint8array.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <thread>
+
+
+using BAG::UInt8Array;
+
+//  explicit UInt8Array(size_t len);
+TEST_CASE("test uint8array zero initialized", "[uint8array][constructor]")
+{
+    const UInt8Array array{100};
+    REQUIRE(array);
+    CHECK(array.size() == 100);
+
+    for (size_t i = 0; i < array.size(); ++i)
+        CHECK(array[i] == 0);
+}
+
+//  static UInt8Array uninitialized(size_t len);
+TEST_CASE("test uint8array uninitialized", "[uint8array][uninitialized]")
+{
+    constexpr size_t kSize = 100'000;
+
+    UInt8Array first = UInt8Array::uninitialized(kSize);
+    REQUIRE(first);
+    CHECK(first.size() == kSize);
+
+    UNSCOPED_INFO("Check a freed buffer is reused for the same size.");
+    const auto* pFirst = first.data();
+    first = UInt8Array{};
+
+    UInt8Array second = UInt8Array::uninitialized(kSize);
+    CHECK(second.data() == pFirst);
+
+    UNSCOPED_INFO("Check buffers in use are not handed out twice.");
+    const UInt8Array third = UInt8Array::uninitialized(kSize);
+    CHECK(third.data() != second.data());
+
+    UNSCOPED_INFO("Check a released buffer can be freed with delete[].");
+    std::memset(second.data(), 1, kSize);
+    delete[] second.release();
+    CHECK_FALSE(second);
+
+    UNSCOPED_INFO("Check a buffer can be freed by another thread.");
+    UInt8Array fourth = UInt8Array::uninitialized(kSize);
+    std::thread{[&fourth]() {
+        fourth = UInt8Array{};
+    }}.join();
+    CHECK_FALSE(fourth);
+}
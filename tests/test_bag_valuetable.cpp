@@ -6,11 +6,15 @@
 #include <bag_metadata.h>
 #include <bag_types.h>
 #include <bag_valuetable.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrrefinements.h>
 
 #include <array>
 #include <catch2/catch_all.hpp>
 #include <cstring>  //strcmp
 #include <string>
+#include <tuple>
+#include <vector>
 
 
 using BAG::Dataset;
@@ -850,3 +854,872 @@ TEST_CASE("test georeferenced metadata layer readVR/writeVR", "[georefMetadatala
     }
 }
 
+TEST_CASE("test value table columnar storage", "[valuetable][constructor][getNumRecords][getValue][setValue][getRecords]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    constexpr uint32_t kNumRecords = 1000;
+    BAG::Records expectedRecords;
+    for (uint32_t i=0; i<kNumRecords; ++i)
+        expectedRecords.push_back({CompoundDataType{static_cast<float>(i) / 2.f},
+            CompoundDataType{i}, CompoundDataType{std::string(i % 17, 'x')},
+            CompoundDataType{i % 2 == 0}});
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t chunkSize = 100;
+        constexpr int compressionLevel = 6;
+
+        auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        BAG::RecordDefinition definition(4);
+        definition[0].name = "float";
+        definition[0].type = DT_FLOAT32;
+        definition[1].name = "uint";
+        definition[1].type = DT_UINT32;
+        definition[2].name = "string";
+        definition[2].type = DT_STRING;
+        definition[3].name = "bool";
+        definition[3].type = DT_BOOLEAN;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+            UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+            compressionLevel);
+
+        REQUIRE_NOTHROW(layer.getValueTable().addRecords(expectedRecords));
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READ_WRITE);
+    REQUIRE(pDataset);
+
+    auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+    REQUIRE(pLayer);
+
+    auto& valueTable = pLayer->getValueTable();
+
+    UNSCOPED_INFO("Check the records are counted without decoding them.");
+    CHECK(valueTable.getNumRecords() == kNumRecords + 1);
+
+    UNSCOPED_INFO("Check single values decode as written.");
+    CHECK(valueTable.getValue(1, "float") == expectedRecords[0][0]);
+    CHECK(valueTable.getValue(500, "uint") == expectedRecords[499][1]);
+    CHECK(valueTable.getValue(17, "string") == expectedRecords[16][2]);
+    CHECK(valueTable.getValue(kNumRecords, "bool") ==
+        expectedRecords[kNumRecords - 1][3]);
+
+    UNSCOPED_INFO("Check setting values in decoded and undecoded records.");
+    REQUIRE_NOTHROW(valueTable.setValue(17, "string",
+        CompoundDataType{std::string{"decoded"}}));
+    REQUIRE_NOTHROW(valueTable.setValue(900, "string",
+        CompoundDataType{std::string{"undecoded"}}));
+    expectedRecords[16][2] = CompoundDataType{std::string{"decoded"}};
+    expectedRecords[899][2] = CompoundDataType{std::string{"undecoded"}};
+
+    UNSCOPED_INFO("Check setting a value of the wrong type throws.");
+    REQUIRE_THROWS_AS(valueTable.setValue(2, "uint", CompoundDataType{1.f}),
+        BAG::InvalidValue);
+
+    UNSCOPED_INFO("Check all records decode, including the no data value record.");
+    const auto& records = valueTable.getRecords();
+    REQUIRE(records.size() == kNumRecords + 1);
+    CHECK(records[0].size() == 4);
+
+    for (uint32_t i=0; i<kNumRecords; ++i)
+        CHECK(records[i + 1] == expectedRecords[i]);
+}
+
+TEST_CASE("test value table appender", "[valuetable][beginAppend][addRecord][commit][getNumRecords]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    constexpr uint32_t kNumRecords = 250;
+    BAG::Records expectedRecords;
+    for (uint32_t i=0; i<kNumRecords; ++i)
+        expectedRecords.push_back({CompoundDataType{static_cast<float>(i)},
+            CompoundDataType{std::string(i % 7, 'a')}});
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t chunkSize = 100;
+        constexpr int compressionLevel = 6;
+
+        auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        BAG::RecordDefinition definition(2);
+        definition[0].name = "float";
+        definition[0].type = DT_FLOAT32;
+        definition[1].name = "string";
+        definition[1].type = DT_STRING;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+            UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+            compressionLevel);
+        auto& valueTable = layer.getValueTable();
+
+        UNSCOPED_INFO("Check an appender not committed adds nothing.");
+        {
+            auto pAppender = valueTable.beginAppend();
+            REQUIRE(pAppender);
+            REQUIRE_NOTHROW(pAppender->addRecords(expectedRecords));
+            CHECK(pAppender->size() == kNumRecords + 1);
+        }
+        CHECK(valueTable.getNumRecords() == 1);
+
+        UNSCOPED_INFO("Check records only appear once committed.");
+        auto pAppender = valueTable.beginAppend();
+        for (uint32_t i=0; i<kNumRecords; ++i)
+            CHECK(pAppender->addRecord(expectedRecords[i]) == i + 1);
+
+        CHECK(valueTable.getNumRecords() == 1);
+
+        REQUIRE_NOTHROW(pAppender->commit());
+        CHECK(valueTable.getNumRecords() == kNumRecords + 1);
+        CHECK(valueTable.getValue(kNumRecords, "float") ==
+            expectedRecords.back()[0]);
+
+        UNSCOPED_INFO("Check a committed appender rejects records.");
+        REQUIRE_THROWS_AS(pAppender->addRecord(expectedRecords[0]),
+            BAG::InvalidValueKey);
+
+        UNSCOPED_INFO("Check invalid records are rejected.");
+        auto pOther = valueTable.beginAppend();
+        REQUIRE_THROWS_AS(pOther->addRecord({CompoundDataType{1.f}}),
+            BAG::InvalidValue);
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+    REQUIRE(pLayer);
+
+    UNSCOPED_INFO("Check the appended records were written.");
+    const auto& records = pLayer->getValueTable().getRecords();
+    REQUIRE(records.size() == kNumRecords + 1);
+
+    for (uint32_t i=0; i<kNumRecords; ++i)
+        CHECK(records[i + 1] == expectedRecords[i]);
+}
+
+TEST_CASE("test georeferenced metadata layer read resolved", "[georefMetadatalayer][readResolved][readVRResolved]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    const BAG::Records kRecords{
+        {CompoundDataType{1.5f}, CompoundDataType{std::string{"survey a"}}},
+        {CompoundDataType{2.5f}, CompoundDataType{std::string{"survey b"}}},
+        {CompoundDataType{3.5f}, CompoundDataType{std::string{"survey c"}}},
+    };
+
+    // Keys for rows 0-1, columns 0-2; 0 is the no data value record.
+    const std::array<uint16_t, 6> kSingleResolutionKeys{1, 1, 2, 0, 3, 3};
+    const std::array<uint16_t, 4> kVariableResolutionKeys{3, 3, 3, 1};
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t chunkSize = 100;
+        constexpr int compressionLevel = 6;
+
+        auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        constexpr bool kMakeNode = false;
+        pDataset->createVR(chunkSize, compressionLevel, kMakeNode);
+
+        BAG::RecordDefinition definition(2);
+        definition[0].name = "float";
+        definition[0].type = DT_FLOAT32;
+        definition[1].name = "source";
+        definition[1].type = DT_STRING;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+            UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+            compressionLevel);
+
+        layer.getValueTable().addRecords(kRecords);
+
+        layer.write(0, 0, 1, 2,
+            reinterpret_cast<const uint8_t*>(kSingleResolutionKeys.data()));
+        layer.writeVR(10, 13,
+            reinterpret_cast<const uint8_t*>(kVariableResolutionKeys.data()));
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+    REQUIRE(pLayer);
+
+    UNSCOPED_INFO("Check single resolution values resolve in field order.");
+    {
+        const auto columns = pLayer->readResolved(0, 0, 1, 2, {"source", "float"});
+        REQUIRE(columns.size() == 2);
+
+        CHECK(columns[0].name == "source");
+        CHECK(columns[0].type == DT_STRING);
+        CHECK(columns[1].type == DT_FLOAT32);
+        REQUIRE(columns[0].strings.size() == kSingleResolutionKeys.size());
+        REQUIRE(columns[1].floats.size() == kSingleResolutionKeys.size());
+        CHECK(columns[1].uint32s.empty());
+
+        for (size_t i=0; i<kSingleResolutionKeys.size(); ++i)
+        {
+            const auto key = kSingleResolutionKeys[i];
+            if (key == 0)
+            {
+                CHECK(columns[0].strings[i].empty());
+                CHECK(columns[1].floats[i] == 0.f);
+                continue;
+            }
+
+            CHECK(columns[0].strings[i] == kRecords[key - 1][1].asString());
+            CHECK(columns[1].floats[i] == kRecords[key - 1][0].asFloat());
+        }
+    }
+
+    UNSCOPED_INFO("Check variable resolution values resolve.");
+    {
+        const auto columns = pLayer->readVRResolved(10, 13, {"float"});
+        REQUIRE(columns.size() == 1);
+        REQUIRE(columns[0].floats.size() == kVariableResolutionKeys.size());
+
+        for (size_t i=0; i<kVariableResolutionKeys.size(); ++i)
+            CHECK(columns[0].floats[i] ==
+                kRecords[kVariableResolutionKeys[i] - 1][0].asFloat());
+    }
+
+    UNSCOPED_INFO("Check an unknown field throws.");
+    REQUIRE_THROWS_AS(pLayer->readResolved(0, 0, 0, 0, {"missing"}),
+        BAG::FieldNotFound);
+}
+
+//  VRResolvedRead readVRResolved(
+//      const std::vector<std::pair<uint32_t, uint32_t>>& cells,
+//      const std::vector<std::string>& fieldNames) const;
+//  VRResolvedRead readVRResolved(double minX, double minY, double maxX,
+//      double maxY, const std::vector<std::string>& fieldNames) const;
+TEST_CASE("test georeferenced metadata layer read vr resolved cells", "[georefMetadatalayer][readVRResolved]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    const BAG::Records kRecords{
+        {CompoundDataType{1.5f}},
+        {CompoundDataType{2.5f}},
+    };
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    // Writing the refinements changes the dimensions of the descriptor.
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    constexpr bool kMakeNode = false;
+    pDataset->createVR(chunkSize, compressionLevel, kMakeNode);
+
+    BAG::RecordDefinition definition(1);
+    definition[0].name = "float";
+    definition[0].type = DT_FLOAT32;
+
+    auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+        UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+        compressionLevel);
+    layer.getValueTable().addRecords(kRecords);
+
+    // Refinement i has depth i and key i % 3.
+    constexpr uint32_t kNumRefinements = 12;
+    std::vector<BAG::VRRefinementsItem> refinements(kNumRefinements);
+    std::vector<uint16_t> keys(kNumRefinements);
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+    {
+        refinements[i] = {static_cast<float>(i), 0.5f * i};
+        keys[i] = static_cast<uint16_t>(i % 3);
+    }
+
+    pDataset->getVRRefinements()->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(refinements.data()));
+    layer.writeVR(0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(keys.data()));
+
+    // (4, 6) is 2x2 at 6, and (4, 7) is 3x2 at 0.
+    std::vector<BAG::VRMetadataItem> items(numRows * numColumns,
+        BAG::VRMetadataItem{});
+    items[4 * numColumns + 6] = {6, 2, 2, 1.f, 1.f, 0.f, 0.f};
+    items[4 * numColumns + 7] = {0, 3, 2, 1.f, 1.f, 0.f, 0.f};
+
+    pDataset->getVRMetadata()->write(0, 0, numRows - 1, numColumns - 1,
+        reinterpret_cast<const uint8_t*>(items.data()));
+
+    const auto checkRead = [&](const BAG::VRResolvedRead& read) {
+        REQUIRE(read.cells.size() == 2);
+        CHECK(read.cells[0].row == 4);
+        CHECK(read.cells[0].column == 7);
+        CHECK(read.cells[0].offset == 0);
+        CHECK(read.cells[0].count == 6);
+        CHECK(read.cells[1].column == 6);
+        CHECK(read.cells[1].metadata.index == 6);
+        CHECK(read.cells[1].offset == 6);
+        CHECK(read.cells[1].count == 4);
+
+        REQUIRE(read.depths.size() == 10);
+        REQUIRE(read.uncertainties.size() == 10);
+        REQUIRE(read.columns.size() == 1);
+        REQUIRE(read.columns[0].floats.size() == 10);
+
+        for (uint32_t i=0; i<10; ++i)
+        {
+            CHECK(read.depths[i] == static_cast<float>(i));
+            CHECK(read.uncertainties[i] == 0.5f * i);
+
+            const auto key = keys[i];
+            CHECK(read.columns[0].floats[i] ==
+                (key == 0 ? 0.f : kRecords[key - 1][0].asFloat()));
+        }
+    };
+
+    UNSCOPED_INFO("Check a list of cells reads the refined ones.");
+    checkRead(layer.readVRResolved({{4, 6}, {0, 0}, {4, 7}, {4, 6},
+        {100000, 0}}, {"float"}));
+
+    UNSCOPED_INFO("Check an area reads the refined cells overlapping it.");
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    // From inside cell (3, 6) to inside cell (4, 7).
+    checkRead(layer.readVRResolved(originX + 6 * spacingX,
+        originY + 3 * spacingY, originX + 6.6 * spacingX,
+        originY + 4.2 * spacingY, {"float"}));
+
+    UNSCOPED_INFO("Check an area outside the grid reads nothing.");
+    const auto outside = layer.readVRResolved(originX - 10 * spacingX,
+        originY - 10 * spacingY, originX - 5 * spacingX,
+        originY - 5 * spacingY, {"float"});
+    CHECK(outside.cells.empty());
+    REQUIRE(outside.columns.size() == 1);
+    CHECK(outside.columns[0].floats.empty());
+}
+
+TEST_CASE("test value table indexes", "[valuetable][createIndex][findKeys][georefMetadatalayer][findCells]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    BAG::RecordDefinition definition(3);
+    definition[0].name = "survey id";
+    definition[0].type = DT_UINT32;
+    definition[1].name = "date";
+    definition[1].type = DT_FLOAT32;
+    definition[2].name = "name";
+    definition[2].type = DT_STRING;
+
+    auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT8,
+        UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+        compressionLevel);
+    auto& valueTable = layer.getValueTable();
+
+    // Keys 1-20; survey ids repeat every 5 records.
+    BAG::Records records;
+    for (uint32_t i=0; i<20; ++i)
+        records.push_back({CompoundDataType{i % 5}, CompoundDataType{i * 10.f},
+            CompoundDataType{std::string{"survey "} + std::to_string(i % 5)}});
+    valueTable.addRecords(records);
+
+    const BAG::ValueQuery byId{"survey id", CompoundDataType{2u},
+        CompoundDataType{2u}};
+    const BAG::ValueQuery byDate{"date", CompoundDataType{45.f},
+        CompoundDataType{100.f}};
+    const BAG::ValueQuery byName{"name", CompoundDataType{std::string{"survey 4"}},
+        CompoundDataType{std::string{"survey 4"}}};
+
+    const std::vector<size_t> kExpectedById{3, 8, 13, 18};
+    const std::vector<size_t> kExpectedByDate{6, 7, 8, 9, 10, 11};
+    const std::vector<size_t> kExpectedByName{5, 10, 15, 20};
+
+    UNSCOPED_INFO("Check queries without an index scan the columns.");
+    CHECK_FALSE(valueTable.hasIndex("survey id"));
+    CHECK(valueTable.findKeys(byId) == kExpectedById);
+    CHECK(valueTable.findKeys(byDate) == kExpectedByDate);
+    CHECK(valueTable.findKeys(byName) == kExpectedByName);
+
+    UNSCOPED_INFO("Check queries give the same keys with an index.");
+    valueTable.createIndex("survey id");
+    valueTable.createIndex("date");
+    valueTable.createIndex("name");
+    CHECK(valueTable.hasIndex("survey id"));
+    CHECK(valueTable.findKeys(byId) == kExpectedById);
+    CHECK(valueTable.findKeys(byDate) == kExpectedByDate);
+    CHECK(valueTable.findKeys(byName) == kExpectedByName);
+
+    UNSCOPED_INFO("Check indexes follow added and changed records.");
+    valueTable.setValue(3, "survey id", CompoundDataType{7u});
+    valueTable.setValue(6, "date", CompoundDataType{1000.f});
+    valueTable.setValue(5, "name", CompoundDataType{std::string{"renamed"}});
+    const auto newKey = valueTable.addRecord({CompoundDataType{2u},
+        CompoundDataType{50.f}, CompoundDataType{std::string{"survey 4"}}});
+
+    CHECK(valueTable.findKeys(byId) == std::vector<size_t>{8, 13, 18, newKey});
+    CHECK(valueTable.findKeys(byDate) ==
+        std::vector<size_t>{7, 8, 9, 10, 11, newKey});
+    CHECK(valueTable.findKeys(byName) ==
+        std::vector<size_t>{10, 15, 20, newKey});
+
+    UNSCOPED_INFO("Check a query of the wrong type throws.");
+    REQUIRE_THROWS_AS(valueTable.findKeys({"date", CompoundDataType{1u},
+        CompoundDataType{2u}}), BAG::InvalidValue);
+
+    UNSCOPED_INFO("Check finding the cells of the matching keys.");
+    const std::array<uint8_t, 6> kKeys{8, 1, 13, 0, 3, 8};
+    layer.write(0, 0, 1, 2, kKeys.data());
+
+    const auto cells = layer.findCells(byId, 0, 0, 1, 2);
+    const std::vector<std::pair<uint32_t, uint32_t>> kExpectedCells{
+        {0, 0}, {0, 2}, {1, 2}};
+    CHECK(cells == kExpectedCells);
+
+    valueTable.dropIndex("survey id");
+    CHECK_FALSE(valueTable.hasIndex("survey id"));
+    CHECK(layer.findCells(byId, 0, 0, 1, 2) == kExpectedCells);
+}
+
+TEST_CASE("test georeferenced metadata layer key statistics", "[georefMetadatalayer][computeKeyStatistics][computeVRKeyStatistics]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    std::vector<BAG::KeyStatistics> expectedStatistics;
+    uint64_t numNodes = 0;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t chunkSize = 10;
+        constexpr int compressionLevel = 6;
+
+        auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        constexpr bool kMakeNode = false;
+        pDataset->createVR(chunkSize, compressionLevel, kMakeNode);
+
+        uint32_t rows = 0, columns = 0;
+        std::tie(rows, columns) = pDataset->getDescriptor().getDims();
+        numNodes = static_cast<uint64_t>(rows) * columns;
+
+        BAG::RecordDefinition definition(1);
+        definition[0].name = "id";
+        definition[0].type = DT_UINT32;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+            UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+            compressionLevel);
+        layer.getValueTable().addRecords({{CompoundDataType{1u}},
+            {CompoundDataType{2u}}, {CompoundDataType{3u}}});
+
+        UNSCOPED_INFO("Check an unwritten layer is all no data keys.");
+        auto statistics = layer.computeKeyStatistics();
+        REQUIRE(statistics.size() == 4);
+        CHECK(statistics[0].count == numNodes);
+        CHECK(statistics[1].count == 0);
+
+        // Key 1 in a block of rows 2-4, columns 5-6; key 2 in two far corners.
+        const std::array<uint16_t, 6> kBlock{1, 1, 1, 1, 1, 1};
+        layer.write(2, 5, 4, 6, reinterpret_cast<const uint8_t*>(kBlock.data()));
+
+        const uint16_t kCorner = 2;
+        layer.write(1, 0, 1, 0, reinterpret_cast<const uint8_t*>(&kCorner));
+        layer.write(rows - 1, columns - 1, rows - 1, columns - 1,
+            reinterpret_cast<const uint8_t*>(&kCorner));
+
+        UNSCOPED_INFO("Check the counts and extents of each key.");
+        statistics = layer.computeKeyStatistics(true);
+        REQUIRE(statistics.size() == 4);
+
+        CHECK(statistics[0].count == numNodes - 8);
+
+        CHECK(statistics[1].count == 6);
+        CHECK(statistics[1].minRow == 2);
+        CHECK(statistics[1].maxRow == 4);
+        CHECK(statistics[1].minColumn == 5);
+        CHECK(statistics[1].maxColumn == 6);
+
+        CHECK(statistics[2].count == 2);
+        CHECK(statistics[2].minRow == 1);
+        CHECK(statistics[2].maxRow == rows - 1);
+        CHECK(statistics[2].minColumn == 0);
+        CHECK(statistics[2].maxColumn == columns - 1);
+
+        CHECK(statistics[3].count == 0);
+
+        expectedStatistics = statistics;
+
+        // Keys 3, 3, 2 at indices 20-22.
+        const std::array<uint16_t, 3> kVRKeys{3, 3, 2};
+        layer.writeVR(20, 22, reinterpret_cast<const uint8_t*>(kVRKeys.data()));
+
+        UNSCOPED_INFO("Check the variable resolution counts and extents.");
+        const auto vrStatistics = layer.computeVRKeyStatistics(true);
+        REQUIRE(vrStatistics.size() == 4);
+        CHECK(vrStatistics[0].count == 20);
+        CHECK(vrStatistics[3].count == 2);
+        CHECK(vrStatistics[3].minRow == 0);
+        CHECK(vrStatistics[3].minColumn == 20);
+        CHECK(vrStatistics[3].maxColumn == 21);
+        CHECK(vrStatistics[2].count == 1);
+        CHECK(vrStatistics[2].minColumn == 22);
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READ_WRITE);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+    REQUIRE(pLayer);
+
+    UNSCOPED_INFO("Check the cached statistics are read back.");
+    auto statistics = pLayer->computeKeyStatistics();
+    REQUIRE(statistics.size() == expectedStatistics.size());
+    for (size_t key=0; key<statistics.size(); ++key)
+    {
+        CHECK(statistics[key].count == expectedStatistics[key].count);
+        CHECK(statistics[key].minRow == expectedStatistics[key].minRow);
+        CHECK(statistics[key].maxColumn == expectedStatistics[key].maxColumn);
+    }
+
+    CHECK(pLayer->computeVRKeyStatistics()[3].count == 2);
+
+    UNSCOPED_INFO("Check writing keys discards the cached statistics.");
+    const uint16_t kKey = 3;
+    pLayer->write(0, 0, 0, 0, reinterpret_cast<const uint8_t*>(&kKey));
+
+    statistics = pLayer->computeKeyStatistics();
+    CHECK(statistics[3].count == 1);
+    CHECK(statistics[0].count == numNodes - 9);
+}
+
+TEST_CASE("test georeferenced metadata layer key type", "[georefMetadatalayer][setKeyType][narrowKeyType][readKeys][readVRKeys]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    const std::array<uint32_t, 4> kBlock{1, 2, 2, 1};
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t chunkSize = 10;
+        constexpr int compressionLevel = 6;
+
+        auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            chunkSize, compressionLevel);
+        REQUIRE(pDataset);
+
+        constexpr bool kMakeNode = false;
+        pDataset->createVR(chunkSize, compressionLevel, kMakeNode);
+
+        BAG::RecordDefinition definition(2);
+        definition[0].name = "id";
+        definition[0].type = DT_UINT32;
+        definition[1].name = "source";
+        definition[1].type = DT_STRING;
+
+        auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT8,
+            UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+            compressionLevel);
+        auto& valueTable = layer.getValueTable();
+        valueTable.addRecords({
+            {CompoundDataType{1u}, CompoundDataType{std::string{"survey"}}},
+            {CompoundDataType{2u}, CompoundDataType{std::string{"chart"}}}});
+
+        const std::array<uint8_t, 4> kNarrowBlock{1, 2, 2, 1};
+        layer.write(3, 4, 4, 5, kNarrowBlock.data());
+
+        UNSCOPED_INFO("Check the key type limits the number of records/values.");
+        BAG::Records records;
+        for (uint32_t id=3; valueTable.getNumRecords() + records.size() < 255;
+            ++id)
+            records.push_back({CompoundDataType{id},
+                CompoundDataType{std::string{"fill"}}});
+        valueTable.addRecords(records);
+        REQUIRE(valueTable.getNumRecords() == 255);
+
+        const BAG::Record kRecord{CompoundDataType{500u},
+            CompoundDataType{std::string{"late"}}};
+        REQUIRE_THROWS_AS(valueTable.addRecord(kRecord), BAG::KeyTypeTooNarrow);
+        REQUIRE_THROWS_AS(layer.setKeyType(DT_FLOAT32), BAG::InvalidKeyType);
+
+        UNSCOPED_INFO("Check widening the keys makes room for more.");
+        layer.setKeyType(DT_UINT32);
+        CHECK(layer.getDescriptor()->getDataType() == DT_UINT32);
+        CHECK(layer.getDescriptor()->getElementSize() == 4);
+        CHECK(valueTable.addRecord(kRecord) == 255);
+        CHECK(layer.getNarrowestKeyType() == DT_UINT16);
+        REQUIRE_THROWS_AS(layer.setKeyType(DT_UINT8), BAG::KeyTypeTooNarrow);
+
+        const auto wideKeys = layer.read(3, 4, 4, 5);
+        REQUIRE(wideKeys.size() == kBlock.size() * sizeof(uint32_t));
+        for (size_t i=0; i<kBlock.size(); ++i)
+            CHECK(reinterpret_cast<const uint32_t*>(wideKeys.data())[i] ==
+                kBlock[i]);
+
+        UNSCOPED_INFO("Check a key too large for the key type prevents narrowing.");
+        const uint32_t kLargeKey = 70000;
+        layer.write(0, 0, 0, 0, reinterpret_cast<const uint8_t*>(&kLargeKey));
+        REQUIRE_THROWS_AS(layer.narrowKeyType(), BAG::KeyTypeTooNarrow);
+        CHECK(layer.getDescriptor()->getDataType() == DT_UINT32);
+
+        const auto largeKey = layer.readKeys(0, 0, 0, 0, DT_UINT64);
+        CHECK(*reinterpret_cast<const uint64_t*>(largeKey.data()) == kLargeKey);
+
+        const uint32_t kLastKey = 255;
+        layer.write(0, 0, 0, 0, reinterpret_cast<const uint8_t*>(&kLastKey));
+
+        UNSCOPED_INFO("Check narrowing the keys keeps them.");
+        CHECK(layer.narrowKeyType() == DT_UINT16);
+        CHECK(layer.getDescriptor()->getElementSize() == 2);
+
+        const auto keys = layer.read(3, 4, 4, 5);
+        REQUIRE(keys.size() == kBlock.size() * sizeof(uint16_t));
+        for (size_t i=0; i<kBlock.size(); ++i)
+            CHECK(reinterpret_cast<const uint16_t*>(keys.data())[i] ==
+                kBlock[i]);
+
+        const auto readKeys = layer.readKeys(3, 4, 4, 5, DT_UINT32);
+        REQUIRE(readKeys.size() == kBlock.size() * sizeof(uint32_t));
+        for (size_t i=0; i<kBlock.size(); ++i)
+            CHECK(reinterpret_cast<const uint32_t*>(readKeys.data())[i] ==
+                kBlock[i]);
+
+        REQUIRE_THROWS_AS(layer.readKeys(3, 4, 4, 5, DT_UINT8),
+            BAG::InvalidKeyType);
+    }
+
+    {
+        const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READ_WRITE);
+        REQUIRE(pDataset);
+
+        auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+        REQUIRE(pLayer);
+        CHECK(pLayer->getDescriptor()->getDataType() == DT_UINT16);
+
+        UNSCOPED_INFO("Check the variable resolution keys are rewritten too.");
+        const std::array<uint16_t, 2> kVRKeys{2, 255};
+        pLayer->writeVR(5, 6, reinterpret_cast<const uint8_t*>(kVRKeys.data()));
+
+        pLayer->setKeyType(DT_UINT32);
+
+        const auto vrKeys = pLayer->readVRKeys(5, 6, DT_UINT64);
+        REQUIRE(vrKeys.size() == 2 * sizeof(uint64_t));
+        CHECK(reinterpret_cast<const uint64_t*>(vrKeys.data())[0] == 2);
+        CHECK(reinterpret_cast<const uint64_t*>(vrKeys.data())[1] == 255);
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto pLayer = pDataset->getGeorefMetadataLayer(kExpectedLayerName);
+    REQUIRE(pLayer);
+
+    UNSCOPED_INFO("Check the rewritten keys and values are read back.");
+    CHECK(pLayer->getDescriptor()->getDataType() == DT_UINT32);
+
+    const auto keys = pLayer->read(0, 0, 3, 4);
+    const auto* typedKeys = reinterpret_cast<const uint32_t*>(keys.data());
+    CHECK(typedKeys[0] == 255);
+    CHECK(typedKeys[3 * 5 + 4] == kBlock[0]);
+
+    const auto vrKeys = pLayer->readVR(6, 6);
+    CHECK(*reinterpret_cast<const uint32_t*>(vrKeys.data()) == 255);
+
+    const auto& valueTable = pLayer->getValueTable();
+    REQUIRE(valueTable.getNumRecords() == 256);
+    CHECK(valueTable.getUInt32(1, 0) == 1);
+    CHECK(std::string{valueTable.getString(2, 1)} == "chart");
+    CHECK(std::string{valueTable.getString(255, 1)} == "late");
+}
+
+TEST_CASE("test value table typed getters and moved records", "[valuetable][getFloat][getUInt32][getBool][getString][addRecord][addRecords]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+    const std::string kExpectedLayerName = "elevation";
+
+    using BAG::CompoundDataType;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    BAG::RecordDefinition definition(4);
+    definition[0].name = "float";
+    definition[0].type = DT_FLOAT32;
+    definition[1].name = "uint";
+    definition[1].type = DT_UINT32;
+    definition[2].name = "bool";
+    definition[2].type = DT_BOOLEAN;
+    definition[3].name = "string";
+    definition[3].type = DT_STRING;
+
+    auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+        UNKNOWN_METADATA_PROFILE, kExpectedLayerName, definition, chunkSize,
+        compressionLevel);
+    auto& valueTable = layer.getValueTable();
+
+    const std::string kLongString(100, 'z');
+
+    UNSCOPED_INFO("Check records can be moved into the value table.");
+    BAG::Record record{CompoundDataType{1.25f}, CompoundDataType{7u},
+        CompoundDataType{true}, CompoundDataType{kLongString}};
+    const BAG::Record expectedRecord = record;
+    CHECK(valueTable.addRecord(std::move(record)) == 1);
+
+    BAG::Records records{
+        {CompoundDataType{2.5f}, CompoundDataType{8u}, CompoundDataType{false},
+            CompoundDataType{std::string{"two"}}},
+        {CompoundDataType{3.75f}, CompoundDataType{9u}, CompoundDataType{true},
+            CompoundDataType{std::string{"three"}}},
+    };
+    const auto expectedRecords = records;
+    valueTable.addRecords(std::move(records));
+    CHECK(valueTable.getNumRecords() == 4);
+
+    CHECK(valueTable.getRecords()[1] == expectedRecord);
+    CHECK(valueTable.getRecords()[3] == expectedRecords[1]);
+
+    UNSCOPED_INFO("Check the typed getters read the values.");
+    CHECK(valueTable.getFloat(1, 0) == 1.25f);
+    CHECK(valueTable.getUInt32(2, 1) == 8u);
+    CHECK_FALSE(valueTable.getBool(2, 2));
+    CHECK(valueTable.getString(1, 3) == kLongString);
+    CHECK(std::string{valueTable.getString(3, 3)} == "three");
+
+    UNSCOPED_INFO("Check the no data value record can be read.");
+    CHECK(valueTable.getFloat(0, 0) == 0.f);
+    CHECK(std::string{valueTable.getString(0, 3)}.empty());
+
+    UNSCOPED_INFO("Check invalid arguments throw.");
+    REQUIRE_THROWS_AS(valueTable.getFloat(1, 1), BAG::InvalidType);
+    REQUIRE_THROWS_AS(valueTable.getUInt32(4, 1), BAG::ValueNotFound);
+    REQUIRE_THROWS_AS(valueTable.getBool(1, 4), BAG::FieldNotFound);
+}
+
+TEST_CASE("test value table export columns", "[valuetable][exportColumn][exportColumns]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    using BAG::CompoundDataType;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t chunkSize = 100;
+    constexpr int compressionLevel = 6;
+
+    auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        chunkSize, compressionLevel);
+    REQUIRE(pDataset);
+
+    BAG::RecordDefinition definition(4);
+    definition[0].name = "float";
+    definition[0].type = DT_FLOAT32;
+    definition[1].name = "uint";
+    definition[1].type = DT_UINT32;
+    definition[2].name = "bool";
+    definition[2].type = DT_BOOLEAN;
+    definition[3].name = "string";
+    definition[3].type = DT_STRING;
+
+    auto& layer = pDataset->createGeorefMetadataLayer(DT_UINT16,
+        UNKNOWN_METADATA_PROFILE, "elevation", definition, chunkSize,
+        compressionLevel);
+    auto& valueTable = layer.getValueTable();
+
+    valueTable.addRecords(BAG::Records{
+        {CompoundDataType{2.5f}, CompoundDataType{8u}, CompoundDataType{false},
+            CompoundDataType{std::string{"two"}}},
+        {CompoundDataType{3.75f}, CompoundDataType{9u}, CompoundDataType{true},
+            CompoundDataType{std::string{"three"}}},
+    });
+
+    const auto columns = valueTable.exportColumns();
+    REQUIRE(columns.size() == 4);
+
+    UNSCOPED_INFO("Check numbers are packed in key order, after the no data value.");
+    CHECK(columns[0].name == "float");
+    CHECK(columns[0].type == DT_FLOAT32);
+    REQUIRE(columns[0].values.size() == 3 * sizeof(float));
+    std::array<float, 3> floats{};
+    std::memcpy(floats.data(), columns[0].values.data(), sizeof(floats));
+    CHECK(floats == std::array<float, 3>{0.f, 2.5f, 3.75f});
+
+    REQUIRE(columns[1].values.size() == 3 * sizeof(uint32_t));
+    std::array<uint32_t, 3> uint32s{};
+    std::memcpy(uint32s.data(), columns[1].values.data(), sizeof(uint32s));
+    CHECK(uint32s == std::array<uint32_t, 3>{0u, 8u, 9u});
+
+    CHECK(columns[2].values == std::vector<uint8_t>{0, 0, 1});
+    CHECK(columns[2].offsets.empty());
+
+    UNSCOPED_INFO("Check strings use offsets into unterminated characters.");
+    CHECK(columns[3].values.empty());
+    CHECK(columns[3].offsets == std::vector<uint64_t>{0, 0, 3, 8});
+    CHECK(std::string(columns[3].characters.begin(),
+        columns[3].characters.end()) == "twothree");
+
+    CHECK(valueTable.exportColumn(3).offsets == columns[3].offsets);
+    REQUIRE_THROWS_AS(valueTable.exportColumn(4), BAG::FieldNotFound);
+}
@@ -0,0 +1,458 @@
+
+#include "test_utils.h"
+#include <bag_dataset.h>
+#include <bag_exceptions.h>
+#include <bag_metadata.h>
+#include <bag_vrindex.h>
+#include <bag_vrmetadata.h>
+#include <bag_vrrefinements.h>
+#include <bag_vrtrackinglist.h>
+
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <vector>
+
+
+using BAG::Dataset;
+using BAG::VRIndex;
+using BAG::VRPoint;
+
+namespace {
+
+const std::string kMetadataXML{R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>
+<gmi:MI_Metadata xmlns:gmi="http://www.isotc211.org/2005/gmi"
+    xmlns:bag="http://www.opennavsurf.org/schema/bag"
+    xmlns:gco="http://www.isotc211.org/2005/gco"
+    xmlns:gmd="http://www.isotc211.org/2005/gmd"
+    xmlns:gml="http://www.opengis.net/gml/3.2"
+    xmlns:xlink="http://www.w3.org/1999/xlink"
+    xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.opennavsurf.org/schema/bag http://www.opennavsurf.org/schema/bag/bag.xsd">
+    <gmd:fileIdentifier>
+        <gco:CharacterString>Unique Identifier</gco:CharacterString>
+    </gmd:fileIdentifier>
+    <gmd:language>
+        <gmd:LanguageCode codeList="http://www.loc.gov/standards/iso639-2/" codeListValue="eng">eng</gmd:LanguageCode>
+    </gmd:language>
+    <gmd:characterSet>
+        <gmd:MD_CharacterSetCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CharacterSetCode" codeListValue="utf8">utf8</gmd:MD_CharacterSetCode>
+    </gmd:characterSet>
+    <gmd:hierarchyLevel>
+        <gmd:MD_ScopeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ScopeCode" codeListValue="dataset">dataset</gmd:MD_ScopeCode>
+    </gmd:hierarchyLevel>
+    <gmd:contact>
+        <gmd:CI_ResponsibleParty>
+            <gmd:individualName>
+                <gco:CharacterString>Name of individual responsible for the BAG</gco:CharacterString>
+            </gmd:individualName>
+            <gmd:role>
+                <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="pointOfContact">pointOfContact</gmd:CI_RoleCode>
+            </gmd:role>
+        </gmd:CI_ResponsibleParty>
+    </gmd:contact>
+    <gmd:dateStamp>
+        <gco:Date>2012-01-27</gco:Date>
+    </gmd:dateStamp>
+    <gmd:metadataStandardName>
+        <gco:CharacterString>ISO 19115</gco:CharacterString>
+    </gmd:metadataStandardName>
+    <gmd:metadataStandardVersion>
+        <gco:CharacterString>2003/Cor.1:2006</gco:CharacterString>
+    </gmd:metadataStandardVersion>
+    <gmd:spatialRepresentationInfo>
+        <gmd:MD_Georectified>
+            <gmd:numberOfDimensions>
+                <gco:Integer>2</gco:Integer>
+            </gmd:numberOfDimensions>
+            <gmd:axisDimensionProperties>
+                <gmd:MD_Dimension>
+                    <gmd:dimensionName>
+                        <gmd:MD_DimensionNameTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_DimensionNameTypeCode" codeListValue="row">row</gmd:MD_DimensionNameTypeCode>
+                    </gmd:dimensionName>
+                    <gmd:dimensionSize>
+                        <gco:Integer>100</gco:Integer>
+                    </gmd:dimensionSize>
+                    <gmd:resolution>
+                        <gco:Measure uom="Metres">10</gco:Measure>
+                    </gmd:resolution>
+                </gmd:MD_Dimension>
+            </gmd:axisDimensionProperties>
+            <gmd:axisDimensionProperties>
+                <gmd:MD_Dimension>
+                    <gmd:dimensionName>
+                        <gmd:MD_DimensionNameTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_DimensionNameTypeCode" codeListValue="column">column</gmd:MD_DimensionNameTypeCode>
+                    </gmd:dimensionName>
+                    <gmd:dimensionSize>
+                        <gco:Integer>100</gco:Integer>
+                    </gmd:dimensionSize>
+                    <gmd:resolution>
+                        <gco:Measure uom="Metres">10</gco:Measure>
+                    </gmd:resolution>
+                </gmd:MD_Dimension>
+            </gmd:axisDimensionProperties>
+            <gmd:cellGeometry>
+                <gmd:MD_CellGeometryCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CellGeometryCode" codeListValue="point">point</gmd:MD_CellGeometryCode>
+            </gmd:cellGeometry>
+            <gmd:transformationParameterAvailability>
+                <gco:Boolean>1</gco:Boolean>
+            </gmd:transformationParameterAvailability>
+            <gmd:checkPointAvailability>
+                <gco:Boolean>0</gco:Boolean>
+            </gmd:checkPointAvailability>
+            <gmd:cornerPoints>
+                <gml:Point gml:id="id1">
+                    <gml:coordinates cs="," decimal="." ts=" ">687910.000000,5554620.000000 691590.000000,5562100.000000</gml:coordinates>
+                </gml:Point>
+            </gmd:cornerPoints>
+            <gmd:pointInPixel>
+                <gmd:MD_PixelOrientationCode>center</gmd:MD_PixelOrientationCode>
+            </gmd:pointInPixel>
+        </gmd:MD_Georectified>
+    </gmd:spatialRepresentationInfo>
+    <gmd:referenceSystemInfo>
+        <gmd:MD_ReferenceSystem>
+            <gmd:referenceSystemIdentifier>
+                <gmd:RS_Identifier>
+                    <gmd:code>
+                        <gco:CharacterString>PROJCS["UTM-19N-Nad83",
+    GEOGCS["unnamed",
+        DATUM["North_American_Datum_1983",
+            SPHEROID["North_American_Datum_1983",6378137,298.2572201434276],
+            TOWGS84[0,0,0,0,0,0,0]],
+        PRIMEM["Greenwich",0],
+        UNIT["degree",0.0174532925199433],
+        EXTENSION["Scaler","0,0,0,0.02,0.02,0.001"],
+        EXTENSION["Source","CARIS"]],
+    PROJECTION["Transverse_Mercator"],
+    PARAMETER["latitude_of_origin",0],
+    PARAMETER["central_meridian",-69],
+    PARAMETER["scale_factor",0.9996],
+    PARAMETER["false_easting",500000],
+    PARAMETER["false_northing",0],
+    UNIT["metre",1]]</gco:CharacterString>
+                    </gmd:code>
+                    <gmd:codeSpace>
+                        <gco:CharacterString>WKT</gco:CharacterString>
+                    </gmd:codeSpace>
+                </gmd:RS_Identifier>
+            </gmd:referenceSystemIdentifier>
+        </gmd:MD_ReferenceSystem>
+    </gmd:referenceSystemInfo>
+    <gmd:referenceSystemInfo>
+        <gmd:MD_ReferenceSystem>
+            <gmd:referenceSystemIdentifier>
+                <gmd:RS_Identifier>
+                    <gmd:code>
+                        <gco:CharacterString>VERT_CS["Alicante height",
+    VERT_DATUM["Alicante",2000]]</gco:CharacterString>
+                    </gmd:code>
+                    <gmd:codeSpace>
+                        <gco:CharacterString>WKT</gco:CharacterString>
+                    </gmd:codeSpace>
+                </gmd:RS_Identifier>
+            </gmd:referenceSystemIdentifier>
+        </gmd:MD_ReferenceSystem>
+    </gmd:referenceSystemInfo>
+    <gmd:identificationInfo>
+        <bag:BAG_DataIdentification>
+            <gmd:citation>
+                <gmd:CI_Citation>
+                    <gmd:title>
+                        <gco:CharacterString>Name of dataset input</gco:CharacterString>
+                    </gmd:title>
+                    <gmd:date>
+                        <gmd:CI_Date>
+                            <gmd:date>
+                                <gco:Date>2008-10-21</gco:Date>
+                            </gmd:date>
+                            <gmd:dateType>
+                                <gmd:CI_DateTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_DateTypeCode" codeListValue="creation">creation</gmd:CI_DateTypeCode>
+                            </gmd:dateType>
+                        </gmd:CI_Date>
+                    </gmd:date>
+                    <gmd:citedResponsibleParty>
+                        <gmd:CI_ResponsibleParty>
+                            <gmd:individualName>
+                                <gco:CharacterString>Person responsible for input data</gco:CharacterString>
+                            </gmd:individualName>
+                            <gmd:role>
+                                <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="originator">originator</gmd:CI_RoleCode>
+                            </gmd:role>
+                        </gmd:CI_ResponsibleParty>
+                    </gmd:citedResponsibleParty>
+                </gmd:CI_Citation>
+            </gmd:citation>
+            <gmd:abstract>
+                <gco:CharacterString>Sample Metadata</gco:CharacterString>
+            </gmd:abstract>
+            <gmd:status>
+                <gmd:MD_ProgressCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ProgressCode" codeListValue="completed">completed</gmd:MD_ProgressCode>
+            </gmd:status>
+            <gmd:spatialRepresentationType>
+                <gmd:MD_SpatialRepresentationTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_SpatialRepresentationTypeCode" codeListValue="grid">grid</gmd:MD_SpatialRepresentationTypeCode>
+            </gmd:spatialRepresentationType>
+            <gmd:language>
+                <gmd:LanguageCode codeList="http://www.loc.gov/standards/iso639-2/" codeListValue="eng">eng</gmd:LanguageCode>
+            </gmd:language>
+            <gmd:characterSet>
+                <gmd:MD_CharacterSetCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_CharacterSetCode" codeListValue="utf8">utf8</gmd:MD_CharacterSetCode>
+            </gmd:characterSet>
+            <gmd:topicCategory>
+                <gmd:MD_TopicCategoryCode>elevation</gmd:MD_TopicCategoryCode>
+            </gmd:topicCategory>
+            <gmd:extent>
+                <gmd:EX_Extent>
+                    <gmd:geographicElement>
+                        <gmd:EX_GeographicBoundingBox>
+                            <gmd:westBoundLongitude>
+                                <gco:Decimal>-66.371629</gco:Decimal>
+                            </gmd:westBoundLongitude>
+                            <gmd:eastBoundLongitude>
+                                <gco:Decimal>-66.316454</gco:Decimal>
+                            </gmd:eastBoundLongitude>
+                            <gmd:southBoundLatitude>
+                                <gco:Decimal>50.114053</gco:Decimal>
+                            </gmd:southBoundLatitude>
+                            <gmd:northBoundLatitude>
+                                <gco:Decimal>50.180077</gco:Decimal>
+                            </gmd:northBoundLatitude>
+                        </gmd:EX_GeographicBoundingBox>
+                    </gmd:geographicElement>
+                </gmd:EX_Extent>
+            </gmd:extent>
+            <bag:verticalUncertaintyType>
+                <bag:BAG_VertUncertCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_VertUncertCode" codeListValue="rawStdDev">rawStdDev</bag:BAG_VertUncertCode>
+            </bag:verticalUncertaintyType>
+            <bag:depthCorrectionType>
+                <bag:BAG_DepthCorrectCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_DepthCorrectCode" codeListValue="trueDepth">trueDepth</bag:BAG_DepthCorrectCode>
+            </bag:depthCorrectionType>
+            <bag:elevationSolutionGroupType>
+                <bag:BAG_OptGroupCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_OptGroupCode" codeListValue="cube">cube</bag:BAG_OptGroupCode>
+            </bag:elevationSolutionGroupType>
+            <bag:nodeGroupType>
+                <bag:BAG_OptGroupCode codeList="http://www.opennavsurf.org/schema/bag/bagCodelists.xml#BAG_OptGroupCode" codeListValue="product">product</bag:BAG_OptGroupCode>
+            </bag:nodeGroupType>
+        </bag:BAG_DataIdentification>
+    </gmd:identificationInfo>
+    <gmd:dataQualityInfo>
+        <gmd:DQ_DataQuality>
+            <gmd:scope>
+                <gmd:DQ_Scope>
+                    <gmd:level>
+                        <gmd:MD_ScopeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ScopeCode" codeListValue="dataset">dataset</gmd:MD_ScopeCode>
+                    </gmd:level>
+                </gmd:DQ_Scope>
+            </gmd:scope>
+            <gmd:lineage>
+                <gmd:LI_Lineage>
+                    <gmd:processStep>
+                        <bag:BAG_ProcessStep>
+                            <gmd:description>
+                                <gco:CharacterString>List to be determined by WG. I.e. Product Creation</gco:CharacterString>
+                            </gmd:description>
+                            <gmd:dateTime>
+                                <gco:DateTime>2008-10-21T12:21:53</gco:DateTime>
+                            </gmd:dateTime>
+                            <gmd:processor>
+                                <gmd:CI_ResponsibleParty>
+                                    <gmd:individualName>
+                                        <gco:CharacterString>Name of the processor</gco:CharacterString>
+                                    </gmd:individualName>
+                                    <gmd:role>
+                                        <gmd:CI_RoleCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_RoleCode" codeListValue="processor">processor</gmd:CI_RoleCode>
+                                    </gmd:role>
+                                </gmd:CI_ResponsibleParty>
+                            </gmd:processor>
+                            <gmd:source>
+                                <gmd:LI_Source>
+                                    <gmd:description>
+                                        <gco:CharacterString>Source</gco:CharacterString>
+                                    </gmd:description>
+                                    <gmd:sourceCitation>
+                                        <gmd:CI_Citation>
+                                            <gmd:title>
+                                                <gco:CharacterString>Name of dataset input</gco:CharacterString>
+                                            </gmd:title>
+                                            <gmd:date>
+                                                <gmd:CI_Date>
+                                                    <gmd:date gco:nilReason="unknown"/>
+                                                    <gmd:dateType>
+                                                        <gmd:CI_DateTypeCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#CI_DateTypeCode" codeListValue="creation">creation</gmd:CI_DateTypeCode>
+                                                    </gmd:dateType>
+                                                </gmd:CI_Date>
+                                            </gmd:date>
+                                        </gmd:CI_Citation>
+                                    </gmd:sourceCitation>
+                                </gmd:LI_Source>
+                            </gmd:source>
+                            <bag:trackingId>
+                                <gco:CharacterString>1</gco:CharacterString>
+                            </bag:trackingId>
+                        </bag:BAG_ProcessStep>
+                    </gmd:processStep>
+                </gmd:LI_Lineage>
+            </gmd:lineage>
+        </gmd:DQ_DataQuality>
+    </gmd:dataQualityInfo>
+    <gmd:metadataConstraints>
+        <gmd:MD_LegalConstraints>
+            <gmd:useConstraints>
+                <gmd:MD_RestrictionCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_RestrictionCode" codeListValue="otherRestrictions">otherRestrictions</gmd:MD_RestrictionCode>
+            </gmd:useConstraints>
+            <gmd:otherConstraints>
+                <gco:CharacterString>some other constraints</gco:CharacterString>
+            </gmd:otherConstraints>
+        </gmd:MD_LegalConstraints>
+    </gmd:metadataConstraints>
+    <gmd:metadataConstraints>
+        <gmd:MD_SecurityConstraints>
+            <gmd:classification>
+                <gmd:MD_ClassificationCode codeList="http://www.isotc211.org/2005/resources/Codelist/gmxCodelists.xml#MD_ClassificationCode" codeListValue="unclassified">unclassified</gmd:MD_ClassificationCode>
+            </gmd:classification>
+            <gmd:userNote>
+                <gco:CharacterString>some user node</gco:CharacterString>
+            </gmd:userNote>
+        </gmd:MD_SecurityConstraints>
+    </gmd:metadataConstraints>
+</gmi:MI_Metadata>
+)"};
+
+}  // namespace
+
+//  explicit VRIndex(const Dataset& dataset);
+//  VRPointResult queryPoint(double x, double y) const;
+//  std::vector<VRPointResult> queryPoints(
+//      const std::vector<VRPoint>& points) const;
+//  std::vector<VRRefinementsItem> sample(const std::vector<double>& xs,
+//      const std::vector<double>& ys, SampleMethod method) const;
+TEST_CASE("test vr index query", "[vrindex][constructor][queryPoint][queryPoints][sample]")
+{
+    const TestUtils::RandomFileGuard tmpBagFile;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    const auto pDataset = Dataset::create(tmpBagFile, std::move(metadata), 100, 6);
+    REQUIRE(pDataset);
+
+    UNSCOPED_INFO("Check an index needs variable resolution layers.");
+    REQUIRE_THROWS_AS(VRIndex{*pDataset}, BAG::DatasetRequiresVariableResolution);
+
+    REQUIRE_NOTHROW(pDataset->createVR(100, 6, false));
+
+    // Refinements hold their own index as the depth.
+    constexpr uint32_t kNumRefinements = 10;
+    std::vector<BAG::VRRefinementsItem> refinements(kNumRefinements);
+    for (uint32_t i=0; i<kNumRefinements; ++i)
+        refinements[i] = {static_cast<float>(i), 0.1f * i};
+
+    pDataset->getVRRefinements()->write(0, 0, 0, kNumRefinements - 1,
+        reinterpret_cast<const uint8_t*>(refinements.data()));
+
+    // Two refined supergrid cells: (2, 3) is 3x2 and (5, 5) is 2x2.
+    constexpr uint32_t kDim = 100;
+    std::vector<BAG::VRMetadataItem> items(kDim * kDim, BAG::VRMetadataItem{});
+    items[2 * kDim + 3] = {0, 3, 2, 3.f, 4.f, 1.f, .5f};
+    items[5 * kDim + 5] = {6, 2, 2, 4.f, 4.f, 1.f, 1.f};
+
+    pDataset->getVRMetadata()->write(0, 0, kDim - 1, kDim - 1,
+        reinterpret_cast<const uint8_t*>(items.data()));
+
+    // Two edits of refined node (1, 2) of cell (2, 3), and one of (0, 2).
+    const auto pTrackingList = pDataset->getVRTrackingList();
+    REQUIRE(pTrackingList);
+    pTrackingList->emplace_back(BAG::VRTrackingItem{2, 3, 1, 2, 1.f, .1f, 1, 1});
+    pTrackingList->emplace_back(BAG::VRTrackingItem{2, 3, 0, 2, 2.f, .2f, 1, 1});
+    pTrackingList->emplace_back(BAG::VRTrackingItem{2, 3, 1, 2, 3.f, .3f, 2, 1});
+
+    const VRIndex index{*pDataset};
+
+    double originX = 0., originY = 0.;
+    std::tie(originX, originY) = pDataset->getDescriptor().getOrigin();
+
+    double spacingX = 0., spacingY = 0.;
+    std::tie(spacingX, spacingY) = pDataset->getDescriptor().getGridSpacing();
+
+    // The position of a refined node of a supergrid cell.
+    const auto position = [&](uint32_t row, uint32_t column, uint32_t refinedRow,
+        uint32_t refinedColumn) {
+        const auto& item = items[row * kDim + column];
+        return VRPoint{
+            originX + (column - .5) * spacingX + item.sw_corner_x +
+                refinedColumn * item.resolution_x,
+            originY + (row - .5) * spacingY + item.sw_corner_y +
+                refinedRow * item.resolution_y};
+    };
+
+    UNSCOPED_INFO("Check a refined node is found.");
+    const auto node = position(2, 3, 1, 2);
+    auto result = index.queryPoint(node.x, node.y);
+    REQUIRE(result.found);
+    CHECK(result.row == 2);
+    CHECK(result.column == 3);
+    CHECK(result.subRow == 1);
+    CHECK(result.subColumn == 2);
+    CHECK(result.refinementIndex == 5);
+    CHECK(result.item.depth == 5.f);
+
+    UNSCOPED_INFO("Check the tracking list items of the refined node are found.");
+    REQUIRE(result.trackingItems.size() == 2);
+    CHECK(result.trackingItems[0].depth == 1.f);
+    CHECK(result.trackingItems[1].depth == 3.f);
+
+    UNSCOPED_INFO("Check a position near a refined node is snapped to it.");
+    result = index.queryPoint(node.x + 1., node.y - 1.);
+    REQUIRE(result.found);
+    CHECK(result.refinementIndex == 5);
+
+    UNSCOPED_INFO("Check an unrefined supergrid cell is not found.");
+    const auto unrefined = position(7, 7, 0, 0);
+    CHECK_FALSE(index.queryPoint(unrefined.x, unrefined.y).found);
+
+    UNSCOPED_INFO("Check a position outside the BAG is not found.");
+    CHECK_FALSE(index.queryPoint(originX - 100., originY).found);
+
+    UNSCOPED_INFO("Check a batch matches single queries, in order.");
+    const std::vector<VRPoint> points{position(5, 5, 1, 1), position(2, 3, 0, 0),
+        unrefined, position(5, 5, 0, 1), position(2, 3, 1, 0)};
+    const auto results = index.queryPoints(points);
+    REQUIRE(results.size() == points.size());
+
+    for (size_t i=0; i<points.size(); ++i)
+    {
+        const auto expected = index.queryPoint(points[i].x, points[i].y);
+        CHECK(results[i].found == expected.found);
+        CHECK(results[i].refinementIndex == expected.refinementIndex);
+        CHECK(results[i].item.depth == expected.item.depth);
+        CHECK(results[i].item.depth_uncrt == expected.item.depth_uncrt);
+        CHECK(results[i].trackingItems.size() == expected.trackingItems.size());
+    }
+
+    CHECK(results[0].refinementIndex == 9);
+    CHECK(results[1].refinementIndex == 0);
+    CHECK(results[4].refinementIndex == 3);
+    CHECK(results[0].trackingItems.empty());
+
+    UNSCOPED_INFO("Check sampling interpolates the refined nodes of a cell.");
+    // Halfway between the refined nodes of cell (5, 5), 4 apart.
+    const auto centre = position(5, 5, 0, 0);
+    const std::vector<double> xs{centre.x + 2., node.x, unrefined.x,
+        originX - 100.};
+    const std::vector<double> ys{centre.y + 2., node.y, unrefined.y, originY};
+
+    auto samples = index.sample(xs, ys);
+    REQUIRE(samples.size() == xs.size());
+    CHECK(samples[0].depth == Catch::Approx(7.5));
+    CHECK(samples[0].depth_uncrt == Catch::Approx(.75));
+    CHECK(samples[1].depth == Catch::Approx(5.));
+    CHECK(samples[2].depth == BAG_NULL_ELEVATION);
+    CHECK(samples[2].depth_uncrt == BAG_NULL_UNCERTAINTY);
+    CHECK(samples[3].depth == BAG_NULL_ELEVATION);
+
+    samples = index.sample(xs, ys, BAG::SampleMethod::Nearest);
+    REQUIRE(samples.size() == xs.size());
+    CHECK(samples[1].depth == 5.f);
+    CHECK(samples[2].depth == BAG_NULL_ELEVATION);
+
+    REQUIRE_THROWS_AS(index.sample(xs, {}), BAG::InvalidSamplePositions);
+}
+
@@ -7,6 +7,7 @@
 
 #include <catch2/catch_all.hpp>
 #include <string>
+#include <vector>
 
 
 using BAG::Dataset;
@@ -469,3 +470,68 @@ TEST_CASE("test vr metadata write read", "[vrmetadata][write][read]")
     CHECK(res->sw_corner_y == kExpectedItem0.sw_corner_y);
 }
 
+TEST_CASE("test vr metadata table", "[vrmetadata][getTable]")
+{
+    const TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr unsigned int kCompressionLevel = 6;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    auto pDataset = Dataset::create(tmpBagFile, std::move(metadata), kChunkSize,
+        kCompressionLevel);
+    REQUIRE(pDataset);
+
+    REQUIRE_NOTHROW(pDataset->createVR(kChunkSize, kCompressionLevel, false));
+
+    auto pVrMetadata = pDataset->getVRMetadata();
+    REQUIRE(pVrMetadata);
+
+    uint32_t numRows = 0, numColumns = 0;
+    std::tie(numRows, numColumns) = pDataset->getDescriptor().getDims();
+
+    // Refine cells (1, 2) as 3x2 and (4, 0) as 2x2.
+    std::vector<BAG::VRMetadataItem> items(numRows * numColumns,
+        BAG::VRMetadataItem{});
+    items[1 * numColumns + 2] = {0, 3, 2, 3.f, 4.f, 1.f, .5f};
+    items[4 * numColumns + 0] = {6, 2, 2, 4.f, 4.f, 1.f, 1.f};
+
+    REQUIRE_NOTHROW(pVrMetadata->write(0, 0, numRows - 1, numColumns - 1,
+        reinterpret_cast<const uint8_t*>(items.data())));
+
+    const auto pTable = pVrMetadata->getTable();
+    REQUIRE(pTable);
+
+    UNSCOPED_INFO("Check the table covers the whole layer.");
+    CHECK(pTable->getNumRows() == numRows);
+    CHECK(pTable->getNumColumns() == numColumns);
+    REQUIRE(pTable->size() == items.size());
+    CHECK(pTable->end() - pTable->begin() == static_cast<ptrdiff_t>(items.size()));
+
+    CHECK(pTable->get(1, 2).dimensions_x == 3);
+    CHECK(pTable->get(4, 0).index == 6);
+    CHECK(pTable->get(0, 0).dimensions_x == 0);
+
+    UNSCOPED_INFO("Check the running total of refinements.");
+    CHECK(pTable->getRefinementOffset(0, 0) == 0);
+    CHECK(pTable->getRefinementOffset(1, 2) == 0);
+    CHECK(pTable->getRefinementOffset(1, 3) == 6);
+    CHECK(pTable->getRefinementOffset(4, 0) == 6);
+    CHECK(pTable->getRefinementOffset(4, 1) == 10);
+    CHECK(pTable->getNumRefinements() == 10);
+
+    UNSCOPED_INFO("Check the table is shared until the layer is written.");
+    CHECK(pVrMetadata->getTable() == pTable);
+
+    const BAG::VRMetadataItem kItem{10, 1, 1, 2.f, 2.f, 0.f, 0.f};
+    REQUIRE_NOTHROW(pVrMetadata->write(0, 0, 0, 0,
+        reinterpret_cast<const uint8_t*>(&kItem)));
+
+    const auto pNewTable = pVrMetadata->getTable();
+    CHECK(pNewTable != pTable);
+    CHECK(pNewTable->get(0, 0).index == 10);
+    CHECK(pNewTable->getNumRefinements() == 11);
+    CHECK(pTable->get(0, 0).dimensions_x == 0);
+}
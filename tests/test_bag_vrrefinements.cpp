@@ -4,9 +4,12 @@
 #include <bag_metadata.h>
 #include <bag_vrrefinements.h>
 #include <bag_vrrefinementsdescriptor.h>
+#include <bag_vrtrackinglist.h>
 
 #include <catch2/catch_all.hpp>
+#include <H5Cpp.h>
 #include <string>
+#include <vector>
 
 
 using BAG::Dataset;
@@ -449,3 +452,256 @@ TEST_CASE("test vr refinements write read", "[vrrefinements][write][read]")
     CHECK(res->depth_uncrt == kExpectedItem0.depth_uncrt);
 }
 
+TEST_CASE("test vr refinements append writer", "[vrrefinements][appendWriter]")
+{
+    const TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr unsigned int kCompressionLevel = 6;
+
+    // Runs of 1 to 7 refinements, like one supergrid cell at a time.
+    constexpr uint32_t kNumRuns = 500;
+    std::vector<BAG::VRRefinementsItem> expected;
+    expected.push_back({9.8f, 0.654f});
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        auto pDataset = Dataset::create(tmpBagFile, std::move(metadata),
+            kChunkSize, kCompressionLevel);
+        REQUIRE(pDataset);
+
+        REQUIRE_NOTHROW(pDataset->createVR(kChunkSize, kCompressionLevel, false));
+
+        auto pVrRefinements = pDataset->getVRRefinements();
+        REQUIRE(pVrRefinements);
+
+        UNSCOPED_INFO("Write one record the usual way first.");
+        REQUIRE_NOTHROW(pVrRefinements->write(0, 0, 0, 0,
+            reinterpret_cast<const uint8_t*>(expected.data())));
+
+        auto pWriter = pVrRefinements->appendWriter();
+        REQUIRE(pWriter);
+        CHECK(pWriter->size() == 1);
+
+        UNSCOPED_INFO("Check each run starts where the last one ended.");
+        for (uint32_t run=0; run<kNumRuns; ++run)
+        {
+            std::vector<BAG::VRRefinementsItem> items(run % 7 + 1);
+            for (size_t i=0; i<items.size(); ++i)
+                items[i] = {static_cast<float>(expected.size() + i),
+                    0.5f + run % 3};
+
+            const auto first = pWriter->append(items.data(), items.size());
+            CHECK(first == expected.size());
+
+            expected.insert(expected.end(), items.begin(), items.end());
+        }
+
+        CHECK(pWriter->size() == expected.size());
+
+        REQUIRE_NOTHROW(pWriter->close());
+
+        UNSCOPED_INFO("Check appending after closing throws.");
+        REQUIRE_THROWS_AS(pWriter->append(expected.data(), 1),
+            BAG::AppendWriterClosed);
+
+        UNSCOPED_INFO("Check appending leaves the dimensions of the grid alone.");
+        CHECK(pDataset->getDescriptor().getDims() == std::make_tuple(100u, 100u));
+        REQUIRE_NOTHROW(pDataset->getLayer(Elevation).read(0, 0, 99, 99));
+
+        float minDepth = 0.f, maxDepth = 0.f;
+        std::tie(minDepth, maxDepth) = pVrRefinements->getDescriptor()->getMinMaxDepth();
+        CHECK(minDepth == 1.f);
+        CHECK(maxDepth == expected.back().depth);
+
+        const auto lastColumn = static_cast<uint32_t>(expected.size() - 1);
+        const auto result = pVrRefinements->read(0, 0, 0, lastColumn);
+        REQUIRE(result.size() == expected.size() * sizeof(BAG::VRRefinementsItem));
+
+        const auto* items =
+            reinterpret_cast<const BAG::VRRefinementsItem*>(result.data());
+        for (size_t i=0; i<expected.size(); ++i)
+        {
+            CHECK(items[i].depth == expected[i].depth);
+            CHECK(items[i].depth_uncrt == expected[i].depth_uncrt);
+        }
+
+        UNSCOPED_INFO("Check reading past the appended refinements throws.");
+        REQUIRE_THROWS(pVrRefinements->read(0, 0, 0, lastColumn + 1));
+    }
+
+    {
+        auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+        REQUIRE(pDataset);
+
+        auto pVrRefinements = pDataset->getVRRefinements();
+        REQUIRE(pVrRefinements);
+
+        UNSCOPED_INFO("Check the min/max attributes were written on close.");
+        float minDepth = 0.f, maxDepth = 0.f;
+        std::tie(minDepth, maxDepth) = pVrRefinements->getDescriptor()->getMinMaxDepth();
+        CHECK(minDepth == 1.f);
+        CHECK(maxDepth == expected.back().depth);
+
+        const auto result = pVrRefinements->read(0, 0, 0, 0);
+        CHECK(reinterpret_cast<const BAG::VRRefinementsItem*>(
+            result.data())->depth == expected[0].depth);
+    }
+}
+
+//  void createVR(uint64_t chunkSize, const CompressionSpec& compression,
+//      bool makeNode, const VRSizeHint& sizeHint);
+TEST_CASE("test vr refinements size hint", "[vrrefinements][createVR][appendWriter]")
+{
+    const TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr unsigned int kCompressionLevel = 6;
+
+    BAG::VRSizeHint sizeHint;
+    sizeHint.numRefinements = 1000;
+    sizeHint.numTrackingItems = 50;
+
+    constexpr uint32_t kNumRefinements = 310;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        auto pDataset = Dataset::create(tmpBagFile, std::move(metadata),
+            kChunkSize, kCompressionLevel);
+        REQUIRE(pDataset);
+
+        REQUIRE_NOTHROW(pDataset->createVR(kChunkSize, kCompressionLevel,
+            true, sizeHint));
+
+        auto pVrRefinements = pDataset->getVRRefinements();
+        REQUIRE(pVrRefinements);
+
+        UNSCOPED_INFO("Check the refinements are chunked for those expected.");
+        CHECK(pVrRefinements->getDescriptor()->getChunkSize() == 1000);
+
+        UNSCOPED_INFO("Check writing into the room reserved counts only what is written.");
+        const std::vector<BAG::VRRefinementsItem> items(10, {1.f, 0.5f});
+        pVrRefinements->write(0, 0, 0, 9,
+            reinterpret_cast<const uint8_t*>(items.data()));
+        CHECK(pDataset->getDescriptor().getDims() == std::make_tuple(100u, 100u));
+        REQUIRE_THROWS(pVrRefinements->read(0, 0, 0, 10));
+
+        auto pWriter = pVrRefinements->appendWriter();
+        REQUIRE(pWriter);
+        CHECK(pWriter->size() == 10);
+
+        const std::vector<BAG::VRRefinementsItem> appended(
+            kNumRefinements - 10, {2.f, 0.5f});
+        CHECK(pWriter->append(appended.data(), appended.size()) == 10);
+        pWriter->close();
+
+        CHECK(pDataset->getDescriptor().getDims() == std::make_tuple(100u, 100u));
+
+        auto pTrackingList = pDataset->getVRTrackingList();
+        REQUIRE(pTrackingList);
+        pTrackingList->emplace_back(BAG::VRTrackingItem{2, 3, 1, 2, 1.f, .1f,
+            1, 1});
+        pTrackingList->write();
+    }
+
+    UNSCOPED_INFO("Check the room left was trimmed when the BAG was closed.");
+    {
+        const ::H5::H5File h5file{tmpBagFile.m_fileName, H5F_ACC_RDONLY};
+
+        hsize_t length = 0;
+        h5file.openDataSet("/BAG_root/varres_refinements").getSpace()
+            .getSimpleExtentDims(&length);
+        CHECK(length == kNumRefinements);
+
+        h5file.openDataSet("/BAG_root/varres_nodes").getSpace()
+            .getSimpleExtentDims(&length);
+        CHECK(length == 0);
+
+        h5file.openDataSet("/BAG_root/varres_tracking_list").getSpace()
+            .getSimpleExtentDims(&length);
+        CHECK(length == 1);
+    }
+
+    auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto result = pDataset->getVRRefinements()->read(0, 9, 0, 10);
+    const auto* read =
+        reinterpret_cast<const BAG::VRRefinementsItem*>(result.data());
+    CHECK(read[0].depth == 1.f);
+    CHECK(read[1].depth == 2.f);
+    CHECK(pDataset->getVRTrackingList()->size() == 1);
+}
+
+//  LayerTiles tiles() const;
+TEST_CASE("test vr refinements tiles", "[vrrefinements][tiles]")
+{
+    const TestUtils::RandomFileGuard tmpBagFile;
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr unsigned int kCompressionLevel = 6;
+    constexpr uint32_t kNumRefinements = 250;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        auto pDataset = Dataset::create(tmpBagFile, std::move(metadata),
+            kChunkSize, kCompressionLevel);
+        REQUIRE(pDataset);
+
+        REQUIRE_NOTHROW(pDataset->createVR(kChunkSize, kCompressionLevel,
+            false));
+
+        auto pVrRefinements = pDataset->getVRRefinements();
+        REQUIRE(pVrRefinements);
+
+        UNSCOPED_INFO("Check an empty layer has no tiles.");
+        CHECK(pVrRefinements->tiles().size() == 0);
+
+        std::vector<BAG::VRRefinementsItem> items(kNumRefinements);
+        for (uint32_t i=0; i<kNumRefinements; ++i)
+            items[i] = {static_cast<float>(i), 0.5f};
+
+        pVrRefinements->write(0, 0, 0, kNumRefinements - 1,
+            reinterpret_cast<const uint8_t*>(items.data()));
+
+        UNSCOPED_INFO("Check the tiles are runs of a chunk of refinements.");
+        const auto tiles = pVrRefinements->tiles();
+        CHECK(tiles.getNumRows() == 1);
+        CHECK(tiles.getNumColumns() == kNumRefinements);
+        CHECK(tiles.getTileRows() == 1);
+        CHECK(tiles.getTileColumns() == kChunkSize);
+        CHECK(tiles.size() == 3);
+    }
+
+    UNSCOPED_INFO("Check the tiles of the reopened layer cover every refinement once.");
+    auto pDataset = Dataset::open(tmpBagFile, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto tiles = pDataset->getVRRefinements()->tiles();
+    CHECK(tiles.getNumRows() == 1);
+    CHECK(tiles.getNumColumns() == kNumRefinements);
+
+    uint32_t numRead = 0;
+    for (const auto& tile : tiles)
+    {
+        REQUIRE(tile.data);
+        CHECK(tile.rowStart == 0);
+        CHECK(tile.rowEnd == 0);
+        CHECK(tile.columnStart == numRead);
+        REQUIRE(tile.columnEnd < kNumRefinements);
+
+        const auto* read =
+            reinterpret_cast<const BAG::VRRefinementsItem*>(tile.data.data());
+        for (uint32_t i=tile.columnStart; i<=tile.columnEnd; ++i)
+            CHECK(read[i - tile.columnStart].depth == static_cast<float>(i));
+
+        numRead = tile.columnEnd + 1;
+    }
+    CHECK(numRead == kNumRefinements);
+}
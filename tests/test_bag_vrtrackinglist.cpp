@@ -425,3 +425,234 @@ TEST_CASE("test VR tracking list construction (create, open)", "[vrtrackinglist]
     CHECK(kExpectedItem1 == (*trackingList)[1]);
 }
 
+
+TEST_CASE("test VR tracking list queries", "[vrtrackinglist][getItemsAtNode][getItemsAtSubNode][getItemsWithCode][getItemsInSeries][getItemsInWindow]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr int kCompressionLevel = 6;
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        kChunkSize, kCompressionLevel);
+    REQUIRE(pDataset);
+
+    pDataset->createVR(kChunkSize, kCompressionLevel, false);
+    const auto trackingList = pDataset->getVRTrackingList();
+    REQUIRE(trackingList);
+
+    const VRTrackingList::value_type kItem0{4, 4, 1, 2, 1.f, 0.1f, 1, 10};
+    const VRTrackingList::value_type kItem1{1, 2, 3, 4, 2.f, 0.2f, 2, 10};
+    const VRTrackingList::value_type kItem2{1, 2, 1, 2, 3.f, 0.3f, 2, 20};
+    const VRTrackingList::value_type kItem3{1, 5, 0, 0, 4.f, 0.4f, 3, 20};
+
+    trackingList->push_back(kItem0);
+    trackingList->push_back(kItem1);
+    trackingList->push_back(kItem2);
+    trackingList->push_back(kItem3);
+
+    const VRTrackingList& constList = *trackingList;
+
+    UNSCOPED_INFO("Check the items are found by node and sub node.");
+    auto items = constList.getItemsAtNode(1, 2);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0] == kItem1);
+    CHECK(items[1] == kItem2);
+
+    items = constList.getItemsAtSubNode(1, 2);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0] == kItem0);
+    CHECK(items[1] == kItem2);
+
+    UNSCOPED_INFO("Check the items are found by track code and list series.");
+    CHECK(constList.getItemsWithCode(2).size() == 2);
+    items = constList.getItemsInSeries(20);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0] == kItem2);
+    CHECK(items[1] == kItem3);
+
+    UNSCOPED_INFO("Check the items are found in a window.");
+    items = constList.getItemsInWindow(0, 3, 4, 5);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0] == kItem3);
+    CHECK(items[1] == kItem0);
+
+    UNSCOPED_INFO("Check an inverted window throws.");
+    REQUIRE_THROWS_AS(constList.getItemsInWindow(4, 0, 3, 0),
+        BAG::InvalidReadSize);
+
+    UNSCOPED_INFO("Check adding items updates the queries.");
+    trackingList->emplace_back(kItem1);
+    CHECK(constList.getItemsAtNode(1, 2).size() == 3);
+}
+
+TEST_CASE("test VR tracking list incremental write", "[vrtrackinglist][write]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    {
+        BAG::Metadata metadata;
+        metadata.loadFromBuffer(kMetadataXML);
+
+        constexpr uint64_t kChunkSize = 100;
+        constexpr int kCompressionLevel = 6;
+        const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+            kChunkSize, kCompressionLevel);
+        REQUIRE(pDataset);
+
+        pDataset->createVR(kChunkSize, kCompressionLevel, false);
+        const auto trackingList = pDataset->getVRTrackingList();
+        REQUIRE(trackingList);
+
+        for (uint32_t i=0; i<10; ++i)
+        {
+            trackingList->emplace_back(VRTrackingList::value_type{i, i, 1, 2,
+                static_cast<float>(i), 0.5f, 3, 4});
+            REQUIRE_NOTHROW(trackingList->write());
+        }
+
+        trackingList->front().depth = 42.f;
+        REQUIRE_NOTHROW(trackingList->write());
+    }
+
+    const auto pDataset = Dataset::open(tmpFileName, BAG_OPEN_READONLY);
+    REQUIRE(pDataset);
+
+    const auto trackingList = pDataset->getVRTrackingList();
+    REQUIRE(trackingList);
+
+    UNSCOPED_INFO("Check every write reached the file.");
+    REQUIRE(trackingList->size() == 10);
+    CHECK((*trackingList)[0].depth == 42.f);
+
+    for (uint32_t i=1; i<10; ++i)
+    {
+        CHECK((*trackingList)[i].row == i);
+        CHECK((*trackingList)[i].depth == static_cast<float>(i));
+    }
+}
+
+TEST_CASE("test VR tracking list sort", "[vrtrackinglist][sortByNode][sortBySubNode][sortByCode][sortBySeries]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr int kCompressionLevel = 6;
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        kChunkSize, kCompressionLevel);
+    REQUIRE(pDataset);
+
+    pDataset->createVR(kChunkSize, kCompressionLevel, false);
+    const auto trackingList = pDataset->getVRTrackingList();
+    REQUIRE(trackingList);
+
+    trackingList->emplace_back(VRTrackingList::value_type{4, 4, 1, 2, 1.f, 0.1f, 1, 10});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 2, 3, 4, 2.f, 0.2f, 2, 10});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 2, 1, 2, 3.f, 0.3f, 2, 20});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 5, 0, 0, 4.f, 0.4f, 3, 20});
+
+    UNSCOPED_INFO("Check sorting by node orders by node, then sub node.");
+    trackingList->sortByNode();
+    CHECK((*trackingList)[0].depth == 3.f);
+    CHECK((*trackingList)[1].depth == 2.f);
+    CHECK((*trackingList)[2].depth == 4.f);
+    CHECK((*trackingList)[3].depth == 1.f);
+
+    auto items = trackingList->getItemsAtNode(1, 2);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0].depth == 3.f);
+    CHECK(items[1].depth == 2.f);
+
+    UNSCOPED_INFO("Check sorting twice the same way changes nothing.");
+    trackingList->sortByNode();
+    CHECK((*trackingList)[0].depth == 3.f);
+    CHECK((*trackingList)[3].depth == 1.f);
+
+    UNSCOPED_INFO("Check sorting descending by sub node.");
+    trackingList->sortBySubNode(true);
+    CHECK((*trackingList)[0].depth == 2.f);
+    CHECK((*trackingList)[1].depth == 3.f);
+    CHECK((*trackingList)[2].depth == 1.f);
+    CHECK((*trackingList)[3].depth == 4.f);
+
+    items = trackingList->getItemsAtSubNode(1, 2);
+    REQUIRE(items.size() == 2);
+    CHECK(items[0].depth == 3.f);
+    CHECK(items[1].depth == 1.f);
+
+    UNSCOPED_INFO("Check sorting by track code and list series.");
+    trackingList->sortByCode(true);
+    CHECK((*trackingList)[0].track_code == 3);
+    CHECK((*trackingList)[1].depth == 2.f);
+    CHECK((*trackingList)[2].depth == 3.f);
+    CHECK((*trackingList)[3].track_code == 1);
+
+    trackingList->sortBySeries();
+    CHECK((*trackingList)[0].list_series == 10);
+    CHECK((*trackingList)[1].list_series == 10);
+    CHECK((*trackingList)[2].list_series == 20);
+    CHECK(trackingList->getItemsWithCode(2).size() == 2);
+}
+
+TEST_CASE("test VR tracking table", "[vrtrackinglist][getTable][vrtrackingtable]")
+{
+    const TestUtils::RandomFileGuard tmpFileName;
+
+    BAG::Metadata metadata;
+    metadata.loadFromBuffer(kMetadataXML);
+
+    constexpr uint64_t kChunkSize = 100;
+    constexpr int kCompressionLevel = 6;
+    const auto pDataset = Dataset::create(tmpFileName, std::move(metadata),
+        kChunkSize, kCompressionLevel);
+    REQUIRE(pDataset);
+
+    pDataset->createVR(kChunkSize, kCompressionLevel, false);
+    const auto trackingList = pDataset->getVRTrackingList();
+    REQUIRE(trackingList);
+
+    trackingList->emplace_back(VRTrackingList::value_type{4, 4, 1, 2, 1.f, 0.1f, 1, 10});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 2, 3, 4, 2.f, 0.2f, 2, 10});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 2, 1, 2, 3.f, 0.3f, 2, 20});
+    trackingList->emplace_back(VRTrackingList::value_type{1, 2, 3, 4, 4.f, 0.4f, 3, 20});
+
+    const auto table = trackingList->getTable();
+    REQUIRE(table);
+
+    UNSCOPED_INFO("Check the items are grouped by node, then sub node.");
+    REQUIRE(table->size() == 4);
+    CHECK(table->getNumNodes() == 2);
+    CHECK(table->begin()[0].depth == 3.f);
+    CHECK(table->begin()[1].depth == 2.f);
+    CHECK(table->begin()[2].depth == 4.f);
+    CHECK(table->begin()[3].depth == 1.f);
+
+    auto items = table->getItemsAtNode(1, 2);
+    CHECK(items.second - items.first == 3);
+    CHECK(items.first == table->begin());
+
+    items = table->getItemsAtSubNode(1, 2, 3, 4);
+    REQUIRE(items.second - items.first == 2);
+    CHECK(items.first[0].depth == 2.f);
+    CHECK(items.first[1].depth == 4.f);
+
+    items = table->getItemsAtNode(2, 2);
+    CHECK(items.first == items.second);
+    items = table->getItemsAtSubNode(4, 4, 0, 0);
+    CHECK(items.first == items.second);
+
+    UNSCOPED_INFO("Check the table is kept until the items change.");
+    CHECK(trackingList->getTable() == table);
+
+    trackingList->push_back(VRTrackingList::value_type{0, 0, 0, 0, 5.f, 0.5f, 1, 1});
+    const auto changedTable = trackingList->getTable();
+    CHECK(changedTable != table);
+    CHECK(changedTable->size() == 5);
+    CHECK(changedTable->getNumNodes() == 3);
+    CHECK(table->size() == 4);
+}